@@ -573,6 +573,29 @@ static inline int64_t libvlc_delay(int64_t pts)
 
 /** @} */
 
+/** \defgroup libvlc_trace LibVLC tracing
+ * These functions give access to the tracing of the decoding pipelines.
+ * @{
+ */
+
+/**
+ * Write the events traced in the input, decoder, output and stream output
+ * threads to a file, in the Chrome trace JSON format, as loaded by
+ * chrome://tracing and Perfetto.
+ *
+ * \note The tracing is only available if LibVLC was configured with
+ * --enable-trace.
+ *
+ * \param p_instance the libvlc instance
+ * \param psz_path path of the file to write
+ * \return 0 on success, -1 on error or if the tracing is not available
+ * \version LibVLC 3.0.0 and later.
+ */
+LIBVLC_API
+int libvlc_trace_dump( libvlc_instance_t *p_instance, const char *psz_path );
+
+/** @} */
+
 # ifdef __cplusplus
 }
 # endif
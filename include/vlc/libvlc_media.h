@@ -109,6 +109,11 @@ typedef enum libvlc_track_type_t
     libvlc_track_text      = 2
 } libvlc_track_type_t;
 
+/**
+ * Number of buckets of the audio drift distribution of the media statistics
+ */
+#define LIBVLC_MEDIA_STATS_DRIFT_BUCKETS 10
+
 typedef struct libvlc_media_stats_t
 {
     /* Input */
@@ -132,6 +137,17 @@ typedef struct libvlc_media_stats_t
     /* Audio output */
     int         i_played_abuffers;
     int         i_lost_abuffers;
+    int         i_audio_latency;    /**< Last output latency (µs) */
+    int         i_audio_drift;      /**< Last A/V drift (µs) */
+    int         i_audio_drift_max;  /**< Largest absolute A/V drift (µs) */
+    int         i_audio_resampling; /**< Resampling adjustment (Hz) */
+    int         i_audio_underruns;  /**< Flushes of a late output */
+    int         i_audio_silences;   /**< Silences inserted before an early
+                                         output */
+    /** Distribution of the absolute A/V drifts: the bucket i counts the
+     * drifts below (1 << i) milliseconds (and not counted by the previous
+     * buckets), the last bucket counts the remaining drifts. */
+    int         pi_audio_drift[LIBVLC_MEDIA_STATS_DRIFT_BUCKETS];
 
     /* Stream output */
     int         i_sent_packets;
@@ -291,6 +307,11 @@ typedef enum libvlc_media_parse_flag_t
      * when the input is asking for credentials.
      */
     libvlc_media_do_interact    = 0x08,
+    /**
+     * Preparse this item before the other pending ones, typically because it
+     * is visible to the user.
+     */
+    libvlc_media_parse_priority = 0x10,
 } libvlc_media_parse_flag_t;
 
 /**
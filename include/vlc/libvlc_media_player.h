@@ -274,6 +274,38 @@ LIBVLC_API void libvlc_media_player_pause ( libvlc_media_player_t *p_mi );
  */
 LIBVLC_API void libvlc_media_player_stop ( libvlc_media_player_t *p_mi );
 
+/**
+ * Open a media on standby, to switch to it quickly (e.g. adjacent live
+ * channels)
+ *
+ * The media is opened and demuxed, and its decoders are created, but it is
+ * neither decoded nor output: the video is kept from its last key frame on.
+ * When the media is later set with libvlc_media_player_set_media(),
+ * libvlc_media_player_play() switches to the standby input, reusing the
+ * video and audio outputs of the media player, instead of opening it.
+ *
+ * \note A standby input keeps receiving the data of the stream, it is
+ * meant for live streams.
+ *
+ * \param p_mi the Media Player
+ * \param p_md the media to open on standby
+ * \return 0 on success, -1 on error (e.g. already on standby).
+ * \version LibVLC 3.0.0 or later
+ */
+LIBVLC_API int libvlc_media_player_add_standby( libvlc_media_player_t *p_mi,
+                                                libvlc_media_t *p_md );
+
+/**
+ * Close the standby input of a media
+ *
+ * \param p_mi the Media Player
+ * \param p_md the media that was opened on standby
+ * \return 0 on success, -1 if the media is not on standby.
+ * \version LibVLC 3.0.0 or later
+ */
+LIBVLC_API int libvlc_media_player_remove_standby( libvlc_media_player_t *p_mi,
+                                                   libvlc_media_t *p_md );
+
 /**
  * Set a renderer to the media player
  *
@@ -337,6 +369,20 @@ typedef void (*libvlc_video_unlock_cb)(void *opaque, void *picture,
  */
 typedef void (*libvlc_video_display_cb)(void *opaque, void *picture);
 
+/**
+ * Callback prototype to release a picture buffer.
+ *
+ * With direct rendering, picture buffers are lent to LibVLC from the lock
+ * callback until the release callback. In the meantime, the video decoder
+ * writes into them, and can keep reading them as references to decode later
+ * pictures, even after they were displayed.
+ *
+ * \param opaque private pointer as passed to libvlc_video_set_callbacks() [IN]
+ * \param picture private pointer returned from the @ref libvlc_video_lock_cb
+ *                callback [IN]
+ */
+typedef void (*libvlc_video_release_cb)(void *opaque, void *picture);
+
 /**
  * Callback prototype to configure picture buffers format.
  * This callback gets the format of the video as output by the video decoder
@@ -405,7 +451,8 @@ typedef void (*libvlc_video_cleanup_cb)(void *opaque);
  *   cropping and/or picture re-orientation, must be performed by the CPU
  *   instead of the GPU.
  * - Memory copying is required between LibVLC reference picture buffers and
- *   application buffers (between lock and unlock callbacks).
+ *   application buffers (between lock and unlock callbacks), unless
+ *   libvlc_video_set_release_callback() is used.
  *
  * \param mp the media player
  * \param lock callback to lock video memory (must not be NULL)
@@ -456,6 +503,146 @@ void libvlc_video_set_format_callbacks( libvlc_media_player_t *mp,
                                         libvlc_video_format_cb setup,
                                         libvlc_video_cleanup_cb cleanup );
 
+/**
+ * Render video directly into the application picture buffers.
+ * This only works in combination with libvlc_video_set_callbacks().
+ *
+ * Instead of copying each picture into the buffer returned by the lock
+ * callback, LibVLC hands that buffer to the video decoder (or to the video
+ * converter, if the format selected by the application differs from the
+ * decoded one). The buffer remains in use until the release callback,
+ * so the application must provide as many buffers as the number returned by
+ * the @ref libvlc_video_format_cb callback, or return NULL planes from the
+ * lock callback when none is available (the picture is then dropped).
+ *
+ * The lock callback may be invoked from the decoder threads, concurrently
+ * with the display callback. The unlock callback still indicates that the
+ * picture is complete, and the display callback that it must be shown.
+ *
+ * \note Decoders only write directly into buffers whose planes and pitches
+ * are suitably aligned for them; 64 bytes are always enough. The number of
+ * lines should also be a multiple of 32, to leave room to the decoders.
+ *
+ * \param mp the media player
+ * \param release callback to release video memory (or NULL to copy the
+ *                pictures into the buffers, as by default)
+ * \version LibVLC 3.0.0 or later
+ */
+LIBVLC_API
+void libvlc_video_set_release_callback( libvlc_media_player_t *mp,
+                                        libvlc_video_release_cb release );
+
+/**
+ * Callback prototype called to initialize the application rendering.
+ *
+ * \param opaque private pointer passed to
+ *               libvlc_video_set_output_callbacks() [IN/OUT]
+ * \return true on success
+ */
+typedef bool (*libvlc_video_output_setup_cb)(void **opaque);
+
+/**
+ * Callback prototype called to update the size of the render target.
+ *
+ * The OpenGL context is current during the callback. The application
+ * (re)allocates its render target, typically a framebuffer object backed by
+ * a texture of its own, and binds it. Each picture is then drawn into it.
+ *
+ * \param opaque private pointer passed to
+ *               libvlc_video_set_output_callbacks() [IN]
+ * \param width the rendering width in pixels [IN]
+ * \param height the rendering height in pixels [IN]
+ * \return true on success
+ */
+typedef bool (*libvlc_video_update_output_cb)(void *opaque, unsigned width,
+                                              unsigned height);
+
+/**
+ * Callback prototype called after a picture was drawn, and must be shown.
+ *
+ * The OpenGL context is current during the callback, so that the
+ * application can flush the rendering commands, or insert a fence (e.g.
+ * glFenceSync()) to wait for them in its own context before compositing.
+ * The render target is not used by LibVLC again until the next picture.
+ *
+ * \param opaque private pointer passed to
+ *               libvlc_video_set_output_callbacks() [IN]
+ */
+typedef void (*libvlc_video_swap_cb)(void *opaque);
+
+/**
+ * Callback prototype to make the OpenGL context current or not.
+ *
+ * \param opaque private pointer passed to
+ *               libvlc_video_set_output_callbacks() [IN]
+ * \param enter true to make the context current, false to release it [IN]
+ * \return true on success
+ */
+typedef bool (*libvlc_video_make_current_cb)(void *opaque, bool enter);
+
+/**
+ * Callback prototype to load an OpenGL (or EGL) function.
+ *
+ * \param opaque private pointer passed to
+ *               libvlc_video_set_output_callbacks() [IN]
+ * \param name name of the function to load [IN]
+ * \return a pointer to the function, or NULL if it is not available
+ */
+typedef void *(*libvlc_video_get_proc_address_cb)(void *opaque,
+                                                  const char *name);
+
+/**
+ * Enumeration of the graphic APIs of libvlc_video_set_output_callbacks()
+ */
+typedef enum libvlc_video_engine_t {
+    libvlc_video_engine_opengl,
+    libvlc_video_engine_gles2,
+} libvlc_video_engine_t;
+
+/**
+ * Set callbacks to render decoded video into an OpenGL context of the
+ * application.
+ *
+ * Unlike libvlc_video_set_callbacks(), pictures remain on the GPU:
+ * hardware decoded surfaces are imported as textures of the application
+ * context by the OpenGL interop converters (VA-API through EGL DMA-BUF
+ * import, or CoreVideo on macOS), and drawn into the render target of the
+ * application. No picture is read back to system memory.
+ *
+ * For the VA-API interop, the context must be an EGL context, and the
+ * get_proc_address callback must also load the EGL functions, as
+ * eglGetProcAddress() does with EGL 1.5 or EGL_KHR_get_all_proc_addresses.
+ *
+ * The callbacks are invoked from the video output thread. The context must
+ * not be current in any other thread between make_current calls.
+ *
+ * \param mp the media player
+ * \param engine the graphic API of the context
+ * \param setup_cb callback called to initialize the rendering (or NULL)
+ * \param cleanup_cb callback called to release the rendering resources
+ *                   (or NULL)
+ * \param update_output_cb callback called to resize the render target
+ *                         (or NULL)
+ * \param swap_cb callback called when a picture is drawn (cannot be NULL)
+ * \param make_current_cb callback to make the context current or not
+ *                        (cannot be NULL)
+ * \param get_proc_address_cb callback to load the OpenGL functions
+ *                            (cannot be NULL)
+ * \param opaque private pointer passed to the callbacks
+ * \return 0 on success, -1 if the engine is not supported
+ * \version LibVLC 3.0.0 or later
+ */
+LIBVLC_API
+int libvlc_video_set_output_callbacks( libvlc_media_player_t *mp,
+                                       libvlc_video_engine_t engine,
+                                       libvlc_video_output_setup_cb setup_cb,
+                                       libvlc_video_cleanup_cb cleanup_cb,
+                                       libvlc_video_update_output_cb update_output_cb,
+                                       libvlc_video_swap_cb swap_cb,
+                                       libvlc_video_make_current_cb make_current_cb,
+                                       libvlc_video_get_proc_address_cb get_proc_address_cb,
+                                       void *opaque );
+
 /**
  * Set the NSView handler where the media player should render its video output.
  *
@@ -775,6 +962,94 @@ LIBVLC_API
 void libvlc_audio_set_format( libvlc_media_player_t *mp, const char *format,
                               unsigned rate, unsigned channels );
 
+/**
+ * Opaque audio samples ring buffer.
+ *
+ * The audio output copies the decoded samples directly into the ring buffer
+ * memory, and the application reads them from any thread, without locking.
+ * There must be a single reading thread at a time.
+ */
+typedef struct libvlc_audio_ring_t libvlc_audio_ring_t;
+
+/**
+ * Creates an audio samples ring buffer.
+ *
+ * \param samples memory of the samples, that must remain valid until the ring
+ *                buffer is released by all its users
+ * \param frames ring buffer capacity in frames (samples of all channels)
+ * \param frame_size frame size in bytes, e.g. 4 for stereo S16N
+ * \return the ring buffer, or NULL on error
+ * \version LibVLC 3.0.0 or later
+ */
+LIBVLC_API
+libvlc_audio_ring_t *libvlc_audio_ring_new( void *samples, size_t frames,
+                                            unsigned frame_size );
+
+/**
+ * Releases an audio samples ring buffer.
+ *
+ * The media player keeps its own reference while the ring buffer is in use.
+ *
+ * \param ring the ring buffer
+ * \version LibVLC 3.0.0 or later
+ */
+LIBVLC_API
+void libvlc_audio_ring_release( libvlc_audio_ring_t *ring );
+
+/**
+ * Gets the next samples to play from an audio ring buffer.
+ *
+ * \param ring the ring buffer
+ * \param samples pointer to the first frame [OUT]
+ * \return the number of contiguous frames available (possibly zero), that
+ *         can be fewer than all the available frames when the ring buffer
+ *         wraps around
+ * \version LibVLC 3.0.0 or later
+ */
+LIBVLC_API
+size_t libvlc_audio_ring_peek( libvlc_audio_ring_t *ring,
+                               const void **samples );
+
+/**
+ * Releases frames read after libvlc_audio_ring_peek().
+ *
+ * \param ring the ring buffer
+ * \param frames the number of frames played, at most the peeked ones
+ * \version LibVLC 3.0.0 or later
+ */
+LIBVLC_API
+void libvlc_audio_ring_consume( libvlc_audio_ring_t *ring, size_t frames );
+
+/**
+ * Sets the latency of the application, between reading samples from an
+ * audio ring buffer and their rendering.
+ *
+ * \param ring the ring buffer
+ * \param latency latency in microseconds
+ * \version LibVLC 3.0.0 or later
+ */
+LIBVLC_API
+void libvlc_audio_ring_set_latency( libvlc_audio_ring_t *ring,
+                                    int64_t latency );
+
+/**
+ * Sets an audio ring buffer as the audio output.
+ *
+ * The samples format is "S16N", with the rate and the channels count
+ * selected by libvlc_audio_set_format() or libvlc_audio_set_format_callbacks().
+ * The frame size of the ring buffer must match the channels count.
+ * The play callback of libvlc_audio_set_callbacks() is not used, while the
+ * other callbacks still are if set. The audio delay accounts for the frames
+ * not read yet from the ring buffer and for the application latency.
+ *
+ * \param mp the media player
+ * \param ring the ring buffer, or NULL to stop using one
+ * \version LibVLC 3.0.0 or later
+ */
+LIBVLC_API
+void libvlc_audio_set_ring( libvlc_media_player_t *mp,
+                            libvlc_audio_ring_t *ring );
+
 /** \bug This might go away ... to be replaced by a broader system */
 
 /**
@@ -1136,6 +1411,57 @@ LIBVLC_API
 int libvlc_video_get_cursor( libvlc_media_player_t *p_mi, unsigned num,
                              int *px, int *py );
 
+/**
+ * Number of buckets of the video frame timing histograms
+ */
+#define LIBVLC_VIDEO_TIMING_BUCKETS 16
+
+/**
+ * Video frame durations histogram.
+ *
+ * The bucket i counts the durations below (128 << i) microseconds (and not
+ * counted by the previous buckets). The last bucket counts the remaining
+ * durations.
+ */
+typedef struct libvlc_video_timing_histogram_t
+{
+    uint64_t i_count; /**< Number of durations */
+    uint64_t i_sum;   /**< Sum of the durations (microseconds) */
+    uint64_t i_max;   /**< Longest duration (microseconds) */
+    uint64_t pi_buckets[LIBVLC_VIDEO_TIMING_BUCKETS];
+} libvlc_video_timing_histogram_t;
+
+/**
+ * Video frame timings
+ */
+typedef struct libvlc_video_timing_t
+{
+    /** From the decoder output to the display of a frame */
+    libvlc_video_timing_histogram_t latency;
+    /** Delay of the display of a frame after its presentation date */
+    libvlc_video_timing_histogram_t late;
+    /** Filtering, subtitles blending and preparation of a frame */
+    libvlc_video_timing_histogram_t prepare;
+    /** Display of a prepared frame */
+    libvlc_video_timing_histogram_t display;
+    /** Between the display of two frames */
+    libvlc_video_timing_histogram_t interval;
+} libvlc_video_timing_t;
+
+/**
+ * Get the frame timings of a video, since its output was created.
+ *
+ * \version LibVLC 3.0.0 and later.
+ *
+ * \param p_mi media player
+ * \param num number of the video (starting from, and most commonly 0)
+ * \param p_timing pointer to get the timings [OUT]
+ * \return 0 on success, -1 if the specified video does not exist
+ */
+LIBVLC_API
+int libvlc_video_get_timing( libvlc_media_player_t *p_mi, unsigned num,
+                             libvlc_video_timing_t *p_timing );
+
 /**
  * Get the current video scaling factor.
  * See also libvlc_video_set_scale().
@@ -0,0 +1,181 @@
+/*****************************************************************************
+ * vlc_aout_ring.h: audio samples ring buffer
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_AOUT_RING_H
+#define VLC_AOUT_RING_H 1
+
+#include <assert.h>
+#include <vlc_atomic.h>
+
+/**
+ * \defgroup audio_ring Audio samples ring buffer
+ * \ingroup audio_output
+ * Lock-free ring buffer of audio frames, with a single producer, the audio
+ * output, and a single consumer, the application. The samples memory is
+ * provided by the application.
+ * @{
+ * \file
+ */
+
+typedef struct aout_ring_t
+{
+    uint8_t *buffer; /**< Samples memory */
+    size_t frames; /**< Ring capacity in frames */
+    unsigned frame_size; /**< Frame size in bytes */
+
+    /* Frames positions since the creation. Only the producer updates the
+     * written and flushed positions, and only the consumer the read one. */
+    atomic_uint_least64_t written;
+    atomic_uint_least64_t flushed; /**< written position at the last flush */
+    atomic_uint_least64_t read;
+
+    atomic_int_least64_t latency; /**< consumer latency (microseconds) */
+    atomic_uint refs;
+} aout_ring_t;
+
+static inline void aout_RingInit(aout_ring_t *ring, void *buffer,
+                                 size_t frames, unsigned frame_size)
+{
+    ring->buffer = (uint8_t *)buffer;
+    ring->frames = frames;
+    ring->frame_size = frame_size;
+    atomic_init(&ring->written, 0);
+    atomic_init(&ring->flushed, 0);
+    atomic_init(&ring->read, 0);
+    atomic_init(&ring->latency, 0);
+    atomic_init(&ring->refs, 1);
+}
+
+static inline aout_ring_t *aout_RingHold(aout_ring_t *ring)
+{
+    atomic_fetch_add_explicit(&ring->refs, 1, memory_order_relaxed);
+    return ring;
+}
+
+/**
+ * Releases a reference, the last one freeing the ring (but not the samples
+ * memory).
+ */
+static inline void aout_RingRelease(aout_ring_t *ring)
+{
+    if (atomic_fetch_sub_explicit(&ring->refs, 1, memory_order_acq_rel) == 1)
+        free(ring);
+}
+
+/**
+ * Copies frames into the ring (producer).
+ * \return the number of frames written, less than requested if the ring is
+ * full
+ */
+static inline size_t aout_RingWrite(aout_ring_t *ring, const void *data,
+                                    size_t count)
+{
+    uint_least64_t w = atomic_load_explicit(&ring->written,
+                                            memory_order_relaxed);
+    uint_least64_t r = atomic_load_explicit(&ring->read,
+                                            memory_order_acquire);
+    size_t room = ring->frames - (size_t)(w - r);
+
+    if (count > room)
+        count = room;
+
+    /* Up to the end of the samples memory, then from its start */
+    size_t offset = w % ring->frames;
+    size_t n = ring->frames - offset;
+    if (n > count)
+        n = count;
+    memcpy(ring->buffer + offset * ring->frame_size, data,
+           n * ring->frame_size);
+    memcpy(ring->buffer, (const uint8_t *)data + n * ring->frame_size,
+           (count - n) * ring->frame_size);
+
+    atomic_store_explicit(&ring->written, w + count, memory_order_release);
+    return count;
+}
+
+/**
+ * Discards the frames not read yet (producer).
+ */
+static inline void aout_RingFlush(aout_ring_t *ring)
+{
+    atomic_store_explicit(&ring->flushed,
+                          atomic_load_explicit(&ring->written,
+                                               memory_order_relaxed),
+                          memory_order_release);
+}
+
+/**
+ * Returns the frames not read yet.
+ */
+static inline size_t aout_RingGetPending(aout_ring_t *ring)
+{
+    uint_least64_t w = atomic_load_explicit(&ring->written,
+                                            memory_order_acquire);
+    uint_least64_t f = atomic_load_explicit(&ring->flushed,
+                                            memory_order_relaxed);
+    uint_least64_t r = atomic_load_explicit(&ring->read,
+                                            memory_order_relaxed);
+    return w - (r > f ? r : f);
+}
+
+/**
+ * Gets the next contiguous frames to read (consumer).
+ * \param data pointer to the first frame [OUT]
+ * \return the number of contiguous frames, that can be fewer than the
+ * pending ones when the ring wraps around
+ */
+static inline size_t aout_RingPeek(aout_ring_t *ring, const void **data)
+{
+    uint_least64_t r = atomic_load_explicit(&ring->read,
+                                            memory_order_relaxed);
+    uint_least64_t f = atomic_load_explicit(&ring->flushed,
+                                            memory_order_acquire);
+    if (f > r)
+    {   /* Skip the flushed frames */
+        r = f;
+        atomic_store_explicit(&ring->read, r, memory_order_release);
+    }
+
+    uint_least64_t w = atomic_load_explicit(&ring->written,
+                                            memory_order_acquire);
+    size_t offset = r % ring->frames;
+    size_t count = w - r;
+
+    if (count > ring->frames - offset)
+        count = ring->frames - offset;
+    *data = ring->buffer + offset * ring->frame_size;
+    return count;
+}
+
+/**
+ * Releases frames read after aout_RingPeek() (consumer).
+ */
+static inline void aout_RingConsume(aout_ring_t *ring, size_t count)
+{
+    uint_least64_t r = atomic_load_explicit(&ring->read,
+                                            memory_order_relaxed);
+    assert(count <= atomic_load_explicit(&ring->written,
+                                         memory_order_relaxed) - r);
+    atomic_store_explicit(&ring->read, r + count, memory_order_release);
+}
+
+/** @} */
+
+#endif
@@ -41,6 +41,9 @@ typedef struct audio_volume audio_volume_t;
 
 /**
  * Audio volume
+ *
+ * The amplifier may ramp the gain from the one of the previous buffer, so
+ * that the volume changes do not click.
  */
 struct audio_volume
 {
@@ -48,6 +51,7 @@ struct audio_volume
 
     vlc_fourcc_t format; /**< Audio samples format */
     void (*amplify)(audio_volume_t *, block_t *, float); /**< Amplifier */
+    void *sys; /**< Private data of the amplifier */
 };
 
 /** @} */
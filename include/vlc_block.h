@@ -213,6 +213,34 @@ static inline block_t *block_Duplicate( block_t *p_block )
     return p_dup;
 }
 
+/**
+ * Makes a block payload shareable.
+ *
+ * Converts a block so that its payload can be referenced by other blocks,
+ * with block_Share(), rather than copied. Only the given block is converted,
+ * not the rest of its chain.
+ *
+ * @param block block to convert (this function takes ownership)
+ * @return the shareable block, or NULL on error (the block is released)
+ */
+VLC_API block_t *block_Shareable(block_t *block) VLC_USED;
+
+/**
+ * Shares a block payload.
+ *
+ * Creates a block referencing the payload of a shareable block, without
+ * copying it. Each block has its own properties and payload boundaries, but
+ * the payload data itself is shared: it must be treated as read-only by all
+ * the owners of the sharing blocks. block_TryRealloc() and block_Realloc()
+ * make a private copy whenever the payload needs to grow.
+ *
+ * The shared payload is released with the last of its blocks.
+ *
+ * @param block a block returned by block_Shareable() or block_Share()
+ * @return the new block, or NULL on error
+ */
+VLC_API block_t *block_Share(block_t *block) VLC_USED;
+
 /**
  * Wraps heap in a block.
  *
@@ -621,6 +649,94 @@ static inline void vlc_fifo_Cleanup(void *fifo)
 
 /** @} */
 
+/**
+ * \defgroup spsc Single producer single consumer block queue
+ * Bounded lock-less block queue
+ *
+ * Unlike the block FIFO, this queue takes no lock to queue or dequeue
+ * blocks. The threads only sleep, and get woken up, when the queue is
+ * respectively empty or full. It must only be used by exactly one producer
+ * thread and one consumer thread.
+ * @{
+ */
+
+typedef struct vlc_spsc vlc_spsc_t;
+
+/**
+ * Creates a single producer single consumer queue of blocks.
+ *
+ * @param capacity maximum number of queued blocks (rounded up to a power
+ * of two)
+ * @return the queue or NULL on memory error
+ */
+VLC_API vlc_spsc_t *vlc_spsc_New(size_t capacity) VLC_USED VLC_MALLOC;
+
+/**
+ * Destroys a queue created by vlc_spsc_New().
+ *
+ * @note Any queued blocks are also destroyed.
+ * @warning Neither the producer nor the consumer may be using the queue
+ * anymore.
+ */
+VLC_API void vlc_spsc_Delete(vlc_spsc_t *);
+
+/**
+ * Queues a block, waiting for room if the queue is full.
+ *
+ * @note This function is not a cancellation point.
+ * @warning Only the producer thread may call this function.
+ *
+ * @return false if the queue was closed (the block is then released)
+ */
+VLC_API bool vlc_spsc_Push(vlc_spsc_t *, block_t *);
+
+/**
+ * Queues a block if the queue is not full.
+ *
+ * @warning Only the producer thread may call this function.
+ *
+ * @return false if the queue is full (the block is then not queued)
+ */
+VLC_API bool vlc_spsc_TryPush(vlc_spsc_t *, block_t *) VLC_USED;
+
+/**
+ * Dequeues a block, waiting for one if the queue is empty.
+ *
+ * @note This function is not a cancellation point.
+ * @warning Only the consumer thread may call this function.
+ *
+ * @return the first block, or NULL if the queue is empty and closed
+ */
+VLC_API block_t *vlc_spsc_Pop(vlc_spsc_t *) VLC_USED;
+
+/**
+ * Dequeues a block if the queue is not empty.
+ *
+ * @warning Only the consumer thread may call this function.
+ *
+ * @return the first block or NULL if the queue is empty
+ */
+VLC_API block_t *vlc_spsc_TryPop(vlc_spsc_t *) VLC_USED;
+
+/**
+ * Closes a queue.
+ *
+ * Wakes up the waiting producer and consumer up. Further pushes fail, and
+ * pops fail once the queued blocks are dequeued. This may be called from
+ * any thread.
+ */
+VLC_API void vlc_spsc_Close(vlc_spsc_t *);
+
+/**
+ * Counts blocks in a queue.
+ *
+ * The count may already be outdated when returning, unless called from the
+ * producer (for an upper bound) or the consumer (for a lower bound).
+ */
+VLC_API size_t vlc_spsc_GetCount(const vlc_spsc_t *) VLC_USED;
+
+/** @} */
+
 /** @} */
 
 #endif /* VLC_BLOCK_H */
@@ -50,6 +50,18 @@
  */
 VLC_API size_t vlc_towc(const char *str, uint32_t *restrict pwc);
 
+/**
+ * Measures the valid UTF-8 prefix of a string.
+ *
+ * This is faster than decoding the string with vlc_towc(), especially when
+ * it is mostly made of ASCII characters.
+ *
+ * \param str a null-terminated bytes sequence
+ * \return the size in bytes of the longest valid UTF-8 prefix of str, i.e.
+ * the offset of either the null terminator, or the first invalid sequence
+ */
+VLC_API size_t vlc_utf8_span(const char *str) VLC_USED;
+
 /**
  * Checks UTF-8 validity.
  *
@@ -62,15 +74,8 @@ VLC_API size_t vlc_towc(const char *str, uint32_t *restrict pwc);
  */
 VLC_USED static inline const char *IsUTF8(const char *str)
 {
-    size_t n;
-    uint32_t cp;
-
-    while ((n = vlc_towc(str, &cp)) != 0)
-        if (likely(n != (size_t)-1))
-            str += n;
-        else
-            return NULL;
-    return str;
+    str += vlc_utf8_span(str);
+    return (*str == '\0') ? str : NULL;
 }
 
 /**
@@ -94,17 +99,12 @@ VLC_USED static inline const char *IsUTF8(const char *str)
 static inline char *EnsureUTF8(char *str)
 {
     char *ret = str;
-    size_t n;
-    uint32_t cp;
-
-    while ((n = vlc_towc(str, &cp)) != 0)
-        if (likely(n != (size_t)-1))
-            str += n;
-        else
-        {
-            *str++ = '?';
-            ret = NULL;
-        }
+
+    while (*(str += vlc_utf8_span(str)) != '\0')
+    {
+        *str++ = '?';
+        ret = NULL;
+    }
     return ret;
 }
 
@@ -47,6 +47,8 @@ typedef struct decoder_owner_sys_t decoder_owner_sys_t;
 
 typedef struct decoder_cc_desc_t decoder_cc_desc_t;
 
+typedef struct decoder_load_t decoder_load_t;
+
 /*
  * BIG FAT WARNING : the code relies in the first 4 members of filter_t
  * and decoder_t to be the same, so if you have anything to add, do it
@@ -175,6 +177,10 @@ struct decoder_t
      * XXX use decoder_GetDisplayRate */
     int             (*pf_get_display_rate)( decoder_t * );
 
+    /* Load of the pipeline
+     * XXX use decoder_GetLoad */
+    int             (*pf_get_load)( decoder_t *, decoder_load_t * );
+
     /* XXX use decoder_QueueVideo or decoder_QueueVideoWithCc */
     int             (*pf_queue_video)( decoder_t *, picture_t * );
     /* XXX use decoder_QueueAudio */
@@ -198,6 +204,14 @@ struct decoder_cc_desc_t
     int i_reorder_depth;     /* reorder depth, -1 for no reorder, 0 for old P/B flag based */
 };
 
+/* Load of the decoding pipeline, see decoder_GetLoad() */
+struct decoder_load_t
+{
+    unsigned i_queued;       /* blocks waiting to be decoded */
+    unsigned i_displayed;    /* pictures displayed since the previous call */
+    mtime_t  i_late;         /* their average display delay, 0 if none */
+};
+
 /**
  * @}
  */
@@ -417,6 +431,14 @@ VLC_API mtime_t decoder_GetDisplayDate( decoder_t *, mtime_t ) VLC_USED;
  */
 VLC_API int decoder_GetDisplayRate( decoder_t * ) VLC_USED;
 
+/**
+ * This function returns the load of the decoding pipeline: the blocks
+ * waiting to be decoded and how late the pictures are displayed since the
+ * previous call. It returns VLC_EGENERIC if the owner does not know.
+ * You MUST use it *only* to adapt the decoding speed.
+ */
+VLC_API int decoder_GetLoad( decoder_t *, decoder_load_t * ) VLC_USED;
+
 /** @} */
 /** @} */
 #endif /* _VLC_CODEC_H */
@@ -466,5 +466,50 @@ VLC_API int filter_chain_MouseEvent( filter_chain_t *,
 int filter_chain_ForEach( filter_chain_t *chain,
                           int (*cb)( filter_t *, void * ), void *opaque );
 
+/** @} */
+
+/**
+ * \defgroup filter_slices Slice threading
+ * \ingroup filter
+ * Worker threads shared by the video filters, to process horizontal bands of
+ * a picture concurrently.
+ *
+ * A filter whose rows can be computed independently holds the pool when it
+ * is opened, and runs its per-picture work through filter_SlicesRun().
+ * @{
+ */
+typedef struct filter_slices_t filter_slices_t;
+
+/**
+ * Holds the shared slice threads.
+ *
+ * \return the pool, or NULL if slice threading is disabled, in which case
+ * filter_SlicesRun() executes inline.
+ */
+VLC_API filter_slices_t *filter_SlicesHold( vlc_object_t * ) VLC_USED;
+#define filter_SlicesHold(o) filter_SlicesHold(VLC_OBJECT(o))
+
+/**
+ * Releases the shared slice threads.
+ */
+VLC_API void filter_SlicesRelease( filter_slices_t * );
+
+/**
+ * Runs a callback over a range of rows.
+ *
+ * The range [0, count) is split into consecutive bands, which are processed
+ * concurrently by the pool and the calling thread. The call returns once all
+ * the bands have been processed.
+ *
+ * \param slices the pool (or NULL to run inline)
+ * \param count number of rows (in any unit suitable to the caller)
+ * \param run callback processing the rows [first, last)
+ * \param opaque data pointer for the callback
+ */
+VLC_API void filter_SlicesRun( filter_slices_t *slices, unsigned count,
+                               void (*run)( void *opaque, unsigned first,
+                                            unsigned last ),
+                               void *opaque );
+
 /** @} */
 #endif /* _VLC_FILTER_H */
@@ -36,6 +36,9 @@
 extern "C" {
 # endif
 
+/* Number of idle decoders kept by an image handler for other formats */
+#define IMAGE_DECODER_CACHE 4
+
 struct image_handler_t
 {
     picture_t * (*pf_read)      ( image_handler_t *, block_t *,
@@ -54,6 +57,7 @@ struct image_handler_t
     /* Private properties */
     vlc_object_t *p_parent;
     decoder_t *p_dec;
+    decoder_t *pp_dec_cache[IMAGE_DECODER_CACHE];
     encoder_t *p_enc;
     filter_t  *p_filter;
 
@@ -70,6 +74,28 @@ VLC_API void image_HandlerDelete( image_handler_t * );
 #define image_WriteUrl( a, b, c, d, e ) a->pf_write_url( a, b, c, d, e )
 #define image_Convert( a, b, c, d ) a->pf_convert( a, b, c, d )
 
+/**
+ * Reads a batch of images.
+ *
+ * The images are decoded by a pool of worker threads, each keeping its
+ * decoders and converters from one image to the next. Every picture is
+ * converted to the chroma and dimensions of the output format; the
+ * dimensions left to zero are computed to keep the aspect ratio.
+ *
+ * \param obj parent object
+ * \param urls URLs of the images
+ * \param count number of images
+ * \param fmt_out output format
+ * \param pics table of count pictures, set to the decoded pictures,
+ *             or NULL for the images that could not be read
+ * \return the number of images read
+ */
+VLC_API size_t image_ReadUrlBatch( vlc_object_t *obj, const char *const *urls,
+                                   size_t count, const video_format_t *fmt_out,
+                                   picture_t **pics );
+#define image_ReadUrlBatch( a, b, c, d, e ) \
+        image_ReadUrlBatch( VLC_OBJECT(a), b, c, d, e )
+
 VLC_API vlc_fourcc_t image_Type2Fourcc( const char *psz_name );
 VLC_API vlc_fourcc_t image_Ext2Fourcc( const char *psz_name );
 VLC_API vlc_fourcc_t image_Mime2Fourcc( const char *psz_mime );
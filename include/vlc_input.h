@@ -487,6 +487,10 @@ enum input_query_e
     /* External clock managments */
     INPUT_GET_PCR_SYSTEM,   /* arg1=mtime_t *, arg2=mtime_t *       res=can fail */
     INPUT_MODIFY_PCR_SYSTEM,/* arg1=int absolute, arg2=mtime_t      res=can fail */
+
+    /* Standby: the input demuxes but does not decode nor output, so that it
+     * can be switched to at once. It can only be entered before starting. */
+    INPUT_SET_STANDBY,      /* arg1=bool                          res=can fail */
 };
 
 /** @}*/
@@ -352,7 +352,8 @@ typedef enum input_item_meta_request_option_t
     META_REQUEST_OPTION_SCOPE_LOCAL   = 0x01,
     META_REQUEST_OPTION_SCOPE_NETWORK = 0x02,
     META_REQUEST_OPTION_SCOPE_ANY     = 0x03,
-    META_REQUEST_OPTION_DO_INTERACT   = 0x04
+    META_REQUEST_OPTION_DO_INTERACT   = 0x04,
+    META_REQUEST_OPTION_PRIORITY      = 0x08
 } input_item_meta_request_option_t;
 
 /* status of the vlc_InputItemPreparseEnded event */
@@ -374,6 +375,19 @@ VLC_API void libvlc_MetadataCancel( libvlc_int_t *, void * );
 /******************
  * Input stats
  ******************/
+
+/**
+ * Number of buckets of the audio drift distribution
+ */
+#define INPUT_STATS_DRIFT_BUCKETS 10
+
+/**
+ * Upper (excluded) limit, in microseconds, of the absolute A/V drifts
+ * counted by the bucket \p i of the audio drift distribution. The last
+ * bucket has no limit.
+ */
+#define INPUT_STATS_DRIFT_LIMIT(i) (INT64_C(1000) << (i))
+
 struct input_stats_t
 {
     vlc_mutex_t         lock;
@@ -408,6 +422,14 @@ struct input_stats_t
     /* Aout */
     int64_t i_played_abuffers;
     int64_t i_lost_abuffers;
+    int64_t i_aout_latency;     /**< Last measured output latency (µs) */
+    int64_t i_aout_drift;       /**< Last measured A/V drift (µs) */
+    int64_t i_aout_drift_max;   /**< Largest absolute A/V drift (µs) */
+    int64_t i_aout_resampling;  /**< Current resampling adjustment (Hz) */
+    int64_t i_aout_underruns;   /**< Flushes of a late output */
+    int64_t i_aout_silences;    /**< Silences inserted before an early output */
+    /** Absolute A/V drifts distribution, \see INPUT_STATS_DRIFT_LIMIT */
+    int64_t pi_aout_drift[INPUT_STATS_DRIFT_BUCKETS];
 };
 
 /**
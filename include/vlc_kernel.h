@@ -0,0 +1,74 @@
+/*****************************************************************************
+ * vlc_kernel.h: selection of the implementations of processing kernels
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_KERNEL_H
+#define VLC_KERNEL_H 1
+
+/**
+ * \defgroup kernel Processing kernels
+ * \ingroup cpu
+ * Selection of the fastest implementation of a kernel
+ *
+ * A kernel is a small hot function with alternative implementations for
+ * the instruction sets, such as a start code scan or a plane copy. By
+ * default, the most specialized implementation supported by the CPU is
+ * used. With the kernel-autotune option, the implementations are measured
+ * on first use instead, and the fastest one is remembered across runs.
+ * @{
+ */
+
+/** Generic kernel function, cast to and from the actual kernel type */
+typedef void (*vlc_kernel_func_t)(void);
+
+typedef struct vlc_kernel_impl
+{
+    const char *name; /**< name of the implementation, e.g. "sse2" */
+    vlc_kernel_func_t func;
+    unsigned cpu; /**< required VLC_CPU_* flags, 0 for none */
+} vlc_kernel_impl_t;
+
+/**
+ * Measures one implementation of a kernel.
+ *
+ * \param func implementation to run on a representative workload
+ * \return the time spent in the implementation
+ */
+typedef mtime_t (*vlc_kernel_bench_cb)(vlc_kernel_func_t func, void *opaque);
+
+/**
+ * Selects an implementation of a kernel.
+ *
+ * \param kernel name of the kernel, unique among all modules
+ * \param impls implementations, from the generic one (first, without CPU
+ * requirements) to the most specialized ones
+ * \param bench callback to measure the implementations, or NULL
+ * \return the selected implementation (never NULL)
+ */
+VLC_API vlc_kernel_func_t vlc_kernel_Select(vlc_object_t *obj,
+                                            const char *kernel,
+                                            const vlc_kernel_impl_t *impls,
+                                            size_t count,
+                                            vlc_kernel_bench_cb bench,
+                                            void *opaque) VLC_USED;
+#define vlc_kernel_Select(o, k, i, c, b, p) \
+    vlc_kernel_Select(VLC_OBJECT(o), k, i, c, b, p)
+
+/** @} */
+#endif
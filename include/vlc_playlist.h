@@ -109,6 +109,11 @@ struct intf_thread_t;
  * - "leaf-to-parent": It will contain the playlist_item_t->i_id of an item that is transformed
  *   into a node.
  *
+ * - "playlist-batch": It will contain a pointer to the playlist_item_t node
+ * whose sub-tree changed, when a batch of changes is committed, see
+ * playlist_BeginBatch(). Interfaces can ignore the add and delete events
+ * while playlist_IsBatching() is true, and update that node once instead.
+ *
  * The playlist contains rate-variable which is propagated to current input if
  * available also rate-slower/rate-faster is in use.
  */
@@ -259,7 +264,7 @@ enum {
  * - probe, initialize or deinitialize a module or a plugin,
  * - install or deinstall a variable or event callback,
  * - set a variable or trigger a variable callback, with the sole exception
- *   of the playlist core triggering add/remove/leaf item callbacks,
+ *   of the playlist core triggering add/remove/leaf item and batch callbacks,
  * - invoke a module/plugin callback other than:
  *   - playlist export,
  *   - logger message callback.
@@ -395,6 +400,21 @@ VLC_API playlist_item_t * playlist_NodeCreate( playlist_t *, const char *, playl
 VLC_API playlist_item_t * playlist_ChildSearchName(playlist_item_t*, const char* ) VLC_USED;
 VLC_API void playlist_NodeDelete( playlist_t *, playlist_item_t * );
 
+/**
+ * Starts a batch of changes below a node.
+ *
+ * The add and delete events are still triggered for each item, then the
+ * "playlist-batch" event is triggered once by the outermost
+ * playlist_EndBatch(). Batches can be nested, and can span unlocking the
+ * playlist. The playlist must be locked.
+ *
+ * \param p_node node below which the changes occur, or NULL for the root
+ */
+VLC_API void playlist_BeginBatch( playlist_t *, playlist_item_t *p_node );
+VLC_API void playlist_EndBatch( playlist_t * );
+/** Tells whether a batch of changes is ongoing. The playlist must be locked. */
+VLC_API bool playlist_IsBatching( playlist_t * ) VLC_USED;
+
 /**************************
  * Audio output management
  **************************/
@@ -939,6 +939,27 @@ VLC_API void vlc_timer_schedule(vlc_timer_t timer, bool absolute,
  */
 VLC_API unsigned vlc_timer_getoverrun(vlc_timer_t) VLC_USED;
 
+/**
+ * Timers statistics, for the whole process.
+ */
+typedef struct vlc_timer_stats
+{
+    unsigned timers; /**< count of existing timers */
+    unsigned threads; /**< count of threads running the timer callbacks */
+    uint64_t fired; /**< count of callbacks invoked so far */
+    mtime_t latency_avg; /**< average delay of the callbacks */
+    mtime_t latency_max; /**< largest delay of a callback */
+} vlc_timer_stats_t;
+
+/**
+ * Fetches the timers statistics.
+ *
+ * The delay of a callback is the time elapsed between the date the timer was
+ * scheduled for and the start of the callback. It is zero where the system
+ * does not provide it.
+ */
+VLC_API void vlc_timer_getstats(vlc_timer_stats_t *);
+
 /**
  * Count CPUs.
  *
@@ -1056,6 +1077,7 @@ enum
 #ifdef _WIN32
    VLC_MTA_MUTEX,
 #endif
+   VLC_STREAM_CACHE_MUTEX,
    /* Insert new entry HERE */
    VLC_MAX_MUTEX
 };
@@ -184,6 +184,35 @@ VLC_API vlc_tls_t *vlc_tls_ServerSessionCreate(vlc_tls_creds_t *creds,
  */
 VLC_API void vlc_tls_SessionDelete (vlc_tls_t *);
 
+/**
+ * Saves TLS session resumption data.
+ *
+ * Stores the opaque session data (session ID or ticket) negotiated with a
+ * server in the process-wide session cache, so that subsequent client
+ * sessions to the same host can resume it with an abbreviated handshake.
+ * Any previous data for the host is replaced.
+ *
+ * This is meant to be called by TLS back-ends after a successful and
+ * authenticated client handshake.
+ *
+ * @param host server host name
+ * @param data opaque session data
+ * @param len length of session data in bytes
+ */
+VLC_API void vlc_tls_SessionCacheStore(const char *host, const void *data,
+                                       size_t len);
+
+/**
+ * Looks up TLS session resumption data.
+ *
+ * @param host server host name
+ * @param lenp pointer to the length of session data in bytes [OUT]
+ *
+ * @return a heap-allocated copy of the cached session data (use free()),
+ * or NULL if there is no valid cached session for the host.
+ */
+VLC_API void *vlc_tls_SessionCacheLoad(const char *host, size_t *lenp);
+
 static inline int vlc_tls_GetFD(vlc_tls_t *tls)
 {
     return tls->get_fd(tls);
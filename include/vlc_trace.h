@@ -0,0 +1,105 @@
+/*****************************************************************************
+ * vlc_trace.h: hot path tracing
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_TRACE_H
+#define VLC_TRACE_H 1
+
+/**
+ * \defgroup trace Tracing
+ * \ingroup os
+ * Low overhead tracing of the hot paths
+ *
+ * The events are recorded without locks in per-thread ring buffers, and
+ * dumped in the Chrome trace (JSON) format, that chrome://tracing and
+ * Perfetto can load.
+ *
+ * The tracing is only compiled in with the --enable-trace configure flag.
+ * Otherwise, the macros below expand to nothing.
+ *
+ * The names must be string literals: only their address is recorded.
+ * @{
+ */
+
+enum vlc_trace_type
+{
+    VLC_TRACE_BEGIN, /**< start of a slice of time */
+    VLC_TRACE_END, /**< end of the last started slice of time */
+    VLC_TRACE_COUNTER, /**< value of a counter */
+    VLC_TRACE_FLOW_START, /**< a data unit enters the pipeline */
+    VLC_TRACE_FLOW_STEP, /**< a data unit goes through a stage */
+    VLC_TRACE_FLOW_END, /**< a data unit leaves the pipeline */
+};
+
+/**
+ * Records an event in the buffer of the calling thread.
+ *
+ * \param type type of event
+ * \param name name of the slice, of the counter or of the flow
+ * \param value value of the counter, or identifier of the flow
+ */
+VLC_API void vlc_trace_Event(int type, const char *name, int64_t value);
+
+/**
+ * Writes the recorded events of all threads to a file, as a Chrome trace.
+ *
+ * \return VLC_SUCCESS, or VLC_EGENERIC if the tracing is not compiled in or
+ * the file cannot be written
+ */
+VLC_API int vlc_trace_Dump(const char *path);
+
+#ifdef ENABLE_TRACE
+# define vlc_trace_Begin(name) vlc_trace_Event(VLC_TRACE_BEGIN, name, 0)
+# define vlc_trace_End(name)   vlc_trace_Event(VLC_TRACE_END, name, 0)
+# define vlc_trace_Counter(name, value) \
+    vlc_trace_Event(VLC_TRACE_COUNTER, name, value)
+/* The flows of the data units are identified by their timestamps */
+# define vlc_trace_Flow(type, name, id) \
+    do { \
+        if ((id) > VLC_TS_INVALID) \
+            vlc_trace_Event(VLC_TRACE_FLOW_##type, name, id); \
+    } while (0)
+
+static inline void vlc_trace_ScopeEnd(const char *const *name)
+{
+    vlc_trace_Event(VLC_TRACE_END, *name, 0);
+}
+
+/**
+ * Traces a slice of time until the end of the current block of code.
+ * There can only be one scope per block.
+ */
+# define vlc_trace_Scope(name) \
+    const char *const vlc_trace_scope \
+        __attribute__((cleanup(vlc_trace_ScopeEnd))) = (name); \
+    vlc_trace_Begin(vlc_trace_scope)
+#else
+# define vlc_trace_Begin(name) ((void)0)
+# define vlc_trace_End(name) ((void)0)
+# define vlc_trace_Counter(name, value) ((void)0)
+# define vlc_trace_Flow(type, name, id) ((void)0)
+# define vlc_trace_Scope(name) ((void)0)
+#endif
+
+/** Name of the flows of an elementary stream category */
+#define vlc_trace_FlowName(cat) \
+    ((cat) == VIDEO_ES ? "video" : (cat) == AUDIO_ES ? "audio" : "spu")
+
+/** @} */
+#endif
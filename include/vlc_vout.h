@@ -55,6 +55,40 @@ typedef struct {
     unsigned             dpb_size;
 } vout_configuration_t;
 
+/**
+ * Number of buckets of the frame timing histograms
+ */
+#define VOUT_TIMING_BUCKETS 16
+
+/**
+ * Upper (excluded) limit, in microseconds, of the durations counted by the
+ * bucket \p i of a frame timing histogram. The last bucket has no limit.
+ */
+#define VOUT_TIMING_BUCKET_LIMIT(i) (UINT64_C(128) << (i))
+
+/**
+ * Frame durations histogram
+ */
+typedef struct {
+    uint64_t count;                         /**< Number of durations */
+    uint64_t sum;                           /**< Sum of the durations (µs) */
+    uint64_t max;                           /**< Longest duration (µs) */
+    uint64_t buckets[VOUT_TIMING_BUCKETS];
+} vout_timing_histogram_t;
+
+/**
+ * Frame timings of a video output, since its creation
+ */
+typedef struct {
+    vout_timing_histogram_t latency;  /**< From decoder output to display */
+    vout_timing_histogram_t late;     /**< Display after the picture date */
+    vout_timing_histogram_t prepare;  /**< Filtering, blending and prepare */
+    vout_timing_histogram_t display;  /**< Display of the prepared picture */
+    vout_timing_histogram_t interval; /**< Between two displayed pictures */
+    vout_timing_histogram_t presented; /**< On screen after the picture date,
+                                            if reported by the display */
+} vout_timing_t;
+
 /**
  * Video output thread private structure
  */
@@ -145,10 +179,47 @@ VLC_API int vout_GetSnapshot( vout_thread_t *p_vout,
                               video_format_t *p_fmt,
                               const char *psz_format, mtime_t i_timeout );
 
+/**
+ * Receives an asynchronous snapshot.
+ *
+ * \param p_image the encoded picture, to be released by the callee, or NULL
+ *                if the snapshot failed or the vout was closed
+ * \param p_fmt the format of the picture before encoding, or NULL
+ */
+typedef void (*vout_snapshot_cb)( void *p_opaque, block_t *p_image,
+                                  const video_format_t *p_fmt );
+
+/**
+ * This function will request a snapshot without waiting for it.
+ *
+ * The next displayed picture is copied, then encoded in psz_format format by
+ * a background thread, and given to pf_snapshot from that thread. Once the
+ * request is accepted, pf_snapshot is called exactly once.
+ *
+ * i_quality is the encoding quality from 0 to 100 of the lossy formats, or -1
+ * to use the "sout-jpeg-quality" value.
+ *
+ * The request is refused if too many snapshots are pending, or if the
+ * previous one was requested less than "snapshot-interval" ago.
+ */
+VLC_API int vout_GetSnapshotAsync( vout_thread_t *p_vout,
+                                   const char *psz_format, int i_quality,
+                                   vout_snapshot_cb pf_snapshot,
+                                   void *p_opaque );
+
 VLC_API void vout_ChangeAspectRatio( vout_thread_t *p_vout,
                                      unsigned int i_num, unsigned int i_den );
 
 /* */
+/**
+ * Gets the frame timings of a vout.
+ *
+ * The timings are also published every second, as the average durations
+ * of the period, in the "stats-latency", "stats-late", "stats-prepare",
+ * "stats-display" and "stats-interval" integer variables of the vout.
+ */
+VLC_API void vout_GetTiming( vout_thread_t *, vout_timing_t * );
+
 VLC_API picture_t * vout_GetPicture( vout_thread_t * );
 VLC_API void vout_PutPicture( vout_thread_t *, picture_t * );
 
@@ -221,6 +221,11 @@ enum {
 
     /* VR navigation */
     VOUT_DISPLAY_EVENT_VIEWPOINT_MOVED,
+
+    /* A picture reached the screen: mtime_t date of the picture,
+     * mtime_t date of the presentation.
+     * It must be sent from the display callbacks (on the vout thread). */
+    VOUT_DISPLAY_EVENT_PRESENTED,
 };
 
 /**
@@ -406,6 +411,12 @@ static inline void vout_display_SendEventViewpointMoved(vout_display_t *vd,
 {
     vout_display_SendEvent(vd, VOUT_DISPLAY_EVENT_VIEWPOINT_MOVED, vp);
 }
+static inline void vout_display_SendEventPresented(vout_display_t *vd,
+                                                   mtime_t date,
+                                                   mtime_t presented)
+{
+    vout_display_SendEvent(vd, VOUT_DISPLAY_EVENT_PRESENTED, date, presented);
+}
 
 /**
  * Asks for a new window of a given type.
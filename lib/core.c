@@ -31,6 +31,7 @@
 
 #include <vlc_interface.h>
 #include <vlc_vlm.h>
+#include <vlc_trace.h>
 
 #include <stdarg.h>
 #include <limits.h>
@@ -257,4 +258,10 @@ int64_t libvlc_clock(void)
     return mdate();
 }
 
+int libvlc_trace_dump( libvlc_instance_t *p_instance, const char *psz_path )
+{
+    VLC_UNUSED(p_instance);
+    return vlc_trace_Dump( psz_path ) == VLC_SUCCESS ? 0 : -1;
+}
+
 const char vlc_module_name[] = "libvlc";
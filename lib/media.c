@@ -719,6 +719,16 @@ int libvlc_media_get_stats( libvlc_media_t *p_md,
 
     p_stats->i_played_abuffers = p_itm_stats->i_played_abuffers;
     p_stats->i_lost_abuffers = p_itm_stats->i_lost_abuffers;
+    p_stats->i_audio_latency = p_itm_stats->i_aout_latency;
+    p_stats->i_audio_drift = p_itm_stats->i_aout_drift;
+    p_stats->i_audio_drift_max = p_itm_stats->i_aout_drift_max;
+    p_stats->i_audio_resampling = p_itm_stats->i_aout_resampling;
+    p_stats->i_audio_underruns = p_itm_stats->i_aout_underruns;
+    p_stats->i_audio_silences = p_itm_stats->i_aout_silences;
+    static_assert (LIBVLC_MEDIA_STATS_DRIFT_BUCKETS
+                   == INPUT_STATS_DRIFT_BUCKETS, "Drift buckets mismatch");
+    for( unsigned i = 0; i < LIBVLC_MEDIA_STATS_DRIFT_BUCKETS; i++ )
+        p_stats->pi_audio_drift[i] = p_itm_stats->pi_aout_drift[i];
 
     p_stats->i_sent_packets = p_itm_stats->i_sent_packets;
     p_stats->i_sent_bytes = p_itm_stats->i_sent_bytes;
@@ -791,6 +801,8 @@ static int media_parse(libvlc_media_t *media, bool b_async,
             parse_scope |= META_REQUEST_OPTION_SCOPE_NETWORK;
         if (parse_flag & libvlc_media_do_interact)
             parse_scope |= META_REQUEST_OPTION_DO_INTERACT;
+        if (parse_flag & libvlc_media_parse_priority)
+            parse_scope |= META_REQUEST_OPTION_PRIORITY;
         ret = libvlc_MetadataRequest(libvlc, item, parse_scope, timeout, media);
         if (ret != VLC_SUCCESS)
             return ret;
@@ -35,6 +35,7 @@
 #include <vlc_input.h>
 #include <vlc_vout.h>
 #include <vlc_aout.h>
+#include <vlc_aout_ring.h>
 #include <vlc_actions.h>
 
 #include "libvlc_internal.h"
@@ -184,6 +185,33 @@ static void release_input_thread( libvlc_media_player_t *p_mi )
     input_Close( p_input_thread );
 }
 
+/*
+ * Close a standby input and release its media.
+ * Input lock is held or instance is being destroyed.
+ */
+static void release_standby( libvlc_media_player_t *p_mi,
+                             libvlc_media_player_standby_t *p_standby )
+{
+    TAB_REMOVE( p_mi->input.i_standby, p_mi->input.pp_standby, p_standby );
+
+    if( p_standby->p_thread != NULL )
+    {
+        input_Stop( p_standby->p_thread );
+        input_Close( p_standby->p_thread );
+    }
+    libvlc_media_release( p_standby->p_md );
+    free( p_standby );
+}
+
+static libvlc_media_player_standby_t *
+find_standby( libvlc_media_player_t *p_mi, libvlc_media_t *p_md )
+{
+    for( int i = 0; i < p_mi->input.i_standby; i++ )
+        if( p_mi->input.pp_standby[i]->p_md == p_md )
+            return p_mi->input.pp_standby[i];
+    return NULL;
+}
+
 /*
  * Retrieve the input thread. Be sure to release the object
  * once you are done with it. (libvlc Internal)
@@ -627,6 +655,7 @@ libvlc_media_player_new( libvlc_instance_t *instance )
     var_Create (mp, "vmem-lock", VLC_VAR_ADDRESS);
     var_Create (mp, "vmem-unlock", VLC_VAR_ADDRESS);
     var_Create (mp, "vmem-display", VLC_VAR_ADDRESS);
+    var_Create (mp, "vmem-release", VLC_VAR_ADDRESS);
     var_Create (mp, "vmem-data", VLC_VAR_ADDRESS);
     var_Create (mp, "vmem-setup", VLC_VAR_ADDRESS);
     var_Create (mp, "vmem-cleanup", VLC_VAR_ADDRESS);
@@ -634,6 +663,15 @@ libvlc_media_player_new( libvlc_instance_t *instance )
     var_Create (mp, "vmem-width", VLC_VAR_INTEGER | VLC_VAR_DOINHERIT);
     var_Create (mp, "vmem-height", VLC_VAR_INTEGER | VLC_VAR_DOINHERIT);
     var_Create (mp, "vmem-pitch", VLC_VAR_INTEGER | VLC_VAR_DOINHERIT);
+    var_Create (mp, "vout-cb-opaque", VLC_VAR_ADDRESS);
+    var_Create (mp, "vout-cb-setup", VLC_VAR_ADDRESS);
+    var_Create (mp, "vout-cb-cleanup", VLC_VAR_ADDRESS);
+    var_Create (mp, "vout-cb-update-output", VLC_VAR_ADDRESS);
+    var_Create (mp, "vout-cb-swap", VLC_VAR_ADDRESS);
+    var_Create (mp, "vout-cb-make-current", VLC_VAR_ADDRESS);
+    var_Create (mp, "vout-cb-get-proc-address", VLC_VAR_ADDRESS);
+    var_Create (mp, "gl", VLC_VAR_STRING | VLC_VAR_DOINHERIT);
+    var_Create (mp, "gles2", VLC_VAR_STRING | VLC_VAR_DOINHERIT);
     var_Create (mp, "avcodec-hw", VLC_VAR_STRING);
     var_Create (mp, "drawable-xid", VLC_VAR_INTEGER);
 #if defined (_WIN32) || defined (__OS2__)
@@ -710,6 +748,7 @@ libvlc_media_player_new( libvlc_instance_t *instance )
     var_Create (mp, "amem-flush", VLC_VAR_ADDRESS);
     var_Create (mp, "amem-drain", VLC_VAR_ADDRESS);
     var_Create (mp, "amem-set-volume", VLC_VAR_ADDRESS);
+    var_Create (mp, "amem-ring", VLC_VAR_ADDRESS);
     var_Create (mp, "amem-format", VLC_VAR_STRING | VLC_VAR_DOINHERIT);
     var_Create (mp, "amem-rate", VLC_VAR_INTEGER | VLC_VAR_DOINHERIT);
     var_Create (mp, "amem-channels", VLC_VAR_INTEGER | VLC_VAR_DOINHERIT);
@@ -728,6 +767,7 @@ libvlc_media_player_new( libvlc_instance_t *instance )
     mp->state = libvlc_NothingSpecial;
     mp->p_libvlc_instance = instance;
     mp->input.p_thread = NULL;
+    TAB_INIT(mp->input.i_standby, mp->input.pp_standby);
     mp->input.p_resource = input_resource_New(VLC_OBJECT(mp));
     if (unlikely(mp->input.p_resource == NULL))
     {
@@ -806,6 +846,9 @@ static void libvlc_media_player_destroy( libvlc_media_player_t *p_mi )
     /* No need for lock_input() because no other threads knows us anymore */
     if( p_mi->input.p_thread )
         release_input_thread(p_mi);
+    while( p_mi->input.i_standby > 0 )
+        release_standby( p_mi, p_mi->input.pp_standby[0] );
+    TAB_CLEAN( p_mi->input.i_standby, p_mi->input.pp_standby );
     input_resource_Terminate( p_mi->input.p_resource );
     input_resource_Release( p_mi->input.p_resource );
     vlc_mutex_destroy( &p_mi->input.lock );
@@ -814,6 +857,10 @@ static void libvlc_media_player_destroy( libvlc_media_player_t *p_mi )
     libvlc_media_release( p_mi->p_md );
     vlc_mutex_destroy( &p_mi->object_lock );
 
+    aout_ring_t *ring = var_GetAddress( p_mi, "amem-ring" );
+    if( ring != NULL )
+        aout_RingRelease( ring );
+
     libvlc_instance_t *instance = p_mi->p_libvlc_instance;
     vlc_object_release( p_mi );
     libvlc_release(instance);
@@ -966,6 +1013,35 @@ int libvlc_media_player_play( libvlc_media_player_t *p_mi )
 
     media_attach_preparsed_event( p_mi->p_md );
 
+    /* Switch to the standby input of the media, if it is still alive */
+    libvlc_media_player_standby_t *p_standby = find_standby( p_mi, p_mi->p_md );
+    if( p_standby != NULL )
+    {
+        const int i_state = var_GetInteger( p_standby->p_thread, "state" );
+
+        if( i_state == PLAYING_S || i_state == OPENING_S )
+        {
+            p_input_thread = p_standby->p_thread;
+            p_standby->p_thread = NULL;
+        }
+        release_standby( p_mi, p_standby );
+    }
+
+    if( p_input_thread != NULL )
+    {
+        unlock(p_mi);
+        var_AddCallback( p_input_thread, "can-seek", input_seekable_changed, p_mi );
+        var_AddCallback( p_input_thread, "can-pause", input_pausable_changed, p_mi );
+        var_AddCallback( p_input_thread, "program-scrambled", input_scrambled_changed, p_mi );
+        var_AddCallback( p_input_thread, "intf-event", input_event_changed, p_mi );
+        add_es_callbacks( p_input_thread, p_mi );
+
+        input_Control( p_input_thread, INPUT_SET_STANDBY, false );
+        p_mi->input.p_thread = p_input_thread;
+        unlock_input(p_mi);
+        return 0;
+    }
+
     p_input_thread = input_Create( p_mi, p_mi->p_md->p_input_item, NULL,
                                    p_mi->input.p_resource, NULL );
     unlock(p_mi);
@@ -1063,6 +1139,71 @@ void libvlc_media_player_stop( libvlc_media_player_t *p_mi )
     unlock_input(p_mi);
 }
 
+int libvlc_media_player_add_standby( libvlc_media_player_t *p_mi,
+                                     libvlc_media_t *p_md )
+{
+    lock_input( p_mi );
+
+    if( find_standby( p_mi, p_md ) != NULL )
+    {
+        unlock_input( p_mi );
+        libvlc_printerr( "Media already on standby" );
+        return -1;
+    }
+
+    libvlc_media_player_standby_t *p_standby = malloc( sizeof(*p_standby) );
+    if( unlikely(p_standby == NULL) )
+    {
+        unlock_input( p_mi );
+        libvlc_printerr( "Not enough memory" );
+        return -1;
+    }
+
+    p_standby->p_thread = input_Create( p_mi, p_md->p_input_item, NULL,
+                                        p_mi->input.p_resource, NULL );
+    if( p_standby->p_thread == NULL )
+    {
+        unlock_input( p_mi );
+        free( p_standby );
+        libvlc_printerr( "Not enough memory" );
+        return -1;
+    }
+
+    if( input_Control( p_standby->p_thread, INPUT_SET_STANDBY, true )
+     || input_Start( p_standby->p_thread ) )
+    {
+        unlock_input( p_mi );
+        input_Close( p_standby->p_thread );
+        free( p_standby );
+        libvlc_printerr( "Input initialization failure" );
+        return -1;
+    }
+
+    libvlc_media_retain( p_md );
+    p_standby->p_md = p_md;
+    TAB_APPEND( p_mi->input.i_standby, p_mi->input.pp_standby, p_standby );
+    unlock_input( p_mi );
+    return 0;
+}
+
+int libvlc_media_player_remove_standby( libvlc_media_player_t *p_mi,
+                                        libvlc_media_t *p_md )
+{
+    lock_input( p_mi );
+
+    libvlc_media_player_standby_t *p_standby = find_standby( p_mi, p_md );
+    if( p_standby == NULL )
+    {
+        unlock_input( p_mi );
+        libvlc_printerr( "Media not on standby" );
+        return -1;
+    }
+
+    release_standby( p_mi, p_standby );
+    unlock_input( p_mi );
+    return 0;
+}
+
 int libvlc_media_player_set_renderer( libvlc_media_player_t *p_mi,
                                       const libvlc_renderer_item_t *p_litem )
 {
@@ -1100,6 +1241,12 @@ void libvlc_video_set_format_callbacks( libvlc_media_player_t *mp,
     var_SetAddress( mp, "vmem-cleanup", cleanup );
 }
 
+void libvlc_video_set_release_callback( libvlc_media_player_t *mp,
+                                        libvlc_video_release_cb release )
+{
+    var_SetAddress( mp, "vmem-release", release );
+}
+
 void libvlc_video_set_format( libvlc_media_player_t *mp, const char *chroma,
                               unsigned width, unsigned height, unsigned pitch )
 {
@@ -1109,6 +1256,43 @@ void libvlc_video_set_format( libvlc_media_player_t *mp, const char *chroma,
     var_SetInteger( mp, "vmem-pitch", pitch );
 }
 
+int libvlc_video_set_output_callbacks( libvlc_media_player_t *mp,
+                                       libvlc_video_engine_t engine,
+                                       libvlc_video_output_setup_cb setup_cb,
+                                       libvlc_video_cleanup_cb cleanup_cb,
+                                       libvlc_video_update_output_cb update_output_cb,
+                                       libvlc_video_swap_cb swap_cb,
+                                       libvlc_video_make_current_cb make_current_cb,
+                                       libvlc_video_get_proc_address_cb get_proc_address_cb,
+                                       void *opaque )
+{
+    switch( engine )
+    {
+        case libvlc_video_engine_opengl:
+            var_SetString( mp, "vout", "gl" );
+            var_SetString( mp, "gl", "vgl" );
+            break;
+        case libvlc_video_engine_gles2:
+            var_SetString( mp, "vout", "gles2" );
+            var_SetString( mp, "gles2", "vgl" );
+            break;
+        default:
+            return -1;
+    }
+
+    var_SetAddress( mp, "vout-cb-opaque", opaque );
+    var_SetAddress( mp, "vout-cb-setup", setup_cb );
+    var_SetAddress( mp, "vout-cb-cleanup", cleanup_cb );
+    var_SetAddress( mp, "vout-cb-update-output", update_output_cb );
+    var_SetAddress( mp, "vout-cb-swap", swap_cb );
+    var_SetAddress( mp, "vout-cb-make-current", make_current_cb );
+    var_SetAddress( mp, "vout-cb-get-proc-address", get_proc_address_cb );
+    /* Keep the hardware decoders, their surfaces are imported as textures */
+    var_SetString( mp, "avcodec-hw", "any" );
+    var_SetString( mp, "window", "vgl" );
+    return 0;
+}
+
 /**************************************************************************
  * set_nsobject
  **************************************************************************/
@@ -1307,6 +1491,63 @@ void libvlc_audio_set_format( libvlc_media_player_t *mp, const char *format,
     input_resource_ResetAout(mp->input.p_resource);
 }
 
+/* libvlc_audio_ring_t is an opaque alias for the core audio ring buffer */
+libvlc_audio_ring_t *libvlc_audio_ring_new( void *samples, size_t frames,
+                                            unsigned frame_size )
+{
+    if( unlikely(frames == 0 || frame_size == 0) )
+        return NULL;
+
+    aout_ring_t *ring = malloc( sizeof (*ring) );
+    if( unlikely(ring == NULL) )
+    {
+        libvlc_printerr( "Not enough memory" );
+        return NULL;
+    }
+    aout_RingInit( ring, samples, frames, frame_size );
+    return (libvlc_audio_ring_t *)ring;
+}
+
+void libvlc_audio_ring_release( libvlc_audio_ring_t *ring )
+{
+    aout_RingRelease( (aout_ring_t *)ring );
+}
+
+size_t libvlc_audio_ring_peek( libvlc_audio_ring_t *ring,
+                               const void **samples )
+{
+    return aout_RingPeek( (aout_ring_t *)ring, samples );
+}
+
+void libvlc_audio_ring_consume( libvlc_audio_ring_t *ring, size_t frames )
+{
+    aout_RingConsume( (aout_ring_t *)ring, frames );
+}
+
+void libvlc_audio_ring_set_latency( libvlc_audio_ring_t *ring,
+                                    int64_t latency )
+{
+    atomic_store_explicit( &((aout_ring_t *)ring)->latency, latency,
+                           memory_order_relaxed );
+}
+
+void libvlc_audio_set_ring( libvlc_media_player_t *mp,
+                            libvlc_audio_ring_t *ring )
+{
+    aout_ring_t *old = var_GetAddress( mp, "amem-ring" );
+
+    if( ring != NULL )
+        aout_RingHold( (aout_ring_t *)ring );
+    var_SetAddress( mp, "amem-ring", ring );
+    if( ring != NULL )
+        var_SetString( mp, "aout", "amem,none" );
+
+    input_resource_ResetAout(mp->input.p_resource);
+    /* The audio output holds its own reference */
+    if( old != NULL )
+        aout_RingRelease( old );
+}
+
 
 /**************************************************************************
  * Getters for stream information
@@ -36,6 +36,12 @@
 
 #include "../modules/audio_filter/equalizer_presets.h"
 
+typedef struct
+{
+    libvlc_media_t *p_md;
+    input_thread_t *p_thread;
+} libvlc_media_player_standby_t;
+
 struct libvlc_media_player_t
 {
     VLC_COMMON_MEMBERS
@@ -48,6 +54,10 @@ struct libvlc_media_player_t
         input_thread_t   *p_thread;
         input_resource_t *p_resource;
         vlc_mutex_t       lock;
+
+        /* Inputs opened on standby */
+        int               i_standby;
+        libvlc_media_player_standby_t **pp_standby;
     } input;
 
     struct libvlc_instance_t * p_libvlc_instance; /* Parent instance */
@@ -222,6 +222,37 @@ int libvlc_video_get_cursor( libvlc_media_player_t *mp, unsigned num,
     return 0;
 }
 
+static void CopyTiming( libvlc_video_timing_histogram_t *dst,
+                        const vout_timing_histogram_t *src )
+{
+    dst->i_count = src->count;
+    dst->i_sum   = src->sum;
+    dst->i_max   = src->max;
+    for (unsigned i = 0; i < LIBVLC_VIDEO_TIMING_BUCKETS; i++)
+        dst->pi_buckets[i] = src->buckets[i];
+}
+
+int libvlc_video_get_timing( libvlc_media_player_t *mp, unsigned num,
+                             libvlc_video_timing_t *p_timing )
+{
+    vout_thread_t *p_vout = GetVout (mp, num);
+    if (p_vout == NULL)
+        return -1;
+
+    vout_timing_t timing;
+    vout_GetTiming (p_vout, &timing);
+    vlc_object_release (p_vout);
+
+    static_assert (LIBVLC_VIDEO_TIMING_BUCKETS == VOUT_TIMING_BUCKETS,
+                   "Timing buckets mismatch");
+    CopyTiming (&p_timing->latency, &timing.latency);
+    CopyTiming (&p_timing->late, &timing.late);
+    CopyTiming (&p_timing->prepare, &timing.prepare);
+    CopyTiming (&p_timing->display, &timing.display);
+    CopyTiming (&p_timing->interval, &timing.interval);
+    return 0;
+}
+
 unsigned libvlc_media_player_has_vout( libvlc_media_player_t *p_mi )
 {
     size_t n;
@@ -50,6 +50,7 @@
 #include <vlc_xml.h>
 #include <vlc_url.h>
 #include <vlc_aout.h>
+#include <vlc_threads.h>
 
 #ifdef _WIN32
 # define KM_WIN32
@@ -67,6 +68,11 @@ using namespace ASDCP;
 #define FRAME_BUFFER_SIZE 1302083 /* maximum frame length, in bytes, after
                                      "Digital Cinema System Specification Version 1.2
                                      with Errata as of 30 August 2012" */
+/* Encrypted frames carry an IV, a check value and a padding block more */
+#define CIPHER_BUFFER_SIZE ( FRAME_BUFFER_SIZE + 3 * CBC_BLOCK_SIZE )
+
+#define DCP_READ_AHEAD  8 /* video frames read ahead of the playback */
+#define DCP_WORKERS_MAX 4 /* threads decrypting the video frames */
 
 /* Forward declarations */
 static int Open( vlc_object_t * );
@@ -108,6 +114,17 @@ struct audioReader_t
     PCM::MXFReader *p_AudioMXFReader;
 };
 
+/* Video frame read ahead, and decrypted by a worker if it is encrypted */
+struct dcpFrame_t
+{
+    block_t  *p_block;           /* NULL if it could not be read or decrypted */
+    AESKey   *p_key;             /* key to decrypt it with, NULL once clear */
+    uint32_t frame_no;
+    ui32_t   i_source_length;    /* plaintext size */
+    ui32_t   i_plaintext_offset; /* size of the unencrypted head */
+    bool     b_busy;             /* being decrypted */
+};
+
 /* ASDCP library (version 1.10.48) can handle files having one of the following Essence Types, as defined in AS_DCP.h:
     ESS_UNKNOWN,     // the file is not a supported AS-DCP essence container
     ESS_MPEG2_VES,   // the file contains an MPEG video elementary stream
@@ -164,6 +181,19 @@ class demux_sys_t
 
     mtime_t i_pts;
 
+    /* Video frames read ahead, oldest first. The demux thread reads them,
+     * the workers decrypt them, and they are sent in order. */
+    dcpFrame_t frames[DCP_READ_AHEAD];
+    unsigned i_frame_head;
+    unsigned i_frame_count;
+    uint32_t read_no;              /* next video frame to read */
+
+    std::vector<vlc_thread_t> workers;
+    vlc_mutex_t lock;
+    vlc_cond_t  wait_job;          /* an encrypted frame was read, or exit */
+    vlc_cond_t  wait_done;         /* a frame was decrypted */
+    bool b_exit;
+
     demux_sys_t():
         PictureEssType ( ESS_UNKNOWN ),
         v_videoReader(),
@@ -174,10 +204,24 @@ class demux_sys_t
         frame_no( 0 ),
         frames_total( 0 ),
         i_video_reel( 0 ),
-        i_audio_reel( 0 ) {};
+        i_audio_reel( 0 ),
+        i_frame_head( 0 ),
+        i_frame_count( 0 ),
+        read_no( 0 ),
+        workers(),
+        b_exit( false )
+    {
+        vlc_mutex_init( &lock );
+        vlc_cond_init( &wait_job );
+        vlc_cond_init( &wait_done );
+    };
 
     ~demux_sys_t()
     {
+        vlc_cond_destroy( &wait_done );
+        vlc_cond_destroy( &wait_job );
+        vlc_mutex_destroy( &lock );
+
         switch ( PictureEssType )
         {
             case ESS_UNKNOWN:
@@ -285,6 +329,10 @@ static const unsigned i_channel_mask[] =
 static int Demux( demux_t * );
 static int Control( demux_t *, int, va_list );
 
+static int StartVideoWorkers( demux_t * );
+static void StopVideoWorkers( demux_t * );
+static void FlushVideoFrames( demux_t * );
+
 int dcpInit ( demux_t *p_demux );
 int parseXML ( demux_t * p_demux );
 static inline void fillVideoFmt(
@@ -577,6 +625,10 @@ static int Open( vlc_object_t *obj )
     p_demux->pf_demux = Demux;
     p_demux->pf_control = Control;
     p_sys->frame_no = p_sys->p_dcp->video_reels[0].i_entrypoint;
+    p_sys->read_no = p_sys->frame_no;
+
+    if( ( retval = StartVideoWorkers( p_demux ) ) )
+        goto error;
 
     return VLC_SUCCESS;
 error:
@@ -597,28 +649,349 @@ static inline void Close( vlc_object_t *obj )
 
 
 /*****************************************************************************
- * Demux: DCP Demuxing function
+ * Video frames pipeline
  *****************************************************************************/
-static int Demux( demux_t *p_demux )
+
+/**
+ * Reads a video frame as stored: the encrypted frames are decrypted later,
+ * by a worker
+ * @param p_demux DCP access-demux
+ * @param p_frame frame to fill
+ */
+static void ReadVideoFrame( demux_t *p_demux, dcpFrame_t *p_frame )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
-    block_t *p_video_frame = NULL, *p_audio_frame = NULL;
+    info_reel &reel = p_sys->p_dcp->video_reels[p_sys->i_video_reel];
+    videoReader_t &reader = p_sys->v_videoReader[p_sys->i_video_reel];
+    int nextFrame = p_sys->read_no + reel.i_correction;
+
+    JP2K::FrameBuffer  PicFrameBuff;
+    MPEG2::FrameBuffer VideoFrameBuff;
+    ASDCP::FrameBuffer *p_buff;
+    Result_t result;
+
+    p_frame->frame_no = p_sys->read_no;
+    p_frame->p_key = NULL;
+    p_frame->b_busy = false;
+    if( ( p_frame->p_block = block_Alloc( CIPHER_BUFFER_SIZE ) ) == NULL )
+        return;
+
+    if( p_sys->PictureEssType == ESS_MPEG2_VES )
+        p_buff = &VideoFrameBuff;
+    else
+        p_buff = &PicFrameBuff;
 
-    PCM::FrameBuffer   AudioFrameBuff( p_sys->i_audio_buffer);
-    AESDecContext video_aes_ctx, audio_aes_ctx;
+    if( ! ASDCP_SUCCESS(
+            p_buff->SetData( p_frame->p_block->p_buffer, CIPHER_BUFFER_SIZE ) ) )
+        goto error;
 
-    /* swaping video reels */
-    if  ( p_sys->frame_no == p_sys->p_dcp->video_reels[p_sys->i_video_reel].i_absolute_end )
+    /* Without decryption context, the encrypted frames are read as such */
+    switch( p_sys->PictureEssType )
     {
-        if ( p_sys->i_video_reel + 1 == p_sys->v_videoReader.size() )
+        case ESS_JPEG_2000:
+            result = reader.p_PicMXFReader->ReadFrame( nextFrame, PicFrameBuff, NULL, NULL );
+            break;
+        case ESS_JPEG_2000_S:
+            result = reader.p_PicMXFSReader->ReadFrame( nextFrame, JP2K::SP_LEFT, PicFrameBuff, NULL, NULL );
+            break;
+        case ESS_MPEG2_VES:
+            result = reader.p_VideoMXFReader->ReadFrame( nextFrame, VideoFrameBuff, NULL, NULL );
+            break;
+        default:
+            msg_Err( p_demux, "Unrecognized video format" );
+            goto error;
+    }
+    if( ! ASDCP_SUCCESS( result ) )
+    {
+        msg_Err( p_demux, "Couldn't read frame with ASDCP" );
+        goto error;
+    }
+
+    p_frame->p_block->i_buffer = p_buff->Size();
+    p_frame->i_source_length = p_buff->SourceLength();
+    p_frame->i_plaintext_offset = p_buff->PlaintextOffset();
+    if( p_frame->i_source_length != 0 )
+    {
+        /* encrypted frame */
+        if( reel.p_key == NULL )
         {
-            return 0;
+            msg_Err( p_demux, "No key to decrypt the frame with" );
+            goto error;
         }
-        else
+        p_frame->p_key = reel.p_key;
+    }
+    p_buff->SetData( 0, 0 );
+    return;
+
+error:
+    p_buff->SetData( 0, 0 );
+    block_Release( p_frame->p_block );
+    p_frame->p_block = NULL;
+}
+
+/**
+ * Decrypts a video frame
+ * @param ctx decryption context, initialized with the key of the frame
+ * @param p_frame frame read encrypted
+ * @return the decrypted frame or NULL on error
+ */
+static block_t *DecryptVideoFrame( AESDecContext &ctx, dcpFrame_t *p_frame )
+{
+    block_t *p_block = block_Alloc( FRAME_BUFFER_SIZE );
+    if( p_block == NULL )
+        return NULL;
+
+    ASDCP::FrameBuffer CipherBuff, PlainBuff;
+    Result_t result = CipherBuff.SetData( p_frame->p_block->p_buffer,
+                                          CIPHER_BUFFER_SIZE );
+    if( ASDCP_SUCCESS( result ) )
+        result = PlainBuff.SetData( p_block->p_buffer, FRAME_BUFFER_SIZE );
+    if( ASDCP_SUCCESS( result ) )
+    {
+        CipherBuff.Size( p_frame->p_block->i_buffer );
+        CipherBuff.SourceLength( p_frame->i_source_length );
+        CipherBuff.PlaintextOffset( p_frame->i_plaintext_offset );
+        result = DecryptFrameBuffer( CipherBuff, PlainBuff, &ctx );
+    }
+    p_block->i_buffer = PlainBuff.Size();
+    CipherBuff.SetData( 0, 0 );
+    PlainBuff.SetData( 0, 0 );
+
+    if( ! ASDCP_SUCCESS( result ) )
+    {
+        block_Release( p_block );
+        return NULL;
+    }
+    return p_block;
+}
+
+/** Finds the oldest encrypted frame that no worker is decrypting */
+static dcpFrame_t *NextVideoJob( demux_sys_t *p_sys )
+{
+    for( unsigned i = 0; i < p_sys->i_frame_count; i++ )
+    {
+        dcpFrame_t *p_frame =
+            &p_sys->frames[( p_sys->i_frame_head + i ) % DCP_READ_AHEAD];
+        if( p_frame->p_key != NULL && !p_frame->b_busy )
+            return p_frame;
+    }
+    return NULL;
+}
+
+static void *DecryptThread( void *data )
+{
+    demux_t *p_demux = ( demux_t* ) data;
+    demux_sys_t *p_sys = p_demux->p_sys;
+    /* AES-NI is used if the CPU has it, by the crypto library of asdcplib */
+    AESDecContext ctx;
+    AESKey *p_ctx_key = NULL;
+
+    vlc_mutex_lock( &p_sys->lock );
+    for( ;; )
+    {
+        dcpFrame_t *p_frame;
+
+        while( !p_sys->b_exit && ( p_frame = NextVideoJob( p_sys ) ) == NULL )
+            vlc_cond_wait( &p_sys->wait_job, &p_sys->lock );
+        if( p_sys->b_exit )
+            break;
+
+        p_frame->b_busy = true;
+        vlc_mutex_unlock( &p_sys->lock );
+
+        /* The frames are only shared with the demux thread, which does not
+         * touch them while they are busy */
+        block_t *p_block = NULL;
+        if( p_frame->p_key != p_ctx_key )
         {
+            p_ctx_key = NULL;
+            if( ASDCP_SUCCESS( ctx.InitKey( p_frame->p_key->getKey() ) ) )
+                p_ctx_key = p_frame->p_key;
+            else
+                msg_Err( p_demux, "ASDCP failed to initialize AES key" );
+        }
+        if( p_ctx_key != NULL &&
+            ( p_block = DecryptVideoFrame( ctx, p_frame ) ) == NULL )
+            msg_Err( p_demux, "ASDCP failed to decrypt frame" );
+        block_Release( p_frame->p_block );
+
+        vlc_mutex_lock( &p_sys->lock );
+        p_frame->p_block = p_block;
+        p_frame->p_key = NULL;
+        p_frame->b_busy = false;
+        vlc_cond_broadcast( &p_sys->wait_done );
+    }
+    vlc_mutex_unlock( &p_sys->lock );
+    return NULL;
+}
+
+/**
+ * Reads the video frames ahead, up to DCP_READ_AHEAD
+ * @param p_demux DCP access-demux
+ */
+static void FillVideoFrames( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    /* Only the demux thread adds and removes frames */
+    while( p_sys->i_frame_count < DCP_READ_AHEAD )
+    {
+        /* swaping video reels */
+        if( p_sys->read_no == p_sys->p_dcp->video_reels[p_sys->i_video_reel].i_absolute_end )
+        {
+            if( p_sys->i_video_reel + 1 == p_sys->v_videoReader.size() )
+                break;
             p_sys->i_video_reel++;
         }
+
+        dcpFrame_t *p_frame = &p_sys->frames[( p_sys->i_frame_head
+                              + p_sys->i_frame_count ) % DCP_READ_AHEAD];
+        ReadVideoFrame( p_demux, p_frame );
+        p_sys->read_no++;
+
+        vlc_mutex_lock( &p_sys->lock );
+        p_sys->i_frame_count++;
+        if( p_frame->p_key != NULL )
+            vlc_cond_signal( &p_sys->wait_job );
+        vlc_mutex_unlock( &p_sys->lock );
     }
+}
+
+/**
+ * Takes the next video frame, once decrypted
+ * @param p_demux DCP access-demux
+ * @param pp_block the frame, or NULL if it could not be read or decrypted
+ * @return false at the end of the last reel
+ */
+static bool PopVideoFrame( demux_t *p_demux, block_t **pp_block )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    vlc_mutex_lock( &p_sys->lock );
+    if( p_sys->i_frame_count == 0 )
+    {
+        vlc_mutex_unlock( &p_sys->lock );
+        return false;
+    }
+
+    dcpFrame_t *p_frame = &p_sys->frames[p_sys->i_frame_head];
+    while( p_frame->p_key != NULL || p_frame->b_busy )
+        vlc_cond_wait( &p_sys->wait_done, &p_sys->lock );
+
+    *pp_block = p_frame->p_block;
+    p_frame->p_block = NULL;
+    p_sys->i_frame_head = ( p_sys->i_frame_head + 1 ) % DCP_READ_AHEAD;
+    p_sys->i_frame_count--;
+    vlc_mutex_unlock( &p_sys->lock );
+    return true;
+}
+
+/**
+ * Drops the frames read ahead, and reads again from the current frame
+ * @param p_demux DCP access-demux
+ */
+static void FlushVideoFrames( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    vlc_mutex_lock( &p_sys->lock );
+    for( unsigned i = 0; i < p_sys->i_frame_count; i++ )
+    {
+        dcpFrame_t *p_frame =
+            &p_sys->frames[( p_sys->i_frame_head + i ) % DCP_READ_AHEAD];
+
+        /* Once it is not busy, clearing the key keeps it from the workers */
+        while( p_frame->b_busy )
+            vlc_cond_wait( &p_sys->wait_done, &p_sys->lock );
+        p_frame->p_key = NULL;
+        if( p_frame->p_block != NULL )
+            block_Release( p_frame->p_block );
+        p_frame->p_block = NULL;
+    }
+    p_sys->i_frame_head = 0;
+    p_sys->i_frame_count = 0;
+    vlc_mutex_unlock( &p_sys->lock );
+
+    /* Find the reel of the new position */
+    p_sys->read_no = p_sys->frame_no;
+    p_sys->i_video_reel = 0;
+    while( p_sys->i_video_reel + 1 < p_sys->v_videoReader.size() &&
+           p_sys->read_no >= p_sys->p_dcp->video_reels[p_sys->i_video_reel].i_absolute_end )
+        p_sys->i_video_reel++;
+}
+
+/**
+ * Starts the threads decrypting the video frames, if any reel is encrypted
+ * @param p_demux DCP access-demux
+ */
+static int StartVideoWorkers( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    bool b_encrypted = false;
+
+    for( size_t i = 0; i < p_sys->p_dcp->video_reels.size(); i++ )
+        if( p_sys->p_dcp->video_reels[i].p_key != NULL )
+            b_encrypted = true;
+    if( !b_encrypted )
+        return VLC_SUCCESS;
+
+    unsigned i_workers = VLC_CLIP( vlc_GetCPUCount(), 1, DCP_WORKERS_MAX );
+    for( unsigned i = 0; i < i_workers; i++ )
+    {
+        vlc_thread_t thread;
+
+        if( vlc_clone( &thread, DecryptThread, p_demux,
+                       VLC_THREAD_PRIORITY_INPUT ) )
+            break;
+        p_sys->workers.push_back( thread );
+    }
+
+    if( p_sys->workers.empty() )
+    {
+        msg_Err( p_demux, "cannot start the decryption threads" );
+        return VLC_EGENERIC;
+    }
+    msg_Dbg( p_demux, "decrypting with %zu threads", p_sys->workers.size() );
+    return VLC_SUCCESS;
+}
+
+/**
+ * Stops the decryption threads, and drops the frames read ahead
+ * @param p_demux DCP access-demux
+ */
+static void StopVideoWorkers( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    vlc_mutex_lock( &p_sys->lock );
+    p_sys->b_exit = true;
+    vlc_cond_broadcast( &p_sys->wait_job );
+    vlc_mutex_unlock( &p_sys->lock );
+
+    for( size_t i = 0; i < p_sys->workers.size(); i++ )
+        vlc_join( p_sys->workers[i], NULL );
+    p_sys->workers.clear();
+
+    for( unsigned i = 0; i < p_sys->i_frame_count; i++ )
+    {
+        dcpFrame_t *p_frame =
+            &p_sys->frames[( p_sys->i_frame_head + i ) % DCP_READ_AHEAD];
+        if( p_frame->p_block != NULL )
+            block_Release( p_frame->p_block );
+    }
+    p_sys->i_frame_count = 0;
+}
+
+/*****************************************************************************
+ * Demux: DCP Demuxing function
+ *****************************************************************************/
+static int Demux( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    block_t *p_video_frame = NULL, *p_audio_frame = NULL;
+
+    PCM::FrameBuffer   AudioFrameBuff( p_sys->i_audio_buffer);
+    AESDecContext audio_aes_ctx;
 
     /* swaping audio reels */
     if  ( !p_sys->p_dcp->audio_reels.empty() && p_sys->frame_no == p_sys->p_dcp->audio_reels[p_sys->i_audio_reel].i_absolute_end )
@@ -633,71 +1006,12 @@ static int Demux( demux_t *p_demux )
          }
      }
 
-    /* video frame */
-
-    /* initialize AES context, if reel is encrypted */
-    if( p_sys &&
-            p_sys->p_dcp &&
-            p_sys->p_dcp->video_reels.size() > p_sys->i_video_reel &&
-            p_sys->p_dcp->video_reels[p_sys->i_video_reel].p_key )
-    {
-        if( ! ASDCP_SUCCESS( video_aes_ctx.InitKey( p_sys->p_dcp->video_reels[p_sys->i_video_reel].p_key->getKey() ) ) )
-        {
-            msg_Err( p_demux, "ASDCP failed to initialize AES key" );
-            goto error;
-        }
-    }
-
-    switch( p_sys->PictureEssType )
-    {
-        case ESS_JPEG_2000:
-        case ESS_JPEG_2000_S:{
-            JP2K::FrameBuffer  PicFrameBuff(FRAME_BUFFER_SIZE);
-            int nextFrame = p_sys->frame_no + p_sys->p_dcp->video_reels[p_sys->i_video_reel].i_correction;
-            if ( ( p_video_frame = block_Alloc( FRAME_BUFFER_SIZE )) == NULL )
-                goto error;
-
-            if ( ! ASDCP_SUCCESS(
-                    PicFrameBuff.SetData(p_video_frame->p_buffer, FRAME_BUFFER_SIZE)) )
-                goto error_asdcp;
-            if ( p_sys->PictureEssType == ESS_JPEG_2000_S ) {
-                if ( ! ASDCP_SUCCESS(
-                        p_sys->v_videoReader[p_sys->i_video_reel].p_PicMXFSReader->ReadFrame(nextFrame, JP2K::SP_LEFT, PicFrameBuff, &video_aes_ctx, 0)) ) {
-                    PicFrameBuff.SetData(0,0);
-                    goto error_asdcp;
-                }
-             } else {
-                if ( ! ASDCP_SUCCESS(
-                        p_sys->v_videoReader[p_sys->i_video_reel].p_PicMXFReader->ReadFrame(nextFrame, PicFrameBuff, &video_aes_ctx, 0)) ) {
-                    PicFrameBuff.SetData(0,0);
-                    goto error_asdcp;
-                }
-            }
-            p_video_frame->i_buffer = PicFrameBuff.Size();
-            break;
-        }
-        case ESS_MPEG2_VES: {
-            MPEG2::FrameBuffer VideoFrameBuff(FRAME_BUFFER_SIZE);
-            if ( ( p_video_frame = block_Alloc( FRAME_BUFFER_SIZE )) == NULL )
-                goto error;
-
-            if ( ! ASDCP_SUCCESS(
-                    VideoFrameBuff.SetData(p_video_frame->p_buffer, FRAME_BUFFER_SIZE)) )
-                goto error_asdcp;
-
-            if ( ! ASDCP_SUCCESS(
-                    p_sys->v_videoReader[p_sys->i_video_reel].p_VideoMXFReader->ReadFrame(p_sys->frame_no + p_sys->p_dcp->video_reels[p_sys->i_video_reel].i_correction, VideoFrameBuff, &video_aes_ctx, 0)) ) {
-                VideoFrameBuff.SetData(0,0);
-                goto error_asdcp;
-            }
-
-            p_video_frame->i_buffer = VideoFrameBuff.Size();
-            break;
-        }
-        default:
-            msg_Err( p_demux, "Unrecognized video format" );
-            goto error;
-    }
+    /* video frame, read ahead and decrypted by the workers meanwhile */
+    FillVideoFrames( p_demux );
+    if( !PopVideoFrame( p_demux, &p_video_frame ) )
+        return 0;
+    if( p_video_frame == NULL )
+        goto error;
 
     p_video_frame->i_length = CLOCK_FREQ * p_sys->frame_rate_denom / p_sys->frame_rate_num;
     p_video_frame->i_pts = CLOCK_FREQ * p_sys->frame_no * p_sys->frame_rate_denom / p_sys->frame_rate_num;
@@ -810,6 +1124,7 @@ static int Control( demux_t *p_demux, int query, va_list args )
         case DEMUX_SET_POSITION:
             f = va_arg( args, double );
             p_sys->frame_no = (int) ( f * p_sys->frames_total );
+            FlushVideoFrames( p_demux );
             break;
 
         case DEMUX_GET_LENGTH:
@@ -826,6 +1141,7 @@ static int Control( demux_t *p_demux, int query, va_list args )
             i64 = va_arg( args, int64_t );
             msg_Warn( p_demux, "DEMUX_SET_TIME"  );
             p_sys->frame_no = i64 * p_sys->frame_rate_num / ( CLOCK_FREQ * p_sys->frame_rate_denom );
+            FlushVideoFrames( p_demux );
             p_sys->i_pts= i64;
             es_out_SetPCR(p_demux->out, p_sys->i_pts);
             es_out_Control( p_demux->out, ES_OUT_SET_NEXT_DISPLAY_TIME, ( mtime_t ) i64 );
@@ -876,6 +1192,9 @@ static inline void fillVideoFmt( video_format_t * fmt, unsigned int width, unsig
 void CloseDcpAndMxf( demux_t *p_demux )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
+
+    StopVideoWorkers( p_demux );
+
     /* close the files */
     switch( p_sys->PictureEssType )
     {
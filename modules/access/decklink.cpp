@@ -26,6 +26,8 @@
 # include "config.h"
 #endif
 
+#include <cinttypes>
+
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_demux.h>
@@ -125,12 +127,14 @@ vlc_module_end ()
 static int Control(demux_t *, int, va_list);
 
 class DeckLinkCaptureDelegate;
+class DeckLinkCaptureAllocator;
 
 struct demux_sys_t
 {
     IDeckLink *card;
     IDeckLinkInput *input;
     DeckLinkCaptureDelegate *delegate;
+    DeckLinkCaptureAllocator *allocator;
 
     /* We need to hold onto the IDeckLinkConfiguration object, or our settings will not apply.
        See section 2.4.15 of the Blackmagic DeckLink SDK documentation. */
@@ -151,6 +155,10 @@ struct demux_sys_t
     int channels;
 
     bool tenbits;
+
+    /* Only accessed from the capture thread, then from Close() */
+    mtime_t last_stream_time;
+    uint64_t dropped_frames;
 };
 
 static const char *GetFieldDominance(BMDFieldDominance dom, uint32_t *flags)
@@ -222,6 +230,156 @@ static es_format_t GetModeSettings(demux_t *demux, IDeckLinkDisplayMode *m,
     return video_fmt;
 }
 
+/* The frames of the default allocator of the driver are few, and the card
+ * drops the input if they are all held. The captured frames are sent as is
+ * down the pipeline, the buffers are allocated on demand and recycled. */
+class DeckLinkCaptureAllocator : public IDeckLinkMemoryAllocator
+{
+public:
+    DeckLinkCaptureAllocator() : m_ref_(1), buffer_size(0), free_list(NULL),
+                                 free_count(0)
+    {
+        vlc_mutex_init(&lock);
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID, LPVOID *) { return E_NOINTERFACE; }
+
+    virtual ULONG STDMETHODCALLTYPE AddRef(void)
+    {
+        return ++m_ref_;
+    }
+
+    virtual ULONG STDMETHODCALLTYPE Release(void)
+    {
+        unsigned new_ref = --m_ref_;
+        if (new_ref == 0)
+            delete this;
+        return new_ref;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE AllocateBuffer(uint32_t size, void **buffer)
+    {
+        buffer_header *hdr = NULL;
+
+        vlc_mutex_lock(&lock);
+        if (size != buffer_size) {
+            /* the input format changed */
+            Flush();
+            buffer_size = size;
+        }
+        if (free_list) {
+            hdr = free_list;
+            free_list = hdr->next;
+            free_count--;
+        }
+        vlc_mutex_unlock(&lock);
+
+        if (!hdr) {
+            hdr = (buffer_header *)aligned_alloc(BUFFER_ALIGN,
+                        BUFFER_ALIGN + ((size + BUFFER_ALIGN - 1) & ~(BUFFER_ALIGN - 1)));
+            if (!hdr)
+                return E_OUTOFMEMORY;
+            hdr->size = size;
+        }
+
+        /* The buffers can be released after the input, with the last block */
+        AddRef();
+        *buffer = (uint8_t *)hdr + BUFFER_ALIGN;
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE ReleaseBuffer(void *buffer)
+    {
+        buffer_header *hdr = (buffer_header *)((uint8_t *)buffer - BUFFER_ALIGN);
+
+        vlc_mutex_lock(&lock);
+        if (hdr->size == buffer_size && free_count < FREE_MAX) {
+            hdr->next = free_list;
+            free_list = hdr;
+            free_count++;
+            hdr = NULL;
+        }
+        vlc_mutex_unlock(&lock);
+
+        free(hdr);
+        Release();
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE Commit(void)
+    {
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE Decommit(void)
+    {
+        vlc_mutex_lock(&lock);
+        Flush();
+        vlc_mutex_unlock(&lock);
+        return S_OK;
+    }
+
+private:
+    enum { BUFFER_ALIGN = 64, FREE_MAX = 32 };
+
+    struct buffer_header
+    {
+        buffer_header *next;
+        uint32_t size;
+    };
+
+    virtual ~DeckLinkCaptureAllocator()
+    {
+        Flush();
+        vlc_mutex_destroy(&lock);
+    }
+
+    /* with lock */
+    void Flush(void)
+    {
+        while (free_list) {
+            buffer_header *hdr = free_list;
+            free_list = hdr->next;
+            free(hdr);
+        }
+        free_count = 0;
+    }
+
+    std::atomic_uint m_ref_;
+    vlc_mutex_t lock;
+    uint32_t buffer_size;
+    buffer_header *free_list;
+    unsigned free_count;
+};
+
+/* Blocks pointing to the bytes of a captured frame or audio packet */
+struct decklink_block_t
+{
+    block_t self;
+    IUnknown *frame;
+};
+
+static void ReleaseFrameBlock(block_t *block)
+{
+    decklink_block_t *b = (decklink_block_t *)block;
+
+    b->frame->Release();
+    free(b);
+}
+
+static block_t *FrameBlock(IUnknown *frame, void *bytes, size_t size)
+{
+    decklink_block_t *b = (decklink_block_t *)malloc(sizeof(*b));
+    if (!b)
+        return NULL;
+
+    block_Init(&b->self, bytes, size);
+    b->self.pf_release = ReleaseFrameBlock;
+    frame->AddRef();
+    b->frame = frame;
+    return &b->self;
+}
+
 class DeckLinkCaptureDelegate : public IDeckLinkInputCallback
 {
 public:
@@ -277,6 +435,7 @@ public:
 
         es_out_Del(demux_->out, sys->video_es);
         sys->video_fmt = GetModeSettings(demux_, mode, flags);
+        sys->last_stream_time = VLC_TS_INVALID;
         sys->video_es = es_out_Add(demux_->out, &sys->video_fmt);
 
         sys->input->PauseStreams();
@@ -319,19 +478,40 @@ HRESULT DeckLinkCaptureDelegate::VideoInputFrameArrived(IDeckLinkVideoInputFrame
                 bpp = 2;
                 break;
         };
-        block_t *video_frame = block_Alloc(width * height * bpp);
-        if (!video_frame)
-            return S_OK;
 
-        const uint32_t *frame_bytes;
+        uint32_t *frame_bytes;
         videoFrame->GetBytes((void**)&frame_bytes);
 
+        /* Packed frames without padding are sent without copies */
+        const bool lent = sys->video_fmt.i_codec != VLC_CODEC_I422_10L &&
+                          stride == width * bpp;
+        block_t *video_frame;
+        if (lent)
+            video_frame = FrameBlock(videoFrame, frame_bytes, width * height * bpp);
+        else
+            video_frame = block_Alloc(width * height * bpp);
+        if (!video_frame)
+            return S_OK;
+
         BMDTimeValue stream_time, frame_duration;
         videoFrame->GetStreamTime(&stream_time, &frame_duration, CLOCK_FREQ);
         video_frame->i_flags = BLOCK_FLAG_TYPE_I | sys->dominance_flags;
         video_frame->i_pts = video_frame->i_dts = VLC_TS_0 + stream_time;
 
-        if (sys->video_fmt.i_codec == VLC_CODEC_I422_10L) {
+        if (sys->last_stream_time != VLC_TS_INVALID && frame_duration > 0
+         && stream_time - sys->last_stream_time > frame_duration * 3 / 2) {
+            uint64_t lost = (stream_time - sys->last_stream_time) / frame_duration - 1;
+            if (lost == 0)
+                lost = 1;
+            sys->dropped_frames += lost;
+            msg_Warn(demux_, "%" PRIu64 " frame(s) dropped (%" PRIu64 " total)",
+                     lost, sys->dropped_frames);
+        }
+        sys->last_stream_time = stream_time;
+
+        if (lent) {
+            /* the block points to the captured frame */
+        } else if (sys->video_fmt.i_codec == VLC_CODEC_I422_10L) {
             v210_convert((uint16_t*)video_frame->p_buffer, frame_bytes, width, height);
             IDeckLinkVideoFrameAncillary *vanc;
             if (videoFrame->GetAncillaryData(&vanc) == S_OK) {
@@ -386,13 +566,12 @@ HRESULT DeckLinkCaptureDelegate::VideoInputFrameArrived(IDeckLinkVideoInputFrame
     if (audioFrame) {
         const int bytes = audioFrame->GetSampleFrameCount() * sizeof(int16_t) * sys->channels;
 
-        block_t *audio_frame = block_Alloc(bytes);
-        if (!audio_frame)
-            return S_OK;
-
         void *frame_bytes;
         audioFrame->GetBytes(&frame_bytes);
-        memcpy(audio_frame->p_buffer, frame_bytes, bytes);
+
+        block_t *audio_frame = FrameBlock(audioFrame, frame_bytes, bytes);
+        if (!audio_frame)
+            return S_OK;
 
         BMDTimeValue packet_time;
         audioFrame->GetPacketTime(&packet_time, CLOCK_FREQ);
@@ -502,6 +681,7 @@ static int Open(vlc_object_t *p_this)
 
     vlc_mutex_init(&sys->pts_lock);
 
+    sys->last_stream_time = VLC_TS_INVALID;
     sys->tenbits = var_InheritBool(p_this, "decklink-tenbits");
 
     IDeckLinkIterator *decklink_iterator = CreateDeckLinkIteratorInstance();
@@ -632,6 +812,10 @@ static int Open(vlc_object_t *p_this)
         goto finish;
     }
 
+    sys->allocator = new DeckLinkCaptureAllocator();
+    if (sys->input->SetVideoInputFrameMemoryAllocator(sys->allocator) != S_OK)
+        msg_Warn(demux, "Failed to set the frame allocator");
+
     if (sys->input->EnableVideoInput(htonl(u.id), fmt, flags) != S_OK) {
         msg_Err(demux, "Failed to enable video input");
         goto finish;
@@ -721,6 +905,13 @@ static void Close(vlc_object_t *p_this)
     if (sys->delegate)
         sys->delegate->Release();
 
+    if (sys->allocator)
+        sys->allocator->Release();
+
+    if (sys->dropped_frames > 0)
+        msg_Warn(demux, "%" PRIu64 " frame(s) dropped by the card",
+                 sys->dropped_frames);
+
     vlc_mutex_destroy(&sys->pts_lock);
     free(sys);
 }
@@ -32,7 +32,10 @@
 #endif
 
 #include <limits.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/stat.h>
+#include <dirent.h>
 
 #include <vlc_common.h>
 #include "fs.h"
@@ -41,6 +44,7 @@
 
 #include <vlc_fs.h>
 #include <vlc_url.h>
+#include <vlc_atomic.h>
 
 struct access_sys_t
 {
@@ -109,6 +113,213 @@ void DirClose(vlc_object_t *obj)
     closedir(sys->dir);
 }
 
+#define DIR_ENTRY_IGNORE (-1)
+#define DIR_ENTRY_STAT    (-2)
+
+static int ModeToType(mode_t mode, bool special_files)
+{
+    switch (mode & S_IFMT)
+    {
+        case S_IFBLK:
+            return special_files ? ITEM_TYPE_DISC : DIR_ENTRY_IGNORE;
+        case S_IFCHR:
+            return special_files ? ITEM_TYPE_CARD : DIR_ENTRY_IGNORE;
+        case S_IFIFO:
+            return special_files ? ITEM_TYPE_STREAM : DIR_ENTRY_IGNORE;
+        case S_IFREG:
+            return ITEM_TYPE_FILE;
+        case S_IFDIR:
+            return ITEM_TYPE_DIRECTORY;
+        /* S_IFLNK cannot occur while following symbolic links */
+        /* S_IFSOCK cannot be opened with open()/openat() */
+    }
+    return DIR_ENTRY_IGNORE;
+}
+
+static int AddEntry(stream_t *access, struct vlc_readdir_helper *rdh,
+                    const char *entry, int type)
+{
+    access_sys_t *sys = access->p_sys;
+
+    /* Create an input item for the current entry */
+    char *encoded = vlc_uri_encode(entry);
+    if (unlikely(encoded == NULL))
+        return VLC_ENOMEM;
+
+    char *uri;
+    if (unlikely(asprintf(&uri, "%s/%s", sys->base_uri, encoded) == -1))
+        uri = NULL;
+    free(encoded);
+    if (unlikely(uri == NULL))
+        return VLC_ENOMEM;
+
+    int ret = vlc_readdir_helper_additem(rdh, uri, NULL, entry, type,
+                                         ITEM_NET_UNKNOWN);
+    free(uri);
+    return ret;
+}
+
+#if defined (HAVE_OPENAT) && defined (DT_UNKNOWN)
+/* Most file systems tell the entry types while listing the directory. The
+ * others, as well as symbolic links, need a stat() per entry: these are
+ * done in parallel, as each one is a round-trip on network file systems. */
+#define DIR_STAT_THREADS 8
+#define DIR_STAT_MIN_PER_THREAD 16
+
+struct dir_entry
+{
+    char *name;
+    int type; /* input item type, DIR_ENTRY_IGNORE or DIR_ENTRY_STAT */
+};
+
+struct dir_stat_batch
+{
+    int fd;
+    bool special_files;
+    struct dir_entry *entries;
+    size_t count;
+    atomic_size_t next;
+};
+
+static int DirentToType(unsigned char type, bool special_files)
+{
+    switch (type)
+    {
+        case DT_BLK:
+            return ModeToType(S_IFBLK, special_files);
+        case DT_CHR:
+            return ModeToType(S_IFCHR, special_files);
+        case DT_FIFO:
+            return ModeToType(S_IFIFO, special_files);
+        case DT_REG:
+            return ModeToType(S_IFREG, special_files);
+        case DT_DIR:
+            return ModeToType(S_IFDIR, special_files);
+        case DT_SOCK:
+            return DIR_ENTRY_IGNORE;
+    }
+    return DIR_ENTRY_STAT; /* DT_LNK, DT_UNKNOWN */
+}
+
+static void *StatThread(void *data)
+{
+    struct dir_stat_batch *batch = data;
+    size_t i;
+
+    while ((i = atomic_fetch_add(&batch->next, 1)) < batch->count)
+    {
+        struct dir_entry *ent = &batch->entries[i];
+        struct stat st;
+
+        if (ent->type != DIR_ENTRY_STAT)
+            continue;
+        if (fstatat(batch->fd, ent->name, &st, 0))
+            ent->type = DIR_ENTRY_IGNORE;
+        else
+            ent->type = ModeToType(st.st_mode, batch->special_files);
+    }
+    return NULL;
+}
+
+static void StatEntries(struct dir_stat_batch *batch, size_t pending)
+{
+    vlc_thread_t threads[DIR_STAT_THREADS - 1];
+    unsigned count = pending / DIR_STAT_MIN_PER_THREAD;
+
+    if (count > DIR_STAT_THREADS)
+        count = DIR_STAT_THREADS;
+
+    atomic_init(&batch->next, 0);
+
+    /* The calling thread is one of the workers */
+    unsigned started = 0;
+    while (started + 1 < count
+        && !vlc_clone(&threads[started], StatThread, batch,
+                      VLC_THREAD_PRIORITY_LOW))
+        started++;
+
+    StatThread(batch);
+    for (unsigned i = 0; i < started; i++)
+        vlc_join(threads[i], NULL);
+}
+
+int DirRead (stream_t *access, input_item_node_t *node)
+{
+    access_sys_t *sys = access->p_sys;
+    struct dirent *ent;
+    int ret = VLC_SUCCESS;
+
+    bool special_files = var_InheritBool(access, "list-special-files");
+
+    struct dir_stat_batch batch = {
+        .fd = dirfd(sys->dir),
+        .special_files = special_files,
+        .entries = NULL,
+        .count = 0,
+    };
+    size_t size = 0, pending = 0;
+
+    /* vlc_readdir() is readdir() on these systems */
+    while ((ent = readdir(sys->dir)) != NULL)
+    {
+        const char *name = ent->d_name;
+
+        if (!strcmp(name, ".") || !strcmp(name, ".."))
+            continue;
+
+        int type = DirentToType(ent->d_type, special_files);
+        if (type == DIR_ENTRY_IGNORE)
+            continue;
+
+        if (batch.count == size)
+        {
+            size_t newsize = size ? 2 * size : 64;
+            struct dir_entry *tab = realloc(batch.entries,
+                                            newsize * sizeof (*tab));
+            if (unlikely(tab == NULL))
+            {
+                ret = VLC_ENOMEM;
+                break;
+            }
+            batch.entries = tab;
+            size = newsize;
+        }
+
+        struct dir_entry *e = &batch.entries[batch.count];
+        e->name = strdup(name);
+        if (unlikely(e->name == NULL))
+        {
+            ret = VLC_ENOMEM;
+            break;
+        }
+        e->type = type;
+        batch.count++;
+        if (type == DIR_ENTRY_STAT)
+            pending++;
+    }
+
+    if (ret == VLC_SUCCESS && pending > 0)
+        StatEntries(&batch, pending);
+
+    struct vlc_readdir_helper rdh;
+    vlc_readdir_helper_init(&rdh, access, node);
+
+    for (size_t i = 0; i < batch.count; i++)
+    {
+        struct dir_entry *e = &batch.entries[i];
+
+        if (ret == VLC_SUCCESS && e->type >= 0)
+            ret = AddEntry(access, &rdh, e->name, e->type);
+        free(e->name);
+    }
+    free(batch.entries);
+
+    vlc_readdir_helper_finish(&rdh, ret == VLC_SUCCESS);
+
+    return ret;
+}
+
+#else
 int DirRead (stream_t *access, input_item_node_t *node)
 {
     access_sys_t *sys = access->p_sys;
@@ -123,7 +334,6 @@ int DirRead (stream_t *access, input_item_node_t *node)
     while (ret == VLC_SUCCESS && (entry = vlc_readdir(sys->dir)) != NULL)
     {
         struct stat st;
-        int type;
 
 #ifdef HAVE_OPENAT
         if (fstatat(dirfd(sys->dir), entry, &st, 0))
@@ -135,58 +345,15 @@ int DirRead (stream_t *access, input_item_node_t *node)
                      entry) >= PATH_MAX || vlc_stat(path, &st))
             continue;
 #endif
-        switch (st.st_mode & S_IFMT)
-        {
-            case S_IFBLK:
-                if (!special_files)
-                    continue;
-                type = ITEM_TYPE_DISC;
-                break;
-            case S_IFCHR:
-                if (!special_files)
-                    continue;
-                type = ITEM_TYPE_CARD;
-                break;
-            case S_IFIFO:
-                if (!special_files)
-                    continue;
-                type = ITEM_TYPE_STREAM;
-                break;
-            case S_IFREG:
-                type = ITEM_TYPE_FILE;
-                break;
-            case S_IFDIR:
-                type = ITEM_TYPE_DIRECTORY;
-                break;
-            /* S_IFLNK cannot occur while following symbolic links */
-            /* S_IFSOCK cannot be opened with open()/openat() */
-            default:
-                continue; /* ignore */
-        }
-
-        /* Create an input item for the current entry */
-        char *encoded = vlc_uri_encode(entry);
-        if (unlikely(encoded == NULL))
-        {
-            ret = VLC_ENOMEM;
-            break;
-        }
+        int type = ModeToType(st.st_mode, special_files);
+        if (type == DIR_ENTRY_IGNORE)
+            continue;
 
-        char *uri;
-        if (unlikely(asprintf(&uri, "%s/%s", sys->base_uri, encoded) == -1))
-            uri = NULL;
-        free(encoded);
-        if (unlikely(uri == NULL))
-        {
-            ret = VLC_ENOMEM;
-            break;
-        }
-        ret = vlc_readdir_helper_additem(&rdh, uri, NULL, entry, type,
-                                         ITEM_NET_UNKNOWN);
-        free(uri);
+        ret = AddEntry(access, &rdh, entry, type);
     }
 
     vlc_readdir_helper_finish(&rdh, ret == VLC_SUCCESS);
 
     return ret;
 }
+#endif
@@ -424,11 +424,26 @@ vlc_module_begin ()
 #endif
 vlc_module_end ()
 
+/* TS data is read in blocks of DVB_BLOCK_MIN to DVB_BLOCK_MAX bytes, so that
+ * the device is read about DVB_READ_RATE times per second */
+#define DVB_BLOCK_MIN (20 * 188)
+#define DVB_BLOCK_MAX (1024 * 188)
+#define DVB_READ_RATE 100
+/* The kernel buffers DVB_BUFFER_DURATION of TS data, up to DVB_BUFFER_MAX */
+#define DVB_BUFFER_DURATION (CLOCK_FREQ / 2)
+#define DVB_BUFFER_MAX (16 << 20)
+/* The bit rate is measured, and the information updated, every second */
+#define DVB_RATE_PERIOD CLOCK_FREQ
+
 struct access_sys_t
 {
     dvb_device_t *dev;
     uint8_t signal_poll;
     tuner_setup_t pf_setup;
+
+    size_t block_size;
+    uint64_t rate_bytes;
+    mtime_t rate_start;
 };
 
 static block_t *Read (stream_t *, bool *);
@@ -459,6 +474,9 @@ static int Open (vlc_object_t *obj)
     sys->dev = dev;
     sys->signal_poll = 0;
     sys->pf_setup = NULL;
+    sys->block_size = DVB_BLOCK_MIN;
+    sys->rate_bytes = 0;
+    sys->rate_start = mdate ();
     access->p_sys = sys;
 
     uint64_t freq = var_InheritFrequency (obj);
@@ -499,15 +517,49 @@ static void Close (vlc_object_t *obj)
     free (sys);
 }
 
+/** Adapts the block and kernel buffer sizes to the measured bit rate */
+static void UpdateRate (stream_t *access, mtime_t now)
+{
+    access_sys_t *sys = access->p_sys;
+    const uint64_t rate = sys->rate_bytes * CLOCK_FREQ
+                        / (now - sys->rate_start); /* bytes per second */
+
+    size_t block_size = rate / DVB_READ_RATE;
+    block_size -= block_size % 188;
+    sys->block_size = VLC_CLIP(block_size, DVB_BLOCK_MIN, DVB_BLOCK_MAX);
+
+    /* Grow by powers of two, as expanding the buffer discards its data */
+    uint64_t buffer_size = rate * DVB_BUFFER_DURATION / CLOCK_FREQ;
+    size_t size = 1;
+    while (size < buffer_size && size < DVB_BUFFER_MAX)
+        size <<= 1;
+    dvb_set_buffer_size (sys->dev, size);
+
+    if (access->p_input != NULL)
+    {
+        input_item_t *item = input_GetItem (access->p_input);
+        const char *cat = _("Digital broadcasting");
+
+        input_item_AddInfo (item, cat, _("Bit rate"), "%.2f Mb/s",
+                            rate * 8 / 1e6);
+        input_item_AddInfo (item, cat, _("Read size"), "%zu bytes",
+                            sys->block_size);
+        input_item_AddInfo (item, cat, _("Buffer overflows"), "%u",
+                            dvb_get_overflows (sys->dev));
+    }
+
+    sys->rate_bytes = 0;
+    sys->rate_start = now;
+}
+
 static block_t *Read (stream_t *access, bool *restrict eof)
 {
-#define BUFSIZE (20*188)
-    block_t *block = block_Alloc (BUFSIZE);
+    access_sys_t *sys = access->p_sys;
+    block_t *block = block_Alloc (sys->block_size);
     if (unlikely(block == NULL))
         return NULL;
 
-    access_sys_t *sys = access->p_sys;
-    ssize_t val = dvb_read (sys->dev, block->p_buffer, BUFSIZE, -1);
+    ssize_t val = dvb_read (sys->dev, block->p_buffer, sys->block_size, -1);
 
     if (val <= 0)
     {
@@ -519,6 +571,10 @@ static block_t *Read (stream_t *access, bool *restrict eof)
 
     block->i_buffer = val;
 
+    sys->rate_bytes += val;
+    mtime_t now = mdate ();
+    if (now - sys->rate_start >= DVB_RATE_PERIOD)
+        UpdateRate (access, now);
     return block;
 }
 
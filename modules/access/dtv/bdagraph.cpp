@@ -159,6 +159,16 @@ ssize_t dvb_read (dvb_device_t *d, void *buf, size_t len, int ms)
     return d->module->Pop(buf, len, ms);
 }
 
+int dvb_set_buffer_size (dvb_device_t *, size_t)
+{
+    return -1;
+}
+
+unsigned dvb_get_overflows (const dvb_device_t *)
+{
+    return 0;
+}
+
 int dvb_add_pid (dvb_device_t *, uint16_t)
 {
     return 0;
@@ -63,6 +63,8 @@ tuner_setup_t dtv_get_delivery_tuner_setup( dtv_delivery_t );
 dvb_device_t *dvb_open (vlc_object_t *obj);
 void dvb_close (dvb_device_t *);
 ssize_t dvb_read (dvb_device_t *, void *, size_t, int);
+int dvb_set_buffer_size (dvb_device_t *, size_t);
+unsigned dvb_get_overflows (const dvb_device_t *);
 
 int dvb_add_pid (dvb_device_t *, uint16_t);
 void dvb_remove_pid (dvb_device_t *, uint16_t);
@@ -159,9 +159,13 @@ struct dvb_device
     cam_t *cam;
     uint8_t device;
     bool budget;
-    //size_t buffer_size;
+    size_t buffer_size;
+    unsigned overflows;
 };
 
+/* Initial size of the kernel demultiplexing buffer */
+#define DVB_BUFFER_SIZE (1 << 20)
+
 /** Opens the device directory for the specified DVB adapter */
 static int dvb_open_adapter (uint8_t adapter)
 {
@@ -205,6 +209,8 @@ dvb_device_t *dvb_open (vlc_object_t *obj)
     d->frontend = -1;
     d->cam = NULL;
     d->budget = var_InheritBool (obj, "dvb-budget-mode");
+    d->buffer_size = 0;
+    d->overflows = 0;
 
 #ifndef USE_DMX
     if (d->budget)
@@ -220,9 +226,7 @@ dvb_device_t *dvb_open (vlc_object_t *obj)
            return NULL;
        }
 
-       if (ioctl (d->demux, DMX_SET_BUFFER_SIZE, 1 << 20) < 0)
-           msg_Warn (obj, "cannot expand demultiplexing buffer: %s",
-                     vlc_strerror_c(errno));
+       dvb_set_buffer_size (d, DVB_BUFFER_SIZE);
 
        /* We need to filter at least one PID. The tap for TS demultiplexing
         * cannot be configured otherwise. So add the PAT. */
@@ -253,6 +257,7 @@ dvb_device_t *dvb_open (vlc_object_t *obj)
             free (d);
             return NULL;
         }
+        dvb_set_buffer_size (d, DVB_BUFFER_SIZE);
 #endif
     }
 
@@ -311,6 +316,7 @@ static void dvb_frontend_status(vlc_object_t *obj, fe_status_t s)
 
 /**
  * Reads TS data from the tuner.
+ * Only the data that is already buffered is read, up to len bytes.
  * @return number of bytes read, 0 on EOF, -1 if no data (yet).
  */
 ssize_t dvb_read (dvb_device_t *d, void *buf, size_t len, int ms)
@@ -366,6 +372,7 @@ ssize_t dvb_read (dvb_device_t *d, void *buf, size_t len, int ms)
             if (errno == EOVERFLOW)
             {
                 msg_Err (d->obj, "cannot demux data fast enough!");
+                d->overflows++;
                 return -1;
             }
             msg_Err (d->obj, "cannot demux: %s", vlc_strerror_c(errno));
@@ -377,6 +384,32 @@ ssize_t dvb_read (dvb_device_t *d, void *buf, size_t len, int ms)
     return -1;
 }
 
+/**
+ * Expands the kernel buffer of the demultiplexer or DVR device.
+ * The buffer is never shrunk. Expanding it discards the buffered data.
+ */
+int dvb_set_buffer_size (dvb_device_t *d, size_t size)
+{
+    if (size <= d->buffer_size)
+        return 0;
+
+    if (ioctl (d->demux, DMX_SET_BUFFER_SIZE, (unsigned long)size) < 0)
+    {
+        msg_Warn (d->obj, "cannot expand demultiplexing buffer: %s",
+                  vlc_strerror_c(errno));
+        return -1;
+    }
+    msg_Dbg (d->obj, "demultiplexing buffer of %zu bytes", size);
+    d->buffer_size = size;
+    return 0;
+}
+
+/** Counts the overflows of the kernel buffer */
+unsigned dvb_get_overflows (const dvb_device_t *d)
+{
+    return d->overflows;
+}
+
 int dvb_add_pid (dvb_device_t *d, uint16_t pid)
 {
     if (d->budget)
@@ -51,6 +51,9 @@
 #else
 #   include <unistd.h>
 #endif
+#ifdef HAVE_MMAP
+#   include <sys/mman.h>
+#endif
 #include <dirent.h>
 
 #include <vlc_common.h>
@@ -63,10 +66,13 @@
 #include <vlc_fs.h>
 #include <vlc_url.h>
 #include <vlc_interrupt.h>
+#include "file_aio.h"
 
 struct access_sys_t
 {
     int fd;
+    file_aio_t *aio;
+    uint64_t offset; /* memory mapped mode only */
 
     bool b_pace_control;
 };
@@ -126,8 +132,17 @@ static bool IsRemote (const char *path)
 #ifndef HAVE_POSIX_FADVISE
 # define posix_fadvise(fd, off, len, adv)
 #endif
+#ifndef HAVE_POSIX_MADVISE
+# define posix_madvise(addr, len, adv)
+#endif
+
+/* Size of the memory mapped blocks */
+#define FILE_MMAP_BLOCK_SIZE (1 << 20)
 
 static ssize_t Read (stream_t *, void *, size_t);
+#ifdef HAVE_MMAP
+static block_t *BlockMmap (stream_t *, bool *);
+#endif
 static int FileSeek (stream_t *, uint64_t);
 static int NoSeek (stream_t *, uint64_t);
 static int FileControl (stream_t *, int, va_list);
@@ -213,6 +228,7 @@ int FileOpen( vlc_object_t *p_this )
     p_access->pf_control = FileControl;
     p_access->p_sys = p_sys;
     p_sys->fd = fd;
+    p_sys->aio = NULL;
 
     if (S_ISREG (st.st_mode) || S_ISBLK (st.st_mode))
     {
@@ -232,6 +248,27 @@ int FileOpen( vlc_object_t *p_this )
         else
             fcntl (fd, F_RDAHEAD, 1);
 #endif
+#ifdef HAVE_MMAP
+        /* Blocks referencing the mapped pages save a copy. This is not the
+         * default, as truncating a mapped file raises SIGBUS. */
+        if (S_ISREG (st.st_mode) && !IsRemote(fd, p_access->psz_filepath)
+         && var_InheritBool (p_access, "file-mmap"))
+        {
+            off_t offset = lseek (fd, 0, SEEK_CUR);
+
+            p_sys->offset = (offset != (off_t)-1) ? offset : 0;
+            p_access->pf_read = NULL;
+            p_access->pf_block = BlockMmap;
+            msg_Dbg (p_access, "memory mapped mode");
+        }
+        else
+#endif
+        if (S_ISREG (st.st_mode))
+        {
+            unsigned depth = var_InheritInteger (p_access, "file-read-ahead");
+            if (depth > 0)
+                p_sys->aio = file_aio_New (p_this, fd, depth);
+        }
     }
     else
     {
@@ -253,7 +290,7 @@ void FileClose (vlc_object_t * p_this)
 {
     stream_t     *p_access = (stream_t*)p_this;
 
-    if (p_access->pf_read == NULL)
+    if (p_access->pf_read == NULL && p_access->pf_block == NULL)
     {
         DirClose (p_this);
         return;
@@ -261,6 +298,8 @@ void FileClose (vlc_object_t * p_this)
 
     access_sys_t *p_sys = p_access->p_sys;
 
+    if (p_sys->aio != NULL)
+        file_aio_Delete (p_sys->aio);
     vlc_close (p_sys->fd);
 }
 
@@ -270,7 +309,9 @@ static ssize_t Read (stream_t *p_access, void *p_buffer, size_t i_len)
     access_sys_t *p_sys = p_access->p_sys;
     int fd = p_sys->fd;
 
-    ssize_t val = vlc_read_i11e (fd, p_buffer, i_len);
+    ssize_t val = (p_sys->aio != NULL)
+                ? file_aio_Read (p_sys->aio, p_buffer, i_len)
+                : vlc_read_i11e (fd, p_buffer, i_len);
     if (val < 0)
     {
         switch (errno)
@@ -287,6 +328,57 @@ static ssize_t Read (stream_t *p_access, void *p_buffer, size_t i_len)
     return val;
 }
 
+#ifdef HAVE_MMAP
+static block_t *BlockMmap (stream_t *p_access, bool *restrict eof)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    struct stat st;
+
+    /* The file may grow while being read */
+    if (fstat (p_sys->fd, &st))
+    {
+        msg_Err (p_access, "read error: %s", vlc_strerror_c(errno));
+        *eof = true;
+        return NULL;
+    }
+    if (p_sys->offset >= (uint64_t)st.st_size)
+    {
+        *eof = true;
+        return NULL;
+    }
+
+    uint64_t offset = p_sys->offset;
+    size_t skip = offset % sysconf (_SC_PAGESIZE);
+    size_t length = __MIN(FILE_MMAP_BLOCK_SIZE, st.st_size - offset);
+
+    /* Private mapping: consumers may write into the blocks, as they do into
+     * allocated blocks, without modifying the file */
+    void *addr = mmap (NULL, skip + length, PROT_READ|PROT_WRITE,
+                       MAP_PRIVATE, p_sys->fd, offset - skip);
+    if (addr == MAP_FAILED)
+    {
+        msg_Err (p_access, "memory mapping error: %s", vlc_strerror_c(errno));
+        *eof = true;
+        return NULL;
+    }
+
+    posix_madvise (addr, skip + length, POSIX_MADV_SEQUENTIAL);
+    posix_madvise (addr, skip + length, POSIX_MADV_WILLNEED);
+    /* Get the next block on its way too */
+    posix_fadvise (p_sys->fd, offset + length, FILE_MMAP_BLOCK_SIZE,
+                   POSIX_FADV_WILLNEED);
+
+    block_t *block = block_mmap_Alloc (addr, skip + length);
+    if (unlikely(block == NULL))
+        return NULL;
+
+    block->p_buffer += skip;
+    block->i_buffer -= skip;
+    p_sys->offset += length;
+    return block;
+}
+#endif
+
 /*****************************************************************************
  * Seek: seek to a specific location in a file
  *****************************************************************************/
@@ -294,6 +386,14 @@ static int FileSeek (stream_t *p_access, uint64_t i_pos)
 {
     access_sys_t *sys = p_access->p_sys;
 
+    if (p_access->pf_read == NULL)
+    {   /* memory mapped */
+        sys->offset = i_pos;
+        return VLC_SUCCESS;
+    }
+
+    if (sys->aio != NULL)
+        return file_aio_Seek(sys->aio, i_pos);
     if (lseek(sys->fd, i_pos, SEEK_SET) == (off_t)-1)
         return VLC_EGENERIC;
     return VLC_SUCCESS;
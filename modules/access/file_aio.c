@@ -0,0 +1,518 @@
+/*****************************************************************************
+ * file_aio.c: asynchronous read-ahead for the file access
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include <vlc_common.h>
+#include "file_aio.h"
+
+#ifdef HAVE_FILE_AIO
+#ifdef _WIN32
+# include <windows.h>
+# include <io.h>
+#else
+# include <poll.h>
+# include <unistd.h>
+# include <sys/eventfd.h>
+# include <sys/mman.h>
+# include <sys/uio.h>
+# include <linux/io_uring.h>
+# include <vlc_atomic.h>
+# include <vlc_interrupt.h>
+#endif
+
+struct file_aio_slot
+{
+    uint8_t *buf;
+    uint64_t offset;
+    size_t   length;
+    ssize_t  result; /* bytes read, or -errno */
+    bool     pending;
+    mtime_t  date;
+#ifdef _WIN32
+    OVERLAPPED ov;
+#else
+    struct iovec iov;
+#endif
+};
+
+struct file_aio
+{
+    vlc_object_t *obj;
+#ifdef _WIN32
+    HANDLE handle;
+#else
+    int fd;
+    int ring_fd;
+    int event_fd;
+    void *sq_ring, *cq_ring;
+    size_t sq_ring_size, cq_ring_size;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+    atomic_uint *sq_tail;
+    unsigned *sq_array;
+    unsigned sq_mask;
+    atomic_uint *cq_head, *cq_tail;
+    struct io_uring_cqe *cqes;
+    unsigned cq_mask;
+#endif
+
+    uint64_t offset; /* read position */
+    uint64_t next; /* offset of the next read ahead */
+    unsigned head; /* slot containing the read position */
+    unsigned count;
+
+    struct
+    {
+        uint64_t i_reads;
+        mtime_t  i_latency_total;
+        mtime_t  i_latency_max;
+        mtime_t  i_wait_total; /* with the reader blocked */
+    } stat;
+
+    struct file_aio_slot slots[];
+};
+
+static void Complete(file_aio_t *aio, struct file_aio_slot *slot,
+                     ssize_t result)
+{
+    mtime_t latency = mdate() - slot->date;
+
+    assert(slot->pending);
+    slot->pending = false;
+    slot->result = result;
+
+    aio->stat.i_reads++;
+    aio->stat.i_latency_total += latency;
+    if (latency > aio->stat.i_latency_max)
+        aio->stat.i_latency_max = latency;
+}
+
+#ifdef _WIN32
+/*** Overlapped I/O ***/
+static int Setup(file_aio_t *aio, int fd)
+{
+    /* The descriptor was not opened for overlapped I/O */
+    aio->handle = ReOpenFile((HANDLE)_get_osfhandle(fd), GENERIC_READ,
+                             FILE_SHARE_READ|FILE_SHARE_WRITE|FILE_SHARE_DELETE,
+                             FILE_FLAG_OVERLAPPED);
+    if (aio->handle == INVALID_HANDLE_VALUE)
+        return -1;
+
+    for (unsigned i = 0; i < aio->count; i++)
+    {
+        HANDLE event = CreateEvent(NULL, TRUE, FALSE, NULL);
+        if (event == NULL)
+        {
+            while (i > 0)
+                CloseHandle(aio->slots[--i].ov.hEvent);
+            CloseHandle(aio->handle);
+            return -1;
+        }
+        aio->slots[i].ov.hEvent = event;
+    }
+    return 0;
+}
+
+static void Cleanup(file_aio_t *aio)
+{
+    for (unsigned i = 0; i < aio->count; i++)
+        CloseHandle(aio->slots[i].ov.hEvent);
+    CloseHandle(aio->handle);
+}
+
+static ssize_t Result(BOOL ok, DWORD length)
+{
+    if (ok)
+        return length;
+    return (GetLastError() == ERROR_HANDLE_EOF) ? 0 : -EIO;
+}
+
+static void Submit(file_aio_t *aio, struct file_aio_slot *slot,
+                   uint64_t offset, size_t length)
+{
+    HANDLE event = slot->ov.hEvent;
+
+    slot->offset = offset;
+    slot->length = length;
+    slot->pending = true;
+    slot->date = mdate();
+
+    memset(&slot->ov, 0, sizeof (slot->ov));
+    slot->ov.Offset = offset;
+    slot->ov.OffsetHigh = offset >> 32;
+    slot->ov.hEvent = event;
+
+    /* The result is fetched with GetOverlappedResult() even if the read
+     * completed synchronously */
+    if (!ReadFile(aio->handle, slot->buf, length, NULL, &slot->ov)
+     && GetLastError() != ERROR_IO_PENDING)
+        Complete(aio, slot, Result(FALSE, 0));
+}
+
+/* Waits are not interruptible, as for synchronous reads */
+static int Wait(file_aio_t *aio, struct file_aio_slot *slot,
+                bool interruptible)
+{
+    DWORD length;
+    BOOL ok = GetOverlappedResult(aio->handle, &slot->ov, &length, TRUE);
+
+    (void) interruptible;
+    Complete(aio, slot, Result(ok, length));
+    return 0;
+}
+
+static void Cancel(file_aio_t *aio, struct file_aio_slot *slot)
+{
+    CancelIoEx(aio->handle, &slot->ov);
+    Wait(aio, slot, false);
+}
+
+#else
+/*** io_uring ***/
+static int Enter(file_aio_t *aio, unsigned submit, unsigned wait)
+{
+    int ret;
+
+    do
+        ret = syscall(__NR_io_uring_enter, aio->ring_fd, submit, wait,
+                      wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+    while (ret < 0 && errno == EINTR);
+    return ret;
+}
+
+static void Cleanup(file_aio_t *aio)
+{
+    if (aio->sqes != MAP_FAILED)
+        munmap(aio->sqes, aio->sqes_size);
+    if (aio->cq_ring != MAP_FAILED)
+        munmap(aio->cq_ring, aio->cq_ring_size);
+    if (aio->sq_ring != MAP_FAILED)
+        munmap(aio->sq_ring, aio->sq_ring_size);
+    if (aio->event_fd != -1)
+        close(aio->event_fd);
+    close(aio->ring_fd);
+}
+
+static int Setup(file_aio_t *aio, int fd)
+{
+    struct io_uring_params p;
+
+    memset(&p, 0, sizeof (p));
+    aio->fd = fd;
+    aio->ring_fd = syscall(__NR_io_uring_setup, aio->count, &p);
+    if (aio->ring_fd == -1)
+        return -1;
+
+    aio->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof (unsigned);
+    aio->cq_ring_size = p.cq_off.cqes
+                      + p.cq_entries * sizeof (struct io_uring_cqe);
+    aio->sqes_size = p.sq_entries * sizeof (struct io_uring_sqe);
+    aio->sq_ring = mmap(NULL, aio->sq_ring_size, PROT_READ|PROT_WRITE,
+                        MAP_SHARED|MAP_POPULATE, aio->ring_fd,
+                        IORING_OFF_SQ_RING);
+    aio->cq_ring = mmap(NULL, aio->cq_ring_size, PROT_READ|PROT_WRITE,
+                        MAP_SHARED|MAP_POPULATE, aio->ring_fd,
+                        IORING_OFF_CQ_RING);
+    aio->sqes = mmap(NULL, aio->sqes_size, PROT_READ|PROT_WRITE,
+                     MAP_SHARED|MAP_POPULATE, aio->ring_fd, IORING_OFF_SQES);
+    /* Completions are signaled to an event, so that waits can be
+     * interrupted */
+    aio->event_fd = eventfd(0, EFD_CLOEXEC|EFD_NONBLOCK);
+    if (aio->sq_ring == MAP_FAILED || aio->cq_ring == MAP_FAILED
+     || aio->sqes == MAP_FAILED || aio->event_fd == -1
+     || syscall(__NR_io_uring_register, aio->ring_fd,
+                IORING_REGISTER_EVENTFD, &aio->event_fd, 1))
+    {
+        Cleanup(aio);
+        return -1;
+    }
+
+    char *sq = aio->sq_ring, *cq = aio->cq_ring;
+
+    aio->sq_tail = (atomic_uint *)(sq + p.sq_off.tail);
+    aio->sq_array = (unsigned *)(sq + p.sq_off.array);
+    aio->sq_mask = *(unsigned *)(sq + p.sq_off.ring_mask);
+    aio->cq_head = (atomic_uint *)(cq + p.cq_off.head);
+    aio->cq_tail = (atomic_uint *)(cq + p.cq_off.tail);
+    aio->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+    aio->cq_mask = *(unsigned *)(cq + p.cq_off.ring_mask);
+    return 0;
+}
+
+static void Submit(file_aio_t *aio, struct file_aio_slot *slot,
+                   uint64_t offset, size_t length)
+{
+    slot->offset = offset;
+    slot->length = length;
+    slot->pending = true;
+    slot->date = mdate();
+    slot->iov.iov_base = slot->buf;
+    slot->iov.iov_len = length;
+
+    /* This is the only submitter: no need to synchronize the tail */
+    unsigned tail = atomic_load_explicit(aio->sq_tail, memory_order_relaxed);
+    unsigned idx = tail & aio->sq_mask;
+    struct io_uring_sqe *sqe = &aio->sqes[idx];
+
+    memset(sqe, 0, sizeof (*sqe));
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = aio->fd;
+    sqe->off = offset;
+    sqe->addr = (uintptr_t)&slot->iov;
+    sqe->len = 1;
+    sqe->user_data = slot - aio->slots;
+    aio->sq_array[idx] = idx;
+    atomic_store_explicit(aio->sq_tail, tail + 1, memory_order_release);
+
+    if (Enter(aio, 1, 0) < 1)
+    {   /* Not consumed by the kernel: take it back */
+        int err = errno;
+
+        atomic_store_explicit(aio->sq_tail, tail, memory_order_release);
+        Complete(aio, slot, -err);
+    }
+}
+
+static void Reap(file_aio_t *aio)
+{
+    unsigned head = atomic_load_explicit(aio->cq_head, memory_order_relaxed);
+
+    while (head != atomic_load_explicit(aio->cq_tail, memory_order_acquire))
+    {
+        const struct io_uring_cqe *cqe = &aio->cqes[head & aio->cq_mask];
+
+        assert(cqe->user_data < aio->count);
+        Complete(aio, &aio->slots[cqe->user_data], cqe->res);
+        head++;
+    }
+    atomic_store_explicit(aio->cq_head, head, memory_order_release);
+}
+
+static int Wait(file_aio_t *aio, struct file_aio_slot *slot,
+                bool interruptible)
+{
+    for (;;)
+    {
+        Reap(aio);
+        if (!slot->pending)
+            return 0;
+
+        if (interruptible)
+        {
+            struct pollfd ufd = { .fd = aio->event_fd, .events = POLLIN };
+            uint64_t count;
+
+            if (vlc_poll_i11e(&ufd, 1, -1) < 0 && errno == EINTR)
+                return -1;
+            if (read(aio->event_fd, &count, sizeof (count)) < 0)
+                continue; /* already reset, nothing to do */
+        }
+        else
+            Enter(aio, 0, 1);
+    }
+}
+
+/* Reads of the read-ahead size complete soon enough: just wait */
+static void Cancel(file_aio_t *aio, struct file_aio_slot *slot)
+{
+    Wait(aio, slot, false);
+}
+#endif
+
+/*** Read-ahead ***/
+static void Fill(file_aio_t *aio)
+{
+    for (unsigned i = 0; i < aio->count; i++)
+    {
+        struct file_aio_slot *slot =
+            &aio->slots[(aio->head + i) % aio->count];
+
+        assert(!slot->pending);
+        Submit(aio, slot, aio->next, FILE_AIO_READ_SIZE);
+        aio->next += FILE_AIO_READ_SIZE;
+    }
+}
+
+static void Drain(file_aio_t *aio)
+{
+    for (unsigned i = 0; i < aio->count; i++)
+        if (aio->slots[i].pending)
+            Cancel(aio, &aio->slots[i]);
+}
+
+/* Recycles the slot at the read position, once consumed */
+static void Advance(file_aio_t *aio, struct file_aio_slot *slot)
+{
+    assert(slot == &aio->slots[aio->head]);
+
+    if ((size_t)slot->result < slot->length)
+    {   /* Short read: read the rest */
+        Submit(aio, slot, aio->offset,
+               slot->offset + slot->length - aio->offset);
+        return;
+    }
+
+    Submit(aio, slot, aio->next, FILE_AIO_READ_SIZE);
+    aio->next += FILE_AIO_READ_SIZE;
+    aio->head = (aio->head + 1) % aio->count;
+}
+
+file_aio_t *file_aio_New(vlc_object_t *obj, int fd, unsigned depth)
+{
+    file_aio_t *aio = malloc(sizeof (*aio) + depth * sizeof (aio->slots[0]));
+    if (unlikely(aio == NULL))
+        return NULL;
+
+    aio->obj = obj;
+    aio->count = depth;
+    aio->head = 0;
+    memset(&aio->stat, 0, sizeof (aio->stat));
+
+    for (unsigned i = 0; i < depth; i++)
+    {
+        aio->slots[i].buf = malloc(FILE_AIO_READ_SIZE);
+        aio->slots[i].pending = false;
+        if (unlikely(aio->slots[i].buf == NULL))
+        {
+            aio->count = i + 1;
+            goto error;
+        }
+    }
+
+    if (Setup(aio, fd))
+    {
+        msg_Dbg(obj, "asynchronous reads not supported");
+        goto error;
+    }
+
+    /* The descriptor offset is not used afterwards */
+    off_t offset = lseek(fd, 0, SEEK_CUR);
+    aio->offset = aio->next = (offset != (off_t)-1) ? offset : 0;
+    Fill(aio);
+
+    msg_Dbg(obj, "%u asynchronous reads of %u bytes in flight", depth,
+            FILE_AIO_READ_SIZE);
+    return aio;
+
+error:
+    for (unsigned i = 0; i < aio->count; i++)
+        free(aio->slots[i].buf);
+    free(aio);
+    return NULL;
+}
+
+void file_aio_Delete(file_aio_t *aio)
+{
+    Drain(aio);
+    Cleanup(aio);
+
+    msg_Dbg(aio->obj, "%"PRIu64" asynchronous reads, latency %"PRId64" us "
+            "average, %"PRId64" us max, reader waited %"PRId64" ms",
+            aio->stat.i_reads,
+            aio->stat.i_reads ? aio->stat.i_latency_total
+                                / (mtime_t)aio->stat.i_reads : 0,
+            aio->stat.i_latency_max, aio->stat.i_wait_total / 1000);
+
+    for (unsigned i = 0; i < aio->count; i++)
+        free(aio->slots[i].buf);
+    free(aio);
+}
+
+ssize_t file_aio_Read(file_aio_t *aio, void *buf, size_t len)
+{
+    struct file_aio_slot *slot = &aio->slots[aio->head];
+
+    if (slot->pending)
+    {
+        mtime_t start = mdate();
+        int ret = Wait(aio, slot, true);
+
+        aio->stat.i_wait_total += mdate() - start;
+        if (ret)
+            return -1;
+    }
+
+    if (slot->result < 0)
+    {   /* Retry on the next call */
+        errno = -slot->result;
+        Submit(aio, slot, slot->offset, slot->length);
+        return -1;
+    }
+
+    assert(aio->offset >= slot->offset);
+    uint64_t end = slot->offset + slot->result;
+
+    if (aio->offset >= end)
+    {   /* End of file, for now: the file might grow */
+        Submit(aio, slot, aio->offset,
+               slot->offset + slot->length - aio->offset);
+        return 0;
+    }
+
+    size_t copy = __MIN(len, end - aio->offset);
+
+    memcpy(buf, slot->buf + (aio->offset - slot->offset), copy);
+    aio->offset += copy;
+    if (aio->offset == end)
+        Advance(aio, slot);
+    return copy;
+}
+
+int file_aio_Seek(file_aio_t *aio, uint64_t offset)
+{
+    struct file_aio_slot *slot = &aio->slots[aio->head];
+
+    if (offset < slot->offset || offset >= aio->next)
+    {   /* Outside of the read-ahead: start over */
+        Drain(aio);
+        aio->offset = aio->next = offset;
+        Fill(aio);
+        return VLC_SUCCESS;
+    }
+
+    /* Skip the reads before the target */
+    while (offset >= slot->offset + slot->length)
+    {
+        if (slot->pending)
+            Cancel(aio, slot);
+        Submit(aio, slot, aio->next, FILE_AIO_READ_SIZE);
+        aio->next += FILE_AIO_READ_SIZE;
+        aio->head = (aio->head + 1) % aio->count;
+        slot = &aio->slots[aio->head];
+    }
+
+    aio->offset = offset;
+
+    /* A completed short read might not reach the target */
+    if (!slot->pending && slot->result >= 0
+     && offset > slot->offset + slot->result)
+        Submit(aio, slot, offset, slot->offset + slot->length - offset);
+    return VLC_SUCCESS;
+}
+#endif
@@ -0,0 +1,82 @@
+/*****************************************************************************
+ * file_aio.h: asynchronous read-ahead for the file access
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_ACCESS_FILE_AIO_H
+#define VLC_ACCESS_FILE_AIO_H
+
+/* Large reads are kept in flight ahead of the read position, so that the
+ * input thread only waits when the storage cannot keep up: io_uring on
+ * Linux, overlapped I/O on Windows. */
+#if defined (HAVE_LINUX_IO_URING_H) && defined (HAVE_SYS_EVENTFD_H)
+# include <sys/syscall.h>
+# ifdef __NR_io_uring_setup
+#  define HAVE_FILE_AIO 1
+# endif
+#elif defined (_WIN32) && !VLC_WINSTORE_APP
+# define HAVE_FILE_AIO 1
+#endif
+
+#define FILE_AIO_READ_SIZE (1 << 20)
+
+typedef struct file_aio file_aio_t;
+
+#ifdef HAVE_FILE_AIO
+/**
+ * Starts reading ahead from the current file offset.
+ *
+ * @param depth number of reads kept in flight
+ * @return NULL if asynchronous reads are not supported (e.g. old kernel)
+ */
+file_aio_t *file_aio_New(vlc_object_t *, int fd, unsigned depth);
+void file_aio_Delete(file_aio_t *);
+
+/**
+ * Reads like read(), and is interruptible where the system allows.
+ */
+ssize_t file_aio_Read(file_aio_t *, void *, size_t);
+int file_aio_Seek(file_aio_t *, uint64_t);
+#else
+static inline file_aio_t *file_aio_New(vlc_object_t *obj, int fd,
+                                       unsigned depth)
+{
+    (void) obj; (void) fd; (void) depth;
+    return NULL;
+}
+
+static inline void file_aio_Delete(file_aio_t *aio)
+{
+    (void) aio;
+    vlc_assert_unreachable();
+}
+
+static inline ssize_t file_aio_Read(file_aio_t *aio, void *buf, size_t len)
+{
+    (void) aio; (void) buf; (void) len;
+    vlc_assert_unreachable();
+}
+
+static inline int file_aio_Seek(file_aio_t *aio, uint64_t offset)
+{
+    (void) aio; (void) offset;
+    vlc_assert_unreachable();
+}
+#endif
+
+#endif
@@ -39,6 +39,17 @@ vlc_module_begin ()
     set_capability( "access", 50 )
     add_shortcut( "file", "fd", "stream" )
     set_callbacks( FileOpen, FileClose )
+    add_integer( "file-read-ahead", 4, N_("Asynchronous reads"),
+                 N_("Number of 1 MiB reads of regular files kept in flight "
+                    "ahead of the read position, where supported "
+                    "(0 to disable)."), true )
+        change_integer_range( 0, 64 )
+#ifdef HAVE_MMAP
+    add_bool( "file-mmap", false, N_("Memory mapped reads"),
+              N_("Map local regular files in memory, so that data can be "
+                 "handed to the demuxers without copying it. Truncating "
+                 "the file while it is in use crashes."), true )
+#endif
 
     add_submodule()
     set_section( N_("Directory" ), NULL )
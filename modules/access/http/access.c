@@ -258,6 +258,8 @@ static int Open(vlc_object_t *obj)
         access->pf_block = FileRead;
         access->pf_seek = FileSeek;
         access->pf_control = FileControl;
+        vlc_http_file_set_windows(sys->resource,
+                                  var_InheritInteger(obj, "http-parallel"));
     }
     access->p_sys = sys;
     return VLC_SUCCESS;
@@ -279,7 +281,10 @@ static void Close(vlc_object_t *obj)
     stream_t *access = (stream_t *)obj;
     access_sys_t *sys = access->p_sys;
 
-    vlc_http_res_destroy(sys->resource);
+    if (access->pf_block == FileRead)
+        vlc_http_file_destroy(sys->resource);
+    else
+        vlc_http_res_destroy(sys->resource);
     vlc_http_mgr_destroy(sys->manager);
     free(sys);
 }
@@ -297,6 +302,11 @@ vlc_module_begin()
              N_("Keep reading a resource that keeps being updated."), true)
         change_safe()
         change_volatile()
+    add_integer_with_range("http-parallel", 0, 0, 8,
+                           N_("Parallel ranges"),
+                           N_("Maximum number of byte ranges of a file "
+                              "downloaded in parallel ahead of the playback "
+                              "(0 to disable)."), true)
     add_bool("http-forward-cookies", true, N_("Cookies forwarding"),
              N_("Forward cookies across HTTP redirections."), true)
     add_string("http-referrer", NULL, N_("Referrer"),
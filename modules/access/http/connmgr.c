@@ -92,41 +92,212 @@ static char *vlc_http_proxy_find(const char *hostname, unsigned port,
 }
 
 
-struct vlc_http_mgr
+/** Delay after which an unused connection is closed */
+#define VLC_HTTP_MGR_IDLE_TIMEOUT (60 * CLOCK_FREQ)
+/** Maximum number of connections kept by a pool */
+#define VLC_HTTP_MGR_MAX_CONNS 16
+
+/** Pooled connection */
+struct vlc_http_mgr_conn
+{
+    struct vlc_http_mgr_conn *next;
+    struct vlc_http_conn *conn;
+    char *host;
+    char *proxy; /**< Proxy URL, or NULL if direct */
+    unsigned port;
+    bool secure;
+    bool http2; /**< Whether the connection multiplexes the streams */
+    mtime_t used; /**< Date of the last stream */
+};
+
+/**
+ * Connections pool of a LibVLC instance
+ *
+ * The connections are shared by all the HTTP resources of the instance, so
+ * that the playlist items, the preparser and the art fetcher use the
+ * already established connections. An HTTP/1 connection is used by one
+ * stream at a time, so there can be several towards the same server.
+ */
+struct vlc_http_pool
 {
-    vlc_object_t *obj;
+    struct vlc_http_pool *next;
+    vlc_object_t *obj; /**< LibVLC instance */
+    vlc_mutex_t lock;
+    unsigned refs;
     vlc_tls_creds_t *creds;
+    struct vlc_http_mgr_conn *conns; /**< Most recently used first */
+    unsigned count;
+};
+
+static vlc_mutex_t pools_lock = VLC_STATIC_MUTEX;
+static struct vlc_http_pool *pools = NULL;
+
+struct vlc_http_mgr
+{
     struct vlc_http_cookie_jar_t *jar;
-    struct vlc_http_conn *conn;
+    struct vlc_http_pool *pool;
 };
 
-static struct vlc_http_conn *vlc_http_mgr_find(struct vlc_http_mgr *mgr,
-                                               const char *host, unsigned port)
+static void vlc_http_mgr_conn_delete(struct vlc_http_mgr_conn *mc)
 {
-    (void) host; (void) port;
-    return mgr->conn;
+    vlc_http_conn_release(mc->conn);
+    free(mc->proxy);
+    free(mc->host);
+    free(mc);
 }
 
-static void vlc_http_mgr_release(struct vlc_http_mgr *mgr,
-                                 struct vlc_http_conn *conn)
+static bool vlc_http_mgr_conn_match(const struct vlc_http_mgr_conn *mc,
+                                    const char *host, unsigned port,
+                                    bool secure, const char *proxy)
+{
+    if (mc->secure != secure || mc->port != port
+     || strcasecmp(mc->host, host))
+        return false;
+    if (mc->proxy == NULL || proxy == NULL)
+        return mc->proxy == proxy;
+    return !strcmp(mc->proxy, proxy);
+}
+
+/* Must be called with the pool lock */
+static void vlc_http_pool_expire(struct vlc_http_pool *pool)
+{
+    const mtime_t deadline = mdate() - VLC_HTTP_MGR_IDLE_TIMEOUT;
+    struct vlc_http_mgr_conn **pp = &pool->conns;
+    unsigned n = 0;
+
+    /* A connection still in use is only closed once its stream is */
+    while (*pp != NULL)
+    {
+        struct vlc_http_mgr_conn *mc = *pp;
+
+        if (mc->used < deadline || n >= VLC_HTTP_MGR_MAX_CONNS)
+        {
+            *pp = mc->next;
+            pool->count--;
+            vlc_http_mgr_conn_delete(mc);
+        }
+        else
+        {
+            pp = &mc->next;
+            n++;
+        }
+    }
+}
+
+/**
+ * Sends a request through a pooled connection.
+ *
+ * Tries the matching connections, most recently used first. HTTP/1
+ * connections with an active stream are skipped, HTTP/2 connections are
+ * shared. Connections that fail are removed.
+ */
+static
+struct vlc_http_stream *vlc_http_pool_reuse(struct vlc_http_pool *pool,
+                                            const char *host, unsigned port,
+                                            bool secure, const char *proxy,
+                                            const struct vlc_http_msg *req,
+                                            struct vlc_http_conn **connp)
+{
+    struct vlc_http_stream *stream = NULL;
+
+    vlc_mutex_lock(&pool->lock);
+    vlc_http_pool_expire(pool);
+
+    for (struct vlc_http_mgr_conn **pp = &pool->conns, *mc; (mc = *pp) != NULL;)
+    {
+        if (!vlc_http_mgr_conn_match(mc, host, port, secure, proxy))
+        {
+            pp = &mc->next;
+            continue;
+        }
+
+        stream = vlc_http_stream_open(mc->conn, req);
+        if (stream != NULL)
+        {   /* Move to the front */
+            *pp = mc->next;
+            mc->next = pool->conns;
+            pool->conns = mc;
+            mc->used = mdate();
+            *connp = mc->conn;
+            break;
+        }
+
+        if (mc->http2)
+        {   /* Get rid of closing or reset connection */
+            *pp = mc->next;
+            pool->count--;
+            vlc_http_mgr_conn_delete(mc);
+        }
+        else /* Busy (or broken, until it expires) */
+            pp = &mc->next;
+    }
+    vlc_mutex_unlock(&pool->lock);
+    return stream;
+}
+
+/** Adds a new connection to the pool */
+static int vlc_http_pool_add(struct vlc_http_pool *pool,
+                             struct vlc_http_conn *conn, const char *host,
+                             unsigned port, bool secure, const char *proxy,
+                             bool http2)
 {
-    assert(mgr->conn == conn);
-    mgr->conn = NULL;
+    struct vlc_http_mgr_conn *mc = malloc(sizeof (*mc));
+    if (unlikely(mc == NULL))
+        return -1;
+
+    mc->conn = conn;
+    mc->host = strdup(host);
+    mc->proxy = (proxy != NULL) ? strdup(proxy) : NULL;
+    if (unlikely(mc->host == NULL || (proxy != NULL && mc->proxy == NULL)))
+    {
+        free(mc->proxy);
+        free(mc->host);
+        free(mc);
+        return -1;
+    }
+    mc->port = port;
+    mc->secure = secure;
+    mc->http2 = http2;
+    mc->used = mdate();
+
+    vlc_mutex_lock(&pool->lock);
+    mc->next = pool->conns;
+    pool->conns = mc;
+    pool->count++;
+    vlc_http_pool_expire(pool);
+    vlc_mutex_unlock(&pool->lock);
+    return 0;
+}
 
-    vlc_http_conn_release(conn);
+/** Removes a connection that failed, unless another thread did already */
+static void vlc_http_pool_remove(struct vlc_http_pool *pool,
+                                 struct vlc_http_conn *conn)
+{
+    vlc_mutex_lock(&pool->lock);
+    for (struct vlc_http_mgr_conn **pp = &pool->conns, *mc; (mc = *pp) != NULL;
+         pp = &mc->next)
+        if (mc->conn == conn)
+        {
+            *pp = mc->next;
+            pool->count--;
+            vlc_http_mgr_conn_delete(mc);
+            break;
+        }
+    vlc_mutex_unlock(&pool->lock);
 }
 
 static
 struct vlc_http_msg *vlc_http_mgr_reuse(struct vlc_http_mgr *mgr,
                                         const char *host, unsigned port,
+                                        bool secure, const char *proxy,
                                         const struct vlc_http_msg *req)
 {
-    struct vlc_http_conn *conn = vlc_http_mgr_find(mgr, host, port);
-    if (conn == NULL)
-        return NULL;
+    struct vlc_http_pool *pool = mgr->pool;
+    struct vlc_http_conn *conn;
+    struct vlc_http_stream *stream;
 
-    struct vlc_http_stream *stream = vlc_http_stream_open(conn, req);
-    if (stream != NULL)
+    while ((stream = vlc_http_pool_reuse(pool, host, port, secure, proxy,
+                                         req, &conn)) != NULL)
     {
         struct vlc_http_msg *m = vlc_http_msg_get_initial(stream);
         if (m != NULL)
@@ -136,9 +307,10 @@ struct vlc_http_msg *vlc_http_mgr_reuse(struct vlc_http_mgr *mgr,
          * was processed by the other end. Thus POST is not used/supported so
          * far, and CONNECT is treated as if it were idempotent (which works
          * fine here). */
+
+        /* Get rid of closing or reset connection */
+        vlc_http_pool_remove(pool, conn);
     }
-    /* Get rid of closing or reset connection */
-    vlc_http_mgr_release(mgr, conn);
     return NULL;
 }
 
@@ -146,36 +318,47 @@ static struct vlc_http_msg *vlc_https_request(struct vlc_http_mgr *mgr,
                                               const char *host, unsigned port,
                                               const struct vlc_http_msg *req)
 {
+    struct vlc_http_pool *pool = mgr->pool;
     vlc_tls_t *tls;
     bool http2 = true;
 
-    if (mgr->creds == NULL && mgr->conn != NULL)
-        return NULL; /* switch from HTTP to HTTPS not implemented */
+    if (port == 0)
+        port = 443;
 
-    if (mgr->creds == NULL)
+    vlc_mutex_lock(&pool->lock);
+    if (pool->creds == NULL)
     {   /* First TLS connection: load x509 credentials */
-        mgr->creds = vlc_tls_ClientCreate(mgr->obj);
-        if (mgr->creds == NULL)
+        pool->creds = vlc_tls_ClientCreate(pool->obj);
+        if (pool->creds == NULL)
+        {
+            vlc_mutex_unlock(&pool->lock);
             return NULL;
+        }
     }
+    vlc_mutex_unlock(&pool->lock);
+
+    char *proxy = vlc_http_proxy_find(host, port, true);
 
     /* TODO? non-idempotent request support */
-    struct vlc_http_msg *resp = vlc_http_mgr_reuse(mgr, host, port, req);
+    struct vlc_http_msg *resp = vlc_http_mgr_reuse(mgr, host, port, true,
+                                                   proxy, req);
     if (resp != NULL)
+    {
+        free(proxy);
         return resp; /* existing connection reused */
+    }
 
-    char *proxy = vlc_http_proxy_find(host, port, true);
     if (proxy != NULL)
-    {
-        tls = vlc_https_connect_proxy(mgr->creds, mgr->creds,
+        tls = vlc_https_connect_proxy(pool->creds, pool->creds,
                                       host, port, &http2, proxy);
-        free(proxy);
-    }
     else
-        tls = vlc_https_connect(mgr->creds, host, port, &http2);
+        tls = vlc_https_connect(pool->creds, host, port, &http2);
 
     if (tls == NULL)
+    {
+        free(proxy);
         return NULL;
+    }
 
     struct vlc_http_conn *conn;
 
@@ -187,45 +370,56 @@ static struct vlc_http_msg *vlc_https_request(struct vlc_http_mgr *mgr,
      * NOTE: We do not enforce TLS version 1.2 for HTTP 2.0 explicitly.
      */
     if (http2)
-        conn = vlc_h2_conn_create(mgr->obj, tls);
+        conn = vlc_h2_conn_create(pool->obj, tls);
     else
-        conn = vlc_h1_conn_create(mgr->obj, tls, false);
+        conn = vlc_h1_conn_create(pool->obj, tls, false);
 
     if (unlikely(conn == NULL))
     {
         vlc_tls_Close(tls);
+        free(proxy);
         return NULL;
     }
 
-    mgr->conn = conn;
+    if (vlc_http_pool_add(pool, conn, host, port, true, proxy, http2))
+    {
+        vlc_http_conn_release(conn);
+        free(proxy);
+        return NULL;
+    }
 
-    return vlc_http_mgr_reuse(mgr, host, port, req);
+    resp = vlc_http_mgr_reuse(mgr, host, port, true, proxy, req);
+    free(proxy);
+    return resp;
 }
 
 static struct vlc_http_msg *vlc_http_request(struct vlc_http_mgr *mgr,
                                              const char *host, unsigned port,
                                              const struct vlc_http_msg *req)
 {
-    if (mgr->creds != NULL && mgr->conn != NULL)
-        return NULL; /* switch from HTTPS to HTTP not implemented */
+    if (port == 0)
+        port = 80;
 
-    struct vlc_http_msg *resp = vlc_http_mgr_reuse(mgr, host, port, req);
+    char *proxy = vlc_http_proxy_find(host, port, false);
+    struct vlc_http_msg *resp = vlc_http_mgr_reuse(mgr, host, port, false,
+                                                   proxy, req);
     if (resp != NULL)
+    {
+        free(proxy);
         return resp;
+    }
 
     struct vlc_http_conn *conn;
     struct vlc_http_stream *stream;
 
-    char *proxy = vlc_http_proxy_find(host, port, false);
     if (proxy != NULL)
     {
         vlc_url_t url;
 
         vlc_UrlParse(&url, proxy);
-        free(proxy);
 
         if (url.psz_host != NULL)
-            stream = vlc_h1_request(mgr->obj, url.psz_host,
+            stream = vlc_h1_request(mgr->pool->obj, url.psz_host,
                                     url.i_port ? url.i_port : 80, true, req,
                                     true, &conn);
         else
@@ -234,20 +428,26 @@ static struct vlc_http_msg *vlc_http_request(struct vlc_http_mgr *mgr,
         vlc_UrlClean(&url);
     }
     else
-        stream = vlc_h1_request(mgr->obj, host, port ? port : 80, false, req,
+        stream = vlc_h1_request(mgr->pool->obj, host, port, false, req,
                                 true, &conn);
 
     if (stream == NULL)
+    {
+        free(proxy);
         return NULL;
+    }
 
     resp = vlc_http_msg_get_initial(stream);
     if (resp == NULL)
     {
         vlc_http_conn_release(conn);
+        free(proxy);
         return NULL;
     }
 
-    mgr->conn = conn;
+    if (vlc_http_pool_add(mgr->pool, conn, host, port, false, proxy, false))
+        vlc_http_conn_release(conn); /* closed with the stream */
+    free(proxy);
     return resp;
 }
 
@@ -263,6 +463,69 @@ struct vlc_http_cookie_jar_t *vlc_http_mgr_get_jar(struct vlc_http_mgr *mgr)
     return mgr->jar;
 }
 
+static struct vlc_http_pool *vlc_http_pool_hold(vlc_object_t *obj)
+{
+    vlc_object_t *libvlc = VLC_OBJECT(obj->obj.libvlc);
+    struct vlc_http_pool *pool;
+
+    vlc_mutex_lock(&pools_lock);
+    for (pool = pools; pool != NULL; pool = pool->next)
+        if (pool->obj == libvlc)
+            break;
+
+    if (pool == NULL)
+    {
+        pool = malloc(sizeof (*pool));
+        if (likely(pool != NULL))
+        {
+            pool->obj = libvlc;
+            vlc_mutex_init(&pool->lock);
+            pool->refs = 0;
+            pool->creds = NULL;
+            pool->conns = NULL;
+            pool->count = 0;
+            pool->next = pools;
+            pools = pool;
+        }
+    }
+
+    if (likely(pool != NULL))
+        pool->refs++;
+    vlc_mutex_unlock(&pools_lock);
+    return pool;
+}
+
+static void vlc_http_pool_release(struct vlc_http_pool *pool)
+{
+    vlc_mutex_lock(&pools_lock);
+    assert(pool->refs > 0);
+    if (--pool->refs > 0)
+    {   /* Idle connections stay open for the other resources */
+        vlc_mutex_unlock(&pools_lock);
+        return;
+    }
+
+    for (struct vlc_http_pool **pp = &pools; *pp != NULL; pp = &(*pp)->next)
+        if (*pp == pool)
+        {
+            *pp = pool->next;
+            break;
+        }
+    vlc_mutex_unlock(&pools_lock);
+
+    while (pool->conns != NULL)
+    {
+        struct vlc_http_mgr_conn *mc = pool->conns;
+
+        pool->conns = mc->next;
+        vlc_http_mgr_conn_delete(mc);
+    }
+    if (pool->creds != NULL)
+        vlc_tls_Delete(pool->creds);
+    vlc_mutex_destroy(&pool->lock);
+    free(pool);
+}
+
 struct vlc_http_mgr *vlc_http_mgr_create(vlc_object_t *obj,
                                          struct vlc_http_cookie_jar_t *jar)
 {
@@ -270,18 +533,19 @@ struct vlc_http_mgr *vlc_http_mgr_create(vlc_object_t *obj,
     if (unlikely(mgr == NULL))
         return NULL;
 
-    mgr->obj = obj;
-    mgr->creds = NULL;
+    mgr->pool = vlc_http_pool_hold(obj);
+    if (unlikely(mgr->pool == NULL))
+    {
+        free(mgr);
+        return NULL;
+    }
+
     mgr->jar = jar;
-    mgr->conn = NULL;
     return mgr;
 }
 
 void vlc_http_mgr_destroy(struct vlc_http_mgr *mgr)
 {
-    if (mgr->conn != NULL)
-        vlc_http_mgr_release(mgr, mgr->conn);
-    if (mgr->creds != NULL)
-        vlc_tls_Delete(mgr->creds);
+    vlc_http_pool_release(mgr->pool);
     free(mgr);
 }
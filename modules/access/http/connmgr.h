@@ -56,7 +56,9 @@ struct vlc_http_cookie_jar_t *vlc_http_mgr_get_jar(struct vlc_http_mgr *);
 /**
  * Creates an HTTP connection manager
  *
- * Allocates an HTTP client connections manager.
+ * Allocates an HTTP client connections manager. The connections are pooled
+ * with those of the other managers of the same LibVLC instance, by server,
+ * port and proxy, and closed after some time without use.
  *
  * @param obj parent VLC object
  * @param jar HTTP cookies jar (NULL to disable cookies)
@@ -68,7 +70,8 @@ struct vlc_http_mgr *vlc_http_mgr_create(vlc_object_t *obj,
  * Destroys an HTTP connection manager
  *
  * Deallocates an HTTP client connections manager created by
- * vlc_http_msg_destroy(). Any remaining connection is closed and destroyed.
+ * vlc_http_msg_destroy(). The pooled connections are closed and destroyed
+ * with the last manager of the LibVLC instance.
  */
 void vlc_http_mgr_destroy(struct vlc_http_mgr *mgr);
 
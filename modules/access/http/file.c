@@ -39,10 +39,26 @@
 
 #pragma GCC visibility push(default)
 
+/* Size of the byte ranges requested ahead in parallel */
+#define VLC_HTTP_FILE_WINDOW_SIZE (UINTMAX_C(4) << 20)
+#define VLC_HTTP_FILE_MAX_WINDOWS 8
+
 struct vlc_http_file
 {
     struct vlc_http_resource resource;
     uintmax_t offset;
+    uintmax_t last; /**< last byte of a bounded range request */
+
+    /* Parallel ranged download */
+    unsigned max_windows; /**< 0 if disabled */
+    unsigned windows; /**< current count of windows requested ahead */
+    unsigned ahead_count;
+    struct vlc_http_msg *ahead[VLC_HTTP_FILE_MAX_WINDOWS];
+    uintmax_t size;
+    uintmax_t window_end; /**< end of the current response window */
+    uintmax_t ahead_end; /**< end of the last window requested ahead */
+    mtime_t window_start; /**< date the current window started to be read */
+    mtime_t wait; /**< time spent waiting for data in the current window */
 };
 
 static int vlc_http_file_req(const struct vlc_http_resource *res,
@@ -69,6 +85,10 @@ static int vlc_http_file_req(const struct vlc_http_resource *res,
         }
     }
 
+    if (file->last != UINTMAX_MAX)
+        return vlc_http_msg_add_header(req, "Range", "bytes=%ju-%ju",
+                                       *offset, file->last);
+
     if (vlc_http_msg_add_header(req, "Range", "bytes=%ju-", *offset)
      && *offset != 0)
         return -1;
@@ -78,6 +98,7 @@ static int vlc_http_file_req(const struct vlc_http_resource *res,
 static int vlc_http_file_resp(const struct vlc_http_resource *res,
                               const struct vlc_http_msg *resp, void *opaque)
 {
+    const struct vlc_http_file *file = (const struct vlc_http_file *)res;
     const uintmax_t *offset = opaque;
 
     if (vlc_http_msg_get_status(resp) == 206)
@@ -90,13 +111,12 @@ static int vlc_http_file_resp(const struct vlc_http_resource *res,
 
         uintmax_t start, end;
         if (sscanf(str, "bytes %ju-%ju", &start, &end) != 2
-         || start != *offset || start > end)
+         || start != *offset || start > end || end > file->last)
             /* A single range response is what we asked for, but not at that
-             * start offset. */
+             * start offset, or beyond the requested range. */
             goto fail;
     }
 
-    (void) res;
     return 0;
 
 fail:
@@ -126,9 +146,37 @@ struct vlc_http_resource *vlc_http_file_create(struct vlc_http_mgr *mgr,
     }
 
     file->offset = 0;
+    file->last = UINTMAX_MAX;
+    file->max_windows = 0;
+    file->windows = 0;
+    file->ahead_count = 0;
+    file->window_end = UINTMAX_MAX;
     return &file->resource;
 }
 
+void vlc_http_file_set_windows(struct vlc_http_resource *res, unsigned count)
+{
+    struct vlc_http_file *file = (struct vlc_http_file *)res;
+
+    if (count > VLC_HTTP_FILE_MAX_WINDOWS)
+        count = VLC_HTTP_FILE_MAX_WINDOWS;
+    file->max_windows = count;
+    file->windows = (count + 1) / 2;
+}
+
+static void vlc_http_file_drop_windows(struct vlc_http_file *file)
+{
+    while (file->ahead_count > 0)
+        vlc_http_msg_destroy(file->ahead[--file->ahead_count]);
+    file->window_end = UINTMAX_MAX;
+}
+
+void vlc_http_file_destroy(struct vlc_http_resource *res)
+{
+    vlc_http_file_drop_windows((struct vlc_http_file *)res);
+    vlc_http_res_destroy(res);
+}
+
 static uintmax_t vlc_http_msg_get_file_size(const struct vlc_http_msg *resp)
 {
     int status = vlc_http_msg_get_status(resp);
@@ -203,12 +251,15 @@ bool vlc_http_file_can_seek(struct vlc_http_resource *res)
 
 int vlc_http_file_seek(struct vlc_http_resource *res, uintmax_t offset)
 {
+    struct vlc_http_file *file = (struct vlc_http_file *)res;
+
+    /* The windows requested ahead do not follow the new offset */
+    vlc_http_file_drop_windows(file);
+
     struct vlc_http_msg *resp = vlc_http_res_open(res, &offset);
     if (resp == NULL)
         return -1;
 
-    struct vlc_http_file *file = (struct vlc_http_file *)res;
-
     int status = vlc_http_msg_get_status(resp);
     if (res->response != NULL)
     {   /* Accept the new and ditch the old one if:
@@ -229,10 +280,138 @@ int vlc_http_file_seek(struct vlc_http_resource *res, uintmax_t offset)
     return 0;
 }
 
+/**
+ * Requests the byte ranges following the current window.
+ *
+ * The ranges are requested all at once, so that they are transferred in
+ * parallel: over separate connections with HTTP/1, or as separate streams of
+ * the same connection with HTTP/2. They are then read in order.
+ */
+static void vlc_http_file_request_ahead(struct vlc_http_file *file)
+{
+    struct vlc_http_resource *res = &file->resource;
+
+    if (file->window_end == UINTMAX_MAX)
+    {   /* Start with the current response, whatever its range */
+        if (res->response == NULL || !vlc_http_msg_can_seek(res->response))
+            goto disable;
+
+        file->size = vlc_http_msg_get_file_size(res->response);
+        if (file->size == UINTMAX_MAX)
+            goto disable;
+
+        file->window_end = file->offset + VLC_HTTP_FILE_WINDOW_SIZE;
+        if (file->window_end > file->size)
+            file->window_end = file->size;
+        file->ahead_end = file->window_end;
+        file->window_start = mdate();
+        file->wait = 0;
+    }
+
+    while (file->ahead_count < file->windows && file->ahead_end < file->size)
+    {
+        uintmax_t offset = file->ahead_end;
+
+        file->last = offset + VLC_HTTP_FILE_WINDOW_SIZE - 1;
+        if (file->last >= file->size)
+            file->last = file->size - 1;
+
+        struct vlc_http_msg *resp = vlc_http_res_open(res, &offset);
+        uintmax_t last = file->last;
+
+        file->last = UINTMAX_MAX;
+        if (resp == NULL)
+            break; /* try again with the next window */
+        if (vlc_http_msg_get_status(resp) != 206)
+        {
+            vlc_http_msg_destroy(resp);
+            goto disable;
+        }
+
+        file->ahead[file->ahead_count++] = resp;
+        file->ahead_end = last + 1;
+    }
+    return;
+
+disable:
+    vlc_http_file_drop_windows(file);
+    file->max_windows = 0;
+}
+
+/**
+ * Switches to the next window once the current one is fully read.
+ *
+ * The count of windows is adapted from the time spent waiting for data:
+ * more windows are requested if the transfer does not keep up with the
+ * reader, and less if it keeps well ahead.
+ */
+static bool vlc_http_file_next_window(struct vlc_http_file *file)
+{
+    struct vlc_http_resource *res = &file->resource;
+    mtime_t now = mdate();
+    mtime_t elapsed = now - file->window_start;
+
+    if (file->ahead_count == 0 || file->offset != file->window_end)
+        return false;
+
+    if (2 * file->wait > elapsed)
+    {
+        if (file->windows < file->max_windows)
+            file->windows++;
+    }
+    else if (8 * file->wait < elapsed)
+    {
+        if (file->windows > 1)
+            file->windows--;
+    }
+
+    vlc_http_msg_destroy(res->response);
+    res->response = file->ahead[0];
+    file->ahead_count--;
+    memmove(file->ahead, file->ahead + 1,
+            file->ahead_count * sizeof (file->ahead[0]));
+
+    file->window_end += VLC_HTTP_FILE_WINDOW_SIZE;
+    if (file->window_end > file->size)
+        file->window_end = file->size;
+    file->window_start = now;
+    file->wait = 0;
+    return true;
+}
+
+static block_t *vlc_http_file_read_window(struct vlc_http_file *file)
+{
+    struct vlc_http_resource *res = &file->resource;
+    block_t *block;
+
+    vlc_http_file_request_ahead(file);
+    if (file->max_windows == 0)
+        return vlc_http_res_read(res);
+
+    if (file->offset >= file->window_end && !vlc_http_file_next_window(file))
+        /* If the next window could not be requested, reopen from here */
+        return (file->offset < file->size) ? vlc_http_error : NULL;
+
+    mtime_t begin = mdate();
+
+    block = vlc_http_res_read(res);
+    file->wait += mdate() - begin;
+
+    if (block == NULL && file->offset < file->window_end)
+        return vlc_http_error; /* premature end of the window */
+
+    if (block != NULL && block != vlc_http_error
+     && block->i_buffer > file->window_end - file->offset)
+        /* The first response is not bounded, cut it at the window end */
+        block->i_buffer = file->window_end - file->offset;
+    return block;
+}
+
 block_t *vlc_http_file_read(struct vlc_http_resource *res)
 {
     struct vlc_http_file *file = (struct vlc_http_file *)res;
-    block_t *block = vlc_http_res_read(res);
+    block_t *block = (file->max_windows > 0)
+        ? vlc_http_file_read_window(file) : vlc_http_res_read(res);
 
     if (block == vlc_http_error)
     {   /* Automatically reconnect on error if server supports seek */
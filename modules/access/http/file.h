@@ -46,6 +46,18 @@ struct vlc_http_resource *vlc_http_file_create(struct vlc_http_mgr *mgr,
                                                const char *url, const char *ua,
                                                const char *ref);
 
+/**
+ * Enables parallel ranged download.
+ *
+ * Requests up to the given count of consecutive byte ranges ahead of the read
+ * offset, so that they are transferred in parallel. The actual count of
+ * ranges is adapted to the throughput. This has no effects if the server does
+ * not support byte ranges or does not report the file size.
+ *
+ * @param count maximum count of ranges requested ahead (0 to disable)
+ */
+void vlc_http_file_set_windows(struct vlc_http_resource *, unsigned count);
+
 /**
  * Gets file size.
  *
@@ -82,6 +94,10 @@ struct block_t *vlc_http_file_read(struct vlc_http_resource *);
 #define vlc_http_file_get_status vlc_http_res_get_status
 #define vlc_http_file_get_redirect vlc_http_res_get_redirect
 #define vlc_http_file_get_type vlc_http_res_get_type
-#define vlc_http_file_destroy vlc_http_res_destroy
+
+/**
+ * Destroys an HTTP file.
+ */
+void vlc_http_file_destroy(struct vlc_http_resource *);
 
 /** @} */
@@ -91,6 +91,11 @@ static void Close( vlc_object_t * );
     "track, can be increased in case of broken pictures due " \
     "to too small buffer.")
 #define DEFAULT_FRAME_BUFFER_SIZE 250000
+/* Largest frame buffer, so that strange streams do not eat up all the
+ * memory: enough for the intra frames of 4K streams */
+#define MAX_FRAME_BUFFER_SIZE 8000000
+/* The reception statistics are published every 5 seconds */
+#define STATS_PERIOD (5 * CLOCK_FREQ)
 
 vlc_module_begin ()
     set_description( N_("RTP/RTSP/SDP demuxer (using Live555)" ) )
@@ -166,8 +171,9 @@ typedef struct
     bool            b_discard_trunc;
     vlc_demux_chained_t *p_out_muxed;    /* for muxed stream */
 
-    uint8_t         *p_buffer;
-    unsigned int    i_buffer;
+    block_t         *p_frame; /* live555 receives the next frame into it */
+    unsigned int    i_buffer; /* size of the frame blocks */
+    unsigned int    i_truncated; /* frames that did not fit */
 
     bool            b_rtcp_sync;
     bool            b_flushing_discontinuity;
@@ -229,6 +235,8 @@ struct demux_sys_t
     int              i_live555_ret; /* live555 callback return code */
 
     float            f_seek_request;/* In case we receive a seek request while paused*/
+
+    mtime_t          i_stats_next;
 };
 
 
@@ -338,6 +346,7 @@ static int  Open ( vlc_object_t *p_this )
     p_sys->b_force_mcast = var_InheritBool( p_demux, "rtsp-mcast" );
     p_sys->f_seek_request = -1;
     vlc_mutex_init(&p_sys->timeout_mutex);
+    p_sys->i_stats_next = mdate() + STATS_PERIOD;
 
     /* parse URL for rtsp://[user:[passwd]@]serverip:port/options */
     if( asprintf( &psz_url, "%s://%s", p_demux->psz_access, p_demux->psz_location ) == -1 )
@@ -471,7 +480,7 @@ static void Close( vlc_object_t *p_this )
         if( tk->p_out_muxed )
             vlc_demux_chained_Delete( tk->p_out_muxed );
         es_format_Clean( &tk->fmt );
-        free( tk->p_buffer );
+        if( tk->p_frame ) block_Release( tk->p_frame );
         free( tk );
     }
     TAB_CLEAN( p_sys->i_track, p_sys->track );
@@ -845,9 +854,10 @@ static int SessionsSetup( demux_t *p_demux )
             tk->f_npt       = 0.;
             tk->b_selected  = true;
             tk->i_buffer    = i_frame_buffer;
-            tk->p_buffer    = (uint8_t *)malloc( i_frame_buffer );
+            tk->i_truncated = 0;
+            tk->p_frame     = block_Alloc( i_frame_buffer );
 
-            if( !tk->p_buffer )
+            if( !tk->p_frame )
             {
                 free( tk );
                 delete iter;
@@ -1259,6 +1269,55 @@ static int Play( demux_t *p_demux )
 }
 
 
+/*****************************************************************************
+ * PublishStats: reception statistics of all the tracks, as input item info
+ *****************************************************************************/
+static void PublishStats( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    uint64_t i_received = 0, i_expected = 0;
+    unsigned i_truncated = 0;
+    double f_jitter = 0.;
+
+    if( p_demux->p_input == NULL )
+        return;
+
+    for( int i = 0; i < p_sys->i_track; i++ )
+    {
+        live_track_t *tk = p_sys->track[i];
+        RTPSource *src = tk->sub->rtpSource();
+
+        i_truncated += tk->i_truncated;
+        if( src == NULL )
+            continue;
+
+        /* One entry per sender of the track */
+        RTPReceptionStatsDB::Iterator iter( src->receptionStatsDB() );
+        RTPReceptionStats *stats;
+        while( ( stats = iter.next( True ) ) != NULL )
+        {
+            i_received += stats->totNumPacketsReceived();
+            i_expected += stats->totNumPacketsExpected();
+            if( src->timestampFrequency() > 0 )
+                f_jitter = __MAX( f_jitter, 1000. * stats->jitter()
+                                            / src->timestampFrequency() );
+        }
+    }
+
+    input_item_t *p_item = input_GetItem( p_demux->p_input );
+    const char *psz_cat = _("RTP reception");
+
+    /* Duplicated packets may be counted as received */
+    input_item_AddInfo( p_item, psz_cat, _("Received packets"), "%" PRIu64,
+                        i_received );
+    input_item_AddInfo( p_item, psz_cat, _("Lost packets"), "%" PRIu64,
+                        i_expected > i_received ? i_expected - i_received
+                                                : 0 );
+    input_item_AddInfo( p_item, psz_cat, _("Jitter"), "%.1f ms", f_jitter );
+    input_item_AddInfo( p_item, psz_cat, _("Truncated frames"), "%u",
+                        i_truncated );
+}
+
 /*****************************************************************************
  * Demux:
  *****************************************************************************/
@@ -1274,6 +1333,12 @@ static int Demux( demux_t *p_demux )
        during pause */
     vlc_mutex_locker locker(&p_sys->timeout_mutex);
 
+    if( mdate() >= p_sys->i_stats_next )
+    {
+        PublishStats( p_demux );
+        p_sys->i_stats_next = mdate() + STATS_PERIOD;
+    }
+
     for( i = 0; i < p_sys->i_track; i++ )
     {
         live_track_t *tk = p_sys->track[i];
@@ -1331,9 +1396,14 @@ static int Demux( demux_t *p_demux )
 
         if( tk->waiting == 0 )
         {
+            /* The previous frame block was handed over to the ES out */
+            if( tk->p_frame == NULL &&
+                ( tk->p_frame = block_Alloc( tk->i_buffer ) ) == NULL )
+                continue;
             tk->waiting = 1;
-            tk->sub->readSource()->getNextFrame( tk->p_buffer, tk->i_buffer,
-                                          StreamRead, tk, StreamClose, tk );
+            tk->sub->readSource()->getNextFrame( tk->p_frame->p_buffer,
+                                                 tk->i_buffer, StreamRead,
+                                                 tk, StreamClose, tk );
         }
     }
     /* Create a task that will be called if we wait more than 300ms */
@@ -1720,7 +1790,7 @@ static int RollOverTcp( demux_t *p_demux )
         if( tk->p_es ) es_out_Del( p_demux->out, tk->p_es );
         if( tk->p_asf_block ) block_Release( tk->p_asf_block );
         es_format_Clean( &tk->fmt );
-        free( tk->p_buffer );
+        if( tk->p_frame ) block_Release( tk->p_frame );
         free( tk );
     }
     TAB_CLEAN( p_sys->i_track, p_sys->track );
@@ -1938,85 +2008,101 @@ static void StreamRead( void *p_private, unsigned int i_size,
              pts.tv_sec * 1000000LL + pts.tv_usec );
 #endif
 
+    block_t *p_frame = tk->p_frame;
+    const unsigned i_frame_size = tk->i_buffer;
+
     /* grow buffer if it looks like buffer is too small, but don't eat
-     * up all the memory on strange streams */
+     * up all the memory on strange streams. The next frames are received
+     * into blocks of the new size. */
     if( i_truncated_bytes > 0 )
     {
-        if( tk->i_buffer < 2000000 )
+        tk->i_truncated++;
+        if( tk->i_buffer < MAX_FRAME_BUFFER_SIZE )
         {
-            void *p_tmp;
+            unsigned i_needed = i_size + i_truncated_bytes;
+
             msg_Dbg( p_demux, "lost %d bytes", i_truncated_bytes );
-            msg_Dbg( p_demux, "increasing buffer size to %d", tk->i_buffer * 2 );
-            p_tmp = realloc( tk->p_buffer, tk->i_buffer * 2 );
-            if( p_tmp == NULL )
-            {
-                msg_Warn( p_demux, "realloc failed" );
-            }
-            else
-            {
-                tk->p_buffer = (uint8_t*)p_tmp;
-                tk->i_buffer *= 2;
-            }
+            tk->i_buffer = __MIN( __MAX( tk->i_buffer * 2, i_needed ),
+                                  MAX_FRAME_BUFFER_SIZE );
+            msg_Dbg( p_demux, "increasing buffer size to %u", tk->i_buffer );
         }
 
         if( tk->b_discard_trunc )
         {
+            if( tk->i_buffer != i_frame_size )
+            {
+                block_Release( p_frame );
+                tk->p_frame = NULL;
+            }
             p_sys->event_data = 0xff;
             tk->waiting = 0;
             return;
         }
     }
 
-    assert( i_size <= tk->i_buffer );
+    assert( i_size <= i_frame_size );
 
-    if( tk->fmt.i_codec == VLC_CODEC_AMR_NB ||
-        tk->fmt.i_codec == VLC_CODEC_AMR_WB )
+    if( tk->format == live_track_t::ASF_STREAM )
+    {
+        p_block = StreamParseAsf( p_demux, tk,
+                                  tk->sub->rtpSource()->curPacketMarkerBit(),
+                                  p_frame->p_buffer, i_size );
+    }
+    else if( i_size < i_frame_size / 2 )
+    {
+        /* Copy small frames, rather than ship mostly empty blocks, and keep
+         * the frame block for the next one */
+        if( (p_block = block_Alloc( i_size )) )
+            memcpy( p_block->p_buffer, p_frame->p_buffer, i_size );
+    }
+    else
+    {
+        /* Hand the frame block over as is: live555 received into it */
+        p_block = p_frame;
+        p_block->i_buffer = i_size;
+        p_frame = tk->p_frame = NULL;
+    }
+
+    /* The headers are prepended in the reserved space of the block */
+    if( p_block == NULL || tk->format == live_track_t::ASF_STREAM )
+        ;
+    else if( tk->fmt.i_codec == VLC_CODEC_AMR_NB ||
+             tk->fmt.i_codec == VLC_CODEC_AMR_WB )
     {
         AMRAudioSource *amrSource = (AMRAudioSource*)tk->sub->readSource();
 
-        if( (p_block = block_Alloc( i_size + 1 )) )
-        {
+        if( (p_block = block_Realloc( p_block, 1, i_size )) )
             p_block->p_buffer[0] = amrSource->lastFrameHeader();
-            memcpy( p_block->p_buffer + 1, tk->p_buffer, i_size );
-        }
     }
     else if( tk->fmt.i_codec == VLC_CODEC_H261 )
     {
         H261VideoRTPSource *h261Source = (H261VideoRTPSource*)tk->sub->rtpSource();
         uint32_t header = h261Source->lastSpecialHeader();
-        if( (p_block = block_Alloc( i_size + 4 )) )
-        {
+        if( (p_block = block_Realloc( p_block, 4, i_size )) )
             memcpy( p_block->p_buffer, &header, 4 );
-            memcpy( p_block->p_buffer + 4, tk->p_buffer, i_size );
-        }
     }
     else if( tk->fmt.i_codec == VLC_CODEC_H264 || tk->fmt.i_codec == VLC_CODEC_HEVC )
     {
-        if( tk->fmt.i_codec == VLC_CODEC_H264 && (tk->p_buffer[0] & 0x1f) >= 24 )
+        if( tk->fmt.i_codec == VLC_CODEC_H264 && (p_block->p_buffer[0] & 0x1f) >= 24 )
             msg_Warn( p_demux, "unsupported NAL type for H264" );
-        else if( tk->fmt.i_codec == VLC_CODEC_HEVC && ((tk->p_buffer[0] & 0x7e)>>1) >= 48 )
+        else if( tk->fmt.i_codec == VLC_CODEC_HEVC && ((p_block->p_buffer[0] & 0x7e)>>1) >= 48 )
             msg_Warn( p_demux, "unsupported NAL type for H265" );
 
         /* Normal NAL type */
-        if( (p_block = block_Alloc( i_size + 4 )) )
+        if( (p_block = block_Realloc( p_block, 4, i_size )) )
         {
             p_block->p_buffer[0] = 0x00;
             p_block->p_buffer[1] = 0x00;
             p_block->p_buffer[2] = 0x00;
             p_block->p_buffer[3] = 0x01;
-            memcpy( &p_block->p_buffer[4], tk->p_buffer, i_size );
         }
     }
-    else if( tk->format == live_track_t::ASF_STREAM )
-    {
-        p_block = StreamParseAsf( p_demux, tk,
-                                  tk->sub->rtpSource()->curPacketMarkerBit(),
-                                  tk->p_buffer, i_size );
-    }
-    else
+
+    /* The kept frame block is too small after the buffer grew */
+    if( p_frame != NULL && tk->i_buffer != i_frame_size )
     {
-        if( (p_block = block_Alloc( i_size )) )
-            memcpy( p_block->p_buffer, tk->p_buffer, i_size );
+        block_Release( p_frame );
+        tk->p_frame = NULL;
     }
 
     /* No data sent. Always in sync then */
@@ -45,6 +45,10 @@
 #endif
 
 #define DEFAULT_MRU (1500u - (20 + 8))
+#ifdef HAVE_RECVMMSG
+/* Datagrams received per system call */
+# define RTP_BATCH 32
+#endif
 
 /**
  * Processes a packet received from the RTP socket.
@@ -100,6 +104,115 @@ static int rtp_timeout (mtime_t deadline)
     return t;
 }
 
+#ifdef RTP_BATCH
+static void rtp_release_blocks (void *data)
+{
+    block_t **blocks = data;
+
+    for (unsigned i = 0; i < RTP_BATCH; i++)
+        if (blocks[i] != NULL)
+            block_Release (blocks[i]);
+}
+
+/**
+ * Waits for datagrams, releasing the preallocated blocks if cancelled.
+ * This keeps the cleanup handler, thus setjmp(), out of the thread loop.
+ */
+static int rtp_poll_batch (struct pollfd *ufd, int timeout, block_t **blocks)
+{
+    int n;
+
+    vlc_cleanup_push (rtp_release_blocks, blocks);
+    n = poll (ufd, 1, timeout);
+    vlc_cleanup_pop ();
+    return n;
+}
+
+/**
+ * Receives and processes the pending datagrams, in batches.
+ * Left over preallocated blocks are kept for the next call.
+ * @return false if no memory could be allocated at all
+ */
+static bool rtp_recv_batch (demux_t *demux, int fd, block_t **blocks,
+                            size_t *mru)
+{
+    struct mmsghdr msgs[RTP_BATCH];
+    struct iovec iovs[RTP_BATCH];
+    unsigned count;
+
+    for (count = 0; count < RTP_BATCH; count++)
+    {
+        if (blocks[count] == NULL)
+        {
+            blocks[count] = block_Alloc (*mru);
+            if (unlikely(blocks[count] == NULL))
+                break;
+        }
+
+        iovs[count].iov_base = blocks[count]->p_buffer;
+        iovs[count].iov_len = *mru;
+        msgs[count].msg_hdr = (struct msghdr) {
+            .msg_iov = &iovs[count],
+            .msg_iovlen = 1,
+        };
+    }
+
+    if (unlikely(count == 0))
+    {
+        if (*mru == DEFAULT_MRU)
+            return false; /* we are totallly screwed */
+        *mru = DEFAULT_MRU; /* retry with shrunk MRU */
+        return true;
+    }
+
+    int flags = MSG_DONTWAIT;
+#ifdef __linux__
+    flags |= MSG_TRUNC; /* get the actual length of truncated packets */
+#endif
+    int n = recvmmsg (fd, msgs, count, flags, NULL);
+    if (n == -1)
+    {
+        if (errno != EAGAIN
+#if (EAGAIN != EWOULDBLOCK)
+         && errno != EWOULDBLOCK
+#endif
+           )
+            msg_Warn (demux, "RTP network error: %s", vlc_strerror_c(errno));
+        return true;
+    }
+
+    const size_t old_mru = *mru;
+
+    for (int i = 0; i < n; i++)
+    {
+        block_t *block = blocks[i];
+        size_t len = msgs[i].msg_len;
+
+        blocks[i] = NULL;
+        if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC)
+        {
+            msg_Err(demux, "%zu bytes packet truncated (MRU was %zu)",
+                    len, old_mru);
+            block->i_flags |= BLOCK_FLAG_CORRUPTED;
+            if (len > *mru)
+                *mru = len;
+        }
+        else
+            block->i_buffer = len;
+
+        rtp_process (demux, block);
+    }
+
+    if (*mru != old_mru) /* reallocate the left over blocks */
+        for (unsigned i = n; i < count; i++)
+        {
+            block_Release (blocks[i]);
+            blocks[i] = NULL;
+        }
+    return true;
+}
+#endif
+
 /**
  * RTP/RTCP session thread for datagram sockets
  */
@@ -109,6 +222,10 @@ void *rtp_dgram_thread (void *opaque)
     demux_sys_t *sys = demux->p_sys;
     mtime_t deadline = VLC_TS_INVALID;
     int rtp_fd = sys->fd;
+#ifdef RTP_BATCH
+    block_t *blocks[RTP_BATCH] = { NULL };
+    size_t mru = DEFAULT_MRU;
+#else
     struct iovec iov =
     {
         .iov_len = DEFAULT_MRU,
@@ -118,6 +235,7 @@ void *rtp_dgram_thread (void *opaque)
         .msg_iov = &iov,
         .msg_iovlen = 1,
     };
+#endif
 
     struct pollfd ufd[1];
     ufd[0].fd = rtp_fd;
@@ -125,7 +243,11 @@ void *rtp_dgram_thread (void *opaque)
 
     for (;;)
     {
+#ifdef RTP_BATCH
+        int n = rtp_poll_batch (ufd, rtp_timeout (deadline), blocks);
+#else
         int n = poll (ufd, 1, rtp_timeout (deadline));
+#endif
         if (n == -1)
             continue;
 
@@ -139,6 +261,10 @@ void *rtp_dgram_thread (void *opaque)
             if (unlikely(ufd[0].revents & POLLHUP))
                 break; /* RTP socket dead (DCCP only) */
 
+#ifdef RTP_BATCH
+            if (!rtp_recv_batch (demux, rtp_fd, blocks, &mru))
+                break;
+#else
             block_t *block = block_Alloc (iov.iov_len);
             if (unlikely(block == NULL))
             {
@@ -178,6 +304,7 @@ void *rtp_dgram_thread (void *opaque)
                           vlc_strerror_c(errno));
                 block_Release (block);
             }
+#endif
         }
 
     dequeue:
@@ -185,6 +312,9 @@ void *rtp_dgram_thread (void *opaque)
             deadline = VLC_TS_INVALID;
         vlc_restorecancel (canc);
     }
+#ifdef RTP_BATCH
+    rtp_release_blocks (blocks);
+#endif
     return NULL;
 }
 
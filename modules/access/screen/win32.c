@@ -33,6 +33,20 @@
 
 #include "screen.h"
 
+#define CAPTURE_POOL_SIZE 4 /* Maximum number of idle bitmaps kept */
+
+struct block_sys_t;
+
+/* The bitmaps are reused once the blocks sent downstream are released */
+typedef struct
+{
+    vlc_mutex_t lock;
+    unsigned    i_refs;   /* capture + blocks in flight */
+    bool        b_closed;
+    unsigned    i_count;  /* number of idle bitmaps */
+    struct block_sys_t *p_idle[CAPTURE_POOL_SIZE];
+} capture_pool_t;
+
 struct screen_data_t
 {
     HDC hdc_src;
@@ -45,8 +59,25 @@ struct screen_data_t
     int i_fragment_size;
     int i_fragment;
     block_t *p_block;
+
+    capture_pool_t *p_pool;
 };
 
+static void CaptureBlockDestroy( struct block_sys_t * );
+
+static void CapturePoolRelease( capture_pool_t *p_pool )
+{
+    vlc_mutex_lock( &p_pool->lock );
+    bool b_last = --p_pool->i_refs == 0;
+    vlc_mutex_unlock( &p_pool->lock );
+
+    if( b_last )
+    {
+        vlc_mutex_destroy( &p_pool->lock );
+        free( p_pool );
+    }
+}
+
 /*
  * In screen coordinates the origin is the upper-left corner of the primary
  * display, and points can have negative x/y when other displays are located
@@ -105,6 +136,19 @@ int screen_InitCapture( demux_t *p_demux )
         return VLC_EGENERIC;
     }
 
+    p_data->p_pool = malloc( sizeof( *p_data->p_pool ) );
+    if( !p_data->p_pool )
+    {
+        DeleteDC( p_data->hdc_dst );
+        ReleaseDC( 0, p_data->hdc_src );
+        free( p_data );
+        return VLC_ENOMEM;
+    }
+    vlc_mutex_init( &p_data->p_pool->lock );
+    p_data->p_pool->i_refs = 1;
+    p_data->p_pool->b_closed = false;
+    p_data->p_pool->i_count = 0;
+
     i_bits_per_pixel = GetDeviceCaps( p_data->hdc_src, BITSPIXEL );
     switch( i_bits_per_pixel )
     {
@@ -119,6 +163,7 @@ int screen_InitCapture( demux_t *p_demux )
         i_chroma = VLC_CODEC_RGB32; break;
     default:
         msg_Err( p_demux, "unknown screen depth %i", i_bits_per_pixel );
+        CapturePoolRelease( p_data->p_pool );
         DeleteDC( p_data->hdc_dst );
         ReleaseDC( 0, p_data->hdc_src );
         free( p_data );
@@ -172,6 +217,15 @@ int screen_CloseCapture( demux_t *p_demux )
     if( p_data->hgdi_backup)
         SelectObject( p_data->hdc_dst, p_data->hgdi_backup );
 
+    /* The bitmaps still in flight are deleted when released */
+    capture_pool_t *p_pool = p_data->p_pool;
+    vlc_mutex_lock( &p_pool->lock );
+    p_pool->b_closed = true;
+    while( p_pool->i_count > 0 )
+        CaptureBlockDestroy( p_pool->p_idle[--p_pool->i_count] );
+    vlc_mutex_unlock( &p_pool->lock );
+    CapturePoolRelease( p_pool );
+
     DeleteDC( p_data->hdc_dst );
     ReleaseDC( 0, p_data->hdc_src );
     free( p_data );
@@ -183,14 +237,32 @@ struct block_sys_t
 {
     block_t self;
     HBITMAP hbmp;
+    void   *p_pixels;
+    size_t  i_size;
+    capture_pool_t *p_pool;
 };
 
-static void CaptureBlockRelease( block_t *p_block )
+static void CaptureBlockDestroy( struct block_sys_t *p_block )
 {
-    DeleteObject( ((struct block_sys_t *)p_block)->hbmp );
+    DeleteObject( p_block->hbmp );
     free( p_block );
 }
 
+static void CaptureBlockRelease( block_t *p_block )
+{
+    struct block_sys_t *p_sys = (struct block_sys_t *)p_block;
+    capture_pool_t *p_pool = p_sys->p_pool;
+
+    vlc_mutex_lock( &p_pool->lock );
+    if( !p_pool->b_closed && p_pool->i_count < CAPTURE_POOL_SIZE )
+        p_pool->p_idle[p_pool->i_count++] = p_sys;
+    else
+        CaptureBlockDestroy( p_sys );
+    vlc_mutex_unlock( &p_pool->lock );
+
+    CapturePoolRelease( p_pool );
+}
+
 static block_t *CaptureBlockNew( demux_t *p_demux )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
@@ -198,7 +270,7 @@ static block_t *CaptureBlockNew( demux_t *p_demux )
     struct block_sys_t *p_block;
     void *p_buffer;
     int i_buffer;
-    HBITMAP hbmp;
+    HBITMAP hbmp = NULL;
 
     if( p_data->bmi.bmiHeader.biSize == 0 )
     {
@@ -228,43 +300,61 @@ static block_t *CaptureBlockNew( demux_t *p_demux )
     }
 
 
-    /* Create the bitmap storage space */
-    hbmp = CreateDIBSection( p_data->hdc_dst, &p_data->bmi, DIB_RGB_COLORS,
-                             &p_buffer, NULL, 0 );
-    if( !hbmp || !p_buffer )
+    /* Reuse an idle bitmap if any */
+    capture_pool_t *p_pool = p_data->p_pool;
+
+    vlc_mutex_lock( &p_pool->lock );
+    p_block = p_pool->i_count > 0 ? p_pool->p_idle[--p_pool->i_count] : NULL;
+    p_pool->i_refs++;
+    vlc_mutex_unlock( &p_pool->lock );
+
+    if( !p_block )
     {
-        msg_Err( p_demux, "cannot create bitmap" );
-        goto error;
+        /* Create the bitmap storage space */
+        hbmp = CreateDIBSection( p_data->hdc_dst, &p_data->bmi, DIB_RGB_COLORS,
+                                 &p_buffer, NULL, 0 );
+        if( !hbmp || !p_buffer )
+        {
+            msg_Err( p_demux, "cannot create bitmap" );
+            goto error;
+        }
+
+        /* Build block */
+        if( !(p_block = malloc( sizeof( *p_block ) )) )
+            goto error;
+
+        int i_stride =
+            ( ( ( ( p_sys->fmt.video.i_width * p_sys->fmt.video.i_bits_per_pixel ) + 31 ) & ~31 ) >> 3 );
+        i_buffer = i_stride * p_sys->fmt.video.i_height;
+
+        p_block->hbmp     = hbmp;
+        p_block->p_pixels = p_buffer;
+        p_block->i_size   = i_buffer;
+        p_block->p_pool   = p_pool;
     }
 
     /* Select the bitmap into the compatible DC */
     if( !p_data->hgdi_backup )
-        p_data->hgdi_backup = SelectObject( p_data->hdc_dst, hbmp );
+        p_data->hgdi_backup = SelectObject( p_data->hdc_dst, p_block->hbmp );
     else
-        SelectObject( p_data->hdc_dst, hbmp );
+        SelectObject( p_data->hdc_dst, p_block->hbmp );
+
+    /* Fill all fields */
+    block_Init( &p_block->self, p_block->p_pixels, p_block->i_size );
+    p_block->self.pf_release = CaptureBlockRelease;
 
     if( !p_data->hgdi_backup )
     {
         msg_Err( p_demux, "cannot select bitmap" );
-        goto error;
+        block_Release( &p_block->self );
+        return NULL;
     }
 
-    /* Build block */
-    if( !(p_block = malloc( sizeof( block_t ) + sizeof( struct block_sys_t ) )) )
-        goto error;
-
-    /* Fill all fields */
-    int i_stride =
-        ( ( ( ( p_sys->fmt.video.i_width * p_sys->fmt.video.i_bits_per_pixel ) + 31 ) & ~31 ) >> 3 );
-    i_buffer = i_stride * p_sys->fmt.video.i_height;
-    block_Init( &p_block->self, p_buffer, i_buffer );
-    p_block->self.pf_release = CaptureBlockRelease;
-    p_block->hbmp            = hbmp;
-
     return &p_block->self;
 
 error:
     if( hbmp ) DeleteObject( hbmp );
+    CapturePoolRelease( p_pool );
     return NULL;
 }
 
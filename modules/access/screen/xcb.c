@@ -101,6 +101,34 @@ static int Control (demux_t *, int, va_list);
 static es_out_id_t *InitES (demux_t *, uint_fast16_t, uint_fast16_t,
                             uint_fast8_t, uint8_t *);
 
+#ifdef HAVE_SYS_SHM_H
+# define SHM_POOL_SIZE 4 /**< Maximum number of idle segments kept */
+
+typedef struct shm_pool shm_pool_t;
+
+/** Block of a shared memory segment attached to the X server */
+typedef struct
+{
+    block_t        self;
+    shm_pool_t    *pool;
+    xcb_shm_seg_t  segment; /**< SHM segment XID */
+    void          *addr;
+    size_t         size;
+} shm_block_t;
+
+/** Segments are attached once and reused for the captures of the same size,
+ * when the blocks sent downstream are released */
+struct shm_pool
+{
+    vlc_mutex_t       lock;
+    xcb_connection_t *conn; /**< NULL once the capture is closed */
+    unsigned          refs; /**< capture + blocks in flight */
+    size_t            size; /**< size of the idle segments */
+    unsigned          count; /**< number of idle segments */
+    shm_block_t      *idle[SHM_POOL_SIZE];
+};
+#endif
+
 struct demux_sys_t
 {
     /* All owned by timer thread while timer is armed: */
@@ -109,7 +137,9 @@ struct demux_sys_t
     float             rate; /**< Frame rate */
     xcb_window_t      window; /**< Captured window XID  */
     xcb_pixmap_t      pixmap; /**< Pixmap for composited capture */
-    xcb_shm_seg_t     segment; /**< SHM segment XID */
+#ifdef HAVE_SYS_SHM_H
+    shm_pool_t       *shm_pool; /**< Shared memory segments */
+#endif
     int16_t           x, y; /**< Requested capture top-left coordinates */
     uint16_t          w, h; /**< Requested capture pixel dimensions */
     uint8_t           bpp; /**< Actual bytes per pixel *es */
@@ -136,6 +166,134 @@ static bool CheckSHM (xcb_connection_t *conn)
 #endif
 }
 
+#ifdef HAVE_SYS_SHM_H
+/* Must be called with the pool lock */
+static void ShmBlockDestroy (shm_pool_t *pool, shm_block_t *b)
+{
+    if (pool->conn != NULL)
+        xcb_shm_detach (pool->conn, b->segment);
+    shmdt (b->addr);
+    free (b);
+}
+
+static void ShmPoolRelease (shm_pool_t *pool)
+{
+    vlc_mutex_lock (&pool->lock);
+    bool last = --pool->refs == 0;
+    vlc_mutex_unlock (&pool->lock);
+
+    if (last)
+    {
+        vlc_mutex_destroy (&pool->lock);
+        free (pool);
+    }
+}
+
+static void ShmBlockRelease (block_t *block)
+{
+    shm_block_t *b = (shm_block_t *)block;
+    shm_pool_t *pool = b->pool;
+
+    vlc_mutex_lock (&pool->lock);
+    if (pool->conn != NULL && b->size == pool->size
+     && pool->count < SHM_POOL_SIZE)
+        pool->idle[pool->count++] = b;
+    else
+        ShmBlockDestroy (pool, b);
+    vlc_mutex_unlock (&pool->lock);
+
+    ShmPoolRelease (pool);
+}
+
+static shm_pool_t *ShmPoolCreate (xcb_connection_t *conn)
+{
+    shm_pool_t *pool = malloc (sizeof (*pool));
+    if (unlikely(pool == NULL))
+        return NULL;
+
+    vlc_mutex_init (&pool->lock);
+    pool->conn = conn;
+    pool->refs = 1;
+    pool->size = 0;
+    pool->count = 0;
+    return pool;
+}
+
+static void ShmPoolClose (shm_pool_t *pool)
+{
+    vlc_mutex_lock (&pool->lock);
+    while (pool->count > 0)
+        ShmBlockDestroy (pool, pool->idle[--pool->count]);
+    /* Blocks still in flight are detached with the connection */
+    pool->conn = NULL;
+    vlc_mutex_unlock (&pool->lock);
+
+    ShmPoolRelease (pool);
+}
+
+/** Gets an attached segment of the given size */
+static shm_block_t *ShmBlockGet (demux_t *demux, shm_pool_t *pool,
+                                 size_t size)
+{
+    shm_block_t *b = NULL;
+
+    vlc_mutex_lock (&pool->lock);
+    if (pool->size != size)
+    {   /* The capture size changed */
+        while (pool->count > 0)
+            ShmBlockDestroy (pool, pool->idle[--pool->count]);
+        pool->size = size;
+    }
+    if (pool->count > 0)
+        b = pool->idle[--pool->count];
+    pool->refs++;
+    vlc_mutex_unlock (&pool->lock);
+
+    if (b == NULL)
+    {
+        b = malloc (sizeof (*b));
+        if (unlikely(b == NULL))
+            goto error;
+
+        int id = shmget (IPC_PRIVATE, size, IPC_CREAT | 0777);
+        if (id == -1)
+        {
+            msg_Err (demux, "shared memory allocation error: %s",
+                     vlc_strerror_c(errno));
+            free (b);
+            goto error;
+        }
+
+        /* Attach the segment to VLC and X */
+        b->addr = shmat (id, NULL, 0 /* read/write */);
+        if (-1 == (intptr_t)b->addr)
+        {
+            msg_Err (demux, "shared memory attachment error: %s",
+                     vlc_strerror_c(errno));
+            shmctl (id, IPC_RMID, 0);
+            free (b);
+            goto error;
+        }
+
+        b->pool = pool;
+        b->segment = xcb_generate_id (pool->conn);
+        b->size = size;
+        xcb_shm_attach (pool->conn, b->segment, id, 0 /* read/write */);
+        xcb_flush (pool->conn);
+        /* The segment is destroyed once detached from both sides */
+        shmctl (id, IPC_RMID, 0);
+    }
+
+    block_Init (&b->self, b->addr, size);
+    b->self.pf_release = ShmBlockRelease;
+    return b;
+
+error:
+    ShmPoolRelease (pool);
+    return NULL;
+}
+#endif
+
 /**
  * Probes and initializes.
  */
@@ -216,8 +374,16 @@ static int Open (vlc_object_t *obj)
 
     /* Window properties */
     p_sys->pixmap = xcb_generate_id (conn);
-    p_sys->segment = xcb_generate_id (conn);
     p_sys->shm = CheckSHM (conn);
+#ifdef HAVE_SYS_SHM_H
+    p_sys->shm_pool = NULL;
+    if (p_sys->shm)
+    {
+        p_sys->shm_pool = ShmPoolCreate (conn);
+        if (p_sys->shm_pool == NULL)
+            p_sys->shm = false;
+    }
+#endif
     p_sys->w = var_InheritInteger (obj, "screen-width");
     p_sys->h = var_InheritInteger (obj, "screen-height");
     if (p_sys->w != 0 || p_sys->h != 0)
@@ -253,6 +419,10 @@ static int Open (vlc_object_t *obj)
     return VLC_SUCCESS;
 
 error:
+#ifdef HAVE_SYS_SHM_H
+    if (p_sys->shm_pool != NULL)
+        ShmPoolClose (p_sys->shm_pool);
+#endif
     xcb_disconnect (p_sys->conn);
     free (p_sys);
     return VLC_EGENERIC;
@@ -268,6 +438,10 @@ static void Close (vlc_object_t *obj)
     demux_sys_t *p_sys = demux->p_sys;
 
     vlc_timer_destroy (p_sys->timer);
+#ifdef HAVE_SYS_SHM_H
+    if (p_sys->shm_pool != NULL)
+        ShmPoolClose (p_sys->shm_pool);
+#endif
     xcb_disconnect (p_sys->conn);
     free (p_sys);
 }
@@ -436,45 +610,23 @@ discard:
     if (sys->shm)
     {   /* Capture screen through shared memory */
         size_t size = w * h * sys->bpp;
-        int id = shmget (IPC_PRIVATE, size, IPC_CREAT | 0777);
-        if (id == -1) /* XXX: fallback */
-        {
-            msg_Err (demux, "shared memory allocation error: %s",
-                     vlc_strerror_c(errno));
+        shm_block_t *b = ShmBlockGet (demux, sys->shm_pool, size);
+        if (b == NULL) /* XXX: fallback */
             goto noshm;
-        }
 
-        /* Attach the segment to X and capture */
         xcb_shm_get_image_reply_t *img;
         xcb_shm_get_image_cookie_t ck;
 
-        xcb_shm_attach (conn, sys->segment, id, 0 /* read/write */);
         ck = xcb_shm_get_image (conn, drawable, x, y, w, h, ~0,
-                                XCB_IMAGE_FORMAT_Z_PIXMAP, sys->segment, 0);
-        xcb_shm_detach (conn, sys->segment);
+                                XCB_IMAGE_FORMAT_Z_PIXMAP, b->segment, 0);
         img = xcb_shm_get_image_reply (conn, ck, NULL);
-        xcb_flush (conn); /* ensure eventual detach */
-
         if (img == NULL)
         {
-            shmctl (id, IPC_RMID, 0);
+            block_Release (&b->self);
             goto noshm;
         }
         free (img);
-
-        /* Attach the segment to VLC */
-        void *shm = shmat (id, NULL, 0 /* read/write */);
-        shmctl (id, IPC_RMID, 0);
-        if (-1 == (intptr_t)shm)
-        {
-            msg_Err (demux, "shared memory attachment error: %s",
-                     vlc_strerror_c(errno));
-            return;
-        }
-
-        block = block_shm_Alloc (shm, size);
-        if (unlikely(block == NULL))
-            shmdt (shm);
+        block = &b->self;
     }
 noshm:
 #endif
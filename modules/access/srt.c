@@ -32,6 +32,7 @@
 #include <vlc_interrupt.h>
 #include <vlc_plugin.h>
 #include <vlc_access.h>
+#include <vlc_input.h>
 
 #include <vlc_network.h>
 #include <vlc_url.h>
@@ -46,6 +47,11 @@
 /* The default latency is 125
  * which uses srt library internally */
 #define SRT_DEFAULT_LATENCY 125
+/* The link statistics are published every 5 seconds */
+#define SRT_DEFAULT_STATS_PERIOD 5000
+/* Up to 7 messages are received at once, so that a block carries as many
+ * TS packets as an UDP datagram of the sender */
+#define SRT_RECV_MAX_MESSAGES 7
 
 struct stream_sys_t
 {
@@ -55,6 +61,9 @@ struct stream_sys_t
     int         i_latency;
     size_t      i_chunk_size;
     int         i_event_fd;
+
+    mtime_t     i_stats_period;
+    mtime_t     i_stats_next;
 };
 
 static void srt_wait_interrupted(void *p_data)
@@ -93,11 +102,37 @@ static int Control(stream_t *p_stream, int i_query, va_list args)
     return i_ret;
 }
 
+static void PublishStats( stream_t *p_stream )
+{
+    stream_sys_t *p_sys = p_stream->p_sys;
+    SRT_TRACEBSTATS stats;
+
+    if ( p_stream->p_input == NULL ||
+         srt_bstats( p_sys->sock, &stats, 0 ) == SRT_ERROR )
+        return;
+
+    input_item_t *p_item = input_GetItem( p_stream->p_input );
+    const char *psz_cat = _("SRT link");
+
+    input_item_AddInfo( p_item, psz_cat, _("Round trip time"), "%.1f ms",
+                        stats.msRTT );
+    input_item_AddInfo( p_item, psz_cat, _("Bandwidth"), "%.2f Mb/s",
+                        stats.mbpsBandwidth );
+    input_item_AddInfo( p_item, psz_cat, _("Receive rate"), "%.2f Mb/s",
+                        stats.mbpsRecvRate );
+    input_item_AddInfo( p_item, psz_cat, _("Received packets"), "%"PRId64,
+                        stats.pktRecvTotal );
+    input_item_AddInfo( p_item, psz_cat, _("Lost packets"), "%d",
+                        stats.pktRcvLossTotal );
+    input_item_AddInfo( p_item, psz_cat, _("Dropped packets"), "%d",
+                        stats.pktRcvDropTotal );
+}
+
 static block_t *BlockSRT(stream_t *p_stream, bool *restrict eof)
 {
     stream_sys_t *p_sys = p_stream->p_sys;
 
-    block_t *pkt = block_Alloc( p_sys->i_chunk_size );
+    block_t *pkt = block_Alloc( p_sys->i_chunk_size * SRT_RECV_MAX_MESSAGES );
 
     if ( unlikely( pkt == NULL ) )
     {
@@ -140,15 +175,38 @@ static block_t *BlockSRT(stream_t *p_stream, bool *restrict eof)
         }
     }
 
-    int stat = srt_recvmsg( p_sys->sock, (char *)pkt->p_buffer, p_sys->i_chunk_size );
+    /* Read all the messages available, up to the block size */
+    pkt->i_buffer = 0;
+    for ( int i = 0; i < SRT_RECV_MAX_MESSAGES; i++ )
+    {
+        int stat = srt_recvmsg( p_sys->sock,
+                                (char *)&pkt->p_buffer[pkt->i_buffer],
+                                p_sys->i_chunk_size );
 
-    if ( stat == SRT_ERROR )
+        if ( stat == SRT_ERROR )
+        {
+            if ( srt_getlasterror( NULL ) == SRT_EASYNCRCV )
+            {
+                srt_clearlasterror();
+                break;
+            }
+            if ( pkt->i_buffer > 0 )
+                break; /* report the error on the next call */
+            msg_Err( p_stream, "failed to recevie SRT packet (reason: %s)", srt_getlasterror_str() );
+            goto endofstream;
+        }
+        pkt->i_buffer += stat;
+    }
+
+    if ( pkt->i_buffer == 0 )
+        goto skip;
+
+    if ( p_sys->i_stats_period > 0 && mdate() >= p_sys->i_stats_next )
     {
-        msg_Err( p_stream, "failed to recevie SRT packet (reason: %s)", srt_getlasterror_str() );
-        goto endofstream;
+        PublishStats( p_stream );
+        p_sys->i_stats_next = mdate() + p_sys->i_stats_period;
     }
 
-    pkt->i_buffer = stat;
     vlc_interrupt_unregister();
     return pkt;
 
@@ -186,6 +244,9 @@ static int Open(vlc_object_t *p_this)
     p_sys->i_chunk_size = var_InheritInteger( p_stream, "chunk-size" );
     p_sys->i_poll_timeout = var_InheritInteger( p_stream, "poll-timeout" );
     p_sys->i_latency = var_InheritInteger( p_stream, "latency" );
+    p_sys->i_stats_period = INT64_C(1000)
+        * var_InheritInteger( p_stream, "stats-period" );
+    p_sys->i_stats_next = mdate() + p_sys->i_stats_period;
     p_sys->i_poll_id = -1;
     p_sys->i_event_fd = -1;
     p_stream->p_sys = p_sys;
@@ -238,6 +299,10 @@ static int Open(vlc_object_t *p_this)
         goto failed;
     }
 
+    /* Receive without blocking once connected, to read all the pending
+     * messages after each poll */
+    srt_setsockopt( p_sys->sock, 0, SRTO_RCVSYN, &(bool) { false }, sizeof( bool ) );
+
     vlc_UrlClean( &parsed_url );
     freeaddrinfo( res );
 
@@ -304,6 +369,10 @@ vlc_module_begin ()
     add_integer( "poll-timeout", SRT_DEFAULT_POLL_TIMEOUT,
             N_("Return poll wait after timeout miliseconds (-1 = infinite)"), NULL, true )
     add_integer( "latency", SRT_DEFAULT_LATENCY, N_("SRT latency (ms)"), NULL, true )
+    add_integer( "stats-period", SRT_DEFAULT_STATS_PERIOD,
+            N_("SRT statistics period (ms)"),
+            N_("Period of the link statistics update in the media "
+               "information (0 = disabled)."), true )
 
     set_capability( "access", 0 )
     add_shortcut( "srt" )
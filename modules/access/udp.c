@@ -76,11 +76,22 @@ vlc_module_begin ()
     set_callbacks( Open, Close )
 vlc_module_end ()
 
+#ifdef HAVE_RECVMMSG
+/* Datagrams received per system call */
+# define UDP_BATCH 32
+#endif
+
 struct access_sys_t
 {
     int fd;
     int timeout;
     size_t mtu;
+#ifdef UDP_BATCH
+    /* Preallocated blocks, the received ones being from first to last */
+    block_t *pkts[UDP_BATCH];
+    unsigned first;
+    unsigned last;
+#endif
 };
 
 /*****************************************************************************
@@ -100,7 +111,7 @@ static int Open( vlc_object_t *p_this )
     if( p_access->b_preparsing )
         return VLC_EGENERIC;
 
-    sys = vlc_obj_alloc( p_this, 1, sizeof( *sys ) );
+    sys = vlc_obj_calloc( p_this, 1, sizeof( *sys ) );
     if( unlikely( sys == NULL ) )
         return VLC_ENOMEM;
 
@@ -185,6 +196,11 @@ static void Close( vlc_object_t *p_this )
     stream_t     *p_access = (stream_t*)p_this;
     access_sys_t *sys = p_access->p_sys;
 
+#ifdef UDP_BATCH
+    for( unsigned i = 0; i < UDP_BATCH; i++ )
+        if( sys->pkts[i] != NULL )
+            block_Release( sys->pkts[i] );
+#endif
     net_Close( sys->fd );
 }
 
@@ -221,6 +237,106 @@ static int Control( stream_t *p_access, int i_query, va_list args )
 /*****************************************************************************
  * BlockUDP:
  *****************************************************************************/
+#ifdef UDP_BATCH
+static block_t *BlockUDP(stream_t *access, bool *restrict eof)
+{
+    access_sys_t *sys = access->p_sys;
+    block_t *pkt;
+
+    if (sys->first < sys->last)
+    {   /* Return the datagrams received by the previous call first */
+        pkt = sys->pkts[sys->first];
+        sys->pkts[sys->first++] = NULL;
+        return pkt;
+    }
+
+    struct mmsghdr msgs[UDP_BATCH];
+    struct iovec iovs[UDP_BATCH];
+    unsigned count;
+
+    /* Reuse the blocks left over by the previous call */
+    for (count = 0; count < UDP_BATCH; count++)
+    {
+        pkt = sys->pkts[count];
+        if (pkt == NULL)
+        {
+            pkt = block_Alloc(sys->mtu);
+            if (unlikely(pkt == NULL))
+                break;
+            sys->pkts[count] = pkt;
+        }
+
+        iovs[count].iov_base = pkt->p_buffer;
+        iovs[count].iov_len = sys->mtu;
+        msgs[count].msg_hdr = (struct msghdr) {
+            .msg_iov = &iovs[count],
+            .msg_iovlen = 1,
+        };
+    }
+
+    if (unlikely(count == 0))
+    {   /* OOM - dequeue and discard one packet */
+        char dummy;
+        recv(sys->fd, &dummy, 1, 0);
+        return NULL;
+    }
+
+    struct pollfd ufd[1];
+
+    ufd[0].fd = sys->fd;
+    ufd[0].events = POLLIN;
+
+    switch (vlc_poll_i11e(ufd, 1, sys->timeout))
+    {
+        case 0:
+            msg_Err(access, "receive time-out");
+            *eof = true;
+            /* fall through */
+        case -1:
+            return NULL;
+     }
+
+    int flags = MSG_DONTWAIT;
+#ifdef __linux__
+    flags |= MSG_TRUNC; /* get the actual length of truncated packets */
+#endif
+    int n = recvmmsg(sys->fd, msgs, count, flags, NULL);
+    if (n <= 0)
+        return NULL;
+
+    const size_t mtu = sys->mtu;
+
+    for (int i = 0; i < n; i++)
+    {
+        size_t len = msgs[i].msg_len;
+
+        pkt = sys->pkts[i];
+        if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC)
+        {
+            msg_Err(access, "%zu bytes packet truncated (MTU was %zu)",
+                    len, mtu);
+            pkt->i_flags |= BLOCK_FLAG_CORRUPTED;
+            if (len > sys->mtu)
+                sys->mtu = len;
+        }
+        else
+            pkt->i_buffer = len;
+    }
+
+    if (sys->mtu != mtu) /* reallocate the left over blocks */
+        for (unsigned i = n; i < count; i++)
+        {
+            block_Release(sys->pkts[i]);
+            sys->pkts[i] = NULL;
+        }
+
+    pkt = sys->pkts[0];
+    sys->pkts[0] = NULL;
+    sys->first = 1;
+    sys->last = n;
+    return pkt;
+}
+#else
 static block_t *BlockUDP(stream_t *access, bool *restrict eof)
 {
     access_sys_t *sys = access->p_sys;
@@ -282,3 +398,4 @@ skip:
 
     return pkt;
 }
+#endif
@@ -48,6 +48,7 @@ struct demux_sys_t
     vlc_thread_t thread;
 
     struct buffer_t *bufv;
+    vlc_v4l2_lender_t *lender;
     union
     {
         uint32_t bufc;
@@ -553,6 +554,7 @@ static int InitVideo (demux_t *demux, int fd, uint32_t caps)
 
     /* Init I/O method */
     void *(*entry) (void *);
+    sys->lender = NULL;
     if (caps & V4L2_CAP_STREAMING)
     {
         if (0 /* BROKEN */ && StartUserPtr (VLC_OBJECT(demux), fd) == 0)
@@ -570,10 +572,14 @@ static int InitVideo (demux_t *demux, int fd, uint32_t caps)
         }
         else /* fall back to memory map */
         {
-            sys->bufc = 4;
+            /* Some buffers are lent to the blocks sent downstream */
+            sys->bufc = 6;
             sys->bufv = StartMmap (VLC_OBJECT(demux), fd, &sys->bufc);
             if (sys->bufv == NULL)
                 return -1;
+            sys->lender = LenderCreate (fd, sys->bufv, sys->bufc);
+            if (sys->lender != NULL)
+                sys->bufv = NULL; /* owned by the lender now */
             entry = MmapThread;
             msg_Dbg (demux, "streaming with %"PRIu32" memory-mapped buffers",
                      sys->bufc);
@@ -608,6 +614,8 @@ static int InitVideo (demux_t *demux, int fd, uint32_t caps)
         if (sys->vbi != NULL)
             CloseVBI (sys->vbi);
 #endif
+        if (sys->lender != NULL)
+            LenderStop (sys->lender);
         if (sys->bufv != NULL)
             StopMmap (sys->fd, sys->bufv, sys->bufc);
         return -1;
@@ -622,6 +630,8 @@ void DemuxClose( vlc_object_t *obj )
 
     vlc_cancel (sys->thread);
     vlc_join (sys->thread, NULL);
+    if (sys->lender != NULL)
+        LenderStop (sys->lender);
     if (sys->bufv != NULL)
         StopMmap (sys->fd, sys->bufv, sys->bufc);
     ControlsDeinit( obj, sys->controls );
@@ -755,7 +765,11 @@ static void *MmapThread (void *data)
         if( ufd[0].revents )
         {
             int canc = vlc_savecancel ();
-            block_t *block = GrabVideo (VLC_OBJECT(demux), fd, sys->bufv);
+            block_t *block;
+            if (sys->lender != NULL)
+                block = GrabVideoLent (VLC_OBJECT(demux), sys->lender);
+            else
+                block = GrabVideo (VLC_OBJECT(demux), fd, sys->bufv);
             if (block != NULL)
             {
                 block->i_flags |= sys->block_flags;
@@ -58,6 +58,12 @@ void StopMmap (int, struct buffer_t *, uint32_t);
 mtime_t GetBufferPTS (const struct v4l2_buffer *);
 block_t* GrabVideo (vlc_object_t *, int, const struct buffer_t *);
 
+typedef struct vlc_v4l2_lender vlc_v4l2_lender_t;
+
+vlc_v4l2_lender_t *LenderCreate (int, struct buffer_t *, uint32_t);
+void LenderStop (vlc_v4l2_lender_t *);
+block_t *GrabVideoLent (vlc_object_t *, vlc_v4l2_lender_t *);
+
 #ifdef ZVBI_COMPILED
 /* vbi.c */
 typedef struct vlc_v4l2_vbi vlc_v4l2_vbi_t;
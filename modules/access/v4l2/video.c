@@ -35,6 +35,7 @@
 
 #include <vlc_common.h>
 #include <vlc_block.h>
+#include <vlc_atomic.h>
 
 #include "v4l2.h"
 
@@ -736,3 +737,167 @@ void StopMmap (int fd, struct buffer_t *bufv, uint32_t bufc)
         v4l2_munmap (bufv[i].start, bufv[i].length);
     free (bufv);
 }
+
+/**
+ * Memory-mapped buffers lent to the blocks sent downstream.
+ *
+ * Each block points into a driver buffer, and queues it back to the driver
+ * once released, so that frames are not copied. If too few buffers would be
+ * left to the driver, frames are copied instead.
+ */
+struct vlc_v4l2_lender
+{
+    int fd;
+    struct buffer_t *bufv;
+    uint32_t bufc;
+
+    vlc_mutex_t lock;
+    bool streaming;
+    atomic_uint refs; /**< the lender and the lent blocks */
+    atomic_uint lent;
+};
+
+typedef struct
+{
+    block_t self;
+    vlc_v4l2_lender_t *lender;
+    struct v4l2_buffer buf;
+} lent_block_t;
+
+/** Minimum number of buffers left queued to the driver */
+#define LENDER_QUEUED_MIN 2
+
+static void LenderRelease (vlc_v4l2_lender_t *lender)
+{
+    if (atomic_fetch_sub (&lender->refs, 1) != 1)
+        return;
+
+    /* Streaming was stopped. The file descriptor may be closed already,
+     * but the mappings remain valid until unmapped. */
+    for (uint32_t i = 0; i < lender->bufc; i++)
+        v4l2_munmap (lender->bufv[i].start, lender->bufv[i].length);
+    free (lender->bufv);
+    vlc_mutex_destroy (&lender->lock);
+    free (lender);
+}
+
+static void LentBlockRelease (block_t *block)
+{
+    lent_block_t *lb = (lent_block_t *)block;
+    vlc_v4l2_lender_t *lender = lb->lender;
+
+    vlc_mutex_lock (&lender->lock);
+    if (lender->streaming)
+        v4l2_ioctl (lender->fd, VIDIOC_QBUF, &lb->buf);
+    vlc_mutex_unlock (&lender->lock);
+
+    atomic_fetch_sub (&lender->lent, 1);
+    free (lb);
+    LenderRelease (lender);
+}
+
+/**
+ * Takes over memory-mapped buffers from StartMmap(), to lend them.
+ * @return the lender, or NULL on error (the buffers are then left as is).
+ */
+vlc_v4l2_lender_t *LenderCreate (int fd, struct buffer_t *bufv,
+                                 uint32_t bufc)
+{
+    vlc_v4l2_lender_t *lender = malloc (sizeof (*lender));
+    if (unlikely(lender == NULL))
+        return NULL;
+
+    lender->fd = fd;
+    lender->bufv = bufv;
+    lender->bufc = bufc;
+    vlc_mutex_init (&lender->lock);
+    lender->streaming = true;
+    atomic_init (&lender->refs, 1);
+    atomic_init (&lender->lent, 0);
+    return lender;
+}
+
+/**
+ * Stops streaming. The buffers are unmapped once all lent blocks are
+ * released.
+ */
+void LenderStop (vlc_v4l2_lender_t *lender)
+{
+    enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+
+    vlc_mutex_lock (&lender->lock);
+    lender->streaming = false;
+    /* STREAMOFF implicitly dequeues all buffers */
+    v4l2_ioctl (lender->fd, VIDIOC_STREAMOFF, &type);
+    vlc_mutex_unlock (&lender->lock);
+
+    LenderRelease (lender);
+}
+
+/*****************************************************************************
+ * GrabVideoLent: Grab a video frame without copying it, if possible
+ *****************************************************************************/
+block_t *GrabVideoLent (vlc_object_t *demux, vlc_v4l2_lender_t *lender)
+{
+    struct v4l2_buffer buf = {
+        .type = V4L2_BUF_TYPE_VIDEO_CAPTURE,
+        .memory = V4L2_MEMORY_MMAP,
+    };
+
+    /* Wait for next frame */
+    if (v4l2_ioctl (lender->fd, VIDIOC_DQBUF, &buf) < 0)
+    {
+        switch (errno)
+        {
+            case EAGAIN:
+                return NULL;
+            case EIO:
+                /* Could ignore EIO, see spec. */
+                /* fall through */
+            default:
+                msg_Err (demux, "dequeue error: %s", vlc_strerror_c(errno));
+                return NULL;
+        }
+    }
+
+    const struct buffer_t *buffer = &lender->bufv[buf.index];
+    block_t *block = NULL;
+
+    /* Lend the buffer if enough others remain queued */
+    if (atomic_load (&lender->lent) + 1 + LENDER_QUEUED_MIN <= lender->bufc)
+    {
+        lent_block_t *lb = malloc (sizeof (*lb));
+        if (unlikely(lb == NULL))
+            goto requeue;
+
+        block = &lb->self;
+        block_Init (block, buffer->start, buffer->length);
+        block->i_buffer = buf.bytesused;
+        block->pf_release = LentBlockRelease;
+        lb->lender = lender;
+        lb->buf = buf;
+        atomic_fetch_add (&lender->refs, 1);
+        atomic_fetch_add (&lender->lent, 1);
+        block->i_pts = block->i_dts = GetBufferPTS (&buf);
+        return block;
+    }
+
+    /* Copy frame */
+    block = block_Alloc (buf.bytesused);
+    if (likely(block != NULL))
+    {
+        block->i_pts = block->i_dts = GetBufferPTS (&buf);
+        memcpy (block->p_buffer, buffer->start, buf.bytesused);
+    }
+
+requeue:
+    /* Unlock */
+    if (v4l2_ioctl (lender->fd, VIDIOC_QBUF, &buf) < 0)
+    {
+        msg_Err (demux, "queue error: %s", vlc_strerror_c(errno));
+        if (block != NULL)
+            block_Release (block);
+        return NULL;
+    }
+    return block;
+}
@@ -50,6 +50,8 @@
 #include <vlc_strings.h>
 #include <vlc_dialog.h>
 
+#include "file_writer.h"
+
 #ifndef O_LARGEFILE
 #   define O_LARGEFILE 0
 #endif
@@ -59,6 +61,12 @@
 
 #define SOUT_CFG_PREFIX "sout-file-"
 
+struct sout_access_out_sys_t
+{
+    int fd;
+    file_writer_t *writer; /* for asynchronous writing, or NULL */
+};
+
 /*****************************************************************************
  * Read: standard read on a file descriptor.
  *****************************************************************************/
@@ -67,7 +75,7 @@ static ssize_t Read( sout_access_out_t *p_access, block_t *p_buffer )
     ssize_t val;
 
     do
-        val = read( (intptr_t)p_access->p_sys, p_buffer->p_buffer,
+        val = read( p_access->p_sys->fd, p_buffer->p_buffer,
                     p_buffer->i_buffer );
     while (val == -1 && errno == EINTR);
     return val;
@@ -82,7 +90,7 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
 
     while( p_buffer )
     {
-        ssize_t val = write ((intptr_t)p_access->p_sys,
+        ssize_t val = write (p_access->p_sys->fd,
                              p_buffer->p_buffer, p_buffer->i_buffer);
         if (val <= 0)
         {
@@ -111,7 +119,7 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
 
 static ssize_t WritePipe(sout_access_out_t *access, block_t *block)
 {
-    int fd = (intptr_t)access->p_sys;
+    int fd = access->p_sys->fd;
     ssize_t total = 0;
 
     while (block != NULL)
@@ -150,7 +158,7 @@ static ssize_t WritePipe(sout_access_out_t *access, block_t *block)
 #ifdef S_ISSOCK
 static ssize_t Send(sout_access_out_t *access, block_t *block)
 {
-    int fd = (intptr_t)access->p_sys;
+    int fd = access->p_sys->fd;
     size_t total = 0;
 
     while (block != NULL)
@@ -189,7 +197,30 @@ static ssize_t Send(sout_access_out_t *access, block_t *block)
  *****************************************************************************/
 static int Seek( sout_access_out_t *p_access, off_t i_pos )
 {
-    return lseek( (intptr_t)p_access->p_sys, i_pos, SEEK_SET );
+    return lseek( p_access->p_sys->fd, i_pos, SEEK_SET );
+}
+
+/*****************************************************************************
+ * Asynchronous writing: the data is written by a thread, which is waited
+ * for before the file is read or seeked
+ *****************************************************************************/
+static ssize_t ReadAsync( sout_access_out_t *p_access, block_t *p_buffer )
+{
+    if( file_writer_Flush( p_access->p_sys->writer ) )
+        return -1;
+    return Read( p_access, p_buffer );
+}
+
+static ssize_t WriteAsync( sout_access_out_t *p_access, block_t *p_buffer )
+{
+    return file_writer_Write( p_access->p_sys->writer, p_buffer );
+}
+
+static int SeekAsync( sout_access_out_t *p_access, off_t i_pos )
+{
+    if( file_writer_Flush( p_access->p_sys->writer ) )
+        return -1;
+    return Seek( p_access, i_pos );
 }
 
 static int Control( sout_access_out_t *p_access, int i_query, va_list args )
@@ -223,6 +254,11 @@ static const char *const ppsz_sout_options[] = {
 #ifdef O_SYNC
     "sync",
 #endif
+    "async",
+    "buffer",
+    "drop",
+    "prealloc",
+    "direct",
     NULL
 };
 
@@ -351,7 +387,39 @@ static int Open( vlc_object_t *p_this )
         p_access->pf_seek = NULL;
     }
     p_access->pf_control = Control;
-    p_access->p_sys    = (void *)(intptr_t)fd;
+
+    sout_access_out_sys_t *p_sys = malloc( sizeof( *p_sys ) );
+    if( unlikely(p_sys == NULL) )
+    {
+        vlc_close( fd );
+        return VLC_ENOMEM;
+    }
+    p_sys->fd = fd;
+    p_sys->writer = NULL;
+    p_access->p_sys = p_sys;
+
+    if( var_GetBool( p_access, SOUT_CFG_PREFIX "async" )
+     && p_access->pf_write == Write )
+    {
+        const file_writer_cfg_t cfg = {
+            .i_queue_max = (size_t)var_GetInteger( p_access,
+                                    SOUT_CFG_PREFIX "buffer" ) << 20,
+            .b_drop = var_GetBool( p_access, SOUT_CFG_PREFIX "drop" ),
+            .b_direct = var_GetBool( p_access, SOUT_CFG_PREFIX "direct" ),
+            .i_prealloc = (uint64_t)var_GetInteger( p_access,
+                                    SOUT_CFG_PREFIX "prealloc" ) << 20,
+        };
+
+        p_sys->writer = file_writer_New( VLC_OBJECT(p_access), fd, &cfg );
+        if( p_sys->writer != NULL )
+        {
+            p_access->pf_read = ReadAsync;
+            p_access->pf_write = WriteAsync;
+            p_access->pf_seek = SeekAsync;
+        }
+        else
+            msg_Warn( p_access, "cannot write asynchronously" );
+    }
 
     msg_Dbg( p_access, "file access output opened (%s)", p_access->psz_path );
     if (append)
@@ -366,8 +434,12 @@ static int Open( vlc_object_t *p_this )
 static void Close( vlc_object_t * p_this )
 {
     sout_access_out_t *p_access = (sout_access_out_t*)p_this;
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
 
-    vlc_close( (intptr_t)p_access->p_sys );
+    if( p_sys->writer != NULL )
+        file_writer_Delete( p_sys->writer );
+    vlc_close( p_sys->fd );
+    free( p_sys );
 
     msg_Dbg( p_access, "file access output closed" );
 }
@@ -383,6 +455,21 @@ static void Close( vlc_object_t * p_this )
     "on the file path")
 #define SYNC_TEXT N_("Synchronous writing")
 #define SYNC_LONGTEXT N_( "Open the file with synchronous writing.")
+#define ASYNC_TEXT N_("Asynchronous writing")
+#define ASYNC_LONGTEXT N_( "Write the file from a background thread, " \
+    "so that slow disks do not stall the stream output.")
+#define BUFFER_TEXT N_("Asynchronous buffer size (MiB)")
+#define BUFFER_LONGTEXT N_( "Data queued in memory at most, while the " \
+    "disk is slow.")
+#define DROP_TEXT N_("Drop data when the buffer is full")
+#define DROP_LONGTEXT N_( "Drop the data instead of waiting for the disk, " \
+    "when the asynchronous buffer is full.")
+#define PREALLOC_TEXT N_("Preallocation (MiB)")
+#define PREALLOC_LONGTEXT N_( "Allocate disk space ahead of the writes, " \
+    "to reduce fragmentation. 0 disables preallocation.")
+#define DIRECT_TEXT N_("Direct writing")
+#define DIRECT_LONGTEXT N_( "Bypass the page cache for asynchronous writes, " \
+    "if supported.")
 
 vlc_module_begin ()
     set_description( N_("File stream output") )
@@ -401,5 +488,15 @@ vlc_module_begin ()
     add_bool( SOUT_CFG_PREFIX "sync", false, SYNC_TEXT,SYNC_LONGTEXT,
               false )
 #endif
+    add_bool( SOUT_CFG_PREFIX "async", false, ASYNC_TEXT, ASYNC_LONGTEXT,
+              true )
+    add_integer_with_range( SOUT_CFG_PREFIX "buffer", 32, 1, 1024,
+                            BUFFER_TEXT, BUFFER_LONGTEXT, true )
+    add_bool( SOUT_CFG_PREFIX "drop", false, DROP_TEXT, DROP_LONGTEXT,
+              true )
+    add_integer_with_range( SOUT_CFG_PREFIX "prealloc", 0, 0, 1024,
+                            PREALLOC_TEXT, PREALLOC_LONGTEXT, true )
+    add_bool( SOUT_CFG_PREFIX "direct", false, DIRECT_TEXT, DIRECT_LONGTEXT,
+              true )
     set_callbacks( Open, Close )
 vlc_module_end ()
@@ -0,0 +1,367 @@
+/*****************************************************************************
+ * file_writer.c: background writing to a file
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_fs.h>
+
+#include "file_writer.h"
+
+/* Bytes per write, a multiple of the alignment of the direct writes */
+#define WRITER_BATCH (1 << 20)
+#define WRITER_ALIGN 4096
+/* Partial batches are written after this much idle time */
+#define WRITER_IDLE  CLOCK_FREQ
+
+struct file_writer
+{
+    vlc_object_t *obj;
+    int fd;
+    file_writer_cfg_t cfg;
+    vlc_thread_t thread;
+
+    vlc_mutex_t lock;
+    vlc_cond_t wait; /* for the thread: data, flush or end */
+    vlc_cond_t done; /* for the callers: room or flushed */
+    block_t *p_first;
+    block_t **pp_last;
+    size_t i_queued; /* bytes queued or being copied by the thread */
+    unsigned i_flush_req;
+    unsigned i_flush_done;
+    bool b_closing;
+    bool b_error;
+    bool b_dropping;
+
+    /* Statistics */
+    uint64_t i_written;
+    uint64_t i_dropped;
+    size_t i_queue_peak;
+    unsigned i_writes;
+    unsigned i_waits;
+
+    /* Thread only */
+    uint8_t *p_batch;
+    size_t i_batch;
+    bool b_direct;
+    int64_t i_allocated; /* end of the preallocated area */
+};
+
+static bool SetDirect( file_writer_t *w, bool b_direct )
+{
+#ifdef O_DIRECT
+    int flags = fcntl( w->fd, F_GETFL );
+
+    if( flags != -1
+     && fcntl( w->fd, F_SETFL, b_direct ? (flags | O_DIRECT)
+                                        : (flags & ~O_DIRECT) ) == 0 )
+    {
+        w->b_direct = b_direct;
+        return true;
+    }
+#else
+    VLC_UNUSED(b_direct);
+#endif
+    w->b_direct = false;
+    return false;
+}
+
+static void Preallocate( file_writer_t *w, int64_t i_pos )
+{
+#if defined(__linux__) && defined(FALLOC_FL_KEEP_SIZE)
+    if( i_pos + (int64_t)w->i_batch <= w->i_allocated )
+        return;
+    /* Keep the size, so that the file needs no truncation at the end */
+    if( fallocate( w->fd, FALLOC_FL_KEEP_SIZE, i_pos, w->cfg.i_prealloc ) )
+    {
+        msg_Dbg( w->obj, "cannot preallocate: %s", vlc_strerror_c(errno) );
+        w->cfg.i_prealloc = 0;
+        return;
+    }
+    w->i_allocated = i_pos + w->cfg.i_prealloc;
+#else
+    VLC_UNUSED(i_pos);
+    w->cfg.i_prealloc = 0;
+#endif
+}
+
+static void WriteBatch( file_writer_t *w )
+{
+    if( w->i_batch == 0 )
+        return;
+    /* Only this thread sets the error */
+    if( w->b_error )
+    {
+        w->i_batch = 0;
+        return;
+    }
+
+    int64_t i_pos = lseek( w->fd, 0, SEEK_CUR );
+
+    /* Direct writes need aligned offsets and sizes, which the last batch
+     * or a seek may break */
+    if( w->b_direct && ( i_pos < 0 || i_pos % WRITER_ALIGN
+                      || w->i_batch % WRITER_ALIGN ) )
+        SetDirect( w, false );
+    if( w->cfg.i_prealloc > 0 && i_pos >= 0 )
+        Preallocate( w, i_pos );
+
+    const uint8_t *p_data = w->p_batch;
+    size_t i_data = w->i_batch;
+
+    while( i_data > 0 )
+    {
+        ssize_t val = vlc_write( w->fd, p_data, i_data );
+        if( val < 0 )
+        {
+            if( errno == EINTR )
+                continue;
+            /* Not all file systems support direct writes */
+            if( errno == EINVAL && w->b_direct && SetDirect( w, false ) )
+                continue;
+
+            msg_Err( w->obj, "cannot write: %s", vlc_strerror_c(errno) );
+            vlc_mutex_lock( &w->lock );
+            w->b_error = true;
+            vlc_cond_broadcast( &w->done );
+            vlc_mutex_unlock( &w->lock );
+            break;
+        }
+        p_data += val;
+        i_data -= val;
+    }
+
+    vlc_mutex_lock( &w->lock );
+    w->i_written += w->i_batch - i_data;
+    w->i_writes++;
+    vlc_mutex_unlock( &w->lock );
+    w->i_batch = 0;
+}
+
+static void *Thread( void *data )
+{
+    file_writer_t *w = data;
+
+    vlc_mutex_lock( &w->lock );
+    for( ;; )
+    {
+        bool b_idle = false;
+
+        while( w->p_first == NULL && w->i_flush_done == w->i_flush_req
+            && !w->b_closing && !b_idle )
+        {
+            if( w->i_batch > 0 )
+                b_idle = vlc_cond_timedwait( &w->wait, &w->lock,
+                                             mdate() + WRITER_IDLE ) != 0;
+            else
+                vlc_cond_wait( &w->wait, &w->lock );
+        }
+
+        /* Everything queued before the flush request is in the chain */
+        block_t *p_chain = w->p_first;
+        const unsigned i_flush = w->i_flush_req;
+        const bool b_closing = w->b_closing;
+
+        w->p_first = NULL;
+        w->pp_last = &w->p_first;
+        vlc_mutex_unlock( &w->lock );
+
+        size_t i_consumed = 0;
+        while( p_chain != NULL )
+        {
+            block_t *p_next = p_chain->p_next;
+            const uint8_t *p_data = p_chain->p_buffer;
+            size_t i_data = p_chain->i_buffer;
+
+            while( i_data > 0 )
+            {
+                size_t i_copy = __MIN( i_data, WRITER_BATCH - w->i_batch );
+
+                memcpy( w->p_batch + w->i_batch, p_data, i_copy );
+                w->i_batch += i_copy;
+                p_data += i_copy;
+                i_data -= i_copy;
+                if( w->i_batch == WRITER_BATCH )
+                    WriteBatch( w );
+            }
+            i_consumed += p_chain->i_buffer;
+            block_Release( p_chain );
+            p_chain = p_next;
+        }
+
+        if( b_idle || b_closing || i_flush != w->i_flush_done )
+            WriteBatch( w );
+
+        vlc_mutex_lock( &w->lock );
+        w->i_queued -= i_consumed;
+        w->i_flush_done = i_flush;
+        vlc_cond_broadcast( &w->done );
+        if( b_closing && w->p_first == NULL )
+            break;
+    }
+    vlc_mutex_unlock( &w->lock );
+    return NULL;
+}
+
+file_writer_t *file_writer_New( vlc_object_t *obj, int fd,
+                                const file_writer_cfg_t *cfg )
+{
+    file_writer_t *w = malloc( sizeof( *w ) );
+    if( unlikely(w == NULL) )
+        return NULL;
+
+    w->p_batch = aligned_alloc( WRITER_ALIGN, WRITER_BATCH );
+    if( unlikely(w->p_batch == NULL) )
+    {
+        free( w );
+        return NULL;
+    }
+
+    w->obj = obj;
+    w->fd = fd;
+    w->cfg = *cfg;
+    vlc_mutex_init( &w->lock );
+    vlc_cond_init( &w->wait );
+    vlc_cond_init( &w->done );
+    w->p_first = NULL;
+    w->pp_last = &w->p_first;
+    w->i_queued = 0;
+    w->i_flush_req = w->i_flush_done = 0;
+    w->b_closing = false;
+    w->b_error = false;
+    w->b_dropping = false;
+    w->i_written = w->i_dropped = 0;
+    w->i_queue_peak = 0;
+    w->i_writes = w->i_waits = 0;
+    w->i_batch = 0;
+    w->b_direct = false;
+    w->i_allocated = 0;
+
+    if( cfg->b_direct && !SetDirect( w, true ) )
+        msg_Warn( obj, "cannot bypass the page cache" );
+
+    if( vlc_clone( &w->thread, Thread, w, VLC_THREAD_PRIORITY_LOW ) )
+    {
+        vlc_cond_destroy( &w->done );
+        vlc_cond_destroy( &w->wait );
+        vlc_mutex_destroy( &w->lock );
+        aligned_free( w->p_batch );
+        free( w );
+        return NULL;
+    }
+    return w;
+}
+
+void file_writer_Delete( file_writer_t *w )
+{
+    vlc_mutex_lock( &w->lock );
+    w->b_closing = true;
+    vlc_cond_signal( &w->wait );
+    vlc_mutex_unlock( &w->lock );
+    vlc_join( w->thread, NULL );
+
+    if( w->b_direct )
+        SetDirect( w, false );
+
+    msg_Dbg( w->obj, "%"PRIu64" bytes written in %u writes, up to %zu bytes "
+             "queued, waited %u times", w->i_written, w->i_writes,
+             w->i_queue_peak, w->i_waits );
+    if( w->i_dropped > 0 )
+        msg_Warn( w->obj, "%"PRIu64" bytes dropped, as the disk was too slow",
+                  w->i_dropped );
+
+    vlc_cond_destroy( &w->done );
+    vlc_cond_destroy( &w->wait );
+    vlc_mutex_destroy( &w->lock );
+    aligned_free( w->p_batch );
+    free( w );
+}
+
+ssize_t file_writer_Write( file_writer_t *w, block_t *p_chain )
+{
+    size_t i_size;
+
+    block_ChainProperties( p_chain, NULL, &i_size, NULL );
+
+    vlc_mutex_lock( &w->lock );
+    if( !w->cfg.b_drop )
+    {
+        while( w->i_queued > 0 && w->i_queued + i_size > w->cfg.i_queue_max
+            && !w->b_error )
+        {
+            w->i_waits++;
+            vlc_cond_wait( &w->done, &w->lock );
+        }
+    }
+
+    if( w->b_error )
+    {
+        vlc_mutex_unlock( &w->lock );
+        block_ChainRelease( p_chain );
+        return -1;
+    }
+
+    if( w->i_queued + i_size > w->cfg.i_queue_max )
+    {
+        if( !w->b_dropping )
+            msg_Warn( w->obj, "the disk is too slow, dropping data" );
+        w->b_dropping = true;
+        w->i_dropped += i_size;
+        vlc_mutex_unlock( &w->lock );
+        block_ChainRelease( p_chain );
+        return i_size;
+    }
+
+    if( w->b_dropping )
+        msg_Warn( w->obj, "the disk caught up, %"PRIu64" bytes dropped "
+                  "so far", w->i_dropped );
+    w->b_dropping = false;
+
+    block_ChainLastAppend( &w->pp_last, p_chain );
+    w->i_queued += i_size;
+    if( w->i_queued > w->i_queue_peak )
+        w->i_queue_peak = w->i_queued;
+    vlc_cond_signal( &w->wait );
+    vlc_mutex_unlock( &w->lock );
+    return i_size;
+}
+
+int file_writer_Flush( file_writer_t *w )
+{
+    vlc_mutex_lock( &w->lock );
+    const unsigned i_req = ++w->i_flush_req;
+
+    vlc_cond_signal( &w->wait );
+    while( (int)(w->i_flush_done - i_req) < 0 )
+        vlc_cond_wait( &w->done, &w->lock );
+
+    const bool b_error = w->b_error;
+    vlc_mutex_unlock( &w->lock );
+    return b_error ? VLC_EGENERIC : VLC_SUCCESS;
+}
@@ -0,0 +1,62 @@
+/*****************************************************************************
+ * file_writer.h: background writing to a file
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_FILE_WRITER_H
+#define VLC_FILE_WRITER_H 1
+
+/* The data is queued in memory by the callers, and written to the file in
+ * large batches by a thread, so that slow disks do not stall them. */
+typedef struct file_writer file_writer_t;
+
+typedef struct
+{
+    size_t   i_queue_max; /* bytes queued at most */
+    bool     b_drop;      /* drop the data when full, instead of waiting */
+    bool     b_direct;    /* bypass the page cache, if supported */
+    uint64_t i_prealloc;  /* bytes allocated ahead on disk, 0 for none */
+} file_writer_cfg_t;
+
+/**
+ * Starts writing to a file descriptor, at its current offset. The file
+ * descriptor stays owned by the caller.
+ */
+file_writer_t *file_writer_New( vlc_object_t *, int fd,
+                                const file_writer_cfg_t * );
+
+/**
+ * Writes all the queued data, then stops the thread and prints the
+ * statistics.
+ */
+void file_writer_Delete( file_writer_t * );
+
+/**
+ * Queues a chain of blocks.
+ *
+ * \return the number of bytes queued, or -1 after a write error
+ */
+ssize_t file_writer_Write( file_writer_t *, block_t * );
+
+/**
+ * Waits for the queued data to be written, before the file descriptor is
+ * used directly, e.g. to seek.
+ */
+int file_writer_Flush( file_writer_t * );
+
+#endif
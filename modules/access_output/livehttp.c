@@ -43,6 +43,8 @@
 #include <vlc_fs.h>
 #include <vlc_strings.h>
 #include <vlc_charset.h>
+#include <vlc_httpd.h>
+#include <vlc_memstream.h>
 
 #include <gcrypt.h>
 #include <vlc_gcrypt.h>
@@ -105,6 +107,18 @@ static void Close( vlc_object_t * );
 #define INTITIAL_SEG_TEXT N_("Number of first segment")
 #define INITIAL_SEG_LONGTEXT N_("The number of the first segment generated")
 
+#define HTTPD_TEXT N_("Serve over HTTP")
+#define HTTPD_LONGTEXT N_("Keep the segments in memory and serve them and "\
+                          "the index with the built-in HTTP server, instead "\
+                          "of writing files. The segment path and the index "\
+                          "are then URL paths on that server.")
+
+#define PARTLEN_TEXT N_("Partial segment length")
+#define PARTLEN_LONGTEXT N_("Length in milliseconds of the partial segments "\
+                            "listed for low latency playback, 0 to disable. "\
+                            "Only available when serving over HTTP, without "\
+                            "encryption.")
+
 vlc_module_begin ()
     set_description( N_("HTTP Live streaming output") )
     set_shortname( N_("LiveHTTP" ))
@@ -125,6 +139,10 @@ vlc_module_begin ()
               NOCACHE_TEXT, NOCACHE_LONGTEXT, true )
     add_bool( SOUT_CFG_PREFIX "generate-iv", false,
               RANDOMIV_TEXT, RANDOMIV_LONGTEXT, true )
+    add_bool( SOUT_CFG_PREFIX "httpd", false,
+              HTTPD_TEXT, HTTPD_LONGTEXT, true )
+    add_integer( SOUT_CFG_PREFIX "part-length", 0,
+                 PARTLEN_TEXT, PARTLEN_LONGTEXT, true )
     add_string( SOUT_CFG_PREFIX "index", NULL,
                 INDEX_TEXT, INDEX_LONGTEXT, false )
     add_string( SOUT_CFG_PREFIX "index-url", NULL,
@@ -156,12 +174,21 @@ static const char *const ppsz_sout_options[] = {
     "key-loadfile",
     "generate-iv",
     "initial-segment-number",
+    "httpd",
+    "part-length",
     NULL
 };
 
 static ssize_t Write( sout_access_out_t *, block_t * );
 static int Control( sout_access_out_t *, int, va_list );
 
+typedef struct output_part
+{
+    block_t *p_data;
+    mtime_t i_length;
+    bool b_independent;
+} output_part_t;
+
 typedef struct output_segment
 {
     char *psz_filename;
@@ -171,6 +198,16 @@ typedef struct output_segment
     float f_seglength;
     uint32_t i_segment_number;
     uint8_t aes_ivs[16];
+
+    /* In memory segment, served over HTTP. The parts and b_complete are
+     * shared with the HTTP server thread, under the access output lock. */
+    sout_access_out_sys_t *p_sys;
+    httpd_handler_t *p_handler;
+    block_t *p_pending;
+    block_t **pp_pending_last;
+    output_part_t *p_parts;
+    unsigned i_parts;
+    bool b_complete;
 } output_segment_t;
 
 struct sout_access_out_sys_t
@@ -205,6 +242,28 @@ struct sout_access_out_sys_t
     uint8_t stuffing_bytes[16];
     ssize_t stuffing_size;
     vlc_array_t segments_t;
+    bool b_segment_open;
+
+    /* fMP4 initialization segment (EXT-X-MAP) */
+    block_t *p_init;
+    char *psz_init_filename;
+    char *psz_init_uri;
+
+    /* In memory serving */
+    httpd_host_t *p_httpd_host;
+    httpd_file_t *p_index_file;
+    httpd_file_t *p_init_file;
+    vlc_mutex_t lock;
+    char *psz_index;
+    size_t i_index;
+    uint32_t i_index_first;
+    unsigned i_index_offset;
+
+    /* Partial segments */
+    mtime_t i_partlen;
+    mtime_t i_partdts;
+    mtime_t i_lastdts;
+    bool b_part_independent;
 };
 
 static int LoadCryptFile( sout_access_out_t *p_access);
@@ -212,6 +271,10 @@ static int CryptSetup( sout_access_out_t *p_access, char *keyfile );
 static int CheckSegmentChange( sout_access_out_t *p_access, block_t *p_buffer );
 static ssize_t writeSegment( sout_access_out_t *p_access );
 static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys );
+static int IndexFill( httpd_file_sys_t *, httpd_file_t *, uint8_t *,
+                      uint8_t **, int * );
+static int InitFill( httpd_file_sys_t *, httpd_file_t *, uint8_t *,
+                     uint8_t **, int * );
 /*****************************************************************************
  * Open: open the file
  *****************************************************************************/
@@ -250,6 +313,8 @@ static int Open( vlc_object_t *p_this )
     p_sys->b_caching = var_GetBool( p_access, SOUT_CFG_PREFIX "caching") ;
     p_sys->b_generate_iv = var_GetBool( p_access, SOUT_CFG_PREFIX "generate-iv") ;
     p_sys->b_segment_has_data = false;
+    p_sys->b_segment_open = false;
+    p_sys->i_partlen = var_GetInteger( p_access, SOUT_CFG_PREFIX "part-length" ) * 1000;
 
     vlc_array_init( &p_sys->segments_t );
 
@@ -270,7 +335,8 @@ static int Open( vlc_object_t *p_this )
             return VLC_ENOMEM;
         }
         p_sys->psz_indexPath = psz_tmp;
-        if( p_sys->i_initial_segment != 1 )
+        if( p_sys->i_initial_segment != 1 &&
+            !var_GetBool( p_access, SOUT_CFG_PREFIX "httpd" ) )
             vlc_unlink( p_sys->psz_indexPath );
     }
 
@@ -299,12 +365,66 @@ static int Open( vlc_object_t *p_this )
 
     p_sys->i_handle = -1;
     p_sys->i_segment = p_sys->i_initial_segment-1;
+    p_sys->i_index_first = p_sys->i_initial_segment;
     p_sys->psz_cursegPath = NULL;
 
+    vlc_mutex_init( &p_sys->lock );
+    if( var_GetBool( p_access, SOUT_CFG_PREFIX "httpd" ) )
+    {
+        if( !p_sys->psz_indexPath )
+        {
+            msg_Err( p_access, "no index URL specified" );
+            goto error;
+        }
+
+        p_sys->p_httpd_host = vlc_http_HostNew( VLC_OBJECT(p_access) );
+        if( !p_sys->p_httpd_host )
+        {
+            msg_Err( p_access, "cannot start HTTP server" );
+            goto error;
+        }
+
+        p_sys->p_index_file = httpd_FileNew( p_sys->p_httpd_host,
+                                             p_sys->psz_indexPath,
+                                             "application/vnd.apple.mpegurl",
+                                             NULL, NULL, IndexFill,
+                                             (httpd_file_sys_t *)p_access );
+        if( !p_sys->p_index_file )
+        {
+            msg_Err( p_access, "cannot serve index at `%s'",
+                     p_sys->psz_indexPath );
+            httpd_HostDelete( p_sys->p_httpd_host );
+            goto error;
+        }
+
+        if( p_sys->i_numsegs == 0 || !p_sys->b_delsegs )
+            msg_Warn( p_access, "all segments are kept in memory" );
+    }
+
+    if( p_sys->i_partlen > 0 && ( !p_sys->p_httpd_host || p_sys->key_uri ) )
+    {
+        msg_Warn( p_access, "partial segments need HTTP serving "
+                  "and no encryption, disabling them" );
+        p_sys->i_partlen = 0;
+    }
+
     p_access->pf_write = Write;
     p_access->pf_control = Control;
 
     return VLC_SUCCESS;
+
+error:
+    vlc_mutex_destroy( &p_sys->lock );
+    if( p_sys->key_uri )
+    {
+        gcry_cipher_close( p_sys->aes_ctx );
+        free( p_sys->key_uri );
+    }
+    free( p_sys->psz_keyfile );
+    free( p_sys->psz_indexUrl );
+    free( p_sys->psz_indexPath );
+    free( p_sys );
+    return VLC_EGENERIC;
 }
 
 /************************************************************************
@@ -504,8 +624,43 @@ static char *formatSegmentPath( char *psz_path, uint32_t i_seg )
     return psz_result;
 }
 
+/*****************************************************************************
+ * formatInitPath: create initialization segment path name
+ *****************************************************************************/
+static char *formatInitPath( char *psz_path )
+{
+    char *psz_result;
+    char *psz_firstNumSign;
+    int ret;
+
+    if ( ! ( psz_result  = vlc_strftime( psz_path ) ) )
+        return NULL;
+
+    psz_firstNumSign = psz_result + strcspn( psz_result, SEG_NUMBER_PLACEHOLDER );
+    if ( *psz_firstNumSign )
+    {
+        int i_cnt = strspn( psz_firstNumSign, SEG_NUMBER_PLACEHOLDER );
+
+        *psz_firstNumSign = '\0';
+        ret = asprintf( &psz_path, "%sinit%s", psz_result, psz_firstNumSign + i_cnt );
+    }
+    else
+        ret = asprintf( &psz_path, "%s.init", psz_result );
+    free( psz_result );
+
+    return ( ret < 0 ) ? NULL : psz_path;
+}
+
 static void destroySegment( output_segment_t *segment )
 {
+    /* Stops the HTTP server thread from reading the segment */
+    if( segment->p_handler )
+        httpd_HandlerDelete( segment->p_handler );
+    for( unsigned i = 0; i < segment->i_parts; i++ )
+        block_Release( segment->p_parts[i].p_data );
+    free( segment->p_parts );
+    block_ChainRelease( segment->p_pending );
+
     free( segment->psz_filename );
     free( segment->psz_duration );
     free( segment->psz_uri );
@@ -556,132 +711,175 @@ static bool isFirstItemRemovable( sout_access_out_sys_t *p_sys, uint32_t i_first
 }
 
 /************************************************************************
- * updateIndexAndDel: If necessary, update index file & delete old segments
+ * writeIndex: Write or publish the index listing segments from i_firstseg
  ************************************************************************/
-static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys, bool b_isend )
+static int writeIndex( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys,
+                       uint32_t i_firstseg, unsigned i_index_offset, bool b_isend )
 {
+    struct vlc_memstream ms;
+    char *psz_current_uri=NULL;
 
-    uint32_t i_firstseg;
-    unsigned i_index_offset = 0;
-
-    if ( p_sys->i_numsegs == 0 ||
-         p_sys->i_segment < ( p_sys->i_numsegs + p_sys->i_initial_segment ) )
-    {
-        i_firstseg = p_sys->i_initial_segment;
-    }
-    else
-    {
-        unsigned numsegs = segmentAmountNeeded( p_sys );
-        i_firstseg = ( p_sys->i_segment - numsegs ) + 1;
-        i_index_offset = vlc_array_count( &p_sys->segments_t ) - numsegs;
-    }
-
-    // First update index
-    if ( p_sys->psz_indexPath )
-    {
-        int val;
-        FILE *fp;
-        char *psz_idxTmp;
-        if ( asprintf( &psz_idxTmp, "%s.tmp", p_sys->psz_indexPath ) < 0)
-            return -1;
-
-        fp = vlc_fopen( psz_idxTmp, "wt");
-        if ( !fp )
-        {
-            msg_Err( p_access, "cannot open index file `%s'", psz_idxTmp );
-            free( psz_idxTmp );
-            return -1;
-        }
+    if( vlc_memstream_open( &ms ) )
+        return -1;
 
-        if ( fprintf( fp, "#EXTM3U\n#EXT-X-TARGETDURATION:%zu\n#EXT-X-VERSION:3\n#EXT-X-ALLOW-CACHE:%s"
-                          "%s\n#EXT-X-MEDIA-SEQUENCE:%"PRIu32"\n%s", p_sys->i_seglen,
+    vlc_memstream_printf( &ms, "#EXTM3U\n#EXT-X-TARGETDURATION:%zu\n#EXT-X-VERSION:%d\n",
+                          p_sys->i_seglen,
+                          ( p_sys->psz_init_uri || p_sys->i_partlen > 0 ) ? 6 : 3 );
+    if( p_sys->i_partlen > 0 )
+        vlc_memstream_printf( &ms, "#EXT-X-PART-INF:PART-TARGET=%"PRId64".%03"PRId64"\n"
+                              "#EXT-X-SERVER-CONTROL:PART-HOLD-BACK=%"PRId64".%03"PRId64"\n",
+                              p_sys->i_partlen / CLOCK_FREQ,
+                              p_sys->i_partlen % CLOCK_FREQ / 1000,
+                              3 * p_sys->i_partlen / CLOCK_FREQ,
+                              3 * p_sys->i_partlen % CLOCK_FREQ / 1000 );
+    vlc_memstream_printf( &ms, "#EXT-X-ALLOW-CACHE:%s"
+                          "%s\n#EXT-X-MEDIA-SEQUENCE:%"PRIu32"\n%s",
                           p_sys->b_caching ? "YES" : "NO",
                           p_sys->i_numsegs > 0 ? "" : b_isend ? "\n#EXT-X-PLAYLIST-TYPE:VOD" : "\n#EXT-X-PLAYLIST-TYPE:EVENT",
                           i_firstseg, ((p_sys->i_initial_segment > 1) && (p_sys->i_initial_segment == i_firstseg)) ? "#EXT-X-DISCONTINUITY\n" : ""
-                          ) < 0 )
-        {
-            free( psz_idxTmp );
-            fclose( fp );
-            return -1;
-        }
-        char *psz_current_uri=NULL;
+                          );
 
+    /* Before any key, as the initialization segment is not encrypted */
+    if( p_sys->psz_init_uri )
+        vlc_memstream_printf( &ms, "#EXT-X-MAP:URI=\"%s\"\n", p_sys->psz_init_uri );
 
-        for ( uint32_t i = i_firstseg; i <= p_sys->i_segment; i++ )
-        {
-            //scale to i_index_offset..numsegs + i_index_offset
-            uint32_t index = i - i_firstseg + i_index_offset;
+    for ( uint32_t i = i_firstseg; i <= p_sys->i_segment; i++ )
+    {
+        //scale to i_index_offset..numsegs + i_index_offset
+        uint32_t index = i - i_firstseg + i_index_offset;
 
-            output_segment_t *segment = vlc_array_item_at_index( &p_sys->segments_t, index );
-            if( p_sys->key_uri &&
-                ( !psz_current_uri ||  strcmp( psz_current_uri, segment->psz_key_uri ) )
-              )
+        output_segment_t *segment = vlc_array_item_at_index( &p_sys->segments_t, index );
+        if( p_sys->key_uri &&
+            ( !psz_current_uri ||  strcmp( psz_current_uri, segment->psz_key_uri ) )
+          )
+        {
+            free( psz_current_uri );
+            psz_current_uri = strdup( segment->psz_key_uri );
+            if( p_sys->b_generate_iv )
             {
-                int ret = 0;
-                free( psz_current_uri );
-                psz_current_uri = strdup( segment->psz_key_uri );
-                if( p_sys->b_generate_iv )
+                unsigned long long iv_hi = segment->aes_ivs[0];
+                unsigned long long iv_lo = segment->aes_ivs[8];
+                for( unsigned short j = 1; j < 8; j++ )
                 {
-                    unsigned long long iv_hi = segment->aes_ivs[0];
-                    unsigned long long iv_lo = segment->aes_ivs[8];
-                    for( unsigned short j = 1; j < 8; j++ )
-                    {
-                        iv_hi <<= 8;
-                        iv_hi |= segment->aes_ivs[j] & 0xff;
-                        iv_lo <<= 8;
-                        iv_lo |= segment->aes_ivs[8+j] & 0xff;
-                    }
-                    ret = fprintf( fp, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\",IV=0X%16.16llx%16.16llx\n",
-                                   segment->psz_key_uri, iv_hi, iv_lo );
-
-                } else {
-                    ret = fprintf( fp, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\"\n", segment->psz_key_uri );
+                    iv_hi <<= 8;
+                    iv_hi |= segment->aes_ivs[j] & 0xff;
+                    iv_lo <<= 8;
+                    iv_lo |= segment->aes_ivs[8+j] & 0xff;
                 }
-                if( ret < 0 )
-                {
-                    free( psz_current_uri );
-                    free( psz_idxTmp );
-                    fclose( fp );
-                    return -1;
-                }
-            }
+                vlc_memstream_printf( &ms, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\",IV=0X%16.16llx%16.16llx\n",
+                                      segment->psz_key_uri, iv_hi, iv_lo );
 
-            val = fprintf( fp, "#EXTINF:%s,\n%s\n", segment->psz_duration, segment->psz_uri);
-            if ( val < 0 )
-            {
-                free( psz_current_uri );
-                free( psz_idxTmp );
-                fclose( fp );
-                return -1;
+            } else {
+                vlc_memstream_printf( &ms, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\"\n", segment->psz_key_uri );
             }
         }
-        free( psz_current_uri );
 
-        if ( b_isend )
+        /* Only the parts of the last two segments are listed, the writer
+         * thread is the only one changing them, no need to lock */
+        if( p_sys->i_partlen > 0 && i + 1 >= p_sys->i_segment )
         {
-            if ( fputs ( STR_ENDLIST, fp ) < 0)
+            const char *psz_sep = strchr( segment->psz_uri, '?' ) ? "&" : "?";
+
+            for( unsigned j = 0; j < segment->i_parts; j++ )
             {
-                free( psz_idxTmp );
-                fclose( fp ) ;
-                return -1;
+                const output_part_t *part = &segment->p_parts[j];
+                vlc_memstream_printf( &ms, "#EXT-X-PART:DURATION=%"PRId64".%03"PRId64
+                                      ",URI=\"%s%spart=%u\"%s\n",
+                                      part->i_length / CLOCK_FREQ,
+                                      part->i_length % CLOCK_FREQ / 1000,
+                                      segment->psz_uri, psz_sep, j,
+                                      part->b_independent ? ",INDEPENDENT=YES" : "" );
             }
-
         }
-        fclose( fp );
 
-        val = vlc_rename ( psz_idxTmp, p_sys->psz_indexPath);
+        /* The ongoing segment is only listed by its parts */
+        if( segment->psz_duration )
+            vlc_memstream_printf( &ms, "#EXTINF:%s,\n%s\n", segment->psz_duration, segment->psz_uri);
+    }
+    free( psz_current_uri );
 
-        if ( val < 0 )
-        {
-            vlc_unlink( psz_idxTmp );
-            msg_Err( p_access, "Error moving LiveHttp index file" );
-        }
-        else
-            msg_Dbg( p_access, "LiveHttpIndexComplete: %s" , p_sys->psz_indexPath );
+    if ( b_isend )
+        vlc_memstream_puts( &ms, STR_ENDLIST );
+
+    if( vlc_memstream_close( &ms ) )
+        return -1;
+
+    if( p_sys->p_httpd_host )
+    {
+        vlc_mutex_lock( &p_sys->lock );
+        free( p_sys->psz_index );
+        p_sys->psz_index = ms.ptr;
+        p_sys->i_index = ms.length;
+        vlc_mutex_unlock( &p_sys->lock );
+        return 0;
+    }
 
+    int val;
+    FILE *fp;
+    char *psz_idxTmp;
+    if ( asprintf( &psz_idxTmp, "%s.tmp", p_sys->psz_indexPath ) < 0)
+    {
+        free( ms.ptr );
+        return -1;
+    }
+
+    fp = vlc_fopen( psz_idxTmp, "wt");
+    if ( !fp )
+    {
+        msg_Err( p_access, "cannot open index file `%s'", psz_idxTmp );
+        free( psz_idxTmp );
+        free( ms.ptr );
+        return -1;
+    }
+
+    val = fwrite( ms.ptr, 1, ms.length, fp ) == ms.length ? 0 : -1;
+    free( ms.ptr );
+    if ( fclose( fp ) || val < 0 )
+    {
+        vlc_unlink( psz_idxTmp );
         free( psz_idxTmp );
+        return -1;
+    }
+
+    val = vlc_rename ( psz_idxTmp, p_sys->psz_indexPath);
+
+    if ( val < 0 )
+    {
+        vlc_unlink( psz_idxTmp );
+        msg_Err( p_access, "Error moving LiveHttp index file" );
+    }
+    else
+        msg_Dbg( p_access, "LiveHttpIndexComplete: %s" , p_sys->psz_indexPath );
+
+    free( psz_idxTmp );
+    return 0;
+}
+
+/************************************************************************
+ * updateIndexAndDel: If necessary, update index file & delete old segments
+ ************************************************************************/
+static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys, bool b_isend )
+{
+
+    uint32_t i_firstseg;
+    unsigned i_index_offset = 0;
+
+    if ( p_sys->i_numsegs == 0 ||
+         p_sys->i_segment < ( p_sys->i_numsegs + p_sys->i_initial_segment ) )
+    {
+        i_firstseg = p_sys->i_initial_segment;
+    }
+    else
+    {
+        unsigned numsegs = segmentAmountNeeded( p_sys );
+        i_firstseg = ( p_sys->i_segment - numsegs ) + 1;
+        i_index_offset = vlc_array_count( &p_sys->segments_t ) - numsegs;
     }
 
+    // First update index
+    if ( p_sys->psz_indexPath &&
+         writeIndex( p_access, p_sys, i_firstseg, i_index_offset, b_isend ) < 0 )
+        return -1;
     // Then take care of deletion
     // Try to follow pantos draft 11 section 6.2.2
     while( p_sys->b_delsegs && p_sys->i_numsegs &&
@@ -692,7 +890,7 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
          msg_Dbg( p_access, "Removing segment number %d", segment->i_segment_number );
          vlc_array_remove( &p_sys->segments_t, 0 );
 
-         if ( segment->psz_filename )
+         if ( segment->psz_filename && !p_sys->p_httpd_host )
          {
              vlc_unlink( segment->psz_filename );
          }
@@ -701,18 +899,93 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
          i_index_offset -=1;
     }
 
+    /* Kept to list the parts of the next segment */
+    p_sys->i_index_first = i_firstseg;
+    p_sys->i_index_offset = i_index_offset;
+
+    return 0;
+}
+
+static output_segment_t *currentSegment( sout_access_out_sys_t *p_sys )
+{
+    return vlc_array_item_at_index( &p_sys->segments_t, vlc_array_count( &p_sys->segments_t ) - 1 );
+}
+
+/*****************************************************************************
+ * storeSegmentData: Queue data of the in memory segment
+ *****************************************************************************/
+static void storeSegmentData( output_segment_t *segment, block_t *p_data )
+{
+    block_ChainLastAppend( &segment->pp_pending_last, p_data );
+}
+
+/*****************************************************************************
+ * publishPart: Make the queued data of the segment available over HTTP
+ *****************************************************************************/
+static int publishPart( sout_access_out_sys_t *p_sys, output_segment_t *segment,
+                        mtime_t i_length, bool b_independent )
+{
+    if( !segment->p_pending )
+        return 0;
+
+    /* Gathered, so that each request is a single copy from the part */
+    block_t *p_data = block_ChainGather( segment->p_pending );
+    if( unlikely( !p_data ) )
+        return -1;
+    segment->p_pending = NULL;
+    segment->pp_pending_last = &segment->p_pending;
 
+    vlc_mutex_lock( &p_sys->lock );
+    output_part_t *p_parts = realloc( segment->p_parts,
+                                      ( segment->i_parts + 1 ) * sizeof( *p_parts ) );
+    if( unlikely( !p_parts ) )
+    {
+        vlc_mutex_unlock( &p_sys->lock );
+        block_Release( p_data );
+        return -1;
+    }
+    p_parts[segment->i_parts].p_data = p_data;
+    p_parts[segment->i_parts].i_length = i_length;
+    p_parts[segment->i_parts].b_independent = b_independent;
+    segment->p_parts = p_parts;
+    segment->i_parts++;
+    vlc_mutex_unlock( &p_sys->lock );
     return 0;
 }
 
+/*****************************************************************************
+ * closePart: Publish the ongoing partial segment, ending at i_dts
+ *****************************************************************************/
+static void closePart( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys,
+                       mtime_t i_dts )
+{
+    output_segment_t *segment = currentSegment( p_sys );
+
+    if( !segment->p_pending )
+        return;
+
+    if( publishPart( p_sys, segment, i_dts - p_sys->i_partdts,
+                     p_sys->b_part_independent ) )
+    {
+        msg_Err( p_access, "Couldn't store part of segment %"PRIu32,
+                 p_sys->i_segment );
+        return;
+    }
+    p_sys->i_partdts = i_dts;
+
+    if( p_sys->psz_indexPath )
+        writeIndex( p_access, p_sys, p_sys->i_index_first,
+                    p_sys->i_index_offset, false );
+}
+
 /*****************************************************************************
  * closeCurrentSegment: Close the segment file
  *****************************************************************************/
 static void closeCurrentSegment( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys, bool b_isend )
 {
-    if ( p_sys->i_handle >= 0 )
+    if ( p_sys->b_segment_open )
     {
-        output_segment_t *segment = vlc_array_item_at_index( &p_sys->segments_t, vlc_array_count( &p_sys->segments_t ) - 1 );
+        output_segment_t *segment = currentSegment( p_sys );
 
         if( p_sys->key_uri )
         {
@@ -722,6 +995,16 @@ static void closeCurrentSegment( sout_access_out_t *p_access, sout_access_out_sy
 
             if( err ) {
                msg_Err( p_access, "Couldn't encrypt 16 bytes: %s", gpg_strerror(err) );
+            } else if( p_sys->p_httpd_host ) {
+
+            block_t *p_stuffing = block_Alloc( 16 );
+            if( likely( p_stuffing ) )
+            {
+                memcpy( p_stuffing->p_buffer, p_sys->stuffing_bytes, 16 );
+                storeSegmentData( segment, p_stuffing );
+            }
+            else
+                msg_Err( p_access, "Couldn't write 16 bytes" );
             } else {
 
             int ret = vlc_write( p_sys->i_handle, p_sys->stuffing_bytes, 16 );
@@ -732,8 +1015,12 @@ static void closeCurrentSegment( sout_access_out_t *p_access, sout_access_out_sy
         }
 
 
-        vlc_close( p_sys->i_handle );
-        p_sys->i_handle = -1;
+        if( p_sys->i_handle >= 0 )
+        {
+            vlc_close( p_sys->i_handle );
+            p_sys->i_handle = -1;
+        }
+        p_sys->b_segment_open = false;
 
         if( ! ( us_asprintf( &segment->psz_duration, "%.2f", p_sys->f_seglen ) ) )
         {
@@ -744,6 +1031,16 @@ static void closeCurrentSegment( sout_access_out_t *p_access, sout_access_out_sy
 
         segment->i_segment_number = p_sys->i_segment;
 
+        if( p_sys->p_httpd_host )
+        {
+            /* Without partial segments, this is the whole segment */
+            if( publishPart( p_sys, segment, p_sys->f_seglen * CLOCK_FREQ, true ) )
+                msg_Err( p_access, "Couldn't store segment %"PRIu32, p_sys->i_segment );
+            vlc_mutex_lock( &p_sys->lock );
+            segment->b_complete = true;
+            vlc_mutex_unlock( &p_sys->lock );
+        }
+
         if ( p_sys->psz_cursegPath )
         {
             msg_Dbg( p_access, "LiveHttpSegmentComplete: %s (%"PRIu32")" , p_sys->psz_cursegPath, p_sys->i_segment );
@@ -786,6 +1083,12 @@ static void Close( vlc_object_t * p_this )
         p_sys->ongoing_segment_end = &p_sys->ongoing_segment;
     }
 
+    if( p_sys->i_partlen > 0 && p_sys->b_segment_open )
+    {
+        closePart( p_access, p_sys, p_sys->i_lastdts );
+        p_sys->f_seglen = (float)( p_sys->i_lastdts - p_sys->i_opendts ) / CLOCK_FREQ;
+    }
+
     ssize_t writevalue = writeSegment( p_access );
     msg_Dbg( p_access, "Writing.. %zd", writevalue );
     if( unlikely( writevalue < 0 ) )
@@ -808,7 +1111,8 @@ static void Close( vlc_object_t * p_this )
     {
         output_segment_t *segment = vlc_array_item_at_index( &p_sys->segments_t, 0 );
         vlc_array_remove( &p_sys->segments_t, 0 );
-        if( p_sys->b_delsegs && p_sys->i_numsegs && segment->psz_filename )
+        if( p_sys->b_delsegs && p_sys->i_numsegs && segment->psz_filename &&
+            !p_sys->p_httpd_host )
         {
             msg_Dbg( p_access, "Removing segment number %d name %s", segment->i_segment_number, segment->psz_filename );
             vlc_unlink( segment->psz_filename );
@@ -817,6 +1121,20 @@ static void Close( vlc_object_t * p_this )
         destroySegment( segment );
     }
 
+    if( p_sys->p_httpd_host )
+    {
+        if( p_sys->p_init_file )
+            httpd_FileDelete( p_sys->p_init_file );
+        httpd_FileDelete( p_sys->p_index_file );
+        httpd_HostDelete( p_sys->p_httpd_host );
+    }
+    free( p_sys->psz_index );
+    if( p_sys->p_init )
+        block_Release( p_sys->p_init );
+    free( p_sys->psz_init_filename );
+    free( p_sys->psz_init_uri );
+    vlc_mutex_destroy( &p_sys->lock );
+
     free( p_sys->psz_indexUrl );
     free( p_sys->psz_indexPath );
     free( p_sys );
@@ -844,12 +1162,119 @@ static int Control( sout_access_out_t *p_access, int i_query, va_list args )
     return VLC_SUCCESS;
 }
 
+/*****************************************************************************
+ * HTTP server callbacks, run by the HTTP server thread
+ *****************************************************************************/
+static int IndexFill( httpd_file_sys_t *p_filesys, httpd_file_t *p_file,
+                      uint8_t *psz_request, uint8_t **pp_data, int *pi_data )
+{
+    sout_access_out_t *p_access = (sout_access_out_t *)p_filesys;
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    VLC_UNUSED(p_file); VLC_UNUSED(psz_request);
+
+    *pp_data = NULL;
+    *pi_data = 0;
+
+    vlc_mutex_lock( &p_sys->lock );
+    if( p_sys->psz_index && ( *pp_data = malloc( p_sys->i_index ) ) )
+    {
+        memcpy( *pp_data, p_sys->psz_index, p_sys->i_index );
+        *pi_data = p_sys->i_index;
+    }
+    vlc_mutex_unlock( &p_sys->lock );
+    return VLC_SUCCESS;
+}
+
+static int InitFill( httpd_file_sys_t *p_filesys, httpd_file_t *p_file,
+                     uint8_t *psz_request, uint8_t **pp_data, int *pi_data )
+{
+    sout_access_out_t *p_access = (sout_access_out_t *)p_filesys;
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    VLC_UNUSED(p_file); VLC_UNUSED(psz_request);
+
+    *pp_data = NULL;
+    *pi_data = 0;
+
+    vlc_mutex_lock( &p_sys->lock );
+    if( p_sys->p_init && ( *pp_data = malloc( p_sys->p_init->i_buffer ) ) )
+    {
+        memcpy( *pp_data, p_sys->p_init->p_buffer, p_sys->p_init->i_buffer );
+        *pi_data = p_sys->p_init->i_buffer;
+    }
+    vlc_mutex_unlock( &p_sys->lock );
+    return VLC_SUCCESS;
+}
+
+/* Serves the whole segment once it is complete, or one of its parts with
+ * a "part=<n>" query, as soon as that part is */
+static int SegmentFill( void *opaque, httpd_handler_t *p_handler, char *psz_url,
+                        uint8_t *psz_request, int i_type,
+                        uint8_t *p_in, int i_in,
+                        char *psz_remote_addr, char *psz_remote_host,
+                        uint8_t **pp_data, int *pi_data )
+{
+    output_segment_t *segment = opaque;
+    sout_access_out_sys_t *p_sys = segment->p_sys;
+    const char *psz_part = psz_request ? strstr( (char *)psz_request, "part=" ) : NULL;
+    unsigned i_first = 0, i_count = 0;
+    size_t i_size = 0;
+    VLC_UNUSED(p_handler); VLC_UNUSED(psz_url); VLC_UNUSED(i_type);
+    VLC_UNUSED(p_in); VLC_UNUSED(i_in);
+    VLC_UNUSED(psz_remote_addr); VLC_UNUSED(psz_remote_host);
+
+    vlc_mutex_lock( &p_sys->lock );
+    if( psz_part )
+    {
+        if( sscanf( psz_part, "part=%u", &i_first ) == 1 &&
+            i_first < segment->i_parts )
+            i_count = 1;
+    }
+    else if( segment->b_complete )
+        i_count = segment->i_parts;
+
+    for( unsigned i = i_first; i < i_first + i_count; i++ )
+        i_size += segment->p_parts[i].p_data->i_buffer;
+
+    char *psz_header;
+    int i_header;
+    if( i_count > 0 )
+        i_header = asprintf( &psz_header, "Status: 200\r\nContent-Type: %s\r\n"
+                             "Content-Length: %zu\r\n\r\n",
+                             p_sys->p_init ? "video/mp4" : "video/mp2t", i_size );
+    else
+        i_header = asprintf( &psz_header, "Status: 404\r\n"
+                             "Content-Length: 0\r\n\r\n" );
+
+    *pp_data = NULL;
+    *pi_data = 0;
+    if( i_header >= 0 )
+    {
+        uint8_t *p_data = realloc( psz_header, i_header + i_size );
+        if( likely( p_data ) )
+        {
+            *pp_data = p_data;
+            *pi_data = i_header + i_size;
+            p_data += i_header;
+            for( unsigned i = i_first; i < i_first + i_count; i++ )
+            {
+                const block_t *p_block = segment->p_parts[i].p_data;
+                memcpy( p_data, p_block->p_buffer, p_block->i_buffer );
+                p_data += p_block->i_buffer;
+            }
+        }
+        else
+            free( psz_header );
+    }
+    vlc_mutex_unlock( &p_sys->lock );
+    return VLC_SUCCESS;
+}
+
 /*****************************************************************************
  * openNextFile: Open the segment file
  *****************************************************************************/
 static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys )
 {
-    int fd;
+    int fd = -1;
 
     uint32_t i_newseg = p_sys->i_segment + 1;
 
@@ -859,6 +1284,8 @@ static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t
         return -1;
 
     segment->i_segment_number = i_newseg;
+    segment->p_sys = p_sys;
+    segment->pp_pending_last = &segment->p_pending;
     segment->psz_filename = formatSegmentPath( p_access->psz_path, i_newseg );
     char *psz_idxFormat = p_sys->psz_indexUrl ? p_sys->psz_indexUrl : p_access->psz_path;
     segment->psz_uri = formatSegmentPath( psz_idxFormat , i_newseg );
@@ -870,14 +1297,30 @@ static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t
         return -1;
     }
 
-    fd = vlc_open( segment->psz_filename, O_WRONLY | O_CREAT | O_LARGEFILE |
-                     O_TRUNC, 0666 );
-    if ( fd == -1 )
+    if( p_sys->p_httpd_host )
     {
-        msg_Err( p_access, "cannot open `%s' (%s)", segment->psz_filename,
-                 vlc_strerror_c(errno) );
-        destroySegment( segment );
-        return -1;
+        segment->p_handler = httpd_HandlerNew( p_sys->p_httpd_host,
+                                               segment->psz_filename,
+                                               NULL, NULL, SegmentFill,
+                                               segment );
+        if( !segment->p_handler )
+        {
+            msg_Err( p_access, "cannot serve `%s'", segment->psz_filename );
+            destroySegment( segment );
+            return -1;
+        }
+    }
+    else
+    {
+        fd = vlc_open( segment->psz_filename, O_WRONLY | O_CREAT | O_LARGEFILE |
+                         O_TRUNC, 0666 );
+        if ( fd == -1 )
+        {
+            msg_Err( p_access, "cannot open `%s' (%s)", segment->psz_filename,
+                     vlc_strerror_c(errno) );
+            destroySegment( segment );
+            return -1;
+        }
     }
 
     vlc_array_append_or_abort( &p_sys->segments_t, segment );
@@ -900,7 +1343,8 @@ static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t
     p_sys->i_handle = fd;
     p_sys->i_segment = i_newseg;
     p_sys->b_segment_has_data = false;
-    return fd;
+    p_sys->b_segment_open = true;
+    return p_sys->p_httpd_host ? 0 : fd;
 }
 /*****************************************************************************
  * CheckSegmentChange: Check if segment needs to be closed and new opened
@@ -910,7 +1354,8 @@ static int CheckSegmentChange( sout_access_out_t *p_access, block_t *p_buffer )
     sout_access_out_sys_t *p_sys = p_access->p_sys;
     ssize_t writevalue = 0;
 
-    if( p_sys->i_handle > 0 && p_sys->b_segment_has_data &&
+    if( p_sys->b_segment_open && p_sys->b_segment_has_data &&
+        p_buffer->i_dts > VLC_TS_INVALID &&
        (( p_buffer->i_length + p_buffer->i_dts - p_sys->i_opendts ) >= p_sys->i_seglenm ) )
     {
         writevalue = writeSegment( p_access );
@@ -923,14 +1368,17 @@ static int CheckSegmentChange( sout_access_out_t *p_access, block_t *p_buffer )
         return writevalue;
     }
 
-    if ( unlikely( p_sys->i_handle < 0 ) )
+    if ( unlikely( !p_sys->b_segment_open ) )
     {
+        /* Muxers do not date all their blocks, such as the mp4 mdat headers */
         p_sys->i_opendts = p_buffer->i_dts;
 
-        if( p_sys->ongoing_segment && ( p_sys->ongoing_segment->i_dts < p_sys->i_opendts) )
+        if( p_sys->ongoing_segment && p_sys->ongoing_segment->i_dts > VLC_TS_INVALID &&
+            ( p_sys->i_opendts <= VLC_TS_INVALID || p_sys->ongoing_segment->i_dts < p_sys->i_opendts) )
             p_sys->i_opendts = p_sys->ongoing_segment->i_dts;
 
-        if( p_sys->full_segments && ( p_sys->full_segments->i_dts < p_sys->i_opendts) )
+        if( p_sys->full_segments && p_sys->full_segments->i_dts > VLC_TS_INVALID &&
+            ( p_sys->i_opendts <= VLC_TS_INVALID || p_sys->full_segments->i_dts < p_sys->i_opendts) )
             p_sys->i_opendts = p_sys->full_segments->i_dts;
 
         msg_Dbg( p_access, "Setting new opendts %"PRId64, p_sys->i_opendts );
@@ -946,6 +1394,9 @@ static ssize_t writeSegment( sout_access_out_t *p_access )
     sout_access_out_sys_t *p_sys = p_access->p_sys;
     msg_Dbg( p_access, "Writing all full segments" );
 
+    if( p_sys->p_httpd_host && !p_sys->b_segment_open )
+        return -1;
+
     block_t *output = p_sys->full_segments;
     mtime_t output_last_length = 0;
     if( output )
@@ -990,6 +1441,22 @@ static ssize_t writeSegment( sout_access_out_t *p_access )
 
         }
 
+        if( output->i_dts > VLC_TS_INVALID )
+            p_sys->f_seglen =
+                (float)(output_last_length +
+                        output->i_dts - p_sys->i_opendts) / CLOCK_FREQ;
+
+        if( p_sys->p_httpd_host )
+        {
+            block_t *p_next = output->p_next;
+            output->p_next = NULL;
+            i_write += output->i_buffer;
+            storeSegmentData( currentSegment( p_sys ), output );
+            output = p_next;
+            crypted=false;
+            continue;
+        }
+
         ssize_t val = vlc_write( p_sys->i_handle, output->p_buffer, output->i_buffer );
         if ( val == -1 )
         {
@@ -998,10 +1465,6 @@ static ssize_t writeSegment( sout_access_out_t *p_access )
            return -1;
         }
 
-        p_sys->f_seglen =
-            (float)(output_last_length +
-                    output->i_dts - p_sys->i_opendts) / CLOCK_FREQ;
-
         if ( (size_t)val >= output->i_buffer )
         {
            block_t *p_next = output->p_next;
@@ -1019,6 +1482,156 @@ static ssize_t writeSegment( sout_access_out_t *p_access )
     return i_write;
 }
 
+/*****************************************************************************
+ * isInitSegment: Check for the fMP4 header of the mp4 fragmented muxer
+ *****************************************************************************/
+static bool isInitSegment( const block_t *p_buffer )
+{
+    return ( p_buffer->i_flags & BLOCK_FLAG_HEADER ) &&
+           p_buffer->i_buffer >= 8 && !memcmp( &p_buffer->p_buffer[4], "ftyp", 4 );
+}
+
+/*****************************************************************************
+ * isSplitPoint: Check if a segment can start with the block
+ *****************************************************************************/
+static bool isSplitPoint( sout_access_out_sys_t *p_sys, const block_t *p_buffer )
+{
+    /* fMP4 segments start with a moof, flagged as intra by the muxer */
+    if( p_sys->p_init )
+        return p_sys->b_splitanywhere || ( p_buffer->i_flags & BLOCK_FLAG_TYPE_I );
+    return p_sys->b_splitanywhere || ( p_buffer->i_flags & BLOCK_FLAG_HEADER );
+}
+
+/*****************************************************************************
+ * updateInitSegment: Store, then write or serve, the initialization segment
+ *****************************************************************************/
+static int updateInitSegment( sout_access_out_t *p_access, block_t *p_buffer )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    if( !p_sys->psz_init_uri )
+    {
+        char *psz_idxFormat = p_sys->psz_indexUrl ? p_sys->psz_indexUrl : p_access->psz_path;
+        p_sys->psz_init_filename = formatInitPath( p_access->psz_path );
+        p_sys->psz_init_uri = formatInitPath( psz_idxFormat );
+        if( unlikely( !p_sys->psz_init_filename || !p_sys->psz_init_uri ) )
+        {
+            FREENULL( p_sys->psz_init_filename );
+            FREENULL( p_sys->psz_init_uri );
+            block_Release( p_buffer );
+            return -1;
+        }
+    }
+
+    vlc_mutex_lock( &p_sys->lock );
+    if( p_sys->p_init )
+        block_Release( p_sys->p_init );
+    p_sys->p_init = p_buffer;
+    vlc_mutex_unlock( &p_sys->lock );
+
+    if( p_sys->p_httpd_host )
+    {
+        if( !p_sys->p_init_file )
+            p_sys->p_init_file = httpd_FileNew( p_sys->p_httpd_host,
+                                                p_sys->psz_init_filename,
+                                                "video/mp4", NULL, NULL, InitFill,
+                                                (httpd_file_sys_t *)p_access );
+        if( !p_sys->p_init_file )
+        {
+            msg_Err( p_access, "cannot serve `%s'", p_sys->psz_init_filename );
+            return -1;
+        }
+        return 0;
+    }
+
+    int fd = vlc_open( p_sys->psz_init_filename, O_WRONLY | O_CREAT | O_LARGEFILE |
+                       O_TRUNC, 0666 );
+    if ( fd == -1 )
+    {
+        msg_Err( p_access, "cannot open `%s' (%s)", p_sys->psz_init_filename,
+                 vlc_strerror_c(errno) );
+        return -1;
+    }
+
+    ssize_t val = vlc_write( fd, p_buffer->p_buffer, p_buffer->i_buffer );
+    vlc_close( fd );
+    if( val < 0 || (size_t)val < p_buffer->i_buffer )
+    {
+        msg_Err( p_access, "cannot write `%s'", p_sys->psz_init_filename );
+        return -1;
+    }
+    return 0;
+}
+
+/*****************************************************************************
+ * WriteParts: write with partial segments, straight to the in memory segment
+ *****************************************************************************/
+static ssize_t WriteParts( sout_access_out_t *p_access, block_t *p_buffer )
+{
+    size_t i_write = 0;
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    while( p_buffer )
+    {
+        block_t *p_temp = p_buffer->p_next;
+        p_buffer->p_next = NULL;
+
+        if( isInitSegment( p_buffer ) )
+        {
+            if( updateInitSegment( p_access, p_buffer ) )
+                msg_Err( p_access, "Error in write loop");
+            p_buffer = p_temp;
+            continue;
+        }
+
+        /* Segments are only ever cut at split points, so that the data can
+            be published as parts before the segment is complete */
+        if( p_sys->b_segment_open && p_buffer->i_dts > VLC_TS_INVALID )
+        {
+            if( p_sys->b_segment_has_data && isSplitPoint( p_sys, p_buffer ) &&
+                p_buffer->i_dts - p_sys->i_opendts >= p_sys->i_seglenm )
+            {
+                closePart( p_access, p_sys, p_buffer->i_dts );
+                p_sys->f_seglen = (float)( p_buffer->i_dts - p_sys->i_opendts ) / CLOCK_FREQ;
+                closeCurrentSegment( p_access, p_sys, false );
+            }
+            else if( ( !p_sys->p_init || ( p_buffer->i_flags & BLOCK_FLAG_TYPE_I ) ) &&
+                     p_buffer->i_dts - p_sys->i_partdts >= p_sys->i_partlen )
+                closePart( p_access, p_sys, p_buffer->i_dts );
+        }
+
+        if( !p_sys->b_segment_open )
+        {
+            if( openNextFile( p_access, p_sys ) < 0 )
+            {
+                msg_Err( p_access, "Error in write loop");
+                block_Release( p_buffer );
+                block_ChainRelease( p_temp );
+                return -1;
+            }
+            p_sys->i_opendts = p_buffer->i_dts;
+            p_sys->i_partdts = p_buffer->i_dts;
+            p_sys->b_part_independent = true;
+        }
+        else if( !currentSegment( p_sys )->p_pending )
+            p_sys->b_part_independent = ( p_buffer->i_flags & BLOCK_FLAG_HEADER ) != 0;
+
+        if( p_buffer->i_dts > VLC_TS_INVALID )
+        {
+            if( p_sys->i_opendts <= VLC_TS_INVALID )
+                p_sys->i_opendts = p_sys->i_partdts = p_buffer->i_dts;
+            if( p_buffer->i_dts + p_buffer->i_length > p_sys->i_lastdts )
+                p_sys->i_lastdts = p_buffer->i_dts + p_buffer->i_length;
+        }
+
+        i_write += p_buffer->i_buffer;
+        storeSegmentData( currentSegment( p_sys ), p_buffer );
+        p_sys->b_segment_has_data = true;
+        p_buffer = p_temp;
+    }
+
+    return i_write;
+}
+
 /*****************************************************************************
  * Write: standard write on a file descriptor.
  *****************************************************************************/
@@ -1026,12 +1639,26 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
 {
     size_t i_write = 0;
     sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    if( p_sys->i_partlen > 0 )
+        return WriteParts( p_access, p_buffer );
+
     while( p_buffer )
     {
+        if( isInitSegment( p_buffer ) )
+        {
+            block_t *p_temp = p_buffer->p_next;
+            p_buffer->p_next = NULL;
+            if( updateInitSegment( p_access, p_buffer ) )
+                msg_Err( p_access, "Error in write loop");
+            p_buffer = p_temp;
+            continue;
+        }
+
         /* Check if current block is already past segment-length
             and we want to write gathered blocks into segment
             and update playlist */
-        if( p_sys->ongoing_segment && ( p_sys->b_splitanywhere  || ( p_buffer->i_flags & BLOCK_FLAG_HEADER ) ) )
+        if( p_sys->ongoing_segment && isSplitPoint( p_sys, p_buffer ) )
         {
             msg_Dbg( p_access, "Moving ongoing segment to full segments-queue" );
             block_ChainLastAppend( &p_sys->full_segments_end, p_sys->ongoing_segment );
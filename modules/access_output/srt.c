@@ -47,6 +47,11 @@
 /* The default latency is 125
  * which uses srt library internally */
 #define SRT_DEFAULT_LATENCY 125
+/* The default bandwidth overhead for the retransmissions is 25%,
+ * as libsrt does */
+#define SRT_DEFAULT_BANDWIDTH_OVERHEAD 25
+/* The link statistics are logged every 5 seconds */
+#define SRT_DEFAULT_STATS_PERIOD 5000
 
 struct sout_access_out_sys_t
 {
@@ -56,6 +61,13 @@ struct sout_access_out_sys_t
     int           i_latency;
     size_t        i_chunk_size;
     int           i_event_fd;
+
+    /* Data waiting for a full chunk */
+    uint8_t      *p_chunk;
+    size_t        i_chunk;
+
+    mtime_t       i_stats_period;
+    mtime_t       i_stats_next;
 };
 
 static void srt_wait_interrupted(void *p_data)
@@ -69,6 +81,66 @@ static void srt_wait_interrupted(void *p_data)
     }
 }
 
+static int SendChunk( sout_access_out_t *p_access, const uint8_t *p_data,
+                      size_t i_data )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    SRTSOCKET ready[2];
+    struct epoll_event event[1] = { 0 };
+
+retry:
+    if ( srt_epoll_wait( p_sys->i_poll_id,
+        0, 0, ready, &(int){ 2 }, p_sys->i_poll_timeout,
+        &(int) { p_sys->i_event_fd }, &(int) { 1 }, 0, 0 ) == -1 )
+    {
+        /* Assuming that timeout error is normal when SRT socket is connected. */
+        if ( srt_getlasterror( NULL ) == SRT_ETIMEOUT &&
+             srt_getsockstate( p_sys->sock ) == SRTS_CONNECTED )
+        {
+            srt_clearlasterror();
+            goto retry;
+        }
+
+        return VLC_EGENERIC;
+    }
+
+    if ( event[0].events & EPOLLIN )
+    {
+        bool cancel = 0;
+        int ret = read( event[0].data.fd, &cancel, sizeof( bool ) );
+        if ( ret < 0 )
+        {
+            goto retry;
+        }
+
+        if ( cancel )
+        {
+            msg_Dbg( p_access, "Cancelled running" );
+            return VLC_EGENERIC;
+        }
+    }
+
+    if ( srt_sendmsg2( p_sys->sock, (char *)p_data, i_data, 0 ) == SRT_ERROR )
+        msg_Warn( p_access, "send error: %s", srt_getlasterror_str() );
+
+    return VLC_SUCCESS;
+}
+
+static void LogStats( sout_access_out_t *p_access )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    SRT_TRACEBSTATS stats;
+
+    if ( srt_bstats( p_sys->sock, &stats, 0 ) == SRT_ERROR )
+        return;
+
+    msg_Dbg( p_access, "link: rtt %.1f ms, bandwidth %.2f Mb/s, "
+             "rate %.2f Mb/s, %"PRId64" packets sent, %d retransmitted, "
+             "%d lost, %d dropped", stats.msRTT, stats.mbpsBandwidth,
+             stats.mbpsSendRate, stats.pktSentTotal, stats.pktRetransTotal,
+             stats.pktSndLossTotal, stats.pktSndDropTotal );
+}
+
 static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
 {
     sout_access_out_sys_t *p_sys = p_access->p_sys;
@@ -82,51 +154,42 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
 
         i_len += p_buffer->i_buffer;
 
+        /* Fill the messages up to the chunk size, across the blocks */
         while( p_buffer->i_buffer )
         {
-            size_t i_write = __MIN( p_buffer->i_buffer, p_sys->i_chunk_size );
-            SRTSOCKET ready[2];
-
-            struct epoll_event event[1] = { 0 };
-retry:
-            if ( srt_epoll_wait( p_sys->i_poll_id,
-                0, 0, ready, &(int){ 2 }, p_sys->i_poll_timeout,
-                &(int) { p_sys->i_event_fd }, &(int) { 1 }, 0, 0 ) == -1 )
+            if ( p_sys->i_chunk == 0 &&
+                 p_buffer->i_buffer >= p_sys->i_chunk_size )
             {
-                /* Assuming that timeout error is normal when SRT socket is connected. */
-                if ( srt_getlasterror( NULL ) == SRT_ETIMEOUT &&
-                     srt_getsockstate( p_sys->sock ) == SRTS_CONNECTED )
+                /* Full chunk in the block, sent as is */
+                if ( SendChunk( p_access, p_buffer->p_buffer,
+                                p_sys->i_chunk_size ) )
                 {
-                    srt_clearlasterror();
-                    goto retry;
+                    i_len = VLC_EGENERIC;
+                    goto out;
                 }
-
-                i_len = VLC_EGENERIC;
-                goto out;
+                p_buffer->p_buffer += p_sys->i_chunk_size;
+                p_buffer->i_buffer -= p_sys->i_chunk_size;
+                continue;
             }
 
-            if ( event[0].events & EPOLLIN )
-            {
-                bool cancel = 0;
-                int ret = read( event[0].data.fd, &cancel, sizeof( bool ) );
-                if ( ret < 0 )
-                {
-                    goto retry;
-                }
+            size_t i_copy = __MIN( p_buffer->i_buffer,
+                                   p_sys->i_chunk_size - p_sys->i_chunk );
+            memcpy( &p_sys->p_chunk[p_sys->i_chunk], p_buffer->p_buffer,
+                    i_copy );
+            p_sys->i_chunk += i_copy;
+            p_buffer->p_buffer += i_copy;
+            p_buffer->i_buffer -= i_copy;
 
-                if ( cancel )
+            if ( p_sys->i_chunk == p_sys->i_chunk_size )
+            {
+                p_sys->i_chunk = 0;
+                if ( SendChunk( p_access, p_sys->p_chunk,
+                                p_sys->i_chunk_size ) )
                 {
-                    msg_Dbg( p_access, "Cancelled running" );
-                    i_len = 0;
+                    i_len = VLC_EGENERIC;
                     goto out;
                 }
             }
-
-            if ( srt_sendmsg2( p_sys->sock, (char *)p_buffer->p_buffer, i_write, 0 ) == SRT_ERROR )
-                msg_Warn( p_access, "send error: %s", srt_getlasterror_str() );
-
-            p_buffer->p_buffer += i_write;
-            p_buffer->i_buffer -= i_write;
         }
 
         p_next = p_buffer->p_next;
@@ -134,6 +197,12 @@ retry:
         p_buffer = p_next;
     }
 
+    if ( p_sys->i_stats_period > 0 && mdate() >= p_sys->i_stats_next )
+    {
+        LogStats( p_access );
+        p_sys->i_stats_next = mdate() + p_sys->i_stats_period;
+    }
+
 out:
     vlc_interrupt_unregister();
     if ( i_len <= 0 ) block_ChainRelease( p_buffer );
@@ -185,6 +254,18 @@ static int Open( vlc_object_t *p_this )
         return VLC_ENOMEM;
 
     p_sys->i_chunk_size = var_InheritInteger( p_access, "chunk-size" );
+    if ( p_sys->i_chunk_size == 0 )
+        p_sys->i_chunk_size = SRT_DEFAULT_CHUNK_SIZE;
+    p_sys->p_chunk = malloc( p_sys->i_chunk_size );
+    if( unlikely( p_sys->p_chunk == NULL ) )
+    {
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+    p_sys->i_chunk = 0;
+    p_sys->i_stats_period = INT64_C(1000)
+        * var_InheritInteger( p_access, "stats-period" );
+    p_sys->i_stats_next = mdate() + p_sys->i_stats_period;
     p_sys->i_poll_timeout = var_InheritInteger( p_access, "poll-timeout" );
     p_sys->i_latency = var_InheritInteger( p_access, "latency" );
     p_sys->i_poll_id = -1;
@@ -196,6 +277,7 @@ static int Open( vlc_object_t *p_this )
     char *psz_parser = psz_dst_addr = strdup( p_access->psz_path );
     if( !psz_dst_addr )
     {
+        free( p_sys->p_chunk );
         free( p_sys );
         return VLC_ENOMEM;
     }
@@ -243,6 +325,11 @@ static int Open( vlc_object_t *p_this )
     /* Set latency */
     srt_setsockopt( p_sys->sock, 0, SRTO_TSBPDDELAY, &p_sys->i_latency, sizeof( int ) );
 
+    /* Set the bandwidth left for the retransmissions */
+    srt_setsockopt( p_sys->sock, 0, SRTO_OHEADBW,
+                    &(int) { var_InheritInteger( p_access, "bandwidth-overhead" ) },
+                    sizeof( int ) );
+
     p_sys->i_poll_id = srt_epoll_create();
     if ( p_sys->i_poll_id == -1 )
     {
@@ -287,6 +374,7 @@ failed:
         if ( p_sys->sock != -1 ) srt_close( p_sys->sock );
         if ( p_sys->i_event_fd != -1 ) close( p_sys->i_event_fd );
 
+        free( p_sys->p_chunk );
         free( p_sys );
     }
 
@@ -298,6 +386,12 @@ static void Close( vlc_object_t * p_this )
     sout_access_out_t     *p_access = (sout_access_out_t*)p_this;
     sout_access_out_sys_t *p_sys = p_access->p_sys;
 
+    /* Send the last partial chunk */
+    if ( p_sys->i_chunk > 0 &&
+         srt_sendmsg2( p_sys->sock, (char *)p_sys->p_chunk, p_sys->i_chunk,
+                       0 ) == SRT_ERROR )
+        msg_Warn( p_access, "send error: %s", srt_getlasterror_str() );
+
     srt_epoll_release( p_sys->i_poll_id );
     srt_close( p_sys->sock );
 
@@ -307,6 +401,7 @@ static void Close( vlc_object_t * p_this )
         p_sys->i_event_fd = -1;
     }
 
+    free( p_sys->p_chunk );
     free( p_sys );
 }
 
@@ -322,6 +417,13 @@ vlc_module_begin()
     add_integer( "poll-timeout", SRT_DEFAULT_POLL_TIMEOUT,
             N_("Return poll wait after timeout miliseconds (-1 = infinite)"), NULL, true )
     add_integer( "latency", SRT_DEFAULT_LATENCY, N_("SRT latency (ms)"), NULL, true )
+    add_integer_with_range( "bandwidth-overhead", SRT_DEFAULT_BANDWIDTH_OVERHEAD,
+            5, 100, N_("SRT bandwidth overhead (%)"),
+            N_("Bandwidth left for the retransmissions, in percent of the "
+               "input rate."), true )
+    add_integer( "stats-period", SRT_DEFAULT_STATS_PERIOD,
+            N_("SRT statistics period (ms)"),
+            N_("Period of the link statistics log (0 = disabled)."), true )
 
     set_capability( "sout access", 0 )
     add_shortcut( "srt" )
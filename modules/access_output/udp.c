@@ -46,11 +46,22 @@
 #else
 #   include <sys/socket.h>
 #endif
+#ifdef HAVE_SYS_UIO_H
+#   include <sys/uio.h>
+#endif
+#ifdef __linux__
+#   include <netinet/udp.h>
+#endif
 
 #include <vlc_network.h>
 
 #define MAX_EMPTY_BLOCKS 200
 
+/* Datagrams due within the pacing window are sent together, in one batch */
+#define UDP_BATCH 32
+#define PACING_WINDOW (CLOCK_FREQ / 1000)
+#define STATS_PERIOD (10 * CLOCK_FREQ)
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -114,6 +125,7 @@ struct sout_access_out_sys_t
     mtime_t       i_caching;
     int           i_handle;
     bool          b_mtu_warning;
+    bool          b_gso;
     size_t        i_mtu;
 
     block_fifo_t *p_fifo;
@@ -209,6 +221,7 @@ static int Open( vlc_object_t *p_this )
     p_sys->i_handle = i_handle;
     p_sys->i_mtu = var_CreateGetInteger( p_this, "mtu" );
     p_sys->b_mtu_warning = false;
+    p_sys->b_gso = true;
     p_sys->p_fifo = block_FifoNew();
     p_sys->p_empty_blocks = block_FifoNew();
     p_sys->p_buffer = NULL;
@@ -380,6 +393,149 @@ static block_t *NewUDPPacket( sout_access_out_t *p_access, mtime_t i_dts)
     return p_buffer;
 }
 
+typedef struct
+{
+    block_t *pkts[UDP_BATCH];
+    unsigned count;
+    block_t *next; /* dequeued but not due yet */
+} udp_batch_t;
+
+static void BatchCleanup( void *data )
+{
+    udp_batch_t *batch = data;
+
+    for( unsigned i = 0; i < batch->count; i++ )
+        block_Release( batch->pkts[i] );
+    if( batch->next != NULL )
+        block_Release( batch->next );
+}
+
+/* Pacing errors, i.e. the differences between the send and the due dates */
+typedef struct
+{
+    mtime_t  i_next_report;
+    unsigned i_batches;
+    unsigned i_datagrams;
+    mtime_t  i_total;
+    mtime_t  i_max;
+} pacing_stats_t;
+
+static void PacingUpdate( sout_access_out_t *p_access, pacing_stats_t *stats,
+                          const udp_batch_t *batch, mtime_t now )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    for( unsigned i = 0; i < batch->count; i++ )
+    {
+        mtime_t error = now - (batch->pkts[i]->i_dts + p_sys->i_caching);
+
+        if( error < 0 )
+            error = -error; /* sent early, within the pacing window */
+        stats->i_total += error;
+        if( error > stats->i_max )
+            stats->i_max = error;
+    }
+    stats->i_datagrams += batch->count;
+    stats->i_batches++;
+
+    if( now < stats->i_next_report )
+        return;
+    if( stats->i_next_report != 0 )
+        msg_Dbg( p_access, "pacing error: average %"PRId64" us, maximum "
+                 "%"PRId64" us, %u datagrams in %u batches",
+                 stats->i_total / stats->i_datagrams, stats->i_max,
+                 stats->i_datagrams, stats->i_batches );
+    *stats = (pacing_stats_t){ .i_next_report = now + STATS_PERIOD };
+}
+
+/*****************************************************************************
+ * SendBatch: send the datagrams with as few system calls as possible
+ *****************************************************************************/
+static void SendBatch( sout_access_out_t *p_access, const udp_batch_t *batch )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    struct iovec iovs[UDP_BATCH];
+
+    for( unsigned i = 0; i < batch->count; i++ )
+    {
+        iovs[i].iov_base = batch->pkts[i]->p_buffer;
+        iovs[i].iov_len = batch->pkts[i]->i_buffer;
+    }
+
+#ifdef UDP_SEGMENT
+    /* The kernel segments the payload in datagrams of the first one size,
+     * so only the last one may be shorter. */
+    size_t i_total = iovs[0].iov_len;
+    bool b_gso = p_sys->b_gso && batch->count > 1;
+
+    for( unsigned i = 1; b_gso && i < batch->count; i++ )
+    {
+        i_total += iovs[i].iov_len;
+        if( iovs[i - 1].iov_len != iovs[0].iov_len
+         || iovs[i].iov_len > iovs[0].iov_len || i_total > 65507 )
+            b_gso = false;
+    }
+
+    if( b_gso )
+    {
+        union
+        {
+            char buf[CMSG_SPACE(sizeof (uint16_t))];
+            struct cmsghdr align;
+        } control;
+        struct msghdr msg = {
+            .msg_iov = iovs,
+            .msg_iovlen = batch->count,
+            .msg_control = control.buf,
+            .msg_controllen = sizeof (control.buf),
+        };
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR( &msg );
+        uint16_t i_segment = iovs[0].iov_len;
+
+        cmsg->cmsg_level = IPPROTO_UDP;
+        cmsg->cmsg_type = UDP_SEGMENT;
+        cmsg->cmsg_len = CMSG_LEN(sizeof (i_segment));
+        memcpy( CMSG_DATA(cmsg), &i_segment, sizeof (i_segment) );
+
+        if( sendmsg( p_sys->i_handle, &msg, 0 ) != -1 )
+            return;
+        if( errno != EINVAL && errno != EIO && errno != ENOPROTOOPT )
+        {
+            msg_Warn( p_access, "send error: %s", vlc_strerror_c(errno) );
+            return;
+        }
+        msg_Dbg( p_access, "UDP segmentation offload not available" );
+        p_sys->b_gso = false;
+    }
+#endif
+
+#ifdef HAVE_SENDMMSG
+    struct mmsghdr msgs[UDP_BATCH];
+
+    for( unsigned i = 0; i < batch->count; i++ )
+        msgs[i].msg_hdr = (struct msghdr) {
+            .msg_iov = &iovs[i],
+            .msg_iovlen = 1,
+        };
+
+    for( unsigned i = 0; i < batch->count; )
+    {
+        int n = sendmmsg( p_sys->i_handle, msgs + i, batch->count - i, 0 );
+        if( n <= 0 )
+        {   /* Skip the failed datagram */
+            msg_Warn( p_access, "send error: %s", vlc_strerror_c(errno) );
+            n = 1;
+        }
+        i += n;
+    }
+#else
+    for( unsigned i = 0; i < batch->count; i++ )
+        if( send( p_sys->i_handle, iovs[i].iov_base, iovs[i].iov_len,
+                  0 ) == -1 )
+            msg_Warn( p_access, "send error: %s", vlc_strerror_c(errno) );
+#endif
+}
+
 /*****************************************************************************
  * ThreadWrite: Write a packet on the network at the good time.
  *****************************************************************************/
@@ -392,12 +548,18 @@ static void* ThreadWrite( void *data )
                                              SOUT_CFG_PREFIX "group" );
     mtime_t i_to_send = i_group;
     unsigned i_dropped_packets = 0;
+    pacing_stats_t stats = { .i_next_report = 0 };
+    udp_batch_t batch = { .next = NULL };
 
     for (;;)
     {
-        block_t *p_pk = block_FifoGet( p_sys->p_fifo );
+        block_t *p_pk = batch.next;
         mtime_t       i_date, i_sent;
 
+        if( p_pk == NULL )
+            p_pk = block_FifoGet( p_sys->p_fifo );
+        batch.next = NULL;
+
         i_date = p_sys->i_caching + p_pk->i_dts;
         if( i_date_last > 0 )
         {
@@ -421,15 +583,39 @@ static void* ThreadWrite( void *data )
             }
         }
 
-        block_cleanup_push( p_pk );
+        batch.pkts[0] = p_pk;
+        batch.count = 1;
+        vlc_cleanup_push( BatchCleanup, &batch );
         i_to_send--;
         if( !i_to_send || (p_pk->i_flags & BLOCK_FLAG_CLOCK) )
         {
             mwait( i_date );
             i_to_send = i_group;
         }
-        if ( send( p_sys->i_handle, p_pk->p_buffer, p_pk->i_buffer, 0 ) == -1 )
-            msg_Warn( p_access, "send error: %s", vlc_strerror_c(errno) );
+
+        /* Send the queued datagrams due within the pacing window along */
+        const mtime_t i_deadline = mdate() + PACING_WINDOW;
+
+        vlc_fifo_Lock( p_sys->p_fifo );
+        while( batch.count < UDP_BATCH && !vlc_fifo_IsEmpty( p_sys->p_fifo ) )
+        {
+            block_t *p_next = vlc_fifo_DequeueUnlocked( p_sys->p_fifo );
+            mtime_t i_next = p_sys->i_caching + p_next->i_dts;
+
+            if( i_next - i_date > 2000000 /* hole */
+             || (i_next > i_deadline /* not due yet, unless grouped */
+              && (i_to_send <= 1 || (p_next->i_flags & BLOCK_FLAG_CLOCK))) )
+            {
+                batch.next = p_next;
+                break;
+            }
+            if( i_next > i_deadline )
+                i_to_send--;
+            batch.pkts[batch.count++] = p_next;
+        }
+        vlc_fifo_Unlock( p_sys->p_fifo );
+
+        SendBatch( p_access, &batch );
         vlc_cleanup_pop();
 
         if( i_dropped_packets )
@@ -438,18 +624,17 @@ static void* ThreadWrite( void *data )
             i_dropped_packets = 0;
         }
 
-#if 1
         i_sent = mdate();
         if ( i_sent > i_date + 20000 )
         {
             msg_Dbg( p_access, "packet has been sent too late (%"PRId64 ")",
                      i_sent - i_date );
         }
-#endif
-
-        block_FifoPut( p_sys->p_empty_blocks, p_pk );
+        PacingUpdate( p_access, &stats, &batch, i_sent );
 
-        i_date_last = i_date;
+        i_date_last = p_sys->i_caching + batch.pkts[batch.count - 1]->i_dts;
+        for( unsigned i = 0; i < batch.count; i++ )
+            block_FifoPut( p_sys->p_empty_blocks, batch.pkts[i] );
     }
     return NULL;
 }
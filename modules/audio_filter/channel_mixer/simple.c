@@ -28,242 +28,43 @@
 # include "config.h"
 #endif
 
+#include <assert.h>
+
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_aout.h>
 #include <vlc_filter.h>
 #include <vlc_block.h>
 
+#include "simple_matrix.h"
+#if defined (CAN_COMPILE_ARM)
+# include "simple_neon.h"
+#endif
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
 static int  OpenFilter( vlc_object_t * );
+static void CloseFilter( vlc_object_t * );
 
 vlc_module_begin ()
     set_description( N_("Audio filter for simple channel mixing") )
     set_category( CAT_AUDIO )
     set_subcategory( SUBCAT_AUDIO_MISC )
     set_capability( "audio converter", 10 )
-    set_callbacks( OpenFilter, NULL );
+    set_callbacks( OpenFilter, CloseFilter )
 vlc_module_end ()
 
 static block_t *Filter( filter_t *, block_t * );
 
-static void DoWork_7_x_to_2_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
-    {
-        float ctr = p_src[6] * 0.7071f;
-        *p_dest++ = ctr + p_src[0] + p_src[2] / 4 + p_src[4] / 4;
-        *p_dest++ = ctr + p_src[1] + p_src[3] / 4 + p_src[5] / 4;
-
-        p_src += 7;
-
-        if( p_filter->fmt_in.audio.i_physical_channels & AOUT_CHAN_LFE ) p_src++;
-    }
-}
-
-static void DoWork_6_1_to_2_0( filter_t *p_filter, block_t *p_in_buf,
-                               block_t *p_out_buf )
+struct filter_sys_t
 {
-    VLC_UNUSED(p_filter);
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
-    {
-        float ctr = (p_src[2] + p_src[5]) * 0.7071f;
-        *p_dest++ = p_src[0] + p_src[3] + ctr;
-        *p_dest++ = p_src[1] + p_src[4] + ctr;
-
-        p_src += 6;
-
-        /* We always have LFE here */
-        p_src++;
-    }
-}
-
-static void DoWork_5_x_to_2_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
-    {
-        *p_dest++ = p_src[0] + 0.7071f * (p_src[4] + p_src[2]);
-        *p_dest++ = p_src[1] + 0.7071f * (p_src[4] + p_src[3]);
-
-        p_src += 5;
-
-        if( p_filter->fmt_in.audio.i_physical_channels & AOUT_CHAN_LFE ) p_src++;
-    }
-}
-
-static void DoWork_4_0_to_2_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    VLC_UNUSED(p_filter);
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
-    {
-        *p_dest++ = p_src[2] + p_src[3] + 0.5f * p_src[0];
-        *p_dest++ = p_src[2] + p_src[3] + 0.5f * p_src[1];
-        p_src += 4;
-    }
-}
-
-static void DoWork_3_x_to_2_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
-    {
-        *p_dest++ = p_src[2] + 0.5f * p_src[0];
-        *p_dest++ = p_src[2] + 0.5f * p_src[1];
-
-        p_src += 3;
-
-        if( p_filter->fmt_in.audio.i_physical_channels & AOUT_CHAN_LFE ) p_src++;
-    }
-}
-
-static void DoWork_7_x_to_1_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
-    {
-        *p_dest++ = p_src[6] + p_src[0] / 4 + p_src[1] / 4 + p_src[2] / 8 + p_src[3] / 8 + p_src[4] / 8 + p_src[5] / 8;
-
-        p_src += 7;
-
-        if( p_filter->fmt_in.audio.i_physical_channels & AOUT_CHAN_LFE ) p_src++;
-    }
-}
-
-static void DoWork_5_x_to_1_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
-    {
-        *p_dest++ = 0.7071f * (p_src[0] + p_src[1]) + p_src[4]
-                     + 0.5f * (p_src[2] + p_src[3]);
-
-        p_src += 5;
-
-        if( p_filter->fmt_in.audio.i_physical_channels & AOUT_CHAN_LFE ) p_src++;
-    }
-}
-
-static void DoWork_4_0_to_1_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    VLC_UNUSED(p_filter);
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
-    {
-        *p_dest++ = p_src[2] + p_src[3] + p_src[0] / 4 + p_src[1] / 4;
-        p_src += 4;
-    }
-}
-
-static void DoWork_3_x_to_1_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
-    {
-        *p_dest++ = p_src[2] + p_src[0] / 4 + p_src[1] / 4;
-
-        p_src += 3;
-
-        if( p_filter->fmt_in.audio.i_physical_channels & AOUT_CHAN_LFE ) p_src++;
-    }
-}
-
-static void DoWork_2_x_to_1_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    VLC_UNUSED(p_filter);
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
-    {
-        *p_dest++ = p_src[0] / 2 + p_src[1] / 2;
-
-        p_src += 2;
-    }
-}
-
-static void DoWork_7_x_to_4_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
-    {
-        *p_dest++ = p_src[6] + 0.5f * p_src[0] + p_src[2] / 6;
-        *p_dest++ = p_src[6] + 0.5f * p_src[1] + p_src[3] / 6;
-        *p_dest++ = p_src[2] / 6 +  p_src[4];
-        *p_dest++ = p_src[3] / 6 +  p_src[5];
-
-        p_src += 7;
-
-        if( p_filter->fmt_in.audio.i_physical_channels & AOUT_CHAN_LFE ) p_src++;
-    }
-}
-
-static void DoWork_5_x_to_4_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
-    {
-        float ctr = p_src[4] * 0.7071f;
-        *p_dest++ = p_src[0] + ctr;
-        *p_dest++ = p_src[1] + ctr;
-        *p_dest++ = p_src[2];
-        *p_dest++ = p_src[3];
-
-        p_src += 5;
-
-        if( p_filter->fmt_in.audio.i_physical_channels & AOUT_CHAN_LFE ) p_src++;
-    }
-}
-
-static void DoWork_7_x_to_5_x( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
-    {
-        *p_dest++ = p_src[0];
-        *p_dest++ = p_src[1];
-        *p_dest++ = (p_src[2] + p_src[4]) * 0.5f;
-        *p_dest++ = (p_src[3] + p_src[5]) * 0.5f;
-        *p_dest++ = p_src[6];
-
-        p_src += 7;
-
-        if( p_filter->fmt_in.audio.i_physical_channels & AOUT_CHAN_LFE &&
-            p_filter->fmt_out.audio.i_physical_channels & AOUT_CHAN_LFE )
-            *p_dest++ = *p_src++;
-        else if( p_filter->fmt_in.audio.i_physical_channels & AOUT_CHAN_LFE ) p_src++;
-    }
-}
-
-static void DoWork_6_1_to_5_x( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    VLC_UNUSED(p_filter);
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
-    {
-        *p_dest++ = p_src[0];
-        *p_dest++ = p_src[1];
-        *p_dest++ = (p_src[2] + p_src[4]) * 0.5f;
-        *p_dest++ = (p_src[3] + p_src[4]) * 0.5f;
-        *p_dest++ = p_src[5];
-
-        p_src += 6;
-
-        /* We always have LFE here */
-        *p_dest++ = *p_src++;
-    }
-}
-
+    mix_matrix_t mx;
+    mix_matrix_cb pf_mix;
 #if defined (CAN_COMPILE_ARM)
-#include "simple_neon.h"
-#define GET_WORK(in, out) GET_WORK_##in##_to_##out##_neon()
-#else
-#define GET_WORK(in, out) DoWork_##in##_to_##out
+    neon_convert_cb pf_neon;
 #endif
+};
 
 /*****************************************************************************
  * OpenFilter:
@@ -271,7 +72,7 @@ static void DoWork_6_1_to_5_x( filter_t * p_filter,  block_t * p_in_buf, block_t
 static int OpenFilter( vlc_object_t *p_this )
 {
     filter_t *p_filter = (filter_t *)p_this;
-    void (*do_work)(filter_t *, block_t *, block_t *) = NULL;
+    mix_matrix_t mx;
 
     if( p_filter->fmt_in.audio.i_format != VLC_CODEC_FL32 ||
         p_filter->fmt_in.audio.i_format != p_filter->fmt_out.audio.i_format ||
@@ -286,77 +87,38 @@ static int OpenFilter( vlc_object_t *p_this )
     if( input == output )
         return VLC_EGENERIC;
 
-    const bool b_input_6_1 = input == AOUT_CHANS_6_1_MIDDLE;
-    const bool b_input_4_center_rear = input == AOUT_CHANS_4_CENTER_REAR;
-
-    input &= ~AOUT_CHAN_LFE;
-
-    const bool b_input_7_x = input == AOUT_CHANS_7_0;
-    const bool b_input_5_x = input == AOUT_CHANS_5_0
-                          || input == AOUT_CHANS_5_0_MIDDLE;
-    const bool b_input_3_x = input == AOUT_CHANS_3_0;
+    if( MixMatrixInit( &mx, input, output ) )
+        return VLC_EGENERIC;
 
-    /*
-     * TODO: We don't support any 8.1 input
-     * TODO: We don't support any 6.x input
-     * TODO: We don't support 4.0 rear and 4.0 middle
-     */
-    if( output == AOUT_CHAN_CENTER )
-    {
-        if( b_input_7_x )
-            do_work = GET_WORK(7_x,1_0);
-        else if( b_input_5_x )
-            do_work = GET_WORK(5_x,1_0);
-        else if( b_input_4_center_rear )
-            do_work = GET_WORK(4_0,1_0);
-        else if( b_input_3_x )
-            do_work = GET_WORK(3_x,1_0);
-        else
-            do_work = GET_WORK(2_x,1_0);
-    }
-    else if( output == AOUT_CHANS_2_0 )
-    {
-        if( b_input_7_x )
-            do_work = GET_WORK(7_x,2_0);
-        else if( b_input_6_1 )
-            do_work = GET_WORK(6_1,2_0);
-        else if( b_input_5_x )
-            do_work = GET_WORK(5_x,2_0);
-        else if( b_input_4_center_rear )
-            do_work = GET_WORK(4_0,2_0);
-        else if( b_input_3_x )
-            do_work = GET_WORK(3_x,2_0);
-    }
-    else if( output == AOUT_CHANS_4_0 )
-    {
-        if( b_input_7_x )
-            do_work = GET_WORK(7_x,4_0);
-        else if( b_input_5_x )
-            do_work = GET_WORK(5_x,4_0);
-    }
-    else if( (output & ~AOUT_CHAN_LFE) == AOUT_CHANS_5_0 ||
-             (output & ~AOUT_CHAN_LFE) == AOUT_CHANS_5_0_MIDDLE )
-    {
-        if( b_input_7_x )
-            do_work = GET_WORK(7_x,5_x);
-        else if( b_input_6_1 )
-            do_work = GET_WORK(6_1,5_x);
-    }
+    filter_sys_t *p_sys = malloc( sizeof( *p_sys ) );
+    if( unlikely(p_sys == NULL) )
+        return VLC_ENOMEM;
 
-    if( do_work == NULL )
-        return VLC_EGENERIC;
+    p_sys->mx = mx;
+    p_sys->pf_mix = MixGetMatrix();
+#if defined (CAN_COMPILE_ARM)
+    p_sys->pf_neon = vlc_CPU_ARM_NEON() ? GetNeonConvert( input, output )
+                                        : NULL;
+#endif
 
     p_filter->pf_audio_filter = Filter;
-    p_filter->p_sys = (void *)do_work;
+    p_filter->p_sys = p_sys;
     return VLC_SUCCESS;
 }
 
+static void CloseFilter( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+
+    free( p_filter->p_sys );
+}
+
 /*****************************************************************************
  * Filter:
  *****************************************************************************/
 static block_t *Filter( filter_t *p_filter, block_t *p_block )
 {
-    void (*work)(filter_t *, block_t *, block_t *) = (void *)p_filter->p_sys;
+    filter_sys_t *p_sys = p_filter->p_sys;
 
     if( !p_block || !p_block->i_nb_samples )
     {
@@ -365,32 +127,24 @@ static block_t *Filter( filter_t *p_filter, block_t *p_block )
         return NULL;
     }
 
-    size_t i_out_size = p_block->i_nb_samples *
-      p_filter->fmt_out.audio.i_bitspersample *
-        p_filter->fmt_out.audio.i_channels / 8;
-
-    block_t *p_out = block_Alloc( i_out_size );
-    if( !p_out )
-    {
-        msg_Warn( p_filter, "can't get output buffer" );
-        block_Release( p_block );
-        return NULL;
-    }
-
-    p_out->i_nb_samples = p_block->i_nb_samples;
-    p_out->i_dts = p_block->i_dts;
-    p_out->i_pts = p_block->i_pts;
-    p_out->i_length = p_block->i_length;
-
     int i_input_nb = aout_FormatNbChannels( &p_filter->fmt_in.audio );
     int i_output_nb = aout_FormatNbChannels( &p_filter->fmt_out.audio );
-    p_out->i_nb_samples = p_block->i_nb_samples;
-    p_out->i_buffer = p_block->i_buffer * i_output_nb / i_input_nb;
 
-    work( p_filter, p_block, p_out );
+    /* All the conversions are downmixes, reading each input frame before
+     * writing the output one behind it: they are done in place. */
+    assert( i_output_nb < i_input_nb );
+
+    float *p_buf = (float *)p_block->p_buffer;
+#if defined (CAN_COMPILE_ARM)
+    if( p_sys->pf_neon != NULL )
+        p_sys->pf_neon( p_buf, p_buf, p_block->i_nb_samples,
+                        p_filter->fmt_in.audio.i_physical_channels & AOUT_CHAN_LFE );
+    else
+#endif
+        p_sys->pf_mix( &p_sys->mx, p_buf, p_buf, p_block->i_nb_samples );
 
-    block_Release( p_block );
+    p_block->i_buffer = p_block->i_buffer * i_output_nb / i_input_nb;
 
-    return p_out;
+    return p_block;
 }
 
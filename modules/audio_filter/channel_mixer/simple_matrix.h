@@ -0,0 +1,332 @@
+/*****************************************************************************
+ * simple_matrix.h: downmix matrices of the simple channel mixer
+ *****************************************************************************
+ * Copyright (C) 2002-2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_SIMPLE_MATRIX_H_
+#define VLC_SIMPLE_MATRIX_H_
+
+#include <string.h>
+#include <vlc_cpu.h>
+#include <vlc_aout.h>
+
+#if defined(HAVE_SSE2_INTRINSICS)
+# include <emmintrin.h>
+#endif
+#if defined(HAVE_AVX2_INTRINSICS)
+# include <immintrin.h>
+#endif
+#if defined(__ARM_NEON)
+# include <arm_neon.h>
+#endif
+
+#define MIX_CHANNELS_MAX 8
+
+/* Downmix matrix: each output channel is the sum of the input channels,
+ * weighted by its row, the channels being interleaved */
+typedef struct
+{
+    unsigned i_in;
+    unsigned i_out;
+    float m[MIX_CHANNELS_MAX][MIX_CHANNELS_MAX]; /* [out][in], zero padded */
+} mix_matrix_t;
+
+typedef void (*mix_matrix_cb)( const mix_matrix_t *, float *, const float *,
+                               unsigned );
+
+/* Sets the matrix of a layouts pair: the rows are given for the input
+ * channels but the LFE, which is mixed to the output LFE, if any */
+static inline void MixMatrixSet( mix_matrix_t *p_mx, unsigned i_in,
+                                 unsigned i_out, const float *p_rows,
+                                 bool b_lfe_in, bool b_lfe_out )
+{
+    memset( p_mx, 0, sizeof( *p_mx ) );
+    p_mx->i_in = i_in + b_lfe_in;
+    p_mx->i_out = i_out + b_lfe_out;
+    for( unsigned o = 0; o < i_out; o++ )
+        for( unsigned i = 0; i < i_in; i++ )
+            p_mx->m[o][i] = p_rows[o * i_in + i];
+    if( b_lfe_in && b_lfe_out )
+        p_mx->m[i_out][i_in] = 1.f;
+}
+
+/* -3 dB */
+#define MIX_3DB 0.7071f
+
+#define MIX_SET(mx, in, out, lfe_in, lfe_out, ...) \
+    do { \
+        static const float rows[] = { __VA_ARGS__ }; \
+        static_assert( ARRAY_SIZE(rows) == (in) * (out), "Bad matrix" ); \
+        MixMatrixSet( mx, in, out, rows, lfe_in, lfe_out ); \
+    } while( 0 )
+
+/* Sets the matrix converting the input physical channels to the output
+ * ones, or returns VLC_EGENERIC if the conversion is not supported.
+ * The 5.x rear and middle layouts are mixed the same way. */
+static inline int MixMatrixInit( mix_matrix_t *p_mx, uint32_t input,
+                                 uint32_t output )
+{
+    const bool b_input_6_1 = input == AOUT_CHANS_6_1_MIDDLE;
+    const bool b_input_4_center_rear = input == AOUT_CHANS_4_CENTER_REAR;
+    const bool b_lfe_in = ( input & AOUT_CHAN_LFE ) != 0;
+    const bool b_lfe_out = ( output & AOUT_CHAN_LFE ) != 0;
+    const unsigned i_physical = popcount( input );
+
+    input &= ~AOUT_CHAN_LFE;
+
+    const bool b_input_7_x = input == AOUT_CHANS_7_0;
+    const bool b_input_5_x = input == AOUT_CHANS_5_0
+                          || input == AOUT_CHANS_5_0_MIDDLE;
+    const bool b_input_3_x = input == AOUT_CHANS_3_0;
+
+    /*
+     * TODO: We don't support any 8.1 input
+     * TODO: We don't support any 6.x input
+     * TODO: We don't support 4.0 rear and 4.0 middle
+     */
+    if( output == AOUT_CHAN_CENTER )
+    {
+        if( b_input_7_x )
+            MIX_SET( p_mx, 7, 1, b_lfe_in, false,
+                     .25f, .25f, .125f, .125f, .125f, .125f, 1.f );
+        else if( b_input_5_x )
+            MIX_SET( p_mx, 5, 1, b_lfe_in, false,
+                     MIX_3DB, MIX_3DB, .5f, .5f, 1.f );
+        else if( b_input_4_center_rear )
+            MIX_SET( p_mx, 4, 1, false, false,
+                     .25f, .25f, 1.f, 1.f );
+        else if( b_input_3_x )
+            MIX_SET( p_mx, 3, 1, b_lfe_in, false,
+                     .25f, .25f, 1.f );
+        else if( i_physical <= MIX_CHANNELS_MAX )
+        {   /* Front channels only */
+            MIX_SET( p_mx, 2, 1, false, false, .5f, .5f );
+            p_mx->i_in = i_physical;
+        }
+        else
+            return VLC_EGENERIC;
+    }
+    else if( output == AOUT_CHANS_2_0 )
+    {
+        if( b_input_7_x )
+            MIX_SET( p_mx, 7, 2, b_lfe_in, false,
+                     1.f, 0.f, .25f, 0.f, .25f, 0.f, MIX_3DB,
+                     0.f, 1.f, 0.f, .25f, 0.f, .25f, MIX_3DB );
+        else if( b_input_6_1 )
+            MIX_SET( p_mx, 6, 2, true, false,
+                     1.f, 0.f, MIX_3DB, 1.f, 0.f, MIX_3DB,
+                     0.f, 1.f, MIX_3DB, 0.f, 1.f, MIX_3DB );
+        else if( b_input_5_x )
+            MIX_SET( p_mx, 5, 2, b_lfe_in, false,
+                     1.f, 0.f, MIX_3DB, 0.f, MIX_3DB,
+                     0.f, 1.f, 0.f, MIX_3DB, MIX_3DB );
+        else if( b_input_4_center_rear )
+            MIX_SET( p_mx, 4, 2, false, false,
+                     .5f, 0.f, 1.f, 1.f,
+                     0.f, .5f, 1.f, 1.f );
+        else if( b_input_3_x )
+            MIX_SET( p_mx, 3, 2, b_lfe_in, false,
+                     .5f, 0.f, 1.f,
+                     0.f, .5f, 1.f );
+        else
+            return VLC_EGENERIC;
+    }
+    else if( output == AOUT_CHANS_4_0 )
+    {
+        if( b_input_7_x )
+            MIX_SET( p_mx, 7, 4, b_lfe_in, false,
+                     .5f, 0.f, 1.f / 6, 0.f, 0.f, 0.f, 1.f,
+                     0.f, .5f, 0.f, 1.f / 6, 0.f, 0.f, 1.f,
+                     0.f, 0.f, 1.f / 6, 0.f, 1.f, 0.f, 0.f,
+                     0.f, 0.f, 0.f, 1.f / 6, 0.f, 1.f, 0.f );
+        else if( b_input_5_x )
+            MIX_SET( p_mx, 5, 4, b_lfe_in, false,
+                     1.f, 0.f, 0.f, 0.f, MIX_3DB,
+                     0.f, 1.f, 0.f, 0.f, MIX_3DB,
+                     0.f, 0.f, 1.f, 0.f, 0.f,
+                     0.f, 0.f, 0.f, 1.f, 0.f );
+        else
+            return VLC_EGENERIC;
+    }
+    else if( (output & ~AOUT_CHAN_LFE) == AOUT_CHANS_5_0 ||
+             (output & ~AOUT_CHAN_LFE) == AOUT_CHANS_5_0_MIDDLE )
+    {
+        if( b_input_7_x )
+            MIX_SET( p_mx, 7, 5, b_lfe_in, b_lfe_out,
+                     1.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f,
+                     0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 0.f,
+                     0.f, 0.f, .5f, 0.f, .5f, 0.f, 0.f,
+                     0.f, 0.f, 0.f, .5f, 0.f, .5f, 0.f,
+                     0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 1.f );
+        else if( b_input_6_1 )
+            MIX_SET( p_mx, 6, 5, true, b_lfe_out,
+                     1.f, 0.f, 0.f, 0.f, 0.f, 0.f,
+                     0.f, 1.f, 0.f, 0.f, 0.f, 0.f,
+                     0.f, 0.f, .5f, 0.f, .5f, 0.f,
+                     0.f, 0.f, 0.f, .5f, .5f, 0.f,
+                     0.f, 0.f, 0.f, 0.f, 0.f, 1.f );
+        else
+            return VLC_EGENERIC;
+    }
+    else
+        return VLC_EGENERIC;
+
+    return VLC_SUCCESS;
+}
+
+#undef MIX_3DB
+#undef MIX_SET
+
+static inline __attribute__((always_inline))
+void MixFramesC( const mix_matrix_t *p_mx, float *out, const float *in,
+                 unsigned i_frames, const unsigned I )
+{
+    const unsigned i_out = p_mx->i_out;
+
+    for( unsigned f = 0; f < i_frames; f++ )
+    {
+        float frame[MIX_CHANNELS_MAX];
+
+        memcpy( frame, in, I * sizeof (float) );
+        for( unsigned o = 0; o < i_out; o++ )
+        {
+            float sum = p_mx->m[o][0] * frame[0];
+            for( unsigned i = 1; i < I; i++ )
+                sum += p_mx->m[o][i] * frame[i];
+            out[o] = sum;
+        }
+        in += I;
+        out += i_out;
+    }
+}
+
+/* Reference downmix, also used for the frames left by the vectorized ones.
+ * An output frame never overwrites the input of the next frames, so that
+ * the downmix can be done in place. */
+static void MixMatrixC( const mix_matrix_t *p_mx, float *out, const float *in,
+                        unsigned i_frames )
+{
+    /* Instantiate the loops per input channels count, so that they are
+     * unrolled */
+    switch( p_mx->i_in )
+    {
+#define MIX_CASE(n) \
+        case n: MixFramesC( p_mx, out, in, i_frames, n ); break;
+        MIX_CASE(2) MIX_CASE(3) MIX_CASE(4)
+        MIX_CASE(5) MIX_CASE(6) MIX_CASE(7) MIX_CASE(8)
+#undef MIX_CASE
+        default:
+            MixFramesC( p_mx, out, in, i_frames, p_mx->i_in );
+    }
+}
+
+#if defined(HAVE_SSE2_INTRINSICS)
+# define MIX_TARGET __attribute__((__target__("sse2")))
+# define MIX_FUNC(name) name##SSE2
+# define V __m128
+# define V_N 4
+# define V_HALVES 1
+# define V_SET1(f) _mm_set1_ps(f)
+# define V_BCAST(p) _mm_set1_ps(*(p))
+# define V_LOAD(p) _mm_loadu_ps(p)
+# define V_LOADG(p, d) _mm_loadu_ps(p)
+# define V_STORE(p, v) _mm_storeu_ps(p, v)
+# define V_ADD(a, b) _mm_add_ps(a, b)
+# define V_MUL(a, b) _mm_mul_ps(a, b)
+# define V_PAIR(a, b, k) _mm_shuffle_ps(a, b, _MM_SHUFFLE(k, k, k, k))
+# define V_TRANSPOSE4(a, b, c, d) _MM_TRANSPOSE4_PS(a, b, c, d)
+# include "simple_matrix_simd.h"
+#endif
+
+#if defined(HAVE_AVX2_INTRINSICS)
+/* Only AVX is needed, but the build system checks for the AVX2 support */
+# define MIX_TARGET __attribute__((__target__("avx")))
+# define MIX_FUNC(name) name##AVX
+# define V __m256
+# define V_N 8
+# define V_HALVES 2
+# define V_SET1(f) _mm256_set1_ps(f)
+# define V_BCAST(p) _mm256_broadcast_ss(p)
+# define V_LOAD(p) _mm256_loadu_ps(p)
+# define V_LOADG(p, d) \
+    _mm256_insertf128_ps( _mm256_castps128_ps256( _mm_loadu_ps(p) ), \
+                          _mm_loadu_ps( (p) + (d) ), 1 )
+# define V_STORE(p, v) _mm256_storeu_ps(p, v)
+# define V_ADD(a, b) _mm256_add_ps(a, b)
+# define V_MUL(a, b) _mm256_mul_ps(a, b)
+# define V_PAIR(a, b, k) _mm256_shuffle_ps(a, b, _MM_SHUFFLE(k, k, k, k))
+# define V_TRANSPOSE4(a, b, c, d) \
+    do { \
+        __m256 t0 = _mm256_unpacklo_ps(a, b), t1 = _mm256_unpackhi_ps(a, b); \
+        __m256 t2 = _mm256_unpacklo_ps(c, d), t3 = _mm256_unpackhi_ps(c, d); \
+        a = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)); \
+        b = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2)); \
+        c = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)); \
+        d = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2)); \
+    } while( 0 )
+# include "simple_matrix_simd.h"
+#endif
+
+#if defined(__ARM_NEON)
+# define MIX_TARGET
+# define MIX_FUNC(name) name##NEON
+# define V float32x4_t
+# define V_N 4
+# define V_HALVES 1
+# define V_SET1(f) vdupq_n_f32(f)
+# define V_BCAST(p) vld1q_dup_f32(p)
+# define V_LOAD(p) vld1q_f32(p)
+# define V_LOADG(p, d) vld1q_f32(p)
+# define V_STORE(p, v) vst1q_f32(p, v)
+# define V_ADD(a, b) vaddq_f32(a, b)
+# define V_MUL(a, b) vmulq_f32(a, b)
+# define V_HALF(a, k) ( (k) < 2 ? vget_low_f32(a) : vget_high_f32(a) )
+# define V_PAIR(a, b, k) \
+    vcombine_f32( vdup_lane_f32( V_HALF(a, k), (k) & 1 ), \
+                  vdup_lane_f32( V_HALF(b, k), (k) & 1 ) )
+# define V_TRANSPOSE4(a, b, c, d) \
+    do { \
+        float32x4x2_t t0 = vtrnq_f32(a, b), t1 = vtrnq_f32(c, d); \
+        a = vcombine_f32( vget_low_f32(t0.val[0]), vget_low_f32(t1.val[0]) ); \
+        b = vcombine_f32( vget_low_f32(t0.val[1]), vget_low_f32(t1.val[1]) ); \
+        c = vcombine_f32( vget_high_f32(t0.val[0]), vget_high_f32(t1.val[0]) ); \
+        d = vcombine_f32( vget_high_f32(t0.val[1]), vget_high_f32(t1.val[1]) ); \
+    } while( 0 )
+# include "simple_matrix_simd.h"
+# undef V_HALF
+#endif
+
+/* Returns the fastest downmix for the CPU */
+static inline mix_matrix_cb MixGetMatrix( void )
+{
+#if defined(HAVE_AVX2_INTRINSICS)
+    if( vlc_CPU_AVX() )
+        return MixMatrixAVX;
+#endif
+#if defined(HAVE_SSE2_INTRINSICS)
+    if( vlc_CPU_SSE2() )
+        return MixMatrixSSE2;
+#endif
+#if defined(__ARM_NEON)
+    return MixMatrixNEON;
+#else
+    return MixMatrixC;
+#endif
+}
+
+#endif
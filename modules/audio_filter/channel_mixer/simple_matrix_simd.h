@@ -0,0 +1,214 @@
+/*****************************************************************************
+ * simple_matrix_simd.h: vectorized downmix matrix
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* This file is included once per instruction set by simple_matrix.h, with:
+ *  - MIX_TARGET, the function attribute enabling the instruction set,
+ *  - MIX_FUNC(name), the name of the instantiated functions,
+ *  - V, a vector of V_N floats made of V_HALVES groups of 4 floats, and its
+ *    V_* operations, the shuffles operating within each group.
+ *
+ * The output samples are computed in the vector lanes, in their interleaved
+ * order, so that they are stored without any shuffle:
+ *  - to mono, the groups hold 4 frames, transposed to get each input channel
+ *    in the lanes,
+ *  - to stereo, the groups hold 2 frames, each input channel being
+ *    duplicated in the lanes of its frame,
+ *  - to more channels, a vector holds the output channels of a frame, each
+ *    input channel being broadcast.
+ * All the input of a vector is loaded before its output is stored, so that
+ * the downmix can be done in place. The channels are summed in the same
+ * order as by MixMatrixC(), so that the results are the same. */
+
+/* Loads the first 4, or 8 if there are more, channels of the frames
+ * starting at p, the groups being d floats apart */
+#define MIX_LOAD(v, p, d) \
+    do { \
+        v##_lo = V_LOADG( (p), (d) ); \
+        if( I > 4 ) \
+            v##_hi = V_LOADG( (p) + 4, (d) ); \
+    } while( 0 )
+
+/* Channel c of the loaded frames */
+#define MIX_CHANNEL(v, c) ( (c) < 4 ? v##_lo : v##_hi )
+
+static inline MIX_TARGET __attribute__((always_inline))
+void MIX_FUNC(MixMono)( const mix_matrix_t *p_mx, float *out, const float *in,
+                        unsigned i_frames, const unsigned I )
+{
+    /* Frames per vector */
+    const unsigned F = 4 * V_HALVES;
+    V c[MIX_CHANNELS_MAX];
+
+    for( unsigned i = 0; i < I; i++ )
+        c[i] = V_SET1( p_mx->m[0][i] );
+
+    unsigned f = 0;
+    for( ; f + F <= i_frames
+        && (f + F - 1) * I + (I > 4 ? 8 : 4) <= i_frames * I; f += F )
+    {
+        const float *p = &in[f * I];
+        V a0_lo, a1_lo, a2_lo, a3_lo, a0_hi, a1_hi, a2_hi, a3_hi;
+
+        MIX_LOAD( a0, p,         4 * I );
+        MIX_LOAD( a1, p + I,     4 * I );
+        MIX_LOAD( a2, p + 2 * I, 4 * I );
+        MIX_LOAD( a3, p + 3 * I, 4 * I );
+        V_TRANSPOSE4( a0_lo, a1_lo, a2_lo, a3_lo );
+        if( I > 4 )
+            V_TRANSPOSE4( a0_hi, a1_hi, a2_hi, a3_hi );
+
+        V o = V_MUL( a0_lo, c[0] );
+        o = V_ADD( o, V_MUL( a1_lo, c[1] ) );
+        if( I > 2 ) o = V_ADD( o, V_MUL( a2_lo, c[2] ) );
+        if( I > 3 ) o = V_ADD( o, V_MUL( a3_lo, c[3] ) );
+        if( I > 4 ) o = V_ADD( o, V_MUL( a0_hi, c[4] ) );
+        if( I > 5 ) o = V_ADD( o, V_MUL( a1_hi, c[5] ) );
+        if( I > 6 ) o = V_ADD( o, V_MUL( a2_hi, c[6] ) );
+        if( I > 7 ) o = V_ADD( o, V_MUL( a3_hi, c[7] ) );
+        V_STORE( &out[f], o );
+    }
+    MixMatrixC( p_mx, &out[f], &in[f * I], i_frames - f );
+}
+
+static inline MIX_TARGET __attribute__((always_inline))
+void MIX_FUNC(MixStereo)( const mix_matrix_t *p_mx, float *out,
+                          const float *in, unsigned i_frames, const unsigned I )
+{
+    /* Frames per vector */
+    const unsigned F = 2 * V_HALVES;
+    V c[MIX_CHANNELS_MAX];
+
+    for( unsigned i = 0; i < I; i++ )
+    {
+        float pair[V_N];
+        for( unsigned j = 0; j < V_N; j++ )
+            pair[j] = p_mx->m[j & 1][i];
+        c[i] = V_LOAD( pair );
+    }
+
+    unsigned f = 0;
+    for( ; f + F <= i_frames
+        && (f + F - 1) * I + (I > 4 ? 8 : 4) <= i_frames * I; f += F )
+    {
+        const float *p = &in[f * I];
+        V a_lo, a_hi, b_lo, b_hi;
+
+        MIX_LOAD( a, p,     2 * I );
+        MIX_LOAD( b, p + I, 2 * I );
+
+#define MIX_TERM(k) \
+        if( I > k ) \
+            o = V_ADD( o, V_MUL( V_PAIR( MIX_CHANNEL(a, k), \
+                                         MIX_CHANNEL(b, k), (k) & 3 ), c[k] ) );
+        V o = V_MUL( V_PAIR( a_lo, b_lo, 0 ), c[0] );
+        MIX_TERM(1) MIX_TERM(2) MIX_TERM(3)
+        MIX_TERM(4) MIX_TERM(5) MIX_TERM(6) MIX_TERM(7)
+#undef MIX_TERM
+        V_STORE( &out[2 * f], o );
+    }
+    MixMatrixC( p_mx, &out[2 * f], &in[f * I], i_frames - f );
+}
+
+static inline MIX_TARGET __attribute__((always_inline))
+void MIX_FUNC(MixFrames)( const mix_matrix_t *p_mx, float *out,
+                          const float *in, unsigned i_frames,
+                          const unsigned I )
+{
+    const unsigned O = p_mx->i_out;
+    const unsigned i_vec = ( O + V_N - 1 ) / V_N;
+    V c[MIX_CHANNELS_MAX][MIX_CHANNELS_MAX / V_N];
+
+    for( unsigned i = 0; i < I; i++ )
+        for( unsigned v = 0; v < i_vec; v++ )
+        {
+            float col[V_N];
+            for( unsigned j = 0; j < V_N; j++ )
+                col[j] = v * V_N + j < MIX_CHANNELS_MAX
+                       ? p_mx->m[v * V_N + j][i] : 0.f;
+            c[i][v] = V_LOAD( col );
+        }
+
+    for( unsigned f = 0; f < i_frames; f++ )
+    {
+        const float *p = &in[f * I];
+        V o[MIX_CHANNELS_MAX / V_N];
+
+        for( unsigned v = 0; v < i_vec; v++ )
+        {
+            o[v] = V_MUL( V_BCAST( &p[0] ), c[0][v] );
+            for( unsigned i = 1; i < I; i++ )
+                o[v] = V_ADD( o[v], V_MUL( V_BCAST( &p[i] ), c[i][v] ) );
+        }
+
+        if( O % V_N == 0 )
+            for( unsigned v = 0; v < i_vec; v++ )
+                V_STORE( &out[f * O + v * V_N], o[v] );
+        else
+        {
+            float tmp[MIX_CHANNELS_MAX];
+            for( unsigned v = 0; v < i_vec; v++ )
+                V_STORE( &tmp[v * V_N], o[v] );
+            memcpy( &out[f * O], tmp, O * sizeof (float) );
+        }
+    }
+}
+
+#define MIX_CASE(n) \
+    case n: \
+        if( p_mx->i_out == 1 ) \
+            MIX_FUNC(MixMono)( p_mx, out, in, i_frames, n ); \
+        else if( p_mx->i_out == 2 ) \
+            MIX_FUNC(MixStereo)( p_mx, out, in, i_frames, n ); \
+        else \
+            MIX_FUNC(MixFrames)( p_mx, out, in, i_frames, n ); \
+        break;
+
+static MIX_TARGET
+void MIX_FUNC(MixMatrix)( const mix_matrix_t *p_mx, float *out,
+                          const float *in, unsigned i_frames )
+{
+    /* Instantiate the kernels per input channels count, so that the
+     * shuffles get immediate channel indexes */
+    switch( p_mx->i_in )
+    {
+        MIX_CASE(2) MIX_CASE(3) MIX_CASE(4)
+        MIX_CASE(5) MIX_CASE(6) MIX_CASE(7) MIX_CASE(8)
+        default:
+            MixMatrixC( p_mx, out, in, i_frames );
+    }
+}
+
+#undef MIX_CASE
+#undef MIX_CHANNEL
+#undef MIX_LOAD
+#undef MIX_TARGET
+#undef MIX_FUNC
+#undef V
+#undef V_N
+#undef V_HALVES
+#undef V_SET1
+#undef V_BCAST
+#undef V_LOAD
+#undef V_LOADG
+#undef V_STORE
+#undef V_ADD
+#undef V_MUL
+#undef V_PAIR
+#undef V_TRANSPOSE4
@@ -33,40 +33,56 @@
 /* Only from 7/7.1/5/5.1/3/3.1/2.0
  * XXX 5.X rear and middle are handled the same way */
 
-#define NEON_WRAPPER(in, out)                                                    \
-    void convert_##in##_to_##out##_neon_asm(float *dst, const float *src, int num, bool lfeChannel); \
-    static inline void DoWork_##in##_to_##out##_neon( filter_t *p_filter, block_t *p_in_buf, block_t *p_out_buf )  \
-    {                                                                            \
-        const float *p_src = (const float *)p_in_buf->p_buffer;                  \
-        float *p_dest = (float *)p_out_buf->p_buffer;                            \
-        convert_##in##_to_##out##_neon_asm( p_dest, p_src, p_in_buf->i_nb_samples, \
-                  p_filter->fmt_in.audio.i_physical_channels & AOUT_CHAN_LFE );  \
-    } \
-    static inline void (*GET_WORK_##in##_to_##out##_neon())(filter_t*, block_t*, block_t*) \
-    { \
-        return vlc_CPU_ARM_NEON() ? DoWork_##in##_to_##out##_neon : DoWork_##in##_to_##out; \
-    }
+typedef void (*neon_convert_cb)( float *, const float *, int, bool );
 
-NEON_WRAPPER(7_x,2_0)
-NEON_WRAPPER(5_x,2_0)
-NEON_WRAPPER(4_0,2_0)
-NEON_WRAPPER(3_x,2_0)
-NEON_WRAPPER(7_x,1_0)
-NEON_WRAPPER(5_x,1_0)
-NEON_WRAPPER(7_x,4_0)
-NEON_WRAPPER(5_x,4_0)
+#define NEON_CONVERT(in, out) \
+    void convert_##in##_to_##out##_neon_asm(float *dst, const float *src, int num, bool lfeChannel);
 
-/* TODO: the following conversions are not handled in NEON */
+NEON_CONVERT(7_x,2_0)
+NEON_CONVERT(5_x,2_0)
+NEON_CONVERT(4_0,2_0)
+NEON_CONVERT(3_x,2_0)
+NEON_CONVERT(7_x,1_0)
+NEON_CONVERT(5_x,1_0)
+NEON_CONVERT(7_x,4_0)
+NEON_CONVERT(5_x,4_0)
 
-#define C_WRAPPER(in, out) \
-    static inline void (*GET_WORK_##in##_to_##out##_neon())(filter_t*, block_t*, block_t*) \
-    { \
-        return DoWork_##in##_to_##out; \
-    }
+/* Returns the assembly conversion, or NULL to use the downmix matrix */
+static inline neon_convert_cb GetNeonConvert( uint32_t input, uint32_t output )
+{
+    const bool b_input_4_center_rear = input == AOUT_CHANS_4_CENTER_REAR;
+
+    input &= ~AOUT_CHAN_LFE;
+
+    const bool b_input_7_x = input == AOUT_CHANS_7_0;
+    const bool b_input_5_x = input == AOUT_CHANS_5_0
+                          || input == AOUT_CHANS_5_0_MIDDLE;
+    const bool b_input_3_x = input == AOUT_CHANS_3_0;
 
-C_WRAPPER(4_0,1_0)
-C_WRAPPER(3_x,1_0)
-C_WRAPPER(2_x,1_0)
-C_WRAPPER(6_1,2_0)
-C_WRAPPER(7_x,5_x)
-C_WRAPPER(6_1,5_x)
+    if( output == AOUT_CHAN_CENTER )
+    {
+        if( b_input_7_x )
+            return convert_7_x_to_1_0_neon_asm;
+        if( b_input_5_x )
+            return convert_5_x_to_1_0_neon_asm;
+    }
+    else if( output == AOUT_CHANS_2_0 )
+    {
+        if( b_input_7_x )
+            return convert_7_x_to_2_0_neon_asm;
+        if( b_input_5_x )
+            return convert_5_x_to_2_0_neon_asm;
+        if( b_input_4_center_rear )
+            return convert_4_0_to_2_0_neon_asm;
+        if( b_input_3_x )
+            return convert_3_x_to_2_0_neon_asm;
+    }
+    else if( output == AOUT_CHANS_4_0 )
+    {
+        if( b_input_7_x )
+            return convert_7_x_to_4_0_neon_asm;
+        if( b_input_5_x )
+            return convert_5_x_to_4_0_neon_asm;
+    }
+    return NULL;
+}
@@ -118,6 +118,8 @@ struct filter_sys_t
 
     CAmbisonicSpeaker *speakers;
 
+    CBFormat inData;
+
     std::vector<float> inputSamples;
     mtime_t i_inputPTS;
     unsigned i_rate;
@@ -133,6 +135,10 @@ struct filter_sys_t
     float f_phi;
     float f_roll;
     float f_zoom;
+    /* The rotation and zoom are recomputed once per block, and only if the
+     * view point changed since the previous block. */
+    bool b_orientationChanged;
+    bool b_zoomChanged;
 };
 
 static std::string getHRTFPath(filter_t *p_filter)
@@ -211,19 +217,26 @@ static block_t *Mix( filter_t *p_filter, block_t *p_buf )
             case filter_sys_t::AMBISONICS_DECODER:
             case filter_sys_t::AMBISONICS_BINAURAL_DECODER:
             {
-                CBFormat inData;
-                inData.Configure(p_sys->i_order, true, AMB_BLOCK_TIME_LEN);
+                CBFormat &inData = p_sys->inData;
 
                 for (unsigned i = 0; i < p_sys->i_inputNb; ++i)
                     inData.InsertStream(p_sys->inBuf[i], i, AMB_BLOCK_TIME_LEN);
 
-                Orientation ori(p_sys->f_teta, p_sys->f_phi, p_sys->f_roll);
-                p_sys->processor.SetOrientation(ori);
-                p_sys->processor.Refresh();
+                if (p_sys->b_orientationChanged)
+                {
+                    Orientation ori(p_sys->f_teta, p_sys->f_phi, p_sys->f_roll);
+                    p_sys->processor.SetOrientation(ori);
+                    p_sys->processor.Refresh();
+                    p_sys->b_orientationChanged = false;
+                }
                 p_sys->processor.Process(&inData, inData.GetSampleCount());
 
-                p_sys->zoomer.SetZoom(p_sys->f_zoom);
-                p_sys->zoomer.Refresh();
+                if (p_sys->b_zoomChanged)
+                {
+                    p_sys->zoomer.SetZoom(p_sys->f_zoom);
+                    p_sys->zoomer.Refresh();
+                    p_sys->b_zoomChanged = false;
+                }
                 p_sys->zoomer.Process(&inData, inData.GetSampleCount());
 
                 if (p_sys->mode == filter_sys_t::AMBISONICS_DECODER)
@@ -265,15 +278,31 @@ static void ChangeViewpoint( filter_t *p_filter, const vlc_viewpoint_t *p_vp)
     filter_sys_t *p_sys = (filter_sys_t *)p_filter->p_sys;
 
 #define RAD(d) ((float) ((d) * M_PI / 180.f))
-    p_sys->f_teta = -RAD(p_vp->yaw);
-    p_sys->f_phi = RAD(p_vp->pitch);
-    p_sys->f_roll = RAD(p_vp->roll);
+    float f_teta = -RAD(p_vp->yaw);
+    float f_phi = RAD(p_vp->pitch);
+    float f_roll = RAD(p_vp->roll);
+    float f_zoom;
 
     if (p_vp->fov >= FIELD_OF_VIEW_DEGREES_DEFAULT)
-        p_sys->f_zoom = 0.f; // no unzoom as it does not really make sense.
+        f_zoom = 0.f; // no unzoom as it does not really make sense.
     else
-        p_sys->f_zoom = (FIELD_OF_VIEW_DEGREES_DEFAULT - p_vp->fov) / (FIELD_OF_VIEW_DEGREES_DEFAULT - FIELD_OF_VIEW_DEGREES_MIN);
+        f_zoom = (FIELD_OF_VIEW_DEGREES_DEFAULT - p_vp->fov) / (FIELD_OF_VIEW_DEGREES_DEFAULT - FIELD_OF_VIEW_DEGREES_MIN);
 #undef RAD
+
+    if (f_teta != p_sys->f_teta || f_phi != p_sys->f_phi
+     || f_roll != p_sys->f_roll)
+    {
+        p_sys->f_teta = f_teta;
+        p_sys->f_phi = f_phi;
+        p_sys->f_roll = f_roll;
+        p_sys->b_orientationChanged = true;
+    }
+
+    if (f_zoom != p_sys->f_zoom)
+    {
+        p_sys->f_zoom = f_zoom;
+        p_sys->b_zoomChanged = true;
+    }
 }
 
 static int allocateBuffers(filter_sys_t *p_sys)
@@ -405,6 +434,8 @@ static int Open(vlc_object_t *p_this)
     p_sys->f_phi = 0.f;
     p_sys->f_roll = 0.f;
     p_sys->f_zoom = 0.f;
+    p_sys->b_orientationChanged = true;
+    p_sys->b_zoomChanged = true;
     p_sys->i_rate = p_filter->fmt_in.audio.i_rate;
     p_sys->i_inputNb = p_filter->fmt_in.audio.i_channels;
     p_sys->i_outputNb = p_filter->fmt_out.audio.i_channels;
@@ -509,6 +540,13 @@ static int Open(vlc_object_t *p_this)
         return VLC_EGENERIC;
     }
 
+    if (!p_sys->inData.Configure(p_sys->i_order, true, AMB_BLOCK_TIME_LEN))
+    {
+        msg_Err(p_filter, "Error creating the ambisonic buffer.");
+        delete p_sys;
+        return VLC_ENOMEM;
+    }
+
     p_filter->pf_audio_filter = Mix;
     p_filter->pf_flush = Flush;
     p_filter->pf_change_viewpoint = ChangeViewpoint;
@@ -61,8 +61,35 @@ static block_t *Upmix( filter_t *p_filter, block_t *p_in_buf )
 
     assert( i_input_nb < i_output_nb );
 
-    block_t *p_out_buf = block_Alloc(
-                              p_in_buf->i_buffer * i_output_nb / i_input_nb );
+    const size_t i_out_size = p_in_buf->i_buffer * i_output_nb / i_input_nb;
+    const int *channel_map = p_filter->p_sys->channel_map;
+
+    /* Upmix in place, starting from the last frame, if the block has the
+     * room for it */
+    if( p_in_buf->p_buffer + i_out_size <= p_in_buf->p_start + p_in_buf->i_size )
+    {
+        float *p_dest = (float *)p_in_buf->p_buffer
+                      + p_in_buf->i_nb_samples * i_output_nb;
+        const float *p_src = (float *)p_in_buf->p_buffer
+                           + p_in_buf->i_nb_samples * i_input_nb;
+        /* Use an extra buffer to avoid overlapping */
+        float buffer[i_output_nb];
+
+        for( size_t i = 0; i < p_in_buf->i_nb_samples; i++ )
+        {
+            p_src -= i_input_nb;
+            p_dest -= i_output_nb;
+
+            for( unsigned j = 0; j < i_output_nb; j++ )
+                buffer[j] = channel_map[j] == -1 ? 0.f : p_src[channel_map[j]];
+            memcpy( p_dest, buffer, i_output_nb * sizeof(float) );
+        }
+        p_in_buf->i_buffer = i_out_size;
+
+        return p_in_buf;
+    }
+
+    block_t *p_out_buf = block_Alloc( i_out_size );
     if( unlikely(p_out_buf == NULL) )
     {
         block_Release( p_in_buf );
@@ -76,7 +103,6 @@ static block_t *Upmix( filter_t *p_filter, block_t *p_in_buf )
 
     float *p_dest = (float *)p_out_buf->p_buffer;
     const float *p_src = (float *)p_in_buf->p_buffer;
-    const int *channel_map = p_filter->p_sys->channel_map;
 
     for( size_t i = 0; i < p_in_buf->i_nb_samples; i++ )
     {
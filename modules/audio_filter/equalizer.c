@@ -38,10 +38,9 @@
 #include <vlc_aout.h>
 #include <vlc_filter.h>
 
-#include "equalizer_presets.h"
+#include "equalizer_filter.h"
 
 /* TODO:
- *  - optimize a bit (you can hardly do slower ;)
  *  - add tables for more bands (15 and 32 would be cool), maybe with auto coeffs
  *    computation (not too hard once the Q is found).
  *  - support for external preset
@@ -103,31 +102,14 @@ vlc_module_end ()
  *****************************************************************************/
 struct filter_sys_t
 {
-    /* Filter static config */
-    int i_band;
-    float *f_alpha;
-    float *f_beta;
-    float *f_gamma;
-
-    /* Filter dyn config */
-    float *f_amp;   /* Per band amp */
-    float f_gamp;   /* Global preamp */
-    bool b_2eqz;
-
-    /* Filter state */
-    float x[32][2];
-    float y[32][128][2];
-
-    /* Second filter state */
-    float x2[32][2];
-    float y2[32][128][2];
+    eqz_filter_t eqz;
+    eqz_filter_cb pf_filter;
 
     vlc_mutex_t lock;
 };
 
 static block_t *DoWork( filter_t *, block_t * );
 
-#define EQZ_IN_FACTOR (0.25f)
 static int  EqzInit( filter_t *, int );
 static void EqzFilter( filter_t *, float *, float *, int, int );
 static void EqzClean( filter_t * );
@@ -200,143 +182,25 @@ static block_t * DoWork( filter_t * p_filter, block_t * p_in_buf )
 /*****************************************************************************
  * Equalizer stuff
  *****************************************************************************/
-typedef struct
-{
-    int   i_band;
-
-    struct
-    {
-        float f_frequency;
-        float f_alpha;
-        float f_beta;
-        float f_gamma;
-    } band[EQZ_BANDS_MAX];
-
-} eqz_config_t;
-
-/* Equalizer coefficient calculation function based on equ-xmms */
-static void EqzCoeffs( int i_rate, float f_octave_percent,
-                       bool b_use_vlc_freqs,
-                       eqz_config_t *p_eqz_config )
-{
-    const float *f_freq_table_10b = b_use_vlc_freqs
-                                  ? f_vlc_frequency_table_10b
-                                  : f_iso_frequency_table_10b;
-    float f_rate = (float) i_rate;
-    float f_nyquist_freq = 0.5f * f_rate;
-    float f_octave_factor = powf( 2.0f, 0.5f * f_octave_percent );
-    float f_octave_factor_1 = 0.5f * ( f_octave_factor + 1.0f );
-    float f_octave_factor_2 = 0.5f * ( f_octave_factor - 1.0f );
-
-    p_eqz_config->i_band = EQZ_BANDS_MAX;
-
-    for( int i = 0; i < EQZ_BANDS_MAX; i++ )
-    {
-        float f_freq = f_freq_table_10b[i];
-
-        p_eqz_config->band[i].f_frequency = f_freq;
-
-        if( f_freq <= f_nyquist_freq )
-        {
-            float f_theta_1 = ( 2.0f * (float) M_PI * f_freq ) / f_rate;
-            float f_theta_2 = f_theta_1 / f_octave_factor;
-            float f_sin     = sinf( f_theta_2 );
-            float f_sin_prd = sinf( f_theta_2 * f_octave_factor_1 )
-                            * sinf( f_theta_2 * f_octave_factor_2 );
-            float f_sin_hlf = f_sin * 0.5f;
-            float f_den     = f_sin_hlf + f_sin_prd;
-
-            p_eqz_config->band[i].f_alpha = f_sin_prd / f_den;
-            p_eqz_config->band[i].f_beta  = ( f_sin_hlf - f_sin_prd ) / f_den;
-            p_eqz_config->band[i].f_gamma = f_sin * cosf( f_theta_1 ) / f_den;
-        }
-        else
-        {
-            /* Any frequency beyond the Nyquist frequency is no good... */
-            p_eqz_config->band[i].f_alpha =
-            p_eqz_config->band[i].f_beta  =
-            p_eqz_config->band[i].f_gamma = 0.0f;
-        }
-    }
-}
-
-static inline float EqzConvertdB( float db )
-{
-    /* Map it to gain,
-     * (we do as if the input of iir is /EQZ_IN_FACTOR, but in fact it's the non iir data that is *EQZ_IN_FACTOR)
-     * db = 20*log( out / in ) with out = in + amp*iir(i/EQZ_IN_FACTOR)
-     * or iir(i) == i for the center freq so
-     * db = 20*log( 1 + amp/EQZ_IN_FACTOR )
-     * -> amp = EQZ_IN_FACTOR*(10^(db/20) - 1)
-     **/
-
-    if( db < -20.0f )
-        db = -20.0f;
-    else if(  db > 20.0f )
-        db = 20.0f;
-    return EQZ_IN_FACTOR * ( powf( 10.0f, db / 20.0f ) - 1.0f );
-}
-
 static int EqzInit( filter_t *p_filter, int i_rate )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
     eqz_config_t cfg;
-    int i, ch;
+    int i;
     vlc_value_t val1, val2, val3;
     vlc_object_t *p_aout = p_filter->obj.parent;
-    int i_ret = VLC_ENOMEM;
 
     bool b_vlcFreqs = var_InheritBool( p_aout, "equalizer-vlcfreqs" );
     EqzCoeffs( i_rate, 1.0f, b_vlcFreqs, &cfg );
 
-    /* Create the static filter config */
-    p_sys->i_band = cfg.i_band;
-    p_sys->f_alpha = vlc_alloc( p_sys->i_band, sizeof(float) );
-    p_sys->f_beta  = vlc_alloc( p_sys->i_band, sizeof(float) );
-    p_sys->f_gamma = vlc_alloc( p_sys->i_band, sizeof(float) );
-    if( !p_sys->f_alpha || !p_sys->f_beta || !p_sys->f_gamma )
-        goto error;
-
-    for( i = 0; i < p_sys->i_band; i++ )
-    {
-        p_sys->f_alpha[i] = cfg.band[i].f_alpha;
-        p_sys->f_beta[i]  = cfg.band[i].f_beta;
-        p_sys->f_gamma[i] = cfg.band[i].f_gamma;
-    }
-
-    /* Filter dyn config */
-    p_sys->b_2eqz = false;
-    p_sys->f_gamp = 1.0f;
-    p_sys->f_amp  = vlc_alloc( p_sys->i_band, sizeof(float) );
-    if( !p_sys->f_amp )
-        goto error;
-
-    for( i = 0; i < p_sys->i_band; i++ )
-    {
-        p_sys->f_amp[i] = 0.0f;
-    }
-
-    /* Filter state */
-    for( ch = 0; ch < 32; ch++ )
-    {
-        p_sys->x[ch][0]  =
-        p_sys->x[ch][1]  =
-        p_sys->x2[ch][0] =
-        p_sys->x2[ch][1] = 0.0f;
-
-        for( i = 0; i < p_sys->i_band; i++ )
-        {
-            p_sys->y[ch][i][0]  =
-            p_sys->y[ch][i][1]  =
-            p_sys->y2[ch][i][0] =
-            p_sys->y2[ch][i][1] = 0.0f;
-        }
-    }
+    /* Create the static filter config, with a flat response */
+    EqzFilterInit( &p_sys->eqz, &cfg );
+    p_sys->pf_filter = EqzGetFilter();
 
     var_Create( p_aout, "equalizer-bands", VLC_VAR_STRING | VLC_VAR_DOINHERIT );
     var_Create( p_aout, "equalizer-preset", VLC_VAR_STRING | VLC_VAR_DOINHERIT );
 
-    p_sys->b_2eqz = var_CreateGetBool( p_aout, "equalizer-2pass" );
+    p_sys->eqz.b_2eqz = var_CreateGetBool( p_aout, "equalizer-2pass" );
 
     var_Create( p_aout, "equalizer-preamp", VLC_VAR_FLOAT | VLC_VAR_DOINHERIT );
 
@@ -357,9 +221,7 @@ static int EqzInit( filter_t *p_filter, int i_rate )
     {
         msg_Err(p_filter, "No preset selected");
         free( val2.psz_string );
-        free( p_sys->f_amp );
-        i_ret = VLC_EGENERIC;
-        goto error;
+        return VLC_EGENERIC;
     }
     free( val2.psz_string );
 
@@ -370,82 +232,24 @@ static int EqzInit( filter_t *p_filter, int i_rate )
     var_AddCallback( p_aout, "equalizer-2pass", TwoPassCallback, p_sys );
 
     msg_Dbg( p_filter, "equalizer loaded for %d Hz with %d bands %d pass",
-                        i_rate, p_sys->i_band, p_sys->b_2eqz ? 2 : 1 );
-    for( i = 0; i < p_sys->i_band; i++ )
+                        i_rate, p_sys->eqz.i_band, p_sys->eqz.b_2eqz ? 2 : 1 );
+    for( i = 0; i < p_sys->eqz.i_band; i++ )
     {
         msg_Dbg( p_filter, "   %.2f Hz -> factor:%f alpha:%f beta:%f gamma:%f",
-                 cfg.band[i].f_frequency, p_sys->f_amp[i],
-                 p_sys->f_alpha[i], p_sys->f_beta[i], p_sys->f_gamma[i]);
+                 cfg.band[i].f_frequency, p_sys->eqz.f_amp[i],
+                 p_sys->eqz.f_alpha[i], p_sys->eqz.f_beta[i],
+                 p_sys->eqz.f_gamma[i]);
     }
     return VLC_SUCCESS;
-
-error:
-    free( p_sys->f_alpha );
-    free( p_sys->f_beta );
-    free( p_sys->f_gamma );
-    return i_ret;
 }
 
 static void EqzFilter( filter_t *p_filter, float *out, float *in,
                        int i_samples, int i_channels )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
-    int i, ch, j;
 
     vlc_mutex_lock( &p_sys->lock );
-    for( i = 0; i < i_samples; i++ )
-    {
-        for( ch = 0; ch < i_channels; ch++ )
-        {
-            const float x = in[ch];
-            float o = 0.0f;
-
-            for( j = 0; j < p_sys->i_band; j++ )
-            {
-                float y = p_sys->f_alpha[j] * ( x - p_sys->x[ch][1] ) +
-                          p_sys->f_gamma[j] * p_sys->y[ch][j][0] -
-                          p_sys->f_beta[j]  * p_sys->y[ch][j][1];
-
-                p_sys->y[ch][j][1] = p_sys->y[ch][j][0];
-                p_sys->y[ch][j][0] = y;
-
-                o += y * p_sys->f_amp[j];
-            }
-            p_sys->x[ch][1] = p_sys->x[ch][0];
-            p_sys->x[ch][0] = x;
-
-            /* Second filter */
-            if( p_sys->b_2eqz )
-            {
-                const float x2 = EQZ_IN_FACTOR * x + o;
-                o = 0.0f;
-                for( j = 0; j < p_sys->i_band; j++ )
-                {
-                    float y = p_sys->f_alpha[j] * ( x2 - p_sys->x2[ch][1] ) +
-                              p_sys->f_gamma[j] * p_sys->y2[ch][j][0] -
-                              p_sys->f_beta[j]  * p_sys->y2[ch][j][1];
-
-                    p_sys->y2[ch][j][1] = p_sys->y2[ch][j][0];
-                    p_sys->y2[ch][j][0] = y;
-
-                    o += y * p_sys->f_amp[j];
-                }
-                p_sys->x2[ch][1] = p_sys->x2[ch][0];
-                p_sys->x2[ch][0] = x2;
-
-                /* We add source PCM + filtered PCM */
-                out[ch] = p_sys->f_gamp * p_sys->f_gamp *( EQZ_IN_FACTOR * x2 + o );
-            }
-            else
-            {
-                /* We add source PCM + filtered PCM */
-                out[ch] = p_sys->f_gamp *( EQZ_IN_FACTOR * x + o );
-            }
-        }
-
-        in  += i_channels;
-        out += i_channels;
-    }
+    p_sys->pf_filter( &p_sys->eqz, out, in, i_samples, i_channels );
     vlc_mutex_unlock( &p_sys->lock );
 }
 
@@ -458,12 +262,6 @@ static void EqzClean( filter_t *p_filter )
     var_DelCallback( p_aout, "equalizer-preset", PresetCallback, p_sys );
     var_DelCallback( p_aout, "equalizer-preamp", PreampCallback, p_sys );
     var_DelCallback( p_aout, "equalizer-2pass", TwoPassCallback, p_sys );
-
-    free( p_sys->f_alpha );
-    free( p_sys->f_beta );
-    free( p_sys->f_gamma );
-
-    free( p_sys->f_amp );
 }
 
 
@@ -529,7 +327,7 @@ static int PreampCallback( vlc_object_t *p_this, char const *psz_cmd,
         preamp = 10.f;
 
     vlc_mutex_lock( &p_sys->lock );
-    p_sys->f_gamp = preamp;
+    p_sys->eqz.f_gamp = preamp;
     vlc_mutex_unlock( &p_sys->lock );
     return VLC_SUCCESS;
 }
@@ -544,7 +342,7 @@ static int BandsCallback( vlc_object_t *p_this, char const *psz_cmd,
 
     /* Same thing for bands */
     vlc_mutex_lock( &p_sys->lock );
-    while( i < p_sys->i_band )
+    while( i < p_sys->eqz.i_band )
     {
         char *next;
         /* Read dB -20/20 */
@@ -552,14 +350,14 @@ static int BandsCallback( vlc_object_t *p_this, char const *psz_cmd,
         if( next == p || isnan( f ) )
             break; /* no conversion */
 
-        p_sys->f_amp[i++] = EqzConvertdB( f );
+        p_sys->eqz.f_amp[i++] = EqzConvertdB( f );
 
         if( *next == '\0' )
             break; /* end of line */
         p = &next[1];
     }
-    while( i < p_sys->i_band )
-        p_sys->f_amp[i++] = EqzConvertdB( 0.f );
+    while( i < p_sys->eqz.i_band )
+        p_sys->eqz.f_amp[i++] = EqzConvertdB( 0.f );
     vlc_mutex_unlock( &p_sys->lock );
     return VLC_SUCCESS;
 }
@@ -570,7 +368,7 @@ static int TwoPassCallback( vlc_object_t *p_this, char const *psz_cmd,
     filter_sys_t *p_sys = p_data;
 
     vlc_mutex_lock( &p_sys->lock );
-    p_sys->b_2eqz = newval.b_bool;
+    p_sys->eqz.b_2eqz = newval.b_bool;
     vlc_mutex_unlock( &p_sys->lock );
     return VLC_SUCCESS;
 }
@@ -0,0 +1,315 @@
+/*****************************************************************************
+ * equalizer_filter.h: equalizer bands filtering
+ *****************************************************************************
+ * Copyright (C) 2004-2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_EQUALIZER_FILTER_H_
+#define VLC_EQUALIZER_FILTER_H_
+
+#include <math.h>
+#include <vlc_cpu.h>
+
+#include "equalizer_presets.h"
+
+#if defined(HAVE_SSE2_INTRINSICS)
+# include <emmintrin.h>
+#endif
+#if defined(HAVE_AVX2_INTRINSICS)
+# include <immintrin.h>
+#endif
+#if defined(__ARM_NEON)
+# include <arm_neon.h>
+#endif
+
+#define EQZ_IN_FACTOR (0.25f)
+
+/* Bands rounded up to the widest vectors, the extra bands having null
+ * coefficients */
+#define EQZ_LANES 16
+#define EQZ_CHANNELS_MAX 32
+
+static_assert(EQZ_BANDS_MAX <= EQZ_LANES, "Too many bands");
+
+/* Coefficients and state of the filter, the bands being stored
+ * contiguously so that they can be processed in vector lanes */
+typedef struct
+{
+    /* Filter static config */
+    int i_band;
+    float f_alpha[EQZ_LANES];
+    float f_beta[EQZ_LANES];
+    float f_gamma[EQZ_LANES];
+
+    /* Filter dyn config */
+    float f_amp[EQZ_LANES];   /* Per band amp */
+    float f_gamp;   /* Global preamp */
+    bool b_2eqz;
+
+    /* Filter state: the two last inputs, and per band the two last outputs */
+    float x[EQZ_CHANNELS_MAX][2];
+    float y[EQZ_CHANNELS_MAX][2][EQZ_LANES];
+
+    /* Second filter state */
+    float x2[EQZ_CHANNELS_MAX][2];
+    float y2[EQZ_CHANNELS_MAX][2][EQZ_LANES];
+} eqz_filter_t;
+
+typedef void (*eqz_filter_cb)( eqz_filter_t *, float *, const float *,
+                               int, int );
+
+typedef struct
+{
+    int   i_band;
+
+    struct
+    {
+        float f_frequency;
+        float f_alpha;
+        float f_beta;
+        float f_gamma;
+    } band[EQZ_BANDS_MAX];
+
+} eqz_config_t;
+
+/* Equalizer coefficient calculation function based on equ-xmms */
+static inline void EqzCoeffs( int i_rate, float f_octave_percent,
+                              bool b_use_vlc_freqs,
+                              eqz_config_t *p_eqz_config )
+{
+    const float *f_freq_table_10b = b_use_vlc_freqs
+                                  ? f_vlc_frequency_table_10b
+                                  : f_iso_frequency_table_10b;
+    float f_rate = (float) i_rate;
+    float f_nyquist_freq = 0.5f * f_rate;
+    float f_octave_factor = powf( 2.0f, 0.5f * f_octave_percent );
+    float f_octave_factor_1 = 0.5f * ( f_octave_factor + 1.0f );
+    float f_octave_factor_2 = 0.5f * ( f_octave_factor - 1.0f );
+
+    p_eqz_config->i_band = EQZ_BANDS_MAX;
+
+    for( int i = 0; i < EQZ_BANDS_MAX; i++ )
+    {
+        float f_freq = f_freq_table_10b[i];
+
+        p_eqz_config->band[i].f_frequency = f_freq;
+
+        if( f_freq <= f_nyquist_freq )
+        {
+            float f_theta_1 = ( 2.0f * (float) M_PI * f_freq ) / f_rate;
+            float f_theta_2 = f_theta_1 / f_octave_factor;
+            float f_sin     = sinf( f_theta_2 );
+            float f_sin_prd = sinf( f_theta_2 * f_octave_factor_1 )
+                            * sinf( f_theta_2 * f_octave_factor_2 );
+            float f_sin_hlf = f_sin * 0.5f;
+            float f_den     = f_sin_hlf + f_sin_prd;
+
+            p_eqz_config->band[i].f_alpha = f_sin_prd / f_den;
+            p_eqz_config->band[i].f_beta  = ( f_sin_hlf - f_sin_prd ) / f_den;
+            p_eqz_config->band[i].f_gamma = f_sin * cosf( f_theta_1 ) / f_den;
+        }
+        else
+        {
+            /* Any frequency beyond the Nyquist frequency is no good... */
+            p_eqz_config->band[i].f_alpha =
+            p_eqz_config->band[i].f_beta  =
+            p_eqz_config->band[i].f_gamma = 0.0f;
+        }
+    }
+}
+
+static inline float EqzConvertdB( float db )
+{
+    /* Map it to gain,
+     * (we do as if the input of iir is /EQZ_IN_FACTOR, but in fact it's the non iir data that is *EQZ_IN_FACTOR)
+     * db = 20*log( out / in ) with out = in + amp*iir(i/EQZ_IN_FACTOR)
+     * or iir(i) == i for the center freq so
+     * db = 20*log( 1 + amp/EQZ_IN_FACTOR )
+     * -> amp = EQZ_IN_FACTOR*(10^(db/20) - 1)
+     **/
+
+    if( db < -20.0f )
+        db = -20.0f;
+    else if(  db > 20.0f )
+        db = 20.0f;
+    return EQZ_IN_FACTOR * ( powf( 10.0f, db / 20.0f ) - 1.0f );
+}
+
+/* Sets the coefficients, with a flat response, and clears the state */
+static inline void EqzFilterInit( eqz_filter_t *p_eqz,
+                                  const eqz_config_t *p_cfg )
+{
+    memset( p_eqz, 0, sizeof( *p_eqz ) );
+
+    p_eqz->i_band = p_cfg->i_band;
+    for( int i = 0; i < p_eqz->i_band; i++ )
+    {
+        p_eqz->f_alpha[i] = p_cfg->band[i].f_alpha;
+        p_eqz->f_beta[i]  = p_cfg->band[i].f_beta;
+        p_eqz->f_gamma[i] = p_cfg->band[i].f_gamma;
+    }
+    p_eqz->f_gamp = 1.0f;
+}
+
+static void EqzFilterC( eqz_filter_t *p_eqz, float *out, const float *in,
+                        int i_samples, int i_channels )
+{
+    int i, ch, j;
+
+    for( i = 0; i < i_samples; i++ )
+    {
+        for( ch = 0; ch < i_channels; ch++ )
+        {
+            const float x = in[ch];
+            float o = 0.0f;
+
+            for( j = 0; j < p_eqz->i_band; j++ )
+            {
+                float y = p_eqz->f_alpha[j] * ( x - p_eqz->x[ch][1] ) +
+                          p_eqz->f_gamma[j] * p_eqz->y[ch][0][j] -
+                          p_eqz->f_beta[j]  * p_eqz->y[ch][1][j];
+
+                p_eqz->y[ch][1][j] = p_eqz->y[ch][0][j];
+                p_eqz->y[ch][0][j] = y;
+
+                o += y * p_eqz->f_amp[j];
+            }
+            p_eqz->x[ch][1] = p_eqz->x[ch][0];
+            p_eqz->x[ch][0] = x;
+
+            /* Second filter */
+            if( p_eqz->b_2eqz )
+            {
+                const float x2 = EQZ_IN_FACTOR * x + o;
+                o = 0.0f;
+                for( j = 0; j < p_eqz->i_band; j++ )
+                {
+                    float y = p_eqz->f_alpha[j] * ( x2 - p_eqz->x2[ch][1] ) +
+                              p_eqz->f_gamma[j] * p_eqz->y2[ch][0][j] -
+                              p_eqz->f_beta[j]  * p_eqz->y2[ch][1][j];
+
+                    p_eqz->y2[ch][1][j] = p_eqz->y2[ch][0][j];
+                    p_eqz->y2[ch][0][j] = y;
+
+                    o += y * p_eqz->f_amp[j];
+                }
+                p_eqz->x2[ch][1] = p_eqz->x2[ch][0];
+                p_eqz->x2[ch][0] = x2;
+
+                /* We add source PCM + filtered PCM */
+                out[ch] = p_eqz->f_gamp * p_eqz->f_gamp *( EQZ_IN_FACTOR * x2 + o );
+            }
+            else
+            {
+                /* We add source PCM + filtered PCM */
+                out[ch] = p_eqz->f_gamp *( EQZ_IN_FACTOR * x + o );
+            }
+        }
+
+        in  += i_channels;
+        out += i_channels;
+    }
+}
+
+#if defined(HAVE_SSE2_INTRINSICS)
+# define EQZ_TARGET __attribute__((__target__("sse2")))
+# define EQZ_FUNC(name) name##SSE2
+# define V __m128
+# define V_N 4
+# define V_SET1(f) _mm_set1_ps(f)
+# define V_LOAD(p) _mm_loadu_ps(p)
+# define V_STORE(p, v) _mm_storeu_ps(p, v)
+# define V_ADD(a, b) _mm_add_ps(a, b)
+# define V_SUB(a, b) _mm_sub_ps(a, b)
+# define V_MUL(a, b) _mm_mul_ps(a, b)
+static inline EQZ_TARGET float EqzHsumSSE2( __m128 v )
+{
+    v = _mm_add_ps( v, _mm_movehl_ps( v, v ) );
+    v = _mm_add_ss( v, _mm_shuffle_ps( v, v, 1 ) );
+    return _mm_cvtss_f32( v );
+}
+# define V_HSUM(v) EqzHsumSSE2(v)
+# include "equalizer_simd.h"
+#endif
+
+#if defined(HAVE_AVX2_INTRINSICS)
+/* Only AVX is needed, but the build system checks for the AVX2 support */
+# define EQZ_TARGET __attribute__((__target__("avx")))
+# define EQZ_FUNC(name) name##AVX
+# define V __m256
+# define V_N 8
+# define V_SET1(f) _mm256_set1_ps(f)
+# define V_LOAD(p) _mm256_loadu_ps(p)
+# define V_STORE(p, v) _mm256_storeu_ps(p, v)
+# define V_ADD(a, b) _mm256_add_ps(a, b)
+# define V_SUB(a, b) _mm256_sub_ps(a, b)
+# define V_MUL(a, b) _mm256_mul_ps(a, b)
+static inline EQZ_TARGET float EqzHsumAVX( __m256 v )
+{
+    __m128 h = _mm_add_ps( _mm256_castps256_ps128( v ),
+                           _mm256_extractf128_ps( v, 1 ) );
+    h = _mm_add_ps( h, _mm_movehl_ps( h, h ) );
+    h = _mm_add_ss( h, _mm_shuffle_ps( h, h, 1 ) );
+    return _mm_cvtss_f32( h );
+}
+# define V_HSUM(v) EqzHsumAVX(v)
+# include "equalizer_simd.h"
+#endif
+
+#if defined(__ARM_NEON)
+# define EQZ_TARGET
+# define EQZ_FUNC(name) name##NEON
+# define V float32x4_t
+# define V_N 4
+# define V_SET1(f) vdupq_n_f32(f)
+# define V_LOAD(p) vld1q_f32(p)
+# define V_STORE(p, v) vst1q_f32(p, v)
+# define V_ADD(a, b) vaddq_f32(a, b)
+# define V_SUB(a, b) vsubq_f32(a, b)
+# define V_MUL(a, b) vmulq_f32(a, b)
+static inline float EqzHsumNEON( float32x4_t v )
+{
+# if defined(__aarch64__)
+    return vaddvq_f32( v );
+# else
+    float32x2_t h = vadd_f32( vget_low_f32( v ), vget_high_f32( v ) );
+    return vget_lane_f32( vpadd_f32( h, h ), 0 );
+# endif
+}
+# define V_HSUM(v) EqzHsumNEON(v)
+# include "equalizer_simd.h"
+#endif
+
+/* Returns the fastest filter for the CPU */
+static inline eqz_filter_cb EqzGetFilter( void )
+{
+#if defined(HAVE_AVX2_INTRINSICS)
+    if( vlc_CPU_AVX() )
+        return EqzFilterAVX;
+#endif
+#if defined(HAVE_SSE2_INTRINSICS)
+    if( vlc_CPU_SSE2() )
+        return EqzFilterSSE2;
+#endif
+#if defined(__ARM_NEON)
+    return EqzFilterNEON;
+#else
+    return EqzFilterC;
+#endif
+}
+
+#endif
@@ -0,0 +1,130 @@
+/*****************************************************************************
+ * equalizer_simd.h: vectorized equalizer bands filtering
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* This file is included once per instruction set by equalizer_filter.h,
+ * with:
+ *  - EQZ_TARGET, the function attribute enabling the instruction set,
+ *  - EQZ_FUNC(name), the name of the instantiated functions,
+ *  - V, a vector of V_N floats, and its V_* operations.
+ * The bands are processed in the vector lanes, and the channels one after
+ * the other so that their state stays in registers. Only the order in which
+ * the bands are summed differs from the generic filter. */
+
+#define EQZ_VECTORS (EQZ_LANES / V_N)
+
+static inline EQZ_TARGET
+float EQZ_FUNC(EqzBands)( int i_vec, float f_dx, const V *alpha,
+                          const V *beta, const V *gamma, const V *amp,
+                          V *y0, V *y1 )
+{
+    const V dx = V_SET1( f_dx );
+    V o = V_SET1( 0.0f );
+
+    for( int v = 0; v < i_vec; v++ )
+    {
+        V y = V_SUB( V_ADD( V_MUL( alpha[v], dx ), V_MUL( gamma[v], y0[v] ) ),
+                     V_MUL( beta[v], y1[v] ) );
+        y1[v] = y0[v];
+        y0[v] = y;
+        o = V_ADD( o, V_MUL( y, amp[v] ) );
+    }
+    return V_HSUM( o );
+}
+
+static EQZ_TARGET
+void EQZ_FUNC(EqzFilter)( eqz_filter_t *p_eqz, float *out, const float *in,
+                          int i_samples, int i_channels )
+{
+    const int i_vec = ( p_eqz->i_band + V_N - 1 ) / V_N;
+    const float f_gamp = p_eqz->f_gamp;
+    V alpha[EQZ_VECTORS], beta[EQZ_VECTORS], gamma[EQZ_VECTORS];
+    V amp[EQZ_VECTORS];
+
+    for( int v = 0; v < i_vec; v++ )
+    {
+        alpha[v] = V_LOAD( &p_eqz->f_alpha[v * V_N] );
+        beta[v]  = V_LOAD( &p_eqz->f_beta[v * V_N] );
+        gamma[v] = V_LOAD( &p_eqz->f_gamma[v * V_N] );
+        amp[v]   = V_LOAD( &p_eqz->f_amp[v * V_N] );
+    }
+
+    for( int ch = 0; ch < i_channels; ch++ )
+    {
+        V y0[EQZ_VECTORS], y1[EQZ_VECTORS], z0[EQZ_VECTORS], z1[EQZ_VECTORS];
+        float x0 = p_eqz->x[ch][0], x1 = p_eqz->x[ch][1];
+        float w0 = p_eqz->x2[ch][0], w1 = p_eqz->x2[ch][1];
+
+        for( int v = 0; v < i_vec; v++ )
+        {
+            y0[v] = V_LOAD( &p_eqz->y[ch][0][v * V_N] );
+            y1[v] = V_LOAD( &p_eqz->y[ch][1][v * V_N] );
+            z0[v] = V_LOAD( &p_eqz->y2[ch][0][v * V_N] );
+            z1[v] = V_LOAD( &p_eqz->y2[ch][1][v * V_N] );
+        }
+
+        for( int i = 0; i < i_samples; i++ )
+        {
+            const float x = in[i * i_channels + ch];
+            float o = EQZ_FUNC(EqzBands)( i_vec, x - x1, alpha, beta, gamma,
+                                          amp, y0, y1 );
+            x1 = x0;
+            x0 = x;
+
+            if( p_eqz->b_2eqz )
+            {
+                const float x2 = EQZ_IN_FACTOR * x + o;
+                o = EQZ_FUNC(EqzBands)( i_vec, x2 - w1, alpha, beta, gamma,
+                                        amp, z0, z1 );
+                w1 = w0;
+                w0 = x2;
+
+                out[i * i_channels + ch] = f_gamp * f_gamp
+                                         * ( EQZ_IN_FACTOR * x2 + o );
+            }
+            else
+                out[i * i_channels + ch] = f_gamp * ( EQZ_IN_FACTOR * x + o );
+        }
+
+        for( int v = 0; v < i_vec; v++ )
+        {
+            V_STORE( &p_eqz->y[ch][0][v * V_N], y0[v] );
+            V_STORE( &p_eqz->y[ch][1][v * V_N], y1[v] );
+            V_STORE( &p_eqz->y2[ch][0][v * V_N], z0[v] );
+            V_STORE( &p_eqz->y2[ch][1][v * V_N], z1[v] );
+        }
+        p_eqz->x[ch][0] = x0;
+        p_eqz->x[ch][1] = x1;
+        p_eqz->x2[ch][0] = w0;
+        p_eqz->x2[ch][1] = w1;
+    }
+}
+
+#undef EQZ_VECTORS
+#undef EQZ_TARGET
+#undef EQZ_FUNC
+#undef V
+#undef V_N
+#undef V_SET1
+#undef V_LOAD
+#undef V_STORE
+#undef V_ADD
+#undef V_SUB
+#undef V_MUL
+#undef V_HSUM
@@ -0,0 +1,202 @@
+/*****************************************************************************
+ * polyphase.c : polyphase FIR resampler
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Preamble:
+ *
+ * The input is filtered by a Kaiser-windowed sinc low-pass filter, computed
+ * as a bank of phases for the nominal rates. The small rate adjustments
+ * requested by the audio output only change the phases step, the
+ * coefficients being interpolated between the phases.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_aout.h>
+#include <vlc_filter.h>
+#include <vlc_block.h>
+
+#include "polyphase.h"
+
+/*****************************************************************************
+ * Local prototypes
+ *****************************************************************************/
+static int  OpenConverter( vlc_object_t * );
+static int  OpenResampler( vlc_object_t * );
+static void Close( vlc_object_t * );
+static block_t *Resample( filter_t *, block_t * );
+static block_t *Drain( filter_t * );
+static void     Flush( filter_t * );
+
+struct filter_sys_t
+{
+    poly_resampler_t poly;
+};
+
+/*****************************************************************************
+ * Module descriptor
+ *****************************************************************************/
+vlc_module_begin ()
+    set_shortname( N_("Polyphase resampler") )
+    set_description( N_("Polyphase FIR audio resampler") )
+    set_category( CAT_AUDIO )
+    set_subcategory( SUBCAT_AUDIO_RESAMPLER )
+    set_capability( "audio converter", 10 )
+    set_callbacks( OpenConverter, Close )
+
+    add_submodule()
+    set_capability( "audio resampler", 10 )
+    set_callbacks( OpenResampler, Close )
+    add_shortcut( "polyphase" )
+vlc_module_end ()
+
+static int OpenResampler( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+
+    if( p_filter->fmt_in.audio.i_format != VLC_CODEC_FL32
+     || p_filter->fmt_out.audio.i_format != VLC_CODEC_FL32
+     || p_filter->fmt_in.audio.i_channels != p_filter->fmt_out.audio.i_channels
+     || p_filter->fmt_in.audio.i_channels == 0 )
+        return VLC_EGENERIC;
+
+    filter_sys_t *p_sys = malloc( sizeof (*p_sys) );
+    if( unlikely(p_sys == NULL) )
+        return VLC_ENOMEM;
+
+    if( PolyInit( &p_sys->poly, p_filter->fmt_in.audio.i_channels,
+                  p_filter->fmt_in.audio.i_rate,
+                  p_filter->fmt_out.audio.i_rate ) != VLC_SUCCESS )
+    {
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+
+    msg_Dbg( p_filter, "%uHz to %uHz, %u phases of %u taps",
+             p_filter->fmt_in.audio.i_rate, p_filter->fmt_out.audio.i_rate,
+             p_sys->poly.i_phases, p_sys->poly.i_taps );
+
+    p_filter->p_sys = p_sys;
+    p_filter->pf_audio_filter = Resample;
+    p_filter->pf_audio_drain = Drain;
+    p_filter->pf_flush = Flush;
+    return VLC_SUCCESS;
+}
+
+static int OpenConverter( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+
+    /* Will change rate */
+    if( p_filter->fmt_in.audio.i_rate == p_filter->fmt_out.audio.i_rate )
+        return VLC_EGENERIC;
+    return OpenResampler( p_this );
+}
+
+static void Close( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    PolyClean( &p_sys->poly );
+    free( p_sys );
+}
+
+static block_t *Process( filter_t *p_filter, block_t *p_in,
+                         const float *p_samples, size_t i_frames,
+                         mtime_t i_pts )
+{
+    poly_resampler_t *p_poly = &p_filter->p_sys->poly;
+    const unsigned i_in_rate = p_filter->fmt_in.audio.i_rate;
+    const unsigned i_out_rate = p_filter->fmt_out.audio.i_rate;
+    block_t *p_out;
+
+    i_pts -= PolyGetDelay( p_poly, i_in_rate ) * CLOCK_FREQ / i_in_rate;
+
+    if( p_in != NULL && PolyCanBypass( p_poly, i_in_rate ) )
+        p_out = p_in;
+    else
+    {
+        p_out = block_Alloc( PolyGetOutLen( p_poly, i_frames, i_in_rate )
+                             * p_filter->fmt_out.audio.i_bytes_per_frame );
+        if( unlikely(p_out == NULL) )
+            goto out;
+    }
+
+    p_out->i_nb_samples = PolyProcess( p_poly, (float *)p_out->p_buffer,
+                                       p_samples, i_frames, i_in_rate );
+    p_out->i_buffer = p_out->i_nb_samples
+                    * p_filter->fmt_out.audio.i_bytes_per_frame;
+    p_out->i_pts = i_pts;
+    p_out->i_length = p_out->i_nb_samples * CLOCK_FREQ / i_out_rate;
+out:
+    if( p_in != NULL && p_in != p_out )
+        block_Release( p_in );
+    return p_out;
+}
+
+static block_t *Resample( filter_t *p_filter, block_t *p_in )
+{
+    if( p_in->i_flags & BLOCK_FLAG_DISCONTINUITY )
+        Flush( p_filter );
+
+    return Process( p_filter, p_in, (const float *)p_in->p_buffer,
+                    p_in->i_nb_samples, p_in->i_pts );
+}
+
+static block_t *Drain( filter_t *p_filter )
+{
+    poly_resampler_t *p_poly = &p_filter->p_sys->poly;
+    block_t *p_out = NULL;
+
+    /* Push the silence following the input until the last input frame is
+     * output, or only output the pending frames if not resampling */
+    const size_t i_frames =
+        p_filter->fmt_in.audio.i_rate != p_filter->fmt_out.audio.i_rate
+        ? p_poly->i_wing : 0;
+    float *p_zero = calloc( i_frames * p_poly->i_channels + 1,
+                            sizeof (float) );
+    if( unlikely(p_zero == NULL) )
+        return NULL;
+
+    p_out = Process( p_filter, NULL, p_zero, i_frames, VLC_TS_INVALID );
+    free( p_zero );
+    if( p_out != NULL )
+    {
+        /* The time following the last input frame is not known */
+        p_out->i_pts = VLC_TS_INVALID;
+        if( p_out->i_nb_samples == 0 )
+        {
+            block_Release( p_out );
+            p_out = NULL;
+        }
+    }
+    PolyFlush( p_poly );
+    return p_out;
+}
+
+static void Flush( filter_t *p_filter )
+{
+    PolyFlush( &p_filter->p_sys->poly );
+}
@@ -0,0 +1,438 @@
+/*****************************************************************************
+ * polyphase.h: polyphase FIR resampling
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_POLYPHASE_H_
+#define VLC_POLYPHASE_H_
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vlc_cpu.h>
+
+#if defined(HAVE_SSE2_INTRINSICS)
+# include <emmintrin.h>
+#endif
+#if defined(HAVE_AVX2_INTRINSICS)
+# include <immintrin.h>
+#endif
+#if defined(__ARM_NEON)
+# include <arm_neon.h>
+#endif
+
+/* Half the filter length when upsampling, in input frames: the filter is
+ * stretched by the ratio when downsampling, to keep the same transition band
+ * at the output rate */
+#define POLY_WING 32
+/* The taps are rounded up to the widest vectors, the extra ones being null */
+#define POLY_TAPS_ALIGN 8
+#define POLY_TAPS_MAX 256
+/* Phases when they are interpolated, and the limit for them not to be */
+#define POLY_PHASES 256
+#define POLY_PHASES_MIN 128
+#define POLY_PHASES_MAX 512
+/* Kaiser window beta, for about 80 dB of stop band attenuation */
+#define POLY_BETA 8.0
+/* Cut-off frequency, relative to the lowest Nyquist frequency */
+#define POLY_CUTOFF 0.92
+
+/* Computes an output frame for the i_channels planes of input frames, the
+ * coefficients being interpolated between two phases by f_mu */
+typedef void (*poly_frame_cb)( float *, const float *, const float *, float,
+                               const float *, size_t, unsigned, unsigned );
+
+typedef struct
+{
+    /* Filter bank: i_phases + 1 phases of i_taps coefficients, the last one
+     * being the first one delayed by a frame, for the interpolation */
+    unsigned i_phases;
+    unsigned i_taps;
+    float *p_bank;
+    poly_frame_cb pf_frame;
+
+    unsigned i_channels;
+    unsigned i_out_rate;
+
+    /* Input history, per channel planes of i_size frames. The first frame is
+     * the first tap of the next output frame, which is located at
+     * i_wing - 1 + i_frac / i_out_rate. */
+    float *p_planes;
+    size_t i_size;
+    size_t i_frames;
+    unsigned i_wing;
+    unsigned i_frac;
+} poly_resampler_t;
+
+static inline double PolyBesselI0( double x )
+{
+    double sum = 1., term = 1.;
+
+    for( unsigned k = 1; term > sum * 1e-12; k++ )
+    {
+        const double t = x / ( 2 * k );
+        term *= t * t;
+        sum += term;
+    }
+    return sum;
+}
+
+static unsigned PolyGCD( unsigned a, unsigned b )
+{
+    while( b != 0 )
+    {
+        unsigned r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+/* Computes the filter bank. The bank holds a multiple of the phases of the
+ * rational ratio if it is not too large, as for the usual 44.1, 48 and
+ * 96 kHz rates, so that the coefficients need no interpolation at the
+ * nominal ratio. */
+static int PolyBankInit( poly_resampler_t *p_poly, unsigned i_in_rate,
+                         unsigned i_out_rate )
+{
+    const unsigned i_l = i_out_rate / PolyGCD( i_in_rate, i_out_rate );
+    const double f_ratio = (double)i_out_rate / i_in_rate;
+    const double f_scale = f_ratio < 1. ? f_ratio : 1.;
+
+    if( i_l <= POLY_PHASES_MAX )
+        p_poly->i_phases = i_l * ( ( POLY_PHASES_MIN + i_l - 1 ) / i_l );
+    else
+        p_poly->i_phases = POLY_PHASES;
+
+    unsigned i_wing = ceil( POLY_WING / f_scale );
+    i_wing = ( i_wing + POLY_TAPS_ALIGN / 2 - 1 ) / ( POLY_TAPS_ALIGN / 2 )
+           * ( POLY_TAPS_ALIGN / 2 );
+    if( i_wing > POLY_TAPS_MAX / 2 )
+        i_wing = POLY_TAPS_MAX / 2;
+    p_poly->i_wing = i_wing;
+    p_poly->i_taps = 2 * i_wing;
+
+    const unsigned i_taps = p_poly->i_taps;
+    float *p_bank = vlc_alloc( ( p_poly->i_phases + 1 ) * i_taps,
+                               sizeof (float) );
+    if( unlikely(p_bank == NULL) )
+        return VLC_ENOMEM;
+
+    const double f_cutoff = POLY_CUTOFF * f_scale;
+    const double f_i0beta = PolyBesselI0( POLY_BETA );
+
+    for( unsigned p = 0; p <= p_poly->i_phases; p++ )
+    {
+        float *h = &p_bank[p * i_taps];
+        double f_sum = 0.;
+
+        /* Tap k is at k + 1 - i_wing - p / i_phases input frames from the
+         * output frame */
+        for( unsigned k = 0; k < i_taps; k++ )
+        {
+            const double t = (double)k + 1 - i_wing
+                           - (double)p / p_poly->i_phases;
+            const double w = t / i_wing;
+            double f_coef = 0.;
+
+            if( w > -1. && w < 1. )
+            {
+                const double x = M_PI * f_cutoff * t;
+                f_coef = f_cutoff * ( x != 0. ? sin( x ) / x : 1. )
+                       * PolyBesselI0( POLY_BETA * sqrt( 1. - w * w ) )
+                       / f_i0beta;
+            }
+            h[k] = f_coef;
+            f_sum += f_coef;
+        }
+
+        /* Unity gain for every phase */
+        for( unsigned k = 0; k < i_taps; k++ )
+            h[k] /= f_sum;
+    }
+    p_poly->p_bank = p_bank;
+    return VLC_SUCCESS;
+}
+
+/* Reference filter */
+static void PolyFrameC( float *out, const float *h0, const float *h1,
+                        float f_mu, const float *in, size_t i_stride,
+                        unsigned i_channels, unsigned i_taps )
+{
+    float h[POLY_TAPS_MAX];
+
+    if( f_mu != 0.f )
+    {
+        for( unsigned k = 0; k < i_taps; k++ )
+            h[k] = h0[k] + f_mu * ( h1[k] - h0[k] );
+        h0 = h;
+    }
+
+    for( unsigned c = 0; c < i_channels; c++ )
+    {
+        const float *x = &in[c * i_stride];
+        float f_sum = 0.f;
+
+        for( unsigned k = 0; k < i_taps; k++ )
+            f_sum += h0[k] * x[k];
+        out[c] = f_sum;
+    }
+}
+
+#if defined(HAVE_SSE2_INTRINSICS)
+# define POLY_TARGET __attribute__((__target__("sse2")))
+# define POLY_FUNC(name) name##SSE2
+# define V __m128
+# define V_N 4
+# define V_SET1(f) _mm_set1_ps(f)
+# define V_ZERO() _mm_setzero_ps()
+# define V_LOAD(p) _mm_loadu_ps(p)
+# define V_STORE(p, v) _mm_storeu_ps(p, v)
+# define V_ADD(a, b) _mm_add_ps(a, b)
+# define V_SUB(a, b) _mm_sub_ps(a, b)
+# define V_MUL(a, b) _mm_mul_ps(a, b)
+static inline POLY_TARGET float PolyHsumSSE2( __m128 v )
+{
+    v = _mm_add_ps( v, _mm_movehl_ps( v, v ) );
+    v = _mm_add_ss( v, _mm_shuffle_ps( v, v, 1 ) );
+    return _mm_cvtss_f32( v );
+}
+# define V_HSUM(v) PolyHsumSSE2(v)
+# include "polyphase_simd.h"
+#endif
+
+#if defined(HAVE_AVX2_INTRINSICS)
+/* Only AVX is needed, but the build system checks for the AVX2 support */
+# define POLY_TARGET __attribute__((__target__("avx")))
+# define POLY_FUNC(name) name##AVX
+# define V __m256
+# define V_N 8
+# define V_SET1(f) _mm256_set1_ps(f)
+# define V_ZERO() _mm256_setzero_ps()
+# define V_LOAD(p) _mm256_loadu_ps(p)
+# define V_STORE(p, v) _mm256_storeu_ps(p, v)
+# define V_ADD(a, b) _mm256_add_ps(a, b)
+# define V_SUB(a, b) _mm256_sub_ps(a, b)
+# define V_MUL(a, b) _mm256_mul_ps(a, b)
+static inline POLY_TARGET float PolyHsumAVX( __m256 v )
+{
+    __m128 h = _mm_add_ps( _mm256_castps256_ps128( v ),
+                           _mm256_extractf128_ps( v, 1 ) );
+    h = _mm_add_ps( h, _mm_movehl_ps( h, h ) );
+    h = _mm_add_ss( h, _mm_shuffle_ps( h, h, 1 ) );
+    return _mm_cvtss_f32( h );
+}
+# define V_HSUM(v) PolyHsumAVX(v)
+# include "polyphase_simd.h"
+#endif
+
+#if defined(__ARM_NEON)
+# define POLY_TARGET
+# define POLY_FUNC(name) name##NEON
+# define V float32x4_t
+# define V_N 4
+# define V_SET1(f) vdupq_n_f32(f)
+# define V_ZERO() vdupq_n_f32(0.f)
+# define V_LOAD(p) vld1q_f32(p)
+# define V_STORE(p, v) vst1q_f32(p, v)
+# define V_ADD(a, b) vaddq_f32(a, b)
+# define V_SUB(a, b) vsubq_f32(a, b)
+# define V_MUL(a, b) vmulq_f32(a, b)
+static inline float PolyHsumNEON( float32x4_t v )
+{
+# if defined(__aarch64__)
+    return vaddvq_f32( v );
+# else
+    float32x2_t h = vadd_f32( vget_low_f32( v ), vget_high_f32( v ) );
+    return vget_lane_f32( vpadd_f32( h, h ), 0 );
+# endif
+}
+# define V_HSUM(v) PolyHsumNEON(v)
+# include "polyphase_simd.h"
+#endif
+
+/* Returns the fastest filter for the CPU */
+static inline poly_frame_cb PolyGetFrame( void )
+{
+#if defined(HAVE_AVX2_INTRINSICS)
+    if( vlc_CPU_AVX() )
+        return PolyFrameAVX;
+#endif
+#if defined(HAVE_SSE2_INTRINSICS)
+    if( vlc_CPU_SSE2() )
+        return PolyFrameSSE2;
+#endif
+#if defined(__ARM_NEON)
+    return PolyFrameNEON;
+#else
+    return PolyFrameC;
+#endif
+}
+
+/* Clears the history, the first input frame being the next output one */
+static void PolyFlush( poly_resampler_t *p_poly )
+{
+    p_poly->i_frames = p_poly->i_wing - 1;
+    p_poly->i_frac = 0;
+    for( unsigned c = 0; c < p_poly->i_channels; c++ )
+        memset( &p_poly->p_planes[c * p_poly->i_size], 0,
+                p_poly->i_frames * sizeof (float) );
+}
+
+static int PolyInit( poly_resampler_t *p_poly, unsigned i_channels,
+                     unsigned i_in_rate, unsigned i_out_rate )
+{
+    int i_ret = PolyBankInit( p_poly, i_in_rate, i_out_rate );
+    if( i_ret != VLC_SUCCESS )
+        return i_ret;
+
+    p_poly->pf_frame = PolyGetFrame();
+    p_poly->i_channels = i_channels;
+    p_poly->i_out_rate = i_out_rate;
+    p_poly->i_size = 2 * p_poly->i_taps;
+    p_poly->p_planes = vlc_alloc( i_channels * p_poly->i_size,
+                                  sizeof (float) );
+    if( unlikely(p_poly->p_planes == NULL) )
+    {
+        free( p_poly->p_bank );
+        return VLC_ENOMEM;
+    }
+    PolyFlush( p_poly );
+    return VLC_SUCCESS;
+}
+
+static inline void PolyClean( poly_resampler_t *p_poly )
+{
+    free( p_poly->p_planes );
+    free( p_poly->p_bank );
+}
+
+/* Returns whether the input can be output as is, once pushed in the
+ * history */
+static inline bool PolyCanBypass( const poly_resampler_t *p_poly,
+                                  unsigned i_in_rate )
+{
+    return i_in_rate == p_poly->i_out_rate
+        && p_poly->i_frames == p_poly->i_wing - 1;
+}
+
+/* Returns the delay of the next output frame before the next input one, in
+ * input frames */
+static inline double PolyGetDelay( const poly_resampler_t *p_poly,
+                                   unsigned i_in_rate )
+{
+    double f_delay = (double)p_poly->i_frames - ( p_poly->i_wing - 1 );
+    if( i_in_rate != p_poly->i_out_rate )
+        f_delay -= (double)p_poly->i_frac / p_poly->i_out_rate;
+    return f_delay;
+}
+
+/* Returns the maximum number of output frames for i_in input frames */
+static inline size_t PolyGetOutLen( const poly_resampler_t *p_poly,
+                                    size_t i_in, unsigned i_in_rate )
+{
+    return ( p_poly->i_frames + i_in ) * (uint64_t)p_poly->i_out_rate
+           / i_in_rate + 1;
+}
+
+/* Resamples i_in interleaved frames, at the current input rate: the small
+ * rate adjustments only change the step between the phases. The input is
+ * copied as is when the rates are the same, and out can then be in if
+ * PolyCanBypass(). Returns the number of output frames. */
+static size_t PolyProcess( poly_resampler_t *p_poly, float *out,
+                           const float *in, size_t i_in, unsigned i_in_rate )
+{
+    const unsigned i_channels = p_poly->i_channels;
+    const unsigned i_out_rate = p_poly->i_out_rate;
+    const unsigned i_taps = p_poly->i_taps;
+    const bool b_copy = out != in || !PolyCanBypass( p_poly, i_in_rate );
+
+    /* Append the input to the planes */
+    size_t i_avail = p_poly->i_frames + i_in;
+    if( i_avail > p_poly->i_size )
+    {
+        size_t i_size = i_avail + i_taps;
+        float *p_planes = vlc_alloc( i_channels * i_size, sizeof (float) );
+        if( unlikely(p_planes == NULL) )
+            return 0;
+        for( unsigned c = 0; c < i_channels; c++ )
+            memcpy( &p_planes[c * i_size], &p_poly->p_planes[c * p_poly->i_size],
+                    p_poly->i_frames * sizeof (float) );
+        free( p_poly->p_planes );
+        p_poly->p_planes = p_planes;
+        p_poly->i_size = i_size;
+    }
+
+    const size_t i_stride = p_poly->i_size;
+    float *p_planes = p_poly->p_planes;
+
+    for( unsigned c = 0; c < i_channels; c++ )
+    {
+        float *p = &p_planes[c * i_stride + p_poly->i_frames];
+        for( size_t i = 0; i < i_in; i++ )
+            p[i] = in[i * i_channels + c];
+    }
+
+    size_t i_out = 0, i_pos;
+
+    if( i_in_rate == i_out_rate )
+    {
+        /* Output the next frames as they are, dropping the phase */
+        i_pos = i_avail - ( p_poly->i_wing - 1 );
+        p_poly->i_frac = 0;
+        if( b_copy )
+            for( unsigned c = 0; c < i_channels; c++ )
+            {
+                const float *p = &p_planes[c * i_stride + p_poly->i_wing - 1];
+                for( size_t i = 0; i < i_pos; i++ )
+                    out[i * i_channels + c] = p[i];
+            }
+        i_out = i_pos;
+    }
+    else
+    {
+        const unsigned i_phases = p_poly->i_phases;
+        unsigned i_frac = p_poly->i_frac;
+
+        for( i_pos = 0; i_pos + i_taps <= i_avail; i_out++ )
+        {
+            const uint64_t i_phase = (uint64_t)i_frac * i_phases;
+            const float *h0 = &p_poly->p_bank[i_phase / i_out_rate * i_taps];
+            const float f_mu = (float)( i_phase % i_out_rate ) / i_out_rate;
+
+            p_poly->pf_frame( &out[i_out * i_channels], h0, h0 + i_taps, f_mu,
+                              &p_planes[i_pos], i_stride, i_channels, i_taps );
+
+            i_frac += i_in_rate;
+            i_pos += i_frac / i_out_rate;
+            i_frac %= i_out_rate;
+        }
+        p_poly->i_frac = i_frac;
+    }
+    assert( i_pos <= i_avail );
+
+    /* Keep the frames not consumed yet */
+    p_poly->i_frames = i_avail - i_pos;
+    for( unsigned c = 0; c < i_channels; c++ )
+        memmove( &p_planes[c * i_stride], &p_planes[c * i_stride + i_pos],
+                 p_poly->i_frames * sizeof (float) );
+    return i_out;
+}
+
+#endif
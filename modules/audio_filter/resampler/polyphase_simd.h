@@ -0,0 +1,81 @@
+/*****************************************************************************
+ * polyphase_simd.h: vectorized polyphase FIR filter
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* This file is included once per instruction set by polyphase.h, with:
+ *  - POLY_TARGET, the function attribute enabling the instruction set,
+ *  - POLY_FUNC(name), the name of the instantiated functions,
+ *  - V, a vector of V_N floats, and its V_* operations.
+ * The taps are processed in the vector lanes, the channel planes being
+ * contiguous, with two sums to hide the latency of the additions. Only the
+ * order in which the taps are summed differs from the reference filter. */
+
+static POLY_TARGET
+void POLY_FUNC(PolyFrame)( float *out, const float *h0, const float *h1,
+                           float f_mu, const float *in, size_t i_stride,
+                           unsigned i_channels, unsigned i_taps )
+{
+    float h[POLY_TAPS_MAX];
+
+    static_assert( POLY_TAPS_ALIGN % V_N == 0, "Unaligned taps" );
+    assert( i_taps % POLY_TAPS_ALIGN == 0 );
+
+    if( f_mu != 0.f )
+    {
+        const V mu = V_SET1( f_mu );
+
+        for( unsigned k = 0; k < i_taps; k += V_N )
+        {
+            const V a = V_LOAD( &h0[k] );
+            V_STORE( &h[k], V_ADD( a, V_MUL( mu, V_SUB( V_LOAD( &h1[k] ),
+                                                        a ) ) ) );
+        }
+        h0 = h;
+    }
+
+    for( unsigned c = 0; c < i_channels; c++ )
+    {
+        const float *x = &in[c * i_stride];
+        V s0 = V_ZERO(), s1 = V_ZERO();
+        unsigned k = 0;
+
+        for( ; k + 2 * V_N <= i_taps; k += 2 * V_N )
+        {
+            s0 = V_ADD( s0, V_MUL( V_LOAD( &h0[k] ), V_LOAD( &x[k] ) ) );
+            s1 = V_ADD( s1, V_MUL( V_LOAD( &h0[k + V_N] ),
+                                   V_LOAD( &x[k + V_N] ) ) );
+        }
+        if( k < i_taps )
+            s0 = V_ADD( s0, V_MUL( V_LOAD( &h0[k] ), V_LOAD( &x[k] ) ) );
+        out[c] = V_HSUM( V_ADD( s0, s1 ) );
+    }
+}
+
+#undef POLY_TARGET
+#undef POLY_FUNC
+#undef V
+#undef V_N
+#undef V_SET1
+#undef V_ZERO
+#undef V_LOAD
+#undef V_STORE
+#undef V_ADD
+#undef V_SUB
+#undef V_MUL
+#undef V_HSUM
@@ -37,6 +37,7 @@
 
 #include <string.h> /* for memset */
 #include <limits.h> /* form INT_MIN */
+#include <math.h>
 
 /*****************************************************************************
  * Module descriptor
@@ -89,6 +90,8 @@ vlc_module_end ()
  * Scaletempo smooths the overlap further by searching within the input buffer
  * for the best overlap position.  Scaletempo uses a statistical cross correlation
  * (roughly a dot-product).  Scaletempo consumes most of its CPU cycles here.
+ * For long windows, the correlations at all the offsets are computed at once
+ * with FFTs.
  *
  * NOTE:
  * sample: a single audio sample for one channel
@@ -130,6 +133,10 @@ struct filter_sys_t
     void     *buf_pre_corr;
     void     *table_window;
     unsigned(*best_overlap_offset)( filter_t *p_filter );
+    /* FFT cross correlation */
+    unsigned  fft_order;
+    float    *fft_twiddle;
+    float    *buf_fft;
 #ifdef PITCH_SHIFTER
     /* pitch */
     filter_t * resampler;
@@ -140,30 +147,52 @@ struct filter_sys_t
 /*****************************************************************************
  * best_overlap_offset: calculate best offset for overlap
  *****************************************************************************/
+static void pre_correlate_float( filter_sys_t *p )
+{
+    float *pw  = p->table_window;
+    float *po  = (float *)p->buf_overlap + p->samples_per_frame;
+    float *ppc = p->buf_pre_corr;
+    unsigned i;
+
+    for( i = p->samples_per_frame; i < p->samples_overlap; i++ ) {
+      *ppc++ = *pw++ * *po++;
+    }
+}
+
+/* Independent partial sums, so that the compiler can use vector lanes */
+#define CORR_LANES 8
+
+static float dot_product_float( const float *a, const float *b, unsigned n )
+{
+    const unsigned blocks = n / CORR_LANES;
+    float sums[CORR_LANES] = { 0 };
+    float corr = 0;
+
+    for( unsigned k = 0; k < blocks; k++ )
+        for( unsigned j = 0; j < CORR_LANES; j++ )
+            sums[j] += a[k * CORR_LANES + j] * b[k * CORR_LANES + j];
+    for( unsigned i = blocks * CORR_LANES; i < n; i++ )
+        corr += a[i] * b[i];
+
+    for( unsigned j = 0; j < CORR_LANES; j++ )
+        corr += sums[j];
+    return corr;
+}
+
 static unsigned best_overlap_offset_float( filter_t *p_filter )
 {
     filter_sys_t *p = p_filter->p_sys;
-    float *pw, *po, *ppc, *search_start;
+    float *search_start;
     float best_corr = INT_MIN;
     unsigned best_off = 0;
-    unsigned i, off;
+    unsigned off;
 
-    pw  = p->table_window;
-    po  = p->buf_overlap;
-    po += p->samples_per_frame;
-    ppc = p->buf_pre_corr;
-    for( i = p->samples_per_frame; i < p->samples_overlap; i++ ) {
-      *ppc++ = *pw++ * *po++;
-    }
+    pre_correlate_float( p );
 
     search_start = (float *)p->buf_queue + p->samples_per_frame;
     for( off = 0; off < p->frames_search; off++ ) {
-      float corr = 0;
-      float *ps = search_start;
-      ppc = p->buf_pre_corr;
-      for( i = p->samples_per_frame; i < p->samples_overlap; i++ ) {
-        corr += *ppc++ * *ps++;
-      }
+      float corr = dot_product_float( p->buf_pre_corr, search_start,
+                                      p->samples_overlap - p->samples_per_frame );
       if( corr > best_corr ) {
         best_corr = corr;
         best_off  = off;
@@ -174,6 +203,140 @@ static unsigned best_overlap_offset_float( filter_t *p_filter )
     return best_off * p->bytes_per_frame;
 }
 
+/* In place radix-2 FFT of 2^order interleaved complex samples, without
+ * scaling. The twiddles are the first half of the roots of unity. */
+static void fft_float( float *z, unsigned order, const float *tw, bool inverse )
+{
+    const unsigned n = 1u << order;
+    const float sign = inverse ? -1.f : 1.f;
+
+    for( unsigned i = 1, j = 0; i < n; i++ )
+    {
+        unsigned bit = n >> 1;
+        for( ; j & bit; bit >>= 1 )
+            j ^= bit;
+        j |= bit;
+        if( i < j )
+        {
+            float r = z[2 * i], m = z[2 * i + 1];
+            z[2 * i] = z[2 * j]; z[2 * i + 1] = z[2 * j + 1];
+            z[2 * j] = r; z[2 * j + 1] = m;
+        }
+    }
+
+    for( unsigned half = 1, step = n / 2; half < n; half *= 2, step /= 2 )
+    {
+        for( unsigned i = 0; i < n; i += 2 * half )
+        {
+            for( unsigned k = 0; k < half; k++ )
+            {
+                const float wr = tw[2 * k * step];
+                const float wi = sign * tw[2 * k * step + 1];
+                float *a = &z[2 * ( i + k )];
+                float *b = &z[2 * ( i + k + half )];
+                const float tr = b[0] * wr - b[1] * wi;
+                const float ti = b[0] * wi + b[1] * wr;
+                b[0] = a[0] - tr; b[1] = a[1] - ti;
+                a[0] += tr;       a[1] += ti;
+            }
+        }
+    }
+}
+
+static unsigned best_overlap_offset_fft( filter_t *p_filter )
+{
+    filter_sys_t *p = p_filter->p_sys;
+    const unsigned n = 1u << p->fft_order;
+    const unsigned spf = p->samples_per_frame;
+    const unsigned frames_window = p->samples_overlap / spf - 1;
+    const unsigned frames_searched = frames_window + p->frames_search - 1;
+    const float *ppc = p->buf_pre_corr;
+    const float *ps = (float *)p->buf_queue + spf;
+    float *z = p->buf_fft;
+    float *x = p->buf_fft + 2 * n;
+
+    pre_correlate_float( p );
+
+    /* The window and the searched samples of a channel are transformed at
+     * once, as the real and imaginary parts, and the cross spectra of the
+     * channels are summed */
+    memset( x, 0, 2 * n * sizeof(*x) );
+    for( unsigned c = 0; c < spf; c++ )
+    {
+        for( unsigned i = 0; i < n; i++ )
+        {
+            z[2 * i]     = i < frames_window ? ppc[i * spf + c] : 0.f;
+            z[2 * i + 1] = i < frames_searched ? ps[i * spf + c] : 0.f;
+        }
+        fft_float( z, p->fft_order, p->fft_twiddle, false );
+
+        for( unsigned k = 0; k < n; k++ )
+        {
+            const unsigned m = ( n - k ) & ( n - 1 );
+            const float ar = z[2 * k] + z[2 * m];
+            const float ai = z[2 * k + 1] - z[2 * m + 1];
+            const float br = z[2 * k + 1] + z[2 * m + 1];
+            const float bi = z[2 * m] - z[2 * k];
+            x[2 * k]     += ar * br + ai * bi;
+            x[2 * k + 1] += ar * bi - ai * br;
+        }
+    }
+    fft_float( x, p->fft_order, p->fft_twiddle, true );
+
+    /* The real parts are the correlations, up to a positive factor */
+    float best_corr = x[0];
+    unsigned best_off = 0;
+    for( unsigned off = 1; off < p->frames_search; off++ )
+    {
+        if( x[2 * off] > best_corr )
+        {
+            best_corr = x[2 * off];
+            best_off  = off;
+        }
+    }
+
+    return best_off * p->bytes_per_frame;
+}
+
+/* Selects the FFT correlation if it needs fewer operations than the direct
+ * one, the cost of a butterfly being measured as a few multiply-adds */
+#define CORR_FFT_COST 40
+
+static int init_fft( filter_sys_t *p, unsigned frames_window )
+{
+    unsigned frames = frames_window + p->frames_search - 1;
+    unsigned order = 1;
+    while( ( 1u << order ) < frames )
+        order++;
+
+    const unsigned n = 1u << order;
+    uint64_t direct = (uint64_t)p->samples_per_frame * frames_window
+                    * p->frames_search;
+    uint64_t fft = (uint64_t)CORR_FFT_COST * ( p->samples_per_frame + 1 )
+                 * n * order / 2;
+
+    free( p->fft_twiddle );
+    free( p->buf_fft );
+    p->fft_twiddle = NULL;
+    p->buf_fft = NULL;
+    p->fft_order = 0;
+    if( fft >= direct )
+        return VLC_SUCCESS;
+
+    p->fft_twiddle = vlc_alloc( n, sizeof(float) );
+    p->buf_fft = vlc_alloc( 4 * n, sizeof(float) );
+    if( !p->fft_twiddle || !p->buf_fft )
+        return VLC_ENOMEM;
+
+    for( unsigned k = 0; k < n / 2; k++ )
+    {
+        p->fft_twiddle[2 * k]     = cos( -2. * M_PI * k / n );
+        p->fft_twiddle[2 * k + 1] = sin( -2. * M_PI * k / n );
+    }
+    p->fft_order = order;
+    return VLC_SUCCESS;
+}
+
 /*****************************************************************************
  * output_overlap: blend end of previous stride with beginning of current stride
  *****************************************************************************/
@@ -362,6 +525,11 @@ static int reinit_buffers( filter_t *p_filter )
                 *pw++ = v;
         }
         p->best_overlap_offset = best_overlap_offset_float;
+
+        if( init_fft( p, frames_overlap - 1 ) != VLC_SUCCESS )
+            return VLC_ENOMEM;
+        if( p->fft_order )
+            p->best_overlap_offset = best_overlap_offset_fft;
     }
 
     unsigned new_size = ( p->frames_search + frames_stride + frames_overlap ) * p->bytes_per_frame;
@@ -391,13 +559,14 @@ static int reinit_buffers( filter_t *p_filter )
     p->frames_stride_scaled = p->bytes_stride_scaled / p->bytes_per_frame;
 
     msg_Dbg( VLC_OBJECT(p_filter),
-             "%.3f scale, %.3f stride_in, %i stride_out, %i standing, %i overlap, %i search, %i queue, %s mode",
+             "%.3f scale, %.3f stride_in, %i stride_out, %i standing, %i overlap, %i search%s, %i queue, %s mode",
              p->scale,
              p->frames_stride_scaled,
              (int)( p->bytes_stride / p->bytes_per_frame ),
              (int)( p->bytes_standing / p->bytes_per_frame ),
              (int)( p->bytes_overlap / p->bytes_per_frame ),
              p->frames_search,
+             p->best_overlap_offset == best_overlap_offset_fft ? " (fft)" : "",
              (int)( p->bytes_queue_max / p->bytes_per_frame ),
              "fl32");
 
@@ -440,6 +609,9 @@ static int Open( vlc_object_t *p_this )
     p_sys->table_blend    = NULL;
     p_sys->buf_pre_corr   = NULL;
     p_sys->table_window   = NULL;
+    p_sys->fft_order      = 0;
+    p_sys->fft_twiddle    = NULL;
+    p_sys->buf_fft        = NULL;
     p_sys->bytes_overlap  = 0;
     p_sys->bytes_queued   = 0;
     p_sys->bytes_to_slide = 0;
@@ -536,6 +708,8 @@ static void Close( vlc_object_t *p_this )
     free( p_sys->table_blend );
     free( p_sys->buf_pre_corr );
     free( p_sys->table_window );
+    free( p_sys->fft_twiddle );
+    free( p_sys->buf_fft );
     free( p_sys );
 }
 
@@ -25,6 +25,9 @@ public:
     void    setfeedback(float val);
     float    getfeedback();
 private:
+    // The reverb model processes the delay line by chunks
+    friend class revmodel;
+
     float    feedback;
     float    filterstore;
     float    damp1;
@@ -11,13 +11,171 @@
 
 // This code is public domain
 
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+
 #include "revmodel.hpp"
 #include "tuning.h"
 #include <stdlib.h>
 
+#if defined(HAVE_SSE2_INTRINSICS)
+# include <emmintrin.h>
+#endif
+#if defined(__ARM_NEON)
+# include <arm_neon.h>
+#endif
+
+// Frames processed at once, bounded anyway by the delay lines lengths
+static const int chunksize = 256;
+
+namespace generic {
+static void combchunk(float *buf, const float *in, float *out, int n,
+                      float damp2, float feedback)
+{
+    for (int i = 0; i < n; i++)
+    {
+        float o = undenormalise(buf[i]);
+        out[i] += o;
+        buf[i] = in[i] + undenormalise(o*damp2)*feedback;
+    }
+}
+
+static void allpasschunk(float *buf, float *inout, int n, float feedback)
+{
+    for (int i = 0; i < n; i++)
+    {
+        float b = undenormalise(buf[i]);
+        float x = inout[i];
+        buf[i] = x + b*feedback;
+        inout[i] = -x + b;
+    }
+}
+}
+
+#if defined(HAVE_SSE2_INTRINSICS)
+# define REV_TARGET_SSE2 __attribute__((__target__("sse2")))
+namespace sse2 {
+#define REV_TARGET REV_TARGET_SSE2
+struct V {
+    typedef __m128 T;
+    static const int N = 4;
+    static inline REV_TARGET T set1(float f) { return _mm_set1_ps(f); }
+    static inline REV_TARGET T load(const float *p) { return _mm_loadu_ps(p); }
+    static inline REV_TARGET void store(float *p, T v) { _mm_storeu_ps(p, v); }
+    static inline REV_TARGET T add(T a, T b) { return _mm_add_ps(a, b); }
+    static inline REV_TARGET T sub(T a, T b) { return _mm_sub_ps(a, b); }
+    static inline REV_TARGET T mul(T a, T b) { return _mm_mul_ps(a, b); }
+};
+#include "revmodel_simd.h"
+#undef REV_TARGET
+}
+#endif
+
+#if defined(__ARM_NEON)
+namespace neon {
+#define REV_TARGET
+struct V {
+    typedef float32x4_t T;
+    static const int N = 4;
+    static inline T set1(float f) { return vdupq_n_f32(f); }
+    static inline T load(const float *p) { return vld1q_f32(p); }
+    static inline void store(float *p, T v) { vst1q_f32(p, v); }
+    static inline T add(T a, T b) { return vaddq_f32(a, b); }
+    static inline T sub(T a, T b) { return vsubq_f32(a, b); }
+    static inline T mul(T a, T b) { return vmulq_f32(a, b); }
+};
+#include "revmodel_simd.h"
+#undef REV_TARGET
+}
+#endif
+
+// Flushes the denormals to zero while processing, which the vectorized
+// filters rely on instead of undenormalise()
+class denormalsflush
+{
+public:
+    denormalsflush(bool enable) : enabled(enable), saved(0)
+    {
+        if (enabled)
+            saved = set();
+    }
+    ~denormalsflush()
+    {
+        if (enabled)
+            restore(saved);
+    }
+private:
+    bool enabled;
+    unsigned long saved;
+
+#if defined(HAVE_SSE2_INTRINSICS)
+    // Flush-to-zero and denormals-are-zero modes of the MXCSR
+    static REV_TARGET_SSE2 unsigned long set()
+    {
+        unsigned csr = _mm_getcsr();
+        _mm_setcsr(csr | 0x8040);
+        return csr;
+    }
+    static REV_TARGET_SSE2 void restore(unsigned long csr)
+    {
+        _mm_setcsr(csr);
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    // Flush-to-zero mode of the FPCR, which also flushes the inputs
+    static unsigned long set()
+    {
+        unsigned long fpcr;
+        __asm__ volatile ("mrs %0, fpcr" : "=r"(fpcr));
+        __asm__ volatile ("msr fpcr, %0" :: "r"(fpcr | (1UL << 24)));
+        return fpcr;
+    }
+    static void restore(unsigned long fpcr)
+    {
+        __asm__ volatile ("msr fpcr, %0" :: "r"(fpcr));
+    }
+#elif defined(__ARM_NEON)
+    // NEON always flushes, the FPSCR does it for the VFP remainders
+    static unsigned long set()
+    {
+        unsigned long fpscr;
+        __asm__ volatile ("vmrs %0, fpscr" : "=r"(fpscr));
+        __asm__ volatile ("vmsr fpscr, %0" :: "r"(fpscr | (1UL << 24)));
+        return fpscr;
+    }
+    static void restore(unsigned long fpscr)
+    {
+        __asm__ volatile ("vmsr fpscr, %0" :: "r"(fpscr));
+    }
+#else
+    static unsigned long set() { return 0; }
+    static void restore(unsigned long) { }
+#endif
+};
+
 revmodel::revmodel() : roomsize(initialroom), damp(initialdamp),
                        wet(initialwet), dry(initialdry), width(1.), mode(0.)
 {
+    combchunk = generic::combchunk;
+    allpasschunk = generic::allpasschunk;
+    flushdenormals = false;
+#if defined(__ARM_NEON)
+    combchunk = neon::combchunk;
+    allpasschunk = neon::allpasschunk;
+    flushdenormals = true;
+#endif
+#if defined(HAVE_SSE2_INTRINSICS)
+    if (vlc_CPU_SSE2())
+    {
+        combchunk = sse2::combchunk;
+        allpasschunk = sse2::allpasschunk;
+        flushdenormals = true;
+    }
+#endif
+
     // Tie the components to their buffers
     combL[0].setbuffer(bufcombL1,combtuningL1);
     combR[0].setbuffer(bufcombR1,combtuningR1);
@@ -89,38 +247,77 @@ void revmodel::mute()
  * /param long numsamples  number of samples to be processed
  * /param int skip             number of channels in the audio stream
  *****************************************************************************/
-void revmodel::processreplace(float *inputL, float *outputL, long /* numsamples */, int skip)
+void revmodel::processreplace(float *inputL, float *outputL, long numsamples, int skip)
 {
-    float outL,outR,input;
-    float inputR;
+    float input[chunksize], inputR[chunksize];
+    float outL[chunksize], outR[chunksize];
+    denormalsflush flush(flushdenormals);
     int i;
 
-    outL = outR = 0;
-        /* TODO this module supports only 2 audio channels, let's improve this */
-        if (skip > 1)
-           inputR = inputL[1];
-        else
-           inputR = inputL[0];
-        input = (inputL[0] + inputR) * gain;
+    while (numsamples > 0)
+    {
+        // Stop the chunk at the first delay line wrap around
+        int n = numsamples < chunksize ? numsamples : chunksize;
+        for(i=0; i<numcombs; i++)
+        {
+            n = __MIN(n, combL[i].bufsize - combL[i].bufidx);
+            n = __MIN(n, combR[i].bufsize - combR[i].bufidx);
+        }
+        for(i=0; i<numallpasses; i++)
+        {
+            n = __MIN(n, allpassL[i].bufsize - allpassL[i].bufidx);
+            n = __MIN(n, allpassR[i].bufsize - allpassR[i].bufidx);
+        }
+
+        for(i=0; i<n; i++)
+        {
+            /* TODO this module supports only 2 audio channels, let's improve this */
+            if (skip > 1)
+               inputR[i] = inputL[i*skip + 1];
+            else
+               inputR[i] = inputL[i*skip];
+            input[i] = (inputL[i*skip] + inputR[i]) * gain;
+            outL[i] = outR[i] = 0;
+        }
 
         // Accumulate comb filters in parallel
         for(i=0; i<numcombs; i++)
         {
-            outL += combL[i].process(input);
-            outR += combR[i].process(input);
+            comb *c[2] = { &combL[i], &combR[i] };
+            float *out[2] = { outL, outR };
+            for(int j=0; j<2; j++)
+            {
+                combchunk(&c[j]->buffer[c[j]->bufidx], input, out[j], n,
+                          c[j]->damp2, c[j]->feedback);
+                if((c[j]->bufidx += n) >= c[j]->bufsize) c[j]->bufidx = 0;
+            }
         }
 
         // Feed through allpasses in series
         for(i=0; i<numallpasses; i++)
         {
-            outL = allpassL[i].process(outL);
-            outR = allpassR[i].process(outR);
+            allpass *a[2] = { &allpassL[i], &allpassR[i] };
+            float *out[2] = { outL, outR };
+            for(int j=0; j<2; j++)
+            {
+                allpasschunk(&a[j]->buffer[a[j]->bufidx], out[j], n,
+                             a[j]->feedback);
+                if((a[j]->bufidx += n) >= a[j]->bufsize) a[j]->bufidx = 0;
+            }
         }
 
         // Calculate output REPLACING anything already there
-        outputL[0] = (outL*wet1 + outR*wet2 + inputR*dry);
-           if (skip > 1)
-        outputL[1] = (outR*wet1 + outL*wet2 + inputR*dry);
+        for(i=0; i<n; i++)
+        {
+            outputL[i*skip] = (outL[i]*wet1 + outR[i]*wet2 + inputR[i]*dry);
+            if (skip > 1)
+                outputL[i*skip + 1] = (outR[i]*wet1 + outL[i]*wet2 + inputR[i]*dry);
+        }
+
+        inputL += n*skip;
+        outputL += n*skip;
+        numsamples -= n;
+    }
 }
 
 void revmodel::processmix(float *inputL, float *outputL, long /* numsamples */, int skip)
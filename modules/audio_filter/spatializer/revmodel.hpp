@@ -36,6 +36,12 @@ public:
 private:
     void    update();
 private:
+    // Processes a chunk of frames through the delay lines
+    void    (*combchunk)(float *buf, const float *in, float *out, int n,
+                         float damp2, float feedback);
+    void    (*allpasschunk)(float *buf, float *inout, int n, float feedback);
+    bool    flushdenormals;
+
     float    gain;
     float    roomsize,roomsize1;
     float    damp,damp1;
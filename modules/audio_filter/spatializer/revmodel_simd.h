@@ -0,0 +1,56 @@
+// Vectorized comb and allpass filters
+//
+// This code is public domain
+
+// This file is included once per instruction set by revmodel.cpp, inside a
+// namespace providing:
+//  - REV_TARGET, the function attribute enabling the instruction set,
+//  - V, the vector operations on V::N float lanes.
+// A chunk never wraps around the delay lines, so that a sample read from a
+// delay line was written at least one whole delay earlier: the frames are
+// independent and processed in the vector lanes. The denormals are expected
+// to be flushed to zero by the FPU, and the results are otherwise the same
+// as the comb::process() and allpass::process() ones.
+
+static REV_TARGET
+void combchunk(float *buf, const float *in, float *out, int n,
+               float damp2, float feedback)
+{
+    const V::T vd = V::set1(damp2), vf = V::set1(feedback);
+    int i = 0;
+
+    for (; i + V::N <= n; i += V::N)
+    {
+        V::T o = V::load(&buf[i]);
+        V::store(&out[i], V::add(V::load(&out[i]), o));
+        V::store(&buf[i], V::add(V::load(&in[i]), V::mul(V::mul(o, vd), vf)));
+    }
+    for (; i < n; i++)
+    {
+        float o = buf[i];
+        out[i] += o;
+        buf[i] = in[i] + (o*damp2)*feedback;
+    }
+}
+
+static REV_TARGET
+void allpasschunk(float *buf, float *inout, int n, float feedback)
+{
+    const V::T vf = V::set1(feedback);
+    int i = 0;
+
+    for (; i + V::N <= n; i += V::N)
+    {
+        V::T b = V::load(&buf[i]);
+        V::T x = V::load(&inout[i]);
+        V::store(&buf[i], V::add(x, V::mul(b, vf)));
+        V::store(&inout[i], V::sub(b, x));
+    }
+    for (; i < n; i++)
+    {
+        float b = buf[i];
+        float x = inout[i];
+        buf[i] = x + b*feedback;
+        inout[i] = b - x;
+    }
+}
@@ -35,10 +35,13 @@
 #include <vlc_aout.h>
 #include <vlc_aout_volume.h>
 
+#include "float_amplify.h"
+
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
-static int Create( vlc_object_t * );
+static int  Create( vlc_object_t * );
+static void Destroy( vlc_object_t * );
 
 /*****************************************************************************
  * Module descriptor
@@ -47,38 +50,76 @@ vlc_module_begin ()
     set_category( CAT_AUDIO )
     set_subcategory( SUBCAT_AUDIO_MISC )
     set_description( N_("Single precision audio volume") )
-    set_capability( "audio volume", 10 )
-    set_callbacks( Create, NULL )
+    set_capability( "audio volume", 11 )
+    set_callbacks( Create, Destroy )
 vlc_module_end ()
 
+typedef struct
+{
+    amplify_ramp_cb pf_ramp;
+    float f_gain; /* gain at the end of the last buffer, negative if none */
+} volume_sys_t;
+
+/* Returns the gain of the previous buffer, and remembers the new one */
+static float GetLastGain( audio_volume_t *p_volume, float f_multiplier )
+{
+    volume_sys_t *p_sys = p_volume->sys;
+    float f_last = p_sys->f_gain;
+
+    p_sys->f_gain = f_multiplier;
+    return f_last < 0.f ? f_multiplier : f_last;
+}
+
 /**
- * Mixes a new output buffer
+ * Mixes a new output buffer, ramping the gain linearly over the buffer
  */
 static void FilterFL32( audio_volume_t *p_volume, block_t *p_buffer,
                         float f_multiplier )
 {
-    if( f_multiplier == 1.f )
-        return; /* nothing to do */
-
-    float *p = (float *)p_buffer->p_buffer;
-    for( size_t i = p_buffer->i_buffer / sizeof(*p); i > 0; i-- )
-        *(p++) *= f_multiplier;
+    volume_sys_t *p_sys = p_volume->sys;
+    const float f_last = GetLastGain( p_volume, f_multiplier );
+    const size_t i_samples = p_buffer->i_buffer / sizeof (float);
 
-    (void) p_volume;
+    if( i_samples == 0 )
+        return;
+    if( f_last == f_multiplier )
+    {
+        if( f_multiplier == 1.f )
+            return; /* nothing to do */
+        p_sys->pf_ramp( (float *)p_buffer->p_buffer, i_samples,
+                        f_multiplier, 0.f );
+    }
+    else
+    {
+        /* The last sample gets the new gain */
+        const float f_step = ( f_multiplier - f_last ) / i_samples;
+        p_sys->pf_ramp( (float *)p_buffer->p_buffer, i_samples,
+                        f_last + f_step, f_step );
+    }
 }
 
 static void FilterFL64( audio_volume_t *p_volume, block_t *p_buffer,
                         float f_multiplier )
 {
     double *p = (double *)p_buffer->p_buffer;
-    double mult = f_multiplier;
-    if( mult == 1. )
-        return; /* nothing to do */
+    const double mult = f_multiplier;
+    double last = GetLastGain( p_volume, f_multiplier );
+    const size_t i_samples = p_buffer->i_buffer / sizeof(*p);
 
-    for( size_t i = p_buffer->i_buffer / sizeof(*p); i > 0; i-- )
-        *(p++) *= mult;
+    if( last == mult )
+    {
+        if( mult == 1. )
+            return; /* nothing to do */
 
-    (void) p_volume;
+        for( size_t i = i_samples; i > 0; i-- )
+            *(p++) *= mult;
+    }
+    else
+    {
+        const double step = ( mult - last ) / i_samples;
+        for( size_t i = 1; i <= i_samples; i++ )
+            *(p++) *= last + step * i;
+    }
 }
 
 /**
@@ -99,5 +140,19 @@ static int Create( vlc_object_t *p_this )
         default:
             return -1;
     }
+
+    volume_sys_t *p_sys = malloc( sizeof (*p_sys) );
+    if( unlikely(p_sys == NULL) )
+        return -1;
+    p_sys->pf_ramp = AmplifyGetRamp();
+    p_sys->f_gain = -1.f;
+    p_volume->sys = p_sys;
     return 0;
 }
+
+static void Destroy( vlc_object_t *p_this )
+{
+    audio_volume_t *p_volume = (audio_volume_t *)p_this;
+
+    free( p_volume->sys );
+}
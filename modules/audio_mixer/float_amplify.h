@@ -0,0 +1,113 @@
+/*****************************************************************************
+ * float_amplify.h: single precision amplification with gain ramps
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_FLOAT_AMPLIFY_H_
+#define VLC_FLOAT_AMPLIFY_H_
+
+#include <vlc_cpu.h>
+
+#if defined(HAVE_SSE2_INTRINSICS)
+# include <emmintrin.h>
+#endif
+#if defined(HAVE_AVX2_INTRINSICS)
+# include <immintrin.h>
+#endif
+#if defined(__ARM_NEON)
+# include <arm_neon.h>
+#endif
+
+/* Multiplies the i_samples samples by a linear gain ramp, sample i being
+ * multiplied by f_gain + i * f_step */
+typedef void (*amplify_ramp_cb)( float *, size_t, float, float );
+
+static void AmplifyRampC( float *p, size_t i_samples, float f_gain,
+                          float f_step )
+{
+    if( f_step == 0.f )
+        for( size_t i = 0; i < i_samples; i++ )
+            p[i] *= f_gain;
+    else
+        for( size_t i = 0; i < i_samples; i++ )
+            p[i] *= f_gain + f_step * (float)i;
+}
+
+#if defined(HAVE_SSE2_INTRINSICS)
+# define AMP_TARGET __attribute__((__target__("sse2")))
+# define AMP_FUNC(name) name##SSE2
+# define V __m128
+# define V_N 4
+# define V_SET1(f) _mm_set1_ps(f)
+# define V_INDEX() _mm_setr_ps(0.f, 1.f, 2.f, 3.f)
+# define V_LOAD(p) _mm_loadu_ps(p)
+# define V_STORE(p, v) _mm_storeu_ps(p, v)
+# define V_ADD(a, b) _mm_add_ps(a, b)
+# define V_MUL(a, b) _mm_mul_ps(a, b)
+# include "float_amplify_simd.h"
+#endif
+
+#if defined(HAVE_AVX2_INTRINSICS)
+/* Only AVX is needed, but the build system checks for the AVX2 support */
+# define AMP_TARGET __attribute__((__target__("avx")))
+# define AMP_FUNC(name) name##AVX
+# define V __m256
+# define V_N 8
+# define V_SET1(f) _mm256_set1_ps(f)
+# define V_INDEX() _mm256_setr_ps(0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f)
+# define V_LOAD(p) _mm256_loadu_ps(p)
+# define V_STORE(p, v) _mm256_storeu_ps(p, v)
+# define V_ADD(a, b) _mm256_add_ps(a, b)
+# define V_MUL(a, b) _mm256_mul_ps(a, b)
+# include "float_amplify_simd.h"
+#endif
+
+#if defined(__ARM_NEON)
+static const float amplify_index_neon[4] = { 0.f, 1.f, 2.f, 3.f };
+# define AMP_TARGET
+# define AMP_FUNC(name) name##NEON
+# define V float32x4_t
+# define V_N 4
+# define V_SET1(f) vdupq_n_f32(f)
+# define V_INDEX() vld1q_f32(amplify_index_neon)
+# define V_LOAD(p) vld1q_f32(p)
+# define V_STORE(p, v) vst1q_f32(p, v)
+# define V_ADD(a, b) vaddq_f32(a, b)
+# define V_MUL(a, b) vmulq_f32(a, b)
+# include "float_amplify_simd.h"
+#endif
+
+/* Returns the fastest amplifier for the CPU */
+static inline amplify_ramp_cb AmplifyGetRamp( void )
+{
+#if defined(HAVE_AVX2_INTRINSICS)
+    if( vlc_CPU_AVX() )
+        return AmplifyRampAVX;
+#endif
+#if defined(HAVE_SSE2_INTRINSICS)
+    if( vlc_CPU_SSE2() )
+        return AmplifyRampSSE2;
+#endif
+#if defined(__ARM_NEON)
+    return AmplifyRampNEON;
+#else
+    return AmplifyRampC;
+#endif
+}
+
+#endif
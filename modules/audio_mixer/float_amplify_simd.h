@@ -0,0 +1,70 @@
+/*****************************************************************************
+ * float_amplify_simd.h: vectorized amplification with gain ramps
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* This file is included once per instruction set by float_amplify.h, with:
+ *  - AMP_TARGET, the function attribute enabling the instruction set,
+ *  - AMP_FUNC(name), the name of the instantiated functions,
+ *  - V, a vector of V_N floats, and its V_* operations.
+ * The gain of each lane is computed from its sample index, rather than
+ * accumulated, so that the results are the same as AmplifyRampC() ones. */
+
+static AMP_TARGET
+void AMP_FUNC(AmplifyRamp)( float *p, size_t i_samples, float f_gain,
+                            float f_step )
+{
+    const V gain = V_SET1( f_gain );
+    size_t i = 0;
+
+    if( f_step == 0.f )
+    {
+        for( ; i + 2 * V_N <= i_samples; i += 2 * V_N )
+        {
+            V_STORE( &p[i], V_MUL( V_LOAD( &p[i] ), gain ) );
+            V_STORE( &p[i + V_N], V_MUL( V_LOAD( &p[i + V_N] ), gain ) );
+        }
+        for( ; i < i_samples; i++ )
+            p[i] *= f_gain;
+    }
+    else
+    {
+        const V step = V_SET1( f_step ), next = V_SET1( V_N );
+        V index = V_INDEX();
+
+        for( ; i + V_N <= i_samples; i += V_N )
+        {
+            V_STORE( &p[i], V_MUL( V_LOAD( &p[i] ),
+                                   V_ADD( gain, V_MUL( step, index ) ) ) );
+            index = V_ADD( index, next );
+        }
+        for( ; i < i_samples; i++ )
+            p[i] *= f_gain + f_step * (float)i;
+    }
+}
+
+#undef AMP_TARGET
+#undef AMP_FUNC
+#undef V
+#undef V_N
+#undef V_SET1
+#undef V_INDEX
+#undef V_LOAD
+#undef V_STORE
+#undef V_ADD
+#undef V_MUL
@@ -31,26 +31,48 @@
 #include <vlc_aout_volume.h>
 
 static int Activate (vlc_object_t *);
+static void Deactivate (vlc_object_t *);
 
 vlc_module_begin ()
     set_category (CAT_AUDIO)
     set_subcategory (SUBCAT_AUDIO_MISC)
     set_description (N_("Integer audio volume"))
     set_capability ("audio volume", 9)
-    set_callbacks (Activate, NULL)
+    set_callbacks (Activate, Deactivate)
 vlc_module_end ()
 
+/**
+ * Gets the linear gain ramp from the volume of the previous buffer to this
+ * one, with 16 more fractional bits than the multipliers.
+ * \return the multiplier of this buffer
+ */
+static int_fast64_t GetRamp (audio_volume_t *vol, float volume, float one,
+                             size_t n, int_fast64_t *restrict mult,
+                             int_fast64_t *restrict step)
+{
+    float *last = vol->sys;
+    int_fast64_t from = lroundf ((*last < 0.f ? volume : *last) * one);
+    int_fast64_t to = lroundf (volume * one);
+
+    *last = volume;
+    *mult = from * 65536;
+    *step = (n > 0) ? (to - from) * 65536 / (int_fast64_t)n : 0;
+    return (from == to) ? to : -1;
+}
+
 static void FilterS32N (audio_volume_t *vol, block_t *block, float volume)
 {
     int32_t *p = (int32_t *)block->p_buffer;
+    size_t n = block->i_buffer / sizeof (*p);
+    int_fast64_t mult, step;
 
-    int_fast32_t mult = lroundf (volume * 0x1.p24f);
-    if (mult == (1 << 24))
+    if (GetRamp (vol, volume, 0x1.p24f, n, &mult, &step) == (1 << 24))
         return;
 
-    for (size_t n = block->i_buffer / sizeof (*p); n > 0; n--)
+    for (; n > 0; n--)
     {
-        int_fast64_t s = (*p * (int_fast64_t)mult) >> INT64_C(24);
+        mult += step;
+        int_fast64_t s = (*p * (mult >> 16)) >> INT64_C(24);
         if (s > INT32_MAX)
             s = INT32_MAX;
         else
@@ -58,20 +80,21 @@ static void FilterS32N (audio_volume_t *vol, block_t *block, float volume)
             s = INT32_MIN;
         *(p++) = s;
     }
-    (void) vol;
 }
 
 static void FilterS16N (audio_volume_t *vol, block_t *block, float volume)
 {
     int16_t *p = (int16_t *)block->p_buffer;
+    size_t n = block->i_buffer / sizeof (*p);
+    int_fast64_t mult, step;
 
-    int_fast16_t mult = lroundf (volume * 0x1.p8f);
-    if (mult == (1 << 8))
+    if (GetRamp (vol, volume, 0x1.p8f, n, &mult, &step) == (1 << 8))
         return;
 
-    for (size_t n = block->i_buffer / sizeof (*p); n > 0; n--)
+    for (; n > 0; n--)
     {
-        int_fast32_t s = (*p * (int_fast32_t)mult) >> 8;
+        mult += step;
+        int_fast32_t s = (*p * (int_fast32_t)(mult >> 16)) >> 8;
         if (s > INT16_MAX)
             s = INT16_MAX;
         else
@@ -79,20 +102,22 @@ static void FilterS16N (audio_volume_t *vol, block_t *block, float volume)
             s = INT16_MIN;
         *(p++) = s;
     }
-    (void) vol;
 }
 
 static void FilterU8 (audio_volume_t *vol, block_t *block, float volume)
 {
     uint8_t *p = (uint8_t *)block->p_buffer;
+    size_t n = block->i_buffer / sizeof (*p);
+    int_fast64_t mult, step;
 
-    int_fast16_t mult = lroundf (volume * 0x1.p8f);
-    if (mult == (1 << 8))
+    if (GetRamp (vol, volume, 0x1.p8f, n, &mult, &step) == (1 << 8))
         return;
 
-    for (size_t n = block->i_buffer / sizeof (*p); n > 0; n--)
+    for (; n > 0; n--)
     {
-        int_fast32_t s = (((int_fast8_t)(*p - 128)) * (int_fast32_t)mult) >> 8;
+        mult += step;
+        int_fast32_t s = (((int_fast8_t)(*p - 128))
+                          * (int_fast32_t)(mult >> 16)) >> 8;
         if (s > INT8_MAX)
             s = INT8_MAX;
         else
@@ -100,7 +125,6 @@ static void FilterU8 (audio_volume_t *vol, block_t *block, float volume)
             s = INT8_MIN;
         *(p++) = s + 128;
     }
-    (void) vol;
 }
 
 static int Activate (vlc_object_t *obj)
@@ -121,5 +145,19 @@ static int Activate (vlc_object_t *obj)
         default:
             return -1;
     }
+
+    /* Volume of the previous buffer, none yet */
+    float *last = malloc (sizeof (*last));
+    if (unlikely(last == NULL))
+        return -1;
+    *last = -1.f;
+    vol->sys = last;
     return 0;
 }
+
+static void Deactivate (vlc_object_t *obj)
+{
+    audio_volume_t *vol = (audio_volume_t *)obj;
+
+    free (vol->sys);
+}
@@ -29,6 +29,7 @@
 #endif
 
 #include <assert.h>
+#include <errno.h>
 
 #include <vlc_common.h>
 #include <vlc_plugin.h>
@@ -48,6 +49,10 @@ struct aout_sys_t
     uint8_t chans_table[AOUT_CHAN_MAX]; /**< Channels order table */
     uint8_t chans_to_reorder; /**< Number of channels to reorder */
 
+    bool mmap; /**< Writes to the memory-mapped ring buffer */
+    mtime_t latency; /**< Buffer duration target, 0 for the default */
+    unsigned xruns; /**< Underruns since the device was opened */
+
     bool soft_mute;
     float soft_gain;
     char *device;
@@ -56,6 +61,8 @@ struct aout_sys_t
 #include "audio_output/volume.h"
 
 #define A52_FRAME_NB 1536
+/* Underruns before the latency target is increased */
+#define XRUNS_MAX 3
 
 static int Open (vlc_object_t *);
 static void Close (vlc_object_t *);
@@ -68,6 +75,13 @@ static int EnumDevices (vlc_object_t *, char const *, char ***, char ***);
 #define AUDIO_CHAN_LONGTEXT N_("Channels available for audio output. " \
     "If the input has more channels than the output, it will be down-mixed. " \
     "This parameter is ignored when digital pass-through is active.")
+#define MMAP_TEXT N_("Memory-mapped output")
+#define MMAP_LONGTEXT N_("Write the samples directly to the ring buffer " \
+    "of the device, if it supports memory-mapped access.")
+#define LATENCY_TEXT N_("Latency (ms)")
+#define LATENCY_LONGTEXT N_("Target duration of the device buffer, " \
+    "0 for the default. It is increased when the buffer underruns.")
+
 static const int channels[] = {
     AOUT_CHAN_CENTER, AOUT_CHANS_STEREO, AOUT_CHANS_4_0, AOUT_CHANS_4_1,
     AOUT_CHANS_5_0, AOUT_CHANS_5_1, AOUT_CHANS_7_1,
@@ -88,6 +102,9 @@ vlc_module_begin ()
     add_integer ("alsa-audio-channels", AOUT_CHANS_FRONT,
                  AUDIO_CHAN_TEXT, AUDIO_CHAN_LONGTEXT, false)
         change_integer_list (channels, channels_text)
+    add_bool ("alsa-mmap", false, MMAP_TEXT, MMAP_LONGTEXT, true)
+    add_integer_with_range ("alsa-latency", 0, 0, 2000,
+                            LATENCY_TEXT, LATENCY_LONGTEXT, true)
     add_sw_gain ()
     set_capability( "audio output", 150 )
     set_callbacks( Open, Close )
@@ -418,8 +435,14 @@ static int Start (audio_output_t *aout, audio_sample_format_t *restrict fmt)
         goto error;
     }
 
-    val = snd_pcm_hw_params_set_access (pcm, hw,
-                                        SND_PCM_ACCESS_RW_INTERLEAVED);
+    sys->mmap = var_InheritBool (aout, "alsa-mmap")
+             && snd_pcm_hw_params_set_access (pcm, hw,
+                                        SND_PCM_ACCESS_MMAP_INTERLEAVED) == 0;
+    if (sys->mmap)
+        val = 0;
+    else
+        val = snd_pcm_hw_params_set_access (pcm, hw,
+                                            SND_PCM_ACCESS_RW_INTERLEAVED);
     if (val)
     {
         msg_Err (aout, "cannot set access mode: %s", snd_strerror (val));
@@ -500,6 +523,8 @@ static int Start (audio_output_t *aout, audio_sample_format_t *restrict fmt)
 
 #if 1 /* work-around for period-long latency outputs (e.g. PulseAudio): */
     param = AOUT_MIN_PREPARE_TIME;
+    if (sys->latency > 0) /* four periods per buffer */
+        param = sys->latency / 4;
     val = snd_pcm_hw_params_set_period_time_near (pcm, hw, &param, NULL);
     if (val)
     {
@@ -509,6 +534,8 @@ static int Start (audio_output_t *aout, audio_sample_format_t *restrict fmt)
 #endif
     /* Set buffer size */
     param = AOUT_MAX_ADVANCE_TIME;
+    if (sys->latency > 0)
+        param = sys->latency;
     val = snd_pcm_hw_params_set_buffer_time_near (pcm, hw, &param, NULL);
     if (val)
     {
@@ -542,6 +569,13 @@ static int Start (audio_output_t *aout, audio_sample_format_t *restrict fmt)
     }
     Dump (aout, "final HW setup:\n", snd_pcm_hw_params_dump, hw);
 
+    snd_pcm_uframes_t period_size, buffer_size;
+    if (snd_pcm_hw_params_get_period_size (hw, &period_size, NULL) == 0
+     && snd_pcm_hw_params_get_buffer_size (hw, &buffer_size) == 0)
+        msg_Dbg (aout, "%s access, %lu frames period, %"PRId64" us buffer",
+                 sys->mmap ? "memory-mapped" : "read/write", period_size,
+                 (int64_t)buffer_size * CLOCK_FREQ / sys->rate);
+
     /* Get Initial software parameters */
     snd_pcm_sw_params_t *sw;
 
@@ -605,6 +639,38 @@ error:
     return VLC_EGENERIC;
 }
 
+/**
+ * Recovers from a write error, and adapts the latency to the underruns.
+ */
+static int Recover (audio_output_t *aout, int err)
+{
+    aout_sys_t *sys = aout->sys;
+
+    if (err == -EPIPE)
+    {
+        sys->xruns++;
+        msg_Warn (aout, "buffer underrun (%u so far)", sys->xruns);
+
+        if (sys->latency > 0 && sys->latency < AOUT_MAX_ADVANCE_TIME
+         && sys->xruns % XRUNS_MAX == 0)
+        {
+            /* The periods can only be resized by setting the device up */
+            sys->latency = __MIN(sys->latency * 3 / 2, AOUT_MAX_ADVANCE_TIME);
+            msg_Dbg (aout, "increasing latency to %"PRId64" us", sys->latency);
+            aout_RestartRequest (aout, AOUT_RESTART_OUTPUT);
+        }
+    }
+
+    int val = snd_pcm_recover (sys->pcm, err, 1);
+    if (val)
+    {
+        msg_Err (aout, "cannot recover playback stream: %s",
+                 snd_strerror (val));
+        DumpDeviceStatus (aout, sys->pcm);
+    }
+    return val;
+}
+
 static int TimeGet (audio_output_t *aout, mtime_t *restrict delay)
 {
     aout_sys_t *sys = aout->sys;
@@ -620,6 +686,37 @@ static int TimeGet (audio_output_t *aout, mtime_t *restrict delay)
     return 0;
 }
 
+/**
+ * Copies samples to the memory-mapped ring buffer, as snd_pcm_writei() does.
+ */
+static snd_pcm_sframes_t WriteMmap (snd_pcm_t *pcm, const void *buf,
+                                    snd_pcm_uframes_t count)
+{
+    snd_pcm_sframes_t avail = snd_pcm_avail_update (pcm);
+    if (avail < 0)
+        return avail;
+    if (avail == 0)
+    {   /* The ring buffer is full: wait for the device to play a period */
+        int val = snd_pcm_wait (pcm, 1000);
+        if (val < 0)
+            return val;
+        return 0;
+    }
+
+    const snd_pcm_channel_area_t *areas;
+    snd_pcm_uframes_t offset, frames = count;
+
+    int val = snd_pcm_mmap_begin (pcm, &areas, &offset, &frames);
+    if (val < 0)
+        return val;
+
+    /* Interleaved: the first area covers all the channels */
+    uint8_t *dst = (uint8_t *)areas[0].addr
+                 + (areas[0].first + offset * areas[0].step) / 8;
+    memcpy (dst, buf, snd_pcm_frames_to_bytes (pcm, frames));
+    return snd_pcm_mmap_commit (pcm, offset, frames);
+}
+
 /**
  * Queues one audio buffer to the hardware.
  */
@@ -640,7 +737,11 @@ static void Play (audio_output_t *aout, block_t *block)
     {
         snd_pcm_sframes_t frames;
 
-        frames = snd_pcm_writei (pcm, block->p_buffer, block->i_nb_samples);
+        if (sys->mmap)
+            frames = WriteMmap (pcm, block->p_buffer, block->i_nb_samples);
+        else
+            frames = snd_pcm_writei (pcm, block->p_buffer,
+                                     block->i_nb_samples);
         if (frames >= 0)
         {
             size_t bytes = snd_pcm_frames_to_bytes (pcm, frames);
@@ -651,14 +752,8 @@ static void Play (audio_output_t *aout, block_t *block)
         }
         else  
         {
-            int val = snd_pcm_recover (pcm, frames, 1);
-            if (val)
-            {
-                msg_Err (aout, "cannot recover playback stream: %s",
-                         snd_strerror (val));
-                DumpDeviceStatus (aout, pcm);
+            if (Recover (aout, frames))
                 break;
-            }
             msg_Warn (aout, "cannot write samples: %s", snd_strerror (frames));
         }
     }
@@ -799,6 +894,9 @@ static int Open(vlc_object_t *obj)
     sys->device = var_InheritString (aout, "alsa-audio-device");
     if (unlikely(sys->device == NULL))
         goto error;
+    /* Kept across the restarts, so that the buffer only grows */
+    sys->latency = var_InheritInteger (aout, "alsa-latency") * 1000;
+    sys->xruns = 0;
 
     aout->sys = sys;
     aout->start = Start;
@@ -25,6 +25,7 @@
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_aout.h>
+#include <vlc_aout_ring.h>
 #include <assert.h>
 
 static int Open (vlc_object_t *);
@@ -78,6 +79,8 @@ struct aout_sys_t
     float volume;
     bool mute;
     bool ready;
+    aout_ring_t *ring;
+    unsigned ring_rate;
 };
 
 static void Play (audio_output_t *aout, block_t *block)
@@ -89,6 +92,28 @@ static void Play (audio_output_t *aout, block_t *block)
     block_Release (block);
 }
 
+static void RingPlay (audio_output_t *aout, block_t *block)
+{
+    aout_sys_t *sys = aout->sys;
+    size_t count = aout_RingWrite (sys->ring, block->p_buffer,
+                                   block->i_nb_samples);
+
+    if (unlikely(count < block->i_nb_samples))
+        msg_Warn (aout, "ring buffer full, dropped %zu frames",
+                  block->i_nb_samples - count);
+    block_Release (block);
+}
+
+static int RingTimeGet (audio_output_t *aout, mtime_t *delay)
+{
+    aout_sys_t *sys = aout->sys;
+
+    /* The frames not read yet, and the application own latency */
+    *delay = aout_RingGetPending (sys->ring) * CLOCK_FREQ / sys->ring_rate
+           + atomic_load_explicit (&sys->ring->latency, memory_order_relaxed);
+    return 0;
+}
+
 static void Pause (audio_output_t *aout, bool paused, mtime_t date)
 {
     aout_sys_t *sys = aout->sys;
@@ -103,6 +128,8 @@ static void Flush (audio_output_t *aout, bool wait)
     aout_sys_t *sys = aout->sys;
     void (*cb) (void *) = wait ? sys->drain : sys->flush;
 
+    if (sys->ring != NULL && !wait)
+        aout_RingFlush (sys->ring);
     if (cb != NULL)
         cb (sys->opaque);
 }
@@ -196,6 +223,18 @@ static int Start (audio_output_t *aout, audio_sample_format_t *fmt)
         return VLC_EGENERIC;
     }
 
+    if (sys->ring != NULL)
+    {
+        if (sys->ring->frame_size != channels * sizeof (int16_t))
+        {
+            msg_Err (aout, "ring buffer frame size mismatch: %u bytes for "
+                     "%u channel(s)", sys->ring->frame_size, channels);
+            Stop (aout);
+            return VLC_EGENERIC;
+        }
+        sys->ring_rate = fmt->i_rate;
+    }
+
     /* channel mapping */
     switch (channels)
     {
@@ -265,7 +304,8 @@ static int Open (vlc_object_t *obj)
     sys->volume = 1.;
     sys->mute = false;
     sys->ready = false;
-    if (sys->play == NULL)
+    sys->ring = var_InheritAddress (obj, "amem-ring");
+    if (sys->play == NULL && sys->ring == NULL)
     {
         free (sys);
         return VLC_EGENERIC;
@@ -274,8 +314,17 @@ static int Open (vlc_object_t *obj)
     aout->sys = sys;
     aout->start = Start;
     aout->stop = Stop;
-    aout->time_get = NULL;
-    aout->play = Play;
+    if (sys->ring != NULL)
+    {   /* Write directly into the application ring buffer */
+        aout_RingHold (sys->ring);
+        aout->time_get = RingTimeGet;
+        aout->play = RingPlay;
+    }
+    else
+    {
+        aout->time_get = NULL;
+        aout->play = Play;
+    }
     aout->pause = Pause;
     aout->flush = Flush;
     if (sys->set_volume != NULL)
@@ -296,5 +345,7 @@ static void Close (vlc_object_t *obj)
     audio_output_t *aout = (audio_output_t *)obj;
     aout_sys_t *sys = aout->sys;
 
+    if (sys->ring != NULL)
+        aout_RingRelease (sys->ring);
     free (sys);
 }
@@ -23,6 +23,8 @@
 # include <config.h>
 #endif
 
+#include <string.h>
+
 #include <vlc_common.h>
 #include <vlc_modules.h>
 #include <vlc_fourcc.h>
@@ -113,16 +115,137 @@ static void vlc_va_Stop(void *func, va_list ap)
     close(va, hwctx);
 }
 
+/* Back-ends that worked, or that all failed, for the previous streams of a
+ * LibVLC instance, so that opening a new stream (such as when switching
+ * channels) goes straight to the working back-end instead of probing all. */
+#define VA_CACHE_SIZE 16
+/* Failures are forgotten after a while, in case the device changed */
+#define VA_CACHE_FAILURE_TTL (60 * CLOCK_FREQ)
+
+struct vlc_va_cache_entry
+{
+    const void *libvlc;
+    enum AVCodecID codec_id;
+    int profile;
+    enum PixelFormat pix_fmt;
+    bool has_sys; /* surfaces provided by the video output */
+    int width, height;
+    char module[32]; /* empty if every back-end failed */
+    mtime_t date;
+};
+
+static vlc_mutex_t va_cache_lock = VLC_STATIC_MUTEX;
+static struct vlc_va_cache_entry va_cache[VA_CACHE_SIZE];
+
+static bool vlc_va_CacheMatch(const struct vlc_va_cache_entry *entry,
+                              const struct vlc_va_cache_entry *key)
+{
+    return entry->libvlc == key->libvlc && entry->codec_id == key->codec_id
+        && entry->profile == key->profile && entry->pix_fmt == key->pix_fmt
+        && entry->has_sys == key->has_sys;
+}
+
+/* Returns false if every back-end is known to fail, else the back-end to try
+ * first in module, if any. */
+static bool vlc_va_CacheLookup(const struct vlc_va_cache_entry *key,
+                               char *module, size_t size)
+{
+    bool usable = true;
+
+    module[0] = '\0';
+    vlc_mutex_lock(&va_cache_lock);
+    for (size_t i = 0; i < VA_CACHE_SIZE; i++)
+    {
+        const struct vlc_va_cache_entry *entry = &va_cache[i];
+
+        if (entry->libvlc == NULL || !vlc_va_CacheMatch(entry, key))
+            continue;
+
+        if (entry->module[0] != '\0')
+            strlcpy(module, entry->module, size);
+        else if (key->date - entry->date < VA_CACHE_FAILURE_TTL
+              && key->width >= entry->width && key->height >= entry->height)
+            usable = false; /* this or a smaller size failed already */
+        break;
+    }
+    vlc_mutex_unlock(&va_cache_lock);
+    return usable;
+}
+
+static void vlc_va_CacheStore(const struct vlc_va_cache_entry *key,
+                              const char *module)
+{
+    struct vlc_va_cache_entry *oldest = &va_cache[0];
+
+    vlc_mutex_lock(&va_cache_lock);
+    for (size_t i = 0; i < VA_CACHE_SIZE; i++)
+    {
+        struct vlc_va_cache_entry *entry = &va_cache[i];
+
+        if (entry->libvlc != NULL && vlc_va_CacheMatch(entry, key))
+        {
+            oldest = entry;
+            break;
+        }
+        if (entry->date < oldest->date)
+            oldest = entry;
+    }
+
+    *oldest = *key;
+    if (module != NULL)
+        strlcpy(oldest->module, module, sizeof (oldest->module));
+    else
+        oldest->module[0] = '\0';
+    vlc_mutex_unlock(&va_cache_lock);
+}
+
 vlc_va_t *vlc_va_New(vlc_object_t *obj, AVCodecContext *avctx,
                      enum PixelFormat pix_fmt, const es_format_t *fmt,
                      picture_sys_t *p_sys)
 {
+    /* The cache is only used for the automatic choice of the back-end */
+    char *names = var_InheritString(obj, "avcodec-hw");
+    bool cached = names == NULL || !strcmp(names, "any");
+    free(names);
+
+    struct vlc_va_cache_entry key = {
+        .libvlc = obj->obj.libvlc,
+        .codec_id = avctx->codec_id,
+        .profile = avctx->profile,
+        .pix_fmt = pix_fmt,
+        .has_sys = p_sys != NULL,
+        .width = avctx->coded_width,
+        .height = avctx->coded_height,
+        .date = mdate(),
+    };
+    char module[sizeof (key.module)];
+    char list[sizeof (module) + sizeof (",any")];
+
+    if (cached)
+    {
+        if (!vlc_va_CacheLookup(&key, module, sizeof (module)))
+        {
+            msg_Dbg(obj, "no hardware decoder for this stream (cached)");
+            return NULL;
+        }
+        if (module[0] != '\0')
+            snprintf(list, sizeof (list), "%s,any", module);
+        else
+            strcpy(list, "any");
+    }
+    else
+        strcpy(list, "$avcodec-hw");
+
     vlc_va_t *va = vlc_object_create(obj, sizeof (*va));
     if (unlikely(va == NULL))
         return NULL;
 
-    va->module = vlc_module_load(va, "hw decoder", "$avcodec-hw", true,
+    va->module = vlc_module_load(va, "hw decoder", list, true,
                                  vlc_va_Start, va, avctx, pix_fmt, fmt, p_sys);
+    if (cached)
+        /* A device change is noticed when the cached back-end fails */
+        vlc_va_CacheStore(&key, va->module != NULL ?
+                                module_get_object(va->module) : NULL);
     if (va->module == NULL)
     {
         vlc_object_release(va);
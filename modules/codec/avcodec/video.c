@@ -47,6 +47,7 @@
 #include "va.h"
 
 #include "../codec/cc.h"
+#include "../codec/skip.h"
 
 /*****************************************************************************
  * decoder_sys_t : decoder descriptor
@@ -67,6 +68,8 @@ struct decoder_sys_t
     bool b_show_corrupted;
     bool b_from_preroll;
     enum AVDiscard i_skip_frame;
+    enum AVDiscard i_skip_loop_filter;
+    decoder_skip_t skip;
 
     /* how many decoded frames are late */
     int     i_late_frames;
@@ -113,6 +116,9 @@ static enum PixelFormat ffmpeg_GetFormat( AVCodecContext *,
 static int  DecodeVideo( decoder_t *, block_t * );
 static void Flush( decoder_t * );
 
+/* Number of opened video decoders, shared by all the inputs */
+static atomic_uint active_decoders = ATOMIC_VAR_INIT(0);
+
 static uint32_t ffmpeg_CodecTag( vlc_fourcc_t fcc )
 {
     uint8_t *p = (uint8_t*)&fcc;
@@ -488,6 +494,7 @@ int InitVideoDec( vlc_object_t *obj )
     else if( i_val == 2 ) p_context->skip_loop_filter = AVDISCARD_BIDIR;
     else if( i_val == 1 ) p_context->skip_loop_filter = AVDISCARD_NONREF;
     else p_context->skip_loop_filter = AVDISCARD_DEFAULT;
+    p_sys->i_skip_loop_filter = p_context->skip_loop_filter;
 
     if( var_CreateGetBool( p_dec, "avcodec-fast" ) )
         p_context->flags2 |= AV_CODEC_FLAG2_FAST;
@@ -534,15 +541,24 @@ int InitVideoDec( vlc_object_t *obj )
     p_context->get_buffer2 = lavc_GetFrame;
     p_context->opaque = p_dec;
 
+    /* The automatic thread count is a share of the CPUs among all the
+     * video decoders of the process, so that many concurrent inputs (mosaic,
+     * VLM) do not each spawn a full set of workers */
+    unsigned i_decoders = atomic_fetch_add( &active_decoders, 1 ) + 1;
     int i_thread_count = var_InheritInteger( p_dec, "avcodec-threads" );
     if( i_thread_count <= 0 )
     {
-        i_thread_count = vlc_GetCPUCount();
-        if( i_thread_count > 1 )
+        i_thread_count = vlc_GetCPUCount() / i_decoders;
+        if( i_thread_count < 1 )
+            i_thread_count = 1;
+        else if( i_thread_count > 1 )
             i_thread_count++;
 
         //FIXME: take in count the decoding time
-        i_thread_count = __MIN( i_thread_count, p_codec->id == AV_CODEC_ID_HEVC ? 12 : 6 );
+        /* JPEG 2000 frames are all intra and slow to decode: decode as many
+         * frames in parallel as there are CPUs */
+        if( p_codec->id != AV_CODEC_ID_JPEG2000 )
+            i_thread_count = __MIN( i_thread_count, p_codec->id == AV_CODEC_ID_HEVC ? 12 : 6 );
     }
     i_thread_count = __MIN( i_thread_count, p_codec->id == AV_CODEC_ID_HEVC ? 32 : 16 );
     msg_Dbg( p_dec, "allowing %d thread(s) for decoding", i_thread_count );
@@ -578,6 +594,7 @@ int InitVideoDec( vlc_object_t *obj )
     p_sys->b_first_frame = true;
     p_sys->i_late_frames = 0;
     p_sys->b_from_preroll = false;
+    decoder_skip_Reset( &p_sys->skip );
 
     /* Set output properties */
     if( GetVlcChroma( &p_dec->fmt_out.video, p_context->pix_fmt ) != VLC_SUCCESS )
@@ -603,6 +620,7 @@ int InitVideoDec( vlc_object_t *obj )
     /* ***** Open the codec ***** */
     if( OpenVideoCodec( p_dec ) < 0 )
     {
+        atomic_fetch_sub( &active_decoders, 1 );
         vlc_sem_destroy( &p_sys->sem_mt );
         free( p_sys );
         avcodec_free_context( &p_context );
@@ -630,6 +648,7 @@ static void Flush( decoder_t *p_dec )
 
     date_Set(&p_sys->pts, VLC_TS_INVALID); /* To make sure we recover properly */
     p_sys->i_late_frames = 0;
+    decoder_skip_Reset( &p_sys->skip );
     cc_Flush( &p_sys->cc );
 
     /* Abort pictures in order to unblock all avcodec workers threads waiting
@@ -658,6 +677,7 @@ static bool check_block_validity( decoder_sys_t *p_sys, block_t *block )
         cc_Flush( &p_sys->cc );
 
         p_sys->i_late_frames = 0;
+        decoder_skip_Reset( &p_sys->skip );
         if( block->i_flags & BLOCK_FLAG_CORRUPTED )
         {
             block_Release( block );
@@ -679,6 +699,7 @@ static bool check_block_being_late( decoder_sys_t *p_sys, block_t *block, mtime_
         p_sys->i_late_frames = 0;
         p_sys->b_from_preroll = true;
         p_sys->i_last_late_delay = INT64_MAX;
+        decoder_skip_Reset( &p_sys->skip );
     }
 
     if( p_sys->i_late_frames <= 0 )
@@ -694,26 +715,26 @@ static bool check_block_being_late( decoder_sys_t *p_sys, block_t *block, mtime_
     return false;
 }
 
-static bool check_frame_should_be_dropped( decoder_sys_t *p_sys, AVCodecContext *p_context, bool *b_need_output_picture )
+/* Applies the degradation level of the skip policy over the user settings */
+static void apply_skip_level( decoder_sys_t *p_sys, AVCodecContext *p_context )
 {
-    if( p_sys->i_late_frames <= 4)
-        return false;
-
-    *b_need_output_picture = false;
-    if( p_sys->i_late_frames < 12 )
-    {
-        p_context->skip_frame =
-                (p_sys->i_skip_frame <= AVDISCARD_NONREF) ?
-                AVDISCARD_NONREF : p_sys->i_skip_frame;
-    }
-    else
+    static const struct
     {
-        /* picture too late, won't decode
-         * but break picture until a new I, and for mpeg4 ...*/
-        p_sys->i_late_frames--; /* needed else it will never be decrease */
-        return true;
-    }
-    return false;
+        enum AVDiscard frame;
+        enum AVDiscard loop_filter;
+    } levels[SKIP_LEVEL_MAX + 1] = {
+        [SKIP_LEVEL_NONE]               = { AVDISCARD_DEFAULT, AVDISCARD_DEFAULT },
+        [SKIP_LEVEL_LOOP_FILTER_NONREF] = { AVDISCARD_DEFAULT, AVDISCARD_NONREF },
+        [SKIP_LEVEL_LOOP_FILTER_BIDIR]  = { AVDISCARD_DEFAULT, AVDISCARD_BIDIR },
+        [SKIP_LEVEL_FRAME_NONREF]       = { AVDISCARD_NONREF,  AVDISCARD_BIDIR },
+        [SKIP_LEVEL_FRAME_BIDIR]        = { AVDISCARD_BIDIR,   AVDISCARD_ALL },
+        [SKIP_LEVEL_FRAME_NONKEY]       = { AVDISCARD_NONKEY,  AVDISCARD_ALL },
+    };
+    const int level = p_sys->skip.level;
+
+    p_context->skip_frame = __MAX( p_sys->i_skip_frame, levels[level].frame );
+    p_context->skip_loop_filter = __MAX( p_sys->i_skip_loop_filter,
+                                         levels[level].loop_filter );
 }
 
 static void interpolate_next_pts( decoder_t *p_dec, AVFrame *frame )
@@ -763,6 +784,14 @@ static void update_late_frame_count( decoder_t *p_dec, block_t *p_block, mtime_t
    {
        p_sys->i_late_frames = 0;
    }
+
+   /* Let the policy choose what to skip from the lateness of the pictures */
+   if( i_display_date > VLC_TS_INVALID && p_sys->b_hurry_up &&
+       p_dec->b_frame_drop_allowed &&
+       decoder_skip_Update( &p_sys->skip, p_dec, current_time,
+                            current_time - i_display_date ) )
+       msg_Dbg( p_dec, "skip level %d (%"PRId64" us late on average)",
+                p_sys->skip.level, p_sys->skip.late );
 }
 
 
@@ -934,18 +963,10 @@ static picture_t *DecodeBlock( decoder_t *p_dec, block_t **pp_block, bool *error
     /* Change skip_frame config only if hurry_up is enabled */
     if( p_sys->b_hurry_up )
     {
-        p_context->skip_frame = p_sys->i_skip_frame;
-
-        /* Check also if we should/can drop the block and move to next block
-            as trying to catchup the speed*/
-        if( p_dec->b_frame_drop_allowed &&
-            check_frame_should_be_dropped( p_sys, p_context, &b_need_output_picture ) )
-        {
-            if( p_block )
-                block_Release( p_block );
-            msg_Warn( p_dec, "More than 11 late frames, dropping frame" );
-            return NULL;
-        }
+        if( p_dec->b_frame_drop_allowed )
+            apply_skip_level( p_sys, p_context );
+        else
+            p_context->skip_frame = p_sys->i_skip_frame;
     }
     if( !b_need_output_picture )
     {
@@ -1261,6 +1282,7 @@ void EndVideoDec( vlc_object_t *obj )
     if( p_sys->p_va )
         vlc_va_Delete( p_sys->p_va, &hwaccel_context );
 
+    atomic_fetch_sub( &active_decoders, 1 );
     vlc_sem_destroy( &p_sys->sem_mt );
     free( p_sys );
 }
@@ -520,6 +520,25 @@ static int DecodeBlock(decoder_t *p_dec, block_t *p_block)
 
     p_sys->p_jpeg.out_color_space = JCS_RGB;
 
+    /* Reduce the image in the DCT domain when a smaller picture is wanted,
+     * by the largest factor that keeps it at least as large */
+    unsigned i_width = var_GetInteger(p_dec, "image-width");
+    unsigned i_height = var_GetInteger(p_dec, "image-height");
+    if (i_width > 0 || i_height > 0)
+    {
+        unsigned i_denom = 8;
+
+        while (i_denom > 1
+            && ((i_width > 0
+              && (p_sys->p_jpeg.image_width + i_denom - 1) / i_denom < i_width)
+             || (i_height > 0
+              && (p_sys->p_jpeg.image_height + i_denom - 1) / i_denom < i_height)))
+            i_denom /= 2;
+
+        p_sys->p_jpeg.scale_num = 1;
+        p_sys->p_jpeg.scale_denom = i_denom;
+    }
+
     jpeg_start_decompress(&p_sys->p_jpeg);
 
     /* Set output properties */
@@ -83,9 +83,26 @@ struct decoder_sys_t
 
     /* */
     ASS_Track      *p_track;
+
+    /* Rendering ahead of the video output, on a worker thread */
+    vlc_thread_t   thread;
+    vlc_cond_t     wait;
+    bool           b_thread;
+    bool           b_quit;
+    mtime_t        i_request;  /* stream date (ms) to render ahead, or -1 */
+    mtime_t        i_last;     /* stream date (ms) of the last validation */
+    unsigned       i_image_id; /* changed when the libass images change */
+    struct
+    {
+        mtime_t              i_date;     /* stream date (ms), or -1 */
+        bool                 b_valid;    /* regions match the image id */
+        unsigned             i_image_id;
+        subpicture_region_t *p_region;
+    } ahead;
 };
 static void DecSysRelease( decoder_sys_t *p_sys );
 static void DecSysHold( decoder_sys_t *p_sys );
+static void *AheadThread( void * );
 
 /* */
 static int SubpictureValidate( subpicture_t *,
@@ -106,6 +123,9 @@ struct subpicture_updater_sys_t
     mtime_t       i_pts;
 
     ASS_Image     *p_img;
+    bool          b_copy;     /* copy the regions rendered ahead */
+    bool          b_image;    /* the regions show the image id */
+    unsigned      i_image_id;
 };
 
 typedef struct
@@ -118,6 +138,7 @@ typedef struct
 
 static int BuildRegions( rectangle_t *p_region, int i_max_region, ASS_Image *p_img_list, int i_width, int i_height );
 static void RegionDraw( subpicture_region_t *p_region, ASS_Image *p_img );
+static subpicture_region_t *RegionsNew( const video_format_t *, ASS_Image * );
 
 //#define DEBUG_REGION
 
@@ -147,6 +168,15 @@ static int Create( vlc_object_t *p_this )
     p_sys->p_library  = NULL;
     p_sys->p_renderer = NULL;
     p_sys->p_track    = NULL;
+    vlc_cond_init( &p_sys->wait );
+    p_sys->b_thread   = false;
+    p_sys->b_quit     = false;
+    p_sys->i_request  = -1;
+    p_sys->i_last     = -1;
+    p_sys->i_image_id = 0;
+    p_sys->ahead.i_date   = -1;
+    p_sys->ahead.b_valid  = false;
+    p_sys->ahead.p_region = NULL;
 
     /* Create libass library */
     ASS_Library *p_library = p_sys->p_library = ass_library_init();
@@ -268,6 +298,11 @@ static int Create( vlc_object_t *p_this )
     }
     ass_process_codec_private( p_track, p_dec->fmt_in.p_extra, p_dec->fmt_in.i_extra );
 
+    p_sys->b_thread = !vlc_clone( &p_sys->thread, AheadThread, p_sys,
+                                  VLC_THREAD_PRIORITY_LOW );
+    if( !p_sys->b_thread )
+        msg_Warn( p_dec, "cannot render ahead" );
+
     p_dec->fmt_out.i_codec = VLC_CODEC_RGBA;
 
     return VLC_SUCCESS;
@@ -300,6 +335,17 @@ static void DecSysRelease( decoder_sys_t *p_sys )
         return;
     }
     vlc_mutex_unlock( &p_sys->lock );
+
+    if( p_sys->b_thread )
+    {
+        vlc_mutex_lock( &p_sys->lock );
+        p_sys->b_quit = true;
+        vlc_cond_signal( &p_sys->wait );
+        vlc_mutex_unlock( &p_sys->lock );
+        vlc_join( p_sys->thread, NULL );
+    }
+    subpicture_region_ChainDelete( p_sys->ahead.p_region );
+    vlc_cond_destroy( &p_sys->wait );
     vlc_mutex_destroy( &p_sys->lock );
 
     if( p_sys->p_track )
@@ -370,6 +416,8 @@ static int DecodeBlock( decoder_t *p_dec, block_t *p_block )
     }
 
     p_spu_sys->p_img = NULL;
+    p_spu_sys->b_copy = false;
+    p_spu_sys->b_image = false;
     p_spu_sys->p_dec_sys = p_sys;
     p_spu_sys->i_subs_len = p_block->i_buffer;
     p_spu_sys->p_subs_data = malloc( p_block->i_buffer );
@@ -395,6 +443,8 @@ static int DecodeBlock( decoder_t *p_dec, block_t *p_block )
     {
         ass_process_chunk( p_sys->p_track, p_spu_sys->p_subs_data, p_spu_sys->i_subs_len,
                            p_block->i_pts / 1000, p_block->i_length / 1000 );
+        /* The frame rendered ahead may miss the new event */
+        p_sys->ahead.i_date = -1;
     }
     vlc_mutex_unlock( &p_sys->lock );
 
@@ -409,12 +459,55 @@ static int DecodeBlock( decoder_t *p_dec, block_t *p_block )
 /****************************************************************************
  *
  ****************************************************************************/
+/* Must be called with the lock held */
+static ASS_Image *RenderFrame( decoder_sys_t *p_sys, mtime_t i_date )
+{
+    int i_changed;
+    ASS_Image *p_img = ass_render_frame( p_sys->p_renderer, p_sys->p_track,
+                                         i_date, &i_changed );
+    if( i_changed )
+        p_sys->i_image_id++;
+    return p_img;
+}
+
+static void *AheadThread( void *data )
+{
+    decoder_sys_t *p_sys = data;
+
+    vlc_mutex_lock( &p_sys->lock );
+    for( ;; )
+    {
+        while( !p_sys->b_quit && p_sys->i_request == -1 )
+            vlc_cond_wait( &p_sys->wait, &p_sys->lock );
+        if( p_sys->b_quit )
+            break;
+
+        const mtime_t i_date = p_sys->i_request;
+        p_sys->i_request = -1;
+
+        ASS_Image *p_img = RenderFrame( p_sys, i_date );
+
+        /* Reuse the regions if the images did not change */
+        if( !p_sys->ahead.b_valid || p_sys->ahead.i_image_id != p_sys->i_image_id )
+        {
+            subpicture_region_ChainDelete( p_sys->ahead.p_region );
+            p_sys->ahead.p_region = RegionsNew( &p_sys->fmt, p_img );
+            p_sys->ahead.i_image_id = p_sys->i_image_id;
+            p_sys->ahead.b_valid = true;
+        }
+        p_sys->ahead.i_date = i_date;
+    }
+    vlc_mutex_unlock( &p_sys->lock );
+    return NULL;
+}
+
 static int SubpictureValidate( subpicture_t *p_subpic,
                                bool b_fmt_src, const video_format_t *p_fmt_src,
                                bool b_fmt_dst, const video_format_t *p_fmt_dst,
                                mtime_t i_ts )
 {
-    decoder_sys_t *p_sys = p_subpic->updater.p_sys->p_dec_sys;
+    subpicture_updater_sys_t *p_spu_sys = p_subpic->updater.p_sys;
+    decoder_sys_t *p_sys = p_spu_sys->p_dec_sys;
 
     vlc_mutex_lock( &p_sys->lock );
 
@@ -430,21 +523,55 @@ static int SubpictureValidate( subpicture_t *p_subpic,
         const double dst_ratio = (double)p_fmt_dst->i_visible_width / p_fmt_dst->i_visible_height;
         ass_set_aspect_ratio( p_sys->p_renderer, dst_ratio / src_ratio, 1 );
         p_sys->fmt = fmt;
+
+        /* The regions rendered ahead have the former size */
+        subpicture_region_ChainDelete( p_sys->ahead.p_region );
+        p_sys->ahead.p_region = NULL;
+        p_sys->ahead.b_valid = false;
+        p_sys->ahead.i_date = -1;
     }
 
     /* */
-    const mtime_t i_stream_date = p_subpic->updater.p_sys->i_pts + (i_ts - p_subpic->i_start);
-    int i_changed;
-    ASS_Image *p_img = ass_render_frame( p_sys->p_renderer, p_sys->p_track,
-                                         i_stream_date/1000, &i_changed );
+    const mtime_t i_stream_date = ( p_spu_sys->i_pts + (i_ts - p_subpic->i_start) ) / 1000;
 
-    if( !i_changed && !b_fmt_src && !b_fmt_dst &&
-        (p_img != NULL) == (p_subpic->p_region != NULL) )
+    /* Ask the worker for the next frame, assuming a steady frame rate */
+    if( p_sys->b_thread && i_stream_date != p_sys->i_last )
+    {
+        if( p_sys->i_last != -1 && i_stream_date > p_sys->i_last &&
+            i_stream_date - p_sys->i_last < 1000 )
+        {
+            p_sys->i_request = 2 * i_stream_date - p_sys->i_last;
+            vlc_cond_signal( &p_sys->wait );
+        }
+        p_sys->i_last = i_stream_date;
+    }
+
+    unsigned i_image_id;
+    bool b_copy;
+    ASS_Image *p_img = NULL;
+    if( p_sys->ahead.i_date != i_stream_date || !p_sys->ahead.b_valid )
+    {
+        p_img = RenderFrame( p_sys, i_stream_date );
+        i_image_id = p_sys->i_image_id;
+        b_copy = p_sys->ahead.b_valid && p_sys->ahead.i_image_id == i_image_id;
+    }
+    else
+    {
+        /* Rendered ahead */
+        i_image_id = p_sys->ahead.i_image_id;
+        b_copy = true;
+    }
+
+    if( p_spu_sys->b_image && p_spu_sys->i_image_id == i_image_id &&
+        !b_fmt_src && !b_fmt_dst )
     {
         vlc_mutex_unlock( &p_sys->lock );
         return VLC_SUCCESS;
     }
-    p_subpic->updater.p_sys->p_img = p_img;
+    p_spu_sys->p_img = p_img;
+    p_spu_sys->b_copy = b_copy;
+    p_spu_sys->b_image = true;
+    p_spu_sys->i_image_id = i_image_id;
 
     /* The lock is released by SubpictureUpdate */
     return VLC_EGENERIC;
@@ -457,15 +584,38 @@ static void SubpictureUpdate( subpicture_t *p_subpic,
 {
     VLC_UNUSED( p_fmt_src ); VLC_UNUSED( p_fmt_dst ); VLC_UNUSED( i_ts );
 
-    decoder_sys_t *p_sys = p_subpic->updater.p_sys->p_dec_sys;
+    subpicture_updater_sys_t *p_spu_sys = p_subpic->updater.p_sys;
+    decoder_sys_t *p_sys = p_spu_sys->p_dec_sys;
 
     video_format_t fmt = p_sys->fmt;
-    ASS_Image *p_img = p_subpic->updater.p_sys->p_img;
 
     /* */
     p_subpic->i_original_picture_height = fmt.i_visible_height;
     p_subpic->i_original_picture_width = fmt.i_visible_width;
 
+    if( p_spu_sys->b_copy )
+    {
+        /* Copying the pictures is cheaper than blending the images again */
+        subpicture_region_t **pp_region_last = &p_subpic->p_region;
+        for( subpicture_region_t *p_src = p_sys->ahead.p_region;
+             p_src; p_src = p_src->p_next )
+        {
+            subpicture_region_t *r = subpicture_region_Copy( p_src );
+            if( !r )
+                break;
+            *pp_region_last = r;
+            pp_region_last = &r->p_next;
+        }
+    }
+    else
+        p_subpic->p_region = RegionsNew( &fmt, p_spu_sys->p_img );
+
+    vlc_mutex_unlock( &p_sys->lock );
+}
+
+/* Draws the images in a few regions */
+static subpicture_region_t *RegionsNew( const video_format_t *p_fmt, ASS_Image *p_img )
+{
     /* XXX to improve efficiency we merge regions that are close minimizing
      * the lost surface.
      * libass tends to create a lot of small regions and thus spu engine
@@ -474,16 +624,11 @@ static void SubpictureUpdate( subpicture_t *p_subpic,
      */
     const int i_max_region = 4;
     rectangle_t region[i_max_region];
-    const int i_region = BuildRegions( region, i_max_region, p_img, fmt.i_width, fmt.i_height );
-
-    if( i_region <= 0 )
-    {
-        vlc_mutex_unlock( &p_sys->lock );
-        return;
-    }
+    const int i_region = BuildRegions( region, i_max_region, p_img, p_fmt->i_width, p_fmt->i_height );
 
     /* Allocate the regions and draw them */
-    subpicture_region_t **pp_region_last = &p_subpic->p_region;
+    subpicture_region_t *p_head = NULL;
+    subpicture_region_t **pp_region_last = &p_head;
 
     for( int i = 0; i < i_region; i++ )
     {
@@ -491,7 +636,7 @@ static void SubpictureUpdate( subpicture_t *p_subpic,
         video_format_t fmt_region;
 
         /* */
-        fmt_region = fmt;
+        fmt_region = *p_fmt;
         fmt_region.i_width =
         fmt_region.i_visible_width  = region[i].x1 - region[i].x0;
         fmt_region.i_height =
@@ -511,9 +656,9 @@ static void SubpictureUpdate( subpicture_t *p_subpic,
         *pp_region_last = r;
         pp_region_last = &r->p_next;
     }
-    vlc_mutex_unlock( &p_sys->lock );
-
+    return p_head;
 }
+
 static void SubpictureDestroy( subpicture_t *p_subpic )
 {
     subpicture_updater_sys_t *p_sys = p_subpic->updater.p_sys;
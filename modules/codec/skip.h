@@ -0,0 +1,134 @@
+/*****************************************************************************
+ * skip.h: decoding degradation policy
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_CODEC_SKIP_H_
+#define VLC_CODEC_SKIP_H_
+
+#include <vlc_codec.h>
+
+/* Chooses how much of the decoding to skip when the decoder cannot keep up,
+ * from how late the pictures are decoded, how late the video output
+ * displays them and how many blocks are waiting to be decoded.
+ *
+ * The level is raised one step at a time while the decoder is late, and
+ * lowered much more slowly once it is in time again, so that the quality
+ * degrades smoothly instead of swinging between bursts of drops. */
+
+/* Degradation levels, from none to the worst */
+enum
+{
+    SKIP_LEVEL_NONE,
+    SKIP_LEVEL_LOOP_FILTER_NONREF, /* no deblocking of non-reference frames */
+    SKIP_LEVEL_LOOP_FILTER_BIDIR,  /* no deblocking of B frames */
+    SKIP_LEVEL_FRAME_NONREF,       /* non-reference frames are skipped */
+    SKIP_LEVEL_FRAME_BIDIR,        /* B frames are skipped, no deblocking */
+    SKIP_LEVEL_FRAME_NONKEY,       /* only key frames are decoded */
+    SKIP_LEVEL_MAX = SKIP_LEVEL_FRAME_NONKEY,
+};
+
+/* Average lateness above which the decoder is considered too slow */
+#define SKIP_LATE_THRESHOLD (CLOCK_FREQ / 50)
+/* Time to be too slow before the level is raised */
+#define SKIP_RAISE_DELAY    (CLOCK_FREQ / 4)
+/* Time to be in time before the level is lowered */
+#define SKIP_LOWER_DELAY    (2 * CLOCK_FREQ)
+
+typedef struct
+{
+    int      level;
+    mtime_t  late;     /* smoothed lateness, negative when in advance */
+    mtime_t  changed;  /* date of the last level change */
+    mtime_t  pressure; /* since when the decoder is late */
+    mtime_t  relief;   /* since when the decoder is in time */
+    unsigned queued;   /* blocks waiting at the last level change */
+} decoder_skip_t;
+
+static inline void decoder_skip_Reset(decoder_skip_t *skip)
+{
+    skip->level = SKIP_LEVEL_NONE;
+    skip->late = 0;
+    skip->changed = VLC_TS_INVALID;
+    skip->pressure = VLC_TS_INVALID;
+    skip->relief = VLC_TS_INVALID;
+    skip->queued = 0;
+}
+
+/* Updates the policy with a decoded picture, late by the given time (that is
+ * negative if the picture was decoded before its display date). Returns true
+ * if the level changed. */
+static inline bool decoder_skip_Update(decoder_skip_t *skip, decoder_t *dec,
+                                       mtime_t now, mtime_t late)
+{
+    decoder_load_t load;
+
+    if (decoder_GetLoad(dec, &load) != VLC_SUCCESS)
+        load.i_queued = load.i_displayed = 0;
+    /* The video output may be the bottleneck */
+    if (load.i_displayed > 0 && load.i_late > SKIP_LATE_THRESHOLD
+     && load.i_late > late)
+        late = load.i_late;
+
+    skip->late = (7 * skip->late + late) / 8;
+
+    if (skip->late > SKIP_LATE_THRESHOLD)
+    {
+        skip->relief = VLC_TS_INVALID;
+        if (skip->pressure == VLC_TS_INVALID)
+            skip->pressure = now;
+
+        if (skip->level < SKIP_LEVEL_MAX
+         && now - skip->pressure >= SKIP_RAISE_DELAY
+         && (skip->changed == VLC_TS_INVALID
+          || now - skip->changed >= SKIP_RAISE_DELAY))
+        {
+            skip->level++;
+            skip->changed = skip->pressure = now;
+            skip->queued = load.i_queued;
+            return true;
+        }
+    }
+    else if (skip->late < 0)
+    {
+        skip->pressure = VLC_TS_INVALID;
+        if (skip->relief == VLC_TS_INVALID)
+            skip->relief = now;
+
+        /* Do not lower while the backlog is still growing */
+        if (skip->level > SKIP_LEVEL_NONE
+         && now - skip->relief >= SKIP_LOWER_DELAY
+         && now - skip->changed >= SKIP_LOWER_DELAY
+         && load.i_queued <= skip->queued + skip->queued / 8 + 1)
+        {
+            skip->level--;
+            skip->changed = skip->relief = now;
+            skip->queued = load.i_queued;
+            return true;
+        }
+    }
+    else
+    {
+        /* Dead band between the two thresholds */
+        skip->pressure = VLC_TS_INVALID;
+        skip->relief = VLC_TS_INVALID;
+    }
+    return false;
+}
+
+#endif
@@ -33,6 +33,9 @@
 
 #include <ctype.h>
 #include <assert.h>
+#ifdef HAVE_SEARCH_H
+# include <search.h>
+#endif
 
 #include "substext.h"
 #include "ttml.h"
@@ -82,8 +85,19 @@ typedef struct
     ttml_length_t    root_extent_h, root_extent_v;
     unsigned         i_cell_resolution_v;
     unsigned         i_cell_resolution_h;
+    /* Lookups and styles computed once per document, as they do not
+     * depend on the playback time */
+    vlc_dictionary_t style_nodes;  /* referenced <style>, by id */
+    vlc_dictionary_t region_nodes; /* referenced <region>, by id */
+    void *           p_inherited;  /* ttml_inherited_t tree, by node */
 } ttml_context_t;
 
+typedef struct
+{
+    const tt_node_t *p_node;
+    ttml_style_t    *p_style; /* NULL if nothing is inherited */
+} ttml_inherited_t;
+
 typedef struct
 {
     subpicture_updater_sys_region_t updt;
@@ -147,7 +161,7 @@ static void ttml_region_Delete( ttml_region_t *p_region )
 
 static ttml_style_t * ttml_style_Duplicate( const ttml_style_t *p_src )
 {
-    ttml_style_t *p_dup = ttml_style_New( );
+    ttml_style_t *p_dup = malloc( sizeof( *p_dup ) );
     if( p_dup )
     {
         *p_dup = *p_src;
@@ -261,6 +275,21 @@ static tt_node_t * FindNode( tt_node_t *p_node, const char *psz_nodename,
     return NULL;
 }
 
+static const tt_node_t * FindNodeByID( ttml_context_t *p_ctx,
+                                       vlc_dictionary_t *p_cache,
+                                       const char *psz_nodename,
+                                       const char *psz_id )
+{
+    const tt_node_t *p_node = vlc_dictionary_value_for_key( p_cache, psz_id );
+    if( p_node == kVLCDictionaryNotFound )
+    {
+        p_node = FindNode( p_ctx->p_rootnode, psz_nodename, -1, psz_id );
+        if( p_node )
+            vlc_dictionary_insert( p_cache, psz_id, (void *) p_node );
+    }
+    return p_node;
+}
+
 static void FillTextStyle( const char *psz_attr, const char *psz_val,
                            text_style_t *p_text_style )
 {
@@ -542,8 +571,8 @@ static void DictMergeWithStyleID( ttml_context_t *p_ctx, const char *psz_id,
     if( psz_id && p_ctx->p_rootnode )
     {
         /* Lookup referenced style ID */
-        const tt_node_t *p_node = FindNode( p_ctx->p_rootnode,
-                                            "style", -1, psz_id );
+        const tt_node_t *p_node = FindNodeByID( p_ctx, &p_ctx->style_nodes,
+                                                "style", psz_id );
         if( p_node )
             DictionaryMerge( &p_node->attr_dict, p_dst );
     }
@@ -555,8 +584,8 @@ static void DictMergeWithRegionID( ttml_context_t *p_ctx, const char *psz_id,
     assert(p_ctx->p_rootnode);
     if( psz_id && p_ctx->p_rootnode )
     {
-        const tt_node_t *p_regionnode = FindNode( p_ctx->p_rootnode,
-                                                 "region", -1, psz_id );
+        const tt_node_t *p_regionnode = FindNodeByID( p_ctx, &p_ctx->region_nodes,
+                                                     "region", psz_id );
         if( !p_regionnode )
             return;
 
@@ -596,7 +625,22 @@ static void DictToTTMLStyle( ttml_context_t *p_ctx, const vlc_dictionary_t *p_di
     ComputeTTMLStyles( p_ctx, p_dict, p_ttml_style );
 }
 
-static ttml_style_t * InheritTTMLStyles( ttml_context_t *p_ctx, tt_node_t *p_node )
+static int ttml_inherited_Compare( const void *a, const void *b )
+{
+    const tt_node_t *p_a = ((const ttml_inherited_t *) a)->p_node;
+    const tt_node_t *p_b = ((const ttml_inherited_t *) b)->p_node;
+    return ( p_a > p_b ) - ( p_a < p_b );
+}
+
+static void ttml_inherited_Delete( void *p )
+{
+    ttml_inherited_t *p_inherited = p;
+    if( p_inherited->p_style )
+        ttml_style_Delete( p_inherited->p_style );
+    free( p_inherited );
+}
+
+static ttml_style_t * ComputeInheritedTTMLStyles( ttml_context_t *p_ctx, tt_node_t *p_node )
 {
     assert( p_node );
     ttml_style_t *p_ttml_style = NULL;
@@ -629,6 +673,35 @@ static ttml_style_t * InheritTTMLStyles( ttml_context_t *p_ctx, tt_node_t *p_nod
     return p_ttml_style;
 }
 
+/* Returns a copy of the styles inherited by the node, computed the first
+ * time the node is met in the document */
+static ttml_style_t * InheritTTMLStyles( ttml_context_t *p_ctx, tt_node_t *p_node )
+{
+    ttml_inherited_t key = { .p_node = p_node };
+    ttml_inherited_t **pp_found = tfind( &key, &p_ctx->p_inherited,
+                                         ttml_inherited_Compare );
+    if( pp_found == NULL )
+    {
+        ttml_inherited_t *p_inherited = malloc( sizeof( *p_inherited ) );
+        if( unlikely( p_inherited == NULL ) )
+            return ComputeInheritedTTMLStyles( p_ctx, p_node );
+        p_inherited->p_node = p_node;
+        p_inherited->p_style = ComputeInheritedTTMLStyles( p_ctx, p_node );
+
+        pp_found = tsearch( p_inherited, &p_ctx->p_inherited,
+                            ttml_inherited_Compare );
+        if( unlikely( pp_found == NULL ) )
+        {
+            ttml_style_t *p_style = p_inherited->p_style;
+            free( p_inherited );
+            return p_style;
+        }
+    }
+
+    const ttml_style_t *p_style = (*pp_found)->p_style;
+    return p_style ? ttml_style_Duplicate( p_style ) : NULL;
+}
+
 static int ParseTTMLChunk( xml_reader_t *p_reader, tt_node_t **pp_rootnode )
 {
     const char* psz_node_name;
@@ -907,6 +980,9 @@ static tt_node_t *ParseTTML( decoder_t *p_dec, const uint8_t *p_buffer, size_t i
 static void InitTTMLContext( tt_node_t *p_rootnode, ttml_context_t *p_ctx )
 {
     p_ctx->p_rootnode = p_rootnode;
+    vlc_dictionary_init( &p_ctx->style_nodes, 0 );
+    vlc_dictionary_init( &p_ctx->region_nodes, 0 );
+    p_ctx->p_inherited = NULL;
     /* set defaults required for size/cells computation */
     p_ctx->root_extent_h.i_value = 100;
     p_ctx->root_extent_h.unit = TTML_UNIT_PERCENT;
@@ -935,26 +1011,30 @@ static void InitTTMLContext( tt_node_t *p_rootnode, ttml_context_t *p_ctx )
     }
 }
 
-static ttml_region_t *GenerateRegions( tt_node_t *p_rootnode, tt_time_t playbacktime )
+static void CleanTTMLContext( ttml_context_t *p_ctx )
+{
+    tdestroy( p_ctx->p_inherited, ttml_inherited_Delete );
+    vlc_dictionary_clear( &p_ctx->region_nodes, NULL, NULL );
+    vlc_dictionary_clear( &p_ctx->style_nodes, NULL, NULL );
+}
+
+static ttml_region_t *GenerateRegions( ttml_context_t *p_ctx, tt_time_t playbacktime )
 {
     ttml_region_t*  p_regions = NULL;
     ttml_region_t** pp_region_last = &p_regions;
+    tt_node_t *p_rootnode = p_ctx->p_rootnode;
 
     if( !tt_node_NameCompare( p_rootnode->psz_node_name, "tt" ) )
     {
         const tt_node_t *p_bodynode = FindNode( p_rootnode, "body", 1, NULL );
         if( p_bodynode )
         {
-            ttml_context_t context;
-            InitTTMLContext( p_rootnode, &context );
-            context.p_rootnode = p_rootnode;
-
-            vlc_dictionary_init( &context.regions, 1 );
-            ConvertNodesToRegionContent( &context, p_bodynode, NULL, NULL, playbacktime );
+            vlc_dictionary_init( &p_ctx->regions, 1 );
+            ConvertNodesToRegionContent( p_ctx, p_bodynode, NULL, NULL, playbacktime );
 
-            for( int i = 0; i < context.regions.i_size; ++i )
+            for( int i = 0; i < p_ctx->regions.i_size; ++i )
             {
-                for ( const vlc_dictionary_entry_t* p_entry = context.regions.p_entries[i];
+                for ( const vlc_dictionary_entry_t* p_entry = p_ctx->regions.p_entries[i];
                                                     p_entry != NULL; p_entry = p_entry->p_next )
                 {
                     *pp_region_last = (ttml_region_t *) p_entry->p_value;
@@ -962,7 +1042,7 @@ static ttml_region_t *GenerateRegions( tt_node_t *p_rootnode, tt_time_t playback
                 }
             }
 
-            vlc_dictionary_clear( &context.regions, NULL, NULL );
+            vlc_dictionary_clear( &p_ctx->regions, NULL, NULL );
         }
     }
     else if ( !tt_node_NameCompare( p_rootnode->psz_node_name, "div" ) ||
@@ -1004,6 +1084,10 @@ static int ParseBlock( decoder_t *p_dec, const block_t *p_block )
     tt_timings_Resolve( (tt_basenode_t *) p_rootnode, &temporal_extent,
                         &p_timings_array, &i_timings_count );
 
+    /* The context is kept for all the cues of the document */
+    ttml_context_t context;
+    InitTTMLContext( p_rootnode, &context );
+
 #ifdef TTML_DEBUG
     for( size_t i=0; i<i_timings_count; i++ )
         printf("%ld ", tt_time_Convert( &p_timings_array[i] ) );
@@ -1020,7 +1104,7 @@ static int ParseBlock( decoder_t *p_dec, const block_t *p_block )
             break;
 
         subpicture_t *p_spu = NULL;
-        ttml_region_t *p_regions = GenerateRegions( p_rootnode, p_timings_array[i] );
+        ttml_region_t *p_regions = GenerateRegions( &context, p_timings_array[i] );
         if( p_regions && ( p_spu = decoder_NewSubpictureText( p_dec ) ) )
         {
             p_spu->i_start    = VLC_TS_0 + tt_time_Convert( &p_timings_array[i] );
@@ -1075,6 +1159,7 @@ static int ParseBlock( decoder_t *p_dec, const block_t *p_block )
             decoder_QueueSub( p_dec, p_spu );
     }
 
+    CleanTTMLContext( &context );
     tt_node_RecursiveDelete( p_rootnode );
 
     free( p_timings_array );
@@ -259,7 +259,8 @@ static bool ParseH264NAL(decoder_t *p_dec,
                 sei.i_pic_struct = UINT8_MAX;
 
                 if(p_sei_nal)
-                    HxxxParseSEI(p_sei_nal, i_sei_nal, 1, ParseH264SEI, &sei);
+                    HxxxParseSEI(p_sei_nal, i_sei_nal, 1, HXXX_SEI_MASK_PIC_TIMING,
+                                 ParseH264SEI, &sei);
 
                 p_info->i_num_ts = h264_get_num_ts(p_sps, &slice, sei.i_pic_struct,
                                                    p_info->i_foc, bFOC);
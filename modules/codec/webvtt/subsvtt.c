@@ -121,6 +121,7 @@ struct webvtt_dom_cue_t
     webvtt_cue_settings_t settings;
     unsigned i_lines;
     text_style_t *p_cssstyle;
+    bool b_css_applied;
     webvtt_dom_node_t *p_child;
 };
 
@@ -151,6 +152,7 @@ struct decoder_sys_t
 #ifdef HAVE_CSS
     /* CSS */
     vlc_css_rule_t *p_css_rules;
+    bool b_css_timed; /* rules with :past or :future */
 #endif
 };
 
@@ -532,6 +534,21 @@ static bool webvtt_domnode_Match_PseudoClass( const webvtt_dom_node_t *p_node, c
     return false;
 }
 
+#ifdef HAVE_CSS
+static bool vlc_css_selectors_AreTimed( const vlc_css_selector_t *p_sel )
+{
+    for( ; p_sel; p_sel = p_sel->p_next )
+    {
+        if( ( p_sel->type == SELECTOR_PSEUDOCLASS &&
+              ( !strcmp(p_sel->psz_name, "past") || !strcmp(p_sel->psz_name, "future") ) ) ||
+            vlc_css_selectors_AreTimed( p_sel->specifiers.p_first ) ||
+            vlc_css_selectors_AreTimed( p_sel->p_matchsel ) )
+            return true;
+    }
+    return false;
+}
+#endif
+
 static bool webvtt_domnode_Match_PseudoElement( const webvtt_dom_node_t *p_node, const char *psz )
 {
     if( !strcmp(psz, "cue") )
@@ -761,6 +778,26 @@ static void webvtt_domnode_SelectNodesInTree( decoder_t *p_dec, const vlc_css_se
                                            i_playbacktime, p_results );
 }
 
+/* Without timed rules, the styles computed for a cue stay valid, and only
+ * the new cues (and the regions they are added to) need matching */
+static bool webvtt_domnode_NeedsCSSRules( decoder_t *p_dec, const webvtt_dom_node_t *p_node )
+{
+    if( p_dec->p_sys->b_css_timed )
+        return true;
+
+    if( p_node->type == NODE_CUE )
+        return !((const webvtt_dom_cue_t *)p_node)->b_css_applied;
+
+    for( const webvtt_dom_node_t *p_child = webvtt_domnode_getFirstChild( p_node );
+                                  p_child; p_child = p_child->p_next )
+    {
+        if( p_child->type == NODE_CUE &&
+            !((const webvtt_dom_cue_t *)p_child)->b_css_applied )
+            return true;
+    }
+    return false;
+}
+
 static void webvtt_domnode_SelectRuleNodes( decoder_t *p_dec, const vlc_css_rule_t *p_rule,
                                             mtime_t i_playbacktime, vlc_array_t *p_results )
 {
@@ -771,6 +808,8 @@ static void webvtt_domnode_SelectRuleNodes( decoder_t *p_dec, const vlc_css_rule
         vlc_array_init( &tempresults );
         for( const webvtt_dom_node_t *p_node = p_cues; p_node; p_node = p_node->p_next )
         {
+            if( !webvtt_domnode_NeedsCSSRules( p_dec, p_node ) )
+                continue;
             webvtt_domnode_SelectNodesInTree( p_dec, p_sel, p_node, WEBVTT_MAX_DEPTH,
                                               i_playbacktime, &tempresults );
         }
@@ -841,6 +880,7 @@ static webvtt_dom_cue_t * webvtt_dom_cue_New( mtime_t i_start, mtime_t i_end )
         p_cue->p_child = NULL;
         p_cue->i_lines = 0;
         p_cue->p_cssstyle = NULL;
+        p_cue->b_css_applied = false;
         webvtt_cue_settings_Init( &p_cue->settings );
     }
     return p_cue;
@@ -1510,6 +1550,17 @@ static void ApplyCSSRules( decoder_t *p_dec, const vlc_css_rule_t *p_rule,
         vlc_array_clear( &results );
     }
 }
+
+static void MarkCSSRulesApplied( webvtt_dom_node_t *p_node )
+{
+    for( ; p_node; p_node = p_node->p_next )
+    {
+        if( p_node->type == NODE_CUE )
+            ((webvtt_dom_cue_t *)p_node)->b_css_applied = true;
+        else if( p_node->type == NODE_REGION )
+            MarkCSSRulesApplied( ((webvtt_region_t *)p_node)->p_child );
+    }
+}
 #endif
 
 static void RenderRegions( decoder_t *p_dec, mtime_t i_start, mtime_t i_stop )
@@ -1519,6 +1570,7 @@ static void RenderRegions( decoder_t *p_dec, mtime_t i_start, mtime_t i_stop )
 
 #ifdef HAVE_CSS
     ApplyCSSRules( p_dec, p_dec->p_sys->p_css_rules, i_start );
+    MarkCSSRulesApplied( p_dec->p_sys->p_root->p_child );
 #endif
 
     for( const webvtt_dom_node_t *p_node = p_dec->p_sys->p_root->p_child;
@@ -1612,6 +1664,16 @@ static int timedtagsArrayCmp( const void *a, const void *b )
     return result == 0 ? 0 : result > 0 ? 1 : -1;
 }
 
+static inline bool CSSStylesAreTimed( const decoder_sys_t *p_sys )
+{
+#ifdef HAVE_CSS
+    return p_sys->b_css_timed;
+#else
+    VLC_UNUSED(p_sys);
+    return true;
+#endif
+}
+
 static void Render( decoder_t *p_dec, mtime_t i_start, mtime_t i_stop )
 {
     decoder_sys_t *p_sys = p_dec->p_sys;
@@ -1629,7 +1691,7 @@ static void Render( decoder_t *p_dec, mtime_t i_start, mtime_t i_stop )
                  (const webvtt_dom_tag_t *) vlc_array_item_at_index( &timedtags, i );
          if( p_tag->i_start != i_substart ) /* might be duplicates */
          {
-             if( i > 0 )
+             if( i > 0 && CSSStylesAreTimed( p_sys ) )
                  ClearCSSStyles( (webvtt_dom_node_t *)p_sys->p_root );
              RenderRegions( p_dec, i_substart, p_tag->i_start );
              i_substart = p_tag->i_start;
@@ -1637,7 +1699,7 @@ static void Render( decoder_t *p_dec, mtime_t i_start, mtime_t i_stop )
     }
     if( i_substart != i_stop )
     {
-        if( i_substart != i_start )
+        if( i_substart != i_start && CSSStylesAreTimed( p_sys ) )
             ClearCSSStyles( (webvtt_dom_node_t *)p_sys->p_root );
         RenderRegions( p_dec, i_substart, i_stop );
     }
@@ -1746,6 +1808,13 @@ static void ParserHeaderHandler( void *priv, enum webvtt_header_line_e s,
 #  ifdef CSS_PARSER_DEBUG
                 vlc_css_parser_Debug( &p );
 #  endif
+                for( const vlc_css_rule_t *p_rule = p.rules.p_first;
+                                           p_rule; p_rule = p_rule->p_next )
+                {
+                    if( vlc_css_selectors_AreTimed( p_rule->p_selectors ) )
+                        p_sys->b_css_timed = true;
+                }
+
                 vlc_css_rule_t **pp_append = &p_sys->p_css_rules;
                 while( *pp_append )
                     pp_append = &((*pp_append)->p_next);
@@ -414,6 +414,12 @@ static void x264_log( void *, int i_level, const char *psz, va_list );
 #define LOOKAHEAD_LONGTEXT N_("Framecount to use on frametype lookahead. " \
     "Currently default can cause sync-issues on unmuxable output, like rtsp-output without ts-mux" )
 
+#define LATENCY_TEXT N_("Latency budget (ms)")
+#define LATENCY_LONGTEXT N_("Maximum time a picture may spend in the encoder " \
+    "for live output. The threading, lookahead and B-frames are chosen to " \
+    "fit in this budget, below one frame the pictures are split in slices " \
+    "encoded in parallel. 0 leaves the encoder settings as they are." )
+
 #define HRD_TEXT N_("HRD-timing information")
 #define TUNE_TEXT N_("Default tune setting used" )
 #define PRESET_TEXT N_("Default preset setting used" )
@@ -689,6 +695,10 @@ vlc_module_begin ()
                  LOOKAHEAD_LONGTEXT, true )
         change_integer_range( 0, 60 )
 
+    add_integer( SOUT_CFG_PREFIX "latency", 0, LATENCY_TEXT,
+                 LATENCY_LONGTEXT, true )
+        change_integer_range( 0, 10000 )
+
     add_bool( SOUT_CFG_PREFIX "intra-refresh", false, INTRAREFRESH_TEXT,
               INTRAREFRESH_LONGTEXT, true )
 
@@ -772,7 +782,7 @@ static const char *const ppsz_sout_options[] = {
     "qpmin", "quiet", "ratetol", "ref", "scenecut",
     "sps-id", "ssim", "stats", "subme", "trellis",
     "verbose", "vbv-bufsize", "vbv-init", "vbv-maxrate", "weightb", "weightp",
-    "aq-mode", "aq-strength", "psy-rd", "psy", "profile", "lookahead", "slices",
+    "aq-mode", "aq-strength", "psy-rd", "psy", "profile", "lookahead", "latency", "slices",
     "slice-max-size", "slice-max-mbs", "intra-refresh", "mbtree", "hrd",
     "tune","preset", "opengop", "bluray-compat", "frame-packing", "options",
     "fullrange",
@@ -781,6 +791,11 @@ static const char *const ppsz_sout_options[] = {
 
 static block_t *Encode( encoder_t *, picture_t * );
 
+/* Number of pictures whose submission date is remembered */
+#define LATENCY_HISTORY 64
+/* Period of the latency reports */
+#define LATENCY_REPORT  (5 * CLOCK_FREQ)
+
 struct encoder_sys_t
 {
     x264_t          *h;
@@ -788,6 +803,18 @@ struct encoder_sys_t
 
     mtime_t         i_initial_delay;
 
+    /* Encoding latency statistics */
+    struct
+    {
+        mtime_t     pts;
+        mtime_t     date;
+    } submitted[LATENCY_HISTORY];
+    unsigned        i_submitted;
+    mtime_t         i_latency_sum;
+    mtime_t         i_latency_max;
+    unsigned        i_latency_count;
+    mtime_t         i_latency_report;
+
     char            *psz_stat_name;
     int             i_sei_size;
     uint32_t         i_colorspace;
@@ -799,6 +826,63 @@ static vlc_mutex_t pthread_win32_mutex = VLC_STATIC_MUTEX;
 static int pthread_win32_count = 0;
 #endif
 
+/*****************************************************************************
+ * SetLatency: fit the encoder delay in a live latency budget
+ *****************************************************************************/
+static void SetLatency( encoder_t *p_enc, int64_t i_budget_ms )
+{
+    x264_param_t *param = &p_enc->p_sys->param;
+    unsigned i_num = p_enc->fmt_in.video.i_frame_rate;
+    unsigned i_den = p_enc->fmt_in.video.i_frame_rate_base;
+
+    if( i_num == 0 || i_den == 0 )
+    {
+        i_num = 25;
+        i_den = 1;
+    }
+
+    /* Budget in frames. Every frame thread, lookahead frame and B-frame
+     * delays the output by one frame. */
+    int i_frames = i_budget_ms * i_num / (i_den * 1000);
+
+    param->i_sync_lookahead = 0;
+    if( i_frames < 2 )
+    {
+        /* Sub-frame latency: encode each picture as slices in parallel */
+        param->b_sliced_threads = 1;
+        param->i_bframe = 0;
+        param->rc.i_lookahead = 0;
+        param->rc.b_mb_tree = 0;
+        msg_Dbg( p_enc, "latency budget %"PRId64" ms: sliced threads",
+                 i_budget_ms );
+        return;
+    }
+
+    int i_threads = param->i_threads;
+    if( i_threads <= 0 )
+        i_threads = vlc_GetCPUCount() * 3 / 2;
+    if( i_threads > i_frames - 1 )
+        i_threads = i_frames - 1;
+    param->b_sliced_threads = 0;
+    param->i_threads = i_threads;
+
+    int i_left = i_frames - i_threads;
+    if( param->i_bframe > i_left )
+        param->i_bframe = i_left;
+    if( param->rc.i_lookahead > i_left )
+        param->rc.i_lookahead = i_left;
+    if( param->rc.i_lookahead == 0 )
+        param->rc.b_mb_tree = 0;
+#if X264_BUILD >= 130
+    /* Keep the lookahead from stalling the frame threads */
+    if( param->rc.i_lookahead > 0 )
+        param->i_lookahead_threads = X264_THREADS_AUTO;
+#endif
+    msg_Dbg( p_enc, "latency budget %"PRId64" ms: %d frame threads, "
+             "%d lookahead, %d B-frames", i_budget_ms, i_threads,
+             param->rc.i_lookahead, param->i_bframe );
+}
+
 /*****************************************************************************
  * Open: probe the encoder
  *****************************************************************************/
@@ -900,6 +984,13 @@ static int  Open ( vlc_object_t *p_this )
     p_sys->psz_stat_name = NULL;
     p_sys->i_sei_size = 0;
     p_sys->p_sei = NULL;
+    for( i = 0; i < LATENCY_HISTORY; i++ )
+        p_sys->submitted[i].pts = VLC_TS_INVALID;
+    p_sys->i_submitted = 0;
+    p_sys->i_latency_sum = 0;
+    p_sys->i_latency_max = 0;
+    p_sys->i_latency_count = 0;
+    p_sys->i_latency_report = VLC_TS_INVALID;
 
     char *psz_preset = var_GetString( p_enc, SOUT_CFG_PREFIX  "preset" );
     char *psz_tune = var_GetString( p_enc, SOUT_CFG_PREFIX  "tune" );
@@ -1420,6 +1511,10 @@ static int  Open ( vlc_object_t *p_this )
        p_sys->param.rc.i_lookahead = var_GetInteger( p_enc, SOUT_CFG_PREFIX "lookahead" );
     }
 
+    i_val = var_GetInteger( p_enc, SOUT_CFG_PREFIX "latency" );
+    if( i_val > 0 )
+        SetLatency( p_enc, i_val );
+
     /* We don't want repeated headers, we repeat p_extra ourself if needed */
     p_sys->param.b_repeat_headers = 0;
 
@@ -1522,6 +1617,45 @@ static void x264_log( void *data, int i_level, const char *psz, va_list args)
     msg_GenericVa( p_enc, i_level, psz, args );
 };
 
+/****************************************************************************
+ * UpdateLatency: accounts the time the picture spent in the encoder
+ ****************************************************************************/
+static void UpdateLatency( encoder_t *p_enc, mtime_t i_pts )
+{
+    encoder_sys_t *p_sys = p_enc->p_sys;
+    mtime_t now = mdate();
+
+    for( unsigned i = 0; i < LATENCY_HISTORY; i++ )
+    {
+        if( p_sys->submitted[i].pts != i_pts )
+            continue;
+
+        mtime_t i_latency = now - p_sys->submitted[i].date;
+        p_sys->submitted[i].pts = VLC_TS_INVALID;
+        p_sys->i_latency_sum += i_latency;
+        if( i_latency > p_sys->i_latency_max )
+            p_sys->i_latency_max = i_latency;
+        p_sys->i_latency_count++;
+        break;
+    }
+
+    if( p_sys->i_latency_report == VLC_TS_INVALID )
+        p_sys->i_latency_report = now;
+    if( now - p_sys->i_latency_report < LATENCY_REPORT
+     || p_sys->i_latency_count == 0 )
+        return;
+
+    msg_Dbg( p_enc, "encoding latency %"PRId64" ms average, %"PRId64" ms max, "
+             "%d frames queued",
+             p_sys->i_latency_sum / p_sys->i_latency_count / 1000,
+             p_sys->i_latency_max / 1000,
+             x264_encoder_delayed_frames( p_sys->h ) );
+    p_sys->i_latency_sum = 0;
+    p_sys->i_latency_max = 0;
+    p_sys->i_latency_count = 0;
+    p_sys->i_latency_report = now;
+}
+
 /****************************************************************************
  * Encode:
  ****************************************************************************/
@@ -1549,6 +1683,10 @@ static block_t *Encode( encoder_t *p_enc, picture_t *p_pict )
            pic.img.i_stride[i] = p_pict->p[i].i_pitch;
        }
 
+       p_sys->submitted[p_sys->i_submitted].pts = p_pict->date;
+       p_sys->submitted[p_sys->i_submitted].date = mdate();
+       p_sys->i_submitted = (p_sys->i_submitted + 1) % LATENCY_HISTORY;
+
        x264_encoder_encode( p_sys->h, &nal, &i_nal, &pic, &pic );
     } else {
        if( x264_encoder_delayed_frames( p_sys->h ) ) {
@@ -1601,6 +1739,7 @@ static block_t *Encode( encoder_t *p_enc, picture_t *p_pict )
     p_block->i_pts = pic.i_pts;
     p_block->i_dts = pic.i_dts;
 
+    UpdateLatency( p_enc, pic.i_pts );
     return p_block;
 }
 
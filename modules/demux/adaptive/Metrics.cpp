@@ -0,0 +1,352 @@
+/*
+ * Metrics.cpp
+ *****************************************************************************
+ * Copyright (C) 2017 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "Metrics.hpp"
+#include "playlist/BaseRepresentation.h"
+#include "playlist/Segment.h"
+#include "playlist/SegmentChunk.hpp"
+
+#include <vlc_demux.h>
+#include <vlc_input.h>
+#include <vlc_fs.h>
+
+#include <sstream>
+
+using namespace adaptive;
+using namespace adaptive::playlist;
+
+const mtime_t Histogram::bounds[Histogram::BUCKETS - 1] =
+{
+    CLOCK_FREQ / 100,
+    CLOCK_FREQ / 40,
+    CLOCK_FREQ / 20,
+    CLOCK_FREQ / 10,
+    CLOCK_FREQ / 4,
+    CLOCK_FREQ / 2,
+    CLOCK_FREQ,
+    CLOCK_FREQ * 5 / 2,
+    CLOCK_FREQ * 5,
+};
+
+Histogram::Histogram()
+{
+    for(size_t i=0; i<BUCKETS; i++)
+        buckets[i] = 0;
+    samples = 0;
+    sum = 0;
+    max = 0;
+}
+
+void Histogram::add(mtime_t value)
+{
+    size_t i = 0;
+    while(i < BUCKETS - 1 && value >= bounds[i])
+        i++;
+    buckets[i]++;
+    samples++;
+    sum += value;
+    if(value > max)
+        max = value;
+}
+
+uint64_t Histogram::count() const
+{
+    return samples;
+}
+
+mtime_t Histogram::average() const
+{
+    return (samples) ? sum / (mtime_t) samples : 0;
+}
+
+mtime_t Histogram::maximum() const
+{
+    return max;
+}
+
+std::string Histogram::str() const
+{
+    std::ostringstream ss;
+    ss.imbue(std::locale("C"));
+    for(size_t i=0; i<BUCKETS - 1; i++)
+        ss << "<" << bounds[i] / 1000 << "ms:" << buckets[i] << " ";
+    ss << ">=" << bounds[BUCKETS - 2] / 1000 << "ms:" << buckets[BUCKETS - 1];
+    return ss.str();
+}
+
+MetricsLog::MetricsLog(vlc_object_t *p_obj_)
+{
+    p_obj = p_obj_;
+    p_file = NULL;
+    start = mdate();
+    vlc_mutex_init(&lock);
+}
+
+MetricsLog::~MetricsLog()
+{
+    if(p_file)
+        fclose(p_file);
+    vlc_mutex_destroy(&lock);
+}
+
+bool MetricsLog::open(const char *psz_path)
+{
+    p_file = vlc_fopen(psz_path, "a");
+    if(!p_file)
+    {
+        msg_Warn(p_obj, "cannot open metrics log %s", psz_path);
+        return false;
+    }
+    return true;
+}
+
+void MetricsLog::write(const std::string &record)
+{
+    vlc_mutex_locker locker(&lock);
+    if(p_file)
+    {
+        fprintf(p_file, "%s\n", record.c_str());
+        fflush(p_file);
+    }
+}
+
+mtime_t MetricsLog::elapsed() const
+{
+    return mdate() - start;
+}
+
+static std::string jsonString(const std::string &str)
+{
+    std::string out("\"");
+    for(std::string::const_iterator it = str.begin(); it != str.end(); ++it)
+    {
+        const unsigned char c = *it;
+        if(c == '"' || c == '\\')
+            out += '\\';
+        if(c < 0x20)
+            out += ' ';
+        else
+            out += c;
+    }
+    out += '"';
+    return out;
+}
+
+StreamMetrics::StreamMetrics(demux_t *p_demux_, const ID &id_, MetricsLog *log_)
+{
+    p_demux = p_demux_;
+    id = id_;
+    log = log_;
+    category = std::string(_("Adaptive stream")) + " " + id.str();
+    created = mdate();
+    segments = 0;
+    failures = 0;
+    cached = 0;
+    bytes = 0;
+    downloadtime = 0;
+    rep = NULL;
+    segmentduration = 0;
+    buffercurrent = 0;
+    buffertarget = 0;
+    bufferlowest = -1;
+    switches = 0;
+}
+
+StreamMetrics::~StreamMetrics()
+{
+}
+
+void StreamMetrics::trackerEvent(const SegmentTrackerEvent &event)
+{
+    switch(event.type)
+    {
+        case SegmentTrackerEvent::SWITCHING:
+            switched(event.u.switching.prev, event.u.switching.next);
+            break;
+
+        case SegmentTrackerEvent::SEGMENT_CHANGE:
+            segmentduration = event.u.segment.duration;
+            break;
+
+        case SegmentTrackerEvent::BUFFERING_LEVEL_CHANGE:
+            buffercurrent = event.u.buffering_level.current;
+            buffertarget = event.u.buffering_level.target;
+            /* only once playback could start */
+            if(bufferlowest >= 0 || buffercurrent >= event.u.buffering_level.minimum)
+            {
+                if(bufferlowest < 0 || buffercurrent < bufferlowest)
+                    bufferlowest = buffercurrent;
+            }
+            break;
+
+        case SegmentTrackerEvent::SEGMENT_COMPLETED:
+            completed(event.u.completed.sc, event.u.completed.number);
+            break;
+
+        default:
+            break;
+    }
+}
+
+void StreamMetrics::switched(const BaseRepresentation *prev, const BaseRepresentation *next)
+{
+    rep = next;
+    if(!prev || !next || prev == next)
+        return;
+
+    Switch sw;
+    sw.time = mdate() - created;
+    sw.from = prev->getBandwidth();
+    sw.to = next->getBandwidth();
+    switches++;
+    switchhistory.push_back(sw);
+    if(switchhistory.size() > MAX_SWITCHES_HISTORY)
+        switchhistory.pop_front();
+
+    if(log)
+    {
+        std::ostringstream ss;
+        ss.imbue(std::locale("C"));
+        ss << "{\"event\":\"switch\",\"elapsed\":" << log->elapsed() / 1000
+           << ",\"stream\":" << jsonString(id.str())
+           << ",\"from\":" << jsonString(prev->getID().str())
+           << ",\"from_bandwidth\":" << sw.from
+           << ",\"to\":" << jsonString(next->getID().str())
+           << ",\"to_bandwidth\":" << sw.to
+           << ",\"buffer\":" << buffercurrent / 1000 << "}";
+        log->write(ss.str());
+    }
+
+    publish();
+}
+
+void StreamMetrics::completed(const SegmentChunk *chunk, uint64_t number)
+{
+    const TransferStats stats = chunk->getTransferStats();
+    const ISegment *segment = chunk->getSegment();
+    const bool b_media = segment->getClassId() != InitSegment::CLASSID_INITSEGMENT &&
+                         segment->getClassId() != IndexSegment::CLASSID_INDEXSEGMENT;
+    const bool b_failed = chunk->getBytesRead() == 0;
+    const bool b_cached = stats.requested == 0;
+    mtime_t first = 0, total = 0;
+
+    segments++;
+    if(b_failed)
+        failures++;
+    if(b_cached)
+        cached++;
+
+    if(!b_cached && stats.completed > stats.requested)
+    {
+        if(stats.firstbyte)
+            first = stats.firstbyte - stats.requested;
+        total = stats.completed - stats.requested;
+        ttfb.add(first);
+        latency.add(total);
+        bytes += stats.bytes;
+        downloadtime += total;
+    }
+
+    if(log)
+    {
+        const char *psz_type = "media";
+        if(segment->getClassId() == InitSegment::CLASSID_INITSEGMENT)
+            psz_type = "init";
+        else if(segment->getClassId() == IndexSegment::CLASSID_INDEXSEGMENT)
+            psz_type = "index";
+
+        std::ostringstream ss;
+        ss.imbue(std::locale("C"));
+        ss << "{\"event\":\"segment\",\"elapsed\":" << log->elapsed() / 1000
+           << ",\"stream\":" << jsonString(id.str());
+        if(chunk->getRepresentation())
+            ss << ",\"representation\":" << jsonString(chunk->getRepresentation()->getID().str())
+               << ",\"bandwidth\":" << chunk->getRepresentation()->getBandwidth();
+        ss << ",\"type\":\"" << psz_type << "\"";
+        if(b_media)
+            ss << ",\"number\":" << number
+               << ",\"duration\":" << segmentduration / 1000;
+        ss << ",\"bytes\":" << stats.bytes
+           << ",\"ttfb\":" << first / 1000
+           << ",\"download\":" << total / 1000;
+        if(total)
+            ss << ",\"throughput\":" << (uint64_t) stats.bytes * 8 * CLOCK_FREQ / total;
+        ss << ",\"buffer\":" << buffercurrent / 1000
+           << ",\"cached\":" << (b_cached ? "true" : "false")
+           << ",\"failed\":" << (b_failed ? "true" : "false") << "}";
+        log->write(ss.str());
+    }
+
+    publish();
+}
+
+void StreamMetrics::publish() const
+{
+    input_item_t *p_item = (p_demux->p_input) ? input_GetItem(p_demux->p_input) : NULL;
+    if(!p_item)
+        return;
+
+    const char *psz_cat = category.c_str();
+
+    if(rep)
+        input_item_AddInfo(p_item, psz_cat, _("Representation"), "%s (%" PRIu64 " kb/s)",
+                           rep->getID().str().c_str(), rep->getBandwidth() / 1000);
+    if(downloadtime)
+        input_item_AddInfo(p_item, psz_cat, _("Throughput"), "%" PRIu64 " kb/s",
+                           bytes * 8 * CLOCK_FREQ / downloadtime / 1000);
+    input_item_AddInfo(p_item, psz_cat, _("Segments"),
+                       "%" PRIu64 " (%" PRIu64 " failed, %" PRIu64 " cached)",
+                       segments, failures, cached);
+    input_item_AddInfo(p_item, psz_cat, _("Downloaded"), "%" PRIu64 " KiB", bytes / 1024);
+    if(ttfb.count())
+    {
+        input_item_AddInfo(p_item, psz_cat, _("Time to first byte"),
+                           "%" PRId64 " ms average, %" PRId64 " ms max",
+                           ttfb.average() / 1000, ttfb.maximum() / 1000);
+        input_item_AddInfo(p_item, psz_cat, _("Time to first byte distribution"),
+                           "%s", ttfb.str().c_str());
+        input_item_AddInfo(p_item, psz_cat, _("Download time"),
+                           "%" PRId64 " ms average, %" PRId64 " ms max",
+                           latency.average() / 1000, latency.maximum() / 1000);
+        input_item_AddInfo(p_item, psz_cat, _("Download time distribution"),
+                           "%s", latency.str().c_str());
+    }
+    input_item_AddInfo(p_item, psz_cat, _("Buffer level"),
+                       "%" PRId64 " ms (target %" PRId64 " ms, lowest %" PRId64 " ms)",
+                       buffercurrent / 1000, buffertarget / 1000,
+                       (bufferlowest > 0) ? bufferlowest / 1000 : 0);
+
+    std::ostringstream ss;
+    ss.imbue(std::locale("C"));
+    ss << switches;
+    std::list<Switch>::const_iterator it;
+    for(it = switchhistory.begin(); it != switchhistory.end(); ++it)
+    {
+        ss << ((it == switchhistory.begin()) ? " (" : ", ")
+           << (*it).time / CLOCK_FREQ << "s " << (*it).from / 1000
+           << "->" << (*it).to / 1000 << " kb/s";
+    }
+    if(!switchhistory.empty())
+        ss << ")";
+    input_item_AddInfo(p_item, psz_cat, _("Representation switches"), "%s", ss.str().c_str());
+}
@@ -0,0 +1,121 @@
+/*
+ * Metrics.hpp
+ *****************************************************************************
+ * Copyright (C) 2017 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include "SegmentTracker.hpp"
+#include "ID.hpp"
+
+#include <vlc_common.h>
+
+#include <cstdio>
+#include <list>
+#include <string>
+
+namespace adaptive
+{
+    /* Distribution of durations over fixed, roughly logarithmic buckets */
+    class Histogram
+    {
+        public:
+            Histogram();
+            void add(mtime_t);
+            uint64_t count() const;
+            mtime_t average() const;
+            mtime_t maximum() const;
+            std::string str() const;
+
+            static const size_t BUCKETS = 10;
+
+        private:
+            static const mtime_t bounds[BUCKETS - 1];
+            uint64_t buckets[BUCKETS];
+            uint64_t samples;
+            mtime_t sum;
+            mtime_t max;
+    };
+
+    /* Machine readable, one JSON object per line, records of
+     * segments and switches for all the streams of a session */
+    class MetricsLog
+    {
+        public:
+            MetricsLog(vlc_object_t *);
+            ~MetricsLog();
+            bool open(const char *);
+            void write(const std::string &);
+            mtime_t elapsed() const;
+
+        private:
+            vlc_object_t *p_obj;
+            FILE *p_file;
+            mtime_t start;
+            vlc_mutex_t lock;
+    };
+
+    /* Per stream counters, fed by the tracker events, and published
+     * as the input item info (or logged) on segment completion */
+    class StreamMetrics : public SegmentTrackerListenerInterface
+    {
+        public:
+            StreamMetrics(demux_t *, const ID &, MetricsLog *);
+            virtual ~StreamMetrics();
+            virtual void trackerEvent(const SegmentTrackerEvent &); /* impl */
+
+            static const size_t MAX_SWITCHES_HISTORY = 8;
+
+        private:
+            void completed(const SegmentChunk *, uint64_t);
+            void switched(const BaseRepresentation *, const BaseRepresentation *);
+            void publish() const;
+
+            demux_t *p_demux;
+            ID id;
+            MetricsLog *log;
+            std::string category;
+            mtime_t  created;
+
+            uint64_t segments;
+            uint64_t failures;
+            uint64_t cached;
+            uint64_t bytes;
+            mtime_t  downloadtime;
+            Histogram ttfb;
+            Histogram latency;
+
+            const BaseRepresentation *rep;
+            mtime_t  segmentduration;
+            mtime_t  buffercurrent;
+            mtime_t  buffertarget;
+            mtime_t  bufferlowest;
+
+            class Switch
+            {
+                public:
+                    mtime_t time;
+                    uint64_t from;
+                    uint64_t to;
+            };
+            uint64_t switches;
+            std::list<Switch> switchhistory;
+    };
+}
+
+#endif // METRICS_HPP
@@ -31,18 +31,25 @@
 #include "playlist/BaseRepresentation.h"
 #include "http/HTTPConnectionManager.h"
 #include "http/AuthStorage.hpp"
+#include "http/ChunkCache.hpp"
+#include "http/ConnectionParams.hpp"
 #include "logic/AlwaysBestAdaptationLogic.h"
 #include "logic/RateBasedAdaptationLogic.h"
 #include "logic/AlwaysLowestAdaptationLogic.hpp"
 #include "logic/PredictiveAdaptationLogic.hpp"
+#include "logic/BufferBasedAdaptationLogic.hpp"
 #include "logic/NearOptimalAdaptationLogic.hpp"
+#include "logic/SharedBandwidthEstimator.hpp"
+#include "Metrics.hpp"
 #include "tools/Debug.hpp"
 #include <vlc_stream.h>
 #include <vlc_demux.h>
 #include <vlc_threads.h>
 
 #include <algorithm>
+#include <cinttypes>
 #include <ctime>
+#include <sstream>
 
 using namespace adaptive::http;
 using namespace adaptive::logic;
@@ -54,11 +61,14 @@ PlaylistManager::PlaylistManager( demux_t *p_demux_,
                                   AbstractStreamFactory *factory,
                                   AbstractAdaptationLogic::LogicType type ) :
              conManager     ( NULL ),
+             chunkCache     ( NULL ),
              logicType      ( type ),
              logic          ( NULL ),
+             bwEstimator    ( NULL ),
              playlist       ( pl ),
              streamFactory  ( factory ),
-             p_demux        ( p_demux_ )
+             p_demux        ( p_demux_ ),
+             metricsLog     ( NULL )
 {
     currentPeriod = playlist->getFirstPeriod();
     authStorage = auth;
@@ -73,6 +83,18 @@ PlaylistManager::PlaylistManager( demux_t *p_demux_,
     vlc_mutex_init(&lock);
     vlc_cond_init(&waitcond);
     vlc_mutex_init(&cached.lock);
+    updater.b_enabled = false;
+    updater.b_thread = false;
+    updater.b_fetching = false;
+    updater.b_fetched = false;
+    updater.fetched = NULL;
+    updater.i_fetch_time = 0;
+    updater.i_count = 0;
+    updater.i_fetch_total = 0;
+    updater.i_fetch_max = 0;
+    updater.i_merge_max = 0;
+    vlc_mutex_init(&updater.lock);
+    vlc_cond_init(&updater.cond);
     cached.b_live = false;
     cached.i_length = 0;
     cached.f_position = 0.0;
@@ -85,13 +107,18 @@ PlaylistManager::~PlaylistManager   ()
     unsetPeriod();
     delete playlist;
     delete conManager;
+    delete chunkCache;
     delete logic;
+    delete bwEstimator;
+    delete metricsLog;
     delete authStorage;
     vlc_cond_destroy(&waitcond);
     vlc_mutex_destroy(&lock);
     vlc_mutex_destroy(&demux.lock);
     vlc_cond_destroy(&demux.cond);
     vlc_mutex_destroy(&cached.lock);
+    vlc_cond_destroy(&updater.cond);
+    vlc_mutex_destroy(&updater.lock);
 }
 
 void PlaylistManager::unsetPeriod()
@@ -100,6 +127,11 @@ void PlaylistManager::unsetPeriod()
     for(it=streams.begin(); it!=streams.end(); ++it)
         delete *it;
     streams.clear();
+
+    std::vector<StreamMetrics *>::iterator mit;
+    for(mit=metrics.begin(); mit!=metrics.end(); ++mit)
+        delete *mit;
+    metrics.clear();
 }
 
 bool PlaylistManager::setupPeriod()
@@ -107,8 +139,12 @@ bool PlaylistManager::setupPeriod()
     if(!currentPeriod)
         return false;
 
-    if(!logic && !(logic = createLogic(logicType, conManager)))
-        return false;
+    if(!logic)
+    {
+        if(!(logic = createLogic(logicType, conManager)))
+            return false;
+        logic->setBandwidthEstimator(bwEstimator);
+    }
 
     std::vector<BaseAdaptationSet*> sets = currentPeriod->getAdaptationSets();
     std::vector<BaseAdaptationSet*>::iterator it;
@@ -120,6 +156,9 @@ bool PlaylistManager::setupPeriod()
             SegmentTracker *tracker = new (std::nothrow) SegmentTracker(logic, set);
             if(!tracker)
                 continue;
+            tracker->setPrefetch(var_InheritInteger(p_demux, "adaptive-prefetch"),
+                                 CLOCK_FREQ * var_InheritInteger(p_demux, "adaptive-prefetch-duration"));
+            tracker->setRangeCoalescing(var_InheritBool(p_demux, "adaptive-range-coalescing"));
 
             AbstractStream *st = streamFactory->create(p_demux, set->getStreamFormat(),
                                                        tracker, conManager);
@@ -131,6 +170,14 @@ bool PlaylistManager::setupPeriod()
 
             streams.push_back(st);
 
+            StreamMetrics *stmetrics = new (std::nothrow) StreamMetrics(p_demux, set->getID(),
+                                                                       metricsLog);
+            if(stmetrics)
+            {
+                tracker->registerListener(stmetrics);
+                metrics.push_back(stmetrics);
+            }
+
             /* Generate stream description */
             std::list<std::string> languages;
             if(!set->getLang().empty())
@@ -160,6 +207,29 @@ bool PlaylistManager::start()
       )
         return false;
 
+    if(!chunkCache &&
+       (chunkCache = new (std::nothrow) ChunkCache()))
+        conManager->setChunkCache(chunkCache);
+
+    if(!bwEstimator)
+    {
+        ConnectionParams params(playlist->getUrlSegment().toString());
+        bwEstimator = new (std::nothrow) SharedBandwidthEstimator(VLC_OBJECT(p_demux),
+                                                                  params.getHostname());
+    }
+
+    char *psz_log = var_InheritString(p_demux, "adaptive-metrics-log");
+    if(psz_log && *psz_log)
+    {
+        if(!metricsLog && (metricsLog = new (std::nothrow) MetricsLog(VLC_OBJECT(p_demux))) &&
+           !metricsLog->open(psz_log))
+        {
+            delete metricsLog;
+            metricsLog = NULL;
+        }
+    }
+    free(psz_log);
+
     if(!setupPeriod())
         return false;
 
@@ -169,6 +239,10 @@ bool PlaylistManager::start()
     updateControlsContentType();
     updateControlsPosition();
 
+    if(updater.b_enabled && playlist->isLive())
+        updater.b_thread = !vlc_clone(&updater.thread, updaterThread,
+                                      static_cast<void *>(this), VLC_THREAD_PRIORITY_LOW);
+
     b_thread = !vlc_clone(&thread, managerThread,
                           static_cast<void *>(this), VLC_THREAD_PRIORITY_INPUT);
     if(!b_thread)
@@ -187,6 +261,22 @@ void PlaylistManager::stop()
         vlc_join(thread, NULL);
         b_thread = false;
     }
+
+    if(updater.b_thread)
+    {
+        vlc_cancel(updater.thread);
+        vlc_join(updater.thread, NULL);
+        updater.b_thread = false;
+        delete updater.fetched;
+        updater.fetched = NULL;
+        updater.b_fetched = updater.b_fetching = false;
+
+        if(updater.i_count)
+            msg_Dbg(p_demux, "%u playlist updates, fetch time avg %" PRId64 "ms "
+                    "max %" PRId64 "ms, merge time max %" PRId64 "ms",
+                    updater.i_count, updater.i_fetch_total / updater.i_count / 1000,
+                    updater.i_fetch_max / 1000, updater.i_merge_max / 1000);
+    }
 }
 
 struct PrioritizedAbstractStream
@@ -392,6 +482,17 @@ bool PlaylistManager::updatePlaylist()
     return true;
 }
 
+AbstractPlaylist * PlaylistManager::fetchPlaylist()
+{
+    return NULL;
+}
+
+bool PlaylistManager::mergePlaylist(AbstractPlaylist *newplaylist)
+{
+    playlist->mergeWith(newplaylist);
+    return true;
+}
+
 mtime_t PlaylistManager::getFirstPlaybackTime() const
 {
     return 0;
@@ -647,7 +748,13 @@ void PlaylistManager::Run()
         vlc_testcancel();
         vlc_cleanup_pop();
 
-        if(needsUpdate())
+        if(updater.b_thread)
+        {
+            int canc = vlc_savecancel();
+            runAsyncUpdate();
+            vlc_restorecancel(canc);
+        }
+        else if(needsUpdate())
         {
             int canc = vlc_savecancel();
             if(updatePlaylist())
@@ -691,6 +798,90 @@ void PlaylistManager::Run()
     vlc_mutex_unlock(&lock);
 }
 
+/* Merges the playlist fetched by the updater, or requests a new one. The
+ * merge only holds the updater lock for the handover, and happens between
+ * two buffering passes as the synchronous updates do. */
+void PlaylistManager::runAsyncUpdate()
+{
+    vlc_mutex_lock(&updater.lock);
+    if(!updater.b_fetched)
+    {
+        if(!updater.b_fetching && needsUpdate())
+        {
+            updater.b_fetching = true;
+            vlc_cond_signal(&updater.cond);
+        }
+        vlc_mutex_unlock(&updater.lock);
+        return;
+    }
+
+    AbstractPlaylist *newplaylist = updater.fetched;
+    const mtime_t i_fetch_time = updater.i_fetch_time;
+    updater.fetched = NULL;
+    updater.b_fetched = false;
+    vlc_mutex_unlock(&updater.lock);
+
+    mtime_t i_merge_time = mdate();
+    bool b_merged = newplaylist && mergePlaylist(newplaylist);
+    i_merge_time = mdate() - i_merge_time;
+    delete newplaylist;
+
+    if(!b_merged)
+    {
+        failedupdates++;
+        return;
+    }
+
+    updater.i_count++;
+    updater.i_fetch_total += i_fetch_time;
+    updater.i_fetch_max = std::max(updater.i_fetch_max, i_fetch_time);
+    updater.i_merge_max = std::max(updater.i_merge_max, i_merge_time);
+    scheduleNextUpdate();
+    updateControlsContentType();
+    updateControlsPosition();
+
+    if(metricsLog)
+    {
+        std::stringstream ss;
+        ss << "{\"event\":\"update\",\"elapsed\":" << metricsLog->elapsed() / 1000
+           << ",\"fetch\":" << i_fetch_time / 1000
+           << ",\"merge\":" << i_merge_time / 1000 << "}";
+        metricsLog->write(ss.str());
+    }
+}
+
+void PlaylistManager::RunUpdater()
+{
+    vlc_mutex_lock(&updater.lock);
+    while(1)
+    {
+        mutex_cleanup_push(&updater.lock);
+        while(!updater.b_fetching)
+            vlc_cond_wait(&updater.cond, &updater.lock);
+        vlc_cleanup_pop();
+        vlc_mutex_unlock(&updater.lock);
+
+        int canc = vlc_savecancel();
+        mtime_t i_fetch_time = mdate();
+        AbstractPlaylist *newplaylist = fetchPlaylist();
+        i_fetch_time = mdate() - i_fetch_time;
+        vlc_restorecancel(canc);
+
+        vlc_mutex_lock(&updater.lock);
+        updater.fetched = newplaylist;
+        updater.i_fetch_time = i_fetch_time;
+        updater.b_fetched = true;
+        updater.b_fetching = false;
+    }
+    vlc_mutex_unlock(&updater.lock);
+}
+
+void * PlaylistManager::updaterThread(void *opaque)
+{
+    static_cast<PlaylistManager *>(opaque)->RunUpdater();
+    return NULL;
+}
+
 void * PlaylistManager::managerThread(void *opaque)
 {
     static_cast<PlaylistManager *>(opaque)->Run();
@@ -775,6 +966,16 @@ AbstractAdaptationLogic *PlaylistManager::createLogic(AbstractAdaptationLogic::L
             if(predictivelogic)
                 conn->setDownloadRateObserver(predictivelogic);
             logic = predictivelogic;
+            break;
+        }
+        case AbstractAdaptationLogic::BufferBased:
+        {
+            BufferBasedAdaptationLogic *bufferlogic =
+                    new (std::nothrow) BufferBasedAdaptationLogic(VLC_OBJECT(p_demux));
+            if(bufferlogic)
+                conn->setDownloadRateObserver(bufferlogic);
+            logic = bufferlogic;
+            break;
         }
 
         default:
@@ -38,8 +38,17 @@ namespace adaptive
     {
         class AbstractConnectionManager;
         class AuthStorage;
+        class ChunkCache;
     }
 
+    namespace logic
+    {
+        class SharedBandwidthEstimator;
+    }
+
+    class MetricsLog;
+    class StreamMetrics;
+
     using namespace playlist;
     using namespace logic;
     using namespace http;
@@ -65,6 +74,11 @@ namespace adaptive
             virtual bool updatePlaylist();
             virtual void scheduleNextUpdate();
 
+            /* Asynchronous updates: the playlist is downloaded and parsed
+             * by the updater thread, then merged by the buffering thread */
+            virtual AbstractPlaylist * fetchPlaylist();
+            virtual bool mergePlaylist(AbstractPlaylist *);
+
             /* static callbacks */
             static int control_callback(demux_t *, int, va_list);
             static int demux_callback(demux_t *);
@@ -96,12 +110,16 @@ namespace adaptive
 
             AuthStorage                         *authStorage;
             AbstractConnectionManager           *conManager;
+            ChunkCache                          *chunkCache;
             AbstractAdaptationLogic::LogicType  logicType;
             AbstractAdaptationLogic             *logic;
+            SharedBandwidthEstimator            *bwEstimator;
             AbstractPlaylist                    *playlist;
             AbstractStreamFactory               *streamFactory;
             demux_t                             *p_demux;
             std::vector<AbstractStream *>        streams;
+            std::vector<StreamMetrics *>         metrics;
+            MetricsLog                          *metricsLog;
             BasePeriod                          *currentPeriod;
 
             /* shared with demux/buffering */
@@ -117,6 +135,25 @@ namespace adaptive
             time_t                               nextPlaylistupdate;
             int                                  failedupdates;
 
+            /* shared with the updater, enabled by the managers that
+             * implement fetchPlaylist() */
+            struct
+            {
+                bool              b_enabled;
+                bool              b_thread;
+                bool              b_fetching;
+                bool              b_fetched;
+                AbstractPlaylist *fetched;
+                mtime_t           i_fetch_time;
+                unsigned          i_count;
+                mtime_t           i_fetch_total;
+                mtime_t           i_fetch_max;
+                mtime_t           i_merge_max;
+                vlc_thread_t      thread;
+                vlc_mutex_t       lock;
+                vlc_cond_t        cond;
+            } updater;
+
             /* Controls */
             struct
             {
@@ -131,6 +168,9 @@ namespace adaptive
             void setBufferingRunState(bool);
             void Run();
             static void * managerThread(void *);
+            void runAsyncUpdate();
+            void RunUpdater();
+            static void * updaterThread(void *);
             vlc_mutex_t  lock;
             vlc_thread_t thread;
             bool         b_thread;
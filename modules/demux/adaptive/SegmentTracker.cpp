@@ -29,11 +29,18 @@
 #include "playlist/Segment.h"
 #include "playlist/SegmentChunk.hpp"
 #include "logic/AbstractAdaptationLogic.h"
+#include "http/HTTPConnectionManager.h"
+
+#include <algorithm>
 
 using namespace adaptive;
 using namespace adaptive::logic;
 using namespace adaptive::playlist;
 
+#define COALESCING_MIN_DURATION  (CLOCK_FREQ)
+#define COALESCING_MAX_DURATION  (CLOCK_FREQ * 8)
+#define COALESCING_MAX_SIZE      ((uint64_t) 16 * 1024 * 1024)
+
 SegmentTrackerEvent::SegmentTrackerEvent(SegmentChunk *s)
 {
     type = DISCONTINUITY;
@@ -76,6 +83,14 @@ SegmentTrackerEvent::SegmentTrackerEvent(const ID &id, mtime_t duration)
     u.segment.id = &id;
 }
 
+SegmentTrackerEvent::SegmentTrackerEvent(const ID &id, const SegmentChunk *sc, uint64_t number)
+{
+    type = SEGMENT_COMPLETED;
+    u.completed.sc = sc;
+    u.completed.number = number;
+    u.completed.id = &id;
+}
+
 SegmentTracker::SegmentTracker(AbstractAdaptationLogic *logic_, BaseAdaptationSet *adaptSet)
 {
     first = true;
@@ -87,6 +102,11 @@ SegmentTracker::SegmentTracker(AbstractAdaptationLogic *logic_, BaseAdaptationSe
     setAdaptationLogic(logic_);
     adaptationSet = adaptSet;
     format = StreamFormat::UNSUPPORTED;
+    prefetchMaxCount = 0;
+    coalescing = false;
+    measuredBps = 0;
+    measuredRtt = 0;
+    prefetchMaxDuration = 0;
 }
 
 SegmentTracker::~SegmentTracker()
@@ -127,6 +147,7 @@ bool SegmentTracker::segmentsListReady() const
 
 void SegmentTracker::reset()
 {
+    flushPrefetch();
     notify(SegmentTrackerEvent(curRepresentation, NULL));
     curRepresentation = NULL;
     init_sent = false;
@@ -165,6 +186,7 @@ SegmentChunk * SegmentTracker::getNextChunk(bool switch_allowed,
 
     if(rep != curRepresentation)
     {
+        flushPrefetch(); /* Lookahead was fetched from the previous representation */
         notify(SegmentTrackerEvent(curRepresentation, rep));
         prevRep = curRepresentation;
         curRepresentation = rep;
@@ -192,7 +214,10 @@ SegmentChunk * SegmentTracker::getNextChunk(bool switch_allowed,
     if(b_updated)
     {
         if(!rep->consistentSegmentNumber())
+        {
+            flushPrefetch();
             curRepresentation->pruneBySegmentNumber(curNumber);
+        }
         curRepresentation->scheduleNextUpdate(next);
     }
 
@@ -246,7 +271,13 @@ SegmentChunk * SegmentTracker::getNextChunk(bool switch_allowed,
         initializing = false;
     }
 
-    SegmentChunk *chunk = segment->toChunk(next, rep, connManager);
+    SegmentChunk *chunk = getPrefetchedChunk(segment, next, rep);
+    if(!chunk)
+    {
+        std::list<PrefetchedChunk> coalesced;
+        chunk = createChunk(segment, next, rep, connManager, coalesced);
+        prefetched.splice(prefetched.end(), coalesced);
+    }
 
     /* Notify new segment length for stats / logic */
     if(chunk)
@@ -273,11 +304,214 @@ SegmentChunk * SegmentTracker::getNextChunk(bool switch_allowed,
     {
         curNumber = next;
         next++;
+        prefetch(rep, connManager);
+    }
+
+    return chunk;
+}
+
+SegmentChunk * SegmentTracker::getPrefetchedChunk(const ISegment *segment, uint64_t number,
+                                                  const BaseRepresentation *rep)
+{
+    if(prefetched.empty())
+        return NULL;
+
+    const PrefetchedChunk &front = prefetched.front();
+    if(front.segment != segment || front.number != number || front.rep != rep)
+    {
+        /* Not the one we expected (seek, gap, playlist update) */
+        flushPrefetch();
+        return NULL;
     }
 
+    SegmentChunk *chunk = front.chunk;
+    prefetched.pop_front();
     return chunk;
 }
 
+void SegmentTracker::prefetch(BaseRepresentation *rep, AbstractConnectionManager *connManager)
+{
+    if(!prefetchMaxCount)
+        return;
+
+    const Timescale timescale = rep->inheritTimescale();
+    uint64_t number = next;
+    mtime_t duration = 0;
+    std::list<PrefetchedChunk>::const_iterator it;
+    for(it = prefetched.begin(); it != prefetched.end(); ++it)
+    {
+        duration += (*it).duration;
+        number = (*it).number + 1;
+    }
+
+    while(prefetched.size() < prefetchMaxCount &&
+          (!prefetchMaxDuration || duration < prefetchMaxDuration))
+    {
+        bool b_gap = false;
+        uint64_t segnumber;
+        ISegment *segment = rep->getNextSegment(BaseRepresentation::INFOTYPE_MEDIA,
+                                                number, &segnumber, &b_gap);
+        /* Gaps need discontinuity handling from getNextChunk() */
+        if(!segment || b_gap)
+            break;
+
+        std::list<PrefetchedChunk> coalesced;
+        SegmentChunk *chunk = createChunk(segment, segnumber, rep, connManager, coalesced);
+        if(!chunk)
+            break;
+
+        PrefetchedChunk entry;
+        entry.chunk = chunk;
+        entry.segment = segment;
+        entry.rep = rep;
+        entry.number = segnumber;
+        entry.duration = timescale.ToTime(segment->duration.Get());
+        prefetched.push_back(entry);
+
+        duration += entry.duration;
+        number = segnumber + 1;
+
+        for(it = coalesced.begin(); it != coalesced.end(); ++it)
+        {
+            duration += (*it).duration;
+            number = (*it).number + 1;
+        }
+        prefetched.splice(prefetched.end(), coalesced);
+    }
+}
+
+size_t SegmentTracker::getCoalescingSize() const
+{
+    if(!measuredBps)
+        return 0;
+    /* Fetch enough for the request round trip to remain a small
+       part of the transfer time */
+    mtime_t duration = std::max(COALESCING_MIN_DURATION, measuredRtt * 8);
+    duration = std::min(duration, COALESCING_MAX_DURATION);
+    return std::min(COALESCING_MAX_SIZE, measuredBps / 8 * duration / CLOCK_FREQ);
+}
+
+SegmentChunk * SegmentTracker::createChunk(ISegment *segment, uint64_t number,
+                                           BaseRepresentation *rep,
+                                           AbstractConnectionManager *connManager,
+                                           std::list<PrefetchedChunk> &coalesced)
+{
+    const size_t maxsize = (coalescing) ? getCoalescingSize() : 0;
+    if(segment->getClassId() != SubSegment::CLASSID_SUBSEGMENT ||
+       segment->getEndOffset() <= segment->getOffset() ||
+       segment->getEndOffset() - segment->getOffset() >= maxsize)
+        return segment->toChunk(number, rep, connManager);
+
+    /* Can only slice the same clear data */
+    AbstractChunkFilter *filter = segment->createChunkFilter();
+    if(filter)
+    {
+        delete filter;
+        return segment->toChunk(number, rep, connManager);
+    }
+
+    const std::string url = segment->getUrlSegment().toString(number, rep);
+    std::vector<ISegment *> segments;
+    segments.push_back(segment);
+    size_t end = segment->getEndOffset();
+    uint64_t last = number;
+    while(end + 1 - segment->getOffset() < maxsize)
+    {
+        bool b_gap = false;
+        uint64_t segnumber;
+        ISegment *nextsegment = rep->getNextSegment(BaseRepresentation::INFOTYPE_MEDIA,
+                                                    last + 1, &segnumber, &b_gap);
+        if(!nextsegment || b_gap || segnumber != last + 1 ||
+           nextsegment->getClassId() != SubSegment::CLASSID_SUBSEGMENT ||
+           nextsegment->getOffset() != end + 1 ||
+           nextsegment->getEndOffset() <= nextsegment->getOffset() ||
+           nextsegment->getEndOffset() + 1 - segment->getOffset() > maxsize ||
+           nextsegment->getUrlSegment().toString(segnumber, rep) != url)
+            break;
+        segments.push_back(nextsegment);
+        end = nextsegment->getEndOffset();
+        last = segnumber;
+    }
+
+    if(segments.size() == 1)
+        return segment->toChunk(number, rep, connManager);
+
+    HTTPChunkBufferedSource *source =
+            new (std::nothrow) HTTPChunkBufferedSource(url, connManager,
+                                                       rep->getAdaptationSet()->getID());
+    if(!source)
+        return NULL;
+    source->setBytesRange(BytesRange(segment->getOffset(), end));
+
+    SharedChunkSource *shared = new (std::nothrow) SharedChunkSource(source);
+    if(!shared)
+    {
+        delete source;
+        return NULL;
+    }
+
+    const Timescale timescale = rep->inheritTimescale();
+    SegmentChunk *first = NULL;
+    shared->hold();
+    for(size_t i=0; i<segments.size(); i++)
+    {
+        ISegment *seg = segments[i];
+        ChunkSliceSource *slice = new (std::nothrow)
+                ChunkSliceSource(shared, seg->getOffset() - segment->getOffset(),
+                                 seg->getEndOffset() + 1 - seg->getOffset(),
+                                 i + 1 == segments.size());
+        if(!slice)
+            break;
+        slice->setBytesRange(BytesRange(seg->getOffset(), seg->getEndOffset()));
+        SegmentChunk *chunk = new (std::nothrow) SegmentChunk(seg, slice, rep);
+        if(!chunk)
+        {
+            delete slice;
+            break;
+        }
+
+        if(!first)
+        {
+            first = chunk;
+            continue;
+        }
+
+        PrefetchedChunk entry;
+        entry.chunk = chunk;
+        entry.segment = seg;
+        entry.rep = rep;
+        entry.number = number + i;
+        entry.duration = timescale.ToTime(seg->duration.Get());
+        coalesced.push_back(entry);
+    }
+
+    if(first)
+        connManager->start(source);
+    shared->release();
+
+    return first;
+}
+
+void SegmentTracker::flushPrefetch()
+{
+    /* Deleting the chunk cancels the pending download */
+    std::list<PrefetchedChunk>::const_iterator it;
+    for(it = prefetched.begin(); it != prefetched.end(); ++it)
+        delete (*it).chunk;
+    prefetched.clear();
+}
+
+void SegmentTracker::setPrefetch(unsigned count, mtime_t duration)
+{
+    prefetchMaxCount = count;
+    prefetchMaxDuration = duration;
+}
+
+void SegmentTracker::setRangeCoalescing(bool b)
+{
+    coalescing = b;
+}
+
 bool SegmentTracker::setPositionByTime(mtime_t time, bool restarted, bool tryonly)
 {
     uint64_t segnumber;
@@ -297,6 +531,7 @@ bool SegmentTracker::setPositionByTime(mtime_t time, bool restarted, bool tryonl
 
 void SegmentTracker::setPositionByNumber(uint64_t segnumber, bool restarted)
 {
+    flushPrefetch();
     if(restarted)
     {
         initializing = true;
@@ -342,6 +577,22 @@ void SegmentTracker::notifyBufferingLevel(mtime_t min, mtime_t current, mtime_t
     notify(SegmentTrackerEvent(adaptationSet->getID(), min, current, target));
 }
 
+void SegmentTracker::notifyChunkCompleted(const SegmentChunk *chunk)
+{
+    /* Keep our own transfer estimates for sizing coalesced requests */
+    const TransferStats stats = chunk->getTransferStats();
+    if(stats.requested && stats.firstbyte && stats.completed > stats.requested)
+    {
+        const uint64_t bps = (uint64_t) stats.bytes * 8 * CLOCK_FREQ /
+                             (stats.completed - stats.requested);
+        const mtime_t rtt = stats.firstbyte - stats.requested;
+        measuredBps = (measuredBps) ? (measuredBps * 3 + bps) / 4 : bps;
+        measuredRtt = (measuredRtt) ? (measuredRtt * 3 + rtt) / 4 : rtt;
+    }
+
+    notify(SegmentTrackerEvent(adaptationSet->getID(), chunk, curNumber));
+}
+
 void SegmentTracker::registerListener(SegmentTrackerListenerInterface *listener)
 {
     listeners.push_back(listener);
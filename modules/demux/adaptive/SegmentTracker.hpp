@@ -44,6 +44,7 @@ namespace adaptive
         class BaseAdaptationSet;
         class BaseRepresentation;
         class SegmentChunk;
+        class ISegment;
     }
 
     using namespace playlist;
@@ -59,6 +60,7 @@ namespace adaptive
             SegmentTrackerEvent(const ID &, bool);
             SegmentTrackerEvent(const ID &, mtime_t, mtime_t, mtime_t);
             SegmentTrackerEvent(const ID &, mtime_t);
+            SegmentTrackerEvent(const ID &, const SegmentChunk *, uint64_t);
             enum
             {
                 DISCONTINUITY,
@@ -67,6 +69,7 @@ namespace adaptive
                 BUFFERING_STATE,
                 BUFFERING_LEVEL_CHANGE,
                 SEGMENT_CHANGE,
+                SEGMENT_COMPLETED,
             } type;
             union
             {
@@ -100,6 +103,12 @@ namespace adaptive
                     const ID *id;
                    mtime_t duration;
                } segment;
+               struct
+               {
+                   const ID *id;
+                   const SegmentChunk *sc;
+                   uint64_t number;
+               } completed;
             } u;
     };
 
@@ -125,12 +134,37 @@ namespace adaptive
             mtime_t getMinAheadTime() const;
             void notifyBufferingState(bool) const;
             void notifyBufferingLevel(mtime_t, mtime_t, mtime_t) const;
+            void notifyChunkCompleted(const SegmentChunk *);
             void registerListener(SegmentTrackerListenerInterface *);
             void updateSelected();
+            void setPrefetch(unsigned, mtime_t);
+            void setRangeCoalescing(bool);
 
         private:
             void setAdaptationLogic(AbstractAdaptationLogic *);
             void notify(const SegmentTrackerEvent &) const;
+            SegmentChunk * getPrefetchedChunk(const ISegment *, uint64_t,
+                                              const BaseRepresentation *);
+            void prefetch(BaseRepresentation *, AbstractConnectionManager *);
+            void flushPrefetch();
+            class PrefetchedChunk
+            {
+                public:
+                    SegmentChunk *chunk;
+                    const ISegment *segment;
+                    const BaseRepresentation *rep;
+                    uint64_t number;
+                    mtime_t duration;
+            };
+            SegmentChunk * createChunk(ISegment *, uint64_t, BaseRepresentation *,
+                                       AbstractConnectionManager *, std::list<PrefetchedChunk> &);
+            size_t getCoalescingSize() const;
+            std::list<PrefetchedChunk> prefetched;
+            unsigned prefetchMaxCount;
+            mtime_t prefetchMaxDuration;
+            bool coalescing;
+            uint64_t measuredBps;
+            mtime_t measuredRtt;
             bool first;
             bool initializing;
             bool index_sent;
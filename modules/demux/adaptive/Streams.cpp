@@ -375,6 +375,15 @@ AbstractStream::buffering_status AbstractStream::doBufferize(mtime_t nz_deadline
         vlc_mutex_lock(&lock);
         if(i_ret != VLC_DEMUXER_SUCCESS)
         {
+            if(!discontinuity && needrestart &&
+               demuxer->isPersistent() && demuxer->resume())
+            {
+                msg_Dbg(p_realdemux, "Resuming demuxer");
+                commandsqueue->Commit();
+                needrestart = false;
+                vlc_mutex_unlock(&lock);
+                return AbstractStream::buffering_ongoing;
+            }
             if(discontinuity || needrestart)
             {
                 msg_Dbg(p_realdemux, "Restarting demuxer");
@@ -472,6 +481,7 @@ block_t * AbstractStream::readNextBlock()
     block_t *block = currentChunk->readBlock();
     if(block == NULL)
     {
+        segmentTracker->notifyChunkCompleted(currentChunk);
         delete currentChunk;
         currentChunk = NULL;
         return NULL;
@@ -479,6 +489,7 @@ block_t * AbstractStream::readNextBlock()
 
     if (currentChunk->isEmpty())
     {
+        segmentTracker->notifyChunkCompleted(currentChunk);
         delete currentChunk;
         currentChunk = NULL;
     }
@@ -76,10 +76,44 @@ static void Close   (vlc_object_t *);
 #define ADAPT_ACCESS_TEXT N_("Use regular HTTP modules")
 #define ADAPT_ACCESS_LONGTEXT N_("Connect using http access instead of custom http code")
 
+#define ADAPT_DOWNLOADERS_TEXT N_("Parallel downloads")
+#define ADAPT_DOWNLOADERS_LONGTEXT N_("Maximum number of segments downloaded at the same time, " \
+                                      "each stream using its own connection")
+
+#define ADAPT_PREFETCH_TEXT N_("Segments prefetch")
+#define ADAPT_PREFETCH_LONGTEXT N_("Number of upcoming segments requested ahead of playback, " \
+                                   "hiding request latency between segments")
+#define ADAPT_PREFETCH_DURATION_TEXT N_("Maximum prefetch duration (seconds)")
+#define ADAPT_PREFETCH_DURATION_LONGTEXT N_("Stop prefetching once upcoming segments " \
+                                            "cover that duration (0 for no limit)")
+
+#define ADAPT_HTTP2_TEXT N_("Use HTTP/2 when available")
+#define ADAPT_HTTP2_LONGTEXT N_("Send HTTPS requests through the http access stack, " \
+                                "which shares a single HTTP/2 session per server")
+
+#define ADAPT_LOWLATENCY_TEXT N_("Low latency delivery")
+#define ADAPT_LOWLATENCY_LONGTEXT N_("Hand over fragmented MP4 data to the demuxer " \
+                                     "box by box, as soon as it is received, and honor " \
+                                     "live availability time offsets")
+
+#define ADAPT_BW_PERSIST_TEXT N_("Remember bandwidth estimates")
+#define ADAPT_BW_PERSIST_LONGTEXT N_("Save the bandwidth measured for each server to disk, " \
+                                     "so that playback starts at a matching quality")
+
+#define ADAPT_COALESCING_TEXT N_("Coalesce byte range requests")
+#define ADAPT_COALESCING_LONGTEXT N_("Fetch consecutive subsegments of indexed on-demand " \
+                                     "streams with a single request, sized from the " \
+                                     "measured throughput and latency")
+
+#define ADAPT_METRICS_LOG_TEXT N_("Streaming metrics log")
+#define ADAPT_METRICS_LOG_LONGTEXT N_("Append a JSON record for each downloaded segment " \
+                                      "and each representation switch to this file")
+
 static const AbstractAdaptationLogic::LogicType pi_logics[] = {
                                 AbstractAdaptationLogic::Default,
                                 AbstractAdaptationLogic::Predictive,
                                 AbstractAdaptationLogic::NearOptimal,
+                                AbstractAdaptationLogic::BufferBased,
                                 AbstractAdaptationLogic::RateBased,
                                 AbstractAdaptationLogic::FixedRate,
                                 AbstractAdaptationLogic::AlwaysLowest,
@@ -89,6 +123,7 @@ static const char *const ppsz_logics_values[] = {
                                 "",
                                 "predictive",
                                 "nearoptimal",
+                                "buffer",
                                 "rate",
                                 "fixedrate",
                                 "lowest",
@@ -97,6 +132,7 @@ static const char *const ppsz_logics_values[] = {
 static const char *const ppsz_logics[] = { N_("Default"),
                                            N_("Predictive"),
                                            N_("Near Optimal"),
+                                           N_("Buffer Based"),
                                            N_("Bandwidth Adaptive"),
                                            N_("Fixed Bandwidth"),
                                            N_("Lowest Bandwidth/Quality"),
@@ -121,7 +157,19 @@ vlc_module_begin ()
         add_integer( "adaptive-maxheight", 0,
                      ADAPT_HEIGHT_TEXT, ADAPT_HEIGHT_TEXT, false )
         add_integer( "adaptive-bw",     250, ADAPT_BW_TEXT,     ADAPT_BW_LONGTEXT,     false )
+        add_bool   ( "adaptive-bw-persist", false, ADAPT_BW_PERSIST_TEXT, ADAPT_BW_PERSIST_LONGTEXT, true )
         add_bool   ( "adaptive-use-access", false, ADAPT_ACCESS_TEXT, ADAPT_ACCESS_LONGTEXT, true );
+        add_bool   ( "adaptive-http2", true, ADAPT_HTTP2_TEXT, ADAPT_HTTP2_LONGTEXT, true )
+        add_integer_with_range( "adaptive-downloaders", 2, 1, 8,
+                     ADAPT_DOWNLOADERS_TEXT, ADAPT_DOWNLOADERS_LONGTEXT, true )
+        add_integer_with_range( "adaptive-prefetch", 1, 0, 8,
+                     ADAPT_PREFETCH_TEXT, ADAPT_PREFETCH_LONGTEXT, true )
+        add_integer( "adaptive-prefetch-duration", 12,
+                     ADAPT_PREFETCH_DURATION_TEXT, ADAPT_PREFETCH_DURATION_LONGTEXT, true )
+        add_bool   ( "adaptive-lowlatency", false, ADAPT_LOWLATENCY_TEXT, ADAPT_LOWLATENCY_LONGTEXT, true )
+        add_bool   ( "adaptive-range-coalescing", false, ADAPT_COALESCING_TEXT, ADAPT_COALESCING_LONGTEXT, true )
+        add_savefile( "adaptive-metrics-log", NULL,
+                      ADAPT_METRICS_LOG_TEXT, ADAPT_METRICS_LOG_LONGTEXT, true )
         set_callbacks( Open, Close )
 vlc_module_end ()
 
@@ -29,6 +29,7 @@
 #include "HTTPConnection.hpp"
 #include "HTTPConnectionManager.h"
 #include "Downloader.hpp"
+#include "ChunkCache.hpp"
 
 #include <vlc_common.h>
 #include <vlc_block.h>
@@ -37,6 +38,14 @@
 
 using namespace adaptive::http;
 
+TransferStats::TransferStats()
+{
+    requested = 0;
+    firstbyte = 0;
+    completed = 0;
+    bytes = 0;
+}
+
 AbstractChunkSource::AbstractChunkSource()
 {
     contentLength = 0;
@@ -59,6 +68,11 @@ const BytesRange & AbstractChunkSource::getBytesRange() const
     return bytesRange;
 }
 
+TransferStats AbstractChunkSource::getTransferStats() const
+{
+    return transfer;
+}
+
 AbstractChunk::AbstractChunk(AbstractChunkSource *source_)
 {
     bytesRead = 0;
@@ -106,6 +120,13 @@ bool AbstractChunk::isEmpty() const
     return !source->hasMoreData();
 }
 
+TransferStats AbstractChunk::getTransferStats() const
+{
+    if(!source)
+        return TransferStats();
+    return source->getTransferStats();
+}
+
 block_t * AbstractChunk::readBlock()
 {
     return doRead(0, true);
@@ -133,12 +154,12 @@ HTTPChunkSource::HTTPChunkSource(const std::string& url, AbstractConnectionManag
 HTTPChunkSource::~HTTPChunkSource()
 {
     if(connection)
-        connection->setUsed(false);
+        connManager->recycleConnection(connection);
 }
 
 bool HTTPChunkSource::init(const std::string &url)
 {
-    params = ConnectionParams(url);
+    params = connManager->getParams(url);
 
     if(params.getScheme() != "http" && params.getScheme() != "https")
         return false;
@@ -195,11 +216,15 @@ block_t * HTTPChunkSource::read(size_t readsize)
     {
         p_block->i_buffer = (size_t) ret;
         consumed += p_block->i_buffer;
+        transfer.bytes = consumed;
         if((size_t)ret < readsize)
             eof = true;
         connManager->updateDownloadRate(sourceid, p_block->i_buffer, time);
     }
 
+    if(eof)
+        transfer.completed = mdate();
+
     return p_block;
 }
 
@@ -211,6 +236,9 @@ bool HTTPChunkSource::prepare(int i_redir)
     if(!connManager)
         return false;
 
+    if(!transfer.requested)
+        transfer.requested = mdate();
+
     if(!connection)
     {
         connection = connManager->getConnection(params);
@@ -229,6 +257,7 @@ bool HTTPChunkSource::prepare(int i_redir)
            from content length */
     contentLength = connection->getContentLength();
     prepared = true;
+    transfer.firstbyte = mdate();
 
     return true;
 }
@@ -250,7 +279,14 @@ HTTPChunkBufferedSource::HTTPChunkBufferedSource(const std::string& url, Abstrac
     done = false;
     eof = false;
     held = false;
+    boxaligned = false;
+    boxremaining = 0;
     downloadstart = 0;
+    cache = NULL;
+    p_cachehead = NULL;
+    pp_cachetail = &p_cachehead;
+    filter = NULL;
+    p_filterpending = NULL;
 }
 
 HTTPChunkBufferedSource::~HTTPChunkBufferedSource()
@@ -270,12 +306,23 @@ HTTPChunkBufferedSource::~HTTPChunkBufferedSource()
         pp_tail = &p_head;
     }
     buffered = 0;
+    if(p_cachehead)
+        block_ChainRelease(p_cachehead);
+    if(p_filterpending)
+        block_Release(p_filterpending);
+    delete filter;
     vlc_mutex_unlock(&lock);
 
     vlc_cond_destroy(&avail);
     vlc_mutex_destroy(&lock);
 }
 
+TransferStats HTTPChunkBufferedSource::getTransferStats() const
+{
+    vlc_mutex_locker locker( &lock );
+    return transfer;
+}
+
 bool HTTPChunkBufferedSource::isDone() const
 {
     vlc_mutex_locker locker( &lock );
@@ -302,12 +349,15 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
     {
         done = true;
         eof = true;
+        transfer.completed = mdate();
         vlc_cond_signal(&avail);
         vlc_mutex_unlock(&lock);
         return;
     }
 
-    if(readsize < HTTPChunkSource::CHUNK_SIZE)
+    if(boxaligned)
+        readsize = boxAlignedReadSize(readsize);
+    else if(readsize < HTTPChunkSource::CHUNK_SIZE)
         readsize = HTTPChunkSource::CHUNK_SIZE;
 
     if(contentLength && readsize > contentLength - buffered)
@@ -332,25 +382,36 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
     if(ret <= 0)
     {
         block_Release(p_block);
-        p_block = NULL;
+        p_block = (filter) ? filterBlock(NULL, true) : NULL;
         vlc_mutex_locker locker( &lock );
+        if(p_block)
+            enqueue(p_block);
         done = true;
         rate.size = buffered + consumed;
         rate.time = mdate() - downloadstart;
         downloadstart = 0;
+        transfer.completed = mdate();
+        transfer.bytes = rate.size;
+        cacheStore();
     }
     else
     {
         p_block->i_buffer = (size_t) ret;
+        const bool b_last = ((size_t) ret < readsize);
+        if(filter) /* outside of lock, as the reader could wait for its output */
+            p_block = filterBlock(p_block, b_last);
         vlc_mutex_locker locker( &lock );
-        buffered += p_block->i_buffer;
-        block_ChainLastAppend(&pp_tail, p_block);
-        if((size_t) ret < readsize)
+        if(p_block)
+            enqueue(p_block);
+        if(b_last)
         {
             done = true;
             rate.size = buffered + consumed;
             rate.time = mdate() - downloadstart;
             downloadstart = 0;
+            transfer.completed = mdate();
+            transfer.bytes = rate.size;
+            cacheStore();
         }
     }
 
@@ -362,6 +423,124 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
     vlc_cond_signal(&avail);
 }
 
+void HTTPChunkBufferedSource::enqueue(block_t *p_chain)
+{
+    for(block_t *p_block = p_chain; p_block; p_block = p_block->p_next)
+    {
+        if(boxaligned)
+            boxAlignedUpdate(p_block);
+        buffered += p_block->i_buffer;
+        if(cache)
+        {
+            block_t *p_copy = block_Duplicate(p_block);
+            if(p_copy)
+                block_ChainLastAppend(&pp_cachetail, p_copy);
+            else
+                cache = NULL;
+        }
+    }
+    block_ChainLastAppend(&pp_tail, p_chain);
+}
+
+void HTTPChunkBufferedSource::setFilter(AbstractChunkFilter *filter_)
+{
+    vlc_mutex_locker locker( &lock );
+    delete filter;
+    filter = filter_;
+    /* boundaries can't be parsed from filtered (encrypted) data */
+    boxaligned = false;
+}
+
+block_t * HTTPChunkBufferedSource::filterBlock(block_t *p_block, bool b_last)
+{
+    /* The filter needs to be told about the last block (ex: to remove
+     * padding), which we only know about on next read. So we need to
+     * hold back one block. */
+    block_t *p_out = NULL;
+    block_t **pp_out = &p_out;
+
+    if(p_filterpending)
+    {
+        block_t *p_filtered = filter->filter(p_filterpending, b_last && p_block == NULL);
+        p_filterpending = NULL;
+        if(p_filtered)
+            block_ChainLastAppend(&pp_out, p_filtered);
+    }
+
+    if(p_block)
+    {
+        if(b_last)
+        {
+            block_t *p_filtered = filter->filter(p_block, true);
+            if(p_filtered)
+                block_ChainLastAppend(&pp_out, p_filtered);
+        }
+        else p_filterpending = p_block;
+    }
+
+    return p_out;
+}
+
+void HTTPChunkBufferedSource::setBoxAligned(bool b)
+{
+    vlc_mutex_locker locker( &lock );
+    boxaligned = b;
+    boxremaining = 0;
+}
+
+void HTTPChunkBufferedSource::setCache(ChunkCache *cache_, const std::string &key)
+{
+    vlc_mutex_locker locker( &lock );
+    cache = cache_;
+    cachekey = key;
+}
+
+void HTTPChunkBufferedSource::cacheStore()
+{
+    /* Only complete responses of known length can be told apart from
+     * a failed or truncated transfer */
+    if(cache && p_cachehead && contentLength &&
+       buffered + consumed == contentLength)
+    {
+        cache->put(cachekey, p_cachehead);
+        p_cachehead = NULL;
+        pp_cachetail = &p_cachehead;
+    }
+    cache = NULL;
+}
+
+size_t HTTPChunkBufferedSource::boxAlignedReadSize(size_t readsize) const
+{
+    /* Connection reads only return once the requested size has been
+     * received. With chunked CMAF, the server pushes complete moof/mdat
+     * pairs, so reading up to the end of the current box delivers each
+     * fragment as soon as it has arrived instead of waiting for a full slice */
+    if(boxremaining == 0)
+        return 8; /* next box header */
+    if(readsize < HTTPChunkSource::CHUNK_SIZE)
+        readsize = HTTPChunkSource::CHUNK_SIZE;
+    return (boxremaining < readsize) ? boxremaining : readsize;
+}
+
+void HTTPChunkBufferedSource::boxAlignedUpdate(const block_t *p_block)
+{
+    if(boxremaining == 0)
+    {
+        uint32_t boxsize = 0;
+        if(p_block->i_buffer == 8)
+            boxsize = GetDWBE(p_block->p_buffer);
+        /* largesize or until end boxes: fall back to regular slicing */
+        if(boxsize < 8)
+            boxaligned = false;
+        else
+            boxremaining = boxsize - 8;
+    }
+    else
+    {
+        boxremaining -= p_block->i_buffer;
+    }
+}
+
 bool HTTPChunkBufferedSource::prepare()
 {
     if(!prepared)
@@ -419,8 +598,33 @@ block_t * HTTPChunkBufferedSource::read(size_t readsize)
     while(readsize > buffered && !done)
         vlc_cond_wait(&avail, &lock);
 
-    block_t *p_block = NULL;
-    if(!readsize || !buffered || !(p_block = block_Alloc(readsize)) )
+    if(!readsize || !buffered)
+    {
+        eof = true;
+        return NULL;
+    }
+
+    /* Hand over the queued block when it fully matches the request */
+    if(p_head->i_buffer == readsize ||
+       (p_head->p_next == NULL && p_head->i_buffer < readsize))
+    {
+        block_t *p_block = p_head;
+        p_head = p_head->p_next;
+        if(p_head == NULL)
+            pp_tail = &p_head;
+        p_block->p_next = NULL;
+
+        consumed += p_block->i_buffer;
+        buffered -= p_block->i_buffer;
+
+        if(p_block->i_buffer < readsize)
+            eof = true;
+
+        return p_block;
+    }
+
+    block_t *p_block = block_Alloc(readsize);
+    if(!p_block)
     {
         eof = true;
         return NULL;
@@ -456,6 +660,162 @@ block_t * HTTPChunkBufferedSource::read(size_t readsize)
     return p_block;
 }
 
+MemoryChunkSource::MemoryChunkSource(block_t *p_block) :
+    AbstractChunkSource()
+{
+    data = p_block;
+    i_read = 0;
+    contentLength = data->i_buffer;
+}
+
+MemoryChunkSource::~MemoryChunkSource()
+{
+    if(data)
+        block_Release(data);
+}
+
+bool MemoryChunkSource::hasMoreData() const
+{
+    return i_read < contentLength;
+}
+
+block_t * MemoryChunkSource::readBlock()
+{
+    if(data && i_read == 0) /* hand over whole data */
+    {
+        block_t *p_block = data;
+        data = NULL;
+        i_read = contentLength;
+        return p_block;
+    }
+    return read(contentLength - i_read);
+}
+
+block_t * MemoryChunkSource::read(size_t toread)
+{
+    if(!data)
+        return NULL;
+    if(toread > contentLength - i_read)
+        toread = contentLength - i_read;
+    if(toread == 0)
+        return NULL;
+
+    block_t *p_block = block_Alloc(toread);
+    if(p_block)
+    {
+        memcpy(p_block->p_buffer, &data->p_buffer[i_read], toread);
+        i_read += toread;
+    }
+    return p_block;
+}
+
+SharedChunkSource::SharedChunkSource(AbstractChunkSource *source_)
+{
+    source = source_;
+    position = 0;
+    refs = 0;
+}
+
+SharedChunkSource::~SharedChunkSource()
+{
+    delete source;
+}
+
+void SharedChunkSource::hold()
+{
+    refs++;
+}
+
+void SharedChunkSource::release()
+{
+    if(--refs == 0)
+        delete this;
+}
+
+block_t * SharedChunkSource::read(size_t offset, size_t size)
+{
+    /* Drop what previous slices did not read */
+    while(position < offset)
+    {
+        size_t toskip = offset - position;
+        if(toskip > HTTPChunkSource::CHUNK_SIZE)
+            toskip = HTTPChunkSource::CHUNK_SIZE;
+        block_t *p_block = source->read(toskip);
+        if(!p_block)
+            return NULL;
+        position += p_block->i_buffer;
+        block_Release(p_block);
+    }
+
+    if(position != offset)
+        return NULL;
+
+    block_t *p_block = source->read(size);
+    if(p_block)
+        position += p_block->i_buffer;
+    return p_block;
+}
+
+bool SharedChunkSource::hasMoreData() const
+{
+    return source->hasMoreData();
+}
+
+TransferStats SharedChunkSource::getTransferStats() const
+{
+    return source->getTransferStats();
+}
+
+ChunkSliceSource::ChunkSliceSource(SharedChunkSource *shared_, size_t offset_,
+                                   size_t length, bool b_last_) :
+    AbstractChunkSource()
+{
+    shared = shared_;
+    shared->hold();
+    offset = offset_;
+    consumed = 0;
+    contentLength = length;
+    b_last = b_last_;
+}
+
+ChunkSliceSource::~ChunkSliceSource()
+{
+    shared->release();
+}
+
+block_t * ChunkSliceSource::readBlock()
+{
+    return read(HTTPChunkSource::CHUNK_SIZE);
+}
+
+block_t * ChunkSliceSource::read(size_t size)
+{
+    if(size > contentLength - consumed)
+        size = contentLength - consumed;
+    if(size == 0)
+        return NULL;
+
+    block_t *p_block = shared->read(offset + consumed, size);
+    if(p_block)
+        consumed += p_block->i_buffer;
+    else
+        consumed = contentLength;
+    return p_block;
+}
+
+bool ChunkSliceSource::hasMoreData() const
+{
+    return consumed < contentLength && shared->hasMoreData();
+}
+
+TransferStats ChunkSliceSource::getTransferStats() const
+{
+    /* Not a request of its own, unless it completes the shared one */
+    if(b_last)
+        return shared->getTransferStats();
+    return TransferStats();
+}
+
 HTTPChunk::HTTPChunk(const std::string &url, AbstractConnectionManager *manager,
                      const adaptive::ID &id):
     AbstractChunk(new HTTPChunkSource(url, manager, id))
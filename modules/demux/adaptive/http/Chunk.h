@@ -41,6 +41,26 @@ namespace adaptive
         class AbstractConnection;
         class AbstractConnectionManager;
         class AbstractChunk;
+        class ChunkCache;
+
+        /* In place processing of the downloaded data (ex: decryption),
+         * done on the downloader thread */
+        class AbstractChunkFilter
+        {
+            public:
+                virtual ~AbstractChunkFilter() {}
+                virtual block_t * filter(block_t *, bool b_last) = 0;
+        };
+
+        class TransferStats
+        {
+            public:
+                TransferStats();
+                mtime_t             requested; /* 0 when not fetched from network */
+                mtime_t             firstbyte; /* response received */
+                mtime_t             completed;
+                size_t              bytes;
+        };
 
         class AbstractChunkSource
         {
@@ -50,12 +70,14 @@ namespace adaptive
                 virtual block_t *   readBlock       () = 0;
                 virtual block_t *   read            (size_t) = 0;
                 virtual bool        hasMoreData     () const = 0;
+                virtual TransferStats getTransferStats() const;
                 void                setBytesRange   (const BytesRange &);
                 const BytesRange &  getBytesRange   () const;
 
             protected:
                 size_t              contentLength;
                 BytesRange          bytesRange;
+                TransferStats       transfer;
         };
 
         class AbstractChunk
@@ -66,6 +88,7 @@ namespace adaptive
                 size_t              getBytesRead            () const;
                 uint64_t            getStartByteInFile      () const;
                 bool                isEmpty                 () const;
+                TransferStats       getTransferStats        () const;
 
                 virtual block_t *   readBlock       ();
                 virtual block_t *   read            (size_t);
@@ -118,13 +141,22 @@ namespace adaptive
                 virtual block_t *  readBlock       (); /* reimpl */
                 virtual block_t *  read            (size_t); /* reimpl */
                 virtual bool       hasMoreData     () const; /* impl */
+                virtual TransferStats getTransferStats() const; /* reimpl */
                 void               hold();
                 void               release();
+                void               setBoxAligned(bool);
+                void               setCache(ChunkCache *, const std::string &);
+                void               setFilter(AbstractChunkFilter *); /* takes ownership */
 
             protected:
                 virtual bool       prepare(); /* reimpl */
                 void               bufferize(size_t);
                 bool               isDone() const;
+                size_t             boxAlignedReadSize(size_t) const;
+                void               boxAlignedUpdate(const block_t *);
+                void               cacheStore();
+                void               enqueue(block_t *);
+                block_t *          filterBlock(block_t *, bool);
 
             private:
                 block_t            *p_head; /* read cache buffer */
@@ -136,6 +168,66 @@ namespace adaptive
                 mutable vlc_mutex_t lock;
                 vlc_cond_t          avail;
                 bool                held;
+                bool                boxaligned; /* stop reads on ISOBMFF box boundaries */
+                uint64_t            boxremaining;
+                ChunkCache         *cache;
+                std::string         cachekey;
+                block_t            *p_cachehead; /* copy of the whole content */
+                block_t           **pp_cachetail;
+                AbstractChunkFilter *filter;
+                block_t            *p_filterpending;
+        };
+
+        class MemoryChunkSource : public AbstractChunkSource
+        {
+            public:
+                MemoryChunkSource(block_t *);
+                virtual ~MemoryChunkSource();
+
+                virtual block_t *   readBlock       (); /* impl */
+                virtual block_t *   read            (size_t); /* impl */
+                virtual bool        hasMoreData     () const; /* impl */
+
+            private:
+                block_t            *data;
+                size_t              i_read;
+        };
+
+        /* One download shared by several sources reading consecutive
+         * parts of it, in order. Refcounted by the slices. */
+        class SharedChunkSource
+        {
+            public:
+                SharedChunkSource(AbstractChunkSource *); /* takes ownership */
+                void                hold();
+                void                release();
+                block_t *           read            (size_t, size_t);
+                bool                hasMoreData     () const;
+                TransferStats       getTransferStats() const;
+
+            private:
+                ~SharedChunkSource();
+                AbstractChunkSource *source;
+                size_t              position;
+                unsigned            refs;
+        };
+
+        class ChunkSliceSource : public AbstractChunkSource
+        {
+            public:
+                ChunkSliceSource(SharedChunkSource *, size_t offset, size_t length, bool b_last);
+                virtual ~ChunkSliceSource();
+
+                virtual block_t *   readBlock       (); /* impl */
+                virtual block_t *   read            (size_t); /* impl */
+                virtual bool        hasMoreData     () const; /* impl */
+                virtual TransferStats getTransferStats() const; /* reimpl */
+
+            private:
+                SharedChunkSource  *shared;
+                size_t              offset;
+                size_t              consumed;
+                bool                b_last; /* reports the shared transfer */
         };
 
         class HTTPChunk : public AbstractChunk
@@ -0,0 +1,109 @@
+/*
+ * ChunkCache.cpp
+ *****************************************************************************
+ * Copyright (C) 2017 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "ChunkCache.hpp"
+#include "BytesRange.hpp"
+
+#include <vlc_block.h>
+
+#include <sstream>
+
+using namespace adaptive::http;
+
+ChunkCache::ChunkCache(size_t maxsize_)
+{
+    size = 0;
+    maxsize = maxsize_;
+    vlc_mutex_init(&lock);
+}
+
+ChunkCache::~ChunkCache()
+{
+    std::list<Entry>::const_iterator it;
+    for(it = entries.begin(); it != entries.end(); ++it)
+        block_Release((*it).second);
+    vlc_mutex_destroy(&lock);
+}
+
+std::string ChunkCache::makeKey(const std::string &url, const BytesRange &range)
+{
+    std::ostringstream os;
+    os.imbue(std::locale("C"));
+    os << url;
+    if(range.isValid())
+        os << "@" << range.getStartByte() << "-" << range.getEndByte();
+    return os.str();
+}
+
+block_t * ChunkCache::get(const std::string &key)
+{
+    vlc_mutex_locker locker(&lock);
+    std::list<Entry>::iterator it;
+    for(it = entries.begin(); it != entries.end(); ++it)
+    {
+        if((*it).first == key)
+        {
+            if(it != entries.begin())
+                entries.splice(entries.begin(), entries, it);
+            return block_Duplicate((*it).second);
+        }
+    }
+    return NULL;
+}
+
+void ChunkCache::put(const std::string &key, block_t *p_block)
+{
+    p_block = block_ChainGather(p_block);
+    if(!p_block)
+        return;
+
+    if(p_block->i_buffer > maxsize / 4)
+    {
+        block_Release(p_block);
+        return;
+    }
+
+    vlc_mutex_locker locker(&lock);
+    std::list<Entry>::iterator it;
+    for(it = entries.begin(); it != entries.end(); ++it)
+    {
+        if((*it).first == key)
+        {
+            size -= (*it).second->i_buffer;
+            block_Release((*it).second);
+            entries.erase(it);
+            break;
+        }
+    }
+
+    entries.push_front(Entry(key, p_block));
+    size += p_block->i_buffer;
+
+    while(size > maxsize)
+    {
+        Entry &last = entries.back();
+        size -= last.second->i_buffer;
+        block_Release(last.second);
+        entries.pop_back();
+    }
+}
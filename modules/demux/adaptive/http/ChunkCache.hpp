@@ -0,0 +1,59 @@
+/*
+ * ChunkCache.hpp
+ *****************************************************************************
+ * Copyright (C) 2017 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef CHUNKCACHE_HPP
+#define CHUNKCACHE_HPP
+
+#include <vlc_common.h>
+
+#include <list>
+#include <string>
+
+namespace adaptive
+{
+    namespace http
+    {
+        class BytesRange;
+
+        /* Keeps the raw bytes of small, often refetched resources
+         * (initialization and index segments) so that switching back
+         * to a representation does not issue new requests */
+        class ChunkCache
+        {
+            public:
+                ChunkCache(size_t = defaultMaxSize);
+                ~ChunkCache();
+
+                block_t * get(const std::string &); /* returns a copy */
+                void      put(const std::string &, block_t *); /* takes ownership */
+                static std::string makeKey(const std::string &, const BytesRange &);
+
+                static const size_t defaultMaxSize = 4 * 1024 * 1024;
+
+            private:
+                typedef std::pair<std::string, block_t *> Entry;
+                std::list<Entry>    entries; /* most recently used first */
+                size_t              size;
+                size_t              maxsize;
+                vlc_mutex_t         lock;
+        };
+    }
+}
+
+#endif // CHUNKCACHE_HPP
@@ -24,12 +24,16 @@
 #include "ConnectionParams.hpp"
 
 #include <vlc_url.h>
+#include <cctype>
+#include <cstring>
 #include <sstream>
 
 using namespace adaptive::http;
 
 ConnectionParams::ConnectionParams()
 {
+    authoritylen = 0;
+    port = 0;
 }
 
 ConnectionParams::ConnectionParams(const std::string &uri)
@@ -38,6 +42,13 @@ ConnectionParams::ConnectionParams(const std::string &uri)
     parse();
 }
 
+ConnectionParams::ConnectionParams(const std::string &uri, const ConnectionParams &base)
+{
+    this->uri = uri;
+    if(!parseFrom(base))
+        parse();
+}
+
 const std::string & ConnectionParams::getUrl() const
 {
     return uri;
@@ -58,6 +69,11 @@ const std::string & ConnectionParams::getPath() const
     return path;
 }
 
+const std::string & ConnectionParams::getEndpoint() const
+{
+    return endpoint;
+}
+
 void ConnectionParams::setPath(const std::string &path_)
 {
     path = path_;
@@ -72,8 +88,10 @@ void ConnectionParams::setPath(const std::string &path_)
             (port != 443 && scheme != "https") )
             os << ":" << port;
     }
+    authoritylen = hostname.empty() ? 0 : (size_t)os.tellp();
     os << path;
     uri = os.str();
+    setEndpoint();
 }
 
 uint16_t ConnectionParams::getPort() const
@@ -81,12 +99,64 @@ uint16_t ConnectionParams::getPort() const
     return port;
 }
 
+void ConnectionParams::setEndpoint()
+{
+    std::ostringstream os;
+    os.imbue(std::locale("C"));
+    os << scheme << "://" << hostname << ":" << port;
+    endpoint = os.str();
+}
+
+static bool IsPlainPathChar(unsigned char c)
+{
+    /* unreserved, sub-delims and the path separators of RFC3986 */
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           (c >= '0' && c <= '9') || strchr("-._~!$&'()*+,;=:@/%", c);
+}
+
+bool ConnectionParams::parseFrom(const ConnectionParams &base)
+{
+    /* Segments of a stream share the server, only the path changes */
+    const size_t len = base.authoritylen;
+    if(len == 0 || uri.size() <= len || uri[len] != '/' ||
+       uri.compare(0, len, base.uri, 0, len))
+        return false;
+
+    /* Anything that vlc_UrlParse() would convert or reject needs it */
+    bool query = false;
+    for(size_t i = len; i < uri.size(); i++)
+    {
+        const unsigned char c = uri[i];
+        if(c == '?')
+            query = true;
+        else if(c == '#' || c < 0x20 || c >= 0x80 ||
+                (!query && !IsPlainPathChar(c)))
+            return false;
+        else if(c == '%' && !query &&
+                (i + 2 >= uri.size() || !isxdigit((unsigned char)uri[i + 1]) ||
+                 !isxdigit((unsigned char)uri[i + 2])))
+            return false;
+    }
+
+    scheme = base.scheme;
+    hostname = base.hostname;
+    port = base.port;
+    endpoint = base.endpoint;
+    authoritylen = len;
+    path = uri.substr(len);
+    return true;
+}
+
 void ConnectionParams::parse()
 {
+    authoritylen = 0;
     std::size_t pos = uri.find("://");
     if(pos != std::string::npos)
     {
         scheme = uri.substr(0, pos);
+        authoritylen = uri.find_first_of("/?#", pos + 3);
+        if(authoritylen == std::string::npos)
+            authoritylen = uri.size();
     }
 
     vlc_url_t url_components;
@@ -103,6 +173,9 @@ void ConnectionParams::parse()
                          ((scheme == "https") ? 443 : 80);
     if(url_components.psz_host)
         hostname = url_components.psz_host;
+    else
+        authoritylen = 0;
 
     vlc_UrlClean(&url_components);
+    setEndpoint();
 }
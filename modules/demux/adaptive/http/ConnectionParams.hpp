@@ -34,19 +34,27 @@ namespace adaptive
             public:
                 ConnectionParams();
                 ConnectionParams(const std::string &);
+                /* reuses the parsed scheme, host and port of base when
+                 * the URL has the same authority */
+                ConnectionParams(const std::string &, const ConnectionParams &base);
                 const std::string & getUrl() const;
                 const std::string & getScheme() const;
                 const std::string & getHostname() const;
                 const std::string & getPath() const;
+                const std::string & getEndpoint() const;
                 void setPath(const std::string &);
                 uint16_t getPort() const;
 
             private:
                 void parse();
+                bool parseFrom(const ConnectionParams &);
+                void setEndpoint();
                 std::string uri;
                 std::string scheme;
                 std::string hostname;
                 std::string path;
+                std::string endpoint; /* scheme://hostname:port */
+                size_t authoritylen; /* of the scheme and authority in uri */
                 uint16_t port;
         };
     }
@@ -28,37 +28,44 @@
 
 using namespace adaptive::http;
 
-Downloader::Downloader()
+Downloader::Downloader(unsigned workers_)
 {
     vlc_mutex_init(&lock);
     vlc_cond_init(&waitcond);
+    vlc_cond_init(&updatedcond);
     killed = false;
-    thread_handle_valid = false;
+    workers = workers_ ? workers_ : 1;
 }
 
 bool Downloader::start()
 {
-    if(!thread_handle_valid &&
-       vlc_clone(&thread_handle, downloaderThread,
-                 static_cast<void *>(this), VLC_THREAD_PRIORITY_INPUT))
+    if(!thread_handles.empty())
+        return true;
+
+    for(unsigned i=0; i<workers; i++)
     {
-        return false;
+        vlc_thread_t thread_handle;
+        if(vlc_clone(&thread_handle, downloaderThread,
+                     static_cast<void *>(this), VLC_THREAD_PRIORITY_INPUT))
+            break;
+        thread_handles.push_back(thread_handle);
     }
-    thread_handle_valid = true;
-    return true;
+    return !thread_handles.empty();
 }
 
 Downloader::~Downloader()
 {
     vlc_mutex_lock( &lock );
     killed = true;
-    vlc_cond_signal(&waitcond);
+    vlc_cond_broadcast(&waitcond);
     vlc_mutex_unlock( &lock );
 
-    if(thread_handle_valid)
-        vlc_join(thread_handle, NULL);
+    std::vector<vlc_thread_t>::const_iterator it;
+    for(it = thread_handles.begin(); it != thread_handles.end(); ++it)
+        vlc_join(*it, NULL);
     vlc_mutex_destroy(&lock);
     vlc_cond_destroy(&waitcond);
+    vlc_cond_destroy(&updatedcond);
 }
 void Downloader::schedule(HTTPChunkBufferedSource *source)
 {
@@ -72,6 +79,9 @@ void Downloader::schedule(HTTPChunkBufferedSource *source)
 void Downloader::cancel(HTTPChunkBufferedSource *source)
 {
     vlc_mutex_lock(&lock);
+    /* wait for the worker to finish its current slice */
+    while(isActive(source))
+        vlc_cond_wait(&updatedcond, &lock);
     source->release();
     chunks.remove(source);
     vlc_mutex_unlock(&lock);
@@ -92,27 +102,84 @@ void Downloader::DownloadSource(HTTPChunkBufferedSource *source)
         source->bufferize(HTTPChunkSource::CHUNK_SIZE);
 }
 
+bool Downloader::isActive(const HTTPChunkBufferedSource *source) const
+{
+    std::list<HTTPChunkBufferedSource *>::const_iterator it;
+    for(it = active.begin(); it != active.end(); ++it)
+        if(*it == source)
+            return true;
+    return false;
+}
+
+bool Downloader::isStreamActive(const ID &id) const
+{
+    std::list<HTTPChunkBufferedSource *>::const_iterator it;
+    for(it = active.begin(); it != active.end(); ++it)
+        if((*it)->sourceid == id)
+            return true;
+    return false;
+}
+
+HTTPChunkBufferedSource * Downloader::nextSource()
+{
+    /* Segments of a same stream must be fetched in order,
+       so we only pick the first queued one of each idle stream */
+    std::list<HTTPChunkBufferedSource *>::const_iterator it;
+    for(it = chunks.begin(); it != chunks.end(); ++it)
+    {
+        if(!isStreamActive((*it)->sourceid))
+            return *it;
+    }
+    return NULL;
+}
+
+void Downloader::rotate(const ID &id)
+{
+    /* Move that stream's sources behind the others, keeping their order,
+       so a worker can't starve other streams when it is alone */
+    std::list<HTTPChunkBufferedSource *> moved;
+    std::list<HTTPChunkBufferedSource *>::iterator it = chunks.begin();
+    while(it != chunks.end())
+    {
+        if((*it)->sourceid == id)
+            moved.splice(moved.end(), chunks, it++);
+        else
+            ++it;
+    }
+    chunks.splice(chunks.end(), moved);
+}
+
 void Downloader::Run()
 {
     vlc_mutex_lock(&lock);
     while(1)
     {
-        while(chunks.empty() && !killed)
+        HTTPChunkBufferedSource *source = NULL;
+        while(!killed && (source = nextSource()) == NULL)
             vlc_cond_wait(&waitcond, &lock);
 
         if(killed)
             break;
 
-        if(!chunks.empty())
+        active.push_back(source);
+        vlc_mutex_unlock(&lock);
+
+        DownloadSource(source);
+
+        vlc_mutex_lock(&lock);
+        if(source->isDone())
+        {
+            chunks.remove(source);
+            source->release();
+        }
+        else
         {
-            HTTPChunkBufferedSource *source = chunks.front();
-            DownloadSource(source);
-            if(source->isDone())
-            {
-                chunks.pop_front();
-                source->release();
-            }
+            rotate(source->sourceid);
         }
+        active.remove(source);
+        vlc_cond_broadcast(&updatedcond);
+        /* stream is available again for any worker */
+        vlc_cond_signal(&waitcond);
     }
     vlc_mutex_unlock(&lock);
 }
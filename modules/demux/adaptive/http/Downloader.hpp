@@ -24,6 +24,7 @@
 
 #include <vlc_common.h>
 #include <list>
+#include <vector>
 
 namespace adaptive
 {
@@ -34,7 +35,7 @@ namespace adaptive
         class Downloader
         {
             public:
-                Downloader();
+                Downloader(unsigned = 1);
                 ~Downloader();
                 bool start();
                 void schedule(HTTPChunkBufferedSource *);
@@ -44,12 +45,20 @@ namespace adaptive
                 static void * downloaderThread(void *);
                 void Run();
                 void DownloadSource(HTTPChunkBufferedSource *);
-                vlc_thread_t thread_handle;
+                HTTPChunkBufferedSource * nextSource();
+                bool isActive(const HTTPChunkBufferedSource *) const;
+                bool isStreamActive(const ID &) const;
+                void rotate(const ID &);
+                std::vector<vlc_thread_t> thread_handles;
+                unsigned     workers;
                 vlc_mutex_t  lock;
                 vlc_cond_t   waitcond;
-                bool         thread_handle_valid;
+                vlc_cond_t   updatedcond;
                 bool         killed;
+                /* queued sources, in scheduling order within each stream */
                 std::list<HTTPChunkBufferedSource *> chunks;
+                /* sources currently read by a worker, at most one per stream */
+                std::list<HTTPChunkBufferedSource *> active;
         };
 
     }
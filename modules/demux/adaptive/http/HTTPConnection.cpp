@@ -59,6 +59,11 @@ size_t AbstractConnection::getContentLength() const
     return contentLength;
 }
 
+bool AbstractConnection::isHealthy() const
+{
+    return true;
+}
+
 HTTPConnection::HTTPConnection(vlc_object_t *p_object_, AuthStorage *auth,
                                Socket *socket_, const ConnectionParams &proxy, bool persistent)
     : AbstractConnection( p_object_ )
@@ -89,15 +94,15 @@ bool HTTPConnection::canReuse(const ConnectionParams &params_) const
     char *psz_proxy_url = vlc_getProxyUrl(params_.getUrl().c_str());
     if(psz_proxy_url)
     {
-        ConnectionParams proxy(psz_proxy_url);
+        /* same proxy URL as this connection: no need to parse it again */
+        bool b_same = proxyparams.getUrl() == psz_proxy_url;
+        if(!b_same)
+            b_same = ConnectionParams(psz_proxy_url).getEndpoint() ==
+                     proxyparams.getEndpoint();
         free(psz_proxy_url);
-        return (proxyparams.getHostname() == proxy.getHostname() &&
-                proxyparams.getScheme() == proxy.getScheme() &&
-                proxyparams.getPort() == proxy.getPort());
+        return b_same;
     }
-    else return (params.getHostname() == params_.getHostname() &&
-                 params.getScheme() == params_.getScheme() &&
-                 params.getPort() == params_.getPort());
+    else return params.getEndpoint() == params_.getEndpoint();
 }
 
 bool HTTPConnection::connect()
@@ -115,6 +120,11 @@ bool HTTPConnection::connected() const
     return socket->connected();
 }
 
+bool HTTPConnection::isHealthy() const
+{
+    return socket->alive();
+}
+
 void HTTPConnection::disconnect()
 {
     queryOk = false;
@@ -566,9 +576,9 @@ AbstractConnection * ConnectionFactory::createConnection(vlc_object_t *p_object,
     if(!socket)
         return NULL;
 
-    /* disable pipelined tls until we have ticket/resume session support */
+    /* tls sessions are resumed from core's session cache when reconnecting */
     HTTPConnection *conn = new (std::nothrow)
-            HTTPConnection(p_object, authStorage, socket, proxy, sockettype != TLSSocket::TLS);
+            HTTPConnection(p_object, authStorage, socket, proxy, true);
     if(!conn)
     {
         delete socket;
@@ -51,6 +51,7 @@ namespace adaptive
 
                 virtual size_t  getContentLength() const;
                 virtual void    setUsed( bool ) = 0;
+                virtual bool    isHealthy   () const;
 
             protected:
                 vlc_object_t      *p_object;
@@ -73,6 +74,7 @@ namespace adaptive
                 virtual ssize_t read        (void *p_buffer, size_t len);
 
                 void setUsed( bool );
+                virtual bool    isHealthy   () const; /* reimpl */
 
             protected:
                 virtual bool    connected   () const;
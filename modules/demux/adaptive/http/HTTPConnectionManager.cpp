@@ -27,6 +27,7 @@
 
 #include "HTTPConnectionManager.h"
 #include "HTTPConnection.hpp"
+#include "LibVLCHTTPConnection.hpp"
 #include "ConnectionParams.hpp"
 #include "Sockets.hpp"
 #include "Downloader.hpp"
@@ -40,11 +41,24 @@ AbstractConnectionManager::AbstractConnectionManager(vlc_object_t *p_object_)
 {
     p_object = p_object_;
     rateObserver = NULL;
+    chunkCache = NULL;
+    vlc_mutex_init(&paramsLock);
 }
 
 AbstractConnectionManager::~AbstractConnectionManager()
 {
+    vlc_mutex_destroy(&paramsLock);
+}
 
+ConnectionParams AbstractConnectionManager::getParams(const std::string &url)
+{
+    /* Requests mostly go to the same server, whose URL was already parsed */
+    vlc_mutex_lock(&paramsLock);
+    ConnectionParams params(url, lastParams);
+    if(params.getEndpoint() != lastParams.getEndpoint() && !params.getHostname().empty())
+        lastParams = params;
+    vlc_mutex_unlock(&paramsLock);
+    return params;
 }
 
 void AbstractConnectionManager::updateDownloadRate(const adaptive::ID &sourceid, size_t size, mtime_t time)
@@ -58,12 +72,24 @@ void AbstractConnectionManager::setDownloadRateObserver(IDownloadRateObserver *o
     rateObserver = obs;
 }
 
+void AbstractConnectionManager::setChunkCache(ChunkCache *cache)
+{
+    chunkCache = cache;
+}
+
+ChunkCache * AbstractConnectionManager::getChunkCache() const
+{
+    return chunkCache;
+}
+
 HTTPConnectionManager::HTTPConnectionManager    (vlc_object_t *p_object_, ConnectionFactory *factory_)
     : AbstractConnectionManager( p_object_ )
 {
     vlc_mutex_init(&lock);
-    downloader = new (std::nothrow) Downloader();
-    downloader->start();
+    lastExpiry = 0;
+    downloader = new (std::nothrow) Downloader(var_InheritInteger(p_object, "adaptive-downloaders"));
+    if(downloader)
+        downloader->start();
     factory = factory_;
 }
 
@@ -71,10 +97,14 @@ HTTPConnectionManager::HTTPConnectionManager    (vlc_object_t *p_object_, AuthSt
     : AbstractConnectionManager( p_object_ )
 {
     vlc_mutex_init(&lock);
-    downloader = new (std::nothrow) Downloader();
-    downloader->start();
+    lastExpiry = 0;
+    downloader = new (std::nothrow) Downloader(var_InheritInteger(p_object, "adaptive-downloaders"));
+    if(downloader)
+        downloader->start();
     if(var_InheritBool(p_object, "adaptive-use-access"))
         factory = new (std::nothrow) StreamUrlConnectionFactory();
+    else if(var_InheritBool(p_object, "adaptive-http2"))
+        factory = new (std::nothrow) LibVLCHTTPConnectionFactory( storage );
     else
         factory = new (std::nothrow) ConnectionFactory( storage );
 }
@@ -91,27 +121,89 @@ void HTTPConnectionManager::closeAllConnections      ()
 {
     vlc_mutex_lock(&lock);
     releaseAllConnections();
-    vlc_delete_all(this->connectionPool);
+    std::map<AbstractConnection *, PoolEntry>::const_iterator it;
+    for(it = connectionPool.begin(); it != connectionPool.end(); ++it)
+        delete (*it).first;
+    connectionPool.clear();
+    idleConnections.clear();
     vlc_mutex_unlock(&lock);
 }
 
 void HTTPConnectionManager::releaseAllConnections()
 {
-    std::vector<AbstractConnection *>::iterator it;
+    std::map<AbstractConnection *, PoolEntry>::const_iterator it;
     for(it = connectionPool.begin(); it != connectionPool.end(); ++it)
-        (*it)->setUsed(false);
+        (*it).first->setUsed(false);
 }
 
-AbstractConnection * HTTPConnectionManager::reuseConnection(ConnectionParams &params)
+std::string HTTPConnectionManager::poolKey(const ConnectionParams &params)
 {
-    std::vector<AbstractConnection *>::const_iterator it;
-    for(it = connectionPool.begin(); it != connectionPool.end(); ++it)
+    char *psz_proxy_url = vlc_getProxyUrl(params.getUrl().c_str());
+    if(psz_proxy_url)
+    {
+        /* all requests through the same proxy can share connections */
+        ConnectionParams proxy(psz_proxy_url);
+        free(psz_proxy_url);
+        return "proxy " + proxy.getEndpoint();
+    }
+    return params.getEndpoint();
+}
+
+void HTTPConnectionManager::expireIdleConnections(mtime_t now,
+                                                  std::list<AbstractConnection *> &expired)
+{
+    const mtime_t timeout = CLOCK_FREQ * idleTimeoutSeconds;
+    std::map<std::string, IdleConnections>::iterator it = idleConnections.begin();
+    while(it != idleConnections.end())
+    {
+        IdleConnections &idle = (*it).second;
+        /* most recently used first, so expired ones are at the back */
+        while(!idle.empty() && now - connectionPool[idle.back()].idlesince > timeout)
+        {
+            expired.push_back(idle.back());
+            connectionPool.erase(idle.back());
+            idle.pop_back();
+        }
+        if(idle.empty())
+            idleConnections.erase(it++);
+        else
+            ++it;
+    }
+    lastExpiry = now;
+}
+
+AbstractConnection * HTTPConnectionManager::reuseConnection(ConnectionParams &params,
+                                                            const std::string &key)
+{
+    for(;;)
     {
-        AbstractConnection *conn = *it;
-        if(conn->canReuse(params))
+        AbstractConnection *conn = NULL;
+        std::list<AbstractConnection *> expired;
+
+        vlc_mutex_lock(&lock);
+        const mtime_t now = mdate();
+        if(now - lastExpiry > CLOCK_FREQ)
+            expireIdleConnections(now, expired);
+        std::map<std::string, IdleConnections>::iterator it = idleConnections.find(key);
+        if(it != idleConnections.end() && !(*it).second.empty())
+        {
+            conn = (*it).second.front();
+            (*it).second.pop_front();
+            connectionPool.erase(conn);
+        }
+        vlc_mutex_unlock(&lock);
+
+        vlc_delete_all(expired);
+
+        if(conn == NULL)
+            return NULL;
+
+        /* checked outside of the lock, the connection being ours now */
+        if(conn->isHealthy() && conn->canReuse(params))
             return conn;
+
+        delete conn;
     }
-    return NULL;
 }
 
 AbstractConnection * HTTPConnectionManager::getConnection(ConnectionParams &params)
@@ -119,31 +211,63 @@ AbstractConnection * HTTPConnectionManager::getConnection(ConnectionParams &para
     if(unlikely(!factory || !downloader))
         return NULL;
 
-    vlc_mutex_lock(&lock);
-    AbstractConnection *conn = reuseConnection(params);
+    const std::string key = poolKey(params);
+    AbstractConnection *conn = reuseConnection(params, key);
     if(!conn)
     {
         conn = factory->createConnection(p_object, params);
         if(!conn)
-        {
-            vlc_mutex_unlock(&lock);
             return NULL;
-        }
-
-        connectionPool.push_back(conn);
+    }
 
-        if (!conn->prepare(params))
-        {
-            vlc_mutex_unlock(&lock);
-            return NULL;
-        }
+    if (!conn->prepare(params))
+    {
+        delete conn;
+        return NULL;
     }
 
     conn->setUsed(true);
+
+    vlc_mutex_lock(&lock);
+    connectionPool[conn] = PoolEntry(key);
     vlc_mutex_unlock(&lock);
     return conn;
 }
 
+void HTTPConnectionManager::recycleConnection(AbstractConnection *conn)
+{
+    conn->setUsed(false);
+
+    std::list<AbstractConnection *> discarded;
+
+    vlc_mutex_lock(&lock);
+    std::map<AbstractConnection *, PoolEntry>::iterator it = connectionPool.find(conn);
+    if(it != connectionPool.end())
+    {
+        if(!conn->isHealthy())
+        {
+            connectionPool.erase(it);
+            discarded.push_back(conn);
+        }
+        else
+        {
+            PoolEntry &entry = (*it).second;
+            entry.idlesince = mdate();
+            IdleConnections &idle = idleConnections[entry.key];
+            idle.push_front(conn);
+            while(idle.size() > maxIdlePerHost)
+            {
+                discarded.push_back(idle.back());
+                connectionPool.erase(idle.back());
+                idle.pop_back();
+            }
+        }
+    }
+    vlc_mutex_unlock(&lock);
+
+    vlc_delete_all(discarded);
+}
+
 void HTTPConnectionManager::start(AbstractChunkSource *source)
 {
     HTTPChunkBufferedSource *src = dynamic_cast<HTTPChunkBufferedSource *>(source);
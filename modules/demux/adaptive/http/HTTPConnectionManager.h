@@ -26,22 +26,24 @@
 #define HTTPCONNECTIONMANAGER_H_
 
 #include "../logic/IDownloadRateObserver.h"
+#include "ConnectionParams.hpp"
 
 #include <vlc_common.h>
 
-#include <vector>
+#include <map>
+#include <list>
 #include <string>
 
 namespace adaptive
 {
     namespace http
     {
-        class ConnectionParams;
         class ConnectionFactory;
         class AbstractConnection;
         class AuthStorage;
         class Downloader;
         class AbstractChunkSource;
+        class ChunkCache;
 
         class AbstractConnectionManager : public IDownloadRateObserver
         {
@@ -50,17 +52,24 @@ namespace adaptive
                 ~AbstractConnectionManager();
                 virtual void    closeAllConnections () = 0;
                 virtual AbstractConnection * getConnection(ConnectionParams &) = 0;
+                virtual void recycleConnection(AbstractConnection *) = 0;
                 virtual void start(AbstractChunkSource *) = 0;
                 virtual void cancel(AbstractChunkSource *) = 0;
 
                 virtual void updateDownloadRate(const ID &, size_t, mtime_t); /* impl */
                 void setDownloadRateObserver(IDownloadRateObserver *);
+                void setChunkCache(ChunkCache *);
+                ChunkCache * getChunkCache() const;
+                ConnectionParams getParams(const std::string &);
 
             protected:
                 vlc_object_t                                       *p_object;
 
             private:
                 IDownloadRateObserver                              *rateObserver;
+                ChunkCache                                         *chunkCache; /* not owned */
+                vlc_mutex_t                                         paramsLock;
+                ConnectionParams                                    lastParams; /* of the last parsed server */
         };
 
         class HTTPConnectionManager : public AbstractConnectionManager
@@ -72,17 +81,33 @@ namespace adaptive
 
                 virtual void    closeAllConnections () /* impl */;
                 virtual AbstractConnection * getConnection(ConnectionParams &) /* impl */;
+                virtual void recycleConnection(AbstractConnection *) /* impl */;
 
                 virtual void start(AbstractChunkSource *) /* impl */;
                 virtual void cancel(AbstractChunkSource *) /* impl */;
 
             private:
+                class PoolEntry
+                {
+                    public:
+                        PoolEntry(const std::string &k = std::string()) : key(k), idlesince(0) {}
+                        std::string key;
+                        mtime_t     idlesince;
+                };
+                typedef std::list<AbstractConnection *> IdleConnections;
+
                 void    releaseAllConnections ();
+                void    expireIdleConnections (mtime_t, std::list<AbstractConnection *> &);
+                static std::string poolKey(const ConnectionParams &);
                 Downloader                                         *downloader;
                 vlc_mutex_t                                         lock;
-                std::vector<AbstractConnection *>                   connectionPool;
+                std::map<AbstractConnection *, PoolEntry>           connectionPool;
+                std::map<std::string, IdleConnections>              idleConnections; /* by endpoint, recent first */
+                mtime_t                                             lastExpiry;
                 ConnectionFactory                                  *factory;
-                AbstractConnection * reuseConnection(ConnectionParams &);
+                AbstractConnection * reuseConnection(ConnectionParams &, const std::string &);
+                static const unsigned maxIdlePerHost = 4;
+                static const int      idleTimeoutSeconds = 30;
         };
     }
 }
@@ -0,0 +1,319 @@
+/*
+ * LibVLCHTTPConnection.cpp
+ *****************************************************************************
+ * Copyright (C) 2017 - VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "LibVLCHTTPConnection.hpp"
+#include "AuthStorage.hpp"
+
+#include <vlc_block.h>
+
+extern "C"
+{
+    #include "../../../access/http/message.h"
+    #include "../../../access/http/resource.h"
+    #include "../../../access/http/connmgr.h"
+}
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+using namespace adaptive::http;
+
+namespace
+{
+    struct RangedResource
+    {
+        struct vlc_http_resource resource;
+        uintmax_t start;
+        uintmax_t end; /* inclusive, 0 for open ended */
+        bool      ranged;
+    };
+
+    int ranged_resource_request(const struct vlc_http_resource *res,
+                                struct vlc_http_msg *req, void *)
+    {
+        const RangedResource *ranged = reinterpret_cast<const RangedResource *>(res);
+        if(!ranged->ranged)
+            return 0;
+        if(ranged->end)
+            return vlc_http_msg_add_header(req, "Range", "bytes=%ju-%ju",
+                                           ranged->start, ranged->end);
+        return vlc_http_msg_add_header(req, "Range", "bytes=%ju-", ranged->start);
+    }
+
+    int ranged_resource_response(const struct vlc_http_resource *res,
+                                 const struct vlc_http_msg *resp, void *)
+    {
+        const RangedResource *ranged = reinterpret_cast<const RangedResource *>(res);
+        if(!ranged->ranged)
+            return 0;
+
+        const int status = vlc_http_msg_get_status(resp);
+        if(status == 206)
+        {
+            const char *str = vlc_http_msg_get_header(resp, "Content-Range");
+            uintmax_t start, end;
+            /* multipart/byteranges or unexpected offset */
+            if(str == NULL || sscanf(str, "bytes %ju-%ju", &start, &end) != 2 ||
+               start != ranged->start)
+                return -1;
+        }
+        else if(status / 100 == 2 && ranged->start != 0)
+        {
+            /* range ignored, we would read from the wrong offset */
+            return -1;
+        }
+        return 0;
+    }
+
+    const struct vlc_http_resource_cbs ranged_resource_callbacks =
+    {
+        ranged_resource_request,
+        ranged_resource_response,
+    };
+}
+
+LibVLCHTTPConnection::LibVLCHTTPConnection(vlc_object_t *p_object_,
+                                           LibVLCHTTPConnectionFactory *factory_)
+    : AbstractConnection(p_object_)
+{
+    factory = factory_;
+    resource = NULL;
+    p_block = NULL;
+    psz_useragent = var_InheritString(p_object_, "http-user-agent");
+}
+
+LibVLCHTTPConnection::~LibVLCHTTPConnection()
+{
+    reset();
+    free(psz_useragent);
+}
+
+void LibVLCHTTPConnection::reset()
+{
+    if(p_block)
+        block_Release(p_block);
+    p_block = NULL;
+    if(resource)
+        vlc_http_res_destroy(resource);
+    resource = NULL;
+    bytesRead = 0;
+    contentLength = 0;
+    bytesRange = BytesRange();
+}
+
+bool LibVLCHTTPConnection::canReuse(const ConnectionParams &) const
+{
+    /* endpoint is selected per request */
+    return available;
+}
+
+int LibVLCHTTPConnection::request(const std::string &path, const BytesRange &range)
+{
+    reset();
+
+    /* Set new path for this query */
+    if(!locationparams.getHostname().empty())
+    {
+        params = locationparams;
+        locationparams = ConnectionParams();
+    }
+    else params.setPath(path);
+
+    LibVLCHTTPConnectionFactory::Endpoint *endpoint = factory->getEndpoint(p_object, params);
+    if(!endpoint)
+        return VLC_EGENERIC;
+
+    msg_Dbg(p_object, "Retrieving %s @%zu", params.getUrl().c_str(),
+                      range.isValid() ? range.getStartByte() : 0);
+
+    RangedResource *res = (RangedResource *) malloc(sizeof(*res));
+    if(unlikely(!res))
+        return VLC_EGENERIC;
+
+    res->ranged = range.isValid();
+    res->start = range.isValid() ? range.getStartByte() : 0;
+    res->end = range.isValid() ? range.getEndByte() : 0;
+
+    if(vlc_http_res_init(&res->resource, &ranged_resource_callbacks, endpoint->mgr,
+                         params.getUrl().c_str(), psz_useragent, NULL))
+    {
+        free(res);
+        return VLC_EGENERIC;
+    }
+    resource = &res->resource;
+
+    vlc_mutex_lock(&endpoint->lock);
+    int status = vlc_http_res_get_status(resource);
+    vlc_mutex_unlock(&endpoint->lock);
+
+    if(status / 100 == 3)
+    {
+        char *psz_location = vlc_http_res_get_redirect(resource);
+        reset();
+        if(!psz_location)
+            return VLC_EGENERIC;
+        locationparams = ConnectionParams(psz_location);
+        free(psz_location);
+        return VLC_ETIMEOUT;
+    }
+    else if(status / 100 != 2)
+    {
+        reset();
+        return VLC_EGENERIC;
+    }
+
+    bytesRange = range;
+    if(range.isValid() && range.getEndByte() > 0)
+    {
+        contentLength = range.getEndByte() - range.getStartByte() + 1;
+    }
+    else
+    {
+        const uintmax_t size = vlc_http_msg_get_size(resource->response);
+        if(size != (uintmax_t) -1)
+            contentLength = size;
+    }
+
+    return VLC_SUCCESS;
+}
+
+ssize_t LibVLCHTTPConnection::read(void *p_buffer, size_t len)
+{
+    if(!resource)
+        return VLC_EGENERIC;
+
+    if(len == 0)
+        return VLC_SUCCESS;
+
+    const size_t toRead = (contentLength) ? contentLength - bytesRead : len;
+    if (toRead == 0)
+        return VLC_SUCCESS;
+
+    if(len > toRead)
+        len = toRead;
+
+    /* Only return short reads on end of stream */
+    size_t total = 0;
+    while(total < len)
+    {
+        if(!p_block)
+        {
+            p_block = vlc_http_res_read(resource);
+            if(p_block == vlc_http_error)
+                p_block = NULL;
+            if(!p_block)
+                break;
+        }
+
+        size_t copy = std::min(p_block->i_buffer, len - total);
+        memcpy((uint8_t *) p_buffer + total, p_block->p_buffer, copy);
+        total += copy;
+        p_block->p_buffer += copy;
+        p_block->i_buffer -= copy;
+        if(p_block->i_buffer == 0)
+        {
+            block_Release(p_block);
+            p_block = NULL;
+        }
+    }
+
+    bytesRead += total;
+
+    if(total < len || contentLength == bytesRead)
+        reset();
+
+    return total;
+}
+
+void LibVLCHTTPConnection::setUsed( bool b )
+{
+    available = !b;
+    if(available)
+        reset();
+}
+
+LibVLCHTTPConnectionFactory::Endpoint::Endpoint(struct vlc_http_mgr *mgr_)
+{
+    mgr = mgr_;
+    vlc_mutex_init(&lock);
+}
+
+LibVLCHTTPConnectionFactory::Endpoint::~Endpoint()
+{
+    vlc_http_mgr_destroy(mgr);
+    vlc_mutex_destroy(&lock);
+}
+
+LibVLCHTTPConnectionFactory::LibVLCHTTPConnectionFactory( AuthStorage *storage )
+    : ConnectionFactory( storage )
+{
+    jar = storage ? storage->getJar() : NULL;
+    vlc_mutex_init(&lock);
+}
+
+LibVLCHTTPConnectionFactory::~LibVLCHTTPConnectionFactory()
+{
+    std::map<std::string, Endpoint *>::const_iterator it;
+    for(it = endpoints.begin(); it != endpoints.end(); ++it)
+        delete (*it).second;
+    vlc_mutex_destroy(&lock);
+}
+
+LibVLCHTTPConnectionFactory::Endpoint *
+LibVLCHTTPConnectionFactory::getEndpoint(vlc_object_t *p_object, const ConnectionParams &params)
+{
+    const std::string &key = params.getEndpoint();
+
+    Endpoint *endpoint = NULL;
+    vlc_mutex_lock(&lock);
+    std::map<std::string, Endpoint *>::const_iterator it = endpoints.find(key);
+    if(it != endpoints.end())
+    {
+        endpoint = (*it).second;
+    }
+    else
+    {
+        struct vlc_http_mgr *mgr = vlc_http_mgr_create(p_object, jar);
+        if(mgr)
+        {
+            endpoint = new (std::nothrow) Endpoint(mgr);
+            if(endpoint)
+                endpoints.insert(std::pair<std::string, Endpoint *>(key, endpoint));
+            else
+                vlc_http_mgr_destroy(mgr);
+        }
+    }
+    vlc_mutex_unlock(&lock);
+    return endpoint;
+}
+
+AbstractConnection * LibVLCHTTPConnectionFactory::createConnection(vlc_object_t *p_object,
+                                                                   const ConnectionParams &params)
+{
+    /* h2 is only negotiated over TLS */
+    if(params.getScheme() != "https" || params.getHostname().empty())
+        return ConnectionFactory::createConnection(p_object, params);
+
+    return new (std::nothrow) LibVLCHTTPConnection(p_object, this);
+}
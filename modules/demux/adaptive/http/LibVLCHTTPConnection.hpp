@@ -0,0 +1,90 @@
+/*
+ * LibVLCHTTPConnection.hpp
+ *****************************************************************************
+ * Copyright (C) 2017 - VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef LIBVLCHTTPCONNECTION_HPP
+#define LIBVLCHTTPCONNECTION_HPP
+
+#include "HTTPConnection.hpp"
+#include <vlc_http.h>
+
+#include <map>
+#include <string>
+
+struct vlc_http_mgr;
+struct vlc_http_resource;
+
+namespace adaptive
+{
+    namespace http
+    {
+        class LibVLCHTTPConnectionFactory;
+
+        /* Connection backed by the access/http stack, which negotiates
+         * HTTP/2 over TLS and then multiplexes all requests to the same
+         * endpoint over a single session */
+        class LibVLCHTTPConnection : public AbstractConnection
+        {
+            public:
+                LibVLCHTTPConnection(vlc_object_t *, LibVLCHTTPConnectionFactory *);
+                virtual ~LibVLCHTTPConnection();
+
+                virtual bool    canReuse     (const ConnectionParams &) const;
+
+                virtual int     request     (const std::string& path, const BytesRange & = BytesRange());
+                virtual ssize_t read        (void *p_buffer, size_t len);
+
+                virtual void    setUsed( bool );
+
+            protected:
+                void reset();
+                LibVLCHTTPConnectionFactory *factory;
+                ConnectionParams locationparams;
+                struct vlc_http_resource *resource;
+                block_t *p_block;
+                char *psz_useragent;
+        };
+
+        class LibVLCHTTPConnectionFactory : public ConnectionFactory
+        {
+            public:
+                LibVLCHTTPConnectionFactory( AuthStorage * );
+                virtual ~LibVLCHTTPConnectionFactory();
+                virtual AbstractConnection * createConnection(vlc_object_t *, const ConnectionParams &);
+
+                /* One access/http manager per endpoint, as it only keeps a
+                 * single connection. Managers are not thread safe. */
+                class Endpoint
+                {
+                    public:
+                        Endpoint(struct vlc_http_mgr *);
+                        ~Endpoint();
+                        struct vlc_http_mgr *mgr;
+                        vlc_mutex_t lock;
+                };
+                Endpoint * getEndpoint(vlc_object_t *, const ConnectionParams &);
+
+            private:
+                vlc_http_cookie_jar_t *jar;
+                vlc_mutex_t lock;
+                std::map<std::string, Endpoint *> endpoints;
+        };
+    }
+}
+
+#endif // LIBVLCHTTPCONNECTION_HPP
@@ -25,6 +25,9 @@
 
 #include <vlc_network.h>
 #include <cerrno>
+#ifdef HAVE_POLL
+# include <poll.h>
+#endif
 
 using namespace adaptive::http;
 
@@ -65,6 +68,20 @@ bool Socket::connected() const
     return (netfd != -1);
 }
 
+bool Socket::alive() const
+{
+    if (netfd == -1)
+        return false;
+
+    /* Nothing is expected on an idle connection. Readable means the peer
+     * has closed (or sent a TLS alert) and we can't reuse it */
+    struct pollfd ufd;
+    ufd.fd = netfd;
+    ufd.events = POLLIN;
+    ufd.revents = 0;
+    return poll(&ufd, 1, 0) == 0;
+}
+
 void Socket::disconnect()
 {
     if (netfd >= 0)
@@ -39,6 +39,7 @@ namespace adaptive
                 virtual ssize_t read        (vlc_object_t *, void *p_buffer, size_t len);
                 virtual std::string readline(vlc_object_t *);
                 virtual void    disconnect  ();
+                bool    alive       () const;
                 int     getType() const;
                 static const int REGULAR = 0;
 
@@ -26,6 +26,7 @@
 #endif
 
 #include "AbstractAdaptationLogic.h"
+#include "SharedBandwidthEstimator.hpp"
 
 #include <limits>
 
@@ -35,14 +36,17 @@ AbstractAdaptationLogic::AbstractAdaptationLogic    ()
 {
     maxwidth = std::numeric_limits<int>::max();
     maxheight = std::numeric_limits<int>::max();
+    bwEstimator = NULL;
 }
 
 AbstractAdaptationLogic::~AbstractAdaptationLogic   ()
 {
 }
 
-void AbstractAdaptationLogic::updateDownloadRate    (const adaptive::ID &, size_t, mtime_t)
+void AbstractAdaptationLogic::updateDownloadRate    (const adaptive::ID &, size_t size, mtime_t time)
 {
+    if(bwEstimator)
+        bwEstimator->push(size, time);
 }
 
 void AbstractAdaptationLogic::setMaxDeviceResolution (int w, int h)
@@ -50,3 +54,15 @@ void AbstractAdaptationLogic::setMaxDeviceResolution (int w, int h)
     maxwidth = (w > 0) ? w : std::numeric_limits<int>::max();
     maxheight = (h > 0) ? h : std::numeric_limits<int>::max();
 }
+
+void AbstractAdaptationLogic::setBandwidthEstimator(SharedBandwidthEstimator *estimator)
+{
+    bwEstimator = estimator;
+}
+
+size_t AbstractAdaptationLogic::getInitialBandwidth() const
+{
+    /* Previous sessions estimate, with a safety margin as
+     * network conditions might have changed since */
+    return (bwEstimator) ? bwEstimator->getEstimate() * 3 / 4 : 0;
+}
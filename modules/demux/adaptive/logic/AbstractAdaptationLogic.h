@@ -40,6 +40,8 @@ namespace adaptive
     {
         using namespace playlist;
 
+        class SharedBandwidthEstimator;
+
         class AbstractAdaptationLogic : public IDownloadRateObserver,
                                         public SegmentTrackerListenerInterface
         {
@@ -51,6 +53,7 @@ namespace adaptive
                 virtual void                updateDownloadRate     (const ID &, size_t, mtime_t);
                 virtual void                trackerEvent           (const SegmentTrackerEvent &) {}
                 void                        setMaxDeviceResolution (int, int);
+                void                        setBandwidthEstimator  (SharedBandwidthEstimator *);
 
                 enum LogicType
                 {
@@ -61,11 +64,16 @@ namespace adaptive
                     FixedRate,
                     Predictive,
                     NearOptimal,
+                    BufferBased,
                 };
 
             protected:
+                size_t                      getInitialBandwidth    () const;
                 int maxwidth;
                 int maxheight;
+
+            private:
+                SharedBandwidthEstimator *bwEstimator; /* not owned */
         };
     }
 }
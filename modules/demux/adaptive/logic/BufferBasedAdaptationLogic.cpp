@@ -0,0 +1,231 @@
+/*
+ * BufferBasedAdaptationLogic.cpp
+ *****************************************************************************
+ * Copyright (C) 2017 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "BufferBasedAdaptationLogic.hpp"
+#include "Representationselectors.hpp"
+
+#include "../playlist/BaseAdaptationSet.h"
+#include "../playlist/BaseRepresentation.h"
+#include "../tools/Debug.hpp"
+
+using namespace adaptive::logic;
+using namespace adaptive;
+
+/*
+ * Buffer based rate selection, with BBA-1 like startup phase
+ * A Buffer-Based Approach to Rate Adaptation: Evidence from a Large Video
+ * Streaming Service, http://yuba.stanford.edu/~nickm/papers/sigcomm2014-video.pdf
+ *
+ * Below the reservoir, we stay on the lowest rate. Between the reservoir and
+ * the top of the cushion, the buffer level is linearly mapped to a rate.
+ * We only switch once that rate crosses the neighbour representations, which
+ * gives hysteresis around the current one.
+ */
+
+#define reservoirMinS        (CLOCK_FREQ * 4)
+#define startupSafetyFactor  0.5
+
+BufferBasedContext::BufferBasedContext()
+    : startup( true )
+    , buffering_min( reservoirMinS )
+    , buffering_level( 0 )
+    , buffering_target( 1 )
+    , last_buffering_level( 0 )
+    , last_download_rate( 0 )
+{ }
+
+BufferBasedAdaptationLogic::BufferBasedAdaptationLogic( vlc_object_t *p_obj )
+    : AbstractAdaptationLogic()
+    , p_obj( p_obj )
+{
+    vlc_mutex_init(&lock);
+}
+
+BufferBasedAdaptationLogic::~BufferBasedAdaptationLogic()
+{
+    vlc_mutex_destroy(&lock);
+}
+
+BaseRepresentation *
+BufferBasedAdaptationLogic::getBufferBasedRepresentation( BaseAdaptationSet *adaptSet,
+                                                          RepresentationSelector &selector,
+                                                          BaseRepresentation *prevRep,
+                                                          const BufferBasedContext &ctx ) const
+{
+    BaseRepresentation *lowest = selector.select(adaptSet, 0);
+    BaseRepresentation *highest = selector.select(adaptSet);
+    if(!lowest || !highest)
+        return NULL;
+
+    const mtime_t reservoir = std::max(std::max(ctx.buffering_min, (mtime_t) reservoirMinS),
+                                       ctx.buffering_target / 10);
+    const mtime_t cushion = ctx.buffering_target * 9 / 10 - reservoir;
+    if(ctx.buffering_level <= reservoir || cushion <= 0)
+        return lowest;
+
+    const uint64_t lowbw = lowest->getBandwidth();
+    const uint64_t highbw = highest->getBandwidth();
+    uint64_t rate;
+    if(ctx.buffering_level >= reservoir + cushion)
+        rate = highbw + 1;
+    else
+        rate = lowbw + (highbw - lowbw) * (ctx.buffering_level - reservoir) / cushion;
+
+    if(prevRep == NULL)
+        return selector.select(adaptSet, rate);
+
+    BaseRepresentation *up = selector.higher(adaptSet, prevRep);
+    BaseRepresentation *down = selector.lower(adaptSet, prevRep);
+
+    if(up != prevRep && rate > up->getBandwidth())
+    {
+        /* highest below mapped rate */
+        return selector.select(adaptSet, rate);
+    }
+    else if(down != prevRep && rate <= down->getBandwidth())
+    {
+        /* lowest above or at mapped rate */
+        BaseRepresentation *rep = selector.select(adaptSet, rate);
+        if(rep->getBandwidth() < rate)
+            rep = selector.higher(adaptSet, rep);
+        return rep;
+    }
+
+    return prevRep;
+}
+
+BaseRepresentation *BufferBasedAdaptationLogic::getNextRepresentation(BaseAdaptationSet *adaptSet, BaseRepresentation *prevRep)
+{
+    RepresentationSelector selector(maxwidth, maxheight);
+
+    vlc_mutex_lock(&lock);
+
+    std::map<ID, BufferBasedContext>::iterator it = streams.find(adaptSet->getID());
+    if(it == streams.end())
+    {
+        vlc_mutex_unlock(&lock);
+        return selector.select(adaptSet, getInitialBandwidth());
+    }
+
+    BufferBasedContext &ctx = (*it).second;
+    BaseRepresentation *rep = getBufferBasedRepresentation(adaptSet, selector, prevRep, ctx);
+
+    if(ctx.startup && prevRep == NULL)
+    {
+        /* Nothing measured yet: start from previous sessions estimate */
+        BaseRepresentation *initialrep = selector.select(adaptSet, getInitialBandwidth());
+        if(initialrep && (!rep || initialrep->getBandwidth() > rep->getBandwidth()))
+            rep = initialrep;
+    }
+
+    if(ctx.startup)
+    {
+        /* Buffer is still filling from empty, and the buffer map alone would
+         * keep us on lowest quality for too long. Step up, one at a time,
+         * while the measured throughput allows it. */
+        if(ctx.buffering_level < ctx.last_buffering_level)
+        {
+            ctx.startup = false;
+        }
+        else if(prevRep && ctx.last_download_rate)
+        {
+            BaseRepresentation *up = selector.higher(adaptSet, prevRep);
+            BaseRepresentation *startrep = prevRep;
+            if(up->getBandwidth() < ctx.last_download_rate * startupSafetyFactor)
+                startrep = up;
+            if(rep && rep->getBandwidth() >= startrep->getBandwidth())
+                ctx.startup = false;
+            else
+                rep = startrep;
+        }
+    }
+    ctx.last_buffering_level = ctx.buffering_level;
+
+    BwDebug( if( rep && rep != prevRep )
+                msg_Info(p_obj, "Stream %s buffering level %.2f%% %s new bandwidth usage %zu kBps",
+                         adaptSet->getID().str().c_str(),
+                         (float) 100 * ctx.buffering_level / ctx.buffering_target,
+                         ctx.startup ? "startup" : "steady", rep->getBandwidth() / 8000); );
+
+    vlc_mutex_unlock(&lock);
+
+    return rep;
+}
+
+void BufferBasedAdaptationLogic::updateDownloadRate(const ID &id, size_t dlsize, mtime_t time)
+{
+    AbstractAdaptationLogic::updateDownloadRate(id, dlsize, time);
+    vlc_mutex_lock(&lock);
+    std::map<ID, BufferBasedContext>::iterator it = streams.find(id);
+    if(it != streams.end() && time > 0)
+    {
+        BufferBasedContext &ctx = (*it).second;
+        ctx.last_download_rate = ctx.average.push(CLOCK_FREQ * dlsize * 8 / time);
+    }
+    vlc_mutex_unlock(&lock);
+}
+
+void BufferBasedAdaptationLogic::trackerEvent(const SegmentTrackerEvent &event)
+{
+    switch(event.type)
+    {
+    case SegmentTrackerEvent::BUFFERING_STATE:
+        {
+            const ID &id = *event.u.buffering.id;
+            vlc_mutex_lock(&lock);
+            if(event.u.buffering.enabled)
+            {
+                if(streams.find(id) == streams.end())
+                {
+                    BufferBasedContext ctx;
+                    streams.insert(std::pair<ID, BufferBasedContext>(id, ctx));
+                }
+            }
+            else
+            {
+                std::map<ID, BufferBasedContext>::iterator it = streams.find(id);
+                if(it != streams.end())
+                    streams.erase(it);
+            }
+            vlc_mutex_unlock(&lock);
+            BwDebug(msg_Info(p_obj, "Stream %s is now known %sactive", id.str().c_str(),
+                         (event.u.buffering.enabled) ? "" : "in"));
+        }
+        break;
+
+    case SegmentTrackerEvent::BUFFERING_LEVEL_CHANGE:
+        {
+            const ID &id = *event.u.buffering_level.id;
+            vlc_mutex_lock(&lock);
+            BufferBasedContext &ctx = streams[id];
+            ctx.buffering_min = event.u.buffering_level.minimum;
+            ctx.buffering_level = event.u.buffering_level.current;
+            ctx.buffering_target = event.u.buffering_level.target;
+            vlc_mutex_unlock(&lock);
+        }
+        break;
+
+    default:
+            break;
+    }
+}
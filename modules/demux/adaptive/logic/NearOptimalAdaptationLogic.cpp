@@ -98,11 +98,11 @@ BaseRepresentation *NearOptimalAdaptationLogic::getNextRepresentation(BaseAdapta
     if(it == streams.end())
     {
         vlc_mutex_unlock(&lock);
-        return selector.lowest(adaptSet);
+        return selector.select(adaptSet, getInitialBandwidth());
     }
     NearOptimalContext ctxcopy = (*it).second;
 
-    const unsigned bps = getAvailableBw(currentBps, prevRep);
+    const unsigned bps = getAvailableBw((currentBps) ? currentBps : getInitialBandwidth(), prevRep);
 
     vlc_mutex_unlock(&lock);
 
@@ -180,6 +180,7 @@ unsigned NearOptimalAdaptationLogic::getMaxCurrentBw() const
 
 void NearOptimalAdaptationLogic::updateDownloadRate(const ID &id, size_t dlsize, mtime_t time)
 {
+    AbstractAdaptationLogic::updateDownloadRate(id, dlsize, time);
     vlc_mutex_lock(&lock);
     std::map<ID, NearOptimalContext>::iterator it = streams.find(id);
     if(it != streams.end())
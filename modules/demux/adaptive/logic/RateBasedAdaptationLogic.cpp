@@ -59,7 +59,8 @@ BaseRepresentation *RateBasedAdaptationLogic::getNextRepresentation(BaseAdaptati
         return NULL;
 
     vlc_mutex_lock(const_cast<vlc_mutex_t *>(&lock));
-    size_t availBps = currentBps + ((currep) ? currep->getBandwidth() : 0);
+    size_t availBps = (bpsAvg) ? currentBps : getInitialBandwidth();
+    availBps += (currep) ? currep->getBandwidth() : 0;
     vlc_mutex_unlock(const_cast<vlc_mutex_t *>(&lock));
     if(availBps > usedBps)
         availBps -= usedBps;
@@ -78,10 +79,12 @@ BaseRepresentation *RateBasedAdaptationLogic::getNextRepresentation(BaseAdaptati
     return rep;
 }
 
-void RateBasedAdaptationLogic::updateDownloadRate(const ID &, size_t size, mtime_t time)
+void RateBasedAdaptationLogic::updateDownloadRate(const ID &id, size_t size, mtime_t time)
 {
     if(unlikely(time == 0))
         return;
+    AbstractAdaptationLogic::updateDownloadRate(id, size, time);
+
     /* Accumulate up to observation window */
     dllength += time;
     dlsize += size;
@@ -0,0 +1,204 @@
+/*
+ * SharedBandwidthEstimator.cpp
+ *****************************************************************************
+ * Copyright (C) 2017 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "SharedBandwidthEstimator.hpp"
+
+#include <vlc_variables.h>
+#include <vlc_configuration.h>
+#include <vlc_fs.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <sstream>
+
+using namespace adaptive::logic;
+
+/* Estimates are kept as text in a variable of the libvlc instance,
+ * which outlives the sessions and is released along with it */
+#define ESTIMATES_VAR "adaptive-bw-estimates"
+
+static vlc_mutex_t estimates_lock = VLC_STATIC_MUTEX;
+
+SharedBandwidthEstimator::SharedBandwidthEstimator(vlc_object_t *p_obj_,
+                                                   const std::string &host_)
+{
+    p_obj = p_obj_;
+    host = host_;
+    initialBps = 0;
+    bps = 0;
+    dlsize = 0;
+    dllength = 0;
+    b_persist = var_InheritBool(p_obj, "adaptive-bw-persist");
+    vlc_mutex_init(&lock);
+
+    if(host.empty())
+        return;
+
+    Entries entries;
+    vlc_mutex_lock(&estimates_lock);
+    load(entries);
+    vlc_mutex_unlock(&estimates_lock);
+
+    Entries::const_iterator it = entries.find(host);
+    if(it != entries.end())
+    {
+        initialBps = (*it).second.bps;
+        msg_Dbg(p_obj, "using previous bandwidth estimate of %zu kbps for %s",
+                initialBps / 1000, host.c_str());
+    }
+}
+
+SharedBandwidthEstimator::~SharedBandwidthEstimator()
+{
+    if(!host.empty() && bps)
+        commit();
+    vlc_mutex_destroy(&lock);
+}
+
+size_t SharedBandwidthEstimator::getEstimate() const
+{
+    vlc_mutex_locker locker(&lock);
+    return bps ? bps : initialBps;
+}
+
+void SharedBandwidthEstimator::push(size_t size, mtime_t time)
+{
+    if(unlikely(time <= 0))
+        return;
+
+    vlc_mutex_locker locker(&lock);
+    /* Accumulate up to observation window */
+    dlsize += size;
+    dllength += time;
+    if(dllength < CLOCK_FREQ / 4)
+        return;
+
+    const size_t sample = CLOCK_FREQ * dlsize * 8 / dllength;
+    bps = (bps) ? (bps * 4 + sample) / 5 : sample;
+    dlsize = dllength = 0;
+}
+
+void SharedBandwidthEstimator::commit()
+{
+    vlc_mutex_lock(&lock);
+    const size_t sessionbps = bps;
+    vlc_mutex_unlock(&lock);
+
+    vlc_mutex_lock(&estimates_lock);
+
+    Entries entries;
+    load(entries);
+    entries[host] = Entry(sessionbps, time(NULL));
+
+    while(entries.size() > maxEntries)
+    {
+        Entries::iterator oldest = entries.begin();
+        for(Entries::iterator it = entries.begin(); it != entries.end(); ++it)
+            if((*it).second.date < (*oldest).second.date)
+                oldest = it;
+        entries.erase(oldest);
+    }
+
+    const std::string str = serialize(entries);
+    var_Create(p_obj->obj.libvlc, ESTIMATES_VAR, VLC_VAR_STRING);
+    var_SetString(p_obj->obj.libvlc, ESTIMATES_VAR, str.c_str());
+
+    if(b_persist)
+    {
+        const std::string path = getStorePath();
+        FILE *f = path.empty() ? NULL : vlc_fopen(path.c_str(), "wt");
+        if(f)
+        {
+            fputs(str.c_str(), f);
+            fclose(f);
+        }
+        else msg_Warn(p_obj, "cannot save bandwidth estimates");
+    }
+
+    vlc_mutex_unlock(&estimates_lock);
+}
+
+void SharedBandwidthEstimator::load(Entries &entries) const
+{
+    char *psz = var_GetString(p_obj->obj.libvlc, ESTIMATES_VAR);
+    if(psz && *psz)
+    {
+        parse(psz, entries);
+    }
+    else if(b_persist)
+    {
+        /* first session of this instance */
+        const std::string path = getStorePath();
+        FILE *f = path.empty() ? NULL : vlc_fopen(path.c_str(), "rt");
+        if(f)
+        {
+            std::string str;
+            char buf[512];
+            size_t len;
+            while((len = fread(buf, 1, sizeof(buf), f)) > 0)
+                str.append(buf, len);
+            fclose(f);
+            parse(str.c_str(), entries);
+        }
+    }
+    free(psz);
+}
+
+void SharedBandwidthEstimator::parse(const char *psz, Entries &entries)
+{
+    const time_t now = time(NULL);
+    std::istringstream is(psz);
+    is.imbue(std::locale("C"));
+    std::string name;
+    size_t entrybps;
+    long long date;
+    while(is >> name >> entrybps >> date)
+    {
+        if(entrybps && now - date < maxAge)
+            entries[name] = Entry(entrybps, date);
+    }
+}
+
+std::string SharedBandwidthEstimator::serialize(const Entries &entries)
+{
+    std::ostringstream os;
+    os.imbue(std::locale("C"));
+    for(Entries::const_iterator it = entries.begin(); it != entries.end(); ++it)
+        os << (*it).first << " " << (*it).second.bps << " "
+           << (long long) (*it).second.date << "\n";
+    return os.str();
+}
+
+std::string SharedBandwidthEstimator::getStorePath() const
+{
+    std::string path;
+    char *psz_dir = config_GetUserDir(VLC_CACHE_DIR);
+    if(psz_dir)
+    {
+        vlc_mkdir(psz_dir, 0700);
+        path = std::string(psz_dir) + DIR_SEP "adaptive-bandwidth";
+        free(psz_dir);
+    }
+    return path;
+}
@@ -0,0 +1,75 @@
+/*
+ * SharedBandwidthEstimator.hpp
+ *****************************************************************************
+ * Copyright (C) 2017 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef SHAREDBANDWIDTHESTIMATOR_HPP
+#define SHAREDBANDWIDTHESTIMATOR_HPP
+
+#include <vlc_common.h>
+
+#include <map>
+#include <string>
+
+namespace adaptive
+{
+    namespace logic
+    {
+        /* Per host bandwidth estimates, shared by all the sessions of a libvlc
+         * instance (and optionally saved to disk), so that a new session can
+         * start on a sensible representation instead of the lowest one. */
+        class SharedBandwidthEstimator
+        {
+            public:
+                SharedBandwidthEstimator(vlc_object_t *, const std::string &);
+                ~SharedBandwidthEstimator(); /* commits the session estimate */
+
+                size_t getEstimate() const; /* bps, 0 if unknown */
+                void   push(size_t, mtime_t);
+
+            private:
+                class Entry
+                {
+                    public:
+                        Entry(size_t b = 0, time_t t = 0) : bps(b), date(t) {}
+                        size_t bps;
+                        time_t date;
+                };
+                typedef std::map<std::string, Entry> Entries;
+
+                static void   parse(const char *, Entries &);
+                static std::string serialize(const Entries &);
+                void          load(Entries &) const;
+                void          commit();
+                std::string   getStorePath() const;
+
+                vlc_object_t *p_obj;
+                std::string   host;
+                size_t        initialBps;
+                size_t        bps; /* this session */
+                size_t        dlsize;
+                mtime_t       dllength;
+                bool          b_persist;
+                mutable vlc_mutex_t lock;
+
+                static const time_t maxAge = 6 * 3600;
+                static const size_t maxEntries = 64;
+        };
+    }
+}
+
+#endif // SHAREDBANDWIDTHESTIMATOR_HPP
@@ -33,7 +33,9 @@
 #include "SegmentChunk.hpp"
 #include "../http/BytesRange.hpp"
 #include "../http/HTTPConnectionManager.h"
+#include "../http/ChunkCache.hpp"
 #include "../http/Downloader.hpp"
+#include <vlc_block.h>
 #include <cassert>
 
 using namespace adaptive::http;
@@ -67,15 +69,54 @@ void ISegment::onChunkDownload(block_t **, SegmentChunk *, BaseRepresentation *)
 
 }
 
+AbstractChunkFilter * ISegment::createChunkFilter() const
+{
+    return NULL;
+}
+
 SegmentChunk* ISegment::toChunk(size_t index, BaseRepresentation *rep, AbstractConnectionManager *connManager)
 {
     const std::string url = getUrlSegment().toString(index, rep);
+
+    /* Init and index data is refetched on each switch back to a representation */
+    ChunkCache *cache = connManager->getChunkCache();
+    std::string cachekey;
+    if(cache && (classId == InitSegment::CLASSID_INITSEGMENT ||
+                 classId == IndexSegment::CLASSID_INDEXSEGMENT))
+    {
+        cachekey = ChunkCache::makeKey(url, (startByte != endByte) ? BytesRange(startByte, endByte)
+                                                                   : BytesRange());
+        block_t *p_cached = cache->get(cachekey);
+        if(p_cached)
+        {
+            MemoryChunkSource *source = new (std::nothrow) MemoryChunkSource(p_cached);
+            if(!source)
+            {
+                block_Release(p_cached);
+                return NULL;
+            }
+            SegmentChunk *chunk = new (std::nothrow) SegmentChunk(this, source, rep);
+            if(!chunk)
+                delete source;
+            return chunk;
+        }
+    }
+
     HTTPChunkBufferedSource *source = new (std::nothrow) HTTPChunkBufferedSource(url, connManager,
                                                                                  rep->getAdaptationSet()->getID());
     if( source )
     {
         if(startByte != endByte)
             source->setBytesRange(BytesRange(startByte, endByte));
+        if(!cachekey.empty())
+            source->setCache(cache, cachekey);
+        if(rep->getStreamFormat() == StreamFormat(StreamFormat::MP4) &&
+                var_InheritBool(rep->getPlaylist()->getVLCObject(), "adaptive-lowlatency"))
+            source->setBoxAligned(true);
+
+        AbstractChunkFilter *filter = createChunkFilter();
+        if(filter)
+            source->setFilter(filter);
 
         SegmentChunk *chunk = new (std::nothrow) SegmentChunk(this, source, rep);
         if( chunk )
@@ -117,6 +158,11 @@ size_t ISegment::getOffset() const
     return startByte;
 }
 
+size_t ISegment::getEndOffset() const
+{
+    return endByte;
+}
+
 void ISegment::debug(vlc_object_t *obj, int indent) const
 {
     std::stringstream ss;
@@ -64,6 +64,7 @@ namespace adaptive
                 virtual uint64_t                        getSequenceNumber() const;
                 virtual bool                            isTemplate      () const;
                 virtual size_t                          getOffset       () const;
+                virtual size_t                          getEndOffset    () const;
                 virtual std::vector<ISegment*>          subSegments     () = 0;
                 virtual void                            addSubSegment   (SubSegment *) = 0;
                 virtual void                            debug           (vlc_object_t *,int = 0) const;
@@ -78,6 +79,7 @@ namespace adaptive
                 static const int CLASSID_ISEGMENT = 0;
                 /* callbacks */
                 virtual void                            onChunkDownload (block_t **, SegmentChunk *, BaseRepresentation *);
+                virtual AbstractChunkFilter *           createChunkFilter() const;
 
             protected:
                 size_t                  startByte;
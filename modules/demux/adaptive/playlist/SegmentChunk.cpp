@@ -58,3 +58,12 @@ StreamFormat SegmentChunk::getStreamFormat() const
         return StreamFormat();
 }
 
+const ISegment * SegmentChunk::getSegment() const
+{
+    return segment;
+}
+
+const BaseRepresentation * SegmentChunk::getRepresentation() const
+{
+    return rep;
+}
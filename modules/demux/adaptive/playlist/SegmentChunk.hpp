@@ -42,6 +42,8 @@ namespace adaptive
             virtual ~SegmentChunk();
             virtual void onDownload(block_t **); // reimpl
             StreamFormat getStreamFormat() const;
+            const ISegment * getSegment() const;
+            const BaseRepresentation * getRepresentation() const;
             bool discontinuity;
 
         protected:
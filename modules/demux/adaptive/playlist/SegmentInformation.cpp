@@ -151,6 +151,21 @@ std::size_t SegmentInformation::getSegments(SegmentInfoType type, std::vector<IS
     }
 }
 
+/* Returns the list getSegments() would flatten for media segments,
+   when it can be looked up directly */
+const SegmentList * SegmentInformation::getIndexedMediaSegmentList() const
+{
+    if( mediaSegmentTemplate )
+        return NULL;
+    else if( segmentList && !segmentList->getSegments().empty() )
+        return segmentList->isIndexed() ? segmentList : NULL;
+    else if( segmentBase )
+        return NULL;
+    else if( parent )
+        return parent->getIndexedMediaSegmentList();
+    return NULL;
+}
+
 std::size_t SegmentInformation::getAllSegments(std::vector<ISegment *> &retSegments) const
 {
     for(int i=0; i<InfoTypeCount; i++)
@@ -224,7 +239,7 @@ uint64_t SegmentInformation::getLiveStartSegmentNumber(uint64_t def) const
     else if ( segmentList && !segmentList->getSegments().empty() )
     {
         const Timescale timescale = segmentList->inheritTimescale();
-        const std::vector<ISegment *> list = segmentList->getSegments();
+        const std::vector<ISegment *> &list = segmentList->getSegments();
 
         const ISegment *back = list.back();
         const stime_t bufferingstart = back->startTime.Get() + back->duration.Get() - timescale.ToScaled( i_max_buffering );
@@ -268,6 +283,18 @@ ISegment * SegmentInformation::getNextSegment(SegmentInfoType type, uint64_t i_p
     if( type != INFOTYPE_MEDIA )
         return NULL;
 
+    const SegmentList *indexedList = getIndexedMediaSegmentList();
+    if( indexedList )
+    {
+        ISegment *seg = indexedList->getNextSegmentByNumber( i_pos );
+        if( seg )
+        {
+            *pi_newpos = seg->getSequenceNumber();
+            *pb_gap = (*pi_newpos != i_pos);
+        }
+        return seg;
+    }
+
     std::vector<ISegment *> retSegments;
     const size_t size = getSegments( type, retSegments );
     if( size )
@@ -309,6 +336,13 @@ ISegment * SegmentInformation::getNextSegment(SegmentInfoType type, uint64_t i_p
 
 ISegment * SegmentInformation::getSegment(SegmentInfoType type, uint64_t pos) const
 {
+    const SegmentList *indexedList = (type == INFOTYPE_MEDIA) ? getIndexedMediaSegmentList() : NULL;
+    if( indexedList )
+    {
+        ISegment *seg = indexedList->getNextSegmentByNumber( pos );
+        return (seg && seg->getSequenceNumber() == pos) ? seg : NULL;
+    }
+
     std::vector<ISegment *> retSegments;
     const size_t size = getSegments( type, retSegments );
     if( size )
@@ -476,6 +510,18 @@ void SegmentInformation::mergeWithTimeline(SegmentTimeline *updated)
     }
 }
 
+bool SegmentInformation::extendTimeline(stime_t time, stime_t duration)
+{
+    MediaSegmentTemplate *templ = inheritSegmentTemplate();
+    if(templ)
+    {
+        SegmentTimeline *timeline = templ->segmentTimeline.Get();
+        if(timeline)
+            return timeline->extendWith(time, duration);
+    }
+    return false;
+}
+
 void SegmentInformation::pruneByPlaybackTime(mtime_t time)
 {
     if(segmentList)
@@ -578,6 +624,10 @@ void SegmentInformation::SplitUsingIndex(std::vector<SplitPoint> &splitlist)
 {
     std::vector<ISegment *> seglist;
     getSegments(INFOTYPE_MEDIA, seglist);
+    /* subsegments numbering no longer follows the list */
+    SegmentList *list = inheritSegmentList();
+    if(list)
+        list->invalidateIndex();
     size_t prevstart = 0;
     stime_t prevtime = 0;
     const Timescale timescale = inheritTimescale();
@@ -82,6 +82,7 @@ namespace adaptive
                 uint64_t getLiveStartSegmentNumber(uint64_t) const;
                 virtual void mergeWith(SegmentInformation *, mtime_t);
                 virtual void mergeWithTimeline(SegmentTimeline *); /* ! don't use with global merge */
+                bool extendTimeline(stime_t, stime_t); /* appends one element if new */
                 virtual void pruneBySegmentNumber(uint64_t);
                 virtual void pruneByPlaybackTime(mtime_t);
                 virtual uint64_t translateSegmentNumber(uint64_t, const SegmentInformation *) const;
@@ -89,6 +90,7 @@ namespace adaptive
             protected:
                 std::size_t getAllSegments(std::vector<ISegment *> &) const;
                 std::size_t getSegments(SegmentInfoType, std::vector<ISegment *>&) const;
+                const SegmentList * getIndexedMediaSegmentList() const;
                 std::vector<SegmentInformation *> childs;
                 SegmentInformation * getChildByID( const ID & );
                 SegmentInformation *parent;
@@ -29,11 +29,24 @@
 #include "Segment.h"
 #include "SegmentInformation.hpp"
 
+#include <algorithm>
+
 using namespace adaptive::playlist;
 
+static bool SegmentNumberLess(const ISegment *seg, uint64_t number)
+{
+    return seg->getSequenceNumber() < number;
+}
+
+static bool SegmentTimeLess(stime_t time, const ISegment *seg)
+{
+    return time < seg->startTime.Get();
+}
+
 SegmentList::SegmentList( SegmentInformation *parent ):
     SegmentInfoCommon( parent ), TimescaleAble( parent )
 {
+    indexed = true;
 }
 SegmentList::~SegmentList()
 {
@@ -47,8 +60,31 @@ const std::vector<ISegment*>& SegmentList::getSegments() const
     return segments;
 }
 
+bool SegmentList::isIndexed() const
+{
+    return indexed;
+}
+
+void SegmentList::invalidateIndex()
+{
+    indexed = false;
+}
+
+ISegment * SegmentList::getNextSegmentByNumber(uint64_t number) const
+{
+    std::vector<ISegment *>::const_iterator it =
+            std::lower_bound(segments.begin(), segments.end(), number, SegmentNumberLess);
+    return (it != segments.end()) ? *it : NULL;
+}
+
 ISegment * SegmentList::getSegmentByNumber(uint64_t number)
 {
+    if(indexed)
+    {
+        ISegment *seg = getNextSegmentByNumber(number);
+        return (seg && seg->getSequenceNumber() == number) ? seg : NULL;
+    }
+
     std::vector<ISegment *>::const_iterator it = segments.begin();
     for(it = segments.begin(); it != segments.end(); ++it)
     {
@@ -68,6 +104,13 @@ ISegment * SegmentList::getSegmentByNumber(uint64_t number)
 void SegmentList::addSegment(ISegment *seg)
 {
     seg->setParent(this);
+    if(indexed && !segments.empty())
+    {
+        const ISegment *back = segments.back();
+        if(back->getSequenceNumber() >= seg->getSequenceNumber() ||
+           back->startTime.Get() > seg->startTime.Get())
+            indexed = false;
+    }
     segments.push_back(seg);
 }
 
@@ -111,7 +154,7 @@ void SegmentList::pruneByPlaybackTime(mtime_t time)
 void SegmentList::pruneBySegmentNumber(uint64_t tobelownum)
 {
     std::vector<ISegment *>::iterator it = segments.begin();
-    while(it != segments.end())
+    for(; it != segments.end(); ++it)
     {
         ISegment *seg = *it;
 
@@ -121,13 +164,26 @@ void SegmentList::pruneBySegmentNumber(uint64_t tobelownum)
         if(seg->chunksuse.Get()) /* can't prune from here, still in use */
             break;
 
-        delete *it;
-        it = segments.erase(it);
+        delete seg;
     }
+    segments.erase(segments.begin(), it);
 }
 
 bool SegmentList::getSegmentNumberByScaledTime(stime_t time, uint64_t *ret) const
 {
+    if(indexed)
+    {
+        /* same rules as SegmentInfoCommon::getSegmentNumberByScaledTime() */
+        if(segments.empty() || (segments.size() > 1 && segments[1]->startTime.Get() == 0))
+            return false;
+        std::vector<ISegment *>::const_iterator it =
+                std::upper_bound(segments.begin(), segments.end(), time, SegmentTimeLess);
+        if(it == segments.begin())
+            return false;
+        *ret = (*(it - 1))->getSequenceNumber();
+        return true;
+    }
+
     std::vector<ISegment *> allsubsegments;
     std::vector<ISegment *>::const_iterator it;
     for(it=segments.begin(); it!=segments.end(); ++it)
@@ -43,6 +43,9 @@ namespace adaptive
 
                 const std::vector<ISegment *>&   getSegments() const;
                 ISegment *              getSegmentByNumber(uint64_t);
+                ISegment *              getNextSegmentByNumber(uint64_t) const;
+                bool                    isIndexed() const;
+                void                    invalidateIndex();
                 void                    addSegment(ISegment *seg);
                 void                    mergeWith(SegmentList *, bool = false);
                 void                    pruneBySegmentNumber(uint64_t);
@@ -51,7 +54,10 @@ namespace adaptive
                 bool                    getPlaybackTimeDurationBySegmentNumber(uint64_t, mtime_t *, mtime_t *) const;
 
             private:
+                /* segments are also their own index, by number and by start time,
+                   as long as they're appended in order and never subsegmented */
                 std::vector<ISegment *>  segments;
+                bool                     indexed;
         };
     }
 }
@@ -33,121 +33,152 @@ using namespace adaptive::playlist;
 SegmentTimeline::SegmentTimeline(TimescaleAble *parent)
     :TimescaleAble(parent)
 {
+    head = 0;
 }
 
 SegmentTimeline::SegmentTimeline(uint64_t scale)
     :TimescaleAble(NULL)
 {
+    head = 0;
     setTimescale(scale);
 }
 
 SegmentTimeline::~SegmentTimeline()
 {
-    std::list<Element *>::iterator it;
-    for(it = elements.begin(); it != elements.end(); ++it)
-        delete *it;
 }
 
-void SegmentTimeline::addElement(uint64_t number, stime_t d, uint64_t r, stime_t t)
+bool SegmentTimeline::numberBefore(uint64_t number, const Element &el)
+{
+    return number < el.number;
+}
+
+bool SegmentTimeline::scaledTimeBefore(stime_t scaled, const Element &el)
 {
-    Element *element = new (std::nothrow) Element(number, d, r, t);
-    if(element)
+    return scaled < el.t;
+}
+
+bool SegmentTimeline::startsBefore(const Element &el, stime_t scaled)
+{
+    return el.t < scaled;
+}
+
+void SegmentTimeline::append(const Element &el)
+{
+    if(head < elements.size())
     {
-        if(!elements.empty() && !t)
+        /* Extend previous run when contiguous */
+        Element &last = elements.back();
+        if(el.d == last.d && el.t == last.endTime() &&
+           el.number == last.lastNumber() + 1)
         {
-            const Element *el = elements.back();
-            element->t = el->t + (el->d * (el->r + 1));
+            last.r += el.r + 1;
+            return;
         }
-        elements.push_back(element);
     }
+    elements.push_back(el);
+}
+
+void SegmentTimeline::compact()
+{
+    /* Only move the live part once it is no bigger than what was pruned,
+       so that pruning stays amortized constant per element */
+    if(head && head * 2 >= elements.size())
+    {
+        elements.erase(elements.begin(), elements.begin() + head);
+        head = 0;
+    }
+}
+
+const SegmentTimeline::Element * SegmentTimeline::findByNumber(uint64_t number) const
+{
+    std::vector<Element>::const_iterator it =
+            std::upper_bound(elements.begin() + head, elements.end(), number, numberBefore);
+    if(it == elements.begin() + head)
+        return NULL;
+    return &*(--it);
+}
+
+const SegmentTimeline::Element * SegmentTimeline::findByScaledTime(stime_t scaled) const
+{
+    std::vector<Element>::const_iterator it =
+            std::upper_bound(elements.begin() + head, elements.end(), scaled, scaledTimeBefore);
+    if(it == elements.begin() + head)
+        return NULL;
+    return &*(--it);
+}
+
+void SegmentTimeline::addElement(uint64_t number, stime_t d, uint64_t r, stime_t t)
+{
+    Element element(number, d, r, t);
+    if(head < elements.size() && !t)
+        element.t = elements.back().endTime();
+    append(element);
 }
 
 mtime_t SegmentTimeline::getMinAheadScaledTime(uint64_t number) const
 {
     stime_t totalscaledtime = 0;
 
-    std::list<Element *>::const_reverse_iterator it;
-    for(it = elements.rbegin(); it != elements.rend(); ++it)
+    std::vector<Element>::const_iterator it = elements.begin() + head;
+    const Element *el = findByNumber(number);
+    if(el)
     {
-        const Element *el = *it;
-
-        if(number < el->number)
-        {
-            totalscaledtime += (el->d * (el->r + 1));
-            break;
-        }
-        else if(number <= el->number + el->r)
-        {
-            totalscaledtime += el->d * (el->number + el->r - number);
-        }
-        else break;
+        if(number < el->lastNumber())
+            totalscaledtime += el->d * (el->lastNumber() - number);
+        it += (el - &elements[head]) + 1;
     }
 
+    for(; it != elements.end(); ++it)
+        totalscaledtime += (*it).d * ((*it).r + 1);
+
     return totalscaledtime;
 }
 
 uint64_t SegmentTimeline::getElementNumberByScaledPlaybackTime(stime_t scaled) const
 {
-    uint64_t prevnumber = 0;
-    std::list<Element *>::const_iterator it;
-    for(it = elements.begin(); it != elements.end(); ++it)
-    {
-        const Element *el = *it;
-        if(it == elements.begin())
-        {
-            scaled -= el->t;
-            prevnumber = el->number;
-        }
-
-        for(uint64_t repeat = 1 + el->r; repeat; repeat--)
-        {
-            if(el->d >= scaled)
-                return prevnumber;
+    if(head == elements.size())
+        return 0;
 
-            scaled -= el->d;
-            prevnumber++;
-        }
+    const Element *el = findByScaledTime(scaled);
+    if(!el) /* before first */
+        return elements[head].number;
 
-        /* might have been discontinuity */
-        prevnumber = el->number;
-    }
+    /* past the end, or might have been discontinuity */
+    if(!el->d || scaled >= el->endTime())
+        return el->lastNumber();
 
-    return prevnumber;
+    return el->number + (scaled - el->t) / el->d;
 }
 
 bool SegmentTimeline::getScaledPlaybackTimeDurationBySegmentNumber(uint64_t number,
                                                                    stime_t *time, stime_t *duration) const
 {
-    stime_t totalscaledtime = 0;
-    stime_t lastduration = 0;
+    *time = *duration = 0;
 
-    std::list<Element *>::const_iterator it;
-    for(it = elements.begin(); it != elements.end(); ++it)
-    {
-        const Element *el = *it;
-
-        /* set start time, or from discontinuity */
-        if(it == elements.begin() || el->t)
-        {
-            totalscaledtime = el->t;
-        }
-
-        lastduration = el->d;
-
-        if(number <= el->number)
-            break;
-
-        if(number <= el->number + el->r)
-        {
-            totalscaledtime += el->d * (number - el->number);
-            break;
-        }
+    if(head == elements.size())
+        return true;
 
-        totalscaledtime += (el->d * (el->r + 1));
+    const Element *el = findByNumber(number);
+    if(!el)
+    {
+        el = &elements[head];
+        *time = el->t;
+    }
+    else if(number <= el->lastNumber())
+    {
+        *time = el->t + el->d * (number - el->number);
+    }
+    else if(el != &elements.back()) /* number gap */
+    {
+        el++;
+        *time = el->t;
+    }
+    else
+    {
+        *time = el->endTime();
     }
 
-    *time = totalscaledtime;
-    *duration = lastduration;
+    *duration = el->d;
     return true;
 }
 
@@ -160,18 +191,16 @@ stime_t SegmentTimeline::getScaledPlaybackTimeByElementNumber(uint64_t number) c
 
 uint64_t SegmentTimeline::maxElementNumber() const
 {
-    if(elements.empty())
+    if(head == elements.size())
         return 0;
-
-    const Element *e = elements.back();
-    return e->number + e->r;
+    return elements.back().lastNumber();
 }
 
 uint64_t SegmentTimeline::minElementNumber() const
 {
-    if(elements.empty())
+    if(head == elements.size())
         return 0;
-    return elements.front()->number;
+    return elements[head].number;
 }
 
 void SegmentTimeline::pruneByPlaybackTime(mtime_t time)
@@ -184,84 +213,91 @@ void SegmentTimeline::pruneByPlaybackTime(mtime_t time)
 size_t SegmentTimeline::pruneBySequenceNumber(uint64_t number)
 {
     size_t prunednow = 0;
-    while(elements.size())
+    while(head < elements.size())
     {
-        Element *el = elements.front();
-        if(el->number >= number)
+        Element &el = elements[head];
+        if(el.number >= number)
         {
             break;
         }
-        else if(el->number + el->r >= number)
+        else if(el.lastNumber() >= number)
         {
-            uint64_t count = number - el->number;
-            el->number += count;
-            el->t += count * el->d;
-            el->r -= count;
+            uint64_t count = number - el.number;
+            el.number += count;
+            el.t += count * el.d;
+            el.r -= count;
             prunednow += count;
             break;
         }
         else
         {
-            prunednow += el->r + 1;
-            elements.pop_front();
-            delete el;
+            prunednow += el.r + 1;
+            head++;
         }
     }
 
+    compact();
+
     return prunednow;
 }
 
 void SegmentTimeline::mergeWith(SegmentTimeline &other)
 {
-    if(elements.empty())
+    std::vector<Element>::iterator it = other.elements.begin() + other.head;
+
+    if(head < elements.size())
     {
-        while(other.elements.size())
-        {
-            elements.push_back(other.elements.front());
-            other.elements.pop_front();
-        }
-        return;
+        /* Skip everything we already have before our last element */
+        it = std::lower_bound(it, other.elements.end(), elements.back().t, startsBefore);
     }
 
-    Element *last = elements.back();
-    while(other.elements.size())
+    for(; it != other.elements.end(); ++it)
     {
-        Element *el = other.elements.front();
-        other.elements.pop_front();
-
-        if(last->contains(el->t)) /* Same element, but prev could have been middle of repeat */
-        {
-            const uint64_t count = (el->t - last->t) / last->d;
-            last->r = std::max(last->r, el->r + count);
-            delete el;
-        }
-        else if(el->t < last->t)
+        Element el = *it;
+        if(head < elements.size())
         {
-            delete el;
-        }
-        else /* Did not exist in previous list */
-        {
-            elements.push_back(el);
-            el->number = last->number + last->r + 1;
-            last = el;
+            Element &last = elements.back();
+            if(last.contains(el.t)) /* Same element, but prev could have been middle of repeat */
+            {
+                const uint64_t count = (el.t - last.t) / last.d;
+                last.r = std::max(last.r, el.r + count);
+                continue;
+            }
+            el.number = last.lastNumber() + 1; /* Did not exist in previous list */
         }
+        append(el);
+    }
+
+    other.elements.clear();
+    other.head = 0;
+}
+
+bool SegmentTimeline::extendWith(stime_t t, stime_t d)
+{
+    /* Same as merging a single element timeline, without building it */
+    if(head < elements.size())
+    {
+        const Element &last = elements.back();
+        if(t < last.endTime()) /* already known */
+            return false;
+        append(Element(last.lastNumber() + 1, d, 0, t));
     }
+    else append(Element(1, d, 0, t));
+    return true;
 }
 
 mtime_t SegmentTimeline::start() const
 {
-    if(elements.empty())
+    if(head == elements.size())
         return 0;
-    return inheritTimescale().ToTime(elements.front()->t);
+    return inheritTimescale().ToTime(elements[head].t);
 }
 
 mtime_t SegmentTimeline::end() const
 {
-    if(elements.empty())
+    if(head == elements.size())
         return 0;
-    const Element *last = elements.back();
-    stime_t scaled = last->t + last->d * (last->r + 1);
-    return inheritTimescale().ToTime(scaled);
+    return inheritTimescale().ToTime(elements.back().endTime());
 }
 
 void SegmentTimeline::debug(vlc_object_t *obj, int indent) const
@@ -270,9 +306,9 @@ void SegmentTimeline::debug(vlc_object_t *obj, int indent) const
     ss << std::string(indent, ' ') << "Timeline";
     msg_Dbg(obj, "%s", ss.str().c_str());
 
-    std::list<Element *>::const_iterator it;
-    for(it = elements.begin(); it != elements.end(); ++it)
-        (*it)->debug(obj, indent + 1);
+    std::vector<Element>::const_iterator it;
+    for(it = elements.begin() + head; it != elements.end(); ++it)
+        (*it).debug(obj, indent + 1);
 }
 
 SegmentTimeline::Element::Element(uint64_t number_, stime_t d_, uint64_t r_, stime_t t_)
@@ -285,11 +321,21 @@ SegmentTimeline::Element::Element(uint64_t number_, stime_t d_, uint64_t r_, sti
 
 bool SegmentTimeline::Element::contains(stime_t time) const
 {
-    if(time >= t && time < t + (stime_t)(r + 1) * d)
+    if(time >= t && time < endTime())
         return true;
     return false;
 }
 
+stime_t SegmentTimeline::Element::endTime() const
+{
+    return t + (stime_t)(r + 1) * d;
+}
+
+uint64_t SegmentTimeline::Element::lastNumber() const
+{
+    return number + r;
+}
+
 void SegmentTimeline::Element::debug(vlc_object_t *obj, int indent) const
 {
     std::stringstream ss;
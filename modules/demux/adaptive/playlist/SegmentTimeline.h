@@ -26,7 +26,7 @@
 
 #include "SegmentInfoCommon.h"
 #include <vlc_common.h>
-#include <list>
+#include <vector>
 
 namespace adaptive
 {
@@ -50,24 +50,38 @@ namespace adaptive
                 void pruneByPlaybackTime(mtime_t);
                 size_t pruneBySequenceNumber(uint64_t);
                 void mergeWith(SegmentTimeline &);
+                bool extendWith(stime_t t, stime_t d);
                 mtime_t start() const;
                 mtime_t end() const;
                 void debug(vlc_object_t *, int = 0) const;
 
             private:
-                std::list<Element *> elements;
-
                 class Element
                 {
                     public:
                         Element(uint64_t, stime_t, uint64_t, stime_t);
                         void debug(vlc_object_t *, int = 0) const;
                         bool contains(stime_t) const;
+                        stime_t endTime() const;
+                        uint64_t lastNumber() const;
                         stime_t  t;
                         stime_t  d;
                         uint64_t r;
                         uint64_t number;
                 };
+
+                /* Run length encoded: each element covers r + 1 segments,
+                   numbered and timed contiguously. Elements before head
+                   are pruned and get reclaimed in batches. */
+                std::vector<Element> elements;
+                size_t head;
+                void append(const Element &);
+                void compact();
+                const Element * findByNumber(uint64_t) const;
+                const Element * findByScaledTime(stime_t) const;
+                static bool numberBefore(uint64_t, const Element &);
+                static bool scaledTimeBefore(stime_t, const Element &);
+                static bool startsBefore(const Element &, stime_t);
         };
     }
 }
@@ -43,6 +43,7 @@ enum
 AbstractCommand::AbstractCommand( int type_ )
 {
     type = type_;
+    next = NULL;
 }
 
 AbstractCommand::~AbstractCommand()
@@ -175,6 +176,102 @@ void EsOutMetaCommand::Execute( es_out_t *out )
     es_out_Control( out, ES_OUT_SET_GROUP_META, group, p_meta );
 }
 
+/*
+ * Commands allocation
+ */
+
+#define COMMAND_MAX_SIZE(a, b) ((a) > (b) ? (a) : (b))
+static const size_t commandSlotSize =
+    COMMAND_MAX_SIZE(COMMAND_MAX_SIZE(COMMAND_MAX_SIZE(sizeof(EsOutSendCommand),
+                                                       sizeof(EsOutDelCommand)),
+                                      COMMAND_MAX_SIZE(sizeof(EsOutAddCommand),
+                                                       sizeof(EsOutControlPCRCommand))),
+                     COMMAND_MAX_SIZE(COMMAND_MAX_SIZE(sizeof(EsOutDestroyCommand),
+                                                       sizeof(EsOutControlResetPCRCommand)),
+                                      sizeof(EsOutMetaCommand)));
+#undef COMMAND_MAX_SIZE
+
+/* Process wide freelist of command slots, released with the last queue */
+static struct
+{
+    vlc_mutex_t lock;
+    void *freelist;
+    unsigned count;
+    unsigned users;
+} commandsPool = { VLC_STATIC_MUTEX, NULL, 0, 0 };
+
+static const unsigned commandsPoolMax = 1024;
+
+void * AbstractCommand::operator new( size_t size, const std::nothrow_t & ) throw()
+{
+    if( size > commandSlotSize )
+        return ::operator new( size, std::nothrow );
+
+    vlc_mutex_lock( &commandsPool.lock );
+    void *p = commandsPool.freelist;
+    if( p )
+    {
+        commandsPool.freelist = *static_cast<void **>(p);
+        commandsPool.count--;
+    }
+    vlc_mutex_unlock( &commandsPool.lock );
+
+    return p ? p : ::operator new( commandSlotSize, std::nothrow );
+}
+
+void AbstractCommand::operator delete( void *p, size_t size )
+{
+    if( p == NULL )
+        return;
+
+    if( size <= commandSlotSize )
+    {
+        vlc_mutex_lock( &commandsPool.lock );
+        if( commandsPool.users && commandsPool.count < commandsPoolMax )
+        {
+            *static_cast<void **>(p) = commandsPool.freelist;
+            commandsPool.freelist = p;
+            commandsPool.count++;
+            p = NULL;
+        }
+        vlc_mutex_unlock( &commandsPool.lock );
+    }
+
+    ::operator delete( p );
+}
+
+void AbstractCommand::operator delete( void *p, const std::nothrow_t & ) throw()
+{
+    ::operator delete( p );
+}
+
+static void CommandsPoolHold()
+{
+    vlc_mutex_lock( &commandsPool.lock );
+    commandsPool.users++;
+    vlc_mutex_unlock( &commandsPool.lock );
+}
+
+static void CommandsPoolRelease()
+{
+    void *p_free = NULL;
+    vlc_mutex_lock( &commandsPool.lock );
+    if( --commandsPool.users == 0 )
+    {
+        p_free = commandsPool.freelist;
+        commandsPool.freelist = NULL;
+        commandsPool.count = 0;
+    }
+    vlc_mutex_unlock( &commandsPool.lock );
+
+    while( p_free )
+    {
+        void *p_next = *static_cast<void **>(p_free);
+        ::operator delete( p_free );
+        p_free = p_next;
+    }
+}
+
 /*
  * Commands Default Factory
  */
@@ -220,11 +317,118 @@ EsOutMetaCommand * CommandsFactory::createEsOutMetaCommand( int group, const vlc
     return NULL;
 }
 
+/*
+ * Intrusive commands list
+ */
+CommandsList::CommandsList()
+{
+    head = NULL;
+    pp_tail = &head;
+}
+
+bool CommandsList::empty() const
+{
+    return head == NULL;
+}
+
+AbstractCommand * CommandsList::front() const
+{
+    return head;
+}
+
+AbstractCommand * CommandsList::next( const AbstractCommand *command )
+{
+    return command->next;
+}
+
+void CommandsList::push_back( AbstractCommand *command )
+{
+    command->next = NULL;
+    *pp_tail = command;
+    pp_tail = &command->next;
+}
+
+AbstractCommand * CommandsList::pop_front()
+{
+    AbstractCommand *command = head;
+    if( command )
+    {
+        head = command->next;
+        if( head == NULL )
+            pp_tail = &head;
+        command->next = NULL;
+    }
+    return command;
+}
+
+void CommandsList::splice( CommandsList &other )
+{
+    if( other.head == NULL )
+        return;
+    *pp_tail = other.head;
+    pp_tail = other.pp_tail;
+    other.head = NULL;
+    other.pp_tail = &other.head;
+}
+
+void CommandsList::sort( bool (*lessthan)( const AbstractCommand *, const AbstractCommand * ) )
+{
+    /* bottom-up merge sort, keeping equal elements in order */
+    if( head == NULL || head->next == NULL )
+        return;
+
+    for( size_t width = 1;; width *= 2 )
+    {
+        AbstractCommand *p = head;
+        AbstractCommand **pp_out = &head;
+        unsigned merges = 0;
+
+        while( p )
+        {
+            merges++;
+            AbstractCommand *q = p;
+            size_t psize = 0;
+            while( q && psize < width )
+            {
+                q = q->next;
+                psize++;
+            }
+            size_t qsize = width;
+
+            while( psize > 0 || (qsize > 0 && q) )
+            {
+                AbstractCommand *e;
+                if( psize == 0 )
+                {
+                    e = q; q = q->next; qsize--;
+                }
+                else if( qsize == 0 || !q || !lessthan( q, p ) )
+                {
+                    e = p; p = p->next; psize--;
+                }
+                else
+                {
+                    e = q; q = q->next; qsize--;
+                }
+                *pp_out = e;
+                pp_out = &e->next;
+            }
+            p = q;
+        }
+        *pp_out = NULL;
+        pp_tail = pp_out;
+
+        if( merges <= 1 )
+            break;
+    }
+}
+
 /*
  * Commands Queue management
  */
 CommandsQueue::CommandsQueue( CommandsFactory *f )
 {
+    CommandsPoolHold();
     bufferinglevel = VLC_TS_INVALID;
     pcr = VLC_TS_INVALID;
     b_drop = false;
@@ -239,9 +443,10 @@ CommandsQueue::~CommandsQueue()
     Abort( false );
     delete commandsFactory;
     vlc_mutex_destroy(&lock);
+    CommandsPoolRelease();
 }
 
-static bool compareCommands( AbstractCommand *a, AbstractCommand *b )
+static bool compareCommands( const AbstractCommand *a, const AbstractCommand *b )
 {
     return (a->getTime() < b->getTime() && a->getTime() != VLC_TS_INVALID);
 }
@@ -283,12 +488,12 @@ mtime_t CommandsQueue::Process( es_out_t *out, mtime_t barrier )
        ex: for a target time of 2, you must dequeue <= 2 until >= PCR2
        A0,A1,A2,B0,PCR0,B1,B2,PCR2,B3,A3,PCR3
     */
-    std::list<AbstractCommand *> output;
-    std::list<AbstractCommand *> in;
+    CommandsList output;
+    CommandsList in;
 
     vlc_mutex_lock(&lock);
 
-    in.splice( in.end(), commands );
+    in.splice( commands );
 
     while( !in.empty() )
     {
@@ -313,7 +518,7 @@ mtime_t CommandsQueue::Process( es_out_t *out, mtime_t barrier )
     }
 
     /* push remaining ones if broke above */
-    commands.splice( commands.end(), in );
+    commands.splice( in );
 
     if(commands.empty() && b_draining)
         b_draining = false;
@@ -321,8 +526,7 @@ mtime_t CommandsQueue::Process( es_out_t *out, mtime_t barrier )
     /* Now execute our selected commands */
     while( !output.empty() )
     {
-        AbstractCommand *command = output.front();
-        output.pop_front();
+        AbstractCommand *command = output.pop_front();
 
         if( command->getType() == ES_OUT_PRIVATE_COMMAND_SEND )
             lastdts = command->getTime();
@@ -341,7 +545,7 @@ void CommandsQueue::LockedCommit()
 {
     /* reorder all blocks by time between 2 PCR and merge with main list */
     incoming.sort( compareCommands );
-    commands.splice( commands.end(), incoming );
+    commands.splice( incoming );
 }
 
 void CommandsQueue::Commit()
@@ -354,12 +558,9 @@ void CommandsQueue::Commit()
 void CommandsQueue::Abort( bool b_reset )
 {
     vlc_mutex_lock(&lock);
-    commands.splice( commands.end(), incoming );
+    commands.splice( incoming );
     while( !commands.empty() )
-    {
-        delete commands.front();
-        commands.pop_front();
-    }
+        delete commands.pop_front();
 
     if( b_reset )
     {
@@ -436,12 +637,12 @@ mtime_t CommandsQueue::getBufferingLevel() const
 
 mtime_t CommandsQueue::getFirstDTS() const
 {
-    std::list<AbstractCommand *>::const_iterator it;
+    const AbstractCommand *command;
     vlc_mutex_lock(const_cast<vlc_mutex_t *>(&lock));
     mtime_t i_firstdts = pcr;
-    for( it = commands.begin(); it != commands.end(); ++it )
+    for( command = commands.front(); command; command = CommandsList::next( command ) )
     {
-        const mtime_t i_dts = (*it)->getTime();
+        const mtime_t i_dts = command->getTime();
         if( i_dts > VLC_TS_INVALID )
         {
             if( i_dts < i_firstdts || i_firstdts == VLC_TS_INVALID )
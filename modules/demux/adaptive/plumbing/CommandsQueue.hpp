@@ -24,7 +24,7 @@
 #include <vlc_es.h>
 #include <vlc_atomic.h>
 
-#include <list>
+#include <new>
 
 namespace adaptive
 {
@@ -34,15 +34,24 @@ namespace adaptive
     class AbstractCommand
     {
         friend class CommandsFactory;
+        friend class CommandsList;
         public:
             virtual ~AbstractCommand();
             virtual void Execute( es_out_t * ) = 0;
             virtual mtime_t getTime() const;
             int getType() const;
 
+            /* commands are recycled through a freelist */
+            static void * operator new( size_t, const std::nothrow_t & ) throw();
+            static void operator delete( void *, size_t );
+            static void operator delete( void *, const std::nothrow_t & ) throw();
+
         protected:
             AbstractCommand( int );
             int type;
+
+        private:
+            AbstractCommand *next; /* intrusive queue link */
     };
 
     class AbstractFakeEsCommand : public AbstractCommand
@@ -146,6 +155,24 @@ namespace adaptive
             virtual EsOutMetaCommand * createEsOutMetaCommand( int, const vlc_meta_t * ) const;
     };
 
+    /* Intrusive FIFO, so queuing does not allocate */
+    class CommandsList
+    {
+        public:
+            CommandsList();
+            bool empty() const;
+            AbstractCommand * front() const;
+            static AbstractCommand * next( const AbstractCommand * );
+            void push_back( AbstractCommand * );
+            AbstractCommand * pop_front();
+            void splice( CommandsList & ); /* moves all other's to the end */
+            void sort( bool (*)( const AbstractCommand *, const AbstractCommand * ) ); /* stable */
+
+        private:
+            AbstractCommand *head;
+            AbstractCommand **pp_tail;
+    };
+
     /* Queuing for doing all the stuff in order */
     class CommandsQueue
     {
@@ -173,8 +200,8 @@ namespace adaptive
             vlc_mutex_t lock;
             void LockedCommit();
             void LockedSetDraining();
-            std::list<AbstractCommand *> incoming;
-            std::list<AbstractCommand *> commands;
+            CommandsList incoming;
+            CommandsList commands;
             mtime_t bufferinglevel;
             mtime_t pcr;
             bool b_draining;
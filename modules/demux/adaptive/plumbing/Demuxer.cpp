@@ -38,6 +38,7 @@ AbstractDemuxer::AbstractDemuxer()
     b_reinitsonseek = true;
     b_candetectswitches = true;
     b_alwaysrestarts = false;
+    b_persistent = false;
 }
 
 AbstractDemuxer::~AbstractDemuxer()
@@ -60,6 +61,23 @@ bool AbstractDemuxer::needsRestartOnEachSegment() const
     return b_alwaysrestarts;
 }
 
+/* Persistent demuxers are not recreated on the restarts that are not caused
+ * by a format change, but fed the next segment with resume() */
+bool AbstractDemuxer::isPersistent() const
+{
+    return b_persistent;
+}
+
+bool AbstractDemuxer::resume()
+{
+    return false;
+}
+
+void AbstractDemuxer::setPersistent( bool b )
+{
+    b_persistent = b;
+}
+
 void AbstractDemuxer::setCanDetectSwitches( bool b )
 {
     b_candetectswitches = b;
@@ -130,6 +148,16 @@ void Demuxer::destroy()
     sourcestream->Reset();
 }
 
+bool Demuxer::resume()
+{
+    if(!p_demux)
+        return false;
+    /* Keep probing, ES and state, the source continues with next segment */
+    sourcestream->Reset();
+    b_eof = false;
+    return true;
+}
+
 void Demuxer::drain()
 {
     while(p_demux && demux_Demux(p_demux) == VLC_DEMUXER_SUCCESS);
@@ -36,18 +36,22 @@ namespace adaptive
             virtual void drain() = 0;
             virtual bool create() = 0;
             virtual void destroy() = 0;
+            virtual bool resume();
             bool alwaysStartsFromZero() const;
             bool needsRestartOnSeek() const;
             bool needsRestartOnSwitch() const;
             bool needsRestartOnEachSegment() const;
+            bool isPersistent() const;
             void setCanDetectSwitches(bool);
             void setRestartsOnEachSegment(bool);
+            void setPersistent(bool);
 
         protected:
             bool b_startsfromzero;
             bool b_reinitsonseek;
             bool b_alwaysrestarts;
             bool b_candetectswitches;
+            bool b_persistent;
     };
 
     class Demuxer : public AbstractDemuxer
@@ -59,6 +63,7 @@ namespace adaptive
             virtual void drain(); /* impl */
             virtual bool create(); /* impl */
             virtual void destroy(); /* impl */
+            virtual bool resume(); /* reimpl */
 
         protected:
             AbstractSourceStream *sourcestream;
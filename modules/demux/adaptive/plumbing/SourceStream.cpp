@@ -32,8 +32,7 @@
 using namespace adaptive;
 
 ChunksSourceStream::ChunksSourceStream(vlc_object_t *p_obj_, ChunksSource *source_)
-    : p_block( NULL )
-    , b_eof( false )
+    : b_eof( false )
     , p_obj( p_obj_ )
     , source( source_ )
 { }
@@ -45,9 +44,6 @@ ChunksSourceStream::~ChunksSourceStream()
 
 void ChunksSourceStream::Reset()
 {
-    if(p_block)
-        block_Release(p_block);
-    p_block = NULL;
     b_eof = false;
 }
 
@@ -57,7 +53,8 @@ stream_t * ChunksSourceStream::makeStream()
     if(p_stream)
     {
         p_stream->pf_control = control_Callback;
-        p_stream->pf_read = read_Callback;
+        /* Blocks are passed as is, stream core only copies on partial reads */
+        p_stream->pf_block = block_Callback;
         p_stream->pf_readdir = NULL;
         p_stream->pf_seek = seek_Callback;
         p_stream->p_sys = reinterpret_cast<stream_sys_t*>(this);
@@ -65,46 +62,34 @@ stream_t * ChunksSourceStream::makeStream()
     return p_stream;
 }
 
-ssize_t ChunksSourceStream::Read(uint8_t *buf, size_t size)
+block_t * ChunksSourceStream::ReadBlock()
 {
-    size_t i_copied = 0;
-    size_t i_toread = size;
-
-    while(i_toread && !b_eof)
+    block_t *p_block = NULL;
+    while(!b_eof && !p_block)
     {
-        if(!p_block && !(p_block = source->readNextBlock()))
+        if(!(p_block = source->readNextBlock()))
         {
             b_eof = true;
             break;
         }
 
-        if(p_block->i_buffer > i_toread)
-        {
-            if(buf)
-                memcpy(buf + i_copied, p_block->p_buffer, i_toread);
-            i_copied += i_toread;
-            p_block->p_buffer += i_toread;
-            p_block->i_buffer -= i_toread;
-            i_toread = 0;
-        }
-        else
+        if(p_block->i_buffer == 0)
         {
-            if(buf)
-                memcpy(buf + i_copied, p_block->p_buffer, p_block->i_buffer);
-            i_copied += p_block->i_buffer;
-            i_toread -= p_block->i_buffer;
             block_Release(p_block);
             p_block = NULL;
         }
     }
 
-    return i_copied;
+    return p_block;
 }
 
-ssize_t ChunksSourceStream::read_Callback(stream_t *s, void *buf, size_t size)
+block_t * ChunksSourceStream::block_Callback(stream_t *s, bool *eof)
 {
     ChunksSourceStream *me = reinterpret_cast<ChunksSourceStream *>(s->p_sys);
-    return me->Read(reinterpret_cast<uint8_t *>(buf), size);
+    block_t *p_block = me->ReadBlock();
+    if(!p_block)
+        *eof = true;
+    return p_block;
 }
 
 int ChunksSourceStream::seek_Callback(stream_t *, uint64_t)
@@ -44,12 +44,11 @@ namespace adaptive
             virtual void Reset(); /* impl */
 
         protected:
-            ssize_t Read(uint8_t *, size_t);
+            block_t *ReadBlock();
 
         private:
-            block_t *p_block;
             bool b_eof;
-            static ssize_t read_Callback(stream_t *, void *, size_t);
+            static block_t *block_Callback(stream_t *, bool *);
             static int seek_Callback(stream_t *, uint64_t);
             static int control_Callback( stream_t *, int i_query, va_list );
             static void delete_Callback( stream_t * );
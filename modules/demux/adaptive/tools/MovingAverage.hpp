@@ -20,23 +20,38 @@
 #ifndef MOVINGAVERAGE_HPP
 #define MOVINGAVERAGE_HPP
 
-#include <list>
-#include <algorithm>
+#include <vector>
+#include <exception>
 
 namespace adaptive
 {
-    template <class T>
-    class MovingAverageSum
+    /* Fixed size FIFO of window slots, used as monotonic queue
+     * for the window min/max */
+    class MovingAverageSlotQueue
     {
         public:
-            MovingAverageSum<T>(T i): sum(0), prev(i) { }
-            void operator()(T n) {
-                sum += (n > prev) ? n - prev : prev - n;
-                prev = n;
+            MovingAverageSlotQueue(unsigned size) : slots(size), first(0), last(0), count(0) { }
+            bool empty() const { return count == 0; }
+            unsigned front() const { return slots[first]; }
+            unsigned back() const { return slots[last]; }
+            void pop_front() { if(--count) first = next(first); }
+            void pop_back() { if(--count) last = prev(last); }
+            void push_back(unsigned slot)
+            {
+                if(count++)
+                    last = next(last);
+                else
+                    last = first;
+                slots[last] = slot;
             }
-            T sum;
+
         private:
-            T prev;
+            unsigned next(unsigned i) const { return (i + 1 == slots.size()) ? 0 : i + 1; }
+            unsigned prev(unsigned i) const { return i ? i - 1 : slots.size() - 1; }
+            std::vector<unsigned> slots;
+            unsigned first;
+            unsigned last;
+            unsigned count;
     };
 
     template <class T>
@@ -47,43 +62,71 @@ namespace adaptive
             T push(T);
 
         private:
-            std::list<T> values;
+            static T absdiff(T a, T b) { return (a > b) ? a - b : b - a; }
+            std::vector<T> values; /* ring buffer of observations */
+            MovingAverageSlotQueue minqueue;
+            MovingAverageSlotQueue maxqueue;
+            unsigned head; /* next slot to write */
+            unsigned count;
             T previous;
+            T diffsum;
             unsigned maxobs;
             T avg;
     };
 
     template <class T>
-    MovingAverage<T>::MovingAverage(unsigned nbobs) : avg(0)
+    MovingAverage<T>::MovingAverage(unsigned nbobs) : values(nbobs ? nbobs : 1),
+        minqueue(nbobs ? nbobs : 1), maxqueue(nbobs ? nbobs : 1), avg(0)
     {
         if(nbobs < 1)
             throw new std::exception();
         this->maxobs = nbobs;
         previous = 0;
+        diffsum = 0;
+        head = 0;
+        count = 0;
     }
 
     template <class T>
     T MovingAverage<T>::push(T v)
     {
-        if(values.size() >= maxobs)
+        if(count >= maxobs)
         {
-            previous = values.front();
-            values.pop_front();
+            /* drop oldest observation, which is in the slot we overwrite,
+             * and its diff to the previous one */
+            const T oldest = values[head];
+            diffsum -= absdiff(oldest, previous);
+            previous = oldest;
+            if(minqueue.front() == head)
+                minqueue.pop_front();
+            if(maxqueue.front() == head)
+                maxqueue.pop_front();
+            count--;
         }
-        values.push_back(v);
+
+        diffsum += absdiff(v, count ? values[head ? head - 1 : maxobs - 1] : previous);
+        values[head] = v;
+        count++;
+
+        while(!minqueue.empty() && values[minqueue.back()] >= v)
+            minqueue.pop_back();
+        minqueue.push_back(head);
+        while(!maxqueue.empty() && values[maxqueue.back()] <= v)
+            maxqueue.pop_back();
+        maxqueue.push_back(head);
+        if(++head == maxobs)
+            head = 0;
 
         /* compute for deltamax */
-        T omin = *std::min_element(values.begin(), values.end());
-        T omax = *std::max_element(values.begin(), values.end());
-        MovingAverageSum<T> diffsums = std::for_each(values.begin(), values.end(),
-                                                     MovingAverageSum<T>(previous));
+        const T omin = values[minqueue.front()];
+        const T omax = values[maxqueue.front()];
         /* Vertical Horizontal Filter / Moving Average
          *
          * stability during observation window alters the alpha parameter
          * and then defines how fast we adapt */
         const T deltamax = omax - omin;
-        double alpha = (diffsums.sum) ? 0.33 * ((double)deltamax / diffsums.sum) : 0.5;
-        avg = alpha * avg + (1.0 - alpha) * (*values.rbegin());
+        double alpha = (diffsum) ? 0.33 * ((double)deltamax / diffsum) : 0.5;
+        avg = alpha * avg + (1.0 - alpha) * v;
         return avg;
     }
 }
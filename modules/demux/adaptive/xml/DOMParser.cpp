@@ -108,7 +108,7 @@ Node* DOMParser::processNode(bool b_strict)
                         lifo.top()->addSubNode(node);
                     lifo.push(node);
 
-                    node->setName(std::string(data));
+                    node->setName(data);
                     addAttributesToNode(node);
                 }
 
@@ -160,11 +160,7 @@ void    DOMParser::addAttributesToNode      (Node *node)
     const char *attrName;
 
     while((attrName = xml_ReaderNextAttr(this->vlc_reader, &attrValue)) != NULL)
-    {
-        std::string key     = attrName;
-        std::string value   = attrValue;
-        node->addAttribute(key, value);
-    }
+        node->addAttribute(attrName, attrValue);
 }
 void    DOMParser::print                    (Node *node, int offset)
 {
@@ -64,33 +64,44 @@ void                                Node::setName               (const std::stri
 
 bool                                Node::hasAttribute        (const std::string& name) const
 {
-    if(this->attributes.find(name) != this->attributes.end())
-        return true;
-
+    Attributes::const_iterator it;
+    for(it = attributes.begin(); it != attributes.end(); ++it)
+    {
+        if((*it).name == name)
+            return true;
+    }
     return false;
 }
 const std::string&                  Node::getAttributeValue     (const std::string& key) const
 {
-    std::map<std::string, std::string>::const_iterator  it = this->attributes.find( key );
-
-    if ( it != this->attributes.end() )
-        return it->second;
+    Attributes::const_iterator it;
+    for(it = attributes.begin(); it != attributes.end(); ++it)
+    {
+        if((*it).name == key)
+            return (*it).value;
+    }
     return EmptyString;
 }
 
-void                                Node::addAttribute          ( const std::string& key, const std::string& value)
+void                                Node::addAttribute          (const char *key, const char *value)
 {
-    this->attributes[key] = value;
+    Attributes::iterator it;
+    for(it = attributes.begin(); it != attributes.end(); ++it)
+    {
+        if((*it).name == key)
+        {
+            (*it).value = value;
+            return;
+        }
+    }
+    attributes.push_back(Attribute(key, value));
 }
 std::vector<std::string>            Node::getAttributeKeys      () const
 {
     std::vector<std::string> keys;
-    std::map<std::string, std::string>::const_iterator it;
-
-    for(it = this->attributes.begin(); it != this->attributes.end(); ++it)
-    {
-        keys.push_back(it->first);
-    }
+    Attributes::const_iterator it;
+    for(it = attributes.begin(); it != attributes.end(); ++it)
+        keys.push_back((*it).name);
     return keys;
 }
 
@@ -104,7 +115,7 @@ void Node::setText(const std::string &text)
     this->text = text;
 }
 
-const std::map<std::string,std::string>&   Node::getAttributes         () const
+const Node::Attributes&                     Node::getAttributes         () const
 {
     return this->attributes;
 }
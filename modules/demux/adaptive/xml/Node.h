@@ -27,7 +27,6 @@
 
 #include <vector>
 #include <string>
-#include <map>
 
 namespace adaptive
 {
@@ -36,6 +35,16 @@ namespace adaptive
         class Node
         {
             public:
+                class Attribute
+                {
+                    public:
+                        Attribute(const char *name_, const char *value_) :
+                            name(name_), value(value_) {}
+                        std::string name;
+                        std::string value;
+                };
+                typedef std::vector<Attribute> Attributes;
+
                 Node            ();
                 virtual ~Node   ();
 
@@ -44,12 +53,12 @@ namespace adaptive
                 const std::string&                  getName             () const;
                 void                                setName             (const std::string& name);
                 bool                                hasAttribute        (const std::string& name) const;
-                void                                addAttribute        (const std::string& key, const std::string& value);
+                void                                addAttribute        (const char *key, const char *value);
                 const std::string&                  getAttributeValue   (const std::string& key) const;
                 std::vector<std::string>            getAttributeKeys    () const;
                 const std::string&                  getText             () const;
                 void                                setText( const std::string &text );
-                const std::map<std::string, std::string>& getAttributes () const;
+                const Attributes&                   getAttributes       () const;
                 int                                 getType() const;
                 void                                setType( int type );
                 std::vector<std::string>            toString(int) const;
@@ -57,7 +66,9 @@ namespace adaptive
             private:
                 static const std::string            EmptyString;
                 std::vector<Node *>                 subNodes;
-                std::map<std::string, std::string>  attributes;
+                /* elements only have a few attributes, a flat list
+                   is cheaper to build and search than a map */
+                Attributes                          attributes;
                 std::string                         name;
                 std::string                         text;
                 int                                 type;
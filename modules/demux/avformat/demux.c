@@ -79,7 +79,10 @@ struct demux_sys_t
     input_title_t *p_title;
 };
 
-#define AVFORMAT_IOBUFFER_SIZE 32768  /* FIXME */
+/* Reads block until the I/O buffer is filled: keep it small for streams, so
+ * as not to delay the packets, and larger where seeking is fast (files) */
+#define AVFORMAT_IOBUFFER_SIZE      32768
+#define AVFORMAT_IOBUFFER_FAST_SIZE (256 * 1024)
 
 /*****************************************************************************
  * Local prototypes
@@ -156,6 +159,7 @@ int avformat_OpenDemux( vlc_object_t *p_this )
     AVInputFormat *fmt = NULL;
     int64_t       i_start_time = -1;
     bool          b_can_seek;
+    bool          b_fast_seek;
     char         *psz_url;
     const uint8_t *peek;
     int           error;
@@ -190,6 +194,8 @@ int avformat_OpenDemux( vlc_object_t *p_this )
     pd.filename = psz_url;
 
     vlc_stream_Control( p_demux->s, STREAM_CAN_SEEK, &b_can_seek );
+    if( vlc_stream_Control( p_demux->s, STREAM_CAN_FASTSEEK, &b_fast_seek ) )
+        b_fast_seek = false;
 
     vlc_init_avformat(p_this);
 
@@ -284,7 +290,9 @@ int avformat_OpenDemux( vlc_object_t *p_this )
     p_sys->p_title = NULL;
 
     /* Create I/O wrapper */
-    unsigned char * p_io_buffer = av_malloc( AVFORMAT_IOBUFFER_SIZE );
+    const int i_io_buffer = b_fast_seek ? AVFORMAT_IOBUFFER_FAST_SIZE
+                                        : AVFORMAT_IOBUFFER_SIZE;
+    unsigned char * p_io_buffer = av_malloc( i_io_buffer );
     if( !p_io_buffer )
     {
         free( psz_url );
@@ -302,7 +310,7 @@ int avformat_OpenDemux( vlc_object_t *p_this )
     }
 
     AVIOContext *pb = p_sys->ic->pb = avio_alloc_context( p_io_buffer,
-        AVFORMAT_IOBUFFER_SIZE, 0, p_demux, IORead, NULL, IOSeek );
+        i_io_buffer, 0, p_demux, IORead, NULL, IOSeek );
     if( !pb )
     {
         av_free( p_io_buffer );
@@ -727,6 +735,42 @@ void avformat_CloseDemux( vlc_object_t *p_this )
 /*****************************************************************************
  * Demux:
  *****************************************************************************/
+typedef struct
+{
+    block_t self;
+    AVPacket packet;
+} vlc_av_packet_t;
+
+static void vlc_av_packet_Release( block_t *p_block )
+{
+    vlc_av_packet_t *b = (void *)p_block;
+
+    av_packet_unref( &b->packet );
+    free( b );
+}
+
+/* Wraps the payload of a packet in a block. The payload is shared with a new
+ * reference, it is only copied if the packet is not reference counted. */
+static block_t *vlc_av_packet_Wrap( AVPacket *p_pkt )
+{
+    vlc_av_packet_t *b = malloc( sizeof( *b ) );
+    if( unlikely(b == NULL) )
+        return NULL;
+
+    av_init_packet( &b->packet );
+    if( av_packet_ref( &b->packet, p_pkt ) )
+    {
+        free( b );
+        return NULL;
+    }
+
+    block_t *p_block = &b->self;
+
+    block_Init( p_block, b->packet.data, b->packet.size );
+    p_block->pf_release = vlc_av_packet_Release;
+    return p_block;
+}
+
 static int Demux( demux_t *p_demux )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
@@ -781,12 +825,11 @@ static int Demux( demux_t *p_demux )
     }
     else
     {
-        if( ( p_frame = block_Alloc( pkt.size ) ) == NULL )
+        if( ( p_frame = vlc_av_packet_Wrap( &pkt ) ) == NULL )
         {
             av_packet_unref( &pkt );
             return 0;
         }
-        memcpy( p_frame->p_buffer, pkt.data, pkt.size );
     }
 
     if( pkt.flags & AV_PKT_FLAG_KEY )
@@ -38,6 +38,7 @@
 #include <vlc_input.h>
 
 #include <vlc_dialog.h>
+#include <vlc_atomic.h>
 
 #include <vlc_meta.h>
 #include <vlc_codecs.h>
@@ -58,6 +59,11 @@
     "Recreate a index for the AVI file. Use this if your AVI file is damaged "\
     "or incomplete (not seekable)." )
 
+#define INDEX_BACKGROUND_TEXT N_("Create the index in the background")
+#define INDEX_BACKGROUND_LONGTEXT N_( \
+    "Start playing right away when the index must be created, and build it " \
+    "in the background. Seeking uses the part already built." )
+
 #define BI_RAWRGB 0x00
 #define BI_RGBBITFIELDS 0x03
 
@@ -83,6 +89,8 @@ vlc_module_begin ()
     add_integer( "avi-index", 0,
               INDEX_TEXT, INDEX_LONGTEXT, false )
         change_integer_list( pi_index, ppsz_indexes )
+    add_bool( "avi-index-background", true,
+              INDEX_BACKGROUND_TEXT, INDEX_BACKGROUND_LONGTEXT, true )
 
     set_callbacks( Open, Close )
 vlc_module_end ()
@@ -172,6 +180,17 @@ typedef struct
 
 } avi_track_t;
 
+typedef struct
+{
+    vlc_thread_t thread;
+    vlc_mutex_t  lock;
+    stream_t     *s;
+    atomic_bool  b_abort;
+    bool         b_done;
+    off_t        i_last_pos;
+    avi_index_t  p_index[]; /* one per track */
+} avi_index_builder_t;
+
 struct demux_sys_t
 {
     mtime_t i_time;
@@ -199,6 +218,9 @@ struct demux_sys_t
 
     unsigned int       i_attachment;
     input_attachment_t **attachment;
+
+    /* index built in the background */
+    avi_index_builder_t *p_builder;
 };
 
 static inline off_t __EVEN( off_t i )
@@ -221,12 +243,15 @@ static int AVI_StreamBytesSet ( demux_t *,
 vlc_fourcc_t AVI_FourccGetCodec( unsigned int i_cat, vlc_fourcc_t );
 static int   AVI_GetKeyFlag    ( vlc_fourcc_t , uint8_t * );
 
-static int AVI_PacketGetHeader( demux_t *, avi_packet_t *p_pk );
-static int AVI_PacketNext     ( demux_t * );
-static int AVI_PacketSearch   ( demux_t * );
+static int AVI_PacketGetHeader( stream_t *, avi_packet_t *p_pk );
+static int AVI_PacketNext     ( stream_t * );
+static int AVI_PacketSearch   ( demux_t *, stream_t * );
 
 static void AVI_IndexLoad    ( demux_t * );
 static void AVI_IndexCreate  ( demux_t * );
+static int  AVI_IndexBuildStart( demux_t * );
+static void AVI_IndexBuildStop ( demux_t * );
+static void AVI_IndexBuildAdopt( demux_t * );
 
 static void AVI_ExtractSubtitle( demux_t *, unsigned int i_stream, avi_chunk_list_t *, avi_chunk_STRING_t * );
 
@@ -262,6 +287,8 @@ static void Close ( vlc_object_t * p_this )
     demux_t *    p_demux = (demux_t *)p_this;
     demux_sys_t *p_sys = p_demux->p_sys  ;
 
+    AVI_IndexBuildStop( p_demux );
+
     for( unsigned int i = 0; i < p_sys->i_track; i++ )
     {
         if( p_sys->track[i] )
@@ -292,7 +319,7 @@ static int Open( vlc_object_t * p_this )
     demux_t  *p_demux = (demux_t *)p_this;
     demux_sys_t     *p_sys;
 
-    bool       b_index = false, b_aborted = false;
+    bool       b_index = false, b_aborted = false, b_background;
     int              i_do_index;
 
     avi_chunk_list_t    *p_riff;
@@ -751,16 +778,21 @@ static int Open( vlc_object_t * p_this )
     }
 
     i_do_index = var_InheritInteger( p_demux, "avi-index" );
+    b_background = var_InheritBool( p_demux, "avi-index-background" );
     if( i_do_index == 1 ) /* Always fix */
     {
 aviindex:
         if( p_sys->b_fastseekable )
         {
-            AVI_IndexCreate( p_demux );
+            if( !b_background || AVI_IndexBuildStart( p_demux ) )
+                AVI_IndexCreate( p_demux );
         }
         else if( p_sys->b_seekable )
         {
-            AVI_IndexLoad( p_demux );
+            /* A broken index is rebuilt from a second stream, if the access
+             * can be opened twice */
+            if( !b_index || !b_background || AVI_IndexBuildStart( p_demux ) )
+                AVI_IndexLoad( p_demux );
         }
         else
         {
@@ -796,7 +828,7 @@ aviindex:
                 b_index = true;
                 goto aviindex;
             }
-            if( i_do_index == 0 )
+            if( i_do_index == 0 && !b_background )
             {
                 const char *psz_msg = _(
                     "Because this file index is broken or missing, "
@@ -1136,7 +1168,7 @@ static int Demux_Seekable( demux_t *p_demux )
             if( p_sys->b_seekable && p_sys->i_movi_lastchunk_pos >= p_sys->i_movi_begin + 12 )
             {
                 vlc_stream_Seek( p_demux->s, p_sys->i_movi_lastchunk_pos );
-                if( AVI_PacketNext( p_demux ) )
+                if( AVI_PacketNext( p_demux->s ) )
                 {
                     return( AVI_TrackStopFinishedStreams( p_demux ) ? 0 : 1 );
                 }
@@ -1150,7 +1182,7 @@ static int Demux_Seekable( demux_t *p_demux )
             {
                 avi_packet_t avi_pk;
 
-                if( AVI_PacketGetHeader( p_demux, &avi_pk ) )
+                if( AVI_PacketGetHeader( p_demux->s, &avi_pk ) )
                 {
                     msg_Warn( p_demux,
                              "cannot get packet header, track disabled" );
@@ -1159,7 +1191,7 @@ static int Demux_Seekable( demux_t *p_demux )
                 if( avi_pk.i_stream >= p_sys->i_track ||
                     ( avi_pk.i_cat != AUDIO_ES && avi_pk.i_cat != VIDEO_ES ) )
                 {
-                    if( AVI_PacketNext( p_demux ) )
+                    if( AVI_PacketNext( p_demux->s ) )
                     {
                         msg_Warn( p_demux,
                                   "cannot skip packet, track disabled" );
@@ -1200,7 +1232,7 @@ static int Demux_Seekable( demux_t *p_demux )
                     }
                     else
                     {
-                        if( AVI_PacketNext( p_demux ) )
+                        if( AVI_PacketNext( p_demux->s ) )
                         {
                             msg_Warn( p_demux,
                                       "cannot skip packet, track disabled" );
@@ -1401,7 +1433,7 @@ static int Demux_UnSeekable( demux_t *p_demux )
 
         avi_packet_t    avi_pk;
 
-        if( AVI_PacketGetHeader( p_demux, &avi_pk ) )
+        if( AVI_PacketGetHeader( p_demux->s, &avi_pk ) )
         {
             return VLC_DEMUXER_EOF;
         }
@@ -1418,18 +1450,18 @@ static int Demux_UnSeekable( demux_t *p_demux )
                 case AVIFOURCC_JUNK:
                 case AVIFOURCC_LIST:
                 case AVIFOURCC_RIFF:
-                    return( !AVI_PacketNext( p_demux ) ? 1 : 0 );
+                    return( !AVI_PacketNext( p_demux->s ) ? 1 : 0 );
                 case AVIFOURCC_idx1:
                     if( p_sys->b_odml )
                     {
-                        return( !AVI_PacketNext( p_demux ) ? 1 : 0 );
+                        return( !AVI_PacketNext( p_demux->s ) ? 1 : 0 );
                     }
                     return VLC_DEMUXER_EOF;
                 default:
                     msg_Warn( p_demux,
                               "seems to have lost position @%"PRIu64", resync",
                               vlc_stream_Tell(p_demux->s) );
-                    if( AVI_PacketSearch( p_demux ) )
+                    if( AVI_PacketSearch( p_demux, p_demux->s ) )
                     {
                         msg_Err( p_demux, "resync failed" );
                         return VLC_DEMUXER_EGENERIC;
@@ -1469,7 +1501,7 @@ static int Demux_UnSeekable( demux_t *p_demux )
             }
             else
             {
-                if( AVI_PacketNext( p_demux ) )
+                if( AVI_PacketNext( p_demux->s ) )
                 {
                     return VLC_DEMUXER_EOF;
                 }
@@ -1509,6 +1541,9 @@ static int Seek( demux_t *p_demux, mtime_t i_date, int i_percent, bool b_accurat
     {
         int64_t i_pos_backup = vlc_stream_Tell( p_demux->s );
 
+        /* Use the part of the index built in the background so far */
+        AVI_IndexBuildAdopt( p_demux );
+
         /* Check and lazy load indexes if it was not done (not fastseekable) */
         if ( !p_sys->b_indexloaded && ( p_sys->i_avih_flags & AVIF_HASINDEX ) )
         {
@@ -1864,7 +1899,7 @@ static int AVI_StreamChunkFind( demux_t *p_demux, unsigned int i_stream )
     if( p_sys->i_movi_lastchunk_pos >= p_sys->i_movi_begin + 12 )
     {
         vlc_stream_Seek( p_demux->s, p_sys->i_movi_lastchunk_pos );
-        if( AVI_PacketNext( p_demux ) )
+        if( AVI_PacketNext( p_demux->s ) )
         {
             return VLC_EGENERIC;
         }
@@ -1876,7 +1911,7 @@ static int AVI_StreamChunkFind( demux_t *p_demux, unsigned int i_stream )
 
     for( ;; )
     {
-        if( AVI_PacketGetHeader( p_demux, &avi_pk ) )
+        if( AVI_PacketGetHeader( p_demux->s, &avi_pk ) )
         {
             msg_Warn( p_demux, "cannot get packet header" );
             return VLC_EGENERIC;
@@ -1884,7 +1919,7 @@ static int AVI_StreamChunkFind( demux_t *p_demux, unsigned int i_stream )
         if( avi_pk.i_stream >= p_sys->i_track ||
             ( avi_pk.i_cat != AUDIO_ES && avi_pk.i_cat != VIDEO_ES ) )
         {
-            if( AVI_PacketNext( p_demux ) )
+            if( AVI_PacketNext( p_demux->s ) )
             {
                 return VLC_EGENERIC;
             }
@@ -1918,7 +1953,7 @@ static int AVI_StreamChunkFind( demux_t *p_demux, unsigned int i_stream )
                 return VLC_SUCCESS;
             }
 
-            if( AVI_PacketNext( p_demux ) )
+            if( AVI_PacketNext( p_demux->s ) )
             {
                 return VLC_EGENERIC;
             }
@@ -2215,17 +2250,17 @@ static void AVI_ParseStreamHeader( vlc_fourcc_t i_id,
 /****************************************************************************
  *
  ****************************************************************************/
-static int AVI_PacketGetHeader( demux_t *p_demux, avi_packet_t *p_pk )
+static int AVI_PacketGetHeader( stream_t *s, avi_packet_t *p_pk )
 {
     const uint8_t *p_peek;
 
-    if( vlc_stream_Peek( p_demux->s, &p_peek, 16 ) < 16 )
+    if( vlc_stream_Peek( s, &p_peek, 16 ) < 16 )
     {
         return VLC_EGENERIC;
     }
     p_pk->i_fourcc  = VLC_FOURCC( p_peek[0], p_peek[1], p_peek[2], p_peek[3] );
     p_pk->i_size    = GetDWLE( p_peek + 4 );
-    p_pk->i_pos     = vlc_stream_Tell( p_demux->s );
+    p_pk->i_pos     = vlc_stream_Tell( s );
     if( p_pk->i_fourcc == AVIFOURCC_LIST || p_pk->i_fourcc == AVIFOURCC_RIFF )
     {
         p_pk->i_type = VLC_FOURCC( p_peek[8],  p_peek[9],
@@ -2242,12 +2277,12 @@ static int AVI_PacketGetHeader( demux_t *p_demux, avi_packet_t *p_pk )
     return VLC_SUCCESS;
 }
 
-static int AVI_PacketNext( demux_t *p_demux )
+static int AVI_PacketNext( stream_t *s )
 {
     avi_packet_t    avi_ck;
     size_t          i_skip = 0;
 
-    if( AVI_PacketGetHeader( p_demux, &avi_ck ) )
+    if( AVI_PacketGetHeader( s, &avi_ck ) )
     {
         return VLC_EGENERIC;
     }
@@ -2272,7 +2307,7 @@ static int AVI_PacketNext( demux_t *p_demux )
     if( i_skip > SSIZE_MAX )
         return VLC_EGENERIC;
 
-    ssize_t i_ret = vlc_stream_Read( p_demux->s, NULL, i_skip );
+    ssize_t i_ret = vlc_stream_Read( s, NULL, i_skip );
     if( i_ret < 0 || (size_t) i_ret != i_skip )
     {
         return VLC_EGENERIC;
@@ -2280,7 +2315,7 @@ static int AVI_PacketNext( demux_t *p_demux )
     return VLC_SUCCESS;
 }
 
-static int AVI_PacketSearch( demux_t *p_demux )
+static int AVI_PacketSearch( demux_t *p_demux, stream_t *s )
 {
     demux_sys_t     *p_sys = p_demux->p_sys;
     avi_packet_t    avi_pk;
@@ -2288,11 +2323,11 @@ static int AVI_PacketSearch( demux_t *p_demux )
 
     for( ;; )
     {
-        if( vlc_stream_Read( p_demux->s, NULL, 1 ) != 1 )
+        if( vlc_stream_Read( s, NULL, 1 ) != 1 )
         {
             return VLC_EGENERIC;
         }
-        AVI_PacketGetHeader( p_demux, &avi_pk );
+        AVI_PacketGetHeader( s, &avi_pk );
         if( avi_pk.i_stream < p_sys->i_track &&
             ( avi_pk.i_cat == AUDIO_ES || avi_pk.i_cat == VIDEO_ES ) )
         {
@@ -2641,68 +2676,24 @@ static void AVI_IndexLoad( demux_t *p_demux )
     }
 }
 
-static void AVI_IndexCreate( demux_t *p_demux )
+/* Scans the chunks of the movi list from the current position of the stream
+ * and appends them to the indexes, until pf_stop returns true */
+static void AVI_IndexScan( demux_t *p_demux, stream_t *s,
+                           avi_index_t **pp_index, off_t *pi_last_pos,
+                           off_t i_movi_end, vlc_mutex_t *p_lock,
+                           bool (*pf_stop)( demux_t *, void * ), void *opaque )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
 
-    avi_chunk_list_t *p_riff;
-    avi_chunk_list_t *p_movi;
-
-    unsigned int i_stream;
-    off_t i_movi_end;
-
-    mtime_t i_dialog_update;
-    vlc_dialog_id *p_dialog_id = NULL;
-
-    p_riff = AVI_ChunkFind( &p_sys->ck_root, AVIFOURCC_RIFF, 0);
-    p_movi = AVI_ChunkFind( p_riff, AVIFOURCC_movi, 0);
-
-    if( !p_movi )
-    {
-        msg_Err( p_demux, "cannot find p_movi" );
-        return;
-    }
-
-    for( i_stream = 0; i_stream < p_sys->i_track; i_stream++ )
-        avi_index_Init( &p_sys->track[i_stream]->idx );
-
-    i_movi_end = __MIN( (off_t)(p_movi->i_chunk_pos + p_movi->i_chunk_size),
-                        stream_Size( p_demux->s ) );
-
-    vlc_stream_Seek( p_demux->s, p_movi->i_chunk_pos + 12 );
-    msg_Warn( p_demux, "creating index from LIST-movi, will take time !" );
-
-
-    /* Only show dialog if AVI is > 10MB */
-    i_dialog_update = mdate();
-    if( stream_Size( p_demux->s ) > 10000000 )
-    {
-        p_dialog_id =
-            vlc_dialog_display_progress( p_demux, false, 0.0, _("Cancel"),
-                                         _("Broken or missing AVI Index"),
-                                         _("Fixing AVI Index...") );
-    }
-
     for( ;; )
     {
         avi_packet_t pk;
 
-        /* Don't update/check dialog too often */
-        if( p_dialog_id != NULL && mdate() - i_dialog_update > 100000 )
-        {
-            if( vlc_dialog_is_cancelled( p_demux, p_dialog_id ) )
-                break;
-
-            double f_current = vlc_stream_Tell( p_demux->s );
-            double f_size    = stream_Size( p_demux->s );
-            double f_pos     = f_current / f_size;
-            vlc_dialog_update_progress( p_demux, p_dialog_id, f_pos );
-
-            i_dialog_update = mdate();
-        }
+        if( pf_stop( p_demux, opaque ) )
+            return;
 
-        if( AVI_PacketGetHeader( p_demux, &pk ) )
-            break;
+        if( AVI_PacketGetHeader( s, &pk ) )
+            return;
 
         if( pk.i_stream < p_sys->i_track &&
             pk.i_cat == p_sys->track[pk.i_stream]->fmt.i_cat )
@@ -2715,7 +2706,11 @@ static void AVI_IndexCreate( demux_t *p_demux )
             index.i_pos     = pk.i_pos;
             index.i_length  = pk.i_size;
             index.i_lengthtotal = pk.i_size;
-            avi_index_Append( &tk->idx, &p_sys->i_movi_lastchunk_pos, &index );
+            if( p_lock != NULL )
+                vlc_mutex_lock( p_lock );
+            avi_index_Append( pp_index[pk.i_stream], pi_last_pos, &index );
+            if( p_lock != NULL )
+                vlc_mutex_unlock( p_lock );
         }
         else
         {
@@ -2729,12 +2724,11 @@ static void AVI_IndexCreate( demux_t *p_demux )
                                             AVIFOURCC_RIFF, 1 );
 
                     msg_Dbg( p_demux, "looking for new RIFF chunk" );
-                    if( vlc_stream_Seek( p_demux->s,
-                                         p_sysx->i_chunk_pos + 24 ) )
-                        goto print_stat;
+                    if( vlc_stream_Seek( s, p_sysx->i_chunk_pos + 24 ) )
+                        return;
                     break;
                 }
-                goto print_stat;
+                return;
 
             case AVIFOURCC_RIFF:
                     msg_Dbg( p_demux, "new RIFF chunk found" );
@@ -2746,24 +2740,111 @@ static void AVI_IndexCreate( demux_t *p_demux )
 
             default:
                 msg_Warn( p_demux, "need resync, probably broken avi" );
-                if( AVI_PacketSearch( p_demux ) )
+                if( AVI_PacketSearch( p_demux, s ) )
                 {
                     msg_Warn( p_demux, "lost sync, abord index creation" );
-                    goto print_stat;
+                    return;
                 }
             }
         }
 
         if( ( !p_sys->b_odml && pk.i_pos + pk.i_size >= i_movi_end ) ||
-            AVI_PacketNext( p_demux ) )
+            AVI_PacketNext( s ) )
         {
-            break;
+            return;
         }
     }
+}
+
+static off_t AVI_IndexMoviEnd( demux_t *p_demux, stream_t *s,
+                               avi_chunk_list_t **pp_movi )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    avi_chunk_list_t *p_riff = AVI_ChunkFind( &p_sys->ck_root,
+                                              AVIFOURCC_RIFF, 0);
+    avi_chunk_list_t *p_movi = AVI_ChunkFind( p_riff, AVIFOURCC_movi, 0);
+
+    *pp_movi = p_movi;
+    if( !p_movi )
+        return -1;
+    return __MIN( (off_t)(p_movi->i_chunk_pos + p_movi->i_chunk_size),
+                  stream_Size( s ) );
+}
+
+struct avi_index_dialog
+{
+    vlc_dialog_id *p_id;
+    mtime_t i_update;
+};
+
+static bool AVI_IndexCreateStop( demux_t *p_demux, void *opaque )
+{
+    struct avi_index_dialog *p_dialog = opaque;
+
+    /* Don't update/check dialog too often */
+    if( p_dialog->p_id != NULL && mdate() - p_dialog->i_update > 100000 )
+    {
+        if( vlc_dialog_is_cancelled( p_demux, p_dialog->p_id ) )
+            return true;
+
+        double f_current = vlc_stream_Tell( p_demux->s );
+        double f_size    = stream_Size( p_demux->s );
+        double f_pos     = f_current / f_size;
+        vlc_dialog_update_progress( p_demux, p_dialog->p_id, f_pos );
+
+        p_dialog->i_update = mdate();
+    }
+    return false;
+}
+
+static void AVI_IndexCreate( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    avi_chunk_list_t *p_movi;
+    unsigned int i_stream;
+    off_t i_movi_end;
+
+    struct avi_index_dialog dialog = { NULL, 0 };
+
+    i_movi_end = AVI_IndexMoviEnd( p_demux, p_demux->s, &p_movi );
+    if( !p_movi )
+    {
+        msg_Err( p_demux, "cannot find p_movi" );
+        return;
+    }
+
+    avi_index_t *pp_index[p_sys->i_track];
+    for( i_stream = 0; i_stream < p_sys->i_track; i_stream++ )
+    {
+        avi_index_Init( &p_sys->track[i_stream]->idx );
+        pp_index[i_stream] = &p_sys->track[i_stream]->idx;
+    }
+
+    if( vlc_stream_Seek( p_demux->s, p_movi->i_chunk_pos + 12 ) )
+    {
+        msg_Err( p_demux, "cannot seek to the LIST-movi" );
+        return;
+    }
+    msg_Warn( p_demux, "creating index from LIST-movi, will take time !" );
+
+
+    /* Only show dialog if AVI is > 10MB */
+    dialog.i_update = mdate();
+    if( stream_Size( p_demux->s ) > 10000000 )
+    {
+        dialog.p_id =
+            vlc_dialog_display_progress( p_demux, false, 0.0, _("Cancel"),
+                                         _("Broken or missing AVI Index"),
+                                         _("Fixing AVI Index...") );
+    }
+
+    AVI_IndexScan( p_demux, p_demux->s, pp_index,
+                   &p_sys->i_movi_lastchunk_pos, i_movi_end, NULL,
+                   AVI_IndexCreateStop, &dialog );
 
-print_stat:
-    if( p_dialog_id != NULL )
-        vlc_dialog_release( p_demux, p_dialog_id );
+    if( dialog.p_id != NULL )
+        vlc_dialog_release( p_demux, dialog.p_id );
 
     for( i_stream = 0; i_stream < p_sys->i_track; i_stream++ )
     {
@@ -2772,6 +2853,178 @@ print_stat:
     }
 }
 
+/*****************************************************************************
+ * Background index creation: the file is played forward while the index is
+ * built from a second stream. The seeks use the part of the index already
+ * built.
+ *****************************************************************************/
+static bool AVI_IndexBuildAborted( demux_t *p_demux, void *opaque )
+{
+    avi_index_builder_t *p_builder = opaque;
+
+    (void) p_demux;
+    return atomic_load( &p_builder->b_abort );
+}
+
+static void *AVI_IndexBuildThread( void *data )
+{
+    demux_t *p_demux = data;
+    demux_sys_t *p_sys = p_demux->p_sys;
+    avi_index_builder_t *p_builder = p_sys->p_builder;
+    avi_chunk_list_t *p_movi;
+
+    off_t i_movi_end = AVI_IndexMoviEnd( p_demux, p_builder->s, &p_movi );
+    if( p_movi != NULL &&
+        !vlc_stream_Seek( p_builder->s, p_movi->i_chunk_pos + 12 ) )
+    {
+        avi_index_t *pp_index[p_sys->i_track];
+        for( unsigned i = 0; i < p_sys->i_track; i++ )
+            pp_index[i] = &p_builder->p_index[i];
+
+        AVI_IndexScan( p_demux, p_builder->s, pp_index,
+                       &p_builder->i_last_pos, i_movi_end, &p_builder->lock,
+                       AVI_IndexBuildAborted, p_builder );
+    }
+
+    vlc_mutex_lock( &p_builder->lock );
+    p_builder->b_done = true;
+    vlc_mutex_unlock( &p_builder->lock );
+    msg_Dbg( p_demux, "index built in the background" );
+    return NULL;
+}
+
+static int AVI_IndexBuildStart( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    char *psz_url;
+
+    if( p_demux->psz_access == NULL || p_demux->psz_location == NULL ||
+        asprintf( &psz_url, "%s://%s", p_demux->psz_access,
+                  p_demux->psz_location ) == -1 )
+        return VLC_EGENERIC;
+
+    avi_index_builder_t *p_builder = malloc( sizeof( *p_builder ) +
+                                 p_sys->i_track * sizeof( avi_index_t ) );
+    if( unlikely(p_builder == NULL) )
+    {
+        free( psz_url );
+        return VLC_ENOMEM;
+    }
+
+    p_builder->s = vlc_stream_NewURL( p_demux, psz_url );
+    free( psz_url );
+    if( p_builder->s == NULL )
+    {
+        free( p_builder );
+        return VLC_EGENERIC;
+    }
+
+    vlc_mutex_init( &p_builder->lock );
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+        avi_index_Init( &p_builder->p_index[i] );
+    p_builder->i_last_pos = 0;
+    p_builder->b_done = false;
+    atomic_init( &p_builder->b_abort, false );
+
+    /* Play from the beginning of the movi list, indexing on the fly until
+     * the index built in the background is adopted */
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+    {
+        avi_index_Clean( &p_sys->track[i]->idx );
+        avi_index_Init( &p_sys->track[i]->idx );
+    }
+    p_sys->i_movi_lastchunk_pos = 0;
+    p_sys->b_indexloaded = true;
+
+    p_sys->p_builder = p_builder;
+    if( vlc_clone( &p_builder->thread, AVI_IndexBuildThread, p_demux,
+                   VLC_THREAD_PRIORITY_LOW ) )
+    {
+        p_sys->p_builder = NULL;
+        vlc_mutex_destroy( &p_builder->lock );
+        vlc_stream_Delete( p_builder->s );
+        free( p_builder );
+        return VLC_EGENERIC;
+    }
+    msg_Dbg( p_demux, "building the index in the background" );
+    return VLC_SUCCESS;
+}
+
+static void AVI_IndexBuildStop( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    avi_index_builder_t *p_builder = p_sys->p_builder;
+
+    if( p_builder == NULL )
+        return;
+
+    atomic_store( &p_builder->b_abort, true );
+    vlc_join( p_builder->thread, NULL );
+    vlc_stream_Delete( p_builder->s );
+    vlc_mutex_destroy( &p_builder->lock );
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+        avi_index_Clean( &p_builder->p_index[i] );
+    free( p_builder );
+    p_sys->p_builder = NULL;
+}
+
+/* Takes the index built in the background if it goes further than the one
+ * built while playing. Both list the same chunks from the beginning of the
+ * movi list, so that the current positions remain valid. */
+static void AVI_IndexBuildAdopt( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    avi_index_builder_t *p_builder = p_sys->p_builder;
+
+    if( p_builder == NULL )
+        return;
+
+    vlc_mutex_lock( &p_builder->lock );
+    bool b_done = p_builder->b_done;
+    bool b_adopt = p_builder->i_last_pos > p_sys->i_movi_lastchunk_pos;
+
+    /* All the tracks or none */
+    for( unsigned i = 0; b_adopt && i < p_sys->i_track; i++ )
+    {
+        avi_index_t *p_src = &p_builder->p_index[i];
+        avi_index_t *p_dst = &p_sys->track[i]->idx;
+
+        if( p_src->i_size > p_dst->i_max )
+        {
+            avi_entry_t *p_entry = realloc( p_dst->p_entry,
+                                p_src->i_max * sizeof( *p_entry ) );
+            if( unlikely(p_entry == NULL) )
+                b_adopt = false;
+            else
+            {
+                p_dst->p_entry = p_entry;
+                p_dst->i_max = p_src->i_max;
+            }
+        }
+    }
+
+    if( b_adopt )
+    {
+        for( unsigned i = 0; i < p_sys->i_track; i++ )
+        {
+            avi_index_t *p_src = &p_builder->p_index[i];
+            avi_index_t *p_dst = &p_sys->track[i]->idx;
+
+            memcpy( p_dst->p_entry, p_src->p_entry,
+                    p_src->i_size * sizeof( *p_src->p_entry ) );
+            p_dst->i_size = p_src->i_size;
+        }
+        p_sys->i_movi_lastchunk_pos = p_builder->i_last_pos;
+    }
+    vlc_mutex_unlock( &p_builder->lock );
+
+    if( b_done )
+    {
+        AVI_IndexBuildStop( p_demux );
+        p_sys->i_length = AVI_MovieGetLength( p_demux );
+    }
+}
+
 /* */
 static void AVI_MetaLoad( demux_t *p_demux,
                           avi_chunk_list_t *p_riff, avi_chunk_avih_t *p_avih )
@@ -56,6 +56,8 @@ DASHManager::DASHManager(demux_t *demux_,
                          AbstractAdaptationLogic::LogicType type) :
              PlaylistManager(demux_, auth, mpd, factory, type)
 {
+    /* Parsing large MPD must not stall the buffering */
+    updater.b_enabled = true;
 }
 
 DASHManager::~DASHManager   ()
@@ -101,50 +103,60 @@ bool DASHManager::updatePlaylist()
     /* do update */
     if(nextPlaylistupdate)
     {
-        std::string url(p_demux->psz_access);
-        url.append("://");
-        url.append(p_demux->psz_location);
-
-        block_t *p_block = Retrieve::HTTP(VLC_OBJECT(p_demux), authStorage, url);
-        if(!p_block)
+        AbstractPlaylist *newmpd = fetchPlaylist();
+        if(!newmpd)
             return false;
+        mergePlaylist(newmpd);
+        delete newmpd;
+    }
 
-        stream_t *mpdstream = vlc_stream_MemoryNew(p_demux, p_block->p_buffer, p_block->i_buffer, true);
-        if(!mpdstream)
-        {
-            block_Release(p_block);
-            return false;
-        }
+    return true;
+}
 
-        xml::DOMParser parser(mpdstream);
-        if(!parser.parse(true))
-        {
-            vlc_stream_Delete(mpdstream);
-            block_Release(p_block);
-            return false;
-        }
+/* Runs on the updater thread: must not touch the current playlist */
+AbstractPlaylist * DASHManager::fetchPlaylist()
+{
+    std::string url(p_demux->psz_access);
+    url.append("://");
+    url.append(p_demux->psz_location);
 
-        mtime_t minsegmentTime = 0;
-        std::vector<AbstractStream *>::iterator it;
-        for(it=streams.begin(); it!=streams.end(); it++)
-        {
-            mtime_t segmentTime = (*it)->getPlaybackTime();
-            if(!minsegmentTime || segmentTime < minsegmentTime)
-                minsegmentTime = segmentTime;
-        }
+    block_t *p_block = Retrieve::HTTP(VLC_OBJECT(p_demux), authStorage, url);
+    if(!p_block)
+        return NULL;
 
+    stream_t *mpdstream = vlc_stream_MemoryNew(p_demux, p_block->p_buffer, p_block->i_buffer, true);
+    if(!mpdstream)
+    {
+        block_Release(p_block);
+        return NULL;
+    }
+
+    MPD *newmpd = NULL;
+    xml::DOMParser parser(mpdstream);
+    if(parser.parse(true))
+    {
         IsoffMainParser mpdparser(parser.getRootNode(), VLC_OBJECT(p_demux),
                                   mpdstream, Helper::getDirectoryPath(url).append("/"));
-        MPD *newmpd = mpdparser.parse();
-        if(newmpd)
-        {
-            playlist->mergeWith(newmpd, minsegmentTime);
-            delete newmpd;
-        }
-        vlc_stream_Delete(mpdstream);
-        block_Release(p_block);
+        newmpd = mpdparser.parse();
+    }
+    vlc_stream_Delete(mpdstream);
+    block_Release(p_block);
+
+    return newmpd;
+}
+
+bool DASHManager::mergePlaylist(AbstractPlaylist *newmpd)
+{
+    mtime_t minsegmentTime = 0;
+    std::vector<AbstractStream *>::iterator it;
+    for(it=streams.begin(); it!=streams.end(); it++)
+    {
+        mtime_t segmentTime = (*it)->getPlaybackTime();
+        if(!minsegmentTime || segmentTime < minsegmentTime)
+            minsegmentTime = segmentTime;
     }
 
+    playlist->mergeWith(newmpd, minsegmentTime);
     return true;
 }
 
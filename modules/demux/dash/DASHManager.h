@@ -54,6 +54,8 @@ namespace dash
             virtual bool needsUpdate() const; /* reimpl */
             virtual bool updatePlaylist(); /* reimpl */
             virtual void scheduleNextUpdate();/* reimpl */
+            virtual AbstractPlaylist * fetchPlaylist(); /* reimpl */
+            virtual bool mergePlaylist(AbstractPlaylist *); /* reimpl */
             static bool isDASH(xml::Node *);
             static bool mimeMatched(const std::string &);
 
@@ -44,6 +44,7 @@
 #include "../adaptive/tools/Debug.hpp"
 #include "../adaptive/tools/Conversions.hpp"
 #include <vlc_stream.h>
+#include <vlc_charset.h>
 #include <cstdio>
 
 using namespace dash::mpd;
@@ -89,45 +90,35 @@ MPD * IsoffMainParser::parse()
 
 void    IsoffMainParser::parseMPDAttributes   (MPD *mpd, xml::Node *node)
 {
-    const std::map<std::string, std::string> & attr = node->getAttributes();
+    const Node::Attributes & attr = node->getAttributes();
 
-    std::map<std::string, std::string>::const_iterator it;
-
-    it = attr.find("mediaPresentationDuration");
-    if(it != attr.end())
-        mpd->duration.Set(IsoTime(it->second) * CLOCK_FREQ);
-
-    it = attr.find("minBufferTime");
-    if(it != attr.end())
-        mpd->setMinBuffering(IsoTime(it->second) * CLOCK_FREQ);
-
-    it = attr.find("minimumUpdatePeriod");
-    if(it != attr.end())
+    Node::Attributes::const_iterator it;
+    for(it = attr.begin(); it != attr.end(); ++it)
     {
-        mtime_t minupdate = IsoTime(it->second) * CLOCK_FREQ;
-        if(minupdate > 0)
-            mpd->minUpdatePeriod.Set(minupdate);
+        const std::string &name = (*it).name;
+        const std::string &value = (*it).value;
+
+        if(name == "mediaPresentationDuration")
+            mpd->duration.Set(IsoTime(value) * CLOCK_FREQ);
+        else if(name == "minBufferTime")
+            mpd->setMinBuffering(IsoTime(value) * CLOCK_FREQ);
+        else if(name == "minimumUpdatePeriod")
+        {
+            mtime_t minupdate = IsoTime(value) * CLOCK_FREQ;
+            if(minupdate > 0)
+                mpd->minUpdatePeriod.Set(minupdate);
+        }
+        else if(name == "maxSegmentDuration")
+            mpd->maxSegmentDuration.Set(IsoTime(value) * CLOCK_FREQ);
+        else if(name == "type")
+            mpd->setType(value);
+        else if(name == "availabilityStartTime")
+            mpd->availabilityStartTime.Set(UTCTime(value).time());
+        else if(name == "timeShiftBufferDepth")
+            mpd->timeShiftBufferDepth.Set(IsoTime(value) * CLOCK_FREQ);
+        else if(name == "suggestedPresentationDelay")
+            mpd->suggestedPresentationDelay.Set(IsoTime(value) * CLOCK_FREQ);
     }
-
-    it = attr.find("maxSegmentDuration");
-    if(it != attr.end())
-        mpd->maxSegmentDuration.Set(IsoTime(it->second) * CLOCK_FREQ);
-
-    it = attr.find("type");
-    if(it != attr.end())
-        mpd->setType(it->second);
-
-    it = attr.find("availabilityStartTime");
-    if(it != attr.end())
-        mpd->availabilityStartTime.Set(UTCTime(it->second).time());
-
-    it = attr.find("timeShiftBufferDepth");
-        if(it != attr.end())
-            mpd->timeShiftBufferDepth.Set(IsoTime(it->second) * CLOCK_FREQ);
-
-    it = attr.find("suggestedPresentationDelay");
-    if(it != attr.end())
-        mpd->suggestedPresentationDelay.Set(IsoTime(it->second) * CLOCK_FREQ);
 }
 
 void IsoffMainParser::parsePeriods(MPD *mpd, Node *root)
@@ -176,6 +167,16 @@ size_t IsoffMainParser::parseSegmentTemplate(Node *templateNode, SegmentInformat
     if(templateNode->hasAttribute("duration"))
         mediaTemplate->duration.Set(Integer<stime_t>(templateNode->getAttributeValue("duration")));
 
+    if(templateNode->hasAttribute("availabilityTimeOffset") &&
+       var_InheritBool(p_object, "adaptive-lowlatency"))
+    {
+        const std::string ato = templateNode->getAttributeValue("availabilityTimeOffset");
+        const double offset = us_strtod(ato.c_str(), NULL);
+        /* INF only makes sense for on demand content */
+        if(ato != "INF" && offset > 0.0)
+            mediaTemplate->availabilityTimeOffset.Set(offset * CLOCK_FREQ);
+    }
+
     InitSegmentTemplate *initTemplate = NULL;
 
     if(templateNode->hasAttribute("initialization"))
@@ -451,12 +452,12 @@ void IsoffMainParser::parseTimeline(Node *node, MediaSegmentTemplate *templ)
     SegmentTimeline *timeline = new (std::nothrow) SegmentTimeline(templ);
     if(timeline)
     {
-        std::vector<Node *> elements = DOMHelper::getElementByTagName(node, "S", false);
+        const std::vector<Node *> &elements = node->getSubNodes();
         std::vector<Node *>::const_iterator it;
         for(it = elements.begin(); it != elements.end(); ++it)
         {
             const Node *s = *it;
-            if(!s->hasAttribute("d")) /* Mandatory */
+            if(s->getName() != "S" || !s->hasAttribute("d")) /* Mandatory */
                 continue;
             stime_t d = Integer<stime_t>(s->getAttributeValue("d"));
             uint64_t r = 0; // never repeats by default
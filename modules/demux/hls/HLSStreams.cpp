@@ -90,7 +90,12 @@ AbstractDemuxer * HLSStream::createDemux(const StreamFormat &format)
         case StreamFormat::WEBVTT:
             ret = new Demuxer(p_realdemux, "webvttstream", fakeesout->getEsOut(), demuxersource);
             if(ret)
+            {
+                /* Each segment is a complete document, that ends the stream,
+                 * but the same demuxer can parse the next one */
                 ret->setRestartsOnEachSegment(true);
+                ret->setPersistent(true);
+            }
             break;
 
         default:
@@ -28,6 +28,7 @@
 #include <vlc_common.h>
 #include <vlc_block.h>
 #ifdef HAVE_GCRYPT
+ #include <gcrypt.h>
  #include <vlc_gcrypt.h>
 #endif
 
@@ -38,94 +39,119 @@ SegmentEncryption::SegmentEncryption()
     method = SegmentEncryption::NONE;
 }
 
+#ifdef HAVE_GCRYPT
+namespace hls
+{
+    namespace playlist
+    {
+        /* Decrypts in place on the downloader thread. gcrypt selects
+         * its AES-NI / ARMv8 Crypto Extensions code paths at runtime. */
+        class AES128Decrypter : public AbstractChunkFilter
+        {
+            public:
+                AES128Decrypter(const std::vector<uint8_t> &key,
+                                const std::vector<uint8_t> &iv)
+                {
+                    vlc_gcrypt_init();
+                    if( gcry_cipher_open(&ctx, GCRY_CIPHER_AES, GCRY_CIPHER_MODE_CBC, 0) )
+                        ctx = NULL;
+                    else if( key.size() != 16 || iv.size() != 16 ||
+                             gcry_cipher_setkey(ctx, &key[0], 16) ||
+                             gcry_cipher_setiv(ctx, &iv[0], 16) )
+                    {
+                        gcry_cipher_close(ctx);
+                        ctx = NULL;
+                    }
+                }
+
+                virtual ~AES128Decrypter()
+                {
+                    if(ctx)
+                        gcry_cipher_close(ctx);
+                }
+
+                virtual block_t * filter(block_t *p_block, bool b_last) /* impl */
+                {
+                    if(!ctx)
+                    {
+                        p_block->i_buffer = 0;
+                        return p_block;
+                    }
+
+                    if ((p_block->i_buffer % 16) != 0 || p_block->i_buffer < 16 ||
+                        gcry_cipher_decrypt(ctx, p_block->p_buffer, p_block->i_buffer, NULL, 0))
+                    {
+                        p_block->i_buffer = 0;
+                        gcry_cipher_close(ctx);
+                        ctx = NULL;
+                    }
+                    else if(b_last)
+                    {
+                        /* remove the PKCS#7 padding from the buffer */
+                        const uint8_t pad = p_block->p_buffer[p_block->i_buffer - 1];
+                        uint8_t i = 0;
+                        if(pad > 0 && pad <= 16)
+                        {
+                            for(; i<pad; i++)
+                                if(p_block->p_buffer[p_block->i_buffer - i - 1] != pad)
+                                    break;
+                        }
+                        if(i > 0 && i == pad)
+                            p_block->i_buffer -= pad;
+                    }
+                    return p_block;
+                }
+
+            private:
+                gcry_cipher_hd_t ctx;
+        };
+    }
+}
+#endif
+
 HLSSegment::HLSSegment( ICanonicalUrl *parent, uint64_t seq ) :
     Segment( parent )
 {
     setSequenceNumber(seq);
     utcTime = 0;
-#ifdef HAVE_GCRYPT
-    ctx = NULL;
-#endif
 }
 
 HLSSegment::~HLSSegment()
 {
-#ifdef HAVE_GCRYPT
-    if(ctx)
-        gcry_cipher_close(ctx);
-#endif
 }
 
-void HLSSegment::onChunkDownload(block_t **pp_block, SegmentChunk *chunk, BaseRepresentation *)
+AbstractChunkFilter * HLSSegment::createChunkFilter() const
 {
-    block_t *p_block = *pp_block;
-
-#ifndef HAVE_GCRYPT
-    (void)chunk;
-#else
+#ifdef HAVE_GCRYPT
     if(encryption.method == SegmentEncryption::AES_128)
     {
-        block_t *p_block = *pp_block;
-        /* first bytes */
-        if(!ctx && chunk->getBytesRead() == p_block->i_buffer)
+        std::vector<uint8_t> iv = encryption.iv;
+        if (iv.size() != 16)
         {
-            vlc_gcrypt_init();
-            if (encryption.iv.size() != 16)
-            {
-                encryption.iv.clear();
-                encryption.iv.resize(16);
-                encryption.iv[15] = (getSequenceNumber() - Segment::SEQUENCE_FIRST) & 0xff;
-                encryption.iv[14] = ((getSequenceNumber() - Segment::SEQUENCE_FIRST) >> 8)& 0xff;
-                encryption.iv[13] = ((getSequenceNumber() - Segment::SEQUENCE_FIRST) >> 16)& 0xff;
-                encryption.iv[12] = ((getSequenceNumber() - Segment::SEQUENCE_FIRST) >> 24)& 0xff;
-            }
-
-            if( gcry_cipher_open(&ctx, GCRY_CIPHER_AES, GCRY_CIPHER_MODE_CBC, 0) ||
-                encryption.key.size() != 16 ||
-                gcry_cipher_setkey(ctx, &encryption.key[0], 16) ||
-                gcry_cipher_setiv(ctx, &encryption.iv[0], 16) )
-            {
-                gcry_cipher_close(ctx);
-                ctx = NULL;
-            }
-        }
-
-        if(ctx)
-        {
-            if ((p_block->i_buffer % 16) != 0 || p_block->i_buffer < 16 ||
-                gcry_cipher_decrypt(ctx, p_block->p_buffer, p_block->i_buffer, NULL, 0))
-            {
-                p_block->i_buffer = 0;
-                gcry_cipher_close(ctx);
-                ctx = NULL;
-            }
-            else
-            {
-                /* last bytes */
-                if(chunk->isEmpty())
-                {
-                    /* remove the PKCS#7 padding from the buffer */
-                    const uint8_t pad = p_block->p_buffer[p_block->i_buffer - 1];
-                    for(uint8_t i=0; i<pad && i<=16; i++)
-                    {
-                        if(p_block->p_buffer[p_block->i_buffer - i - 1] != pad)
-                            break;
-
-                        if(i==pad)
-                            p_block->i_buffer -= pad;
-                    }
-
-                    gcry_cipher_close(ctx);
-                    ctx = NULL;
-                }
-            }
+            iv.clear();
+            iv.resize(16);
+            iv[15] = (getSequenceNumber() - Segment::SEQUENCE_FIRST) & 0xff;
+            iv[14] = ((getSequenceNumber() - Segment::SEQUENCE_FIRST) >> 8)& 0xff;
+            iv[13] = ((getSequenceNumber() - Segment::SEQUENCE_FIRST) >> 16)& 0xff;
+            iv[12] = ((getSequenceNumber() - Segment::SEQUENCE_FIRST) >> 24)& 0xff;
         }
+        return new (std::nothrow) AES128Decrypter(encryption.key, iv);
     }
-    else
 #endif
+    return NULL;
+}
+
+void HLSSegment::onChunkDownload(block_t **pp_block, SegmentChunk *, BaseRepresentation *)
+{
+    /* AES-128 has already been decrypted by the chunk filter */
+#ifdef HAVE_GCRYPT
+    if(encryption.method != SegmentEncryption::NONE &&
+       encryption.method != SegmentEncryption::AES_128)
+#else
     if(encryption.method != SegmentEncryption::NONE)
+#endif
     {
-        p_block->i_buffer = 0;
+        (*pp_block)->i_buffer = 0;
     }
 }
 
@@ -22,9 +22,6 @@
 
 #include "../adaptive/playlist/Segment.h"
 #include <vector>
-#ifdef HAVE_GCRYPT
- #include <gcrypt.h>
-#endif
 
 namespace hls
 {
@@ -60,11 +57,9 @@ namespace hls
             protected:
                 mtime_t utcTime;
                 virtual void onChunkDownload(block_t **, SegmentChunk *, BaseRepresentation *); /* reimpl */
+                virtual AbstractChunkFilter * createChunkFilter() const; /* reimpl */
 
                 SegmentEncryption encryption;
-#ifdef HAVE_GCRYPT
-                gcry_cipher_hd_t ctx;
-#endif
         };
     }
 }
@@ -165,7 +165,7 @@ void M3U8Parser::createAndFillRepresentation(vlc_object_t *p_obj, BaseAdaptation
 
 bool M3U8Parser::appendSegmentsFromPlaylistURI(vlc_object_t *p_obj, Representation *rep)
 {
-    block_t *p_block = Retrieve::HTTP(p_obj, auth, rep->getPlaylistUrl().toString());
+    block_t *p_block = Retrieve::HTTP(p_obj, auth, rep->getUpdatePlaylistUrl());
     if(p_block)
     {
         stream_t *substream = vlc_stream_MemoryNew(p_obj, p_block->p_buffer, p_block->i_buffer, true);
@@ -188,6 +188,10 @@ void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::l
 {
     SegmentList *segmentList = new (std::nothrow) SegmentList(rep);
 
+    /* On updates, segments already listed are dropped by the merge,
+       so don't create them at all */
+    const uint64_t knownSequenceEnd = (rep->b_loaded) ? rep->nextMediaSequence : 0;
+
     rep->setTimescale(100);
     rep->b_loaded = true;
 
@@ -230,6 +234,32 @@ void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::l
                     break;
                 }
 
+                if(sequenceNumber < knownSequenceEnd)
+                {
+                    /* Only keep track of timings and offsets */
+                    const Attribute *attribute = (ctx_extinf) ? ctx_extinf->getAttributeByName("DURATION") : NULL;
+                    if(attribute)
+                    {
+                        const mtime_t nzDuration = CLOCK_FREQ * attribute->floatingPoint();
+                        nzStartTime += nzDuration;
+                        totalduration += nzDuration;
+                        if(absReferenceTime > VLC_TS_INVALID)
+                            absReferenceTime += nzDuration;
+                    }
+                    if(ctx_byterange)
+                    {
+                        std::pair<std::size_t,std::size_t> range = ctx_byterange->getValue().getByteRange();
+                        if(range.first == 0)
+                            range.first = prevbyterangeoffset;
+                        prevbyterangeoffset = range.first + range.second;
+                    }
+                    ctx_extinf = NULL;
+                    ctx_byterange = NULL;
+                    discontinuity = false;
+                    sequenceNumber++;
+                    break;
+                }
+
                 HLSSegment *segment = new (std::nothrow) HLSSegment(rep, sequenceNumber++);
                 if(!segment)
                     break;
@@ -358,6 +388,25 @@ void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::l
             }
             break;
 
+            case AttributesTag::EXTXSERVERCONTROL:
+            {
+                const AttributesTag *controltag = static_cast<const AttributesTag *>(tag);
+                const Attribute *attr = controltag->getAttributeByName("CAN-SKIP-UNTIL");
+                rep->canSkipUntil = (attr) ? CLOCK_FREQ * attr->floatingPoint() : 0;
+                attr = controltag->getAttributeByName("CAN-BLOCK-RELOAD");
+                rep->b_canBlockReload = (attr && attr->value == "YES");
+            }
+            break;
+
+            case AttributesTag::EXTXSKIP:
+            {
+                /* Delta update, skipped segments are the ones we already have */
+                const Attribute *attr = static_cast<const AttributesTag *>(tag)->getAttributeByName("SKIPPED-SEGMENTS");
+                if(attr)
+                    sequenceNumber += attr->decimal();
+            }
+            break;
+
             case Tag::EXTXDISCONTINUITY:
                 discontinuity  = true;
                 break;
@@ -368,6 +417,8 @@ void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::l
         }
     }
 
+    rep->nextMediaSequence = sequenceNumber;
+
     if(rep->isLive())
     {
         rep->getPlaylist()->duration.Set(0);
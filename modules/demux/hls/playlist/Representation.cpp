@@ -33,6 +33,7 @@
 #include "../adaptive/playlist/SegmentList.h"
 
 #include <ctime>
+#include <sstream>
 
 using namespace hls;
 using namespace hls::playlist;
@@ -45,6 +46,10 @@ Representation::Representation  ( BaseAdaptationSet *set ) :
     switchpolicy = SegmentInformation::SWITCH_SEGMENT_ALIGNED; /* FIXME: based on streamformat */
     nextUpdateTime = 0;
     targetDuration = 0;
+    lastUpdateTime = 0;
+    canSkipUntil = 0;
+    b_canBlockReload = false;
+    nextMediaSequence = 0;
     streamFormat = StreamFormat::UNKNOWN;
 }
 
@@ -87,6 +92,35 @@ Url Representation::getPlaylistUrl() const
     }
 }
 
+std::string Representation::getUpdatePlaylistUrl() const
+{
+    std::string url = getPlaylistUrl().toString();
+    if(!b_loaded || !isLive())
+        return url;
+
+    std::string query;
+    /* Request only the segments we don't have yet, which is only
+       valid if our copy isn't older than the skip boundary */
+    if(canSkipUntil && nextMediaSequence &&
+       CLOCK_FREQ * (time(NULL) - lastUpdateTime) < canSkipUntil / 2)
+        query = "_HLS_skip=YES";
+
+    /* Have the server hold the reload until next segment is available */
+    if(b_canBlockReload && nextMediaSequence)
+    {
+        std::ostringstream os;
+        os.imbue(std::locale("C"));
+        os << "_HLS_msn=" << nextMediaSequence;
+        if(!query.empty())
+            query.append("&");
+        query.append(os.str());
+    }
+
+    if(!query.empty())
+        url.append((url.find('?') == std::string::npos) ? "?" : "&").append(query);
+    return url;
+}
+
 void Representation::debug(vlc_object_t *obj, int indent) const
 {
     BaseRepresentation::debug(obj, indent);
@@ -149,6 +183,7 @@ bool Representation::runLocalUpdates(mtime_t, uint64_t number, bool prune)
         /* !ugly hack */
         parser.appendSegmentsFromPlaylistURI(playlist->getVLCObject(), this);
         b_loaded = true;
+        lastUpdateTime = now;
 
         if(prune)
             pruneBySegmentNumber(number);
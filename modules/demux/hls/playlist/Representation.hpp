@@ -45,6 +45,7 @@ namespace hls
 
                 void setPlaylistUrl(const std::string &);
                 Url getPlaylistUrl() const;
+                std::string getUpdatePlaylistUrl() const;
                 bool isLive() const;
                 bool initialized() const;
                 virtual void scheduleNextUpdate(uint64_t); /* reimpl */
@@ -59,7 +60,12 @@ namespace hls
                 bool b_loaded;
                 time_t nextUpdateTime;
                 time_t targetDuration;
+                time_t lastUpdateTime;
                 Url playlistUrl;
+                /* EXT-X-SERVER-CONTROL delta and blocking reload capabilities */
+                mtime_t canSkipUntil;
+                bool b_canBlockReload;
+                uint64_t nextMediaSequence; /* after the last parsed segment */
         };
     }
 }
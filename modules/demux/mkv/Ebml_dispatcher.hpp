@@ -66,55 +66,83 @@ namespace {
       );
   }
 
+  // --------------------------------------------------------------
+  // The handlers are looked up in an open addressing table keyed on the
+  // EbmlId value, built once when the dispatcher is created. The table
+  // is at most half full so that probes stay short.
+  // --------------------------------------------------------------
+
   class EbmlTypeDispatcher : public Dispatcher<EbmlTypeDispatcher, EbmlProcessorEntry::EbmlProcessor> {
     protected:
       typedef std::vector<EbmlProcessorEntry> ProcessorContainer;
+      typedef std::vector<size_t>             SlotContainer;
+
+      static const size_t EMPTY_SLOT = static_cast<size_t>( -1 );
+
+      static size_t hash (EbmlId const& id) {
+        return ( static_cast<uint32_t>( id.GetValue() ) * UINT32_C( 2654435761 ) ) ^ id.GetLength();
+      }
 
     public:
+      EbmlTypeDispatcher () : _mask (0) { }
+
       void insert (EbmlProcessorEntry const& data) {
         _processors.push_back (data);
       }
 
       void on_create () {
         std::sort (_processors.begin(), _processors.end());
+
+        size_t size = 4;
+        while (size < 2 * _processors.size())
+          size *= 2;
+
+        _slots.assign (size, static_cast<size_t> (EMPTY_SLOT));
+        _mask = size - 1;
+
+        for (size_t i = 0; i < _processors.size(); ++i) {
+          size_t h = hash (*_processors[i].p_ebmlid) & _mask;
+          while (_slots[h] != EMPTY_SLOT)
+            h = (h + 1) & _mask;
+          _slots[h] = i;
+        }
       }
 
       bool send (EbmlElement * const& element, void* payload) const
       {
-        EbmlProcessorEntry eb = EbmlProcessorEntry (
-          static_cast<EbmlId const&> (*element), NULL, NULL
-        );
-
         // --------------------------------------------------------------
         // Find the appropriate callback for the received EbmlElement
         // --------------------------------------------------------------
 
-        ProcessorContainer::const_iterator cit_end = _processors.end();
-        ProcessorContainer::const_iterator cit     = std::lower_bound (
-            _processors.begin(), cit_end, eb
-        );
-
-        if (element && cit != cit_end)
+        if (element && !_slots.empty())
         {
-          // --------------------------------------------------------------
-          // normally we only need to compare the addresses of the EbmlId
-          // since libebml returns a reference to a _static_ instance.
-          // --------------------------------------------------------------
+          EbmlId const& id = static_cast<EbmlId const&> (*element);
+          std::type_info const* ti = NULL;
 
-          while (cit != cit_end && (cit->p_ebmlid == eb.p_ebmlid || (*cit->p_ebmlid == *eb.p_ebmlid))) {
-            std::type_info const& ti = typeid (*element);
+          for (size_t h = hash (id) & _mask; _slots[h] != EMPTY_SLOT; h = (h + 1) & _mask)
+          {
+            EbmlProcessorEntry const& entry = _processors[_slots[h]];
+
+            // --------------------------------------------------------------
+            // normally we only need to compare the addresses of the EbmlId
+            // since libebml returns a reference to a _static_ instance.
+            // --------------------------------------------------------------
+
+            if (entry.p_ebmlid != &id && !(*entry.p_ebmlid == id))
+              continue;
 
             // --------------------------------------------------------------
             // even though the EbmlId are equivalent, we still need to make
             // sure that the typeid also matches.
             // --------------------------------------------------------------
 
-            if (*(cit->p_typeid) == ti) {
-              cit->callback (element, payload);
+            if (ti == NULL)
+              ti = &typeid (*element);
+
+            if (*(entry.p_typeid) == *ti) {
+              entry.callback (element, payload);
               return true;
             }
-
-            ++cit;
           }
         }
 
@@ -127,6 +155,10 @@ namespace {
 
     public:
       ProcessorContainer _processors;
+
+    private:
+      SlotContainer _slots;
+      size_t        _mask;
   };
 
 } /* end-of-namespace */
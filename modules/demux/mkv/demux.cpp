@@ -445,6 +445,7 @@ demux_sys_t::~demux_sys_t()
     while( titles.size() )
     { vlc_input_title_Delete( titles.back() ); titles.pop_back();}
 
+    vlc_mutex_destroy( &lock_segments );
     vlc_mutex_destroy( &lock_demuxer );
 }
 
@@ -542,11 +543,8 @@ matroska_stream_c *demux_sys_t::AnalyseAllSegmentsFound( demux_t *p_demux, EbmlS
                         if( MKV_IS_ID( l, KaxSegmentUID ) )
                         {
                             KaxSegmentUID *p_uid = static_cast<KaxSegmentUID*>(l);
-                            b_keep_segment = (FindSegment( *p_uid ) == NULL);
                             delete p_segment1->p_segment_uid;
                             p_segment1->p_segment_uid = new KaxSegmentUID(*p_uid);
-                            if ( !b_keep_segment )
-                                break; // this segment is already known
                         }
                         else if( MKV_IS_ID( l, KaxPrevUID ) )
                         {
@@ -564,8 +562,14 @@ matroska_stream_c *demux_sys_t::AnalyseAllSegmentsFound( demux_t *p_demux, EbmlS
                             p_segment1->families.push_back( p_fam );
                         }
                     }
+                    /* sibling files may be probed concurrently, the lookup
+                     * and the insertion must not be interleaved */
+                    vlc_mutex_lock( &lock_segments );
+                    if( p_segment1->p_segment_uid )
+                        b_keep_segment = (FindSegment( *p_segment1->p_segment_uid ) == NULL); // or already known
                     if( b_keep_segment || !p_segment1->p_segment_uid )
                         opened_segments.push_back( p_segment1 );
+                    vlc_mutex_unlock( &lock_segments );
                     break;
                 }
             }
@@ -657,6 +661,22 @@ void demux_sys_t::PreloadFamily( const matroska_segment_c & of_segment )
     }
 }
 
+// parse the tags and attachments that were left out of the preloading
+void demux_sys_t::LoadLazyMetadata( bool b_tags )
+{
+    vlc_mutex_locker demux_lock ( &lock_demuxer );
+
+    for (size_t i=0; i<opened_segments.size(); i++)
+    {
+        matroska_segment_c *p_segment = opened_segments[i];
+        if ( !p_segment->b_preloaded )
+            continue;
+        if ( b_tags )
+            p_segment->LoadLazyTags();
+        p_segment->LoadLazyAttachments();
+    }
+}
+
 // preload all the linked segments for all preloaded segments
 bool demux_sys_t::PreloadLinked()
 {
@@ -710,6 +730,7 @@ bool demux_sys_t::PreloadLinked()
                         /* Check in tags if the edition has a name */
 
                         /* We use only the tags of the first segment as it contains the edition */
+                        opened_segments[0]->LoadLazyTags();
                         matroska_segment_c::tags_t const& tags = opened_segments[0]->tags;
                         uint64_t i_ed_uid = 0;
                         if( p_ved->p_edition )
@@ -344,6 +344,7 @@ public:
         ,p_ev(NULL)
     {
         vlc_mutex_init( &lock_demuxer );
+        vlc_mutex_init( &lock_segments );
     }
 
     virtual ~demux_sys_t();
@@ -382,6 +383,7 @@ public:
 
     void PreloadFamily( const matroska_segment_c & of_segment );
     bool PreloadLinked();
+    void LoadLazyMetadata( bool b_tags );
     void FreeUnused();
     bool PreparePlayback( virtual_segment_c & new_vsegment, mtime_t i_mk_date );
     matroska_stream_c *AnalyseAllSegmentsFound( demux_t *p_demux, EbmlStream *p_estream, bool b_initial = false );
@@ -394,6 +396,7 @@ public:
     input_thread_t *p_input;
     uint8_t        palette[4][4];
     vlc_mutex_t    lock_demuxer;
+    vlc_mutex_t    lock_segments; /* opened_segments, while probing files in parallel */
 
     /* event */
     event_thread_t *p_ev;
@@ -60,14 +60,10 @@ namespace {
   template<class T, T*, class DispatcherType>
   class DispatchContainer {
     public:    static DispatcherType dispatcher;
-    protected: static vlc_mutex_t   _dispatcher_lock;
   };
 
   template<class T, T* P, class DT>
   DT DispatchContainer<T, P, DT>::dispatcher;
-
-  template<class T, T* P, class DT>
-  vlc_mutex_t DispatchContainer<T, P, DT>::_dispatcher_lock = VLC_STATIC_MUTEX;
 }
 
 // ----------------------------------------------------------------------------
@@ -104,19 +100,18 @@ namespace {
 // ----------------------------------------------------------------------------
 //   * `Dispatcher` is a static function used to access the dispatcher in a
 //      thread-safe manner. We only want _one_ thread to actually construct
-//      and initialize it, hence the lock.
+//      and initialize it, which the initialization of local statics
+//      guarantees, without taking a lock on every element dispatched.
 // ----------------------------------------------------------------------------
 
 #define MKV_SWITCH_INIT()                     \
+  static handler_t * Create () {              \
+      static handler_t handler;               \
+      handler.dispatcher.on_create ();        \
+      return &handler;                        \
+  }                                           \
   static dispatch_t& Dispatcher () {          \
-      static handler_t * p_handler = NULL;    \
-      vlc_mutex_lock( &_dispatcher_lock );    \
-      if (unlikely( p_handler == NULL) ) {    \
-          static handler_t handler;           \
-          p_handler = &handler;               \
-          p_handler->dispatcher.on_create (); \
-      }                                       \
-      vlc_mutex_unlock( &_dispatcher_lock );  \
+      static handler_t * const p_handler = Create (); \
       return p_handler->dispatcher;           \
   } struct PleaseAddSemicolon {}
 
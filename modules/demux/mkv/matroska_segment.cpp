@@ -28,6 +28,13 @@
 #include "util.hpp"
 #include "Ebml_parser.hpp"
 #include "Ebml_dispatcher.hpp"
+#include "stream_io_callback.hpp"
+
+#include <vlc_fs.h>
+#include <vlc_url.h>
+#include <vlc_configuration.h>
+
+#include <sys/stat.h>
 
 #include <new>
 #include <iterator>
@@ -45,6 +52,9 @@ matroska_segment_c::matroska_segment_c( demux_sys_t & demuxer, EbmlStream & estr
     ,i_info_position(-1)
     ,i_chapters_position(-1)
     ,i_attachments_position(-1)
+    ,b_lazy_metadata( var_InheritBool( &demuxer.demuxer, "mkv-lazy-metadata" ) )
+    ,i_lazy_tags_position(-1)
+    ,i_lazy_attachments_position(-1)
     ,cluster(NULL)
     ,i_block_pos(0)
     ,p_segment_uid(NULL)
@@ -61,11 +71,14 @@ matroska_segment_c::matroska_segment_c( demux_sys_t & demuxer, EbmlStream & estr
     ,ep(NULL)
     ,b_preloaded(false)
     ,b_ref_external_segments(false)
+    ,i_index_cache_entries(0)
 {
 }
 
 matroska_segment_c::~matroska_segment_c()
 {
+    SaveIndexCache();
+
     free( psz_writing_application );
     free( psz_muxing_application );
     free( psz_segment_filename );
@@ -480,6 +493,18 @@ void matroska_segment_c::IndexAppendCluster( KaxCluster *cluster )
     _seeker.add_cluster( cluster );
 }
 
+void matroska_segment_c::ReadAheadCluster( KaxCluster *cluster )
+{
+    if( !cluster->IsFiniteSize() )
+        return;
+
+    uint64 i_start = es.I_O().getFilePointer();
+    uint64 i_end   = cluster->GetEndPosition();
+
+    if( i_end > i_start )
+        static_cast<vlc_stream_io_callback&>( es.I_O() ).readAhead( i_start, i_end - i_start );
+}
+
 bool matroska_segment_c::PreloadClusters(uint64 i_cluster_pos)
 {
     struct ClusterHandlerPayload
@@ -575,6 +600,100 @@ bool matroska_segment_c::SameFamily( const matroska_segment_c & of_segment ) con
     return false;
 }
 
+/*****************************************************************************
+ * Index cache: the seekpoints and clusters found in a local file are kept
+ * in the user cache directory, keyed by the file size, modification time
+ * and SegmentUID, so that reopening it does not need to scan it again.
+ *****************************************************************************/
+bool matroska_segment_c::LoadIndexCache()
+{
+    if( !index_cache_path.empty() || p_segment_uid == NULL ||
+        !var_InheritBool( &sys.demuxer, "mkv-index-cache" ) )
+        return false;
+
+    stream_t *s = static_cast<vlc_stream_io_callback&>( es.I_O() ).stream();
+    char *psz_path = NULL;
+    if( s->psz_filepath != NULL )
+        psz_path = strdup( s->psz_filepath );
+    else if( s->psz_url != NULL )
+        psz_path = vlc_uri2path( s->psz_url );
+
+    struct stat st;
+    bool b_local = psz_path != NULL && vlc_stat( psz_path, &st ) == 0 && S_ISREG( st.st_mode );
+    free( psz_path );
+    if( !b_local )
+        return false;
+
+    char *psz_cachedir = config_GetUserDir( VLC_CACHE_DIR );
+    if( psz_cachedir == NULL )
+        return false;
+
+    const uint8_t *p_uid = p_segment_uid->GetBuffer();
+    const size_t   i_uid = p_segment_uid->GetSize();
+    const uint64_t i_size  = st.st_size;
+    const int64_t  i_mtime = st.st_mtime;
+
+    std::string name;
+    for( size_t i = 0; i < i_uid; i++ )
+    {
+        char hex[3];
+        snprintf( hex, sizeof( hex ), "%02x", p_uid[i] );
+        name += hex;
+    }
+    {
+        char suffix[32];
+        snprintf( suffix, sizeof( suffix ), "-%" PRIu64 ".idx", i_size );
+        name += suffix;
+    }
+
+    std::string dir = std::string( psz_cachedir ) + DIR_SEP "mkv-index";
+    vlc_mkdir( psz_cachedir, 0700 );
+    vlc_mkdir( dir.c_str(), 0700 );
+    free( psz_cachedir );
+
+    index_cache_path = dir + DIR_SEP + name;
+    index_cache_key.assign( reinterpret_cast<const char*>( &i_size ), sizeof( i_size ) );
+    index_cache_key.append( reinterpret_cast<const char*>( &i_mtime ), sizeof( i_mtime ) );
+    index_cache_key.append( reinterpret_cast<const char*>( p_uid ), i_uid );
+
+    bool b_loaded = false;
+    FILE *p_file = vlc_fopen( index_cache_path.c_str(), "rb" );
+    if( p_file != NULL )
+    {
+        b_loaded = _seeker.load_index( p_file, index_cache_key );
+        fclose( p_file );
+        if( b_loaded )
+            msg_Dbg( &sys.demuxer, "loaded index from %s", index_cache_path.c_str() );
+        else
+            msg_Warn( &sys.demuxer, "ignoring stale or invalid index %s", index_cache_path.c_str() );
+    }
+
+    i_index_cache_entries = b_loaded ? _seeker.index_size() : 0;
+    return b_loaded;
+}
+
+void matroska_segment_c::SaveIndexCache()
+{
+    if( index_cache_path.empty() || _seeker.index_size() == i_index_cache_entries )
+        return;
+
+    /* write aside and rename, so that concurrent instances never read
+     * a partial file */
+    std::string tmp_path = index_cache_path + ".tmp";
+    FILE *p_file = vlc_fopen( tmp_path.c_str(), "wb" );
+    if( p_file == NULL )
+        return;
+
+    bool b_ok = _seeker.save_index( p_file, index_cache_key );
+    b_ok = fclose( p_file ) == 0 && b_ok;
+
+    if( !b_ok || vlc_rename( tmp_path.c_str(), index_cache_path.c_str() ) )
+    {
+        msg_Warn( &sys.demuxer, "cannot write index %s", index_cache_path.c_str() );
+        vlc_unlink( tmp_path.c_str() );
+    }
+}
+
 bool matroska_segment_c::Preload( )
 {
     if ( b_preloaded )
@@ -633,7 +752,9 @@ bool matroska_segment_c::Preload( )
         }
         else if( MKV_CHECKED_PTR_DECL ( kc_ptr, KaxCluster, el ) )
         {
-            if( var_InheritBool( &sys.demuxer, "mkv-preload-clusters" ) )
+            bool b_index_cached = LoadIndexCache();
+
+            if( !b_index_cached && var_InheritBool( &sys.demuxer, "mkv-preload-clusters" ) )
             {
                 PreloadClusters        ( kc_ptr->GetElementPosition() );
                 es.I_O().setFilePointer( kc_ptr->GetElementPosition() );
@@ -645,6 +766,7 @@ bool matroska_segment_c::Preload( )
 
             cluster = kc_ptr;
             IndexAppendCluster( cluster );
+            ReadAheadCluster( cluster );
 
             // add first cluster as trusted seekpoint for all tracks
             for( tracks_map_t::const_iterator it = tracks.begin();
@@ -661,7 +783,12 @@ bool matroska_segment_c::Preload( )
         else if( MKV_CHECKED_PTR_DECL ( ka_ptr, KaxAttachments, el ) )
         {
             msg_Dbg( &sys.demuxer, "|   + Attachments" );
-            if( i_attachments_position < 0 )
+            if( b_lazy_metadata )
+            {
+                if( i_attachments_position < 0 )
+                    i_lazy_attachments_position = el->GetElementPosition();
+            }
+            else if( i_attachments_position < 0 )
             {
                 ParseAttachments( ka_ptr );
                 i_attachments_position = el->GetElementPosition();
@@ -679,7 +806,12 @@ bool matroska_segment_c::Preload( )
         else if( MKV_CHECKED_PTR_DECL ( kt_ptr, KaxTags, el ) )
         {
             msg_Dbg( &sys.demuxer, "|   + Tags" );
-            if(tags.empty ())
+            if( b_lazy_metadata )
+            {
+                if( tags.empty() )
+                    i_lazy_tags_position = el->GetElementPosition();
+            }
+            else if(tags.empty ())
             {
                 LoadTags( kt_ptr );
             }
@@ -799,6 +931,29 @@ bool matroska_segment_c::LoadSeekHeadItem( const EbmlCallbacks & ClassInfos, int
     return true;
 }
 
+/* Parse the elements Preload only located, on their first use */
+void matroska_segment_c::LoadLazyTags()
+{
+    if( i_lazy_tags_position < 0 )
+        return;
+
+    int64_t i_pos = i_lazy_tags_position;
+    i_lazy_tags_position = -1;
+    if( tags.empty() )
+        LoadSeekHeadItem( EBML_INFO(KaxTags), i_pos );
+}
+
+void matroska_segment_c::LoadLazyAttachments()
+{
+    if( i_lazy_attachments_position < 0 )
+        return;
+
+    int64_t i_pos = i_lazy_attachments_position;
+    i_lazy_attachments_position = -1;
+    if( i_attachments_position < 0 )
+        LoadSeekHeadItem( EBML_INFO(KaxAttachments), i_pos );
+}
+
 bool matroska_segment_c::FastSeek( demux_t &demuxer, mtime_t i_mk_date, mtime_t i_mk_time_offset )
 {
     if( Seek( demuxer, i_mk_date, i_mk_time_offset ) )
@@ -1188,6 +1343,7 @@ int matroska_segment_c::BlockGet( KaxBlock * & pp_block, KaxSimpleBlock * & pp_s
         {
             vars.obj->cluster = &kcluster;
             vars.b_cluster_timecode = false;
+            vars.obj->ReadAheadCluster( &kcluster );
             vars.ep->Down ();
         }
         E_CASE( KaxCues, kcue )
@@ -104,6 +104,11 @@ public:
     int64_t                 i_chapters_position;
     int64_t                 i_attachments_position;
 
+    /* tags and attachments found but not parsed yet (mkv-lazy-metadata) */
+    bool                    b_lazy_metadata;
+    int64_t                 i_lazy_tags_position;
+    int64_t                 i_lazy_attachments_position;
+
     KaxCluster              *cluster;
     uint64                  i_block_pos;
     KaxSegmentUID           *p_segment_uid;
@@ -153,6 +158,9 @@ public:
 
     bool SameFamily( const matroska_segment_c & of_segment ) const;
 
+    void LoadLazyTags();
+    void LoadLazyAttachments();
+
 private:
     void LoadCues( KaxCues *cues );
     void LoadTags( KaxTags *tags );
@@ -167,12 +175,20 @@ private:
     bool ParseCluster( KaxCluster *cluster, bool b_update_start_time = true, ScopeMode read_fully = SCOPE_ALL_DATA );
     bool ParseSimpleTags( SimpleTag* out, KaxTagSimple *tag, int level = 50 );
     void IndexAppendCluster( KaxCluster *cluster );
+    void ReadAheadCluster( KaxCluster *cluster );
     bool TrackInit( mkv_track_t * p_tk );
     void ComputeTrackPriority();
     void EnsureDuration();
+    bool LoadIndexCache();
+    void SaveIndexCache();
 
     SegmentSeeker _seeker;
 
+    /* persistent index */
+    std::string             index_cache_path;
+    std::string             index_cache_key;
+    size_t                  i_index_cache_entries;
+
     friend SegmentSeeker;
 };
 
@@ -166,7 +166,13 @@ void matroska_segment_c::ParseSeekHead( KaxSeekHead *seekhead )
                 else if( id == EBML_ID(KaxTags) )
                 {
                     msg_Dbg( &sys.demuxer, "|   - tags at %" PRId64, i_pos );
-                    LoadSeekHeadItem( EBML_INFO(KaxTags), i_pos );
+                    if( b_lazy_metadata )
+                    {
+                        if( tags.empty() )
+                            i_lazy_tags_position = i_pos;
+                    }
+                    else
+                        LoadSeekHeadItem( EBML_INFO(KaxTags), i_pos );
                 }
                 else if( id == EBML_ID(KaxSeekHead) )
                 {
@@ -181,7 +187,13 @@ void matroska_segment_c::ParseSeekHead( KaxSeekHead *seekhead )
                 else if( id == EBML_ID(KaxAttachments) )
                 {
                     msg_Dbg( &sys.demuxer, "|   - attachments at %" PRId64, i_pos );
-                    LoadSeekHeadItem( EBML_INFO(KaxAttachments), i_pos );
+                    if( b_lazy_metadata )
+                    {
+                        if( i_attachments_position < 0 )
+                            i_lazy_attachments_position = i_pos;
+                    }
+                    else
+                        LoadSeekHeadItem( EBML_INFO(KaxAttachments), i_pos );
                 }
 #ifdef MKV_DEBUG
                 else if( id != EBML_ID(KaxCluster) && id != EBML_ID(EbmlVoid) &&
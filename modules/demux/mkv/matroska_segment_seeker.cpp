@@ -31,6 +31,7 @@
 
 #include <sstream>
 #include <limits>
+#include <cstring>
 
 namespace { 
     template<class It, class T>
@@ -47,6 +48,23 @@ namespace {
 
     template<class It> It prev_( It it ) { return --it; }
     template<class It> It next_( It it ) { return ++it; }
+
+    // the persistent index is stored in host byte order, the marker
+    // makes a file written on a foreign host fail to load
+
+    static const char     index_magic[8]  = { 'V', 'L', 'C', 'M', 'K', 'V', 'I', 'X' };
+    static const uint64_t index_marker    = UINT64_C( 0x0102030405060708 );
+    static const uint32_t index_version   = 1;
+
+    template<class T> bool write_( FILE *p_file, T const& value )
+    {
+        return fwrite( &value, sizeof( value ), 1, p_file ) == 1;
+    }
+
+    template<class T> bool read_( FILE *p_file, T& value )
+    {
+        return fread( &value, sizeof( value ), 1, p_file ) == 1;
+    }
 }
 
 SegmentSeeker::cluster_positions_t::iterator
@@ -114,20 +132,14 @@ SegmentSeeker::add_cluster( KaxCluster * const p_cluster )
 void
 SegmentSeeker::add_seekpoint( track_id_t track_id, Seekpoint sp )
 {
-    seekpoints_t&  seekpoints = _tracks_seekpoints[ track_id ];
-    seekpoints_t::iterator it = std::lower_bound( seekpoints.begin(), seekpoints.end(), sp );
-
-    if( it != seekpoints.end() && it->pts == sp.pts )
-    {
-        if (sp.trust_level <= it->trust_level)
-            return;
+    _tracks_seekpoints[ track_id ].insert( sp.fpos, sp.pts, sp.trust_level );
+}
 
-        *it = sp;
-    }
-    else
-    {
-        seekpoints.insert( it, sp );
-    }
+SegmentSeeker::Seekpoint
+SegmentSeeker::get_seekpoint( seekpoints_t const& seekpoints, size_t i )
+{
+    return Seekpoint( seekpoints.fpos( i ), seekpoints.pts( i ),
+                      Seekpoint::TrustLevel( seekpoints.trust( i ) ) );
 }
 
 SegmentSeeker::tracks_seekpoint_t
@@ -163,23 +175,15 @@ SegmentSeeker::get_first_seekpoint_around( mtime_t pts, seekpoints_t const& seek
         return Seekpoint();
     }
 
-    typedef seekpoints_t::const_iterator iterator;
-
-    Seekpoint const needle ( std::numeric_limits<fptr_t>::max(), pts );
-
-    iterator const it_begin  = seekpoints.begin();
-    iterator const it_end    = seekpoints.end();
-    iterator const it_middle = greatest_lower_bound( it_begin, it_end, needle );
-
-    iterator it_before;
+    size_t i = seekpoints.greatest_lower_bound( pts );
 
     // rewrind to _previous_ seekpoint with appropriate trust
-    for( it_before = it_middle; it_before != it_begin; --it_before )
+    for( ; i > 0; --i )
     {
-        if( it_before->trust_level >= trust_level )
-            return *it_before;
+        if( seekpoints.trust( i ) >= trust_level )
+            return get_seekpoint( seekpoints, i );
     }
-    return *it_begin;
+    return get_seekpoint( seekpoints, 0 );
 }
 
 SegmentSeeker::seekpoint_pair_t
@@ -190,19 +194,11 @@ SegmentSeeker::get_seekpoints_around( mtime_t pts, seekpoints_t const& seekpoint
         return seekpoint_pair_t();
     }
 
-    typedef seekpoints_t::const_iterator iterator;
-
-    Seekpoint const needle ( std::numeric_limits<fptr_t>::max(), pts );
-
-    iterator const it_begin  = seekpoints.begin();
-    iterator const it_end    = seekpoints.end();
-    iterator const it_middle = greatest_lower_bound( it_begin, it_end, needle );
+    size_t const i_before = seekpoints.greatest_lower_bound( pts );
+    size_t const i_after  = i_before + 1;
 
-    iterator it_before = it_middle;
-    iterator it_after = it_middle == it_end ? it_middle : next_( it_middle ) ;
-
-    return seekpoint_pair_t( *it_before,
-      it_after == it_end ? Seekpoint() : *it_after
+    return seekpoint_pair_t( get_seekpoint( seekpoints, i_before ),
+      i_after == seekpoints.size() ? Seekpoint() : get_seekpoint( seekpoints, i_after )
     );
 }
 
@@ -486,3 +482,174 @@ SegmentSeeker::mkv_jump_to( matroska_segment_c& ms, fptr_t fpos )
     ms.es.I_O().setFilePointer( fpos );
 }
 
+bool
+SegmentSeeker::save_index( FILE *p_file, std::string const& key ) const
+{
+    bool b_ok = fwrite( index_magic, sizeof( index_magic ), 1, p_file ) == 1
+             && write_( p_file, index_marker )
+             && write_( p_file, index_version )
+             && write_( p_file, uint64_t( key.size() ) )
+             && fwrite( key.data(), 1, key.size(), p_file ) == key.size();
+
+    b_ok = b_ok && write_( p_file, uint64_t( _ranges_searched.size() ) );
+    for( ranges_t::const_iterator it = _ranges_searched.begin(); b_ok && it != _ranges_searched.end(); ++it )
+    {
+        b_ok = write_( p_file, it->start ) && write_( p_file, it->end );
+    }
+
+    b_ok = b_ok && write_( p_file, uint64_t( _tracks_seekpoints.size() ) );
+    for( tracks_seekpoints_t::const_iterator it = _tracks_seekpoints.begin(); b_ok && it != _tracks_seekpoints.end(); ++it )
+    {
+        b_ok = write_( p_file, uint64_t( it->first ) )
+            && write_( p_file, uint64_t( it->second.size() ) );
+
+        for( size_t i = 0; b_ok && i < it->second.size(); ++i )
+        {
+            b_ok = write_( p_file, it->second.fpos( i ) )
+                && write_( p_file, int64_t( it->second.pts( i ) ) )
+                && write_( p_file, int32_t( it->second.trust( i ) ) );
+        }
+    }
+
+    b_ok = b_ok && write_( p_file, uint64_t( _cluster_positions.size() ) );
+    for( cluster_positions_t::const_iterator it = _cluster_positions.begin(); b_ok && it != _cluster_positions.end(); ++it )
+    {
+        b_ok = write_( p_file, *it );
+    }
+
+    b_ok = b_ok && write_( p_file, uint64_t( _clusters.size() ) );
+    for( cluster_map_t::const_iterator it = _clusters.begin(); b_ok && it != _clusters.end(); ++it )
+    {
+        b_ok = write_( p_file, it->second.fpos )
+            && write_( p_file, int64_t( it->second.pts ) )
+            && write_( p_file, int64_t( it->second.duration ) )
+            && write_( p_file, it->second.size );
+    }
+
+    return b_ok;
+}
+
+bool
+SegmentSeeker::load_index( FILE *p_file, std::string const& key )
+{
+    char     magic[ sizeof( index_magic ) ];
+    uint64_t marker, count, key_size;
+    uint32_t version;
+
+    if( fread( magic, sizeof( magic ), 1, p_file ) != 1 ||
+        memcmp( magic, index_magic, sizeof( magic ) ) ||
+        !read_( p_file, marker )   || marker  != index_marker  ||
+        !read_( p_file, version )  || version != index_version ||
+        !read_( p_file, key_size ) || key_size != key.size() )
+        return false;
+
+    {
+        std::string file_key( key.size(), '\0' );
+        if( fread( &file_key[0], 1, file_key.size(), p_file ) != file_key.size() ||
+            file_key != key )
+            return false;
+    }
+
+    // parse everything before touching the current index, so that
+    // a truncated file leaves it untouched
+
+    ranges_t            ranges;
+    tracks_seekpoints_t seekpoints;
+    cluster_positions_t positions;
+    cluster_map_t       clusters;
+
+    if( !read_( p_file, count ) )
+        return false;
+
+    for( ; count > 0; --count )
+    {
+        Range range( 0, 0 );
+        if( !read_( p_file, range.start ) || !read_( p_file, range.end ) )
+            return false;
+        ranges.push_back( range );
+    }
+
+    if( !read_( p_file, count ) )
+        return false;
+
+    for( ; count > 0; --count )
+    {
+        uint64_t track_id, points;
+        if( !read_( p_file, track_id ) || !read_( p_file, points ) )
+            return false;
+
+        seekpoints_t& track_seekpoints = seekpoints[ track_id_t( track_id ) ];
+
+        for( ; points > 0; --points )
+        {
+            fptr_t  fpos;
+            int64_t pts;
+            int32_t trust_level;
+
+            if( !read_( p_file, fpos ) || !read_( p_file, pts ) || !read_( p_file, trust_level ) )
+                return false;
+
+            track_seekpoints.insert( fpos, mtime_t( pts ), trust_level );
+        }
+    }
+
+    if( !read_( p_file, count ) )
+        return false;
+
+    for( ; count > 0; --count )
+    {
+        fptr_t fpos;
+        if( !read_( p_file, fpos ) )
+            return false;
+        positions.push_back( fpos );
+    }
+
+    if( !read_( p_file, count ) )
+        return false;
+
+    for( ; count > 0; --count )
+    {
+        Cluster cinfo;
+        int64_t pts, duration;
+
+        if( !read_( p_file, cinfo.fpos ) || !read_( p_file, pts ) ||
+            !read_( p_file, duration ) || !read_( p_file, cinfo.size ) )
+            return false;
+
+        cinfo.pts      = mtime_t( pts );
+        cinfo.duration = mtime_t( duration );
+        clusters.insert( cluster_map_t::value_type( cinfo.pts, cinfo ) );
+    }
+
+    // merge with what was already indexed while preloading
+
+    for( ranges_t::const_iterator it = ranges.begin(); it != ranges.end(); ++it )
+        mark_range_as_searched( *it );
+
+    for( tracks_seekpoints_t::const_iterator it = seekpoints.begin(); it != seekpoints.end(); ++it )
+    {
+        for( size_t i = 0; i < it->second.size(); ++i )
+            add_seekpoint( it->first, get_seekpoint( it->second, i ) );
+    }
+
+    for( cluster_positions_t::const_iterator it = positions.begin(); it != positions.end(); ++it )
+    {
+        if( !std::binary_search( _cluster_positions.begin(), _cluster_positions.end(), *it ) )
+            add_cluster_position( *it );
+    }
+
+    _clusters.insert( clusters.begin(), clusters.end() );
+
+    return true;
+}
+
+size_t
+SegmentSeeker::index_size() const
+{
+    size_t entries = _ranges_searched.size() + _cluster_positions.size() + _clusters.size();
+
+    for( tracks_seekpoints_t::const_iterator it = _tracks_seekpoints.begin(); it != _tracks_seekpoints.end(); ++it )
+        entries += it->second.size();
+
+    return entries;
+}
@@ -25,8 +25,10 @@
 #define MKV_MATROSKA_SEGMENT_SEEKER_HPP_
 
 #include "mkv.hpp"
+#include "seekpoint_index.hpp"
 
 #include <algorithm>
+#include <cstdio>
 #include <vector>
 #include <map>
 #include <limits>
@@ -89,7 +91,7 @@ class SegmentSeeker
     public:
         typedef std::vector<track_id_t> track_ids_t;
         typedef std::vector<Range> ranges_t;
-        typedef std::vector<Seekpoint> seekpoints_t;
+        typedef SeekpointIndex seekpoints_t;
         typedef std::vector<fptr_t> cluster_positions_t;
 
         typedef std::map<track_id_t, Seekpoint> tracks_seekpoint_t;
@@ -99,6 +101,7 @@ class SegmentSeeker
         typedef std::pair<Seekpoint, Seekpoint> seekpoint_pair_t;
 
         void add_seekpoint( track_id_t, Seekpoint );
+        static Seekpoint get_seekpoint( seekpoints_t const&, size_t );
 
         seekpoint_pair_t get_seekpoints_around( mtime_t, seekpoints_t const& );
         Seekpoint get_first_seekpoint_around( mtime_t, seekpoints_t const&, Seekpoint::TrustLevel = Seekpoint::TRUSTED );
@@ -118,6 +121,11 @@ class SegmentSeeker
         void mark_range_as_searched( Range );
         ranges_t get_search_areas( fptr_t start, fptr_t end ) const;
 
+        // persistent index, the key identifies the file the index belongs to
+        bool load_index( FILE *, std::string const& key );
+        bool save_index( FILE *, std::string const& key ) const;
+        size_t index_size() const;
+
     public:
         ranges_t            _ranges_searched;
         tracks_seekpoints_t _tracks_seekpoints;
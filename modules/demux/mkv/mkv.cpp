@@ -76,6 +76,18 @@ vlc_module_begin ()
             N_("Preload clusters"),
             N_("Find all cluster positions by jumping cluster-to-cluster before playback"), true );
 
+    add_bool( "mkv-cluster-readahead", false,
+            N_("Read clusters ahead"),
+            N_("Load each cluster in a single read and the next one in the background. Helps with high bitrate files on network shares."), true );
+
+    add_bool( "mkv-lazy-metadata", false,
+            N_("Load tags and attachments on demand"),
+            N_("Do not parse tags and attachments when opening the file, but the first time they are requested. Speeds up opening files with many attachments, such as fonts."), true );
+
+    add_bool( "mkv-index-cache", false,
+            N_("Cache the seek index"),
+            N_("Keep the seek index of local files in the cache directory, so that they do not need to be scanned again when reopened."), true );
+
     add_shortcut( "mka", "mkv" )
 vlc_module_end ()
 
@@ -85,6 +97,124 @@ static int  Demux  ( demux_t * );
 static int  Control( demux_t *, int, va_list );
 static int  Seek   ( demux_t *, mtime_t i_mk_date, double f_percent, virtual_chapter_c *p_vchapter, bool b_precise = true );
 
+/*****************************************************************************
+ * ProbeSiblings: open the files of the same directory to find linked segments
+ *****************************************************************************
+ * Over network shares, opening each file and reading its headers is mostly
+ * waiting, so the candidates are probed by a few threads at once.
+ *****************************************************************************/
+#define MKV_PROBE_THREADS 4
+
+struct sibling_probe_t
+{
+    demux_t                         *p_demux;
+    const std::vector<std::string>  *p_files;
+    std::vector<matroska_stream_c*> results;
+    size_t                          i_next;
+    vlc_mutex_t                     lock;
+};
+
+static matroska_stream_c *ProbeSibling( demux_t *p_demux, const std::string & s_filename )
+{
+    demux_sys_t       *p_sys = p_demux->p_sys;
+    matroska_stream_c *p_stream = NULL;
+
+    // test whether this file belongs to our family
+    const uint8_t *p_peek;
+    bool          file_ok = false;
+    char          *psz_url = vlc_path2uri( s_filename.c_str(), "file" );
+    stream_t      *p_file_stream = vlc_stream_NewURL(
+                                    p_demux,
+                                    psz_url );
+    /* peek the begining */
+    if( p_file_stream &&
+        vlc_stream_Peek( p_file_stream, &p_peek, 4 ) >= 4
+        && p_peek[0] == 0x1a && p_peek[1] == 0x45 &&
+        p_peek[2] == 0xdf && p_peek[3] == 0xa3 ) file_ok = true;
+
+    if ( file_ok )
+    {
+        vlc_stream_io_callback *p_file_io = new vlc_stream_io_callback( p_file_stream, true );
+        if( var_InheritBool( p_demux, "mkv-cluster-readahead" ) )
+            p_file_io->enableReadAhead( MKV_READAHEAD_MAX );
+        EbmlStream *p_estream = new EbmlStream(*p_file_io);
+
+        p_stream = p_sys->AnalyseAllSegmentsFound( p_demux, p_estream );
+
+        if ( p_stream == NULL )
+        {
+            msg_Dbg( p_demux, "the file '%s' will not be used", s_filename.c_str() );
+            delete p_estream;
+            delete p_file_io;
+        }
+        else
+        {
+            p_stream->p_io_callback = p_file_io;
+            p_stream->p_estream = p_estream;
+        }
+    }
+    else
+    {
+        if( p_file_stream ) {
+            vlc_stream_Delete( p_file_stream );
+        }
+        msg_Dbg( p_demux, "the file '%s' cannot be opened", s_filename.c_str() );
+    }
+    free( psz_url );
+
+    return p_stream;
+}
+
+static void *ProbeSiblingsThread( void *p_data )
+{
+    sibling_probe_t *p_probe = static_cast<sibling_probe_t*>( p_data );
+
+    for( ;; )
+    {
+        vlc_mutex_lock( &p_probe->lock );
+        size_t i = p_probe->i_next++;
+        vlc_mutex_unlock( &p_probe->lock );
+
+        if( i >= p_probe->p_files->size() )
+            break;
+
+        /* each slot is only written by the thread probing it */
+        p_probe->results[i] = ProbeSibling( p_probe->p_demux, (*p_probe->p_files)[i] );
+    }
+
+    return NULL;
+}
+
+static void ProbeSiblings( demux_t *p_demux, const std::vector<std::string> & files )
+{
+    sibling_probe_t probe;
+    probe.p_demux = p_demux;
+    probe.p_files = &files;
+    probe.results.resize( files.size(), NULL );
+    probe.i_next = 0;
+    vlc_mutex_init( &probe.lock );
+
+    /* the calling thread probes too */
+    vlc_thread_t threads[MKV_PROBE_THREADS - 1];
+    size_t i_threads = 0;
+    while( i_threads < MKV_PROBE_THREADS - 1 && i_threads + 1 < files.size() &&
+           !vlc_clone( &threads[i_threads], ProbeSiblingsThread, &probe, VLC_THREAD_PRIORITY_INPUT ) )
+        i_threads++;
+
+    ProbeSiblingsThread( &probe );
+
+    for( size_t i = 0; i < i_threads; i++ )
+        vlc_join( threads[i], NULL );
+    vlc_mutex_destroy( &probe.lock );
+
+    /* keep the directory order for the streams */
+    for( size_t i = 0; i < probe.results.size(); i++ )
+    {
+        if( probe.results[i] )
+            p_demux->p_sys->streams.push_back( probe.results[i] );
+    }
+}
+
 /*****************************************************************************
  * Open: initializes matroska demux structures
  *****************************************************************************/
@@ -113,6 +243,8 @@ static int Open( vlc_object_t * p_this )
     p_demux->p_sys      = p_sys = new demux_sys_t( *p_demux );
 
     p_io_callback = new vlc_stream_io_callback( p_demux->s, false );
+    if( var_InheritBool( p_demux, "mkv-cluster-readahead" ) )
+        p_io_callback->enableReadAhead( MKV_READAHEAD_MAX );
     p_io_stream = new (std::nothrow) EbmlStream( *p_io_callback );
 
     if( p_io_stream == NULL )
@@ -178,6 +310,7 @@ static int Open( vlc_object_t * p_this )
 
             if (p_src_dir != NULL)
             {
+                std::vector<std::string> files;
                 const char *psz_file;
                 while ((psz_file = vlc_readdir(p_src_dir)) != NULL)
                 {
@@ -197,51 +330,13 @@ static int Open( vlc_object_t * p_this )
                         if (!strcasecmp(s_filename.c_str() + s_filename.length() - 4, ".mkv") ||
                             !strcasecmp(s_filename.c_str() + s_filename.length() - 4, ".mka"))
                         {
-                            // test whether this file belongs to our family
-                            const uint8_t *p_peek;
-                            bool          file_ok = false;
-                            char          *psz_url = vlc_path2uri( s_filename.c_str(), "file" );
-                            stream_t      *p_file_stream = vlc_stream_NewURL(
-                                                            p_demux,
-                                                            psz_url );
-                            /* peek the begining */
-                            if( p_file_stream &&
-                                vlc_stream_Peek( p_file_stream, &p_peek, 4 ) >= 4
-                                && p_peek[0] == 0x1a && p_peek[1] == 0x45 &&
-                                p_peek[2] == 0xdf && p_peek[3] == 0xa3 ) file_ok = true;
-
-                            if ( file_ok )
-                            {
-                                vlc_stream_io_callback *p_file_io = new vlc_stream_io_callback( p_file_stream, true );
-                                EbmlStream *p_estream = new EbmlStream(*p_file_io);
-
-                                p_stream = p_sys->AnalyseAllSegmentsFound( p_demux, p_estream );
-
-                                if ( p_stream == NULL )
-                                {
-                                    msg_Dbg( p_demux, "the file '%s' will not be used", s_filename.c_str() );
-                                    delete p_estream;
-                                    delete p_file_io;
-                                }
-                                else
-                                {
-                                    p_stream->p_io_callback = p_file_io;
-                                    p_stream->p_estream = p_estream;
-                                    p_sys->streams.push_back( p_stream );
-                                }
-                            }
-                            else
-                            {
-                                if( p_file_stream ) {
-                                    vlc_stream_Delete( p_file_stream );
-                                }
-                                msg_Dbg( p_demux, "the file '%s' cannot be opened", s_filename.c_str() );
-                            }
-                            free( psz_url );
+                            files.push_back( s_filename );
                         }
                     }
                 }
                 closedir( p_src_dir );
+
+                ProbeSiblings( p_demux, files );
             }
         }
 
@@ -311,6 +406,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
             ppp_attach = va_arg( args, input_attachment_t*** );
             pi_int = va_arg( args, int * );
 
+            p_sys->LoadLazyMetadata( false );
             if( p_sys->stored_attachments.size() <= 0 )
                 return VLC_EGENERIC;
 
@@ -334,6 +430,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 
         case DEMUX_GET_META:
             p_meta = va_arg( args, vlc_meta_t* );
+            p_sys->LoadLazyMetadata( true );
             vlc_meta_Merge( p_meta, p_sys->meta );
             return VLC_SUCCESS;
 
@@ -501,6 +598,10 @@ void BlockDecode( demux_t *p_demux, KaxBlock *block, KaxSimpleBlock *simpleblock
     demux_sys_t        *p_sys = p_demux->p_sys;
     matroska_segment_c *p_segment = p_sys->p_current_vsegment->CurrentSegment();
 
+    /* frames of block groups reference the KaxBlock buffers, simple
+     * blocks remain owned by the parser and are copied */
+    kaxblock_frames_c frames( block );
+
     if( !p_segment ) return;
 
     mkv_track_t *p_track = p_segment->FindTrackByBlock( block, simpleblock );
@@ -570,7 +671,11 @@ void BlockDecode( demux_t *p_demux, KaxBlock *block, KaxSimpleBlock *simpleblock
         else if( unlikely( track.fmt.i_codec == VLC_CODEC_WAVPACK ) )
             p_block = packetize_wavpack( track, data->Buffer(), data->Size() );
         else
-            p_block = MemToBlock( data->Buffer(), data->Size(), 0 );
+        {
+            p_block = frames.Wrap( *data );
+            if( p_block == NULL )
+                p_block = MemToBlock( data->Buffer(), data->Size(), 0 );
+        }
 
         if( p_block == NULL )
         {
@@ -810,8 +915,6 @@ static int Demux( demux_t *p_demux)
 
     BlockDecode( p_demux, block, simpleblock, p_sys->i_pts, i_block_duration, b_key_picture, b_discardable_picture );
 
-    delete block;
-
     return 1;
 }
 
@@ -113,12 +113,16 @@ enum
 
 #define MKVD_TIMECODESCALE 1000000
 
+/* biggest cluster loaded whole by the read-ahead */
+#define MKV_READAHEAD_MAX (32 * 1024 * 1024)
+
 #define MKV_IS_ID( el, C ) ( el != NULL && typeid( *el ) == typeid( C ) )
 #define MKV_CHECKED_PTR_DECL( name, type, src ) type * name = MKV_IS_ID(src, type) ? static_cast<type*>(src) : NULL
 
 
 using namespace LIBMATROSKA_NAMESPACE;
 
+/* takes ownership of the block */
 void BlockDecode( demux_t *p_demux, KaxBlock *block, KaxSimpleBlock *simpleblock,
                   mtime_t i_pts, mtime_t i_duration, bool b_key_picture,
                   bool b_discardable_picture );
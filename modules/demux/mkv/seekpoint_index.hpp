@@ -0,0 +1,96 @@
+/*****************************************************************************
+ * seekpoint_index.hpp : matroska demuxer
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef MKV_SEEKPOINT_INDEX_HPP_
+#define MKV_SEEKPOINT_INDEX_HPP_
+
+#include <vlc_common.h>
+
+#include <algorithm>
+#include <vector>
+
+// Seekpoints of a single track, sorted by pts. The fields are kept in
+// separate arrays so that lookups only walk the pts, and since blocks are
+// mostly indexed in playback order, inserting past the end is a plain append.
+
+class SeekpointIndex
+{
+    public:
+        typedef uint64_t fptr_t;
+
+        size_t size() const  { return _pts.size(); }
+        bool   empty() const { return _pts.empty(); }
+
+        fptr_t  fpos ( size_t i ) const { return _fpos[i]; }
+        mtime_t pts  ( size_t i ) const { return _pts[i]; }
+        int     trust( size_t i ) const { return _trust[i]; }
+
+        void reserve( size_t count )
+        {
+            _fpos.reserve( count );
+            _pts.reserve( count );
+            _trust.reserve( count );
+        }
+
+        // an existing entry with the same pts is only replaced by a more
+        // trusted one
+        void insert( fptr_t fpos, mtime_t pts, int trust )
+        {
+            if( _pts.empty() || _pts.back() < pts )
+            {
+                _fpos.push_back( fpos );
+                _pts.push_back( pts );
+                _trust.push_back( trust );
+                return;
+            }
+
+            size_t i = std::lower_bound( _pts.begin(), _pts.end(), pts ) - _pts.begin();
+
+            if( _pts[i] == pts )
+            {
+                if( trust <= _trust[i] )
+                    return;
+
+                _fpos[i]  = fpos;
+                _trust[i] = trust;
+            }
+            else
+            {
+                _fpos.insert( _fpos.begin() + i, fpos );
+                _pts.insert( _pts.begin() + i, pts );
+                _trust.insert( _trust.begin() + i, trust );
+            }
+        }
+
+        // index of the last entry with a pts not after the given one,
+        // or the first entry if there is none (the index must not be empty)
+        size_t greatest_lower_bound( mtime_t pts ) const
+        {
+            size_t i = std::upper_bound( _pts.begin(), _pts.end(), pts ) - _pts.begin();
+            return i ? i - 1 : 0;
+        }
+
+    private:
+        std::vector<fptr_t>  _fpos;
+        std::vector<mtime_t> _pts;
+        std::vector<int8_t>  _trust;
+};
+
+#endif /* include-guard */
@@ -34,6 +34,36 @@ vlc_stream_io_callback::vlc_stream_io_callback( stream_t *s_, bool b_owner_ )
                        : s( s_), b_owner( b_owner_ )
 {
     mb_eof = false;
+    i_readahead_max = 0;
+    i_pos = 0;
+    p_window = p_next = NULL;
+    i_window_start = i_next_start = 0;
+    i_request_start = 0;
+    i_request_size = 0;
+    b_thread = b_closing = false;
+    vlc_mutex_init( &lock );
+    vlc_cond_init( &wait );
+}
+
+vlc_stream_io_callback::~vlc_stream_io_callback()
+{
+    if( b_thread )
+    {
+        vlc_mutex_lock( &lock );
+        b_closing = true;
+        vlc_cond_signal( &wait );
+        vlc_mutex_unlock( &lock );
+        vlc_join( thread, NULL );
+    }
+    if( p_window )
+        block_Release( p_window );
+    if( p_next )
+        block_Release( p_next );
+    vlc_cond_destroy( &wait );
+    vlc_mutex_destroy( &lock );
+
+    if( b_owner )
+        vlc_stream_Delete( s );
 }
 
 uint32 vlc_stream_io_callback::read( void *p_buffer, size_t i_size )
@@ -41,6 +71,9 @@ uint32 vlc_stream_io_callback::read( void *p_buffer, size_t i_size )
     if( i_size <= 0 || mb_eof )
         return 0;
 
+    if( i_readahead_max )
+        return readWindowed( static_cast<uint8_t *>( p_buffer ), i_size );
+
     int i_ret = vlc_stream_Read( s, p_buffer, i_size );
     return i_ret < 0 ? 0 : i_ret;
 }
@@ -48,7 +81,22 @@ uint32 vlc_stream_io_callback::read( void *p_buffer, size_t i_size )
 void vlc_stream_io_callback::setFilePointer(int64_t i_offset, seek_mode mode )
 {
     int64_t i_pos, i_size;
-    int64_t i_current = vlc_stream_Tell( s );
+    int64_t i_current;
+
+    if( i_readahead_max )
+    {
+        /* only move the logical position, the stream is moved on the next
+         * read outside of the loaded ranges */
+        i_current = this->i_pos;
+        vlc_mutex_lock( &lock );
+        i_size = stream_Size( s );
+        vlc_mutex_unlock( &lock );
+    }
+    else
+    {
+        i_current = vlc_stream_Tell( s );
+        i_size = stream_Size( s );
+    }
 
     switch( mode )
     {
@@ -56,7 +104,7 @@ void vlc_stream_io_callback::setFilePointer(int64_t i_offset, seek_mode mode )
             i_pos = i_offset;
             break;
         case seek_end:
-            i_pos = stream_Size( s ) - i_offset;
+            i_pos = i_size - i_offset;
             break;
         default:
             i_pos= i_current + i_offset;
@@ -66,13 +114,19 @@ void vlc_stream_io_callback::setFilePointer(int64_t i_offset, seek_mode mode )
     if(i_pos == i_current)
         return;
 
-    if( i_pos < 0 || ( ( i_size = stream_Size( s ) ) != 0 && i_pos >= i_size ) )
+    if( i_pos < 0 || ( i_size != 0 && i_pos >= i_size ) )
     {
         mb_eof = true;
         return;
     }
 
     mb_eof = false;
+    if( i_readahead_max )
+    {
+        this->i_pos = i_pos;
+        return;
+    }
+
     if( vlc_stream_Seek( s, i_pos ) )
     {
         mb_eof = true;
@@ -84,6 +138,8 @@ uint64 vlc_stream_io_callback::getFilePointer( void )
 {
     if ( s == NULL )
         return 0;
+    if( i_readahead_max )
+        return i_pos;
     return vlc_stream_Tell( s );
 }
 
@@ -99,11 +155,170 @@ uint64 vlc_stream_io_callback::toRead( void )
     if( s == NULL)
         return 0;
 
-    i_size = stream_Size( s );
+    if( i_readahead_max )
+    {
+        vlc_mutex_lock( &lock );
+        i_size = stream_Size( s );
+        vlc_mutex_unlock( &lock );
+    }
+    else
+        i_size = stream_Size( s );
 
     if( i_size <= 0 )
         return UINT64_MAX;
 
-    return static_cast<uint64>( i_size - vlc_stream_Tell( s ) );
+    return static_cast<uint64>( i_size - getFilePointer() );
+}
+
+/*****************************************************************************
+ * Cluster read-ahead
+ *****************************************************************************
+ * Over network shares, the many small reads libebml issues per element
+ * stall playback. Clusters are instead read whole into p_window, and the
+ * range following the current cluster into p_next by a background thread.
+ * Reads outside both fall back to the stream, which is then only accessed
+ * under the lock since the thread moves it.
+ *****************************************************************************/
+void vlc_stream_io_callback::enableReadAhead( size_t i_max )
+{
+    if( i_readahead_max || i_max == 0 )
+        return;
+    i_pos = vlc_stream_Tell( s );
+    i_readahead_max = i_max;
+}
+
+bool vlc_stream_io_callback::inWindow( uint64 i_offset ) const
+{
+    return p_window && i_offset >= i_window_start &&
+           i_offset - i_window_start < p_window->i_buffer;
+}
+
+uint32 vlc_stream_io_callback::readWindowed( uint8_t *p_buffer, size_t i_size )
+{
+    size_t i_done = 0;
+
+    while( i_done < i_size )
+    {
+        if( !inWindow( i_pos ) )
+        {
+            /* the parser reached the prefetched range (this waits for the
+             * thread if it is still loading it) */
+            vlc_mutex_lock( &lock );
+            if( p_next && i_pos >= i_next_start &&
+                i_pos - i_next_start < p_next->i_buffer )
+            {
+                if( p_window )
+                    block_Release( p_window );
+                p_window = p_next;
+                i_window_start = i_next_start;
+                p_next = NULL;
+            }
+            vlc_mutex_unlock( &lock );
+        }
+
+        if( inWindow( i_pos ) )
+        {
+            size_t i_offset = i_pos - i_window_start;
+            size_t i_copy = __MIN( i_size - i_done, p_window->i_buffer - i_offset );
+            memcpy( p_buffer + i_done, p_window->p_buffer + i_offset, i_copy );
+            i_done += i_copy;
+            i_pos += i_copy;
+            continue;
+        }
+
+        ssize_t i_ret = -1;
+        vlc_mutex_lock( &lock );
+        if( vlc_stream_Tell( s ) == i_pos || vlc_stream_Seek( s, i_pos ) == VLC_SUCCESS )
+            i_ret = vlc_stream_Read( s, p_buffer + i_done, i_size - i_done );
+        vlc_mutex_unlock( &lock );
+
+        if( i_ret > 0 )
+        {
+            i_done += i_ret;
+            i_pos += i_ret;
+        }
+        break;
+    }
+
+    return i_done;
+}
+
+void vlc_stream_io_callback::readAhead( uint64 i_start, uint64 i_size )
+{
+    if( !i_readahead_max || i_size == 0 || i_size > i_readahead_max )
+        return;
+
+    vlc_mutex_lock( &lock );
+
+    if( !b_thread )
+        b_thread = !vlc_clone( &thread, ReadAheadThread, this, VLC_THREAD_PRIORITY_INPUT );
+
+    if( !inWindow( i_start ) || !inWindow( i_start + i_size - 1 ) )
+    {
+        if( p_next && i_start >= i_next_start &&
+            i_start + i_size <= i_next_start + p_next->i_buffer )
+        {
+            if( p_window )
+                block_Release( p_window );
+            p_window = p_next;
+            i_window_start = i_next_start;
+            p_next = NULL;
+        }
+        else if( vlc_stream_Tell( s ) == i_start || vlc_stream_Seek( s, i_start ) == VLC_SUCCESS )
+        {
+            block_t *p_block = vlc_stream_Block( s, i_size );
+            if( p_block )
+            {
+                if( p_window )
+                    block_Release( p_window );
+                p_window = p_block;
+                i_window_start = i_start;
+            }
+        }
+    }
+
+    /* the next cluster is expected to be about the size of this one */
+    if( b_thread && ( !p_next || i_next_start != i_start + i_size ) )
+    {
+        i_request_start = i_start + i_size;
+        i_request_size = i_size;
+        vlc_cond_signal( &wait );
+    }
+
+    vlc_mutex_unlock( &lock );
 }
 
+void *vlc_stream_io_callback::ReadAheadThread( void *p_data )
+{
+    vlc_stream_io_callback *p_this = static_cast<vlc_stream_io_callback *>( p_data );
+
+    vlc_mutex_lock( &p_this->lock );
+    while( !p_this->b_closing )
+    {
+        if( p_this->i_request_size == 0 )
+        {
+            vlc_cond_wait( &p_this->wait, &p_this->lock );
+            continue;
+        }
+
+        uint64 i_start = p_this->i_request_start;
+        size_t i_size = p_this->i_request_size;
+        p_this->i_request_size = 0;
+
+        if( vlc_stream_Tell( p_this->s ) != i_start &&
+            vlc_stream_Seek( p_this->s, i_start ) != VLC_SUCCESS )
+            continue;
+
+        block_t *p_block = vlc_stream_Block( p_this->s, i_size );
+        if( p_block )
+        {
+            if( p_this->p_next )
+                block_Release( p_this->p_next );
+            p_this->p_next = p_block;
+            p_this->i_next_start = i_start;
+        }
+    }
+    vlc_mutex_unlock( &p_this->lock );
+
+    return NULL;
+}
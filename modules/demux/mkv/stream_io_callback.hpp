@@ -33,14 +33,28 @@ class vlc_stream_io_callback: public IOCallback
     bool           mb_eof;
     bool           b_owner;
 
+    /* cluster read-ahead, only used once enabled */
+    size_t         i_readahead_max;
+    uint64         i_pos;          /* the stream may be elsewhere */
+    block_t        *p_window;      /* the cluster being parsed */
+    uint64         i_window_start;
+    block_t        *p_next;        /* filled by the thread */
+    uint64         i_next_start;
+    uint64         i_request_start;
+    size_t         i_request_size;
+    bool           b_thread;
+    bool           b_closing;
+    vlc_thread_t   thread;
+    vlc_mutex_t    lock;           /* stream, next and request */
+    vlc_cond_t     wait;
+
+    static void   *ReadAheadThread( void * );
+    bool           inWindow( uint64 ) const;
+    uint32         readWindowed( uint8_t *, size_t );
+
   public:
     vlc_stream_io_callback( stream_t *, bool );
-
-    virtual ~vlc_stream_io_callback()
-    {
-        if( b_owner )
-            vlc_stream_Delete( s );
-    }
+    virtual ~vlc_stream_io_callback();
 
     virtual uint32   read            ( void *p_buffer, size_t i_size);
     virtual void     setFilePointer  ( int64_t i_offset, seek_mode mode = seek_beginning );
@@ -48,5 +62,13 @@ class vlc_stream_io_callback: public IOCallback
     virtual uint64   getFilePointer  ( void );
     virtual void     close           ( void ) { return; }
     uint64           toRead          ( void );
+    stream_t        *stream          ( void ) const { return s; }
+
+    /* cluster read-ahead: once enabled, readAhead() loads the given range
+     * (the cluster about to be parsed) in one read, and the range following
+     * it in the background, so that parsing runs off memory */
+    void             enableReadAhead ( size_t i_max );
+    void             readAhead       ( uint64 i_start, uint64 i_size );
 };
 
+
@@ -25,7 +25,6 @@
 
 #include "dispatcher.hpp"
 
-#include <map>
 #include <vector>
 #include <string>
 #include <cstring>
@@ -33,11 +32,13 @@
 
 namespace {
   namespace detail {
-    struct CStringCompare {
-      bool operator () (char const * const& s1, char const * const& s2) const {
-        return std::strcmp (s1, s2) < 0;
-      }
-    };
+    // FNV-1a
+    static inline size_t CStringHash (char const* str) {
+      uint32_t h = UINT32_C( 2166136261 );
+      for ( ; *str; ++str)
+        h = ( h ^ static_cast<unsigned char>( *str ) ) * UINT32_C( 16777619 );
+      return h;
+    }
   }
 
   class StringDispatcher : public Dispatcher<StringDispatcher, void(*)(char const*, void*)> {
@@ -45,14 +46,53 @@ namespace {
       typedef void(*Processor)(char const*, void*);
 
       typedef std::pair<char const *, Processor>                         ProcessorEntry;
-      typedef std::map <char const *, Processor, detail::CStringCompare> ProcessorContainer;
+      typedef std::vector<ProcessorEntry>                                ProcessorContainer;
+      typedef std::vector<size_t>                                        SlotContainer;
 
       typedef std::vector<std::string>                      GlobParts;
       typedef std::vector<std::pair<GlobParts, Processor> > GlobContainer;
 
+      static const size_t EMPTY_SLOT = static_cast<size_t>( -1 );
+
     public:
+      StringDispatcher () : _mask (0) { }
+
       void insert (ProcessorEntry const& data) {
-        _processors.insert (data);
+        _processors.push_back (data);
+      }
+
+      // exact matches are looked up in an open addressing table, at most
+      // half full, built once when the dispatcher is created
+      void on_create () {
+        size_t size = 4;
+        while (size < 2 * _processors.size())
+          size *= 2;
+
+        _slots.assign (size, static_cast<size_t> (EMPTY_SLOT));
+        _mask = size - 1;
+
+        for (size_t i = 0; i < _processors.size(); ++i) {
+          size_t h = detail::CStringHash (_processors[i].first) & _mask;
+          for ( ; _slots[h] != EMPTY_SLOT; h = (h + 1) & _mask) {
+            if (!std::strcmp (_processors[_slots[h]].first, _processors[i].first))
+              break; /* first registered wins */
+          }
+          if (_slots[h] == EMPTY_SLOT)
+            _slots[h] = i;
+        }
+      }
+
+      Processor find (char const* const& str) const {
+        if (_slots.empty())
+          return NULL;
+
+        for (size_t h = detail::CStringHash (str) & _mask; _slots[h] != EMPTY_SLOT; h = (h + 1) & _mask) {
+          ProcessorEntry const& entry = _processors[_slots[h]];
+          if (!std::strcmp (entry.first, str))
+            return entry.second;
+        }
+
+        return NULL;
       }
 
       void insert_glob (ProcessorEntry const& data) {
@@ -122,11 +162,8 @@ namespace {
 
       bool send (char const* const& str, void* const& payload) const
       {
-        ProcessorContainer::const_iterator cit     = _processors.begin ();
-        ProcessorContainer::const_iterator cit_end = _processors.end ();
-
-        if ((cit = _processors.find (str)) != cit_end) {
-            cit->second (str, payload);
+        if (Processor callback = find (str)) {
+            callback (str, payload);
             return true;
         }
 
@@ -145,6 +182,8 @@ namespace {
 
     private:
       ProcessorContainer _processors;
+      SlotContainer _slots;
+      size_t _mask;
       GlobContainer _glob_processors;
   };
 
@@ -25,6 +25,8 @@
 #include "util.hpp"
 #include "demux.hpp"
 
+#include <atomic>
+
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
@@ -162,6 +164,78 @@ block_t *MemToBlock( uint8_t *p_mem, size_t i_mem, size_t offset)
 }
 
 
+struct kaxblock_shared_t
+{
+    KaxBlock              *p_block;
+    std::atomic<unsigned>  i_refs;
+};
+
+namespace
+{
+    struct frame_block_t
+    {
+        block_t            self;
+        kaxblock_shared_t *p_shared;
+    };
+
+    void kaxblock_shared_Release( kaxblock_shared_t *p_shared )
+    {
+        if( p_shared->i_refs.fetch_sub( 1 ) == 1 )
+        {
+            delete p_shared->p_block;
+            delete p_shared;
+        }
+    }
+
+    void frame_block_Release( block_t *p_block )
+    {
+        frame_block_t *p_frame = reinterpret_cast<frame_block_t *>( p_block );
+        kaxblock_shared_Release( p_frame->p_shared );
+        delete p_frame;
+    }
+}
+
+kaxblock_frames_c::kaxblock_frames_c( KaxBlock *block )
+    :p_block( block )
+    ,p_shared( NULL )
+{
+}
+
+kaxblock_frames_c::~kaxblock_frames_c()
+{
+    if( p_shared )
+        kaxblock_shared_Release( p_shared );
+    else
+        delete p_block;
+}
+
+block_t *kaxblock_frames_c::Wrap( DataBuffer & data )
+{
+    if( p_block == NULL )
+        return NULL;
+
+    if( p_shared == NULL )
+    {
+        p_shared = new (std::nothrow) kaxblock_shared_t;
+        if( unlikely( p_shared == NULL ) )
+            return NULL;
+        p_shared->p_block = p_block;
+        p_shared->i_refs = 1;
+    }
+
+    frame_block_t *p_frame = new (std::nothrow) frame_block_t;
+    if( unlikely( p_frame == NULL ) )
+        return NULL;
+
+    block_Init( &p_frame->self, data.Buffer(), data.Size() );
+    p_frame->self.pf_release = frame_block_Release;
+    p_frame->p_shared = p_shared;
+    p_shared->i_refs++;
+
+    return &p_frame->self;
+}
+
+
 void handle_real_audio(demux_t * p_demux, mkv_track_t * p_tk, block_t * p_blk, mtime_t i_pts)
 {
     uint8_t * p_frame = p_blk->p_buffer;
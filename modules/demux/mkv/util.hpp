@@ -31,6 +31,25 @@ block_t *block_zlib_decompress( vlc_object_t *p_this, block_t *p_in_block );
 #endif
 
 block_t *MemToBlock( uint8_t *p_mem, size_t i_mem, size_t offset);
+
+/* Wraps the frames of a KaxBlock as block_t, without copying them. The
+ * KaxBlock is owned: it is deleted once this and all the wrapped frames
+ * are released. */
+struct kaxblock_shared_t;
+class kaxblock_frames_c
+{
+public:
+    explicit kaxblock_frames_c( KaxBlock * );
+    ~kaxblock_frames_c();
+    block_t *Wrap( DataBuffer & );
+
+private:
+    kaxblock_frames_c( const kaxblock_frames_c & );
+    kaxblock_frames_c & operator=( const kaxblock_frames_c & );
+
+    KaxBlock          *p_block;
+    kaxblock_shared_t *p_shared;
+};
 void handle_real_audio(demux_t * p_demux, mkv_track_t * p_tk, block_t * p_blk, mtime_t i_pts);
 void send_Block( demux_t * p_demux, mkv_track_t * p_tk, block_t * p_block, unsigned int i_number_frames, mtime_t i_duration );
 
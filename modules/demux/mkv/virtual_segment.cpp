@@ -24,6 +24,7 @@
  *****************************************************************************/
 #include <vector>
 #include <new>
+#include <algorithm>
 
 #include "demux.hpp"
 
@@ -113,6 +114,7 @@ virtual_edition_c::virtual_edition_c( chapter_edition_c * p_edit, matroska_segme
     bool b_fake_ordered = false;
     p_edition = p_edit;
     b_ordered = false;
+    i_last_bound = 0;
 
     int64_t usertime_offset = 0;
 
@@ -212,6 +214,8 @@ virtual_edition_c::virtual_edition_c( chapter_edition_c * p_edit, matroska_segme
             b_ordered = true;
     }
 
+    indexChapters();
+
 #ifdef MKV_DEBUG
     msg_Dbg( &p_main_segment.sys.demuxer, "-- RECAP-BEGIN --" );
     print();
@@ -263,6 +267,51 @@ void virtual_edition_c::retimeChapters()
     }
 }
 
+static void chapterBounds( const virtual_chapter_c * p_vchap, std::vector<mtime_t> & bounds )
+{
+    if( p_vchap->i_mk_virtual_start_time >= p_vchap->i_mk_virtual_stop_time )
+        return;
+
+    bounds.push_back( p_vchap->i_mk_virtual_start_time );
+    bounds.push_back( p_vchap->i_mk_virtual_stop_time );
+
+    for( size_t i = 0; i < p_vchap->sub_vchapters.size(); i++ )
+        chapterBounds( p_vchap->sub_vchapters[i], bounds );
+}
+
+/* A time belongs to the first chapter containing it, then to the first of its
+ * sub chapters containing it, and so on. Filling the intervals from the last
+ * chapter to the first, each one over its parent, gives the same result. */
+void virtual_edition_c::indexSubChapters( virtual_chapter_c * p_vchap, mtime_t i_min, mtime_t i_max )
+{
+    mtime_t i_start = std::max( p_vchap->i_mk_virtual_start_time, i_min );
+    mtime_t i_stop  = std::min( p_vchap->i_mk_virtual_stop_time, i_max );
+    if( i_start >= i_stop )
+        return;
+
+    size_t i_first = std::lower_bound( chapter_bounds.begin(), chapter_bounds.end(), i_start ) - chapter_bounds.begin();
+    size_t i_end   = std::lower_bound( chapter_bounds.begin(), chapter_bounds.end(), i_stop ) - chapter_bounds.begin();
+    std::fill( chapter_at.begin() + i_first, chapter_at.begin() + i_end, p_vchap );
+
+    for( size_t i = p_vchap->sub_vchapters.size(); i-- > 0; )
+        indexSubChapters( p_vchap->sub_vchapters[i], i_start, i_stop );
+}
+
+void virtual_edition_c::indexChapters()
+{
+    chapter_bounds.clear();
+    for( size_t i = 0; i < vchapters.size(); i++ )
+        chapterBounds( vchapters[i], chapter_bounds );
+
+    std::sort( chapter_bounds.begin(), chapter_bounds.end() );
+    chapter_bounds.erase( std::unique( chapter_bounds.begin(), chapter_bounds.end() ), chapter_bounds.end() );
+    chapter_at.assign( chapter_bounds.size(), NULL );
+    i_last_bound = 0;
+
+    for( size_t i = vchapters.size(); i-- > 0; )
+        indexSubChapters( vchapters[i], INT64_MIN, INT64_MAX );
+}
+
 virtual_segment_c::virtual_segment_c( matroska_segment_c & main_segment, std::vector<matroska_segment_c*> & p_opened_segments )
 {
     /* Main segment */
@@ -389,25 +438,28 @@ bool virtual_chapter_c::ContainsTimestamp( int64_t time )
     return ( time >= i_mk_virtual_start_time && time < i_mk_virtual_stop_time );
 }
 
-virtual_chapter_c* virtual_chapter_c::getSubChapterbyTimecode( int64_t time )
-{
-    for( size_t i = 0; i < sub_vchapters.size(); i++ )
-    {
-        if( sub_vchapters[i]->ContainsTimestamp( time ) )
-            return sub_vchapters[i]->getSubChapterbyTimecode( time );
-    }
-
-    return this;
-}
-
 virtual_chapter_c* virtual_edition_c::getChapterbyTimecode( int64_t time )
 {
-    for( size_t i = 0; i < vchapters.size(); i++ )
+    virtual_chapter_c *p_vchap = NULL;
+    size_t i = i_last_bound;
+
+    /* most of the time we are still in the same interval */
+    if( i + 1 < chapter_bounds.size() &&
+        chapter_bounds[i] <= time && time < chapter_bounds[i + 1] )
+        p_vchap = chapter_at[i];
+    else
     {
-        if( vchapters[i]->ContainsTimestamp( time ) )
-            return vchapters[i]->getSubChapterbyTimecode( time );
+        i = std::upper_bound( chapter_bounds.begin(), chapter_bounds.end(), time ) - chapter_bounds.begin();
+        if( i > 0 )
+        {
+            i_last_bound = --i;
+            p_vchap = chapter_at[i];
+        }
     }
 
+    if( p_vchap )
+        return p_vchap;
+
     if( vchapters.size() )
     {
         virtual_chapter_c* last_chapter = vchapters.back();
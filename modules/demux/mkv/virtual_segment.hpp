@@ -48,7 +48,6 @@ public:
                                                      std::vector<matroska_segment_c*> & segments,
                                                      int64_t & usertime_offset, bool b_ordered );
 
-    virtual_chapter_c* getSubChapterbyTimecode( int64_t time );
     bool Leave( );
     bool EnterAndLeave( virtual_chapter_c *p_leaving_vchapter, bool b_enter = true );
     virtual_chapter_c * FindChapter( int64_t i_find_uid );
@@ -105,6 +104,14 @@ public:
 private:
     void retimeChapters();
     void retimeSubChapters( virtual_chapter_c * p_vchap );
+    void indexChapters();
+    void indexSubChapters( virtual_chapter_c * p_vchap, mtime_t i_min, mtime_t i_max );
+
+    /* the chapter tree flattened, chapter_at[i] is the chapter playing
+     * from chapter_bounds[i] until the next bound */
+    std::vector<mtime_t>            chapter_bounds;
+    std::vector<virtual_chapter_c*> chapter_at;
+    size_t                          i_last_bound;
 #ifdef MKV_DEBUG
     void print(){ for( size_t i = 0; i<chapters.size(); i++ ) chapters[i]->print(); }
 #endif
@@ -30,6 +30,13 @@
 #include "fragments.h"
 #include "../asf/asfpacket.h"
 
+/* Position of a sample in the runs of a stts or ctts table */
+typedef struct
+{
+    uint32_t     i_run;  /* table entry */
+    uint32_t     i_skip; /* samples of that entry before this one */
+} mp4_tts_pos_t;
+
 /* Contain all information about a chunk */
 typedef struct
 {
@@ -47,17 +54,10 @@ typedef struct
     uint64_t     i_first_dts;   /* DTS of the first sample */
     uint64_t     i_duration;    /* total duration of all samples */
 
-    uint32_t     i_entries_dts;
-    uint32_t     *p_sample_count_dts;
-    uint32_t     *p_sample_delta_dts;   /* dts delta */
-
-    uint32_t     i_entries_pts;
-    uint32_t     *p_sample_count_pts;
-    int32_t      *p_sample_offset_pts;  /* pts-dts */
-
-    uint32_t     *p_sample_size;
-    /* TODO if needed add pts
-        but quickly *add* support for edts and seeking */
+    /* where the first sample is in the stts and ctts tables, the
+       timings are read from there instead of being expanded */
+    mp4_tts_pos_t dts_pos;
+    mp4_tts_pos_t pts_pos;
 
 } mp4_chunk_t;
 
@@ -120,8 +120,26 @@ typedef struct
     /* sample size, p_sample_size defined only if i_sample_size == 0
         else i_sample_size is size for all sample */
     uint32_t         i_sample_size;
-    uint32_t         *p_sample_size; /* XXX perhaps add file offset if take
-//                                    too much time to do sumations each time*/
+    const uint32_t   *p_sample_size; /* stsz table */
+
+    /* timing tables, none of them copied */
+    const MP4_Box_data_stts_t *p_stts;
+    const MP4_Box_data_ctts_t *p_ctts; /* can be NULL */
+    int64_t          i_cts_shift;
+
+    /* last sample whose timings were looked up, so that reading in order
+       does not walk the runs from the start of the chunk every time */
+    struct
+    {
+        uint32_t      i_sample;
+        mp4_tts_pos_t pos;
+        uint64_t      i_dts;
+    } dts_cursor;
+    struct
+    {
+        uint32_t      i_sample;
+        mp4_tts_pos_t pos;
+    } pts_cursor;
 
     uint32_t     i_sample_first; /* i_sample_first value
                                                    of the next chunk */
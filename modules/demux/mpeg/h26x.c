@@ -35,6 +35,7 @@
 #include <vlc_codec.h>
 #include "../packetizer/hevc_nal.h" /* definitions, inline helpers */
 #include "../packetizer/h264_nal.h" /* definitions, inline helpers */
+#include "../packetizer/startcode_helper.h"
 
 /*****************************************************************************
  * Module descriptor
@@ -273,29 +274,36 @@ static int GenericOpen( demux_t *p_demux, const char *psz_module,
         size_t i_probe_offset = 4;
         const uint8_t *p_probe = p_peek;
         bool b_synced = true;
-        unsigned i_bitflow = 0;
 
         for( unsigned i=0; i<H26X_NAL_COUNT; i++ )
         {
             while( !b_synced )
             {
-                if( i_probe_offset + H26X_MIN_PEEK >= i_peek &&
-                    i_peek_target + H26X_PEEK_CHUNK <= H26X_MAX_PEEK )
+                /* Check for annexB, leaving enough data to probe after it */
+                const uint8_t *p_startcode = NULL;
+                if( i_probe_offset + H26X_MIN_PEEK < i_peek )
+                    p_startcode = startcode_FindAnnexB( &p_peek[i_probe_offset],
+                                                        &p_peek[i_peek - H26X_MIN_PEEK] );
+                if( p_startcode != NULL )
                 {
-                    i_peek_target += H26X_PEEK_CHUNK;
-                    i_peek = vlc_stream_Peek( p_demux->s, &p_peek, i_peek_target );
+                    i_probe_offset = p_startcode - p_peek + 3;
+                    b_synced = true;
+                    break;
                 }
 
-                if( i_probe_offset + H26X_MIN_PEEK >= i_peek )
+                if( i_peek_target + H26X_PEEK_CHUNK > H26X_MAX_PEEK )
                     break;
 
-                p_probe = &p_peek[i_probe_offset];
-                i_bitflow = (i_bitflow << 1) | (!p_probe[0]);
-                /* Check for annexB */
-                if( p_probe[0] == 0x01 && ((i_bitflow & 0x06) == 0x06) )
-                    b_synced = true;
+                /* Scan again the bytes that can start a startcode */
+                if( i_probe_offset + H26X_MIN_PEEK + 2 < i_peek )
+                    i_probe_offset = i_peek - H26X_MIN_PEEK - 2;
 
-                i_probe_offset++;
+                size_t i_prev_peek = i_peek;
+                i_peek_target += H26X_PEEK_CHUNK;
+                ssize_t i_ret_peek = vlc_stream_Peek( p_demux->s, &p_peek, i_peek_target );
+                i_peek = i_ret_peek > 0 ? i_ret_peek : 0;
+                if( i_peek <= i_prev_peek )
+                    break;
             }
 
             if( b_synced )
@@ -35,6 +35,8 @@
 #include <vlc_access.h>    /* DVB-specific things */
 #include <vlc_demux.h>
 #include <vlc_input.h>
+#include <vlc_atomic.h>
+#include <vlc_trace.h>
 
 #include "ts_pid.h"
 #include "ts_streams.h"
@@ -46,6 +48,7 @@
 #include "ts_hotfixes.h"
 #include "ts_sl.h"
 #include "ts_metadata.h"
+#include "ts_index.h"
 #include "sections.h"
 #include "pes.h"
 #include "timestamps.h"
@@ -111,6 +114,11 @@ static void Close ( vlc_object_t * );
     "Seek and position based on a percent byte position, not a PCR generated " \
     "time position. If seeking doesn't work property, turn on this option." )
 
+#define BATCH_TEXT N_("Batched packets reads")
+#define BATCH_LONGTEXT N_( \
+    "Read the packets of fast seekable streams, such as local files, " \
+    "in batches instead of one at a time." )
+
 #define PCR_TEXT N_("Trust in-stream PCR")
 #define PCR_LONGTEXT N_("Use the stream PCR as a reference.")
 
@@ -148,6 +156,7 @@ vlc_module_begin ()
 
     add_bool( "ts-split-es", true, SPLIT_ES_TEXT, SPLIT_ES_LONGTEXT, false )
     add_bool( "ts-seek-percent", false, SEEK_PERCENT_TEXT, SEEK_PERCENT_LONGTEXT, true )
+    add_bool( "ts-batch-read", true, BATCH_TEXT, BATCH_LONGTEXT, true )
 
     add_obsolete_bool( "ts-silent" );
 
@@ -181,6 +190,9 @@ static bool GatherSectionsData( demux_t *p_demux, ts_pid_t *, block_t *, size_t
 static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_prg, mtime_t i_pcr );
 
 static block_t* ReadTSPacket( demux_t *p_demux );
+static void BatchFlush( demux_sys_t * );
+static uint64_t TsTell( demux_sys_t * );
+static int TsSeek( demux_sys_t *, uint64_t );
 static int SeekToTime( demux_t *p_demux, const ts_pmt_t *, int64_t time );
 static void ReadyQueuesPostSeek( demux_t *p_demux );
 static void PCRHandle( demux_t *p_demux, ts_pid_t *, mtime_t );
@@ -191,6 +203,7 @@ static void PCRFixHandle( demux_t *, ts_pmt_t *, block_t * );
 #define TS_PACKET_SIZE_204 204
 #define TS_PACKET_SIZE_MAX 204
 #define TS_HEADER_SIZE 4
+#define TS_BATCH_PACKETS 64
 
 static int DetectPacketSize( demux_t *p_demux, unsigned *pi_header_size, int i_offset )
 {
@@ -376,6 +389,7 @@ static int Open( vlc_object_t *p_this )
     p_sys->i_network_time_update = 0;
 
     p_sys->vdr = vdr;
+    ts_seek_index_Init( &p_sys->vdrindex );
 
     p_sys->arib.b25stream = NULL;
     p_sys->stream = p_demux->s;
@@ -387,6 +401,9 @@ static int Open( vlc_object_t *p_this )
     p_sys->i_packet_size = i_packet_size;
     p_sys->i_packet_header_size = i_packet_header_size;
     p_sys->i_ts_read = 50;
+    p_sys->batch.i_size = 0;
+    p_sys->batch.p_batch = NULL;
+    p_sys->batch.i_next = p_sys->batch.i_count = 0;
     p_sys->csa = NULL;
     p_sys->b_start_record = false;
 
@@ -511,6 +528,14 @@ static int Open( vlc_object_t *p_this )
     vlc_stream_Control( p_sys->stream, STREAM_CAN_FASTSEEK,
                         &p_sys->b_canfastseek );
 
+    /* Peeking ahead would add latency to live streams */
+    if( p_sys->b_canfastseek && var_InheritBool( p_demux, "ts-batch-read" ) )
+        p_sys->batch.i_size = TS_BATCH_PACKETS;
+
+    if( p_sys->b_canseek && p_demux->psz_file )
+        ts_seek_index_LoadVDR( &p_sys->vdrindex, VLC_OBJECT(p_demux),
+                               p_demux->psz_file );
+
     /* Preparse time */
     if( p_sys->b_canseek )
     {
@@ -566,6 +591,9 @@ static void Close( vlc_object_t *p_this )
 
     vlc_mutex_destroy( &p_sys->csa_lock );
 
+    BatchFlush( p_sys );
+    ts_seek_index_Clean( &p_sys->vdrindex );
+
     /* Release all non default pids */
     ts_pid_list_Release( p_demux, &p_sys->pids );
 
@@ -927,7 +955,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 
         if( (i64 = stream_Size( p_sys->stream) ) > 0 )
         {
-            uint64_t offset = vlc_stream_Tell( p_sys->stream );
+            uint64_t offset = TsTell( p_sys );
             *pf = (double)offset / (double)i64;
             return VLC_SUCCESS;
         }
@@ -974,7 +1002,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 
         i64 = stream_Size( p_sys->stream );
         if( i64 > 0 &&
-            vlc_stream_Seek( p_sys->stream, (int64_t)(i64 * f) ) == VLC_SUCCESS )
+            TsSeek( p_sys, (int64_t)(i64 * f) ) == VLC_SUCCESS )
         {
             ReadyQueuesPostSeek( p_demux );
             return VLC_SUCCESS;
@@ -1691,20 +1719,136 @@ static bool PushPESBlock( demux_t *p_demux, ts_pid_t *pid, block_t *p_pkt, bool
     return b_ret;
 }
 
+/* Batched reads: the packets are read in a single allocation, and handed
+ * out as blocks pointing into it. It is freed along with its last packet. */
+typedef struct
+{
+    block_t     self;
+    ts_batch_t *p_batch;
+} ts_batch_packet_t;
+
+struct ts_batch_t
+{
+    atomic_uint       refs;
+    ts_batch_packet_t packets[];
+};
+
+static void BatchRelease( ts_batch_t *p_batch, unsigned i_refs )
+{
+    if( atomic_fetch_sub_explicit( &p_batch->refs, i_refs,
+                                   memory_order_acq_rel ) == i_refs )
+        free( p_batch );
+}
+
+static void BatchPacketRelease( block_t *p_block )
+{
+    ts_batch_packet_t *p_pkt = container_of( p_block, ts_batch_packet_t, self );
+    BatchRelease( p_pkt->p_batch, 1 );
+}
+
+static void BatchFlush( demux_sys_t *p_sys )
+{
+    if( p_sys->batch.p_batch )
+    {
+        BatchRelease( p_sys->batch.p_batch,
+                      p_sys->batch.i_count - p_sys->batch.i_next );
+        p_sys->batch.p_batch = NULL;
+    }
+    p_sys->batch.i_next = p_sys->batch.i_count = 0;
+}
+
+static bool BatchFill( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const unsigned i_packet_size = p_sys->i_packet_size;
+    const uint8_t *p_peek;
+
+    BatchFlush( p_sys );
+
+    ssize_t i_peek = vlc_stream_Peek( p_sys->stream, &p_peek,
+                                      i_packet_size * p_sys->batch.i_size );
+    if( i_peek < (ssize_t)i_packet_size )
+        return false;
+
+    /* Only take the packets up to a sync loss, the resync is left
+     * to the single packet reads */
+    unsigned i_count = 0;
+    for( const uint8_t *p = &p_peek[p_sys->i_packet_header_size];
+         i_count < (size_t)i_peek / i_packet_size && *p == 0x47;
+         p += i_packet_size )
+        i_count++;
+    if( i_count == 0 )
+        return false;
+
+    const size_t i_data = (size_t)i_count * i_packet_size;
+    ts_batch_t *p_batch = malloc( sizeof(*p_batch) +
+                                  i_count * sizeof(ts_batch_packet_t) + i_data );
+    if( unlikely(p_batch == NULL) )
+        return false;
+
+    uint8_t *p_data = (uint8_t *) &p_batch->packets[i_count];
+    if( vlc_stream_Read( p_sys->stream, p_data, i_data ) != (ssize_t)i_data )
+    {
+        free( p_batch );
+        return false;
+    }
+
+    atomic_init( &p_batch->refs, i_count );
+    for( unsigned i = 0; i < i_count; i++ )
+    {
+        ts_batch_packet_t *p_pkt = &p_batch->packets[i];
+        block_Init( &p_pkt->self, &p_data[i * i_packet_size], i_packet_size );
+        p_pkt->self.pf_release = BatchPacketRelease;
+        p_pkt->p_batch = p_batch;
+    }
+
+    p_sys->batch.p_batch = p_batch;
+    p_sys->batch.i_count = i_count;
+    return true;
+}
+
+/* Position of the next packet, not counting the batched ones */
+static uint64_t TsTell( demux_sys_t *p_sys )
+{
+    return vlc_stream_Tell( p_sys->stream ) - (uint64_t)p_sys->i_packet_size *
+           ( p_sys->batch.i_count - p_sys->batch.i_next );
+}
+
+static int TsSeek( demux_sys_t *p_sys, uint64_t i_pos )
+{
+    BatchFlush( p_sys );
+    return vlc_stream_Seek( p_sys->stream, i_pos );
+}
+
 static block_t* ReadTSPacket( demux_t *p_demux )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
 
     block_t     *p_pkt;
 
+    vlc_trace_Scope( "ts read" );
+
+    if( p_sys->batch.i_size &&
+        ( p_sys->batch.i_next < p_sys->batch.i_count || BatchFill( p_demux ) ) )
+    {
+        /* Sync bytes were already checked for the whole batch */
+        p_pkt = &p_sys->batch.p_batch->packets[p_sys->batch.i_next++].self;
+        if( p_sys->batch.i_next == p_sys->batch.i_count )
+            p_sys->batch.p_batch = NULL; /* now only owned by its packets */
+
+        p_pkt->p_buffer += p_sys->i_packet_header_size;
+        p_pkt->i_buffer -= p_sys->i_packet_header_size;
+        return p_pkt;
+    }
+
     /* Get a new TS packet */
     if( !( p_pkt = vlc_stream_Block( p_sys->stream, p_sys->i_packet_size ) ) )
     {
         int64_t size = stream_Size( p_sys->stream );
-        if( size >= 0 && (uint64_t)size == vlc_stream_Tell( p_sys->stream ) )
-            msg_Dbg( p_demux, "EOF at %"PRIu64, vlc_stream_Tell( p_sys->stream ) );
+        if( size >= 0 && (uint64_t)size == TsTell( p_sys ) )
+            msg_Dbg( p_demux, "EOF at %"PRIu64, TsTell( p_sys ) );
         else
-            msg_Dbg( p_demux, "Can't read TS packet at %"PRIu64, vlc_stream_Tell(p_sys->stream) );
+            msg_Dbg( p_demux, "Can't read TS packet at %"PRIu64, TsTell( p_sys ) );
         return NULL;
     }
 
@@ -1873,13 +2017,13 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, int64_t i_scaled
 
     /* Deal with common but worst binary search case */
     if( p_pmt->pcr.i_first == i_scaledtime && p_sys->b_canseek )
-        return vlc_stream_Seek( p_sys->stream, 0 );
+        return TsSeek( p_sys, 0 );
 
     const int64_t i_stream_size = stream_Size( p_sys->stream );
     if( !p_sys->b_canfastseek || i_stream_size < p_sys->i_packet_size )
         return VLC_EGENERIC;
 
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    const uint64_t i_initial_pos = TsTell( p_sys );
 
     /* Find the time position by using binary search algorithm. */
     uint64_t i_head_pos = 0;
@@ -1887,6 +2031,16 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, int64_t i_scaled
     if( i_head_pos >= i_tail_pos )
         return VLC_EGENERIC;
 
+    /* Start from the known positions around that time, if any */
+    const mtime_t i_reltime = TimeStampWrapAround( p_pmt->pcr.i_first, i_scaledtime )
+                            - p_pmt->pcr.i_first;
+    const mtime_t i_tolerance = TO_SCALE(VLC_TS_0 + CLOCK_FREQ / 2);
+    if( ts_seek_index_Lookup( &p_pmt->seekindex, i_reltime, i_tolerance,
+                              &i_head_pos, &i_tail_pos ) ||
+        ts_seek_index_Lookup( &p_sys->vdrindex, i_reltime, i_tolerance,
+                              &i_head_pos, &i_tail_pos ) )
+        return TsSeek( p_sys, i_head_pos );
+
     bool b_found = false;
     while( (i_head_pos + p_sys->i_packet_size) <= i_tail_pos && !b_found )
     {
@@ -1895,7 +2049,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, int64_t i_scaled
         uint64_t i_div = i_splitpos % p_sys->i_packet_size;
         i_splitpos -= i_div;
 
-        if ( vlc_stream_Seek( p_sys->stream, i_splitpos ) != VLC_SUCCESS )
+        if ( TsSeek( p_sys, i_splitpos ) != VLC_SUCCESS )
             break;
 
         uint64_t i_pos = i_splitpos;
@@ -1909,7 +2063,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, int64_t i_scaled
                 break;
             }
             else
-                i_pos = vlc_stream_Tell( p_sys->stream );
+                i_pos = TsTell( p_sys );
 
             int i_pid = PIDGet( p_pkt );
             ts_pid_t *p_pid = GetPID(p_sys, i_pid);
@@ -1966,7 +2120,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, int64_t i_scaled
     if( !b_found )
     {
         msg_Dbg( p_demux, "Seek():cannot find a time position." );
-        vlc_stream_Seek( p_sys->stream, i_initial_pos );
+        TsSeek( p_sys, i_initial_pos );
         return VLC_EGENERIC;
     }
     return VLC_SUCCESS;
@@ -2049,7 +2203,7 @@ static int ProbeChunk( demux_t *p_demux, int i_program, bool b_end, int64_t *pi_
                         if( b_end )
                         {
                             p_pmt->i_last_dts = *pi_pcr;
-                            p_pmt->i_last_dts_byte = vlc_stream_Tell( p_sys->stream );
+                            p_pmt->i_last_dts_byte = TsTell( p_sys );
                         }
                         /* Start, only keep first */
                         else if( b_pcrresult && p_pmt->pcr.i_first == -1 )
@@ -2077,7 +2231,7 @@ static int ProbeChunk( demux_t *p_demux, int i_program, bool b_end, int64_t *pi_
 int ProbeStart( demux_t *p_demux, int i_program )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    const uint64_t i_initial_pos = TsTell( p_sys );
     int64_t i_stream_size = stream_Size( p_sys->stream );
 
     int i_probe_count = 0;
@@ -2090,7 +2244,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
         i_pos = p_sys->i_packet_size * i_probe_count;
         i_pos = __MIN( i_pos, i_stream_size );
 
-        if( vlc_stream_Seek( p_sys->stream, i_pos ) )
+        if( TsSeek( p_sys, i_pos ) )
             return VLC_EGENERIC;
 
         ProbeChunk( p_demux, i_program, false, &i_pcr, &b_found );
@@ -2099,7 +2253,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
         i_probe_count += PROBE_CHUNK_COUNT;
     } while( i_pos > 0 && (i_pcr == -1 || !b_found) && i_probe_count < (2 * PROBE_CHUNK_COUNT) );
 
-    if( vlc_stream_Seek( p_sys->stream, i_initial_pos ) )
+    if( TsSeek( p_sys, i_initial_pos ) )
         return VLC_EGENERIC;
 
     return (b_found) ? VLC_SUCCESS : VLC_EGENERIC;
@@ -2108,7 +2262,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
 int ProbeEnd( demux_t *p_demux, int i_program )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    const uint64_t i_initial_pos = TsTell( p_sys );
     int64_t i_stream_size = stream_Size( p_sys->stream );
 
     int i_probe_count = PROBE_CHUNK_COUNT;
@@ -2121,7 +2275,7 @@ int ProbeEnd( demux_t *p_demux, int i_program )
         i_pos = i_stream_size - (p_sys->i_packet_size * i_probe_count);
         i_pos = __MAX( i_pos, 0 );
 
-        if( vlc_stream_Seek( p_sys->stream, i_pos ) )
+        if( TsSeek( p_sys, i_pos ) )
             return VLC_EGENERIC;
 
         ProbeChunk( p_demux, i_program, true, &i_pcr, &b_found );
@@ -2130,7 +2284,7 @@ int ProbeEnd( demux_t *p_demux, int i_program )
         i_probe_count += PROBE_CHUNK_COUNT;
     } while( i_pos > 0 && (i_pcr == -1 || !b_found) && i_probe_count < (6 * PROBE_CHUNK_COUNT) );
 
-    if( vlc_stream_Seek( p_sys->stream, i_initial_pos ) )
+    if( TsSeek( p_sys, i_initial_pos ) )
         return VLC_EGENERIC;
 
     return (b_found) ? VLC_SUCCESS : VLC_EGENERIC;
@@ -2181,10 +2335,10 @@ static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_pmt, mtime_t i_pcr )
         es_out_Control( p_demux->out, ES_OUT_SET_GROUP_PCR, p_pmt->i_number, FROM_SCALE(i_pcr) );
         /* growing files/named fifo handling */
         if( p_sys->b_access_control == false &&
-            vlc_stream_Tell( p_sys->stream ) > p_pmt->i_last_dts_byte )
+            TsTell( p_sys ) > p_pmt->i_last_dts_byte )
         {
             p_pmt->i_last_dts = i_pcr;
-            p_pmt->i_last_dts_byte = vlc_stream_Tell( p_sys->stream );
+            p_pmt->i_last_dts_byte = TsTell( p_sys );
         }
     }
 }
@@ -2311,6 +2465,11 @@ static void PCRHandle( demux_t *p_demux, ts_pid_t *pid, mtime_t i_pcr )
                 /* We've found a target group for update */
                 PCRCheckDTS( p_demux, p_pmt, i_pcr );
                 ProgramSetPCR( p_demux, p_pmt, i_program_pcr );
+
+                if( p_sys->b_canseek && p_pmt->pcr.i_first > -1 )
+                    ts_seek_index_Add( &p_pmt->seekindex,
+                                       i_program_pcr - p_pmt->pcr.i_first,
+                                       TsTell( p_sys ) - p_sys->i_packet_size );
             }
         }
 
@@ -44,6 +44,8 @@ typedef struct
     int i_service;
 } vdr_info_t;
 
+typedef struct ts_batch_t ts_batch_t;
+
 struct demux_sys_t
 {
     stream_t   *stream;
@@ -60,6 +62,15 @@ struct demux_sys_t
     /* how many TS packet we read at once */
     unsigned    i_ts_read;
 
+    /* Batched packets reads, see ReadTSPacket */
+    struct
+    {
+        unsigned    i_size;     /* packets per read, 0 if disabled */
+        ts_batch_t *p_batch;    /* until all its packets are handed out */
+        unsigned    i_next;
+        unsigned    i_count;
+    } batch;
+
     bool        b_ignore_time_for_positions;
 
     ts_standards_e standard;
@@ -124,6 +135,7 @@ struct demux_sys_t
     } patfix;
 
     vdr_info_t  vdr;
+    ts_seek_index_t vdrindex; /* from the recording index file */
 
     /* downloadable content */
     vlc_dictionary_t attachments;
@@ -24,6 +24,7 @@
 #include <vlc_demux.h>
 
 #include "ts_pid.h"
+#include "ts_index.h"
 #include "ts.h"
 
 #include "ts_arib.h"
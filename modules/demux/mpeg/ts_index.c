@@ -0,0 +1,192 @@
+/*****************************************************************************
+ * ts_index.c : MPEG TS time to byte position index
+ *****************************************************************************
+ * Copyright (C) 2017 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_arrays.h>
+#include <vlc_charset.h>
+#include <vlc_fs.h>
+
+#include <stdio.h>
+
+#include "ts_index.h"
+
+void ts_seek_index_Init( ts_seek_index_t *p_index )
+{
+    ARRAY_INIT( p_index->points );
+}
+
+void ts_seek_index_Clean( ts_seek_index_t *p_index )
+{
+    ARRAY_RESET( p_index->points );
+}
+
+/* Index of the first point after i_time */
+static int UpperBound( const ts_seek_index_t *p_index, mtime_t i_time )
+{
+    int i_low = 0, i_high = p_index->points.i_size;
+    while( i_low < i_high )
+    {
+        int i_mid = i_low + (i_high - i_low) / 2;
+        if( p_index->points.p_elems[i_mid].i_time <= i_time )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
+    return i_low;
+}
+
+void ts_seek_index_Add( ts_seek_index_t *p_index, mtime_t i_time, uint64_t i_pos )
+{
+    const int i_size = p_index->points.i_size;
+    const ts_seekpoint_t point = { i_time, i_pos };
+
+    /* Common case, while playing forward */
+    if( i_size == 0 ||
+        p_index->points.p_elems[i_size - 1].i_time < i_time )
+    {
+        if( i_size && i_time - p_index->points.p_elems[i_size - 1].i_time
+                      < TS_SEEK_INDEX_INTERVAL )
+            return;
+        ARRAY_APPEND( p_index->points, point );
+        return;
+    }
+
+    const int i = UpperBound( p_index, i_time );
+    if( i > 0 && i_time - p_index->points.p_elems[i - 1].i_time
+                 < TS_SEEK_INDEX_INTERVAL )
+        return;
+    if( i < i_size && p_index->points.p_elems[i].i_time - i_time
+                      < TS_SEEK_INDEX_INTERVAL )
+        return;
+    ARRAY_INSERT( p_index->points, point, i );
+}
+
+bool ts_seek_index_Lookup( const ts_seek_index_t *p_index, mtime_t i_time,
+                           mtime_t i_tolerance,
+                           uint64_t *pi_head, uint64_t *pi_tail )
+{
+    const int i = UpperBound( p_index, i_time );
+
+    if( i < p_index->points.i_size &&
+        p_index->points.p_elems[i].i_pos < *pi_tail )
+        *pi_tail = p_index->points.p_elems[i].i_pos;
+
+    if( i == 0 )
+        return false;
+
+    const ts_seekpoint_t *p_point = &p_index->points.p_elems[i - 1];
+    if( i_time - p_point->i_time < i_tolerance )
+    {
+        *pi_head = p_point->i_pos;
+        return true;
+    }
+    if( p_point->i_pos > *pi_head )
+        *pi_head = p_point->i_pos;
+    return false;
+}
+
+/* The index entries of a recording are one per frame, little endian:
+ * offset:40, reserved:7, independent:1, file number:16 (bit fields) */
+#define VDR_INDEX_ENTRY_SIZE 8
+
+static double ReadVDRFrameRate( const char *psz_path )
+{
+    double f_fps = 25.; /* VDR default */
+
+    FILE *p_file = vlc_fopen( psz_path, "rt" );
+    if( p_file == NULL )
+        return f_fps;
+
+    char psz_line[256];
+    while( fgets( psz_line, sizeof(psz_line), p_file ) )
+    {
+        if( psz_line[0] == 'F' && psz_line[1] == ' ' )
+        {
+            double f = us_atof( &psz_line[2] );
+            if( f > 0. )
+                f_fps = f;
+            break;
+        }
+    }
+    fclose( p_file );
+    return f_fps;
+}
+
+int ts_seek_index_LoadVDR( ts_seek_index_t *p_index, vlc_object_t *p_obj,
+                           const char *psz_file )
+{
+    /* Recordings are directories of 00001.ts, 00002.ts... files */
+    const char *psz_name = strrchr( psz_file, DIR_SEP_CHAR );
+    psz_name = psz_name ? psz_name + 1 : psz_file;
+    if( strlen( psz_name ) != 8 || strspn( psz_name, "0123456789" ) != 5 ||
+        strcmp( &psz_name[5], ".ts" ) )
+        return VLC_EGENERIC;
+
+    const unsigned i_number = atoi( psz_name );
+    const int i_dir = psz_name - psz_file;
+
+    char *psz_path;
+    if( asprintf( &psz_path, "%.*sinfo", i_dir, psz_file ) == -1 )
+        return VLC_ENOMEM;
+    const double f_fps = ReadVDRFrameRate( psz_path );
+    free( psz_path );
+
+    if( asprintf( &psz_path, "%.*sindex", i_dir, psz_file ) == -1 )
+        return VLC_ENOMEM;
+    FILE *p_file = vlc_fopen( psz_path, "rb" );
+    free( psz_path );
+    if( p_file == NULL )
+        return VLC_EGENERIC;
+
+    /* Frame numbers count from the start of the recording, and the
+     * times from the start of that file */
+    int64_t i_first = -1;
+    bool b_done = false;
+    uint8_t entries[VDR_INDEX_ENTRY_SIZE * 512];
+    size_t i_entries;
+    for( int64_t i_frame = 0; !b_done &&
+         (i_entries = fread( entries, VDR_INDEX_ENTRY_SIZE,
+                             ARRAY_SIZE(entries) / VDR_INDEX_ENTRY_SIZE,
+                             p_file )) > 0; )
+    {
+        for( size_t i = 0; i < i_entries && !b_done; i++, i_frame++ )
+        {
+            const uint64_t i_entry = GetQWLE( &entries[i * VDR_INDEX_ENTRY_SIZE] );
+            if( (i_entry >> 48) != i_number )
+            {
+                b_done = i_first >= 0; /* next file */
+                continue;
+            }
+            if( i_first < 0 )
+                i_first = i_frame;
+            if( i_entry & (UINT64_C(1) << 47) ) /* independent */
+                ts_seek_index_Add( p_index,
+                                   (i_frame - i_first) * 90000 / f_fps,
+                                   i_entry & UINT64_C(0xFFFFFFFFFF) );
+        }
+    }
+    fclose( p_file );
+
+    msg_Dbg( p_obj, "loaded %d points from the VDR index",
+             p_index->points.i_size );
+    return p_index->points.i_size ? VLC_SUCCESS : VLC_EGENERIC;
+}
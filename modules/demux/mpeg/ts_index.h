@@ -0,0 +1,53 @@
+/*****************************************************************************
+ * ts_index.h : MPEG TS time to byte position index
+ *****************************************************************************
+ * Copyright (C) 2017 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef VLC_TS_INDEX_H
+#define VLC_TS_INDEX_H
+
+/* Minimum time between two points, in 90kHz units */
+#define TS_SEEK_INDEX_INTERVAL 90000
+
+typedef struct
+{
+    mtime_t  i_time; /* 90kHz, relative to the program first PCR */
+    uint64_t i_pos;
+} ts_seekpoint_t;
+
+/* Sparse, sorted by time (and so by position) */
+typedef struct
+{
+    DECL_ARRAY(ts_seekpoint_t) points;
+} ts_seek_index_t;
+
+void ts_seek_index_Init( ts_seek_index_t * );
+void ts_seek_index_Clean( ts_seek_index_t * );
+
+void ts_seek_index_Add( ts_seek_index_t *, mtime_t i_time, uint64_t i_pos );
+
+/* Returns true and sets *pi_head if a point is less than i_tolerance
+ * before i_time. Otherwise narrows [*pi_head, *pi_tail] to the positions
+ * of the points around i_time, and returns false. */
+bool ts_seek_index_Lookup( const ts_seek_index_t *, mtime_t i_time,
+                           mtime_t i_tolerance,
+                           uint64_t *pi_head, uint64_t *pi_tail );
+
+/* Reads the VDR (1.7+) index file of the recording, if file is one */
+int ts_seek_index_LoadVDR( ts_seek_index_t *, vlc_object_t *,
+                           const char *psz_file );
+
+#endif
@@ -26,6 +26,7 @@
 #include "ts_pid.h"
 #include "ts_streams.h"
 
+#include "ts_index.h"
 #include "ts.h"
 
 #include <assert.h>
@@ -41,8 +42,8 @@ void ts_pid_list_Init( ts_pid_list_t *p_list )
     p_list->pp_all = NULL;
     p_list->i_all = 0;
     p_list->i_all_alloc = 0;
-    p_list->i_last_pid = 0;
-    p_list->p_last = NULL;
+    for( int i = 0; i < PID_TABLE_BLOCKS; i++ )
+        p_list->pp_table[i] = NULL;
 }
 
 void ts_pid_list_Release( demux_t *p_demux, ts_pid_list_t *p_list )
@@ -57,6 +58,9 @@ void ts_pid_list_Release( demux_t *p_demux, ts_pid_list_t *p_list )
         free( pid );
     }
     free( p_list->pp_all );
+
+    for( int i = 0; i < PID_TABLE_BLOCKS; i++ )
+        free( p_list->pp_table[i] );
 }
 
 struct searchkey
@@ -84,11 +88,27 @@ ts_pid_t * ts_pid_Get( ts_pid_list_t *p_list, uint16_t i_pid )
         case 0x1FFF:
             return &p_list->dummy;
         default:
-            if( p_list->i_last_pid == i_pid )
-                return p_list->p_last;
+            if( unlikely(i_pid > 0x1FFF) )
+                return &p_list->dummy;
         break;
     }
 
+    ts_pid_t ***ppp_block = &p_list->pp_table[i_pid >> PID_TABLE_BITS];
+    const unsigned i_slot = i_pid & ((1 << PID_TABLE_BITS) - 1);
+
+    if( likely(*ppp_block && (*ppp_block)[i_slot]) )
+        return (*ppp_block)[i_slot];
+
+    if( *ppp_block == NULL )
+    {
+        *ppp_block = calloc( 1 << PID_TABLE_BITS, sizeof(ts_pid_t *) );
+        if( !*ppp_block )
+        {
+            abort();
+            //return NULL;
+        }
+    }
+
     size_t i_index = 0;
     ts_pid_t *p_pid = NULL;
 
@@ -147,8 +167,7 @@ ts_pid_t * ts_pid_Get( ts_pid_list_t *p_list, uint16_t i_pid )
 
     }
 
-    p_list->p_last = p_pid;
-    p_list->i_last_pid = i_pid;
+    (*ppp_block)[i_slot] = p_pid;
 
     return p_pid;
 }
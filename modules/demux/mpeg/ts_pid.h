@@ -79,6 +79,10 @@ struct ts_pid_t
 
 };
 
+/* direct PID lookup table, in blocks allocated on first use */
+#define PID_TABLE_BITS   6
+#define PID_TABLE_BLOCKS (0x2000 >> PID_TABLE_BITS)
+
 struct ts_pid_list_t
 {
     ts_pid_t   pat;
@@ -88,9 +92,8 @@ struct ts_pid_list_t
     ts_pid_t **pp_all;
     int        i_all;
     int        i_all_alloc;
-    /* last recently used */
-    uint16_t   i_last_pid;
-    ts_pid_t  *p_last;
+    /* same pids, indexed by pid value */
+    ts_pid_t **pp_table[PID_TABLE_BLOCKS];
 
 };
 
@@ -44,6 +44,7 @@
 #include "ts_psip_dvbpsi_fixes.h"
 
 #include "ts_pid.h"
+#include "ts_index.h"
 #include "ts.h"
 #include "ts_streams_private.h"
 #include "ts_scte.h"
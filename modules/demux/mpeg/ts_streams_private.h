@@ -23,6 +23,7 @@ typedef struct dvbpsi_s dvbpsi_t;
 typedef struct ts_sections_processor_t ts_sections_processor_t;
 
 #include "mpeg4_iod.h"
+#include "ts_index.h"
 
 #include <vlc_common.h>
 #include <vlc_es.h>
@@ -75,6 +76,9 @@ struct ts_pmt_t
     mtime_t i_last_dts;
     uint64_t i_last_dts_byte;
 
+    /* PCR positions met while demuxing */
+    ts_seek_index_t seekindex;
+
     /* ARIB specific */
     struct
     {
@@ -427,6 +427,10 @@ static int Demux( demux_t * p_demux )
             {
                 continue;
             }
+
+            /* Learn the page positions for the next seeks */
+            Oggseek_IndexPage( p_stream, &p_sys->current_page,
+                               p_sys->i_page_pos );
         }
 
         /* clear the finished flag if pages after eos (ex: after a seek) */
@@ -994,6 +998,10 @@ static int Ogg_ReadPage( demux_t *p_demux, ogg_page *p_oggpage )
         ogg_sync_wrote( &p_ogg->oy, i_read );
     }
 
+    /* The page was the last one out of the buffered data */
+    p_ogg->i_page_pos = vlc_stream_Tell( p_demux->s )
+                      - ( p_ogg->oy.fill - p_ogg->oy.returned )
+                      - p_oggpage->header_len - p_oggpage->body_len;
     return VLC_SUCCESS;
 }
 
@@ -2205,6 +2213,7 @@ static int Ogg_BeginningOfStream( demux_t *p_demux )
 
         /* initialise kframe index */
         p_stream->idx=NULL;
+        p_stream->i_idx = p_stream->i_idx_max = 0;
 
         if ( p_stream->fmt.i_bitrate == 0  &&
              ( p_stream->fmt.i_cat == VIDEO_ES ||
@@ -2296,10 +2305,7 @@ static void Ogg_LogicalStreamDelete( demux_t *p_demux, logical_stream_t *p_strea
     es_format_Clean( &p_stream->fmt_old );
     es_format_Clean( &p_stream->fmt );
 
-    if ( p_stream->idx != NULL)
-    {
-        oggseek_index_entries_free( p_stream->idx );
-    }
+    oggseek_index_entries_free( p_stream );
 
     Ogg_FreeSkeleton( p_stream->p_skel );
     p_stream->p_skel = NULL;
@@ -101,6 +101,8 @@ typedef struct logical_stream_s
 
     /* keyframe index for seeking, created as we discover keyframes */
     demux_index_entry_t *idx;
+    size_t i_idx;
+    size_t i_idx_max;
 
     /* Skeleton data */
     ogg_skeleton_t *p_skel;
@@ -206,8 +208,9 @@ struct demux_sys_t
     /* offset position in file (for reading) */
     int64_t i_input_position;
 
-    /* current page being parsed */
+    /* current page being parsed, and its position when played */
     ogg_page current_page;
+    int64_t i_page_pos;
 
     /* */
     vlc_meta_t          *p_meta;
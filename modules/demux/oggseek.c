@@ -67,115 +67,123 @@ typedef struct packetStartCoordinates
 * index entries
 *************************************************************/
 
-/* free all entries in index list */
+/* free all entries in index */
 
-void oggseek_index_entries_free ( demux_index_entry_t *idx )
+void oggseek_index_entries_free ( logical_stream_t *p_stream )
 {
-    demux_index_entry_t *idx_next;
-
-    while ( idx != NULL )
-    {
-        idx_next = idx->p_next;
-        free( idx );
-        idx = idx_next;
-    }
+    free( p_stream->idx );
+    p_stream->idx = NULL;
+    p_stream->i_idx = p_stream->i_idx_max = 0;
 }
 
+/* first entry at or after the page position */
 
-/* internal function to create a new list member */
-
-static demux_index_entry_t *index_entry_new( void )
+static size_t OggSeekIndexLowerBound( const logical_stream_t *p_stream,
+                                      int64_t i_pagepos )
 {
-    demux_index_entry_t *idx = xmalloc( sizeof( demux_index_entry_t ) );
-    if ( !idx ) return NULL;
-    idx->p_next = idx->p_prev = NULL;
-    idx->i_pagepos_end = -1;
-    return idx;
+    size_t i_low = 0, i_high = p_stream->i_idx;
+
+    while ( i_low < i_high )
+    {
+        size_t i_mid = i_low + ( i_high - i_low ) / 2;
+        if ( p_stream->idx[i_mid].i_pagepos < i_pagepos )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
+    return i_low;
 }
 
 /* We insert into index, sorting by pagepos (as a page can match multiple
-   time stamps) */
+   time stamps). The returned entry is valid until the next insertion. */
 const demux_index_entry_t *OggSeek_IndexAdd ( logical_stream_t *p_stream,
                                              int64_t i_timestamp,
                                              int64_t i_pagepos )
 {
-    demux_index_entry_t *idx;
-    demux_index_entry_t *last_idx = NULL;
-
     if ( p_stream == NULL ) return NULL;
 
-    idx = p_stream->idx;
-
     if ( i_timestamp < 1 || i_pagepos < 1 ) return NULL;
 
-    if ( idx == NULL )
-    {
-        demux_index_entry_t *ie = index_entry_new();
-        if ( !ie ) return NULL;
-        ie->i_value = i_timestamp;
-        ie->i_pagepos = i_pagepos;
-        p_stream->idx = ie;
-        return ie;
-    }
+    size_t i = OggSeekIndexLowerBound( p_stream, i_pagepos );
 
-    while ( idx != NULL )
-    {
-        if ( idx->i_pagepos > i_pagepos ) break;
-        last_idx = idx;
-        idx = idx->p_next;
-    }
+    if ( i < p_stream->i_idx && p_stream->idx[i].i_pagepos == i_pagepos )
+        return &p_stream->idx[i]; /* already known page */
 
-    /* new entry; insert after last_idx */
-    idx = index_entry_new();
-    if ( !idx ) return NULL;
-    if ( last_idx != NULL )
-    {
-        idx->p_next = last_idx->p_next;
-        last_idx->p_next = idx;
-        idx->p_prev = last_idx;
-    }
-    else
+    if ( p_stream->i_idx >= p_stream->i_idx_max )
     {
-        idx->p_next = p_stream->idx;
-        p_stream->idx = idx;
+        size_t i_max = p_stream->i_idx_max ? p_stream->i_idx_max * 2 : 256;
+        demux_index_entry_t *p_realloc =
+            realloc( p_stream->idx, i_max * sizeof( *p_realloc ) );
+        if ( !p_realloc ) return NULL;
+        p_stream->idx = p_realloc;
+        p_stream->i_idx_max = i_max;
     }
 
-    if ( idx->p_next != NULL )
-    {
-        idx->p_next->p_prev = idx;
-    }
+    memmove( &p_stream->idx[i + 1], &p_stream->idx[i],
+             ( p_stream->i_idx - i ) * sizeof( *p_stream->idx ) );
+    p_stream->idx[i].i_value = i_timestamp;
+    p_stream->idx[i].i_pagepos = i_pagepos;
+    p_stream->i_idx++;
+
+    return &p_stream->idx[i];
+}
+
+/* Records a page read while playing, if decoding can start from it */
+void Oggseek_IndexPage( logical_stream_t *p_stream, const ogg_page *p_page,
+                        int64_t i_pagepos )
+{
+    int64_t i_granule = ogg_page_granulepos( p_page );
+
+    if ( i_granule <= 0 || i_pagepos < p_stream->i_data_start ||
+         Ogg_GetKeyframeGranule( p_stream, i_granule ) != i_granule )
+        return;
 
-    idx->i_value = i_timestamp;
-    idx->i_pagepos = i_pagepos;
+    int64_t i_time = Oggseek_GranuleToAbsTimestamp( p_stream, i_granule, false );
+    if ( i_time <= 0 )
+        return;
+
+    /* Keep the index sparse while playing */
+    size_t i = OggSeekIndexLowerBound( p_stream, i_pagepos );
+    if ( i > 0 && i_time - p_stream->idx[i - 1].i_value < OGGSEEK_INDEX_SPACING )
+        return;
+    if ( i < p_stream->i_idx &&
+         p_stream->idx[i].i_value - i_time < OGGSEEK_INDEX_SPACING )
+        return;
 
-    return idx;
+    OggSeek_IndexAdd( p_stream, i_time, i_pagepos );
 }
 
+/* Finds the entries around the timestamp. The times of the entries are
+ * returned too, or -1 if unknown. */
 static bool OggSeekIndexFind ( logical_stream_t *p_stream, int64_t i_timestamp,
-                               int64_t *pi_pos_lower, int64_t *pi_pos_upper )
+                               int64_t *pi_pos_lower, int64_t *pi_pos_upper,
+                               int64_t *pi_time_lower, int64_t *pi_time_upper )
 {
-    demux_index_entry_t *idx = p_stream->idx;
+    size_t i_low = 0, i_high = p_stream->i_idx;
 
-    while ( idx != NULL )
+    /* first entry after the timestamp, the times grow with the positions */
+    while ( i_low < i_high )
     {
-        if ( idx->i_value <= i_timestamp )
-        {
-            if ( !idx->p_next ) /* found on last index */
-            {
-                *pi_pos_lower = idx->i_pagepos;
-                return true;
-            }
-            if ( idx->p_next->i_value > i_timestamp )
-            {
-                *pi_pos_lower = idx->i_pagepos;
-                *pi_pos_upper = idx->p_next->i_pagepos;
-                return true;
-            }
-        }
-        idx = idx->p_next;
+        size_t i_mid = i_low + ( i_high - i_low ) / 2;
+        if ( p_stream->idx[i_mid].i_value <= i_timestamp )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
     }
 
-    return false;
+    if ( i_low == 0 )
+        return false;
+
+    *pi_pos_lower = p_stream->idx[i_low - 1].i_pagepos;
+    if ( pi_time_lower )
+        *pi_time_lower = p_stream->idx[i_low - 1].i_value;
+    if ( i_low < p_stream->i_idx )
+    {
+        *pi_pos_upper = p_stream->idx[i_low].i_pagepos;
+        if ( pi_time_upper )
+            *pi_time_upper = p_stream->idx[i_low].i_value;
+    }
+    return true;
 }
 
 /*********************************************************************
@@ -344,7 +352,7 @@ static int64_t find_first_page_granule( demux_t *p_demux,
     if ( i_pos1 == p_stream->i_data_start )
         return p_sys->i_input_position;
 
-    if ( i_bytes_to_read > OGGSEEK_BYTES_TO_READ ) i_bytes_to_read = OGGSEEK_BYTES_TO_READ;
+    if ( i_bytes_to_read > OGGSEEK_PROBE_BYTES_TO_READ ) i_bytes_to_read = OGGSEEK_PROBE_BYTES_TO_READ;
 
     while ( 1 )
     {
@@ -362,7 +370,7 @@ static int64_t find_first_page_granule( demux_t *p_demux,
             return -1;
         }
 
-        i_bytes_to_read = OGGSEEK_BYTES_TO_READ;
+        i_bytes_to_read = OGGSEEK_PROBE_BYTES_TO_READ;
 
         i_result = ogg_sync_pageseek( &p_sys->oy, &p_sys->current_page );
 
@@ -562,7 +570,7 @@ static int64_t OggForwardSeekToFrame( demux_t *p_demux, int64_t i_pos1, int64_t
 
     i_bytes_to_read = i_pos2 - i_pos1 + 1;
     seek_byte( p_demux, i_pos1 );
-    if ( i_bytes_to_read > OGGSEEK_BYTES_TO_READ ) i_bytes_to_read = OGGSEEK_BYTES_TO_READ;
+    if ( i_bytes_to_read > OGGSEEK_PROBE_BYTES_TO_READ ) i_bytes_to_read = OGGSEEK_PROBE_BYTES_TO_READ;
 
     OggDebug(
         msg_Dbg( p_demux, "Probing Fwd %"PRId64" %"PRId64" for granule %"PRId64,
@@ -579,7 +587,7 @@ static int64_t OggForwardSeekToFrame( demux_t *p_demux, int64_t i_pos1, int64_t
         if ( ! ( i_bytes_read = get_data( p_demux, i_bytes_to_read ) ) )
             return SEGMENT_NOT_FOUND;
 
-        i_bytes_to_read = OGGSEEK_BYTES_TO_READ;
+        i_bytes_to_read = OGGSEEK_PROBE_BYTES_TO_READ;
 
         i_result = ogg_sync_pageseek( &p_sys->oy, &p_sys->current_page );
 
@@ -750,13 +758,13 @@ int64_t Oggseek_GranuleToAbsTimestamp( logical_stream_t *p_stream,
     return i_timestamp;
 }
 
-/* returns pos */
+/* returns pos. The times at the bounds are -1 if unknown. */
 static int64_t OggBisectSearchByTime( demux_t *p_demux, logical_stream_t *p_stream,
-            int64_t i_targettime, int64_t i_pos_lower, int64_t i_pos_upper)
+            int64_t i_targettime, int64_t i_pos_lower, int64_t i_pos_upper,
+            int64_t i_time_lower, int64_t i_time_upper )
 {
-    int64_t i_start_pos;
-    int64_t i_end_pos;
-    int64_t i_segsize;
+    int64_t i_span = -1;
+    unsigned i_probes = 0;
 
     struct
     {
@@ -769,37 +777,43 @@ static int64_t OggBisectSearchByTime( demux_t *p_demux, logical_stream_t *p_stre
 
     demux_sys_t *p_sys  = p_demux->p_sys;
 
+    /* Pages can be indexed if decoding can start from any of them */
+    const bool b_index =
+        Ogg_GetKeyframeGranule( p_stream, 0xFF00FF00 ) == 0xFF00FF00;
+
     i_pos_lower = __MAX( i_pos_lower, p_stream->i_data_start );
     i_pos_upper = __MIN( i_pos_upper, p_sys->i_total_length );
     if ( i_pos_upper < 0 ) i_pos_upper = p_sys->i_total_length;
 
-    i_start_pos = i_pos_lower;
-    i_end_pos = i_pos_upper;
-
-    i_segsize = ( i_end_pos - i_start_pos + 1 ) >> 1;
-    i_start_pos += i_segsize;
+    if ( i_pos_lower == p_stream->i_data_start )
+        i_time_lower = 0;
+    if ( i_pos_upper == p_sys->i_total_length && p_sys->i_length > 0 )
+        i_time_upper = p_sys->i_length * CLOCK_FREQ;
 
     OggDebug( msg_Dbg(p_demux, "Bisecting for time=%"PRId64" between %"PRId64" and %"PRId64,
             i_targettime, i_pos_lower, i_pos_upper ) );
 
-    do
+    while ( i_pos_upper - i_pos_lower > 64 && i_probes++ < OGGSEEK_MAX_PROBES )
     {
-        /* see if the frame lies in current segment */
-        i_start_pos = __MAX( i_start_pos, i_pos_lower );
-        i_end_pos = __MIN( i_end_pos, i_pos_upper );
+        int64_t i_probe = i_pos_lower + ( ( i_pos_upper - i_pos_lower ) >> 1 );
 
-        if ( i_start_pos >= i_end_pos )
+        /* Interpolate the position from the times at the bounds, unless the
+         * last guess did not halve the search region (uneven bitrate) */
+        if ( i_time_lower >= 0 && i_time_upper > i_time_lower &&
+             i_targettime >= i_time_lower && i_targettime < i_time_upper &&
+             ( i_span == -1 || i_pos_upper - i_pos_lower <= i_span / 2 ) )
         {
-            if ( i_start_pos == i_pos_lower)
-            {
-                return i_start_pos;
-            }
-            return -1;
+            double f = (double)( i_targettime - i_time_lower ) /
+                       ( i_time_upper - i_time_lower );
+            i_probe = i_pos_lower + f * ( i_pos_upper - i_pos_lower );
+            /* aim a bit before, as pages are stamped with their end */
+            i_probe -= OGGSEEK_PROBE_BYTES_TO_READ / 2;
         }
-
+        i_probe = VLC_CLIP( i_probe, i_pos_lower + 1, i_pos_upper - 1 );
+        i_span = i_pos_upper - i_pos_lower;
 
         current.i_pos = find_first_page_granule( p_demux,
-                                                 i_start_pos, i_end_pos,
+                                                 i_probe, i_pos_upper,
                                                  p_stream,
                                                  &current.i_granule );
 
@@ -819,38 +833,36 @@ static int64_t OggBisectSearchByTime( demux_t *p_demux, logical_stream_t *p_stre
         if ( current.i_pos != -1 && current.i_granule != -1 )
         {
             /* found a page */
+            if ( b_index )
+                OggSeek_IndexAdd( p_stream, current.i_timestamp, current.i_pos );
 
             if ( current.i_timestamp <= i_targettime )
             {
                 /* set our lower bound */
                 if ( current.i_timestamp > bestlower.i_timestamp )
                     bestlower = current;
-                i_start_pos = current.i_pos;
+                i_pos_lower = current.i_pos;
+                i_time_lower = current.i_timestamp;
             }
-            else if ( current.i_timestamp > i_targettime )
+            else
             {
                 if ( lowestupper.i_timestamp == -1 || current.i_timestamp < lowestupper.i_timestamp )
                     lowestupper = current;
-                /* check lower half of segment */
-                i_start_pos -= i_segsize;
-                i_end_pos -= i_segsize;
+                /* check lower part of segment */
+                i_pos_upper = current.i_pos;
+                i_time_upper = current.i_timestamp;
             }
         }
         else
         {
-            /* no keyframe found, check lower segment */
-            i_end_pos -= i_segsize;
-            i_start_pos -= i_segsize;
+            /* no page found, check lower part of segment */
+            i_pos_upper = i_probe;
         }
 
-        OggDebug( msg_Dbg(p_demux, "Bisect restart i_segsize=%"PRId64" between %"PRId64
+        OggDebug( msg_Dbg(p_demux, "Bisect restart between %"PRId64
                                    " and %"PRId64 " bl %"PRId64" lu %"PRId64,
-                i_segsize, i_start_pos, i_end_pos, bestlower.i_granule, lowestupper.i_granule  ) );
-
-        i_segsize = ( i_end_pos - i_start_pos + 1 ) >> 1;
-        i_start_pos += i_segsize;
-
-    } while ( i_segsize > 64 );
+                i_pos_lower, i_pos_upper, bestlower.i_granule, lowestupper.i_granule  ) );
+    }
 
     if ( bestlower.i_granule == -1 )
     {
@@ -908,7 +920,8 @@ int Oggseek_BlindSeektoAbsoluteTime( demux_t *p_demux, logical_stream_t *p_strea
     if ( i_lowerpos != -1 ) b_found = true;
 
     /* And also search in our own index */
-    if ( !b_found && OggSeekIndexFind( p_stream, i_time, &i_lowerpos, &i_upperpos ) )
+    if ( !b_found && OggSeekIndexFind( p_stream, i_time, &i_lowerpos, &i_upperpos,
+                                       NULL, NULL ) )
     {
         b_found = true;
     }
@@ -927,7 +940,8 @@ int Oggseek_BlindSeektoAbsoluteTime( demux_t *p_demux, logical_stream_t *p_strea
     if ( !b_found && b_fastseek )
     {
         i_lowerpos = OggBisectSearchByTime( p_demux, p_stream, i_time,
-                                            p_stream->i_data_start, p_sys->i_total_length );
+                                            p_stream->i_data_start, p_sys->i_total_length,
+                                            -1, -1 );
         b_found = ( i_lowerpos != -1 );
     }
 
@@ -991,6 +1005,8 @@ int Oggseek_SeektoAbsolutetime( demux_t *p_demux, logical_stream_t *p_stream,
     OggDebug( msg_Dbg( p_demux, "=================== Seeking To Absolute Time %"PRId64, i_time ) );
     int64_t i_offset_lower = -1;
     int64_t i_offset_upper = -1;
+    int64_t i_time_lower = -1;
+    int64_t i_time_upper = -1;
 
     if ( Ogg_GetBoundsUsingSkeletonIndex( p_stream, i_time, &i_offset_lower, &i_offset_upper ) )
     {
@@ -1005,14 +1021,16 @@ int Oggseek_SeektoAbsolutetime( demux_t *p_demux, logical_stream_t *p_stream,
     OggDebug( msg_Dbg( p_demux, "Search bounds set to %"PRId64" %"PRId64" using skeleton index", i_offset_lower, i_offset_upper ) );
 
     OggNoDebug(
-        OggSeekIndexFind( p_stream, i_time, &i_offset_lower, &i_offset_upper )
+        OggSeekIndexFind( p_stream, i_time, &i_offset_lower, &i_offset_upper,
+                          &i_time_lower, &i_time_upper )
     );
 
     i_offset_lower = __MAX( i_offset_lower, p_stream->i_data_start );
     i_offset_upper = __MIN( i_offset_upper, p_sys->i_total_length );
 
     int64_t i_pagepos = OggBisectSearchByTime( p_demux, p_stream, i_time,
-                                       i_offset_lower, i_offset_upper);
+                                       i_offset_lower, i_offset_upper,
+                                       i_time_lower, i_time_upper );
     if ( i_pagepos >= 0 )
     {
         /* be sure to clear any state or read+pagein() will fail on same # */
@@ -29,24 +29,26 @@
 #define PAGE_HEADER_BYTES 27
 
 #define OGGSEEK_BYTES_TO_READ 8500
+/* Read size of the bisection probes, large enough to avoid a seek on a
+ * network access to find the next page */
+#define OGGSEEK_PROBE_BYTES_TO_READ 65536
+/* Minimal time between the entries learned while playing */
+#define OGGSEEK_INDEX_SPACING (CLOCK_FREQ / 2)
+/* Maximum number of probes of a bisection */
+#define OGGSEEK_MAX_PROBES 64
 
 /* index entries are structured as follows:
  *   - for theora, highest granulepos -> pagepos (bytes) where keyframe begins
  *  - for dirac, kframe (sync point) -> pagepos of sequence start (?)
  */
 
-/* this is typedefed to demux_index_entry_t in ogg.h */
+/* this is typedefed to demux_index_entry_t in ogg.h
+ * the entries are kept in an array sorted by page position */
 struct oggseek_index_entry
 {
-    demux_index_entry_t *p_next;
-    demux_index_entry_t *p_prev;
-
-    /* value is highest granulepos for theora, sync frame for dirac */
+    /* timestamp from which decoding can start at the page */
     int64_t i_value;
     int64_t i_pagepos;
-
-    /* not used for theora because the granulepos tells us this */
-    int64_t i_pagepos_end;
 };
 
 int64_t Ogg_GetKeyframeGranule ( logical_stream_t *p_stream, int64_t i_granule );
@@ -58,8 +60,9 @@ int     Oggseek_BlindSeektoAbsoluteTime ( demux_t *, logical_stream_t *, int64_t
 int     Oggseek_BlindSeektoPosition ( demux_t *, logical_stream_t *, double f, bool );
 int     Oggseek_SeektoAbsolutetime ( demux_t *, logical_stream_t *, int64_t i_granulepos );
 const demux_index_entry_t *OggSeek_IndexAdd ( logical_stream_t *, int64_t, int64_t );
+void    Oggseek_IndexPage( logical_stream_t *, const ogg_page *, int64_t i_pagepos );
 void    Oggseek_ProbeEnd( demux_t * );
 
-void oggseek_index_entries_free ( demux_index_entry_t * );
+void oggseek_index_entries_free ( logical_stream_t * );
 
 int64_t oggseek_read_page ( demux_t * );
@@ -24,8 +24,6 @@
 #include "IndexReader.hpp"
 #include "../adaptive/playlist/BaseRepresentation.h"
 #include "../adaptive/playlist/BaseAdaptationSet.h"
-#include "../adaptive/playlist/SegmentTemplate.h"
-#include "../adaptive/playlist/SegmentTimeline.h"
 #include "../adaptive/playlist/AbstractPlaylist.hpp"
 
 using namespace adaptive::mp4;
@@ -36,49 +34,111 @@ IndexReader::IndexReader(vlc_object_t *obj)
 {
 }
 
+/* Only a few boxes of the moof are needed, so they are looked up in place
+ * instead of parsing the whole fragment with the mp4 reader */
+static uint8_t * FindBox(uint8_t *p_data, size_t i_data, vlc_fourcc_t type,
+                         size_t *pi_box, size_t *pi_header)
+{
+    while(i_data >= 8)
+    {
+        uint64_t i_size = GetDWBE(p_data);
+        size_t i_header = 8;
+        if(i_size == 1)
+        {
+            if(i_data < 16)
+                return NULL;
+            i_size = GetQWBE(&p_data[8]);
+            i_header = 16;
+        }
+        else if(i_size == 0)
+            i_size = i_data;
+
+        if(i_size < i_header || i_size > i_data) /* truncated */
+            return NULL;
+
+        if(VLC_FOURCC(p_data[4], p_data[5], p_data[6], p_data[7]) == type)
+        {
+            *pi_box = i_size;
+            *pi_header = i_header;
+            return p_data;
+        }
+        p_data += i_size;
+        i_data -= i_size;
+    }
+    return NULL;
+}
+
 bool IndexReader::parseIndex(block_t *p_block, BaseRepresentation *rep)
 {
-    if(!rep || !parseBlock(p_block))
+    if(!rep)
         return false;
 
+    size_t i_box, i_header;
+    uint8_t *p_moof = FindBox(p_block->p_buffer, p_block->i_buffer,
+                              ATOM_moof, &i_box, &i_header);
+    if(!p_moof)
+        return false;
+    uint8_t *p_traf = FindBox(p_moof + i_header, i_box - i_header,
+                              ATOM_traf, &i_box, &i_header);
+    if(!p_traf)
+        return false;
+    p_traf += i_header;
+    const size_t i_traf = i_box - i_header;
+
     /* Do track ID fixup */
-    const MP4_Box_t *tfhd_box = MP4_BoxGet( rootbox, "moof/traf/tfhd" );
-    if ( tfhd_box )
-        SetDWBE( &p_block->p_buffer[tfhd_box->i_pos + 8 + 4], 0x01 );
+    uint8_t *p_tfhd = FindBox(p_traf, i_traf, ATOM_tfhd, &i_box, &i_header);
+    if(p_tfhd && i_box >= i_header + 8)
+        SetDWBE(&p_tfhd[i_header + 4], 0x01);
 
     if(!rep->getPlaylist()->isLive())
         return true;
 
-    const MP4_Box_t *uuid_box = MP4_BoxGet( rootbox, "moof/traf/uuid" );
-    while( uuid_box && uuid_box->i_type == ATOM_uuid )
+    /* tfrf: uuid, version, flags, count, then the times of the next
+     * fragments, on 32 or 64 bits depending on the version */
+    const uint8_t *p_tfrf = NULL;
+    size_t i_tfrf = 0;
+    for(uint8_t *p = p_traf; (size_t)(p - p_traf) < i_traf; p += i_box)
     {
-        if ( !CmpUUID( &uuid_box->i_uuid, &TfrfBoxUUID ) )
+        p = FindBox(p, i_traf - (p - p_traf), ATOM_uuid, &i_box, &i_header);
+        if(!p)
+            break;
+        if(i_box >= i_header + 16 + 5 &&
+           !memcmp(&p[i_header], &TfrfBoxUUID, 16))
+        {
+            p_tfrf = &p[i_header + 16];
+            i_tfrf = i_box - i_header - 16;
             break;
-        uuid_box = uuid_box->p_next;
+        }
     }
 
-    if(!uuid_box)
+    if(!p_tfrf)
         return false;
 
-    SegmentTimeline *timelineadd = new (std::nothrow) SegmentTimeline(rep->inheritTimescale());
-    if (timelineadd)
-    {
-        const MP4_Box_data_tfrf_t *p_tfrfdata = uuid_box->data.p_tfrf;
-        for ( uint8_t i=0; i<p_tfrfdata->i_fragment_count; i++ )
-        {
-            uint64_t dur = p_tfrfdata->p_tfrf_data_fields[i].i_fragment_duration;
-            uint64_t stime = p_tfrfdata->p_tfrf_data_fields[i].i_fragment_abs_time;
-            timelineadd->addElement(i+1, dur, 0, stime);
-        }
+    const bool b_64 = p_tfrf[0] != 0;
+    const size_t i_field = b_64 ? 16 : 8;
+    const uint8_t i_count = __MIN(p_tfrf[4], (i_tfrf - 5) / i_field);
 
-        rep->mergeWithTimeline(timelineadd);
-        delete timelineadd;
+    /* Most of the announced fragments are already known from the previous
+     * ones, only the new ones extend the timeline */
+    bool b_updated = false;
+    for(uint8_t i=0; i<i_count; i++)
+    {
+        const uint8_t *p_field = &p_tfrf[5 + i * i_field];
+        stime_t stime = b_64 ? GetQWBE(p_field) : GetDWBE(p_field);
+        stime_t dur = b_64 ? GetQWBE(&p_field[8]) : GetDWBE(&p_field[4]);
+        if(rep->extendTimeline(stime, dur))
+            b_updated = true;
+    }
 
 #ifndef NDEBUG
+    if(b_updated)
+    {
         msg_Dbg(rep->getPlaylist()->getVLCObject(), "Updated timeline from tfrf");
         rep->debug(rep->getPlaylist()->getVLCObject(), 0);
-#endif
     }
+#else
+    VLC_UNUSED(b_updated);
+#endif
 
     return true;
 }
@@ -22,7 +22,6 @@
 #endif
 
 #include "ForgedInitSegment.hpp"
-#include "MemoryChunk.hpp"
 #include "../adaptive/playlist/SegmentChunk.hpp"
 
 #include <vlc_common.h>
@@ -37,7 +36,7 @@ extern "C"
 
 using namespace adaptive::playlist;
 using namespace smooth::playlist;
-using namespace smooth::http;
+using namespace adaptive::http;
 
 ForgedInitSegment::ForgedInitSegment(ICanonicalUrl *parent,
                                      const std::string &type_,
@@ -61,10 +60,15 @@ ForgedInitSegment::ForgedInitSegment(ICanonicalUrl *parent,
     fourcc = 0;
     es_type = UNKNOWN_ES;
     track_id = 1;
+    moov = NULL;
+    vlc_mutex_init(&lock);
 }
 
 ForgedInitSegment::~ForgedInitSegment()
 {
+    if(moov)
+        block_Release(moov);
+    vlc_mutex_destroy(&lock);
     free(extradata);
 }
 
@@ -306,10 +310,17 @@ block_t * ForgedInitSegment::buildMoovBox()
 
 SegmentChunk* ForgedInitSegment::toChunk(size_t, BaseRepresentation *rep, AbstractConnectionManager *)
 {
-    block_t *moov = buildMoovBox();
-    if(moov)
+    /* The setters are only used while parsing the manifest, so the boxes
+     * stay valid for all the restarts and switches to this quality level */
+    vlc_mutex_lock(&lock);
+    if(!moov)
+        moov = buildMoovBox();
+    block_t *copy = moov ? block_Duplicate(moov) : NULL;
+    vlc_mutex_unlock(&lock);
+
+    if(copy)
     {
-        MemoryChunkSource *source = new (std::nothrow) MemoryChunkSource(moov);
+        MemoryChunkSource *source = new (std::nothrow) MemoryChunkSource(copy);
         if( source )
         {
             SegmentChunk *chunk = new (std::nothrow) SegmentChunk(this, source, rep);
@@ -318,6 +329,7 @@ SegmentChunk* ForgedInitSegment::toChunk(size_t, BaseRepresentation *rep, Abstra
             else
                 delete source;
         }
+        else block_Release(copy);
     }
     return NULL;
 }
@@ -57,6 +57,8 @@ namespace smooth
                 void fromWaveFormatEx(const uint8_t *p_data, size_t i_data);
                 void fromVideoInfoHeader(const uint8_t *p_data, size_t i_data);
                 block_t * buildMoovBox();
+                block_t *moov; /* built once, on first use */
+                vlc_mutex_t lock;
                 std::string data;
                 std::string type;
                 std::string language;
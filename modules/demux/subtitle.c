@@ -134,6 +134,7 @@ typedef struct
     int64_t i_stop;
 
     char    *psz_text;
+    uint64_t i_offset; /* of the text in the stream, if not loaded yet */
 } subtitle_t;
 
 typedef struct
@@ -180,6 +181,8 @@ struct demux_sys_t
         subtitle_t *p_array;
         size_t      i_count;
         size_t      i_current;
+        bool        b_sorted;
+        bool        b_lazy;  /* texts are read from the stream when sent */
     } subtitles;
 
     int64_t     i_length;
@@ -209,6 +212,9 @@ static int  ParseSubViewer1 ( vlc_object_t *, subs_properties_t *, text_t *, sub
 static int  ParseCommonSBV  ( vlc_object_t *, subs_properties_t *, text_t *, subtitle_t *, size_t );
 static int  ParseSCC        ( vlc_object_t *, subs_properties_t *, text_t *, subtitle_t *, size_t );
 
+static int  IndexSubRip     ( demux_t * );
+static char *LoadSubRipText ( demux_t *, const subtitle_t * );
+
 static const struct
 {
     const char *psz_type_name;
@@ -328,6 +334,7 @@ static int Open ( vlc_object_t *p_this )
     p_sys->subtitles.i_current= 0;
     p_sys->subtitles.i_count  = 0;
     p_sys->subtitles.p_array  = NULL;
+    p_sys->subtitles.b_lazy   = false;
 
     p_sys->props.psz_header         = NULL;
     p_sys->props.i_microsecperframe = 40000;
@@ -643,8 +650,6 @@ static int Open ( vlc_object_t *p_this )
         }
     }
 
-    msg_Dbg( p_demux, "loading all subtitles..." );
-
     if( e_bom == UTF8BOM && /* skip BOM */
         vlc_stream_Read( p_demux->s, NULL, 3 ) != 3 )
     {
@@ -652,12 +657,36 @@ static int Open ( vlc_object_t *p_this )
         return VLC_EGENERIC;
     }
 
+    /* SubRip files are only indexed, each text is read when it is sent.
+     * The UTF-16 streams are converted as they are read, so their offsets
+     * cannot be used. */
+    bool b_can_seek = false;
+    if( p_sys->props.i_type == SUB_TYPE_SUBRIP &&
+        e_bom != UTF16LE && e_bom != UTF16BE &&
+        vlc_stream_Control( p_demux->s, STREAM_CAN_SEEK, &b_can_seek ) == VLC_SUCCESS &&
+        b_can_seek )
+    {
+        msg_Dbg( p_demux, "indexing subtitles..." );
+        if( IndexSubRip( p_demux ) )
+        {
+            Close( p_this );
+            return VLC_ENOMEM;
+        }
+        p_sys->subtitles.b_lazy = true;
+    }
+    else
+        msg_Dbg( p_demux, "loading all subtitles..." );
+
     /* Load the whole file */
     text_t txtlines;
-    TextLoad( &txtlines, p_demux->s );
+    if( !p_sys->subtitles.b_lazy )
+        TextLoad( &txtlines, p_demux->s );
+    else
+        txtlines.i_line_count = 0;
 
     /* Parse it */
-    for( size_t i_max = 0; i_max < SIZE_MAX - 500 * sizeof(subtitle_t); )
+    for( size_t i_max = 0; !p_sys->subtitles.b_lazy &&
+         i_max < SIZE_MAX - 500 * sizeof(subtitle_t); )
     {
         if( p_sys->subtitles.i_count >= i_max )
         {
@@ -706,6 +735,16 @@ static int Open ( vlc_object_t *p_this )
     else
         es_format_Init( &fmt, SPU_ES, VLC_CODEC_SUBT );
 
+    /* Seeking can use a binary search if the subtitles are in order */
+    p_sys->subtitles.b_sorted = true;
+    for( size_t i = 1; i < p_sys->subtitles.i_count; i++ )
+        if( p_sys->subtitles.p_array[i].i_start <
+            p_sys->subtitles.p_array[i - 1].i_start )
+        {
+            p_sys->subtitles.b_sorted = false;
+            break;
+        }
+
     /* Stupid language detection in the filename */
     char * psz_language = get_language_from_filename( p_demux->psz_file );
 
@@ -785,6 +824,26 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 
         case DEMUX_SET_TIME:
             i64 = va_arg( args, int64_t );
+            if( p_sys->subtitles.b_sorted )
+            {
+                /* First subtitle after the first one starting at or after
+                 * the time */
+                size_t i_low = 1, i_high = p_sys->subtitles.i_count;
+                while( i_low < i_high )
+                {
+                    size_t i_mid = i_low + (i_high - i_low) / 2;
+                    if( p_sys->subtitles.p_array[i_mid].i_start >= i64 )
+                        i_high = i_mid;
+                    else
+                        i_low = i_mid + 1;
+                }
+                if( i_low >= p_sys->subtitles.i_count )
+                    break;
+                p_sys->subtitles.i_current = i_low - 1;
+                p_sys->i_next_demux_date = i64;
+                p_sys->b_first_time = true;
+                return VLC_SUCCESS;
+            }
             for( size_t i = 0; i + 1< p_sys->subtitles.i_count; i++ )
             {
                 if( p_sys->subtitles.p_array[i + 1].i_start >= i64 )
@@ -858,7 +917,7 @@ static int Demux( demux_t *p_demux )
     while( p_sys->subtitles.i_current < p_sys->subtitles.i_count &&
            p_sys->subtitles.p_array[p_sys->subtitles.i_current].i_start <= i_barrier )
     {
-        const subtitle_t *p_subtitle = &p_sys->subtitles.p_array[p_sys->subtitles.i_current];
+        subtitle_t *p_subtitle = &p_sys->subtitles.p_array[p_sys->subtitles.i_current];
 
         if ( !p_sys->b_slave && p_sys->b_first_time )
         {
@@ -866,7 +925,10 @@ static int Demux( demux_t *p_demux )
             p_sys->b_first_time = false;
         }
 
-        if( p_subtitle->i_start >= 0 )
+        if( p_sys->subtitles.b_lazy && p_subtitle->i_start >= 0 )
+            p_subtitle->psz_text = LoadSubRipText( p_demux, p_subtitle );
+
+        if( p_subtitle->i_start >= 0 && p_subtitle->psz_text != NULL )
         {
             block_t *p_block = p_sys->pf_convert( p_subtitle );
             if( p_block )
@@ -880,6 +942,11 @@ static int Demux( demux_t *p_demux )
             }
         }
 
+        if( p_sys->subtitles.b_lazy )
+        {
+            free( p_subtitle->psz_text );
+            p_subtitle->psz_text = NULL;
+        }
         p_sys->subtitles.i_current++;
     }
 
@@ -1179,6 +1246,85 @@ static int  ParseSubRip( vlc_object_t *p_obj, subs_properties_t *p_props,
                                  false );
 }
 
+/* IndexSubRip
+ *  Scans the SubRip cue timings without keeping their texts in memory
+ */
+static int IndexSubRip( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    size_t i_max = 0;
+    bool b_text = false;
+    char *psz_line;
+
+    while( (psz_line = vlc_stream_ReadLine( p_demux->s )) != NULL )
+    {
+        subtitle_t sub;
+
+        if( b_text )
+        {   /* Skip the text until an empty line */
+            b_text = *psz_line != '\0';
+        }
+        else if( subtitle_ParseSubRipTiming( &sub, psz_line ) == VLC_SUCCESS &&
+                 sub.i_start < sub.i_stop )
+        {
+            if( p_sys->subtitles.i_count >= i_max )
+            {
+                subtitle_t *p_realloc = NULL;
+                if( i_max < SIZE_MAX / sizeof(subtitle_t) - 500 )
+                    p_realloc = realloc( p_sys->subtitles.p_array,
+                                         sizeof(subtitle_t) * (i_max + 500) );
+                if( p_realloc == NULL )
+                {
+                    free( psz_line );
+                    return VLC_ENOMEM;
+                }
+                p_sys->subtitles.p_array = p_realloc;
+                i_max += 500;
+            }
+
+            sub.psz_text = NULL;
+            sub.i_offset = vlc_stream_Tell( p_demux->s );
+            p_sys->subtitles.p_array[p_sys->subtitles.i_count++] = sub;
+            b_text = true;
+        }
+        free( psz_line );
+    }
+    return VLC_SUCCESS;
+}
+
+/* LoadSubRipText
+ *  Reads the text of an indexed SubRip cue
+ */
+static char *LoadSubRipText( demux_t *p_demux, const subtitle_t *p_subtitle )
+{
+    if( vlc_stream_Seek( p_demux->s, p_subtitle->i_offset ) )
+        return NULL;
+
+    char *psz_text = strdup("");
+    char *psz_line;
+
+    while( psz_text != NULL &&
+           (psz_line = vlc_stream_ReadLine( p_demux->s )) != NULL )
+    {
+        size_t i_len = strlen( psz_line );
+        if( i_len == 0 )
+        {
+            free( psz_line );
+            break;
+        }
+
+        size_t i_old = strlen( psz_text );
+        psz_text = realloc_or_free( psz_text, i_old + i_len + 1 + 1 );
+        if( psz_text != NULL )
+        {
+            memcpy( &psz_text[i_old], psz_line, i_len );
+            memcpy( &psz_text[i_old + i_len], "\n", 2 );
+        }
+        free( psz_line );
+    }
+    return psz_text;
+}
+
 /* subtitle_ParseSubViewerTiming
  * Parses SubViewer timing.
  */
@@ -59,6 +59,7 @@ struct demux_sys_t
     } cues;
 
     webvtt_text_parser_t *p_streamparser;
+    bool                  b_stream_ended;
 };
 
 /*****************************************************************************
@@ -485,9 +486,36 @@ static int DemuxStream( demux_t *p_demux )
     demux_sys_t *p_sys = p_demux->p_sys;
 
     char *psz_line = vlc_stream_ReadLine( p_demux->s );
+
+    /* The source can resume after its end with the next document of a
+     * segmented stream, which needs a new parser for its header */
+    if( psz_line && p_sys->b_stream_ended )
+    {
+        p_sys->b_stream_ended = false;
+        if( !strncmp( psz_line, "WEBVTT", 6 ) ||
+            !strncmp( psz_line, "\xEF\xBB\xBFWEBVTT", 9 ) )
+        {
+            webvtt_text_parser_t *p_parser =
+                webvtt_text_parser_New( p_demux, StreamParserGetCueHandler,
+                                        StreamParserCueDoneHandler, NULL );
+            if( !p_parser )
+            {
+                free( psz_line );
+                return VLC_DEMUXER_EGENERIC;
+            }
+            webvtt_text_parser_Delete( p_sys->p_streamparser );
+            p_sys->p_streamparser = p_parser;
+        }
+    }
+
     webvtt_text_parser_Feed( p_sys->p_streamparser, psz_line );
 
-    return ( psz_line == NULL ) ? VLC_DEMUXER_EOF : VLC_DEMUXER_SUCCESS;
+    if( psz_line == NULL )
+    {
+        p_sys->b_stream_ended = true;
+        return VLC_DEMUXER_EOF;
+    }
+    return VLC_DEMUXER_SUCCESS;
 }
 
 /*****************************************************************************
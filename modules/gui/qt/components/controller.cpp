@@ -43,6 +43,7 @@
 #include "util/customwidgets.hpp"                       /* qEventToKey */
 
 #include "adapters/seekpoints.hpp"
+#include "util/thumbnailer.hpp"                          /* SeekThumbnailer */
 
 #include <QToolButton>
 #include <QHBoxLayout>
@@ -353,6 +354,7 @@ QWidget *AbstractController::createWidget( buttonType_e button, int options )
         SeekPoints *chapters = new SeekPoints( this, p_intf );
         CONNECT( THEMIM->getIM(), chapterChanged( bool ), chapters, update() );
         slider->setChapters( chapters );
+        slider->setThumbnailer( new SeekThumbnailer( this, p_intf ) );
 
         /* Update the position when the IM has changed */
         CONNECT( THEMIM->getIM(), positionUpdated( float, int64_t, int ),
@@ -78,7 +78,8 @@ void EPGProgram::pruneEvents( const QDateTime &date )
         if( item->endsBefore( date ) ) /* Expired item ? */
         {
             EPGItem *modifiableitem = eventsbyid.take( item->eventID() );
-            view->scene()->removeItem( modifiableitem );
+            if( shown.remove( modifiableitem ) )
+                view->scene()->removeItem( modifiableitem );
             delete modifiableitem;
             it = eventsbytime.erase( it );
         }
@@ -88,10 +89,49 @@ void EPGProgram::pruneEvents( const QDateTime &date )
 
 void EPGProgram::updateEventPos()
 {
-    foreach( EPGItem *item, eventsbyid )
+    /* hidden items get placed when they are shown again */
+    foreach( EPGItem *item, shown )
         item->updatePos();
 }
 
+void EPGProgram::updateVisibleEvents( const QDateTime &from, const QDateTime &to )
+{
+    QSet<EPGItem *> visible;
+
+    /* Only the events within the window are part of the scene, the others
+     * are kept aside with their data until they get scrolled into view. */
+    if( from.isValid() && from < to )
+    {
+        QMap<QDateTime, const EPGItem *>::const_iterator it =
+                eventsbytime.lowerBound( from );
+        if( it != eventsbytime.constBegin() )
+            --it; /* might still be playing */
+
+        for( ; it != eventsbytime.constEnd() && (*it)->start() < to; ++it )
+        {
+            if( !(*it)->endsBefore( from ) )
+                visible.insert( eventsbyid.value( (*it)->eventID() ) );
+        }
+    }
+
+    foreach( EPGItem *item, shown )
+    {
+        if( !visible.contains( item ) )
+            view->scene()->removeItem( item );
+    }
+
+    foreach( EPGItem *item, visible )
+    {
+        if( !shown.contains( item ) )
+        {
+            item->updatePos();
+            view->scene()->addItem( item );
+        }
+    }
+
+    shown = visible;
+}
+
 void EPGProgram::updateEvents( const vlc_epg_event_t * const * pp_events, size_t i_events,
                                const vlc_epg_event_t *p_current, QDateTime *mindate )
 {
@@ -126,8 +166,6 @@ void EPGProgram::updateEvents( const vlc_epg_event_t * const * pp_events, size_t
             eventsbyid.insert( p_event->i_id, epgItem );
             eventsbytime.insert( eventStart, epgItem );
 
-            view->scene()->addItem( epgItem );
-
             /* First Insert, needs to focus by default then */
             if( !view->hasFocus() )
                 view->focusItem( epgItem );
@@ -26,6 +26,7 @@
 #include <QObject>
 #include <QMap>
 #include <QHash>
+#include <QSet>
 #include <QDateTime>
 
 class EPGView;
@@ -43,6 +44,7 @@ class EPGProgram : public QObject
         void updateEvents( const vlc_epg_event_t * const *, size_t, const vlc_epg_event_t *,
                            QDateTime * );
         void updateEventPos();
+        void updateVisibleEvents( const QDateTime &, const QDateTime & );
         size_t getPosition() const;
         void setPosition( size_t );
         void activate();
@@ -55,6 +57,7 @@ class EPGProgram : public QObject
 
     private:
         const EPGItem *current;
+        QSet<EPGItem *> shown;
         EPGView *view;
         size_t pos;
 
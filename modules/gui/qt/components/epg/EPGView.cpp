@@ -31,6 +31,7 @@
 #include <QDateTime>
 #include <QMatrix>
 #include <QPaintEvent>
+#include <QResizeEvent>
 #include <QRectF>
 
 EPGGraphicsScene::EPGGraphicsScene( QObject *parent ) : QGraphicsScene( parent )
@@ -88,6 +89,8 @@ EPGView::EPGView( QWidget *parent ) : QGraphicsView( parent )
     m_scaleFactor = 1.0;
 
     EPGGraphicsScene *EPGscene = new EPGGraphicsScene( this );
+    /* only the visible items are in the scene, and they come and go */
+    EPGscene->setItemIndexMethod( QGraphicsScene::NoIndex );
 
     setScene( EPGscene );
 }
@@ -98,6 +101,7 @@ void EPGView::setScale( double scaleFactor )
     QMatrix matrix;
     matrix.scale( scaleFactor, 1 );
     setMatrix( matrix );
+    updateVisibleItems();
 }
 
 const QDateTime& EPGView::startTime() const
@@ -159,6 +163,7 @@ void EPGView::reset()
     qDeleteAll(programs.values());
     programs.clear();
     m_startTime = m_maxTime = QDateTime();
+    scene()->setSceneRect( QRectF() );
 }
 
 void EPGView::walkItems( bool b_cleanup )
@@ -193,12 +198,54 @@ void EPGView::walkItems( bool b_cleanup )
     m_startTime = m_updtMinTime;
     m_maxTime = maxTime;
 
+    /* Most items are not part of the scene, so it can't grow by itself */
+    if( m_startTime.isValid() && m_maxTime.isValid() )
+        scene()->setSceneRect( 0, 0, m_startTime.secsTo( m_maxTime ),
+                               programs.count() * TRACKS_HEIGHT );
+
     if ( b_rangechanged )
     {
         foreach( EPGProgram *program, programs )
             program->updateEventPos();
         emit rangeChanged( m_startTime, m_maxTime );
     }
+
+    updateVisibleItems();
+}
+
+void EPGView::updateVisibleItems()
+{
+    if( !m_startTime.isValid() )
+        return;
+
+    /* Keep some margin, so that small scrolls don't hit empty areas */
+    QRectF area = mapToScene( viewport()->rect() ).boundingRect();
+    area.adjust( -area.width() / 2, -TRACKS_HEIGHT,
+                 area.width() / 2, TRACKS_HEIGHT );
+
+    QDateTime from = m_startTime.addSecs( area.left() );
+    QDateTime to = m_startTime.addSecs( area.right() );
+
+    foreach( EPGProgram *program, programs )
+    {
+        qreal y = program->getPosition() * TRACKS_HEIGHT;
+        if( y + TRACKS_HEIGHT >= area.top() && y <= area.bottom() )
+            program->updateVisibleEvents( from, to );
+        else
+            program->updateVisibleEvents( QDateTime(), QDateTime() );
+    }
+}
+
+void EPGView::scrollContentsBy( int dx, int dy )
+{
+    QGraphicsView::scrollContentsBy( dx, dy );
+    updateVisibleItems();
+}
+
+void EPGView::resizeEvent( QResizeEvent *event )
+{
+    QGraphicsView::resizeEvent( event );
+    updateVisibleItems();
 }
 
 void EPGView::cleanup()
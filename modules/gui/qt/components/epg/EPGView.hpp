@@ -77,6 +77,9 @@ signals:
 
 protected:
     void            walkItems( bool );
+    void            updateVisibleItems();
+    void            scrollContentsBy( int, int ) Q_DECL_OVERRIDE;
+    void            resizeEvent( QResizeEvent * ) Q_DECL_OVERRIDE;
     QDateTime       m_epgTime;
     QDateTime       m_startTime;
     QDateTime       m_maxTime;
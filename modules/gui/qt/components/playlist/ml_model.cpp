@@ -0,0 +1,362 @@
+/*****************************************************************************
+ * ml_model.cpp : Model for the indexed media library
+ ****************************************************************************
+ * Copyright (C) 2017 the VideoLAN team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "components/playlist/ml_model.hpp"
+#include "input_manager.hpp"                /* THEMIM */
+
+#include <vlc_input_item.h>
+#include <vlc_playlist.h>
+
+#include <QAction>
+#include <QBrush>
+
+/* Rows fetched at once from the index */
+#define ML_MODEL_PAGE 256
+
+/*************************************************************************
+ * Items
+ *************************************************************************/
+
+MLItem::MLItem( const MediaIndex::Entry &_entry )
+    : entry( _entry ), p_input( NULL )
+{
+    parentItem = NULL;
+}
+
+MLItem::~MLItem()
+{
+    if( p_input )
+        input_item_Release( p_input );
+}
+
+input_item_t *MLItem::inputItem()
+{
+    if( p_input == NULL )
+    {
+        p_input = input_item_NewFile( qtu( entry.uri ), qtu( entry.title ),
+                                      entry.duration, ITEM_LOCAL );
+        if( p_input )
+        {
+            if( !entry.artist.isEmpty() )
+                input_item_SetArtist( p_input, qtu( entry.artist ) );
+            if( !entry.album.isEmpty() )
+                input_item_SetAlbum( p_input, qtu( entry.album ) );
+        }
+    }
+    return p_input;
+}
+
+/*************************************************************************
+ * Model
+ *************************************************************************/
+
+MLModel::MLModel( intf_thread_t *_p_intf, QObject *parent )
+    : VLCModel( _p_intf, parent )
+{
+    mediaIndex = MediaIndex::getInstance( p_intf );
+
+    CONNECT( mediaIndex, rowsAppended( int, int ),
+             this, rowsAppended( int, int ) );
+    CONNECT( mediaIndex, rowChanged( int ), this, rowChanged( int ) );
+    CONNECT( mediaIndex, reset(), this, indexReset() );
+}
+
+MLModel::~MLModel()
+{
+    qDeleteAll( items );
+}
+
+QVariant MLModel::data( const QModelIndex &index, const int role ) const
+{
+    if( !index.isValid() )
+        return QVariant();
+
+    MLItem *item = getItem( index );
+    const MediaIndex::Entry &entry = item->entry;
+
+    switch( role )
+    {
+        case Qt::FontRole:
+            return customFont;
+
+        case Qt::DisplayRole:
+        {
+            switch( columnToMeta( index.column() ) )
+            {
+                case COLUMN_NUMBER:
+                    return QString::number( index.row() + 1 );
+                case COLUMN_TITLE:
+                    return entry.title;
+                case COLUMN_DURATION:
+                {
+                    char psz_duration[MSTRTIME_MAX_SIZE];
+                    if( entry.duration <= 0 )
+                        return QString();
+                    secstotimestr( psz_duration, entry.duration / CLOCK_FREQ );
+                    return qfu( psz_duration );
+                }
+                case COLUMN_ARTIST:
+                    return entry.artist;
+                case COLUMN_ALBUM:
+                    return entry.album;
+                case COLUMN_URI:
+                    return entry.uri;
+                case COLUMN_COVER:
+                    return entry.artUrl;
+                default:
+                    return QVariant();
+            }
+        }
+
+        case Qt::DecorationRole:
+            switch( columnToMeta( index.column() ) )
+            {
+                case COLUMN_TITLE:
+                    return QVariant( icons[ITEM_TYPE_FILE] );
+                case COLUMN_COVER:
+                    return getArtPixmap( index, QSize(16,16) );
+                default:
+                    break;
+            }
+            break;
+
+        case Qt::BackgroundRole:
+            if( isCurrent( index ) )
+                return QVariant( QBrush( Qt::gray ) );
+            break;
+
+        case CURRENT_ITEM_ROLE:
+            return QVariant( isCurrent( index ) );
+
+        case CURRENT_ITEM_CHILD_ROLE:
+            return QVariant( false );
+
+        case LEAF_NODE_ROLE:
+            return QVariant( true );
+
+        default:
+            break;
+    }
+
+    return QVariant();
+}
+
+bool MLModel::setData( const QModelIndex &index, const QVariant & value, int role )
+{
+    switch( role )
+    {
+    case Qt::FontRole:
+        customFont = value.value<QFont>();
+        return true;
+    default:
+        return VLCModel::setData( index, value, role );
+    }
+}
+
+QModelIndex MLModel::index( const int row, const int column,
+                            const QModelIndex &parent ) const
+{
+    if( parent.isValid() || row < 0 || row >= items.count() )
+        return QModelIndex();
+    return createIndex( row, column, items[row] );
+}
+
+QModelIndex MLModel::parent( const QModelIndex & ) const
+{
+    return QModelIndex();
+}
+
+int MLModel::rowCount( const QModelIndex &parent ) const
+{
+    return parent.isValid() ? 0 : items.count();
+}
+
+bool MLModel::canFetchMore( const QModelIndex &parent ) const
+{
+    return !parent.isValid() && items.count() < mediaIndex->count();
+}
+
+void MLModel::fetchMore( const QModelIndex &parent )
+{
+    if( !canFetchMore( parent ) )
+        return;
+
+    QVector<MediaIndex::Entry> page =
+        mediaIndex->page( items.count(), ML_MODEL_PAGE );
+
+    beginInsertRows( QModelIndex(), items.count(),
+                     items.count() + page.count() - 1 );
+    foreach( const MediaIndex::Entry &entry, page )
+        items.append( new MLItem( entry ) );
+    endInsertRows();
+}
+
+MLItem *MLModel::getItem( const QModelIndex &index ) const
+{
+    return static_cast<MLItem *>( VLCModel::getItem( index ) );
+}
+
+void MLModel::rebuild( playlist_item_t * )
+{
+    /* Views will fetch the first page again */
+    beginResetModel();
+    qDeleteAll( items );
+    items.clear();
+    endResetModel();
+}
+
+void MLModel::rowsAppended( int, int )
+{
+    /* Only the rows not fetched yet were appended: the views will ask for
+       them as they scroll. Tell them if they are shown already. */
+    if( items.count() < ML_MODEL_PAGE )
+        fetchMore( QModelIndex() );
+}
+
+void MLModel::rowChanged( int row )
+{
+    if( row >= items.count() )
+        return;
+
+    MLItem *item = items[row];
+    item->entry = mediaIndex->entry( row );
+    if( item->p_input )
+    {
+        input_item_Release( item->p_input );
+        item->p_input = NULL;
+    }
+    emit dataChanged( index( row, 0 ), index( row, columnCount() - 1 ) );
+}
+
+QModelIndex MLModel::indexByURI( const QString &uri, const int c ) const
+{
+    int row = mediaIndex->rowOf( uri );
+    if( row < 0 || row >= items.count() )
+        return QModelIndex();
+    return index( row, c );
+}
+
+QModelIndex MLModel::indexByInputItem( const input_item_t *p_input,
+                                       const int c ) const
+{
+    if( !p_input )
+        return QModelIndex();
+
+    char *psz_uri = input_item_GetURI( const_cast<input_item_t *>( p_input ) );
+    QString uri = qfu( psz_uri );
+    free( psz_uri );
+    return indexByURI( uri, c );
+}
+
+QModelIndex MLModel::currentIndex() const
+{
+    return indexByInputItem( THEMIM->currentInputItem(), 0 );
+}
+
+bool MLModel::isCurrent( const QModelIndex &index ) const
+{
+    input_item_t *p_current = THEMIM->currentInputItem();
+    if( !index.isValid() || !p_current )
+        return false;
+
+    char *psz_uri = input_item_GetURI( p_current );
+    bool b_current = getItem( index )->entry.uri == qfu( psz_uri );
+    free( psz_uri );
+    return b_current;
+}
+
+void MLModel::activateItem( const QModelIndex &index )
+{
+    input_item_t *p_input = index.isValid() ? getItem( index )->inputItem()
+                                            : NULL;
+    if( p_input )
+        playlist_AddInput( THEPL, p_input, true, true );
+}
+
+bool MLModel::action( QAction *action, const QModelIndexList &indexes )
+{
+    actionsContainerType a = action->data().value<actionsContainerType>();
+
+    switch( a.action )
+    {
+    case ACTION_PLAY:
+        if( !indexes.empty() && indexes.first().isValid() )
+        {
+            if( isCurrent( indexes.first() ) )
+                playlist_Resume( THEPL );
+            else
+                activateItem( indexes.first() );
+            return true;
+        }
+        break;
+
+    case ACTION_PAUSE:
+        if( !indexes.empty() && indexes.first().isValid() )
+        {
+            playlist_Pause( THEPL );
+            return true;
+        }
+        break;
+
+    case ACTION_ADDTOPLAYLIST:
+        foreach( const QModelIndex &currentIndex, indexes )
+        {
+            input_item_t *p_input = getInputItem( currentIndex );
+            if( p_input )
+                playlist_AddInput( THEPL, p_input, false, true );
+        }
+        return true;
+
+    case ACTION_ENQUEUEDIR:
+        if( a.uris.isEmpty() ) break;
+
+        mediaIndex->addFolder( a.uris.first() );
+        return true;
+
+    default:
+        break;
+    }
+    return false;
+}
+
+bool MLModel::isSupportedAction( actions action, const QModelIndex &index ) const
+{
+    switch( action )
+    {
+    case ACTION_PLAY:
+        return index.isValid() && !isCurrent( index );
+    case ACTION_PAUSE:
+        return index.isValid() && isCurrent( index );
+    case ACTION_ADDTOPLAYLIST:
+    case ACTION_INFO:
+    case ACTION_EXPLORE:
+    case ACTION_STREAM:
+    case ACTION_SAVE:
+        return index.isValid();
+    case ACTION_ENQUEUEDIR:
+        return true;
+    default:
+        return false;
+    }
+}
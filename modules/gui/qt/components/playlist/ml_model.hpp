@@ -0,0 +1,114 @@
+/*****************************************************************************
+ * ml_model.hpp : Model for the indexed media library
+ ****************************************************************************
+ * Copyright (C) 2017 the VideoLAN team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_QT_ML_MODEL_HPP_
+#define VLC_QT_ML_MODEL_HPP_
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "qt.hpp"
+#include "components/playlist/vlc_model.hpp"
+#include "util/media_index.hpp"
+
+#include <QFont>
+#include <QList>
+
+class MLItem : public AbstractPLItem
+{
+    friend class MLModel;
+
+public:
+    virtual ~MLItem();
+
+private:
+    MLItem( const MediaIndex::Entry & );
+
+    /* AbstractPLItem */
+    int id() const Q_DECL_OVERRIDE { return -1; }
+    input_item_t *inputItem() Q_DECL_OVERRIDE;
+    AbstractPLItem *child( int ) const Q_DECL_OVERRIDE { return NULL; }
+    QString getURI() const Q_DECL_OVERRIDE { return entry.uri; }
+    QString getTitle() const Q_DECL_OVERRIDE { return entry.title; }
+    bool readOnly() const Q_DECL_OVERRIDE { return true; }
+
+    MediaIndex::Entry entry;
+    /* Only created once needed, to play or show the item */
+    input_item_t *p_input;
+};
+
+/* Flat view of the MediaIndex. Rows are fetched by pages as the views
+   scroll, so that large libraries are shown at once. */
+class MLModel : public VLCModel
+{
+    Q_OBJECT
+
+public:
+    MLModel( intf_thread_t *, QObject *parent = 0 );
+    virtual ~MLModel();
+
+    /*** QAbstractItemModel subclassing ***/
+    QVariant data( const QModelIndex &index, const int role ) const Q_DECL_OVERRIDE;
+    bool setData( const QModelIndex &index, const QVariant & value, int role ) Q_DECL_OVERRIDE;
+    QModelIndex index( const int r, const int c, const QModelIndex &parent = QModelIndex() ) const Q_DECL_OVERRIDE;
+    QModelIndex parent( const QModelIndex &index ) const Q_DECL_OVERRIDE;
+    int rowCount( const QModelIndex &parent = QModelIndex() ) const Q_DECL_OVERRIDE;
+    bool canFetchMore( const QModelIndex &parent ) const Q_DECL_OVERRIDE;
+    void fetchMore( const QModelIndex &parent ) Q_DECL_OVERRIDE;
+
+    /*** VLCModelSubInterface subclassing ***/
+    void rebuild( playlist_item_t * p = NULL ) Q_DECL_OVERRIDE;
+    void doDelete( QModelIndexList ) Q_DECL_OVERRIDE {}
+    void createNode( QModelIndex, QString ) Q_DECL_OVERRIDE {}
+    void renameNode( QModelIndex, QString ) Q_DECL_OVERRIDE {}
+    void removeAll() Q_DECL_OVERRIDE {}
+    QModelIndex rootIndex() const Q_DECL_OVERRIDE { return QModelIndex(); }
+    void filter( const QString&, const QModelIndex &, bool ) Q_DECL_OVERRIDE {}
+    QModelIndex currentIndex() const Q_DECL_OVERRIDE;
+    QModelIndex indexByPLID( const int, const int ) const Q_DECL_OVERRIDE { return QModelIndex(); }
+    QModelIndex indexByInputItem( const input_item_t *, const int c ) const Q_DECL_OVERRIDE;
+    bool isTree() const Q_DECL_OVERRIDE { return false; }
+    bool canEdit() const Q_DECL_OVERRIDE { return false; }
+    bool action( QAction *, const QModelIndexList & ) Q_DECL_OVERRIDE;
+    bool isSupportedAction( actions action, const QModelIndex & ) const Q_DECL_OVERRIDE;
+
+protected:
+    bool isCurrent( const QModelIndex &index ) const Q_DECL_OVERRIDE;
+    bool isParent( const QModelIndex &, const QModelIndex & ) const Q_DECL_OVERRIDE { return false; }
+    bool isLeaf( const QModelIndex & ) const Q_DECL_OVERRIDE { return true; }
+    MLItem *getItem( const QModelIndex & index ) const Q_DECL_OVERRIDE;
+
+private:
+    QModelIndex indexByURI( const QString &uri, const int c ) const;
+
+    MediaIndex *mediaIndex;
+    /* The first rows of the index, as fetched so far */
+    QList<MLItem *> items;
+    QFont customFont;
+
+private slots:
+    void activateItem( const QModelIndex &index ) Q_DECL_OVERRIDE;
+    void rowsAppended( int first, int last );
+    void rowChanged( int row );
+    void indexReset() { rebuild(); }
+};
+
+#endif
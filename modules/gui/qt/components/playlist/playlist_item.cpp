@@ -61,6 +61,7 @@ void PLItem::init( playlist_item_t *_playlist_item, PLItem *parent )
     i_playlist_id = _playlist_item->i_id;           /* Playlist item specific id */
     p_input = _playlist_item->p_input;
     i_flags = _playlist_item->i_flags;
+    i_fetched = 0;
     input_item_Hold( p_input );
 }
 
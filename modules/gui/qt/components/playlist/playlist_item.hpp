@@ -92,6 +92,9 @@ private:
     int i_playlist_id;
     int i_flags;
     input_item_t *p_input;
+    /* Children are fetched on demand: number of playlist children looked at
+     * so far, as a hint, see PLModel::fetchedCount() */
+    int i_fetched;
 };
 
 #endif
@@ -31,6 +31,7 @@
 #include "components/playlist/playlist_model.hpp"
 #include "input_manager.hpp"                            /* THEMIM */
 #include "util/qt_dirs.hpp"
+#include "util/media_index.hpp"                        /* MediaIndex */
 #include "recents.hpp"                                  /* Open:: */
 
 #include <vlc_intf_strings.h>                           /* I_DIR */
@@ -47,6 +48,10 @@
  * Playlist model implementation
  *************************************************************************/
 
+/* The children of a node are created on demand, by chunks of that many,
+ * as the views scroll or expand it, see fetchMore() */
+#define PLMODEL_FETCH_CHUNK 500
+
 PLModel::PLModel( playlist_t *_p_playlist,  /* THEPL */
                   intf_thread_t *_p_intf,   /* main Qt p_intf */
                   playlist_item_t * p_root,
@@ -67,6 +72,8 @@ PLModel::PLModel( playlist_t *_p_playlist,  /* THEPL */
              this, processItemAppend( int, int ) );
     CONNECT( THEMIM, playlistItemRemoved( int ),
              this, processItemRemoval( int ) );
+    CONNECT( THEMIM, playlistBatchCommitted( int ),
+             this, processBatch( int ) );
 }
 
 PLModel::~PLModel()
@@ -259,7 +266,11 @@ void PLModel::dropMove( const PlMimeData * plMimeData, PLItem *target, int row )
     foreach( PLItem *item, model_items )
         takeItem( item );
 
-    insertChildren( target, model_items, model_pos );
+    /* Items moved past the fetched children will be fetched again */
+    if( model_pos > target->childCount() )
+        qDeleteAll( model_items );
+    else
+        insertChildren( target, model_items, model_pos );
     free( pp_items );
 }
 
@@ -511,6 +522,46 @@ int PLModel::rowCount( const QModelIndex &parent ) const
     return parentItem->childCount();
 }
 
+bool PLModel::hasChildren( const QModelIndex &parent ) const
+{
+    PLItem *parentItem = parent.isValid() ? getItem( parent ) : rootItem;
+    if( parentItem->childCount() > 0 ) return true;
+
+    vlc_playlist_locker pl_lock ( THEPL );
+
+    playlist_item_t *p_node =
+        playlist_ItemGetById( p_playlist, parentItem->id() );
+    return p_node && p_node->i_children > 0;
+}
+
+bool PLModel::canFetchMore( const QModelIndex &parent ) const
+{
+    PLItem *parentItem = parent.isValid() ? getItem( parent ) : rootItem;
+
+    vlc_playlist_locker pl_lock ( THEPL );
+
+    playlist_item_t *p_node =
+        playlist_ItemGetById( p_playlist, parentItem->id() );
+    return p_node && fetchedCount( p_node, parentItem ) < p_node->i_children;
+}
+
+void PLModel::fetchMore( const QModelIndex &parent )
+{
+    PLItem *parentItem = parent.isValid() ? getItem( parent ) : rootItem;
+    QList<PLItem*> items;
+
+    {
+        vlc_playlist_locker pl_lock ( THEPL );
+
+        playlist_item_t *p_node =
+            playlist_ItemGetById( p_playlist, parentItem->id() );
+        if( !p_node ) return;
+        items = fetchChildren( p_node, parentItem, PLMODEL_FETCH_CHUNK );
+    }
+
+    insertChildren( parentItem, items, parentItem->childCount() );
+}
+
 /************************* Lookups *****************************/
 PLItem *PLModel::findByPLId( PLItem *root, int i_id ) const
 {
@@ -604,7 +655,7 @@ void PLModel::processInputItemUpdate( )
     input_thread_t *p_input = THEMIM->getInput();
     if( !p_input ) return;
 
-    PLItem *item = findByInput( rootItem, input_GetItem( p_input ) );
+    PLItem *item = fetchUpTo( input_GetItem( p_input ) );
     if( item ) emit currentIndexChanged( index( item, 0 ) );
 
     processInputItemUpdate( input_GetItem( p_input ) );
@@ -649,10 +700,16 @@ void PLModel::processItemAppend( int i_pl_itemid, int i_pl_itemidparent )
         for( pos = p_item->p_parent->i_children - 1; pos >= 0; pos-- )
             if( p_item->p_parent->pp_children[pos] == p_item ) break;
 
+        /* Items past the fetched children will be fetched with them */
+        int fetched = fetchedCount( p_item->p_parent, nodeParentItem );
+        if( pos > fetched ) return;
+        nodeParentItem->i_fetched = qMax( fetched, pos + 1 );
+
         newItem = new PLItem( p_item, nodeParentItem );
     }
 
     /* We insert the newItem (children) inside the parent */
+    pos = qMin( pos, nodeParentItem->childCount() );
     beginInsertRows( index( nodeParentItem, 0 ), pos, pos );
     nodeParentItem->insertChild( newItem, pos );
     endInsertRows();
@@ -663,6 +720,49 @@ void PLModel::processItemAppend( int i_pl_itemid, int i_pl_itemidparent )
     filter( latestSearch, index( rootItem, 0), false /*FIXME*/ );
 }
 
+void PLModel::processBatch( int i_pl_nodeid )
+{
+    PLItem *nodeItem = findByPLId( rootItem, i_pl_nodeid );
+
+    if( !nodeItem )
+    {
+        /* Only rebuild if the node contains the displayed root */
+        bool b_rebuild = false;
+        {
+            vlc_playlist_locker pl_lock ( THEPL );
+
+            playlist_item_t *p_node = playlist_ItemGetById( p_playlist,
+                                                            i_pl_nodeid );
+            for( playlist_item_t *p = playlist_ItemGetById( p_playlist,
+                                                            rootItem->id() );
+                 p_node != NULL && p != NULL; p = p->p_parent )
+                if( p == p_node )
+                {
+                    b_rebuild = true;
+                    break;
+                }
+        }
+        if( b_rebuild ) rebuild();
+        return;
+    }
+
+    /* Update the whole node at once, instead of inserting and removing each
+     * of the batch rows */
+    beginResetModel();
+    {
+        vlc_playlist_locker pl_lock ( THEPL );
+
+        playlist_item_t *p_node = playlist_ItemGetById( p_playlist,
+                                                        nodeItem->id() );
+        nodeItem->clearChildren();
+        if( p_node ) updateChildren( p_node, nodeItem );
+    }
+    endResetModel();
+
+    if( latestSearch.isEmpty() ) return;
+    filter( latestSearch, index( rootItem, 0), false /*FIXME*/ );
+}
+
 void PLModel::rebuild( playlist_item_t *p_root )
 {
     beginResetModel();
@@ -736,20 +836,125 @@ void PLModel::removeItem( PLItem *item )
 void PLModel::updateChildren( PLItem *root )
 {
     playlist_item_t *p_node = playlist_ItemGetById( p_playlist, root->id() );
-    updateChildren( p_node, root );
+    if( p_node ) updateChildren( p_node, root );
 }
 
-/* This function must be entered WITH the playlist lock */
+/* Fetches the first children of a node without children.
+ * This function must be entered WITH the playlist lock */
 void PLModel::updateChildren( playlist_item_t *p_node, PLItem *root )
 {
-    for( int i = 0; i < p_node->i_children ; i++ )
+    assert( root->childCount() == 0 );
+    root->i_fetched = 0;
+
+    foreach( PLItem *item, fetchChildren( p_node, root, PLMODEL_FETCH_CHUNK ) )
+        root->appendChild( item );
+}
+
+/* Returns the position following the last fetched child of a node. Disabled
+ * children are skipped, so this is not the count of model children.
+ * This function must be entered WITH the playlist lock */
+int PLModel::fetchedCount( playlist_item_t *p_node, const PLItem *item ) const
+{
+    int count = qMin( item->i_fetched, qMax( p_node->i_children, 0 ) );
+    if( item->children.isEmpty() )
+        return count;
+
+    /* Look for the last fetched child, first where it was */
+    int i_last = item->children.last()->id();
+    for( int i = count - 1; i >= 0; i-- )
+        if( p_node->pp_children[i]->i_id == i_last )
+        {
+            i++;
+            while( i < count
+                && ( p_node->pp_children[i]->i_flags & PLAYLIST_DBL_FLAG ) )
+                i++;
+            return i;
+        }
+    for( int i = count; i < p_node->i_children; i++ )
+        if( p_node->pp_children[i]->i_id == i_last )
+            return i + 1;
+    return count;
+}
+
+/* Creates the next children of a node, without adding them.
+ * This function must be entered WITH the playlist lock */
+QList<PLItem*> PLModel::fetchChildren( playlist_item_t *p_node, PLItem *root,
+                                       int max )
+{
+    QList<PLItem*> items;
+    int i = fetchedCount( p_node, root );
+
+    for( ; i < p_node->i_children && items.count() < max; i++ )
     {
         if( p_node->pp_children[i]->i_flags & PLAYLIST_DBL_FLAG ) continue;
-        PLItem *newItem =  new PLItem( p_node->pp_children[i], root );
-        root->appendChild( newItem );
-        if( p_node->pp_children[i]->i_children != -1 )
-            updateChildren( p_node->pp_children[i], newItem );
+        items.append( new PLItem( p_node->pp_children[i], root ) );
+    }
+    root->i_fetched = i;
+    return items;
+}
+
+/* Replaces the children of an item with the first children of its node */
+void PLModel::refetchChildren( PLItem *item )
+{
+    QModelIndex qIndex = index( item, 0 );
+    int count = item->childCount();
+    if( count )
+    {
+        beginRemoveRows( qIndex, 0, count - 1 );
+        item->clearChildren();
+        endRemoveRows( );
+    }
+
+    QList<PLItem*> items;
+    {
+        vlc_playlist_locker pl_lock ( THEPL );
+
+        playlist_item_t *p_node = playlist_ItemGetById( p_playlist,
+                                                        item->id() );
+        item->i_fetched = 0;
+        if( p_node )
+            items = fetchChildren( p_node, item, PLMODEL_FETCH_CHUNK );
     }
+    insertChildren( item, items, 0 );
+}
+
+/* Fetches the children down to an input item below the root, and returns its
+ * model item */
+PLItem *PLModel::fetchUpTo( const input_item_t *p_input )
+{
+    PLItem *item = findByInput( rootItem, p_input );
+    if( item ) return item;
+
+    /* Playlist IDs of the item and of its parents below the root */
+    QList<int> path;
+    {
+        vlc_playlist_locker pl_lock ( THEPL );
+
+        playlist_item_t *p_item = playlist_ItemGetByInput( p_playlist, p_input );
+        for( ; p_item && p_item->i_id != rootItem->id(); p_item = p_item->p_parent )
+            path.prepend( p_item->i_id );
+        if( !p_item ) return NULL;
+    }
+
+    item = rootItem;
+    foreach( int i_id, path )
+    {
+        PLItem *child = NULL;
+        int i = 0;
+
+        for( ;; )
+        {
+            for( ; i < item->childCount() && !child; i++ )
+                if( item->children[i]->id() == i_id )
+                    child = static_cast<PLItem*>( item->children[i] );
+            if( child || !canFetchMore( index( item, 0 ) ) )
+                break;
+            fetchMore( index( item, 0 ) );
+        }
+        if( !child ) return NULL;
+        item = child;
+    }
+    return item;
 }
 
 /* Function doesn't need playlist-lock, as we don't touch playlist_item_t stuff here*/
@@ -824,22 +1029,11 @@ void PLModel::sort( QModelIndex caller, QModelIndex rootIndex, const int column,
         ? static_cast<AbstractPLItem*>( caller.internalPointer() )->inputItem()
         : NULL;
 
-    int i_root_id = item->id();
-
-    QModelIndex qIndex = index( item, 0 );
-    int count = item->childCount();
-    if( count )
-    {
-        beginRemoveRows( qIndex, 0, count - 1 );
-        item->clearChildren();
-        endRemoveRows( );
-    }
-
     {
         vlc_playlist_locker pl_lock ( THEPL );
 
         playlist_item_t *p_root = playlist_ItemGetById( p_playlist,
-                                                        i_root_id );
+                                                        item->id() );
         if( p_root )
         {
             playlist_RecursiveNodeSort( p_playlist, p_root,
@@ -847,14 +1041,8 @@ void PLModel::sort( QModelIndex caller, QModelIndex rootIndex, const int column,
                                         order == Qt::AscendingOrder ?
                                             ORDER_NORMAL : ORDER_REVERSE );
         }
-
-        if( count )
-        {
-            beginInsertRows( qIndex, 0, count - 1 );
-            updateChildren( item );
-            endInsertRows( );
-        }
     }
+    refetchChildren( item );
 
     /* if we have popup item, try to make sure that you keep that item visible */
     if( p_caller_item )
@@ -880,23 +1068,12 @@ void PLModel::filter( const QString& search_text, const QModelIndex & idx, bool
         assert( p_root );
         playlist_LiveSearchUpdate( p_playlist, p_root, qtu( search_text ),
                                    b_recursive );
-        if( idx.isValid() )
-        {
-            PLItem *searchRoot = getItem( idx );
-
-            beginRemoveRows( idx, 0, searchRoot->childCount() - 1 );
-            searchRoot->clearChildren();
-            endRemoveRows();
-
-            beginInsertRows( idx, 0, searchRoot->childCount() - 1 );
-            updateChildren( searchRoot ); // The PL_LOCK is needed here
-            endInsertRows();
-
-            return;
-        }
     }
 
-    rebuild();
+    if( idx.isValid() )
+        refetchChildren( getItem( idx ) );
+    else
+        rebuild();
 }
 
 void PLModel::removeAll()
@@ -1008,6 +1185,10 @@ bool PLModel::action( QAction *action, const QModelIndexList &indexes )
     case ACTION_ENQUEUEDIR:
         if( a.uris.isEmpty() ) break;
 
+        /* Remember the library folders, so that they are indexed */
+        if( getPLRootType() == ROOTTYPE_MEDIA_LIBRARY )
+            MediaIndex::getInstance( p_intf )->addFolder( a.uris.first() );
+
         Open::openMRL( p_intf, a.uris.first().toLatin1().constData(),
                        false, getPLRootType() == ROOTTYPE_CURRENT_PLAYING );
 
@@ -78,6 +78,9 @@ public:
     Qt::ItemFlags flags( const QModelIndex &index ) const Q_DECL_OVERRIDE;
     QModelIndex index( const int r, const int c, const QModelIndex &parent ) const Q_DECL_OVERRIDE;
     QModelIndex parent( const QModelIndex &index ) const Q_DECL_OVERRIDE;
+    bool hasChildren( const QModelIndex &parent = QModelIndex() ) const Q_DECL_OVERRIDE;
+    bool canFetchMore( const QModelIndex &parent ) const Q_DECL_OVERRIDE;
+    void fetchMore( const QModelIndex &parent ) Q_DECL_OVERRIDE;
 
     /* Drag and Drop */
     Qt::DropActions supportedDropActions() const Q_DECL_OVERRIDE;
@@ -129,9 +132,13 @@ private:
     void recurseDelete( QList<AbstractPLItem*> children, QModelIndexList *fullList );
     void takeItem( PLItem * ); //will not delete item
     void insertChildren( PLItem *node, QList<PLItem*>& items, int i_pos );
+    void refetchChildren( PLItem * );
+    PLItem *fetchUpTo( const input_item_t * );
     /* ...of which  the following will not update the views */
     void updateChildren( PLItem * );
     void updateChildren( playlist_item_t *, PLItem * );
+    int fetchedCount( playlist_item_t *, const PLItem * ) const;
+    QList<PLItem*> fetchChildren( playlist_item_t *, PLItem *, int );
 
     /* Deep actions (affect core playlist) */
     void dropAppendCopy( const PlMimeData * data, PLItem *target, int pos );
@@ -161,6 +168,7 @@ private slots:
     void processInputItemUpdate();
     void processItemRemoval( int i_pl_itemid );
     void processItemAppend( int i_pl_itemid, int i_pl_itemidparent );
+    void processBatch( int i_pl_nodeid );
     void activateItem( playlist_item_t *p_item );
     virtual void activateItem( const QModelIndex &index ) Q_DECL_OVERRIDE;
 };
@@ -23,9 +23,9 @@
 
 #include "vlc_model.hpp"
 #include "input_manager.hpp"                            /* THEMIM */
+#include "util/artloader.hpp"
 #include "pixmaps/types/type_unknown.xpm"
 
-#include <QImageReader>
 
 VLCModelSubInterface::VLCModelSubInterface()
 {
@@ -62,6 +62,9 @@ VLCModel::VLCModel( intf_thread_t *_p_intf, QObject *parent )
     ADD_ICON( PLAYLIST, ":/type/playlist.svg" );
     ADD_ICON( NODE, ":/type/node.svg" );
 #undef ADD_ICON
+
+    CONNECT( ArtLoader::getInstance( p_intf ), artLoaded( const QModelIndex & ),
+             this, artLoaded( const QModelIndex & ) );
 }
 
 VLCModel::~VLCModel()
@@ -75,39 +78,42 @@ QString VLCModel::getMeta( const QModelIndex & index, int meta )
         data().toString();
 }
 
-QPixmap VLCModel::getArtPixmap( const QModelIndex & index, const QSize & size )
+/* The art is decoded in the background: until it is ready, the "no art"
+   pixmap is returned, and the index data is changed afterwards. */
+QPixmap VLCModel::getArtPixmap( const QModelIndex & index, const QSize & size,
+                                bool *pending )
 {
     QString artUrl = index.sibling( index.row(),
                      VLCModel::columnFromMeta(COLUMN_COVER) ).data().toString();
     QPixmap artPix;
 
-    QString key = artUrl + QString("%1%2").arg(size.width()).arg(size.height());
+    if( pending ) *pending = false;
 
-    if( !QPixmapCache::find( key, artPix ))
+    if( artUrl.isEmpty() == false )
     {
-        if( artUrl.isEmpty() == false )
-        {
-            QImageReader reader( artUrl );
-            reader.setDecideFormatFromContent( true );
-            artPix = QPixmap::fromImageReader( &reader ).scaled( size );
-            if ( artPix.isNull() == false )
-            {
-                QPixmapCache::insert( key, artPix );
-                return artPix;
-            }
-        }
-        key = QString("noart%1%2").arg(size.width()).arg(size.height());
-        if( !QPixmapCache::find( key, artPix ) )
-        {
-            artPix = QPixmap( ":/noart" ).scaled( size,
-                                          Qt::KeepAspectRatio,
-                                          Qt::SmoothTransformation );
-            QPixmapCache::insert( key, artPix );
-        }
+        artPix = ArtLoader::getInstance()->get( artUrl, size, index, pending );
+        if ( artPix.isNull() == false )
+            return artPix;
+    }
+
+    QString key = QString("noart%1%2").arg(size.width()).arg(size.height());
+    if( !QPixmapCache::find( key, artPix ) )
+    {
+        artPix = QPixmap( ":/noart" ).scaled( size,
+                                      Qt::KeepAspectRatio,
+                                      Qt::SmoothTransformation );
+        QPixmapCache::insert( key, artPix );
     }
     return artPix;
 }
 
+void VLCModel::artLoaded( const QModelIndex &index )
+{
+    if( index.model() != this ) return;
+    emit dataChanged( index.sibling( index.row(), 0 ),
+                      index.sibling( index.row(), columnCount( index.parent() ) - 1 ) );
+}
+
 QVariant VLCModel::headerData( int section, Qt::Orientation orientation,
                               int role ) const
 {
@@ -138,12 +138,16 @@ public:
     static int columnToMeta( int _column );
     static int metaToColumn( int meta );
     static QString getMeta( const QModelIndex & index, int meta );
-    static QPixmap getArtPixmap( const QModelIndex & index, const QSize & size );
+    static QPixmap getArtPixmap( const QModelIndex & index, const QSize & size,
+                                 bool *pending = NULL );
 
 public slots:
     /* slots handlers */
     void ensureArtRequested( const QModelIndex &index ) Q_DECL_OVERRIDE;
 
+private slots:
+    void artLoaded( const QModelIndex &index );
+
 signals:
     void currentIndexChanged( const QModelIndex& );
     void rootIndexChanged();
@@ -36,6 +36,9 @@
 #include <vlc_aout.h>           /* audio_output_t */
 
 #include <QApplication>
+#include <QGuiApplication>
+#include <QScreen>
+#include <QTimer>
 #include <QFile>
 #include <QDir>
 #include <QSignalMapper>
@@ -77,8 +80,11 @@ InputManager::InputManager( MainInputManager *mim, intf_thread_t *_p_intf) :
     timeA        = 0;
     timeB        = 0;
     f_cache      = -1.; /* impossible initial value, different from all */
+    coalesceTimer = new QTimer( this );
+    coalesceTimer->setSingleShot( true );
+    CONNECT( coalesceTimer, timeout(), this, flushCoalesced() );
     registerAndCheckEventIds( IMEvent::PositionUpdate, IMEvent::FullscreenControlPlanHide );
-    registerAndCheckEventIds( PLEvent::PLItemAppended, PLEvent::PLEmpty );
+    registerAndCheckEventIds( PLEvent::PLItemAppended, PLEvent::PLBatch );
 }
 
 InputManager::~InputManager()
@@ -173,6 +179,9 @@ void InputManager::delInput()
     }
 
     delCallbacks();
+    /* no callback can be running anymore, drop what they left pending */
+    pendingEvents.store( 0 );
+    coalesceTimer->stop();
     i_old_playing_status = END_S;
     p_item               = NULL;
     oldName              = "";
@@ -215,6 +224,24 @@ void InputManager::delInput()
     emit cachingChanged( 0.0 );
 }
 
+/* High rate events are coalesced: the input thread only records the type
+ * of the event, and the first one since the last flush wakes the UI thread
+ * up. The UI then handles each type once, at the display refresh rate. */
+static inline int coalescedBit( int i_type )
+{
+    return 1 << ( i_type - IMEvent::PositionUpdate );
+}
+
+static qint64 coalesceInterval()
+{
+    QScreen *screen = QGuiApplication::primaryScreen();
+    qreal f_rate = screen ? screen->refreshRate() : 0.;
+
+    if( f_rate < 1. )
+        f_rate = 60.;
+    return qMax( (qint64)( 1000. / f_rate ), (qint64)1 );
+}
+
 /* Convert the event from the callbacks in actions */
 void InputManager::customEvent( QEvent *event )
 {
@@ -248,8 +275,21 @@ void InputManager::customEvent( QEvent *event )
         }
         break;
     case IMEvent::ItemStateChanged:
+        /* Don't let a late position follow the new state */
+        if( pendingEvents.load() != 0 )
+            flushCoalesced();
         UpdateStatus();
         break;
+    case IMEvent::CoalescedUpdate:
+        if( !coalesceTimer->isActive() )
+        {
+            qint64 i_interval = coalesceInterval();
+            if( !lastFlush.isValid() || lastFlush.elapsed() >= i_interval )
+                flushCoalesced();
+            else
+                coalesceTimer->start( i_interval - lastFlush.elapsed() );
+        }
+        break;
     case IMEvent::MetaChanged:
         UpdateMeta();
         UpdateName(); /* Needed for NowPlaying */
@@ -302,6 +342,34 @@ void InputManager::customEvent( QEvent *event )
     }
 }
 
+void InputManager::postCoalesced( IMEvent::event_types type )
+{
+    if( pendingEvents.fetchAndOrOrdered( coalescedBit( type ) ) == 0 )
+        QApplication::postEvent( this,
+                                 new IMEvent( IMEvent::CoalescedUpdate ) );
+}
+
+void InputManager::flushCoalesced()
+{
+    int i_pending = pendingEvents.fetchAndStoreOrdered( 0 );
+
+    coalesceTimer->stop();
+    lastFlush.start();
+    if( !hasInput() )
+        return;
+
+    if( i_pending & coalescedBit( IMEvent::PositionUpdate ) )
+        UpdatePosition();
+    if( i_pending & coalescedBit( IMEvent::StatisticsUpdate ) )
+        UpdateStats();
+    if( i_pending & coalescedBit( IMEvent::CachingEvent ) )
+        UpdateCaching();
+    if( i_pending & coalescedBit( IMEvent::InfoChanged ) )
+        UpdateInfo();
+    if( i_pending & coalescedBit( IMEvent::EPGEvent ) )
+        UpdateEPG();
+}
+
 /* Add the callbacks on Input. Self explanatory */
 inline void InputManager::addCallbacks()
 {
@@ -330,7 +398,7 @@ static int InputEvent( vlc_object_t *, const char *,
                        vlc_value_t, vlc_value_t newval, void *param )
 {
     InputManager *im = (InputManager*)param;
-    IMEvent *event;
+    IMEvent *event = NULL;
 
     switch( newval.i_int )
     {
@@ -342,7 +410,7 @@ static int InputEvent( vlc_object_t *, const char *,
         break;
     case INPUT_EVENT_POSITION:
     //case INPUT_EVENT_LENGTH:
-        event = new IMEvent( IMEvent::PositionUpdate );
+        im->postCoalesced( IMEvent::PositionUpdate );
         break;
 
     case INPUT_EVENT_TITLE:
@@ -358,7 +426,7 @@ static int InputEvent( vlc_object_t *, const char *,
         break;
 
     case INPUT_EVENT_STATISTICS:
-        event = new IMEvent( IMEvent::StatisticsUpdate );
+        im->postCoalesced( IMEvent::StatisticsUpdate );
         break;
 
     case INPUT_EVENT_VOUT:
@@ -372,7 +440,7 @@ static int InputEvent( vlc_object_t *, const char *,
         event = new IMEvent( IMEvent::MetaChanged );
         break;
     case INPUT_EVENT_ITEM_INFO: /* Codec Info */
-        event = new IMEvent( IMEvent::InfoChanged );
+        im->postCoalesced( IMEvent::InfoChanged );
         break;
 
     case INPUT_EVENT_AUDIO_DELAY:
@@ -381,7 +449,7 @@ static int InputEvent( vlc_object_t *, const char *,
         break;
 
     case INPUT_EVENT_CACHE:
-        event = new IMEvent( IMEvent::CachingEvent );
+        im->postCoalesced( IMEvent::CachingEvent );
         break;
 
     case INPUT_EVENT_BOOKMARK:
@@ -399,7 +467,7 @@ static int InputEvent( vlc_object_t *, const char *,
 
     case INPUT_EVENT_ITEM_EPG:
         /* EPG data changed */
-        event = new IMEvent( IMEvent::EPGEvent );
+        im->postCoalesced( IMEvent::EPGEvent );
         break;
 
     case INPUT_EVENT_SIGNAL:
@@ -997,6 +1065,7 @@ MainInputManager::MainInputManager( intf_thread_t *_p_intf )
     var_AddCallback( THEPL, "leaf-to-parent", MainInputManager::LeafToParent, this );
     var_AddCallback( THEPL, "playlist-item-append", MainInputManager::PLItemAppended, this );
     var_AddCallback( THEPL, "playlist-item-deleted", MainInputManager::PLItemRemoved, this );
+    var_AddCallback( THEPL, "playlist-batch", MainInputManager::PLBatch, this );
 
     /* Core Callbacks to widget */
     random.addCallback( this, SLOT(notifyRandom(bool)) );
@@ -1025,6 +1094,7 @@ MainInputManager::~MainInputManager()
 
     var_DelCallback( THEPL, "playlist-item-append", MainInputManager::PLItemAppended, this );
     var_DelCallback( THEPL, "playlist-item-deleted", MainInputManager::PLItemRemoved, this );
+    var_DelCallback( THEPL, "playlist-batch", MainInputManager::PLBatch, this );
 
     delete menusAudioMapper;
 }
@@ -1086,6 +1156,10 @@ void MainInputManager::customEvent( QEvent *event )
         plEv = static_cast<PLEvent*>( event );
         emit leafBecameParent( plEv->getItemId() );
         return;
+    case PLEvent::PLBatch:
+        plEv = static_cast<PLEvent*>( event );
+        emit playlistBatchCommitted( plEv->getItemId() );
+        return;
     default:
         if( type != IMEvent::ItemChanged ) return;
     }
@@ -1251,13 +1325,17 @@ void MainInputManager::menusUpdateAudio( const QString& data )
     }
 }
 
-int MainInputManager::PLItemAppended( vlc_object_t *, const char *,
+int MainInputManager::PLItemAppended( vlc_object_t *obj, const char *,
                                       vlc_value_t, vlc_value_t cur,
                                       void *data )
 {
     MainInputManager *mim = static_cast<MainInputManager*>(data);
     playlist_item_t *item = static_cast<playlist_item_t *>( cur.p_address );
 
+    /* The whole batch is processed at once, see PLBatch() */
+    if( playlist_IsBatching( (playlist_t *)obj ) ) // lock is held
+        return VLC_SUCCESS;
+
     PLEvent *event = new PLEvent( PLEvent::PLItemAppended, item->i_id,
         (item->p_parent != NULL) ? item->p_parent->i_id : -1  );
     QApplication::postEvent( mim, event );
@@ -1274,6 +1352,9 @@ int MainInputManager::PLItemRemoved( vlc_object_t *obj, const char *,
     MainInputManager *mim = static_cast<MainInputManager*>(data);
     playlist_item_t *item = static_cast<playlist_item_t *>( cur.p_address );
 
+    if( playlist_IsBatching( pl ) ) // lock is held
+        return VLC_SUCCESS;
+
     PLEvent *event = new PLEvent( PLEvent::PLItemRemoved, item->i_id, 0  );
     QApplication::postEvent( mim, event );
     // can't use playlist_IsEmpty(  ) as it isn't true yet
@@ -1285,6 +1366,23 @@ int MainInputManager::PLItemRemoved( vlc_object_t *obj, const char *,
     return VLC_SUCCESS;
 }
 
+int MainInputManager::PLBatch( vlc_object_t *obj, const char *,
+                               vlc_value_t, vlc_value_t cur, void *data )
+{
+    playlist_t *pl = (playlist_t *) obj;
+    MainInputManager *mim = static_cast<MainInputManager*>(data);
+    playlist_item_t *node = static_cast<playlist_item_t *>( cur.p_address );
+
+    PLEvent *event = new PLEvent( PLEvent::PLBatch, node->i_id, 0 );
+    QApplication::postEvent( mim, event );
+
+    // lock is held
+    event = new PLEvent( PLEvent::PLEmpty,
+                         playlist_IsEmpty( pl ) ? -1 : node->i_id, 0 );
+    QApplication::postEvent( mim, event );
+    return VLC_SUCCESS;
+}
+
 void MainInputManager::changeFullscreen( bool new_val )
 {
     if ( var_GetBool( THEPL, "fullscreen" ) != new_val)
@@ -37,7 +37,10 @@
 
 #include <QObject>
 #include <QEvent>
+#include <QAtomicInt>
+#include <QElapsedTimer>
 class QSignalMapper;
+class QTimer;
 
 enum { NORMAL,    /* loop: 0, repeat: 0 */
        REPEAT_ONE,/* loop: 0, repeat: 1 */
@@ -68,6 +71,7 @@ public:
         RandomChanged,
         LoopOrRepeatChanged, /* 20 */
         EPGEvent,
+        CoalescedUpdate, /* holds no data, see InputManager::postCoalesced */
     /*    SignalChanged, */
 
         FullscreenControlToggle = QEvent::User + IMEventTypeOffset + 50,
@@ -103,7 +107,8 @@ public:
         PLItemAppended = QEvent::User + PLEventTypeOffset + 1,
         PLItemRemoved,
         LeafToParent,
-        PLEmpty
+        PLEmpty,
+        PLBatch
     };
 
     PLEvent( PLEventTypes t, int i, int p = 0 )
@@ -143,6 +148,10 @@ public:
     QString getName() { return oldName; }
     static const QString decodeArtURL( input_item_t *p_item );
 
+    /// Merges high rate events, delivered once per display refresh at most
+    /// (thread-safe)
+    void postCoalesced( IMEvent::event_types );
+
 private:
     intf_thread_t  *p_intf;
     MainInputManager* p_mim;
@@ -157,6 +166,9 @@ private:
     float           f_cache;
     bool            b_video;
     mtime_t         timeA, timeB;
+    QAtomicInt      pendingEvents; ///< bit mask of the coalesced event types
+    QTimer         *coalesceTimer;
+    QElapsedTimer   lastFlush;
 
     void customEvent( QEvent * );
 
@@ -212,6 +224,7 @@ public slots:
 
 private slots:
     void AtoBLoop( float, int64_t, int );
+    void flushCoalesced();
 
 signals:
     /// Send new position, new time and new length
@@ -308,6 +321,8 @@ private:
                             vlc_value_t, vlc_value_t, void * );
     static int PLItemRemoved( vlc_object_t *, const char *,
                             vlc_value_t, vlc_value_t, void * );
+    static int PLBatch( vlc_object_t *, const char *,
+                        vlc_value_t, vlc_value_t, void * );
 
 public slots:
     void togglePlayPause();
@@ -336,6 +351,7 @@ signals:
     void soundMuteChanged( bool );
     void playlistItemAppended( int itemId, int parentId );
     void playlistItemRemoved( int itemId );
+    void playlistBatchCommitted( int nodeId );
     void playlistNotEmpty( bool );
     void randomChanged( bool );
     void repeatLoopChanged( int );
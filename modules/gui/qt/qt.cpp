@@ -46,6 +46,8 @@
 #include "dialogs/help.hpp"     /* Launch Update */
 #include "recents.hpp"          /* Recents Item destruction */
 #include "util/qvlcapp.hpp"     /* QVLCApplication definition */
+#include "util/artloader.hpp"   /* ArtLoader::killInstance */
+#include "util/media_index.hpp" /* MediaIndex::killInstance */
 #include "components/playlist/playlist_model.hpp" /* for ~PLModel() */
 
 #include <vlc_plugin.h>
@@ -617,6 +619,10 @@ static void *ThreadPlatform( void *obj, char *platform_name )
         var_Create( THEPL, "window", VLC_VAR_STRING );
         if( p_sys->voutWindowType != VOUT_WINDOW_TYPE_INVALID )
             var_SetString( THEPL, "window", "qt,any" );
+
+        /* Loads the library index, and looks for changes in the background */
+        if( THEPL->p_media_library )
+            MediaIndex::getInstance( p_intf );
     }
 
     /* Explain how to show a dialog :D */
@@ -684,6 +690,12 @@ static void *ThreadPlatform( void *obj, char *platform_name )
     /* */
     delete p_sys->pl_model;
 
+    /* The art loader may still be decoding for the models */
+    ArtLoader::killInstance();
+
+    /* Stops the folder scans, and saves the index */
+    MediaIndex::killInstance();
+
     /* Destroy the MainInputManager */
     MainInputManager::killInstance();
 
@@ -0,0 +1,139 @@
+/*****************************************************************************
+ * artloader.cpp : Background cover art loader
+ ****************************************************************************
+ * Copyright (C) 2017 the VideoLAN team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "util/artloader.hpp"
+
+#include <QImageReader>
+#include <QMetaObject>
+#include <QPixmapCache>
+#include <QRunnable>
+#include <QThread>
+
+/* Sizes are rounded up to a multiple of this to share the decoding */
+#define ART_BUCKET_STEP 32
+
+namespace {
+
+class ArtLoaderTask : public QRunnable
+{
+public:
+    ArtLoaderTask( QObject *_loader, const QString &_url, const QString &_key,
+                   const QSize &_size )
+        : loader( _loader ), url( _url ), key( _key ), size( _size ) {}
+
+    void run() Q_DECL_OVERRIDE
+    {
+        QImageReader reader( url );
+        reader.setDecideFormatFromContent( true );
+        /* Formats such as JPEG decode directly to the smaller size */
+        reader.setScaledSize( size );
+        QImage image = reader.read();
+
+        QMetaObject::invokeMethod( loader, "loaded", Qt::QueuedConnection,
+                                   Q_ARG( QString, key ),
+                                   Q_ARG( QImage, image ) );
+    }
+
+private:
+    QObject *loader;
+    QString url;
+    QString key;
+    QSize size;
+};
+
+}
+
+ArtLoader::ArtLoader( intf_thread_t * )
+{
+    /* Keep some cores for the input and the GUI */
+    pool.setMaxThreadCount( qBound( 1, QThread::idealThreadCount() / 2, 4 ) );
+}
+
+ArtLoader::~ArtLoader()
+{
+    pool.clear();
+    pool.waitForDone();
+}
+
+QSize ArtLoader::bucket( const QSize &size )
+{
+    return QSize( ( size.width() + ART_BUCKET_STEP - 1 ) / ART_BUCKET_STEP * ART_BUCKET_STEP,
+                  ( size.height() + ART_BUCKET_STEP - 1 ) / ART_BUCKET_STEP * ART_BUCKET_STEP );
+}
+
+QString ArtLoader::key( const QString &url, const QSize &size )
+{
+    return url + QString("%1%2").arg(size.width()).arg(size.height());
+}
+
+QPixmap ArtLoader::get( const QString &url, const QSize &size,
+                        const QModelIndex &index, bool *pending )
+{
+    QPixmap artPix;
+    QString sizeKey = key( url, size );
+
+    if( pending ) *pending = false;
+
+    if( QPixmapCache::find( sizeKey, artPix ) )
+        return artPix;
+
+    /* Scaling down a decoded bucket is cheap enough to be done at once */
+    QSize bucketSize = bucket( size );
+    QString bucketKey = key( url, bucketSize );
+    if( QPixmapCache::find( bucketKey, artPix ) )
+    {
+        artPix = artPix.scaled( size );
+        QPixmapCache::insert( sizeKey, artPix );
+        return artPix;
+    }
+
+    if( failed.contains( bucketKey ) )
+        return QPixmap();
+
+    QHash<QString, QList<QPersistentModelIndex> >::iterator it =
+        pending.find( bucketKey );
+    if( it == pending.end() )
+    {
+        it = pending.insert( bucketKey, QList<QPersistentModelIndex>() );
+        pool.start( new ArtLoaderTask( this, url, bucketKey, bucketSize ) );
+    }
+    if( index.isValid() && !it->contains( index ) )
+        it->append( index );
+    if( pending ) *pending = true;
+    return QPixmap();
+}
+
+void ArtLoader::loaded( const QString &bucketKey, const QImage &image )
+{
+    QList<QPersistentModelIndex> indexes = pending.take( bucketKey );
+
+    if( image.isNull() )
+        failed.insert( bucketKey );
+    else
+        QPixmapCache::insert( bucketKey, QPixmap::fromImage( image ) );
+
+    foreach( const QPersistentModelIndex &index, indexes )
+        if( index.isValid() )
+            emit artLoaded( index );
+}
@@ -0,0 +1,78 @@
+/*****************************************************************************
+ * artloader.hpp : Background cover art loader
+ ****************************************************************************
+ * Copyright (C) 2017 the VideoLAN team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_QT_ARTLOADER_HPP_
+#define VLC_QT_ARTLOADER_HPP_
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "qt.hpp"
+#include "util/singleton.hpp"
+
+#include <QObject>
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QPersistentModelIndex>
+#include <QPixmap>
+#include <QSet>
+#include <QSize>
+#include <QString>
+#include <QThreadPool>
+
+/* Decodes and scales cover art on background threads, so that views never
+   wait for an image while painting.
+   Art is decoded once per size bucket, then scaled to the requested sizes.
+   Both are kept in the QPixmapCache, which bounds their memory. */
+class ArtLoader : public QObject, public Singleton<ArtLoader>
+{
+    Q_OBJECT
+    friend class Singleton<ArtLoader>;
+
+public:
+    /* Returns the art of the given size, or a null pixmap if it cannot be
+       decoded, or if it is not loaded yet: then artLoaded() is emitted with
+       the index once it is. */
+    QPixmap get( const QString &url, const QSize &size,
+                 const QModelIndex &index, bool *pending = NULL );
+
+signals:
+    void artLoaded( const QModelIndex & );
+
+private:
+    ArtLoader( intf_thread_t * );
+    virtual ~ArtLoader();
+
+    static QSize bucket( const QSize & );
+    static QString key( const QString &url, const QSize &size );
+
+    QThreadPool pool;
+    /* Indexes to update for each bucket being decoded */
+    QHash<QString, QList<QPersistentModelIndex> > pending;
+    /* Buckets that could not be decoded */
+    QSet<QString> failed;
+
+private slots:
+    void loaded( const QString &key, const QImage &image );
+};
+
+#endif
@@ -32,6 +32,7 @@
 #include "util/input_slider.hpp"
 #include "util/timetooltip.hpp"
 #include "adapters/seekpoints.hpp"
+#include "util/thumbnailer.hpp"
 #include "input_manager.hpp"
 #include "imagehelper.hpp"
 
@@ -72,6 +73,7 @@ SeekSlider::SeekSlider( Qt::Orientation q, QWidget *_parent, bool _static )
     mHandleOpacity = 1.0;
     mLoading = 0.0;
     chapters = NULL;
+    thumbnailer = NULL;
     mHandleLength = -1;
     b_seekable = true;
     alternativeStyle = NULL;
@@ -191,6 +193,25 @@ void SeekSlider::setChapters( SeekPoints *chapters_ )
     chapters->setParent( this );
 }
 
+/***
+ * \brief Sets the previews shown in the tooltip
+ *
+ * \params SeekThumbnailer initialized with current intf thread
+***/
+void SeekSlider::setThumbnailer( SeekThumbnailer *thumbnailer_ )
+{
+    delete thumbnailer;
+    thumbnailer = thumbnailer_;
+    thumbnailer->setParent( this );
+    CONNECT( thumbnailer, previewReady( const QImage & ),
+             this, previewReady( const QImage & ) );
+}
+
+void SeekSlider::previewReady( const QImage &image )
+{
+    mTimeTooltip->setPreview( image );
+}
+
 /***
  * \brief Main public method, superseeding setValue. Disabling the slider when neeeded
  *
@@ -387,7 +408,15 @@ void SeekSlider::mouseMoveEvent( QMouseEvent *event )
         QPoint target( event->globalX() - ( event->x() - posX ),
                 QWidget::mapToGlobal( QPoint( 0, 0 ) ).y() );
         if( likely( size().width() > handleLength() ) ) {
-            secstotimestr( psz_length, getValuePercentageFromXPos( event->x() ) * inputLength );
+            float f_pos = getValuePercentageFromXPos( event->x() );
+            secstotimestr( psz_length, f_pos * inputLength );
+            /* Until the new one is decoded, the previous preview is kept */
+            if( thumbnailer )
+            {
+                QImage preview = thumbnailer->get( f_pos );
+                if( !preview.isNull() )
+                    mTimeTooltip->setPreview( preview );
+            }
             mTimeTooltip->setTip( target, psz_length, chapterLabel );
         }
     }
@@ -35,6 +35,7 @@
 #include <QSlider>
 #include <QPainter>
 #include <QTime>
+#include <QImage>
 
 #define MSTRTIME_MAX_SIZE 22
 
@@ -43,6 +44,7 @@ class QWheelEvent;
 class QHideEvent;
 class QTimer;
 class SeekPoints;
+class SeekThumbnailer;
 class QPropertyAnimation;
 class QCommonStyle;
 class TimeTooltip;
@@ -58,6 +60,7 @@ public:
     SeekSlider( Qt::Orientation q, QWidget *_parent = 0, bool _classic = false );
     virtual ~SeekSlider();
     void setChapters( SeekPoints * );
+    void setThumbnailer( SeekThumbnailer * );
 
 protected:
     void mouseMoveEvent( QMouseEvent *event ) Q_DECL_OVERRIDE;
@@ -93,6 +96,7 @@ private:
     float f_buffering;
     QTime bufferingStart;
     SeekPoints* chapters;
+    SeekThumbnailer *thumbnailer;
     bool b_classic;
     bool b_seekable;
     int mHandleLength;
@@ -126,6 +130,7 @@ private slots:
     void updatePos();
     void inputUpdated( bool );
     void startAnimLoading();
+    void previewReady( const QImage & );
 
 signals:
     void sliderDragged( float );
@@ -0,0 +1,478 @@
+/*****************************************************************************
+ * media_index.cpp : Persistent index of the media library files
+ ****************************************************************************
+ * Copyright (C) 2017 the VideoLAN team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "util/media_index.hpp"
+#include "input_manager.hpp"      /* InputManager::decodeArtURL */
+
+#include <vlc_events.h>
+#include <vlc_input_item.h>
+#include <vlc_interface.h>        /* EXTENSIONS_MEDIA */
+#include <vlc_url.h>
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QMetaObject>
+#include <QMutex>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QSet>
+#include <QWaitCondition>
+
+#define MEDIA_INDEX_FILE    "media-index.dat"
+#define MEDIA_INDEX_MAGIC   0x564c4d49 /* VLMI */
+#define MEDIA_INDEX_VERSION 1
+
+/* Files being preparsed at the same time by a scan */
+#define MEDIA_INDEX_INFLIGHT 4
+/* Entries sent back to the GUI thread at once */
+#define MEDIA_INDEX_BATCH    64
+
+static QDataStream &operator<<( QDataStream &out, const MediaIndex::Entry &e )
+{
+    return out << e.uri << e.mtime << e.size << e.title << e.artist
+               << e.album << e.duration << e.artUrl;
+}
+
+static QDataStream &operator>>( QDataStream &in, MediaIndex::Entry &e )
+{
+    return in >> e.uri >> e.mtime >> e.size >> e.title >> e.artist
+              >> e.album >> e.duration >> e.artUrl;
+}
+
+namespace {
+
+class MediaIndexLoad : public QRunnable
+{
+public:
+    MediaIndexLoad( QObject *_index, const QString &_path )
+        : index( _index ), path( _path ) {}
+
+    void run() Q_DECL_OVERRIDE
+    {
+        QStringList dirs;
+        QVector<MediaIndex::Entry> entries;
+
+        QFile file( path );
+        if( file.open( QIODevice::ReadOnly ) )
+        {
+            QDataStream in( &file );
+            quint32 magic, version;
+
+            in >> magic >> version;
+            if( magic == MEDIA_INDEX_MAGIC && version == MEDIA_INDEX_VERSION )
+            {
+                in.setVersion( QDataStream::Qt_5_5 );
+                in >> dirs >> entries;
+            }
+            /* A damaged index is only rebuilt */
+            if( in.status() != QDataStream::Ok )
+            {
+                dirs.clear();
+                entries.clear();
+            }
+        }
+
+        QMetaObject::invokeMethod( index, "loaded", Qt::QueuedConnection,
+                                   Q_ARG( QStringList, dirs ),
+                                   Q_ARG( QVector<MediaIndex::Entry>, entries ) );
+    }
+
+private:
+    QObject *index;
+    QString path;
+};
+
+class MediaIndexSave : public QRunnable
+{
+public:
+    MediaIndexSave( const QString &_path, const QStringList &_dirs,
+                    const QVector<MediaIndex::Entry> &_entries )
+        : path( _path ), dirs( _dirs ), entries( _entries ) {}
+
+    void run() Q_DECL_OVERRIDE
+    {
+        QDir().mkpath( QFileInfo( path ).path() );
+
+        /* Written aside, so that a crash never leaves half an index */
+        QSaveFile file( path );
+        if( !file.open( QIODevice::WriteOnly ) )
+            return;
+
+        QDataStream out( &file );
+        out << (quint32)MEDIA_INDEX_MAGIC << (quint32)MEDIA_INDEX_VERSION;
+        out.setVersion( QDataStream::Qt_5_5 );
+        out << dirs << entries;
+        file.commit();
+    }
+
+private:
+    QString path;
+    QStringList dirs;
+    QVector<MediaIndex::Entry> entries;
+};
+
+class MediaIndexScan : public QRunnable
+{
+public:
+    MediaIndexScan( MediaIndex *_index, intf_thread_t *_p_intf,
+                    const QStringList &_folders,
+                    const MediaIndex::FileStates &_known )
+        : index( _index ), p_intf( _p_intf ), folders( _folders ),
+          known( _known ) {}
+
+    void run() Q_DECL_OVERRIDE
+    {
+        QStringList filters = qfu( EXTENSIONS_MEDIA ).split( ';' );
+        QStringList found;
+
+        foreach( const QString &folder, folders )
+        {
+            QDirIterator it( folder, filters, QDir::Files | QDir::Readable,
+                             QDirIterator::Subdirectories );
+
+            while( it.hasNext() && !index->isStopping() )
+            {
+                it.next();
+                QFileInfo info = it.fileInfo();
+
+                char *psz_uri = vlc_path2uri( qtu( info.absoluteFilePath() ),
+                                              NULL );
+                if( !psz_uri )
+                    continue;
+                QString uri = qfu( psz_uri );
+                free( psz_uri );
+                found.append( uri );
+
+                QPair<qint64, qint64> state(
+                    info.lastModified().toMSecsSinceEpoch(), info.size() );
+                MediaIndex::FileStates::const_iterator known_it =
+                    known.constFind( uri );
+                if( known_it != known.constEnd() && *known_it == state )
+                    continue;
+
+                preparse( uri, info.fileName(), state );
+                collect( MEDIA_INDEX_INFLIGHT - 1 );
+            }
+        }
+        collect( 0 );
+        flush();
+
+        if( !index->isStopping() )
+            QMetaObject::invokeMethod( index, "scanDone", Qt::QueuedConnection,
+                                       Q_ARG( QStringList, folders ),
+                                       Q_ARG( QStringList, found ) );
+    }
+
+private:
+    static void preparseEnded( const vlc_event_t *event, void *data )
+    {
+        MediaIndexScan *scan = static_cast<MediaIndexScan *>( data );
+
+        QMutexLocker locker( &scan->lock );
+        scan->done.append( static_cast<input_item_t *>( event->p_obj ) );
+        scan->wait.wakeAll();
+    }
+
+    void preparse( const QString &uri, const QString &name,
+                   const QPair<qint64, qint64> &state )
+    {
+        input_item_t *p_item = input_item_NewFile( qtu( uri ), qtu( name ),
+                                                   -1, ITEM_LOCAL );
+        if( !p_item )
+            return;
+
+        if( vlc_event_attach( &p_item->event_manager,
+                              vlc_InputItemPreparseEnded,
+                              preparseEnded, this ) )
+        {
+            input_item_Release( p_item );
+            return;
+        }
+        inflight.insert( p_item, state );
+
+        if( libvlc_MetadataRequest( p_intf->obj.libvlc, p_item,
+                                    META_REQUEST_OPTION_SCOPE_LOCAL, -1,
+                                    this ) )
+            finish( p_item, false );
+    }
+
+    /* Waits until at most window files are being preparsed */
+    void collect( int window )
+    {
+        while( inflight.count() > window )
+        {
+            QList<input_item_t *> items;
+            {
+                QMutexLocker locker( &lock );
+                while( done.isEmpty() && !index->isStopping() )
+                    wait.wait( &lock, 100 );
+                items.swap( done );
+            }
+
+            if( index->isStopping() )
+            {
+                /* Nothing is signaled for the requests cancelled before
+                   they were started */
+                libvlc_MetadataCancel( p_intf->obj.libvlc, this );
+                foreach( input_item_t *p_item, inflight.keys() )
+                    finish( p_item, false );
+                return;
+            }
+
+            foreach( input_item_t *p_item, items )
+                if( inflight.contains( p_item ) )
+                    finish( p_item, true );
+        }
+    }
+
+    void finish( input_item_t *p_item, bool b_store )
+    {
+        /* Past this point, the callback is not running and won't be called */
+        vlc_event_detach( &p_item->event_manager, vlc_InputItemPreparseEnded,
+                          preparseEnded, this );
+
+        QPair<qint64, qint64> state = inflight.take( p_item );
+        if( b_store )
+        {
+            MediaIndex::Entry entry;
+            char *psz;
+
+            psz = input_item_GetURI( p_item );
+            entry.uri = qfu( psz );
+            free( psz );
+            entry.mtime = state.first;
+            entry.size = state.second;
+            psz = input_item_GetTitleFbName( p_item );
+            entry.title = qfu( psz );
+            free( psz );
+            psz = input_item_GetArtist( p_item );
+            entry.artist = qfu( psz );
+            free( psz );
+            psz = input_item_GetAlbum( p_item );
+            entry.album = qfu( psz );
+            free( psz );
+            entry.duration = input_item_GetDuration( p_item );
+            entry.artUrl = InputManager::decodeArtURL( p_item );
+
+            batch.append( entry );
+            if( batch.count() >= MEDIA_INDEX_BATCH )
+                flush();
+        }
+        input_item_Release( p_item );
+    }
+
+    void flush()
+    {
+        if( batch.isEmpty() || index->isStopping() )
+            return;
+        QMetaObject::invokeMethod( index, "scanned", Qt::QueuedConnection,
+                                   Q_ARG( QVector<MediaIndex::Entry>, batch ) );
+        batch.clear();
+    }
+
+    MediaIndex *index;
+    intf_thread_t *p_intf;
+    QStringList folders;
+    MediaIndex::FileStates known;
+
+    QHash<input_item_t *, QPair<qint64, qint64> > inflight;
+    QVector<MediaIndex::Entry> batch;
+
+    /* Preparsed items, filled from the preparser threads */
+    QMutex lock;
+    QWaitCondition wait;
+    QList<input_item_t *> done;
+};
+
+}
+
+MediaIndex::MediaIndex( intf_thread_t *_p_intf )
+    : p_intf( _p_intf ), b_loaded( false ), stopping( 0 )
+{
+    qRegisterMetaType<MediaIndex::Entry>();
+    qRegisterMetaType<QVector<MediaIndex::Entry> >();
+
+    /* Scans are run one after the other */
+    pool.setMaxThreadCount( 1 );
+
+    path = QVLCUserDir( VLC_CACHE_DIR ) + DIR_SEP MEDIA_INDEX_FILE;
+    pool.start( new MediaIndexLoad( this, path ) );
+}
+
+MediaIndex::~MediaIndex()
+{
+    stopping.store( 1 );
+    pool.clear();
+    pool.waitForDone();
+
+    /* Keep what scans were interrupted, they'll resume where they stopped */
+    if( b_loaded )
+        MediaIndexSave( path, dirs, entries ).run();
+}
+
+QVector<MediaIndex::Entry> MediaIndex::page( int offset, int count ) const
+{
+    if( offset < 0 || offset >= entries.count() )
+        return QVector<Entry>();
+    return entries.mid( offset, count );
+}
+
+MediaIndex::FileStates MediaIndex::fileStates() const
+{
+    FileStates states;
+    states.reserve( entries.count() );
+    foreach( const Entry &entry, entries )
+        states.insert( entry.uri, qMakePair( entry.mtime, entry.size ) );
+    return states;
+}
+
+void MediaIndex::addFolder( const QString &folder )
+{
+    QString local = folder;
+
+    if( local.contains( "://" ) )
+    {
+        /* As returned by DialogsProvider::getDirectoryDialog() */
+        if( local.startsWith( "directory://" ) )
+            local.replace( 0, strlen( "directory" ), "file" );
+
+        char *psz_path = vlc_uri2path( qtu( local ) );
+        if( !psz_path )
+        {
+            msg_Warn( p_intf, "cannot index %s", qtu( folder ) );
+            return;
+        }
+        local = qfu( psz_path );
+        free( psz_path );
+    }
+
+    QString dir = QDir::cleanPath( QFileInfo( local ).absoluteFilePath() );
+
+    if( !dirs.contains( dir ) )
+        dirs.append( dir );
+    startScan( QStringList( dir ) );
+}
+
+void MediaIndex::rescan()
+{
+    startScan( dirs );
+}
+
+void MediaIndex::startScan( const QStringList &folders )
+{
+    /* All the folders are scanned once loaded */
+    if( b_loaded && !folders.isEmpty() )
+        pool.start( new MediaIndexScan( this, p_intf, folders, fileStates() ) );
+}
+
+void MediaIndex::save()
+{
+    pool.start( new MediaIndexSave( path, dirs, entries ) );
+}
+
+void MediaIndex::loaded( const QStringList &loadedDirs,
+                         const QVector<MediaIndex::Entry> &loadedEntries )
+{
+    entries = loadedEntries;
+    rows.clear();
+    rows.reserve( entries.count() );
+    for( int i = 0; i < entries.count(); i++ )
+        rows.insert( entries[i].uri, i );
+    foreach( const QString &dir, loadedDirs )
+        if( !dirs.contains( dir ) )
+            dirs.append( dir );
+    b_loaded = true;
+    emit reset();
+
+    /* Catch up with the changes made while VLC was not running */
+    rescan();
+}
+
+void MediaIndex::scanned( const QVector<MediaIndex::Entry> &batch )
+{
+    int first = entries.count();
+
+    foreach( const Entry &entry, batch )
+    {
+        int row = rows.value( entry.uri, -1 );
+        if( row >= 0 )
+        {
+            entries[row] = entry;
+            emit rowChanged( row );
+        }
+        else
+        {
+            rows.insert( entry.uri, entries.count() );
+            entries.append( entry );
+        }
+    }
+
+    if( entries.count() > first )
+        emit rowsAppended( first, entries.count() - 1 );
+}
+
+void MediaIndex::scanDone( const QStringList &folders,
+                           const QStringList &found )
+{
+    QStringList prefixes;
+    foreach( const QString &folder, folders )
+    {
+        char *psz_uri = vlc_path2uri( qtu( folder ), NULL );
+        if( psz_uri )
+            prefixes.append( qfu( psz_uri ) + "/" );
+        free( psz_uri );
+    }
+
+    /* Forget the files removed from the scanned folders */
+    QSet<QString> present = found.toSet();
+    QVector<Entry> kept;
+    kept.reserve( entries.count() );
+    foreach( const Entry &entry, entries )
+    {
+        bool b_scanned = false;
+        foreach( const QString &prefix, prefixes )
+            if( entry.uri.startsWith( prefix ) )
+            {
+                b_scanned = true;
+                break;
+            }
+        if( !b_scanned || present.contains( entry.uri ) )
+            kept.append( entry );
+    }
+
+    if( kept.count() != entries.count() )
+    {
+        entries = kept;
+        rows.clear();
+        for( int i = 0; i < entries.count(); i++ )
+            rows.insert( entries[i].uri, i );
+        emit reset();
+    }
+
+    save();
+}
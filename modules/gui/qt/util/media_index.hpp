@@ -0,0 +1,119 @@
+/*****************************************************************************
+ * media_index.hpp : Persistent index of the media library files
+ ****************************************************************************
+ * Copyright (C) 2017 the VideoLAN team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_QT_MEDIA_INDEX_HPP_
+#define VLC_QT_MEDIA_INDEX_HPP_
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "qt.hpp"
+#include "util/singleton.hpp"
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QMetaType>
+#include <QObject>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+
+/* Keeps the metadata of the files found in the library folders, in a file
+   of the user cache directory, so that they are known at once on startup.
+   Folders are scanned on a background thread, and only the files whose
+   modification time or size changed are preparsed again.
+   The entries are only ever modified from the GUI thread: the scans work on
+   a copy, and send their results back. */
+class MediaIndex : public QObject, public Singleton<MediaIndex>
+{
+    Q_OBJECT
+    friend class Singleton<MediaIndex>;
+
+public:
+    struct Entry
+    {
+        Entry() : mtime( 0 ), size( 0 ), duration( -1 ) {}
+
+        QString uri;
+        qint64 mtime;
+        qint64 size;
+        QString title;
+        QString artist;
+        QString album;
+        qint64 duration; /* in microseconds, -1 if unknown */
+        QString artUrl;
+    };
+    /* File state (mtime, size) of each known uri */
+    typedef QHash<QString, QPair<qint64, qint64> > FileStates;
+
+    int count() const { return entries.count(); }
+    /* Returns at most count entries, starting at row offset */
+    QVector<Entry> page( int offset, int count ) const;
+    Entry entry( int row ) const { return entries.value( row ); }
+    int rowOf( const QString &uri ) const { return rows.value( uri, -1 ); }
+
+    QStringList folders() const { return dirs; }
+    /* Adds a folder to the library, and indexes its files.
+       Accepts a local path, or a file:// or directory:// MRL. */
+    void addFolder( const QString & );
+    /* Looks for changes in all the library folders */
+    void rescan();
+
+    bool isStopping() const { return stopping.load() != 0; }
+
+signals:
+    /* Rows first to last were added at the end */
+    void rowsAppended( int first, int last );
+    void rowChanged( int row );
+    /* Rows were removed, or the index was loaded */
+    void reset();
+
+private:
+    MediaIndex( intf_thread_t * );
+    virtual ~MediaIndex();
+
+    void save();
+    void startScan( const QStringList & );
+    FileStates fileStates() const;
+
+    intf_thread_t *p_intf;
+    QString path;
+    /* Scans wait for the index to be loaded first */
+    bool b_loaded;
+
+    QVector<Entry> entries;
+    QHash<QString, int> rows;
+    QStringList dirs;
+
+    QThreadPool pool;
+    QAtomicInt stopping;
+
+private slots:
+    void loaded( const QStringList &, const QVector<MediaIndex::Entry> & );
+    void scanned( const QVector<MediaIndex::Entry> & );
+    void scanDone( const QStringList &folders, const QStringList &found );
+};
+
+Q_DECLARE_METATYPE(MediaIndex::Entry)
+
+#endif
@@ -0,0 +1,95 @@
+/*****************************************************************************
+ * picture_image.cpp : Decoded pictures as QImages
+ ****************************************************************************
+ * Copyright (C) 2017 the VideoLAN team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "util/picture_image.hpp"
+
+#include <vlc_image.h>
+#include <vlc_picture.h>
+
+static void releasePicture( void *data )
+{
+    picture_Release( static_cast<picture_t *>( data ) );
+}
+
+PictureImageConverter::PictureImageConverter( vlc_object_t *_p_obj )
+    : p_obj( _p_obj ), p_image( NULL )
+{
+}
+
+PictureImageConverter::~PictureImageConverter()
+{
+    if( p_image )
+        image_HandlerDelete( p_image );
+}
+
+QImage PictureImageConverter::convert( picture_t *p_pic,
+                                       const video_format_t *p_fmt,
+                                       const QSize &size )
+{
+    unsigned i_sar_num = p_fmt->i_sar_num, i_sar_den = p_fmt->i_sar_den;
+    if( !i_sar_num || !i_sar_den )
+        i_sar_num = i_sar_den = 1;
+
+    QSize source( (int64_t)p_fmt->i_visible_width * i_sar_num / i_sar_den,
+                  p_fmt->i_visible_height );
+    if( source.isEmpty() )
+        return QImage();
+    QSize target = source.scaled( size, Qt::KeepAspectRatio );
+    if( target.isEmpty() )
+        return QImage();
+
+    picture_t *p_rgba;
+    if( p_fmt->i_chroma == VLC_CODEC_RGBA && i_sar_num == i_sar_den &&
+        p_fmt->i_x_offset == 0 && p_fmt->i_y_offset == 0 &&
+        source == target )
+    {
+        /* Nothing to do, the decoded planes are shown as they are */
+        p_rgba = picture_Hold( p_pic );
+    }
+    else
+    {
+        if( !p_image )
+        {
+            /* The converter is kept as long as the formats do not change */
+            p_image = image_HandlerCreate( p_obj );
+            if( !p_image )
+                return QImage();
+        }
+
+        video_format_t fmt_out;
+        video_format_Init( &fmt_out, VLC_CODEC_RGBA );
+        fmt_out.i_width = fmt_out.i_visible_width = target.width();
+        fmt_out.i_height = fmt_out.i_visible_height = target.height();
+        fmt_out.i_sar_num = fmt_out.i_sar_den = 1;
+
+        p_rgba = image_Convert( p_image, p_pic, p_fmt, &fmt_out );
+        if( !p_rgba )
+            return QImage();
+    }
+
+    const plane_t *p_plane = &p_rgba->p[0];
+    return QImage( p_plane->p_pixels, target.width(), target.height(),
+                   p_plane->i_pitch, QImage::Format_RGBA8888,
+                   releasePicture, p_rgba );
+}
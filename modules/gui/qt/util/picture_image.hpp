@@ -0,0 +1,58 @@
+/*****************************************************************************
+ * picture_image.hpp : Decoded pictures as QImages
+ ****************************************************************************
+ * Copyright (C) 2017 the VideoLAN team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_QT_PICTURE_IMAGE_HPP_
+#define VLC_QT_PICTURE_IMAGE_HPP_
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_es.h>
+
+#include <QImage>
+#include <QSize>
+
+/* Gives decoded pictures to the GUI without copying them around.
+   A picture is converted and scaled in a single pass to RGBA, unless it is
+   already so, and the QImage then uses the planes of the converted picture
+   directly: the picture is released with the last copy of the image.
+   Not thread-safe: use one converter per thread. */
+class PictureImageConverter
+{
+public:
+    PictureImageConverter( vlc_object_t * );
+    ~PictureImageConverter();
+
+    /* Fits the picture in the given size, keeping its aspect ratio.
+       Returns a null image if the picture cannot be converted. */
+    QImage convert( picture_t *, const video_format_t *, const QSize & );
+
+private:
+    /* Not implemented */
+    PictureImageConverter( const PictureImageConverter & );
+    PictureImageConverter &operator=( const PictureImageConverter & );
+
+    vlc_object_t *p_obj;
+    image_handler_t *p_image;
+};
+
+#endif
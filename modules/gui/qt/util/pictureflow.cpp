@@ -40,6 +40,7 @@
 #include <QVector>
 #include <QWidget>
 #include <QHash>
+#include <QScopedPointer>
 #include "../components/playlist/playlist_model.hpp" /* getArtPixmap etc */
 #include "../components/playlist/sorting.h"          /* Columns List */
 #include "input_manager.hpp"
@@ -467,13 +468,14 @@ static QImage* prepareSurface(const QImage* slideImage, int w, int h, QRgb bgcol
     return result;
 }
 
-QImage* PictureFlowSoftwareRenderer::surface(QModelIndex index)
+QImage* PictureFlowSoftwareRenderer::surface(QModelIndex index, bool *pending)
 {
+    *pending = false;
     if (!state || !index.isValid())
         return 0;
 
     QImage* img = new QImage(VLCModel::getArtPixmap( index,
-                                         QSize( state->slideWidth, state->slideHeight ) ).toImage());
+                                         QSize( state->slideWidth, state->slideHeight ), pending ).toImage());
 
     QImage* sr = prepareSurface(img, state->slideWidth, state->slideHeight, bgcolor, state->reflectionEffect, index );
 
@@ -506,13 +508,17 @@ QRect PictureFlowSoftwareRenderer::renderSlide(const SlideInfo &slide, int col1,
     QString key = QString("%1%2%3%4").arg(VLCModel::getMeta( index, COLUMN_TITLE )).arg( VLCModel::getMeta( index, COLUMN_ARTIST ) ).arg(index.data( VLCModel::CURRENT_ITEM_ROLE ).toBool() ).arg( artURL );
 
     QImage* src;
+    bool pending = false;
     if( cache.contains( key ) )
        src = cache.value( key );
     else
     {
-       src = surface( index );
-       cache.insert( key, src );
+       src = surface( index, &pending );
+       /* Rendered again once the art is loaded */
+       if( !pending )
+           cache.insert( key, src );
     }
+    QScopedPointer<QImage> placeholder( pending ? src : NULL );
     if (!src)
         return QRect();
 
@@ -327,7 +327,7 @@ private:
     void render();
     void renderSlides();
     QRect renderSlide(const SlideInfo &slide, int col1 = -1, int col2 = -1);
-    QImage* surface(QModelIndex);
+    QImage* surface(QModelIndex, bool *pending);
     QHash<QString, QImage*> cache;
 };
 
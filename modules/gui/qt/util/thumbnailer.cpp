@@ -0,0 +1,487 @@
+/*****************************************************************************
+ * thumbnailer.cpp : Seek previews of the current input
+ ****************************************************************************
+ * Copyright (C) 2017 the VideoLAN team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "util/thumbnailer.hpp"
+#include "util/picture_image.hpp"
+#include "input_manager.hpp"
+
+#include <vlc_codec.h>
+#include <vlc_demux.h>
+#include <vlc_es_out.h>
+#include <vlc_modules.h>
+#include <vlc_picture.h>
+#include <vlc_stream.h>
+
+#include <QMetaObject>
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+
+/* Number of previews over the whole duration */
+#define THUMBNAILER_BUCKETS    200
+/* Size the previews fit in */
+#define THUMBNAILER_WIDTH      160
+#define THUMBNAILER_HEIGHT     90
+/* Memory kept for the previews, in KiB */
+#define THUMBNAILER_CACHE_SIZE (8 * 1024)
+/* Give up looking for a key frame after so many demux calls */
+#define THUMBNAILER_MAX_DEMUX  1000
+
+class ThumbnailerThread : public QThread
+{
+public:
+    ThumbnailerThread( QObject *, intf_thread_t * );
+    virtual ~ThumbnailerThread();
+
+    /* Replaces the request being decoded, if any */
+    void request( const QString &uri, int bucket );
+    void stop();
+
+protected:
+    void run() Q_DECL_OVERRIDE;
+
+private:
+    bool open( const QString & );
+    void close();
+    QImage decode( int bucket );
+    bool isCancelled();
+    bool isStopping();
+
+    /* es_out_t callbacks */
+    static es_out_id_t *esOutAdd( es_out_t *, const es_format_t * );
+    static int esOutSend( es_out_t *, es_out_id_t *, block_t * );
+    static void esOutDel( es_out_t *, es_out_id_t * );
+    static int esOutControl( es_out_t *, int, va_list );
+    static void esOutDestroy( es_out_t * );
+
+    /* decoder_t callbacks */
+    static int decoderFormatUpdate( decoder_t * );
+    static picture_t *decoderBufferNew( decoder_t * );
+    static int decoderQueueVideo( decoder_t *, picture_t * );
+
+    QObject *owner;
+    intf_thread_t *p_intf;
+
+    /* Requests, from the GUI thread */
+    QMutex lock;
+    QWaitCondition wait;
+    QString pendingUri;
+    int pendingBucket;
+    bool b_stop;
+
+    /* Pipeline, only used from this thread */
+    QString currentUri;
+    bool b_failed;
+    es_out_t out;
+    demux_t *p_demux;
+    decoder_t *p_dec;
+    picture_t *p_picture;
+    PictureImageConverter *converter;
+};
+
+ThumbnailerThread::ThumbnailerThread( QObject *_owner, intf_thread_t *_p_intf )
+    : owner( _owner ), p_intf( _p_intf ), pendingBucket( -1 ), b_stop( false ),
+      b_failed( false ), p_demux( NULL ), p_dec( NULL ), p_picture( NULL )
+{
+    out.pf_add = esOutAdd;
+    out.pf_send = esOutSend;
+    out.pf_del = esOutDel;
+    out.pf_control = esOutControl;
+    out.pf_destroy = esOutDestroy;
+    out.p_sys = reinterpret_cast<es_out_sys_t *>( this );
+
+    converter = new PictureImageConverter( VLC_OBJECT( p_intf ) );
+}
+
+ThumbnailerThread::~ThumbnailerThread()
+{
+    delete converter;
+}
+
+void ThumbnailerThread::request( const QString &uri, int bucket )
+{
+    QMutexLocker locker( &lock );
+    pendingUri = uri;
+    pendingBucket = bucket;
+    wait.wakeAll();
+}
+
+void ThumbnailerThread::stop()
+{
+    QMutexLocker locker( &lock );
+    b_stop = true;
+    wait.wakeAll();
+}
+
+bool ThumbnailerThread::isCancelled()
+{
+    /* A newer request makes the current one useless */
+    QMutexLocker locker( &lock );
+    return b_stop || pendingBucket >= 0;
+}
+
+bool ThumbnailerThread::isStopping()
+{
+    QMutexLocker locker( &lock );
+    return b_stop;
+}
+
+void ThumbnailerThread::run()
+{
+    for( ;; )
+    {
+        QString uri;
+        int bucket;
+        {
+            QMutexLocker locker( &lock );
+            while( !b_stop && pendingBucket < 0 )
+                wait.wait( &lock );
+            if( b_stop )
+                break;
+            uri = pendingUri;
+            bucket = pendingBucket;
+            pendingBucket = -1;
+        }
+
+        if( uri != currentUri )
+        {
+            close();
+            currentUri = uri;
+            b_failed = !open( uri );
+        }
+
+        QImage image;
+        if( !b_failed )
+            image = decode( bucket );
+        /* Cancelled previews are not failures: only send the decoded ones */
+        if( !isStopping() && ( !image.isNull() || !isCancelled() ) )
+            QMetaObject::invokeMethod( owner, "decoded", Qt::QueuedConnection,
+                                       Q_ARG( QString, uri ),
+                                       Q_ARG( int, bucket ),
+                                       Q_ARG( QImage, image ) );
+    }
+    close();
+}
+
+bool ThumbnailerThread::open( const QString &uri )
+{
+    stream_t *p_stream = vlc_stream_NewURL( p_intf, qtu( uri ) );
+    if( !p_stream )
+        return false;
+
+    int i_sep = uri.indexOf( "://" );
+    QString location = i_sep >= 0 ? uri.mid( i_sep + 3 ) : uri;
+    p_demux = demux_New( VLC_OBJECT( p_intf ), "any", qtu( location ),
+                         p_stream, &out );
+    if( !p_demux )
+    {
+        vlc_stream_Delete( p_stream );
+        return false;
+    }
+
+    bool b_seekable;
+    if( demux_Control( p_demux, DEMUX_CAN_SEEK, &b_seekable ) || !b_seekable )
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void ThumbnailerThread::close()
+{
+    /* The ES are deleted with the demux */
+    if( p_demux )
+        demux_Delete( p_demux );
+    p_demux = NULL;
+    if( p_dec )
+        esOutDel( &out, reinterpret_cast<es_out_id_t *>( p_dec ) );
+    if( p_picture )
+        picture_Release( p_picture );
+    p_picture = NULL;
+}
+
+QImage ThumbnailerThread::decode( int bucket )
+{
+    /* Aim at the middle of the bucket */
+    double f_pos = ( bucket + .5 ) / THUMBNAILER_BUCKETS;
+    int64_t i_length;
+
+    /* Imprecise seeks stop at the key frame before */
+    if( demux_Control( p_demux, DEMUX_GET_LENGTH, &i_length ) || i_length <= 0
+     || demux_Control( p_demux, DEMUX_SET_TIME, (int64_t)( f_pos * i_length ),
+                       false ) )
+    {
+        if( demux_Control( p_demux, DEMUX_SET_POSITION, f_pos, false ) )
+            return QImage();
+    }
+
+    if( p_dec && p_dec->pf_flush )
+        p_dec->pf_flush( p_dec );
+    if( p_picture )
+    {
+        /* Left from a cancelled request */
+        picture_Release( p_picture );
+        p_picture = NULL;
+    }
+
+    for( int i = 0; i < THUMBNAILER_MAX_DEMUX && !p_picture; i++ )
+    {
+        if( demux_Demux( p_demux ) != VLC_DEMUXER_SUCCESS || isCancelled() )
+            break;
+    }
+    if( !p_dec && !p_picture )
+    {
+        /* No video in there: don't try again */
+        b_failed = true;
+        return QImage();
+    }
+    if( !p_picture )
+        return QImage();
+
+    QImage image = converter->convert( p_picture, &p_dec->fmt_out.video,
+                                       QSize( THUMBNAILER_WIDTH,
+                                              THUMBNAILER_HEIGHT ) );
+    picture_Release( p_picture );
+    p_picture = NULL;
+    return image;
+}
+
+es_out_id_t *ThumbnailerThread::esOutAdd( es_out_t *out, const es_format_t *fmt )
+{
+    ThumbnailerThread *thread = reinterpret_cast<ThumbnailerThread *>( out->p_sys );
+
+    /* Other ES are only ignored, but demuxers want an identifier anyway */
+    if( fmt->i_cat != VIDEO_ES || thread->p_dec )
+        return reinterpret_cast<es_out_id_t *>( thread );
+
+    decoder_t *p_dec = (decoder_t *)vlc_object_create( thread->p_intf,
+                                                       sizeof( *p_dec ) );
+    if( !p_dec )
+        return reinterpret_cast<es_out_id_t *>( thread );
+
+    es_format_Copy( &p_dec->fmt_in, fmt );
+    es_format_Init( &p_dec->fmt_out, VIDEO_ES, 0 );
+    p_dec->b_frame_drop_allowed = true;
+    p_dec->pf_vout_format_update = decoderFormatUpdate;
+    p_dec->pf_vout_buffer_new = decoderBufferNew;
+    p_dec->pf_queue_video = decoderQueueVideo;
+    p_dec->p_queue_ctx = thread;
+
+    /* Only decode the key frames, in software, with the least latency */
+    var_Create( p_dec, "avcodec-hw", VLC_VAR_STRING );
+    var_SetString( p_dec, "avcodec-hw", "none" );
+    var_Create( p_dec, "avcodec-skip-frame", VLC_VAR_INTEGER );
+    var_SetInteger( p_dec, "avcodec-skip-frame", 3 ); /* non key frames */
+    var_Create( p_dec, "avcodec-skiploopfilter", VLC_VAR_INTEGER );
+    var_SetInteger( p_dec, "avcodec-skiploopfilter", 4 ); /* all */
+    var_Create( p_dec, "avcodec-threads", VLC_VAR_INTEGER );
+    var_SetInteger( p_dec, "avcodec-threads", 1 );
+
+    p_dec->p_module = module_need( p_dec, "video decoder", "$codec", false );
+    if( !p_dec->p_module )
+    {
+        msg_Dbg( thread->p_intf, "no decoder for the seek previews" );
+        es_format_Clean( &p_dec->fmt_in );
+        es_format_Clean( &p_dec->fmt_out );
+        vlc_object_release( p_dec );
+        return reinterpret_cast<es_out_id_t *>( thread );
+    }
+
+    thread->p_dec = p_dec;
+    return reinterpret_cast<es_out_id_t *>( p_dec );
+}
+
+int ThumbnailerThread::esOutSend( es_out_t *out, es_out_id_t *id,
+                                  block_t *p_block )
+{
+    ThumbnailerThread *thread = reinterpret_cast<ThumbnailerThread *>( out->p_sys );
+    decoder_t *p_dec = thread->p_dec;
+
+    /* Once a picture is out, the rest is not needed */
+    if( p_dec == NULL || reinterpret_cast<decoder_t *>( id ) != p_dec
+     || thread->p_picture )
+    {
+        block_Release( p_block );
+        return VLC_SUCCESS;
+    }
+
+    p_dec->pf_decode( p_dec, p_block );
+    return VLC_SUCCESS;
+}
+
+void ThumbnailerThread::esOutDel( es_out_t *out, es_out_id_t *id )
+{
+    ThumbnailerThread *thread = reinterpret_cast<ThumbnailerThread *>( out->p_sys );
+    decoder_t *p_dec = thread->p_dec;
+
+    if( p_dec == NULL || reinterpret_cast<decoder_t *>( id ) != p_dec )
+        return;
+
+    module_unneed( p_dec, p_dec->p_module );
+    es_format_Clean( &p_dec->fmt_in );
+    es_format_Clean( &p_dec->fmt_out );
+    if( p_dec->p_description )
+        vlc_meta_Delete( p_dec->p_description );
+    vlc_object_release( p_dec );
+    thread->p_dec = NULL;
+}
+
+int ThumbnailerThread::esOutControl( es_out_t *out, int i_query, va_list args )
+{
+    ThumbnailerThread *thread = reinterpret_cast<ThumbnailerThread *>( out->p_sys );
+
+    switch( i_query )
+    {
+        case ES_OUT_GET_ES_STATE:
+        {
+            /* Lets demuxers skip the tracks that are not decoded */
+            es_out_id_t *id = va_arg( args, es_out_id_t * );
+            bool *pb_selected = va_arg( args, bool * );
+            *pb_selected = thread->p_dec &&
+                           reinterpret_cast<decoder_t *>( id ) == thread->p_dec;
+            return VLC_SUCCESS;
+        }
+        case ES_OUT_GET_EMPTY:
+            *va_arg( args, bool * ) = true;
+            return VLC_SUCCESS;
+        case ES_OUT_GET_PCR_SYSTEM:
+        case ES_OUT_MODIFY_PCR_SYSTEM:
+        case ES_OUT_POST_SUBNODE:
+            return VLC_EGENERIC;
+        default:
+            /* Nothing is played: there is no clock, no group, no meta */
+            return VLC_SUCCESS;
+    }
+}
+
+void ThumbnailerThread::esOutDestroy( es_out_t * )
+{
+    /* Embedded in the thread */
+}
+
+int ThumbnailerThread::decoderFormatUpdate( decoder_t *p_dec )
+{
+    p_dec->fmt_out.video.i_chroma = p_dec->fmt_out.i_codec;
+    if( !p_dec->fmt_out.video.i_visible_width ||
+        !p_dec->fmt_out.video.i_visible_height )
+    {
+        p_dec->fmt_out.video.i_visible_width = p_dec->fmt_out.video.i_width;
+        p_dec->fmt_out.video.i_visible_height = p_dec->fmt_out.video.i_height;
+    }
+    return 0;
+}
+
+picture_t *ThumbnailerThread::decoderBufferNew( decoder_t *p_dec )
+{
+    return picture_NewFromFormat( &p_dec->fmt_out.video );
+}
+
+int ThumbnailerThread::decoderQueueVideo( decoder_t *p_dec, picture_t *p_pic )
+{
+    ThumbnailerThread *thread =
+        static_cast<ThumbnailerThread *>( p_dec->p_queue_ctx );
+
+    if( thread->p_picture )
+        picture_Release( p_pic );
+    else
+        thread->p_picture = p_pic;
+    return 0;
+}
+
+SeekThumbnailer::SeekThumbnailer( QObject *parent, intf_thread_t *_p_intf )
+    : QObject( parent ), p_intf( _p_intf ), requested( -1 )
+{
+    cache.setMaxCost( THUMBNAILER_CACHE_SIZE );
+
+    thread = new ThumbnailerThread( this, p_intf );
+    thread->start( QThread::LowPriority );
+
+    CONNECT( THEMIM, inputChanged( bool ), this, inputChanged() );
+    inputChanged();
+}
+
+SeekThumbnailer::~SeekThumbnailer()
+{
+    thread->stop();
+    thread->wait();
+    delete thread;
+}
+
+void SeekThumbnailer::inputChanged()
+{
+    QString newUri;
+    input_item_t *p_item = THEMIM->currentInputItem();
+    if( p_item )
+    {
+        char *psz_uri = input_item_GetURI( p_item );
+        newUri = qfu( psz_uri );
+        free( psz_uri );
+    }
+
+    if( newUri == uri )
+        return;
+
+    uri = newUri;
+    cache.clear();
+    requested = -1;
+    emit previewReady( QImage() );
+}
+
+QImage SeekThumbnailer::get( float pos )
+{
+    if( uri.isEmpty() || pos < 0.f || pos > 1.f )
+        return QImage();
+
+    int bucket = qMin( (int)( pos * THUMBNAILER_BUCKETS ),
+                       THUMBNAILER_BUCKETS - 1 );
+    QImage *image = cache.object( bucket );
+    if( image )
+        return *image;
+
+    if( bucket != requested )
+    {
+        requested = bucket;
+        thread->request( uri, bucket );
+    }
+    return QImage();
+}
+
+void SeekThumbnailer::decoded( const QString &decodedUri, int bucket,
+                               const QImage &image )
+{
+    if( decodedUri != uri )
+        return;
+
+    /* Previews that failed are remembered too, not to try again */
+    int cost = qMax( 1, image.byteCount() / 1024 );
+    cache.insert( bucket, new QImage( image ), cost );
+
+    if( bucket == requested )
+    {
+        requested = -1;
+        if( !image.isNull() )
+            emit previewReady( image );
+    }
+}
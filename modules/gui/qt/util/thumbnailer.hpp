@@ -0,0 +1,71 @@
+/*****************************************************************************
+ * thumbnailer.hpp : Seek previews of the current input
+ ****************************************************************************
+ * Copyright (C) 2017 the VideoLAN team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_QT_THUMBNAILER_HPP_
+#define VLC_QT_THUMBNAILER_HPP_
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "qt.hpp"
+
+#include <QCache>
+#include <QImage>
+#include <QObject>
+#include <QString>
+
+class ThumbnailerThread;
+
+/* Previews the current input at the positions hovered on the seek slider.
+   A second demux and video decoder of the input run on a thread of their
+   own. They only seek to key frames, and skip everything else.
+   Previews are cached by bucket of the duration. */
+class SeekThumbnailer : public QObject
+{
+    Q_OBJECT
+
+public:
+    SeekThumbnailer( QObject *parent, intf_thread_t * );
+    virtual ~SeekThumbnailer();
+
+    /* Returns the preview at pos (0..1) if it is known already, else a null
+       image, and previewReady() is emitted once it is decoded.
+       Only the last position requested is decoded. */
+    QImage get( float pos );
+
+signals:
+    /* A null image means that there is no preview to show any more */
+    void previewReady( const QImage & );
+
+private:
+    intf_thread_t *p_intf;
+    ThumbnailerThread *thread;
+
+    QString uri;
+    QCache<int, QImage> cache;
+    int requested;
+
+private slots:
+    void inputChanged();
+    void decoded( const QString &uri, int bucket, const QImage & );
+};
+
+#endif
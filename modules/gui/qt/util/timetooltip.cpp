@@ -63,6 +63,13 @@ void TimeTooltip::adjustPosition()
     textbox.adjust( -2, -2, 2, 2 );
     textbox.moveTo( 0, 0 );
 
+    // The preview goes on top of the text
+    if( !mPreview.isNull() )
+    {
+        textbox.setWidth( qMax( textbox.width(), mPreview.width() + 2 ) );
+        textbox.setHeight( textbox.height() + mPreview.height() + 1 );
+    }
+
     // Resize the widget to fit our needs
     QSize size( textbox.width() + 1, textbox.height() + TIP_HEIGHT + 1 );
 
@@ -143,6 +150,16 @@ void TimeTooltip::setTip( const QPoint& target, const QString& time, const QStri
     raise();
 }
 
+void TimeTooltip::setPreview( const QImage& preview )
+{
+    if( preview.isNull() && mPreview.isNull() )
+        return;
+
+    mPreview = preview;
+    adjustPosition();
+    update();
+}
+
 void TimeTooltip::show()
 {
     setVisible( true );
@@ -158,7 +175,16 @@ void TimeTooltip::paintEvent( QPaintEvent * )
     p.setBrush( qApp->palette().base() );
     p.drawPath( mPainterPath );
 
+    QRect textBox = mBox;
+    if( !mPreview.isNull() )
+    {
+        QPoint origin( mBox.left() + ( mBox.width() - mPreview.width() ) / 2,
+                       mBox.top() + 1 );
+        p.drawImage( origin, mPreview );
+        textBox.setTop( origin.y() + mPreview.height() );
+    }
+
     p.setFont( mFont );
     p.setPen( QPen( qApp->palette().text(), 1 ) );
-    p.drawText( mBox, Qt::AlignCenter, mDisplayedText );
+    p.drawText( textBox, Qt::AlignCenter, mDisplayedText );
 }
@@ -26,6 +26,7 @@
 
 #include <QWidget>
 #include <QBitmap>
+#include <QImage>
 
 class QPaintEvent;
 class QString;
@@ -39,6 +40,8 @@ class TimeTooltip : public QWidget
 public:
     explicit TimeTooltip( QWidget *parent = 0 );
     void setTip( const QPoint& pos, const QString& time, const QString& text );
+    /* Shown above the time, a null image removes it */
+    void setPreview( const QImage& preview );
     virtual void show();
 
 protected:
@@ -51,6 +54,7 @@ private:
     QString mTime;
     QString mText;
     QString mDisplayedText;
+    QImage mPreview;
     QFont mFont;
     QRect mBox;
     QPainterPath mPainterPath;
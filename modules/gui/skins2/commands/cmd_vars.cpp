@@ -71,6 +71,19 @@ void CmdPlaytreeDelete::execute()
     VlcProc::instance( getIntf() )->getPlaytreeVar().onDelete( m_id );
 }
 
+void CmdPlaytreeChanged::execute()
+{
+    VlcProc::instance( getIntf() )->getPlaytreeVar().onChangeNode( m_id );
+}
+
+bool CmdPlaytreeChanged::checkRemove( CmdGeneric *pQueuedCommand ) const
+{
+    // We don't use RTTI - Use C-style cast
+    CmdPlaytreeChanged *pChangedCommand =
+        (CmdPlaytreeChanged *)(pQueuedCommand);
+    return m_id == -1 || m_id == pChangedCommand->m_id;
+}
+
 void CmdSetText::execute()
 {
     m_rText.set( m_value );
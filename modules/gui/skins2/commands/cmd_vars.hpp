@@ -95,6 +95,25 @@ private:
 };
 
 
+/// Command to notify the playtree of a batch of changes below a node
+class CmdPlaytreeChanged: public CmdGeneric
+{
+public:
+    /// Use -1 as i_id when the whole playlist changed
+    CmdPlaytreeChanged( intf_thread_t *pIntf, int i_id ):
+        CmdGeneric( pIntf ), m_id( i_id ) { }
+    virtual ~CmdPlaytreeChanged() { }
+    virtual void execute();
+    virtual std::string getType() const { return "playtree changed"; }
+
+    /// Only replace the changes of the same node, or all of them
+    virtual bool checkRemove( CmdGeneric * ) const;
+
+private:
+    int m_id;
+};
+
+
 /// Command to set a text variable
 class CmdSetText: public CmdGeneric
 {
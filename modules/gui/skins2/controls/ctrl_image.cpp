@@ -157,10 +157,11 @@ void CtrlImage::draw( OSGraphics &rImage, int xDest, int yDest, int w, int h )
         {
             OSFactory *pOsFactory = OSFactory::instance( getIntf() );
             // Rescale the image with the actual size of the control
-            ScaledBitmap bmp( getIntf(), *m_pBitmap, width, height );
+            ScaledBitmapPtr pBmp = ScaledBitmapCache::instance( getIntf() )
+                                       ->get( *m_pBitmap, width, height );
             delete m_pImage;
             m_pImage = pOsFactory->createOSGraphics( width, height );
-            m_pImage->drawBitmap( bmp, 0, 0 );
+            m_pImage->drawBitmap( *pBmp, 0, 0 );
         }
         rImage.drawGraphics( *m_pImage,
                              inter.x - pPos->getLeft(),
@@ -230,10 +231,11 @@ void CtrlImage::draw( OSGraphics &rImage, int xDest, int yDest, int w, int h )
             h != m_pImage->getHeight() )
         {
             OSFactory *pOsFactory = OSFactory::instance( getIntf() );
-            ScaledBitmap bmp( getIntf(), *m_pBitmap, w, h );
+            ScaledBitmapPtr pBmp = ScaledBitmapCache::instance( getIntf() )
+                                       ->get( *m_pBitmap, w, h );
             delete m_pImage;
             m_pImage = pOsFactory->createOSGraphics( w, h );
-            m_pImage->drawBitmap( bmp, 0, 0 );
+            m_pImage->drawBitmap( *pBmp, 0, 0 );
         }
 
         // draw the scaled image at offset (m_x, m_y) from control origin
@@ -434,8 +434,9 @@ void CtrlList::makeImage()
     {
         // A background bitmap is given, so we scale it, ignoring the
         // background colors
-        ScaledBitmap bmp( getIntf(), *m_pBitmap, width, height );
-        m_pImage->drawBitmap( bmp, 0, 0 );
+        ScaledBitmapPtr pBmp = ScaledBitmapCache::instance( getIntf() )
+                                   ->get( *m_pBitmap, width, height );
+        m_pImage->drawBitmap( *pBmp, 0, 0 );
 
         // Take care of the selection color
         for( int yPos = 0; yPos < height; yPos += itemHeight )
@@ -334,7 +334,7 @@ CtrlSliderBg::CtrlSliderBg( intf_thread_t *pIntf,
     CtrlGeneric( pIntf, rHelp, pVisible ), m_pCursor( NULL ),
     m_rVariable( rVariable ), m_thickness( thickness ), m_rCurve( rCurve ),
     m_width( rCurve.getWidth() ), m_height( rCurve.getHeight() ),
-    m_pImgSeq( pBackground ), m_pScaledBmp( NULL ),
+    m_pImgSeq( pBackground ), m_pScaledBmp(),
     m_nbHoriz( nbHoriz ), m_nbVert( nbVert ),
     m_padHoriz( padHoriz ), m_padVert( padVert ),
     m_bgWidth( 0 ), m_bgHeight( 0 ), m_position( 0 )
@@ -354,8 +354,6 @@ CtrlSliderBg::~CtrlSliderBg()
 {
     if( m_pImgSeq )
         m_rVariable.delObserver( this );
-
-    delete m_pScaledBmp;
 }
 
 
@@ -365,7 +363,7 @@ bool CtrlSliderBg::mouseOver( int x, int y ) const
     float factorX, factorY;
     getResizeFactors( factorX, factorY );
 
-    if( m_pScaledBmp )
+    if( m_pScaledBmp.get() )
     {
         // background size that is displayed
         int width = m_bgWidth - (int)(m_padHoriz * factorX);
@@ -384,7 +382,7 @@ bool CtrlSliderBg::mouseOver( int x, int y ) const
 
 void CtrlSliderBg::draw( OSGraphics &rImage, int xDest, int yDest, int w, int h )
 {
-    if( !m_pScaledBmp || m_bgWidth <= 0 || m_bgHeight <= 0 )
+    if( !m_pScaledBmp.get() || m_bgWidth <= 0 || m_bgHeight <= 0 )
         return;
 
     // Compute the resize factors
@@ -545,12 +543,12 @@ void CtrlSliderBg::setCurrentImage()
     // Rescale the image accordingly
     int width = m_bgWidth * m_nbHoriz - (int)(m_padHoriz * factorX);
     int height = m_bgHeight * m_nbVert - (int)(m_padVert * factorY);
-    if( !m_pScaledBmp ||
+    if( !m_pScaledBmp.get() ||
         m_pScaledBmp->getWidth() != width ||
         m_pScaledBmp->getHeight() != height )
     {
-        // scaled bitmap
-        delete m_pScaledBmp;
-        m_pScaledBmp = new ScaledBitmap( getIntf(), *m_pImgSeq, width, height );
+        // scaled bitmap, shared with the other controls if possible
+        m_pScaledBmp = ScaledBitmapCache::instance( getIntf() )->get(
+                            *m_pImgSeq, width, height );
     }
 }
@@ -181,7 +181,7 @@ private:
     /// Background image sequence (optional)
     GenericBitmap *m_pImgSeq;
     /// Scaled bitmap if needed
-    ScaledBitmap *m_pScaledBmp;
+    CountedPtr<ScaledBitmap> m_pScaledBmp;
     /// Number of images in the background bitmap
     int m_nbHoriz, m_nbVert;
     /// Number of pixels between two images
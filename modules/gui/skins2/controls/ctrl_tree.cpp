@@ -62,7 +62,7 @@ CtrlTree::CtrlTree( intf_thread_t *pIntf,
     CtrlGeneric( pIntf,rHelp, pVisible), m_rTree( rTree), m_rFont( rFont ),
     m_pBgBitmap( pBgBitmap ), m_pItemBitmap( pItemBitmap ),
     m_pOpenBitmap( pOpenBitmap ), m_pClosedBitmap( pClosedBitmap ),
-    m_pScaledBitmap( NULL ), m_pImage( NULL ),
+    m_pScaledBitmap(), m_pImage( NULL ),
     m_fgColor( fgColor ), m_playColor( playColor ),
     m_bgColor1( bgColor1 ), m_bgColor2( bgColor2 ), m_selColor( selColor ),
     m_firstPos( m_rTree.end() ), m_lastClicked( m_rTree.end() ),
@@ -78,7 +78,6 @@ CtrlTree::~CtrlTree()
 {
     m_rTree.delObserver( this );
     delete m_pImage;
-    delete m_pScaledBitmap;
 }
 
 int CtrlTree::itemHeight()
@@ -194,6 +193,7 @@ void CtrlTree::onUpdate( Subject<VarTree, tree_update> &rTree,
     else if( arg->type == arg->ResetAll )
     {
         m_lastClicked = m_rTree.end();
+        m_itOver = m_rTree.end();
         m_firstPos = getFirstFromSlider();
 
         makeImage();
@@ -584,13 +584,12 @@ void CtrlTree::makeImage()
     if( m_pBgBitmap )
     {
         // Draw the background bitmap
-        if( !m_pScaledBitmap ||
+        if( !m_pScaledBitmap.get() ||
             m_pScaledBitmap->getWidth() != width ||
             m_pScaledBitmap->getHeight() != height )
         {
-            delete m_pScaledBitmap;
-            m_pScaledBitmap =
-                new ScaledBitmap( getIntf(), *m_pBgBitmap, width, height );
+            m_pScaledBitmap = ScaledBitmapCache::instance( getIntf() )->get(
+                                  *m_pBgBitmap, width, height );
         }
         m_pImage->drawBitmap( *m_pScaledBitmap, 0, 0 );
 
@@ -628,6 +627,9 @@ void CtrlTree::makeImage()
 
     int bitmapWidth = itemImageWidth();
 
+    // Only the lines displayed now are kept for the next image
+    std::map<int, CachedLine> lines;
+
     it = m_firstPos;
     for( int yPos = 0; yPos < height && it != m_rTree.end(); ++it )
     {
@@ -637,11 +639,11 @@ void CtrlTree::makeImage()
         {
             uint32_t color = it->isPlaying() ? m_playColor : m_fgColor;
             int depth = m_flat ? 1 : it->depth();
-            GenericBitmap *pText =
-                m_rFont.drawString( *pStr, color, width-bitmapWidth*depth );
+            const GenericBitmap *pText =
+                getLine( lines, *it, color, width-bitmapWidth*depth );
             if( !pText )
             {
-                return;
+                break;
             }
             if( it->size() )
                 m_pCurBitmap =
@@ -654,10 +656,7 @@ void CtrlTree::makeImage()
                 // Make sure we are centered on the line
                 int yPos2 = yPos+(i_itemHeight-m_pCurBitmap->getHeight()+1)/2;
                 if( yPos2 >= height )
-                {
-                    delete pText;
                     break;
-                }
                 // Draw the icon in front of the text
                 m_pImage->drawBitmap( *m_pCurBitmap, 0, 0,
                                       bitmapWidth * (depth - 1 ), yPos2,
@@ -667,10 +666,7 @@ void CtrlTree::makeImage()
             }
             yPos += (i_itemHeight - pText->getHeight());
             if( yPos >= height )
-            {
-                delete pText;
                 break;
-            }
 
             int ySrc = 0;
             if( yPos < 0 )
@@ -693,11 +689,39 @@ void CtrlTree::makeImage()
                     bitmapWidth + pText->getWidth(), __MAX( lineHeight/5, 3 ),
                     m_selColor );
             }
-            delete pText;
         }
     }
+    m_lines.swap( lines );
+}
+
+const GenericBitmap *CtrlTree::getLine( std::map<int, CachedLine> &rLines,
+                                        VarTree &rItem, uint32_t color,
+                                        int maxWidth )
+{
+    const UString *pStr = rItem.getString();
+
+    std::map<int, CachedLine>::const_iterator it =
+        m_lines.find( rItem.getId() );
+    if( it != m_lines.end() && it->second.m_color == color &&
+        it->second.m_maxWidth == maxWidth && *it->second.m_pText == *pStr )
+    {
+        rLines[rItem.getId()] = it->second;
+        return it->second.m_pBitmap.get();
+    }
+
+    GenericBitmap *pText = m_rFont.drawString( *pStr, color, maxWidth );
+    if( !pText )
+        return NULL;
+
+    CachedLine &rLine = rLines[rItem.getId()];
+    rLine.m_pText = UStringPtr( new UString( *pStr ) );
+    rLine.m_color = color;
+    rLine.m_maxWidth = maxWidth;
+    rLine.m_pBitmap = CountedPtr<GenericBitmap>( pText );
+    return pText;
 }
 
+
 CtrlTree::Iterator CtrlTree::findItemAtPos( int pos )
 {
     // The first item is m_firstPos.
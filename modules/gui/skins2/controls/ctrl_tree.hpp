@@ -29,9 +29,12 @@
 #include "../utils/observer.hpp"
 #include "../utils/var_tree.hpp"
 
+#include <map>
+
 class OSGraphics;
 class GenericFont;
 class GenericBitmap;
+class ScaledBitmap;
 
 /// Class for control tree
 class CtrlTree: public CtrlGeneric, public Observer<VarTree, tree_update>
@@ -98,7 +101,7 @@ private:
     /// Closed node bitmap
     const GenericBitmap *m_pClosedBitmap;
     /// scaled bitmap
-    GenericBitmap *m_pScaledBitmap;
+    CountedPtr<ScaledBitmap> m_pScaledBitmap;
     /// Image of the control
     OSGraphics *m_pImage;
 
@@ -125,6 +128,23 @@ private:
     /// flag for item deletion
     bool m_bRefreshOnDelete;
 
+    /// Rendered text of a line
+    struct CachedLine
+    {
+        UStringPtr m_pText;
+        uint32_t m_color;
+        int m_maxWidth;
+        CountedPtr<GenericBitmap> m_pBitmap;
+    };
+    /// Lines drawn by the last makeImage(), by item id
+    std::map<int, CachedLine> m_lines;
+
+    /// Get the rendered text of an item, and keep it in rLines.
+    /// The rendering of the previous image is reused if it still matches
+    const GenericBitmap *getLine( std::map<int, CachedLine> &rLines,
+                                  VarTree &rItem, uint32_t color,
+                                  int maxWidth );
+
     /// Method called when the tree variable is modified
     virtual void onUpdate( Subject<VarTree, tree_update> &rTree,
                            tree_update *);
@@ -27,6 +27,8 @@
 #include "os_graphics.hpp"
 #include "os_timer.hpp"
 
+#include <algorithm>
+
 
 AnimBitmap::AnimBitmap( intf_thread_t *pIntf, const GenericBitmap &rBitmap ):
     SkinObject( pIntf ),
@@ -50,8 +52,10 @@ AnimBitmap::~AnimBitmap()
 
 void AnimBitmap::startAnim()
 {
+    // No need to change frames faster than the display can show them
     if( m_nbFrames > 1 && m_frameRate > 0 )
-        m_pTimer->start( 1000 / m_frameRate, false );
+        m_pTimer->start( std::max( 1000 / m_frameRate, OSTIMER_FRAME_DELAY ),
+                         false );
 }
 
 
@@ -26,6 +26,7 @@
 #endif
 
 #include "art_manager.hpp"
+#include "scaled_bitmap.hpp"
 #include <vlc_image.h>
 
 #include <new>
@@ -69,10 +70,15 @@ ArtManager::~ArtManager( )
         m_pImageHandler = NULL;
     }
 
+    ScaledBitmapCache *pCache = ScaledBitmapCache::instance( getIntf() );
     std::list<ArtBitmap*>::const_iterator it;
     for( it = m_listBitmap.begin(); it != m_listBitmap.end(); ++it )
+    {
+        pCache->forget( **it );
         delete *it;
+    }
     m_listBitmap.clear();
+    m_mapBitmap.clear();
 }
 
 
@@ -85,12 +91,10 @@ ArtBitmap* ArtManager::getArtBitmap( std::string uriName )
         return NULL;
 
     // check whether art is already loaded
-    std::list<ArtBitmap*>::const_iterator it;
-    for( it = m_listBitmap.begin(); it != m_listBitmap.end(); ++it )
-    {
-        if( (*it)->getUriName() == uriName )
-            return *it;
-    }
+    std::map<std::string, ArtBitmap*>::const_iterator it =
+        m_mapBitmap.find( uriName );
+    if( it != m_mapBitmap.end() )
+        return it->second;
 
     // create and retain a new ArtBitmap since uri is not yet known
     ArtBitmap* pArt = new (std::nothrow) ArtBitmap( getIntf(), m_pImageHandler, uriName );
@@ -99,10 +103,13 @@ ArtBitmap* ArtManager::getArtBitmap( std::string uriName )
         if( m_listBitmap.size() == MAX_ART_CACHED )
         {
             ArtBitmap* pOldest = *(m_listBitmap.begin());
+            m_mapBitmap.erase( pOldest->getUriName() );
+            ScaledBitmapCache::instance( getIntf() )->forget( *pOldest );
             delete pOldest;
             m_listBitmap.pop_front();
         }
         m_listBitmap.push_back( pArt );
+        m_mapBitmap[uriName] = pArt;
         return pArt;
     }
     else
@@ -27,6 +27,7 @@
 #include "file_bitmap.hpp"
 #include <string>
 #include <list>
+#include <map>
 
 
 /// Class for art bitmaps
@@ -72,8 +73,10 @@ private:
     /// Image handler (used to load art files)
     image_handler_t *m_pImageHandler;
 
-    // keep a cache of art already open
+    // keep a cache of art already open, oldest first
     std::list<ArtBitmap*> m_listBitmap;
+    /// Index of the cached art by uri name
+    std::map<std::string, ArtBitmap*> m_mapBitmap;
 };
 
 #endif
@@ -26,6 +26,7 @@
 #include "top_window.hpp"
 #include "os_factory.hpp"
 #include "os_graphics.hpp"
+#include "os_timer.hpp"
 #include "var_manager.hpp"
 #include "anchor.hpp"
 #include "../controls/ctrl_generic.hpp"
@@ -33,6 +34,9 @@
 #include "../utils/var_bool.hpp"
 #include <set>
 
+/// Past this number of damaged areas, repaint their bounding box instead
+#define MAX_DIRTY_RECTS 8
+
 
 GenericLayout::GenericLayout( intf_thread_t *pIntf, int width, int height,
                               int minWidth, int maxWidth, int minHeight,
@@ -42,12 +46,15 @@ GenericLayout::GenericLayout( intf_thread_t *pIntf, int width, int height,
     m_rect( 0, 0, width, height ),
     m_minWidth( minWidth ), m_maxWidth( maxWidth ),
     m_minHeight( minHeight ), m_maxHeight( maxHeight ), m_pVideoCtrlSet(),
-    m_visible( false ), m_pVarActive( NULL )
+    m_visible( false ), m_pVarActive( NULL ), m_pRefreshTimer( NULL ),
+    m_cmdRefresh( this )
 {
     // Get the OSFactory
     OSFactory *pOsFactory = OSFactory::instance( getIntf() );
     // Create the graphics buffer
     m_pImage = pOsFactory->createOSGraphics( width, height );
+    // Create the timer for the deferred repaints
+    m_pRefreshTimer = pOsFactory->createOSTimer( m_cmdRefresh );
 
     // Create the "active layout" variable and register it in the manager
     m_pVarActive = new VarBoolImpl( pIntf );
@@ -57,6 +64,7 @@ GenericLayout::GenericLayout( intf_thread_t *pIntf, int width, int height,
 
 GenericLayout::~GenericLayout()
 {
+    delete m_pRefreshTimer;
     delete m_pImage;
 
     std::list<Anchor*>::const_iterator it;
@@ -166,12 +174,51 @@ void GenericLayout::onControlUpdate( const CtrlGeneric &rCtrl,
         rect inter;
         if( rect::intersect( layout, region, &inter ) )
         {
-            refreshRect( inter.x, inter.y, inter.width, inter.height );
+            // Animated controls may damage the layout much more often
+            // than the screen is refreshed, so repaint once per frame
+            if( m_dirtyRects.empty() )
+                m_pRefreshTimer->start( OSTIMER_FRAME_DELAY, true );
+            addDirtyRect( inter );
         }
     }
 }
 
 
+void GenericLayout::addDirtyRect( const rect &rRect )
+{
+    rect damage = rRect;
+
+    std::list<rect>::iterator it = m_dirtyRects.begin();
+    while( it != m_dirtyRects.end() )
+    {
+        // Merge two areas when their bounding box is not larger than both
+        // of them, i.e. when they overlap or are close enough
+        rect joined;
+        rect::join( *it, damage, &joined );
+        if( joined.width * joined.height <=
+            it->width * it->height + damage.width * damage.height )
+        {
+            damage = joined;
+            m_dirtyRects.erase( it );
+            // The larger area may now overlap others
+            it = m_dirtyRects.begin();
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    if( m_dirtyRects.size() >= MAX_DIRTY_RECTS )
+    {
+        for( it = m_dirtyRects.begin(); it != m_dirtyRects.end(); ++it )
+            rect::join( *it, damage, &damage );
+        m_dirtyRects.clear();
+    }
+    m_dirtyRects.push_back( damage );
+}
+
+
 void GenericLayout::resize( int width, int height )
 {
     // check real resize
@@ -210,6 +257,34 @@ void GenericLayout::refreshRect( int x, int y, int width, int height )
     if( !m_visible )
         return;
 
+    drawRect( x, y, width, height );
+
+    // The pending areas covered by this one are up to date now
+    rect area( x, y, width, height );
+    std::list<rect>::iterator it = m_dirtyRects.begin();
+    while( it != m_dirtyRects.end() )
+    {
+        if( rect::isIncluded( *it, area ) )
+            it = m_dirtyRects.erase( it );
+        else
+            ++it;
+    }
+    if( m_dirtyRects.empty() )
+        m_pRefreshTimer->stop();
+
+    // Refresh the associated window
+    TopWindow *pWindow = getWindow();
+    if( pWindow )
+    {
+        // first apply new shape to the window
+        pWindow->updateShape();
+        pWindow->invalidateRect( x, y, width, height );
+    }
+}
+
+
+void GenericLayout::drawRect( int x, int y, int width, int height )
+{
     // update the transparency global mask
     m_pImage->clear( x, y, width, height );
 
@@ -223,14 +298,40 @@ void GenericLayout::refreshRect( int x, int y, int width, int height )
             pCtrl->draw( *m_pImage, x, y, width, height );
         }
     }
+}
 
-    // Refresh the associated window
-    TopWindow *pWindow = getWindow();
-    if( pWindow )
+
+void GenericLayout::CmdRefresh::execute()
+{
+    std::list<rect> dirtyRects;
+    dirtyRects.swap( m_pParent->m_dirtyRects );
+
+    if( !m_pParent->m_visible )
+        return;
+
+    // The layout may have been resized in the meantime
+    rect layout( 0, 0, m_pParent->getWidth(), m_pParent->getHeight() );
+    std::list<rect>::iterator it = dirtyRects.begin();
+    while( it != dirtyRects.end() )
+    {
+        if( rect::intersect( layout, *it, &*it ) )
+        {
+            m_pParent->drawRect( it->x, it->y, it->width, it->height );
+            ++it;
+        }
+        else
+        {
+            it = dirtyRects.erase( it );
+        }
+    }
+
+    // Apply the new shape only once for all the areas
+    TopWindow *pWindow = m_pParent->getWindow();
+    if( pWindow && !dirtyRects.empty() )
     {
-        // first apply new shape to the window
         pWindow->updateShape();
-        pWindow->invalidateRect( x, y, width, height );
+        for( it = dirtyRects.begin(); it != dirtyRects.end(); ++it )
+            pWindow->invalidateRect( it->x, it->y, it->width, it->height );
     }
 }
 
@@ -258,6 +359,9 @@ void GenericLayout::onShow()
 void GenericLayout::onHide()
 {
     m_visible = false;
+
+    m_pRefreshTimer->stop();
+    m_dirtyRects.clear();
 }
 
 
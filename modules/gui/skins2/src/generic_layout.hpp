@@ -29,11 +29,13 @@
 #include "top_window.hpp"
 #include "../utils/pointer.hpp"
 #include "../utils/position.hpp"
+#include "../commands/cmd_generic.hpp"
 
 #include <list>
 
 class Anchor;
 class OSGraphics;
+class OSTimer;
 class CtrlGeneric;
 class CtrlVideo;
 class VarBoolImpl;
@@ -177,6 +179,19 @@ private:
      * layout). This way, we avoid using a setActiveLayoutInner method.
      */
     mutable VarBoolImpl *m_pVarActive;
+    /// Areas damaged by the controls, not repainted yet
+    std::list<rect> m_dirtyRects;
+    /// Timer to repaint the damaged areas, once per frame at most
+    OSTimer *m_pRefreshTimer;
+
+    /// Add an area to repaint, merging it with the overlapping ones
+    void addDirtyRect( const rect &rRect );
+
+    /// Draw the controls in a part of the layout image
+    void drawRect( int x, int y, int width, int height );
+
+    /// Callback to repaint the damaged areas
+    DEFINE_CALLBACK( GenericLayout, Refresh )
 };
 
 
@@ -27,6 +27,9 @@
 
 #include "skin_common.hpp"
 
+/// Shortest delay worth using for a timer that triggers repaints (in ms),
+/// that is about one display refresh
+#define OSTIMER_FRAME_DELAY 16
 
 // Base class for OS-specific timers
 class OSTimer: public SkinObject
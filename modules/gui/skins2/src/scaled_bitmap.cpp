@@ -24,6 +24,11 @@
 
 #include "scaled_bitmap.hpp"
 
+#include <climits>
+
+/// Memory the cached scaled bitmaps may use, in bytes
+#define MAX_SCALED_CACHE_SIZE (16 * 1024 * 1024)
+
 
 ScaledBitmap::ScaledBitmap( intf_thread_t *pIntf, const GenericBitmap &rBitmap,
                             int width, int height ):
@@ -107,3 +112,91 @@ ScaledBitmap::~ScaledBitmap()
     delete[] m_pData;
 }
 
+
+ScaledBitmapCache *ScaledBitmapCache::instance( intf_thread_t *pIntf )
+{
+    if( pIntf->p_sys->p_scaledBitmapCache == NULL )
+    {
+        pIntf->p_sys->p_scaledBitmapCache = new ScaledBitmapCache( pIntf );
+    }
+
+    return pIntf->p_sys->p_scaledBitmapCache;
+}
+
+
+void ScaledBitmapCache::destroy( intf_thread_t *pIntf )
+{
+    delete pIntf->p_sys->p_scaledBitmapCache;
+    pIntf->p_sys->p_scaledBitmapCache = NULL;
+}
+
+
+ScaledBitmapCache::ScaledBitmapCache( intf_thread_t *pIntf ):
+    SkinObject( pIntf ), m_size( 0 )
+{
+}
+
+
+bool ScaledBitmapCache::Key::operator<( const Key &rOther ) const
+{
+    if( m_pSource != rOther.m_pSource )
+        return m_pSource < rOther.m_pSource;
+    if( m_width != rOther.m_width )
+        return m_width < rOther.m_width;
+    return m_height < rOther.m_height;
+}
+
+
+ScaledBitmapPtr ScaledBitmapCache::get( const GenericBitmap &rBitmap,
+                                        int width, int height )
+{
+    Key key( &rBitmap, width, height );
+
+    std::map<Key, Entry>::iterator it = m_entries.find( key );
+    if( it != m_entries.end() )
+    {
+        // Move the bitmap to the front of the LRU list
+        m_lru.splice( m_lru.begin(), m_lru, it->second.m_lruPos );
+        return it->second.m_pBitmap;
+    }
+
+    ScaledBitmapPtr pBitmap( new ScaledBitmap( getIntf(), rBitmap,
+                                               width, height ) );
+    m_lru.push_front( key );
+    Entry &rEntry = m_entries[key];
+    rEntry.m_pBitmap = pBitmap;
+    rEntry.m_lruPos = m_lru.begin();
+    m_size += (size_t)width * height * 4;
+
+    // Evict the least recently used bitmaps, but keep the new one.
+    // The controls still using them keep their own reference.
+    while( m_size > MAX_SCALED_CACHE_SIZE && m_lru.size() > 1 )
+        erase( m_entries.find( m_lru.back() ) );
+
+    return pBitmap;
+}
+
+
+void ScaledBitmapCache::forget( const GenericBitmap &rBitmap )
+{
+    std::map<Key, Entry>::iterator it =
+        m_entries.lower_bound( Key( &rBitmap, INT_MIN, INT_MIN ) );
+    while( it != m_entries.end() && it->first.m_pSource == &rBitmap )
+        erase( it++ );
+}
+
+
+void ScaledBitmapCache::clear()
+{
+    m_entries.clear();
+    m_lru.clear();
+    m_size = 0;
+}
+
+
+void ScaledBitmapCache::erase( std::map<Key, Entry>::iterator it )
+{
+    m_size -= (size_t)it->first.m_width * it->first.m_height * 4;
+    m_lru.erase( it->second.m_lruPos );
+    m_entries.erase( it );
+}
@@ -26,6 +26,8 @@
 #define SCALED_BITMAP_HPP
 
 #include "generic_bitmap.hpp"
+#include <list>
+#include <map>
 
 
 /// Class for scaling bitmaps
@@ -56,4 +58,60 @@ private:
 };
 
 
+typedef CountedPtr<ScaledBitmap> ScaledBitmapPtr;
+
+
+/// Singleton object caching the scaled bitmaps, shared by all the controls
+class ScaledBitmapCache: public SkinObject
+{
+public:
+    /// Get the instance of ScaledBitmapCache
+    static ScaledBitmapCache *instance( intf_thread_t *pIntf );
+
+    /// Delete the instance of ScaledBitmapCache
+    static void destroy( intf_thread_t *pIntf );
+
+    /// Get the given bitmap scaled to the given size
+    ScaledBitmapPtr get( const GenericBitmap &rBitmap, int width, int height );
+
+    /// Drop the scaled copies of a bitmap, which is about to be deleted
+    void forget( const GenericBitmap &rBitmap );
+
+    /// Drop all the scaled copies
+    void clear();
+
+protected:
+    // Protected because it is a singleton
+    ScaledBitmapCache( intf_thread_t *pIntf );
+    virtual ~ScaledBitmapCache() { }
+
+private:
+    /// Source bitmap and size of a scaled copy
+    struct Key
+    {
+        Key( const GenericBitmap *pSource, int width, int height ):
+            m_pSource( pSource ), m_width( width ), m_height( height ) { }
+        bool operator<( const Key &rOther ) const;
+
+        const GenericBitmap *m_pSource;
+        int m_width, m_height;
+    };
+
+    /// Scaled copy and its place in the LRU list
+    struct Entry
+    {
+        ScaledBitmapPtr m_pBitmap;
+        std::list<Key>::iterator m_lruPos;
+    };
+
+    std::map<Key, Entry> m_entries;
+    /// Keys by order of use, most recent first
+    std::list<Key> m_lru;
+    /// Memory used by the cached bitmaps, in bytes
+    size_t m_size;
+
+    void erase( std::map<Key, Entry>::iterator it );
+};
+
+
 #endif
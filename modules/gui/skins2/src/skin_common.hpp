@@ -46,6 +46,7 @@ class VarManager;
 class VlcProc;
 class VoutManager;
 class ArtManager;
+class ScaledBitmapCache;
 class Theme;
 class ThemeRepository;
 
@@ -115,6 +116,8 @@ struct intf_sys_t
     VoutManager *p_voutManager;
     /// Art manager
     ArtManager *p_artManager;
+    /// Cache of scaled bitmaps
+    ScaledBitmapCache *p_scaledBitmapCache;
     /// Theme repository
     ThemeRepository *p_repository;
 
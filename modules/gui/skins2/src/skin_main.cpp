@@ -46,6 +46,7 @@
 #include "vout_window.hpp"
 #include "vout_manager.hpp"
 #include "art_manager.hpp"
+#include "scaled_bitmap.hpp"
 #include "../parser/interpreter.hpp"
 #include "../commands/async_queue.hpp"
 #include "../commands/cmd_quit.hpp"
@@ -95,6 +96,7 @@ static int Open( vlc_object_t *p_this )
     p_intf->p_sys->p_voutManager = NULL;
     p_intf->p_sys->p_vlcProc = NULL;
     p_intf->p_sys->p_repository = NULL;
+    p_intf->p_sys->p_scaledBitmapCache = NULL;
 
     // No theme yet
     p_intf->p_sys->p_theme = NULL;
@@ -299,6 +301,7 @@ end:
     Dialogs::destroy( p_intf );
     ThemeRepository::destroy( p_intf );
     ArtManager::destroy( p_intf );
+    ScaledBitmapCache::destroy( p_intf );
     VoutManager::destroy( p_intf );
     VlcProc::destroy( p_intf );
     VarManager::destroy( p_intf );
@@ -24,6 +24,7 @@
 
 #include "theme.hpp"
 #include "top_window.hpp"
+#include "scaled_bitmap.hpp"
 #include <sstream>
 
 
@@ -33,6 +34,12 @@ Theme::~Theme()
     m_layouts.clear();
     m_controls.clear();
     m_windows.clear();
+
+    // The scaled copies must not outlive their source
+    ScaledBitmapCache *pCache = ScaledBitmapCache::instance( getIntf() );
+    IDmap<GenericBitmapPtr>::const_iterator it;
+    for( it = m_bitmaps.begin(); it != m_bitmaps.end(); ++it )
+        pCache->forget( *it->second );
     m_bitmaps.clear();
     m_fonts.clear();
     m_commands.clear();
@@ -169,6 +169,8 @@ VlcProc::VlcProc( intf_thread_t *pIntf ): SkinObject( pIntf ),
     // Called when a playlist item is deleted
     // TODO: properly handle item-deleted
     var_AddCallback( getPL(), "playlist-item-deleted", onItemDelete, this );
+    // Called when a batch of playlist changes is committed
+    var_AddCallback( getPL(), "playlist-batch", onPlaylistBatch, this );
     // Called when the current input changes
     var_AddCallback( getPL(), "input-current", onInputNew, this );
     // Called when a playlist item changed
@@ -202,6 +204,7 @@ VlcProc::~VlcProc()
 
     var_DelCallback( getPL(), "playlist-item-append", onItemAppend, this );
     var_DelCallback( getPL(), "playlist-item-deleted", onItemDelete, this );
+    var_DelCallback( getPL(), "playlist-batch", onPlaylistBatch, this );
     var_DelCallback( getPL(), "input-current", onInputNew, this );
     var_DelCallback( getPL(), "item-change", onItemChange, this );
     var_DelCallback( getIntf(), "interaction", onInteraction, this );
@@ -248,9 +251,13 @@ int VlcProc::onItemAppend( vlc_object_t *pObj, const char *pVariable,
                            vlc_value_t oldVal, vlc_value_t newVal,
                            void *pParam )
 {
-    (void)pObj; (void)pVariable; (void)oldVal;
+    (void)pVariable; (void)oldVal;
     VlcProc *pThis = (VlcProc*)pParam;
 
+    // The whole batch is processed at once, see onPlaylistBatch()
+    if( playlist_IsBatching( (playlist_t *)pObj ) )
+        return VLC_SUCCESS;
+
     playlist_item_t *item = static_cast<playlist_item_t *>(newVal.p_address);
     CmdPlaytreeAppend *pCmdTree =
         new CmdPlaytreeAppend( pThis->getIntf(), item->i_id );
@@ -266,9 +273,12 @@ int VlcProc::onItemDelete( vlc_object_t *pObj, const char *pVariable,
                            vlc_value_t oldVal, vlc_value_t newVal,
                            void *pParam )
 {
-    (void)pObj; (void)pVariable; (void)oldVal;
+    (void)pVariable; (void)oldVal;
     VlcProc *pThis = (VlcProc*)pParam;
 
+    if( playlist_IsBatching( (playlist_t *)pObj ) )
+        return VLC_SUCCESS;
+
     playlist_item_t *item = static_cast<playlist_item_t *>(newVal.p_address);
     CmdPlaytreeDelete *pCmdTree =
         new CmdPlaytreeDelete( pThis->getIntf(), item->i_id);
@@ -280,6 +290,28 @@ int VlcProc::onItemDelete( vlc_object_t *pObj, const char *pVariable,
     return VLC_SUCCESS;
 }
 
+int VlcProc::onPlaylistBatch( vlc_object_t *pObj, const char *pVariable,
+                              vlc_value_t oldVal, vlc_value_t newVal,
+                              void *pParam )
+{
+    (void)pVariable; (void)oldVal;
+    VlcProc *pThis = (VlcProc*)pParam;
+    playlist_t *pPlaylist = (playlist_t *)pObj;
+
+    // The playlist is locked here, so the node is still valid
+    playlist_item_t *pNode = static_cast<playlist_item_t *>(newVal.p_address);
+    int i_id = ( pNode && pNode != &pPlaylist->root ) ? pNode->i_id : -1;
+
+    CmdPlaytreeChanged *pCmdTree =
+        new CmdPlaytreeChanged( pThis->getIntf(), i_id );
+
+    // Push the command in the asynchronous command queue
+    AsyncQueue *pQueue = AsyncQueue::instance( pThis->getIntf() );
+    pQueue->push( CmdGenericPtr( pCmdTree ), true );
+
+    return VLC_SUCCESS;
+}
+
 int VlcProc::onInteraction( vlc_object_t *pObj, const char *pVariable,
                             vlc_value_t oldVal, vlc_value_t newVal,
                             void *pParam )
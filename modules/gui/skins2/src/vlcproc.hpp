@@ -196,6 +196,11 @@ private:
                              vlc_value_t oldVal, vlc_value_t newVal,
                              void *pParam );
 
+    /// Callback for playlist-batch variable
+    static int onPlaylistBatch( vlc_object_t *pObj, const char *pVariable,
+                                vlc_value_t oldVal, vlc_value_t newVal,
+                                void *pParam );
+
     static int onInteraction( vlc_object_t *pObj, const char *pVariable,
                               vlc_value_t oldVal, vlc_value_t newVal,
                               void *pParam );
@@ -29,7 +29,8 @@
 const std::string VarTree::m_type = "tree";
 
 VarTree::VarTree( intf_thread_t *pIntf )
-    : Variable( pIntf ), m_pParent( NULL ), m_id( 0 ),
+    : Variable( pIntf ), m_pParent( NULL ),
+      m_visibleCount( -1 ), m_leafCount( -1 ), m_id( 0 ),
       m_readonly( false ), m_selected( false ),
       m_playing( false ), m_expanded( false ),
       m_flat( false ), m_dontMove( false )
@@ -45,6 +46,7 @@ VarTree::VarTree( intf_thread_t *pIntf, VarTree *pParent, int id,
                   const UStringPtr &rcString, bool selected, bool playing,
                   bool expanded, bool readonly )
     : Variable( pIntf ), m_pParent( pParent ),
+      m_visibleCount( -1 ), m_leafCount( -1 ),
       m_id( id ), m_cString( rcString ),
       m_readonly( readonly ), m_selected( selected ),
       m_playing( playing ), m_expanded( expanded ),
@@ -60,6 +62,7 @@ VarTree::VarTree( intf_thread_t *pIntf, VarTree *pParent, int id,
 VarTree::VarTree( const VarTree& v )
     : Variable( v.getIntf() ),
       m_children( v.m_children), m_pParent( v.m_pParent ),
+      m_visibleCount( -1 ), m_leafCount( -1 ),
       m_id( v.m_id ), m_cString( v.m_cString ),
       m_readonly( v.m_readonly ), m_selected( v.m_selected ),
       m_playing( v.m_playing ), m_expanded( v.m_expanded ),
@@ -92,6 +95,7 @@ VarTree::Iterator VarTree::add( int id, const UStringPtr &rcString,
         for( int i = 0; i < pos && it != m_children.end(); ++it, i++ );
     }
 
+    invalidateCounts( true );
     return m_children.insert( it,
                               VarTree( getIntf(), this, id, rcString,
                                        selected, playing,
@@ -107,6 +111,7 @@ void VarTree::delSelected()
             Iterator oldIt = it;
             ++it;
             m_children.erase( oldIt );
+            invalidateCounts( true );
         }
     }
 }
@@ -114,6 +119,22 @@ void VarTree::delSelected()
 void VarTree::clear()
 {
     m_children.clear();
+    invalidateCounts( true );
+}
+
+void VarTree::invalidateCounts( bool b_leafs )
+{
+    // The counts of a node are only known if those of its displayed
+    // children are, so we can stop at the first unknown one
+    for( VarTree *p_node = this; p_node; p_node = p_node->m_pParent )
+    {
+        if( p_node->m_visibleCount < 0 &&
+            ( !b_leafs || p_node->m_leafCount < 0 ) )
+            break;
+        p_node->m_visibleCount = -1;
+        if( b_leafs )
+            p_node->m_leafCount = -1;
+    }
 }
 
 VarTree::Iterator VarTree::getNextSiblingOrUncle()
@@ -188,6 +209,9 @@ VarTree::Iterator VarTree::prev_uncle()
 
 int VarTree::visibleItems()
 {
+    if( m_visibleCount >= 0 )
+        return m_visibleCount;
+
     int i_count = size();
     for( Iterator it = m_children.begin(); it != m_children.end(); ++it )
     {
@@ -196,6 +220,7 @@ int VarTree::visibleItems()
             i_count += it->visibleItems();
         }
     }
+    m_visibleCount = i_count;
     return i_count;
 }
 
@@ -375,7 +400,7 @@ void VarTree::ensureExpanded( const Iterator& it )
     current = current->parent();
     while( current->parent() )
     {
-        current->m_expanded = true;
+        current->setExpanded( true );
         current = current->parent();
     }
 }
@@ -385,11 +410,15 @@ int VarTree::countLeafs()
     if( size() == 0 )
         return 1;
 
+    if( m_leafCount >= 0 )
+        return m_leafCount;
+
     int i_count = 0;
     for( Iterator it = m_children.begin(); it != m_children.end(); ++it )
     {
         i_count += it->countLeafs();
     }
+    m_leafCount = i_count;
     return i_count;
 }
 
@@ -402,17 +431,37 @@ VarTree::Iterator VarTree::firstLeaf()
 
 int VarTree::getIndex( const Iterator& item )
 {
+    if( item == m_children.end() || ( m_flat && item->size() ) )
+        return -1;
+
+    // Count what is displayed before the item, from its level up to ours,
+    // using the cached sizes of the subtrees
     int index = 0;
-    Iterator it;
-    for( it = m_flat ? firstLeaf() : m_children.begin();
-         it != m_children.end();
-         it = m_flat ? getNextLeaf( it ) : getNextVisibleItem( it ) )
+    for( VarTree *p_item = &*item; p_item != this; )
     {
-        if( it == item )
-            break;
-        index++;
+        VarTree *p_parent = p_item->m_pParent;
+        if( !p_parent )
+            return -1;
+
+        for( Iterator it = p_parent->m_children.begin();
+             &*it != p_item; ++it )
+        {
+            if( m_flat )
+                index += it->countLeafs();
+            else
+                index += 1 + ( it->m_expanded ? it->visibleItems() : 0 );
+        }
+
+        if( !m_flat && p_parent != this )
+        {
+            // Hidden in a folded node
+            if( !p_parent->m_expanded )
+                return -1;
+            index++;
+        }
+        p_item = p_parent;
     }
-    return (it == item) ? index : -1;
+    return index;
 }
 
 VarTree::Iterator VarTree::getItemFromSlider()
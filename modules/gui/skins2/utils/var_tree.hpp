@@ -80,7 +80,15 @@ public:
 
     inline void setSelected( bool val ) { m_selected = val; }
     inline void setPlaying( bool val ) { m_playing = val; }
-    inline void setExpanded( bool val ) { m_expanded = val; }
+    inline void setExpanded( bool val )
+    {
+        if( val == m_expanded )
+            return;
+        m_expanded = val;
+        // Only the ancestors display a different number of items
+        if( m_pParent )
+            m_pParent->invalidateCounts( false );
+    }
     inline void setFlat( bool val ) { m_flat = val; }
 
     inline void toggleSelected() { m_selected = !m_selected; }
@@ -179,7 +187,11 @@ public:
     Iterator firstLeaf();
 
     /// Remove a child
-    void removeChild( Iterator it ) { m_children.erase( it ); }
+    void removeChild( Iterator it )
+    {
+        m_children.erase( it );
+        invalidateCounts( true );
+    }
 
     /// Execute the action associated to this item
     virtual void action( VarTree *pItem ) { VLC_UNUSED(pItem); }
@@ -192,10 +204,10 @@ public:
     const VariablePtr &getPositionVarPtr() const { return m_cPosition; }
 
     /// Count the number of items that should be displayed if the
-    /// playlist window wasn't limited
+    /// playlist window wasn't limited (cached)
     int visibleItems();
 
-    /// Count the number of leafs in the tree
+    /// Count the number of leafs in the tree (cached)
     int countLeafs();
 
     /// Return iterator to the n'th visible item
@@ -273,6 +285,13 @@ private:
     /// Pointer to parent node
     VarTree *m_pParent;
 
+    /// Cached results of visibleItems() and countLeafs(), -1 if unknown
+    int m_visibleCount;
+    int m_leafCount;
+
+    /// Forget the cached counts of this node and of its ancestors
+    void invalidateCounts( bool b_leafs );
+
     int m_id;
     UStringPtr m_cString;
 
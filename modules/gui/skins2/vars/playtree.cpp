@@ -93,6 +93,37 @@ void Playtree::onChange()
     notify( &descr );
 }
 
+void Playtree::onChangeNode( int id )
+{
+    Iterator it = findById( id );
+    if( it == m_children.end() )
+    {
+        onChange();
+        return;
+    }
+
+    playlist_Lock( m_pPlaylist );
+    playlist_item_t *pNode = playlist_ItemGetById( m_pPlaylist, id );
+    if( !pNode )
+    {
+        playlist_Unlock( m_pPlaylist );
+        onChange();
+        return;
+    }
+
+    // Only mirror again the children of this node
+    forgetChildren( it );
+    it->clear();
+    for( int i = 0; i < pNode->i_children; i++ )
+    {
+        buildNode( pNode->pp_children[i], *it );
+    }
+    playlist_Unlock( m_pPlaylist );
+
+    tree_update descr( tree_update::ResetAll, end() );
+    notify( &descr );
+}
+
 void Playtree::onUpdateItem( int id )
 {
     Iterator it = findById( id );
@@ -186,6 +217,7 @@ void Playtree::onDelete( int i_id )
                 tree_update::DeletingItem, IteratorVisible( it, this ) );
             notify( &descr );
 
+            forgetChildren( it );
             parent->removeChild( it );
             m_allItems.erase( i_id );
 
@@ -250,6 +282,16 @@ void Playtree::buildNode( playlist_item_t *pNode, VarTree &rTree )
     }
 }
 
+void Playtree::forgetChildren( Iterator it )
+{
+    Iterator last = it->getNextSiblingOrUncle();
+    for( Iterator child = getNextItem( it ); child != last;
+         child = getNextItem( child ) )
+    {
+        m_allItems.erase( child->getId() );
+    }
+}
+
 void Playtree::buildTree()
 {
     clear();
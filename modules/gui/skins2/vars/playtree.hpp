@@ -46,6 +46,9 @@ public:
     /// Function called to notify playlist changes
     void onChange();
 
+    /// Function called to notify changes below a node (-1 for the root)
+    void onChangeNode( int id );
+
     /// Function called to notify playlist item update
     void onUpdateItem( int id );
 
@@ -80,6 +83,9 @@ private:
     /// Update Node's children
     void buildNode( playlist_item_t *p_node, VarTree &m_pNode );
 
+    /// Remove the descendants of an item from the id index
+    void forgetChildren( Iterator it );
+
     /// title for an item
     UString* getTitle( input_item_t *pItem );
 };
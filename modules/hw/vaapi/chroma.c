@@ -41,10 +41,13 @@ struct filter_sys_t
 {
     struct vlc_vaapi_instance *va_inst;
     VADisplay           dpy;
-    picture_pool_t *    dest_pics;
-    VASurfaceID *       va_surface_ids;
+    struct vlc_vaapi_shared_pool *dest_pics;
     copy_cache_t        cache;
 
+    /* time spent waiting for the GPU before downloading */
+    mtime_t             sync_time;
+    unsigned            sync_count;
+
     bool                derive_failed;
     bool                image_fallback_failed;
 };
@@ -139,8 +142,11 @@ DownloadSurface(filter_t *filter, picture_t *src_pic)
 
     VAImageID image_fallback_id = VA_INVALID_ID;
     VASurfaceID surface = vlc_vaapi_PicGetSurface(src_pic);
+    mtime_t start = mdate();
     if (vaSyncSurface(va_dpy, surface))
         goto error;
+    filter_sys->sync_time += mdate() - start;
+    filter_sys->sync_count++;
 
     if (filter_sys->derive_failed ||
         vlc_vaapi_DeriveImage(VLC_OBJECT(filter), va_dpy, surface, &src_img))
@@ -242,7 +248,8 @@ UploadSurface(filter_t *filter, picture_t *src)
     VADisplay const va_dpy = filter->p_sys->dpy;
     VAImage         dest_img;
     void *          dest_buf;
-    picture_t *     dest_pic = picture_pool_Wait(filter->p_sys->dest_pics);
+    picture_t *     dest_pic =
+        vlc_vaapi_SharedPoolWait(VLC_OBJECT(filter), filter->p_sys->dest_pics);
 
     if (!dest_pic)
     {
@@ -354,9 +361,9 @@ vlc_vaapi_OpenChroma(vlc_object_t *obj)
         }
 
         filter_sys->dest_pics =
-            vlc_vaapi_PoolNew(obj, filter_sys->va_inst, filter_sys->dpy,
-                              DEST_PICS_POOL_SZ, &filter_sys->va_surface_ids,
-                              &filter->fmt_out.video, true);
+            vlc_vaapi_SharedPoolHold(filter_sys->va_inst, filter_sys->dpy,
+                                     DEST_PICS_POOL_SZ, &filter->fmt_out.video,
+                                     true);
         if (!filter_sys->dest_pics)
         {
             vlc_vaapi_FilterReleaseInstance(filter, filter_sys->va_inst);
@@ -378,7 +385,8 @@ vlc_vaapi_OpenChroma(vlc_object_t *obj)
     {
         if (is_upload)
         {
-            picture_pool_Release(filter_sys->dest_pics);
+            vlc_vaapi_SharedPoolRelease(filter_sys->dest_pics,
+                                        DEST_PICS_POOL_SZ);
             vlc_vaapi_FilterReleaseInstance(filter, filter_sys->va_inst);
         }
         free(filter_sys);
@@ -401,8 +409,12 @@ vlc_vaapi_CloseChroma(vlc_object_t *obj)
     filter_t *filter = (filter_t *)obj;
     filter_sys_t *const filter_sys = filter->p_sys;
 
+    if (filter_sys->sync_count > 0)
+        msg_Dbg(obj, "waited %"PRId64" us on average for %u surfaces",
+                filter_sys->sync_time / filter_sys->sync_count,
+                filter_sys->sync_count);
     if (filter_sys->dest_pics)
-        picture_pool_Release(filter_sys->dest_pics);
+        vlc_vaapi_SharedPoolRelease(filter_sys->dest_pics, DEST_PICS_POOL_SZ);
     if (filter_sys->va_inst != NULL)
         vlc_vaapi_FilterReleaseInstance(filter, filter_sys->va_inst);
     CopyCleanCache(&filter_sys->cache);
@@ -106,15 +106,18 @@ struct  va_filter_desc
     VAConfigID          conf;
     VAContextID         ctx;
     VABufferID          buf;
-    VASurfaceID *       surface_ids;
 };
 
 struct  filter_sys_t
 {
-    struct va_filter_desc       va;
-    picture_pool_t *            dest_pics;
-    bool                        b_pipeline_fast;
-    void *                      p_data;
+    struct va_filter_desc           va;
+    struct vlc_vaapi_shared_pool *  dest_pics;
+    bool                            b_pipeline_fast;
+    void *                          p_data;
+
+    /* time spent submitting the pictures to the GPU */
+    mtime_t                         submit_time;
+    unsigned                        submit_count;
 };
 
 #define DEST_PICS_POOL_SZ       3
@@ -273,10 +276,13 @@ Filter(filter_t * filter, picture_t * src,
                                          VAProcPipelineParameterBuffer *))
 {
     filter_sys_t *const filter_sys = filter->p_sys;
-    picture_t *const    dest = picture_pool_Wait(filter_sys->dest_pics);
+    picture_t *const    dest =
+        vlc_vaapi_SharedPoolWait(VLC_OBJECT(filter), filter_sys->dest_pics);
     if (!dest)
         return NULL;
 
+    mtime_t const       start = mdate();
+
     vlc_vaapi_PicAttachContext(dest);
     picture_CopyProperties(dest, src);
 
@@ -338,6 +344,11 @@ Filter(filter_t * filter, picture_t * src,
                              filter_sys->va.dpy, filter_sys->va.ctx))
         goto error;
 
+    /* The picture is processed asynchronously: it is only synchronized by
+     * the first user of its surface on the CPU side. */
+    filter_sys->submit_time += mdate() - start;
+    filter_sys->submit_count++;
+
     return dest;
 
 error:
@@ -380,10 +391,9 @@ Open(filter_t * filter,
         goto error;
 
     filter_sys->dest_pics =
-        vlc_vaapi_PoolNew(VLC_OBJECT(filter), filter_sys->va.inst,
-                          filter_sys->va.dpy, DEST_PICS_POOL_SZ,
-                          &filter_sys->va.surface_ids, &filter->fmt_out.video,
-                          true);
+        vlc_vaapi_SharedPoolHold(filter_sys->va.inst, filter_sys->va.dpy,
+                                 DEST_PICS_POOL_SZ, &filter->fmt_out.video,
+                                 true);
     if (!filter_sys->dest_pics)
         goto error;
 
@@ -399,8 +409,7 @@ Open(filter_t * filter,
                                 filter_sys->va.dpy, filter_sys->va.conf,
                                 filter->fmt_out.video.i_width,
                                 filter->fmt_out.video.i_height,
-                                0, filter_sys->va.surface_ids,
-                                DEST_PICS_POOL_SZ);
+                                0, NULL, 0);
     if (filter_sys->va.ctx == VA_INVALID_ID)
         goto error;
 
@@ -453,6 +462,8 @@ error:
     if (filter_sys->va.conf != VA_INVALID_ID)
         vlc_vaapi_DestroyConfig(VLC_OBJECT(filter),
                                 filter_sys->va.dpy, filter_sys->va.conf);
+    if (filter_sys->dest_pics)
+        vlc_vaapi_SharedPoolRelease(filter_sys->dest_pics, DEST_PICS_POOL_SZ);
     if (filter_sys->va.inst)
         vlc_vaapi_FilterReleaseInstance(filter, filter_sys->va.inst);
     free(filter_sys);
@@ -463,7 +474,11 @@ static void
 Close(filter_t *filter, filter_sys_t * filter_sys)
 {
     vlc_object_t * obj = VLC_OBJECT(filter);
-    picture_pool_Release(filter_sys->dest_pics);
+    if (filter_sys->submit_count > 0)
+        msg_Dbg(obj, "%u pictures submitted in %"PRId64" us on average",
+                filter_sys->submit_count,
+                filter_sys->submit_time / filter_sys->submit_count);
+    vlc_vaapi_SharedPoolRelease(filter_sys->dest_pics, DEST_PICS_POOL_SZ);
     vlc_vaapi_DestroyBuffer(obj, filter_sys->va.dpy, filter_sys->va.buf);
     vlc_vaapi_DestroyContext(obj, filter_sys->va.dpy, filter_sys->va.ctx);
     vlc_vaapi_DestroyConfig(obj, filter_sys->va.dpy, filter_sys->va.conf);
@@ -77,11 +77,16 @@ vlc_chroma_to_vaapi(int i_vlc_chroma, unsigned *va_rt_format, int *va_fourcc)
  * VA instance management *
  **************************/
 
+struct vlc_vaapi_shared_pool;
+
 struct vlc_vaapi_instance {
     VADisplay dpy;
     VANativeDisplay native;
     vlc_vaapi_native_destroy_cb native_destroy_cb;
     atomic_uint pic_refcount;
+
+    vlc_mutex_t lock;
+    struct vlc_vaapi_shared_pool *shared_pools; /* with lock */
 };
 
 struct vlc_vaapi_instance *
@@ -99,6 +104,8 @@ vlc_vaapi_InitializeInstance(vlc_object_t *o, VADisplay dpy,
     inst->native = native;
     inst->native_destroy_cb = native_destroy_cb;
     atomic_init(&inst->pic_refcount, 1);
+    vlc_mutex_init(&inst->lock);
+    inst->shared_pools = NULL;
 
     return inst;
 error:
@@ -120,6 +127,8 @@ vlc_vaapi_ReleaseInstance(struct vlc_vaapi_instance *inst)
 {
     if (atomic_fetch_sub(&inst->pic_refcount, 1) == 1)
     {
+        assert(inst->shared_pools == NULL);
+        vlc_mutex_destroy(&inst->lock);
         vaTerminate(inst->dpy);
         if (inst->native != NULL && inst->native_destroy_cb != NULL)
             inst->native_destroy_cb(inst->native);
@@ -624,6 +633,134 @@ error:
     return NULL;
 }
 
+struct vlc_vaapi_shared_pool
+{
+    struct vlc_vaapi_instance *va_inst;
+    VADisplay dpy;
+    video_format_t fmt;
+    bool b_force_fourcc;
+
+    /* with the instance lock */
+    struct vlc_vaapi_shared_pool *next;
+    unsigned holders;
+    unsigned count;
+    picture_pool_t *pool;
+    unsigned pool_count;
+    /* Pools that were too small for a late user. There may still be users
+     * waiting on them, they are released with the last user. */
+    picture_pool_t **retired;
+    unsigned num_retired;
+};
+
+struct vlc_vaapi_shared_pool *
+vlc_vaapi_SharedPoolHold(struct vlc_vaapi_instance *inst, VADisplay dpy,
+                         unsigned count, const video_format_t *restrict fmt,
+                         bool b_force_fourcc)
+{
+    struct vlc_vaapi_shared_pool *pool;
+
+    vlc_mutex_lock(&inst->lock);
+    for (pool = inst->shared_pools; pool != NULL; pool = pool->next)
+        if (pool->fmt.i_chroma == fmt->i_chroma
+         && pool->fmt.i_visible_width == fmt->i_visible_width
+         && pool->fmt.i_visible_height == fmt->i_visible_height
+         && pool->b_force_fourcc == b_force_fourcc)
+            break;
+
+    if (pool == NULL)
+    {
+        pool = calloc(1, sizeof (*pool));
+        if (unlikely(pool == NULL))
+            goto end;
+        pool->va_inst = inst;
+        pool->dpy = dpy;
+        video_format_Copy(&pool->fmt, fmt);
+        pool->b_force_fourcc = b_force_fourcc;
+        pool->next = inst->shared_pools;
+        inst->shared_pools = pool;
+    }
+    pool->holders++;
+    pool->count += count;
+end:
+    vlc_mutex_unlock(&inst->lock);
+    return pool;
+}
+
+void
+vlc_vaapi_SharedPoolRelease(struct vlc_vaapi_shared_pool *pool,
+                            unsigned count)
+{
+    struct vlc_vaapi_instance *inst = pool->va_inst;
+
+    vlc_mutex_lock(&inst->lock);
+    assert(pool->count >= count);
+    pool->count -= count;
+    if (--pool->holders > 0)
+    {
+        vlc_mutex_unlock(&inst->lock);
+        return;
+    }
+
+    struct vlc_vaapi_shared_pool **pp = &inst->shared_pools;
+    while (*pp != pool)
+        pp = &(*pp)->next;
+    *pp = pool->next;
+    vlc_mutex_unlock(&inst->lock);
+
+    /* The surfaces are destroyed with the last picture in use */
+    if (pool->pool != NULL)
+        picture_pool_Release(pool->pool);
+    for (unsigned i = 0; i < pool->num_retired; i++)
+        picture_pool_Release(pool->retired[i]);
+    free(pool->retired);
+    video_format_Clean(&pool->fmt);
+    free(pool);
+}
+
+picture_t *
+vlc_vaapi_SharedPoolWait(vlc_object_t *o, struct vlc_vaapi_shared_pool *pool)
+{
+    struct vlc_vaapi_instance *inst = pool->va_inst;
+    picture_pool_t *pics;
+
+    vlc_mutex_lock(&inst->lock);
+    if (pool->pool == NULL || pool->pool_count < pool->count)
+    {
+        VASurfaceID *render_targets;
+        pics = vlc_vaapi_PoolNew(o, inst, pool->dpy, pool->count,
+                                 &render_targets, &pool->fmt,
+                                 pool->b_force_fourcc);
+        if (pics == NULL)
+            goto error;
+
+        if (pool->pool != NULL)
+        {
+            picture_pool_t **retired =
+                realloc(pool->retired,
+                        (pool->num_retired + 1) * sizeof (*retired));
+            if (unlikely(retired == NULL))
+            {
+                picture_pool_Release(pics);
+                goto error;
+            }
+            retired[pool->num_retired++] = pool->pool;
+            pool->retired = retired;
+        }
+        msg_Dbg(o, "%u surfaces shared by %u users", pool->count,
+                pool->holders);
+        pool->pool = pics;
+        pool->pool_count = pool->count;
+    }
+    pics = pool->pool;
+    vlc_mutex_unlock(&inst->lock);
+
+    return picture_pool_Wait(pics);
+
+error:
+    vlc_mutex_unlock(&inst->lock);
+    return NULL;
+}
+
 unsigned
 vlc_vaapi_PicSysGetRenderTargets(picture_sys_t *sys,
                                  VASurfaceID **render_targets)
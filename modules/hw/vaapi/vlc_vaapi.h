@@ -190,6 +190,24 @@ vlc_vaapi_PoolNew(vlc_object_t *o, struct vlc_vaapi_instance *vainst,
                   VADisplay dpy, unsigned count, VASurfaceID **render_targets,
                   const video_format_t *restrict fmt, bool b_force_fourcc);
 
+/* Registers a user of count surfaces of the given format. The surfaces are
+ * shared with every other user of the same instance and format (the stages
+ * of a filter chain), and allocated on first use for all the users. */
+struct vlc_vaapi_shared_pool *
+vlc_vaapi_SharedPoolHold(struct vlc_vaapi_instance *inst, VADisplay dpy,
+                         unsigned count, const video_format_t *restrict fmt,
+                         bool b_force_fourcc);
+
+/* Unregisters a user of the shared pool, count must be the one given to
+ * vlc_vaapi_SharedPoolHold() */
+void
+vlc_vaapi_SharedPoolRelease(struct vlc_vaapi_shared_pool *pool,
+                            unsigned count);
+
+/* Waits for a picture of the shared pool */
+picture_t *
+vlc_vaapi_SharedPoolWait(vlc_object_t *o, struct vlc_vaapi_shared_pool *pool);
+
 /* Get render targets from a pic_sys allocated by the vaapi pool (see
  * vlc_vaapi_PoolNew()) */
 unsigned
@@ -31,9 +31,12 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 
 #include <vlc_common.h>
 #include <vlc_access.h>
+#include <vlc_charset.h>
+#include <vlc_fs.h>
 
 #include "vlc.h"
 #include "libs.h"
@@ -118,6 +121,202 @@ static const luaL_Reg p_reg_parse[] =
     { NULL, NULL }
 };
 
+/*****************************************************************************
+ * Playlist scripts cache
+ *
+ * Every stream reaching this module probes all the playlist scripts. They
+ * are compiled once, and their bytecode is kept along with the hosts they
+ * declare in their optional probe_hosts table, so that the scripts for
+ * other hosts are skipped without even creating a Lua state.
+ *****************************************************************************/
+struct playlist_script
+{
+    struct playlist_script *next;
+    char *filename;
+    time_t mtime;
+    char *bytecode;
+    size_t size;
+    char **hosts; /* NULL if the script probes any URL */
+};
+
+static vlc_mutex_t scripts_lock = VLC_STATIC_MUTEX;
+static struct playlist_script *scripts = NULL;
+
+static void playlist_script_Clean(struct playlist_script *script)
+{
+    if (script->hosts != NULL)
+        for (char **host = script->hosts; *host != NULL; host++)
+            free(*host);
+    free(script->hosts);
+    free(script->bytecode);
+    script->hosts = NULL;
+    script->bytecode = NULL;
+    script->size = 0;
+}
+
+/* Returns the entry of a script, up to date with its file, or NULL */
+static struct playlist_script *playlist_script_Get(const char *filename)
+{
+    struct stat st;
+    struct playlist_script *script;
+
+    if (vlc_stat(filename, &st))
+        return NULL;
+
+    for (script = scripts; script != NULL; script = script->next)
+        if (!strcmp(script->filename, filename))
+            break;
+
+    if (script == NULL)
+    {
+        script = calloc(1, sizeof (*script));
+        if (unlikely(script == NULL))
+            return NULL;
+        script->filename = strdup(filename);
+        if (unlikely(script->filename == NULL))
+        {
+            free(script);
+            return NULL;
+        }
+        script->mtime = st.st_mtime;
+        script->next = scripts;
+        scripts = script;
+    }
+    else if (script->mtime != st.st_mtime)
+    {   /* The script was modified */
+        playlist_script_Clean(script);
+        script->mtime = st.st_mtime;
+    }
+    return script;
+}
+
+/* Checks the host of the path against the hosts declared by the script */
+static bool playlist_script_Matches(const struct playlist_script *script,
+                                    const char *path)
+{
+    if (script->hosts == NULL)
+        return true;
+    if (path == NULL)
+        return false;
+
+    size_t len = strcspn(path, "/?:");
+    for (char **host = script->hosts; *host != NULL; host++)
+    {
+        if (strlen(*host) == len && !strncasecmp(*host, path, len))
+            return true;
+        if (len > 4 && !strncasecmp(path, "www.", 4)
+         && strlen(*host) == len - 4 && !strncasecmp(*host, path + 4, len - 4))
+            return true;
+    }
+    return false;
+}
+
+static int playlist_script_Writer(lua_State *L, const void *p, size_t size,
+                                  void *data)
+{
+    struct playlist_script *script = data;
+    char *bytecode = realloc(script->bytecode, script->size + size);
+
+    if (unlikely(bytecode == NULL))
+        return 1;
+    memcpy(bytecode + script->size, p, size);
+    script->bytecode = bytecode;
+    script->size += size;
+    (void) L;
+    return 0;
+}
+
+/* Reads the hosts table of the script that just ran */
+static void playlist_script_ReadHosts(struct playlist_script *script,
+                                      lua_State *L)
+{
+    lua_getglobal(L, "probe_hosts");
+    if (lua_istable(L, -1))
+    {
+        size_t count = lua_objlen(L, -1);
+        char **hosts = calloc(count + 1, sizeof (*hosts));
+
+        for (size_t i = 0; hosts != NULL && i < count; i++)
+        {
+            lua_rawgeti(L, -1, i + 1);
+            const char *host = lua_tostring(L, -1);
+            if (host == NULL || (hosts[i] = strdup(host)) == NULL)
+            {   /* Invalid table: probe any URL */
+                while (i > 0)
+                    free(hosts[--i]);
+                free(hosts);
+                hosts = NULL;
+            }
+            lua_pop(L, 1);
+        }
+        script->hosts = hosts;
+    }
+    lua_pop(L, 1);
+}
+
+/* Runs a playlist script, from its cached bytecode if any */
+static int playlist_script_Run(vlc_object_t *obj, lua_State *L,
+                               const char *filename)
+{
+    vlc_mutex_lock(&scripts_lock);
+
+    struct playlist_script *script = playlist_script_Get(filename);
+    int ret;
+
+    if (script == NULL)
+    {
+        vlc_mutex_unlock(&scripts_lock);
+        return vlclua_dofile(obj, L, filename);
+    }
+
+    if (script->bytecode != NULL)
+        ret = luaL_loadbuffer(L, script->bytecode, script->size, filename);
+    else
+    {
+        char *path = ToLocaleDup(filename);
+
+        if (unlikely(path == NULL))
+            ret = LUA_ERRMEM;
+        else
+        {
+            ret = luaL_loadfile(L, path);
+            free(path);
+        }
+#if LUA_VERSION_NUM >= 503
+        if (!ret && lua_dump(L, playlist_script_Writer, script, 0))
+#else
+        if (!ret && lua_dump(L, playlist_script_Writer, script))
+#endif
+            playlist_script_Clean(script);
+    }
+    vlc_mutex_unlock(&scripts_lock);
+
+    if (ret)
+        return ret;
+    ret = lua_pcall(L, 0, LUA_MULTRET, 0);
+    if (ret)
+        return ret;
+
+    vlc_mutex_lock(&scripts_lock);
+    if (script->bytecode != NULL && script->hosts == NULL)
+        playlist_script_ReadHosts(script, L);
+    vlc_mutex_unlock(&scripts_lock);
+    return 0;
+}
+
+/* Returns false if the script does not handle the host of the path */
+static bool playlist_script_Probe(const char *filename, const char *path)
+{
+    bool ret = true;
+
+    vlc_mutex_lock(&scripts_lock);
+    struct playlist_script *script = playlist_script_Get(filename);
+    if (script != NULL && script->bytecode != NULL)
+        ret = playlist_script_Matches(script, path);
+    vlc_mutex_unlock(&scripts_lock);
+    return ret;
+}
+
 /*****************************************************************************
  * Called through lua_scripts_batch_execute to call 'probe' on
  * the script pointed by psz_filename.
@@ -128,6 +327,10 @@ static int probe_luascript(vlc_object_t *obj, const char *filename,
     stream_t *s = (stream_t *)obj;
     struct vlclua_playlist *sys = s->p_sys;
 
+    /* Skip the scripts for other hosts */
+    if (!playlist_script_Probe(filename, sys->path))
+        return VLC_EGENERIC;
+
     /* Initialise Lua state structure */
     lua_State *L = luaL_newstate();
     if( !L )
@@ -168,7 +371,7 @@ static int probe_luascript(vlc_object_t *obj, const char *filename,
     }
 
     /* Load and run the script(s) */
-    if (vlclua_dofile(VLC_OBJECT(s), L, filename))
+    if (playlist_script_Run(VLC_OBJECT(s), L, filename))
     {
         msg_Warn(s, "error loading script %s: %s", filename,
                  lua_tostring(L, lua_gettop(L)));
@@ -217,6 +217,12 @@ static int vlclua_input_item_stats( lua_State *L )
         STATS_FLOAT( send_bitrate )
         STATS_INT( played_abuffers )
         STATS_INT( lost_abuffers )
+        STATS_INT( aout_latency )
+        STATS_INT( aout_drift )
+        STATS_INT( aout_drift_max )
+        STATS_INT( aout_resampling )
+        STATS_INT( aout_underruns )
+        STATS_INT( aout_silences )
 #undef STATS_INT
 #undef STATS_FLOAT
         vlc_mutex_unlock( &p_item->p_stats->lock );
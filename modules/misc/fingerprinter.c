@@ -22,6 +22,7 @@
 #endif
 
 #include <assert.h>
+#include <sys/stat.h>
 
 #include <vlc_common.h>
 #include <vlc_plugin.h>
@@ -29,6 +30,8 @@
 #include <vlc_modules.h>
 #include <vlc_meta.h>
 #include <vlc_url.h>
+#include <vlc_fs.h>
+#include <vlc_configuration.h>
 
 #include <vlc/vlc.h>
 #include <vlc_input.h>
@@ -40,23 +43,57 @@
  * Local prototypes
  *****************************************************************************/
 
+#define FINGERPRINTER_THREADS_MAX 8
+/* New fingerprints between two saves of the cache */
+#define FINGERPRINTER_CACHE_FLUSH 64
+#define FINGERPRINTER_CACHE_HEADER "VLC fingerprint cache 1\n"
+
+/* Fingerprint of a local file, valid as long as the file is not modified */
+struct fingerprint_cache_entry
+{
+    uint64_t i_size;
+    time_t i_mtime;
+    unsigned int i_length; /* seconds of audio fingerprinted */
+    unsigned int i_duration;
+    char *psz_fingerprint;
+};
+
 struct fingerprinter_sys_t
 {
-    vlc_thread_t thread;
+    vlc_thread_t *threads;
+    unsigned int i_threads;
+    unsigned int i_length;
 
     struct
     {
         vlc_array_t         queue;
         vlc_mutex_t         lock;
-    } incoming, results;
+        vlc_cond_t          cond;
+    } incoming;
 
     struct
     {
         vlc_array_t         queue;
         vlc_mutex_t         lock;
-        vlc_cond_t          cond;
-        bool                b_working;
-    } processing;
+    } results;
+
+    struct
+    {
+        vlc_dictionary_t    dict; /* file path to cache entry */
+        vlc_mutex_t         lock;
+        unsigned int        i_dirty;
+        bool                b_enabled;
+    } cache;
+
+    vlc_mutex_t web_lock; /* one AcoustID query at a time */
+};
+
+/* Wait for the end of one input */
+struct fingerprint_wait
+{
+    vlc_mutex_t lock;
+    vlc_cond_t  cond;
+    bool        b_working;
 };
 
 static int  Open            (vlc_object_t *);
@@ -67,15 +104,246 @@ static void *Run(void *);
 /*****************************************************************************
  * Module descriptor
  ****************************************************************************/
+#define THREADS_TEXT N_("Fingerprinting threads")
+#define THREADS_LONGTEXT N_("Number of tracks fingerprinted concurrently, " \
+    "0 for one per CPU.")
+#define LENGTH_TEXT N_("Fingerprinted length")
+#define LENGTH_LONGTEXT N_("Only the beginning of the tracks is decoded, " \
+    "in seconds.")
+#define CACHE_TEXT N_("Cache the fingerprints")
+#define CACHE_LONGTEXT N_("Keep the fingerprints of the local files, as " \
+    "long as they are not modified.")
+
 vlc_module_begin ()
     set_category(CAT_ADVANCED)
     set_subcategory(SUBCAT_ADVANCED_MISC)
     set_shortname(N_("acoustid"))
     set_description(N_("Track fingerprinter (based on Acoustid)"))
     set_capability("fingerprinter", 10)
+    add_integer_with_range("fingerprinter-threads", 0, 0,
+                           FINGERPRINTER_THREADS_MAX,
+                           THREADS_TEXT, THREADS_LONGTEXT, true)
+    add_integer_with_range("fingerprinter-length", 90, 10, 600,
+                           LENGTH_TEXT, LENGTH_LONGTEXT, true)
+    add_bool("fingerprinter-cache", true, CACHE_TEXT, CACHE_LONGTEXT, true)
     set_callbacks(Open, Close)
 vlc_module_end ()
 
+/*****************************************************************************
+ * Cache
+ *****************************************************************************/
+
+static void FreeCacheEntry( void *p_value, void *p_obj )
+{
+    struct fingerprint_cache_entry *p_entry = p_value;
+
+    VLC_UNUSED( p_obj );
+    free( p_entry->psz_fingerprint );
+    free( p_entry );
+}
+
+static char *CachePath( void )
+{
+    char *psz_dir = config_GetUserDir( VLC_CACHE_DIR ), *psz_path;
+
+    if( psz_dir == NULL
+     || asprintf( &psz_path, "%s" DIR_SEP "fingerprints", psz_dir ) == -1 )
+        psz_path = NULL;
+    free( psz_dir );
+    return psz_path;
+}
+
+/* Each entry is a line: "<size> <mtime> <length> <duration> <path length>
+ * <path> <fingerprint>" */
+static void CacheLoad( fingerprinter_sys_t *p_sys )
+{
+    char *psz_path = CachePath();
+    FILE *file = psz_path ? vlc_fopen( psz_path, "rb" ) : NULL;
+
+    free( psz_path );
+    if( file == NULL )
+        return;
+
+    char header[sizeof( FINGERPRINTER_CACHE_HEADER )];
+    char *psz_line = NULL;
+    size_t i_line = 0;
+
+    if( fgets( header, sizeof( header ), file ) == NULL
+     || strcmp( header, FINGERPRINTER_CACHE_HEADER ) )
+        goto out;
+
+    for( ;; )
+    {
+        uint64_t i_size;
+        long long i_mtime;
+        unsigned int i_length, i_duration;
+        int i_path_len;
+
+        if( fscanf( file, "%"SCNu64" %lld %u %u %d", &i_size, &i_mtime,
+                    &i_length, &i_duration, &i_path_len ) != 5
+         || fgetc( file ) != ' '
+         || i_path_len <= 0 || i_path_len > 65536 )
+            break;
+
+        char *psz_key = malloc( i_path_len + 1 );
+        if( unlikely(psz_key == NULL)
+         || fread( psz_key, 1, i_path_len, file ) != (size_t)i_path_len
+         || fgetc( file ) != ' ' )
+        {
+            free( psz_key );
+            break;
+        }
+        psz_key[i_path_len] = '\0';
+
+        ssize_t i_read = getline( &psz_line, &i_line, file );
+        if( i_read < 2 || psz_line[i_read - 1] != '\n' )
+        {
+            free( psz_key );
+            break;
+        }
+        psz_line[i_read - 1] = '\0';
+
+        struct fingerprint_cache_entry *p_entry = malloc( sizeof( *p_entry ) );
+        if( p_entry != NULL )
+        {
+            p_entry->i_size = i_size;
+            p_entry->i_mtime = i_mtime;
+            p_entry->i_length = i_length;
+            p_entry->i_duration = i_duration;
+            p_entry->psz_fingerprint = strdup( psz_line );
+            if( likely(p_entry->psz_fingerprint != NULL) )
+            {
+                vlc_dictionary_remove_value_for_key( &p_sys->cache.dict,
+                                                     psz_key, FreeCacheEntry,
+                                                     NULL );
+                vlc_dictionary_insert( &p_sys->cache.dict, psz_key, p_entry );
+            }
+            else
+                free( p_entry );
+        }
+        free( psz_key );
+    }
+out:
+    free( psz_line );
+    fclose( file );
+}
+
+/* Called with the cache lock */
+static void CacheSave( vlc_object_t *p_obj, fingerprinter_sys_t *p_sys )
+{
+    if( p_sys->cache.i_dirty == 0 )
+        return;
+
+    char *psz_dir = config_GetUserDir( VLC_CACHE_DIR );
+    if( psz_dir != NULL )
+    {
+        vlc_mkdir( psz_dir, 0700 );
+        free( psz_dir );
+    }
+
+    char *psz_path = CachePath(), *psz_tmp;
+    if( psz_path == NULL || asprintf( &psz_tmp, "%s.tmp", psz_path ) == -1 )
+    {
+        free( psz_path );
+        return;
+    }
+
+    /* Replace the cache atomically, other instances may read it */
+    bool b_saved = false;
+    FILE *file = vlc_fopen( psz_tmp, "wb" );
+    if( file != NULL )
+    {
+        const vlc_dictionary_t *p_dict = &p_sys->cache.dict;
+
+        fputs( FINGERPRINTER_CACHE_HEADER, file );
+        for( int i = 0; p_dict->p_entries && i < p_dict->i_size; i++ )
+            for( const vlc_dictionary_entry_t *e = p_dict->p_entries[i]; e;
+                 e = e->p_next )
+            {
+                const struct fingerprint_cache_entry *p_entry = e->p_value;
+
+                fprintf( file, "%"PRIu64" %lld %u %u %zu %s %s\n",
+                         p_entry->i_size, (long long)p_entry->i_mtime,
+                         p_entry->i_length, p_entry->i_duration,
+                         strlen( e->psz_key ), e->psz_key,
+                         p_entry->psz_fingerprint );
+            }
+        b_saved = fclose( file ) == 0 && vlc_rename( psz_tmp, psz_path ) == 0;
+        if( !b_saved )
+            vlc_unlink( psz_tmp );
+    }
+    if( b_saved )
+        p_sys->cache.i_dirty = 0;
+    else
+        msg_Warn( p_obj, "cannot save the fingerprint cache %s", psz_path );
+    free( psz_tmp );
+    free( psz_path );
+}
+
+/**
+ * Gets the identity of a local file, to look it up in the cache
+ */
+static char *CacheKey( fingerprinter_sys_t *p_sys, const char *psz_uri,
+                       struct stat *p_st )
+{
+    if( !p_sys->cache.b_enabled )
+        return NULL;
+
+    char *psz_path = vlc_uri2path( psz_uri );
+    if( psz_path != NULL && vlc_stat( psz_path, p_st ) )
+        FREENULL( psz_path );
+    return psz_path;
+}
+
+static bool CacheGet( fingerprinter_sys_t *p_sys, const char *psz_key,
+                      const struct stat *p_st, acoustid_fingerprint_t *fp )
+{
+    vlc_mutex_lock( &p_sys->cache.lock );
+    const struct fingerprint_cache_entry *p_entry =
+        vlc_dictionary_value_for_key( &p_sys->cache.dict, psz_key );
+
+    if( p_entry != NULL
+     && p_entry->i_size == (uint64_t)p_st->st_size
+     && p_entry->i_mtime == p_st->st_mtime
+     && p_entry->i_length == p_sys->i_length )
+    {
+        fp->psz_fingerprint = strdup( p_entry->psz_fingerprint );
+        if( !fp->i_duration )
+            fp->i_duration = p_entry->i_duration;
+    }
+    vlc_mutex_unlock( &p_sys->cache.lock );
+    return fp->psz_fingerprint != NULL;
+}
+
+static void CachePut( fingerprinter_thread_t *p_fingerprinter,
+                      const char *psz_key, const struct stat *p_st,
+                      const acoustid_fingerprint_t *fp )
+{
+    fingerprinter_sys_t *p_sys = p_fingerprinter->p_sys;
+    struct fingerprint_cache_entry *p_entry = malloc( sizeof( *p_entry ) );
+
+    if( unlikely(p_entry == NULL) )
+        return;
+    p_entry->i_size = p_st->st_size;
+    p_entry->i_mtime = p_st->st_mtime;
+    p_entry->i_length = p_sys->i_length;
+    p_entry->i_duration = fp->i_duration;
+    p_entry->psz_fingerprint = strdup( fp->psz_fingerprint );
+    if( unlikely(p_entry->psz_fingerprint == NULL) )
+    {
+        free( p_entry );
+        return;
+    }
+
+    vlc_mutex_lock( &p_sys->cache.lock );
+    vlc_dictionary_remove_value_for_key( &p_sys->cache.dict, psz_key,
+                                         FreeCacheEntry, NULL );
+    vlc_dictionary_insert( &p_sys->cache.dict, psz_key, p_entry );
+    if( ++p_sys->cache.i_dirty >= FINGERPRINTER_CACHE_FLUSH )
+        CacheSave( VLC_OBJECT(p_fingerprinter), p_sys );
+    vlc_mutex_unlock( &p_sys->cache.lock );
+}
+
 /*****************************************************************************
  * Requests lifecycle
  *****************************************************************************/
@@ -85,24 +353,12 @@ static int EnqueueRequest( fingerprinter_thread_t *f, fingerprint_request_t *r )
     fingerprinter_sys_t *p_sys = f->p_sys;
     vlc_mutex_lock( &p_sys->incoming.lock );
     int i_ret = vlc_array_append( &p_sys->incoming.queue, r );
+    if( i_ret == 0 )
+        vlc_cond_signal( &p_sys->incoming.cond );
     vlc_mutex_unlock( &p_sys->incoming.lock );
     return i_ret;
 }
 
-static void QueueIncomingRequests( fingerprinter_sys_t *p_sys )
-{
-    vlc_mutex_lock( &p_sys->incoming.lock );
-
-    for( size_t i = vlc_array_count( &p_sys->incoming.queue ); i > 0 ; i-- )
-    {
-        fingerprint_request_t *r = vlc_array_item_at_index( &p_sys->incoming.queue, i - 1 );
-        if( vlc_array_append( &p_sys->processing.queue, r ) )
-            fingerprint_request_Delete( r );
-    }
-    vlc_array_clear( &p_sys->incoming.queue );
-    vlc_mutex_unlock(&p_sys->incoming.lock);
-}
-
 static fingerprint_request_t * GetResult( fingerprinter_thread_t *f )
 {
     fingerprint_request_t *r = NULL;
@@ -136,15 +392,15 @@ static int InputEventHandler( vlc_object_t *p_this, char const *psz_cmd,
     VLC_UNUSED( psz_cmd );
     VLC_UNUSED( oldval );
     input_thread_t *p_input = (input_thread_t *) p_this;
-    fingerprinter_sys_t *p_sys = (fingerprinter_sys_t *) p_data;
+    struct fingerprint_wait *p_wait = p_data;
     if( newval.i_int == INPUT_EVENT_STATE )
     {
         if( var_GetInteger( p_input, "state" ) >= PAUSE_S )
         {
-            vlc_mutex_lock( &p_sys->processing.lock );
-            p_sys->processing.b_working = false;
-            vlc_cond_signal( &p_sys->processing.cond );
-            vlc_mutex_unlock( &p_sys->processing.lock );
+            vlc_mutex_lock( &p_wait->lock );
+            p_wait->b_working = false;
+            vlc_cond_signal( &p_wait->cond );
+            vlc_mutex_unlock( &p_wait->lock );
         }
     }
     return VLC_SUCCESS;
@@ -154,6 +410,7 @@ static void DoFingerprint( fingerprinter_thread_t *p_fingerprinter,
                            acoustid_fingerprint_t *fp,
                            const char *psz_uri )
 {
+    fingerprinter_sys_t *p_sys = p_fingerprinter->p_sys;
     input_item_t *p_item = input_item_New( NULL, NULL );
     if ( unlikely(p_item == NULL) )
          return;
@@ -174,24 +431,27 @@ static void DoFingerprint( fingerprinter_thread_t *p_fingerprinter,
     free( psz_sout_option );
     input_item_AddOption( p_item, "vout=dummy", VLC_INPUT_OPTION_TRUSTED );
     input_item_AddOption( p_item, "aout=dummy", VLC_INPUT_OPTION_TRUSTED );
-    if ( fp->i_duration )
-    {
-        if ( asprintf( &psz_sout_option, "stop-time=%u", fp->i_duration ) == -1 )
-        {
-            input_item_Release( p_item );
-            return;
-        }
-        input_item_AddOption( p_item, psz_sout_option, VLC_INPUT_OPTION_TRUSTED );
-        free( psz_sout_option );
-    }
+    input_item_AddOption( p_item, "no-sout-video", VLC_INPUT_OPTION_TRUSTED );
+    input_item_AddOption( p_item, "no-sout-spu", VLC_INPUT_OPTION_TRUSTED );
+
+    /* Only decode what is fingerprinted, with a margin for the timestamps */
+    char psz_length[32];
+    snprintf( psz_length, sizeof( psz_length ), "duration=%u",
+              p_sys->i_length );
+    input_item_AddOption( p_item, psz_length, VLC_INPUT_OPTION_TRUSTED );
+    snprintf( psz_length, sizeof( psz_length ), "stop-time=%u",
+              p_sys->i_length + 1 );
+    input_item_AddOption( p_item, psz_length, VLC_INPUT_OPTION_TRUSTED );
     input_item_SetURI( p_item, psz_uri ) ;
 
     input_thread_t *p_input = input_Create( p_fingerprinter, p_item, "fingerprinter", NULL, NULL );
-    input_item_Release( p_item );
-
     if( p_input == NULL )
+    {
+        input_item_Release( p_item );
         return;
+    }
 
+    struct fingerprint_wait wait;
     chromaprint_fingerprint_t chroma_fingerprint;
 
     chroma_fingerprint.psz_fingerprint = NULL;
@@ -200,29 +460,39 @@ static void DoFingerprint( fingerprinter_thread_t *p_fingerprinter,
     var_Create( p_input, "fingerprint-data", VLC_VAR_ADDRESS );
     var_SetAddress( p_input, "fingerprint-data", &chroma_fingerprint );
 
-    var_AddCallback( p_input, "intf-event", InputEventHandler, p_fingerprinter->p_sys );
+    vlc_mutex_init( &wait.lock );
+    vlc_cond_init( &wait.cond );
+    wait.b_working = true;
+    var_AddCallback( p_input, "intf-event", InputEventHandler, &wait );
 
     if( input_Start( p_input ) != VLC_SUCCESS )
     {
-        var_DelCallback( p_input, "intf-event", InputEventHandler, p_fingerprinter->p_sys );
+        var_DelCallback( p_input, "intf-event", InputEventHandler, &wait );
         input_Close( p_input );
     }
     else
     {
-        p_fingerprinter->p_sys->processing.b_working = true;
-        while( p_fingerprinter->p_sys->processing.b_working )
-        {
-            vlc_cond_wait( &p_fingerprinter->p_sys->processing.cond,
-                           &p_fingerprinter->p_sys->processing.lock );
-        }
-        var_DelCallback( p_input, "intf-event", InputEventHandler, p_fingerprinter->p_sys );
+        vlc_mutex_lock( &wait.lock );
+        while( wait.b_working )
+            vlc_cond_wait( &wait.cond, &wait.lock );
+        vlc_mutex_unlock( &wait.lock );
+        var_DelCallback( p_input, "intf-event", InputEventHandler, &wait );
         input_Stop( p_input );
         input_Close( p_input );
 
         fp->psz_fingerprint = chroma_fingerprint.psz_fingerprint;
         if( !fp->i_duration ) /* had not given hint */
-            fp->i_duration = chroma_fingerprint.i_duration;
+        {
+            /* Only the beginning was fingerprinted, the demuxer knows
+             * the actual length of most tracks */
+            mtime_t i_duration = input_item_GetDuration( p_item );
+            fp->i_duration = ( i_duration > 0 ) ? i_duration / CLOCK_FREQ
+                                                : chroma_fingerprint.i_duration;
+        }
     }
+    vlc_cond_destroy( &wait.cond );
+    vlc_mutex_destroy( &wait.lock );
+    input_item_Release( p_item );
 }
 
 /*****************************************************************************
@@ -240,25 +510,49 @@ static int Open(vlc_object_t *p_this)
 
     vlc_array_init( &p_sys->incoming.queue );
     vlc_mutex_init( &p_sys->incoming.lock );
-
-    vlc_array_init( &p_sys->processing.queue );
-    vlc_mutex_init( &p_sys->processing.lock );
-    vlc_cond_init( &p_sys->processing.cond );
+    vlc_cond_init( &p_sys->incoming.cond );
 
     vlc_array_init( &p_sys->results.queue );
     vlc_mutex_init( &p_sys->results.lock );
 
+    vlc_dictionary_init( &p_sys->cache.dict, 0 );
+    vlc_mutex_init( &p_sys->cache.lock );
+    vlc_mutex_init( &p_sys->web_lock );
+
+    p_sys->i_length = var_InheritInteger( p_fingerprinter,
+                                          "fingerprinter-length" );
+    p_sys->cache.b_enabled = var_InheritBool( p_fingerprinter,
+                                              "fingerprinter-cache" );
+    if( p_sys->cache.b_enabled )
+        CacheLoad( p_sys );
+
+    unsigned i_threads = var_InheritInteger( p_fingerprinter,
+                                             "fingerprinter-threads" );
+    if( i_threads == 0 )
+        i_threads = __MIN( vlc_GetCPUCount(), FINGERPRINTER_THREADS_MAX );
+    p_sys->threads = vlc_alloc( i_threads, sizeof( *p_sys->threads ) );
+    if( unlikely(p_sys->threads == NULL) )
+        goto error;
+
     p_fingerprinter->pf_enqueue = EnqueueRequest;
     p_fingerprinter->pf_getresults = GetResult;
     p_fingerprinter->pf_apply = ApplyResult;
 
     var_Create( p_fingerprinter, "results-available", VLC_VAR_BOOL );
-    if( vlc_clone( &p_sys->thread, Run, p_fingerprinter,
-                   VLC_THREAD_PRIORITY_LOW ) )
+    while( p_sys->i_threads < i_threads )
+    {
+        if( vlc_clone( &p_sys->threads[p_sys->i_threads], Run,
+                       p_fingerprinter, VLC_THREAD_PRIORITY_LOW ) )
+            break;
+        p_sys->i_threads++;
+    }
+    if( p_sys->i_threads == 0 )
     {
         msg_Err( p_fingerprinter, "cannot spawn fingerprinter thread" );
         goto error;
     }
+    msg_Dbg( p_fingerprinter, "fingerprinting %u tracks at a time",
+             p_sys->i_threads );
 
     return VLC_SUCCESS;
 
@@ -276,8 +570,14 @@ static void Close(vlc_object_t *p_this)
     fingerprinter_thread_t   *p_fingerprinter = (fingerprinter_thread_t*) p_this;
     fingerprinter_sys_t *p_sys = p_fingerprinter->p_sys;
 
-    vlc_cancel( p_sys->thread );
-    vlc_join( p_sys->thread, NULL );
+    for( unsigned i = 0; i < p_sys->i_threads; i++ )
+        vlc_cancel( p_sys->threads[i] );
+    for( unsigned i = 0; i < p_sys->i_threads; i++ )
+        vlc_join( p_sys->threads[i], NULL );
+
+    vlc_mutex_lock( &p_sys->cache.lock );
+    CacheSave( p_this, p_sys );
+    vlc_mutex_unlock( &p_sys->cache.lock );
 
     CleanSys( p_sys );
     free( p_sys );
@@ -289,17 +589,17 @@ static void CleanSys( fingerprinter_sys_t *p_sys )
         fingerprint_request_Delete( vlc_array_item_at_index( &p_sys->incoming.queue, i ) );
     vlc_array_clear( &p_sys->incoming.queue );
     vlc_mutex_destroy( &p_sys->incoming.lock );
-
-    for ( size_t i = 0; i < vlc_array_count( &p_sys->processing.queue ); i++ )
-        fingerprint_request_Delete( vlc_array_item_at_index( &p_sys->processing.queue, i ) );
-    vlc_array_clear( &p_sys->processing.queue );
-    vlc_mutex_destroy( &p_sys->processing.lock );
-    vlc_cond_destroy( &p_sys->processing.cond );
+    vlc_cond_destroy( &p_sys->incoming.cond );
 
     for ( size_t i = 0; i < vlc_array_count( &p_sys->results.queue ); i++ )
         fingerprint_request_Delete( vlc_array_item_at_index( &p_sys->results.queue, i ) );
     vlc_array_clear( &p_sys->results.queue );
     vlc_mutex_destroy( &p_sys->results.lock );
+
+    vlc_dictionary_clear( &p_sys->cache.dict, FreeCacheEntry, NULL );
+    vlc_mutex_destroy( &p_sys->cache.lock );
+    vlc_mutex_destroy( &p_sys->web_lock );
+    free( p_sys->threads );
 }
 
 static void fill_metas_with_results( fingerprint_request_t *p_r, acoustid_fingerprint_t *p_f )
@@ -323,71 +623,81 @@ static void fill_metas_with_results( fingerprint_request_t *p_r, acoustid_finger
     }
 }
 
+static void Process( fingerprinter_thread_t *p_fingerprinter,
+                     fingerprint_request_t *p_data )
+{
+    fingerprinter_sys_t *p_sys = p_fingerprinter->p_sys;
+    char *psz_uri = input_item_GetURI( p_data->p_item );
+    if ( psz_uri == NULL )
+        return;
+
+    acoustid_fingerprint_t acoustid_print;
+    struct stat st;
+
+    memset( &acoustid_print , 0, sizeof (acoustid_print) );
+    /* overwrite with hint, as in this case, fingerprint's session will be truncated */
+    if ( p_data->i_duration )
+         acoustid_print.i_duration = p_data->i_duration;
+
+    char *psz_key = CacheKey( p_sys, psz_uri, &st );
+    if ( psz_key == NULL || !CacheGet( p_sys, psz_key, &st, &acoustid_print ) )
+    {
+        DoFingerprint( p_fingerprinter, &acoustid_print, psz_uri );
+        if ( psz_key != NULL && acoustid_print.psz_fingerprint != NULL )
+            CachePut( p_fingerprinter, psz_key, &st, &acoustid_print );
+    }
+    free( psz_key );
+    free( psz_uri );
+
+    vlc_mutex_lock( &p_sys->web_lock );
+    DoAcoustIdWebRequest( VLC_OBJECT(p_fingerprinter), &acoustid_print );
+    vlc_mutex_unlock( &p_sys->web_lock );
+    fill_metas_with_results( p_data, &acoustid_print );
+
+    for( unsigned j = 0; j < acoustid_print.results.count; j++ )
+         free_acoustid_result_t( &acoustid_print.results.p_results[j] );
+    if( acoustid_print.results.count )
+        free( acoustid_print.results.p_results );
+    free( acoustid_print.psz_fingerprint );
+}
+
 /*****************************************************************************
- * Run :
+ * Run : fingerprinting thread, one per concurrent track
  *****************************************************************************/
 static void *Run( void *opaque )
 {
     fingerprinter_thread_t *p_fingerprinter = opaque;
     fingerprinter_sys_t *p_sys = p_fingerprinter->p_sys;
 
-    vlc_mutex_lock( &p_sys->processing.lock );
-    mutex_cleanup_push( &p_sys->processing.lock );
-
     /* main loop */
     for (;;)
     {
-        msleep( CLOCK_FREQ );
-
-        QueueIncomingRequests( p_sys );
-
-        vlc_testcancel();
-
-        for ( size_t i = 0 ; i < vlc_array_count( &p_sys->processing.queue ); i++ )
-        {
-            int canc = vlc_savecancel();
-            fingerprint_request_t *p_data = vlc_array_item_at_index( &p_sys->processing.queue, i );
-
-            char *psz_uri = input_item_GetURI( p_data->p_item );
-            if ( psz_uri != NULL )
-            {
-                 acoustid_fingerprint_t acoustid_print;
-
-                 memset( &acoustid_print , 0, sizeof (acoustid_print) );
-                /* overwrite with hint, as in this case, fingerprint's session will be truncated */
-                if ( p_data->i_duration )
-                     acoustid_print.i_duration = p_data->i_duration;
-
-                DoFingerprint( p_fingerprinter, &acoustid_print, psz_uri );
-                free( psz_uri );
-
-                DoAcoustIdWebRequest( VLC_OBJECT(p_fingerprinter), &acoustid_print );
-                fill_metas_with_results( p_data, &acoustid_print );
-
-                for( unsigned j = 0; j < acoustid_print.results.count; j++ )
-                     free_acoustid_result_t( &acoustid_print.results.p_results[j] );
-                if( acoustid_print.results.count )
-                    free( acoustid_print.results.p_results );
-                free( acoustid_print.psz_fingerprint );
-            }
-            vlc_restorecancel(canc);
-
-            /* copy results */
-            vlc_mutex_lock( &p_sys->results.lock );
-            if( vlc_array_append( &p_sys->results.queue, p_data ) )
-                fingerprint_request_Delete( p_data );
-            vlc_mutex_unlock( &p_sys->results.lock );
-
-            vlc_testcancel();
-        }
-
-        if ( vlc_array_count( &p_sys->processing.queue ) )
-        {
-            var_TriggerCallback( p_fingerprinter, "results-available" );
-            vlc_array_clear( &p_sys->processing.queue );
-        }
+        fingerprint_request_t *p_data;
+
+        /* The latest requests first, as they used to be */
+        vlc_mutex_lock( &p_sys->incoming.lock );
+        mutex_cleanup_push( &p_sys->incoming.lock );
+        while( vlc_array_count( &p_sys->incoming.queue ) == 0 )
+            vlc_cond_wait( &p_sys->incoming.cond, &p_sys->incoming.lock );
+
+        size_t i_last = vlc_array_count( &p_sys->incoming.queue ) - 1;
+        p_data = vlc_array_item_at_index( &p_sys->incoming.queue, i_last );
+        vlc_array_remove( &p_sys->incoming.queue, i_last );
+        vlc_cleanup_pop();
+        vlc_mutex_unlock( &p_sys->incoming.lock );
+
+        int canc = vlc_savecancel();
+        Process( p_fingerprinter, p_data );
+
+        /* copy results */
+        vlc_mutex_lock( &p_sys->results.lock );
+        if( vlc_array_append( &p_sys->results.queue, p_data ) )
+            fingerprint_request_Delete( p_data );
+        vlc_mutex_unlock( &p_sys->results.lock );
+
+        var_TriggerCallback( p_fingerprinter, "results-available" );
+        vlc_restorecancel( canc );
     }
 
-    vlc_cleanup_pop();
     vlc_assert_unreachable();
 }
@@ -403,13 +403,45 @@ static vlc_tls_t *gnutls_ClientSessionOpen(vlc_tls_creds_t *crd,
     gnutls_dh_set_prime_bits (session, 1024);
 
     if (likely(hostname != NULL))
+    {
         /* fill Server Name Indication */
         gnutls_server_name_set (session, GNUTLS_NAME_DNS,
                                 hostname, strlen (hostname));
 
+        /* try to resume a previous session with the same server */
+        size_t len;
+        void *data = vlc_tls_SessionCacheLoad(hostname, &len);
+        if (data != NULL)
+        {
+            int val = gnutls_session_set_data(session, data, len);
+            if (val != 0)
+                msg_Dbg(crd, "cannot resume session with %s: %s", hostname,
+                        gnutls_strerror(val));
+            free(data);
+        }
+    }
+
     return &priv->tls;
 }
 
+static void gnutls_ClientSessionSave(vlc_tls_creds_t *creds,
+                                     gnutls_session_t session,
+                                     const char *host)
+{
+    if (host == NULL)
+        return;
+
+    if (gnutls_session_is_resumed(session))
+        msg_Dbg(creds, "resumed session with %s", host);
+
+    gnutls_datum_t data;
+    if (gnutls_session_get_data2(session, &data) == 0)
+    {
+        vlc_tls_SessionCacheStore(host, data.data, data.size);
+        gnutls_free(data.data);
+    }
+}
+
 static int gnutls_ClientHandshake(vlc_tls_creds_t *creds, vlc_tls_t *tls,
                                   const char *host, const char *service,
                                   char **restrict alp)
@@ -433,7 +465,10 @@ static int gnutls_ClientHandshake(vlc_tls_creds_t *creds, vlc_tls_t *tls,
     }
 
     if (status == 0) /* Good certificate */
+    {
+        gnutls_ClientSessionSave(creds, session, host);
         return 0;
+    }
 
     /* Bad certificate */
     gnutls_datum_t desc;
@@ -471,6 +506,7 @@ static int gnutls_ClientHandshake(vlc_tls_creds_t *creds, vlc_tls_t *tls,
     {
         case 0:
             msg_Dbg(creds, "certificate key match for %s", host);
+            gnutls_ClientSessionSave(creds, session, host);
             return 0;
         case GNUTLS_E_NO_CERTIFICATE_FOUND:
             msg_Dbg(creds, "no known certificates for %s", host);
@@ -609,6 +645,7 @@ typedef struct vlc_tls_creds_sys
 {
     gnutls_certificate_credentials_t x509_cred;
     gnutls_dh_params_t dh_params;
+    gnutls_datum_t ticket_key;
 } vlc_tls_creds_sys_t;
 
 /**
@@ -623,7 +660,13 @@ static vlc_tls_t *gnutls_ServerSessionOpen(vlc_tls_creds_t *crd,
 
     assert (hostname == NULL);
     priv = gnutls_SessionOpen(crd, GNUTLS_SERVER, sys->x509_cred, sk, alpn);
-    return (priv != NULL) ? &priv->tls : NULL;
+    if (priv == NULL)
+        return NULL;
+
+    /* let returning clients resume with a session ticket */
+    if (sys->ticket_key.data != NULL)
+        gnutls_session_ticket_enable_server(priv->session, &sys->ticket_key);
+    return &priv->tls;
 }
 
 static int gnutls_ServerHandshake(vlc_tls_creds_t *crd, vlc_tls_t *tls,
@@ -717,6 +760,14 @@ static int OpenServer (vlc_tls_creds_t *crd, const char *cert, const char *key)
                  gnutls_strerror (val));
     }
 
+    val = gnutls_session_ticket_key_generate (&sys->ticket_key);
+    if (val < 0)
+    {
+        msg_Warn (crd, "cannot generate session ticket key: %s",
+                  gnutls_strerror (val));
+        sys->ticket_key.data = NULL;
+    }
+
     msg_Dbg (crd, "ciphers parameters loaded");
 
     crd->sys = sys;
@@ -741,6 +792,11 @@ static void CloseServer (vlc_tls_creds_t *crd)
     /* all sessions depending on the server are now deinitialized */
     gnutls_certificate_free_credentials (sys->x509_cred);
     gnutls_dh_params_deinit (sys->dh_params);
+    if (sys->ticket_key.data != NULL)
+    {
+        memset (sys->ticket_key.data, 0, sys->ticket_key.size);
+        gnutls_free (sys->ticket_key.data);
+    }
     free (sys);
 }
 #endif
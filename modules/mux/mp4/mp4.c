@@ -1266,6 +1266,15 @@ static void WriteFragments(sout_mux_t *p_mux, bool b_flush)
         msg_Dbg(p_mux, "writing moof @ %"PRId64, p_sys->i_pos);
         p_sys->i_pos += moof->b->i_buffer;
         assert(moof->b->i_flags & BLOCK_FLAG_TYPE_I); /* http sout */
+
+        /* date the fragment, for segmenting access outputs */
+        for (unsigned int i = 0; i < p_sys->i_nb_streams; i++)
+        {
+            const mp4_fragentry_t *p_entry = p_sys->pp_streams[i]->towrite.p_first;
+            if (p_entry && p_entry->p_block->i_dts > VLC_TS_INVALID &&
+                (moof->b->i_dts <= VLC_TS_INVALID || p_entry->p_block->i_dts < moof->b->i_dts))
+                moof->b->i_dts = p_entry->p_block->i_dts;
+        }
         box_send(p_mux, moof);
         msg_Dbg(p_mux, "writing mdat @ %"PRId64, p_sys->i_pos);
         WriteFragmentMDAT(p_mux, i_mdat_size);
@@ -323,6 +323,100 @@ static inline void BufferChainClean( sout_buffer_chain_t *c )
     BufferChainInit( c );
 }
 
+/* A TS packet being muxed, written in place in its output block */
+typedef struct
+{
+    block_t         *p_block;   /* output block starting with this packet */
+    uint8_t         *p_buffer;
+    mtime_t         i_dts;
+    mtime_t         i_length;
+    uint32_t        i_flags;
+} ts_packet_t;
+
+/* The TS packets of a muxing round, in output order. They are packed into
+ * blocks of up to i_per_block packets; PSI packets and key frame starts
+ * begin a new block, so that the access outputs can still split on them. */
+typedef struct
+{
+    ts_packet_t     *p_packets;
+    int             i_depth;
+    int             i_allocated;
+    int             i_per_block;
+    block_t         *p_block;   /* output block being filled */
+    bool            b_psi;      /* ...with PSI packets */
+    uint8_t         scratch[188]; /* packet dropped on allocation failure */
+} ts_packets_t;
+
+static void TSPacketsInit( ts_packets_t *c, int i_per_block )
+{
+    c->p_packets = NULL;
+    c->i_depth = 0;
+    c->i_allocated = 0;
+    c->i_per_block = i_per_block;
+    c->p_block = NULL;
+    c->b_psi = false;
+}
+
+static ts_packet_t *TSPacketNew( ts_packets_t *c, bool b_new_block, bool b_psi )
+{
+    if( c->i_depth == c->i_allocated )
+    {
+        int i_allocated = __MAX( 2 * c->i_allocated, 256 );
+        ts_packet_t *p_packets = realloc( c->p_packets,
+                                          i_allocated * sizeof(*p_packets) );
+        if( unlikely(p_packets == NULL) )
+            return NULL;
+        c->p_packets = p_packets;
+        c->i_allocated = i_allocated;
+    }
+
+    ts_packet_t *p_ts = &c->p_packets[c->i_depth];
+    if( b_new_block || b_psi != c->b_psi || c->p_block == NULL ||
+        c->p_block->i_buffer >= (size_t)c->i_per_block * 188 )
+    {
+        c->p_block = block_Alloc( c->i_per_block * 188 );
+        if( unlikely(c->p_block == NULL) )
+            return NULL;
+        c->p_block->i_buffer = 0;
+        c->b_psi = b_psi;
+        p_ts->p_block = c->p_block;
+    }
+    else
+        p_ts->p_block = NULL;
+
+    p_ts->p_buffer = &c->p_block->p_buffer[c->p_block->i_buffer];
+    c->p_block->i_buffer += 188;
+    p_ts->i_dts = 0;
+    p_ts->i_length = 0;
+    p_ts->i_flags = 0;
+    c->i_depth++;
+    return p_ts;
+}
+
+/* PEStoTSCallback for the PSI tables */
+static void TSPacketsAppendPSI( void *opaque, block_t *p_psi )
+{
+    ts_packets_t *c = opaque;
+    ts_packet_t *p_ts = TSPacketNew( c, false, true );
+
+    if( likely(p_ts != NULL) )
+    {
+        memcpy( p_ts->p_buffer, p_psi->p_buffer, 188 );
+        p_ts->i_dts = p_psi->i_dts;
+        p_ts->i_flags = p_psi->i_flags;
+    }
+    block_Release( p_psi );
+}
+
+static void TSPacketsClean( ts_packets_t *c )
+{
+    for( int i = 0; i < c->i_depth; i++ )
+        if( c->p_packets[i].p_block )
+            block_Release( c->p_packets[i].p_block );
+    free( c->p_packets );
+    TSPacketsInit( c, c->i_per_block );
+}
+
 typedef struct
 {
     sout_buffer_chain_t chain_pes;
@@ -380,6 +474,7 @@ struct sout_mux_sys_t
     bool            b_use_key_frames;
 
     mtime_t         i_pcr;  /* last PCR emited */
+    ts_packets_t    packets;
 
     csa_t           *csa;
     int             i_csa_pkt_size;
@@ -473,15 +568,18 @@ static int Mux      ( sout_mux_t * );
 
 static block_t *FixPES( sout_mux_t *p_mux, block_fifo_t *p_fifo );
 static block_t *Add_ADTS( block_t *, const es_format_t * );
-static void TSSchedule  ( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
+static void TSSchedule  ( sout_mux_t *p_mux, ts_packet_t *p_packets,
+                          int i_packet_count,
                           mtime_t i_pcr_length, mtime_t i_pcr_dts );
-static void TSDate      ( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
+static void TSDate      ( sout_mux_t *p_mux, ts_packet_t *p_packets,
+                          int i_packet_count,
                           mtime_t i_pcr_length, mtime_t i_pcr_dts );
-static void GetPAT( sout_mux_t *p_mux, sout_buffer_chain_t *c );
-static void GetPMT( sout_mux_t *p_mux, sout_buffer_chain_t *c );
+static void TSSend      ( sout_mux_t *p_mux, ts_packets_t *c );
+static void GetPAT( sout_mux_t *p_mux, ts_packets_t *c );
+static void GetPMT( sout_mux_t *p_mux, ts_packets_t *c );
 
-static block_t *TSNew( sout_mux_t *p_mux, sout_input_sys_t *p_stream, bool b_pcr );
-static void TSSetPCR( block_t *p_ts, mtime_t i_dts );
+static ts_packet_t *TSNew( ts_packets_t *c, sout_input_sys_t *p_stream, bool b_pcr );
+static void TSSetPCR( uint8_t *p_ts, mtime_t i_dts );
 
 static csa_t *csaSetup( vlc_object_t *p_this )
 {
@@ -735,6 +833,10 @@ static int Open( vlc_object_t *p_this )
 
     p_sys->b_use_key_frames = var_GetBool( p_mux, SOUT_CFG_PREFIX "use-key-frames" );
 
+    /* Output as many packets at once as an UDP datagram carries */
+    TSPacketsInit( &p_sys->packets,
+                   __MAX( var_InheritInteger( p_mux, "mtu" ) / 188, 1 ) );
+
     p_mux->p_sys        = p_sys;
 
     p_sys->csa = csaSetup(p_this);
@@ -773,6 +875,7 @@ static void Close( vlc_object_t * p_this )
         free( p_sys->sdt.desc[i].psz_provider );
     }
 
+    TSPacketsClean( &p_sys->packets );
     free( p_sys );
 }
 
@@ -1037,16 +1140,21 @@ static void DelStream( sout_mux_t *p_mux, sout_input_t *p_input )
     p_sys->i_pmt_version_number %= 32;
 }
 
-static void SetHeader( sout_buffer_chain_t *c,
+static void SetHeader( ts_packets_t *c,
                         int depth )
 {
-    block_t *p_ts = BufferChainPeek( c );
-    while( depth > 0 )
-    {
-        p_ts = p_ts->p_next;
-        depth--;
-    }
-    p_ts->i_flags |= BLOCK_FLAG_HEADER;
+    if( depth < c->i_depth )
+        c->p_packets[depth].i_flags |= BLOCK_FLAG_HEADER;
+}
+
+/* Whether the next TS packet of the stream starts a key frame */
+static bool TSKeyFrameNext( const sout_input_sys_t *p_stream )
+{
+    const block_t *p_pes = p_stream->state.chain_pes.p_first;
+
+    return p_stream->state.i_pes_used <= 0 &&
+           !(p_pes->i_flags & BLOCK_FLAG_NO_KEYFRAME) &&
+           (p_pes->i_flags & BLOCK_FLAG_TYPE_I);
 }
 
 static block_t *Pack_Opus(block_t *p_data)
@@ -1197,7 +1305,7 @@ static bool MuxStreams(sout_mux_t *p_mux )
     sout_mux_sys_t  *p_sys = p_mux->p_sys;
     sout_input_sys_t *p_pcr_stream = (sout_input_sys_t*)p_sys->p_pcr_input->p_sys;
 
-    sout_buffer_chain_t chain_ts;
+    ts_packets_t *p_packets = &p_sys->packets;
     mtime_t i_shaping_delay = p_pcr_stream->state.b_key_frame
         ? p_pcr_stream->state.i_pes_length
         : p_sys->i_shaping_delay;
@@ -1478,13 +1586,12 @@ static bool MuxStreams(sout_mux_t *p_mux )
     i_packet_count += (8 * i_pcr_length / p_sys->i_pcr_delay + 175) / 176;
 
     /* 3: mux PES into TS */
-    BufferChainInit( &chain_ts );
     /* append PAT/PMT  -> FIXME with big pcr delay it won't have enough pat/pmt */
     bool pat_was_previous = true; //This is to prevent unnecessary double PAT/PMT insertions
-    GetPAT( p_mux, &chain_ts );
-    GetPMT( p_mux, &chain_ts );
+    GetPAT( p_mux, p_packets );
+    GetPMT( p_mux, p_packets );
     int i_packet_pos = 0;
-    i_packet_count += chain_ts.i_depth;
+    i_packet_count += p_packets->i_depth;
     /* msg_Dbg( p_mux, "estimated pck=%d", i_packet_count ); */
 
     const mtime_t i_pcr_dts = p_pcr_stream->state.i_pes_dts;
@@ -1528,42 +1635,41 @@ static bool MuxStreams(sout_mux_t *p_mux )
                 i_pcr_length / i_packet_count;
         }
 
-        /* Build the TS packet */
-        block_t *p_ts = TSNew( p_mux, p_stream, b_pcr );
-        if( p_sys->csa != NULL &&
-             (p_input->p_fmt->i_cat != AUDIO_ES || p_sys->b_crypt_audio) &&
-             (p_input->p_fmt->i_cat != VIDEO_ES || p_sys->b_crypt_video) )
-        {
-            p_ts->i_flags |= BLOCK_FLAG_SCRAMBLED;
-        }
-        i_packet_pos++;
-
         /* Write PAT/PMT before every keyframe if use-key-frames is enabled,
          * this helps to do segmenting with livehttp-output so it can cut segment
          * and start new one with pat,pmt,keyframe*/
         if( ( p_sys->b_use_key_frames ) &&
             ( p_input->p_fmt->i_cat == VIDEO_ES ) &&
-            ( p_ts->i_flags & BLOCK_FLAG_TYPE_I ) )
+            TSKeyFrameNext( p_stream ) )
         {
             if( likely( !pat_was_previous ) )
             {
-                int startcount = chain_ts.i_depth;
-                GetPAT( p_mux, &chain_ts );
-                GetPMT( p_mux, &chain_ts );
-                SetHeader( &chain_ts, startcount );
-                i_packet_count += (chain_ts.i_depth - startcount );
+                int startcount = p_packets->i_depth;
+                GetPAT( p_mux, p_packets );
+                GetPMT( p_mux, p_packets );
+                SetHeader( p_packets, startcount );
+                i_packet_count += (p_packets->i_depth - startcount );
             } else {
-                SetHeader( &chain_ts, 0); //We just inserted pat/pmt,so just flag it instead of adding new one
+                SetHeader( p_packets, 0); //We just inserted pat/pmt,so just flag it instead of adding new one
             }
         }
         pat_was_previous = false;
 
-        /* */
-        BufferChainAppend( &chain_ts, p_ts );
+        /* Build the TS packet */
+        ts_packet_t *p_ts = TSNew( p_packets, p_stream, b_pcr );
+        if( p_ts != NULL && p_sys->csa != NULL &&
+             (p_input->p_fmt->i_cat != AUDIO_ES || p_sys->b_crypt_audio) &&
+             (p_input->p_fmt->i_cat != VIDEO_ES || p_sys->b_crypt_video) )
+        {
+            p_ts->i_flags |= BLOCK_FLAG_SCRAMBLED;
+        }
+        i_packet_pos++;
     }
 
     /* 4: date and send */
-    TSSchedule( p_mux, &chain_ts, i_pcr_length, i_pcr_dts );
+    TSSchedule( p_mux, p_packets->p_packets, p_packets->i_depth,
+                i_pcr_length, i_pcr_dts );
+    TSSend( p_mux, p_packets );
     return false;
 }
 
@@ -1695,14 +1801,11 @@ static block_t *Add_ADTS( block_t *p_data, const es_format_t *p_fmt )
     return p_new_block;
 }
 
-static void TSSchedule( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
+static void TSSchedule( sout_mux_t *p_mux, ts_packet_t *p_packets,
+                        int i_packet_count,
                         mtime_t i_pcr_length, mtime_t i_pcr_dts )
 {
     sout_mux_sys_t  *p_sys = p_mux->p_sys;
-    sout_buffer_chain_t new_chain;
-    int i_packet_count = p_chain_ts->i_depth;
-
-    BufferChainInit( &new_chain );
 
     if ( i_pcr_length <= 0 )
     {
@@ -1711,51 +1814,45 @@ static void TSSchedule( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
 
     for (int i = 0; i < i_packet_count; i++ )
     {
-        block_t *p_ts = BufferChainGet( p_chain_ts );
+        const ts_packet_t *p_ts = &p_packets[i];
         mtime_t i_new_dts = i_pcr_dts + i_pcr_length * i / i_packet_count;
 
-        BufferChainAppend( &new_chain, p_ts );
-
         if (!p_ts->i_dts || p_ts->i_dts + p_sys->i_dts_delay * 2/3 >= i_new_dts)
             continue;
 
         mtime_t i_max_diff = i_new_dts - p_ts->i_dts;
         mtime_t i_cut_dts = p_ts->i_dts;
 
-        p_ts = BufferChainPeek( p_chain_ts );
         i++;
         i_new_dts = i_pcr_dts + i_pcr_length * i / i_packet_count;
-        while ( p_ts != NULL && i_new_dts - p_ts->i_dts >= i_max_diff )
+        while ( i < i_packet_count &&
+                i_new_dts - p_packets[i].i_dts >= i_max_diff )
         {
-            p_ts = BufferChainGet( p_chain_ts );
-            i_max_diff = i_new_dts - p_ts->i_dts;
-            i_cut_dts = p_ts->i_dts;
-            BufferChainAppend( &new_chain, p_ts );
+            i_max_diff = i_new_dts - p_packets[i].i_dts;
+            i_cut_dts = p_packets[i].i_dts;
 
-            p_ts = BufferChainPeek( p_chain_ts );
             i++;
             i_new_dts = i_pcr_dts + i_pcr_length * i / i_packet_count;
         }
         msg_Dbg( p_mux, "adjusting rate at %"PRId64"/%"PRId64" (%d/%d)",
-                 i_cut_dts - i_pcr_dts, i_pcr_length, new_chain.i_depth,
-                 p_chain_ts->i_depth );
-        if ( new_chain.i_depth )
-            TSDate( p_mux, &new_chain, i_cut_dts - i_pcr_dts, i_pcr_dts );
-        if ( p_chain_ts->i_depth )
-            TSSchedule( p_mux, p_chain_ts, i_pcr_dts + i_pcr_length - i_cut_dts,
-                        i_cut_dts );
+                 i_cut_dts - i_pcr_dts, i_pcr_length, i,
+                 i_packet_count - i );
+        TSDate( p_mux, p_packets, i, i_cut_dts - i_pcr_dts, i_pcr_dts );
+        if ( i < i_packet_count )
+            TSSchedule( p_mux, &p_packets[i], i_packet_count - i,
+                        i_pcr_dts + i_pcr_length - i_cut_dts, i_cut_dts );
         return;
     }
 
-    if ( new_chain.i_depth )
-        TSDate( p_mux, &new_chain, i_pcr_length, i_pcr_dts );
+    if ( i_packet_count )
+        TSDate( p_mux, p_packets, i_packet_count, i_pcr_length, i_pcr_dts );
 }
 
-static void TSDate( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
+static void TSDate( sout_mux_t *p_mux, ts_packet_t *p_packets,
+                    int i_packet_count,
                     mtime_t i_pcr_length, mtime_t i_pcr_dts )
 {
     sout_mux_sys_t  *p_sys = p_mux->p_sys;
-    int i_packet_count = p_chain_ts->i_depth;
 
     if ( i_pcr_length / 1000 > 0 )
     {
@@ -1779,35 +1876,72 @@ static void TSDate( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
     /* msg_Dbg( p_mux, "real pck=%d", i_packet_count ); */
     for (int i = 0; i < i_packet_count; i++ )
     {
-        block_t *p_ts = BufferChainGet( p_chain_ts );
-        mtime_t i_new_dts = i_pcr_dts + i_pcr_length * i / i_packet_count;
+        p_packets[i].i_dts    = i_pcr_dts + i_pcr_length * i / i_packet_count;
+        p_packets[i].i_length = i_pcr_length / i_packet_count;
+    }
+}
 
-        p_ts->i_dts    = i_new_dts;
-        p_ts->i_length = i_pcr_length / i_packet_count;
+static void TSSend( sout_mux_t *p_mux, ts_packets_t *c )
+{
+    sout_mux_sys_t  *p_sys = p_mux->p_sys;
+    bool b_scrambled = false;
+
+    for (int i = 0; i < c->i_depth; i++ )
+    {
+        ts_packet_t *p_ts = &c->p_packets[i];
 
         if( p_ts->i_flags & BLOCK_FLAG_CLOCK )
         {
             /* msg_Dbg( p_mux, "pcr=%lld ms", p_ts->i_dts / 1000 ); */
-            TSSetPCR( p_ts, p_ts->i_dts - p_sys->first_dts );
+            TSSetPCR( p_ts->p_buffer, p_ts->i_dts - p_sys->first_dts );
         }
         if( p_ts->i_flags & BLOCK_FLAG_SCRAMBLED )
+            b_scrambled = true;
+    }
+
+    if( b_scrambled )
+    {
+        vlc_mutex_lock( &p_sys->csa_lock );
+        for (int i = 0; i < c->i_depth; i++ )
         {
-            vlc_mutex_lock( &p_sys->csa_lock );
-            csa_Encrypt( p_sys->csa, p_ts->p_buffer, p_sys->i_csa_pkt_size );
-            vlc_mutex_unlock( &p_sys->csa_lock );
+            ts_packet_t *p_ts = &c->p_packets[i];
+
+            if( p_ts->i_flags & BLOCK_FLAG_SCRAMBLED )
+                csa_Encrypt( p_sys->csa, p_ts->p_buffer,
+                             p_sys->i_csa_pkt_size );
         }
+        vlc_mutex_unlock( &p_sys->csa_lock );
+    }
 
-        /* latency */
-        p_ts->i_dts += p_sys->i_shaping_delay * 3 / 2;
+    /* Each block is dated and flagged as its first packet */
+    block_t *p_block = NULL;
+    for (int i = 0; i < c->i_depth; i++ )
+    {
+        ts_packet_t *p_ts = &c->p_packets[i];
 
-        sout_AccessOutWrite( p_mux->p_access, p_ts );
+        if( p_ts->p_block != NULL )
+        {
+            if( p_block != NULL )
+                sout_AccessOutWrite( p_mux->p_access, p_block );
+            p_block = p_ts->p_block;
+            p_block->i_flags = p_ts->i_flags & ~BLOCK_FLAG_SCRAMBLED;
+            /* latency */
+            p_block->i_dts = p_ts->i_dts + p_sys->i_shaping_delay * 3 / 2;
+            p_block->i_length = 0;
+        }
+        p_block->i_flags |= p_ts->i_flags & BLOCK_FLAG_CLOCK;
+        p_block->i_length += p_ts->i_length;
     }
+    if( p_block != NULL )
+        sout_AccessOutWrite( p_mux->p_access, p_block );
+
+    c->i_depth = 0;
+    c->p_block = NULL;
 }
 
-static block_t *TSNew( sout_mux_t *p_mux, sout_input_sys_t *p_stream,
-                       bool b_pcr )
+static ts_packet_t *TSNew( ts_packets_t *c, sout_input_sys_t *p_stream,
+                          bool b_pcr )
 {
-    VLC_UNUSED(p_mux);
     block_t *p_pes = p_stream->state.chain_pes.p_first;
 
     bool b_new_pes = false;
@@ -1827,9 +1961,20 @@ static block_t *TSNew( sout_mux_t *p_mux, sout_input_sys_t *p_stream,
         b_adaptation_field = true;
     }
 
-    block_t *p_ts = block_Alloc( 188 );
+    /* A key frame starts a new block, for the access outputs to cut on it */
+    bool b_key_frame = TSKeyFrameNext( p_stream );
+    ts_packet_t *p_ts = TSPacketNew( c, b_key_frame, false );
+    ts_packet_t dropped;
+
+    if( unlikely(p_ts == NULL) )
+    {   /* Still consume the payload, to keep the streams consistent */
+        dropped.p_block = NULL;
+        dropped.p_buffer = c->scratch;
+        dropped.i_flags = 0;
+        p_ts = &dropped;
+    }
 
-    if (b_new_pes && !(p_pes->i_flags & BLOCK_FLAG_NO_KEYFRAME) && p_pes->i_flags & BLOCK_FLAG_TYPE_I)
+    if( b_key_frame )
     {
         p_ts->i_flags |= BLOCK_FLAG_TYPE_I;
     }
@@ -1904,34 +2049,34 @@ static block_t *TSNew( sout_mux_t *p_mux, sout_input_sys_t *p_stream,
         p_stream->state.i_pes_used = 0;
     }
 
-    return p_ts;
+    return p_ts != &dropped ? p_ts : NULL;
 }
 
-static void TSSetPCR( block_t *p_ts, mtime_t i_dts )
+static void TSSetPCR( uint8_t *p_ts, mtime_t i_dts )
 {
     mtime_t i_pcr = 9 * i_dts / 100;
 
-    p_ts->p_buffer[6]  = ( i_pcr >> 25 )&0xff;
-    p_ts->p_buffer[7]  = ( i_pcr >> 17 )&0xff;
-    p_ts->p_buffer[8]  = ( i_pcr >> 9  )&0xff;
-    p_ts->p_buffer[9]  = ( i_pcr >> 1  )&0xff;
-    p_ts->p_buffer[10] = ( i_pcr << 7  )&0x80;
-    p_ts->p_buffer[10] |= 0x7e;
-    p_ts->p_buffer[11] = 0; /* we don't set PCR extension */
+    p_ts[6]  = ( i_pcr >> 25 )&0xff;
+    p_ts[7]  = ( i_pcr >> 17 )&0xff;
+    p_ts[8]  = ( i_pcr >> 9  )&0xff;
+    p_ts[9]  = ( i_pcr >> 1  )&0xff;
+    p_ts[10] = ( i_pcr << 7  )&0x80;
+    p_ts[10] |= 0x7e;
+    p_ts[11] = 0; /* we don't set PCR extension */
 }
 
-void GetPAT( sout_mux_t *p_mux, sout_buffer_chain_t *c )
+void GetPAT( sout_mux_t *p_mux, ts_packets_t *c )
 {
     sout_mux_sys_t       *p_sys = p_mux->p_sys;
 
     BuildPAT( p_sys->p_dvbpsi,
-              c, (PEStoTSCallback)BufferChainAppend,
+              c, TSPacketsAppendPSI,
               p_sys->i_tsid, p_sys->i_pat_version_number,
               &p_sys->pat,
               p_sys->i_num_pmt, p_sys->pmt, p_sys->i_pmt_program_number );
 }
 
-static void GetPMT( sout_mux_t *p_mux, sout_buffer_chain_t *c )
+static void GetPMT( sout_mux_t *p_mux, ts_packets_t *c )
 {
     sout_mux_sys_t *p_sys = p_mux->p_sys;
     pes_mapped_stream_t mappeds[p_mux->i_nb_inputs];
@@ -1953,7 +2098,7 @@ static void GetPMT( sout_mux_t *p_mux, sout_buffer_chain_t *c )
     }
 
     BuildPMT( p_sys->p_dvbpsi, VLC_OBJECT(p_mux), p_sys->standard,
-              c, (PEStoTSCallback)BufferChainAppend,
+              c, TSPacketsAppendPSI,
               p_sys->i_tsid, p_sys->i_pmt_version_number,
               ((sout_input_sys_t *)p_sys->p_pcr_input->p_sys)->ts.i_pid,
               &p_sys->sdt,
@@ -130,6 +130,7 @@ struct decoder_sys_t
 
     /* */
     cc_storage_t *p_ccs;
+    unsigned i_cc_unpolled; /* pictures output since the last GetCc */
 };
 
 #define BLOCK_FLAG_PRIVATE_AUD (1 << BLOCK_FLAG_PRIVATE_SHIFT)
@@ -151,6 +152,7 @@ static block_t *OutputPicture( decoder_t *p_dec );
 static void PutSPS( decoder_t *p_dec, block_t *p_frag );
 static void PutPPS( decoder_t *p_dec, block_t *p_frag );
 static bool ParseSliceHeader( decoder_t *p_dec, const block_t *p_frag, h264_slice_t *p_slice );
+static unsigned GetSeiMask( decoder_t * );
 static bool ParseSeiCallback( const hxxx_sei_data_t *, void * );
 
 
@@ -160,6 +162,12 @@ static const uint8_t p_h264_startcode[3] = { 0x00, 0x00, 0x01 };
  * Helpers
  *****************************************************************************/
 
+static bool IsSameNAL( const block_t *p_stored, const block_t *p_frag )
+{
+    return p_stored && p_stored->i_buffer == p_frag->i_buffer &&
+           !memcmp( p_stored->p_buffer, p_frag->p_buffer, p_frag->i_buffer );
+}
+
 static void StoreSPS( decoder_sys_t *p_sys, uint8_t i_id,
                       block_t *p_block, h264_sequence_parameter_set_t *p_sps )
 {
@@ -302,11 +310,15 @@ static int Open( vlc_object_t *p_this )
         free( p_dec->p_sys );
         return VLC_ENOMEM;
     }
+    p_sys->i_cc_unpolled = 0;
 
     packetizer_Init( &p_sys->packetizer,
-                     p_h264_startcode, sizeof(p_h264_startcode), startcode_FindAnnexB,
+                     p_h264_startcode, sizeof(p_h264_startcode),
+                     startcode_SelectAnnexB( VLC_OBJECT(p_dec) ),
                      p_h264_startcode, 1, 5,
                      PacketizeReset, PacketizeParse, PacketizeValidate, p_dec );
+    /* Slices are referenced from the input, only the AU gathering copies */
+    packetizer_EnableSharing( &p_sys->packetizer );
 
     p_sys->b_slice = false;
     p_sys->frame.p_head = NULL;
@@ -491,6 +503,7 @@ static block_t *PacketizeAVC1( decoder_t *p_dec, block_t **pp_block )
  *****************************************************************************/
 static block_t *GetCc( decoder_t *p_dec, decoder_cc_desc_t *p_desc )
 {
+    p_dec->p_sys->i_cc_unpolled = 0;
     return cc_storage_get_current( p_dec->p_sys->p_ccs, p_desc );
 }
 
@@ -604,7 +617,8 @@ static block_t *ParseNALBlock( decoder_t *p_dec, bool *pb_ts_used, block_t *p_fr
                         if( (p_sei->i_flags & BLOCK_FLAG_PRIVATE_SEI) == 0 )
                             continue;
                         HxxxParse_AnnexB_SEI( p_sei->p_buffer, p_sei->i_buffer,
-                                              1 /* nal header */, ParseSeiCallback, p_dec );
+                                              1 /* nal header */, GetSeiMask( p_dec ),
+                                              ParseSeiCallback, p_dec );
                     }
 
                     if( p_sys->b_slice )
@@ -986,6 +1000,8 @@ static block_t *OutputPicture( decoder_t *p_dec )
 
     /* CC */
     cc_storage_commit( p_sys->p_ccs, p_pic );
+    if( p_sys->i_cc_unpolled < 2 )
+        p_sys->i_cc_unpolled++;
 
     return p_pic;
 }
@@ -1003,6 +1019,16 @@ static void PutSPS( decoder_t *p_dec, block_t *p_frag )
         return;
     }
 
+    /* Repeated SPS, as on every IDR of broadcasts, are not decoded again */
+    for( int i = 0; i <= H264_SPS_ID_MAX; i++ )
+    {
+        if( IsSameNAL( p_sys->sps[i].p_block, p_frag ) )
+        {
+            block_Release( p_frag );
+            return;
+        }
+    }
+
     h264_sequence_parameter_set_t *p_sps = h264_decode_sps( p_buffer, i_buffer, true );
     if( !p_sps )
     {
@@ -1030,6 +1056,15 @@ static void PutPPS( decoder_t *p_dec, block_t *p_frag )
         return;
     }
 
+    for( int i = 0; i <= H264_PPS_ID_MAX; i++ )
+    {
+        if( IsSameNAL( p_sys->pps[i].p_block, p_frag ) )
+        {
+            block_Release( p_frag );
+            return;
+        }
+    }
+
     h264_picture_parameter_set_t *p_pps = h264_decode_pps( p_buffer, i_buffer, true );
     if( !p_pps )
     {
@@ -1082,6 +1117,28 @@ static bool ParseSliceHeader( decoder_t *p_dec, const block_t *p_frag, h264_slic
     return true;
 }
 
+/* Only the SEI payloads that have a use now are decoded */
+static unsigned GetSeiMask( decoder_t *p_dec )
+{
+    decoder_sys_t *p_sys = p_dec->p_sys;
+    const h264_sequence_parameter_set_t *p_sps = p_sys->p_active_sps;
+    unsigned i_mask = 0;
+
+    if( p_sps && p_sps->vui.b_valid &&
+        ( p_sps->vui.b_hrd_parameters_present_flag ||
+          p_sps->vui.b_pic_struct_present_flag ) )
+        i_mask |= HXXX_SEI_MASK_PIC_TIMING;
+    /* Nobody gets the CC, when not polled for the last pictures */
+    if( p_sys->i_cc_unpolled < 2 )
+        i_mask |= HXXX_SEI_MASK_USER_DATA_REGISTERED_ITU_T_T35;
+    if( !p_sys->b_recovered )
+        i_mask |= HXXX_SEI_MASK_RECOVERY_POINT;
+    if( p_dec->fmt_in.video.multiview_mode == MULTIVIEW_2D )
+        i_mask |= HXXX_SEI_MASK_FRAME_PACKING_ARRANGEMENT;
+
+    return i_mask;
+}
+
 static bool ParseSeiCallback( const hxxx_sei_data_t *p_sei_data, void *cbdata )
 {
     decoder_t *p_dec = (decoder_t *) cbdata;
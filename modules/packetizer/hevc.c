@@ -70,6 +70,7 @@ static void PacketizeReset(void *p_private, bool b_broken);
 static block_t *PacketizeParse(void *p_private, bool *pb_ts_used, block_t *);
 static block_t *ParseNALBlock(decoder_t *, bool *pb_ts_used, block_t *);
 static int PacketizeValidate(void *p_private, block_t *);
+static unsigned GetSEIMask( decoder_t * );
 static bool ParseSEICallback( const hxxx_sei_data_t *, void * );
 static block_t *GetCc( decoder_t *, decoder_cc_desc_t * );
 
@@ -88,6 +89,10 @@ struct decoder_sys_t
     hevc_video_parameter_set_t    *rgi_p_decvps[HEVC_VPS_ID_MAX + 1];
     hevc_sequence_parameter_set_t *rgi_p_decsps[HEVC_SPS_ID_MAX + 1];
     hevc_picture_parameter_set_t  *rgi_p_decpps[HEVC_PPS_ID_MAX + 1];
+    /* Hashes of the raw decoded sets, to skip the repeated ones */
+    uint64_t rgi_vps_hash[HEVC_VPS_ID_MAX + 1];
+    uint64_t rgi_sps_hash[HEVC_SPS_ID_MAX + 1];
+    uint64_t rgi_pps_hash[HEVC_PPS_ID_MAX + 1];
     const hevc_video_parameter_set_t    *p_active_vps;
     const hevc_sequence_parameter_set_t *p_active_sps;
     const hevc_picture_parameter_set_t  *p_active_pps;
@@ -100,6 +105,7 @@ struct decoder_sys_t
 
     /* */
     cc_storage_t *p_ccs;
+    unsigned i_cc_unpolled; /* pictures output since the last GetCc */
 };
 
 #define BLOCK_FLAG_DROP (1 << BLOCK_FLAG_PRIVATE_SHIFT)
@@ -182,9 +188,12 @@ static int Open(vlc_object_t *p_this)
     INITQ(post);
 
     packetizer_Init(&p_dec->p_sys->packetizer,
-                    p_hevc_startcode, sizeof(p_hevc_startcode), startcode_FindAnnexB,
+                    p_hevc_startcode, sizeof(p_hevc_startcode),
+                     startcode_SelectAnnexB( VLC_OBJECT(p_dec) ),
                     p_hevc_startcode, 1, 5,
                     PacketizeReset, PacketizeParse, PacketizeValidate, p_dec);
+    /* Slices are referenced from the input, only the AU gathering copies */
+    packetizer_EnableSharing(&p_dec->p_sys->packetizer);
 
     /* Copy properties */
     es_format_Copy(&p_dec->fmt_out, &p_dec->fmt_in);
@@ -306,6 +315,7 @@ static void PacketizeFlush( decoder_t *p_dec )
  *****************************************************************************/
 static block_t *GetCc( decoder_t *p_dec, decoder_cc_desc_t *p_desc )
 {
+    p_dec->p_sys->i_cc_unpolled = 0;
     return cc_storage_get_current( p_dec->p_sys->p_ccs, p_desc );
 }
 
@@ -328,30 +338,57 @@ static void PacketizeReset(void *p_private, bool b_broken)
     date_Set(&p_sys->dts, VLC_TS_INVALID);
 }
 
+/* FNV-1a */
+static uint64_t HashXPS(const uint8_t *p_buffer, size_t i_buffer)
+{
+    uint64_t i_hash = UINT64_C(0xcbf29ce484222325);
+    for(size_t i=0; i<i_buffer; i++)
+        i_hash = (i_hash ^ p_buffer[i]) * UINT64_C(0x100000001b3);
+    return i_hash ^ i_buffer;
+}
+
 static bool InsertXPS(decoder_t *p_dec, uint8_t i_nal_type, uint8_t i_id,
                       const block_t *p_nalb)
 {
     decoder_sys_t *p_sys = p_dec->p_sys;
     bool b_active = false;
+    bool b_decoded;
+    uint64_t *p_hash;
 
     switch(i_nal_type)
     {
         case HEVC_NAL_VPS:
             if(i_id > HEVC_VPS_ID_MAX)
                 return false;
+            b_decoded = p_sys->rgi_p_decvps[i_id] != NULL;
+            p_hash = &p_sys->rgi_vps_hash[i_id];
             break;
         case HEVC_NAL_SPS:
             if(i_id > HEVC_SPS_ID_MAX)
                 return false;
+            b_decoded = p_sys->rgi_p_decsps[i_id] != NULL;
+            p_hash = &p_sys->rgi_sps_hash[i_id];
             break;
         case HEVC_NAL_PPS:
             if(i_id > HEVC_PPS_ID_MAX)
                 return false;
+            b_decoded = p_sys->rgi_p_decpps[i_id] != NULL;
+            p_hash = &p_sys->rgi_pps_hash[i_id];
             break;
         default:
             return false;
     }
 
+    const uint8_t *p_buffer = p_nalb->p_buffer;
+    size_t i_buffer = p_nalb->i_buffer;
+    if( !hxxx_strip_AnnexB_startcode( &p_buffer, &i_buffer ) )
+        return false;
+
+    /* Repeated sets, as on every IRAP of broadcasts, are not decoded again */
+    const uint64_t i_hash = HashXPS(p_buffer, i_buffer);
+    if(b_decoded && *p_hash == i_hash)
+        return true;
+
     /* Free associated decoded version */
     if(i_nal_type == HEVC_NAL_SPS && p_sys->rgi_p_decsps[i_id])
     {
@@ -384,49 +421,43 @@ static bool InsertXPS(decoder_t *p_dec, uint8_t i_nal_type, uint8_t i_id,
         p_sys->rgi_p_decvps[i_id] = NULL;
     }
 
-    const uint8_t *p_buffer = p_nalb->p_buffer;
-    size_t i_buffer = p_nalb->i_buffer;
-    if( hxxx_strip_AnnexB_startcode( &p_buffer, &i_buffer ) )
+    /* Create decoded entries */
+    if(i_nal_type == HEVC_NAL_SPS)
     {
-        /* Create decoded entries */
-        if(i_nal_type == HEVC_NAL_SPS)
+        p_sys->rgi_p_decsps[i_id] = hevc_decode_sps(p_buffer, i_buffer, true);
+        if(!p_sys->rgi_p_decsps[i_id])
         {
-            p_sys->rgi_p_decsps[i_id] = hevc_decode_sps(p_buffer, i_buffer, true);
-            if(!p_sys->rgi_p_decsps[i_id])
-            {
-                msg_Err(p_dec, "Failed decoding SPS id %d", i_id);
-                return false;
-            }
-            if(b_active)
-                p_sys->p_active_sps = p_sys->rgi_p_decsps[i_id];
+            msg_Err(p_dec, "Failed decoding SPS id %d", i_id);
+            return false;
         }
-        else if(i_nal_type == HEVC_NAL_PPS)
+        if(b_active)
+            p_sys->p_active_sps = p_sys->rgi_p_decsps[i_id];
+    }
+    else if(i_nal_type == HEVC_NAL_PPS)
+    {
+        p_sys->rgi_p_decpps[i_id] = hevc_decode_pps(p_buffer, i_buffer, true);
+        if(!p_sys->rgi_p_decpps[i_id])
         {
-            p_sys->rgi_p_decpps[i_id] = hevc_decode_pps(p_buffer, i_buffer, true);
-            if(!p_sys->rgi_p_decpps[i_id])
-            {
-                msg_Err(p_dec, "Failed decoding PPS id %d", i_id);
-                return false;
-            }
-            if(b_active)
-                p_sys->p_active_pps = p_sys->rgi_p_decpps[i_id];
+            msg_Err(p_dec, "Failed decoding PPS id %d", i_id);
+            return false;
         }
-        else if(i_nal_type == HEVC_NAL_VPS)
+        if(b_active)
+            p_sys->p_active_pps = p_sys->rgi_p_decpps[i_id];
+    }
+    else if(i_nal_type == HEVC_NAL_VPS)
+    {
+        p_sys->rgi_p_decvps[i_id] = hevc_decode_vps(p_buffer, i_buffer, true);
+        if(!p_sys->rgi_p_decvps[i_id])
         {
-            p_sys->rgi_p_decvps[i_id] = hevc_decode_vps(p_buffer, i_buffer, true);
-            if(!p_sys->rgi_p_decvps[i_id])
-            {
-                msg_Err(p_dec, "Failed decoding VPS id %d", i_id);
-                return false;
-            }
-            if(b_active)
-                p_sys->p_active_vps = p_sys->rgi_p_decvps[i_id];
+            msg_Err(p_dec, "Failed decoding VPS id %d", i_id);
+            return false;
         }
-        return true;
-
+        if(b_active)
+            p_sys->p_active_vps = p_sys->rgi_p_decvps[i_id];
     }
 
-    return false;
+    *p_hash = i_hash;
+    return true;
 }
 
 static bool XPSReady(decoder_sys_t *p_sys)
@@ -534,7 +565,8 @@ static void ParseStoredSEI( decoder_t *p_dec )
         if( hevc_getNALType(&p_nal->p_buffer[4]) == HEVC_NAL_PREF_SEI )
         {
             HxxxParse_AnnexB_SEI( p_nal->p_buffer, p_nal->i_buffer,
-                                  2 /* nal header */, ParseSEICallback, p_dec );
+                                  2 /* nal header */, GetSEIMask(p_dec),
+                                  ParseSEICallback, p_dec );
         }
     }
 }
@@ -677,7 +709,8 @@ static block_t * ParseAUTail(decoder_t *p_dec, uint8_t i_nal_type, block_t *p_na
 
         case HEVC_NAL_SUFF_SEI:
             HxxxParse_AnnexB_SEI( p_nalb->p_buffer, p_nalb->i_buffer,
-                                  2 /* nal header */, ParseSEICallback, p_dec );
+                                  2 /* nal header */, GetSEIMask(p_dec),
+                                  ParseSEICallback, p_dec );
             break;
     }
 
@@ -821,7 +854,11 @@ static block_t *PacketizeParse(void *p_private, bool *pb_ts_used, block_t *p_blo
 
     p_block = ParseNALBlock( p_dec, pb_ts_used, p_block );
     if( p_block )
+    {
         cc_storage_commit( p_sys->p_ccs, p_block );
+        if( p_sys->i_cc_unpolled < 2 )
+            p_sys->i_cc_unpolled++;
+    }
 
     return p_block;
 }
@@ -833,6 +870,24 @@ static int PacketizeValidate( void *p_private, block_t *p_au )
     return VLC_SUCCESS;
 }
 
+/* Only the SEI payloads that have a use now are decoded */
+static unsigned GetSEIMask( decoder_t *p_dec )
+{
+    decoder_sys_t *p_sys = p_dec->p_sys;
+    unsigned i_mask = HXXX_SEI_MASK_MASTERING_DISPLAY_COLOUR_VOLUME |
+                      HXXX_SEI_MASK_CONTENT_LIGHT_LEVEL;
+
+    if( p_sys->p_active_sps )
+        i_mask |= HXXX_SEI_MASK_PIC_TIMING;
+    /* Nobody gets the CC, when not polled for the last pictures */
+    if( p_sys->i_cc_unpolled < 2 )
+        i_mask |= HXXX_SEI_MASK_USER_DATA_REGISTERED_ITU_T_T35;
+    if( p_dec->fmt_in.video.multiview_mode == MULTIVIEW_2D )
+        i_mask |= HXXX_SEI_MASK_FRAME_PACKING_ARRANGEMENT;
+
+    return i_mask;
+}
+
 static bool ParseSEICallback( const hxxx_sei_data_t *p_sei_data, void *cbdata )
 {
     decoder_t *p_dec = (decoder_t *) cbdata;
@@ -28,21 +28,44 @@
 #include "hxxx_sei.h"
 #include "hxxx_nal.h"
 
+static unsigned HxxxSEIMask(unsigned i_type)
+{
+    switch( i_type )
+    {
+        case HXXX_SEI_PIC_TIMING:
+            return HXXX_SEI_MASK_PIC_TIMING;
+        case HXXX_SEI_USER_DATA_REGISTERED_ITU_T_T35:
+            return HXXX_SEI_MASK_USER_DATA_REGISTERED_ITU_T_T35;
+        case HXXX_SEI_RECOVERY_POINT:
+            return HXXX_SEI_MASK_RECOVERY_POINT;
+        case HXXX_SEI_FRAME_PACKING_ARRANGEMENT:
+            return HXXX_SEI_MASK_FRAME_PACKING_ARRANGEMENT;
+        case HXXX_SEI_MASTERING_DISPLAY_COLOUR_VOLUME:
+            return HXXX_SEI_MASK_MASTERING_DISPLAY_COLOUR_VOLUME;
+        case HXXX_SEI_CONTENT_LIGHT_LEVEL:
+            return HXXX_SEI_MASK_CONTENT_LIGHT_LEVEL;
+        default:
+            return 0;
+    }
+}
+
 void HxxxParse_AnnexB_SEI(const uint8_t *p_buf, size_t i_buf,
-                          uint8_t i_header, pf_hxxx_sei_callback cb, void *cbdata)
+                          uint8_t i_header, unsigned i_mask,
+                          pf_hxxx_sei_callback cb, void *cbdata)
 {
-    if( hxxx_strip_AnnexB_startcode( &p_buf, &i_buf ) )
-        HxxxParseSEI(p_buf, i_buf, i_header, cb, cbdata);
+    if( i_mask && hxxx_strip_AnnexB_startcode( &p_buf, &i_buf ) )
+        HxxxParseSEI(p_buf, i_buf, i_header, i_mask, cb, cbdata);
 }
 
 void HxxxParseSEI(const uint8_t *p_buf, size_t i_buf,
-                  uint8_t i_header, pf_hxxx_sei_callback pf_callback, void *cbdata)
+                  uint8_t i_header, unsigned i_mask,
+                  pf_hxxx_sei_callback pf_callback, void *cbdata)
 {
     bs_t s;
     unsigned i_bitflow = 0;
     bool b_continue = true;
 
-    if( i_buf <= i_header )
+    if( i_buf <= i_header || i_mask == 0 )
         return;
 
     bs_init( &s, &p_buf[i_header], i_buf - i_header ); /* skip nal unit header */
@@ -80,7 +103,8 @@ void HxxxParseSEI(const uint8_t *p_buf, size_t i_buf,
 
         /* Save start offset */
         const unsigned i_start_bit_pos = bs_pos( &s );
-        switch( i_type )
+        /* Unrequested payloads go to the default case, and are only skipped */
+        switch( (HxxxSEIMask( i_type ) & i_mask) ? i_type : 0 )
         {
             /* Look for pic timing, do not decode locally */
             case HXXX_SEI_PIC_TIMING:
@@ -151,7 +175,7 @@ void HxxxParseSEI(const uint8_t *p_buf, size_t i_buf,
                     sei_data.frame_packing.b_frame0 = bs_read1( &s );
                 }
                 else sei_data.frame_packing.type = FRAME_PACKING_CANCEL;
-
+                b_continue = pf_callback( &sei_data, cbdata );
             } break;
 
             /* Look for SEI recovery point */
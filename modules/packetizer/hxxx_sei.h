@@ -31,6 +31,17 @@ enum hxxx_sei_type_e
     HXXX_SEI_CONTENT_LIGHT_LEVEL = 144,
 };
 
+/* Payloads to decode, the ones not in the mask are skipped unparsed */
+enum hxxx_sei_mask_e
+{
+    HXXX_SEI_MASK_PIC_TIMING                       = 1 << 0,
+    HXXX_SEI_MASK_USER_DATA_REGISTERED_ITU_T_T35   = 1 << 1,
+    HXXX_SEI_MASK_RECOVERY_POINT                   = 1 << 2,
+    HXXX_SEI_MASK_FRAME_PACKING_ARRANGEMENT        = 1 << 3,
+    HXXX_SEI_MASK_MASTERING_DISPLAY_COLOUR_VOLUME  = 1 << 4,
+    HXXX_SEI_MASK_CONTENT_LIGHT_LEVEL              = 1 << 5,
+};
+
 enum hxxx_sei_t35_type_e
 {
     HXXX_ITU_T35_TYPE_CC,
@@ -93,7 +104,7 @@ typedef struct
 } hxxx_sei_data_t;
 
 typedef bool (*pf_hxxx_sei_callback)(const hxxx_sei_data_t *, void *);
-void HxxxParseSEI(const uint8_t *, size_t, uint8_t, pf_hxxx_sei_callback, void *);
-void HxxxParse_AnnexB_SEI(const uint8_t *, size_t, uint8_t, pf_hxxx_sei_callback, void *);
+void HxxxParseSEI(const uint8_t *, size_t, uint8_t, unsigned, pf_hxxx_sei_callback, void *);
+void HxxxParse_AnnexB_SEI(const uint8_t *, size_t, uint8_t, unsigned, pf_hxxx_sei_callback, void *);
 
 #endif
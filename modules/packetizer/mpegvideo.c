@@ -208,7 +208,8 @@ static int Open( vlc_object_t *p_this )
 
     /* Misc init */
     packetizer_Init( &p_sys->packetizer,
-                     p_mp2v_startcode, sizeof(p_mp2v_startcode), startcode_FindAnnexB,
+                     p_mp2v_startcode, sizeof(p_mp2v_startcode),
+                     startcode_SelectAnnexB( VLC_OBJECT(p_dec) ),
                      NULL, 0, 4,
                      PacketizeReset, PacketizeParse, PacketizeValidate, p_dec );
 
@@ -24,6 +24,7 @@
 #ifndef VLC_PACKETIZER_HELPER_H_
 #define VLC_PACKETIZER_HELPER_H_
 
+#include <assert.h>
 #include <vlc_block.h>
 
 enum
@@ -55,6 +56,8 @@ typedef struct
 
     unsigned i_au_min_size;
 
+    size_t i_share_min_size;
+
     void *p_private;
     packetizer_reset_t    pf_reset;
     packetizer_parse_t    pf_parse;
@@ -79,6 +82,7 @@ static inline void packetizer_Init( packetizer_t *p_pack,
     p_pack->i_au_prepend = i_au_prepend;
     p_pack->p_au_prepend = p_au_prepend;
     p_pack->i_au_min_size = i_au_min_size;
+    p_pack->i_share_min_size = SIZE_MAX;
 
     p_pack->i_startcode = i_startcode;
     p_pack->p_startcode = p_startcode;
@@ -89,6 +93,23 @@ static inline void packetizer_Init( packetizer_t *p_pack,
     p_pack->p_private = p_private;
 }
 
+/* Fragments smaller than that are still copied, so that the parameter sets
+ * and SEI kept by the packetizers do not hold whole input blocks */
+#define PACKETIZER_SHARE_MIN_SIZE 4096
+
+/**
+ * Makes the packetizer output the large fragments as views of the input
+ * blocks, rather than copies, when they do not straddle two blocks.
+ *
+ * The views do not overlap, but the parse callback must not write past the
+ * fragment boundaries. It must be called before any data is packetized.
+ */
+static inline void packetizer_EnableSharing( packetizer_t *p_pack )
+{
+    assert( p_pack->bytestream.p_chain == NULL );
+    p_pack->i_share_min_size = PACKETIZER_SHARE_MIN_SIZE;
+}
+
 static inline void packetizer_Clean( packetizer_t *p_pack )
 {
     block_BytestreamRelease( &p_pack->bytestream );
@@ -102,6 +123,35 @@ static inline void packetizer_Flush( packetizer_t *p_pack )
     p_pack->pf_reset( p_pack->p_private, true );
 }
 
+/* Gets the next fragment as a view of the current bytestream block, when it
+ * lies within that block and is already preceded by the prepended bytes */
+static inline block_t *packetizer_ShareFragment( packetizer_t *p_pack )
+{
+    block_bytestream_t *p_bs = &p_pack->bytestream;
+    block_t *p_block = p_bs->p_block;
+    const size_t i_prepend = p_pack->i_au_prepend;
+
+    if( p_pack->i_offset < p_pack->i_share_min_size ||
+        p_block->i_buffer - p_bs->i_block_offset < p_pack->i_offset ||
+        p_bs->i_block_offset < i_prepend ||
+        memcmp( &p_block->p_buffer[p_bs->i_block_offset - i_prepend],
+                p_pack->p_au_prepend, i_prepend ) )
+        return NULL;
+
+    block_t *p_pic = block_Share( p_block );
+    if( p_pic == NULL )
+        return NULL;
+
+    p_pic->p_buffer += p_bs->i_block_offset - i_prepend;
+    p_pic->i_buffer = p_pack->i_offset + i_prepend;
+    p_pic->i_flags = 0;
+    p_pic->i_nb_samples = 0;
+    p_pic->i_length = 0;
+
+    block_SkipBytes( p_bs, p_pack->i_offset );
+    return p_pic;
+}
+
 static inline block_t *packetizer_Packetize( packetizer_t *p_pack, block_t **pp_block )
 {
     block_t *p_block = ( pp_block ) ? *pp_block : NULL;
@@ -127,6 +177,15 @@ static inline block_t *packetizer_Packetize( packetizer_t *p_pack, block_t **pp_
         }
     }
 
+    if( p_block && p_pack->i_share_min_size != SIZE_MAX )
+    {
+        p_block = block_Shareable( p_block );
+        if( pp_block )
+            *pp_block = p_block;
+        if( p_block == NULL )
+            return NULL;
+    }
+
     if( p_block )
         block_BytestreamPush( &p_pack->bytestream, p_block );
 
@@ -181,14 +240,18 @@ static inline block_t *packetizer_Packetize( packetizer_t *p_pack, block_t **pp_
             /* Get the new fragment and set the pts/dts */
             block_t *p_block_bytestream = p_pack->bytestream.p_block;
 
-            p_pic = block_Alloc( p_pack->i_offset + p_pack->i_au_prepend );
-            p_pic->i_pts = p_block_bytestream->i_pts;
-            p_pic->i_dts = p_block_bytestream->i_dts;
-
-            block_GetBytes( &p_pack->bytestream, &p_pic->p_buffer[p_pack->i_au_prepend],
-                            p_pic->i_buffer - p_pack->i_au_prepend );
-            if( p_pack->i_au_prepend > 0 )
-                memcpy( p_pic->p_buffer, p_pack->p_au_prepend, p_pack->i_au_prepend );
+            p_pic = packetizer_ShareFragment( p_pack );
+            if( p_pic == NULL )
+            {
+                p_pic = block_Alloc( p_pack->i_offset + p_pack->i_au_prepend );
+                p_pic->i_pts = p_block_bytestream->i_pts;
+                p_pic->i_dts = p_block_bytestream->i_dts;
+
+                block_GetBytes( &p_pack->bytestream, &p_pic->p_buffer[p_pack->i_au_prepend],
+                                p_pic->i_buffer - p_pack->i_au_prepend );
+                if( p_pack->i_au_prepend > 0 )
+                    memcpy( p_pic->p_buffer, p_pack->p_au_prepend, p_pack->i_au_prepend );
+            }
 
             p_pack->i_offset = 0;
 
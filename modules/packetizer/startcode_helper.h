@@ -21,10 +21,17 @@
 #define VLC_STARTCODE_HELPER_H_
 
 #include <vlc_cpu.h>
+#include <vlc_kernel.h>
 
 #if !defined(CAN_COMPILE_SSE2) && defined(HAVE_SSE2_INTRINSICS)
    #include <emmintrin.h>
 #endif
+#if defined(HAVE_AVX2_INTRINSICS)
+   #include <immintrin.h>
+#endif
+#if defined(__ARM_NEON)
+   #include <arm_neon.h>
+#endif
 
 /* Looks up efficiently for an AnnexB startcode 0x00 0x00 0x01
  * by using a 4 times faster trick than single byte lookup. */
@@ -109,16 +116,76 @@ static inline const uint8_t * startcode_FindAnnexB_SSE2( const uint8_t *p, const
 
 #endif
 
+/* The vector scanners compare each position with the 3 bytes of the
+ * startcode at once, using 3 loads shifted by one byte: they hit the same
+ * cache lines, and there is no scalar check on streams with many zeros.
+ * As the other scanners, they only return startcodes followed by data. */
+
+#if defined(HAVE_AVX2_INTRINSICS)
+
+VLC_AVX2
+static inline const uint8_t * startcode_FindAnnexB_AVX2( const uint8_t *p, const uint8_t *end )
+{
+    const __m256i zeros = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi8( 0x01 );
+
+    for( ; end - p >= 32 + 3; p += 32 )
+    {
+        __m256i v0 = _mm256_loadu_si256( (const __m256i *)p );
+        __m256i v1 = _mm256_loadu_si256( (const __m256i *)(p + 1) );
+        __m256i v2 = _mm256_loadu_si256( (const __m256i *)(p + 2) );
+        __m256i res = _mm256_and_si256(
+                        _mm256_and_si256( _mm256_cmpeq_epi8( v0, zeros ),
+                                          _mm256_cmpeq_epi8( v1, zeros ) ),
+                        _mm256_cmpeq_epi8( v2, ones ) );
+        uint32_t match = _mm256_movemask_epi8( res );
+        if( match )
+            return p + ctz( match );
+    }
+
+    for (end -= 3; p < end; p++) {
+        if (p[0] == 0 && p[1] == 0 && p[2] == 1)
+            return p;
+    }
+
+    return NULL;
+}
+
+#endif
+
+#if defined(__ARM_NEON)
+
+static inline const uint8_t * startcode_FindAnnexB_NEON( const uint8_t *p, const uint8_t *end )
+{
+    const uint8x16_t zeros = vdupq_n_u8( 0x00 );
+    const uint8x16_t ones = vdupq_n_u8( 0x01 );
+
+    for( ; end - p >= 16 + 3; p += 16 )
+    {
+        uint8x16_t res = vandq_u8( vandq_u8( vceqq_u8( vld1q_u8( p ), zeros ),
+                                             vceqq_u8( vld1q_u8( p + 1 ), zeros ) ),
+                                   vceqq_u8( vld1q_u8( p + 2 ), ones ) );
+        uint64x2_t match = vreinterpretq_u64_u8( res );
+        if( vgetq_lane_u64( match, 0 ) | vgetq_lane_u64( match, 1 ) )
+            break; /* the first match is in these 16 bytes */
+    }
+
+    for (end -= 3; p < end; p++) {
+        if (p[0] == 0 && p[1] == 0 && p[2] == 1)
+            return p;
+    }
+
+    return NULL;
+}
+
+#endif
+
 /* That code is adapted from libav's ff_avc_find_startcode_internal
  * and i believe the trick originated from
  * https://graphics.stanford.edu/~seander/bithacks.html#ZeroInWord
  */
-static inline const uint8_t * startcode_FindAnnexB( const uint8_t *p, const uint8_t *end )
+static inline const uint8_t * startcode_FindAnnexB_C( const uint8_t *p, const uint8_t *end )
 {
-#if defined(CAN_COMPILE_SSE2) || defined(HAVE_SSE2_INTRINSICS)
-    if (vlc_CPU_SSE2())
-        return startcode_FindAnnexB_SSE2(p, end);
-#endif
     const uint8_t *a = p + 4 - ((intptr_t)p & 3);
 
     for (end -= 3; p < a && p < end; p++) {
@@ -143,6 +210,88 @@ static inline const uint8_t * startcode_FindAnnexB( const uint8_t *p, const uint
     return NULL;
 }
 
+/* Looks up the first AnnexB startcode with the fastest scanner for the CPU */
+static inline const uint8_t * startcode_FindAnnexB( const uint8_t *p, const uint8_t *end )
+{
+#if defined(HAVE_AVX2_INTRINSICS)
+    if (vlc_CPU_AVX2())
+        return startcode_FindAnnexB_AVX2(p, end);
+#endif
+#if defined(CAN_COMPILE_SSE2) || defined(HAVE_SSE2_INTRINSICS)
+    if (vlc_CPU_SSE2())
+        return startcode_FindAnnexB_SSE2(p, end);
+#endif
+#if defined(__ARM_NEON)
+    return startcode_FindAnnexB_NEON(p, end);
+#else
+    return startcode_FindAnnexB_C(p, end);
+#endif
+}
+
+/* Workload of the scanner measurements: PES sized NALs of random data */
+#define STARTCODE_BENCH_SIZE (1 << 18)
+#define STARTCODE_BENCH_NAL  4096
+
+typedef const uint8_t * (*startcode_finder_t)( const uint8_t *, const uint8_t * );
+
+struct startcode_bench
+{
+    uint8_t *p_buf;
+};
+
+static inline mtime_t startcode_BenchAnnexB( vlc_kernel_func_t func, void *opaque )
+{
+    struct startcode_bench *bench = opaque;
+    startcode_finder_t pf_find = (startcode_finder_t) func;
+
+    if( bench->p_buf == NULL )
+    {
+        bench->p_buf = malloc( STARTCODE_BENCH_SIZE );
+        if( bench->p_buf == NULL )
+            return INT64_MAX;
+        /* Non zero bytes, as emulation prevention leaves few zero pairs */
+        for( size_t i = 0; i < STARTCODE_BENCH_SIZE; i++ )
+            bench->p_buf[i] = 1 + (i * 131 + (i >> 7)) % 255;
+        for( size_t i = 0; i + 4 < STARTCODE_BENCH_SIZE; i += STARTCODE_BENCH_NAL )
+            memcpy( &bench->p_buf[i], "\x00\x00\x01\x65", 4 );
+    }
+
+    const uint8_t *p = bench->p_buf, *end = p + STARTCODE_BENCH_SIZE;
+    mtime_t start = mdate();
+    while( p != NULL && p < end )
+    {
+        p = pf_find( p, end );
+        if( p != NULL )
+            p += 3;
+    }
+    return mdate() - start;
+}
+
+/* Selects the AnnexB startcode scanner of a packetizer:
+ * the most specialized one, or the measured fastest one with autotuning */
+static inline startcode_finder_t startcode_SelectAnnexB( vlc_object_t *p_obj )
+{
+    const vlc_kernel_impl_t impls[] = {
+        { "c", (vlc_kernel_func_t) startcode_FindAnnexB_C, 0 },
+#if defined(CAN_COMPILE_SSE2) || defined(HAVE_SSE2_INTRINSICS)
+        { "sse2", (vlc_kernel_func_t) startcode_FindAnnexB_SSE2, VLC_CPU_SSE2 },
+#endif
+#if defined(HAVE_AVX2_INTRINSICS)
+        { "avx2", (vlc_kernel_func_t) startcode_FindAnnexB_AVX2, VLC_CPU_AVX2 },
+#endif
+#if defined(__ARM_NEON)
+        { "neon", (vlc_kernel_func_t) startcode_FindAnnexB_NEON, 0 },
+#endif
+    };
+    struct startcode_bench bench = { NULL };
+
+    startcode_finder_t pf_find = (startcode_finder_t)
+        vlc_kernel_Select( p_obj, "startcode-annexb", impls, ARRAY_SIZE(impls),
+                           startcode_BenchAnnexB, &bench );
+    free( bench.p_buf );
+    return pf_find;
+}
+
 /* Special variation to return on prefix only and no data */
 static inline const uint8_t * startcode_FindAnyAnnexB( const uint8_t *p, const uint8_t *end )
 {
@@ -157,7 +157,8 @@ static int Open( vlc_object_t *p_this )
         return VLC_ENOMEM;
 
     packetizer_Init( &p_sys->packetizer,
-                     p_vc1_startcode, sizeof(p_vc1_startcode), startcode_FindAnnexB,
+                     p_vc1_startcode, sizeof(p_vc1_startcode),
+                     startcode_SelectAnnexB( VLC_OBJECT(p_dec) ),
                      NULL, 0, 4,
                      PacketizeReset, PacketizeParse, PacketizeValidate, p_dec );
 
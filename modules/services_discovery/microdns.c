@@ -87,13 +87,33 @@ static const struct
 };
 #define NB_PROTOCOLS (sizeof(protocols) / sizeof(*protocols))
 
-struct discovery_sys
+/* One listener per libvlc instance is shared by all the services and
+ * renderer discoveries: it queries all the protocols at once, and keeps the
+ * answers so that new discoveries get them without waiting. */
+struct mdns_service
 {
+    libvlc_int_t *      p_libvlc;
+    unsigned            i_refs;
     vlc_thread_t        thread;
     atomic_bool         stop;
     struct mdns_ctx *   p_microdns;
     const char *        ppsz_service_names[NB_PROTOCOLS];
-    unsigned int        i_nb_service_names;
+
+    vlc_mutex_t         lock;
+    vlc_array_t         entries; /* struct entry, the cached answers */
+    vlc_array_t         clients; /* struct discovery_sys */
+
+    struct mdns_service *p_next;
+};
+
+static vlc_mutex_t services_lock = VLC_STATIC_MUTEX;
+static struct mdns_service *services = NULL;
+
+struct discovery_sys
+{
+    struct mdns_service *p_service;
+    vlc_object_t *      p_obj;
+    bool                b_renderer;
     vlc_array_t         items;
 };
 
@@ -107,20 +127,32 @@ struct vlc_renderer_discovery_sys
     struct discovery_sys s;
 };
 
+/* A discovered server, valid until its TTL expires */
+struct entry
+{
+    char *              psz_uri;
+    char *              psz_device_name;
+    char *              psz_icon_uri;
+    unsigned            i_protocol;
+    int                 i_renderer_flags;
+    mtime_t             i_expiry;
+};
+
+/* An item published by one discovery, for one entry */
 struct item
 {
     char *              psz_uri;
     input_item_t *      p_input_item;
     vlc_renderer_item_t*p_renderer_item;
-    mtime_t             i_last_seen;
 };
 
 struct srv
 {
-    const char *psz_protocol;
+    unsigned    i_protocol;
     char *      psz_device_name;
     uint16_t    i_port;
     int         i_renderer_flags;
+    uint32_t    i_ttl;
 };
 
 static const char *const ppsz_options[] = {
@@ -150,6 +182,15 @@ strrcmp(const char *s1, const char *s2)
     return strncmp(s1 + m - n, s2, n);
 }
 
+static int
+get_protocol( const char *psz_name )
+{
+    for( unsigned i = 0; i < NB_PROTOCOLS; ++i )
+        if( !strrcmp( psz_name, protocols[i].psz_service_name ) )
+            return i;
+    return -1;
+}
+
 static int
 items_add_input( struct discovery_sys *p_sys, services_discovery_t *p_sd,
                  char *psz_uri, const char *psz_name )
@@ -173,7 +214,6 @@ items_add_input( struct discovery_sys *p_sys, services_discovery_t *p_sd,
     p_item->psz_uri = psz_uri;
     p_item->p_input_item = p_input_item;
     p_item->p_renderer_item = NULL;
-    p_item->i_last_seen = mdate();
     vlc_array_append_or_abort( &p_sys->items, p_item );
     services_discovery_AddItem( p_sd, p_input_item );
 
@@ -188,7 +228,10 @@ items_add_renderer( struct discovery_sys *p_sys, vlc_renderer_discovery_t *p_rd,
 {
     struct item *p_item = malloc( sizeof(struct item) );
     if( p_item == NULL )
+    {
+        free( psz_uri );
         return VLC_ENOMEM;
+    }
 
     const char *psz_extra_uri = i_flags & VLC_RENDERER_CAN_VIDEO ? NULL : "video=0";
 
@@ -205,7 +248,6 @@ items_add_renderer( struct discovery_sys *p_sys, vlc_renderer_discovery_t *p_rd,
     p_item->psz_uri = psz_uri;
     p_item->p_input_item = NULL;
     p_item->p_renderer_item = p_renderer_item;
-    p_item->i_last_seen = mdate();
     vlc_array_append_or_abort( &p_sys->items, p_item );
     vlc_rd_add_item( p_rd, p_renderer_item );
 
@@ -230,57 +272,181 @@ items_release( struct discovery_sys *p_sys, struct item *p_item )
     free( p_item );
 }
 
-static bool
-items_exists( struct discovery_sys *p_sys, const char *psz_uri )
+static void
+items_clear( struct discovery_sys *p_sys )
 {
     for( size_t i = 0; i < vlc_array_count( &p_sys->items ); ++i )
     {
         struct item *p_item = vlc_array_item_at_index( &p_sys->items, i );
-        if( strcmp( p_item->psz_uri, psz_uri ) == 0 )
-        {
-            p_item->i_last_seen = mdate();
-            return true;
-        }
+        items_release( p_sys, p_item );
     }
-    return false;
+    vlc_array_clear( &p_sys->items );
 }
 
+/* Publishes an entry to a discovery, if it handles its protocol */
 static void
-items_timeout( struct discovery_sys *p_sys, services_discovery_t *p_sd,
-               vlc_renderer_discovery_t *p_rd )
+client_add_entry( struct discovery_sys *p_sys, const struct entry *p_entry )
 {
-    assert( p_rd != NULL || p_sd != NULL );
-    mtime_t i_now = mdate();
+    if( protocols[p_entry->i_protocol].b_renderer != p_sys->b_renderer )
+        return;
 
-    /* Remove items that are not seen since TIMEOUT */
+    char *psz_uri = strdup( p_entry->psz_uri );
+    if( psz_uri == NULL )
+        return;
+
+    if( p_sys->b_renderer )
+    {
+        const char *psz_demux_filter =
+            strcmp( protocols[p_entry->i_protocol].psz_protocol,
+                    "chromecast" ) == 0 ? "cc_demux" : NULL;
+
+        items_add_renderer( p_sys, (vlc_renderer_discovery_t *)p_sys->p_obj,
+                            p_entry->psz_device_name, psz_uri,
+                            psz_demux_filter, p_entry->psz_icon_uri,
+                            p_entry->i_renderer_flags );
+    }
+    else
+        items_add_input( p_sys, (services_discovery_t *)p_sys->p_obj,
+                         psz_uri, p_entry->psz_device_name );
+}
+
+static void
+client_remove_entry( struct discovery_sys *p_sys, const struct entry *p_entry )
+{
     for( size_t i = 0; i < vlc_array_count( &p_sys->items ); ++i )
     {
         struct item *p_item = vlc_array_item_at_index( &p_sys->items, i );
-        if( i_now - p_item->i_last_seen > TIMEOUT )
+        if( strcmp( p_item->psz_uri, p_entry->psz_uri ) == 0 )
         {
-            if( p_sd != NULL )
-                services_discovery_RemoveItem( p_sd, p_item->p_input_item );
+            if( p_item->p_input_item != NULL )
+                services_discovery_RemoveItem(
+                    (services_discovery_t *)p_sys->p_obj, p_item->p_input_item );
             else
-                vlc_rd_remove_item( p_rd, p_item->p_renderer_item );
+                vlc_rd_remove_item( (vlc_renderer_discovery_t *)p_sys->p_obj,
+                                    p_item->p_renderer_item );
             items_release( p_sys, p_item );
-            vlc_array_remove( &p_sys->items, i-- );
+            vlc_array_remove( &p_sys->items, i );
+            return;
         }
     }
 }
 
 static void
-items_clear( struct discovery_sys *p_sys )
+entries_release( struct entry *p_entry )
 {
-    for( size_t i = 0; i < vlc_array_count( &p_sys->items ); ++i )
+    free( p_entry->psz_uri );
+    free( p_entry->psz_device_name );
+    free( p_entry->psz_icon_uri );
+    free( p_entry );
+}
+
+/* Entries are valid for their TTL, but at least until the next query was
+ * answered, so that one lost answer does not remove them */
+static mtime_t
+entries_expiry( uint32_t i_ttl )
+{
+    mtime_t i_lifetime = i_ttl * CLOCK_FREQ;
+    return mdate() + __MAX( i_lifetime, TIMEOUT );
+}
+
+static void
+entries_remove( struct mdns_service *p_service, size_t i_idx )
+{
+    struct entry *p_entry = vlc_array_item_at_index( &p_service->entries, i_idx );
+
+    for( size_t i = 0; i < vlc_array_count( &p_service->clients ); ++i )
+        client_remove_entry( vlc_array_item_at_index( &p_service->clients, i ),
+                             p_entry );
+    vlc_array_remove( &p_service->entries, i_idx );
+    entries_release( p_entry );
+}
+
+/* Takes ownership of the URI */
+static void
+entries_update( struct mdns_service *p_service, const struct srv *p_srv,
+                char *psz_uri, const char *psz_icon_uri )
+{
+    for( size_t i = 0; i < vlc_array_count( &p_service->entries ); ++i )
     {
-        struct item *p_item = vlc_array_item_at_index( &p_sys->items, i );
-        items_release( p_sys, p_item );
+        struct entry *p_entry = vlc_array_item_at_index( &p_service->entries, i );
+        if( strcmp( p_entry->psz_uri, psz_uri ) == 0 )
+        {
+            /* Already published, only its lifetime changes */
+            p_entry->i_expiry = entries_expiry( p_srv->i_ttl );
+            free( psz_uri );
+            return;
+        }
+    }
+
+    struct entry *p_entry = malloc( sizeof(*p_entry) );
+    if( p_entry == NULL )
+    {
+        free( psz_uri );
+        return;
+    }
+    p_entry->psz_uri = psz_uri;
+    p_entry->psz_device_name = strdup( p_srv->psz_device_name );
+    p_entry->psz_icon_uri = psz_icon_uri ? strdup( psz_icon_uri ) : NULL;
+    p_entry->i_protocol = p_srv->i_protocol;
+    p_entry->i_renderer_flags = p_srv->i_renderer_flags;
+    p_entry->i_expiry = entries_expiry( p_srv->i_ttl );
+    if( p_entry->psz_device_name == NULL
+     || ( psz_icon_uri != NULL && p_entry->psz_icon_uri == NULL ) )
+    {
+        entries_release( p_entry );
+        return;
+    }
+
+    vlc_array_append_or_abort( &p_service->entries, p_entry );
+    for( size_t i = 0; i < vlc_array_count( &p_service->clients ); ++i )
+        client_add_entry( vlc_array_item_at_index( &p_service->clients, i ),
+                          p_entry );
+}
+
+/* A SRV record with a null TTL announces that the server goes away */
+static void
+entries_goodbye( struct mdns_service *p_service,
+                 const struct rr_entry *p_entries )
+{
+    for( const struct rr_entry *p_rr = p_entries; p_rr != NULL;
+         p_rr = p_rr->next )
+    {
+        if( p_rr->type != RR_SRV || p_rr->ttl != 0 )
+            continue;
+
+        int i_protocol = get_protocol( p_rr->name );
+        if( i_protocol < 0 )
+            continue;
+
+        size_t i_len = strlen( p_rr->name )
+                     - strlen( protocols[i_protocol].psz_service_name ) - 1;
+        for( size_t i = 0; i < vlc_array_count( &p_service->entries ); ++i )
+        {
+            struct entry *p_entry =
+                vlc_array_item_at_index( &p_service->entries, i );
+            if( p_entry->i_protocol == (unsigned)i_protocol
+             && strlen( p_entry->psz_device_name ) == i_len
+             && strncmp( p_entry->psz_device_name, p_rr->name, i_len ) == 0 )
+                entries_remove( p_service, i-- );
+        }
+    }
+}
+
+static void
+entries_timeout( struct mdns_service *p_service )
+{
+    mtime_t i_now = mdate();
+
+    for( size_t i = 0; i < vlc_array_count( &p_service->entries ); ++i )
+    {
+        struct entry *p_entry = vlc_array_item_at_index( &p_service->entries, i );
+        if( i_now > p_entry->i_expiry )
+            entries_remove( p_service, i-- );
     }
-    vlc_array_clear( &p_sys->items );
 }
 
 static int
-parse_entries( const struct rr_entry *p_entries, bool b_renderer,
+parse_entries( const struct rr_entry *p_entries,
                struct srv **pp_srvs, unsigned int *p_nb_srv,
                const char **ppsz_ip, bool *p_ipv6 )
 {
@@ -289,7 +455,7 @@ parse_entries( const struct rr_entry *p_entries, bool b_renderer,
     for( const struct rr_entry *p_entry = p_entries;
          p_entry != NULL; p_entry = p_entry->next )
     {
-        if( p_entry->type == RR_SRV )
+        if( p_entry->type == RR_SRV && p_entry->ttl != 0 )
             i_nb_srv++;
     }
     if( i_nb_srv == 0 )
@@ -305,26 +471,23 @@ parse_entries( const struct rr_entry *p_entries, bool b_renderer,
     for( const struct rr_entry *p_entry = p_entries;
          p_entry != NULL; p_entry = p_entry->next )
     {
-        if( p_entry->type == RR_SRV )
+        if( p_entry->type == RR_SRV && p_entry->ttl != 0 )
         {
-            for( unsigned i = 0; i < NB_PROTOCOLS; ++i )
+            int i = get_protocol( p_entry->name );
+            if( i >= 0 )
             {
-                if( !strrcmp( p_entry->name, protocols[i].psz_service_name ) &&
-                    protocols[i].b_renderer == b_renderer )
-                {
-                    struct srv *p_srv = &p_srvs[i_nb_srv];
-
-                    p_srv->psz_device_name =
-                        strndup( p_entry->name, strlen( p_entry->name )
-                                 - strlen( protocols[i].psz_service_name ) - 1);
-                    if( p_srv->psz_device_name == NULL )
-                        break;
-                    p_srv->psz_protocol = protocols[i].psz_protocol;
-                    p_srv->i_port = p_entry->data.SRV.port;
-                    p_srv->i_renderer_flags = protocols[i].i_renderer_flags;
-                    ++i_nb_srv;
-                    break;
-                }
+                struct srv *p_srv = &p_srvs[i_nb_srv];
+
+                p_srv->psz_device_name =
+                    strndup( p_entry->name, strlen( p_entry->name )
+                             - strlen( protocols[i].psz_service_name ) - 1);
+                if( p_srv->psz_device_name == NULL )
+                    continue;
+                p_srv->i_protocol = i;
+                p_srv->i_port = p_entry->data.SRV.port;
+                p_srv->i_renderer_flags = protocols[i].i_renderer_flags;
+                p_srv->i_ttl = p_entry->ttl;
+                ++i_nb_srv;
             }
         }
         else if( p_entry->type == RR_A && psz_ip == NULL )
@@ -337,6 +500,8 @@ parse_entries( const struct rr_entry *p_entries, bool b_renderer,
     }
     if( psz_ip == NULL || i_nb_srv == 0 )
     {
+        for( unsigned int i = 0; i < i_nb_srv; ++i )
+            free( p_srvs[i].psz_device_name );
         free( p_srvs );
         return VLC_EGENERIC;
     }
@@ -359,100 +524,30 @@ create_uri( const char *psz_protocol, const char *psz_ip, bool b_ipv6,
 }
 
 static void
-new_entries_sd_cb( void *p_this, int i_status, const struct rr_entry *p_entries )
+new_entries_cb( void *p_this, int i_status, const struct rr_entry *p_entries )
 {
-    services_discovery_t *p_sd = (services_discovery_t *)p_this;
-    struct discovery_sys *p_sys = &p_sd->p_sys->s;
+    struct mdns_service *p_service = p_this;
     if( i_status < 0 )
     {
-        print_error( VLC_OBJECT( p_sd ), "entry callback", i_status );
+        print_error( VLC_OBJECT( p_service->p_libvlc ), "entry callback",
+                     i_status );
         return;
     }
 
+    vlc_mutex_lock( &p_service->lock );
+    entries_goodbye( p_service, p_entries );
+
     struct srv *p_srvs;
     unsigned i_nb_srv;
     const char *psz_ip;
     bool b_ipv6 = false;
-    if( parse_entries( p_entries, false, &p_srvs, &i_nb_srv,
+    if( parse_entries( p_entries, &p_srvs, &i_nb_srv,
                        &psz_ip, &b_ipv6 ) != VLC_SUCCESS )
-        return;
-
-    /* send new input items (if they don't already exist) */
-    for( unsigned int i = 0; i < i_nb_srv; ++i )
-    {
-        struct srv *p_srv = &p_srvs[i];
-        char *psz_uri = create_uri( p_srv->psz_protocol, psz_ip, b_ipv6,
-                                    p_srv->i_port );
-
-        if( psz_uri == NULL )
-            break;
-
-        if( items_exists( p_sys, psz_uri ) )
-        {
-            free( psz_uri );
-            continue;
-        }
-        items_add_input( p_sys, p_sd, psz_uri, p_srv->psz_device_name );
-    }
-
-    for( unsigned int i = 0; i < i_nb_srv; ++i )
-        free( p_srvs[i].psz_device_name );
-    free( p_srvs );
-}
-
-
-static bool
-stop_sd_cb( void *p_this )
-{
-    services_discovery_t *p_sd = ( services_discovery_t* )p_this;
-    struct discovery_sys *p_sys = &p_sd->p_sys->s;
-
-    if( atomic_load( &p_sys->stop ) )
-        return true;
-    else
-    {
-        items_timeout( p_sys, p_sd, NULL );
-        return false;
-    }
-}
-
-static void *
-RunSD( void *p_this )
-{
-    services_discovery_t *p_sd = ( services_discovery_t* )p_this;
-    struct discovery_sys *p_sys = &p_sd->p_sys->s;
-
-    int i_status = mdns_listen( p_sys->p_microdns,
-                                p_sys->ppsz_service_names,
-                                p_sys->i_nb_service_names,
-                                RR_PTR, LISTEN_INTERVAL / INT64_C(1000000),
-                                stop_sd_cb, new_entries_sd_cb, p_sd );
-
-    if( i_status < 0 )
-        print_error( VLC_OBJECT( p_sd ), "listen", i_status );
-
-    return NULL;
-}
-
-static void
-new_entries_rd_cb( void *p_this, int i_status, const struct rr_entry *p_entries )
-{
-    vlc_renderer_discovery_t *p_rd = (vlc_renderer_discovery_t *)p_this;
-    struct discovery_sys *p_sys = &p_rd->p_sys->s;
-    if( i_status < 0 )
     {
-        print_error( VLC_OBJECT( p_rd ), "entry callback", i_status );
+        vlc_mutex_unlock( &p_service->lock );
         return;
     }
 
-    struct srv *p_srvs;
-    unsigned i_nb_srv;
-    const char *psz_ip;
-    bool b_ipv6 = false;
-    if( parse_entries( p_entries, true, &p_srvs, &i_nb_srv,
-                       &psz_ip, &b_ipv6 ) != VLC_SUCCESS )
-        return;
-
     const char *psz_model = NULL;
     const char *psz_icon = NULL;
     for( const struct rr_entry *p_entry = p_entries;
@@ -473,45 +568,38 @@ new_entries_rd_cb( void *p_this, int i_status, const struct rr_entry *p_entries
         }
     }
 
-    /* send new input items (if they don't already exist) */
+    /* add the new servers to the cache, and publish them */
     for( unsigned int i = 0; i < i_nb_srv; ++i )
     {
         struct srv *p_srv = &p_srvs[i];
+        const char *psz_protocol = protocols[p_srv->i_protocol].psz_protocol;
         char *psz_icon_uri = NULL;
-        char *psz_uri = create_uri( p_srv->psz_protocol, psz_ip, b_ipv6,
+        char *psz_uri = create_uri( psz_protocol, psz_ip, b_ipv6,
                                     p_srv->i_port );
-        const char *psz_demux_filter = NULL;
 
         if( psz_uri == NULL )
             break;
 
-        if( items_exists( p_sys, psz_uri ) )
-        {
-            free( psz_uri );
-            continue;
-        }
-
-        if( psz_icon != NULL
-         && asprintf( &psz_icon_uri, "http://%s:8008%s", psz_ip, psz_icon )
-                      == -1 )
+        if( protocols[p_srv->i_protocol].b_renderer )
         {
-            free( psz_uri );
-            break;
-        }
+            if( psz_icon != NULL
+             && asprintf( &psz_icon_uri, "http://%s:8008%s", psz_ip,
+                          psz_icon ) == -1 )
+            {
+                free( psz_uri );
+                break;
+            }
 
-        if( strcmp( p_srv->psz_protocol, "chromecast" ) == 0)
-        {
-            if ( psz_model == NULL
-                || strcasecmp( psz_model, "Chromecast Audio" ) != 0 )
+            if( strcmp( psz_protocol, "chromecast" ) == 0
+             && ( psz_model == NULL
+               || strcasecmp( psz_model, "Chromecast Audio" ) != 0 ) )
                 p_srv->i_renderer_flags |= VLC_RENDERER_CAN_VIDEO;
-            psz_demux_filter = "cc_demux";
         }
 
-        items_add_renderer( p_sys, p_rd, p_srv->psz_device_name, psz_uri,
-                            psz_demux_filter, psz_icon_uri,
-                            p_srv->i_renderer_flags );
-        free(psz_icon_uri);
+        entries_update( p_service, p_srv, psz_uri, psz_icon_uri );
+        free( psz_icon_uri );
     }
+    vlc_mutex_unlock( &p_service->lock );
 
     for( unsigned int i = 0; i < i_nb_srv; ++i )
         free( p_srvs[i].psz_device_name );
@@ -519,93 +607,187 @@ new_entries_rd_cb( void *p_this, int i_status, const struct rr_entry *p_entries
 }
 
 static bool
-stop_rd_cb( void *p_this )
+stop_cb( void *p_this )
 {
-    vlc_renderer_discovery_t *p_rd = p_this;
-    struct discovery_sys *p_sys = &p_rd->p_sys->s;
+    struct mdns_service *p_service = p_this;
 
-    if( atomic_load( &p_sys->stop ) )
+    if( atomic_load( &p_service->stop ) )
         return true;
     else
     {
-        items_timeout( p_sys, NULL, p_rd );
+        vlc_mutex_lock( &p_service->lock );
+        entries_timeout( p_service );
+        vlc_mutex_unlock( &p_service->lock );
         return false;
     }
 }
 
 static void *
-RunRD( void *p_this )
+Run( void *p_this )
 {
-    vlc_renderer_discovery_t *p_rd = p_this;
-    struct discovery_sys *p_sys = &p_rd->p_sys->s;
+    struct mdns_service *p_service = p_this;
 
-    int i_status = mdns_listen( p_sys->p_microdns,
-                                p_sys->ppsz_service_names,
-                                p_sys->i_nb_service_names,
+    int i_status = mdns_listen( p_service->p_microdns,
+                                p_service->ppsz_service_names, NB_PROTOCOLS,
                                 RR_PTR, LISTEN_INTERVAL / INT64_C(1000000),
-                                stop_rd_cb, new_entries_rd_cb, p_rd );
+                                stop_cb, new_entries_cb, p_service );
 
     if( i_status < 0 )
-        print_error( VLC_OBJECT( p_rd ), "listen", i_status );
+        print_error( VLC_OBJECT( p_service->p_libvlc ), "listen", i_status );
 
     return NULL;
 }
 
-static int
-OpenCommon( vlc_object_t *p_obj, struct discovery_sys *p_sys, bool b_renderer )
+static struct mdns_service *
+service_Create( libvlc_int_t *p_libvlc )
 {
-    int i_ret = VLC_EGENERIC;
-    atomic_init( &p_sys->stop, false );
-    vlc_array_init( &p_sys->items );
-
-    /* Listen to protocols that are handled by VLC */
+    struct mdns_service *p_service = malloc( sizeof(*p_service) );
+    if( p_service == NULL )
+        return NULL;
+
+    p_service->p_libvlc = p_libvlc;
+    p_service->i_refs = 1;
+    atomic_init( &p_service->stop, false );
+    vlc_mutex_init( &p_service->lock );
+    vlc_array_init( &p_service->entries );
+    vlc_array_init( &p_service->clients );
+
+    /* Listen to all the protocols that are handled by VLC, in one query */
     for( unsigned int i = 0; i < NB_PROTOCOLS; ++i )
     {
-        if( protocols[i].b_renderer == b_renderer )
-            p_sys->ppsz_service_names[p_sys->i_nb_service_names++] =
-                protocols[i].psz_service_name;
-    }
-
-    if( p_sys->i_nb_service_names == 0 )
-    {
-        msg_Err( p_obj, "no services found" );
-        goto error;
+        p_service->ppsz_service_names[i] = protocols[i].psz_service_name;
+        msg_Dbg( p_libvlc, "mDNS: listening to %s %s",
+                 protocols[i].psz_service_name,
+                 protocols[i].b_renderer ? "renderer" : "service" );
     }
-    for( unsigned int i = 0; i < p_sys->i_nb_service_names; ++i )
-        msg_Dbg( p_obj, "mDNS: listening to %s %s", p_sys->ppsz_service_names[i],
-                 b_renderer ? "renderer" : "service" );
 
     int i_status;
-    if( ( i_status = mdns_init( &p_sys->p_microdns, MDNS_ADDR_IPV4,
+    if( ( i_status = mdns_init( &p_service->p_microdns, MDNS_ADDR_IPV4,
                                 MDNS_PORT ) ) < 0 )
     {
-        print_error( p_obj, "init", i_status );
+        print_error( VLC_OBJECT( p_libvlc ), "init", i_status );
         goto error;
     }
 
-    if( vlc_clone( &p_sys->thread, b_renderer ? RunRD : RunSD, p_obj,
+    if( vlc_clone( &p_service->thread, Run, p_service,
                    VLC_THREAD_PRIORITY_LOW) )
     {
-        msg_Err( p_obj, "Can't run the lookup thread" );
+        msg_Err( p_libvlc, "Can't run the lookup thread" );
+        mdns_destroy( p_service->p_microdns );
         goto error;
     }
 
-    return VLC_SUCCESS;
+    return p_service;
 error:
-    if( p_sys->p_microdns != NULL )
-        mdns_destroy( p_sys->p_microdns );
-    free( p_sys );
-    return i_ret;
+    vlc_mutex_destroy( &p_service->lock );
+    free( p_service );
+    return NULL;
+}
+
+static void
+service_Destroy( struct mdns_service *p_service )
+{
+    atomic_store( &p_service->stop, true );
+    vlc_join( p_service->thread, NULL );
+    mdns_destroy( p_service->p_microdns );
+
+    assert( vlc_array_count( &p_service->clients ) == 0 );
+    for( size_t i = 0; i < vlc_array_count( &p_service->entries ); ++i )
+        entries_release( vlc_array_item_at_index( &p_service->entries, i ) );
+    vlc_array_clear( &p_service->entries );
+    vlc_mutex_destroy( &p_service->lock );
+    free( p_service );
+}
+
+static struct mdns_service *
+service_Hold( vlc_object_t *p_obj )
+{
+    libvlc_int_t *p_libvlc = p_obj->obj.libvlc;
+    struct mdns_service *p_service;
+
+    vlc_mutex_lock( &services_lock );
+    for( p_service = services; p_service != NULL;
+         p_service = p_service->p_next )
+    {
+        if( p_service->p_libvlc == p_libvlc )
+        {
+            p_service->i_refs++;
+            break;
+        }
+    }
+
+    if( p_service == NULL )
+    {
+        p_service = service_Create( p_libvlc );
+        if( p_service != NULL )
+        {
+            p_service->p_next = services;
+            services = p_service;
+        }
+    }
+    vlc_mutex_unlock( &services_lock );
+    return p_service;
+}
+
+static void
+service_Release( struct mdns_service *p_service )
+{
+    vlc_mutex_lock( &services_lock );
+    if( --p_service->i_refs > 0 )
+    {
+        vlc_mutex_unlock( &services_lock );
+        return;
+    }
+
+    for( struct mdns_service **pp = &services; *pp != NULL;
+         pp = &(*pp)->p_next )
+    {
+        if( *pp == p_service )
+        {
+            *pp = p_service->p_next;
+            break;
+        }
+    }
+    vlc_mutex_unlock( &services_lock );
+
+    service_Destroy( p_service );
+}
+
+static int
+OpenCommon( vlc_object_t *p_obj, struct discovery_sys *p_sys, bool b_renderer )
+{
+    p_sys->p_obj = p_obj;
+    p_sys->b_renderer = b_renderer;
+    vlc_array_init( &p_sys->items );
+
+    struct mdns_service *p_service = service_Hold( p_obj );
+    if( p_service == NULL )
+        return VLC_EGENERIC;
+    p_sys->p_service = p_service;
+
+    /* Publish what is already known, the next answers will update it */
+    vlc_mutex_lock( &p_service->lock );
+    vlc_array_append_or_abort( &p_service->clients, p_sys );
+    for( size_t i = 0; i < vlc_array_count( &p_service->entries ); ++i )
+        client_add_entry( p_sys,
+                          vlc_array_item_at_index( &p_service->entries, i ) );
+    vlc_mutex_unlock( &p_service->lock );
+
+    return VLC_SUCCESS;
 }
 
 static void
 CleanCommon( struct discovery_sys *p_sys )
 {
-    atomic_store( &p_sys->stop, true );
-    vlc_join( p_sys->thread, NULL );
+    struct mdns_service *p_service = p_sys->p_service;
 
+    vlc_mutex_lock( &p_service->lock );
+    vlc_array_remove( &p_service->clients,
+                      vlc_array_index_of_item( &p_service->clients, p_sys ) );
+    vlc_mutex_unlock( &p_service->lock );
+
+    service_Release( p_service );
     items_clear( p_sys );
-    mdns_destroy( p_sys->p_microdns );
 }
 
 static int
@@ -620,7 +802,10 @@ OpenSD( vlc_object_t *p_obj )
     p_sd->description = _("mDNS Network Discovery");
     config_ChainParse( p_sd, CFG_PREFIX, ppsz_options, p_sd->p_cfg );
 
-    return OpenCommon( p_obj, &p_sd->p_sys->s, false );
+    int i_ret = OpenCommon( p_obj, &p_sd->p_sys->s, false );
+    if( i_ret != VLC_SUCCESS )
+        free( p_sd->p_sys );
+    return i_ret;
 }
 
 static void
@@ -643,7 +828,10 @@ OpenRD( vlc_object_t *p_obj )
 
     config_ChainParse( p_rd, CFG_PREFIX, ppsz_options, p_rd->p_cfg );
 
-    return OpenCommon( p_obj, &p_rd->p_sys->s, true );
+    int i_ret = OpenCommon( p_obj, &p_rd->p_sys->s, true );
+    if( i_ret != VLC_SUCCESS )
+        free( p_rd->p_sys );
+    return i_ret;
 }
 
 static void
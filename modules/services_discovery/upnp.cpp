@@ -1124,21 +1124,41 @@ int MediaServer::sendActionCb( Upnp_EventType eventType,
 }
 
 /* Access part */
-IXML_Document* MediaServer::_browseAction( const char* psz_object_id_,
-                                           const char* psz_browser_flag_,
-                                           const char* psz_filter_,
-                                           const char* psz_requested_count_,
-                                           const char* psz_sort_criteria_ )
+
+/* Number of children requested by each browse() action. Some servers do not
+ * understand "0" as "no limit", and some return less than requested. */
+#define BROWSE_PAGE_SIZE 500
+/* Number of browse() actions kept in flight at once */
+#define BROWSE_PIPELINE 4
+
+/*
+ * Sends a browse() action, and returns immediately. The response must be
+ * waited for with _waitBrowseAction(), even if this fails.
+ */
+bool MediaServer::_browseAction( BrowseRequest* p_req,
+                                 const char* psz_object_id_,
+                                 const char* psz_browser_flag_,
+                                 const char* psz_filter_,
+                                 unsigned i_start, unsigned i_count,
+                                 const char* psz_sort_criteria_ )
 {
     IXML_Document* p_action = NULL;
-    IXML_Document* p_response = NULL;
-    Upnp_i11e_cb *i11eCb = NULL;
     access_sys_t *sys = (access_sys_t *)m_access->p_sys;
+    char psz_starting_index[11], psz_requested_count[11];
 
     int i_res;
 
+    p_req->i_start = i_start;
+    p_req->i_count = i_count;
+    p_req->p_response = NULL;
+    p_req->p_cb = NULL;
+
     if ( vlc_killed() )
-        return NULL;
+        return false;
+
+    snprintf( psz_starting_index, sizeof (psz_starting_index), "%u", i_start );
+    snprintf( psz_requested_count, sizeof (psz_requested_count), "%u",
+              i_count );
 
     i_res = UpnpAddToAction( &p_action, "Browse",
             CONTENT_DIRECTORY_SERVICE_TYPE, "ObjectID", psz_object_id_ ? psz_object_id_ : "0" );
@@ -1171,7 +1191,7 @@ IXML_Document* MediaServer::_browseAction( const char* psz_object_id_,
     }
 
     i_res = UpnpAddToAction( &p_action, "Browse",
-            CONTENT_DIRECTORY_SERVICE_TYPE, "StartingIndex", "0" );
+            CONTENT_DIRECTORY_SERVICE_TYPE, "StartingIndex", psz_starting_index );
     if ( i_res != UPNP_E_SUCCESS )
     {
         msg_Dbg( m_access, "AddToAction 'StartingIndex' failed: %s",
@@ -1180,7 +1200,7 @@ IXML_Document* MediaServer::_browseAction( const char* psz_object_id_,
     }
 
     i_res = UpnpAddToAction( &p_action, "Browse",
-            CONTENT_DIRECTORY_SERVICE_TYPE, "RequestedCount", psz_requested_count_ );
+            CONTENT_DIRECTORY_SERVICE_TYPE, "RequestedCount", psz_requested_count );
 
     if ( i_res != UPNP_E_SUCCESS )
     {
@@ -1201,59 +1221,63 @@ IXML_Document* MediaServer::_browseAction( const char* psz_object_id_,
 
     /* Setup an interruptible callback that will call sendActionCb if not
      * interrupted by vlc_interrupt_kill */
-    i11eCb = new Upnp_i11e_cb( sendActionCb, &p_response );
+    p_req->p_cb = new Upnp_i11e_cb( sendActionCb, &p_req->p_response );
     i_res = UpnpSendActionAsync( sys->p_upnp->handle(),
               m_psz_root,
               CONTENT_DIRECTORY_SERVICE_TYPE,
               NULL, /* ignored in SDK, must be NULL */
               p_action,
-              Upnp_i11e_cb::run, i11eCb );
+              Upnp_i11e_cb::run, p_req->p_cb );
 
     if ( i_res != UPNP_E_SUCCESS )
     {
         msg_Err( m_access, "%s when trying the send() action with URL: %s",
                 UpnpGetErrorMessage( i_res ), m_access->psz_location );
+        /* The callback will never run */
+        delete p_req->p_cb;
+        p_req->p_cb = NULL;
     }
-    /* Wait for the callback to fill p_response or wait for an interrupt */
-    i11eCb->waitAndRelease();
 
 browseActionCleanup:
     ixmlDocument_free( p_action );
-    return p_response;
+    return p_req->p_cb != NULL;
 }
 
 /*
- * Fetches and parses the UPNP response
+ * Waits for the response of a browse() action, or for an interrupt
  */
-bool MediaServer::fetchContents()
+IXML_Document* MediaServer::_waitBrowseAction( BrowseRequest* p_req )
 {
-    IXML_Document* p_response = _browseAction( m_psz_objectId,
-                                      "BrowseDirectChildren",
-                                      "*",
-                                      // Some servers don't understand "0" as "no-limit"
-                                      "5000", /* RequestedCount */
-                                      "" /* SortCriteria */
-                                      );
-    if ( !p_response )
-    {
-        msg_Err( m_access, "No response from browse() action" );
-        return false;
-    }
+    if ( p_req->p_cb == NULL )
+        return NULL;
 
-    IXML_Document* p_result = parseBrowseResult( p_response );
+    p_req->p_cb->waitAndRelease();
+    p_req->p_cb = NULL;
+    return p_req->p_response;
+}
 
-    ixmlDocument_free( p_response );
+/*
+ * Parses a browse() response and adds its children to the node
+ * Returns the number of children found in the response, or -1 on error
+ */
+int MediaServer::addResults( IXML_Document* p_response, unsigned* pi_total )
+{
+    const char* psz_total = xml_getChildElementValue( (IXML_Element*)p_response,
+                                                      "TotalMatches" );
+    *pi_total = psz_total ? strtoul( psz_total, NULL, 10 ) : 0;
 
+    IXML_Document* p_result = parseBrowseResult( p_response );
     if ( !p_result )
     {
         msg_Err( m_access, "browse() response parsing failed" );
-        return false;
+        return -1;
     }
 
 #ifndef NDEBUG
     msg_Dbg( m_access, "Got DIDL document: %s", ixmlPrintDocument( p_result ) );
 #endif
 
+    int i_children = 0;
     IXML_NodeList* containerNodeList =
                 ixmlDocument_getElementsByTagName( p_result, "container" );
 
@@ -1261,6 +1285,7 @@ bool MediaServer::fetchContents()
     {
         for ( unsigned int i = 0; i < ixmlNodeList_length( containerNodeList ); i++ )
             addContainer( (IXML_Element*)ixmlNodeList_item( containerNodeList, i ) );
+        i_children += ixmlNodeList_length( containerNodeList );
         ixmlNodeList_free( containerNodeList );
     }
 
@@ -1270,10 +1295,122 @@ bool MediaServer::fetchContents()
     {
         for ( unsigned int i = 0; i < ixmlNodeList_length( itemNodeList ); i++ )
             addItem( (IXML_Element*)ixmlNodeList_item( itemNodeList, i ) );
+        i_children += ixmlNodeList_length( itemNodeList );
         ixmlNodeList_free( itemNodeList );
     }
 
     ixmlDocument_free( p_result );
+    return i_children;
+}
+
+/*
+ * Fetches and parses the UPNP response
+ *
+ * The children are browsed by pages. Once the first page tells how many
+ * children there are, the next pages are requested a few at a time, and
+ * added in order as their responses arrive.
+ */
+bool MediaServer::fetchContents()
+{
+    BrowseRequest requests[BROWSE_PIPELINE];
+    unsigned i_head = 0, i_pending = 0;
+
+    _browseAction( &requests[0], m_psz_objectId, "BrowseDirectChildren", "*",
+                   0, BROWSE_PAGE_SIZE, "" /* SortCriteria */ );
+    IXML_Document* p_response = _waitBrowseAction( &requests[0] );
+    if ( !p_response )
+    {
+        msg_Err( m_access, "No response from browse() action" );
+        return false;
+    }
+
+    unsigned i_total;
+    int i_returned = addResults( p_response, &i_total );
+    ixmlDocument_free( p_response );
+    if ( i_returned < 0 )
+        return false;
+
+    /* Servers returning less than requested have a lower limit: use it.
+     * Without the total count, pages are requested one at a time until a
+     * short one. */
+    unsigned i_page = BROWSE_PAGE_SIZE;
+    if ( i_returned > 0 && (unsigned)i_returned < i_page && i_total > 0 )
+        i_page = i_returned;
+    unsigned i_depth = i_total > 0 ? BROWSE_PIPELINE : 1;
+    unsigned i_next = i_returned;
+    bool b_end = i_returned == 0 || (unsigned)i_returned < i_page
+              || ( i_total > 0 && i_next >= i_total );
+
+    while ( !b_end || i_pending > 0 )
+    {
+        /* Keep the pipeline full */
+        while ( !b_end && i_pending < i_depth )
+        {
+            BrowseRequest* p_req =
+                &requests[( i_head + i_pending ) % BROWSE_PIPELINE];
+            unsigned i_count = i_page;
+
+            if ( i_total > 0 && i_count > i_total - i_next )
+                i_count = i_total - i_next;
+
+            i_pending++;
+            if ( !_browseAction( p_req, m_psz_objectId, "BrowseDirectChildren",
+                                 "*", i_next, i_count, "" ) )
+            {
+                b_end = true;
+                break;
+            }
+            i_next += i_count;
+            if ( i_total > 0 && i_next >= i_total )
+                b_end = true;
+        }
+
+        BrowseRequest* p_req = &requests[i_head];
+        i_head = ( i_head + 1 ) % BROWSE_PIPELINE;
+        i_pending--;
+
+        p_response = _waitBrowseAction( p_req );
+        if ( !p_response )
+        {
+            /* Interrupted or failed: drop the pages still in flight */
+            b_end = true;
+            continue;
+        }
+        if ( vlc_killed() )
+        {
+            ixmlDocument_free( p_response );
+            b_end = true;
+            continue;
+        }
+
+        unsigned i_page_total;
+        i_returned = addResults( p_response, &i_page_total );
+        ixmlDocument_free( p_response );
+
+        if ( i_returned <= 0 )
+            b_end = true;
+        else if ( (unsigned)i_returned < p_req->i_count )
+        {
+            if ( i_total == 0 )
+                b_end = true;
+            else
+            {
+                /* The next pages would leave a gap: drop them, and request
+                 * the rest of this one again */
+                while ( i_pending > 0 )
+                {
+                    p_response = _waitBrowseAction( &requests[i_head] );
+                    if ( p_response )
+                        ixmlDocument_free( p_response );
+                    i_head = ( i_head + 1 ) % BROWSE_PIPELINE;
+                    i_pending--;
+                }
+                i_next = p_req->i_start + i_returned;
+                i_page = i_returned;
+                b_end = i_next >= i_total;
+            }
+        }
+    }
     return true;
 }
 
@@ -153,11 +153,22 @@ private:
     MediaServer(const MediaServer&);
     MediaServer& operator=(const MediaServer&);
 
+    /* A browse() action in flight */
+    struct BrowseRequest
+    {
+        unsigned i_start;
+        unsigned i_count;
+        IXML_Document* p_response;
+        Upnp_i11e_cb* p_cb;
+    };
+
     bool addContainer( IXML_Element* containerElement );
     bool addItem( IXML_Element* itemElement );
+    int addResults( IXML_Document* p_response, unsigned* pi_total );
 
-    IXML_Document* _browseAction(const char*, const char*,
-            const char*, const char*, const char* );
+    bool _browseAction( BrowseRequest*, const char*, const char*,
+            const char*, unsigned, unsigned, const char* );
+    IXML_Document* _waitBrowseAction( BrowseRequest* );
     static int sendActionCb( Upnp_EventType, UpnpEventPtr, void *);
 
 private:
@@ -334,12 +334,17 @@ static subpicture_t *Filter( filter_t *p_filter, mtime_t date )
         }
     }
 
-    if( !p_sys->b_updated )
-        return NULL;
-
     subpicture_t *p_spu = NULL;
     overlay_t *p_overlay = NULL;
 
+    /* New pictures in the shared memory rings */
+    while( (p_overlay = ListWalk( &p_sys->overlays )) )
+        if( p_overlay->p_shm != NULL && OverlayRingUpdated( p_overlay ) )
+            p_sys->b_updated = true;
+
+    if( !p_sys->b_updated )
+        return NULL;
+
     p_spu = filter_NewSubpicture( p_filter );
     if( !p_spu )
         return NULL;
@@ -354,7 +359,28 @@ static subpicture_t *Filter( filter_t *p_filter, mtime_t date )
     {
         subpicture_region_t *p_region;
 
-        *pp_region = p_region = subpicture_region_New( &p_overlay->format );
+        if( p_overlay->p_shm != NULL )
+        {
+            /* Display the slot as is: the region does not allocate a
+             * picture of its own for text */
+            video_format_t fmt = p_overlay->format;
+            fmt.i_chroma = VLC_CODEC_TEXT;
+
+            picture_t *p_pic = OverlayRingPicture( p_overlay );
+            if( !p_pic )
+                continue;
+            p_region = subpicture_region_New( &fmt );
+            if( p_region )
+            {
+                p_region->fmt.i_chroma = p_overlay->format.i_chroma;
+                p_region->p_picture = p_pic;
+            }
+            else
+                picture_Release( p_pic );
+        }
+        else
+            p_region = subpicture_region_New( &p_overlay->format );
+        *pp_region = p_region;
         if( !p_region )
             break;
 
@@ -367,7 +393,7 @@ static subpicture_t *Filter( filter_t *p_filter, mtime_t date )
             p_region->p_text = text_segment_New( p_overlay->data.p_text );
             p_region->p_text->style = text_style_Duplicate( p_overlay->p_fontstyle );
         }
-        else
+        else if( p_overlay->p_shm == NULL )
         {
             /* FIXME the copy is probably not needed anymore */
             picture_Copy( p_region->p_picture, p_overlay->data.p_pic );
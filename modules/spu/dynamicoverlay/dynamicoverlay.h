@@ -25,7 +25,9 @@
 #define DYNAMIC_OVERLAY_H   1
 
 #include <vlc_common.h>
+#include <vlc_atomic.h>
 #include <vlc_filter.h>
+#include <vlc_picture.h>
 #include <vlc_text_style.h>
 
 /*****************************************************************************
@@ -123,6 +125,54 @@ int QueueEnqueue( queue_t *p_queue, command_t *p_cmd );
 command_t *QueueDequeue( queue_t *p_queue );
 int QueueTransfer( queue_t *p_sink, queue_t *p_source );
 
+/*****************************************************************************
+ * overlay_ring_t: Shared memory ring of pictures
+ *****************************************************************************
+ * Layout of the shared memory segment of the DataSharedRing command: this
+ * header, then i_slots pictures with packed planes, i_slot_size bytes apart.
+ *
+ * The producer fills a slot which is neither the latest one nor held, sets
+ * its dirty area, stores its index to i_latest, then increments i_sequence.
+ * With two slots, this is double buffering. The filter displays the latest
+ * slot without copying it, and holds it meanwhile.
+ *****************************************************************************/
+
+#define OVERLAY_RING_MAGIC     VLC_FOURCC('V','O','R','G')
+#define OVERLAY_RING_SLOTS_MAX 8
+
+typedef struct overlay_ring_t
+{
+    uint32_t i_magic;                          /**< OVERLAY_RING_MAGIC */
+    uint32_t i_slots;                             /**< 2 to SLOTS_MAX slots */
+    uint32_t i_slot_offset;      /**< offset of the first slot in the segment */
+    uint32_t i_slot_size;
+
+    atomic_uint_least32_t i_sequence;        /**< number of published slots */
+    atomic_uint_least32_t i_latest;              /**< slot published last */
+    atomic_uint_least32_t holds[OVERLAY_RING_SLOTS_MAX]; /**< set by VLC */
+
+    /** area changed since the previous slot, empty if none */
+    struct
+    {
+        uint32_t i_x, i_y, i_width, i_height;
+    } dirty[OVERLAY_RING_SLOTS_MAX];
+} overlay_ring_t;
+
+/** Attachment of a ring, shared by an overlay and its displayed pictures */
+typedef struct overlay_shm_t
+{
+    atomic_uint refs;
+    overlay_ring_t *p_ring;
+
+    /* copies of the header, checked once */
+    unsigned i_slots;
+    size_t i_slot_offset, i_slot_size;
+
+    int i_planes;
+    int pi_pitch[PICTURE_PLANE_MAX];
+    int pi_lines[PICTURE_PLANE_MAX];
+} overlay_shm_t;
+
 /*****************************************************************************
  * overlay_t: Overlay descriptor
  *****************************************************************************/
@@ -139,10 +189,15 @@ typedef struct overlay_t
         picture_t *p_pic;
         char *p_text;
     } data;
+
+    overlay_shm_t *p_shm; /**< ring of pictures, instead of data.p_pic */
+    uint32_t i_sequence;  /**< last slot seen in the ring */
 } overlay_t;
 
 overlay_t *OverlayCreate( void );
 int OverlayDestroy( overlay_t *p_ovl );
+bool OverlayRingUpdated( overlay_t *p_ovl );
+picture_t *OverlayRingPicture( overlay_t *p_ovl );
 
 /*****************************************************************************
  * list_t: Command queue
@@ -62,14 +62,134 @@ overlay_t *OverlayCreate( void )
     return p_ovl;
 }
 
+#if defined(HAVE_SYS_SHM_H)
+static void OverlayShmRelease( overlay_shm_t *p_shm )
+{
+    if( atomic_fetch_sub( &p_shm->refs, 1 ) == 1 )
+    {
+        shmdt( p_shm->p_ring );
+        free( p_shm );
+    }
+}
+#endif
+
 int OverlayDestroy( overlay_t *p_ovl )
 {
     free( p_ovl->data.p_text );
     text_style_Delete( p_ovl->p_fontstyle );
+#if defined(HAVE_SYS_SHM_H)
+    if( p_ovl->p_shm != NULL )
+        OverlayShmRelease( p_ovl->p_shm );
+#endif
 
     return VLC_SUCCESS;
 }
 
+/*****************************************************************************
+ * Shared memory rings
+ *****************************************************************************/
+
+/**
+ * Checks whether a new slot was published, with changes.
+ */
+bool OverlayRingUpdated( overlay_t *p_ovl )
+{
+    overlay_shm_t *p_shm = p_ovl->p_shm;
+    uint32_t i_sequence = atomic_load( &p_shm->p_ring->i_sequence );
+    uint32_t i_published = i_sequence - p_ovl->i_sequence;
+
+    if( i_published == 0 )
+        return false;
+    p_ovl->i_sequence = i_sequence;
+
+    /* Only the area changed since the previous slot is known */
+    uint_least32_t i_slot = atomic_load( &p_shm->p_ring->i_latest );
+    if( i_published == 1 && i_slot < p_shm->i_slots )
+        return p_shm->p_ring->dirty[i_slot].i_width != 0 &&
+               p_shm->p_ring->dirty[i_slot].i_height != 0;
+    return true;
+}
+
+#if defined(HAVE_SYS_SHM_H)
+struct picture_sys_t
+{
+    overlay_shm_t *p_shm;
+    unsigned i_slot;
+};
+
+static void OverlayRingPictureDestroy( picture_t *p_pic )
+{
+    picture_sys_t *p_picsys = p_pic->p_sys;
+
+    atomic_fetch_sub( &p_picsys->p_shm->p_ring->holds[p_picsys->i_slot], 1 );
+    OverlayShmRelease( p_picsys->p_shm );
+    free( p_picsys );
+    free( p_pic );
+}
+#endif
+
+/**
+ * Wraps the latest slot of a ring as a picture, which holds the slot.
+ */
+picture_t *OverlayRingPicture( overlay_t *p_ovl )
+{
+#if defined(HAVE_SYS_SHM_H)
+    overlay_shm_t *p_shm = p_ovl->p_shm;
+    overlay_ring_t *p_ring = p_shm->p_ring;
+    uint_least32_t i_slot;
+
+    /* The producer does not reuse the latest slot, so it is held safely if
+     * it is still the latest one afterwards */
+    for( ;; )
+    {
+        i_slot = atomic_load( &p_ring->i_latest );
+        if( i_slot >= p_shm->i_slots )
+            return NULL;
+        atomic_fetch_add( &p_ring->holds[i_slot], 1 );
+        if( atomic_load( &p_ring->i_latest ) == i_slot )
+            break;
+        atomic_fetch_sub( &p_ring->holds[i_slot], 1 );
+    }
+
+    picture_sys_t *p_picsys = malloc( sizeof( *p_picsys ) );
+    if( unlikely(p_picsys == NULL) )
+    {
+        atomic_fetch_sub( &p_ring->holds[i_slot], 1 );
+        return NULL;
+    }
+    p_picsys->p_shm = p_shm;
+    p_picsys->i_slot = i_slot;
+
+    picture_resource_t res = {
+        .p_sys = p_picsys,
+        .pf_destroy = OverlayRingPictureDestroy,
+    };
+    uint8_t *p_pixels = (uint8_t *)p_ring + p_shm->i_slot_offset
+                      + i_slot * p_shm->i_slot_size;
+
+    for( int i = 0; i < p_shm->i_planes; i++ )
+    {
+        res.p[i].p_pixels = p_pixels;
+        res.p[i].i_lines = p_shm->pi_lines[i];
+        res.p[i].i_pitch = p_shm->pi_pitch[i];
+        p_pixels += p_shm->pi_lines[i] * p_shm->pi_pitch[i];
+    }
+
+    picture_t *p_pic = picture_NewFromResource( &p_ovl->format, &res );
+    if( p_pic == NULL )
+    {
+        atomic_fetch_sub( &p_ring->holds[i_slot], 1 );
+        free( p_picsys );
+        return NULL;
+    }
+    atomic_fetch_add( &p_shm->refs, 1 );
+    return p_pic;
+#else
+    VLC_UNUSED(p_ovl);
+    return NULL;
+#endif
+}
+
 /*****************************************************************************
  * Command parsers
  *****************************************************************************/
@@ -434,6 +554,12 @@ static int exec_DataSharedMem( filter_t *p_filter,
     }
     i_size = shminfo.shm_segsz;
 
+    if( p_ovl->p_shm != NULL )
+    {
+        OverlayShmRelease( p_ovl->p_shm );
+        p_ovl->p_shm = NULL;
+    }
+
     if( p_params->fourcc == VLC_CODEC_TEXT )
     {
         char *p_data;
@@ -545,6 +671,116 @@ static int exec_DataSharedMem( filter_t *p_filter,
 #endif
 }
 
+static int exec_DataSharedRing( filter_t *p_filter,
+                                const commandparams_t *p_params,
+                                commandparams_t *p_results )
+{
+#if defined(HAVE_SYS_SHM_H)
+    filter_sys_t *p_sys = (filter_sys_t*) p_filter->p_sys;
+    struct shmid_ds shminfo;
+    overlay_t *p_ovl;
+    size_t i_neededsize = 0;
+
+    VLC_UNUSED(p_results);
+
+    p_ovl = ListGet( &p_sys->overlays, p_params->i_id );
+    if( p_ovl == NULL )
+    {
+        msg_Err( p_filter, "Invalid overlay: %d", p_params->i_id );
+        return VLC_EGENERIC;
+    }
+
+    if( p_params->fourcc == VLC_CODEC_TEXT )
+    {
+        msg_Err( p_filter, "Text cannot be shared through a ring" );
+        return VLC_EGENERIC;
+    }
+
+    if( shmctl( p_params->i_shmid, IPC_STAT, &shminfo ) == -1 )
+    {
+        msg_Err( p_filter, "Unable to access shared memory" );
+        return VLC_EGENERIC;
+    }
+
+    overlay_shm_t *p_shm = malloc( sizeof( *p_shm ) );
+    if( p_shm == NULL )
+        return VLC_ENOMEM;
+
+    /* Geometry of the packed planes of a slot */
+    picture_t *p_pic = picture_New( p_params->fourcc,
+                                    p_params->i_width, p_params->i_height,
+                                    1, 1 );
+    if( p_pic == NULL )
+    {
+        free( p_shm );
+        return VLC_ENOMEM;
+    }
+
+    video_format_t fmt = p_pic->format;
+    p_shm->i_planes = p_pic->i_planes;
+    for( int i = 0; i < p_pic->i_planes; i++ )
+    {
+        p_shm->pi_pitch[i] = p_pic->p[i].i_visible_pitch;
+        p_shm->pi_lines[i] = p_pic->p[i].i_visible_lines;
+        i_neededsize += p_shm->pi_pitch[i] * p_shm->pi_lines[i];
+    }
+    picture_Release( p_pic );
+
+    /* The holds are written to the segment */
+    overlay_ring_t *p_ring = shmat( p_params->i_shmid, NULL, 0 );
+    if( p_ring == (void *)-1 )
+    {
+        msg_Err( p_filter, "Unable to attach to shared memory" );
+        free( p_shm );
+        return VLC_ENOMEM;
+    }
+
+    if( shminfo.shm_segsz < sizeof( *p_ring )
+     || p_ring->i_magic != OVERLAY_RING_MAGIC
+     || p_ring->i_slots < 2 || p_ring->i_slots > OVERLAY_RING_SLOTS_MAX
+     || p_ring->i_slot_offset < sizeof( *p_ring )
+     || p_ring->i_slot_size < i_neededsize
+     || (uint64_t)p_ring->i_slot_offset
+        + (uint64_t)p_ring->i_slots * p_ring->i_slot_size > shminfo.shm_segsz )
+    {
+        msg_Err( p_filter, "Invalid shared memory ring for %dx%d %4.4s",
+                 p_params->i_width, p_params->i_height,
+                 (const char *)&p_params->fourcc );
+        shmdt( p_ring );
+        free( p_shm );
+        return VLC_EGENERIC;
+    }
+
+    atomic_init( &p_shm->refs, 1 );
+    p_shm->p_ring = p_ring;
+    p_shm->i_slots = p_ring->i_slots;
+    p_shm->i_slot_offset = p_ring->i_slot_offset;
+    p_shm->i_slot_size = p_ring->i_slot_size;
+
+    /* Replace the previous image */
+    if( p_ovl->format.i_chroma == VLC_CODEC_TEXT )
+        free( p_ovl->data.p_text );
+    else if( p_ovl->data.p_pic != NULL )
+        picture_Release( p_ovl->data.p_pic );
+    p_ovl->data.p_pic = NULL;
+    if( p_ovl->p_shm != NULL )
+        OverlayShmRelease( p_ovl->p_shm );
+
+    p_ovl->format = fmt;
+    p_ovl->p_shm = p_shm;
+    p_ovl->i_sequence = atomic_load( &p_ring->i_sequence );
+    p_sys->b_updated = p_ovl->b_active;
+
+    return VLC_SUCCESS;
+#else
+    VLC_UNUSED(p_params);
+    VLC_UNUSED(p_results);
+
+    msg_Err( p_filter, "system doesn't support shared memory" );
+    return VLC_EGENERIC;
+#endif
+}
+
 static int exec_DeleteImage( filter_t *p_filter,
                              const commandparams_t *p_params,
                              commandparams_t *p_results )
@@ -792,6 +1028,12 @@ static const commanddesc_static_t p_commands[] =
         .pf_execute = exec_DataSharedMem,
         .pf_unparse = unparse_default,
     },
+    {   .psz_command = "DataSharedRing",
+        .b_atomic = true,
+        .pf_parser = parser_DataSharedMem,
+        .pf_execute = exec_DataSharedRing,
+        .pf_unparse = unparse_default,
+    },
     {   .psz_command = "DeleteImage",
         .b_atomic = true,
         .pf_parser = parser_Id,
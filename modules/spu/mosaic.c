@@ -55,6 +55,20 @@ static int MosaicCallback   ( vlc_object_t *, char const *, vlc_value_t,
 /*****************************************************************************
  * filter_sys_t : filter descriptor
  *****************************************************************************/
+typedef struct
+{
+    picture_t *p_picture;     /* Bridged picture to show */
+    int i_real_index;
+    int i_x, i_y;
+    int i_alpha;
+} mosaic_input_t;
+
+typedef struct
+{
+    picture_t *p_source;      /* Bridged picture */
+    picture_t *p_picture;     /* The same, converted to the tile format */
+} mosaic_tile_t;
+
 struct filter_sys_t
 {
     vlc_mutex_t lock;         /* Internal filter lock */
@@ -78,6 +92,9 @@ struct filter_sys_t
     int *pi_y_offsets;        /* List of substreams y offsets */
     int i_offsets_length;
 
+    mosaic_tile_t *p_tiles;   /* Tiles converted for the last subpicture */
+    int i_tiles;
+
     mtime_t i_delay;
 };
 
@@ -290,6 +307,8 @@ static int CreateFilter( vlc_object_t *p_this )
         return VLC_ENOMEM;
 
     p_filter->pf_sub_source = Filter;
+    p_sys->p_tiles = NULL;
+    p_sys->i_tiles = 0;
 
     vlc_mutex_init( &p_sys->lock );
     vlc_mutex_lock( &p_sys->lock );
@@ -372,6 +391,60 @@ static int CreateFilter( vlc_object_t *p_this )
     return VLC_SUCCESS;
 }
 
+/*****************************************************************************
+ * Tiles
+ *****************************************************************************/
+static void ReleaseTiles( mosaic_tile_t *p_tiles, int i_tiles )
+{
+    for( int i = 0; i < i_tiles; i++ )
+    {
+        if( p_tiles[i].p_source )
+            picture_Release( p_tiles[i].p_source );
+        if( p_tiles[i].p_picture )
+            picture_Release( p_tiles[i].p_picture );
+    }
+}
+
+/* Converts a bridged picture to the tile format. The conversion of the last
+ * subpicture is reused while the substream did not send a new picture, and
+ * there is none if the bridge already scaled the picture to the tile. */
+static picture_t *ConvertTile( filter_t *p_filter, mosaic_tile_t *p_tile,
+                               picture_t *p_source,
+                               const video_format_t *p_fmt_in,
+                               video_format_t *p_fmt_out )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    for( int i = 0; i < p_sys->i_tiles; i++ )
+    {
+        mosaic_tile_t *p_old = &p_sys->p_tiles[i];
+        if( p_old->p_source == p_source
+         && p_old->p_picture->format.i_chroma == p_fmt_out->i_chroma
+         && p_old->p_picture->format.i_width == p_fmt_out->i_width
+         && p_old->p_picture->format.i_height == p_fmt_out->i_height )
+        {
+            *p_tile = *p_old;
+            p_old->p_source = p_old->p_picture = NULL;
+            return p_tile->p_picture;
+        }
+    }
+
+    picture_t *p_picture;
+    if( p_fmt_in->i_chroma == p_fmt_out->i_chroma
+     && p_fmt_in->i_width == p_fmt_out->i_width
+     && p_fmt_in->i_height == p_fmt_out->i_height )
+        p_picture = picture_Hold( p_source );
+    else
+        p_picture = image_Convert( p_sys->p_image, p_source,
+                                   p_fmt_in, p_fmt_out );
+    if( p_picture == NULL )
+        return NULL;
+
+    p_tile->p_source = picture_Hold( p_source );
+    p_tile->p_picture = p_picture;
+    return p_picture;
+}
+
 /*****************************************************************************
  * DestroyFilter: destroy mosaic video filter
  *****************************************************************************/
@@ -421,6 +494,9 @@ static void DestroyFilter( vlc_object_t *p_this )
         p_sys->i_offsets_length = 0;
     }
 
+    ReleaseTiles( p_sys->p_tiles, p_sys->i_tiles );
+    free( p_sys->p_tiles );
+
     vlc_mutex_destroy( &p_sys->lock );
     free( p_sys );
 }
@@ -519,13 +595,27 @@ static subpicture_t *Filter( filter_t *p_filter, mtime_t date )
     row_inner_height = ( ( p_sys->i_height - ( p_sys->i_rows - 1 )
                        * p_sys->i_borderh ) / p_sys->i_rows );
 
+    /* Only pick the pictures to show while the bridge is locked, so that
+     * the bridged substreams are not blocked by the conversions */
+    mosaic_input_t *p_inputs = NULL;
+    int i_inputs = 0;
+
+    if( p_bridge->i_es_num > 0 )
+    {
+        p_inputs = vlc_alloc( p_bridge->i_es_num, sizeof( *p_inputs ) );
+        if( unlikely(p_inputs == NULL) )
+        {
+            vlc_global_unlock( VLC_MOSAIC_MUTEX );
+            vlc_mutex_unlock( &p_sys->lock );
+            return p_spu;
+        }
+    }
+
     i_real_index = 0;
 
     for( int i_index = 0; i_index < p_bridge->i_es_num; i_index++ )
     {
         bridged_es_t *p_es = p_bridge->pp_es[i_index];
-        video_format_t fmt_in, fmt_out;
-        picture_t *p_converted;
 
         if ( p_es->b_empty )
             continue;
@@ -579,6 +669,36 @@ static subpicture_t *Filter( filter_t *p_filter, mtime_t date )
             if ( i == p_sys->i_order_length )
                 i_real_index = ++i_greatest_real_index_used;
         }
+
+        mosaic_input_t *p_input = &p_inputs[i_inputs++];
+        p_input->p_picture = picture_Hold( p_es->p_picture );
+        p_input->i_real_index = i_real_index;
+        p_input->i_x = p_es->i_x;
+        p_input->i_y = p_es->i_y;
+        p_input->i_alpha = p_es->i_alpha;
+    }
+
+    vlc_global_unlock( VLC_MOSAIC_MUTEX );
+
+    mosaic_tile_t *p_tiles = NULL;
+    int i_tiles = 0;
+    int i_shown = i_inputs;
+
+    if( i_inputs > 0 && !p_sys->b_keep )
+    {
+        p_tiles = vlc_alloc( i_inputs, sizeof( *p_tiles ) );
+        if( unlikely(p_tiles == NULL) )
+            i_shown = 0;
+    }
+
+    for( int i_input = 0; i_input < i_shown; i_input++ )
+    {
+        const mosaic_input_t *p_input = &p_inputs[i_input];
+        picture_t *p_picture = p_input->p_picture;
+        video_format_t fmt_in, fmt_out;
+        picture_t *p_converted;
+
+        i_real_index = p_input->i_real_index;
         i_row = ( i_real_index / p_sys->i_cols ) % p_sys->i_rows;
         i_col = i_real_index % p_sys->i_cols ;
 
@@ -588,9 +708,9 @@ static subpicture_t *Filter( filter_t *p_filter, mtime_t date )
         if ( !p_sys->b_keep )
         {
             /* Convert the images */
-            fmt_in.i_chroma = p_es->p_picture->format.i_chroma;
-            fmt_in.i_height = p_es->p_picture->format.i_height;
-            fmt_in.i_width = p_es->p_picture->format.i_width;
+            fmt_in.i_chroma = p_picture->format.i_chroma;
+            fmt_in.i_height = p_picture->format.i_height;
+            fmt_in.i_width = p_picture->format.i_width;
 
             if( fmt_in.i_chroma == VLC_CODEC_YUVA ||
                 fmt_in.i_chroma == VLC_CODEC_RGBA )
@@ -618,8 +738,8 @@ static subpicture_t *Filter( filter_t *p_filter, mtime_t date )
             fmt_out.i_visible_width = fmt_out.i_width;
             fmt_out.i_visible_height = fmt_out.i_height;
 
-            p_converted = image_Convert( p_sys->p_image, p_es->p_picture,
-                                         &fmt_in, &fmt_out );
+            p_converted = ConvertTile( p_filter, &p_tiles[i_tiles], p_picture,
+                                       &fmt_in, &fmt_out );
             if( !p_converted )
             {
                 msg_Warn( p_filter,
@@ -628,10 +748,11 @@ static subpicture_t *Filter( filter_t *p_filter, mtime_t date )
                 video_format_Clean( &fmt_out );
                 continue;
             }
+            i_tiles++;
         }
         else
         {
-            p_converted = p_es->p_picture;
+            p_converted = p_picture;
             fmt_in.i_width = fmt_out.i_width = p_converted->format.i_width;
             fmt_in.i_height = fmt_out.i_height = p_converted->format.i_height;
             fmt_in.i_chroma = fmt_out.i_chroma = p_converted->format.i_chroma;
@@ -639,28 +760,25 @@ static subpicture_t *Filter( filter_t *p_filter, mtime_t date )
             fmt_out.i_visible_height = fmt_out.i_height;
         }
 
+        /* The region shares the converted picture: the blending only
+         * reads it */
         p_region = subpicture_region_New( &fmt_out );
-        /* FIXME the copy is probably not needed anymore */
-        if( p_region )
-            picture_Copy( p_region->p_picture, p_converted );
-        if( !p_sys->b_keep )
-            picture_Release( p_converted );
-
         if( !p_region )
         {
             video_format_Clean( &fmt_in );
             video_format_Clean( &fmt_out );
             msg_Err( p_filter, "cannot allocate SPU region" );
             subpicture_Delete( p_spu );
-            vlc_global_unlock( VLC_MOSAIC_MUTEX );
-            vlc_mutex_unlock( &p_sys->lock );
-            return NULL;
+            p_spu = NULL;
+            break;
         }
+        picture_Release( p_region->p_picture );
+        p_region->p_picture = picture_Hold( p_converted );
 
-        if( p_es->i_x >= 0 && p_es->i_y >= 0 )
+        if( p_input->i_x >= 0 && p_input->i_y >= 0 )
         {
-            p_region->i_x = p_es->i_x;
-            p_region->i_y = p_es->i_y;
+            p_region->i_x = p_input->i_x;
+            p_region->i_y = p_input->i_y;
         }
         else if( p_sys->i_position == position_offsets )
         {
@@ -706,7 +824,7 @@ static subpicture_t *Filter( filter_t *p_filter, mtime_t date )
             }
         }
         p_region->i_align = p_sys->i_align;
-        p_region->i_alpha = p_es->i_alpha;
+        p_region->i_alpha = p_input->i_alpha;
 
         if( p_region_prev == NULL )
         {
@@ -723,9 +841,18 @@ static subpicture_t *Filter( filter_t *p_filter, mtime_t date )
         p_region_prev = p_region;
     }
 
-    vlc_global_unlock( VLC_MOSAIC_MUTEX );
+    /* Keep the conversions for the next subpicture */
+    ReleaseTiles( p_sys->p_tiles, p_sys->i_tiles );
+    free( p_sys->p_tiles );
+    p_sys->p_tiles = p_tiles;
+    p_sys->i_tiles = i_tiles;
+
     vlc_mutex_unlock( &p_sys->lock );
 
+    for( int i_input = 0; i_input < i_inputs; i_input++ )
+        picture_Release( p_inputs[i_input].p_picture );
+    free( p_inputs );
+
     return p_spu;
 }
 
@@ -34,6 +34,8 @@
 #include <vlc_stream.h>
 #include <vlc_interrupt.h>
 
+#include "cache_shared.h"
+
 /* TODO:
  *  - tune the 2 methods (block/stream)
  *  - compute cost for seek
@@ -59,6 +61,9 @@
  * efficient demux probing */
 #define STREAM_CACHE_PREBUFFER_SIZE (128)
 
+/* Size of the blocks read from the shared cache */
+#define STREAM_CACHE_SHARED_BLOCK_SIZE (1 << 16)
+
 /* Method: Simple, for pf_block.
  *  We get blocks and put them in the linked list.
  *  We release blocks once the total size is bigger than STREAM_CACHE_SIZE
@@ -76,6 +81,8 @@ struct stream_sys_t
     block_t     *p_first;
     block_t    **pp_last;
 
+    stream_cache_shared_t *shared;
+
     struct
     {
         /* Stat about reading data */
@@ -85,6 +92,40 @@ struct stream_sys_t
     } stat;
 };
 
+/* Reads from the cache shared with other streams, then from the source */
+static block_t *AStreamReadSource(stream_t *s)
+{
+    stream_sys_t *sys = s->p_sys;
+    uint64_t i_pos = sys->i_start + sys->i_size;
+
+    if (sys->shared == NULL)
+        return vlc_stream_ReadBlock(s->p_source);
+
+    block_t *b = block_Alloc(STREAM_CACHE_SHARED_BLOCK_SIZE);
+    if (likely(b != NULL))
+    {
+        b->i_buffer = stream_CacheSharedRead(sys->shared, i_pos, b->p_buffer,
+                                             b->i_buffer);
+        if (b->i_buffer > 0)
+            return b;
+        block_Release(b);
+    }
+
+    if (stream_CacheSharedSync(s->p_source, i_pos))
+    {
+        msg_Err(s, "cannot resume after shared data");
+        return NULL;
+    }
+
+    b = vlc_stream_ReadBlock(s->p_source);
+    for (block_t *p = b; p != NULL; p = p->p_next)
+    {
+        stream_CacheSharedPut(sys->shared, i_pos, p->p_buffer, p->i_buffer);
+        i_pos += p->i_buffer;
+    }
+    return b;
+}
+
 static int AStreamRefillBlock(stream_t *s)
 {
     stream_sys_t *sys = s->p_sys;
@@ -119,7 +160,7 @@ static int AStreamRefillBlock(stream_t *s)
             return VLC_EGENERIC;
 
         /* Fetch a block */
-        if ((b = vlc_stream_ReadBlock(s->p_source)))
+        if ((b = AStreamReadSource(s)))
             break;
         if (vlc_stream_Eof(s->p_source))
             return VLC_EGENERIC;
@@ -176,7 +217,7 @@ static void AStreamPrebufferBlock(stream_t *s)
         }
 
         /* Fetch a block */
-        block_t *b = vlc_stream_ReadBlock(s->p_source);
+        block_t *b = AStreamReadSource(s);
         if (b == NULL)
         {
             if (vlc_stream_Eof(s->p_source))
@@ -423,7 +464,17 @@ static int AStreamControl(stream_t *s, int i_query, va_list args)
         {
             int ret = vlc_stream_vaControl(s->p_source, i_query, args);
             if (ret == VLC_SUCCESS)
+            {
+                stream_sys_t *sys = s->p_sys;
+
+                /* Offsets now refer to another title */
+                if (sys->shared != NULL)
+                {
+                    stream_CacheSharedRelease(s, sys->shared);
+                    sys->shared = NULL;
+                }
                 AStreamControlReset(s);
+            }
             return ret;
         }
 
@@ -438,6 +489,14 @@ static int AStreamControl(stream_t *s, int i_query, va_list args)
 static int Open(vlc_object_t *obj)
 {
     stream_t *s = (stream_t *)obj;
+    bool fast_seek;
+
+    /* As in the prefetch filter, local files are better cached by the
+     * operating system. Blocks of memory mapped files then also reach the
+     * demuxers without any copy. */
+    if (vlc_stream_Control(s->p_source, STREAM_CAN_FASTSEEK, &fast_seek) == 0
+     && fast_seek)
+        return VLC_EGENERIC;
 
     stream_sys_t *sys = malloc(sizeof (*sys));
     if (unlikely(sys == NULL))
@@ -462,12 +521,17 @@ static int Open(vlc_object_t *obj)
     sys->pp_last = &sys->p_first;
 
     s->p_sys = sys;
+    sys->shared = stream_CacheSharedNew(s);
+
     /* Do the prebuffering */
     AStreamPrebufferBlock(s);
 
     if (sys->i_size <= 0)
     {
         msg_Err(s, "cannot pre fill buffer");
+        if (sys->shared != NULL)
+            stream_CacheSharedRelease(s, sys->shared);
+        block_ChainRelease(sys->p_first);
         free(sys);
         return VLC_EGENERIC;
     }
@@ -486,6 +550,8 @@ static void Close(vlc_object_t *obj)
     stream_t *s = (stream_t *)obj;
     stream_sys_t *sys = s->p_sys;
 
+    if (sys->shared != NULL)
+        stream_CacheSharedRelease(s, sys->shared);
     block_ChainRelease(sys->p_first);
     free(sys);
 }
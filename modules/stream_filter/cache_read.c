@@ -34,6 +34,8 @@
 #include <vlc_stream.h>
 #include <vlc_interrupt.h>
 
+#include "cache_shared.h"
+
 // #define STREAM_DEBUG 1
 
 /*
@@ -98,6 +100,8 @@ struct stream_sys_t
     unsigned     i_used; /* Used since last read */
     unsigned     i_read_size;
 
+    stream_cache_shared_t *shared;
+
     struct
     {
         /* Stat about reading data */
@@ -107,6 +111,31 @@ struct stream_sys_t
     } stat;
 };
 
+/* Reads from the cache shared with other streams, then from the source */
+static ssize_t AStreamReadSource(stream_t *s, uint64_t i_pos, void *buf,
+                                 size_t len)
+{
+    stream_sys_t *sys = s->p_sys;
+
+    if (sys->shared == NULL)
+        return vlc_stream_Read(s->p_source, buf, len);
+
+    size_t i_copy = stream_CacheSharedRead(sys->shared, i_pos, buf, len);
+    if (i_copy > 0)
+        return i_copy;
+
+    if (stream_CacheSharedSync(s->p_source, i_pos))
+    {
+        msg_Err(s, "cannot resume after shared data");
+        return 0;
+    }
+
+    ssize_t i_read = vlc_stream_Read(s->p_source, buf, len);
+    if (i_read > 0)
+        stream_CacheSharedPut(sys->shared, i_pos, buf, i_read);
+    return i_read;
+}
+
 static int AStreamRefillStream(stream_t *s)
 {
     stream_sys_t *sys = s->p_sys;
@@ -134,7 +163,7 @@ static int AStreamRefillStream(stream_t *s)
             return VLC_EGENERIC;
 
         i_read = __MIN(i_toread, STREAM_CACHE_TRACK_SIZE - i_off);
-        i_read = vlc_stream_Read(s->p_source, &tk->p_buffer[i_off], i_read);
+        i_read = AStreamReadSource(s, tk->i_end, &tk->p_buffer[i_off], i_read);
 
         /* msg_Dbg(s, "AStreamRefillStream: read=%d", i_read); */
         if (i_read <  0)
@@ -200,8 +229,8 @@ static void AStreamPrebufferStream(stream_t *s)
 
         i_read = STREAM_CACHE_TRACK_SIZE - i_buffered;
         i_read = __MIN((int)sys->i_read_size, i_read);
-        i_read = vlc_stream_Read(s->p_source, &tk->p_buffer[i_buffered],
-                                 i_read);
+        i_read = AStreamReadSource(s, tk->i_end, &tk->p_buffer[i_buffered],
+                                   i_read);
         if (i_read <  0)
             continue;
         else if (i_read == 0)
@@ -477,7 +506,17 @@ static int AStreamControl(stream_t *s, int i_query, va_list args)
         {
             int ret = vlc_stream_vaControl(s->p_source, i_query, args);
             if (ret == VLC_SUCCESS)
+            {
+                stream_sys_t *sys = s->p_sys;
+
+                /* Offsets now refer to another title */
+                if (sys->shared != NULL)
+                {
+                    stream_CacheSharedRelease(s, sys->shared);
+                    sys->shared = NULL;
+                }
                 AStreamControlReset(s);
+            }
             return ret;
         }
 
@@ -532,6 +571,7 @@ static int Open(vlc_object_t *obj)
     }
 
     s->p_sys = sys;
+    sys->shared = stream_CacheSharedNew(s);
 
     /* Do the prebuffering */
     AStreamPrebufferStream(s);
@@ -539,6 +579,8 @@ static int Open(vlc_object_t *obj)
     if (sys->tk[sys->i_tk].i_end <= 0)
     {
         msg_Err(s, "cannot pre fill buffer");
+        if (sys->shared != NULL)
+            stream_CacheSharedRelease(s, sys->shared);
         free(sys->p_buffer);
         free(sys);
         return VLC_EGENERIC;
@@ -558,6 +600,8 @@ static void Close(vlc_object_t *obj)
     stream_t *s = (stream_t *)obj;
     stream_sys_t *sys = s->p_sys;
 
+    if (sys->shared != NULL)
+        stream_CacheSharedRelease(s, sys->shared);
     free(sys->p_buffer);
     free(sys);
 }
@@ -0,0 +1,447 @@
+/*****************************************************************************
+ * cache_shared.c: stream cache shared between streams of a LibVLC instance
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_stream.h>
+#include <vlc_variables.h>
+
+#include "cache_shared.h"
+
+/* Size of the chunks, aligned on their offset */
+#define CACHE_CHUNK_SIZE (1 << 16)
+
+/* Memory budget of the cache, for all streams */
+#ifdef OPTIMIZE_MEMORY
+#   define CACHE_SHARED_SIZE (4*1024*1024)
+#else
+#   define CACHE_SHARED_SIZE (64*1024*1024)
+#endif
+
+/* LibVLC variable holding the cache, created under VLC_STREAM_CACHE_MUTEX */
+#define CACHE_SHARED_VAR "stream-cache-shared"
+
+struct cache_resource;
+
+struct cache_chunk
+{
+    struct cache_resource *res;
+    uint64_t offset;
+    size_t   length;
+    /* Least recently used list, most recent first */
+    struct cache_chunk *prev, *next;
+    uint8_t  data[];
+};
+
+struct cache_resource
+{
+    char    *url;
+    uint64_t size;
+    unsigned refs; /* open streams */
+
+    /* Sorted by offset */
+    size_t   count;
+    struct cache_chunk **chunks;
+};
+
+struct cache_shared
+{
+    unsigned refs; /* open streams, protected by VLC_STREAM_CACHE_MUTEX */
+
+    vlc_mutex_t lock;
+    size_t   used;
+    struct cache_chunk *first, *last;
+    int      resource_count;
+    struct cache_resource **resources;
+};
+
+struct stream_cache_shared
+{
+    struct cache_shared   *cache;
+    struct cache_resource *res;
+
+    /* Chunk being read from the source */
+    uint64_t pending_offset;
+    size_t   pending_length;
+    uint8_t *pending;
+
+    struct
+    {
+        uint64_t i_hit_bytes;
+        uint64_t i_put_bytes;
+    } stat;
+};
+
+static void ResourceDelete(struct cache_resource *res)
+{
+    assert(res->refs == 0 && res->count == 0);
+    free(res->chunks);
+    free(res->url);
+    free(res);
+}
+
+/* Finds the index of the chunk at the aligned offset, or of its successor */
+static size_t ResourceFind(const struct cache_resource *res, uint64_t offset)
+{
+    size_t lo = 0, hi = res->count;
+
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+
+        if (res->chunks[mid]->offset < offset)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static void LRUUnlink(struct cache_shared *cache, struct cache_chunk *chunk)
+{
+    if (chunk->prev != NULL)
+        chunk->prev->next = chunk->next;
+    else
+        cache->first = chunk->next;
+    if (chunk->next != NULL)
+        chunk->next->prev = chunk->prev;
+    else
+        cache->last = chunk->prev;
+}
+
+static void LRUPush(struct cache_shared *cache, struct cache_chunk *chunk)
+{
+    chunk->prev = NULL;
+    chunk->next = cache->first;
+    if (cache->first != NULL)
+        cache->first->prev = chunk;
+    else
+        cache->last = chunk;
+    cache->first = chunk;
+}
+
+static void ChunkEvict(struct cache_shared *cache, struct cache_chunk *chunk)
+{
+    struct cache_resource *res = chunk->res;
+    size_t idx = ResourceFind(res, chunk->offset);
+
+    assert(idx < res->count && res->chunks[idx] == chunk);
+    memmove(&res->chunks[idx], &res->chunks[idx + 1],
+            (res->count - idx - 1) * sizeof (*res->chunks));
+    res->count--;
+
+    LRUUnlink(cache, chunk);
+    cache->used -= chunk->length;
+    free(chunk);
+
+    if (res->refs == 0 && res->count == 0)
+    {
+        TAB_REMOVE(cache->resource_count, cache->resources, res);
+        ResourceDelete(res);
+    }
+}
+
+static void CacheDelete(struct cache_shared *cache)
+{
+    while (cache->last != NULL)
+        ChunkEvict(cache, cache->last);
+    assert(cache->resource_count == 0 && cache->used == 0);
+    TAB_CLEAN(cache->resource_count, cache->resources);
+    vlc_mutex_destroy(&cache->lock);
+    free(cache);
+}
+
+static void Publish(stream_cache_shared_t *h)
+{
+    struct cache_shared *cache = h->cache;
+    struct cache_resource *res = h->res;
+    struct cache_chunk *chunk = malloc(sizeof (*chunk) + h->pending_length);
+
+    if (unlikely(chunk == NULL))
+        return;
+
+    chunk->res = res;
+    chunk->offset = h->pending_offset;
+    chunk->length = h->pending_length;
+    memcpy(chunk->data, h->pending, h->pending_length);
+
+    vlc_mutex_lock(&cache->lock);
+    size_t idx = ResourceFind(res, chunk->offset);
+    if (idx < res->count && res->chunks[idx]->offset == chunk->offset)
+        goto drop; /* read by another stream meanwhile */
+
+    struct cache_chunk **tab = realloc(res->chunks,
+                                       (res->count + 1) * sizeof (*tab));
+    if (unlikely(tab == NULL))
+        goto drop;
+
+    memmove(&tab[idx + 1], &tab[idx], (res->count - idx) * sizeof (*tab));
+    tab[idx] = chunk;
+    res->chunks = tab;
+    res->count++;
+
+    LRUPush(cache, chunk);
+    cache->used += chunk->length;
+    h->stat.i_put_bytes += chunk->length;
+
+    while (cache->used > CACHE_SHARED_SIZE)
+        ChunkEvict(cache, cache->last);
+    vlc_mutex_unlock(&cache->lock);
+    return;
+
+drop:
+    vlc_mutex_unlock(&cache->lock);
+    free(chunk);
+}
+
+static struct cache_shared *CacheHold(vlc_object_t *libvlc)
+{
+    struct cache_shared *cache;
+
+    vlc_global_lock(VLC_STREAM_CACHE_MUTEX);
+    if (var_Create(libvlc, CACHE_SHARED_VAR, VLC_VAR_ADDRESS))
+    {
+        vlc_global_unlock(VLC_STREAM_CACHE_MUTEX);
+        return NULL;
+    }
+
+    cache = var_GetAddress(libvlc, CACHE_SHARED_VAR);
+    if (cache == NULL)
+    {
+        cache = malloc(sizeof (*cache));
+        if (likely(cache != NULL))
+        {
+            cache->refs = 0;
+            vlc_mutex_init(&cache->lock);
+            cache->used = 0;
+            cache->first = cache->last = NULL;
+            TAB_INIT(cache->resource_count, cache->resources);
+            var_SetAddress(libvlc, CACHE_SHARED_VAR, cache);
+        }
+    }
+
+    if (likely(cache != NULL))
+        cache->refs++;
+    else
+        var_Destroy(libvlc, CACHE_SHARED_VAR);
+    vlc_global_unlock(VLC_STREAM_CACHE_MUTEX);
+    return cache;
+}
+
+static void CacheRelease(vlc_object_t *libvlc, struct cache_shared *cache)
+{
+    vlc_global_lock(VLC_STREAM_CACHE_MUTEX);
+    assert(cache->refs > 0);
+    if (--cache->refs == 0)
+    {
+        var_SetAddress(libvlc, CACHE_SHARED_VAR, NULL);
+        CacheDelete(cache);
+    }
+    var_Destroy(libvlc, CACHE_SHARED_VAR);
+    vlc_global_unlock(VLC_STREAM_CACHE_MUTEX);
+}
+
+stream_cache_shared_t *stream_CacheSharedNew(stream_t *s)
+{
+    stream_t *source = s->p_source;
+    bool can_seek;
+    uint64_t size;
+
+    /* The cached data must still match the resource, and the source must be
+     * able to resume after data read from the cache */
+    if (s->psz_url == NULL
+     || vlc_stream_Control(source, STREAM_CAN_SEEK, &can_seek) || !can_seek
+     || vlc_stream_GetSize(source, &size) || size == 0)
+        return NULL;
+
+    stream_cache_shared_t *h = malloc(sizeof (*h));
+    if (unlikely(h == NULL))
+        return NULL;
+
+    h->pending = malloc(CACHE_CHUNK_SIZE);
+    h->cache = CacheHold(VLC_OBJECT(s->obj.libvlc));
+    if (unlikely(h->pending == NULL || h->cache == NULL))
+        goto error;
+
+    h->pending_offset = 0;
+    h->pending_length = 0;
+    h->stat.i_hit_bytes = 0;
+    h->stat.i_put_bytes = 0;
+
+    struct cache_shared *cache = h->cache;
+    struct cache_resource *res = NULL;
+
+    vlc_mutex_lock(&cache->lock);
+    for (int i = 0; i < cache->resource_count; i++)
+    {
+        struct cache_resource *cand = cache->resources[i];
+
+        if (cand->size == size && !strcmp(cand->url, s->psz_url))
+        {
+            res = cand;
+            break;
+        }
+    }
+
+    if (res == NULL)
+    {
+        res = malloc(sizeof (*res));
+        if (likely(res != NULL))
+        {
+            res->url = strdup(s->psz_url);
+            res->size = size;
+            res->refs = 0;
+            res->count = 0;
+            res->chunks = NULL;
+            if (likely(res->url != NULL))
+                TAB_APPEND(cache->resource_count, cache->resources, res);
+            else
+            {
+                free(res);
+                res = NULL;
+            }
+        }
+    }
+    else
+        msg_Dbg(s, "sharing %zu cached chunks", res->count);
+
+    if (likely(res != NULL))
+        res->refs++;
+    vlc_mutex_unlock(&cache->lock);
+
+    if (unlikely(res == NULL))
+        goto error;
+    h->res = res;
+    return h;
+
+error:
+    if (h->cache != NULL)
+        CacheRelease(VLC_OBJECT(s->obj.libvlc), h->cache);
+    free(h->pending);
+    free(h);
+    return NULL;
+}
+
+void stream_CacheSharedRelease(stream_t *s, stream_cache_shared_t *h)
+{
+    struct cache_shared *cache = h->cache;
+    struct cache_resource *res = h->res;
+
+    msg_Dbg(s, "shared cache: %"PRIu64" bytes hit, %"PRIu64" bytes shared",
+            h->stat.i_hit_bytes, h->stat.i_put_bytes);
+
+    vlc_mutex_lock(&cache->lock);
+    assert(res->refs > 0);
+    if (--res->refs == 0 && res->count == 0)
+    {
+        TAB_REMOVE(cache->resource_count, cache->resources, res);
+        ResourceDelete(res);
+    }
+    vlc_mutex_unlock(&cache->lock);
+
+    CacheRelease(VLC_OBJECT(s->obj.libvlc), cache);
+    free(h->pending);
+    free(h);
+}
+
+size_t stream_CacheSharedRead(stream_cache_shared_t *h, uint64_t offset,
+                              void *buf, size_t len)
+{
+    struct cache_shared *cache = h->cache;
+    struct cache_resource *res = h->res;
+    uint64_t chunk_offset = offset - (offset % CACHE_CHUNK_SIZE);
+    size_t copy = 0;
+
+    vlc_mutex_lock(&cache->lock);
+    size_t idx = ResourceFind(res, chunk_offset);
+    if (idx < res->count && res->chunks[idx]->offset == chunk_offset)
+    {
+        struct cache_chunk *chunk = res->chunks[idx];
+        size_t skip = offset - chunk_offset;
+
+        if (skip < chunk->length)
+        {
+            copy = __MIN(len, chunk->length - skip);
+            memcpy(buf, &chunk->data[skip], copy);
+
+            LRUUnlink(cache, chunk);
+            LRUPush(cache, chunk);
+        }
+    }
+    vlc_mutex_unlock(&cache->lock);
+
+    h->stat.i_hit_bytes += copy;
+    return copy;
+}
+
+void stream_CacheSharedPut(stream_cache_shared_t *h, uint64_t offset,
+                           const void *buf, size_t len)
+{
+    const uint8_t *p = buf;
+
+    while (len > 0)
+    {
+        if (offset != h->pending_offset + h->pending_length
+         || h->pending_length == 0)
+        {   /* Not contiguous: restart at the next chunk boundary */
+            size_t skip = (CACHE_CHUNK_SIZE - offset % CACHE_CHUNK_SIZE)
+                        % CACHE_CHUNK_SIZE;
+            if (skip >= len)
+            {
+                h->pending_length = 0;
+                return;
+            }
+            offset += skip;
+            p += skip;
+            len -= skip;
+            h->pending_offset = offset;
+            h->pending_length = 0;
+        }
+
+        size_t copy = __MIN(len, CACHE_CHUNK_SIZE - h->pending_length);
+        memcpy(&h->pending[h->pending_length], p, copy);
+        h->pending_length += copy;
+        offset += copy;
+        p += copy;
+        len -= copy;
+
+        if (h->pending_length == CACHE_CHUNK_SIZE
+         || h->pending_offset + h->pending_length >= h->res->size)
+        {
+            Publish(h);
+            h->pending_offset += h->pending_length;
+            h->pending_length = 0;
+        }
+    }
+}
+
+int stream_CacheSharedSync(stream_t *source, uint64_t offset)
+{
+    if (vlc_stream_Tell(source) == offset)
+        return VLC_SUCCESS;
+    return vlc_stream_Seek(source, offset);
+}
@@ -0,0 +1,64 @@
+/*****************************************************************************
+ * cache_shared.h: stream cache shared between streams of a LibVLC instance
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_CACHE_SHARED_H
+#define VLC_CACHE_SHARED_H
+
+/* The preparser, the thumbnailer and the player often open the same
+ * resource at the same time. Data read from the source by one stream is
+ * kept in chunks, keyed by URL and offset, where the other streams of the
+ * same LibVLC instance find it instead of reading it again. The chunks are
+ * released in least recently used order past a memory budget, and all of
+ * them once no streams use the cache anymore. */
+
+typedef struct stream_cache_shared stream_cache_shared_t;
+
+/**
+ * Joins the shared cache for the source of a stream filter.
+ *
+ * @return NULL if the source cannot be shared, e.g. as it is not seekable
+ */
+stream_cache_shared_t *stream_CacheSharedNew(stream_t *);
+void stream_CacheSharedRelease(stream_t *, stream_cache_shared_t *);
+
+/**
+ * Copies cached data.
+ *
+ * @return the number of bytes copied, at most up to the end of a chunk,
+ * or 0 if there is no data at that offset
+ */
+size_t stream_CacheSharedRead(stream_cache_shared_t *, uint64_t offset,
+                              void *buf, size_t len);
+
+/**
+ * Stores data read from the source.
+ *
+ * Only contiguous data covering whole chunks is shared.
+ */
+void stream_CacheSharedPut(stream_cache_shared_t *, uint64_t offset,
+                           const void *buf, size_t len);
+
+/**
+ * Moves the source to the offset, as data may have been read from the cache
+ * instead of the source meanwhile.
+ */
+int stream_CacheSharedSync(stream_t *source, uint64_t offset);
+
+#endif
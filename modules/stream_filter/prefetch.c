@@ -35,6 +35,16 @@
 #include <vlc_fs.h>
 #include <vlc_interrupt.h>
 
+/* Cached range of the source stream, in a circular buffer */
+struct prefetch_window
+{
+    char        *buffer;
+    size_t       size;
+    uint64_t     offset; /* of the first buffered byte */
+    size_t       length;
+    mtime_t      last_used;
+};
+
 struct stream_sys_t
 {
     vlc_mutex_t  lock;
@@ -54,13 +64,24 @@ struct stream_sys_t
     int64_t      pts_delay;
     char        *content_type;
 
-    uint64_t     buffer_offset;
+    struct prefetch_window *windows;
+    struct prefetch_window *window; /* active, where the stream is read */
+    unsigned     window_count;
+    uint64_t     upstream_offset;
     uint64_t     stream_offset;
-    size_t       buffer_length;
-    size_t       buffer_size;
-    char        *buffer;
+    size_t       buffer_size; /* largest window */
     size_t       read_size;
     size_t       seek_threshold;
+
+    /* Read rate, in bytes per second */
+    uint64_t     rate;
+    uint64_t     rate_bytes;
+    mtime_t      rate_date;
+
+    /* Statistics */
+    uint64_t     hits;
+    uint64_t     misses;
+    uint64_t     upstream_seeks;
 };
 
 static ssize_t ThreadRead(stream_t *stream, void *buf, size_t length)
@@ -117,6 +138,99 @@ static int ThreadControl(stream_t *stream, int query, ...)
 #define MAX_READ 65536
 #define SEEK_THRESHOLD MAX_READ
 
+/* Windows are sized to hold that many seconds of reading, as there is little
+ * point prefetching more ahead of the next seek */
+#define WINDOW_SECONDS 8
+
+/**
+ * Makes the window holding data at the given offset the active one.
+ */
+static bool WindowSelect(stream_sys_t *sys, uint64_t offset)
+{
+    for (unsigned i = 0; i < sys->window_count; i++)
+    {
+        struct prefetch_window *w = &sys->windows[i];
+
+        if (offset >= w->offset && offset - w->offset < w->length)
+        {
+            sys->window = w;
+            w->last_used = mdate();
+            return true;
+        }
+    }
+    return false;
+}
+
+static size_t WindowSize(const stream_sys_t *sys, uint64_t offset)
+{
+    size_t size = sys->buffer_size;
+
+    /* Adapt to the read rate, once it is known */
+    if (sys->rate > 0 && sys->rate < size / WINDOW_SECONDS)
+        size = sys->rate * WINDOW_SECONDS;
+    if (size < 4 * sys->read_size)
+        size = __MIN(4 * sys->read_size, sys->buffer_size);
+
+    /* Do not overlap the next cached range, e.g. after interleaved seeks */
+    for (unsigned i = 0; i < sys->window_count; i++)
+    {
+        const struct prefetch_window *w = &sys->windows[i];
+
+        if (w->length > 0 && w->offset > offset && w->offset - offset < size)
+            size = w->offset - offset;
+    }
+
+    /* Do not go past the end, e.g. for an index at the end of the file */
+    if (sys->size != (uint64_t)-1 && offset < sys->size
+     && sys->size - offset < size)
+        size = sys->size - offset;
+
+    return size;
+}
+
+/**
+ * Starts a new window at the given offset.
+ *
+ * It reuses the least recently used window, other than the active one, so
+ * that the play position survives a seek to the index.
+ */
+static struct prefetch_window *WindowNew(stream_t *stream, uint64_t offset)
+{
+    stream_sys_t *sys = stream->p_sys;
+    struct prefetch_window *w = NULL;
+
+    for (unsigned i = 0; i < sys->window_count; i++)
+    {
+        struct prefetch_window *cand = &sys->windows[i];
+
+        if (cand == sys->window && sys->window_count > 1)
+            continue;
+        if (w == NULL || cand->last_used < w->last_used)
+            w = cand;
+    }
+
+    size_t size = WindowSize(sys, offset);
+    if (size != w->size)
+    {   /* The content is discarded: no need to reallocate */
+        char *buffer = malloc(size);
+        if (likely(buffer != NULL))
+        {
+            free(w->buffer);
+            w->buffer = buffer;
+            w->size = size;
+        }
+        else if (w->buffer == NULL)
+            w = sys->window; /* keep using the active window buffer */
+    }
+
+    msg_Dbg(stream, "window of %zu bytes at offset %"PRIu64, w->size, offset);
+    w->offset = offset;
+    w->length = 0;
+    w->last_used = mdate();
+    sys->window = w;
+    return w;
+}
+
 static void *Thread(void *data)
 {
     stream_t *stream = data;
@@ -143,14 +257,36 @@ static void *Thread(void *data)
             continue;
         }
 
+        struct prefetch_window *w = sys->window;
         uint_fast64_t stream_offset = sys->stream_offset;
 
-        if (stream_offset < sys->buffer_offset)
-        {   /* Need to seek backward */
-            if (ThreadSeek(stream, stream_offset) == 0)
+        /* If the downstream offset is before the active window, or if
+         * upstream supports seeking and if the downstream offset is far
+         * beyond the active window, then read it into another window.
+         * The reader already switched to any window holding that offset. */
+        if (stream_offset < w->offset
+         || (sys->can_seek
+          && stream_offset - w->offset >= w->length + sys->seek_threshold))
+        {
+            WindowNew(stream, stream_offset);
+            continue;
+        }
+
+        uint64_t window_end = w->offset + w->length;
+
+        if (sys->upstream_offset != window_end)
+        {   /* Move upstream to the end of the active window.
+             * If it fails, assume upstream is well-behaved such that the
+             * failed seek is a no-op. We could read data instead until the
+             * desired seek offset. But in practice, not all upstream accesses
+             * handle reads after failed seek correctly. Furthermore,
+             * sys->stream_offset and/or sys->paused might have changed in the
+             * mean time.
+             * WARNING: Except problems with misbehaving access plug-ins. */
+            if (ThreadSeek(stream, window_end) == 0)
             {
-                sys->buffer_offset = stream_offset;
-                sys->buffer_length = 0;
+                sys->upstream_offset = window_end;
+                sys->upstream_seeks++;
                 assert(!sys->error);
                 sys->eof = false;
             }
@@ -168,43 +304,16 @@ static void *Thread(void *data)
             continue;
         }
 
-        assert(stream_offset >= sys->buffer_offset);
+        assert(stream_offset >= w->offset);
 
-        /* As long as there is space, the buffer will retain already read
+        /* As long as there is space, the window will retain already read
          * ("historical") data. The data can be used if/when seeking backward.
          * Unread data is however given precedence if the buffer is full. */
-        uint64_t history = stream_offset - sys->buffer_offset;
-
-        /* If upstream supports seeking and if the downstream offset is far
-         * beyond the upstream offset, then attempt to skip forward.
-         * If it fails, assume upstream is well-behaved such that the failed
-         * seek is a no-op, and continue as if seeking was not supported.
-         * WARNING: Except problems with misbehaving access plug-ins. */
-        if (sys->can_seek
-         && history >= (sys->buffer_length + sys->seek_threshold))
-        {
-            if (ThreadSeek(stream, stream_offset) == 0)
-            {
-                sys->buffer_offset = stream_offset;
-                sys->buffer_length = 0;
-                assert(!sys->error);
-                assert(!sys->eof);
-            }
-            else
-            {   /* Seek failure is not necessarily fatal here. We could read
-                 * data instead until the desired seek offset. But in practice,
-                 * not all upstream accesses handle reads after failed seek
-                 * correctly. Furthermore, sys->stream_offset and/or
-                 * sys->paused might have changed in the mean time. */
-                sys->error = true;
-                vlc_cond_signal(&sys->wait_data);
-            }
-            continue;
-        }
+        uint64_t history = stream_offset - w->offset;
 
-        assert(sys->buffer_size >= sys->buffer_length);
+        assert(w->size >= w->length);
 
-        size_t len = sys->buffer_size - sys->buffer_length;
+        size_t len = w->size - w->length;
         if (len == 0)
         {   /* Buffer is full */
             if (history == 0)
@@ -218,9 +327,9 @@ static void *Thread(void *data)
             if (len > sys->read_size)
                 len = sys->read_size;
 
-            assert(len <= sys->buffer_length);
-            sys->buffer_offset += len;
-            sys->buffer_length -= len;
+            assert(len <= w->length);
+            w->offset += len;
+            w->length -= len;
         }
         else
         {   /* Some streams cannot return a short data count and just wait for
@@ -231,13 +340,14 @@ static void *Thread(void *data)
                 len = sys->read_size;
         }
 
-        size_t offset = (sys->buffer_offset + sys->buffer_length)
-                        % sys->buffer_size;
+        size_t offset = (w->offset + w->length) % w->size;
          /* Do not step past the sharp edge of the circular buffer */
-        if (offset + len > sys->buffer_size)
-            len = sys->buffer_size - offset;
+        if (offset + len > w->size)
+            len = w->size - offset;
 
-        ssize_t val = ThreadRead(stream, sys->buffer + offset, len);
+        /* The reader may switch windows meanwhile, but only this thread
+         * recycles them: w remains valid */
+        ssize_t val = ThreadRead(stream, w->buffer + offset, len);
         if (val < 0)
             continue;
         if (val == 0)
@@ -248,10 +358,10 @@ static void *Thread(void *data)
         }
 
         assert((size_t)val <= len);
-        sys->buffer_length += val;
-        assert(sys->buffer_length <= sys->buffer_size);
-        //msg_Dbg(stream, "buffer: %zu/%zu", sys->buffer_length,
-        //        sys->buffer_size);
+        w->length += val;
+        sys->upstream_offset += val;
+        assert(w->length <= w->size);
+        //msg_Dbg(stream, "buffer: %zu/%zu", w->length, w->size);
         vlc_cond_signal(&sys->wait_data);
     }
     vlc_assert_unreachable();
@@ -264,6 +374,16 @@ static int Seek(stream_t *stream, uint64_t offset)
     stream_sys_t *sys = stream->p_sys;
 
     vlc_mutex_lock(&sys->lock);
+    if (offset != sys->stream_offset)
+    {
+        if (WindowSelect(sys, offset))
+            sys->hits++;
+        else
+        {
+            msg_Dbg(stream, "cache miss at offset %"PRIu64, offset);
+            sys->misses++;
+        }
+    }
     sys->stream_offset = offset;
     sys->error = false;
     vlc_cond_signal(&sys->wait_space);
@@ -274,17 +394,32 @@ static int Seek(stream_t *stream, uint64_t offset)
 static size_t BufferLevel(const stream_t *stream, bool *eof)
 {
     stream_sys_t *sys = stream->p_sys;
+    const struct prefetch_window *w = sys->window;
 
     *eof = false;
 
-    if (sys->stream_offset < sys->buffer_offset)
+    if (sys->stream_offset < w->offset)
         return 0;
-    if ((sys->stream_offset - sys->buffer_offset) >= sys->buffer_length)
+    if ((sys->stream_offset - w->offset) >= w->length)
     {
-        *eof = sys->eof;
+        *eof = sys->eof && sys->upstream_offset == w->offset + w->length;
         return 0;
     }
-    return sys->buffer_offset + sys->buffer_length - sys->stream_offset;
+    return w->offset + w->length - sys->stream_offset;
+}
+
+static void RateUpdate(stream_sys_t *sys, size_t length)
+{
+    mtime_t now = mdate();
+
+    sys->rate_bytes += length;
+    if (now - sys->rate_date < CLOCK_FREQ)
+        return;
+
+    uint64_t rate = sys->rate_bytes * CLOCK_FREQ / (now - sys->rate_date);
+    sys->rate = (sys->rate > 0) ? (3 * sys->rate + rate) / 4 : rate;
+    sys->rate_bytes = 0;
+    sys->rate_date = now;
 }
 
 static ssize_t Read(stream_t *stream, void *buf, size_t buflen)
@@ -314,20 +449,27 @@ static ssize_t Read(stream_t *stream, void *buf, size_t buflen)
             return 0;
         }
 
+        /* Continue in another window, if it has the data */
+        if (WindowSelect(sys, sys->stream_offset))
+            continue;
+
         vlc_interrupt_forward_start(sys->interrupt, data);
         vlc_cond_wait(&sys->wait_data, &sys->lock);
         vlc_interrupt_forward_stop(data);
     }
 
-    offset = sys->stream_offset % sys->buffer_size;
+    const struct prefetch_window *w = sys->window;
+
+    offset = sys->stream_offset % w->size;
     if (copy > buflen)
         copy = buflen;
     /* Do not step past the sharp edge of the circular buffer */
-    if (offset + copy > sys->buffer_size)
-        copy = sys->buffer_size - offset;
+    if (offset + copy > w->size)
+        copy = w->size - offset;
 
-    memcpy(buf, sys->buffer + offset, copy);
+    memcpy(buf, w->buffer + offset, copy);
     sys->stream_offset += copy;
+    RateUpdate(sys, copy);
     vlc_cond_signal(&sys->wait_space);
     vlc_mutex_unlock(&sys->lock);
     return copy;
@@ -446,9 +588,8 @@ static int Open(vlc_object_t *obj)
     sys->eof = false;
     sys->error = false;
     sys->paused = false;
-    sys->buffer_offset = 0;
+    sys->upstream_offset = 0;
     sys->stream_offset = 0;
-    sys->buffer_length = 0;
     sys->buffer_size = var_InheritInteger(obj, "prefetch-buffer-size") << 10u;
     sys->read_size = var_InheritInteger(obj, "prefetch-read-size");
     sys->seek_threshold = var_InheritInteger(obj, "prefetch-seek-threshold");
@@ -464,10 +605,26 @@ static int Open(vlc_object_t *obj)
     if (sys->buffer_size < sys->read_size)
         sys->buffer_size = sys->read_size;
 
-    sys->buffer = malloc(sys->buffer_size);
-    if (sys->buffer == NULL)
+    /* Without seeking, only the current position can be cached */
+    sys->window_count = sys->can_seek
+                      ? var_InheritInteger(obj, "prefetch-windows") : 1;
+    sys->windows = calloc(sys->window_count, sizeof (*sys->windows));
+    if (unlikely(sys->windows == NULL))
         goto error;
 
+    /* The first window is used until the read rate is known */
+    sys->window = &sys->windows[0];
+    sys->window->buffer = malloc(sys->buffer_size);
+    if (sys->window->buffer == NULL)
+        goto error;
+    sys->window->size = sys->buffer_size;
+    sys->window->last_used = mdate();
+
+    sys->rate = 0;
+    sys->rate_bytes = 0;
+    sys->rate_date = mdate();
+    sys->hits = sys->misses = sys->upstream_seeks = 0;
+
     sys->interrupt = vlc_interrupt_create();
     if (unlikely(sys->interrupt == NULL))
         goto error;
@@ -487,15 +644,17 @@ static int Open(vlc_object_t *obj)
         goto error;
     }
 
-    msg_Dbg(stream, "using %zu bytes buffer, %zu bytes read",
-            sys->buffer_size, sys->read_size);
+    msg_Dbg(stream, "using %u windows of up to %zu bytes, %zu bytes read",
+            sys->window_count, sys->buffer_size, sys->read_size);
     stream->pf_read = Read;
     stream->pf_readdir = ReadDir;
     stream->pf_control = Control;
     return VLC_SUCCESS;
 
 error:
-    free(sys->buffer);
+    if (sys->windows != NULL)
+        free(sys->windows[0].buffer);
+    free(sys->windows);
     free(sys->content_type);
     free(sys);
     return VLC_ENOMEM;
@@ -518,7 +677,13 @@ static void Close (vlc_object_t *obj)
     vlc_cond_destroy(&sys->wait_data);
     vlc_mutex_destroy(&sys->lock);
 
-    free(sys->buffer);
+    msg_Dbg(stream, "%"PRIu64" cache hits, %"PRIu64" misses, "
+            "%"PRIu64" upstream seeks, read rate %"PRIu64" bytes/s",
+            sys->hits, sys->misses, sys->upstream_seeks, sys->rate);
+
+    for (unsigned i = 0; i < sys->window_count; i++)
+        free(sys->windows[i].buffer);
+    free(sys->windows);
     free(sys->content_type);
     free(sys);
 }
@@ -540,4 +705,9 @@ vlc_module_begin()
     add_integer("prefetch-seek-threshold", 1 << 14, N_("Seek threshold"),
                 N_("Prefetch forward seek threshold (bytes)"), true)
         change_integer_range(0, UINT64_C(1) << 60)
+    add_integer("prefetch-windows", 3, N_("Cached ranges"),
+                N_("Number of recently used stream ranges kept in memory, "
+                   "such as the playback position and the file index "
+                   "(each up to the buffer size)"), true)
+        change_integer_range(1, 16)
 vlc_module_end()
@@ -32,10 +32,14 @@
 #include <vlc_plugin.h>
 
 #include <assert.h>
+#include <fcntl.h>
+#include <vlc_block.h>
 #include <vlc_stream.h>
 #include <vlc_input.h>
 #include <vlc_fs.h>
 
+#include "../access_output/file_writer.h"
+
 
 /*****************************************************************************
  * Module descriptor
@@ -43,11 +47,30 @@
 static int  Open ( vlc_object_t * );
 static void Close( vlc_object_t * );
 
+#define BUFFER_TEXT N_("Record buffer size (MiB)")
+#define BUFFER_LONGTEXT N_( "Data queued in memory at most, while the " \
+    "disk is slow.")
+#define DROP_TEXT N_("Drop data when the buffer is full")
+#define DROP_LONGTEXT N_( "Drop the recorded data instead of stalling the " \
+    "playback, when the disk is too slow.")
+#define PREALLOC_TEXT N_("Record preallocation (MiB)")
+#define PREALLOC_LONGTEXT N_( "Allocate disk space ahead of the writes, " \
+    "to reduce fragmentation. 0 disables preallocation.")
+#define DIRECT_TEXT N_("Direct record writing")
+#define DIRECT_LONGTEXT N_( "Bypass the page cache for the recordings, " \
+    "if supported.")
+
 vlc_module_begin()
     set_category( CAT_INPUT )
     set_subcategory( SUBCAT_INPUT_STREAM_FILTER )
     set_description( N_("Internal stream record") )
     set_capability( "stream_filter", 0 )
+    add_integer_with_range( "record-buffer", 32, 1, 1024,
+                            BUFFER_TEXT, BUFFER_LONGTEXT, true )
+    add_bool( "record-drop", true, DROP_TEXT, DROP_LONGTEXT, true )
+    add_integer_with_range( "record-prealloc", 0, 0, 1024,
+                            PREALLOC_TEXT, PREALLOC_LONGTEXT, true )
+    add_bool( "record-direct", false, DIRECT_TEXT, DIRECT_LONGTEXT, true )
     set_callbacks( Open, Close )
 vlc_module_end()
 
@@ -56,7 +79,8 @@ vlc_module_end()
  *****************************************************************************/
 struct stream_sys_t
 {
-    FILE *f;        /* TODO it could be replaced by access_output_t one day */
+    int fd;
+    file_writer_t *writer; /* writes from a thread, NULL if not recording */
     bool b_error;
 };
 
@@ -85,7 +109,7 @@ static int Open ( vlc_object_t *p_this )
     if( !p_sys )
         return VLC_ENOMEM;
 
-    p_sys->f = NULL;
+    p_sys->writer = NULL;
 
     /* */
     s->pf_read = Read;
@@ -104,7 +128,7 @@ static void Close( vlc_object_t *p_this )
     stream_t *s = (stream_t*)p_this;
     stream_sys_t *p_sys = s->p_sys;
 
-    if( p_sys->f )
+    if( p_sys->writer )
         Stop( s );
 
     free( p_sys );
@@ -120,7 +144,7 @@ static ssize_t Read( stream_t *s, void *p_read, size_t i_read )
     const ssize_t i_record = vlc_stream_Read( s->p_source, p_record, i_read );
 
     /* Dump read data */
-    if( p_sys->f )
+    if( p_sys->writer )
     {
         if( p_record && i_record > 0 )
             Write( s, p_record, i_record );
@@ -145,7 +169,7 @@ static int Control( stream_t *s, int i_query, va_list args )
     if( b_active )
         psz_extension = va_arg( args, const char* );
 
-    if( !sys->f == !b_active )
+    if( !sys->writer == !b_active )
         return VLC_SUCCESS;
 
     if( b_active )
@@ -162,7 +186,7 @@ static int Start( stream_t *s, const char *psz_extension )
     stream_sys_t *p_sys = s->p_sys;
 
     char *psz_file;
-    FILE *f;
+    int fd;
 
     /* */
     if( !psz_extension )
@@ -185,13 +209,30 @@ static int Start( stream_t *s, const char *psz_extension )
     if( !psz_file )
         return VLC_ENOMEM;
 
-    f = vlc_fopen( psz_file, "wb" );
-    if( !f )
+    fd = vlc_open( psz_file, O_WRONLY | O_CREAT | O_TRUNC, 0666 );
+    if( fd == -1 )
     {
         free( psz_file );
         return VLC_EGENERIC;
     }
 
+    /* Slow disks must not stall the playback: the data is written from a
+     * thread, and dropped by default if the disk cannot keep up */
+    const file_writer_cfg_t cfg = {
+        .i_queue_max = (size_t)var_InheritInteger( s, "record-buffer" ) << 20,
+        .b_drop = var_InheritBool( s, "record-drop" ),
+        .b_direct = var_InheritBool( s, "record-direct" ),
+        .i_prealloc = (uint64_t)var_InheritInteger( s, "record-prealloc" ) << 20,
+    };
+    file_writer_t *writer = file_writer_New( VLC_OBJECT(s), fd, &cfg );
+    if( writer == NULL )
+    {
+        vlc_close( fd );
+        vlc_unlink( psz_file );
+        free( psz_file );
+        return VLC_ENOMEM;
+    }
+
     /* signal new record file */
     var_SetString( s->obj.libvlc, "record-file", psz_file );
 
@@ -199,7 +240,8 @@ static int Start( stream_t *s, const char *psz_extension )
     free( psz_file );
 
     /* */
-    p_sys->f = f;
+    p_sys->fd = fd;
+    p_sys->writer = writer;
     p_sys->b_error = false;
     return VLC_SUCCESS;
 }
@@ -207,11 +249,12 @@ static int Stop( stream_t *s )
 {
     stream_sys_t *p_sys = s->p_sys;
 
-    assert( p_sys->f );
+    assert( p_sys->writer );
 
+    file_writer_Delete( p_sys->writer );
+    vlc_close( p_sys->fd );
+    p_sys->writer = NULL;
     msg_Dbg( s, "Recording completed" );
-    fclose( p_sys->f );
-    p_sys->f = NULL;
     return VLC_SUCCESS;
 }
 
@@ -219,19 +262,23 @@ static void Write( stream_t *s, const uint8_t *p_buffer, size_t i_buffer )
 {
     stream_sys_t *p_sys = s->p_sys;
 
-    assert( p_sys->f );
+    assert( p_sys->writer );
 
-    if( i_buffer > 0 )
+    if( i_buffer > 0 && !p_sys->b_error )
     {
-        const bool b_previous_error = p_sys->b_error;
-        const size_t i_written = fwrite( p_buffer, 1, i_buffer, p_sys->f );
+        block_t *p_block = block_Alloc( i_buffer );
 
-        p_sys->b_error = i_written != i_buffer;
+        if( p_block != NULL )
+        {
+            memcpy( p_block->p_buffer, p_buffer, i_buffer );
+            /* Write errors are not recoverable, the writer stops writing */
+            p_sys->b_error = file_writer_Write( p_sys->writer, p_block ) < 0;
+        }
+        else
+            p_sys->b_error = true;
 
         /* TODO maybe a intf_UserError or something like that ? */
-        if( p_sys->b_error && !b_previous_error )
-            msg_Err( s, "Failed to record data (begin)" );
-        else if( !p_sys->b_error && b_previous_error )
-            msg_Err( s, "Failed to record data (end)" );
+        if( p_sys->b_error )
+            msg_Err( s, "Failed to record data" );
     }
 }
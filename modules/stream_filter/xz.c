@@ -0,0 +1,445 @@
+/*****************************************************************************
+ * xz.c: xz decompression stream filter
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <string.h>
+#include <lzma.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_stream.h>
+#include <vlc_cpu.h>
+
+/* Sequential reads decode the whole file, with several threads if the
+ * blocks record their sizes in their headers (as written with xz -T).
+ * Seeking locates the target block from the index at the end of the file,
+ * then decodes that block alone from its start. */
+
+struct stream_sys_t
+{
+    lzma_stream strm;
+    uint64_t offset; /**< uncompressed read position */
+    bool eof;
+
+    lzma_index *index;
+    bool index_failed;
+    lzma_index_iter iter; /**< current block, if decoding a single block */
+    lzma_block block_info; /**< used by the block decoder while it runs */
+    bool block;
+
+    uint8_t buffer[65536];
+};
+
+static int StreamStart(stream_t *stream)
+{
+    stream_sys_t *sys = stream->p_sys;
+    lzma_mt mt = {
+        .flags = LZMA_CONCATENATED,
+        .threads = vlc_GetCPUCount(),
+        /* Threads buffer whole blocks: bound that like xz does */
+        .memlimit_threading = lzma_physmem() / 4,
+        .memlimit_stop = UINT64_MAX,
+    };
+
+    if (mt.memlimit_threading == 0)
+        mt.memlimit_threading = 64 << 20;
+    lzma_ret ret = lzma_stream_decoder_mt(&sys->strm, &mt);
+    if (ret != LZMA_OK)
+        return (ret == LZMA_MEM_ERROR) ? VLC_ENOMEM : VLC_EGENERIC;
+
+    sys->strm.avail_in = 0;
+    sys->offset = 0;
+    sys->eof = false;
+    sys->block = false;
+    return VLC_SUCCESS;
+}
+
+/**
+ * Starts decoding the block located by the index iterator.
+ */
+static int BlockStart(stream_t *stream)
+{
+    stream_sys_t *sys = stream->p_sys;
+    const lzma_index_iter *iter = &sys->iter;
+    lzma_filter filters[LZMA_FILTERS_MAX + 1];
+    lzma_block *block = &sys->block_info;
+
+    *block = (lzma_block) {
+        .version = 1,
+        .check = iter->stream.flags->check,
+        .filters = filters,
+    };
+
+    if (vlc_stream_Seek(stream->p_source, iter->block.compressed_file_offset)
+     || vlc_stream_Read(stream->p_source, sys->buffer, 1) < 1)
+        return VLC_EGENERIC;
+
+    block->header_size = lzma_block_header_size_decode(sys->buffer[0]);
+    if (vlc_stream_Read(stream->p_source, sys->buffer + 1,
+                        block->header_size - 1) < block->header_size - 1
+     || lzma_block_header_decode(block, NULL, sys->buffer) != LZMA_OK)
+        return VLC_EGENERIC;
+
+    lzma_ret ret = LZMA_DATA_ERROR;
+
+    if (lzma_block_compressed_size(block,
+                                   iter->block.unpadded_size) == LZMA_OK)
+        ret = lzma_block_decoder(&sys->strm, block);
+    /* The decoder made its own copy of the filter chain */
+    for (unsigned i = 0; filters[i].id != LZMA_VLI_UNKNOWN; i++)
+        free(filters[i].options);
+    block->filters = NULL;
+
+    if (ret != LZMA_OK)
+    {
+        msg_Err(stream, "cannot decode block at %"PRIu64,
+                (uint64_t)iter->block.compressed_file_offset);
+        return VLC_EGENERIC;
+    }
+
+    sys->strm.avail_in = 0;
+    sys->offset = iter->block.uncompressed_file_offset;
+    sys->eof = false;
+    sys->block = true;
+    return VLC_SUCCESS;
+}
+
+/**
+ * Reads the index of all the streams in the file.
+ *
+ * The source position is kept.
+ */
+static int IndexLoad(stream_t *stream)
+{
+    stream_sys_t *sys = stream->p_sys;
+    uint64_t size, pos;
+    bool can_seek;
+
+    if (sys->index != NULL)
+        return VLC_SUCCESS;
+    if (sys->index_failed)
+        return VLC_EGENERIC;
+    sys->index_failed = true;
+
+    if (vlc_stream_Control(stream->p_source, STREAM_CAN_SEEK, &can_seek)
+     || !can_seek || vlc_stream_GetSize(stream->p_source, &size) || size == 0)
+        return VLC_EGENERIC;
+
+    lzma_stream strm = LZMA_STREAM_INIT;
+    uint8_t *buf = malloc(4096);
+    int val = VLC_EGENERIC;
+
+    if (unlikely(buf == NULL))
+        return VLC_ENOMEM;
+    if (lzma_file_info_decoder(&strm, &sys->index, UINT64_MAX, size)
+                                                                  != LZMA_OK)
+        goto out;
+
+    /* The decoder reads the first stream header, then seeks backward from
+     * the end of the file. */
+    pos = vlc_stream_Tell(stream->p_source);
+    if (vlc_stream_Seek(stream->p_source, 0))
+        goto out;
+
+    for (;;)
+    {
+        if (strm.avail_in == 0)
+        {
+            ssize_t len = vlc_stream_Read(stream->p_source, buf, 4096);
+            if (len <= 0)
+                break;
+            strm.next_in = buf;
+            strm.avail_in = len;
+        }
+
+        lzma_ret ret = lzma_code(&strm, LZMA_RUN);
+        if (ret == LZMA_SEEK_NEEDED)
+        {
+            if (vlc_stream_Seek(stream->p_source, strm.seek_pos))
+                break;
+            strm.avail_in = 0;
+        }
+        else if (ret == LZMA_STREAM_END)
+        {
+            val = VLC_SUCCESS;
+            break;
+        }
+        else if (ret != LZMA_OK)
+            break;
+    }
+
+    if (vlc_stream_Seek(stream->p_source, pos))
+        val = VLC_EGENERIC;
+out:
+    lzma_end(&strm);
+    free(buf);
+
+    if (val == VLC_SUCCESS)
+    {
+        msg_Dbg(stream, "%"PRIu64" blocks in %"PRIu64" streams",
+                (uint64_t)lzma_index_block_count(sys->index),
+                (uint64_t)lzma_index_stream_count(sys->index));
+        sys->index_failed = false;
+    }
+    else
+    {
+        msg_Warn(stream, "cannot read index, seeking will be slow");
+        lzma_index_end(sys->index, NULL);
+        sys->index = NULL;
+    }
+    return val;
+}
+
+static ssize_t Read(stream_t *stream, void *buf, size_t buflen)
+{
+    stream_sys_t *sys = stream->p_sys;
+
+    if (sys->eof || unlikely(buflen == 0))
+        return 0;
+
+    sys->strm.next_out = buf;
+    sys->strm.avail_out = buflen;
+
+    while (sys->strm.avail_out == buflen)
+    {
+        lzma_action action = LZMA_RUN;
+
+        if (sys->strm.avail_in == 0)
+        {
+            ssize_t val = vlc_stream_Read(stream->p_source, sys->buffer,
+                                          sizeof (sys->buffer));
+            if (val < 0)
+                return -1;
+            if (val == 0)
+                action = LZMA_FINISH;
+            sys->strm.next_in = sys->buffer;
+            sys->strm.avail_in = val;
+        }
+
+        lzma_ret ret = lzma_code(&sys->strm, action);
+        switch (ret)
+        {
+            case LZMA_OK:
+                continue;
+            case LZMA_STREAM_END:
+                if (sys->block
+                 && !lzma_index_iter_next(&sys->iter,
+                                          LZMA_INDEX_ITER_NONEMPTY_BLOCK))
+                {   /* Blocks are followed by the next block or by
+                     * the index; skip straight to the next block. */
+                    size_t len = buflen - sys->strm.avail_out;
+
+                    sys->offset += len;
+                    if (BlockStart(stream))
+                    {
+                        sys->eof = true;
+                        return len;
+                    }
+                    return (len > 0) ? (ssize_t)len
+                                     : Read(stream, buf, buflen);
+                }
+                msg_Dbg(stream, "end of stream");
+                sys->eof = true;
+                break;
+            case LZMA_BUF_ERROR:
+                msg_Err(stream, "unexpected end of stream");
+                sys->eof = true;
+                break;
+            case LZMA_MEM_ERROR:
+            case LZMA_MEMLIMIT_ERROR:
+                msg_Err(stream, "out of memory");
+                sys->eof = true;
+                return -1;
+            default:
+                msg_Err(stream, "corrupt stream (%d)", ret);
+                sys->eof = true;
+                return -1;
+        }
+        break;
+    }
+
+    size_t len = buflen - sys->strm.avail_out;
+    sys->offset += len;
+    return len;
+}
+
+static int ReadDir(stream_t *stream, input_item_node_t *node)
+{
+    (void) stream; (void) node;
+    return VLC_EGENERIC;
+}
+
+/**
+ * Decodes and discards data up to the offset.
+ */
+static int Skip(stream_t *stream, uint64_t offset)
+{
+    stream_sys_t *sys = stream->p_sys;
+    uint8_t *buf = malloc(65536);
+
+    if (unlikely(buf == NULL))
+        return -1;
+
+    while (sys->offset < offset)
+    {
+        size_t len = __MIN(offset - sys->offset, 65536);
+
+        if (Read(stream, buf, len) <= 0)
+            break;
+    }
+    free(buf);
+    return (sys->offset == offset) ? 0 : -1;
+}
+
+static int Seek(stream_t *stream, uint64_t offset)
+{
+    stream_sys_t *sys = stream->p_sys;
+
+    if (offset == sys->offset)
+        return 0;
+
+    if (IndexLoad(stream) == VLC_SUCCESS)
+    {
+        lzma_index_iter iter;
+
+        lzma_index_iter_init(&iter, sys->index);
+        if (lzma_index_iter_locate(&iter, offset))
+        {   /* Past the end */
+            sys->offset = offset;
+            sys->eof = true;
+            return 0;
+        }
+
+        if (!sys->block || offset < sys->offset
+         || iter.block.number_in_file != sys->iter.block.number_in_file)
+        {
+            sys->iter = iter;
+            if (BlockStart(stream))
+                return -1;
+        }
+        return Skip(stream, offset);
+    }
+
+    /* Without an index, decode again from the start */
+    if (offset < sys->offset || sys->eof)
+    {
+        if (vlc_stream_Seek(stream->p_source, 0) || StreamStart(stream))
+            return -1;
+    }
+    return Skip(stream, offset);
+}
+
+static int Control(stream_t *stream, int query, va_list args)
+{
+    stream_sys_t *sys = stream->p_sys;
+
+    switch (query)
+    {
+        case STREAM_CAN_SEEK:
+            return vlc_stream_vaControl(stream->p_source, query, args);
+        case STREAM_CAN_FASTSEEK:
+            *va_arg(args, bool *) = false;
+            break;
+        case STREAM_GET_SIZE:
+            if (IndexLoad(stream))
+                return VLC_EGENERIC;
+            *va_arg(args, uint64_t *) =
+                lzma_index_uncompressed_size(sys->index);
+            break;
+        case STREAM_CAN_PAUSE:
+        case STREAM_CAN_CONTROL_PACE:
+        case STREAM_GET_PTS_DELAY:
+        case STREAM_GET_META:
+        case STREAM_GET_CONTENT_TYPE:
+        case STREAM_GET_SIGNAL:
+        case STREAM_SET_PAUSE_STATE:
+            return vlc_stream_vaControl(stream->p_source, query, args);
+        case STREAM_IS_DIRECTORY:
+        case STREAM_GET_TITLE_INFO:
+        case STREAM_GET_TITLE:
+        case STREAM_GET_SEEKPOINT:
+        case STREAM_SET_TITLE:
+        case STREAM_SET_SEEKPOINT:
+        case STREAM_SET_PRIVATE_ID_STATE:
+        case STREAM_SET_PRIVATE_ID_CA:
+        case STREAM_GET_PRIVATE_ID_STATE:
+            return VLC_EGENERIC;
+        default:
+            msg_Err(stream, "unimplemented query (%d) in control", query);
+            return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+static int Open(vlc_object_t *obj)
+{
+    stream_t *stream = (stream_t *)obj;
+    const uint8_t *peek;
+
+    if (vlc_stream_Peek(stream->p_source, &peek, 6) < 6
+     || memcmp(peek, "\xFD" "7zXZ\x00", 6))
+        return VLC_EGENERIC;
+
+    stream_sys_t *sys = malloc(sizeof (*sys));
+    if (unlikely(sys == NULL))
+        return VLC_ENOMEM;
+
+    sys->strm = (lzma_stream)LZMA_STREAM_INIT;
+    sys->index = NULL;
+    sys->index_failed = false;
+    stream->p_sys = sys;
+
+    int ret = StreamStart(stream);
+    if (ret != VLC_SUCCESS)
+    {
+        lzma_end(&sys->strm);
+        free(sys);
+        return ret;
+    }
+
+    msg_Dbg(obj, "detected xz compressed stream");
+    stream->pf_read = Read;
+    stream->pf_readdir = ReadDir;
+    stream->pf_seek = Seek;
+    stream->pf_control = Control;
+    return VLC_SUCCESS;
+}
+
+static void Close (vlc_object_t *obj)
+{
+    stream_t *stream = (stream_t *)obj;
+    stream_sys_t *sys = stream->p_sys;
+
+    lzma_end(&sys->strm);
+    lzma_index_end(sys->index, NULL);
+    free(sys);
+}
+
+vlc_module_begin()
+    set_category(CAT_INPUT)
+    set_subcategory(SUBCAT_INPUT_STREAM_FILTER)
+    set_capability("stream_filter", 30)
+
+    set_description(N_("XZ decompression filter"))
+    set_callbacks(Open, Close)
+vlc_module_end()
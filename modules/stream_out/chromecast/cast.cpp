@@ -35,18 +35,38 @@
 #include <vlc_sout.h>
 
 #include <cassert>
+#include <map>
+
+/* Capabilities learned from the receivers, while the module is loaded */
+struct device_caps
+{
+    device_caps() : max_height( 0 ) {}
+
+    /* whether a codec and profile pair can be remuxed */
+    std::map<uint64_t, bool> codecs;
+    /* highest video resolution, 0 if unknown */
+    unsigned max_height;
+};
+
+static vlc_mutex_t caps_lock = VLC_STATIC_MUTEX;
+static std::map<std::string, device_caps> caps_cache;
 
 struct sout_stream_sys_t
 {
-    sout_stream_sys_t(intf_sys_t * const intf, bool has_video, int port,
+    sout_stream_sys_t(intf_sys_t * const intf, const char *psz_device,
+                      bool has_video, int port,
                       const char *psz_default_muxer, const char *psz_default_mime)
         : p_out(NULL)
         , default_muxer(psz_default_muxer)
         , default_mime(psz_default_mime)
         , p_intf(intf)
+        , device(psz_device)
         , b_supports_video(has_video)
         , i_port(port)
         , es_changed( true )
+        , transcode_audio( false )
+        , transcode_video( false )
+        , caps_checked( false )
     {
         assert(p_intf != NULL);
     }
@@ -57,9 +77,10 @@ struct sout_stream_sys_t
         delete p_intf;
     }
 
-    bool canDecodeVideo( vlc_fourcc_t i_codec ) const;
-    bool canDecodeAudio( vlc_fourcc_t i_codec ) const;
+    bool canDecodeVideo( const es_format_t * ) const;
+    bool canDecodeAudio( const es_format_t * ) const;
     bool startSoutChain(sout_stream_t* p_stream);
+    void checkReceiver( sout_stream_t * );
 
     sout_stream_t     *p_out;
     std::string        sout;
@@ -67,6 +88,7 @@ struct sout_stream_sys_t
     const std::string  default_mime;
 
     intf_sys_t * const p_intf;
+    const std::string  device;
     const bool b_supports_video;
     const int i_port;
 
@@ -77,6 +99,13 @@ struct sout_stream_sys_t
 
 private:
     void UpdateOutput( sout_stream_t * );
+    bool isRemuxed( const es_format_t * ) const;
+
+    /* tracks of the current output re-encoded for the receiver */
+    bool transcode_audio;
+    bool transcode_video;
+    /* whether the receiver played the current output */
+    bool caps_checked;
 };
 
 #define SOUT_CFG_PREFIX "sout-chromecast-"
@@ -197,22 +226,112 @@ static void Del(sout_stream_t *p_stream, sout_stream_id_sys_t *id)
 }
 
 
-bool sout_stream_sys_t::canDecodeVideo( vlc_fourcc_t i_codec ) const
+static uint64_t capsKey( const es_format_t *p_es )
+{
+    return ((uint64_t)p_es->i_codec << 32) | (uint32_t)p_es->i_profile;
+}
+
+/* The codecs only supported by some receivers are remuxed until the device
+ * fails to load them once */
+static bool canDecode( const std::string &device, const es_format_t *p_es )
+{
+    vlc_mutex_locker locker( &caps_lock );
+    const device_caps &caps = caps_cache[device];
+
+    if ( p_es->i_cat == VIDEO_ES && caps.max_height != 0 &&
+         p_es->video.i_height > caps.max_height )
+        return false;
+
+    std::map<uint64_t, bool>::const_iterator it = caps.codecs.find( capsKey( p_es ) );
+    return it == caps.codecs.end() || it->second;
+}
+
+bool sout_stream_sys_t::canDecodeVideo( const es_format_t *p_es ) const
+{
+    vlc_fourcc_t i_codec = p_es->i_codec;
+
+    if ( i_codec != VLC_CODEC_H264 && i_codec != VLC_CODEC_VP8 &&
+         i_codec != VLC_CODEC_HEVC && i_codec != VLC_CODEC_VP9 )
+        return false;
+    return canDecode( device, p_es );
+}
+
+bool sout_stream_sys_t::canDecodeAudio( const es_format_t *p_es ) const
+{
+    vlc_fourcc_t i_codec = p_es->i_codec;
+
+    if ( i_codec != VLC_CODEC_VORBIS &&
+         i_codec != VLC_CODEC_MP4A &&
+         i_codec != VLC_FOURCC('h', 'a', 'a', 'c') &&
+         i_codec != VLC_FOURCC('l', 'a', 'a', 'c') &&
+         i_codec != VLC_FOURCC('s', 'a', 'a', 'c') &&
+         i_codec != VLC_CODEC_OPUS &&
+         i_codec != VLC_CODEC_MP3 &&
+         i_codec != VLC_CODEC_A52 &&
+         i_codec != VLC_CODEC_EAC3 &&
+         i_codec != VLC_CODEC_FLAC )
+        return false;
+    return canDecode( device, p_es );
+}
+
+bool sout_stream_sys_t::isRemuxed( const es_format_t *p_es ) const
 {
-    return i_codec == VLC_CODEC_H264 || i_codec == VLC_CODEC_VP8;
+    if ( p_es->i_cat == AUDIO_ES )
+        return !transcode_audio;
+    return p_es->i_cat == VIDEO_ES && b_supports_video && !transcode_video;
 }
 
-bool sout_stream_sys_t::canDecodeAudio( vlc_fourcc_t i_codec ) const
+/* Learns from the receiver whether it can play the remuxed tracks. If it
+ * cannot, the output is restarted with the tracks it does not know yet, or
+ * with a smaller resolution, re-encoded. */
+void sout_stream_sys_t::checkReceiver( sout_stream_t *p_stream )
 {
-    return i_codec == VLC_CODEC_VORBIS ||
-        i_codec == VLC_CODEC_MP4A ||
-        i_codec == VLC_FOURCC('h', 'a', 'a', 'c') ||
-        i_codec == VLC_FOURCC('l', 'a', 'a', 'c') ||
-        i_codec == VLC_FOURCC('s', 'a', 'a', 'c') ||
-        i_codec == VLC_CODEC_OPUS ||
-        i_codec == VLC_CODEC_MP3 ||
-        i_codec == VLC_CODEC_A52 ||
-        i_codec == VLC_CODEC_EAC3;
+    if ( p_out == NULL )
+        return;
+
+    if ( p_intf->loadFailed() )
+    {
+        vlc_mutex_locker locker( &caps_lock );
+        device_caps &caps = caps_cache[device];
+        const es_format_t *p_video = NULL;
+
+        for ( size_t i = 0; i < streams.size(); i++ )
+        {
+            const es_format_t *p_es = &streams[i]->fmt;
+
+            if ( !isRemuxed( p_es ) )
+                continue;
+            if ( p_es->i_cat == VIDEO_ES )
+                p_video = p_es;
+            if ( caps.codecs.find( capsKey( p_es ) ) == caps.codecs.end() )
+            {
+                msg_Warn( p_stream, "the receiver cannot decode %4.4s profile %d",
+                          (const char *)&p_es->i_codec, p_es->i_profile );
+                caps.codecs[capsKey( p_es )] = false;
+                es_changed = true;
+            }
+        }
+
+        /* The known codecs were rejected, try a lower resolution */
+        if ( !es_changed && p_video != NULL && caps.max_height == 0 &&
+             p_video->video.i_height > 1080 )
+        {
+            msg_Warn( p_stream, "the receiver cannot decode %u lines",
+                      p_video->video.i_height );
+            caps.max_height = 1080;
+            es_changed = true;
+        }
+    }
+    else if ( !caps_checked && p_intf->isPlaying() )
+    {
+        vlc_mutex_locker locker( &caps_lock );
+        device_caps &caps = caps_cache[device];
+
+        for ( size_t i = 0; i < streams.size(); i++ )
+            if ( isRemuxed( &streams[i]->fmt ) )
+                caps.codecs[capsKey( &streams[i]->fmt )] = true;
+        caps_checked = true;
+    }
 }
 
 bool sout_stream_sys_t::startSoutChain( sout_stream_t *p_stream )
@@ -267,7 +386,7 @@ void sout_stream_sys_t::UpdateOutput( sout_stream_t *p_stream )
         const es_format_t *p_es = &(*it)->fmt;
         if (p_es->i_cat == AUDIO_ES)
         {
-            if (!canDecodeAudio( p_es->i_codec ))
+            if (!canDecodeAudio( p_es ))
             {
                 msg_Dbg( p_stream, "can't remux audio track %d codec %4.4s", p_es->i_id, (const char*)&p_es->i_codec );
                 canRemux = false;
@@ -277,7 +396,7 @@ void sout_stream_sys_t::UpdateOutput( sout_stream_t *p_stream )
         }
         else if (b_supports_video && p_es->i_cat == VIDEO_ES)
         {
-            if (!canDecodeVideo( p_es->i_codec ))
+            if (!canDecodeVideo( p_es ))
             {
                 msg_Dbg( p_stream, "can't remux video track %d codec %4.4s", p_es->i_id, (const char*)&p_es->i_codec );
                 canRemux = false;
@@ -288,6 +407,7 @@ void sout_stream_sys_t::UpdateOutput( sout_stream_t *p_stream )
     }
 
     std::stringstream ssout;
+    transcode_audio = transcode_video = caps_checked = false;
     if ( !canRemux )
     {
         /* TODO: provide audio samplerate and channels */
@@ -301,16 +421,21 @@ void sout_stream_sys_t::UpdateOutput( sout_stream_t *p_stream )
             vlc_fourcc_to_char( i_codec_audio, s_fourcc );
             s_fourcc[4] = '\0';
             ssout << s_fourcc << ',';
+            transcode_audio = true;
         }
         if ( b_supports_video && i_codec_video == 0 )
         {
             i_codec_video = DEFAULT_TRANSCODE_VIDEO;
             msg_Dbg( p_stream, "Converting video to %.4s", (const char*)&i_codec_video );
-            /* TODO: provide maxwidth,maxheight */
             ssout << "vcodec=";
             vlc_fourcc_to_char( i_codec_video, s_fourcc );
             s_fourcc[4] = '\0';
             ssout << s_fourcc;
+
+            vlc_mutex_locker locker( &caps_lock );
+            if ( caps_cache[device].max_height != 0 )
+                ssout << ",maxheight=" << caps_cache[device].max_height;
+            transcode_video = true;
         }
         ssout << "}:";
     }
@@ -369,6 +494,8 @@ static int Send(sout_stream_t *p_stream, sout_stream_id_sys_t *id,
 {
     sout_stream_sys_t *p_sys = p_stream->p_sys;
 
+    p_sys->checkReceiver( p_stream );
+
     id = p_sys->GetSubId( p_stream, id );
     if ( id == NULL )
         return VLC_EGENERIC;
@@ -481,7 +608,7 @@ static int Open(vlc_object_t *p_this)
 
     b_supports_video = var_GetBool(p_stream, SOUT_CFG_PREFIX "video");
 
-    p_sys = new(std::nothrow) sout_stream_sys_t( p_intf, b_supports_video, i_local_server_port,
+    p_sys = new(std::nothrow) sout_stream_sys_t( p_intf, psz_ip, b_supports_video, i_local_server_port,
                                                  psz_mux, psz_var_mime );
     if (unlikely(p_sys == NULL))
         goto error;
@@ -149,6 +149,9 @@ struct intf_sys_t
     ~intf_sys_t();
 
     bool isFinishedPlaying();
+    bool isPlaying();
+    /* whether the receiver could not load the stream, since the last call */
+    bool loadFailed();
 
     void setHasInput(const std::string mime_type = "");
 
@@ -220,6 +223,7 @@ private:
     ChromecastCommunication m_communication;
     std::queue<QueueableMessages> m_msgQueue;
     States m_state;
+    bool m_load_failed;
 
     std::string m_artwork;
     std::string m_title;
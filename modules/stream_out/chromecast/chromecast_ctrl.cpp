@@ -82,6 +82,7 @@ intf_sys_t::intf_sys_t(vlc_object_t * const p_this, int port, std::string device
  , m_streaming_port(port)
  , m_communication( p_this, device_addr.c_str(), device_port )
  , m_state( Authenticating )
+ , m_load_failed( false )
  , m_ctl_thread_interrupt(p_interrupt)
  , m_time_playback_started( VLC_TS_INVALID )
  , m_ts_local_start( VLC_TS_INVALID )
@@ -420,6 +421,10 @@ void intf_sys_t::processMediaMessage( const castchannel::CastMessage& msg )
         {
             if ( m_state != Ready )
             {
+                /* The receiver could not decode the stream it received */
+                if ( idleReason == "ERROR" &&
+                     ( m_state == Loading || m_state == Buffering ) )
+                    m_load_failed = true;
                 // The playback stopped
                 m_mediaSessionId = "";
                 m_time_playback_started = VLC_TS_INVALID;
@@ -495,6 +500,7 @@ void intf_sys_t::processMediaMessage( const castchannel::CastMessage& msg )
     {
         msg_Err( m_module, "Media load failed");
         vlc_mutex_locker locker(&m_lock);
+        m_load_failed = true;
         /* close the app to restart it */
         if ( m_state == Launching )
             m_communication.msgReceiverClose(m_appTransportId);
@@ -686,6 +692,20 @@ bool intf_sys_t::isFinishedPlaying()
     return m_state == Ready;
 }
 
+bool intf_sys_t::isPlaying()
+{
+    vlc_mutex_locker locker(&m_lock);
+    return m_state == Playing;
+}
+
+bool intf_sys_t::loadFailed()
+{
+    vlc_mutex_locker locker(&m_lock);
+    bool failed = m_load_failed;
+    m_load_failed = false;
+    return failed;
+}
+
 void intf_sys_t::setTitle(const char* psz_title)
 {
     if ( psz_title )
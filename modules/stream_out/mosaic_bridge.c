@@ -527,10 +527,10 @@ static int decoder_queue_video( decoder_t *p_dec, picture_t *p_pic )
 
         p_new_pic = image_Convert( p_sys->p_image,
                                    p_pic, p_fmt_in, &fmt_out );
+        picture_Release( p_pic );
         if( p_new_pic == NULL )
         {
             msg_Err( p_stream, "image conversion failed" );
-            picture_Release( p_pic );
             return -1;
         }
     }
@@ -538,20 +538,10 @@ static int decoder_queue_video( decoder_t *p_dec, picture_t *p_pic )
     {
         /* TODO: chroma conversion if needed */
 
-        p_new_pic = picture_New( p_pic->format.i_chroma,
-                                 p_pic->format.i_width, p_pic->format.i_height,
-                                 p_fmt_in->i_sar_num,
-                                 p_fmt_in->i_sar_den );
-        if( !p_new_pic )
-        {
-            picture_Release( p_pic );
-            msg_Err( p_stream, "image allocation failed" );
-            return -1;
-        }
-
-        picture_Copy( p_new_pic, p_pic );
+        /* The decoded pictures are not pooled nor written to once queued,
+         * so the mosaic can show them without a copy */
+        p_new_pic = p_pic;
     }
-    picture_Release( p_pic );
 
     if( p_sys->p_vf2 )
         p_new_pic = filter_chain_VideoFilter( p_sys->p_vf2, p_new_pic );
@@ -169,6 +169,11 @@ static const char *const ppsz_protocols[] = {
     "not receiving any RTSP request for this long. Setting it to a " \
     "negative value or zero disables timeouts. The default is 60 (one " \
     "minute)." )
+#define RTSP_SHARE_TEXT N_( "Shared VoD window (s)" )
+#define RTSP_SHARE_LONGTEXT N_( "Unicast VoD sessions that start playing " \
+    "the same media from the beginning within this many seconds of each " \
+    "other are sent the same RTP streams, from a single instance. Setting " \
+    "it to zero disables the sharing." )
 
 #define RTSP_USER_TEXT N_("Username")
 #define RTSP_USER_LONGTEXT N_("Username that will be " \
@@ -250,6 +255,8 @@ vlc_module_begin ()
     add_shortcut( "rtsp" )
     add_integer( "rtsp-timeout", 60, RTSP_TIMEOUT_TEXT,
                  RTSP_TIMEOUT_LONGTEXT, true )
+    add_integer( "rtsp-share-window", 0, RTSP_SHARE_TEXT,
+                 RTSP_SHARE_LONGTEXT, true )
     add_string( "sout-rtsp-user", "",
                 RTSP_USER_TEXT, RTSP_USER_LONGTEXT, true )
     add_password( "sout-rtsp-pwd", "",
@@ -1392,54 +1399,214 @@ static int  HttpCallback( httpd_file_sys_t *p_args,
 /****************************************************************************
  * RTP send
  ****************************************************************************/
-static void* ThreadSend( void *data )
-{
 #ifdef _WIN32
 # define ENOBUFS      WSAENOBUFS
 # define EAGAIN       WSAEWOULDBLOCK
 # define EWOULDBLOCK  WSAEWOULDBLOCK
 #endif
+
+/* Packets due within the pacing window are sent together, in one batch */
+#define RTP_BATCH 32
+#define PACING_WINDOW (CLOCK_FREQ / 1000)
+#define STATS_PERIOD (10 * CLOCK_FREQ)
+
+#ifdef HAVE_SRTP
+static block_t *rtp_encrypt( sout_stream_id_sys_t *id, block_t *out )
+{   /* FIXME: this is awfully inefficient */
+    size_t len = out->i_buffer;
+    out = block_Realloc( out, 0, len + 10 );
+    out->i_buffer = len;
+
+    int canc = vlc_savecancel ();
+    int val = srtp_send( id->srtp, out->p_buffer, &len, len + 10 );
+    vlc_restorecancel (canc);
+    if( val )
+    {
+        msg_Dbg( id->p_stream, "SRTP sending error: %s",
+                 vlc_strerror_c(val) );
+        block_Release( out );
+        return NULL;
+    }
+    out->i_buffer = len;
+    return out;
+}
+#endif
+
+/**
+ * Handles a send error.
+ * @return false if the connection is broken
+ */
+static bool rtp_send_error( int fd, const block_t *out )
+{
+    int err = net_errno;
+
+    if( err == EAGAIN
+#if (EAGAIN != EWOULDBLOCK)
+     || err == EWOULDBLOCK
+#endif
+     || err == ENOBUFS || err == ENOMEM )
+        return true;
+
+    int type;
+    getsockopt( fd, SOL_SOCKET, SO_TYPE, &type, &(socklen_t){ sizeof(type) });
+    if( type != SOCK_DGRAM )
+        return false; /* Broken connection */
+
+    /* ICMP soft error: ignore and retry */
+    send( fd, out->p_buffer, out->i_buffer, 0 );
+    return true;
+}
+
+/**
+ * Sends packets to a sink, with as few system calls as possible.
+ * @return false if the connection is broken
+ */
+static bool rtp_send_batch( int fd, block_t *const *pkts, unsigned count )
+{
+#ifdef HAVE_SENDMMSG
+    struct mmsghdr msgs[RTP_BATCH];
+    struct iovec iovs[RTP_BATCH];
+
+    for( unsigned i = 0; i < count; i++ )
+    {
+        iovs[i].iov_base = pkts[i]->p_buffer;
+        iovs[i].iov_len = pkts[i]->i_buffer;
+        msgs[i].msg_hdr = (struct msghdr) {
+            .msg_iov = &iovs[i],
+            .msg_iovlen = 1,
+        };
+    }
+
+    for( unsigned i = 0; i < count; )
+    {
+        int n = sendmmsg( fd, msgs + i, count - i, 0 );
+        if( n <= 0 )
+        {   /* Skip the failed packet */
+            if( !rtp_send_error( fd, pkts[i] ) )
+                return false;
+            n = 1;
+        }
+        i += n;
+    }
+#else
+    for( unsigned i = 0; i < count; i++ )
+        if( send( fd, pkts[i]->p_buffer, pkts[i]->i_buffer, 0 ) == -1
+         && !rtp_send_error( fd, pkts[i] ) )
+            return false;
+#endif
+    return true;
+}
+
+/* Pacing errors, i.e. the differences between the send and the due dates */
+typedef struct
+{
+    mtime_t  next_report;
+    unsigned batches;
+    unsigned packets;
+    mtime_t  total;
+    mtime_t  max;
+} rtp_pacing_stats_t;
+
+static void rtp_pacing_update( sout_stream_id_sys_t *id,
+                               rtp_pacing_stats_t *stats,
+                               block_t *const *pkts, unsigned count,
+                               mtime_t now )
+{
+    for( unsigned i = 0; i < count; i++ )
+    {
+        mtime_t error = now - (pkts[i]->i_dts + id->i_caching);
+
+        if( error < 0 )
+            error = -error; /* sent early, within the pacing window */
+        stats->total += error;
+        if( error > stats->max )
+            stats->max = error;
+    }
+    stats->packets += count;
+    stats->batches++;
+
+    if( now < stats->next_report )
+        return;
+    if( stats->next_report != 0 )
+        msg_Dbg( id->p_stream, "pacing error: average %"PRId64" us, maximum "
+                 "%"PRId64" us, %u packets in %u batches",
+                 stats->total / stats->packets, stats->max,
+                 stats->packets, stats->batches );
+    *stats = (rtp_pacing_stats_t){ .next_report = now + STATS_PERIOD };
+}
+
+/**
+ * Waits until a packet is due, releasing it if the thread is cancelled.
+ * This keeps the cleanup handler, thus setjmp(), out of ThreadSend().
+ */
+static void rtp_wait( block_t *out, mtime_t deadline )
+{
+    block_cleanup_push( out );
+    mwait( deadline );
+    vlc_cleanup_pop();
+}
+
+static void* ThreadSend( void *data )
+{
     sout_stream_id_sys_t *id = data;
     unsigned i_caching = id->i_caching;
+    rtp_pacing_stats_t stats = { .next_report = 0 };
+    block_t *pending = NULL; /* dequeued but not due yet */
 
     for (;;)
     {
-        block_t *out = block_FifoGet( id->p_fifo );
-        block_cleanup_push (out);
+        block_t *out = pending;
 
+        if( out == NULL )
+            out = block_FifoGet( id->p_fifo );
+        pending = NULL;
 #ifdef HAVE_SRTP
         if( id->srtp )
-        {   /* FIXME: this is awfully inefficient */
-            size_t len = out->i_buffer;
-            out = block_Realloc( out, 0, len + 10 );
-            out->i_buffer = len;
-
-            int canc = vlc_savecancel ();
-            int val = srtp_send( id->srtp, out->p_buffer, &len, len + 10 );
-            vlc_restorecancel (canc);
-            if( val )
-            {
-                msg_Dbg( id->p_stream, "SRTP sending error: %s",
-                         vlc_strerror_c(val) );
-                block_Release( out );
-                out = NULL;
-            }
-            else
-                out->i_buffer = len;
+        {
+            out = rtp_encrypt( id, out );
+            if( out == NULL )
+                continue;
         }
-        if (out)
-            mwait (out->i_dts + i_caching);
-        vlc_cleanup_pop ();
-        if (out == NULL)
-            continue;
-#else
-        mwait (out->i_dts + i_caching);
-        vlc_cleanup_pop ();
 #endif
+        rtp_wait( out, out->i_dts + i_caching );
 
-        ssize_t len = out->i_buffer;
         int canc = vlc_savecancel ();
 
+        /* Send the queued packets due within the pacing window along */
+        block_t *pkts[RTP_BATCH];
+        unsigned count = 0;
+        const mtime_t deadline = mdate() + PACING_WINDOW - i_caching;
+
+        pkts[count++] = out;
+        vlc_fifo_Lock( id->p_fifo );
+        while( count < RTP_BATCH && !vlc_fifo_IsEmpty( id->p_fifo ) )
+        {
+            block_t *next = vlc_fifo_DequeueUnlocked( id->p_fifo );
+
+            if( next->i_dts > deadline )
+            {
+                pending = next;
+                break;
+            }
+            pkts[count++] = next;
+        }
+        vlc_fifo_Unlock( id->p_fifo );
+
+#ifdef HAVE_SRTP
+        if( id->srtp )
+        {
+            unsigned encrypted = 1;
+
+            for( unsigned j = 1; j < count; j++ )
+            {
+                block_t *next = rtp_encrypt( id, pkts[j] );
+                if( next != NULL )
+                    pkts[encrypted++] = next;
+            }
+            count = encrypted;
+        }
+#endif
+
         vlc_mutex_lock( &id->lock_sink );
         unsigned deadc = 0; /* How many dead sockets? */
         int deadv[id->sinkc ? id->sinkc : 1]; /* Dead sockets list */
@@ -1449,26 +1616,19 @@ static void* ThreadSend( void *data )
 #ifdef HAVE_SRTP
             if( !id->srtp ) /* FIXME: SRTCP support */
 #endif
-                SendRTCP( id->sinkv[i].rtcp, out );
+                for( unsigned j = 0; j < count; j++ )
+                    SendRTCP( id->sinkv[i].rtcp, pkts[j] );
 
-            if( send( id->sinkv[i].rtp_fd, out->p_buffer, len, 0 ) == -1
-             && net_errno != EAGAIN && net_errno != EWOULDBLOCK
-             && net_errno != ENOBUFS && net_errno != ENOMEM )
-            {
-                int type;
-                getsockopt( id->sinkv[i].rtp_fd, SOL_SOCKET, SO_TYPE,
-                            &type, &(socklen_t){ sizeof(type) });
-                if( type == SOCK_DGRAM )
-                    /* ICMP soft error: ignore and retry */
-                    send( id->sinkv[i].rtp_fd, out->p_buffer, len, 0 );
-                else
-                    /* Broken connection */
-                    deadv[deadc++] = id->sinkv[i].rtp_fd;
-            }
+            if( !rtp_send_batch( id->sinkv[i].rtp_fd, pkts, count ) )
+                deadv[deadc++] = id->sinkv[i].rtp_fd;
         }
-        id->i_seq_sent_next = ntohs(((uint16_t *) out->p_buffer)[1]) + 1;
+        id->i_seq_sent_next =
+            ntohs(((uint16_t *) pkts[count - 1]->p_buffer)[1]) + 1;
         vlc_mutex_unlock( &id->lock_sink );
-        block_Release( out );
+
+        rtp_pacing_update( id, &stats, pkts, count, mdate() );
+        for( unsigned j = 0; j < count; j++ )
+            block_Release( pkts[j] );
 
         for( unsigned i = 0; i < deadc; i++ )
         {
@@ -69,6 +69,11 @@ struct rtsp_stream_t
     int             sessionc;
     rtsp_session_t **sessionv;
 
+    /* VoD instances shared by several sessions */
+    int             groupc;
+    rtsp_session_t **groupv;
+    mtime_t         share_window;
+
     int             timeout;
     vlc_timer_t     timer;
 };
@@ -81,6 +86,8 @@ static int  RtspCallbackId( httpd_callback_sys_t *p_args,
                             httpd_client_t *cl, httpd_message_t *answer,
                             const httpd_message_t *query );
 static void RtspClientDel( rtsp_stream_t *rtsp, rtsp_session_t *session );
+static void RtspGroupLeave( rtsp_stream_t *rtsp, rtsp_session_t *session );
+static void RtspGroupsDrop( rtsp_stream_t *rtsp );
 
 static void RtspTimeOut( void *data );
 
@@ -97,6 +104,9 @@ rtsp_stream_t *RtspSetup( vlc_object_t *owner, vod_media_t *media,
     vlc_mutex_init( &rtsp->lock );
 
     rtsp->timeout = var_InheritInteger(owner, "rtsp-timeout");
+    if (media != NULL)
+        rtsp->share_window = CLOCK_FREQ
+                           * var_InheritInteger(owner, "rtsp-share-window");
     if (rtsp->timeout > 0)
     {
         if (vlc_timer_create(&rtsp->timer, RtspTimeOut, rtsp))
@@ -145,6 +155,7 @@ void RtspUnsetup( rtsp_stream_t *rtsp )
     if( rtsp->host )
         httpd_HostDelete( rtsp->host );
 
+    RtspGroupsDrop( rtsp );
     while( rtsp->sessionc > 0 )
         RtspClientDel( rtsp, rtsp->sessionv[0] );
 
@@ -182,6 +193,12 @@ struct rtsp_session_t
     /* output (id-access) */
     int            trackc;
     rtsp_strack_t *trackv;
+
+    /* Shared VoD instance */
+    rtsp_session_t *group;     /* instance played from, if any */
+    int            members;    /* for a group: sessions playing from it */
+    mtime_t        start_date; /* for a group: when it was started */
+    int64_t        resume_npt; /* where the session left its group */
 };
 
 
@@ -352,6 +369,10 @@ rtsp_session_t *RtspClientNew( rtsp_stream_t *rtsp )
     vlc_rand_bytes (&s->id, sizeof (s->id));
     s->trackc = 0;
     s->trackv = NULL;
+    s->group = NULL;
+    s->members = 0;
+    s->start_date = 0;
+    s->resume_npt = 0;
 
     TAB_APPEND( rtsp->sessionc, rtsp->sessionv, s );
 
@@ -359,9 +380,9 @@ rtsp_session_t *RtspClientNew( rtsp_stream_t *rtsp )
 }
 
 
-/** rtsp must be locked */
 static
-rtsp_session_t *RtspClientGet( rtsp_stream_t *rtsp, const char *name )
+rtsp_session_t *RtspSessionFind( int sessionc, rtsp_session_t **sessionv,
+                                 const char *name )
 {
     char *end;
     uint64_t id;
@@ -376,21 +397,41 @@ rtsp_session_t *RtspClientGet( rtsp_stream_t *rtsp, const char *name )
         return NULL;
 
     /* FIXME: use a hash/dictionary */
-    for( i = 0; i < rtsp->sessionc; i++ )
+    for( i = 0; i < sessionc; i++ )
     {
-        if( rtsp->sessionv[i]->id == id )
-            return rtsp->sessionv[i];
+        if( sessionv[i]->id == id )
+            return sessionv[i];
     }
     return NULL;
 }
 
 
+/** rtsp must be locked */
+static
+rtsp_session_t *RtspClientGet( rtsp_stream_t *rtsp, const char *name )
+{
+    return RtspSessionFind( rtsp->sessionc, rtsp->sessionv, name );
+}
+
+
+/** rtsp must be locked */
+static
+rtsp_session_t *RtspInstanceGet( rtsp_stream_t *rtsp, const char *name )
+{
+    rtsp_session_t *session = RtspClientGet( rtsp, name );
+    if( session == NULL )
+        session = RtspSessionFind( rtsp->groupc, rtsp->groupv, name );
+    return session;
+}
+
+
 /** rtsp must be locked */
 static
 void RtspClientDel( rtsp_stream_t *rtsp, rtsp_session_t *session )
 {
     int i;
     TAB_REMOVE( rtsp->sessionc, rtsp->sessionv, session );
+    RtspGroupLeave( rtsp, session );
 
     for( i = 0; i < session->trackc; i++ )
         RtspTrackClose( &session->trackv[i] );
@@ -400,6 +441,181 @@ void RtspClientDel( rtsp_stream_t *rtsp, rtsp_session_t *session )
 }
 
 
+/* Unicast VoD sessions that start the same media within the share window
+ * play from one instance, a group: its RTP outputs send to all of them.
+ * The group is an hidden session, that owns the instance, and whose
+ * tracks get the ssrc and seq_init of the first session. */
+
+/** rtsp must be locked */
+static rtsp_strack_t *RtspGroupTrack( rtsp_session_t *group,
+                                      const rtsp_stream_id_t *id )
+{
+    for (int i = 0; i < group->trackc; i++)
+        if (group->trackv[i].id == id)
+            return group->trackv + i;
+    return NULL;
+}
+
+/** rtsp must be locked */
+static bool RtspGroupJoinable( rtsp_stream_t *rtsp, rtsp_session_t *group )
+{
+    return group->trackc > 0
+        && mdate() - group->start_date <= rtsp->share_window;
+}
+
+/** rtsp must be locked */
+static rtsp_strack_t *RtspGroupFindTrack( rtsp_stream_t *rtsp,
+                                          const rtsp_stream_id_t *id )
+{
+    for (int i = 0; i < rtsp->groupc; i++)
+    {
+        rtsp_session_t *group = rtsp->groupv[i];
+        if (!RtspGroupJoinable(rtsp, group))
+            continue;
+
+        rtsp_strack_t *tr = RtspGroupTrack(group, id);
+        if (tr != NULL)
+            return tr;
+    }
+    return NULL;
+}
+
+/** rtsp must be locked */
+static bool RtspGroupMatches( rtsp_stream_t *rtsp, rtsp_session_t *group,
+                              const rtsp_session_t *session )
+{
+    if (!RtspGroupJoinable(rtsp, group))
+        return false;
+
+    /* The SETUP answers announced the ssrc of the group */
+    for (int i = 0; i < session->trackc; i++)
+    {
+        const rtsp_strack_t *tr = session->trackv + i;
+        if (tr->setup_fd == -1)
+            continue;
+
+        const rtsp_strack_t *gtr = RtspGroupTrack(group, tr->id);
+        if (gtr == NULL || gtr->ssrc != tr->ssrc)
+            return false;
+    }
+    return true;
+}
+
+/** rtsp must be locked */
+static rtsp_session_t *RtspGroupNew( rtsp_stream_t *rtsp,
+                                     const rtsp_session_t *session )
+{
+    rtsp_session_t *group = malloc( sizeof( *group ) );
+    if( group == NULL )
+        return NULL;
+
+    group->stream = rtsp;
+    vlc_rand_bytes (&group->id, sizeof (group->id));
+    group->last_seen = 0;
+    group->trackc = 0;
+    group->trackv = NULL;
+    group->group = NULL;
+    group->members = 0;
+    group->start_date = mdate();
+    group->resume_npt = 0;
+
+    for (int i = 0; i < session->trackc; i++)
+    {
+        const rtsp_strack_t *tr = session->trackv + i;
+        if (tr->setup_fd == -1)
+            continue;
+
+        rtsp_strack_t track = { .id = tr->id, .sout_id = NULL,
+                                .setup_fd = -1, .rtp_fd = -1,
+                                .ssrc = tr->ssrc, .seq_init = tr->seq_init };
+        TAB_APPEND(group->trackc, group->trackv, track);
+    }
+
+    TAB_APPEND( rtsp->groupc, rtsp->groupv, group );
+    return group;
+}
+
+/** rtsp must be locked */
+static rtsp_session_t *RtspGroupJoin( rtsp_stream_t *rtsp,
+                                      rtsp_session_t *session, bool *created )
+{
+    rtsp_session_t *group = NULL;
+
+    *created = false;
+    for (int i = 0; i < rtsp->groupc && group == NULL; i++)
+        if (RtspGroupMatches(rtsp, rtsp->groupv[i], session))
+            group = rtsp->groupv[i];
+
+    if (group == NULL)
+    {
+        group = RtspGroupNew(rtsp, session);
+        if (group == NULL)
+            return NULL;
+        *created = true;
+    }
+
+    session->group = group;
+    group->members++;
+
+    /* Play from the RTP outputs that are already running */
+    for (int i = 0; i < session->trackc; i++)
+    {
+        rtsp_strack_t *tr = session->trackv + i;
+        if (tr->setup_fd != -1)
+            tr->sout_id = RtspGroupTrack(group, tr->id)->sout_id;
+    }
+    return group;
+}
+
+/** rtsp must be locked */
+static void RtspGroupLeave( rtsp_stream_t *rtsp, rtsp_session_t *session )
+{
+    rtsp_session_t *group = session->group;
+    if (group == NULL)
+        return;
+
+    for (int i = 0; i < session->trackc; i++)
+    {
+        rtsp_strack_t *tr = session->trackv + i;
+        if (tr->rtp_fd != -1)
+        {
+            rtp_del_sink(tr->sout_id, tr->rtp_fd);
+            tr->rtp_fd = -1;
+        }
+        tr->sout_id = NULL;
+    }
+    session->group = NULL;
+
+    if (--group->members > 0)
+        return;
+
+    /* Last session gone: stop the instance */
+    char psz_sesbuf[17];
+    snprintf( psz_sesbuf, sizeof( psz_sesbuf ), "%"PRIx64, group->id );
+    vod_stop(rtsp->vod_media, psz_sesbuf);
+
+    TAB_REMOVE( rtsp->groupc, rtsp->groupv, group );
+    free( group->trackv );
+    free( group );
+}
+
+/* The media is going away with its instances: drop the groups without
+ * stopping them */
+static void RtspGroupsDrop( rtsp_stream_t *rtsp )
+{
+    for (int i = 0; i < rtsp->sessionc; i++)
+        rtsp->sessionv[i]->group = NULL;
+
+    while (rtsp->groupc > 0)
+    {
+        rtsp_session_t *group = rtsp->groupv[0];
+        TAB_REMOVE( rtsp->groupc, rtsp->groupv, group );
+        free( group->trackv );
+        free( group );
+    }
+}
+
+
 /** rtsp must be locked */
 static void RtspClientAlive( rtsp_session_t *session )
 {
@@ -434,7 +650,7 @@ int RtspTrackAttach( rtsp_stream_t *rtsp, const char *name,
     rtsp_session_t *session;
 
     vlc_mutex_lock(&rtsp->lock);
-    session = RtspClientGet(rtsp, name);
+    session = RtspInstanceGet(rtsp, name);
 
     if (session == NULL)
         goto out;
@@ -452,7 +668,8 @@ int RtspTrackAttach( rtsp_stream_t *rtsp, const char *name,
     if (tr != NULL)
     {
         tr->sout_id = sout_id;
-        tr->rtp_fd = dup_socket(tr->setup_fd);
+        if (tr->setup_fd != -1)
+            tr->rtp_fd = dup_socket(tr->setup_fd);
     }
     else
     {
@@ -480,6 +697,26 @@ int RtspTrackAttach( rtsp_stream_t *rtsp, const char *name,
         assert(tr->seq_init == seq);
     }
 
+    /* The members of a group play from its instance */
+    for (int i = 0; i < rtsp->sessionc; i++)
+    {
+        rtsp_session_t *member = rtsp->sessionv[i];
+        if (member->group != session)
+            continue;
+
+        for (int j = 0; j < member->trackc; j++)
+        {
+            rtsp_strack_t *mtr = member->trackv + j;
+            if (mtr->id != id || mtr->setup_fd == -1 || mtr->rtp_fd != -1)
+                continue;
+
+            mtr->sout_id = sout_id;
+            mtr->rtp_fd = dup_socket(mtr->setup_fd);
+            if (mtr->rtp_fd != -1)
+                rtp_add_sink(sout_id, mtr->rtp_fd, false, NULL);
+        }
+    }
+
     val = VLC_SUCCESS;
 out:
     vlc_mutex_unlock(&rtsp->lock);
@@ -494,11 +731,33 @@ void RtspTrackDetach( rtsp_stream_t *rtsp, const char *name,
     rtsp_session_t *session;
 
     vlc_mutex_lock(&rtsp->lock);
-    session = RtspClientGet(rtsp, name);
+    session = RtspInstanceGet(rtsp, name);
 
     if (session == NULL)
         goto out;
 
+    /* Stop the members of a group too */
+    for (int i = 0; i < rtsp->sessionc; i++)
+    {
+        rtsp_session_t *member = rtsp->sessionv[i];
+        if (member->group != session)
+            continue;
+
+        for (int j = 0; j < member->trackc; j++)
+        {
+            rtsp_strack_t *mtr = member->trackv + j;
+            if (mtr->sout_id != sout_id)
+                continue;
+
+            if (mtr->rtp_fd != -1)
+            {
+                rtp_del_sink(sout_id, mtr->rtp_fd);
+                mtr->rtp_fd = -1;
+            }
+            mtr->sout_id = NULL;
+        }
+    }
+
     for (int i = 0; i < session->trackc; i++)
     {
         rtsp_strack_t *tr = session->trackv + i;
@@ -871,9 +1130,21 @@ static int RtspHandler( rtsp_stream_t *rtsp, rtsp_stream_id_t *id,
 
                         if (vod)
                         {
-                            vlc_rand_bytes (&track.seq_init,
-                                            sizeof (track.seq_init));
-                            vlc_rand_bytes (&track.ssrc, sizeof (track.ssrc));
+                            /* Announce the ssrc of a group the session
+                             * can join */
+                            rtsp_strack_t *gtr = RtspGroupFindTrack(rtsp, id);
+                            if (gtr != NULL)
+                            {
+                                track.seq_init = gtr->seq_init;
+                                track.ssrc = gtr->ssrc;
+                            }
+                            else
+                            {
+                                vlc_rand_bytes (&track.seq_init,
+                                                sizeof (track.seq_init));
+                                vlc_rand_bytes (&track.ssrc,
+                                                sizeof (track.ssrc));
+                            }
                             ssrc = track.ssrc;
                         }
                         else
@@ -969,6 +1240,8 @@ static int RtspHandler( rtsp_stream_t *rtsp, rtsp_stream_id_t *id,
                     break;
                 }
             }
+            char psz_groupbuf[17] = "";
+            bool group_new = false;
             vlc_mutex_lock( &rtsp->lock );
             ses = RtspClientGet( rtsp, psz_session );
             if( ses != NULL )
@@ -979,6 +1252,40 @@ static int RtspHandler( rtsp_stream_t *rtsp, rtsp_stream_id_t *id,
                 size_t infolen = 0;
                 RtspClientAlive(ses);
 
+                const char *ts_session = psz_session;
+                if (vod)
+                {
+                    /* Seeking, or playing again after the end, needs an
+                     * instance of its own */
+                    if (ses->group != NULL
+                     && (start > 0 || ses->group->trackc == 0))
+                        RtspGroupLeave(rtsp, ses);
+
+                    if (start < 0 && ses->resume_npt > 0)
+                        start = ses->resume_npt;
+                    ses->resume_npt = 0;
+
+                    bool setup = false, running = false;
+                    for (int i = 0; i < ses->trackc; i++)
+                    {
+                        if (ses->trackv[i].setup_fd != -1)
+                            setup = true;
+                        if (ses->trackv[i].sout_id != NULL)
+                            running = true;
+                    }
+
+                    if (ses->group == NULL && setup && !running && start <= 0
+                     && rtsp->share_window > 0)
+                        RtspGroupJoin(rtsp, ses, &group_new);
+
+                    if (ses->group != NULL)
+                    {
+                        snprintf( psz_groupbuf, sizeof( psz_groupbuf ),
+                                  "%"PRIx64, ses->group->id );
+                        ts_session = psz_groupbuf;
+                    }
+                }
+
                 sout_stream_id_sys_t *sout_id = NULL;
                 if (vod)
                 {
@@ -992,8 +1299,9 @@ static int RtspHandler( rtsp_stream_t *rtsp, rtsp_stream_id_t *id,
                     }
                 }
                 int64_t ts = rtp_get_ts(vod ? NULL : (sout_stream_t *)owner,
-                                        sout_id, rtsp->vod_media, psz_session,
-                                        vod ? NULL : &npt);
+                                        sout_id, rtsp->vod_media, ts_session,
+                                        (vod && psz_groupbuf[0] == '\0')
+                                            ? NULL : &npt);
 
                 for( int i = 0; i < ses->trackc; i++ )
                 {
@@ -1046,7 +1354,13 @@ static int RtspHandler( rtsp_stream_t *rtsp, rtsp_stream_id_t *id,
 
             if (ses != NULL)
             {
-                if (vod)
+                if (group_new)
+                {
+                    /* Start the shared instance */
+                    vod_play(rtsp->vod_media, psz_groupbuf, &start, end);
+                    npt = start;
+                }
+                else if (vod && psz_groupbuf[0] == '\0')
                 {
                     vod_play(rtsp->vod_media, psz_session, &start, end);
                     npt = start;
@@ -1072,13 +1386,32 @@ static int RtspHandler( rtsp_stream_t *rtsp, rtsp_stream_id_t *id,
             }
 
             rtsp_session_t *ses;
+            bool shared = false;
+            int64_t npt = 0;
             answer->i_status = 200;
             psz_session = httpd_MsgGet( query, "Session" );
             vlc_mutex_lock( &rtsp->lock );
             ses = RtspClientGet( rtsp, psz_session );
             if (ses != NULL)
             {
-                if (id != NULL) /* "Mute" the selected track */
+                if (id == NULL && ses->group != NULL)
+                {
+                    /* The shared instance keeps playing for the other
+                     * sessions: leave it, and resume alone from here */
+                    sout_stream_id_sys_t *sout_id = NULL;
+                    for (int i = 0; i < ses->trackc && sout_id == NULL; i++)
+                        sout_id = ses->trackv[i].sout_id;
+
+                    char psz_groupbuf[17];
+                    snprintf( psz_groupbuf, sizeof( psz_groupbuf ),
+                              "%"PRIx64, ses->group->id );
+                    rtp_get_ts(NULL, sout_id, rtsp->vod_media, psz_groupbuf,
+                               &npt);
+                    RtspGroupLeave(rtsp, ses);
+                    ses->resume_npt = npt;
+                    shared = true;
+                }
+                else if (id != NULL) /* "Mute" the selected track */
                 {
                     bool found = false;
                     for (int i = 0; i < ses->trackc; i++)
@@ -1108,8 +1441,8 @@ static int RtspHandler( rtsp_stream_t *rtsp, rtsp_stream_id_t *id,
             if (ses != NULL && id == NULL)
             {
                 assert(vod);
-                int64_t npt = 0;
-                vod_pause(rtsp->vod_media, psz_session, &npt);
+                if (!shared)
+                    vod_pause(rtsp->vod_media, psz_session, &npt);
                 double f_npt = (double) npt / CLOCK_FREQ;
                 httpd_MsgAdd( answer, "Range", "npt=%f-", f_npt );
             }
@@ -37,6 +37,19 @@
  *
  * the video-data and audio-data pointers will be passed to lock/unlock function
  *
+ * Alternatively, the block callback receives the blocks themselves, without
+ * any copy, in batches of up to sout-smem-batch blocks of the same ES:
+ *
+ * void block_callback( void *p_data, unsigned i_blocks,
+ *                      uint8_t *const *pp_buffer, const size_t *pi_size,
+ *                      const int64_t *pi_pts, const int64_t *pi_dts,
+ *                      const uint32_t *pi_flags, void *const *pp_handle,
+ *                      void (*pf_release)( void *p_handle ) );
+ *
+ * The arrays are only valid during the callback, but each buffer remains
+ * valid until the application calls pf_release() with its handle.
+ * This also works with compressed elementary streams.
+ *
  ******************************************************************************/
 
 /*****************************************************************************
@@ -80,6 +93,15 @@
 #define T_AUDIO_DATA N_( "Audio callback data" )
 #define LT_AUDIO_DATA N_( "Data for the audio callback function." )
 
+#define T_BLOCK_CALLBACK N_( "Block callback" )
+#define LT_BLOCK_CALLBACK N_( "Address of the block callback function. " \
+                              "This function will take the ownership of the blocks, " \
+                              "instead of having them copied in its buffers." )
+
+#define T_BATCH N_( "Blocks per callback" )
+#define LT_BATCH N_( "Number of blocks of an elementary stream gathered " \
+                     "before calling the block callback." )
+
 #define T_TIME_SYNC N_( "Time Synchronized output" )
 #define LT_TIME_SYNC N_( "Time Synchronisation option for output. " \
                         "If true, stream will render as usual, else " \
@@ -111,6 +133,9 @@ vlc_module_begin ()
         change_volatile()
     add_string( SOUT_PREFIX_AUDIO "data", "0", T_AUDIO_DATA, LT_VIDEO_DATA, true )
         change_volatile()
+    add_string( SOUT_CFG_PREFIX "block-callback", "0", T_BLOCK_CALLBACK, LT_BLOCK_CALLBACK, true )
+        change_volatile()
+    add_integer_with_range( SOUT_CFG_PREFIX "batch", 1, 1, 256, T_BATCH, LT_BATCH, true )
     add_bool( SOUT_CFG_PREFIX "time-sync", true, T_TIME_SYNC, LT_TIME_SYNC, true )
         change_private()
     set_callbacks( Open, Close )
@@ -122,12 +147,15 @@ vlc_module_end ()
  *****************************************************************************/
 static const char *const ppsz_sout_options[] = {
     "video-prerender-callback", "audio-prerender-callback",
-    "video-postrender-callback", "audio-postrender-callback", "video-data", "audio-data", "time-sync", NULL
+    "video-postrender-callback", "audio-postrender-callback", "video-data", "audio-data",
+    "block-callback", "batch", "time-sync", NULL
 };
 
 static sout_stream_id_sys_t *Add( sout_stream_t *, const es_format_t * );
 static void              Del ( sout_stream_t *, sout_stream_id_sys_t * );
 static int               Send( sout_stream_t *, sout_stream_id_sys_t *, block_t* );
+static int               SendBlocks( sout_stream_t *, sout_stream_id_sys_t *, block_t* );
+static void              Flush( sout_stream_t *, sout_stream_id_sys_t * );
 
 static sout_stream_id_sys_t *AddVideo( sout_stream_t *p_stream,
                                        const es_format_t *p_fmt );
@@ -143,6 +171,10 @@ struct sout_stream_id_sys_t
 {
     es_format_t format;
     void *p_data;
+
+    /* Blocks waiting for the block callback */
+    block_t **pp_pending;
+    unsigned i_pending;
 };
 
 struct sout_stream_sys_t
@@ -152,6 +184,10 @@ struct sout_stream_sys_t
     void ( *pf_audio_prerender_callback ) ( void* p_audio_data, uint8_t** pp_pcm_buffer, size_t size );
     void ( *pf_video_postrender_callback ) ( void* p_video_data, uint8_t* p_pixel_buffer, int width, int height, int pixel_pitch, size_t size, mtime_t pts );
     void ( *pf_audio_postrender_callback ) ( void* p_audio_data, uint8_t* p_pcm_buffer, unsigned int channels, unsigned int rate, unsigned int nb_samples, unsigned int bits_per_sample, size_t size, mtime_t pts );
+    void ( *pf_block_callback ) ( void* p_data, unsigned i_blocks, uint8_t *const *pp_buffer, const size_t *pi_size,
+                                  const int64_t *pi_pts, const int64_t *pi_dts, const uint32_t *pi_flags,
+                                  void *const *pp_handle, void ( *pf_release ) ( void *p_handle ) );
+    unsigned i_batch;
     bool time_sync;
 };
 
@@ -237,10 +273,23 @@ static int Open( vlc_object_t *p_this )
     if (p_sys->pf_audio_postrender_callback == NULL)
         p_sys->pf_audio_postrender_callback = AudioPostrenderDefaultCallback;
 
+    psz_tmp = var_GetString( p_stream, SOUT_CFG_PREFIX "block-callback" );
+    p_sys->pf_block_callback = (void (*) (void*, unsigned, uint8_t *const *, const size_t *, const int64_t *, const int64_t *, const uint32_t *, void *const *, void (*) (void *)))(intptr_t)atoll( psz_tmp );
+    free( psz_tmp );
+    p_sys->i_batch = var_GetInteger( p_stream, SOUT_CFG_PREFIX "batch" );
+    if( p_sys->i_batch < 1 )
+        p_sys->i_batch = 1;
+
     /* Setting stream out module callbacks */
     p_stream->pf_add    = Add;
     p_stream->pf_del    = Del;
-    p_stream->pf_send   = Send;
+    if( p_sys->pf_block_callback != NULL )
+    {
+        p_stream->pf_send  = SendBlocks;
+        p_stream->pf_flush = Flush;
+    }
+    else
+        p_stream->pf_send  = Send;
     p_stream->pace_nocontrol = p_sys->time_sync;
 
     return VLC_SUCCESS;
@@ -255,12 +304,46 @@ static void Close( vlc_object_t * p_this )
     free( p_stream->p_sys );
 }
 
+static sout_stream_id_sys_t *AddBlocks( sout_stream_t *p_stream,
+                                        const es_format_t *p_fmt )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    char* psz_tmp;
+    sout_stream_id_sys_t *id;
+
+    /* The blocks are passed as they are, raw or compressed */
+    id = calloc( 1, sizeof( sout_stream_id_sys_t ) );
+    if( !id )
+        return NULL;
+
+    id->pp_pending = vlc_alloc( p_sys->i_batch, sizeof( *id->pp_pending ) );
+    if( !id->pp_pending )
+    {
+        free( id );
+        return NULL;
+    }
+
+    psz_tmp = var_GetString( p_stream, p_fmt->i_cat == VIDEO_ES ?
+                             SOUT_PREFIX_VIDEO "data" : SOUT_PREFIX_AUDIO "data" );
+    id->p_data = (void *)( intptr_t )atoll( psz_tmp );
+    free( psz_tmp );
+
+    es_format_Copy( &id->format, p_fmt );
+    return id;
+}
+
 static sout_stream_id_sys_t *Add( sout_stream_t *p_stream,
                                   const es_format_t *p_fmt )
 {
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
     sout_stream_id_sys_t *id = NULL;
 
-    if ( p_fmt->i_cat == VIDEO_ES )
+    if( p_sys->pf_block_callback != NULL )
+    {
+        if( p_fmt->i_cat == VIDEO_ES || p_fmt->i_cat == AUDIO_ES )
+            id = AddBlocks( p_stream, p_fmt );
+    }
+    else if ( p_fmt->i_cat == VIDEO_ES )
         id = AddVideo( p_stream, p_fmt );
     else if ( p_fmt->i_cat == AUDIO_ES )
         id = AddAudio( p_stream, p_fmt );
@@ -343,9 +426,58 @@ static sout_stream_id_sys_t *AddAudio( sout_stream_t *p_stream,
     return id;
 }
 
-static void Del( sout_stream_t *p_stream, sout_stream_id_sys_t *id )
+static void ReleaseBlock( void *p_handle )
+{
+    block_Release( p_handle );
+}
+
+/* Hands the pending blocks over to the application */
+static void DeliverBlocks( sout_stream_t *p_stream, sout_stream_id_sys_t *id )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    const unsigned i_blocks = id->i_pending;
+    uint8_t *pp_buffer[i_blocks];
+    size_t pi_size[i_blocks];
+    int64_t pi_pts[i_blocks], pi_dts[i_blocks];
+    uint32_t pi_flags[i_blocks];
+    void *pp_handle[i_blocks];
+
+    if( i_blocks == 0 )
+        return;
+
+    for( unsigned i = 0; i < i_blocks; i++ )
+    {
+        block_t *p_block = id->pp_pending[i];
+
+        pp_buffer[i] = p_block->p_buffer;
+        pi_size[i] = p_block->i_buffer;
+        pi_pts[i] = p_block->i_pts;
+        pi_dts[i] = p_block->i_dts;
+        pi_flags[i] = p_block->i_flags;
+        pp_handle[i] = p_block;
+    }
+    id->i_pending = 0;
+
+    p_sys->pf_block_callback( id->p_data, i_blocks, pp_buffer, pi_size,
+                              pi_pts, pi_dts, pi_flags, pp_handle,
+                              ReleaseBlock );
+}
+
+static void Flush( sout_stream_t *p_stream, sout_stream_id_sys_t *id )
 {
     VLC_UNUSED( p_stream );
+    for( unsigned i = 0; i < id->i_pending; i++ )
+        block_Release( id->pp_pending[i] );
+    id->i_pending = 0;
+}
+
+static void Del( sout_stream_t *p_stream, sout_stream_id_sys_t *id )
+{
+    if( id->pp_pending != NULL )
+    {
+        DeliverBlocks( p_stream, id );
+        free( id->pp_pending );
+    }
     es_format_Clean( &id->format );
     free( id );
 }
@@ -360,6 +492,24 @@ static int Send( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
     return VLC_SUCCESS;
 }
 
+static int SendBlocks( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
+                       block_t *p_buffer )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+
+    while( p_buffer != NULL )
+    {
+        block_t *p_next = p_buffer->p_next;
+
+        p_buffer->p_next = NULL;
+        id->pp_pending[id->i_pending++] = p_buffer;
+        if( id->i_pending >= p_sys->i_batch )
+            DeliverBlocks( p_stream, id );
+        p_buffer = p_next;
+    }
+    return VLC_SUCCESS;
+}
+
 static int SendVideo( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
                       block_t *p_buffer )
 {
@@ -153,6 +153,35 @@ static block_t *transcode_dequeue_all_audios( sout_stream_id_sys_t *id )
     return p_audio_bufs;
 }
 
+static int EncodeAudio( void *opaque, void *item )
+{
+    sout_stream_id_sys_t *id = opaque;
+    block_t *p_audio_buf = item;
+
+    block_t *p_block = id->p_encoder->pf_encode_audio( id->p_encoder, p_audio_buf );
+    block_Release( p_audio_buf );
+    transcode_stage_Output( id->p_encoder_stage, p_block );
+    return VLC_SUCCESS;
+}
+
+static int FilterAudio( void *opaque, void *item )
+{
+    sout_stream_id_sys_t *id = opaque;
+    block_t *p_audio_buf = item;
+
+    p_audio_buf = aout_FiltersPlay( id->p_af_chain, p_audio_buf,
+                                    INPUT_RATE_DEFAULT );
+    if( !p_audio_buf )
+        return VLC_EGENERIC;
+
+    p_audio_buf->i_dts = p_audio_buf->i_pts;
+
+    /* Waits if the encoder thread lags behind */
+    if( transcode_stage_Push( id->p_encoder_stage, p_audio_buf ) )
+        block_Release( p_audio_buf );
+    return VLC_SUCCESS;
+}
+
 static int transcode_audio_new( sout_stream_t *p_stream,
                                 sout_stream_id_sys_t *id )
 {
@@ -207,6 +236,18 @@ static int transcode_audio_new( sout_stream_t *p_stream,
 
 void transcode_audio_close( sout_stream_id_sys_t *id )
 {
+    /* The filters thread feeds the encoder one, stop it first */
+    if( id->p_filter_stage != NULL )
+    {
+        transcode_stage_Delete( id->p_filter_stage );
+        id->p_filter_stage = NULL;
+    }
+    if( id->p_encoder_stage != NULL )
+    {
+        transcode_stage_Delete( id->p_encoder_stage );
+        id->p_encoder_stage = NULL;
+    }
+
     /* Close decoder */
     if( id->p_decoder->p_module )
         module_unneed( id->p_decoder, id->p_decoder->p_module );
@@ -287,6 +328,9 @@ int transcode_audio_process( sout_stream_t *p_stream,
                       ( id->p_decoder->fmt_out.audio.i_physical_channels != id->fmt_audio.i_physical_channels ) ) )
         {
             msg_Info( p_stream, "Audio changed, trying to reinitialize filters" );
+            /* The filters thread must be done with the previous buffers */
+            if( id->p_filter_stage != NULL )
+                transcode_stage_Drain( id->p_filter_stage );
             if( id->p_af_chain != NULL )
                 aout_FiltersDelete( (vlc_object_t *)NULL, id->p_af_chain );
 
@@ -328,6 +372,14 @@ int transcode_audio_process( sout_stream_t *p_stream,
 
         p_audio_buf->i_dts = p_audio_buf->i_pts;
 
+        if( id->p_filter_stage != NULL )
+        {
+            /* Waits if the filters thread lags behind */
+            if( transcode_stage_Push( id->p_filter_stage, p_audio_buf ) )
+                goto error;
+            continue;
+        }
+
         /* Run filter chain */
         p_audio_buf = aout_FiltersPlay( id->p_af_chain, p_audio_buf,
                                         INPUT_RATE_DEFAULT );
@@ -350,7 +402,18 @@ error:
     } while( p_audio_bufs );
 
 end:
-    /* Drain encoder */
+    if( id->p_encoder_stage != NULL )
+    {
+        if( unlikely( in == NULL ) )
+        {
+            transcode_stage_Drain( id->p_filter_stage );
+            transcode_stage_Drain( id->p_encoder_stage );
+        }
+        block_ChainAppend( out,
+                           transcode_stage_GetOutput( id->p_encoder_stage ) );
+    }
+
+    /* Drain encoder, the threads, if any, are idle once drained */
     if( unlikely( !b_error && in == NULL ) )
     {
         block_t *p_block;
@@ -422,5 +485,28 @@ bool transcode_audio_add( sout_stream_t *p_stream, const es_format_t *p_fmt,
             aout_FiltersDelete( (vlc_object_t *)NULL, id->p_af_chain );
         id->p_af_chain = NULL;
     }
+
+    /* Decoding stays in the input thread, filtering and encoding each get
+     * their own */
+    if( p_sys->i_threads > 0 )
+    {
+        int i_priority = p_sys->b_high_priority ? VLC_THREAD_PRIORITY_OUTPUT :
+                           VLC_THREAD_PRIORITY_AUDIO;
+        id->p_encoder_stage = transcode_stage_New( p_sys->pool_size,
+                                                   EncodeAudio, id,
+                                                   i_priority );
+        if( id->p_encoder_stage != NULL )
+            id->p_filter_stage = transcode_stage_New( p_sys->pool_size,
+                                                      FilterAudio, id,
+                                                      VLC_THREAD_PRIORITY_AUDIO );
+        if( id->p_filter_stage == NULL )
+        {
+            msg_Err( p_stream, "cannot spawn encoder threads" );
+            transcode_audio_close( id );
+            sout_StreamIdDel( p_stream->p_next, id->id );
+            id->id = NULL;
+            return false;
+        }
+    }
     return true;
 }
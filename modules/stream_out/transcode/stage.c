@@ -0,0 +1,198 @@
+/*****************************************************************************
+ * stage.c: transcoding stream output module (pipeline stages)
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+
+#include "transcode.h"
+
+#include <assert.h>
+
+struct transcode_stage_t
+{
+    vlc_thread_t    thread;
+    vlc_mutex_t     lock;
+    vlc_cond_t      wait_in;  /**< an item was queued, or abort */
+    vlc_cond_t      wait_out; /**< an item was dequeued or processed */
+
+    /* Bounded queue of items, the producer waits when it is full */
+    void          **pp_items;
+    unsigned        i_size;
+    unsigned        i_first;
+    unsigned        i_count;
+
+    bool            b_busy;   /**< an item is being processed */
+    bool            b_error;  /**< an item failed, no more are accepted */
+    bool            b_abort;
+
+    int           (*pf_process)( void *, void * );
+    void           *p_opaque;
+
+    /* Blocks output by the stage */
+    block_t        *p_out;
+    block_t       **pp_out_last;
+};
+
+static void *StageThread( void *data )
+{
+    transcode_stage_t *p_stage = data;
+    int canc = vlc_savecancel();
+
+    vlc_mutex_lock( &p_stage->lock );
+    for( ;; )
+    {
+        while( p_stage->i_count == 0 && !p_stage->b_abort )
+            vlc_cond_wait( &p_stage->wait_in, &p_stage->lock );
+        /* The queued items are processed before leaving */
+        if( p_stage->i_count == 0 )
+            break;
+
+        void *p_item = p_stage->pp_items[p_stage->i_first];
+        p_stage->i_first = (p_stage->i_first + 1) % p_stage->i_size;
+        p_stage->i_count--;
+        p_stage->b_busy = true;
+        vlc_cond_broadcast( &p_stage->wait_out );
+        vlc_mutex_unlock( &p_stage->lock );
+
+        int ret = p_stage->pf_process( p_stage->p_opaque, p_item );
+
+        vlc_mutex_lock( &p_stage->lock );
+        if( ret != VLC_SUCCESS )
+            p_stage->b_error = true;
+        p_stage->b_busy = false;
+        vlc_cond_broadcast( &p_stage->wait_out );
+    }
+    vlc_mutex_unlock( &p_stage->lock );
+
+    vlc_restorecancel( canc );
+    return NULL;
+}
+
+transcode_stage_t *transcode_stage_New( unsigned i_size,
+                                        int (*pf_process)( void *, void * ),
+                                        void *p_opaque, int i_priority )
+{
+    transcode_stage_t *p_stage = malloc( sizeof( *p_stage ) );
+    if( unlikely(p_stage == NULL) )
+        return NULL;
+
+    if( i_size == 0 )
+        i_size = 1;
+    p_stage->pp_items = vlc_alloc( i_size, sizeof( *p_stage->pp_items ) );
+    if( unlikely(p_stage->pp_items == NULL) )
+    {
+        free( p_stage );
+        return NULL;
+    }
+    p_stage->i_size = i_size;
+    p_stage->i_first = 0;
+    p_stage->i_count = 0;
+    p_stage->b_busy = false;
+    p_stage->b_error = false;
+    p_stage->b_abort = false;
+    p_stage->pf_process = pf_process;
+    p_stage->p_opaque = p_opaque;
+    p_stage->p_out = NULL;
+    p_stage->pp_out_last = &p_stage->p_out;
+
+    vlc_mutex_init( &p_stage->lock );
+    vlc_cond_init( &p_stage->wait_in );
+    vlc_cond_init( &p_stage->wait_out );
+
+    if( vlc_clone( &p_stage->thread, StageThread, p_stage, i_priority ) )
+    {
+        vlc_cond_destroy( &p_stage->wait_out );
+        vlc_cond_destroy( &p_stage->wait_in );
+        vlc_mutex_destroy( &p_stage->lock );
+        free( p_stage->pp_items );
+        free( p_stage );
+        return NULL;
+    }
+    return p_stage;
+}
+
+void transcode_stage_Delete( transcode_stage_t *p_stage )
+{
+    vlc_mutex_lock( &p_stage->lock );
+    p_stage->b_abort = true;
+    vlc_cond_signal( &p_stage->wait_in );
+    vlc_mutex_unlock( &p_stage->lock );
+
+    vlc_join( p_stage->thread, NULL );
+
+    assert( p_stage->i_count == 0 );
+    block_ChainRelease( p_stage->p_out );
+    vlc_cond_destroy( &p_stage->wait_out );
+    vlc_cond_destroy( &p_stage->wait_in );
+    vlc_mutex_destroy( &p_stage->lock );
+    free( p_stage->pp_items );
+    free( p_stage );
+}
+
+int transcode_stage_Push( transcode_stage_t *p_stage, void *p_item )
+{
+    int ret = VLC_EGENERIC;
+
+    vlc_mutex_lock( &p_stage->lock );
+    while( p_stage->i_count == p_stage->i_size && !p_stage->b_error )
+        vlc_cond_wait( &p_stage->wait_out, &p_stage->lock );
+
+    if( !p_stage->b_error )
+    {
+        unsigned i_last = (p_stage->i_first + p_stage->i_count)
+                          % p_stage->i_size;
+        p_stage->pp_items[i_last] = p_item;
+        p_stage->i_count++;
+        vlc_cond_signal( &p_stage->wait_in );
+        ret = VLC_SUCCESS;
+    }
+    vlc_mutex_unlock( &p_stage->lock );
+    return ret;
+}
+
+void transcode_stage_Drain( transcode_stage_t *p_stage )
+{
+    vlc_mutex_lock( &p_stage->lock );
+    while( p_stage->i_count > 0 || p_stage->b_busy )
+        vlc_cond_wait( &p_stage->wait_out, &p_stage->lock );
+    vlc_mutex_unlock( &p_stage->lock );
+}
+
+void transcode_stage_Output( transcode_stage_t *p_stage, block_t *p_block )
+{
+    if( p_block == NULL )
+        return;
+
+    vlc_mutex_lock( &p_stage->lock );
+    block_ChainLastAppend( &p_stage->pp_out_last, p_block );
+    vlc_mutex_unlock( &p_stage->lock );
+}
+
+block_t *transcode_stage_GetOutput( transcode_stage_t *p_stage )
+{
+    vlc_mutex_lock( &p_stage->lock );
+    block_t *p_out = p_stage->p_out;
+    p_stage->p_out = NULL;
+    p_stage->pp_out_last = &p_stage->p_out;
+    vlc_mutex_unlock( &p_stage->lock );
+
+    return p_out;
+}
@@ -36,6 +36,7 @@
 #include <vlc_plugin.h>
 
 #include <vlc_spu.h>
+#include <vlc_charset.h>
 
 #include "transcode.h"
 
@@ -55,6 +56,13 @@
 #define SCALE_TEXT N_("Video scaling")
 #define SCALE_LONGTEXT N_( \
     "Scale factor to apply to the video while transcoding (eg: 0.25)")
+#define RUNG_TEXT N_("Extra video rendition")
+#define RUNG_LONGTEXT N_( \
+    "Encodes another rendition of the video from the same decoded pictures, " \
+    "with its own venc, vcodec, vb, scale, width, height, maxwidth and " \
+    "maxheight options (eg: rung={vb=800,scale=0.5}). The encoder, codec " \
+    "and bitrate default to the main rendition ones. Can be repeated, the " \
+    "audio is encoded only once." )
 #define FPS_TEXT N_("Video frame-rate")
 #define FPS_LONGTEXT N_( \
     "Target output frame rate for the video stream." )
@@ -122,14 +130,16 @@
 
 #define THREADS_TEXT N_("Number of threads")
 #define THREADS_LONGTEXT N_( \
-    "Number of threads used for the transcoding." )
+    "Number of threads used for the transcoding. If not zero, the filters " \
+    "and the encoder of each transcoded stream also run in their own threads." )
 #define HP_TEXT N_("High priority")
 #define HP_LONGTEXT N_( \
-    "Runs the optional encoder thread at the OUTPUT priority instead of " \
-    "VIDEO." )
+    "Runs the optional encoder threads at the OUTPUT priority instead of " \
+    "VIDEO or AUDIO." )
 #define POOL_TEXT N_("Picture pool size")
-#define POOL_LONGTEXT N_( "Defines how many pictures we allow to be in pool "\
-    "between decoder/encoder threads when threads > 0" )
+#define POOL_LONGTEXT N_( "Defines how many pictures or audio buffers we "\
+    "allow to be queued between the decoder, filters and encoder threads " \
+    "when threads > 0" )
 
 
 static const char *const ppsz_deinterlace_type[] =
@@ -174,6 +184,8 @@ vlc_module_begin ()
                  HEIGHT_LONGTEXT, true )
     add_integer( SOUT_CFG_PREFIX "maxwidth", 0, MAXWIDTH_TEXT,
                  MAXWIDTH_LONGTEXT, true )
+    add_string( SOUT_CFG_PREFIX "rung", NULL, RUNG_TEXT,
+                RUNG_LONGTEXT, true )
     add_integer( SOUT_CFG_PREFIX "maxheight", 0, MAXHEIGHT_TEXT,
                  MAXHEIGHT_LONGTEXT, true )
     add_module_list( SOUT_CFG_PREFIX "vfilter", "video filter",
@@ -224,7 +236,7 @@ static const char *const ppsz_sout_options[] = {
     "deinterlace-module", "threads", "aenc", "acodec", "ab", "alang",
     "afilter", "samplerate", "channels", "senc", "scodec", "soverlay",
     "sfilter", "high-priority", "maxwidth", "maxheight", "pool-size",
-    NULL
+    "rung", NULL
 };
 
 /*****************************************************************************
@@ -234,6 +246,68 @@ static sout_stream_id_sys_t *Add( sout_stream_t *, const es_format_t * );
 static void              Del ( sout_stream_t *, sout_stream_id_sys_t * );
 static int               Send( sout_stream_t *, sout_stream_id_sys_t *, block_t* );
 
+/* Parses the options of an extra video rendition. The encoder, codec and
+ * bitrate default to the main rendition ones, not the dimensions. */
+static void ParseRung( sout_stream_t *p_stream, transcode_video_cfg_t *p_rung,
+                       const transcode_video_cfg_t *p_main,
+                       const char *psz_opts )
+{
+    config_chain_t *p_cfg = NULL;
+
+    memset( p_rung, 0, sizeof( *p_rung ) );
+    p_rung->i_vcodec = p_main->i_vcodec;
+    p_rung->i_vbitrate = p_main->i_vbitrate;
+
+    config_ChainParseOptions( &p_cfg, psz_opts );
+    for( config_chain_t *p = p_cfg; p != NULL; p = p->p_next )
+    {
+        const char *psz_value = p->psz_value ? p->psz_value : "";
+
+        if( !strcmp( p->psz_name, "venc" ) )
+        {
+            config_ChainDestroy( p_rung->p_video_cfg );
+            free( p_rung->psz_venc );
+            free( config_ChainCreate( &p_rung->psz_venc, &p_rung->p_video_cfg,
+                                      psz_value ) );
+        }
+        else if( !strcmp( p->psz_name, "vcodec" ) )
+        {
+            char fcc[5] = "    \0";
+            memcpy( fcc, psz_value, __MIN( strlen( psz_value ), 4 ) );
+            p_rung->i_vcodec = vlc_fourcc_GetCodecFromString( VIDEO_ES, fcc );
+        }
+        else if( !strcmp( p->psz_name, "vb" ) )
+        {
+            p_rung->i_vbitrate = atoi( psz_value );
+            if( p_rung->i_vbitrate < 16000 ) p_rung->i_vbitrate *= 1000;
+        }
+        else if( !strcmp( p->psz_name, "scale" ) )
+            p_rung->f_scale = us_atof( psz_value );
+        else if( !strcmp( p->psz_name, "width" ) )
+            p_rung->i_width = atoi( psz_value );
+        else if( !strcmp( p->psz_name, "height" ) )
+            p_rung->i_height = atoi( psz_value );
+        else if( !strcmp( p->psz_name, "maxwidth" ) )
+            p_rung->i_maxwidth = atoi( psz_value );
+        else if( !strcmp( p->psz_name, "maxheight" ) )
+            p_rung->i_maxheight = atoi( psz_value );
+        else
+            msg_Err( p_stream, "ignoring unknown rendition option `%s'",
+                     p->psz_name );
+    }
+    config_ChainDestroy( p_cfg );
+
+    if( p_rung->psz_venc == NULL && p_main->psz_venc != NULL )
+    {
+        p_rung->psz_venc = strdup( p_main->psz_venc );
+        p_rung->p_video_cfg = config_ChainDuplicate( p_main->p_video_cfg );
+    }
+
+    msg_Dbg( p_stream, "extra rendition=%4.4s %dx%d scaling: %f %dkb/s",
+             (char *)&p_rung->i_vcodec, p_rung->i_width, p_rung->i_height,
+             p_rung->f_scale, p_rung->i_vbitrate / 1000 );
+}
+
 /*****************************************************************************
  * Open:
  *****************************************************************************/
@@ -311,42 +385,42 @@ static int Open( vlc_object_t *p_this )
 
     /* Video transcoding parameters */
     psz_string = var_GetString( p_stream, SOUT_CFG_PREFIX "venc" );
-    p_sys->psz_venc = NULL;
-    p_sys->p_video_cfg = NULL;
+    p_sys->video.psz_venc = NULL;
+    p_sys->video.p_video_cfg = NULL;
     if( psz_string && *psz_string )
     {
         char *psz_next;
-        psz_next = config_ChainCreate( &p_sys->psz_venc, &p_sys->p_video_cfg,
+        psz_next = config_ChainCreate( &p_sys->video.psz_venc, &p_sys->video.p_video_cfg,
                                    psz_string );
         free( psz_next );
     }
     free( psz_string );
 
     psz_string = var_GetString( p_stream, SOUT_CFG_PREFIX "vcodec" );
-    p_sys->i_vcodec = 0;
+    p_sys->video.i_vcodec = 0;
     if( psz_string && *psz_string )
     {
         char fcc[5] = "    \0";
         memcpy( fcc, psz_string, __MIN( strlen( psz_string ), 4 ) );
-        p_sys->i_vcodec = vlc_fourcc_GetCodecFromString( VIDEO_ES, fcc );
-        msg_Dbg( p_stream, "Checking video codec mapping for %s got %4.4s ", fcc, (char*)&p_sys->i_vcodec);
+        p_sys->video.i_vcodec = vlc_fourcc_GetCodecFromString( VIDEO_ES, fcc );
+        msg_Dbg( p_stream, "Checking video codec mapping for %s got %4.4s ", fcc, (char*)&p_sys->video.i_vcodec);
     }
     free( psz_string );
 
-    p_sys->i_vbitrate = var_GetInteger( p_stream, SOUT_CFG_PREFIX "vb" );
-    if( p_sys->i_vbitrate < 16000 ) p_sys->i_vbitrate *= 1000;
+    p_sys->video.i_vbitrate = var_GetInteger( p_stream, SOUT_CFG_PREFIX "vb" );
+    if( p_sys->video.i_vbitrate < 16000 ) p_sys->video.i_vbitrate *= 1000;
 
-    p_sys->f_scale = var_GetFloat( p_stream, SOUT_CFG_PREFIX "scale" );
+    p_sys->video.f_scale = var_GetFloat( p_stream, SOUT_CFG_PREFIX "scale" );
 
     p_sys->b_master_sync = var_InheritURational( p_stream, &p_sys->fps_num, &p_sys->fps_den, SOUT_CFG_PREFIX "fps" ) == VLC_SUCCESS;
 
-    p_sys->i_width = var_GetInteger( p_stream, SOUT_CFG_PREFIX "width" );
+    p_sys->video.i_width = var_GetInteger( p_stream, SOUT_CFG_PREFIX "width" );
 
-    p_sys->i_height = var_GetInteger( p_stream, SOUT_CFG_PREFIX "height" );
+    p_sys->video.i_height = var_GetInteger( p_stream, SOUT_CFG_PREFIX "height" );
 
-    p_sys->i_maxwidth = var_GetInteger( p_stream, SOUT_CFG_PREFIX "maxwidth" );
+    p_sys->video.i_maxwidth = var_GetInteger( p_stream, SOUT_CFG_PREFIX "maxwidth" );
 
-    p_sys->i_maxheight = var_GetInteger( p_stream, SOUT_CFG_PREFIX "maxheight" );
+    p_sys->video.i_maxheight = var_GetInteger( p_stream, SOUT_CFG_PREFIX "maxheight" );
 
     psz_string = var_GetString( p_stream, SOUT_CFG_PREFIX "vfilter" );
     if( psz_string && *psz_string )
@@ -365,15 +439,33 @@ static int Open( vlc_object_t *p_this )
                               &p_sys->p_deinterlace_cfg, psz_string ) );
     free( psz_string );
 
+    /* Extra video renditions */
+    p_sys->p_rungs = NULL;
+    p_sys->i_rungs = 0;
+    for( config_chain_t *p_cfg = p_stream->p_cfg; p_cfg != NULL;
+         p_cfg = p_cfg->p_next )
+    {
+        if( strcmp( p_cfg->psz_name, "rung" ) || !p_sys->video.i_vcodec )
+            continue;
+
+        transcode_video_cfg_t *p_rungs =
+            realloc( p_sys->p_rungs, (p_sys->i_rungs + 1) * sizeof( *p_rungs ) );
+        if( unlikely(p_rungs == NULL) )
+            break;
+        p_sys->p_rungs = p_rungs;
+        ParseRung( p_stream, &p_rungs[p_sys->i_rungs++], &p_sys->video,
+                   p_cfg->psz_value ? p_cfg->psz_value : "" );
+    }
+
     p_sys->i_threads = var_GetInteger( p_stream, SOUT_CFG_PREFIX "threads" );
     p_sys->pool_size = var_GetInteger( p_stream, SOUT_CFG_PREFIX "pool-size" );
     p_sys->b_high_priority = var_GetBool( p_stream, SOUT_CFG_PREFIX "high-priority" );
 
-    if( p_sys->i_vcodec )
+    if( p_sys->video.i_vcodec )
     {
         msg_Dbg( p_stream, "codec video=%4.4s %dx%d scaling: %f %dkb/s",
-                 (char *)&p_sys->i_vcodec, p_sys->i_width, p_sys->i_height,
-                 p_sys->f_scale, p_sys->i_vbitrate / 1000 );
+                 (char *)&p_sys->video.i_vcodec, p_sys->video.i_width, p_sys->video.i_height,
+                 p_sys->video.f_scale, p_sys->video.i_vbitrate / 1000 );
     }
 
     /* Subpictures transcoding parameters */
@@ -443,8 +535,15 @@ static void Close( vlc_object_t * p_this )
 
     free( p_sys->psz_vf2 );
 
-    config_ChainDestroy( p_sys->p_video_cfg );
-    free( p_sys->psz_venc );
+    config_ChainDestroy( p_sys->video.p_video_cfg );
+    free( p_sys->video.psz_venc );
+
+    for( int i = 0; i < p_sys->i_rungs; i++ )
+    {
+        config_ChainDestroy( p_sys->p_rungs[i].p_video_cfg );
+        free( p_sys->p_rungs[i].psz_venc );
+    }
+    free( p_sys->p_rungs );
 
     config_ChainDestroy( p_sys->p_deinterlace_cfg );
     free( p_sys->psz_deinterlace );
@@ -462,7 +561,11 @@ static void DeleteSoutStreamID( sout_stream_id_sys_t *id )
 {
     if( id )
     {
-        if( id->p_decoder )
+        for( int i = 0; i < id->i_rungs; i++ )
+            DeleteSoutStreamID( id->pp_rungs[i] );
+        free( id->pp_rungs );
+
+        if( id->p_decoder && !id->b_rung )
         {
             es_format_Clean( &id->p_decoder->fmt_in );
             es_format_Clean( &id->p_decoder->fmt_out );
@@ -481,6 +584,53 @@ static void DeleteSoutStreamID( sout_stream_id_sys_t *id )
     }
 }
 
+static encoder_t *NewEncoder( sout_stream_t *p_stream,
+                              const es_format_t *p_fmt )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    encoder_t *p_encoder = sout_EncoderCreate( p_stream );
+    if( !p_encoder )
+        return NULL;
+    p_encoder->p_module = NULL;
+
+    /* Create destination format */
+    es_format_Init( &p_encoder->fmt_in, p_fmt->i_cat, 0 );
+    es_format_Init( &p_encoder->fmt_out, p_fmt->i_cat, 0 );
+    p_encoder->fmt_out.i_id    = p_fmt->i_id;
+    p_encoder->fmt_out.i_group = p_fmt->i_group;
+
+    if( p_sys->psz_alang )
+        p_encoder->fmt_out.psz_language = strdup( p_sys->psz_alang );
+    else if( p_fmt->psz_language )
+        p_encoder->fmt_out.psz_language = strdup( p_fmt->psz_language );
+
+    return p_encoder;
+}
+
+/* Adds an extra rendition of a video stream, fed by its decoder */
+static void AddRung( sout_stream_t *p_stream, const es_format_t *p_fmt,
+                     sout_stream_id_sys_t *id,
+                     const transcode_video_cfg_t *p_vcfg )
+{
+    sout_stream_id_sys_t *rung = calloc( 1, sizeof( *rung ) );
+    if( !rung )
+        return;
+
+    vlc_mutex_init( &rung->fifo.lock );
+    rung->p_decoder = id->p_decoder;
+    rung->b_rung = true;
+    rung->p_vcfg = p_vcfg;
+
+    rung->p_encoder = NewEncoder( p_stream, p_fmt );
+    if( !rung->p_encoder || !transcode_video_add( p_stream, p_fmt, rung ) )
+    {
+        msg_Err( p_stream, "cannot create video rendition %d", id->i_rungs );
+        DeleteSoutStreamID( rung );
+        return;
+    }
+    TAB_APPEND( id->i_rungs, id->pp_rungs, rung );
+}
+
 static sout_stream_id_sys_t *Add( sout_stream_t *p_stream,
                                   const es_format_t *p_fmt )
 {
@@ -506,28 +656,21 @@ static sout_stream_id_sys_t *Add( sout_stream_t *p_stream,
     id->p_decoder->b_frame_drop_allowed = false;
 
     /* Create encoder object */
-    id->p_encoder = sout_EncoderCreate( p_stream );
+    id->p_encoder = NewEncoder( p_stream, p_fmt );
     if( !id->p_encoder )
         goto error;
-    id->p_encoder->p_module = NULL;
-
-    /* Create destination format */
-    es_format_Init( &id->p_encoder->fmt_in, p_fmt->i_cat, 0 );
-    es_format_Init( &id->p_encoder->fmt_out, p_fmt->i_cat, 0 );
-    id->p_encoder->fmt_out.i_id    = p_fmt->i_id;
-    id->p_encoder->fmt_out.i_group = p_fmt->i_group;
-
-    if( p_sys->psz_alang )
-        id->p_encoder->fmt_out.psz_language = strdup( p_sys->psz_alang );
-    else if( p_fmt->psz_language )
-        id->p_encoder->fmt_out.psz_language = strdup( p_fmt->psz_language );
 
     bool success;
 
     if( p_fmt->i_cat == AUDIO_ES && p_sys->i_acodec )
         success = transcode_audio_add(p_stream, p_fmt, id);
-    else if( p_fmt->i_cat == VIDEO_ES && p_sys->i_vcodec )
+    else if( p_fmt->i_cat == VIDEO_ES && p_sys->video.i_vcodec )
+    {
+        id->p_vcfg = &p_sys->video;
         success = transcode_video_add(p_stream, p_fmt, id);
+        for( int i = 0; success && i < p_sys->i_rungs; i++ )
+            AddRung( p_stream, p_fmt, id, &p_sys->p_rungs[i] );
+    }
     else if( ( p_fmt->i_cat == SPU_ES ) &&
              ( p_sys->i_scodec || p_sys->b_soverlay ) )
         success = transcode_spu_add(p_stream, p_fmt, id);
@@ -573,6 +716,9 @@ static void Del( sout_stream_t *p_stream, sout_stream_id_sys_t *id )
         }
     }
 
+    for( int i = 0; i < id->i_rungs; i++ )
+        if( id->pp_rungs[i]->id )
+            sout_StreamIdDel( p_stream->p_next, id->pp_rungs[i]->id );
     if( id->id ) sout_StreamIdDel( p_stream->p_next, id->id );
 
     DeleteSoutStreamID( id );
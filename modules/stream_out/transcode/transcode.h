@@ -9,22 +9,24 @@
 #include <vlc_es.h>
 #include <vlc_codec.h>
 
-#include <vlc_picture_fifo.h>
-
 /*100ms is around the limit where people are noticing lipsync issues*/
 #define MASTER_SYNC_MAX_DRIFT 100000
 
+/* Video encoding parameters, of the main output or of an extra rendition */
+typedef struct
+{
+    vlc_fourcc_t    i_vcodec;   /* codec video (0 if not transcode) */
+    char            *psz_venc;
+    config_chain_t  *p_video_cfg;
+    int             i_vbitrate;
+    float           f_scale;
+    unsigned int    i_width, i_maxwidth;
+    unsigned int    i_height, i_maxheight;
+} transcode_video_cfg_t;
+
 struct sout_stream_sys_t
 {
-    sout_stream_id_sys_t *id_video;
-    block_t         *p_buffers;
-    vlc_mutex_t     lock_out;
-    vlc_cond_t      cond;
-    bool            b_abort;
-    picture_fifo_t *pp_pics;
-    vlc_sem_t       picture_pool_has_room;
     uint32_t        pool_size;
-    vlc_thread_t    thread;
 
     /* Audio */
     vlc_fourcc_t    i_acodec;   /* codec audio (0 if not transcode) */
@@ -38,13 +40,10 @@ struct sout_stream_sys_t
     char            *psz_af;
 
     /* Video */
-    vlc_fourcc_t    i_vcodec;   /* codec video (0 if not transcode) */
-    char            *psz_venc;
-    config_chain_t  *p_video_cfg;
-    int             i_vbitrate;
-    float           f_scale;
-    unsigned int    i_width, i_maxwidth;
-    unsigned int    i_height, i_maxheight;
+    transcode_video_cfg_t video;
+    /* Extra renditions, encoded from the same decoded pictures */
+    transcode_video_cfg_t *p_rungs;
+    int             i_rungs;
     char            *psz_deinterlace;
     config_chain_t  *p_deinterlace_cfg;
     int             i_threads;
@@ -70,6 +69,25 @@ struct sout_stream_sys_t
 
 struct aout_filters;
 
+/* PIPELINE STAGES */
+
+/* A stage processes the pushed items, pictures or blocks, in its own thread,
+ * with pf_process( p_opaque, item ). */
+typedef struct transcode_stage_t transcode_stage_t;
+
+transcode_stage_t *transcode_stage_New( unsigned i_size,
+                                        int (*pf_process)( void *, void * ),
+                                        void *p_opaque, int i_priority );
+/* Processes the queued items, then stops the thread */
+void transcode_stage_Delete( transcode_stage_t * );
+/* Waits while i_size items are queued. Fails, without taking the item, once
+ * an item failed to be processed. */
+int  transcode_stage_Push( transcode_stage_t *, void * );
+/* Waits until all the pushed items are processed */
+void transcode_stage_Drain( transcode_stage_t * );
+void transcode_stage_Output( transcode_stage_t *, block_t * );
+block_t *transcode_stage_GetOutput( transcode_stage_t * );
+
 struct sout_stream_id_sys_t
 {
     bool            b_transcode;
@@ -118,6 +136,16 @@ struct sout_stream_id_sys_t
 
     /* Encoder */
     encoder_t       *p_encoder;
+    const transcode_video_cfg_t *p_vcfg;
+
+    /* Extra renditions of the video, fed by this decoder */
+    sout_stream_id_sys_t **pp_rungs;
+    int             i_rungs;
+    bool            b_rung; /**< the decoder belongs to another id */
+
+    /* Filter and encoder threads, if threads > 0 */
+    transcode_stage_t *p_filter_stage;
+    transcode_stage_t *p_encoder_stage;
 
     /* Sync */
     date_t          next_input_pts; /**< Incoming calculated PTS */
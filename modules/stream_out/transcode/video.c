@@ -97,60 +97,19 @@ static picture_t *transcode_video_filter_buffer_new( filter_t *p_filter )
     return picture_NewFromFormat( &p_filter->fmt_out.video );
 }
 
-static void* EncoderThread( void *obj )
+static int EncodeVideo( void *opaque, void *item )
 {
-    sout_stream_sys_t *p_sys = (sout_stream_sys_t*)obj;
-    sout_stream_id_sys_t *id = p_sys->id_video;
-    picture_t *p_pic = NULL;
-    int canc = vlc_savecancel ();
-    block_t *p_block = NULL;
+    sout_stream_id_sys_t *id = opaque;
+    picture_t *p_pic = item;
 
-    vlc_mutex_lock( &p_sys->lock_out );
-
-    for( ;; )
-    {
-        while( !p_sys->b_abort &&
-               (p_pic = picture_fifo_Pop( p_sys->pp_pics )) == NULL )
-            vlc_cond_wait( &p_sys->cond, &p_sys->lock_out );
-        vlc_sem_post( &p_sys->picture_pool_has_room );
-
-        if( p_pic )
-        {
-            /* release lock while encoding */
-            vlc_mutex_unlock( &p_sys->lock_out );
-            p_block = id->p_encoder->pf_encode_video( id->p_encoder, p_pic );
-            picture_Release( p_pic );
-            vlc_mutex_lock( &p_sys->lock_out );
-
-            block_ChainAppend( &p_sys->p_buffers, p_block );
-        }
-
-        if( p_sys->b_abort )
-            break;
-    }
-
-    /*Encode what we have in the buffer on closing*/
-    while( (p_pic = picture_fifo_Pop( p_sys->pp_pics )) != NULL )
-    {
-        vlc_sem_post( &p_sys->picture_pool_has_room );
-        p_block = id->p_encoder->pf_encode_video( id->p_encoder, p_pic );
-        picture_Release( p_pic );
-        block_ChainAppend( &p_sys->p_buffers, p_block );
-    }
-
-    /*Now flush encoder*/
-    do {
-        p_block = id->p_encoder->pf_encode_video(id->p_encoder, NULL );
-        block_ChainAppend( &p_sys->p_buffers, p_block );
-    } while( p_block );
-
-    vlc_mutex_unlock( &p_sys->lock_out );
-
-    vlc_restorecancel (canc);
-
-    return NULL;
+    block_t *p_block = id->p_encoder->pf_encode_video( id->p_encoder, p_pic );
+    picture_Release( p_pic );
+    transcode_stage_Output( id->p_encoder_stage, p_block );
+    return VLC_SUCCESS;
 }
 
+static int FilterVideo( void *, void * );
+
 static int decoder_queue_video( decoder_t *p_dec, picture_t *p_pic )
 {
     sout_stream_id_sys_t *id = p_dec->p_queue_ctx;
@@ -177,28 +136,31 @@ static int transcode_video_new( sout_stream_t *p_stream, sout_stream_id_sys_t *i
 {
     sout_stream_sys_t *p_sys = p_stream->p_sys;
 
-    /* Open decoder
+    /* Open decoder, unless it is shared with the main rendition
      * Initialization of decoder structures
      */
-    id->p_decoder->fmt_out = id->p_decoder->fmt_in;
-    id->p_decoder->fmt_out.i_extra = 0;
-    id->p_decoder->fmt_out.p_extra = NULL;
-    id->p_decoder->fmt_out.psz_language = NULL;
-    id->p_decoder->pf_decode = NULL;
-    id->p_decoder->pf_queue_video = decoder_queue_video;
-    id->p_decoder->p_queue_ctx = id;
-    id->p_decoder->pf_get_cc = NULL;
-    id->p_decoder->pf_vout_format_update = video_update_format_decoder;
-    id->p_decoder->pf_vout_buffer_new = video_new_buffer_decoder;
-    id->p_decoder->p_owner = (decoder_owner_sys_t*) p_stream;
-
-    id->p_decoder->p_module =
-        module_need( id->p_decoder, "video decoder", "$codec", false );
-
-    if( !id->p_decoder->p_module )
-    {
-        msg_Err( p_stream, "cannot find video decoder" );
-        return VLC_EGENERIC;
+    if( !id->b_rung )
+    {
+        id->p_decoder->fmt_out = id->p_decoder->fmt_in;
+        id->p_decoder->fmt_out.i_extra = 0;
+        id->p_decoder->fmt_out.p_extra = NULL;
+        id->p_decoder->fmt_out.psz_language = NULL;
+        id->p_decoder->pf_decode = NULL;
+        id->p_decoder->pf_queue_video = decoder_queue_video;
+        id->p_decoder->p_queue_ctx = id;
+        id->p_decoder->pf_get_cc = NULL;
+        id->p_decoder->pf_vout_format_update = video_update_format_decoder;
+        id->p_decoder->pf_vout_buffer_new = video_new_buffer_decoder;
+        id->p_decoder->p_owner = (decoder_owner_sys_t*) p_stream;
+
+        id->p_decoder->p_module =
+            module_need( id->p_decoder, "video decoder", "$codec", false );
+
+        if( !id->p_decoder->p_module )
+        {
+            msg_Err( p_stream, "cannot find video decoder" );
+            return VLC_EGENERIC;
+        }
     }
 
     /*
@@ -240,18 +202,16 @@ static int transcode_video_new( sout_stream_t *p_stream, sout_stream_id_sys_t *i
     id->p_encoder->fmt_in.video.i_frame_rate_base = ENC_FRAMERATE_BASE;
 
     id->p_encoder->i_threads = p_sys->i_threads;
-    id->p_encoder->p_cfg = p_sys->p_video_cfg;
+    id->p_encoder->p_cfg = id->p_vcfg->p_video_cfg;
 
     id->p_encoder->p_module =
-        module_need( id->p_encoder, "encoder", p_sys->psz_venc, true );
+        module_need( id->p_encoder, "encoder", id->p_vcfg->psz_venc, true );
     if( !id->p_encoder->p_module )
     {
         msg_Err( p_stream, "cannot find video encoder (module:%s fourcc:%4.4s). Take a look few lines earlier to see possible reason.",
-                 p_sys->psz_venc ? p_sys->psz_venc : "any",
-                 (char *)&p_sys->i_vcodec );
-        module_unneed( id->p_decoder, id->p_decoder->p_module );
-        id->p_decoder->p_module = 0;
-        return VLC_EGENERIC;
+                 id->p_vcfg->psz_venc ? id->p_vcfg->psz_venc : "any",
+                 (char *)&id->p_vcfg->i_vcodec );
+        goto error;
     }
 
     /* Close the encoder.
@@ -268,34 +228,37 @@ static int transcode_video_new( sout_stream_t *p_stream, sout_stream_id_sys_t *i
     if( p_sys->i_threads <= 0 )
         return VLC_SUCCESS;
 
+    /* Decoding stays in the input thread, filtering and encoding each get
+     * their own */
     int i_priority = p_sys->b_high_priority ? VLC_THREAD_PRIORITY_OUTPUT :
                        VLC_THREAD_PRIORITY_VIDEO;
-    p_sys->id_video = id;
-    p_sys->pp_pics = picture_fifo_New();
-    if( p_sys->pp_pics == NULL )
+    id->p_encoder_stage = transcode_stage_New( p_sys->pool_size, EncodeVideo,
+                                               id, i_priority );
+    if( id->p_encoder_stage != NULL )
     {
-        msg_Err( p_stream, "cannot create picture fifo" );
-        module_unneed( id->p_decoder, id->p_decoder->p_module );
-        id->p_decoder->p_module = NULL;
-        return VLC_ENOMEM;
+        id->p_filter_stage = transcode_stage_New( p_sys->pool_size,
+                                                  FilterVideo, id,
+                                                  VLC_THREAD_PRIORITY_VIDEO );
+        if( id->p_filter_stage == NULL )
+        {
+            transcode_stage_Delete( id->p_encoder_stage );
+            id->p_encoder_stage = NULL;
+        }
     }
+    if( id->p_filter_stage == NULL )
+    {
+        msg_Err( p_stream, "cannot spawn encoder threads" );
+        goto error;
+    }
+    return VLC_SUCCESS;
 
-    vlc_sem_init( &p_sys->picture_pool_has_room, p_sys->pool_size );
-    vlc_mutex_init( &p_sys->lock_out );
-    vlc_cond_init( &p_sys->cond );
-    p_sys->p_buffers = NULL;
-    p_sys->b_abort = false;
-    if( vlc_clone( &p_sys->thread, EncoderThread, p_sys, i_priority ) )
+error:
+    if( !id->b_rung )
     {
-        msg_Err( p_stream, "cannot spawn encoder thread" );
-        vlc_mutex_destroy( &p_sys->lock_out );
-        vlc_cond_destroy( &p_sys->cond );
-        picture_fifo_Delete( p_sys->pp_pics );
         module_unneed( id->p_decoder, id->p_decoder->p_module );
         id->p_decoder->p_module = NULL;
-        return VLC_EGENERIC;
     }
-    return VLC_SUCCESS;
+    return VLC_EGENERIC;
 }
 
 static void transcode_video_filter_init( sout_stream_t *p_stream,
@@ -431,7 +394,7 @@ static void transcode_video_size_init( sout_stream_t *p_stream,
                                      sout_stream_id_sys_t *id,
                                      const es_format_t *p_fmt_out )
 {
-    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    const transcode_video_cfg_t *p_vcfg = id->p_vcfg;
 
     /* Calculate scaling
      * width/height of source */
@@ -462,12 +425,12 @@ static void transcode_video_size_init( sout_stream_t *p_stream,
 
     /* Calculate scaling factor for specified parameters */
     if( id->p_encoder->fmt_out.video.i_visible_width <= 0 &&
-        id->p_encoder->fmt_out.video.i_visible_height <= 0 && p_sys->f_scale )
+        id->p_encoder->fmt_out.video.i_visible_height <= 0 && p_vcfg->f_scale )
     {
         /* Global scaling. Make sure width will remain a factor of 16 */
         float f_real_scale;
         int  i_new_height;
-        int i_new_width = i_src_visible_width * p_sys->f_scale;
+        int i_new_width = i_src_visible_width * p_vcfg->f_scale;
 
         if( i_new_width % 16 <= 7 && i_new_width >= 16 )
             i_new_width -= i_new_width % 16;
@@ -504,16 +467,16 @@ static void transcode_video_size_init( sout_stream_t *p_stream,
      }
 
      /* check maxwidth and maxheight */
-     if( p_sys->i_maxwidth && f_scale_width > (float)p_sys->i_maxwidth /
+     if( p_vcfg->i_maxwidth && f_scale_width > (float)p_vcfg->i_maxwidth /
                                                      i_src_visible_width )
      {
-         f_scale_width = (float)p_sys->i_maxwidth / i_src_visible_width;
+         f_scale_width = (float)p_vcfg->i_maxwidth / i_src_visible_width;
      }
 
-     if( p_sys->i_maxheight && f_scale_height > (float)p_sys->i_maxheight /
+     if( p_vcfg->i_maxheight && f_scale_height > (float)p_vcfg->i_maxheight /
                                                        i_src_visible_height )
      {
-         f_scale_height = (float)p_sys->i_maxheight / i_src_visible_height;
+         f_scale_height = (float)p_vcfg->i_maxheight / i_src_visible_height;
      }
 
 
@@ -612,20 +575,17 @@ static void transcode_video_encoder_init( sout_stream_t *p_stream,
 static int transcode_video_encoder_open( sout_stream_t *p_stream,
                                          sout_stream_id_sys_t *id )
 {
-    sout_stream_sys_t *p_sys = p_stream->p_sys;
-
-
     msg_Dbg( p_stream, "destination (after video filters) %ix%i",
              id->p_encoder->fmt_in.video.i_width,
              id->p_encoder->fmt_in.video.i_height );
 
     id->p_encoder->p_module =
-        module_need( id->p_encoder, "encoder", p_sys->psz_venc, true );
+        module_need( id->p_encoder, "encoder", id->p_vcfg->psz_venc, true );
     if( !id->p_encoder->p_module )
     {
         msg_Err( p_stream, "cannot find video encoder (module:%s fourcc:%4.4s)",
-                 p_sys->psz_venc ? p_sys->psz_venc : "any",
-                 (char *)&p_sys->i_vcodec );
+                 id->p_vcfg->psz_venc ? id->p_vcfg->psz_venc : "any",
+                 (char *)&id->p_vcfg->i_vcodec );
         return VLC_EGENERIC;
     }
 
@@ -648,34 +608,43 @@ static int transcode_video_encoder_open( sout_stream_t *p_stream,
 void transcode_video_close( sout_stream_t *p_stream,
                                    sout_stream_id_sys_t *id )
 {
-    if( p_stream->p_sys->i_threads >= 1 && !p_stream->p_sys->b_abort )
+    /* The extra renditions use the decoder */
+    for( int i = 0; i < id->i_rungs; i++ )
     {
-        vlc_mutex_lock( &p_stream->p_sys->lock_out );
-        p_stream->p_sys->b_abort = true;
-        vlc_cond_signal( &p_stream->p_sys->cond );
-        vlc_mutex_unlock( &p_stream->p_sys->lock_out );
-
-        vlc_join( p_stream->p_sys->thread, NULL );
+        sout_stream_id_sys_t *rung = id->pp_rungs[i];
 
-        picture_fifo_Delete( p_stream->p_sys->pp_pics );
-        block_ChainRelease( p_stream->p_sys->p_buffers );
+        if( rung->b_transcode )
+        {
+            transcode_video_close( p_stream, rung );
+            rung->b_transcode = false;
+        }
     }
 
-    if( p_stream->p_sys->i_threads >= 1 )
+    /* The filters thread feeds the encoder one, stop it first */
+    if( id->p_filter_stage != NULL )
+    {
+        transcode_stage_Delete( id->p_filter_stage );
+        id->p_filter_stage = NULL;
+    }
+    if( id->p_encoder_stage != NULL )
     {
-        vlc_mutex_destroy( &p_stream->p_sys->lock_out );
-        vlc_cond_destroy( &p_stream->p_sys->cond );
+        transcode_stage_Delete( id->p_encoder_stage );
+        id->p_encoder_stage = NULL;
     }
 
     /* Close decoder */
-    if( id->p_decoder->p_module )
-        module_unneed( id->p_decoder, id->p_decoder->p_module );
-    if( id->p_decoder->p_description )
-        vlc_meta_Delete( id->p_decoder->p_description );
+    if( !id->b_rung )
+    {
+        if( id->p_decoder->p_module )
+            module_unneed( id->p_decoder, id->p_decoder->p_module );
+        if( id->p_decoder->p_description )
+            vlc_meta_Delete( id->p_decoder->p_description );
+    }
 
     /* Close encoder */
     if( id->p_encoder->p_module )
         module_unneed( id->p_encoder, id->p_encoder->p_module );
+    id->p_encoder->p_module = NULL;
 
     /* Close filters */
     if( id->p_f_chain )
@@ -730,31 +699,173 @@ static void OutputFrame( sout_stream_t *p_stream, picture_t *p_pic, sout_stream_
         }
     }
 
-    if( p_sys->i_threads == 0 )
+    if( id->p_encoder_stage != NULL )
+    {
+        /* Waits if the encoder thread lags behind */
+        if( transcode_stage_Push( id->p_encoder_stage, p_pic ) )
+            picture_Release( p_pic );
+    }
+    else
     {
         block_t *p_block;
 
         p_block = id->p_encoder->pf_encode_video( id->p_encoder, p_pic );
         block_ChainAppend( out, p_block );
+        picture_Release( p_pic );
+    }
+}
+
+/* Runs the filter and output chains; first with the picture,
+ * and then with NULL as many times as we need until they
+ * stop outputting frames.
+ */
+static void transcode_video_filter( sout_stream_t *p_stream,
+                                    sout_stream_id_sys_t *id,
+                                    picture_t *p_pic, block_t **out )
+{
+    for ( ;; ) {
+        picture_t *p_filtered_pic = p_pic;
+
+        /* Run filter chain */
+        if( id->p_f_chain )
+            p_filtered_pic = filter_chain_VideoFilter( id->p_f_chain, p_filtered_pic );
+        if( !p_filtered_pic )
+            break;
+
+        for ( ;; ) {
+            picture_t *p_user_filtered_pic = p_filtered_pic;
+
+            /* Run user specified filter chain */
+            if( id->p_uf_chain )
+                p_user_filtered_pic = filter_chain_VideoFilter( id->p_uf_chain, p_user_filtered_pic );
+            if( !p_user_filtered_pic )
+                break;
+
+            OutputFrame( p_stream, p_user_filtered_pic, id, out );
+
+            p_filtered_pic = NULL;
+        }
+
+        p_pic = NULL;
+    }
+}
+
+static int FilterVideo( void *opaque, void *item )
+{
+    sout_stream_id_sys_t *id = opaque;
+    sout_stream_t *p_stream = (sout_stream_t *)id->p_decoder->p_owner;
+
+    transcode_video_filter( p_stream, id, item, NULL );
+    return VLC_SUCCESS;
+}
+
+/* Feeds a decoded picture to the filters and the encoder of a rendition */
+static int transcode_video_picture( sout_stream_t *p_stream,
+                                    sout_stream_id_sys_t *id,
+                                    picture_t *p_pic, block_t **out )
+{
+    if( unlikely (
+         id->p_encoder->p_module &&
+         !video_format_IsSimilar( &id->fmt_input_video, &id->p_decoder->fmt_out.video )
+        )
+      )
+    {
+        msg_Info( p_stream, "aspect-ratio changed, reiniting. %i -> %i : %i -> %i.",
+                    id->fmt_input_video.i_sar_num, id->p_decoder->fmt_out.video.i_sar_num,
+                    id->fmt_input_video.i_sar_den, id->p_decoder->fmt_out.video.i_sar_den
+                );
+        if( id->p_filter_stage != NULL )
+        {
+            /* The threads must be done with the previous pictures */
+            transcode_stage_Drain( id->p_filter_stage );
+            transcode_stage_Drain( id->p_encoder_stage );
+        }
+        /* Close filters */
+        if( id->p_f_chain )
+            filter_chain_Delete( id->p_f_chain );
+        id->p_f_chain = NULL;
+        if( id->p_uf_chain )
+            filter_chain_Delete( id->p_uf_chain );
+        id->p_uf_chain = NULL;
+
+        /* Reinitialize filters */
+        id->p_encoder->fmt_out.video.i_visible_width  = id->p_vcfg->i_width & ~1;
+        id->p_encoder->fmt_out.video.i_visible_height = id->p_vcfg->i_height & ~1;
+        id->p_encoder->fmt_out.video.i_sar_num = id->p_encoder->fmt_out.video.i_sar_den = 0;
+
+        transcode_video_encoder_init( p_stream, id );
+        transcode_video_filter_init( p_stream, id );
+        conversion_video_filter_append( id );
+        memcpy( &id->fmt_input_video, &id->p_decoder->fmt_out.video, sizeof(video_format_t));
     }
 
-    if( p_sys->i_threads )
+
+    if( unlikely( !id->p_encoder->p_module ) )
     {
-        vlc_sem_wait( &p_sys->picture_pool_has_room );
-        vlc_mutex_lock( &p_sys->lock_out );
-        picture_fifo_Push( p_sys->pp_pics, p_pic );
-        vlc_cond_signal( &p_sys->cond );
-        vlc_mutex_unlock( &p_sys->lock_out );
+        if( id->p_f_chain )
+            filter_chain_Delete( id->p_f_chain );
+        if( id->p_uf_chain )
+            filter_chain_Delete( id->p_uf_chain );
+        id->p_f_chain = id->p_uf_chain = NULL;
+
+        transcode_video_encoder_init( p_stream, id );
+        transcode_video_filter_init( p_stream, id );
+        conversion_video_filter_append( id );
+        memcpy( &id->fmt_input_video, &id->p_decoder->fmt_out.video, sizeof(video_format_t));
+
+        if( transcode_video_encoder_open( p_stream, id ) != VLC_SUCCESS )
+        {
+            picture_Release( p_pic );
+            transcode_video_close( p_stream, id );
+            id->b_transcode = false;
+            return VLC_EGENERIC;
+        }
     }
 
-    if ( p_sys->i_threads == 0 )
-        picture_Release( p_pic );
+    if( id->p_filter_stage != NULL )
+    {
+        /* Waits if the filters thread lags behind */
+        if( transcode_stage_Push( id->p_filter_stage, p_pic ) )
+            picture_Release( p_pic );
+    }
+    else
+        transcode_video_filter( p_stream, id, p_pic, out );
+    return VLC_SUCCESS;
+}
+
+/* Picks up the encoded blocks, after flushing the encoder if b_flush */
+static void transcode_video_output( sout_stream_t *p_stream,
+                                    sout_stream_id_sys_t *id,
+                                    bool b_flush, block_t **out )
+{
+    if( id->p_encoder_stage != NULL )
+    {
+        if( unlikely( b_flush ) )
+        {
+            msg_Dbg( p_stream, "Flushing threads and waiting that");
+            transcode_stage_Drain( id->p_filter_stage );
+            transcode_stage_Drain( id->p_encoder_stage );
+            msg_Dbg( p_stream, "Flushing done");
+        }
+        /* Pick up any return data the encoder thread wants to output. */
+        block_ChainAppend( out,
+                           transcode_stage_GetOutput( id->p_encoder_stage ) );
+    }
+
+    /* The threads, if any, are idle once drained */
+    if( unlikely( b_flush ) && id->p_encoder->p_module )
+    {
+        block_t *p_block;
+        do {
+            p_block = id->p_encoder->pf_encode_video(id->p_encoder, NULL );
+            block_ChainAppend( out, p_block );
+        } while( p_block );
+    }
 }
 
 int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
                                     block_t *in, block_t **out )
 {
-    sout_stream_sys_t *p_sys = p_stream->p_sys;
     *out = NULL;
     bool b_error = false;
 
@@ -763,146 +874,57 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
         return VLC_EGENERIC;
 
     picture_t *p_pics = transcode_dequeue_all_pics( id );
-    if( p_pics == NULL )
-        goto end;
 
-    do
+    while( p_pics != NULL )
     {
         picture_t *p_pic = p_pics;
         p_pics = p_pics->p_next;
         p_pic->p_next = NULL;
 
-        if( b_error )
-        {
-            picture_Release( p_pic );
-            continue;
-        }
-
-        if( unlikely (
-             id->p_encoder->p_module &&
-             !video_format_IsSimilar( &id->fmt_input_video, &id->p_decoder->fmt_out.video )
-            )
-          )
+        /* The extra renditions get their own pictures, as the filters
+         * change the dates and the links, but the same pixels */
+        for( int i = 0; i < id->i_rungs; i++ )
         {
-            msg_Info( p_stream, "aspect-ratio changed, reiniting. %i -> %i : %i -> %i.",
-                        id->fmt_input_video.i_sar_num, id->p_decoder->fmt_out.video.i_sar_num,
-                        id->fmt_input_video.i_sar_den, id->p_decoder->fmt_out.video.i_sar_den
-                    );
-            /* Close filters */
-            if( id->p_f_chain )
-                filter_chain_Delete( id->p_f_chain );
-            id->p_f_chain = NULL;
-            if( id->p_uf_chain )
-                filter_chain_Delete( id->p_uf_chain );
-            id->p_uf_chain = NULL;
-
-            /* Reinitialize filters */
-            id->p_encoder->fmt_out.video.i_visible_width  = p_sys->i_width & ~1;
-            id->p_encoder->fmt_out.video.i_visible_height = p_sys->i_height & ~1;
-            id->p_encoder->fmt_out.video.i_sar_num = id->p_encoder->fmt_out.video.i_sar_den = 0;
-
-            transcode_video_encoder_init( p_stream, id );
-            transcode_video_filter_init( p_stream, id );
-            conversion_video_filter_append( id );
-            memcpy( &id->fmt_input_video, &id->p_decoder->fmt_out.video, sizeof(video_format_t));
-        }
-
-
-        if( unlikely( !id->p_encoder->p_module ) )
-        {
-            if( id->p_f_chain )
-                filter_chain_Delete( id->p_f_chain );
-            if( id->p_uf_chain )
-                filter_chain_Delete( id->p_uf_chain );
-            id->p_f_chain = id->p_uf_chain = NULL;
+            sout_stream_id_sys_t *rung = id->pp_rungs[i];
+            block_t *p_out = NULL;
 
-            transcode_video_encoder_init( p_stream, id );
-            transcode_video_filter_init( p_stream, id );
-            conversion_video_filter_append( id );
-            memcpy( &id->fmt_input_video, &id->p_decoder->fmt_out.video, sizeof(video_format_t));
-
-            if( transcode_video_encoder_open( p_stream, id ) != VLC_SUCCESS )
-            {
-                picture_Release( p_pic );
-                transcode_video_close( p_stream, id );
-                id->b_transcode = false;
-                b_error = true;
+            if( !rung->b_transcode )
                 continue;
-            }
-        }
-
-        /* Run the filter and output chains; first with the picture,
-         * and then with NULL as many times as we need until they
-         * stop outputting frames.
-         */
-        for ( ;; ) {
-            picture_t *p_filtered_pic = p_pic;
-
-            /* Run filter chain */
-            if( id->p_f_chain )
-                p_filtered_pic = filter_chain_VideoFilter( id->p_f_chain, p_filtered_pic );
-            if( !p_filtered_pic )
-                break;
-
-            for ( ;; ) {
-                picture_t *p_user_filtered_pic = p_filtered_pic;
 
-                /* Run user specified filter chain */
-                if( id->p_uf_chain )
-                    p_user_filtered_pic = filter_chain_VideoFilter( id->p_uf_chain, p_user_filtered_pic );
-                if( !p_user_filtered_pic )
-                    break;
-
-                OutputFrame( p_stream, p_user_filtered_pic, id, out );
-
-                p_filtered_pic = NULL;
-            }
+            picture_t *p_clone = picture_Clone( p_pic );
+            if( unlikely(p_clone == NULL) )
+                continue;
+            picture_CopyProperties( p_clone, p_pic );
 
-            p_pic = NULL;
+            if( transcode_video_picture( p_stream, rung, p_clone, &p_out )
+                != VLC_SUCCESS )
+                msg_Err( p_stream, "dropping video rendition %d", i );
+            if( p_out != NULL )
+                sout_StreamIdSend( p_stream->p_next, rung->id, p_out );
         }
-    } while( p_pics );
 
-    if( p_sys->i_threads >= 1 )
-    {
-        /* Pick up any return data the encoder thread wants to output. */
-        vlc_mutex_lock( &p_sys->lock_out );
-        *out = p_sys->p_buffers;
-        p_sys->p_buffers = NULL;
-        vlc_mutex_unlock( &p_sys->lock_out );
+        if( b_error )
+            picture_Release( p_pic );
+        else if( transcode_video_picture( p_stream, id, p_pic, out )
+                 != VLC_SUCCESS )
+            b_error = true;
     }
 
-end:
-    if( unlikely( in == NULL ) )
+    for( int i = 0; i < id->i_rungs; i++ )
     {
-        if( p_sys->i_threads == 0 )
-        {
-            if( id->p_encoder->p_module )
-            {
-                block_t *p_block;
-                do {
-                    p_block = id->p_encoder->pf_encode_video(id->p_encoder, NULL );
-                    block_ChainAppend( out, p_block );
-                } while( p_block );
-            }
-        }
-        else
-        {
-            msg_Dbg( p_stream, "Flushing thread and waiting that");
-            vlc_mutex_lock( &p_stream->p_sys->lock_out );
-            p_stream->p_sys->b_abort = true;
-            vlc_cond_signal( &p_stream->p_sys->cond );
-            vlc_mutex_unlock( &p_stream->p_sys->lock_out );
-
-            vlc_join( p_stream->p_sys->thread, NULL );
-            vlc_mutex_lock( &p_sys->lock_out );
-            *out = p_sys->p_buffers;
-            p_sys->p_buffers = NULL;
-            vlc_mutex_unlock( &p_sys->lock_out );
+        sout_stream_id_sys_t *rung = id->pp_rungs[i];
+        block_t *p_out = NULL;
 
-            msg_Dbg( p_stream, "Flushing done");
-        }
+        if( !rung->b_transcode )
+            continue;
+        transcode_video_output( p_stream, rung, in == NULL, &p_out );
+        if( p_out != NULL )
+            sout_StreamIdSend( p_stream->p_next, rung->id, p_out );
     }
 
+    if( !b_error )
+        transcode_video_output( p_stream, id, in == NULL, out );
+
     return b_error ? VLC_EGENERIC : VLC_SUCCESS;
 }
 
@@ -913,16 +935,16 @@ bool transcode_video_add( sout_stream_t *p_stream, const es_format_t *p_fmt,
 
     msg_Dbg( p_stream,
              "creating video transcoding from fcc=`%4.4s' to fcc=`%4.4s'",
-             (char*)&p_fmt->i_codec, (char*)&p_sys->i_vcodec );
+             (char*)&p_fmt->i_codec, (char*)&id->p_vcfg->i_vcodec );
 
     id->fifo.audio.first = NULL;
     id->fifo.audio.last = &id->fifo.audio.first;
 
     /* Complete destination format */
-    id->p_encoder->fmt_out.i_codec = p_sys->i_vcodec;
-    id->p_encoder->fmt_out.video.i_visible_width  = p_sys->i_width & ~1;
-    id->p_encoder->fmt_out.video.i_visible_height = p_sys->i_height & ~1;
-    id->p_encoder->fmt_out.i_bitrate = p_sys->i_vbitrate;
+    id->p_encoder->fmt_out.i_codec = id->p_vcfg->i_vcodec;
+    id->p_encoder->fmt_out.video.i_visible_width  = id->p_vcfg->i_width & ~1;
+    id->p_encoder->fmt_out.video.i_visible_height = id->p_vcfg->i_height & ~1;
+    id->p_encoder->fmt_out.i_bitrate = id->p_vcfg->i_vbitrate;
 
     /* Build decoder -> filter -> encoder chain */
     if( transcode_video_new( p_stream, id ) )
@@ -73,6 +73,7 @@ typedef uint32_t uni_char_t;
  * It describes the freetype specific properties of an output thread.
  *****************************************************************************/
 typedef struct vlc_family_t vlc_family_t;
+typedef struct vlc_glyph_cache_t vlc_glyph_cache_t;
 struct filter_sys_t
 {
     FT_Library     p_library;       /* handle to library     */
@@ -111,6 +112,9 @@ struct filter_sys_t
     /** Font face cache */
     vlc_dictionary_t  face_map;
 
+    /** Loaded glyphs, bitmaps and shaped runs cache, NULL if disabled */
+    vlc_glyph_cache_t *p_glyph_cache;
+
     int               i_fallback_counter;
 
     /* Current scaling of the text, default is 100 (%) */
@@ -0,0 +1,550 @@
+/*****************************************************************************
+ * glyph_cache.c : Glyph and shaped runs cache for the freetype renderer
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/** \ingroup glyph_cache
+ * @{
+ * \file
+ * Glyph cache implementation
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+
+#include <vlc_common.h>
+
+#if defined(HAVE_HARFBUZZ)
+# include <hb.h>
+#endif
+
+#include "freetype.h"
+#include "glyph_cache.h"
+
+enum
+{
+    CACHE_OUTLINE,
+    CACHE_BITMAP,
+    CACHE_RUN,
+    CACHE_KINDS
+};
+
+static const char *const ppsz_kind_names[CACHE_KINDS] =
+    { "outlines", "bitmaps", "runs" };
+
+typedef struct cache_entry_t cache_entry_t;
+struct cache_entry_t
+{
+    cache_entry_t *p_hash_next;
+    cache_entry_t *p_lru_prev;                     /**< More recently used */
+    cache_entry_t *p_lru_next;                     /**< Less recently used */
+    uint32_t       i_hash;
+    int            i_kind;
+    size_t         i_bytes;
+
+    union
+    {
+        struct
+        {
+            FT_Glyph  p_glyph;
+            FT_Glyph  p_outline;
+            FT_Vector advance;
+        } outline;
+        FT_Glyph p_bitmap;
+        struct
+        {
+            unsigned i_count;
+            void    *p_data;              /**< Glyph infos then positions */
+        } run;
+    } u;
+
+    size_t         i_key_size;
+    uint8_t        p_key[];
+};
+
+struct vlc_glyph_cache_t
+{
+    cache_entry_t **pp_buckets;
+    uint32_t        i_buckets_mask;
+
+    cache_entry_t  *p_lru_first;
+    cache_entry_t  *p_lru_last;
+    size_t          i_bytes;
+    size_t          i_max_bytes;
+
+    uint64_t        pi_hits[CACHE_KINDS];
+    uint64_t        pi_misses[CACHE_KINDS];
+    uint64_t        i_evictions;
+};
+
+/** Key of a bitmap, rendered with the fractional part of an origin */
+typedef struct
+{
+    glyph_cache_key_t glyph;
+    int               b_border;
+    FT_Pos            i_x;
+    FT_Pos            i_y;
+} bitmap_key_t;
+
+#ifdef HAVE_HARFBUZZ
+/** Key of a shaped run, followed by its code points */
+typedef struct
+{
+    FT_Face        p_face;
+    FT_Fixed       i_x_scale;
+    FT_Fixed       i_y_scale;
+    hb_script_t    script;
+    hb_direction_t direction;
+} run_key_t;
+#endif
+
+/* FNV-1a */
+static uint32_t Hash( uint32_t i_hash, const void *p_data, size_t i_size )
+{
+    const uint8_t *p = p_data;
+
+    for( size_t i = 0; i < i_size; i++ )
+    {
+        i_hash ^= p[i];
+        i_hash *= 16777619;
+    }
+    return i_hash;
+}
+
+static size_t GlyphBytes( FT_Glyph p_glyph )
+{
+    if( !p_glyph )
+        return 0;
+
+    if( p_glyph->format == FT_GLYPH_FORMAT_OUTLINE )
+    {
+        const FT_Outline *p_outline = &((FT_OutlineGlyph)p_glyph)->outline;
+        return sizeof( FT_OutlineGlyphRec )
+             + p_outline->n_points * ( sizeof( FT_Vector ) + 1 )
+             + p_outline->n_contours * sizeof( short );
+    }
+    if( p_glyph->format == FT_GLYPH_FORMAT_BITMAP )
+    {
+        const FT_Bitmap *p_bitmap = &((FT_BitmapGlyph)p_glyph)->bitmap;
+        return sizeof( FT_BitmapGlyphRec )
+             + p_bitmap->rows * (size_t)abs( p_bitmap->pitch );
+    }
+    return sizeof( FT_GlyphRec );
+}
+
+vlc_glyph_cache_t *GlyphCache_New( size_t i_max_bytes )
+{
+    vlc_glyph_cache_t *p_cache = calloc( 1, sizeof( *p_cache ) );
+    if( !p_cache )
+        return NULL;
+
+    /* About one bucket per average sized bitmap */
+    uint32_t i_buckets = 64;
+    while( i_buckets < 65536 && i_buckets * 512 < i_max_bytes )
+        i_buckets *= 2;
+
+    p_cache->pp_buckets = calloc( i_buckets, sizeof( *p_cache->pp_buckets ) );
+    if( !p_cache->pp_buckets )
+    {
+        free( p_cache );
+        return NULL;
+    }
+    p_cache->i_buckets_mask = i_buckets - 1;
+    p_cache->i_max_bytes = i_max_bytes;
+
+    return p_cache;
+}
+
+static void EntryDelete( cache_entry_t *p_entry )
+{
+    switch( p_entry->i_kind )
+    {
+        case CACHE_OUTLINE:
+            FT_Done_Glyph( p_entry->u.outline.p_glyph );
+            if( p_entry->u.outline.p_outline )
+                FT_Done_Glyph( p_entry->u.outline.p_outline );
+            break;
+        case CACHE_BITMAP:
+            FT_Done_Glyph( p_entry->u.p_bitmap );
+            break;
+        case CACHE_RUN:
+            free( p_entry->u.run.p_data );
+            break;
+    }
+    free( p_entry );
+}
+
+void GlyphCache_Delete( vlc_object_t *p_obj, vlc_glyph_cache_t *p_cache )
+{
+    for( int i = 0; i < CACHE_KINDS; i++ )
+    {
+        if( p_cache->pi_hits[i] + p_cache->pi_misses[i] == 0 )
+            continue;
+        msg_Dbg( p_obj, "glyph cache %s: %"PRIu64" hits, %"PRIu64" misses",
+                 ppsz_kind_names[i], p_cache->pi_hits[i],
+                 p_cache->pi_misses[i] );
+    }
+    if( p_cache->i_evictions )
+        msg_Dbg( p_obj, "glyph cache: %"PRIu64" evictions, %zu/%zu bytes used",
+                 p_cache->i_evictions, p_cache->i_bytes,
+                 p_cache->i_max_bytes );
+
+    for( cache_entry_t *p_entry = p_cache->p_lru_first; p_entry; )
+    {
+        cache_entry_t *p_next = p_entry->p_lru_next;
+        EntryDelete( p_entry );
+        p_entry = p_next;
+    }
+    free( p_cache->pp_buckets );
+    free( p_cache );
+}
+
+static void LruRemove( vlc_glyph_cache_t *p_cache, cache_entry_t *p_entry )
+{
+    if( p_entry->p_lru_prev )
+        p_entry->p_lru_prev->p_lru_next = p_entry->p_lru_next;
+    else
+        p_cache->p_lru_first = p_entry->p_lru_next;
+    if( p_entry->p_lru_next )
+        p_entry->p_lru_next->p_lru_prev = p_entry->p_lru_prev;
+    else
+        p_cache->p_lru_last = p_entry->p_lru_prev;
+}
+
+static void LruPushFront( vlc_glyph_cache_t *p_cache, cache_entry_t *p_entry )
+{
+    p_entry->p_lru_prev = NULL;
+    p_entry->p_lru_next = p_cache->p_lru_first;
+    if( p_cache->p_lru_first )
+        p_cache->p_lru_first->p_lru_prev = p_entry;
+    else
+        p_cache->p_lru_last = p_entry;
+    p_cache->p_lru_first = p_entry;
+}
+
+static void Evict( vlc_glyph_cache_t *p_cache )
+{
+    cache_entry_t *p_entry = p_cache->p_lru_last;
+    assert( p_entry );
+
+    cache_entry_t **pp = &p_cache->pp_buckets[p_entry->i_hash
+                                              & p_cache->i_buckets_mask];
+    while( *pp != p_entry )
+        pp = &(*pp)->p_hash_next;
+    *pp = p_entry->p_hash_next;
+
+    LruRemove( p_cache, p_entry );
+    p_cache->i_bytes -= p_entry->i_bytes;
+    p_cache->i_evictions++;
+    EntryDelete( p_entry );
+}
+
+/**
+ * Finds the entry of a key made of a fixed size header and of an optional
+ * variable size tail, and marks it as the most recently used.
+ */
+static cache_entry_t *Find( vlc_glyph_cache_t *p_cache, int i_kind,
+                            const void *p_key, size_t i_key_size,
+                            const void *p_tail, size_t i_tail_size,
+                            uint32_t *pi_hash )
+{
+    uint32_t i_hash = Hash( 2166136261u + i_kind, p_key, i_key_size );
+    i_hash = Hash( i_hash, p_tail, i_tail_size );
+    *pi_hash = i_hash;
+
+    for( cache_entry_t *p_entry = p_cache->pp_buckets[i_hash
+                                                      & p_cache->i_buckets_mask];
+         p_entry; p_entry = p_entry->p_hash_next )
+    {
+        if( p_entry->i_hash != i_hash || p_entry->i_kind != i_kind
+         || p_entry->i_key_size != i_key_size + i_tail_size
+         || memcmp( p_entry->p_key, p_key, i_key_size )
+         || ( i_tail_size
+           && memcmp( p_entry->p_key + i_key_size, p_tail, i_tail_size ) ) )
+            continue;
+
+        LruRemove( p_cache, p_entry );
+        LruPushFront( p_cache, p_entry );
+        return p_entry;
+    }
+    return NULL;
+}
+
+static cache_entry_t *Lookup( vlc_glyph_cache_t *p_cache, int i_kind,
+                              const void *p_key, size_t i_key_size,
+                              const void *p_tail, size_t i_tail_size )
+{
+    uint32_t i_hash;
+    cache_entry_t *p_entry = Find( p_cache, i_kind, p_key, i_key_size,
+                                   p_tail, i_tail_size, &i_hash );
+    if( p_entry )
+        p_cache->pi_hits[i_kind]++;
+    else
+        p_cache->pi_misses[i_kind]++;
+    return p_entry;
+}
+
+/**
+ * Allocates an entry, not yet inserted, or returns NULL if the key is
+ * already cached.
+ */
+static cache_entry_t *EntryNew( vlc_glyph_cache_t *p_cache, int i_kind,
+                                const void *p_key, size_t i_key_size,
+                                const void *p_tail, size_t i_tail_size )
+{
+    uint32_t i_hash;
+    if( Find( p_cache, i_kind, p_key, i_key_size, p_tail, i_tail_size,
+              &i_hash ) )
+        return NULL;
+
+    cache_entry_t *p_entry = malloc( sizeof( *p_entry ) + i_key_size
+                                     + i_tail_size );
+    if( !p_entry )
+        return NULL;
+
+    p_entry->i_hash = i_hash;
+    p_entry->i_kind = i_kind;
+    p_entry->i_key_size = i_key_size + i_tail_size;
+    memcpy( p_entry->p_key, p_key, i_key_size );
+    if( i_tail_size )
+        memcpy( p_entry->p_key + i_key_size, p_tail, i_tail_size );
+    return p_entry;
+}
+
+/**
+ * Inserts an entry, which value takes \p i_bytes, or deletes it if it
+ * does not fit.
+ */
+static void Insert( vlc_glyph_cache_t *p_cache, cache_entry_t *p_entry,
+                    size_t i_bytes )
+{
+    p_entry->i_bytes = sizeof( *p_entry ) + p_entry->i_key_size + i_bytes;
+    if( p_entry->i_bytes > p_cache->i_max_bytes )
+    {
+        EntryDelete( p_entry );
+        return;
+    }
+
+    while( p_cache->i_bytes + p_entry->i_bytes > p_cache->i_max_bytes )
+        Evict( p_cache );
+
+    cache_entry_t **pp_bucket = &p_cache->pp_buckets[p_entry->i_hash
+                                                     & p_cache->i_buckets_mask];
+    p_entry->p_hash_next = *pp_bucket;
+    *pp_bucket = p_entry;
+    LruPushFront( p_cache, p_entry );
+    p_cache->i_bytes += p_entry->i_bytes;
+}
+
+int GlyphCache_GetOutline( vlc_glyph_cache_t *p_cache,
+                           const glyph_cache_key_t *p_key,
+                           FT_Glyph *pp_glyph, FT_Glyph *pp_outline,
+                           FT_Vector *p_advance )
+{
+    cache_entry_t *p_entry = Lookup( p_cache, CACHE_OUTLINE,
+                                     p_key, sizeof( *p_key ), NULL, 0 );
+    if( !p_entry )
+        return VLC_EGENERIC;
+
+    if( FT_Glyph_Copy( p_entry->u.outline.p_glyph, pp_glyph ) )
+        return VLC_EGENERIC;
+
+    *pp_outline = NULL;
+    if( p_entry->u.outline.p_outline
+     && FT_Glyph_Copy( p_entry->u.outline.p_outline, pp_outline ) )
+    {
+        FT_Done_Glyph( *pp_glyph );
+        *pp_glyph = NULL;
+        return VLC_EGENERIC;
+    }
+
+    *p_advance = p_entry->u.outline.advance;
+    return VLC_SUCCESS;
+}
+
+void GlyphCache_PutOutline( vlc_glyph_cache_t *p_cache,
+                            const glyph_cache_key_t *p_key,
+                            FT_Glyph p_glyph, FT_Glyph p_outline,
+                            const FT_Vector *p_advance )
+{
+    cache_entry_t *p_entry = EntryNew( p_cache, CACHE_OUTLINE,
+                                       p_key, sizeof( *p_key ), NULL, 0 );
+    if( !p_entry )
+        return;
+
+    p_entry->u.outline.p_outline = NULL;
+    if( FT_Glyph_Copy( p_glyph, &p_entry->u.outline.p_glyph ) )
+    {
+        free( p_entry );
+        return;
+    }
+    if( p_outline
+     && FT_Glyph_Copy( p_outline, &p_entry->u.outline.p_outline ) )
+    {
+        FT_Done_Glyph( p_entry->u.outline.p_glyph );
+        free( p_entry );
+        return;
+    }
+    p_entry->u.outline.advance = *p_advance;
+
+    Insert( p_cache, p_entry, GlyphBytes( p_glyph ) + GlyphBytes( p_outline ) );
+}
+
+FT_Error GlyphCache_ToBitmap( vlc_glyph_cache_t *p_cache,
+                              const glyph_cache_key_t *p_key, bool b_border,
+                              FT_Glyph *pp_glyph, const FT_Vector *p_origin,
+                              FT_Bool b_destroy )
+{
+    FT_Vector origin = *p_origin;
+
+    /* Bitmap glyphs are not moved by the origin */
+    if( !p_cache || !p_key->p_face
+     || (*pp_glyph)->format != FT_GLYPH_FORMAT_OUTLINE )
+        return FT_Glyph_To_Bitmap( pp_glyph, FT_RENDER_MODE_NORMAL,
+                                   &origin, b_destroy );
+
+    /* Moving the origin by whole pixels only moves the bitmap */
+    bitmap_key_t key;
+    memset( &key, 0, sizeof( key ) );
+    key.glyph = *p_key;
+    key.b_border = b_border;
+    key.i_x = origin.x & 63;
+    key.i_y = origin.y & 63;
+
+    const FT_Int i_x = ( origin.x - key.i_x ) / 64;
+    const FT_Int i_y = ( origin.y - key.i_y ) / 64;
+
+    FT_Glyph p_bitmap;
+    cache_entry_t *p_entry = Lookup( p_cache, CACHE_BITMAP,
+                                     &key, sizeof( key ), NULL, 0 );
+    if( p_entry )
+    {
+        FT_Error i_error = FT_Glyph_Copy( p_entry->u.p_bitmap, &p_bitmap );
+        if( i_error )
+            return i_error;
+    }
+    else
+    {
+        FT_Vector subpixel = { .x = key.i_x, .y = key.i_y };
+
+        p_bitmap = *pp_glyph;
+        FT_Error i_error = FT_Glyph_To_Bitmap( &p_bitmap, FT_RENDER_MODE_NORMAL,
+                                               &subpixel, 0 );
+        if( i_error )
+            return i_error;
+
+        p_entry = EntryNew( p_cache, CACHE_BITMAP, &key, sizeof( key ),
+                            NULL, 0 );
+        if( p_entry )
+        {
+            if( FT_Glyph_Copy( p_bitmap, &p_entry->u.p_bitmap ) )
+                free( p_entry );
+            else
+                Insert( p_cache, p_entry, GlyphBytes( p_bitmap ) );
+        }
+    }
+
+    /* Empty bitmaps are not positioned */
+    FT_BitmapGlyph p_bitmap_glyph = (FT_BitmapGlyph)p_bitmap;
+    if( p_bitmap_glyph->bitmap.rows && p_bitmap_glyph->bitmap.width )
+    {
+        p_bitmap_glyph->left += i_x;
+        p_bitmap_glyph->top  += i_y;
+    }
+
+    if( b_destroy )
+        FT_Done_Glyph( *pp_glyph );
+    *pp_glyph = p_bitmap;
+    return 0;
+}
+
+#ifdef HAVE_HARFBUZZ
+static void RunKeyInit( run_key_t *p_key, FT_Face p_face,
+                        hb_script_t script, hb_direction_t direction )
+{
+    memset( p_key, 0, sizeof( *p_key ) );
+    p_key->p_face = p_face;
+    p_key->i_x_scale = p_face->size->metrics.x_scale;
+    p_key->i_y_scale = p_face->size->metrics.y_scale;
+    p_key->script = script;
+    p_key->direction = direction;
+}
+
+unsigned GlyphCache_GetRun( vlc_glyph_cache_t *p_cache, FT_Face p_face,
+                            hb_script_t script, hb_direction_t direction,
+                            const uni_char_t *p_text, size_t i_length,
+                            hb_glyph_info_t **pp_infos,
+                            hb_glyph_position_t **pp_positions )
+{
+    run_key_t key;
+    RunKeyInit( &key, p_face, script, direction );
+
+    cache_entry_t *p_entry = Lookup( p_cache, CACHE_RUN, &key, sizeof( key ),
+                                     p_text, i_length * sizeof( *p_text ) );
+    if( !p_entry )
+        return 0;
+
+    const unsigned i_count = p_entry->u.run.i_count;
+    const size_t i_size = i_count * ( sizeof( **pp_infos )
+                                    + sizeof( **pp_positions ) );
+    hb_glyph_info_t *p_infos = malloc( i_size );
+    if( !p_infos )
+        return 0;
+    memcpy( p_infos, p_entry->u.run.p_data, i_size );
+
+    *pp_infos = p_infos;
+    *pp_positions = (hb_glyph_position_t *)( p_infos + i_count );
+    return i_count;
+}
+
+void GlyphCache_PutRun( vlc_glyph_cache_t *p_cache, FT_Face p_face,
+                        hb_script_t script, hb_direction_t direction,
+                        const uni_char_t *p_text, size_t i_length,
+                        const hb_glyph_info_t *p_infos,
+                        const hb_glyph_position_t *p_positions,
+                        unsigned i_count )
+{
+    run_key_t key;
+    RunKeyInit( &key, p_face, script, direction );
+
+    cache_entry_t *p_entry = EntryNew( p_cache, CACHE_RUN, &key, sizeof( key ),
+                                       p_text, i_length * sizeof( *p_text ) );
+    if( !p_entry )
+        return;
+
+    const size_t i_infos_size = i_count * sizeof( *p_infos );
+    const size_t i_positions_size = i_count * sizeof( *p_positions );
+    uint8_t *p_data = malloc( i_infos_size + i_positions_size );
+    if( !p_data )
+    {
+        free( p_entry );
+        return;
+    }
+    memcpy( p_data, p_infos, i_infos_size );
+    memcpy( p_data + i_infos_size, p_positions, i_positions_size );
+
+    p_entry->u.run.i_count = i_count;
+    p_entry->u.run.p_data = p_data;
+    Insert( p_cache, p_entry, i_infos_size + i_positions_size );
+}
+#endif
+
+/** @} */
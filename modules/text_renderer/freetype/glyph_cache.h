@@ -0,0 +1,123 @@
+/*****************************************************************************
+ * glyph_cache.h : Glyph and shaped runs cache for the freetype renderer
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_FREETYPE_GLYPH_CACHE_H
+#define VLC_FREETYPE_GLYPH_CACHE_H
+
+/** \defgroup glyph_cache Glyph cache
+ * \ingroup freetype
+ * Least recently used cache of the loaded and rendered glyphs, and of the
+ * shaped runs, bounded in memory.
+ * @{
+ * \file
+ * Glyph cache interface
+ */
+
+/**
+ * Identifies a loaded glyph. Must be zero initialized, as it is
+ * compared and hashed as a whole, padding included.
+ */
+typedef struct
+{
+    FT_Face  p_face;                 /**< NULL if the glyph is not cached */
+    FT_Fixed i_x_scale;              /**< Face size */
+    FT_Fixed i_y_scale;
+    FT_UInt  i_glyph_index;
+    int      i_flags;                /**< Synthetic styles, GLYPH_CACHE_* */
+    FT_Fixed i_outline_radius;       /**< Stroker radius, 0 for no outline */
+} glyph_cache_key_t;
+
+#define GLYPH_CACHE_BOLD   0x1
+#define GLYPH_CACHE_ITALIC 0x2
+
+/**
+ * Creates a cache using at most \p i_max_bytes of glyph data.
+ */
+vlc_glyph_cache_t *GlyphCache_New( size_t i_max_bytes );
+
+/**
+ * Deletes a cache, and logs its statistics.
+ */
+void GlyphCache_Delete( vlc_object_t *p_obj, vlc_glyph_cache_t *p_cache );
+
+/**
+ * Gets copies of a loaded glyph and of its stroked border.
+ *
+ * \param pp_glyph receives the glyph
+ * \param pp_outline receives the border, NULL if there is none
+ * \param p_advance receives the advance of the glyph
+ * \return VLC_SUCCESS, or VLC_EGENERIC if the glyph is not cached
+ */
+int GlyphCache_GetOutline( vlc_glyph_cache_t *p_cache,
+                           const glyph_cache_key_t *p_key,
+                           FT_Glyph *pp_glyph, FT_Glyph *pp_outline,
+                           FT_Vector *p_advance );
+
+/**
+ * Keeps copies of a loaded glyph and of its stroked border.
+ */
+void GlyphCache_PutOutline( vlc_glyph_cache_t *p_cache,
+                            const glyph_cache_key_t *p_key,
+                            FT_Glyph p_glyph, FT_Glyph p_outline,
+                            const FT_Vector *p_advance );
+
+/**
+ * Replaces a loaded glyph by its bitmap, the same as FT_Glyph_To_Bitmap()
+ * does with the FT_RENDER_MODE_NORMAL mode.
+ *
+ * Bitmaps are cached per sub-pixel position of the origin, so that a
+ * cached bitmap is the exact result of the rendering.
+ *
+ * \param b_border true if \p pp_glyph is the stroked border of the key glyph
+ */
+FT_Error GlyphCache_ToBitmap( vlc_glyph_cache_t *p_cache,
+                              const glyph_cache_key_t *p_key, bool b_border,
+                              FT_Glyph *pp_glyph, const FT_Vector *p_origin,
+                              FT_Bool b_destroy );
+
+#ifdef HAVE_HARFBUZZ
+/**
+ * Gets the result of the shaping of a run.
+ *
+ * \param pp_infos receives the glyph infos, to be freed by the caller
+ * \param pp_positions receives the glyph positions, within the same
+ *                     allocation as the infos
+ * \return the number of glyphs, or 0 if the run is not cached
+ */
+unsigned GlyphCache_GetRun( vlc_glyph_cache_t *p_cache, FT_Face p_face,
+                            hb_script_t script, hb_direction_t direction,
+                            const uni_char_t *p_text, size_t i_length,
+                            hb_glyph_info_t **pp_infos,
+                            hb_glyph_position_t **pp_positions );
+
+/**
+ * Keeps the result of the shaping of a run.
+ */
+void GlyphCache_PutRun( vlc_glyph_cache_t *p_cache, FT_Face p_face,
+                        hb_script_t script, hb_direction_t direction,
+                        const uni_char_t *p_text, size_t i_length,
+                        const hb_glyph_info_t *p_infos,
+                        const hb_glyph_position_t *p_positions,
+                        unsigned i_count );
+#endif
+
+/** @} */
+
+#endif
@@ -65,6 +65,7 @@
 #include "freetype.h"
 #include "text_layout.h"
 #include "platform_fonts.h"
+#include "glyph_cache.h"
 
 /* Win32 */
 #ifdef _WIN32
@@ -111,6 +112,7 @@ typedef struct run_desc_t
     hb_glyph_info_t            *p_glyph_infos;
     hb_glyph_position_t        *p_glyph_positions;
     unsigned int                i_glyph_count;
+    void                       *p_cached_glyphs; /**< Shaping from the cache */
 #endif
 
 } run_desc_t;
@@ -130,6 +132,7 @@ typedef struct glyph_bitmaps_t
     int      i_y_offset;
     int      i_x_advance;
     int      i_y_advance;
+    glyph_cache_key_t cache_key;
 } glyph_bitmaps_t;
 
 typedef struct paragraph_t
@@ -684,6 +687,23 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
         else
             p_face = p_run->p_face;
 
+        if( p_sys->p_glyph_cache )
+        {
+            p_run->i_glyph_count =
+                GlyphCache_GetRun( p_sys->p_glyph_cache, p_face,
+                                   p_run->script, p_run->direction,
+                                   p_paragraph->p_code_points + p_run->i_start_offset,
+                                   p_run->i_end_offset - p_run->i_start_offset,
+                                   &p_run->p_glyph_infos,
+                                   &p_run->p_glyph_positions );
+            if( p_run->i_glyph_count > 0 )
+            {
+                p_run->p_cached_glyphs = p_run->p_glyph_infos;
+                i_total_glyphs += p_run->i_glyph_count;
+                continue;
+            }
+        }
+
         p_run->p_hb_font = hb_ft_font_create( p_face, 0 );
         if( !p_run->p_hb_font )
         {
@@ -726,6 +746,14 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
             goto error;
         }
 
+        if( p_sys->p_glyph_cache )
+            GlyphCache_PutRun( p_sys->p_glyph_cache, p_face,
+                               p_run->script, p_run->direction,
+                               p_paragraph->p_code_points + p_run->i_start_offset,
+                               p_run->i_end_offset - p_run->i_start_offset,
+                               p_run->p_glyph_infos, p_run->p_glyph_positions,
+                               p_run->i_glyph_count );
+
         i_total_glyphs += p_run->i_glyph_count;
     }
 
@@ -789,8 +817,11 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
 
     for( int i = 0; i < p_paragraph->i_runs_count; ++i )
     {
-        hb_font_destroy( p_paragraph->p_runs[ i ].p_hb_font );
-        hb_buffer_destroy( p_paragraph->p_runs[ i ].p_buffer );
+        if( p_paragraph->p_runs[ i ].p_hb_font )
+            hb_font_destroy( p_paragraph->p_runs[ i ].p_hb_font );
+        if( p_paragraph->p_runs[ i ].p_buffer )
+            hb_buffer_destroy( p_paragraph->p_runs[ i ].p_buffer );
+        free( p_paragraph->p_runs[ i ].p_cached_glyphs );
     }
     FreeParagraph( *p_old_paragraph );
     *p_old_paragraph = p_new_paragraph;
@@ -804,6 +835,8 @@ error:
             hb_font_destroy( p_paragraph->p_runs[ i ].p_hb_font );
         if( p_paragraph->p_runs[ i ].p_buffer )
             hb_buffer_destroy( p_paragraph->p_runs[ i ].p_buffer );
+        free( p_paragraph->p_runs[ i ].p_cached_glyphs );
+        p_paragraph->p_runs[ i ].p_cached_glyphs = NULL;
     }
 
     if( p_new_paragraph )
@@ -944,18 +977,38 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
         else
             p_face = p_run->p_face;
 
+        int i_radius = 0;
         if( p_sys->p_stroker && (p_style->i_style_flags & STYLE_OUTLINE) )
         {
             double f_outline_thickness =
                 var_InheritInteger( p_filter, "freetype-outline-thickness" ) / 100.0;
             f_outline_thickness = VLC_CLIP( f_outline_thickness, 0.0, 0.5 );
-            int i_radius = ( i_live_size << 6 ) * f_outline_thickness;
+            i_radius = ( i_live_size << 6 ) * f_outline_thickness;
             FT_Stroker_Set( p_sys->p_stroker,
                             i_radius,
                             FT_STROKER_LINECAP_ROUND,
                             FT_STROKER_LINEJOIN_ROUND, 0 );
         }
 
+        /* Glyphs of the run are looked up in the cache, whatever their
+         * position, as long as the face size and styles are the same */
+        glyph_cache_key_t cache_key;
+        memset( &cache_key, 0, sizeof( cache_key ) );
+        if( p_sys->p_glyph_cache )
+        {
+            cache_key.p_face = p_face;
+            cache_key.i_x_scale = p_face->size->metrics.x_scale;
+            cache_key.i_y_scale = p_face->size->metrics.y_scale;
+            if( ( p_style->i_style_flags & STYLE_BOLD )
+                  && !( p_face->style_flags & FT_STYLE_FLAG_BOLD ) )
+                cache_key.i_flags |= GLYPH_CACHE_BOLD;
+            if( ( p_style->i_style_flags & STYLE_ITALIC )
+                  && !( p_face->style_flags & FT_STYLE_FLAG_ITALIC ) )
+                cache_key.i_flags |= GLYPH_CACHE_ITALIC;
+            if( p_sys->p_stroker && (p_style->i_style_flags & STYLE_OUTLINE) )
+                cache_key.i_outline_radius = i_radius;
+        }
+
         for( int j = p_run->i_start_offset; j < p_run->i_end_offset; ++j )
         {
             int i_glyph_index;
@@ -969,6 +1022,7 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
 
 #define SKIP_GLYPH( p_bitmaps ) \
     { \
+        p_bitmaps->cache_key.p_face = NULL; \
         p_bitmaps->p_glyph = 0; \
         p_bitmaps->p_outline = 0; \
         p_bitmaps->p_shadow = 0; \
@@ -1006,6 +1060,27 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
                     SKIP_GLYPH( p_bitmaps )
             }
 
+            p_bitmaps->cache_key = cache_key;
+            p_bitmaps->cache_key.i_glyph_index = i_glyph_index;
+
+            FT_Vector advance;
+            if( cache_key.p_face
+             && !GlyphCache_GetOutline( p_sys->p_glyph_cache,
+                                        &p_bitmaps->cache_key,
+                                        &p_bitmaps->p_glyph,
+                                        &p_bitmaps->p_outline, &advance ) )
+            {
+                if( p_style->i_shadow_alpha != STYLE_ALPHA_TRANSPARENT )
+                    p_bitmaps->p_shadow = p_bitmaps->p_outline ?
+                                          p_bitmaps->p_outline : p_bitmaps->p_glyph;
+                if( b_overwrite_advance )
+                {
+                    p_bitmaps->i_x_advance = advance.x;
+                    p_bitmaps->i_y_advance = advance.y;
+                }
+                continue;
+            }
+
             if( FT_Load_Glyph( p_face, i_glyph_index,
                                FT_LOAD_NO_BITMAP | FT_LOAD_DEFAULT )
              && FT_Load_Glyph( p_face, i_glyph_index, FT_LOAD_DEFAULT ) )
@@ -1040,6 +1115,12 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
                 p_bitmaps->i_x_advance = p_face->glyph->advance.x;
                 p_bitmaps->i_y_advance = p_face->glyph->advance.y;
             }
+
+            if( cache_key.p_face )
+                GlyphCache_PutOutline( p_sys->p_glyph_cache,
+                                       &p_bitmaps->cache_key,
+                                       p_bitmaps->p_glyph, p_bitmaps->p_outline,
+                                       &p_face->glyph->advance );
         }
 
         int i_max_run_advance_x = FT_FLOOR( FT_MulFix( p_face->max_advance_width, p_face->size->metrics.x_scale ) );
@@ -1142,8 +1223,9 @@ static int LayoutLine( filter_t *p_filter,
 
         if( p_bitmaps->p_shadow )
         {
-            if( FT_Glyph_To_Bitmap( &p_bitmaps->p_shadow, FT_RENDER_MODE_NORMAL,
-                                    &pen_shadow, 0 ) )
+            if( GlyphCache_ToBitmap( p_sys->p_glyph_cache, &p_bitmaps->cache_key,
+                                     p_bitmaps->p_shadow == p_bitmaps->p_outline,
+                                     &p_bitmaps->p_shadow, &pen_shadow, 0 ) )
                 p_bitmaps->p_shadow = 0;
             else
                 FT_Glyph_Get_CBox( p_bitmaps->p_shadow, ft_glyph_bbox_pixels,
@@ -1151,8 +1233,8 @@ static int LayoutLine( filter_t *p_filter,
         }
         if( p_bitmaps->p_glyph )
         {
-            if( FT_Glyph_To_Bitmap( &p_bitmaps->p_glyph, FT_RENDER_MODE_NORMAL,
-                                    &pen_new, 1 ) )
+            if( GlyphCache_ToBitmap( p_sys->p_glyph_cache, &p_bitmaps->cache_key,
+                                     false, &p_bitmaps->p_glyph, &pen_new, 1 ) )
             {
                 FT_Done_Glyph( p_bitmaps->p_glyph );
                 if( p_bitmaps->p_outline )
@@ -1168,8 +1250,8 @@ static int LayoutLine( filter_t *p_filter,
         }
         if( p_bitmaps->p_outline )
         {
-            if( FT_Glyph_To_Bitmap( &p_bitmaps->p_outline, FT_RENDER_MODE_NORMAL,
-                                    &pen_new, 1 ) )
+            if( GlyphCache_ToBitmap( p_sys->p_glyph_cache, &p_bitmaps->cache_key,
+                                     true, &p_bitmaps->p_outline, &pen_new, 1 ) )
             {
                 FT_Done_Glyph( p_bitmaps->p_outline );
                 p_bitmaps->p_outline = 0;
@@ -30,6 +30,12 @@
 #include <vlc_picture.h>
 #include <vlc_cpu.h>
 #include <assert.h>
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+#endif
+#ifdef __ARM_NEON
+# include <arm_neon.h>
+#endif
 
 #include "copy.h"
 
@@ -106,7 +112,14 @@ void CopyCleanCache(copy_cache_t *cache)
 # define vlc_CPU_SSE2() ((cpu & VLC_CPU_SSE2) != 0)
 #endif
 
+#ifndef __AVX2__
+# undef vlc_CPU_AVX2
+# define vlc_CPU_AVX2() ((cpu & VLC_CPU_AVX2) != 0)
+#endif
+
 #ifdef COPY_TEST_NOOTPIM
+# undef vlc_CPU_AVX2
+# define vlc_CPU_AVX2() (0)
 # undef vlc_CPU_SSE4_1
 # define vlc_CPU_SSE4_1() (0)
 # undef vlc_CPU_SSE3
@@ -149,14 +162,14 @@ static void CopyFromUswc(uint8_t *dst, size_t dst_pitch,
         } else
 #endif
         {
-            if (!unaligned) {
-                for (; x+63 < width; x += 64)
-                    COPY64(&dst[x], &src[x], "movdqa", "movdqa");
-            } else {
-                COPY16(dst, src, "movdqu", "movdqa");
-                for (; x+63 < width; x += 64)
-                    COPY64(&dst[x], &src[x], "movdqa", "movdqu");
-            }
+                if (!unaligned) {
+                    for (; x+63 < width; x += 64)
+                        COPY64(&dst[x], &src[x], "movdqa", "movdqa");
+                } else {
+                    COPY16(dst, src, "movdqu", "movdqa");
+                    for (; x+63 < width; x += 64)
+                        COPY64(&dst[x], &src[x], "movdqa", "movdqu");
+                }
         }
 
         for (; x < width; x++)
@@ -431,6 +444,184 @@ static void SSE_SplitUV(uint8_t *dstu, size_t dstu_pitch,
 #undef LOAD64
 }
 
+#ifdef HAVE_AVX2_INTRINSICS
+/* Same as CopyFromUswc() with 32 bytes loads */
+VLC_AVX2
+static void AVX2_CopyFromUswc(uint8_t *dst, size_t dst_pitch,
+                              const uint8_t *src, size_t src_pitch,
+                              unsigned width, unsigned height)
+{
+    _mm_mfence();
+
+    for (unsigned y = 0; y < height; y++) {
+        unsigned x = 0;
+
+        if (width >= 32) {
+            const unsigned unaligned = (-(uintptr_t)src) & 0x1f;
+            if (unaligned) {
+                _mm256_storeu_si256((__m256i *)dst,
+                                    _mm256_loadu_si256((const __m256i *)src));
+                x = unaligned;
+            }
+            for (; x+127 < width; x += 128) {
+                const __m256i *s = (const __m256i *)&src[x];
+                __m256i *d = (__m256i *)&dst[x];
+                __m256i x0 = _mm256_stream_load_si256(&s[0]);
+                __m256i x1 = _mm256_stream_load_si256(&s[1]);
+                __m256i x2 = _mm256_stream_load_si256(&s[2]);
+                __m256i x3 = _mm256_stream_load_si256(&s[3]);
+                _mm256_storeu_si256(&d[0], x0);
+                _mm256_storeu_si256(&d[1], x1);
+                _mm256_storeu_si256(&d[2], x2);
+                _mm256_storeu_si256(&d[3], x3);
+            }
+        }
+
+        for (; x < width; x++)
+            dst[x] = src[x];
+
+        src += src_pitch;
+        dst += dst_pitch;
+    }
+    _mm_mfence();
+}
+
+VLC_AVX2
+static void AVX2_Copy2d(uint8_t *dst, size_t dst_pitch,
+                        const uint8_t *src, size_t src_pitch,
+                        unsigned width, unsigned height)
+{
+    for (unsigned y = 0; y < height; y++) {
+        unsigned x = 0;
+
+        bool aligned = ((intptr_t)dst & 0x1f) == 0;
+        for (; x+127 < width; x += 128) {
+            const __m256i *s = (const __m256i *)&src[x];
+            __m256i *d = (__m256i *)&dst[x];
+            __m256i x0 = _mm256_loadu_si256(&s[0]);
+            __m256i x1 = _mm256_loadu_si256(&s[1]);
+            __m256i x2 = _mm256_loadu_si256(&s[2]);
+            __m256i x3 = _mm256_loadu_si256(&s[3]);
+            if (aligned) {
+                _mm256_stream_si256(&d[0], x0);
+                _mm256_stream_si256(&d[1], x1);
+                _mm256_stream_si256(&d[2], x2);
+                _mm256_stream_si256(&d[3], x3);
+            } else {
+                _mm256_storeu_si256(&d[0], x0);
+                _mm256_storeu_si256(&d[1], x1);
+                _mm256_storeu_si256(&d[2], x2);
+                _mm256_storeu_si256(&d[3], x3);
+            }
+        }
+
+        for (; x < width; x++)
+            dst[x] = src[x];
+
+        src += src_pitch;
+        dst += dst_pitch;
+    }
+    _mm_sfence();
+}
+
+VLC_AVX2
+static void AVX2_InterleaveUV(uint8_t *dst, size_t dst_pitch,
+                              const uint8_t *srcu, size_t srcu_pitch,
+                              const uint8_t *srcv, size_t srcv_pitch,
+                              unsigned width, unsigned height,
+                              uint8_t pixel_size)
+{
+    for (unsigned y = 0; y < height; y++) {
+        unsigned x = 0;
+
+        for (; x + 32 <= width; x += 32) {
+            __m256i u = _mm256_loadu_si256((const __m256i *)&srcu[x]);
+            __m256i v = _mm256_loadu_si256((const __m256i *)&srcv[x]);
+            __m256i lo, hi;
+
+            /* The unpacking is done within each 128-bits lane */
+            if (pixel_size == 1) {
+                lo = _mm256_unpacklo_epi8(u, v);
+                hi = _mm256_unpackhi_epi8(u, v);
+            } else {
+                lo = _mm256_unpacklo_epi16(u, v);
+                hi = _mm256_unpackhi_epi16(u, v);
+            }
+            _mm256_storeu_si256((__m256i *)&dst[2*x],
+                                _mm256_permute2x128_si256(lo, hi, 0x20));
+            _mm256_storeu_si256((__m256i *)&dst[2*x+32],
+                                _mm256_permute2x128_si256(lo, hi, 0x31));
+        }
+
+        if (pixel_size == 1) {
+            for (; x < width; x++) {
+                dst[2*x+0] = srcu[x];
+                dst[2*x+1] = srcv[x];
+            }
+        } else {
+            for (; x < width; x += 2) {
+                dst[2*x+0] = srcu[x];
+                dst[2*x+1] = srcu[x + 1];
+                dst[2*x+2] = srcv[x];
+                dst[2*x+3] = srcv[x + 1];
+            }
+        }
+        srcu += srcu_pitch;
+        srcv += srcv_pitch;
+        dst += dst_pitch;
+    }
+}
+
+VLC_AVX2
+static void AVX2_SplitUV(uint8_t *dstu, size_t dstu_pitch,
+                         uint8_t *dstv, size_t dstv_pitch,
+                         const uint8_t *src, size_t src_pitch,
+                         unsigned width, unsigned height, uint8_t pixel_size)
+{
+    const __m256i shuffle = pixel_size == 1
+        ? _mm256_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15,
+                           0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15)
+        : _mm256_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15,
+                           0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15);
+
+    for (unsigned y = 0; y < height; y++) {
+        unsigned x = 0;
+
+        for (; x + 32 <= width; x += 32) {
+            /* Each lane is split into its U then V halves, and the 64-bits
+             * halves are then gathered by plane */
+            __m256i a = _mm256_shuffle_epi8(
+                _mm256_loadu_si256((const __m256i *)&src[2*x]), shuffle);
+            __m256i b = _mm256_shuffle_epi8(
+                _mm256_loadu_si256((const __m256i *)&src[2*x+32]), shuffle);
+            a = _mm256_permute4x64_epi64(a, _MM_SHUFFLE(3, 1, 2, 0));
+            b = _mm256_permute4x64_epi64(b, _MM_SHUFFLE(3, 1, 2, 0));
+            _mm256_storeu_si256((__m256i *)&dstu[x],
+                                _mm256_permute2x128_si256(a, b, 0x20));
+            _mm256_storeu_si256((__m256i *)&dstv[x],
+                                _mm256_permute2x128_si256(a, b, 0x31));
+        }
+
+        if (pixel_size == 1) {
+            for (; x < width; x++) {
+                dstu[x] = src[2*x+0];
+                dstv[x] = src[2*x+1];
+            }
+        } else {
+            for (; x < width; x += 2) {
+                dstu[x] = src[2*x+0];
+                dstu[x+1] = src[2*x+1];
+                dstv[x] = src[2*x+2];
+                dstv[x+1] = src[2*x+3];
+            }
+        }
+        src  += src_pitch;
+        dstu += dstu_pitch;
+        dstv += dstv_pitch;
+    }
+}
+#endif /* HAVE_AVX2_INTRINSICS */
+
 static void SSE_CopyPlane(uint8_t *dst, size_t dst_pitch,
                           const uint8_t *src, size_t src_pitch,
                           uint8_t *cache, size_t cache_size,
@@ -446,15 +637,23 @@ static void SSE_CopyPlane(uint8_t *dst, size_t dst_pitch,
     for (unsigned y = 0; y < height; y += hstep) {
         const unsigned hblock =  __MIN(hstep, height - y);
 
-        /* Copy a bunch of line into our cache */
-        CopyFromUswc(cache, w16,
-                     src, src_pitch,
-                     src_pitch, hblock, cpu);
-
-        /* Copy from our cache to the destination */
-        Copy2d(dst, dst_pitch,
-               cache, w16,
-               src_pitch, hblock);
+#ifdef HAVE_AVX2_INTRINSICS
+        if (vlc_CPU_AVX2()) {
+            AVX2_CopyFromUswc(cache, w16, src, src_pitch, src_pitch, hblock);
+            AVX2_Copy2d(dst, dst_pitch, cache, w16, src_pitch, hblock);
+        } else
+#endif
+        {
+            /* Copy a bunch of line into our cache */
+            CopyFromUswc(cache, w16,
+                         src, src_pitch,
+                         src_pitch, hblock, cpu);
+
+            /* Copy from our cache to the destination */
+            Copy2d(dst, dst_pitch,
+                   cache, w16,
+                   src_pitch, hblock);
+        }
 
         /* */
         src += src_pitch * hblock;
@@ -478,16 +677,29 @@ SSE_InterleavePlanes(uint8_t *dst, size_t dst_pitch,
     {
         unsigned int const      hblock = __MIN(hstep, height - y);
 
-        /* Copy a bunch of line into our cache */
-        CopyFromUswc(cache, w16, srcu, srcu_pitch,
-                     srcu_pitch, hblock, cpu);
-        CopyFromUswc(cache+w16*hblock, w16, srcv, srcv_pitch,
-                     srcv_pitch, hblock, cpu);
-
-        /* Copy from our cache to the destination */
-        SSE_InterleaveUV(dst, dst_pitch, cache, w16,
-                         cache+w16*hblock, w16, srcu_pitch, hblock, pixel_size,
-                         cpu);
+#ifdef HAVE_AVX2_INTRINSICS
+        if (vlc_CPU_AVX2()) {
+            AVX2_CopyFromUswc(cache, w16, srcu, srcu_pitch,
+                              srcu_pitch, hblock);
+            AVX2_CopyFromUswc(cache+w16*hblock, w16, srcv, srcv_pitch,
+                              srcv_pitch, hblock);
+            AVX2_InterleaveUV(dst, dst_pitch, cache, w16,
+                              cache+w16*hblock, w16, srcu_pitch, hblock,
+                              pixel_size);
+        } else
+#endif
+        {
+            /* Copy a bunch of line into our cache */
+            CopyFromUswc(cache, w16, srcu, srcu_pitch,
+                         srcu_pitch, hblock, cpu);
+            CopyFromUswc(cache+w16*hblock, w16, srcv, srcv_pitch,
+                         srcv_pitch, hblock, cpu);
+
+            /* Copy from our cache to the destination */
+            SSE_InterleaveUV(dst, dst_pitch, cache, w16,
+                             cache+w16*hblock, w16, srcu_pitch, hblock, pixel_size,
+                             cpu);
+        }
 
         /* */
         srcu += hblock * srcu_pitch;
@@ -509,13 +721,23 @@ static void SSE_SplitPlanes(uint8_t *dstu, size_t dstu_pitch,
     for (unsigned y = 0; y < height; y += hstep) {
         const unsigned hblock =  __MIN(hstep, height - y);
 
-        /* Copy a bunch of line into our cache */
-        CopyFromUswc(cache, w16, src, src_pitch,
-                     src_pitch, hblock, cpu);
+#ifdef HAVE_AVX2_INTRINSICS
+        if (vlc_CPU_AVX2()) {
+            AVX2_CopyFromUswc(cache, w16, src, src_pitch,
+                              src_pitch, hblock);
+            AVX2_SplitUV(dstu, dstu_pitch, dstv, dstv_pitch,
+                         cache, w16, src_pitch / 2, hblock, pixel_size);
+        } else
+#endif
+        {
+            /* Copy a bunch of line into our cache */
+            CopyFromUswc(cache, w16, src, src_pitch,
+                         src_pitch, hblock, cpu);
 
-        /* Copy from our cache to the destination */
-        SSE_SplitUV(dstu, dstu_pitch, dstv, dstv_pitch,
-                    cache, w16, src_pitch / 2, hblock, pixel_size, cpu);
+            /* Copy from our cache to the destination */
+            SSE_SplitUV(dstu, dstu_pitch, dstv, dstv_pitch,
+                        cache, w16, src_pitch / 2, hblock, pixel_size, cpu);
+        }
 
         /* */
         src  += src_pitch  * hblock;
@@ -648,6 +870,84 @@ static void SplitPlanes16(uint8_t *dstu, size_t dstu_pitch,
     SPLIT_PLANES(uint16_t, 4);
 }
 
+#ifdef __ARM_NEON
+static void NEON_SplitPlanes(uint8_t *dstu, size_t dstu_pitch,
+                             uint8_t *dstv, size_t dstv_pitch,
+                             const uint8_t *src, size_t src_pitch,
+                             unsigned height, uint8_t pixel_size)
+{
+    const unsigned width = src_pitch / 2;
+
+    for (unsigned y = 0; y < height; y++) {
+        unsigned x = 0;
+
+        if (pixel_size == 1) {
+            for (; x + 16 <= width; x += 16) {
+                uint8x16x2_t uv = vld2q_u8(&src[2*x]);
+                vst1q_u8(&dstu[x], uv.val[0]);
+                vst1q_u8(&dstv[x], uv.val[1]);
+            }
+            for (; x < width; x++) {
+                dstu[x] = src[2*x+0];
+                dstv[x] = src[2*x+1];
+            }
+        } else {
+            for (; x + 16 <= width; x += 16) {
+                uint16x8x2_t uv = vld2q_u16((const uint16_t *)&src[2*x]);
+                vst1q_u16((uint16_t *)&dstu[x], uv.val[0]);
+                vst1q_u16((uint16_t *)&dstv[x], uv.val[1]);
+            }
+            for (; x < width; x += 2) {
+                dstu[x] = src[2*x+0];
+                dstu[x+1] = src[2*x+1];
+                dstv[x] = src[2*x+2];
+                dstv[x+1] = src[2*x+3];
+            }
+        }
+        src  += src_pitch;
+        dstu += dstu_pitch;
+        dstv += dstv_pitch;
+    }
+}
+
+static void NEON_InterleavePlanes(uint8_t *dst, size_t dst_pitch,
+                                  const uint8_t *srcu, size_t srcu_pitch,
+                                  const uint8_t *srcv, size_t srcv_pitch,
+                                  unsigned width, unsigned height,
+                                  uint8_t pixel_size)
+{
+    for (unsigned y = 0; y < height; y++) {
+        unsigned x = 0;
+
+        if (pixel_size == 1) {
+            for (; x + 16 <= width; x += 16) {
+                uint8x16x2_t uv = { { vld1q_u8(&srcu[x]), vld1q_u8(&srcv[x]) } };
+                vst2q_u8(&dst[2*x], uv);
+            }
+            for (; x < width; x++) {
+                dst[2*x+0] = srcu[x];
+                dst[2*x+1] = srcv[x];
+            }
+        } else {
+            for (; x + 16 <= width; x += 16) {
+                uint16x8x2_t uv = { { vld1q_u16((const uint16_t *)&srcu[x]),
+                                      vld1q_u16((const uint16_t *)&srcv[x]) } };
+                vst2q_u16((uint16_t *)&dst[2*x], uv);
+            }
+            for (; x < width; x += 2) {
+                dst[2*x+0] = srcu[x];
+                dst[2*x+1] = srcu[x + 1];
+                dst[2*x+2] = srcv[x];
+                dst[2*x+3] = srcv[x + 1];
+            }
+        }
+        srcu += srcu_pitch;
+        srcv += srcv_pitch;
+        dst  += dst_pitch;
+    }
+}
+#endif
+
 void Copy420_SP_to_P(picture_t *dst, const uint8_t *src[static 2],
                      const size_t src_pitch[static 2], unsigned height,
                      const copy_cache_t *cache)
@@ -664,9 +964,15 @@ void Copy420_SP_to_P(picture_t *dst, const uint8_t *src[static 2],
 
     CopyPlane(dst->p[0].p_pixels, dst->p[0].i_pitch,
               src[0], src_pitch[0], height);
+#ifdef __ARM_NEON
+    NEON_SplitPlanes(dst->p[1].p_pixels, dst->p[1].i_pitch,
+                     dst->p[2].p_pixels, dst->p[2].i_pitch,
+                     src[1], src_pitch[1], height/2, 1);
+#else
     SplitPlanes(dst->p[1].p_pixels, dst->p[1].i_pitch,
                 dst->p[2].p_pixels, dst->p[2].i_pitch,
                 src[1], src_pitch[1], height/2);
+#endif
 }
 
 void Copy420_16_SP_to_P(picture_t *dst, const uint8_t *src[static 2],
@@ -685,9 +991,15 @@ void Copy420_16_SP_to_P(picture_t *dst, const uint8_t *src[static 2],
 
     CopyPlane(dst->p[0].p_pixels, dst->p[0].i_pitch,
               src[0], src_pitch[0], height);
+#ifdef __ARM_NEON
+    NEON_SplitPlanes(dst->p[1].p_pixels, dst->p[1].i_pitch,
+                     dst->p[2].p_pixels, dst->p[2].i_pitch,
+                     src[1], src_pitch[1], height/2, 2);
+#else
     SplitPlanes16(dst->p[1].p_pixels, dst->p[1].i_pitch,
                   dst->p[2].p_pixels, dst->p[2].i_pitch,
                   src[1], src_pitch[1], height/2);
+#endif
 }
 
 #define INTERLEAVE_UV() do { \
@@ -718,6 +1030,12 @@ void Copy420_P_to_SP(picture_t *dst, const uint8_t *src[static 3],
     CopyPlane(dst->p[0].p_pixels, dst->p[0].i_pitch,
               src[0], src_pitch[0], height);
 
+#ifdef __ARM_NEON
+    NEON_InterleavePlanes(dst->p[1].p_pixels, dst->p[1].i_pitch,
+                          src[U_PLANE], src_pitch[U_PLANE],
+                          src[V_PLANE], src_pitch[V_PLANE],
+                          src_pitch[1], height / 2, 1);
+#else
     const unsigned copy_lines = height / 2;
     const unsigned copy_pitch = src_pitch[1];
 
@@ -729,6 +1047,7 @@ void Copy420_P_to_SP(picture_t *dst, const uint8_t *src[static 3],
     const uint8_t *srcU  = src[U_PLANE];
     const uint8_t *srcV  = src[V_PLANE];
     INTERLEAVE_UV();
+#endif
 }
 
 void Copy420_16_P_to_SP(picture_t *dst, const uint8_t *src[static 3],
@@ -747,6 +1066,12 @@ void Copy420_16_P_to_SP(picture_t *dst, const uint8_t *src[static 3],
     CopyPlane(dst->p[0].p_pixels, dst->p[0].i_pitch,
               src[0], src_pitch[0], height);
 
+#ifdef __ARM_NEON
+    NEON_InterleavePlanes(dst->p[1].p_pixels, dst->p[1].i_pitch,
+                          src[U_PLANE], src_pitch[U_PLANE],
+                          src[V_PLANE], src_pitch[V_PLANE],
+                          src_pitch[1], height / 2, 2);
+#else
     const unsigned copy_lines = height / 2;
     const unsigned copy_pitch = src_pitch[1] / 2;
 
@@ -758,6 +1083,7 @@ void Copy420_16_P_to_SP(picture_t *dst, const uint8_t *src[static 3],
     const uint16_t *srcU  = (const uint16_t *) src[U_PLANE];
     const uint16_t *srcV  = (const uint16_t *) src[V_PLANE];
     INTERLEAVE_UV();
+#endif
 }
 
 void CopyFromI420_10ToP010(picture_t *dst, const uint8_t *src[static 3],
@@ -1017,6 +1343,30 @@ static picture_t *pic_new_unaligned(const video_format_t *fmt)
     return picture_NewFromResource(fmt, &rsc);
 }
 
+/* Number of conversions timed for the large sizes */
+#define BENCH_LOOPS 20
+
+static void bench(const struct test_dst *test_dst, picture_t *dst,
+                  const picture_t *src, const uint8_t *src_planes[],
+                  const size_t src_pitches[], const copy_cache_t *cache)
+{
+    size_t bytes = 0;
+    for (int i = 0; i < src->i_planes; i++)
+        bytes += src->p[i].i_pitch * src->p[i].i_lines;
+
+    mtime_t start = mdate();
+    for (unsigned i = 0; i < BENCH_LOOPS; i++)
+        test_dst->conv(dst, src_planes, src_pitches,
+                       src->format.i_visible_height, cache);
+    mtime_t duration = mdate() - start;
+    if (duration <= 0)
+        duration = 1;
+
+    fprintf(stderr, "         %.2f ms/frame, %.0f MB/s\n",
+            duration / 1000. / BENCH_LOOPS,
+            (double)bytes * BENCH_LOOPS / duration);
+}
+
 int main(void)
 {
     unsigned cpu = vlc_CPU();
@@ -1095,6 +1445,8 @@ int main(void)
                 test_dst->conv(dst, src_planes, src_pitches,
                                 src->format.i_visible_height, &cache);
                 piccheck(dst, dst_dsc, false);
+                if (size->i_visible_width >= 1920)
+                    bench(test_dst, dst, src, src_planes, src_pitches, &cache);
                 picture_Release(dst);
             }
             picture_Release(src);
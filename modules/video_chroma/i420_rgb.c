@@ -56,6 +56,9 @@ static picture_t *I420_R8G8B8A8_Filter( filter_t *, picture_t * );
 static picture_t *I420_B8G8R8A8_Filter( filter_t *, picture_t * );
 static picture_t *I420_A8B8G8R8_Filter( filter_t *, picture_t * );
 #endif
+#ifdef SSE2
+static picture_t *I420_RGB32_AVX2_Filter( filter_t *, picture_t * );
+#endif
 
 /*****************************************************************************
  * RGB2PIXEL: assemble RGB components to a pixel value, returns a uint32_t
@@ -249,6 +252,18 @@ static int Activate( vlc_object_t *p_this )
         return VLC_EGENERIC;
     }
 
+#ifdef SSE2
+    /* The AVX2 conversion covers all the 32 bits layouts, but not scaling */
+    p_filter->p_sys->p_slices = NULL;
+    if( p_filter->fmt_out.video.i_chroma == VLC_CODEC_RGB32
+     && I420_RGB32_AVX2_Init( p_filter ) )
+    {
+        msg_Dbg( p_this, "using the AVX2 conversion" );
+        p_filter->p_sys->p_slices = filter_SlicesHold( p_filter );
+        p_filter->pf_video_filter = I420_RGB32_AVX2_Filter;
+    }
+#endif
+
 #ifdef PLAIN
     switch( p_filter->fmt_out.video.i_chroma )
     {
@@ -290,6 +305,10 @@ static void Deactivate( vlc_object_t *p_this )
 
 #ifdef PLAIN
     free( p_filter->p_sys->p_base );
+#endif
+#ifdef SSE2
+    if( p_filter->p_sys->p_slices != NULL )
+        filter_SlicesRelease( p_filter->p_sys->p_slices );
 #endif
     free( p_filter->p_sys->p_offset );
     free( p_filter->p_sys->p_buffer );
@@ -303,6 +322,9 @@ VIDEO_FILTER_WRAPPER( I420_A8R8G8B8 )
 VIDEO_FILTER_WRAPPER( I420_R8G8B8A8 )
 VIDEO_FILTER_WRAPPER( I420_B8G8R8A8 )
 VIDEO_FILTER_WRAPPER( I420_A8B8G8R8 )
+# ifdef SSE2
+VIDEO_FILTER_WRAPPER( I420_RGB32_AVX2 )
+# endif
 #else
 VIDEO_FILTER_WRAPPER( I420_RGB8 )
 VIDEO_FILTER_WRAPPER( I420_RGB16 )
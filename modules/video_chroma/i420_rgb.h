@@ -54,6 +54,14 @@ struct filter_sys_t
     uint16_t  p_rgb_g[CMAP_RGB2_SIZE];  /**< Green values of palette */
     uint16_t  p_rgb_b[CMAP_RGB2_SIZE];  /**< Blue values of palette */
 #endif
+#ifdef SSE2
+    /**< AVX2 conversion to 32 bits, without scaling */
+    filter_slices_t *p_slices;
+    int16_t i_y_offset;                /**< black level of the luma */
+    int16_t i_y_coef;                  /**< luma scale, factors in Q13 */
+    int16_t i_v_red, i_u_green, i_v_green, i_u_blue;
+    unsigned i_red_shift, i_green_shift, i_blue_shift, i_alpha_shift;
+#endif
 };
 
 /*****************************************************************************
@@ -71,6 +79,10 @@ void I420_R8G8B8A8     ( filter_t *, picture_t *, picture_t * );
 void I420_B8G8R8A8     ( filter_t *, picture_t *, picture_t * );
 void I420_A8B8G8R8     ( filter_t *, picture_t *, picture_t * );
 #endif
+#ifdef SSE2
+bool I420_RGB32_AVX2_Init( filter_t * );
+void I420_RGB32_AVX2   ( filter_t *, picture_t *, picture_t * );
+#endif
 
 /*****************************************************************************
  * CONVERT_*_PIXEL: pixel conversion macros
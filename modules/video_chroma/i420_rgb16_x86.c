@@ -26,6 +26,8 @@
 # include "config.h"
 #endif
 
+#include <assert.h>
+
 #include <vlc_common.h>
 #include <vlc_filter.h>
 #include <vlc_picture.h>
@@ -34,6 +36,9 @@
 #include "i420_rgb.h"
 #ifdef SSE2
 # include "i420_rgb_sse2.h"
+# ifdef HAVE_AVX2_INTRINSICS
+#  include <immintrin.h>
+# endif
 # define VLC_TARGET VLC_SSE
 #else
 # include "i420_rgb_mmx.h"
@@ -1478,3 +1483,246 @@ void I420_A8B8G8R8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
 
 #endif
 }
+
+#ifdef SSE2
+/*****************************************************************************
+ * AVX2 conversion to 32 bits
+ *****************************************************************************
+ * Unlike the tables and the assembly above, the coefficients follow the
+ * color space and the range of the input. The arithmetic is done on 16 bits
+ * in Q5 fixed point, with the same rounding in the vector and scalar paths.
+ * Each pair of luma rows shares its chroma row: the pairs are independent
+ * and are converted by bands on the slice threads.
+ *****************************************************************************/
+bool I420_RGB32_AVX2_Init( filter_t *p_filter )
+{
+#ifdef HAVE_AVX2_INTRINSICS
+    const video_format_t *fmt_in = &p_filter->fmt_in.video;
+    const video_format_t *fmt_out = &p_filter->fmt_out.video;
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( !vlc_CPU_AVX2() )
+        return false;
+    if( fmt_in->i_x_offset + fmt_in->i_visible_width
+         != fmt_out->i_x_offset + fmt_out->i_visible_width
+     || fmt_in->i_y_offset + fmt_in->i_visible_height
+         != fmt_out->i_y_offset + fmt_out->i_visible_height )
+        return false;
+
+    /* Components of 8 bits within the 32 bits of the pixel */
+    const uint32_t masks[3] = { fmt_out->i_rmask, fmt_out->i_gmask,
+                                fmt_out->i_bmask };
+    unsigned shifts[3];
+    for( unsigned i = 0; i < 3; i++ )
+    {
+        if( masks[i] == 0 || (masks[i] >> ctz( masks[i] )) != 0xff )
+            return false;
+        shifts[i] = ctz( masks[i] );
+    }
+    uint32_t alpha = ~(masks[0] | masks[1] | masks[2]);
+    if( alpha == 0 || (alpha >> ctz( alpha )) != 0xff )
+        return false;
+
+    double kr, kb;
+    video_color_space_t space = fmt_in->space;
+    if( space == COLOR_SPACE_UNDEF )
+        space = fmt_in->i_visible_height > 576 ? COLOR_SPACE_BT709
+                                               : COLOR_SPACE_BT601;
+    switch( space )
+    {
+        case COLOR_SPACE_BT709:
+            kr = 0.2126; kb = 0.0722;
+            break;
+        case COLOR_SPACE_BT2020:
+            kr = 0.2627; kb = 0.0593;
+            break;
+        default:
+            kr = 0.299; kb = 0.114;
+            break;
+    }
+    const double kg = 1. - kr - kb;
+    const double ky = fmt_in->b_color_range_full ? 1. : 255. / 219.;
+    const double kc = fmt_in->b_color_range_full ? 1. : 255. / 224.;
+#define Q13( x ) ((int16_t)((x) * 8192. + .5))
+    p_sys->i_y_offset = fmt_in->b_color_range_full ? 0 : 16;
+    p_sys->i_y_coef = Q13( ky );
+    p_sys->i_v_red = Q13( 2. * (1. - kr) * kc );
+    p_sys->i_u_green = Q13( 2. * (1. - kb) * kb / kg * kc );
+    p_sys->i_v_green = Q13( 2. * (1. - kr) * kr / kg * kc );
+    p_sys->i_u_blue = Q13( 2. * (1. - kb) * kc );
+#undef Q13
+    p_sys->i_red_shift = shifts[0];
+    p_sys->i_green_shift = shifts[1];
+    p_sys->i_blue_shift = shifts[2];
+    p_sys->i_alpha_shift = ctz( alpha );
+    return true;
+#else
+    VLC_UNUSED(p_filter);
+    return false;
+#endif
+}
+
+#ifdef HAVE_AVX2_INTRINSICS
+/* Same rounding as _mm256_mulhrs_epi16 */
+static inline int MulQ15( int a, int b )
+{
+    return (a * b + 0x4000) >> 15;
+}
+
+static inline uint32_t Pixel32( const filter_sys_t *p_sys, int y,
+                                int r, int g, int b )
+{
+    y = MulQ15( (y - p_sys->i_y_offset) * 128, p_sys->i_y_coef );
+    r = VLC_CLIP( (y + r + 16) >> 5, 0, 255 );
+    g = VLC_CLIP( (y - g + 16) >> 5, 0, 255 );
+    b = VLC_CLIP( (y + b + 16) >> 5, 0, 255 );
+    return ((uint32_t)r << p_sys->i_red_shift)
+         | ((uint32_t)g << p_sys->i_green_shift)
+         | ((uint32_t)b << p_sys->i_blue_shift)
+         | (UINT32_C(0xff) << p_sys->i_alpha_shift);
+}
+
+struct rgb32_band
+{
+    const filter_sys_t *p_sys;
+    const picture_t *p_src;
+    picture_t *p_dest;
+    unsigned i_width, i_height;
+};
+
+VLC_AVX2
+static void I420_RGB32_AVX2_Band( void *opaque, unsigned first, unsigned last )
+{
+    const struct rgb32_band *band = opaque;
+    const filter_sys_t *p_sys = band->p_sys;
+    const plane_t *y_plane = &band->p_src->p[Y_PLANE];
+    const plane_t *u_plane = &band->p_src->p[U_PLANE];
+    const plane_t *v_plane = &band->p_src->p[V_PLANE];
+    const plane_t *out = band->p_dest->p;
+    const unsigned i_width = band->i_width;
+
+    const __m256i c128 = _mm256_set1_epi16( 128 );
+    const __m256i c16 = _mm256_set1_epi16( 16 );
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i max = _mm256_set1_epi16( 255 );
+    const __m256i y_offset = _mm256_set1_epi16( p_sys->i_y_offset );
+    const __m256i y_coef = _mm256_set1_epi16( p_sys->i_y_coef );
+    const __m256i v_red = _mm256_set1_epi16( p_sys->i_v_red );
+    const __m256i u_green = _mm256_set1_epi16( p_sys->i_u_green );
+    const __m256i v_green = _mm256_set1_epi16( p_sys->i_v_green );
+    const __m256i u_blue = _mm256_set1_epi16( p_sys->i_u_blue );
+    const __m256i alpha = _mm256_set1_epi32( 0xff << p_sys->i_alpha_shift );
+    const __m128i r_shift = _mm_cvtsi32_si128( p_sys->i_red_shift );
+    const __m128i g_shift = _mm_cvtsi32_si128( p_sys->i_green_shift );
+    const __m128i b_shift = _mm_cvtsi32_si128( p_sys->i_blue_shift );
+
+    for( unsigned i_row = first; i_row < last; i_row++ )
+    {
+        const uint8_t *p_u = u_plane->p_pixels + i_row * u_plane->i_pitch;
+        const uint8_t *p_v = v_plane->p_pixels + i_row * v_plane->i_pitch;
+        unsigned i_lines = __MIN( 2, band->i_height - 2 * i_row );
+        unsigned x = 0;
+
+        for( ; x + 16 <= i_width; x += 16 )
+        {
+            /* Each chroma sample covers 2 pixels of 2 rows */
+            __m128i u8 = _mm_loadl_epi64( (const __m128i *)(p_u + x / 2) );
+            __m128i v8 = _mm_loadl_epi64( (const __m128i *)(p_v + x / 2) );
+            __m256i u = _mm256_cvtepu8_epi16( _mm_unpacklo_epi8( u8, u8 ) );
+            __m256i v = _mm256_cvtepu8_epi16( _mm_unpacklo_epi8( v8, v8 ) );
+            u = _mm256_slli_epi16( _mm256_sub_epi16( u, c128 ), 7 );
+            v = _mm256_slli_epi16( _mm256_sub_epi16( v, c128 ), 7 );
+
+            __m256i r_uv = _mm256_mulhrs_epi16( v, v_red );
+            __m256i g_uv = _mm256_add_epi16( _mm256_mulhrs_epi16( u, u_green ),
+                                             _mm256_mulhrs_epi16( v, v_green ) );
+            __m256i b_uv = _mm256_mulhrs_epi16( u, u_blue );
+
+            for( unsigned i_line = 0; i_line < i_lines; i_line++ )
+            {
+                const uint8_t *p_y = y_plane->p_pixels
+                                   + (2 * i_row + i_line) * y_plane->i_pitch;
+                uint32_t *p_out = (uint32_t *)(out->p_pixels
+                                   + (2 * i_row + i_line) * out->i_pitch);
+
+                __m256i y = _mm256_cvtepu8_epi16(
+                                _mm_loadu_si128( (const __m128i *)(p_y + x) ) );
+                y = _mm256_slli_epi16( _mm256_sub_epi16( y, y_offset ), 7 );
+                y = _mm256_add_epi16( _mm256_mulhrs_epi16( y, y_coef ), c16 );
+
+#define COMPONENT( v ) \
+    _mm256_min_epi16( _mm256_max_epi16( _mm256_srai_epi16( v, 5 ), zero ), max )
+                __m256i r = COMPONENT( _mm256_add_epi16( y, r_uv ) );
+                __m256i g = COMPONENT( _mm256_sub_epi16( y, g_uv ) );
+                __m256i b = COMPONENT( _mm256_add_epi16( y, b_uv ) );
+#undef COMPONENT
+
+                for( unsigned i_half = 0; i_half < 2; i_half++ )
+                {
+                    __m256i r32, g32, b32;
+                    if( i_half == 0 )
+                    {
+                        r32 = _mm256_cvtepu16_epi32( _mm256_castsi256_si128( r ) );
+                        g32 = _mm256_cvtepu16_epi32( _mm256_castsi256_si128( g ) );
+                        b32 = _mm256_cvtepu16_epi32( _mm256_castsi256_si128( b ) );
+                    }
+                    else
+                    {
+                        r32 = _mm256_cvtepu16_epi32( _mm256_extracti128_si256( r, 1 ) );
+                        g32 = _mm256_cvtepu16_epi32( _mm256_extracti128_si256( g, 1 ) );
+                        b32 = _mm256_cvtepu16_epi32( _mm256_extracti128_si256( b, 1 ) );
+                    }
+                    __m256i pix = _mm256_or_si256(
+                        _mm256_or_si256( _mm256_sll_epi32( r32, r_shift ),
+                                         _mm256_sll_epi32( g32, g_shift ) ),
+                        _mm256_or_si256( _mm256_sll_epi32( b32, b_shift ),
+                                         alpha ) );
+                    _mm256_storeu_si256( (__m256i *)(p_out + x + 8 * i_half),
+                                         pix );
+                }
+            }
+        }
+
+        /* Remaining pixels, with the same arithmetic */
+        for( ; x < i_width; x++ )
+        {
+            int u = (p_u[x / 2] - 128) * 128, v = (p_v[x / 2] - 128) * 128;
+            int r = MulQ15( v, p_sys->i_v_red );
+            int g = MulQ15( u, p_sys->i_u_green ) + MulQ15( v, p_sys->i_v_green );
+            int b = MulQ15( u, p_sys->i_u_blue );
+
+            for( unsigned i_line = 0; i_line < i_lines; i_line++ )
+            {
+                const uint8_t *p_y = y_plane->p_pixels
+                                   + (2 * i_row + i_line) * y_plane->i_pitch;
+                uint32_t *p_out = (uint32_t *)(out->p_pixels
+                                   + (2 * i_row + i_line) * out->i_pitch);
+
+                p_out[x] = Pixel32( p_sys, p_y[x], r, g, b );
+            }
+        }
+    }
+}
+#endif
+
+void I420_RGB32_AVX2( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
+{
+#ifdef HAVE_AVX2_INTRINSICS
+    struct rgb32_band band = {
+        .p_sys = p_filter->p_sys,
+        .p_src = p_src,
+        .p_dest = p_dest,
+        .i_width = p_filter->fmt_in.video.i_x_offset
+                 + p_filter->fmt_in.video.i_visible_width,
+        .i_height = p_filter->fmt_in.video.i_y_offset
+                  + p_filter->fmt_in.video.i_visible_height,
+    };
+
+    filter_SlicesRun( p_filter->p_sys->p_slices, (band.i_height + 1) / 2,
+                      I420_RGB32_AVX2_Band, &band );
+#else
+    VLC_UNUSED(p_filter); VLC_UNUSED(p_src); VLC_UNUSED(p_dest);
+    vlc_assert_unreachable();
+#endif
+}
+#endif /* SSE2 */
@@ -65,6 +65,11 @@ const char *const ppsz_mode_descriptions[] =
   N_("Area"), N_("Luma bicubic / chroma bilinear"), N_("Gauss"),
   N_("SincR"), N_("Lanczos"), N_("Bicubic spline") };
 
+#define THREADS_TEXT N_("Scaling threads")
+#define THREADS_LONGTEXT N_( \
+    "Number of horizontal slices scaled concurrently, each with its own " \
+    "context (0 for the number of CPUs, 1 to disable)." )
+
 vlc_module_begin ()
     set_description( N_("Video scaling filter") )
     set_shortname( N_("Swscale" ) )
@@ -74,6 +79,7 @@ vlc_module_begin ()
     set_callbacks( OpenScaler, CloseScaler )
     add_integer( "swscale-mode", 2, SCALEMODE_TEXT, SCALEMODE_LONGTEXT, true )
         change_integer_list( pi_mode_values, ppsz_mode_descriptions )
+    add_integer( "swscale-threads", 1, THREADS_TEXT, THREADS_LONGTEXT, true )
 vlc_module_end ()
 
 /* Version checking */
@@ -82,6 +88,24 @@ vlc_module_end ()
  * Local prototypes
  ****************************************************************************/
 
+/**
+ * Horizontal slice of the conversion, scaled with its own context.
+ *
+ * The context scales the slice with margins, so that the rows of the slice
+ * are computed from the same input rows as with a context for the whole
+ * picture. The margins are dropped when copying the output.
+ */
+typedef struct
+{
+    struct SwsContext *ctx;
+    picture_t *p_dst;     /**< output of the context, margins included */
+    unsigned i_src_y;     /**< first input row, top margin included */
+    unsigned i_src_h;     /**< input rows, margins included */
+    unsigned i_dst_y;     /**< first output row of the slice */
+    unsigned i_dst_h;     /**< output rows of the slice */
+    unsigned i_margin;    /**< output rows of the top margin */
+} scaler_slice_t;
+
 /**
  * Internal swscale filter structure.
  */
@@ -89,6 +113,7 @@ struct filter_sys_t
 {
     SwsFilter *p_filter;
     int i_cpu_mask, i_sws_flags;
+    unsigned i_threads;
 
     video_format_t fmt_in;
     video_format_t fmt_out;
@@ -106,6 +131,10 @@ struct filter_sys_t
     bool b_copy;
     bool b_swap_uvi;
     bool b_swap_uvo;
+
+    filter_slices_t *p_slices;
+    scaler_slice_t *p_slice;
+    unsigned i_slices;
 };
 
 static picture_t *Filter( filter_t *, picture_t * );
@@ -180,12 +209,21 @@ static int OpenScaler( vlc_object_t *p_this )
     default: p_sys->i_sws_flags = SWS_BICUBIC; i_sws_mode = 2; break;
     }
 
+    int i_threads = var_InheritInteger( p_filter, "swscale-threads" );
+    if( i_threads <= 0 )
+        i_threads = vlc_GetCPUCount();
+    p_sys->i_threads = i_threads;
+    if( p_sys->i_threads > 1 )
+        p_sys->p_slices = filter_SlicesHold( p_filter );
+
     /* Misc init */
     memset( &p_sys->fmt_in,  0, sizeof(p_sys->fmt_in) );
     memset( &p_sys->fmt_out, 0, sizeof(p_sys->fmt_out) );
 
     if( Init( p_filter ) )
     {
+        if( p_sys->p_slices )
+            filter_SlicesRelease( p_sys->p_slices );
         if( p_sys->p_filter )
             sws_freeFilter( p_sys->p_filter );
         free( p_sys );
@@ -216,6 +254,8 @@ static void CloseScaler( vlc_object_t *p_this )
     filter_sys_t *p_sys = p_filter->p_sys;
 
     Clean( p_filter );
+    if( p_sys->p_slices )
+        filter_SlicesRelease( p_sys->p_slices );
     if( p_sys->p_filter )
         sws_freeFilter( p_sys->p_filter );
     free( p_sys );
@@ -350,6 +390,143 @@ static int GetParameters( ScalerConfiguration *p_cfg,
     return VLC_SUCCESS;
 }
 
+/* Half size of the vertical filters, in input rows at the 1:1 ratio */
+static unsigned GetFilterRadius( int i_sws_flags )
+{
+    if( i_sws_flags & (SWS_BICUBIC | SWS_BICUBLIN) )
+        return 2;
+    if( i_sws_flags & (SWS_X | SWS_GAUSS) )
+        return 4;
+    if( i_sws_flags & SWS_LANCZOS )
+        return 3;
+    if( i_sws_flags & (SWS_SINC | SWS_SPLINE) )
+        return 10;
+    return 1;
+}
+
+static unsigned GetChromaSubsampling( const vlc_chroma_description_t *desc )
+{
+    unsigned i_max = 1;
+    for( unsigned i = 0; i < desc->plane_count; i++ )
+        if( desc->p[i].h.num != 0 && desc->p[i].h.den / desc->p[i].h.num > i_max )
+            i_max = desc->p[i].h.den / desc->p[i].h.num;
+    return i_max;
+}
+
+static void CleanSlices( filter_sys_t *p_sys )
+{
+    for( unsigned i = 0; i < p_sys->i_slices; i++ )
+    {
+        scaler_slice_t *p_slice = &p_sys->p_slice[i];
+        if( p_slice->ctx )
+            sws_freeContext( p_slice->ctx );
+        if( p_slice->p_dst )
+            picture_Release( p_slice->p_dst );
+    }
+    free( p_sys->p_slice );
+    p_sys->p_slice = NULL;
+    p_sys->i_slices = 0;
+}
+
+/* Creates one context per slice. The slices start on rows mapping exactly
+ * between the input and the output, so that the slice contexts use the
+ * filters of the whole picture one. It fails, and the conversion runs on
+ * a single thread, if the geometry does not allow it. */
+static int InitSlices( filter_t *p_filter, const ScalerConfiguration *p_cfg )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const video_format_t *p_fmti = &p_filter->fmt_in.video;
+    const video_format_t *p_fmto = &p_filter->fmt_out.video;
+    const unsigned i_src_h = p_fmti->i_visible_height;
+    const unsigned i_dst_h = p_fmto->i_visible_height;
+
+    if( p_sys->p_slices == NULL || p_cfg->b_copy ||
+        p_sys->i_extend_factor != 1 )
+        return VLC_EGENERIC;
+
+    const unsigned i_sub_in = GetChromaSubsampling( p_sys->desc_in );
+    const unsigned i_sub_out = GetChromaSubsampling( p_sys->desc_out );
+    if( i_src_h % i_sub_in || i_dst_h % i_sub_out )
+        return VLC_EGENERIC;
+
+    /* The vertical steps of the filters must be exact in 16.16 fixed point,
+     * for the luma and the chroma planes */
+    if( ( (uint64_t)i_src_h << 16 ) % i_dst_h ||
+        ( (uint64_t)(i_src_h / i_sub_in) << 16 ) % (i_dst_h / i_sub_out) )
+        return VLC_EGENERIC;
+
+    /* Smallest step of rows starting a slice in both pictures, aligned on
+     * the chroma subsampling and on the output dithering pattern */
+    const unsigned i_gcd = GCD( i_src_h, i_dst_h );
+    const unsigned i_unit_in = i_src_h / i_gcd;
+    const unsigned i_unit_out = i_dst_h / i_gcd;
+    const unsigned i_align_out = i_sub_out * 8 / GCD( i_sub_out, 8 );
+    const unsigned a = i_sub_in / GCD( i_sub_in, i_unit_in );
+    const unsigned b = i_align_out / GCD( i_align_out, i_unit_out );
+    const unsigned k = a * b / GCD( a, b );
+    const unsigned i_step_in = k * i_unit_in;
+    const unsigned i_step_out = k * i_unit_out;
+    const unsigned i_steps = i_dst_h / i_step_out;
+
+    /* Input rows used by the filters around a row, rounded up to steps */
+    const unsigned i_ratio = ( i_src_h + i_dst_h - 1 ) / i_dst_h;
+    const unsigned i_radius = ( GetFilterRadius( p_cfg->i_sws_flags ) + 2 )
+                            * i_ratio * __MAX( i_sub_in, i_sub_out ) + 4;
+    const unsigned i_margin = ( i_radius + i_step_in - 1 ) / i_step_in;
+
+    unsigned i_slices = __MIN( p_sys->i_threads, i_steps );
+    /* Do not spend more on the margins than on the slices */
+    while( i_slices > 1 && i_steps / i_slices < 2 * i_margin )
+        i_slices--;
+    if( i_slices < 2 )
+        return VLC_EGENERIC;
+
+    p_sys->p_slice = calloc( i_slices, sizeof(*p_sys->p_slice) );
+    if( !p_sys->p_slice )
+        return VLC_ENOMEM;
+    p_sys->i_slices = i_slices;
+
+    for( unsigned i = 0; i < i_slices; i++ )
+    {
+        scaler_slice_t *p_slice = &p_sys->p_slice[i];
+        const unsigned i_first = i * i_steps / i_slices;
+        const unsigned i_last = (i + 1) * i_steps / i_slices;
+        const unsigned i_top = i_first > i_margin ? i_first - i_margin : 0;
+
+        unsigned i_src_end = i_src_h, i_ctx_end = i_dst_h;
+        if( i + 1 < i_slices && i_last + i_margin < i_steps )
+        {
+            i_src_end = (i_last + i_margin) * i_step_in;
+            i_ctx_end = (i_last + i_margin) * i_step_out;
+        }
+
+        p_slice->i_src_y = i_top * i_step_in;
+        p_slice->i_src_h = i_src_end - p_slice->i_src_y;
+        p_slice->i_dst_y = i_first * i_step_out;
+        p_slice->i_dst_h = (i + 1 < i_slices ? i_last * i_step_out : i_dst_h)
+                         - p_slice->i_dst_y;
+        p_slice->i_margin = (i_first - i_top) * i_step_out;
+
+        const unsigned i_ctx_h = i_ctx_end - i_top * i_step_out;
+        p_slice->ctx = sws_getContext( p_fmti->i_visible_width, p_slice->i_src_h,
+                                       p_cfg->i_fmti,
+                                       p_fmto->i_visible_width, i_ctx_h,
+                                       p_cfg->i_fmto,
+                                       p_cfg->i_sws_flags | p_sys->i_cpu_mask,
+                                       p_sys->p_filter, NULL, 0 );
+        p_slice->p_dst = picture_New( p_fmto->i_chroma, p_fmto->i_visible_width,
+                                      i_ctx_h, 1, 1 );
+        if( !p_slice->ctx || !p_slice->p_dst )
+        {
+            CleanSlices( p_sys );
+            return VLC_ENOMEM;
+        }
+    }
+
+    msg_Dbg( p_filter, "scaling in %u slices", i_slices );
+    return VLC_SUCCESS;
+}
+
 static int Init( filter_t *p_filter )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
@@ -436,6 +613,9 @@ static int Init( filter_t *p_filter )
         return VLC_EGENERIC;
     }
 
+    if( p_sys->p_slices )
+        InitSlices( p_filter, &cfg );
+
     if (p_filter->b_allow_fmt_out_change)
     {
         /*
@@ -486,6 +666,8 @@ static void Clean( filter_t *p_filter )
     if( p_sys->ctx )
         sws_freeContext( p_sys->ctx );
 
+    CleanSlices( p_sys );
+
     /* We have to set it to null has we call be called again :( */
     p_sys->ctx = NULL;
     p_sys->ctxA = NULL;
@@ -583,7 +765,9 @@ static void SwapUV( picture_t *p_dst, const picture_t *p_src )
 }
 
 static void Convert( filter_t *p_filter, struct SwsContext *ctx,
-                     picture_t *p_dst, picture_t *p_src, int i_height,
+                     picture_t *p_dst, const video_format_t *p_fmto,
+                     picture_t *p_src, const video_format_t *p_fmti,
+                     int i_height,
                      int i_plane_count, bool b_swap_uvi, bool b_swap_uvo )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
@@ -591,7 +775,7 @@ static void Convert( filter_t *p_filter, struct SwsContext *ctx,
     uint8_t *src[4]; int src_stride[4];
     uint8_t *dst[4]; int dst_stride[4];
 
-    GetPixels( src, src_stride, p_sys->desc_in, &p_filter->fmt_in.video,
+    GetPixels( src, src_stride, p_sys->desc_in, p_fmti,
                p_src, i_plane_count, b_swap_uvi );
     if( p_filter->fmt_in.video.i_chroma == VLC_CODEC_RGBP )
     {
@@ -603,7 +787,7 @@ static void Convert( filter_t *p_filter, struct SwsContext *ctx,
         src_stride[1] = 4;
     }
 
-    GetPixels( dst, dst_stride, p_sys->desc_out, &p_filter->fmt_out.video,
+    GetPixels( dst, dst_stride, p_sys->desc_out, p_fmto,
                p_dst, i_plane_count, b_swap_uvo );
 
 #if LIBSWSCALE_VERSION_INT  >= ((0<<16)+(5<<8)+0)
@@ -615,6 +799,57 @@ static void Convert( filter_t *p_filter, struct SwsContext *ctx,
 #endif
 }
 
+typedef struct
+{
+    filter_t  *p_filter;
+    picture_t *p_dst;
+    picture_t *p_src;
+    int       i_plane_count;
+} scaler_job_t;
+
+static void ConvertSlices( void *opaque, unsigned first, unsigned last )
+{
+    scaler_job_t *job = opaque;
+    filter_t *p_filter = job->p_filter;
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    for( unsigned i = first; i < last; i++ )
+    {
+        const scaler_slice_t *p_slice = &p_sys->p_slice[i];
+        video_format_t fmti = p_filter->fmt_in.video;
+        video_format_t fmto = p_filter->fmt_out.video;
+        video_format_t fmts = p_slice->p_dst->format;
+
+        fmti.i_y_offset += p_slice->i_src_y;
+        Convert( p_filter, p_slice->ctx, p_slice->p_dst, &fmts,
+                 job->p_src, &fmti, p_slice->i_src_h, job->i_plane_count,
+                 p_sys->b_swap_uvi, false );
+
+        /* Copy the slice without its margins */
+        uint8_t *src[4]; int src_stride[4];
+        uint8_t *dst[4]; int dst_stride[4];
+
+        fmts.i_y_offset = p_slice->i_margin;
+        fmto.i_y_offset += p_slice->i_dst_y;
+        GetPixels( src, src_stride, p_sys->desc_out, &fmts, p_slice->p_dst,
+                   job->i_plane_count, false );
+        GetPixels( dst, dst_stride, p_sys->desc_out, &fmto, job->p_dst,
+                   job->i_plane_count, p_sys->b_swap_uvo );
+
+        for( unsigned n = 0; n < 4 && dst[n] != NULL; n++ )
+        {
+            const unsigned i_lines = p_slice->i_dst_h
+                                   * p_sys->desc_out->p[n].h.num
+                                   / p_sys->desc_out->p[n].h.den;
+            const size_t i_size = p_slice->p_dst->p[n].i_visible_pitch;
+
+            for( unsigned y = 0; y < i_lines; y++ )
+                memcpy( &dst[n][y * dst_stride[n]],
+                        &src[n][y * src_stride[n]], i_size );
+        }
+    }
+}
+
 /****************************************************************************
  * Filter: the whole thing
  ****************************************************************************
@@ -662,8 +897,21 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
         /* Even if alpha is unused, swscale expects the pointer to be set */
         const int n_planes = !p_sys->ctxA && (p_src->i_planes == 4 ||
                              p_dst->i_planes == 4) ? 4 : 3;
-        Convert( p_filter, p_sys->ctx, p_dst, p_src, p_fmti->i_visible_height,
-                 n_planes, p_sys->b_swap_uvi, p_sys->b_swap_uvo );
+        if( p_sys->i_slices > 0 )
+        {
+            scaler_job_t job = {
+                .p_filter = p_filter,
+                .p_dst = p_dst,
+                .p_src = p_src,
+                .i_plane_count = n_planes,
+            };
+            filter_SlicesRun( p_sys->p_slices, p_sys->i_slices,
+                              ConvertSlices, &job );
+        }
+        else
+            Convert( p_filter, p_sys->ctx, p_dst, p_fmto, p_src, p_fmti,
+                     p_fmti->i_visible_height, n_planes,
+                     p_sys->b_swap_uvi, p_sys->b_swap_uvo );
     }
     if( p_sys->ctxA )
     {
@@ -675,8 +923,9 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
         else
             plane_CopyPixels( p_sys->p_src_a->p, p_src->p+A_PLANE );
 
-        Convert( p_filter, p_sys->ctxA, p_sys->p_dst_a, p_sys->p_src_a,
-                 p_fmti->i_visible_height, 1, false, false );
+        Convert( p_filter, p_sys->ctxA, p_sys->p_dst_a, p_fmto,
+                 p_sys->p_src_a, p_fmti, p_fmti->i_visible_height, 1,
+                 false, false );
         if( p_fmto->i_chroma == VLC_CODEC_RGBA || p_fmto->i_chroma == VLC_CODEC_BGRA )
             InjectA( p_dst, p_sys->p_dst_a, OFFSET_A );
         else if( p_fmto->i_chroma == VLC_CODEC_ARGB )
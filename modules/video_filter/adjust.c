@@ -123,6 +123,7 @@ struct filter_sys_t
                                int, int );
     int (*pf_process_sat_hue_clip)( picture_t *, picture_t *, int, int,
                                     int, int, int );
+    filter_slices_t *slices;
 };
 
 /*****************************************************************************
@@ -144,6 +145,7 @@ static int Create( vlc_object_t *p_this )
     if( p_filter->p_sys == NULL )
         return VLC_ENOMEM;
     p_sys = p_filter->p_sys;
+    p_sys->slices = NULL;
 
     /* Choose Planar/Packed function and pointer to a Hue/Saturation processing
      * function*/
@@ -154,6 +156,7 @@ static int Create( vlc_object_t *p_this )
             p_filter->pf_video_filter = FilterPlanar;
             p_sys->pf_process_sat_hue_clip = planar_sat_hue_clip_C;
             p_sys->pf_process_sat_hue = planar_sat_hue_C;
+            p_sys->slices = filter_SlicesHold( p_filter );
             break;
 
         CASE_PLANAR_YUV10
@@ -162,6 +165,7 @@ static int Create( vlc_object_t *p_this )
             p_filter->pf_video_filter = FilterPlanar;
             p_sys->pf_process_sat_hue_clip = planar_sat_hue_clip_C_16;
             p_sys->pf_process_sat_hue = planar_sat_hue_C_16;
+            p_sys->slices = filter_SlicesHold( p_filter );
             break;
 
         CASE_PACKED_YUV_422
@@ -222,9 +226,150 @@ static void Destroy( vlc_object_t *p_this )
     var_DelCallback( p_filter, "brightness-threshold",
                                              AdjustCallback, p_sys );
 
+    if( p_sys->slices != NULL )
+        filter_SlicesRelease( p_sys->slices );
     free( p_sys );
 }
 
+/*****************************************************************************
+ * Run the planar filter on a band of rows
+ *****************************************************************************/
+struct planar_band
+{
+    filter_sys_t *p_sys;
+    picture_t *p_pic;
+    picture_t *p_outpic;
+    const int *pi_luma;
+    bool b_16bit;
+    int i_sin, i_cos, i_sat, i_x, i_y;
+    bool b_clip;
+};
+
+/* Makes a view of the rows [first, last) out of count, scaled to each plane */
+static void PictureBand( picture_t *p_band, const picture_t *p_pic,
+                         unsigned first, unsigned last, unsigned count )
+{
+    *p_band = *p_pic;
+    for( int i = 0; i < p_pic->i_planes; i++ )
+    {
+        const plane_t *p = &p_pic->p[i];
+        int i_top = (int64_t)first * p->i_visible_lines / count;
+        int i_bottom = (int64_t)last * p->i_visible_lines / count;
+
+        p_band->p[i].p_pixels = p->p_pixels + i_top * p->i_pitch;
+        p_band->p[i].i_lines = p->i_lines - i_top;
+        p_band->p[i].i_visible_lines = i_bottom - i_top;
+    }
+}
+
+static void FilterPlanarBand( void *data, unsigned first, unsigned last )
+{
+    const struct planar_band *band = data;
+    const int *pi_luma = band->pi_luma;
+    unsigned count = band->p_pic->p[U_PLANE].i_visible_lines;
+    picture_t in, out;
+    picture_t *p_in_pic = &in, *p_out_pic = &out;
+
+    PictureBand( p_in_pic, band->p_pic, first, last, count );
+    PictureBand( p_out_pic, band->p_outpic, first, last, count );
+
+    /*
+     * Do the Y plane
+     */
+    if ( band->b_16bit )
+    {
+        uint16_t *p_in, *p_in_end, *p_line_end;
+        uint16_t *p_out;
+        p_in = (uint16_t *) p_in_pic->p[Y_PLANE].p_pixels;
+        p_in_end = p_in + p_in_pic->p[Y_PLANE].i_visible_lines
+            * (p_in_pic->p[Y_PLANE].i_pitch >> 1) - 8;
+
+        p_out = (uint16_t *) p_out_pic->p[Y_PLANE].p_pixels;
+
+        for( ; p_in < p_in_end ; )
+        {
+            p_line_end = p_in + (p_in_pic->p[Y_PLANE].i_visible_pitch >> 1) - 8;
+
+            for( ; p_in < p_line_end ; )
+            {
+                /* Do 8 pixels at a time */
+                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+            }
+
+            p_line_end += 8;
+
+            for( ; p_in < p_line_end ; )
+            {
+                *p_out++ = pi_luma[ *p_in++ ];
+            }
+
+            p_in += (p_in_pic->p[Y_PLANE].i_pitch >> 1)
+                - (p_in_pic->p[Y_PLANE].i_visible_pitch >> 1);
+            p_out += (p_out_pic->p[Y_PLANE].i_pitch >> 1)
+                - (p_out_pic->p[Y_PLANE].i_visible_pitch >> 1);
+        }
+    }
+    else
+    {
+        uint8_t *p_in, *p_in_end, *p_line_end;
+        uint8_t *p_out;
+        p_in = p_in_pic->p[Y_PLANE].p_pixels;
+        p_in_end = p_in + p_in_pic->p[Y_PLANE].i_visible_lines
+                 * p_in_pic->p[Y_PLANE].i_pitch - 8;
+
+        p_out = p_out_pic->p[Y_PLANE].p_pixels;
+
+        for( ; p_in < p_in_end ; )
+        {
+            p_line_end = p_in + p_in_pic->p[Y_PLANE].i_visible_pitch - 8;
+
+            for( ; p_in < p_line_end ; )
+            {
+                /* Do 8 pixels at a time */
+                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+            }
+
+            p_line_end += 8;
+
+            for( ; p_in < p_line_end ; )
+            {
+                *p_out++ = pi_luma[ *p_in++ ];
+            }
+
+            p_in += p_in_pic->p[Y_PLANE].i_pitch
+                  - p_in_pic->p[Y_PLANE].i_visible_pitch;
+            p_out += p_out_pic->p[Y_PLANE].i_pitch
+                   - p_out_pic->p[Y_PLANE].i_visible_pitch;
+        }
+    }
+
+    /*
+     * Do the U and V planes
+     */
+    if ( band->b_clip )
+    {
+        /* Currently no errors are implemented in the function, if any are added
+         * check them here */
+        band->p_sys->pf_process_sat_hue_clip( p_in_pic, p_out_pic, band->i_sin,
+                                              band->i_cos, band->i_sat,
+                                              band->i_x, band->i_y );
+    }
+    else
+    {
+        /* Currently no errors are implemented in the function, if any are added
+         * check them here */
+        band->p_sys->pf_process_sat_hue( p_in_pic, p_out_pic, band->i_sin,
+                                         band->i_cos, band->i_sat,
+                                         band->i_x, band->i_y );
+    }
+}
+
 /*****************************************************************************
  * Run the filter on a Planar YUV picture
  *****************************************************************************/
@@ -317,85 +462,8 @@ static picture_t *FilterPlanar( filter_t *p_filter, picture_t *p_pic )
     }
 
     /*
-     * Do the Y plane
-     */
-    if ( b_16bit )
-    {
-        uint16_t *p_in, *p_in_end, *p_line_end;
-        uint16_t *p_out;
-        p_in = (uint16_t *) p_pic->p[Y_PLANE].p_pixels;
-        p_in_end = p_in + p_pic->p[Y_PLANE].i_visible_lines
-            * (p_pic->p[Y_PLANE].i_pitch >> 1) - 8;
-
-        p_out = (uint16_t *) p_outpic->p[Y_PLANE].p_pixels;
-
-        for( ; p_in < p_in_end ; )
-        {
-            p_line_end = p_in + (p_pic->p[Y_PLANE].i_visible_pitch >> 1) - 8;
-
-            for( ; p_in < p_line_end ; )
-            {
-                /* Do 8 pixels at a time */
-                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-            }
-
-            p_line_end += 8;
-
-            for( ; p_in < p_line_end ; )
-            {
-                *p_out++ = pi_luma[ *p_in++ ];
-            }
-
-            p_in += (p_pic->p[Y_PLANE].i_pitch >> 1)
-                - (p_pic->p[Y_PLANE].i_visible_pitch >> 1);
-            p_out += (p_outpic->p[Y_PLANE].i_pitch >> 1)
-                - (p_outpic->p[Y_PLANE].i_visible_pitch >> 1);
-        }
-    }
-    else
-    {
-        uint8_t *p_in, *p_in_end, *p_line_end;
-        uint8_t *p_out;
-        p_in = p_pic->p[Y_PLANE].p_pixels;
-        p_in_end = p_in + p_pic->p[Y_PLANE].i_visible_lines
-                 * p_pic->p[Y_PLANE].i_pitch - 8;
-
-        p_out = p_outpic->p[Y_PLANE].p_pixels;
-
-        for( ; p_in < p_in_end ; )
-        {
-            p_line_end = p_in + p_pic->p[Y_PLANE].i_visible_pitch - 8;
-
-            for( ; p_in < p_line_end ; )
-            {
-                /* Do 8 pixels at a time */
-                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-            }
-
-            p_line_end += 8;
-
-            for( ; p_in < p_line_end ; )
-            {
-                *p_out++ = pi_luma[ *p_in++ ];
-            }
-
-            p_in += p_pic->p[Y_PLANE].i_pitch
-                  - p_pic->p[Y_PLANE].i_visible_pitch;
-            p_out += p_outpic->p[Y_PLANE].i_pitch
-                   - p_outpic->p[Y_PLANE].i_visible_pitch;
-        }
-    }
-
-    /*
-     * Do the U and V planes
+     * Do the planes, by bands of chroma rows
      */
-
     int i_sin = sinf(f_hue) * f_max;
     int i_cos = cosf(f_hue) * f_max;
 
@@ -403,20 +471,17 @@ static picture_t *FilterPlanar( filter_t *p_filter, picture_t *p_pic )
     int i_x = ( cosf(f_hue) + sinf(f_hue) ) * f_range * i_mid;
     int i_y = ( cosf(f_hue) - sinf(f_hue) ) * f_range * i_mid;
 
-    if ( i_sat > i_range )
-    {
-        /* Currently no errors are implemented in the function, if any are added
-         * check them here */
-        p_sys->pf_process_sat_hue_clip( p_pic, p_outpic, i_sin, i_cos, i_sat,
-                                        i_x, i_y );
-    }
-    else
-    {
-        /* Currently no errors are implemented in the function, if any are added
-         * check them here */
-        p_sys->pf_process_sat_hue( p_pic, p_outpic, i_sin, i_cos, i_sat,
-                                        i_x, i_y );
-    }
+    struct planar_band band = {
+        .p_sys = p_sys,
+        .p_pic = p_pic,
+        .p_outpic = p_outpic,
+        .pi_luma = pi_luma,
+        .b_16bit = b_16bit,
+        .i_sin = i_sin, .i_cos = i_cos, .i_sat = i_sat, .i_x = i_x, .i_y = i_y,
+        .b_clip = i_sat > i_range,
+    };
+    filter_SlicesRun( p_sys->slices, p_pic->p[U_PLANE].i_visible_lines,
+                      FilterPlanarBand, &band );
 
     return CopyInfoAndRelease( p_outpic, p_pic );
 }
@@ -32,17 +32,32 @@
 #include <vlc_plugin.h>
 #include <vlc_filter.h>
 #include <vlc_picture.h>
+#include <vlc_cpu.h>
 #include "filter_picture.h"
 
+#if defined(HAVE_AVX2_INTRINSICS)
+# include <immintrin.h>
+#elif defined(HAVE_SSE2_INTRINSICS)
+# include <emmintrin.h>
+#endif
+#if defined(__ARM_NEON)
+# include <arm_neon.h>
+#endif
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
 static int  Open (vlc_object_t *);
 static void Close(vlc_object_t *);
 
+#define SIMD_TEXT N_("Use SIMD blending")
+#define SIMD_LONGTEXT N_("Use the vectorized routines for the chromas " \
+    "supporting them. Disable to benchmark or check the generic routines.")
+
 vlc_module_begin()
     set_description(N_("Video pictures blending"))
     set_capability("video blending", 100)
+    add_bool("blend-simd", true, SIMD_TEXT, SIMD_LONGTEXT, true)
     set_callbacks(Open, Close)
 vlc_module_end()
 
@@ -79,6 +94,18 @@ public:
     {
         return fmt;
     }
+    const picture_t *getPicture() const
+    {
+        return picture;
+    }
+    unsigned getX() const
+    {
+        return x;
+    }
+    unsigned getY() const
+    {
+        return y;
+    }
     bool isFull(unsigned) const
     {
         return true;
@@ -551,6 +578,263 @@ void Blend(const CPicture &dst_data, const CPicture &src_data,
 typedef void (*blend_function_t)(const CPicture &dst_data, const CPicture &src_data,
                                  unsigned width, unsigned height, int alpha);
 
+/*****************************************************************************
+ * Vectorized routines
+ *****************************************************************************/
+/* Generic tails of the vectorized routines */
+static inline void BlendSamples(uint8_t *dst, const uint8_t *src,
+                                const uint8_t *a, unsigned from, unsigned to,
+                                unsigned step, unsigned alpha)
+{
+    for (unsigned i = from; i < to; i++) {
+        unsigned f = div255(alpha * a[i * step]);
+        if (f > 0)
+            merge(&dst[i], src[i * step], f);
+    }
+}
+
+static inline void BlendSamplesInterleaved(uint8_t *dst, const uint8_t *src0,
+                                           const uint8_t *src1,
+                                           const uint8_t *a, unsigned from,
+                                           unsigned to, unsigned alpha)
+{
+    for (unsigned i = from; i < to; i++) {
+        unsigned f = div255(alpha * a[2 * i]);
+        if (f > 0) {
+            merge(&dst[2 * i + 0], src0[2 * i], f);
+            merge(&dst[2 * i + 1], src1[2 * i], f);
+        }
+    }
+}
+
+static inline void BlendPixelsRGBX(uint8_t *dst, const uint8_t *src,
+                                   unsigned from, unsigned to, unsigned alpha,
+                                   const unsigned offset[3])
+{
+    for (unsigned i = from; i < to; i++) {
+        unsigned f = div255(alpha * src[4 * i + 3]);
+        if (f > 0)
+            for (unsigned c = 0; c < 3; c++)
+                merge(&dst[4 * i + offset[c]], src[4 * i + c], f);
+    }
+}
+
+/* Same as the CPictureRGBX constructor for RGB32 */
+static inline void GetRGB32Offsets(const video_format_t *fmt, unsigned offset[3])
+{
+#ifdef WORDS_BIGENDIAN
+    offset[0] = (32 - fmt->i_lrshift) / 8;
+    offset[1] = (32 - fmt->i_lgshift) / 8;
+    offset[2] = (32 - fmt->i_lbshift) / 8;
+#else
+    offset[0] = fmt->i_lrshift / 8;
+    offset[1] = fmt->i_lgshift / 8;
+    offset[2] = fmt->i_lbshift / 8;
+#endif
+}
+
+#if defined(HAVE_SSE2_INTRINSICS)
+namespace sse2 {
+#define BLEND_TARGET __attribute__((__target__("sse2")))
+struct V {
+    typedef __m128i T;
+    static const unsigned N = 8;
+
+    static inline BLEND_TARGET T set1(unsigned v) { return _mm_set1_epi16(v); }
+    static inline BLEND_TARGET T add(T a, T b) { return _mm_add_epi16(a, b); }
+    static inline BLEND_TARGET T sub(T a, T b) { return _mm_sub_epi16(a, b); }
+    static inline BLEND_TARGET T mul(T a, T b) { return _mm_mullo_epi16(a, b); }
+    static inline BLEND_TARGET T srl8(T a) { return _mm_srli_epi16(a, 8); }
+
+    static inline BLEND_TARGET T load8(const uint8_t *p)
+    {
+        return _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)p),
+                                 _mm_setzero_si128());
+    }
+    static inline BLEND_TARGET T load8even(const uint8_t *p)
+    {
+        return _mm_and_si128(_mm_loadu_si128((const __m128i *)p),
+                             _mm_set1_epi16(0xff));
+    }
+    static inline BLEND_TARGET T load8odd(const uint8_t *p)
+    {
+        return _mm_srli_epi16(_mm_loadu_si128((const __m128i *)p), 8);
+    }
+    static inline BLEND_TARGET void store8(uint8_t *p, T v)
+    {
+        _mm_storel_epi64((__m128i *)p, _mm_packus_epi16(v, v));
+    }
+    static inline BLEND_TARGET void store8x2(uint8_t *p, T even, T odd)
+    {
+        _mm_storeu_si128((__m128i *)p,
+                         _mm_or_si128(even, _mm_slli_epi16(odd, 8)));
+    }
+    static inline BLEND_TARGET void load32(const uint8_t *p, T c[4])
+    {
+        const __m128i x0 = _mm_loadu_si128((const __m128i *)&p[0]);
+        const __m128i x1 = _mm_loadu_si128((const __m128i *)&p[16]);
+        const __m128i m = _mm_set1_epi32(0xff);
+
+        c[0] = _mm_packs_epi32(_mm_and_si128(x0, m), _mm_and_si128(x1, m));
+        c[1] = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(x0, 8), m),
+                               _mm_and_si128(_mm_srli_epi32(x1, 8), m));
+        c[2] = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(x0, 16), m),
+                               _mm_and_si128(_mm_srli_epi32(x1, 16), m));
+        c[3] = _mm_packs_epi32(_mm_srli_epi32(x0, 24), _mm_srli_epi32(x1, 24));
+    }
+    static inline BLEND_TARGET void store32(uint8_t *p, const T c[4])
+    {
+        const __m128i z = _mm_setzero_si128();
+        __m128i lo = _mm_unpacklo_epi16(c[0], z);
+        __m128i hi = _mm_unpackhi_epi16(c[0], z);
+
+        for (unsigned i = 1; i < 4; i++) {
+            lo = _mm_or_si128(lo, _mm_slli_epi32(_mm_unpacklo_epi16(c[i], z), 8 * i));
+            hi = _mm_or_si128(hi, _mm_slli_epi32(_mm_unpackhi_epi16(c[i], z), 8 * i));
+        }
+        _mm_storeu_si128((__m128i *)&p[0], lo);
+        _mm_storeu_si128((__m128i *)&p[16], hi);
+    }
+};
+#include "blend_simd.h"
+#undef BLEND_TARGET
+}
+#endif
+
+#if defined(HAVE_AVX2_INTRINSICS)
+namespace avx2 {
+#define BLEND_TARGET __attribute__((__target__("avx2")))
+struct V {
+    typedef __m256i T;
+    static const unsigned N = 16;
+
+    static inline BLEND_TARGET T set1(unsigned v) { return _mm256_set1_epi16(v); }
+    static inline BLEND_TARGET T add(T a, T b) { return _mm256_add_epi16(a, b); }
+    static inline BLEND_TARGET T sub(T a, T b) { return _mm256_sub_epi16(a, b); }
+    static inline BLEND_TARGET T mul(T a, T b) { return _mm256_mullo_epi16(a, b); }
+    static inline BLEND_TARGET T srl8(T a) { return _mm256_srli_epi16(a, 8); }
+
+    static inline BLEND_TARGET T load8(const uint8_t *p)
+    {
+        return _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)p));
+    }
+    static inline BLEND_TARGET T load8even(const uint8_t *p)
+    {
+        return _mm256_and_si256(_mm256_loadu_si256((const __m256i *)p),
+                                _mm256_set1_epi16(0xff));
+    }
+    static inline BLEND_TARGET T load8odd(const uint8_t *p)
+    {
+        return _mm256_srli_epi16(_mm256_loadu_si256((const __m256i *)p), 8);
+    }
+    static inline BLEND_TARGET void store8(uint8_t *p, T v)
+    {
+        /* The packing is done within each 128-bits lane */
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(v, v),
+                                                  _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_storeu_si128((__m128i *)p, _mm256_castsi256_si128(packed));
+    }
+    static inline BLEND_TARGET void store8x2(uint8_t *p, T even, T odd)
+    {
+        _mm256_storeu_si256((__m256i *)p,
+                            _mm256_or_si256(even, _mm256_slli_epi16(odd, 8)));
+    }
+    /* The pixels are not in order in the lanes (0-3, 8-11, 4-7, 12-15),
+     * which is fine as store32() restores the order. */
+    static inline BLEND_TARGET void load32(const uint8_t *p, T c[4])
+    {
+        const __m256i x0 = _mm256_loadu_si256((const __m256i *)&p[0]);
+        const __m256i x1 = _mm256_loadu_si256((const __m256i *)&p[32]);
+        const __m256i m = _mm256_set1_epi32(0xff);
+
+        c[0] = _mm256_packs_epi32(_mm256_and_si256(x0, m),
+                                  _mm256_and_si256(x1, m));
+        c[1] = _mm256_packs_epi32(_mm256_and_si256(_mm256_srli_epi32(x0, 8), m),
+                                  _mm256_and_si256(_mm256_srli_epi32(x1, 8), m));
+        c[2] = _mm256_packs_epi32(_mm256_and_si256(_mm256_srli_epi32(x0, 16), m),
+                                  _mm256_and_si256(_mm256_srli_epi32(x1, 16), m));
+        c[3] = _mm256_packs_epi32(_mm256_srli_epi32(x0, 24),
+                                  _mm256_srli_epi32(x1, 24));
+    }
+    static inline BLEND_TARGET void store32(uint8_t *p, const T c[4])
+    {
+        const __m256i z = _mm256_setzero_si256();
+        __m256i lo = _mm256_unpacklo_epi16(c[0], z);
+        __m256i hi = _mm256_unpackhi_epi16(c[0], z);
+
+        for (unsigned i = 1; i < 4; i++) {
+            lo = _mm256_or_si256(lo, _mm256_slli_epi32(_mm256_unpacklo_epi16(c[i], z), 8 * i));
+            hi = _mm256_or_si256(hi, _mm256_slli_epi32(_mm256_unpackhi_epi16(c[i], z), 8 * i));
+        }
+        _mm256_storeu_si256((__m256i *)&p[0], lo);
+        _mm256_storeu_si256((__m256i *)&p[32], hi);
+    }
+};
+#include "blend_simd.h"
+#undef BLEND_TARGET
+}
+#endif
+
+#if defined(__ARM_NEON)
+namespace neon {
+#define BLEND_TARGET
+struct V {
+    typedef uint16x8_t T;
+    static const unsigned N = 8;
+
+    static inline T set1(unsigned v) { return vdupq_n_u16(v); }
+    static inline T add(T a, T b) { return vaddq_u16(a, b); }
+    static inline T sub(T a, T b) { return vsubq_u16(a, b); }
+    static inline T mul(T a, T b) { return vmulq_u16(a, b); }
+    static inline T srl8(T a) { return vshrq_n_u16(a, 8); }
+
+    static inline T load8(const uint8_t *p) { return vmovl_u8(vld1_u8(p)); }
+    static inline T load8even(const uint8_t *p) { return vmovl_u8(vld2_u8(p).val[0]); }
+    static inline T load8odd(const uint8_t *p) { return vmovl_u8(vld2_u8(p).val[1]); }
+    static inline void store8(uint8_t *p, T v) { vst1_u8(p, vmovn_u16(v)); }
+    static inline void store8x2(uint8_t *p, T even, T odd)
+    {
+        uint8x8x2_t x = {{ vmovn_u16(even), vmovn_u16(odd) }};
+        vst2_u8(p, x);
+    }
+    static inline void load32(const uint8_t *p, T c[4])
+    {
+        uint8x8x4_t x = vld4_u8(p);
+        for (unsigned i = 0; i < 4; i++)
+            c[i] = vmovl_u8(x.val[i]);
+    }
+    static inline void store32(uint8_t *p, const T c[4])
+    {
+        uint8x8x4_t x;
+        for (unsigned i = 0; i < 4; i++)
+            x.val[i] = vmovn_u16(c[i]);
+        vst4_u8(p, x);
+    }
+};
+#include "blend_simd.h"
+#undef BLEND_TARGET
+}
+#endif
+
+/* Returns the fastest vectorized routine for the combination, if any */
+static blend_function_t GetVectorBlend(vlc_fourcc_t dst, vlc_fourcc_t src)
+{
+    blend_function_t blend = NULL;
+#if defined(__ARM_NEON)
+    blend = neon::GetBlend(dst, src);
+#endif
+#if defined(HAVE_SSE2_INTRINSICS)
+    if (vlc_CPU_SSE2())
+        blend = sse2::GetBlend(dst, src);
+#endif
+#if defined(HAVE_AVX2_INTRINSICS)
+    if (vlc_CPU_AVX2())
+        blend = avx2::GetBlend(dst, src);
+#endif
+    VLC_UNUSED(dst); VLC_UNUSED(src);
+    return blend;
+}
+
 static const struct {
     vlc_fourcc_t     dst;
     vlc_fourcc_t     src;
@@ -671,7 +955,9 @@ static int Open(vlc_object_t *object)
     const vlc_fourcc_t dst = filter->fmt_out.video.i_chroma;
 
     filter_sys_t *sys = new filter_sys_t();
-    for (size_t i = 0; i < sizeof(blends) / sizeof(*blends); i++) {
+    if (var_InheritBool(filter, "blend-simd"))
+        sys->blend = GetVectorBlend(dst, src);
+    for (size_t i = 0; i < sizeof(blends) / sizeof(*blends) && !sys->blend; i++) {
         if (blends[i].src == src && blends[i].dst == dst)
             sys->blend = blends[i].blend;
     }
@@ -0,0 +1,221 @@
+/*****************************************************************************
+ * blend_simd.h: vectorized blending of the most common chroma combinations
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* This file is included once per instruction set by blend.cpp, inside a
+ * namespace providing:
+ *  - BLEND_TARGET, the function attribute enabling the instruction set,
+ *  - V, the vector operations on V::N unsigned 16-bits lanes.
+ * The results are the same as the generic Blend() ones. */
+
+static inline BLEND_TARGET V::T div255v(V::T v)
+{
+    return V::srl8(V::add(V::add(V::srl8(v), v), V::set1(1)));
+}
+
+static inline BLEND_TARGET V::T mergev(V::T dst, V::T src, V::T f)
+{
+    return div255v(V::add(V::mul(V::sub(V::set1(255), f), dst),
+                          V::mul(src, f)));
+}
+
+/* Blends n samples, returns the number of samples processed */
+static inline BLEND_TARGET
+unsigned BlendRow(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                  unsigned n, unsigned alpha)
+{
+    const V::T va = V::set1(alpha);
+    unsigned i = 0;
+
+    for (; i + V::N <= n; i += V::N) {
+        V::T f = div255v(V::mul(va, V::load8(&a[i])));
+        V::store8(&dst[i], mergev(V::load8(&dst[i]), V::load8(&src[i]), f));
+    }
+    return i;
+}
+
+/* Blends n horizontally subsampled samples, reading every other source
+ * sample, returns the number of samples processed */
+static inline BLEND_TARGET
+unsigned BlendRowHalf(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                      unsigned n, unsigned alpha)
+{
+    const V::T va = V::set1(alpha);
+    unsigned i = 0;
+
+    for (; i + V::N <= n; i += V::N) {
+        V::T f = div255v(V::mul(va, V::load8even(&a[2 * i])));
+        V::store8(&dst[i], mergev(V::load8(&dst[i]),
+                                  V::load8even(&src[2 * i]), f));
+    }
+    return i;
+}
+
+/* Same as BlendRowHalf() for interleaved destination samples */
+static inline BLEND_TARGET
+unsigned BlendRowHalfInterleaved(uint8_t *dst, const uint8_t *src0,
+                                 const uint8_t *src1, const uint8_t *a,
+                                 unsigned n, unsigned alpha)
+{
+    const V::T va = V::set1(alpha);
+    unsigned i = 0;
+
+    for (; i + V::N <= n; i += V::N) {
+        V::T f = div255v(V::mul(va, V::load8even(&a[2 * i])));
+        V::T d0 = V::load8even(&dst[2 * i]);
+        V::T d1 = V::load8odd(&dst[2 * i]);
+
+        V::store8x2(&dst[2 * i],
+                    mergev(d0, V::load8even(&src0[2 * i]), f),
+                    mergev(d1, V::load8even(&src1[2 * i]), f));
+    }
+    return i;
+}
+
+/* Blends n RGBA pixels onto 32-bits RGB pixels, returns the number of
+ * pixels processed */
+static inline BLEND_TARGET
+unsigned BlendRowRGBX(uint8_t *dst, const uint8_t *src, unsigned n,
+                      unsigned alpha, const unsigned offset[3])
+{
+    const V::T va = V::set1(alpha);
+    unsigned i = 0;
+
+    for (; i + V::N <= n; i += V::N) {
+        V::T s[4], d[4];
+
+        V::load32(&src[4 * i], s);
+        V::load32(&dst[4 * i], d);
+
+        V::T f = div255v(V::mul(va, s[3]));
+        for (unsigned c = 0; c < 3; c++)
+            d[offset[c]] = mergev(d[offset[c]], s[c], f);
+        V::store32(&dst[4 * i], d);
+    }
+    return i;
+}
+
+template <bool swap_uv>
+static BLEND_TARGET
+void BlendYUVAToI420(const CPicture &dst_data, const CPicture &src_data,
+                     unsigned width, unsigned height, int alpha)
+{
+    const picture_t *dst = dst_data.getPicture();
+    const picture_t *src = src_data.getPicture();
+    const unsigned dx = dst_data.getX(), dy = dst_data.getY();
+    const unsigned sx = src_data.getX(), sy = src_data.getY();
+    /* First source column matching a chroma sample */
+    const unsigned p = dx % 2;
+    const unsigned chroma = (width + 1 - p) / 2;
+
+    for (unsigned y = 0; y < height; y++) {
+        const uint8_t *s[4];
+        for (unsigned i = 0; i < 4; i++)
+            s[i] = &src->p[i].p_pixels[(sy + y) * src->p[i].i_pitch + sx];
+
+        uint8_t *d = &dst->p[0].p_pixels[(dy + y) * dst->p[0].i_pitch + dx];
+        unsigned n = BlendRow(d, s[0], s[3], width, alpha);
+        BlendSamples(d, s[0], s[3], n, width, 1, alpha);
+
+        if ((dy + y) % 2)
+            continue;
+
+        for (unsigned i = 1; i <= 2; i++) {
+            const plane_t *plane = &dst->p[swap_uv ? 3 - i : i];
+            d = &plane->p_pixels[(dy + y) / 2 * plane->i_pitch + (dx + p) / 2];
+            n = BlendRowHalf(d, s[i] + p, s[3] + p, (width - p) / 2, alpha);
+            BlendSamples(d, s[i] + p, s[3] + p, n, chroma, 2, alpha);
+        }
+    }
+}
+
+template <bool swap_uv>
+static BLEND_TARGET
+void BlendYUVAToNV12(const CPicture &dst_data, const CPicture &src_data,
+                     unsigned width, unsigned height, int alpha)
+{
+    const picture_t *dst = dst_data.getPicture();
+    const picture_t *src = src_data.getPicture();
+    const unsigned dx = dst_data.getX(), dy = dst_data.getY();
+    const unsigned sx = src_data.getX(), sy = src_data.getY();
+    const unsigned p = dx % 2;
+    const unsigned chroma = (width + 1 - p) / 2;
+
+    for (unsigned y = 0; y < height; y++) {
+        const uint8_t *s[4];
+        for (unsigned i = 0; i < 4; i++)
+            s[i] = &src->p[i].p_pixels[(sy + y) * src->p[i].i_pitch + sx];
+
+        uint8_t *d = &dst->p[0].p_pixels[(dy + y) * dst->p[0].i_pitch + dx];
+        unsigned n = BlendRow(d, s[0], s[3], width, alpha);
+        BlendSamples(d, s[0], s[3], n, width, 1, alpha);
+
+        if ((dy + y) % 2)
+            continue;
+
+        const uint8_t *s0 = (swap_uv ? s[2] : s[1]) + p;
+        const uint8_t *s1 = (swap_uv ? s[1] : s[2]) + p;
+        d = &dst->p[1].p_pixels[(dy + y) / 2 * dst->p[1].i_pitch + dx + p];
+        n = BlendRowHalfInterleaved(d, s0, s1, s[3] + p, (width - p) / 2,
+                                    alpha);
+        BlendSamplesInterleaved(d, s0, s1, s[3] + p, n, chroma, alpha);
+    }
+}
+
+static BLEND_TARGET
+void BlendRGBAToRGB32(const CPicture &dst_data, const CPicture &src_data,
+                      unsigned width, unsigned height, int alpha)
+{
+    const picture_t *dst = dst_data.getPicture();
+    const picture_t *src = src_data.getPicture();
+    const unsigned dx = dst_data.getX(), dy = dst_data.getY();
+    const unsigned sx = src_data.getX(), sy = src_data.getY();
+    unsigned offset[3];
+
+    GetRGB32Offsets(dst_data.getFormat(), offset);
+
+    for (unsigned y = 0; y < height; y++) {
+        const uint8_t *s = &src->p[0].p_pixels[(sy + y) * src->p[0].i_pitch
+                                               + 4 * sx];
+        uint8_t *d = &dst->p[0].p_pixels[(dy + y) * dst->p[0].i_pitch
+                                         + 4 * dx];
+        unsigned n = BlendRowRGBX(d, s, width, alpha, offset);
+        BlendPixelsRGBX(d, s, n, width, alpha, offset);
+    }
+}
+
+static blend_function_t GetBlend(vlc_fourcc_t dst, vlc_fourcc_t src)
+{
+    if (src == VLC_CODEC_YUVA) {
+        switch (dst) {
+            case VLC_CODEC_I420:
+            case VLC_CODEC_J420:
+                return BlendYUVAToI420<false>;
+            case VLC_CODEC_YV12:
+                return BlendYUVAToI420<true>;
+            case VLC_CODEC_NV12:
+                return BlendYUVAToNV12<false>;
+            case VLC_CODEC_NV21:
+                return BlendYUVAToNV12<true>;
+        }
+    }
+    if (src == VLC_CODEC_RGBA && dst == VLC_CODEC_RGB32)
+        return BlendRGBAToRGB32;
+    return NULL;
+}
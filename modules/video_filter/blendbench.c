@@ -60,7 +60,13 @@ static picture_t *Filter( filter_t *, picture_t * );
 #define BASE_IMAGE_LONGTEXT N_("The image which will be used to blend onto")
 
 #define BASE_CHROMA_TEXT N_("Chroma for the base image")
-#define BASE_CHROMA_LONGTEXT N_("Chroma which the base image will be loaded in")
+#define BASE_CHROMA_LONGTEXT N_("Chroma which the base image will be loaded " \
+                                "in. Several comma separated chromas can be " \
+                                "given to benchmark each of them")
+
+#define CHECK_TEXT N_("Check the blending")
+#define CHECK_LONGTEXT N_("Compare the result of the blending with the one " \
+                          "of the generic routines")
 
 #define BLEND_IMAGE_TEXT N_("Image which will be blended")
 #define BLEND_IMAGE_LONGTEXT N_("The image blended onto the base image")
@@ -83,6 +89,7 @@ vlc_module_begin ()
               LOOPS_LONGTEXT, false )
     add_integer_with_range( CFG_PREFIX "alpha", 128, 0, 255, ALPHA_TEXT,
               ALPHA_LONGTEXT, false )
+    add_bool( CFG_PREFIX "check", true, CHECK_TEXT, CHECK_LONGTEXT, false )
 
     set_section( N_("Base image"), NULL )
     add_loadfile( CFG_PREFIX "base-image", NULL, BASE_IMAGE_TEXT,
@@ -100,22 +107,25 @@ vlc_module_begin ()
 vlc_module_end ()
 
 static const char *const ppsz_filter_options[] = {
-    "loops", "alpha", "base-image", "base-chroma", "blend-image",
+    "loops", "alpha", "check", "base-image", "base-chroma", "blend-image",
     "blend-chroma", NULL
 };
 
 /*****************************************************************************
  * filter_sys_t: filter method descriptor
  *****************************************************************************/
+#define MAX_BASE_CHROMAS 16
+
 struct filter_sys_t
 {
     bool b_done;
+    bool b_check;
     int i_loops, i_alpha;
 
-    picture_t *p_base_image;
+    unsigned i_base_images;
+    picture_t *pp_base_images[MAX_BASE_CHROMAS];
     picture_t *p_blend_image;
 
-    vlc_fourcc_t i_base_chroma;
     vlc_fourcc_t i_blend_chroma;
 };
 
@@ -163,6 +173,7 @@ static int Create( vlc_object_t *p_this )
 
     p_sys = p_filter->p_sys;
     p_sys->b_done = false;
+    p_sys->i_base_images = 0;
 
     p_filter->pf_video_filter = Filter;
 
@@ -175,19 +186,37 @@ static int Create( vlc_object_t *p_this )
                                                   CFG_PREFIX "loops" );
     p_sys->i_alpha = var_CreateGetIntegerCommand( p_filter,
                                                   CFG_PREFIX "alpha" );
+    p_sys->b_check = var_CreateGetBoolCommand( p_filter, CFG_PREFIX "check" );
 
     psz_temp = var_CreateGetStringCommand( p_filter, CFG_PREFIX "base-chroma" );
-    p_sys->i_base_chroma = !psz_temp || strlen( psz_temp ) != 4 ? 0 :
-        VLC_FOURCC( psz_temp[0], psz_temp[1], psz_temp[2], psz_temp[3] );
     psz_cmd = var_CreateGetStringCommand( p_filter, CFG_PREFIX "base-image" );
-    i_ret = blendbench_LoadImage( p_this, &p_sys->p_base_image,
-                                  p_sys->i_base_chroma, psz_cmd, "Base" );
+    i_ret = VLC_SUCCESS;
+    for( char *psz_chroma = psz_temp, *psz_next;
+         psz_chroma != NULL && i_ret == VLC_SUCCESS
+         && p_sys->i_base_images < MAX_BASE_CHROMAS;
+         psz_chroma = psz_next )
+    {
+        psz_next = strchr( psz_chroma, ',' );
+        if( psz_next != NULL )
+            *psz_next++ = '\0';
+
+        vlc_fourcc_t i_chroma = strlen( psz_chroma ) != 4 ? 0 :
+            VLC_FOURCC( psz_chroma[0], psz_chroma[1], psz_chroma[2],
+                        psz_chroma[3] );
+        i_ret = blendbench_LoadImage( p_this,
+                                      &p_sys->pp_base_images[p_sys->i_base_images],
+                                      i_chroma, psz_cmd, "Base" );
+        if( i_ret == VLC_SUCCESS )
+            p_sys->i_base_images++;
+    }
     free( psz_temp );
     free( psz_cmd );
-    if( i_ret != VLC_SUCCESS )
+    if( i_ret != VLC_SUCCESS || p_sys->i_base_images == 0 )
     {
+        for( unsigned i = 0; i < p_sys->i_base_images; i++ )
+            picture_Release( p_sys->pp_base_images[i] );
         free( p_sys );
-        return i_ret;
+        return VLC_EGENERIC;
     }
 
     psz_temp = var_CreateGetStringCommand( p_filter,
@@ -203,7 +232,8 @@ static int Create( vlc_object_t *p_this )
 
     if( i_ret != VLC_SUCCESS )
     {
-        picture_Release( p_sys->p_base_image );
+        for( unsigned i = 0; i < p_sys->i_base_images; i++ )
+            picture_Release( p_sys->pp_base_images[i] );
         free( p_sys );
 
         return VLC_EGENERIC;
@@ -220,47 +250,111 @@ static void Destroy( vlc_object_t *p_this )
     filter_t *p_filter = (filter_t *)p_this;
     filter_sys_t *p_sys = p_filter->p_sys;
 
-    picture_Release( p_sys->p_base_image );
+    for( unsigned i = 0; i < p_sys->i_base_images; i++ )
+        picture_Release( p_sys->pp_base_images[i] );
     picture_Release( p_sys->p_blend_image );
 }
 
-/*****************************************************************************
- * Render: displays previously rendered output
- *****************************************************************************/
-static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+static filter_t *blendbench_Create( filter_t *p_filter, picture_t *p_base,
+                                    bool b_simd )
 {
-    filter_sys_t *p_sys = p_filter->p_sys;
-    filter_t *p_blend;
-
-    if( p_sys->b_done )
-        return p_pic;
-
-    p_blend = vlc_object_create( p_filter, sizeof(filter_t) );
+    filter_t *p_blend = vlc_object_create( p_filter, sizeof(filter_t) );
     if( !p_blend )
-    {
-        picture_Release( p_pic );
         return NULL;
-    }
-    p_blend->fmt_out.video = p_sys->p_base_image->format;
-    p_blend->fmt_in.video = p_sys->p_blend_image->format;
+
+    /* Overrides the option for this blending filter only */
+    var_Create( p_blend, "blend-simd", VLC_VAR_BOOL );
+    var_SetBool( p_blend, "blend-simd", b_simd );
+
+    p_blend->fmt_out.video = p_base->format;
+    p_blend->fmt_in.video = p_filter->p_sys->p_blend_image->format;
     p_blend->p_module = module_need( p_blend, "video blending", NULL, false );
     if( !p_blend->p_module )
     {
-        picture_Release( p_pic );
         vlc_object_release( p_blend );
         return NULL;
     }
+    return p_blend;
+}
+
+static void blendbench_Delete( filter_t *p_blend )
+{
+    module_unneed( p_blend, p_blend->p_module );
+    vlc_object_release( p_blend );
+}
+
+/* Blends with the default and the generic routines and compares the results */
+static void blendbench_Check( filter_t *p_filter, filter_t *p_blend,
+                              picture_t *p_base )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    filter_t *p_generic = blendbench_Create( p_filter, p_base, false );
+    picture_t *p_ref = picture_NewFromFormat( &p_base->format );
+    picture_t *p_test = picture_NewFromFormat( &p_base->format );
+
+    if( !p_generic || !p_ref || !p_test )
+        goto end;
+
+    picture_Copy( p_ref, p_base );
+    picture_Copy( p_test, p_base );
+    p_generic->pf_video_blend( p_generic, p_ref, p_sys->p_blend_image,
+                               0, 0, p_sys->i_alpha );
+    p_blend->pf_video_blend( p_blend, p_test, p_sys->p_blend_image,
+                             0, 0, p_sys->i_alpha );
+
+    unsigned i_mismatches = 0;
+    for( int i = 0; i < p_ref->i_planes; i++ )
+    {
+        const plane_t *p_r = &p_ref->p[i], *p_t = &p_test->p[i];
+
+        for( int y = 0; y < p_r->i_visible_lines; y++ )
+            if( memcmp( &p_r->p_pixels[y * p_r->i_pitch],
+                        &p_t->p_pixels[y * p_t->i_pitch],
+                        p_r->i_visible_pitch ) )
+                i_mismatches++;
+    }
+
+    if( i_mismatches > 0 )
+        msg_Err( p_filter, "%u lines differ from the generic blending",
+                 i_mismatches );
+    else
+        msg_Info( p_filter, "Blending matches the generic one" );
+end:
+    if( p_test )
+        picture_Release( p_test );
+    if( p_ref )
+        picture_Release( p_ref );
+    if( p_generic )
+        blendbench_Delete( p_generic );
+}
+
+static void blendbench_Run( filter_t *p_filter, picture_t *p_base )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    filter_t *p_blend = blendbench_Create( p_filter, p_base, true );
+
+    if( !p_blend )
+    {
+        msg_Err( p_filter, "Cannot blend %4.4s onto %4.4s",
+                 (const char *)&p_sys->i_blend_chroma,
+                 (const char *)&p_base->format.i_chroma );
+        return;
+    }
 
     mtime_t time = mdate();
     for( int i_iter = 0; i_iter < p_sys->i_loops; ++i_iter )
     {
         p_blend->pf_video_blend( p_blend,
-                                 p_sys->p_base_image, p_sys->p_blend_image,
+                                 p_base, p_sys->p_blend_image,
                                  0, 0, p_sys->i_alpha );
     }
     time = mdate() - time;
+    if( time <= 0 )
+        time = 1;
 
-    msg_Info( p_filter, "Blended %d images in %f sec", p_sys->i_loops,
+    msg_Info( p_filter, "%4.4s onto %4.4s: blended %d images in %f sec",
+              (const char *)&p_sys->i_blend_chroma,
+              (const char *)&p_base->format.i_chroma, p_sys->i_loops,
               time / 1000000.0f );
     msg_Info( p_filter, "Speed is: %f images/second, %f pixels/second",
               (float) p_sys->i_loops / time * 1000000,
@@ -268,9 +362,24 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
                   p_sys->p_blend_image->p[Y_PLANE].i_visible_pitch *
                   p_sys->p_blend_image->p[Y_PLANE].i_visible_lines );
 
-    module_unneed( p_blend, p_blend->p_module );
+    if( p_sys->b_check )
+        blendbench_Check( p_filter, p_blend, p_base );
 
-    vlc_object_release( p_blend );
+    blendbench_Delete( p_blend );
+}
+
+/*****************************************************************************
+ * Render: displays previously rendered output
+ *****************************************************************************/
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( p_sys->b_done )
+        return p_pic;
+
+    for( unsigned i = 0; i < p_sys->i_base_images; i++ )
+        blendbench_Run( p_filter, p_sys->pp_base_images[i] );
 
     p_sys->b_done = true;
     return p_pic;
@@ -47,6 +47,62 @@
    Necessary preprocessor macros are defined in common.h. */
 #include "yadif.h"
 
+struct yadif_band
+{
+    const plane_t *prevp, *curp, *nextp;
+    plane_t *dstp;
+    void (*filter)(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8_t *next,
+                   int w, int prefs, int mrefs, int parity, int mode);
+    int i_field;
+    int parity;
+};
+
+/* Filters the rows [1 + first, 1 + last) of a plane */
+static void RenderYadifBand( void *data, unsigned first, unsigned last )
+{
+    const struct yadif_band *band = data;
+    const plane_t *prevp = band->prevp;
+    const plane_t *curp  = band->curp;
+    const plane_t *nextp = band->nextp;
+    plane_t *dstp        = band->dstp;
+
+    for( int y = 1 + first; y < 1 + (int)last; y++ )
+    {
+        if( (y % 2) == band->i_field  ||  band->parity == 2 )
+        {
+            memcpy( &dstp->p_pixels[y * dstp->i_pitch],
+                        &curp->p_pixels[y * curp->i_pitch], dstp->i_visible_pitch );
+        }
+        else
+        {
+            int mode;
+            /* Spatial checks only when enough data */
+            mode = (y >= 2 && y < dstp->i_visible_lines - 2) ? 0 : 2;
+
+            assert( prevp->i_pitch == curp->i_pitch && curp->i_pitch == nextp->i_pitch );
+            band->filter( &dstp->p_pixels[y * dstp->i_pitch],
+                          &prevp->p_pixels[y * prevp->i_pitch],
+                          &curp->p_pixels[y * curp->i_pitch],
+                          &nextp->p_pixels[y * nextp->i_pitch],
+                          dstp->i_visible_pitch,
+                          y < dstp->i_visible_lines - 2  ? curp->i_pitch : -curp->i_pitch,
+                          y  - 1  ?  -curp->i_pitch : curp->i_pitch,
+                          band->parity,
+                          mode );
+        }
+
+        /* We duplicate the first and last lines */
+        if( y == 1 )
+            memcpy(&dstp->p_pixels[(y-1) * dstp->i_pitch],
+                       &dstp->p_pixels[ y    * dstp->i_pitch],
+                       dstp->i_pitch);
+        else if( y == dstp->i_visible_lines - 2 )
+            memcpy(&dstp->p_pixels[(y+1) * dstp->i_pitch],
+                       &dstp->p_pixels[ y    * dstp->i_pitch],
+                       dstp->i_pitch);
+    }
+}
+
 int RenderYadifSingle( filter_t *p_filter, picture_t *p_dst, picture_t *p_src )
 {
     return RenderYadif( p_filter, p_dst, p_src, 0, 0 );
@@ -113,6 +169,11 @@ int RenderYadif( filter_t *p_filter, picture_t *p_dst, picture_t *p_src,
         void (*filter)(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8_t *next,
                        int w, int prefs, int mrefs, int parity, int mode);
 
+#if defined(HAVE_YADIF_AVX2)
+        if( vlc_CPU_AVX2() )
+            filter = yadif_filter_line_avx2;
+        else
+#endif
 #if defined(HAVE_YADIF_SSSE3)
         if( vlc_CPU_SSSE3() )
             filter = yadif_filter_line_ssse3;
@@ -135,46 +196,20 @@ int RenderYadif( filter_t *p_filter, picture_t *p_dst, picture_t *p_src,
 
         for( int n = 0; n < p_dst->i_planes; n++ )
         {
-            const plane_t *prevp = &p_prev->p[n];
-            const plane_t *curp  = &p_cur->p[n];
-            const plane_t *nextp = &p_next->p[n];
-            plane_t *dstp        = &p_dst->p[n];
-
-            for( int y = 1; y < dstp->i_visible_lines - 1; y++ )
-            {
-                if( (y % 2) == i_field  ||  yadif_parity == 2 )
-                {
-                    memcpy( &dstp->p_pixels[y * dstp->i_pitch],
-                                &curp->p_pixels[y * curp->i_pitch], dstp->i_visible_pitch );
-                }
-                else
-                {
-                    int mode;
-                    /* Spatial checks only when enough data */
-                    mode = (y >= 2 && y < dstp->i_visible_lines - 2) ? 0 : 2;
-
-                    assert( prevp->i_pitch == curp->i_pitch && curp->i_pitch == nextp->i_pitch );
-                    filter( &dstp->p_pixels[y * dstp->i_pitch],
-                            &prevp->p_pixels[y * prevp->i_pitch],
-                            &curp->p_pixels[y * curp->i_pitch],
-                            &nextp->p_pixels[y * nextp->i_pitch],
-                            dstp->i_visible_pitch,
-                            y < dstp->i_visible_lines - 2  ? curp->i_pitch : -curp->i_pitch,
-                            y  - 1  ?  -curp->i_pitch : curp->i_pitch,
-                            yadif_parity,
-                            mode );
-                }
-
-                /* We duplicate the first and last lines */
-                if( y == 1 )
-                    memcpy(&dstp->p_pixels[(y-1) * dstp->i_pitch],
-                               &dstp->p_pixels[ y    * dstp->i_pitch],
-                               dstp->i_pitch);
-                else if( y == dstp->i_visible_lines - 2 )
-                    memcpy(&dstp->p_pixels[(y+1) * dstp->i_pitch],
-                               &dstp->p_pixels[ y    * dstp->i_pitch],
-                               dstp->i_pitch);
-            }
+            struct yadif_band band = {
+                .prevp = &p_prev->p[n],
+                .curp = &p_cur->p[n],
+                .nextp = &p_next->p[n],
+                .dstp = &p_dst->p[n],
+                .filter = filter,
+                .i_field = i_field,
+                .parity = yadif_parity,
+            };
+
+            if( band.dstp->i_visible_lines > 2 )
+                filter_SlicesRun( p_sys->slices,
+                                  band.dstp->i_visible_lines - 2,
+                                  RenderYadifBand, &band );
         }
 
         p_sys->context.i_frame_offset = 1; /* p_cur will be rendered at next frame, too */
@@ -519,6 +519,7 @@ notsupp:
         return VLC_ENOMEM;
 
     p_sys->chroma = chroma;
+    p_sys->slices = filter_SlicesHold( p_filter );
 
     InitDeinterlacingContext( &p_sys->context );
 
@@ -650,5 +651,7 @@ void Close( vlc_object_t *p_this )
     filter_t *p_filter = (filter_t*)p_this;
 
     Flush( p_filter );
+    if( p_filter->p_sys->slices != NULL )
+        filter_SlicesRelease( p_filter->p_sys->slices );
     free( p_filter->p_sys );
 }
@@ -147,3 +147,94 @@ static void yadif_filter_line_c_16bit(uint16_t *dst, uint16_t *prev, uint16_t *c
     prefs /= 2;
     FILTER
 }
+
+#ifdef HAVE_AVX2_INTRINSICS
+// ================= AVX2 =================
+#include <immintrin.h>
+#define HAVE_YADIF_AVX2
+
+#define LOAD(p) _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(p)))
+#define ABSDIFF(a,b) _mm256_abs_epi16(_mm256_sub_epi16(a, b))
+#define AVG(a,b) _mm256_srli_epi16(_mm256_add_epi16(a, b), 1)
+
+/* Same as the FILTER macro, on 16 pixels at once, with the nested spatial
+ * checks turned into masks */
+VLC_AVX2
+static void yadif_filter_line_avx2(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8_t *next, int w, int prefs, int mrefs, int parity, int mode) {
+    uint8_t *prev2= parity ? prev : cur ;
+    uint8_t *next2= parity ? cur  : next;
+    const __m256i one = _mm256_set1_epi16(1);
+    int x;
+
+    for (x = 0; x + 16 <= w; x += 16) {
+        __m256i c = LOAD(&cur[x+mrefs]);
+        __m256i e = LOAD(&cur[x+prefs]);
+        __m256i p2 = LOAD(&prev2[x]);
+        __m256i n2 = LOAD(&next2[x]);
+        __m256i d = AVG(p2, n2);
+        __m256i temporal_diff0 = ABSDIFF(p2, n2);
+        __m256i temporal_diff1 = _mm256_srli_epi16(
+            _mm256_add_epi16(ABSDIFF(LOAD(&prev[x+mrefs]), c),
+                             ABSDIFF(LOAD(&prev[x+prefs]), e)), 1);
+        __m256i temporal_diff2 = _mm256_srli_epi16(
+            _mm256_add_epi16(ABSDIFF(LOAD(&next[x+mrefs]), c),
+                             ABSDIFF(LOAD(&next[x+prefs]), e)), 1);
+        __m256i diff = _mm256_max_epi16(
+            _mm256_max_epi16(_mm256_srli_epi16(temporal_diff0, 1),
+                             temporal_diff1), temporal_diff2);
+        __m256i spatial_pred = AVG(c, e);
+        __m256i spatial_score = _mm256_sub_epi16(_mm256_add_epi16(
+            _mm256_add_epi16(ABSDIFF(LOAD(&cur[x+mrefs-1]), LOAD(&cur[x+prefs-1])),
+                             ABSDIFF(c, e)),
+            ABSDIFF(LOAD(&cur[x+mrefs+1]), LOAD(&cur[x+prefs+1]))), one);
+
+        /* The second check of each direction only applies where the
+         * first one succeeded */
+        for (int j = -1; j <= 1; j += 2) {
+            __m256i valid = _mm256_set1_epi16(-1);
+            for (int k = j; k == j || k == 2*j; k += j) {
+                __m256i score = _mm256_add_epi16(_mm256_add_epi16(
+                    ABSDIFF(LOAD(&cur[x+mrefs-1+k]), LOAD(&cur[x+prefs-1-k])),
+                    ABSDIFF(LOAD(&cur[x+mrefs  +k]), LOAD(&cur[x+prefs  -k]))),
+                    ABSDIFF(LOAD(&cur[x+mrefs+1+k]), LOAD(&cur[x+prefs+1-k])));
+                valid = _mm256_and_si256(valid,
+                                         _mm256_cmpgt_epi16(spatial_score, score));
+                spatial_score = _mm256_blendv_epi8(spatial_score, score, valid);
+                spatial_pred = _mm256_blendv_epi8(spatial_pred,
+                    AVG(LOAD(&cur[x+mrefs+k]), LOAD(&cur[x+prefs-k])), valid);
+            }
+        }
+
+        if (mode < 2) {
+            __m256i b = AVG(LOAD(&prev2[x+2*mrefs]), LOAD(&next2[x+2*mrefs]));
+            __m256i f = AVG(LOAD(&prev2[x+2*prefs]), LOAD(&next2[x+2*prefs]));
+            __m256i de = _mm256_sub_epi16(d, e);
+            __m256i dc = _mm256_sub_epi16(d, c);
+            __m256i bc = _mm256_sub_epi16(b, c);
+            __m256i fe = _mm256_sub_epi16(f, e);
+            __m256i max = _mm256_max_epi16(_mm256_max_epi16(de, dc),
+                                           _mm256_min_epi16(bc, fe));
+            __m256i min = _mm256_min_epi16(_mm256_min_epi16(de, dc),
+                                           _mm256_max_epi16(bc, fe));
+
+            diff = _mm256_max_epi16(_mm256_max_epi16(diff, min),
+                                    _mm256_sub_epi16(_mm256_setzero_si256(), max));
+        }
+
+        spatial_pred = _mm256_min_epi16(_mm256_max_epi16(spatial_pred,
+                                            _mm256_sub_epi16(d, diff)),
+                                        _mm256_add_epi16(d, diff));
+
+        __m256i packed = _mm256_packus_epi16(spatial_pred, spatial_pred);
+        packed = _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_storeu_si128((__m128i *)&dst[x], _mm256_castsi256_si128(packed));
+    }
+
+    if (x < w)
+        yadif_filter_line_c(&dst[x], &prev[x], &cur[x], &next[x], w - x,
+                            prefs, mrefs, parity, mode);
+}
+#undef AVG
+#undef ABSDIFF
+#undef LOAD
+#endif
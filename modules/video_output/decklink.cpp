@@ -43,8 +43,11 @@
 #include <vlc_block.h>
 #include <vlc_image.h>
 #include <vlc_aout.h>
+#include <vlc_atomic.h>
 #include <arpa/inet.h>
 
+#include <vector>
+
 #include <DeckLinkAPI.h>
 #include <DeckLinkAPIDispatch.cpp>
 
@@ -176,6 +179,87 @@ static const char * const rgsz_ar_text[] = {
 };
 static_assert(ARRAY_SIZE(rgi_ar_values) == ARRAY_SIZE(rgsz_ar_text), "afd arrays messed up");
 
+/* The frames are recycled once the card is done with them, rather than
+ * allocated for each picture. This also tells about the late and dropped
+ * frames. */
+class DeckLinkFramePool : public IDeckLinkVideoOutputCallback
+{
+public:
+    DeckLinkFramePool() : late(0), dropped(0), m_ref_(1)
+    {
+        vlc_mutex_init(&lock);
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID, LPVOID *) { return E_NOINTERFACE; }
+
+    virtual ULONG STDMETHODCALLTYPE AddRef(void)
+    {
+        return ++m_ref_;
+    }
+
+    virtual ULONG STDMETHODCALLTYPE Release(void)
+    {
+        unsigned new_ref = --m_ref_;
+        if (new_ref == 0)
+            delete this;
+        return new_ref;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE ScheduledFrameCompleted(IDeckLinkVideoFrame *frame,
+                                                              BMDOutputFrameCompletionResult result)
+    {
+        if (result == bmdOutputFrameDisplayedLate)
+            late++;
+        else if (result == bmdOutputFrameDropped)
+            dropped++;
+
+        /* Only our own frames are scheduled */
+        Put(static_cast<IDeckLinkMutableVideoFrame *>(frame));
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE ScheduledPlaybackHasStopped(void)
+    {
+        return S_OK;
+    }
+
+    /* Returns a free frame with its reference, or NULL */
+    IDeckLinkMutableVideoFrame *Get(void)
+    {
+        IDeckLinkMutableVideoFrame *frame = NULL;
+
+        vlc_mutex_lock(&lock);
+        if (!frames.empty()) {
+            frame = frames.back();
+            frames.pop_back();
+        }
+        vlc_mutex_unlock(&lock);
+        return frame;
+    }
+
+    void Put(IDeckLinkMutableVideoFrame *frame)
+    {
+        vlc_mutex_lock(&lock);
+        frames.push_back(frame);
+        vlc_mutex_unlock(&lock);
+    }
+
+    std::atomic_uint late;
+    std::atomic_uint dropped;
+
+private:
+    virtual ~DeckLinkFramePool()
+    {
+        for (size_t i = 0; i < frames.size(); i++)
+            frames[i]->Release();
+        vlc_mutex_destroy(&lock);
+    }
+
+    std::atomic_uint m_ref_;
+    vlc_mutex_t lock;
+    std::vector<IDeckLinkMutableVideoFrame *> frames;
+};
+
 /* Only one audio output module and one video output module
  * can be used per process.
  * We use a static mutex in audio/video submodules entry points.  */
@@ -211,6 +295,7 @@ typedef struct decklink_sys_t
     {
         video_format_t currentfmt;
         picture_pool_t *pool;
+        DeckLinkFramePool *frames;
         bool tenbits;
         uint8_t afd, ar;
         int nosignal_delay;
@@ -315,6 +400,7 @@ static decklink_sys_t *HoldDLSys(vlc_object_t *obj, int i_cat)
             sys->users = 1;
             sys->b_videomodule = (i_cat == VIDEO_ES);
             sys->b_recycling = false;
+            sys->video.frames = NULL;
             sys->i_rate = var_InheritInteger(obj, AUDIO_CFG_PREFIX "audio-rate");
             if(sys->i_rate > 0)
                 sys->i_rate = -1;
@@ -346,9 +432,19 @@ static void ReleaseDLSys(vlc_object_t *obj, int i_cat)
             sys->p_output->StopScheduledPlayback(0, NULL, 0);
             sys->p_output->DisableVideoOutput();
             sys->p_output->DisableAudioOutput();
+            sys->p_output->SetScheduledFrameCompletionCallback(NULL);
             sys->p_output->Release();
         }
 
+        if (sys->video.frames) {
+            unsigned late = sys->video.frames->late;
+            unsigned dropped = sys->video.frames->dropped;
+            if (late > 0 || dropped > 0)
+                msg_Warn(obj, "%u frame(s) displayed late, %u dropped",
+                         late, dropped);
+            sys->video.frames->Release();
+        }
+
         /* Clean video specific */
         if (sys->video.pool)
             picture_pool_Release(sys->video.pool);
@@ -697,6 +793,10 @@ static int OpenDecklink(vout_display_t *vd, decklink_sys_t *sys)
         result = sys->p_output->EnableVideoOutput(mode_id, flags);
         CHECK("Could not enable video output");
 
+        sys->video.frames = new DeckLinkFramePool();
+        result = sys->p_output->SetScheduledFrameCompletionCallback(sys->video.frames);
+        CHECK("Could not set the frame completion callback");
+
         video_format_t *fmt = &sys->video.currentfmt;
         video_format_Copy(fmt, &vd->fmt);
         fmt->i_width = fmt->i_visible_width = p_display_mode->GetWidth();
@@ -929,15 +1029,17 @@ static void PrepareVideo(vout_display_t *vd, picture_t *picture, subpicture_t *)
     w = vd->fmt.i_width;
     h = vd->fmt.i_height;
 
-    IDeckLinkMutableVideoFrame *pDLVideoFrame;
-    result = sys->p_output->CreateVideoFrame(w, h, w*3,
-        sys->video.tenbits ? bmdFormat10BitYUV : bmdFormat8BitYUV,
-        bmdFrameFlagDefault, &pDLVideoFrame);
+    IDeckLinkMutableVideoFrame *pDLVideoFrame = sys->video.frames->Get();
+    if (!pDLVideoFrame) {
+        result = sys->p_output->CreateVideoFrame(w, h, w*3,
+            sys->video.tenbits ? bmdFormat10BitYUV : bmdFormat8BitYUV,
+            bmdFrameFlagDefault, &pDLVideoFrame);
 
-    if (result != S_OK) {
-        msg_Err(vd, "Failed to create video frame: 0x%X", result);
-        pDLVideoFrame = NULL;
-        goto end;
+        if (result != S_OK) {
+            msg_Err(vd, "Failed to create video frame: 0x%X", result);
+            pDLVideoFrame = NULL;
+            goto end;
+        }
     }
 
     void *frame_bytes;
@@ -994,6 +1096,9 @@ static void PrepareVideo(vout_display_t *vd, picture_t *picture, subpicture_t *)
         goto end;
     }
 
+    /* The frame is back in the pool once it was displayed */
+    pDLVideoFrame = NULL;
+
     now = mdate() - sys->offset;
 
     BMDTimeValue decklink_now;
@@ -1008,7 +1113,7 @@ static void PrepareVideo(vout_display_t *vd, picture_t *picture, subpicture_t *)
 
 end:
     if (pDLVideoFrame)
-        pDLVideoFrame->Release();
+        sys->video.frames->Put(pDLVideoFrame);
 }
 
 static void DisplayVideo(vout_display_t *, picture_t *picture, subpicture_t *)
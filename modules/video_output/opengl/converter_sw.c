@@ -53,6 +53,9 @@
 #ifndef GL_MAP_PERSISTENT_BIT
 # define GL_MAP_PERSISTENT_BIT 0x0040
 #endif
+#ifndef GL_MAP_COHERENT_BIT
+# define GL_MAP_COHERENT_BIT 0x0080
+#endif
 
 #ifndef GL_CLIENT_STORAGE_BIT
 # define GL_CLIENT_STORAGE_BIT 0x0200
@@ -67,8 +70,14 @@
 #ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
 # define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
 #endif
+#ifndef GL_SYNC_FLUSH_COMMANDS_BIT
+# define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#endif
 
 #define PBO_DISPLAY_COUNT 2 /* Double buffering */
+#define RING_SLOT_COUNT 3 /* Frames in flight in the upload ring */
+#define RING_PLANE_ALIGN 64
+#define RING_WAIT_TIMEOUT INT64_C(1000000000) /* 1 second, in ns */
 struct picture_sys_t
 {
     vlc_gl_t    *gl;
@@ -92,6 +101,13 @@ struct priv
         picture_t *pics[VLCGL_PICTURE_MAX];
         unsigned long long list;
     } persistent;
+    struct {
+        GLuint buffer;
+        uint8_t *base; /* persistently mapped, coherent */
+        size_t slot_size;
+        GLsync fences[RING_SLOT_COUNT];
+        size_t slot_idx;
+    } ring;
 };
 
 static void
@@ -520,6 +536,141 @@ tc_common_update(const opengl_tex_converter_t *tc, GLuint *textures,
     return ret;
 }
 
+static void
+ring_release(const opengl_tex_converter_t *tc)
+{
+    struct priv *priv = tc->priv;
+
+    for (size_t i = 0; i < RING_SLOT_COUNT; ++i)
+        if (priv->ring.fences[i] != NULL)
+        {
+            tc->vt->DeleteSync(priv->ring.fences[i]);
+            priv->ring.fences[i] = NULL;
+        }
+
+    if (priv->ring.buffer != 0)
+    {
+        if (priv->ring.base != NULL)
+        {
+            tc->vt->BindBuffer(GL_PIXEL_UNPACK_BUFFER, priv->ring.buffer);
+            tc->vt->UnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            tc->vt->BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        }
+        tc->vt->DeleteBuffers(1, &priv->ring.buffer);
+    }
+    priv->ring.buffer = 0;
+    priv->ring.base = NULL;
+    priv->ring.slot_size = 0;
+    priv->ring.slot_idx = 0;
+}
+
+static int
+ring_alloc(const opengl_tex_converter_t *tc, size_t slot_size)
+{
+    struct priv *priv = tc->priv;
+
+    if (slot_size > SIZE_MAX / RING_SLOT_COUNT)
+        return VLC_EGENERIC;
+
+    /* The storage is immutable: write once, never re-specified, so that the
+     * driver never has to orphan or synchronize it behind our back */
+    const GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT |
+                              GL_MAP_COHERENT_BIT;
+    const size_t size = slot_size * RING_SLOT_COUNT;
+
+    tc->vt->GetError();
+    tc->vt->GenBuffers(1, &priv->ring.buffer);
+    tc->vt->BindBuffer(GL_PIXEL_UNPACK_BUFFER, priv->ring.buffer);
+    tc->vt->BufferStorage(GL_PIXEL_UNPACK_BUFFER, size, NULL, access);
+    if (tc->vt->GetError() == GL_NO_ERROR)
+        priv->ring.base = tc->vt->MapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0,
+                                                 size, access);
+    tc->vt->BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (priv->ring.base == NULL)
+    {
+        msg_Err(tc->gl, "could not map the upload ring");
+        ring_release(tc);
+        return VLC_EGENERIC;
+    }
+    priv->ring.slot_size = slot_size;
+    return VLC_SUCCESS;
+}
+
+static int
+tc_ring_update(const opengl_tex_converter_t *tc, GLuint *textures,
+               const GLsizei *tex_width, const GLsizei *tex_height,
+               picture_t *pic, const size_t *plane_offset)
+{
+    struct priv *priv = tc->priv;
+    size_t offsets[PICTURE_PLANE_MAX];
+    size_t slot_size = 0;
+
+    for (int i = 0; i < pic->i_planes; i++)
+    {
+        offsets[i] = slot_size;
+        slot_size += (pic->p[i].i_pitch * pic->p[i].i_lines
+                      + RING_PLANE_ALIGN - 1) & ~(RING_PLANE_ALIGN - 1);
+    }
+
+    if (slot_size > priv->ring.slot_size)
+    {
+        ring_release(tc);
+        if (ring_alloc(tc, slot_size) != VLC_SUCCESS)
+            return tc_common_update(tc, textures, tex_width, tex_height, pic,
+                                    plane_offset);
+    }
+
+    /* With several frames in flight, the slot was normally consumed by the
+     * GPU long ago and this does not wait */
+    GLsync *fence = &priv->ring.fences[priv->ring.slot_idx];
+    if (*fence != NULL)
+    {
+        GLenum wait = tc->vt->ClientWaitSync(*fence,
+                                             GL_SYNC_FLUSH_COMMANDS_BIT,
+                                             RING_WAIT_TIMEOUT);
+        if (wait != GL_ALREADY_SIGNALED && wait != GL_CONDITION_SATISFIED)
+            msg_Warn(tc->gl, "upload ring slot still in use");
+        tc->vt->DeleteSync(*fence);
+        *fence = NULL;
+    }
+
+    const size_t slot_offset = priv->ring.slot_idx * priv->ring.slot_size;
+    tc->vt->BindBuffer(GL_PIXEL_UNPACK_BUFFER, priv->ring.buffer);
+
+    for (int i = 0; i < pic->i_planes; i++)
+    {
+        const size_t offset = slot_offset + offsets[i];
+        const uint8_t *pixels = plane_offset != NULL ?
+                                &pic->p[i].p_pixels[plane_offset[i]] :
+                                pic->p[i].p_pixels;
+
+        /* The mapping is coherent: no flush is needed before the upload */
+        memcpy(priv->ring.base + offset, pixels,
+               pic->p[i].i_pitch * pic->p[i].i_lines);
+
+        tc->vt->ActiveTexture(GL_TEXTURE0 + i);
+        tc->vt->BindTexture(tc->tex_target, textures[i]);
+
+        tc->vt->PixelStorei(GL_UNPACK_ROW_LENGTH,
+                            pic->p[i].i_pitch / pic->p[i].i_pixel_pitch);
+
+        tc->vt->TexSubImage2D(tc->tex_target, 0, 0, 0, tex_width[i], tex_height[i],
+                              tc->texs[i].format, tc->texs[i].type,
+                              (const GLvoid *)(uintptr_t)offset);
+    }
+
+    /* If the fence cannot be created, the next use of the slot does not
+     * wait: that is a corner case, as with the persistent pictures */
+    *fence = tc->vt->FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    priv->ring.slot_idx = (priv->ring.slot_idx + 1) % RING_SLOT_COUNT;
+
+    /* turn off pbo */
+    tc->vt->BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    return VLC_SUCCESS;
+}
+
 int
 opengl_tex_converter_generic_init(opengl_tex_converter_t *tc, bool allow_dr)
 {
@@ -617,9 +768,20 @@ opengl_tex_converter_generic_init(opengl_tex_converter_t *tc, bool allow_dr)
         }
         if (!supports_map_persistent)
         {
+            /* Without direct rendering, upload through a persistently mapped
+             * ring rather than re-specified PBOs */
+            const bool supports_ring = has_pbo && has_bs
+                && tc->vt->BufferStorage && tc->vt->MapBufferRange
+                && tc->vt->UnmapBuffer && tc->vt->FenceSync
+                && tc->vt->DeleteSync && tc->vt->ClientWaitSync;
             const bool supports_pbo = has_pbo && tc->vt->BufferData
                 && tc->vt->BufferSubData;
-            if (supports_pbo && pbo_pics_alloc(tc) == VLC_SUCCESS)
+            if (supports_ring)
+            {
+                tc->pf_update  = tc_ring_update;
+                msg_Dbg(tc->gl, "persistent upload ring enabled");
+            }
+            else if (supports_pbo && pbo_pics_alloc(tc) == VLC_SUCCESS)
             {
                 tc->pf_update  = tc_pbo_update;
                 msg_Dbg(tc->gl, "PBO support enabled");
@@ -642,6 +804,7 @@ opengl_tex_converter_generic_deinit(opengl_tex_converter_t *tc)
     for (size_t i = 0; i < PBO_DISPLAY_COUNT && priv->pbo.display_pics[i]; ++i)
         picture_Release(priv->pbo.display_pics[i]);
     persistent_release_gpupics(tc, true);
+    ring_release(tc);
     free(priv->texture_temp_buf);
     free(tc->priv);
 }
@@ -0,0 +1,323 @@
+/*****************************************************************************
+ * vgl.c: OpenGL context provided by LibVLC rendering callbacks
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_vout_window.h>
+#include <vlc_opengl.h>
+
+#ifdef HAVE_EGL
+# include <EGL/egl.h>
+# include <EGL/eglext.h>
+#endif
+
+/*****************************************************************************
+ * Module descriptor
+ *****************************************************************************/
+static int  OpenGL   (vlc_object_t *);
+static int  OpenGLES2(vlc_object_t *);
+static void Close    (vlc_object_t *);
+static int  OpenWindow(vout_window_t *, const vout_window_cfg_t *);
+
+vlc_module_begin()
+    set_shortname(N_("Callbacks"))
+    set_description(N_("OpenGL rendering callbacks"))
+    set_category(CAT_VIDEO)
+    set_subcategory(SUBCAT_VIDEO_VOUT)
+    set_capability("opengl", 0)
+    set_callbacks(OpenGL, Close)
+    add_shortcut("vgl")
+
+    add_submodule()
+    set_capability("opengl es2", 0)
+    set_callbacks(OpenGLES2, Close)
+    add_shortcut("vgl")
+
+    add_submodule()
+    set_description(N_("OpenGL rendering callbacks surface"))
+    set_capability("vout window", 0)
+    set_callbacks(OpenWindow, NULL)
+    add_shortcut("vgl")
+vlc_module_end()
+
+/*****************************************************************************
+ * Local prototypes
+ *****************************************************************************/
+/* NOTE: the callback prototypes must match those of LibVLC */
+typedef struct
+{
+    void *opaque;
+    void (*cleanup)(void *);
+    bool (*update_output)(void *, unsigned, unsigned);
+    void (*swap)(void *);
+    bool (*make_current)(void *, bool);
+    void *(*get_proc_address)(void *, const char *);
+
+#ifdef HAVE_EGL
+    EGLDisplay display;
+    PFNEGLQUERYSTRINGPROC eglQueryString;
+    PFNEGLCREATEIMAGEKHRPROC eglCreateImageKHR;
+    PFNEGLDESTROYIMAGEKHRPROC eglDestroyImageKHR;
+#endif
+} vlc_gl_sys_t;
+
+static int MakeCurrent(vlc_gl_t *gl)
+{
+    vlc_gl_sys_t *sys = gl->sys;
+
+    return sys->make_current(sys->opaque, true) ? VLC_SUCCESS : VLC_EGENERIC;
+}
+
+static void ReleaseCurrent(vlc_gl_t *gl)
+{
+    vlc_gl_sys_t *sys = gl->sys;
+
+    sys->make_current(sys->opaque, false);
+}
+
+static void Resize(vlc_gl_t *gl, unsigned width, unsigned height)
+{
+    vlc_gl_sys_t *sys = gl->sys;
+
+    if (sys->update_output == NULL)
+        return;
+    /* The application (re)allocates its render target with the context */
+    if (!sys->make_current(sys->opaque, true))
+        return;
+    if (!sys->update_output(sys->opaque, width, height))
+        msg_Err(gl, "cannot update the output to %ux%u", width, height);
+    sys->make_current(sys->opaque, false);
+}
+
+/* The picture was drawn in the render target of the application, with the
+ * context current. The application can flush it, or insert a fence in the
+ * command stream to synchronize with its own rendering. */
+static void Swap(vlc_gl_t *gl)
+{
+    vlc_gl_sys_t *sys = gl->sys;
+
+    sys->swap(sys->opaque);
+}
+
+static void *GetProcAddress(vlc_gl_t *gl, const char *name)
+{
+    vlc_gl_sys_t *sys = gl->sys;
+
+    return sys->get_proc_address(sys->opaque, name);
+}
+
+#ifdef HAVE_EGL
+/* When the application context is an EGL context, the EGL image extensions
+ * let the VA-API converter import the decoded surfaces without copies. */
+static const char *QueryString(vlc_gl_t *gl, int32_t name)
+{
+    vlc_gl_sys_t *sys = gl->sys;
+
+    return sys->eglQueryString(sys->display, name);
+}
+
+static void *CreateImageKHR(vlc_gl_t *gl, unsigned target, void *buffer,
+                            const int32_t *attrib_list)
+{
+    vlc_gl_sys_t *sys = gl->sys;
+
+    return sys->eglCreateImageKHR(sys->display, NULL, target, buffer,
+                                  attrib_list);
+}
+
+static bool DestroyImageKHR(vlc_gl_t *gl, void *image)
+{
+    vlc_gl_sys_t *sys = gl->sys;
+
+    return sys->eglDestroyImageKHR(sys->display, image);
+}
+
+static void InitEGL(vlc_gl_t *gl)
+{
+    vlc_gl_sys_t *sys = gl->sys;
+    EGLDisplay (*getCurrentDisplay)(void) =
+        GetProcAddress(gl, "eglGetCurrentDisplay");
+
+    if (getCurrentDisplay == NULL)
+        return;
+    sys->display = getCurrentDisplay();
+    if (sys->display == EGL_NO_DISPLAY)
+        return;
+
+    sys->eglQueryString = GetProcAddress(gl, "eglQueryString");
+    if (sys->eglQueryString == NULL)
+        return;
+
+    gl->ext = VLC_GL_EXT_EGL;
+    gl->egl.queryString = QueryString;
+
+    sys->eglCreateImageKHR = GetProcAddress(gl, "eglCreateImageKHR");
+    sys->eglDestroyImageKHR = GetProcAddress(gl, "eglDestroyImageKHR");
+    if (sys->eglCreateImageKHR != NULL && sys->eglDestroyImageKHR != NULL)
+    {
+        gl->egl.createImageKHR = CreateImageKHR;
+        gl->egl.destroyImageKHR = DestroyImageKHR;
+    }
+    msg_Dbg(gl, "using the application EGL display");
+}
+#endif
+
+#ifdef __APPLE__
+/* The CoreVideo converter maps the decoded buffers as textures of the
+ * application CGL context. */
+static void InitCGL(vlc_gl_t *gl)
+{
+    void *(*getCurrentContext)(void) =
+        GetProcAddress(gl, "CGLGetCurrentContext");
+
+    if (getCurrentContext == NULL)
+        return;
+
+    void *ctx = getCurrentContext();
+    if (ctx != NULL)
+    {
+        var_Create(gl, "macosx-glcontext", VLC_VAR_ADDRESS);
+        var_SetAddress(gl, "macosx-glcontext", ctx);
+    }
+}
+#endif
+
+/*****************************************************************************
+ * Open: sets up the application OpenGL context
+ *****************************************************************************/
+static int Open(vlc_object_t *object, const char *api)
+{
+    vlc_gl_t *gl = (vlc_gl_t *)object;
+
+    if (gl->surface->type != VOUT_WINDOW_TYPE_DUMMY)
+        return VLC_EGENERIC;
+
+    vlc_gl_sys_t *sys = malloc(sizeof (*sys));
+    if (unlikely(sys == NULL))
+        return VLC_ENOMEM;
+
+    bool (*setup)(void **) = var_InheritAddress(gl, "vout-cb-setup");
+
+    sys->opaque = var_InheritAddress(gl, "vout-cb-opaque");
+    sys->cleanup = var_InheritAddress(gl, "vout-cb-cleanup");
+    sys->update_output = var_InheritAddress(gl, "vout-cb-update-output");
+    sys->swap = var_InheritAddress(gl, "vout-cb-swap");
+    sys->make_current = var_InheritAddress(gl, "vout-cb-make-current");
+    sys->get_proc_address = var_InheritAddress(gl, "vout-cb-get-proc-address");
+
+    if (sys->swap == NULL || sys->make_current == NULL
+     || sys->get_proc_address == NULL)
+    {
+        msg_Err(gl, "missing %s rendering callbacks", api);
+        free(sys);
+        return VLC_EGENERIC;
+    }
+
+    if (setup != NULL && !setup(&sys->opaque))
+    {
+        msg_Err(gl, "%s rendering setup failure", api);
+        free(sys);
+        return VLC_EGENERIC;
+    }
+
+    gl->sys = sys;
+    gl->makeCurrent = MakeCurrent;
+    gl->releaseCurrent = ReleaseCurrent;
+    gl->resize = Resize;
+    gl->swap = Swap;
+    gl->getProcAddress = GetProcAddress;
+    gl->ext = VLC_GL_EXT_DEFAULT;
+
+    if (MakeCurrent(gl) == VLC_SUCCESS)
+    {
+#ifdef HAVE_EGL
+        InitEGL(gl);
+#endif
+#ifdef __APPLE__
+        InitCGL(gl);
+#endif
+        ReleaseCurrent(gl);
+    }
+    return VLC_SUCCESS;
+}
+
+static int OpenGL(vlc_object_t *object)
+{
+    return Open(object, "OpenGL");
+}
+
+static int OpenGLES2(vlc_object_t *object)
+{
+    return Open(object, "OpenGL ES2");
+}
+
+static void Close(vlc_object_t *object)
+{
+    vlc_gl_t *gl = (vlc_gl_t *)object;
+    vlc_gl_sys_t *sys = gl->sys;
+
+    if (sys->cleanup != NULL)
+        sys->cleanup(sys->opaque);
+    free(sys);
+}
+
+/*****************************************************************************
+ * Surface: there is no window, the application owns the render target
+ *****************************************************************************/
+static int WindowControl(vout_window_t *wnd, int query, va_list ap)
+{
+    VLC_UNUSED(ap);
+
+    switch (query)
+    {
+        case VOUT_WINDOW_SET_SIZE:   /* follows the display size anyway */
+        case VOUT_WINDOW_SET_STATE:
+        case VOUT_WINDOW_SET_FULLSCREEN:
+        case VOUT_WINDOW_HIDE_MOUSE:
+            return VLC_SUCCESS;
+        default:
+            msg_Warn(wnd, "unsupported control query %d", query);
+            return VLC_EGENERIC;
+    }
+}
+
+static int OpenWindow(vout_window_t *wnd, const vout_window_cfg_t *cfg)
+{
+    if (cfg->type != VOUT_WINDOW_TYPE_INVALID
+     && cfg->type != VOUT_WINDOW_TYPE_DUMMY)
+        return VLC_EGENERIC;
+    if (var_InheritAddress(wnd, "vout-cb-swap") == NULL)
+        return VLC_EGENERIC;
+
+    wnd->type = VOUT_WINDOW_TYPE_DUMMY;
+    wnd->control = WindowControl;
+    wnd->sys = NULL;
+    return VLC_SUCCESS;
+}
@@ -81,11 +81,16 @@ vlc_module_end()
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
+/* NOTE: the callback prototypes must match those of LibVLC */
 struct picture_sys_t {
+    /* Copies of the display callbacks, as the pictures can outlive it */
+    void *opaque;
+    void *(*lock)(void *sys, void **plane);
+    void (*release)(void *sys, void *id);
+
     void *id;
 };
 
-/* NOTE: the callback prototypes must match those of LibVLC */
 struct vout_display_sys_t {
     picture_pool_t *pool;
 
@@ -94,6 +99,7 @@ struct vout_display_sys_t {
     void *(*lock)(void *sys, void **plane);
     void (*unlock)(void *sys, void *id, void *const *plane);
     void (*display)(void *sys, void *id);
+    void (*release)(void *sys, void *id);
     void (*cleanup)(void *sys);
 
     unsigned pitches[PICTURE_PLANE_MAX];
@@ -131,6 +137,7 @@ static int Open(vlc_object_t *object)
     }
     sys->unlock = var_InheritAddress(vd, "vmem-unlock");
     sys->display = var_InheritAddress(vd, "vmem-display");
+    sys->release = var_InheritAddress(vd, "vmem-release");
     sys->cleanup = var_InheritAddress(vd, "vmem-cleanup");
     sys->opaque = var_InheritAddress(vd, "vmem-data");
     sys->pool = NULL;
@@ -226,19 +233,95 @@ static void Close(vlc_object_t *object)
     vout_display_t *vd = (vout_display_t *)object;
     vout_display_sys_t *sys = vd->sys;
 
-    if (sys->cleanup)
-        sys->cleanup(sys->opaque);
+    /* Direct buffers are given back to the application first */
     if (sys->pool)
         picture_pool_Release(sys->pool);
+    if (sys->cleanup)
+        sys->cleanup(sys->opaque);
     free(sys);
 }
 
+/* Direct rendering: the application lends its buffers to the pictures of the
+ * pool, from the time they are taken from the pool until they return to it.
+ * Decoders then write into them, and Prepare() does not need to copy. */
+static int PoolLock(picture_t *pic)
+{
+    picture_sys_t *picsys = pic->p_sys;
+    void *planes[PICTURE_PLANE_MAX] = { NULL };
+
+    picsys->id = picsys->lock(picsys->opaque, planes);
+    if (planes[0] == NULL)
+        return VLC_EGENERIC; /* no buffers available at the moment */
+
+    for (int i = 0; i < pic->i_planes; i++)
+        pic->p[i].p_pixels = planes[i];
+    return VLC_SUCCESS;
+}
+
+static void PoolUnlock(picture_t *pic)
+{
+    picture_sys_t *picsys = pic->p_sys;
+
+    picsys->release(picsys->opaque, picsys->id);
+    for (int i = 0; i < pic->i_planes; i++)
+        pic->p[i].p_pixels = NULL;
+}
+
+static picture_pool_t *PoolDirect(vout_display_t *vd, unsigned count)
+{
+    vout_display_sys_t *sys = vd->sys;
+    picture_t *pictures[count];
+    unsigned i;
+
+    for (i = 0; i < count; i++) {
+        picture_sys_t *picsys = malloc(sizeof (*picsys));
+        if (unlikely(picsys == NULL))
+            break;
+        picsys->opaque = sys->opaque;
+        picsys->lock = sys->lock;
+        picsys->release = sys->release;
+        picsys->id = NULL;
+
+        picture_resource_t rsc = { .p_sys = picsys };
+        for (unsigned j = 0; j < PICTURE_PLANE_MAX; j++) {
+            rsc.p[j].p_pixels = NULL;
+            rsc.p[j].i_lines  = sys->lines[j];
+            rsc.p[j].i_pitch  = sys->pitches[j];
+        }
+
+        pictures[i] = picture_NewFromResource(&vd->fmt, &rsc);
+        if (unlikely(pictures[i] == NULL)) {
+            free(picsys);
+            break;
+        }
+    }
+
+    picture_pool_t *pool = NULL;
+    if (i > 0) {
+        picture_pool_configuration_t cfg = {
+            .picture_count = i,
+            .picture = pictures,
+            .lock = PoolLock,
+            .unlock = PoolUnlock,
+        };
+        pool = picture_pool_NewExtended(&cfg);
+    }
+    if (pool == NULL)
+        while (i > 0)
+            picture_Release(pictures[--i]);
+    return pool;
+}
+
 static picture_pool_t *Pool(vout_display_t *vd, unsigned count)
 {
     vout_display_sys_t *sys = vd->sys;
 
-    if (sys->pool == NULL)
-        sys->pool = picture_pool_NewFromFormat(&vd->fmt, count);
+    if (sys->pool == NULL) {
+        if (sys->release != NULL)
+            sys->pool = PoolDirect(vd, count);
+        else
+            sys->pool = picture_pool_NewFromFormat(&vd->fmt, count);
+    }
     return sys->pool;
 }
 
@@ -248,6 +331,19 @@ static void Prepare(vout_display_t *vd, picture_t *pic, subpicture_t *subpic)
     picture_resource_t rsc = { .p_sys = NULL };
     void *planes[PICTURE_PLANE_MAX];
 
+    if (sys->release != NULL) {
+        /* The picture was decoded or converted in the application buffers */
+        assert(pic->p_sys != NULL);
+        for (unsigned i = 0; i < PICTURE_PLANE_MAX; i++)
+            planes[i] = pic->p[i].p_pixels;
+
+        sys->pic_opaque = pic->p_sys->id;
+        if (sys->unlock != NULL)
+            sys->unlock(sys->opaque, sys->pic_opaque, planes);
+        (void) subpic;
+        return;
+    }
+
     sys->pic_opaque = sys->lock(sys->opaque, planes);
 
     for (unsigned i = 0; i < PICTURE_PLANE_MAX; i++) {
@@ -29,6 +29,9 @@
 
 #include <xcb/xcb.h>
 #include <xcb/shm.h>
+#ifdef HAVE_XCB_PRESENT
+# include <xcb/present.h>
+#endif
 
 #include <vlc_common.h>
 #include <vlc_plugin.h>
@@ -41,6 +44,11 @@
 static int  Open (vlc_object_t *);
 static void Close (vlc_object_t *);
 
+#define PRESENT_TEXT N_("Synchronize to the vertical retrace")
+#define PRESENT_LONGTEXT N_( \
+    "Show the pictures on the vertical retraces with the Present " \
+    "extension, to avoid tearing.")
+
 /*
  * Module descriptor
  */
@@ -54,12 +62,17 @@ vlc_module_begin ()
     add_shortcut ("xcb-x11", "x11")
 
     add_obsolete_bool ("x11-shm") /* obsoleted since 2.0.0 */
+#ifdef HAVE_XCB_PRESENT
+    add_bool ("x11-present", true, PRESENT_TEXT, PRESENT_LONGTEXT, true)
+#endif
 vlc_module_end ()
 
-/* This must be large enough to absorb the server display jitter.
- * But excessively large value is useless as direct rendering cannot be used
- * with XCB X11. */
-#define MAX_PICTURES (3)
+/* The pool must be large enough to absorb the server display jitter, and
+ * with Present, to hold the pictures queued or shown by the server. The
+ * pictures are shared memory, so the decoders or the converters render
+ * directly into them, if the pool covers their requested count. */
+#define MIN_PICTURES (3)
+#define MAX_PICTURES (32)
 
 struct vout_display_sys_t
 {
@@ -73,6 +86,24 @@ struct vout_display_sys_t
     uint8_t depth; /* useful bits per pixel */
 
     picture_pool_t *pool; /* picture pool */
+    unsigned count; /* pictures in the pool */
+
+#ifdef HAVE_XCB_PRESENT
+    xcb_special_event_t *present; /* Present events, NULL if not used */
+    uint32_t serial; /* last presented picture */
+    uint64_t msc; /* media stream counter of the last completion */
+    mtime_t ust; /* date of the last completion */
+    mtime_t period; /* between two vertical retraces, 0 if unknown */
+
+    struct
+    {
+        picture_t *pic;
+        xcb_pixmap_t pixmap;
+        picture_t *held; /* while the server uses the pixmap */
+        uint32_t serial; /* of the last presentation */
+        mtime_t date; /* of the picture in the last presentation */
+    } pictures[MAX_PICTURES];
+#endif
 };
 
 static picture_pool_t *Pool (vout_display_t *, unsigned);
@@ -96,6 +127,135 @@ static const xcb_depth_t *FindDepth (const xcb_screen_t *scr,
     return d;
 }
 
+#ifdef HAVE_XCB_PRESENT
+/**
+ * Checks the Present extension, and selects its events on the window.
+ */
+static xcb_special_event_t *PresentInit (vout_display_t *vd,
+                                         xcb_connection_t *conn,
+                                         xcb_window_t window)
+{
+    xcb_present_query_version_cookie_t ck;
+    xcb_present_query_version_reply_t *r;
+
+    ck = xcb_present_query_version (conn, XCB_PRESENT_MAJOR_VERSION,
+                                    XCB_PRESENT_MINOR_VERSION);
+    r = xcb_present_query_version_reply (conn, ck, NULL);
+    if (r == NULL)
+    {
+        msg_Dbg (vd, "Present extension not available");
+        return NULL;
+    }
+    msg_Dbg (vd, "using Present extension version %"PRIu32".%"PRIu32,
+             r->major_version, r->minor_version);
+    free (r);
+
+    xcb_present_event_t eid = xcb_generate_id (conn);
+    xcb_special_event_t *events =
+        xcb_register_for_special_xge (conn, &xcb_present_id, eid, NULL);
+    if (events == NULL)
+        return NULL;
+
+    xcb_present_select_input (conn, eid, window,
+                              XCB_PRESENT_EVENT_MASK_COMPLETE_NOTIFY |
+                              XCB_PRESENT_EVENT_MASK_IDLE_NOTIFY);
+    return events;
+}
+
+/**
+ * Processes the completions and the idle notifications of the presentations.
+ */
+static void PresentManage (vout_display_t *vd)
+{
+    vout_display_sys_t *sys = vd->sys;
+    xcb_generic_event_t *ev;
+
+    while ((ev = xcb_poll_for_special_event (sys->conn, sys->present)) != NULL)
+    {
+        switch (((xcb_ge_generic_event_t *)ev)->event_type)
+        {
+            case XCB_PRESENT_EVENT_COMPLETE_NOTIFY:
+            {
+                const xcb_present_complete_notify_event_t *e = (void *)ev;
+
+                if (e->kind != XCB_PRESENT_COMPLETE_KIND_PIXMAP)
+                    break;
+                /* The server UST is CLOCK_MONOTONIC in microseconds, as
+                 * mdate() is on Linux and BSD */
+                if (sys->ust > VLC_TS_INVALID && e->msc > sys->msc)
+                    sys->period = (e->ust - sys->ust) / (e->msc - sys->msc);
+                sys->msc = e->msc;
+                sys->ust = e->ust;
+
+                for (unsigned i = 0; i < sys->count; i++)
+                    if (sys->pictures[i].serial == e->serial)
+                    {
+                        vout_display_SendEventPresented (vd,
+                                            sys->pictures[i].date, e->ust);
+                        break;
+                    }
+                break;
+            }
+
+            case XCB_PRESENT_EVENT_IDLE_NOTIFY:
+            {
+                const xcb_present_idle_notify_event_t *e = (void *)ev;
+
+                for (unsigned i = 0; i < sys->count; i++)
+                    if (sys->pictures[i].pixmap == e->pixmap
+                     && sys->pictures[i].serial == e->serial
+                     && sys->pictures[i].held != NULL)
+                    {   /* The picture can be rendered into again */
+                        picture_Release (sys->pictures[i].held);
+                        sys->pictures[i].held = NULL;
+                        break;
+                    }
+                break;
+            }
+        }
+        free (ev);
+    }
+}
+
+/**
+ * Queues a shared memory picture for the vertical retrace at its date.
+ */
+static bool PresentPicture (vout_display_t *vd, picture_t *pic)
+{
+    vout_display_sys_t *sys = vd->sys;
+    unsigned i;
+
+    for (i = 0; i < sys->count; i++)
+        if (sys->pictures[i].pic == pic && sys->pictures[i].pixmap != 0)
+            break;
+    if (i == sys->count || sys->pictures[i].held != NULL)
+        return false; /* not a pixmap, or still used by the server */
+
+    /* The vout calls Display() right before the picture date: that is the
+     * next retrace, unless the rate of the retraces is known. Media stream
+     * counters in the past are presented at the next retrace anyway. */
+    uint64_t target = 0;
+    if (sys->period > 0 && pic->date > sys->ust)
+    {
+        uint64_t ahead = (pic->date - sys->ust + sys->period / 2)
+                         / sys->period;
+        if (ahead <= 16)
+            target = sys->msc + __MAX (ahead, 1);
+    }
+
+    sys->pictures[i].serial = ++sys->serial;
+    sys->pictures[i].date = pic->date;
+    sys->pictures[i].held = pic;
+
+    xcb_present_pixmap (sys->conn, sys->window, sys->pictures[i].pixmap,
+                        sys->serial, 0, 0,
+                        -vd->fmt.i_x_offset, -vd->fmt.i_y_offset,
+                        0, 0, 0, XCB_PRESENT_OPTION_NONE,
+                        target, 0, 0, 0, NULL);
+    xcb_flush (sys->conn);
+    return true;
+}
+#endif
 
 /**
  * Probe the X server.
@@ -109,6 +269,10 @@ static int Open (vlc_object_t *obj)
 
     vd->sys = sys;
     sys->pool = NULL;
+    sys->count = 0;
+#ifdef HAVE_XCB_PRESENT
+    sys->present = NULL;
+#endif
 
     /* Get window, connect to X server */
     xcb_connection_t *conn;
@@ -292,6 +456,15 @@ found_format:;
         sys->seg_base = xcb_generate_id (conn);
         for (unsigned i = 1; i < MAX_PICTURES; i++)
              xcb_generate_id (conn);
+#ifdef HAVE_XCB_PRESENT
+        /* Pixmaps of the shared memory pictures are flipped on retraces */
+        if (var_InheritBool (obj, "x11-present"))
+            sys->present = PresentInit (vd, conn, sys->window);
+        sys->serial = 0;
+        sys->msc = 0;
+        sys->ust = VLC_TS_INVALID;
+        sys->period = 0;
+#endif
     }
     else
         sys->seg_base = 0;
@@ -322,6 +495,10 @@ static void Close (vlc_object_t *obj)
     vout_display_sys_t *sys = vd->sys;
 
     ResetPictures (vd);
+#ifdef HAVE_XCB_PRESENT
+    if (sys->present != NULL)
+        xcb_unregister_for_special_event (sys->conn, sys->present);
+#endif
 
     /* colormap, window and context are garbage-collected by X */
     xcb_disconnect (sys->conn);
@@ -335,7 +512,6 @@ static void Close (vlc_object_t *obj)
 static picture_pool_t *Pool (vout_display_t *vd, unsigned requested_count)
 {
     vout_display_sys_t *sys = vd->sys;
-    (void)requested_count;
 
     if (sys->pool)
         return sys->pool;
@@ -367,10 +543,11 @@ static picture_pool_t *Pool (vout_display_t *vd, unsigned requested_count)
     };
     picture_Release (pic);
 
-    unsigned count;
+    unsigned count, max = VLC_CLIP (requested_count, MIN_PICTURES,
+                                     MAX_PICTURES);
     picture_t *pic_array[MAX_PICTURES];
     const size_t size = res.p->i_pitch * res.p->i_lines;
-    for (count = 0; count < MAX_PICTURES; count++)
+    for (count = 0; count < max; count++)
     {
         xcb_shm_seg_t seg = (sys->seg_base != 0) ? (sys->seg_base + count) : 0;
 
@@ -380,16 +557,40 @@ static picture_pool_t *Pool (vout_display_t *vd, unsigned requested_count)
                                                         sys->conn);
         if (unlikely(pic_array[count] == NULL))
             break;
+
+#ifdef HAVE_XCB_PRESENT
+        sys->pictures[count].pic = pic_array[count];
+        sys->pictures[count].pixmap = 0;
+        sys->pictures[count].held = NULL;
+        sys->pictures[count].serial = 0;
+        if (sys->present != NULL && XCB_picture_GetSegment (pic_array[count]))
+        {
+            xcb_pixmap_t pixmap = xcb_generate_id (sys->conn);
+
+            xcb_shm_create_pixmap (sys->conn, pixmap, sys->window,
+                                   res.p->i_pitch / pic_array[count]->p->i_pixel_pitch,
+                                   res.p->i_lines, sys->depth,
+                                   XCB_picture_GetSegment (pic_array[count]),
+                                   0);
+            sys->pictures[count].pixmap = pixmap;
+        }
+#endif
     }
     xcb_flush (sys->conn);
 
     if (count == 0)
         return NULL;
 
+    sys->count = count;
     sys->pool = picture_pool_New (count, pic_array);
     if (unlikely(sys->pool == NULL))
+    {
+        ResetPictures (vd);
         while (count > 0)
             picture_Release(pic_array[--count]);
+    }
+    else
+        msg_Dbg (vd, "using %u pictures", count);
     return sys->pool;
 }
 
@@ -403,9 +604,21 @@ static void Display (vout_display_t *vd, picture_t *pic, subpicture_t *subpictur
     xcb_void_cookie_t ck;
 
     vlc_xcb_Manage(vd, sys->conn, &sys->visible);
+#ifdef HAVE_XCB_PRESENT
+    if (sys->present != NULL)
+        PresentManage (vd);
+#endif
 
     if (!sys->visible)
         goto out;
+#ifdef HAVE_XCB_PRESENT
+    /* The server releases the picture once another one is shown */
+    if (sys->present != NULL && PresentPicture (vd, pic))
+    {
+        (void)subpicture;
+        return;
+    }
+#endif
     if (segment != 0)
         ck = xcb_shm_put_image_checked (sys->conn, sys->window, sys->gc,
           /* real width */ pic->p->i_pitch / pic->p->i_pixel_pitch,
@@ -514,13 +727,28 @@ static void ResetPictures (vout_display_t *vd)
 {
     vout_display_sys_t *sys = vd->sys;
 
-    if (!sys->pool)
+    if (sys->count == 0)
         return;
 
+#ifdef HAVE_XCB_PRESENT
+    for (unsigned i = 0; i < sys->count; i++)
+    {
+        if (sys->pictures[i].pixmap != 0)
+            xcb_free_pixmap (sys->conn, sys->pictures[i].pixmap);
+        /* The segments are detached below, the server will not read the
+         * freed pixmaps anymore */
+        if (sys->pictures[i].held != NULL)
+            picture_Release (sys->pictures[i].held);
+    }
+#endif
     if (sys->seg_base != 0)
-        for (unsigned i = 0; i < MAX_PICTURES; i++)
+        for (unsigned i = 0; i < sys->count; i++)
             xcb_shm_detach (sys->conn, sys->seg_base + i);
+    sys->count = 0;
 
-    picture_pool_Release (sys->pool);
-    sys->pool = NULL;
+    if (sys->pool != NULL)
+    {
+        picture_pool_Release (sys->pool);
+        sys->pool = NULL;
+    }
 }
@@ -959,6 +959,28 @@ static int Configuration( panoramix_output_t pp_output[ROW_MAX][COL_MAX],
     return i_output;
 }
 
+/**
+ * It attenuates a part of a line, with one table per column, followed by the
+ * table of the line if any
+ */
+static inline void AttenuateLine( uint8_t *p_dst, const uint8_t *p_src,
+                                  int i_count,
+                                  uint8_t p_lut[ACCURACY + 1][256],
+                                  const int *p_lambda,
+                                  const uint8_t *p_lut_h )
+{
+    if( p_lut_h )
+    {
+        for( int i = 0; i < i_count; i++ )
+            p_dst[i] = p_lut_h[p_lut[p_lambda[i]][p_src[i]]];
+    }
+    else
+    {
+        for( int i = 0; i < i_count; i++ )
+            p_dst[i] = p_lut[p_lambda[i]][p_src[i]];
+    }
+}
+
 /**
  * It filters a video plane
  */
@@ -992,41 +1014,49 @@ static void FilterPlanar( uint8_t *p_out, int i_out_pitch,
         const uint8_t *p_src = p_in;
         uint8_t *p_dst = p_out;
 
+        /* The complete line is attenuated at top/bottom: the vertical table
+         * is applied to the pixels as they are written, instead of
+         * reading the line again */
+        const uint8_t *p_lut_h = NULL;
+        if( y < p_cfg->attenuate.i_top )
+            p_lut_h = p_lut[lambdah[0][y]];
+        else if( y >= i_copy_lines - p_cfg->attenuate.i_bottom )
+            p_lut_h = p_lut[lambdah[1][y - (i_copy_lines - p_cfg->attenuate.i_bottom)]];
+
+        const int i_black = p_lut_h ? p_lut_h[i_pixel_black] : i_pixel_black;
+
         /* Black border on the left */
         if( p_cfg->black.i_left > 0 )
         {
-            memset( p_dst, i_pixel_black, p_cfg->black.i_left );
+            memset( p_dst, i_black, p_cfg->black.i_left );
             p_dst += p_cfg->black.i_left;
         }
         /* Attenuated video on the left */
-        for( int i = 0; i < p_cfg->attenuate.i_left; i++ )
-            *p_dst++ = p_lut[lambdav[0][i]][*p_src++];
+        AttenuateLine( p_dst, p_src, p_cfg->attenuate.i_left,
+                       p_lut, lambdav[0], p_lut_h );
+        p_dst += p_cfg->attenuate.i_left;
+        p_src += p_cfg->attenuate.i_left;
 
         /* Unmodified video */
         const int i_unmodified_width = i_copy_pitch - p_cfg->attenuate.i_left - p_cfg->attenuate.i_right;
-        memcpy( p_dst, p_src, i_unmodified_width );
+        if( p_lut_h )
+        {
+            for( int i = 0; i < i_unmodified_width; i++ )
+                p_dst[i] = p_lut_h[p_src[i]];
+        }
+        else
+            memcpy( p_dst, p_src, i_unmodified_width );
         p_dst += i_unmodified_width;
         p_src += i_unmodified_width;
 
         /* Attenuated video on the right */
-        for( int i = 0; i < p_cfg->attenuate.i_right; i++ )
-            *p_dst++ = p_lut[lambdav[1][i]][*p_src++];
+        AttenuateLine( p_dst, p_src, p_cfg->attenuate.i_right,
+                       p_lut, lambdav[1], p_lut_h );
+        p_dst += p_cfg->attenuate.i_right;
+
         /* Black border on the right */
         if( p_cfg->black.i_right > 0 )
-        {
-            memset( p_dst, i_pixel_black, p_cfg->black.i_right );
-            p_dst += p_cfg->black.i_right;
-        }
-
-        /* Attenuate complete line at top/bottom */
-        const bool b_attenuate_top    = y < p_cfg->attenuate.i_top;
-        const bool b_attenuate_bottom = y >= i_copy_lines - p_cfg->attenuate.i_bottom;
-        if( b_attenuate_top || b_attenuate_bottom )
-        {
-            const int i_index = b_attenuate_top ? lambdah[0][y] : lambdah[1][y - (i_copy_lines - p_cfg->attenuate.i_bottom)];
-            for( int i = 0; i < i_out_width; i++)
-                p_out[i] = p_lut[i_index][p_out[i]];
-        }
+            memset( p_dst, i_black, p_cfg->black.i_right );
 
         /* */
         p_in  += i_in_pitch;
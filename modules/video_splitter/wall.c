@@ -59,6 +59,11 @@
 #define ASPECT_LONGTEXT N_("Aspect ratio of the individual displays " \
    "building the wall.")
 
+#define ZEROCOPY_TEXT N_("Share the source picture")
+#define ZEROCOPY_LONGTEXT N_("Give each window a reference to the source " \
+    "picture, cropped by the OpenGL video output, instead of copying its " \
+    "part of the picture.")
+
 #define CFG_PREFIX "wall-"
 
 static int  Open ( vlc_object_t * );
@@ -78,6 +83,8 @@ vlc_module_begin()
     add_string( CFG_PREFIX "active", NULL, ACTIVE_TEXT, ACTIVE_LONGTEXT,
                  true )
     add_string( CFG_PREFIX "element-aspect", "16:9", ASPECT_TEXT, ASPECT_LONGTEXT, false )
+    add_bool( CFG_PREFIX "zero-copy", false, ZEROCOPY_TEXT, ZEROCOPY_LONGTEXT,
+              true )
 
     add_shortcut( "wall" )
     set_callbacks( Open, Close )
@@ -87,7 +94,7 @@ vlc_module_end()
  * Local prototypes
  *****************************************************************************/
 static const char *const ppsz_filter_options[] = {
-    "cols", "rows", "active", "element-aspect", NULL
+    "cols", "rows", "active", "element-aspect", "zero-copy", NULL
 };
 
 /* */
@@ -107,6 +114,7 @@ struct video_splitter_sys_t
     int           i_col;
     int           i_row;
     int           i_output;
+    bool          b_zero_copy;
     wall_output_t pp_output[COL_MAX][ROW_MAX]; /* [x][y] */
 };
 
@@ -145,6 +153,8 @@ static int Open( vlc_object_t *p_this )
     msg_Dbg( p_splitter, "opening a %i x %i wall",
              p_sys->i_col, p_sys->i_row );
 
+    p_sys->b_zero_copy = var_CreateGetBool( p_splitter, CFG_PREFIX "zero-copy" );
+
     /* */
     char *psz_state = var_CreateGetNonEmptyString( p_splitter, CFG_PREFIX "active" );
 
@@ -355,16 +365,30 @@ static int Open( vlc_object_t *p_this )
             video_splitter_output_t *p_cfg = &p_splitter->p_output[p_output->i_output];
 
             video_format_Copy( &p_cfg->fmt, &p_splitter->fmt );
-            p_cfg->fmt.i_visible_width  =
-            p_cfg->fmt.i_width          = p_output->i_width;
-            p_cfg->fmt.i_visible_height =
-            p_cfg->fmt.i_height         = p_output->i_height;
+            if( p_sys->b_zero_copy )
+            {
+                /* The window is the visible area of the whole source */
+                p_cfg->fmt.i_x_offset       = p_output->i_left;
+                p_cfg->fmt.i_y_offset       = p_output->i_top;
+                p_cfg->fmt.i_visible_width  = p_output->i_width;
+                p_cfg->fmt.i_visible_height = p_output->i_height;
+            }
+            else
+            {
+                p_cfg->fmt.i_x_offset       =
+                p_cfg->fmt.i_y_offset       = 0;
+                p_cfg->fmt.i_visible_width  =
+                p_cfg->fmt.i_width          = p_output->i_width;
+                p_cfg->fmt.i_visible_height =
+                p_cfg->fmt.i_height         = p_output->i_height;
+            }
             p_cfg->fmt.i_sar_num        = p_splitter->fmt.i_sar_num;
             p_cfg->fmt.i_sar_den        = p_splitter->fmt.i_sar_den;
             p_cfg->window.i_x     = p_output->i_left;
             p_cfg->window.i_y     = p_output->i_top;
             p_cfg->window.i_align = p_output->i_align;
-            p_cfg->psz_module = NULL;
+            /* Only the OpenGL output displays any picture, by uploading it */
+            p_cfg->psz_module = p_sys->b_zero_copy ? strdup( "gl" ) : NULL;
         }
     }
 
@@ -383,6 +407,8 @@ static void Close( vlc_object_t *p_this )
     video_splitter_t *p_splitter = (video_splitter_t*)p_this;
     video_splitter_sys_t *p_sys = p_splitter->p_sys;
 
+    for( int i = 0; i < p_splitter->i_output; i++ )
+        free( p_splitter->p_output[i].psz_module );
     free( p_splitter->p_output );
     free( p_sys );
 }
@@ -391,6 +417,15 @@ static int Filter( video_splitter_t *p_splitter, picture_t *pp_dst[], picture_t
 {
     video_splitter_sys_t *p_sys = p_splitter->p_sys;
 
+    if( p_sys->b_zero_copy )
+    {
+        /* The outputs crop the source picture themselves */
+        for( int i = 0; i < p_splitter->i_output; i++ )
+            pp_dst[i] = picture_Hold( p_src );
+        picture_Release( p_src );
+        return VLC_SUCCESS;
+    }
+
     if( video_splitter_NewPicture( p_splitter, pp_dst ) )
     {
         picture_Release( p_src );
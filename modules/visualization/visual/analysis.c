@@ -0,0 +1,147 @@
+/*****************************************************************************
+ * analysis.c: audio analysis shared by the visualization effects
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <math.h>
+#include <assert.h>
+
+#include "analysis.h"
+
+int visual_analysis_Init( visual_analysis_t *p_ana, vlc_object_t *p_obj,
+                          unsigned i_nb_chans )
+{
+    window_param wind_param;
+
+    assert( i_nb_chans > 0 && i_nb_chans <= AOUT_CHAN_MAX );
+    p_ana->p_block = NULL;
+    p_ana->i_nb_chans = i_nb_chans;
+    p_ana->b_spectrum = p_ana->b_levels = false;
+
+    /* The tables are computed once, not for every block */
+    p_ana->p_state = visual_fft_init();
+    if( !p_ana->p_state )
+    {
+        msg_Err( p_obj, "unable to initialize FFT transform" );
+        return VLC_EGENERIC;
+    }
+
+    window_get_param( p_obj, &wind_param );
+    p_ana->wind_ctx.pf_window_table = NULL;
+    p_ana->wind_ctx.i_buffer_size = 0;
+    if( !window_init( FFT_BUFFER_SIZE, &wind_param, &p_ana->wind_ctx ) )
+    {
+        fft_close( p_ana->p_state );
+        msg_Err( p_obj, "unable to initialize FFT window" );
+        return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+void visual_analysis_Clean( visual_analysis_t *p_ana )
+{
+    window_close( &p_ana->wind_ctx );
+    fft_close( p_ana->p_state );
+}
+
+void visual_analysis_Reset( visual_analysis_t *p_ana, const block_t *p_block )
+{
+    p_ana->p_block = p_block;
+    p_ana->b_spectrum = p_ana->b_levels = false;
+}
+
+const float *visual_analysis_Spectrum( visual_analysis_t *p_ana )
+{
+    const block_t *p_block = p_ana->p_block;
+
+    if( p_ana->b_spectrum )
+        return p_ana->p_spectrum;
+    if( p_block == NULL || p_block->i_nb_samples == 0 )
+        return NULL;
+
+    /* Only the samples of the first channel going through the FFT are
+     * converted, repeating the block if it is too short */
+    const float *p_samples = (const float *)p_block->p_buffer;
+    int16_t p_buffer[FFT_BUFFER_SIZE];
+
+    for( unsigned i = 0, j = 0; i < FFT_BUFFER_SIZE; i++ )
+    {
+        /* Pasted from float32tos16.c */
+        union { float f; int32_t i; } u;
+        u.f = p_samples[j * p_ana->i_nb_chans] + 384.f;
+        if( u.i > 0x43c07fff )
+            p_buffer[i] = 32767;
+        else if( u.i < 0x43bf8000 )
+            p_buffer[i] = -32768;
+        else
+            p_buffer[i] = u.i - 0x43c00000;
+
+        if( ++j >= p_block->i_nb_samples )
+            j = 0;
+    }
+
+    /* Only the first half of the output is computed */
+    memset( p_ana->p_spectrum, 0, sizeof( p_ana->p_spectrum ) );
+    window_scale_in_place( p_buffer, &p_ana->wind_ctx );
+    fft_perform( p_buffer, p_ana->p_spectrum, p_ana->p_state );
+    p_ana->b_spectrum = true;
+    return p_ana->p_spectrum;
+}
+
+void visual_analysis_Levels( visual_analysis_t *p_ana, unsigned i_chan,
+                             float *pf_peak, float *pf_rms )
+{
+    const block_t *p_block = p_ana->p_block;
+    const unsigned i_nb_chans = p_ana->i_nb_chans;
+
+    assert( i_chan < i_nb_chans );
+    if( !p_ana->b_levels )
+    {
+        float pf_peak_acc[AOUT_CHAN_MAX] = { 0.f };
+        float pf_sum_acc[AOUT_CHAN_MAX] = { 0.f };
+        const unsigned i_nb_samples = p_block ? p_block->i_nb_samples : 0;
+        const float *p_sample = p_block ? (const float *)p_block->p_buffer : NULL;
+
+        /* All the channels in one pass; the inner loop has no branch so
+         * that it can be vectorized */
+        for( unsigned i = 0; i < i_nb_samples; i++, p_sample += i_nb_chans )
+            for( unsigned c = 0; c < i_nb_chans; c++ )
+            {
+                const float f = p_sample[c];
+                pf_peak_acc[c] = fmaxf( pf_peak_acc[c], fabsf( f ) );
+                pf_sum_acc[c] += f * f;
+            }
+
+        for( unsigned c = 0; c < i_nb_chans; c++ )
+        {
+            p_ana->pf_peak[c] = pf_peak_acc[c];
+            p_ana->pf_rms[c] = i_nb_samples ? sqrtf( pf_sum_acc[c] / i_nb_samples )
+                                            : 0.f;
+        }
+        p_ana->b_levels = true;
+    }
+
+    if( pf_peak )
+        *pf_peak = p_ana->pf_peak[i_chan];
+    if( pf_rms )
+        *pf_rms = p_ana->pf_rms[i_chan];
+}
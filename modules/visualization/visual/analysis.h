@@ -0,0 +1,64 @@
+/*****************************************************************************
+ * analysis.h: audio analysis shared by the visualization effects
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_VISUAL_ANALYSIS_H_
+#define VLC_VISUAL_ANALYSIS_H_
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_aout.h>
+
+#include "fft.h"
+#include "window.h"
+
+/* Analysis of the current FL32 block. Each result is computed the first
+ * time it is requested, then shared by all the effects drawing the block. */
+typedef struct
+{
+    const block_t  *p_block;
+    unsigned        i_nb_chans;
+
+    /* Spectrum of the first channel */
+    fft_state      *p_state;
+    window_context  wind_ctx;
+    bool            b_spectrum;
+    float           p_spectrum[FFT_BUFFER_SIZE];
+
+    /* Levels of each channel, in [0, 1] */
+    bool            b_levels;
+    float           pf_peak[AOUT_CHAN_MAX];
+    float           pf_rms[AOUT_CHAN_MAX];
+} visual_analysis_t;
+
+int  visual_analysis_Init( visual_analysis_t *, vlc_object_t *,
+                           unsigned i_nb_chans );
+void visual_analysis_Clean( visual_analysis_t * );
+
+/* Starts the analysis of a new block */
+void visual_analysis_Reset( visual_analysis_t *, const block_t * );
+
+/* Returns the windowed FFT (squared magnitudes) of the first channel */
+const float *visual_analysis_Spectrum( visual_analysis_t * );
+
+/* Returns the peak and RMS levels of a channel */
+void visual_analysis_Levels( visual_analysis_t *, unsigned i_chan,
+                             float *pf_peak, float *pf_rms );
+
+#endif /* include-guard */
@@ -184,6 +184,8 @@ struct filter_sys_t
     visual_effect_t **effect;
     int             i_effect;
     vlc_thread_t    thread;
+
+    visual_analysis_t analysis;
 };
 
 /*****************************************************************************
@@ -213,6 +215,14 @@ static int Open( vlc_object_t *p_this )
     p_sys->i_effect = 0;
     p_sys->effect   = NULL;
 
+    /* The effects share the analysis of each block */
+    if( visual_analysis_Init( &p_sys->analysis, VLC_OBJECT(p_filter),
+                              aout_FormatNbChannels( &p_filter->fmt_in.audio ) ) )
+    {
+        free( p_sys );
+        return VLC_EGENERIC;
+    }
+
     /* Parse the effect list */
     psz_parser = psz_effects = var_CreateGetString( p_filter, "effect-list" );
 
@@ -230,6 +240,7 @@ static int Open( vlc_object_t *p_this )
         p_effect->i_idx_right = __MIN( 1, p_effect->i_nb_chans-1 );
 
         p_effect->p_data   = NULL;
+        p_effect->p_analysis = &p_sys->analysis;
         p_effect->pf_run   = NULL;
 
         for( unsigned i = 0; i < effectc; i++ )
@@ -330,6 +341,7 @@ error:
     for( int i = 0; i < p_sys->i_effect; i++ )
         free( p_sys->effect[i] );
     free( p_sys->effect );
+    visual_analysis_Clean( &p_sys->analysis );
     free( p_sys );
     return VLC_EGENERIC;
 }
@@ -351,6 +363,7 @@ static block_t *DoRealWork( filter_t *p_filter, block_t *p_in_buf )
     }
 
     /* We can now call our visualization effects */
+    visual_analysis_Reset( &p_sys->analysis, p_in_buf );
     for( int i = 0; i < p_sys->i_effect; i++ )
     {
 #define p_effect p_sys->effect[i]
@@ -415,5 +428,6 @@ static void Close( vlc_object_t *p_this )
     }
 
     free( p_sys->effect );
+    visual_analysis_Clean( &p_sys->analysis );
     free( p_sys );
 }
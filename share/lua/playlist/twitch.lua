@@ -21,6 +21,9 @@ Resolve Twitch channel and video URLs to the actual stream URL
  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
 --]]
 
+-- Hosts handled by this script, checked before probe() is called
+probe_hosts = { "www.twitch.tv", "go.twitch.tv" }
+
 -- Probe function
 function probe()
     return (vlc.access == "http" or vlc.access == "https")
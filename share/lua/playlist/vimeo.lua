@@ -22,6 +22,9 @@
  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
 --]]
 
+-- Hosts handled by this script, checked before probe() is called
+probe_hosts = { "vimeo.com", "player.vimeo.com" }
+
 -- Probe function.
 function probe()
     local path = vlc.path
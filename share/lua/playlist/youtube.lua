@@ -224,6 +224,9 @@ function pick_url( url_map, fmt, js_url )
     return path
 end
 
+-- Hosts handled by this script, checked before probe() is called
+probe_hosts = { "www.youtube.com" }
+
 -- Probe function.
 function probe()
     return ( ( vlc.access == "http" or vlc.access == "https" )
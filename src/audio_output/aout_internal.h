@@ -25,6 +25,7 @@
 # define LIBVLC_AOUT_INTERNAL_H 1
 
 # include <vlc_atomic.h>
+# include <vlc_input_item.h>
 # include <vlc_viewpoint.h>
 
 /* Max input rate factor (1/4 -> 4) */
@@ -94,8 +95,34 @@ typedef struct
     atomic_uint buffers_lost;
     atomic_uint buffers_played;
     atomic_uchar restart;
+
+    /* Synchronization statistics, written with the output lock held */
+    struct
+    {
+        atomic_uint underruns;
+        atomic_uint silences;
+        atomic_uint drift[INPUT_STATS_DRIFT_BUCKETS];
+        atomic_uint_least64_t drift_max;
+        atomic_int_least64_t drift_last;
+        atomic_int_least64_t latency;
+        atomic_int resampling;
+    } stats;
 } aout_owner_t;
 
+/* Audio output statistics, the counters being reset when they are read */
+typedef struct
+{
+    unsigned lost; /**< Dropped buffers */
+    unsigned played; /**< Played buffers */
+    unsigned underruns; /**< Flushes of a late output */
+    unsigned silences; /**< Silences inserted before an early output */
+    unsigned drift[INPUT_STATS_DRIFT_BUCKETS]; /**< Absolute drifts histogram */
+    mtime_t drift_max; /**< Largest absolute drift */
+    mtime_t drift_last; /**< Last measured drift (gauge) */
+    mtime_t latency; /**< Last measured output latency (gauge) */
+    int resampling; /**< Current resampling adjustment in Hz (gauge) */
+} aout_stats_t;
+
 typedef struct
 {
     audio_output_t output;
@@ -154,7 +181,7 @@ int aout_DecNew(audio_output_t *, const audio_sample_format_t *,
                 const audio_replay_gain_t *, const aout_request_vout_t *);
 void aout_DecDelete(audio_output_t *);
 int aout_DecPlay(audio_output_t *, block_t *, int i_input_rate);
-void aout_DecGetResetStats(audio_output_t *, unsigned *, unsigned *);
+void aout_DecGetResetStats(audio_output_t *, aout_stats_t *);
 void aout_DecChangePause(audio_output_t *, bool b_paused, mtime_t i_date);
 void aout_DecFlush(audio_output_t *, bool wait);
 void aout_RequestRestart (audio_output_t *, unsigned);
@@ -33,6 +33,7 @@
 #include <vlc_common.h>
 #include <vlc_aout.h>
 #include <vlc_input.h>
+#include <vlc_trace.h>
 
 #include "aout_internal.h"
 #include "libvlc.h"
@@ -112,6 +113,14 @@ error:
 
     atomic_init (&owner->buffers_lost, 0);
     atomic_init (&owner->buffers_played, 0);
+    atomic_init (&owner->stats.underruns, 0);
+    atomic_init (&owner->stats.silences, 0);
+    for (unsigned i = 0; i < INPUT_STATS_DRIFT_BUCKETS; i++)
+        atomic_init (&owner->stats.drift[i], 0);
+    atomic_init (&owner->stats.drift_max, 0);
+    atomic_init (&owner->stats.drift_last, 0);
+    atomic_init (&owner->stats.latency, 0);
+    atomic_init (&owner->stats.resampling, 0);
     atomic_store (&owner->vp.update, true);
     return 0;
 }
@@ -209,6 +218,31 @@ static void aout_StopResampling (audio_output_t *aout)
 
     owner->sync.resamp_type = AOUT_RESAMPLING_NONE;
     aout_FiltersAdjustResampling (owner->filters, 0);
+    atomic_store_explicit (&owner->stats.resampling, 0, memory_order_relaxed);
+}
+
+/* Keeps the measured output latency and drift */
+static void aout_DecUpdateStats (aout_owner_t *owner, mtime_t latency,
+                                 mtime_t drift)
+{
+    const uint64_t d = llabs (drift);
+
+    /* Bucket i counts the drifts below INPUT_STATS_DRIFT_LIMIT(i) */
+    unsigned i = 0;
+    while (i < INPUT_STATS_DRIFT_BUCKETS - 1
+        && d >= (uint64_t)INPUT_STATS_DRIFT_LIMIT(i))
+        i++;
+
+    atomic_fetch_add_explicit (&owner->stats.drift[i], 1,
+                               memory_order_relaxed);
+    if (d > atomic_load_explicit (&owner->stats.drift_max,
+                                  memory_order_relaxed))
+        atomic_store_explicit (&owner->stats.drift_max, d,
+                               memory_order_relaxed);
+    atomic_store_explicit (&owner->stats.drift_last, drift,
+                           memory_order_relaxed);
+    atomic_store_explicit (&owner->stats.latency, latency,
+                           memory_order_relaxed);
 }
 
 static void aout_DecSilence (audio_output_t *aout, mtime_t length, mtime_t pts)
@@ -223,6 +257,8 @@ static void aout_DecSilence (audio_output_t *aout, mtime_t length, mtime_t pts)
         return; /* uho! */
 
     msg_Dbg (aout, "inserting %zu zeroes", frames);
+    atomic_fetch_add_explicit (&owner->stats.silences, 1,
+                               memory_order_relaxed);
     memset (block->p_buffer, 0, block->i_buffer);
     block->i_nb_samples = frames;
     block->i_pts = pts;
@@ -255,7 +291,9 @@ static void aout_DecSynchronize (audio_output_t *aout, mtime_t dec_pts,
      */
     if (aout_OutputTimeGet (aout, &drift) != 0)
         return; /* nothing can be done if timing is unknown */
+    const mtime_t latency = drift;
     drift += mdate () - dec_pts;
+    aout_DecUpdateStats (owner, latency, drift);
 
     /* Late audio output.
      * This can happen due to insufficient caching, scheduling jitter
@@ -273,6 +311,8 @@ static void aout_DecSynchronize (audio_output_t *aout, mtime_t dec_pts,
             msg_Dbg (aout, "playback too late (%"PRId64"): "
                      "flushing buffers", drift);
         aout_OutputFlush (aout, false);
+        atomic_fetch_add_explicit (&owner->stats.underruns, 1,
+                                   memory_order_relaxed);
 
         aout_StopResampling (aout);
         owner->sync.end = VLC_TS_INVALID;
@@ -345,8 +385,13 @@ static void aout_DecSynchronize (audio_output_t *aout, mtime_t dec_pts,
     if (!aout_FiltersAdjustResampling (owner->filters, adj))
     {   /* Everything is back to normal: stop resampling. */
         owner->sync.resamp_type = AOUT_RESAMPLING_NONE;
+        atomic_store_explicit (&owner->stats.resampling, 0,
+                               memory_order_relaxed);
         msg_Dbg (aout, "resampling stopped (drift: %"PRId64" us)", drift);
     }
+    else
+        atomic_fetch_add_explicit (&owner->stats.resampling, adj,
+                                   memory_order_relaxed);
 }
 
 /*****************************************************************************
@@ -356,6 +401,8 @@ int aout_DecPlay (audio_output_t *aout, block_t *block, int input_rate)
 {
     aout_owner_t *owner = aout_owner (aout);
 
+    vlc_trace_Scope("aout play");
+
     assert (input_rate >= INPUT_RATE_DEFAULT / AOUT_MAX_INPUT_RATE);
     assert (input_rate <= INPUT_RATE_DEFAULT * AOUT_MAX_INPUT_RATE);
     assert (block->i_pts >= VLC_TS_0);
@@ -418,13 +465,20 @@ lost:
     goto out;
 }
 
-void aout_DecGetResetStats(audio_output_t *aout, unsigned *restrict lost,
-                           unsigned *restrict played)
+void aout_DecGetResetStats(audio_output_t *aout, aout_stats_t *stats)
 {
     aout_owner_t *owner = aout_owner (aout);
 
-    *lost = atomic_exchange(&owner->buffers_lost, 0);
-    *played = atomic_exchange(&owner->buffers_played, 0);
+    stats->lost = atomic_exchange(&owner->buffers_lost, 0);
+    stats->played = atomic_exchange(&owner->buffers_played, 0);
+    stats->underruns = atomic_exchange(&owner->stats.underruns, 0);
+    stats->silences = atomic_exchange(&owner->stats.silences, 0);
+    for (unsigned i = 0; i < INPUT_STATS_DRIFT_BUCKETS; i++)
+        stats->drift[i] = atomic_exchange(&owner->stats.drift[i], 0);
+    stats->drift_max = atomic_exchange(&owner->stats.drift_max, 0);
+    stats->drift_last = atomic_load(&owner->stats.drift_last);
+    stats->latency = atomic_load(&owner->stats.latency);
+    stats->resampling = atomic_load(&owner->stats.resampling);
 }
 
 void aout_DecChangePause (audio_output_t *aout, bool paused, mtime_t date)
@@ -99,6 +99,11 @@
 /* Due to some problems in es_out, we cannot use a large value yet */
 #define CR_BUFFERING_TARGET (100000)
 
+/* Duration and minimal number of clock references over which the margin
+ * before lateness is measured */
+#define CR_MARGIN_WINDOW (5 * CLOCK_FREQ)
+#define CR_MARGIN_COUNT  (16)
+
 /*****************************************************************************
  * Structures
  *****************************************************************************/
@@ -165,6 +170,17 @@ struct input_clock_t
         unsigned i_index;
     } late;
 
+    /* Margin statistics: how long before being late the clock references
+     * arrive, and how much this varies */
+    struct
+    {
+        mtime_t  i_start;  /* start of the current window */
+        mtime_t  i_min;    /* smallest margin of the current window */
+        mtime_t  i_last;
+        mtime_t  i_jitter; /* smoothed variation of the margin */
+        unsigned i_count;
+    } margin;
+
     /* Reference point */
     clock_point_t ref;
     bool          b_has_reference;
@@ -184,6 +200,7 @@ static mtime_t ClockStreamToSystem( input_clock_t *, mtime_t i_stream );
 static mtime_t ClockSystemToStream( input_clock_t *, mtime_t i_system );
 
 static mtime_t ClockGetTsOffset( input_clock_t * );
+static void    ClockResetMargin( input_clock_t *, bool b_jitter );
 
 /*****************************************************************************
  * input_clock_New: create a new clock
@@ -212,6 +229,8 @@ input_clock_t *input_clock_New( int i_rate )
     for( int i = 0; i < INPUT_CLOCK_LATE_COUNT; i++ )
         cl->late.pi_value[i] = 0;
 
+    ClockResetMargin( cl, true );
+
     cl->i_rate = i_rate;
     cl->i_pts_delay = 0;
     cl->b_paused = false;
@@ -278,6 +297,7 @@ void input_clock_Update( input_clock_t *cl, vlc_object_t *p_log,
         cl->ref = clock_point_Create( i_ck_stream,
                                       __MAX( cl->i_ts_max + CR_MEAN_PTS_GAP, i_ck_system ) );
         cl->b_has_external_clock = false;
+        ClockResetMargin( cl, true );
     }
 
     /* Compute the drift between the stream clock and the system clock
@@ -323,6 +343,25 @@ void input_clock_Update( input_clock_t *cl, vlc_object_t *p_log,
         cl->late.i_index = ( cl->late.i_index + 1 ) % INPUT_CLOCK_LATE_COUNT;
     }
 
+    /* Update the margin statistics */
+    const mtime_t i_margin = -i_late;
+    if( cl->margin.i_start == VLC_TS_INVALID )
+    {
+        cl->margin.i_start = i_ck_system;
+        cl->margin.i_min = i_margin;
+        cl->margin.i_count = 0;
+    }
+    else
+    {
+        const mtime_t i_delta = i_margin - cl->margin.i_last;
+
+        cl->margin.i_jitter += ( ( i_delta < 0 ? -i_delta : i_delta )
+                                 - cl->margin.i_jitter ) / 16;
+        cl->margin.i_min = __MIN( cl->margin.i_min, i_margin );
+    }
+    cl->margin.i_last = i_margin;
+    cl->margin.i_count++;
+
     vlc_mutex_unlock( &cl->lock );
 }
 
@@ -337,6 +376,7 @@ void input_clock_Reset( input_clock_t *cl )
     cl->ref = clock_point_Create( VLC_TS_INVALID, VLC_TS_INVALID );
     cl->b_has_external_clock = false;
     cl->i_ts_max = VLC_TS_INVALID;
+    ClockResetMargin( cl, true );
 
     vlc_mutex_unlock( &cl->lock );
 }
@@ -564,7 +604,10 @@ void input_clock_SetJitter( input_clock_t *cl,
      * TODO when increasing -> force rebuffering
      */
     if( cl->i_pts_delay < i_pts_delay )
+    {
         cl->i_pts_delay = i_pts_delay;
+        ClockResetMargin( cl, false );
+    }
 
     /* */
     if( i_cr_average < 10 )
@@ -598,6 +641,46 @@ mtime_t input_clock_GetJitter( input_clock_t *cl )
     return i_pts_delay + i_late_median;
 }
 
+void input_clock_ReduceDelay( input_clock_t *cl, mtime_t i_pts_delay )
+{
+    vlc_mutex_lock( &cl->lock );
+
+    if( i_pts_delay < cl->i_pts_delay )
+    {
+        cl->i_pts_delay = i_pts_delay;
+
+        /* The late observations predate the reduction */
+        for( int i = 0; i < INPUT_CLOCK_LATE_COUNT; i++ )
+            cl->late.pi_value[i] = 0;
+        cl->late.i_index = 0;
+        ClockResetMargin( cl, false );
+    }
+
+    vlc_mutex_unlock( &cl->lock );
+}
+
+int input_clock_GetMargin( input_clock_t *cl,
+                           mtime_t *pi_margin, mtime_t *pi_jitter )
+{
+    int i_ret = VLC_EGENERIC;
+
+    vlc_mutex_lock( &cl->lock );
+
+    if( cl->margin.i_start != VLC_TS_INVALID
+     && cl->last.i_system - cl->margin.i_start >= CR_MARGIN_WINDOW
+     && cl->margin.i_count >= CR_MARGIN_COUNT )
+    {
+        *pi_margin = cl->margin.i_min;
+        *pi_jitter = cl->margin.i_jitter;
+        ClockResetMargin( cl, false );
+        i_ret = VLC_SUCCESS;
+    }
+
+    vlc_mutex_unlock( &cl->lock );
+
+    return i_ret;
+}
+
 /*****************************************************************************
  * ClockStreamToSystem: converts a movie clock to system date
  *****************************************************************************/
@@ -626,6 +709,16 @@ static mtime_t ClockSystemToStream( input_clock_t *cl, mtime_t i_system )
  * It returns timestamp display offset due to ref/last modfied on rate changes
  * It ensures that currently converted dates are not changed.
  */
+/*****************************************************************************
+ * ClockResetMargin: starts a new margin window
+ *****************************************************************************/
+static void ClockResetMargin( input_clock_t *cl, bool b_jitter )
+{
+    cl->margin.i_start = VLC_TS_INVALID;
+    if( b_jitter )
+        cl->margin.i_jitter = 0;
+}
+
 static mtime_t ClockGetTsOffset( input_clock_t *cl )
 {
     return cl->i_pts_delay * ( cl->i_rate - INPUT_RATE_DEFAULT ) / INPUT_RATE_DEFAULT;
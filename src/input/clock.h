@@ -136,4 +136,19 @@ void input_clock_SetJitter( input_clock_t *,
  */
 mtime_t input_clock_GetJitter( input_clock_t * );
 
+/**
+ * This function lowers the pts delay to the given value, if it is smaller
+ * than the current one.
+ */
+void input_clock_ReduceDelay( input_clock_t *, mtime_t i_pts_delay );
+
+/**
+ * This function returns the smallest margin before lateness of the clock
+ * references and their smoothed jitter, once they have been measured over
+ * a long enough window, and starts a new window. Otherwise it returns
+ * VLC_EGENERIC.
+ */
+int input_clock_GetMargin( input_clock_t *, mtime_t *pi_margin,
+                           mtime_t *pi_jitter );
+
 #endif
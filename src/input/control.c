@@ -573,6 +573,19 @@ int input_vaControl( input_thread_t *p_input, int i_query, va_list args )
             return es_out_ControlModifyPcrSystem( priv->p_es_out_display, b_absolute, i_system );
         }
 
+        case INPUT_SET_STANDBY:
+            b_bool = va_arg( args, int );
+            if( b_bool )
+            {
+                if( priv->is_running )
+                    return VLC_EGENERIC;
+                priv->b_standby = true;
+                es_out_SetStandby( priv->p_es_out_display, true );
+            }
+            else
+                input_ControlPush( p_input, INPUT_CONTROL_LEAVE_STANDBY, NULL );
+            return VLC_SUCCESS;
+
         case INPUT_SET_RENDERER:
         {
             vlc_renderer_item_t* p_item = va_arg( args, vlc_renderer_item_t* );
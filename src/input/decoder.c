@@ -43,6 +43,7 @@
 #include <vlc_meta.h>
 #include <vlc_dialog.h>
 #include <vlc_modules.h>
+#include <vlc_trace.h>
 
 #include "audio_output/aout_internal.h"
 #include "stream_output/stream_output.h"
@@ -109,6 +110,10 @@ struct decoder_owner_sys_t
 
     vout_thread_t   *p_vout;
 
+    /* Late display totals at the previous decoder_GetLoad() call */
+    uint64_t         load_late_count;
+    uint64_t         load_late_sum;
+
     /* -- Theses variables need locking on read *and* write -- */
     /* Preroll */
     int64_t i_preroll_end;
@@ -130,6 +135,13 @@ struct decoder_owner_sys_t
     atomic_bool drained;
     bool b_idle;
 
+    /* Standby: the blocks are kept instead of being decoded. Only the
+     * decoder thread accesses the kept blocks. */
+    atomic_bool standby;
+    block_t    *p_standby;
+    block_t   **pp_standby_last;
+    size_t      i_standby_size;
+
     /* CC */
 #define MAX_CC_DECODERS 64 /* The es_out only creates one type of es */
     struct
@@ -149,6 +161,8 @@ struct decoder_owner_sys_t
 
 /* */
 #define DECODER_SPU_VOUT_WAIT_DURATION ((int)(0.200*CLOCK_FREQ))
+/* Video data kept at most while on standby, when there are no key frames */
+#define DECODER_STANDBY_MAX_SIZE (16*1024*1024)
 #define BLOCK_FLAG_CORE_PRIVATE_RELOADED (1 << BLOCK_FLAG_CORE_PRIVATE_SHIFT)
 
 /**
@@ -638,6 +652,39 @@ static int DecoderGetDisplayRate( decoder_t *p_dec )
     return input_clock_GetRate( p_owner->p_clock );
 }
 
+/* Only called by the decoder thread, the only one changing the vout */
+static int DecoderGetLoad( decoder_t *p_dec, decoder_load_t *p_load )
+{
+    decoder_owner_sys_t *p_owner = p_dec->p_owner;
+
+    vlc_fifo_Lock( p_owner->p_fifo );
+    p_load->i_queued = vlc_fifo_GetCount( p_owner->p_fifo );
+    vlc_fifo_Unlock( p_owner->p_fifo );
+    p_load->i_displayed = 0;
+    p_load->i_late = 0;
+
+    if( p_owner->p_vout == NULL )
+        return VLC_SUCCESS;
+
+    vout_timing_t timing;
+    vout_GetTiming( p_owner->p_vout, &timing );
+
+    /* The vout may have been recycled in between */
+    if( timing.late.count >= p_owner->load_late_count
+     && timing.late.sum >= p_owner->load_late_sum )
+    {
+        uint64_t count = timing.late.count - p_owner->load_late_count;
+        if( count > 0 )
+        {
+            p_load->i_displayed = count;
+            p_load->i_late = (timing.late.sum - p_owner->load_late_sum) / count;
+        }
+    }
+    p_owner->load_late_count = timing.late.count;
+    p_owner->load_late_sum = timing.late.sum;
+    return VLC_SUCCESS;
+}
+
 /*****************************************************************************
  * Public functions
  *****************************************************************************/
@@ -703,6 +750,15 @@ int decoder_GetDisplayRate( decoder_t *p_dec )
 
     return p_dec->pf_get_display_rate( p_dec );
 }
+/* decoder_GetLoad:
+ */
+int decoder_GetLoad( decoder_t *p_dec, decoder_load_t *p_load )
+{
+    if( !p_dec->pf_get_load )
+        return VLC_EGENERIC;
+
+    return p_dec->pf_get_load( p_dec, p_load );
+}
 
 void decoder_AbortPictures( decoder_t *p_dec, bool b_abort )
 {
@@ -984,6 +1040,9 @@ static int DecoderPlayVideo( decoder_t *p_dec, picture_t *p_picture,
     vout_thread_t  *p_vout = p_owner->p_vout;
     bool prerolled;
 
+    /* The picture date is still in the stream time base */
+    vlc_trace_Flow( END, "video", p_picture->date );
+
     vlc_mutex_lock( &p_owner->lock );
     if( p_owner->i_preroll_end > p_picture->date )
     {
@@ -1093,11 +1152,9 @@ static void DecoderUpdateStatVideo( decoder_owner_sys_t *p_owner,
         lost += vout_lost;
     }
 
-    vlc_mutex_lock( &input_priv(p_input)->counters.counters_lock );
-    stats_Update( input_priv(p_input)->counters.p_decoded_video, decoded, NULL );
-    stats_Update( input_priv(p_input)->counters.p_lost_pictures, lost , NULL);
-    stats_Update( input_priv(p_input)->counters.p_displayed_pictures, displayed, NULL);
-    vlc_mutex_unlock( &input_priv(p_input)->counters.counters_lock );
+    stats_Update( input_priv(p_input)->counters.p_decoded_video, decoded );
+    stats_Update( input_priv(p_input)->counters.p_lost_pictures, lost );
+    stats_Update( input_priv(p_input)->counters.p_displayed_pictures, displayed );
 }
 
 static int DecoderQueueVideo( decoder_t *p_dec, picture_t *p_pic )
@@ -1120,6 +1177,8 @@ static int DecoderPlayAudio( decoder_t *p_dec, block_t *p_audio,
 
     assert( p_audio != NULL );
 
+    vlc_trace_Flow( END, "audio", p_audio->i_pts );
+
     vlc_mutex_lock( &p_owner->lock );
     if( p_owner->i_preroll_end > p_audio->i_pts )
     {
@@ -1199,7 +1258,7 @@ static void DecoderUpdateStatAudio( decoder_owner_sys_t *p_owner,
                                     unsigned decoded, unsigned lost )
 {
     input_thread_t *p_input = p_owner->p_input;
-    unsigned played = 0;
+    aout_stats_t aout_stats = { .played = 0 };
 
     /* Update ugly stat */
     if( p_input == NULL )
@@ -1207,17 +1266,27 @@ static void DecoderUpdateStatAudio( decoder_owner_sys_t *p_owner,
 
     if( p_owner->p_aout != NULL )
     {
-        unsigned aout_lost;
-
-        aout_DecGetResetStats( p_owner->p_aout, &aout_lost, &played );
-        lost += aout_lost;
+        aout_DecGetResetStats( p_owner->p_aout, &aout_stats );
+        lost += aout_stats.lost;
     }
 
-    vlc_mutex_lock( &input_priv(p_input)->counters.counters_lock);
-    stats_Update( input_priv(p_input)->counters.p_lost_abuffers, lost, NULL );
-    stats_Update( input_priv(p_input)->counters.p_played_abuffers, played, NULL );
-    stats_Update( input_priv(p_input)->counters.p_decoded_audio, decoded, NULL );
-    vlc_mutex_unlock( &input_priv(p_input)->counters.counters_lock);
+    input_thread_private_t *priv = input_priv(p_input);
+
+    stats_Update( priv->counters.p_lost_abuffers, lost );
+    stats_Update( priv->counters.p_played_abuffers, aout_stats.played );
+    stats_Update( priv->counters.p_decoded_audio, decoded );
+    if( p_owner->p_aout != NULL )
+    {
+        stats_Update( priv->counters.p_aout_latency, aout_stats.latency );
+        stats_Update( priv->counters.p_aout_drift, aout_stats.drift_last );
+        stats_Update( priv->counters.p_aout_drift_max, aout_stats.drift_max );
+        stats_Update( priv->counters.p_aout_resampling, aout_stats.resampling );
+        stats_Update( priv->counters.p_aout_underruns, aout_stats.underruns );
+        stats_Update( priv->counters.p_aout_silences, aout_stats.silences );
+        for( unsigned i = 0; i < INPUT_STATS_DRIFT_BUCKETS; i++ )
+            stats_Update( priv->counters.pp_aout_drift_buckets[i],
+                          aout_stats.drift[i] );
+    }
 }
 
 static int DecoderQueueAudio( decoder_t *p_dec, block_t *p_aout_buf )
@@ -1282,11 +1351,7 @@ static int DecoderQueueSpu( decoder_t *p_dec, subpicture_t *p_spu )
     input_thread_t *p_input = p_owner->p_input;
 
     if( p_input != NULL )
-    {
-        vlc_mutex_lock( &input_priv(p_input)->counters.counters_lock );
-        stats_Update( input_priv(p_input)->counters.p_decoded_sub, 1, NULL );
-        vlc_mutex_unlock( &input_priv(p_input)->counters.counters_lock );
-    }
+        stats_Update( input_priv(p_input)->counters.p_decoded_sub, 1 );
 
     int i_ret = -1;
     vout_thread_t *p_vout = input_resource_HoldVout( p_owner->p_resource );
@@ -1317,6 +1382,73 @@ static int DecoderQueueSpu( decoder_t *p_dec, subpicture_t *p_spu )
     return i_ret;
 }
 
+static void DecoderStandbyRelease( decoder_owner_sys_t *p_owner )
+{
+    block_ChainRelease( p_owner->p_standby );
+    p_owner->p_standby = NULL;
+    p_owner->pp_standby_last = &p_owner->p_standby;
+    p_owner->i_standby_size = 0;
+}
+
+/**
+ * Keeps a block instead of decoding it while on standby
+ *
+ * For video, the blocks from the last key frame on are kept, so that the
+ * decoding can resume at once when leaving the standby. The other blocks
+ * are dropped, the decoding resumes with the next one.
+ *
+ * \return true if the block was consumed
+ */
+static bool DecoderStandby( decoder_t *p_dec, block_t *p_block )
+{
+    decoder_owner_sys_t *p_owner = p_dec->p_owner;
+
+    if( !atomic_load( &p_owner->standby ) )
+        return false;
+
+    /* Do not hold the buffering of the input */
+    vlc_mutex_lock( &p_owner->lock );
+    if( p_owner->b_waiting )
+    {
+        p_owner->b_has_data = true;
+        vlc_cond_signal( &p_owner->wait_acknowledge );
+    }
+    vlc_mutex_unlock( &p_owner->lock );
+
+    if( p_dec->fmt_in.i_cat != VIDEO_ES )
+    {
+        block_Release( p_block );
+        return true;
+    }
+
+    if( p_block->i_flags & BLOCK_FLAG_TYPE_I )
+        DecoderStandbyRelease( p_owner );
+    else if( p_owner->p_standby == NULL
+          && ( p_block->i_flags & BLOCK_FLAG_TYPE_MASK ) )
+    {   /* Not decodable without the previous key frame */
+        block_Release( p_block );
+        return true;
+    }
+
+    /* Without key frames, keep the most recent data only */
+    while( p_owner->p_standby != NULL
+        && p_owner->i_standby_size + p_block->i_buffer > DECODER_STANDBY_MAX_SIZE )
+    {
+        block_t *p_old = p_owner->p_standby;
+
+        p_owner->p_standby = p_old->p_next;
+        if( p_owner->p_standby == NULL )
+            p_owner->pp_standby_last = &p_owner->p_standby;
+        p_owner->i_standby_size -= p_old->i_buffer;
+        block_Release( p_old );
+    }
+
+    *p_owner->pp_standby_last = p_block;
+    p_owner->pp_standby_last = &p_block->p_next;
+    p_owner->i_standby_size += p_block->i_buffer;
+    return true;
+}
+
 static void DecoderProcess( decoder_t *p_dec, block_t *p_block );
 static void DecoderDecode( decoder_t *p_dec, block_t *p_block )
 {
@@ -1358,6 +1490,11 @@ static void DecoderProcess( decoder_t *p_dec, block_t *p_block )
 {
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
 
+    vlc_trace_Scope( "decode" );
+    if( p_block != NULL )
+        vlc_trace_Flow( STEP, vlc_trace_FlowName( p_dec->fmt_in.i_cat ),
+                        p_block->i_pts );
+
     if( p_owner->error )
         goto error;
 
@@ -1430,7 +1567,8 @@ static void DecoderProcess( decoder_t *p_dec, block_t *p_block )
                 block_t *p_next = p_packetized_block->p_next;
                 p_packetized_block->p_next = NULL;
 
-                DecoderDecode( p_dec, p_packetized_block );
+                if( !DecoderStandby( p_dec, p_packetized_block ) )
+                    DecoderDecode( p_dec, p_packetized_block );
                 if( p_owner->error )
                 {
                     block_ChainRelease( p_next );
@@ -1444,7 +1582,7 @@ static void DecoderProcess( decoder_t *p_dec, block_t *p_block )
         if( !pp_block )
             DecoderDecode( p_dec, NULL );
     }
-    else
+    else if( p_block == NULL || !DecoderStandby( p_dec, p_block ) )
         DecoderDecode( p_dec, p_block );
     return;
 
@@ -1467,6 +1605,8 @@ static void DecoderProcessFlush( decoder_t *p_dec )
     if ( p_dec->pf_flush != NULL )
         p_dec->pf_flush( p_dec );
 
+    DecoderStandbyRelease( p_owner );
+
     /* flush CC sub decoders */
     if( p_owner->cc.b_supported )
     {
@@ -1580,6 +1720,34 @@ static void *DecoderThread( void *p_data )
             continue;
         }
 
+        if( p_owner->p_standby != NULL && !atomic_load( &p_owner->standby ) )
+        {   /* Decode the blocks kept on standby before the queued ones */
+            block_t *p_chain = p_owner->p_standby;
+            int canc = vlc_savecancel();
+
+            p_owner->p_standby = NULL;
+            p_owner->pp_standby_last = &p_owner->p_standby;
+            p_owner->i_standby_size = 0;
+            vlc_fifo_Unlock( p_owner->p_fifo );
+
+            msg_Dbg( p_dec, "leaving standby" );
+            while( p_chain != NULL )
+            {
+                block_t *p_next = p_chain->p_next;
+
+                p_chain->p_next = NULL;
+                if( p_owner->error )
+                    block_Release( p_chain );
+                else
+                    DecoderDecode( p_dec, p_chain );
+                p_chain = p_next;
+            }
+
+            vlc_fifo_Lock( p_owner->p_fifo );
+            vlc_restorecancel( canc );
+            continue;
+        }
+
         vlc_cond_signal( &p_owner->wait_fifo );
         vlc_testcancel(); /* forced expedited cancellation in case of stop */
 
@@ -1660,6 +1828,8 @@ static decoder_t * CreateDecoder( vlc_object_t *p_parent,
     p_owner->p_resource = p_resource;
     p_owner->p_aout = NULL;
     p_owner->p_vout = NULL;
+    p_owner->load_late_count = 0;
+    p_owner->load_late_sum = 0;
     p_owner->p_spu_vout = NULL;
     p_owner->i_spu_channel = 0;
     p_owner->i_spu_order = 0;
@@ -1686,6 +1856,11 @@ static decoder_t * CreateDecoder( vlc_object_t *p_parent,
     atomic_init( &p_owner->reload, RELOAD_NO_REQUEST );
     p_owner->b_idle = false;
 
+    atomic_init( &p_owner->standby, false );
+    p_owner->p_standby = NULL;
+    p_owner->pp_standby_last = &p_owner->p_standby;
+    p_owner->i_standby_size = 0;
+
     es_format_Init( &p_owner->fmt, fmt->i_cat, 0 );
 
     /* decoder fifo */
@@ -1712,6 +1887,7 @@ static decoder_t * CreateDecoder( vlc_object_t *p_parent,
     p_dec->pf_get_attachments  = DecoderGetInputAttachments;
     p_dec->pf_get_display_date = DecoderGetDisplayDate;
     p_dec->pf_get_display_rate = DecoderGetDisplayRate;
+    p_dec->pf_get_load = DecoderGetLoad;
 
     /* Load a packetizer module if the input is not already packetized */
     if( p_sout == NULL && !fmt->b_packetized )
@@ -1804,6 +1980,7 @@ static void DeleteDecoder( decoder_t * p_dec )
 
     /* Free all packets still in the decoder fifo. */
     block_FifoRelease( p_owner->p_fifo );
+    block_ChainRelease( p_owner->p_standby );
 
     /* Cleanup */
     if( p_owner->p_aout )
@@ -2039,6 +2216,10 @@ void input_DecoderDecode( decoder_t *p_dec, block_t *p_block, bool b_do_pace )
     }
 
     vlc_fifo_QueueUnlocked( p_owner->p_fifo, p_block );
+    vlc_trace_Counter( p_dec->fmt_in.i_cat == VIDEO_ES ? "video fifo" :
+                       p_dec->fmt_in.i_cat == AUDIO_ES ? "audio fifo" :
+                                                         "spu fifo",
+                       vlc_fifo_GetCount( p_owner->p_fifo ) );
     vlc_fifo_Unlock( p_owner->p_fifo );
 }
 
@@ -2249,6 +2430,17 @@ void input_DecoderChangeDelay( decoder_t *p_dec, mtime_t i_delay )
     vlc_mutex_unlock( &p_owner->lock );
 }
 
+void input_DecoderSetStandby( decoder_t *p_dec, bool b_standby )
+{
+    decoder_owner_sys_t *p_owner = p_dec->p_owner;
+
+    vlc_fifo_Lock( p_owner->p_fifo );
+    atomic_store( &p_owner->standby, b_standby );
+    /* Wake the decoder thread up to decode the kept blocks */
+    vlc_fifo_Signal( p_owner->p_fifo );
+    vlc_fifo_Unlock( p_owner->p_fifo );
+}
+
 void input_DecoderStartWait( decoder_t *p_dec )
 {
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
@@ -43,6 +43,14 @@ void input_DecoderChangePause( decoder_t *, bool b_paused, mtime_t i_date );
  */
 void input_DecoderChangeDelay( decoder_t *, mtime_t i_delay );
 
+/**
+ * This function changes the standby state.
+ * On standby, the decoder keeps the video blocks from the last key frame
+ * on instead of decoding them, and drops the other blocks. Leaving the
+ * standby decodes the kept blocks first.
+ */
+void input_DecoderSetStandby( decoder_t *, bool b_standby );
+
 /**
  * This function makes the decoder start waiting for a valid data block from its fifo.
  */
@@ -138,6 +138,55 @@ static const char* DemuxNameFromExtension( char const* ext,
     return result ? result->name : NULL;
 }
 
+/* Guess the demux from the first bytes of the stream, so that the likely
+ * module is probed before the ones with higher scores. Only formats with
+ * a strong signature at the very start are listed, the others are left to
+ * the usual probing. */
+static const char *DemuxNameFromContent( stream_t *s )
+{
+    static const struct
+    {
+        unsigned char offset;
+        unsigned char length;
+        char const magic[8];
+        char const name[8];
+    } signatures[] =
+    {
+        { 0, 4, "\x1A\x45\xDF\xA3",             "mkv"  },
+        { 0, 4, "OggS",                         "ogg"  },
+        { 0, 4, "fLaC",                         "flac" },
+        { 8, 4, "AVI ",                         "avi"  },
+        { 8, 4, "WAVE",                         "wav"  },
+        { 8, 4, "AIFF",                         "aiff" },
+        { 0, 8, "\x30\x26\xB2\x75\x8E\x66\xCF\x11", "asf"  },
+        { 4, 4, "ftyp",                         "mp4"  },
+        { 4, 4, "moov",                         "mp4"  },
+        { 0, 4, "\x00\x00\x01\xBA",             "ps"   },
+        { 0, 4, ".snd",                         "au"   },
+        { 0, 4, "MThd",                         "smf"  },
+        { 0, 4, "NSVf",                         "nsv"  },
+        { 0, 7, "#EXTM3U",                      "m3u"  },
+        { 0, 8, "Creative",                     "voc"  },
+    };
+    const uint8_t *p_peek;
+    ssize_t i_peek = vlc_stream_Peek( s, &p_peek, 2 * 188 + 1 );
+
+    for( size_t i = 0; i < ARRAY_SIZE( signatures ); i++ )
+    {
+        if( i_peek >= signatures[i].offset + signatures[i].length
+         && !memcmp( &p_peek[signatures[i].offset], signatures[i].magic,
+                     signatures[i].length ) )
+            return signatures[i].name;
+    }
+
+    /* Three consecutive sync bytes */
+    if( i_peek >= 2 * 188 + 1 && p_peek[0] == 0x47 && p_peek[188] == 0x47
+     && p_peek[2 * 188] == 0x47 )
+        return "ts";
+
+    return NULL;
+}
+
 /*****************************************************************************
  * demux_New:
  *  if s is NULL then load a access_demux
@@ -175,10 +224,17 @@ static void demux_DestroyDemuxFilter(demux_t *demux)
     demux_Delete(demux->p_next);
 }
 
+struct demux_probe_stats
+{
+    unsigned count;
+    mtime_t  duration;
+};
+
 static int demux_Probe(void *func, va_list ap)
 {
     int (*probe)(vlc_object_t *) = func;
     demux_t *demux = va_arg(ap, demux_t *);
+    struct demux_probe_stats *stats = va_arg(ap, struct demux_probe_stats *);
 
     /* Restore input stream offset (in case previous probed demux failed to
      * to do so). */
@@ -188,7 +244,12 @@ static int demux_Probe(void *func, va_list ap)
         return VLC_EGENERIC;
     }
 
-    return probe(VLC_OBJECT(demux));
+    mtime_t start = mdate();
+    int ret = probe(VLC_OBJECT(demux));
+
+    stats->count++;
+    stats->duration += mdate() - start;
+    return ret;
 }
 
 /*****************************************************************************
@@ -249,6 +310,7 @@ demux_t *demux_NewAdvanced( vlc_object_t *p_obj, input_thread_t *p_parent_input,
     if( s != NULL )
     {
         const char *psz_module = NULL;
+        struct demux_probe_stats stats = { 0, 0 };
 
         if( !strcmp( p_demux->psz_demux, "any" ) && p_demux->psz_file )
         {
@@ -258,11 +320,19 @@ demux_t *demux_NewAdvanced( vlc_object_t *p_obj, input_thread_t *p_parent_input,
                 psz_module = DemuxNameFromExtension( psz_ext + 1, b_preparsing );
         }
 
+        if( psz_module == NULL && !strcmp( p_demux->psz_demux, "any" ) )
+            psz_module = DemuxNameFromContent( s );
+
         if( psz_module == NULL )
             psz_module = p_demux->psz_demux;
 
         p_demux->p_module = vlc_module_load(p_demux, "demux", psz_module,
-             !strcmp(psz_module, p_demux->psz_demux), demux_Probe, p_demux);
+             !strcmp(psz_module, p_demux->psz_demux), demux_Probe, p_demux,
+             &stats);
+
+        if( !b_preparsing )
+            msg_Dbg( p_obj, "%u demux module(s) probed in %"PRId64" us",
+                     stats.count, stats.duration );
     }
     else
     {
@@ -39,6 +39,7 @@
 #include <vlc_aout.h>
 #include <vlc_fourcc.h>
 #include <vlc_meta.h>
+#include <vlc_trace.h>
 
 #include "input_internal.h"
 #include "clock.h"
@@ -62,8 +63,9 @@ typedef struct
     /* Program ID */
     int i_id;
 
-    /* Number of es for this pgrm */
+    /* ES of this pgrm */
     int i_es;
+    es_out_id_t **es;
 
     bool b_selected;
     bool b_scrambled;
@@ -105,8 +107,16 @@ struct es_out_id_t
 
     /* ID for the meta data */
     int         i_meta_id;
+
+    /* Next ES in the same bucket of the ID index */
+    es_out_id_t *p_next_id;
+    /* In the list of the selected ES */
+    bool        b_listed;
 };
 
+/* Buckets of the ES ID index (power of 2) */
+#define ES_OUT_ID_BUCKETS 256
+
 typedef struct
 {
     int         i_count;    /* es count */
@@ -137,6 +147,11 @@ struct es_out_sys_t
     int         i_id;
     int         i_es;
     es_out_id_t **es;
+    es_out_id_t *es_by_id[ES_OUT_ID_BUCKETS]; /* ES by ID, in creation order */
+
+    /* selected es, and some which got unselected with their decoder */
+    int         i_selected;
+    es_out_id_t **selected;
 
     /* mode gestion */
     bool  b_active;
@@ -157,6 +172,10 @@ struct es_out_sys_t
     int         i_cr_average;
     int         i_rate;
 
+    /* Adaptive caching of live streams */
+    bool        b_adaptive_delay;
+    mtime_t     i_pts_delay_min;
+
     /* */
     bool        b_paused;
     mtime_t     i_pause_date;
@@ -175,6 +194,9 @@ struct es_out_sys_t
 
     /* Used only to limit debugging output */
     int         i_prev_stream_level;
+
+    /* Decoders keep the data instead of decoding it */
+    bool        b_standby;
 };
 
 static es_out_id_t *EsOutAdd    ( es_out_t *, const es_format_t * );
@@ -198,6 +220,7 @@ static void EsOutProgramChangePause( es_out_t *out, bool b_paused, mtime_t i_dat
 static void EsOutProgramsChangeRate( es_out_t *out );
 static void EsOutDecodersStopBuffering( es_out_t *out, bool b_forced );
 static void EsOutGlobalMeta( es_out_t *p_out, const vlc_meta_t *p_meta );
+static void EsOutAdaptDelay( es_out_t *out, es_out_pgrm_t *p_pgrm );
 static void EsOutMeta( es_out_t *p_out, const vlc_meta_t *p_meta, const vlc_meta_t *p_progmeta );
 
 static char *LanguageGetName( const char *psz_code );
@@ -314,6 +337,7 @@ es_out_t *input_EsOutNew( input_thread_t *p_input, int i_rate )
     TAB_INIT( p_sys->i_pgrm, p_sys->pgrm );
 
     TAB_INIT( p_sys->i_es, p_sys->es );
+    TAB_INIT( p_sys->i_selected, p_sys->selected );
 
     /* */
     EsOutPropsInit( &p_sys->video, true, p_input, ES_OUT_ES_POLICY_SIMULTANEOUS,
@@ -329,9 +353,14 @@ es_out_t *input_EsOutNew( input_thread_t *p_input, int i_rate )
 
     p_sys->i_rate = i_rate;
 
+    p_sys->b_adaptive_delay = var_InheritBool( p_input, "clock-adaptive" );
+    p_sys->i_pts_delay_min =
+        INT64_C(1000) * var_InheritInteger( p_input, "clock-adaptive-min" );
+
     p_sys->b_buffering = true;
     p_sys->i_preroll_end = -1;
     p_sys->i_prev_stream_level = -1;
+    p_sys->b_standby = false;
 
     return out;
 }
@@ -372,6 +401,8 @@ static void EsOutTerminate( es_out_t *out )
         free( p_sys->es[i] );
     }
     TAB_CLEAN( p_sys->i_es, p_sys->es );
+    TAB_CLEAN( p_sys->i_selected, p_sys->selected );
+    memset( p_sys->es_by_id, 0, sizeof( p_sys->es_by_id ) );
 
     /* FIXME duplicate work EsOutProgramDel (but we cannot use it) add a EsOutProgramClean ? */
     for( int i = 0; i < p_sys->i_pgrm; i++ )
@@ -380,6 +411,7 @@ static void EsOutTerminate( es_out_t *out )
         input_clock_Delete( p_pgrm->p_clock );
         if( p_pgrm->p_meta )
             vlc_meta_Delete( p_pgrm->p_meta );
+        TAB_CLEAN( p_pgrm->i_es, p_pgrm->es );
 
         free( p_pgrm );
     }
@@ -422,14 +454,97 @@ static es_out_id_t *EsOutGetFromID( es_out_t *out, int i_id )
         return es_cat - i_id;
     }
 
-    for( int i = 0; i < out->p_sys->i_es; i++ )
+    es_out_id_t *es = out->p_sys->es_by_id[i_id & (ES_OUT_ID_BUCKETS - 1)];
+    while( es != NULL && es->i_id != i_id )
+        es = es->p_next_id;
+    return es;
+}
+
+static void EsOutIndexAdd( es_out_sys_t *p_sys, es_out_id_t *es )
+{
+    es_out_id_t **pp_es = &p_sys->es_by_id[es->i_id & (ES_OUT_ID_BUCKETS - 1)];
+
+    /* Keep the creation order, the first ES of an ID is the one found */
+    while( *pp_es != NULL )
+        pp_es = &(*pp_es)->p_next_id;
+    es->p_next_id = NULL;
+    *pp_es = es;
+}
+
+static void EsOutIndexRemove( es_out_sys_t *p_sys, es_out_id_t *es )
+{
+    es_out_id_t **pp_es = &p_sys->es_by_id[es->i_id & (ES_OUT_ID_BUCKETS - 1)];
+
+    while( *pp_es != es )
+        pp_es = &(*pp_es)->p_next_id;
+    *pp_es = es->p_next_id;
+}
+
+/* The selected ES are listed when selected, and unlisted when unselected
+ * explicitly. Closed captions get unselected with the decoder of their
+ * master, they are unlisted when found so. */
+static void EsOutListSelected( es_out_sys_t *p_sys, es_out_id_t *es )
+{
+    if( es->b_listed )
+        return;
+    TAB_APPEND( p_sys->i_selected, p_sys->selected, es );
+    es->b_listed = true;
+}
+
+static void EsOutUnlistSelected( es_out_sys_t *p_sys, es_out_id_t *es )
+{
+    if( !es->b_listed )
+        return;
+    TAB_REMOVE( p_sys->i_selected, p_sys->selected, es );
+    es->b_listed = false;
+}
+
+/**
+ * Finds a selected ES of a category (UNKNOWN_ES for all) and of a program
+ * (NULL for all)
+ */
+static es_out_id_t *EsOutGetSelected( es_out_t *out,
+                                      enum es_format_category_e i_cat,
+                                      const es_out_pgrm_t *p_pgrm )
+{
+    es_out_sys_t *p_sys = out->p_sys;
+
+    for( int i = 0; i < p_sys->i_selected; )
     {
-        if( out->p_sys->es[i]->i_id == i_id )
-            return out->p_sys->es[i];
+        es_out_id_t *es = p_sys->selected[i];
+
+        if( !EsIsSelected( es ) )
+        {
+            EsOutUnlistSelected( p_sys, es );
+            continue;
+        }
+        if( ( i_cat == UNKNOWN_ES || es->fmt.i_cat == i_cat ) &&
+            ( p_pgrm == NULL || es->p_pgrm == p_pgrm ) )
+            return es;
+        i++;
     }
     return NULL;
 }
 
+/* Applies the selection mode to all the ES that it may select */
+static void EsOutSelectAll( es_out_t *out )
+{
+    es_out_sys_t *p_sys = out->p_sys;
+
+    /* Only the ES of the master program are selected automatically */
+    if( p_sys->i_mode == ES_OUT_MODE_AUTO )
+    {
+        es_out_pgrm_t *p_pgrm = p_sys->p_pgrm;
+
+        for( int i = 0; p_pgrm != NULL && i < p_pgrm->i_es; i++ )
+            EsOutSelect( out, p_pgrm->es[i], false );
+        return;
+    }
+
+    for( int i = 0; i < p_sys->i_es; i++ )
+        EsOutSelect( out, p_sys->es[i], false );
+}
+
 static bool EsOutDecodersIsEmpty( es_out_t *out )
 {
     es_out_sys_t      *p_sys = out->p_sys;
@@ -441,9 +556,9 @@ static bool EsOutDecodersIsEmpty( es_out_t *out )
             return true;
     }
 
-    for( int i = 0; i < p_sys->i_es; i++ )
+    for( int i = 0; i < p_sys->i_selected; i++ )
     {
-        es_out_id_t *es = p_sys->es[i];
+        es_out_id_t *es = p_sys->selected[i];
 
         if( es->p_dec && !input_DecoderIsEmpty( es->p_dec ) )
             return false;
@@ -511,9 +626,9 @@ static int EsOutSetRecord(  es_out_t *out, bool b_record )
         if( !p_sys->p_sout_record )
             return VLC_EGENERIC;
 
-        for( int i = 0; i < p_sys->i_es; i++ )
+        for( int i = 0; i < p_sys->i_selected; i++ )
         {
-            es_out_id_t *p_es = p_sys->es[i];
+            es_out_id_t *p_es = p_sys->selected[i];
 
             if( !p_es->p_dec || p_es->p_master )
                 continue;
@@ -525,9 +640,9 @@ static int EsOutSetRecord(  es_out_t *out, bool b_record )
     }
     else
     {
-        for( int i = 0; i < p_sys->i_es; i++ )
+        for( int i = 0; i < p_sys->i_selected; i++ )
         {
-            es_out_id_t *p_es = p_sys->es[i];
+            es_out_id_t *p_es = p_sys->selected[i];
 
             if( !p_es->p_dec_record )
                 continue;
@@ -598,9 +713,9 @@ static void EsOutChangePosition( es_out_t *out )
 
     input_SendEventCache( p_sys->p_input, 0.0 );
 
-    for( int i = 0; i < p_sys->i_es; i++ )
+    for( int i = 0; i < p_sys->i_selected; i++ )
     {
-        es_out_id_t *p_es = p_sys->es[i];
+        es_out_id_t *p_es = p_sys->selected[i];
 
         if( p_es->p_dec != NULL )
         {
@@ -681,9 +796,9 @@ static void EsOutDecodersStopBuffering( es_out_t *out, bool b_forced )
     }
 
     const mtime_t i_decoder_buffering_start = mdate();
-    for( int i = 0; i < p_sys->i_es; i++ )
+    for( int i = 0; i < p_sys->i_selected; i++ )
     {
-        es_out_id_t *p_es = p_sys->es[i];
+        es_out_id_t *p_es = p_sys->selected[i];
 
         if( !p_es->p_dec || p_es->fmt.i_cat == SPU_ES )
             continue;
@@ -705,9 +820,9 @@ static void EsOutDecodersStopBuffering( es_out_t *out, bool b_forced )
     input_clock_ChangeSystemOrigin( p_sys->p_pgrm->p_clock, true,
                                     i_current_date + i_wakeup_delay - i_buffering_duration );
 
-    for( int i = 0; i < p_sys->i_es; i++ )
+    for( int i = 0; i < p_sys->i_selected; i++ )
     {
-        es_out_id_t *p_es = p_sys->es[i];
+        es_out_id_t *p_es = p_sys->selected[i];
 
         if( !p_es->p_dec )
             continue;
@@ -722,9 +837,9 @@ static void EsOutDecodersChangePause( es_out_t *out, bool b_paused, mtime_t i_da
     es_out_sys_t *p_sys = out->p_sys;
 
     /* Pause decoders first */
-    for( int i = 0; i < p_sys->i_es; i++ )
+    for( int i = 0; i < p_sys->i_selected; i++ )
     {
-        es_out_id_t *es = p_sys->es[i];
+        es_out_id_t *es = p_sys->selected[i];
 
         if( es->p_dec )
         {
@@ -740,9 +855,9 @@ static bool EsOutIsExtraBufferingAllowed( es_out_t *out )
     es_out_sys_t *p_sys = out->p_sys;
 
     size_t i_size = 0;
-    for( int i = 0; i < p_sys->i_es; i++ )
+    for( int i = 0; i < p_sys->i_selected; i++ )
     {
-        es_out_id_t *p_es = p_sys->es[i];
+        es_out_id_t *p_es = p_sys->selected[i];
 
         if( p_es->p_dec )
             i_size += input_DecoderGetFifoSize( p_es->p_dec );
@@ -806,9 +921,9 @@ static void EsOutFrameNext( es_out_t *out )
 
     assert( p_sys->b_paused );
 
-    for( int i = 0; i < p_sys->i_es; i++ )
+    for( int i = 0; i < p_sys->i_selected; i++ )
     {
-        es_out_id_t *p_es = p_sys->es[i];
+        es_out_id_t *p_es = p_sys->selected[i];
 
         if( p_es->fmt.i_cat == VIDEO_ES && p_es->p_dec )
         {
@@ -1002,7 +1117,6 @@ static void EsOutProgramSelect( es_out_t *out, es_out_pgrm_t *p_pgrm )
 {
     es_out_sys_t      *p_sys = out->p_sys;
     input_thread_t    *p_input = p_sys->p_input;
-    int               i;
 
     if( p_sys->p_pgrm == p_pgrm )
         return; /* Nothing to do */
@@ -1010,14 +1124,12 @@ static void EsOutProgramSelect( es_out_t *out, es_out_pgrm_t *p_pgrm )
     if( p_sys->p_pgrm )
     {
         es_out_pgrm_t *old = p_sys->p_pgrm;
+        es_out_id_t *es;
         msg_Dbg( p_input, "unselecting program id=%d", old->i_id );
 
-        for( i = 0; i < p_sys->i_es; i++ )
-        {
-            if( p_sys->es[i]->p_pgrm == old && EsIsSelected( p_sys->es[i] ) &&
-                p_sys->i_mode != ES_OUT_MODE_ALL )
-                EsUnselect( out, p_sys->es[i], true );
-        }
+        if( p_sys->i_mode != ES_OUT_MODE_ALL )
+            while( ( es = EsOutGetSelected( out, UNKNOWN_ES, old ) ) != NULL )
+                EsUnselect( out, es, true );
 
         p_sys->audio.p_main_es = NULL;
         p_sys->video.p_main_es = NULL;
@@ -1045,16 +1157,12 @@ static void EsOutProgramSelect( es_out_t *out, es_out_pgrm_t *p_pgrm )
     /* TODO event */
     var_SetInteger( p_input, "teletext-es", -1 );
 
-    for( i = 0; i < p_sys->i_es; i++ )
+    for( int i = 0; i < p_pgrm->i_es; i++ )
     {
-        if( p_sys->es[i]->p_pgrm == p_sys->p_pgrm )
-        {
-            EsOutESVarUpdate( out, p_sys->es[i], false );
-            EsOutUpdateInfo( out, p_sys->es[i], &p_sys->es[i]->fmt, NULL );
-        }
-
-        EsOutSelect( out, p_sys->es[i], false );
+        EsOutESVarUpdate( out, p_pgrm->es[i], false );
+        EsOutUpdateInfo( out, p_pgrm->es[i], &p_pgrm->es[i]->fmt, NULL );
     }
+    EsOutSelectAll( out );
 
     /* Ensure the correct running EPG table is selected */
     input_item_ChangeEPGSource( input_priv(p_input)->p_item, p_pgrm->i_id );
@@ -1087,7 +1195,7 @@ static es_out_pgrm_t *EsOutProgramAdd( es_out_t *out, int i_group )
 
     /* Init */
     p_pgrm->i_id = i_group;
-    p_pgrm->i_es = 0;
+    TAB_INIT( p_pgrm->i_es, p_pgrm->es );
     p_pgrm->b_selected = false;
     p_pgrm->b_scrambled = false;
     p_pgrm->p_meta = NULL;
@@ -1153,6 +1261,7 @@ static int EsOutProgramDel( es_out_t *out, int i_group )
 
     if( p_pgrm->p_meta )
         vlc_meta_Delete( p_pgrm->p_meta );
+    TAB_CLEAN( p_pgrm->i_es, p_pgrm->es );
     free( p_pgrm );
 
     /* Update "program" variable */
@@ -1450,9 +1559,9 @@ static void EsOutProgramUpdateScrambled( es_out_t *p_out, es_out_pgrm_t *p_pgrm
     input_thread_t  *p_input = p_sys->p_input;
     bool b_scrambled = false;
 
-    for( int i = 0; i < p_sys->i_es; i++ )
+    for( int i = 0; i < p_pgrm->i_es; i++ )
     {
-        if( p_sys->es[i]->p_pgrm == p_pgrm && p_sys->es[i]->b_scrambled )
+        if( p_pgrm->es[i]->b_scrambled )
         {
             b_scrambled = true;
             break;
@@ -1555,9 +1664,6 @@ static es_out_id_t *EsOutAddSlave( es_out_t *out, const es_format_t *fmt, es_out
         return NULL;
     }
 
-    /* Increase ref count for program */
-    p_pgrm->i_es++;
-
     /* Set up ES */
     es->p_pgrm = p_pgrm;
     es_format_Copy( &es->fmt, fmt );
@@ -1633,8 +1739,11 @@ static es_out_id_t *EsOutAddSlave( es_out_t *out, const es_format_t *fmt, es_out
     es->cc.type = 0;
     es->cc.i_bitmap = 0;
     es->p_master = p_master;
+    es->b_listed = false;
 
     TAB_APPEND( p_sys->i_es, p_sys->es, es );
+    TAB_APPEND( p_pgrm->i_es, p_pgrm->es, es );
+    EsOutIndexAdd( p_sys, es );
 
     if( es->p_pgrm == p_sys->p_pgrm )
         EsOutESVarUpdate( out, es, false );
@@ -1684,6 +1793,9 @@ static void EsCreateDecoder( es_out_t *out, es_out_id_t *p_es )
     p_es->p_dec = input_DecoderNew( p_input, &p_es->fmt, p_es->p_pgrm->p_clock, input_priv(p_input)->p_sout );
     if( p_es->p_dec )
     {
+        EsOutListSelected( p_sys, p_es );
+        if( p_sys->b_standby )
+            input_DecoderSetStandby( p_es->p_dec, true );
         if( p_sys->b_buffering )
             input_DecoderStartWait( p_es->p_dec );
 
@@ -1737,6 +1849,7 @@ static void EsSelect( es_out_t *out, es_out_id_t *es )
             input_DecoderSetCcState( es->p_master->p_dec, es->fmt.i_codec,
                                      i_channel, true ) )
             return;
+        EsOutListSelected( p_sys, es );
     }
     else
     {
@@ -1834,6 +1947,7 @@ static void EsUnselect( es_out_t *out, es_out_id_t *es, bool b_update )
         EsDeleteCCChannels( out, es );
         EsDestroyDecoder( out, es );
     }
+    EsOutUnlistSelected( p_sys, es );
 
     if( !b_update )
         return;
@@ -2039,26 +2153,24 @@ static int EsOutSend( es_out_t *out, es_out_id_t *es, block_t *p_block )
     es_out_sys_t   *p_sys = out->p_sys;
     input_thread_t *p_input = p_sys->p_input;
 
+    vlc_trace_Flow( START, vlc_trace_FlowName( es->fmt.i_cat ),
+                    p_block->i_pts );
+
     if( libvlc_stats( p_input ) )
     {
-        uint64_t i_total;
-
-        vlc_mutex_lock( &input_priv(p_input)->counters.counters_lock );
         stats_Update( input_priv(p_input)->counters.p_demux_read,
-                      p_block->i_buffer, &i_total );
-        stats_Update( input_priv(p_input)->counters.p_demux_bitrate, i_total, NULL );
+                      p_block->i_buffer );
 
         /* Update number of corrupted data packats */
         if( p_block->i_flags & BLOCK_FLAG_CORRUPTED )
         {
-            stats_Update( input_priv(p_input)->counters.p_demux_corrupted, 1, NULL );
+            stats_Update( input_priv(p_input)->counters.p_demux_corrupted, 1 );
         }
         /* Update number of discontinuities */
         if( p_block->i_flags & BLOCK_FLAG_DISCONTINUITY )
         {
-            stats_Update( input_priv(p_input)->counters.p_demux_discontinuity, 1, NULL );
+            stats_Update( input_priv(p_input)->counters.p_demux_discontinuity, 1 );
         }
-        vlc_mutex_unlock( &input_priv(p_input)->counters.counters_lock );
     }
 
     vlc_mutex_lock( &p_sys->lock );
@@ -2136,6 +2248,49 @@ static int EsOutSend( es_out_t *out, es_out_id_t *es, block_t *p_block )
     return VLC_SUCCESS;
 }
 
+/* Lowest margin kept above the measured jitter */
+#define ADAPTIVE_DELAY_GUARD (CLOCK_FREQ / 50)
+/* Largest reduction of the caching per measurement window */
+#define ADAPTIVE_DELAY_STEP  (CLOCK_FREQ / 50)
+
+/**
+ * Lowers the caching of a live stream while its clock references arrive
+ * long enough before being late. Raising it back is left to the late clock
+ * references handling, which also rebuffers.
+ */
+static void EsOutAdaptDelay( es_out_t *out, es_out_pgrm_t *p_pgrm )
+{
+    es_out_sys_t *p_sys = out->p_sys;
+    mtime_t i_margin, i_jitter;
+
+    if( input_clock_GetMargin( p_pgrm->p_clock, &i_margin, &i_jitter ) )
+        return;
+
+    /* Keep a few times the jitter, and reduce by small steps so that the
+     * outputs can absorb the change by resampling instead of dropping */
+    const mtime_t i_excess = i_margin - 4 * i_jitter - ADAPTIVE_DELAY_GUARD;
+    if( i_excess <= 0 )
+        return;
+
+    const mtime_t i_pts_delay =
+        __MAX( p_sys->i_pts_delay - __MIN( i_excess / 4, ADAPTIVE_DELAY_STEP ),
+               p_sys->i_pts_delay_min );
+    if( i_pts_delay >= p_sys->i_pts_delay )
+        return;
+
+    msg_Dbg( p_sys->p_input, "lowering the caching to %"PRId64" ms "
+             "(margin %"PRId64" ms, jitter %"PRId64" ms)", i_pts_delay / 1000,
+             i_margin / 1000, i_jitter / 1000 );
+
+    /* The jitter is lowered first, then the base delay */
+    p_sys->i_pts_jitter = __MAX( p_sys->i_pts_jitter
+                                 - ( p_sys->i_pts_delay - i_pts_delay ), 0 );
+    p_sys->i_pts_delay = i_pts_delay;
+
+    for( int i = 0; i < p_sys->i_pgrm; i++ )
+        input_clock_ReduceDelay( p_sys->pgrm[i]->p_clock, i_pts_delay );
+}
+
 /*****************************************************************************
  * EsOutDel:
  *****************************************************************************/
@@ -2173,9 +2328,11 @@ static void EsOutDel( es_out_t *out, es_out_id_t *es )
     EsDeleteInfo( out, es );
 
     TAB_REMOVE( p_sys->i_es, p_sys->es, es );
+    EsOutIndexRemove( p_sys, es );
+    EsOutUnlistSelected( p_sys, es );
 
     /* Update program */
-    es->p_pgrm->i_es--;
+    TAB_REMOVE( es->p_pgrm->i_es, es->p_pgrm->es, es );
     if( es->p_pgrm->i_es == 0 )
         msg_Dbg( p_sys->p_input, "Program doesn't contain anymore ES" );
 
@@ -2306,14 +2463,10 @@ static int EsOutControlLocked( es_out_t *out, int i_query, va_list args )
         p_sys->i_mode = i_mode;
 
         /* Reapply policy mode */
-        for( int i = 0; i < p_sys->i_es; i++ )
-        {
-            if( EsIsSelected( p_sys->es[i] ) )
-                EsUnselect( out, p_sys->es[i],
-                            p_sys->es[i]->p_pgrm == p_sys->p_pgrm );
-        }
-        for( int i = 0; i < p_sys->i_es; i++ )
-            EsOutSelect( out, p_sys->es[i], false );
+        es_out_id_t *es;
+        while( ( es = EsOutGetSelected( out, UNKNOWN_ES, NULL ) ) != NULL )
+            EsUnselect( out, es, es->p_pgrm == p_sys->p_pgrm );
+        EsOutSelectAll( out );
         if( i_mode == ES_OUT_MODE_END )
             EsOutTerminate( out );
         return VLC_SUCCESS;
@@ -2337,47 +2490,37 @@ static int EsOutControlLocked( es_out_t *out, int i_query, va_list args )
         else
             i_cat = IGNORE_ES;
 
-        for( int i = 0; i < p_sys->i_es; i++ )
+        if( i_cat == IGNORE_ES )
         {
-            if( i_cat == IGNORE_ES )
+            if( i_query == ES_OUT_RESTART_ES && es->p_dec )
             {
-                if( es == p_sys->es[i] )
-                {
-                    if( i_query == ES_OUT_RESTART_ES && p_sys->es[i]->p_dec )
-                    {
-                        EsDestroyDecoder( out, p_sys->es[i] );
-                        EsCreateDecoder( out, p_sys->es[i] );
-                    }
-                    else if( i_query == ES_OUT_SET_ES )
-                    {
-                        EsOutSelect( out, es, true );
-                    }
-                    break;
-                }
+                EsDestroyDecoder( out, es );
+                EsCreateDecoder( out, es );
             }
-            else
+            else if( i_query == ES_OUT_SET_ES )
             {
-                if( i_cat == UNKNOWN_ES || p_sys->es[i]->fmt.i_cat == i_cat )
+                EsOutSelect( out, es, true );
+            }
+        }
+        else if( i_query == ES_OUT_RESTART_ES )
+        {
+            /* Restarting does not change the list */
+            for( int i = 0; i < p_sys->i_selected; i++ )
+            {
+                es = p_sys->selected[i];
+                if( ( i_cat == UNKNOWN_ES || es->fmt.i_cat == i_cat ) &&
+                    es->p_dec )
                 {
-                    if( EsIsSelected( p_sys->es[i] ) )
-                    {
-                        if( i_query == ES_OUT_RESTART_ES )
-                        {
-                            if( p_sys->es[i]->p_dec )
-                            {
-                                EsDestroyDecoder( out, p_sys->es[i] );
-                                EsCreateDecoder( out, p_sys->es[i] );
-                            }
-                        }
-                        else
-                        {
-                            EsUnselect( out, p_sys->es[i],
-                                        p_sys->es[i]->p_pgrm == p_sys->p_pgrm );
-                        }
-                    }
+                    EsDestroyDecoder( out, es );
+                    EsCreateDecoder( out, es );
                 }
             }
         }
+        else
+        {
+            while( ( es = EsOutGetSelected( out, i_cat, NULL ) ) != NULL )
+                EsUnselect( out, es, es->p_pgrm == p_sys->p_pgrm );
+        }
         return VLC_SUCCESS;
     }
     case ES_OUT_RESTART_ALL_ES:
@@ -2507,6 +2650,9 @@ static int EsOutControlLocked( es_out_t *out, int i_query, va_list args )
 
                 es_out_SetJitter( out, i_pts_delay_base, i_pts_delay - i_pts_delay_base, p_sys->i_cr_average );
             }
+            else if( !b_late && p_sys->b_adaptive_delay
+                  && !input_priv(p_sys->p_input)->b_can_pace_control )
+                EsOutAdaptDelay( out, p_pgrm );
         }
         return VLC_SUCCESS;
     }
@@ -2841,6 +2987,22 @@ static int EsOutControlLocked( es_out_t *out, int i_query, va_list args )
         return VLC_SUCCESS;
     }
 
+    case ES_OUT_SET_STANDBY:
+    {
+        const bool b_standby = va_arg( args, int );
+
+        if( b_standby == p_sys->b_standby )
+            return VLC_SUCCESS;
+        p_sys->b_standby = b_standby;
+        for( int i = 0; i < p_sys->i_selected; i++ )
+        {
+            es_out_id_t *id = p_sys->selected[i];
+            if( id->p_dec != NULL )
+                input_DecoderSetStandby( id->p_dec, b_standby );
+        }
+        return VLC_SUCCESS;
+    }
+
     case ES_OUT_POST_SUBNODE:
     {
         input_item_node_t *node = va_arg(args, input_item_node_t *);
@@ -37,6 +37,9 @@
 #endif
 #include <sys/stat.h>
 #include <unistd.h>
+#ifdef HAVE_MMAP
+#  include <sys/mman.h>
+#endif
 
 #include <vlc_common.h>
 #include <vlc_fs.h>
@@ -172,6 +175,7 @@ struct ts_storage_t
 #endif
     size_t  i_file_max; /* Max size in bytes */
     int64_t i_file_size;/* Current size in bytes */
+    uint8_t *p_map;     /* Whole file mapping, used instead of the FILE */
     FILE    *p_filew;   /* FILE handle for data writing */
     FILE    *p_filer;   /* FILE handle for data reading */
 
@@ -1114,20 +1118,38 @@ static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_
         return NULL;
     }
 
-    p_storage->p_filew = fdopen( fd, "w+b" );
-    if( p_storage->p_filew == NULL )
+    p_storage->p_map = NULL;
+#ifdef HAVE_MMAP
+    /* Blocks are then copied once, straight into the page cache */
+    if( ftruncate( fd, i_tmp_size_max ) == 0 )
     {
-        vlc_close( fd );
-        vlc_unlink( psz_file );
-        goto error;
+        void *p_map = mmap( NULL, i_tmp_size_max, PROT_READ|PROT_WRITE,
+                            MAP_SHARED, fd, 0 );
+        if( p_map != MAP_FAILED )
+        {
+            vlc_close( fd );
+            p_storage->p_map = p_map;
+            p_storage->p_filew = p_storage->p_filer = NULL;
+        }
     }
-
-    p_storage->p_filer = vlc_fopen( psz_file, "rb" );
-    if( p_storage->p_filer == NULL )
+    if( p_storage->p_map == NULL )
+#endif
     {
-        fclose( p_storage->p_filew );
-        vlc_unlink( psz_file );
-        goto error;
+        p_storage->p_filew = fdopen( fd, "w+b" );
+        if( p_storage->p_filew == NULL )
+        {
+            vlc_close( fd );
+            vlc_unlink( psz_file );
+            goto error;
+        }
+
+        p_storage->p_filer = vlc_fopen( psz_file, "rb" );
+        if( p_storage->p_filer == NULL )
+        {
+            fclose( p_storage->p_filew );
+            vlc_unlink( psz_file );
+            goto error;
+        }
     }
 
 #ifndef _WIN32
@@ -1173,8 +1195,15 @@ static void TsStorageDelete( ts_storage_t *p_storage )
     }
     free( p_storage->p_cmd );
 
-    fclose( p_storage->p_filer );
-    fclose( p_storage->p_filew );
+#ifdef HAVE_MMAP
+    if( p_storage->p_map )
+        munmap( p_storage->p_map, p_storage->i_file_max );
+    else
+#endif
+    {
+        fclose( p_storage->p_filer );
+        fclose( p_storage->p_filew );
+    }
 #ifdef _WIN32
     vlc_unlink( p_storage->psz_file );
     free( p_storage->psz_file );
@@ -1215,7 +1244,29 @@ static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd, bo
 
     assert( !TsStorageIsFull( p_storage, p_cmd ) );
 
-    if( cmd.i_type == C_SEND )
+    if( cmd.i_type == C_SEND && p_storage->p_map )
+    {
+        block_t *p_block = cmd.u.send.p_block;
+        uint8_t *p = &p_storage->p_map[p_storage->i_file_size];
+
+        /* Only the first command of a storage may not fit */
+        if( sizeof(*p_block) + p_block->i_buffer >
+            p_storage->i_file_max - p_storage->i_file_size )
+        {
+            block_Release( p_block );
+            return;
+        }
+
+        cmd.u.send.p_block = NULL;
+        cmd.u.send.i_offset = p_storage->i_file_size;
+
+        memcpy( p, p_block, sizeof(*p_block) );
+        if( p_block->i_buffer > 0 )
+            memcpy( &p[sizeof(*p_block)], p_block->p_buffer, p_block->i_buffer );
+        p_storage->i_file_size += sizeof(*p_block) + p_block->i_buffer;
+        block_Release( p_block );
+    }
+    else if( cmd.i_type == C_SEND )
     {
         block_t *p_block = cmd.u.send.p_block;
 
@@ -1249,7 +1300,27 @@ static void TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_fl
     assert( !TsStorageIsEmpty( p_storage ) );
 
     *p_cmd = p_storage->p_cmd[p_storage->i_cmd_r++];
-    if( p_cmd->i_type == C_SEND )
+    if( p_cmd->i_type == C_SEND && p_storage->p_map )
+    {
+        const uint8_t *p = &p_storage->p_map[p_cmd->u.send.i_offset];
+        block_t block;
+        block_t *p_block = NULL;
+
+        memcpy( &block, p, sizeof(block) );
+        if( b_flush )
+            p_block = block_Alloc( 1 );
+        else if( (p_block = block_Alloc( block.i_buffer )) != NULL )
+        {
+            p_block->i_dts      = block.i_dts;
+            p_block->i_pts      = block.i_pts;
+            p_block->i_flags    = block.i_flags;
+            p_block->i_length   = block.i_length;
+            p_block->i_nb_samples = block.i_nb_samples;
+            memcpy( p_block->p_buffer, &p[sizeof(block)], block.i_buffer );
+        }
+        p_cmd->u.send.p_block = p_block;
+    }
+    else if( p_cmd->i_type == C_SEND )
     {
         block_t block;
 
@@ -55,6 +55,7 @@
 #include <vlc_stream.h>
 #include <vlc_stream_extractor.h>
 #include <vlc_renderer_discovery.h>
+#include <vlc_trace.h>
 
 /*****************************************************************************
  * Local prototypes
@@ -319,6 +320,7 @@ static input_thread_t *Create( vlc_object_t *p_parent, input_item_t *p_item,
     priv->is_running = false;
     priv->is_stopped = false;
     priv->b_recording = false;
+    priv->b_standby = false;
     priv->i_rate = INPUT_RATE_DEFAULT;
     memset( &priv->bookmark, 0, sizeof(priv->bookmark) );
     TAB_INIT( priv->i_bookmark, priv->pp_bookmark );
@@ -397,7 +399,6 @@ static input_thread_t *Create( vlc_object_t *p_parent, input_item_t *p_item,
         priv->p_resource_private = input_resource_New( VLC_OBJECT( p_input ) );
         priv->p_resource = input_resource_Hold( priv->p_resource_private );
     }
-    input_resource_SetInput( priv->p_resource, p_input );
 
     /* Init control buffer */
     vlc_mutex_init( &priv->lock_control );
@@ -562,6 +563,7 @@ static void MainLoopDemux( input_thread_t *p_input, bool *pb_changed )
     int i_ret;
     demux_t *p_demux = input_priv(p_input)->master->p_demux;
 
+    vlc_trace_Scope( "demux" );
     *pb_changed = false;
 
     if( input_priv(p_input)->i_stop > 0 && input_priv(p_input)->i_time >= input_priv(p_input)->i_stop )
@@ -706,6 +708,11 @@ static void MainLoop( input_thread_t *p_input, bool b_interactive )
         if( b_paused )
             b_paused = !es_out_GetBuffering( input_priv(p_input)->p_es_out )
                     || input_priv(p_input)->master->b_eof;
+        /* A standby input that can be paced is held before demuxing
+         * anything, so that it starts from its beginning once switched to */
+        if( input_priv(p_input)->b_standby
+         && input_priv(p_input)->b_can_pace_control )
+            b_paused = true;
 
         if( !b_paused )
         {
@@ -826,6 +833,18 @@ static void InitStatistics( input_thread_t *p_input )
         INIT_COUNTER( demux_discontinuity, COUNTER );
         INIT_COUNTER( played_abuffers, COUNTER );
         INIT_COUNTER( lost_abuffers, COUNTER );
+        INIT_COUNTER( aout_latency, LAST );
+        INIT_COUNTER( aout_drift, LAST );
+        INIT_COUNTER( aout_drift_max, MAX );
+        INIT_COUNTER( aout_resampling, LAST );
+        INIT_COUNTER( aout_underruns, COUNTER );
+        INIT_COUNTER( aout_silences, COUNTER );
+        for( unsigned i = 0; i < INPUT_STATS_DRIFT_BUCKETS; i++ )
+        {
+            free( priv->counters.pp_aout_drift_buckets[i] );
+            priv->counters.pp_aout_drift_buckets[i] =
+                stats_CounterCreate( STATS_COUNTER );
+        }
         INIT_COUNTER( displayed_pictures, COUNTER );
         INIT_COUNTER( lost_pictures, COUNTER );
         INIT_COUNTER( decoded_audio, COUNTER );
@@ -1320,6 +1339,10 @@ static int Init( input_thread_t * p_input )
         var_SetBool( p_input, "sub-autodetect-file", false );
     }
 
+    /* A standby input gets the resource when leaving the standby */
+    if( !priv->b_standby )
+        input_resource_SetInput( priv->p_resource, p_input );
+
     InitStatistics( p_input );
 #ifdef ENABLE_SOUT
     if( InitSout( p_input ) )
@@ -1414,7 +1437,8 @@ error:
         if( input_priv(p_input)->p_sout )
             input_resource_RequestSout( input_priv(p_input)->p_resource,
                                          input_priv(p_input)->p_sout, NULL );
-        input_resource_SetInput( input_priv(p_input)->p_resource, NULL );
+        if( !input_priv(p_input)->b_standby )
+            input_resource_SetInput( input_priv(p_input)->p_resource, NULL );
         if( input_priv(p_input)->p_resource_private )
             input_resource_Terminate( input_priv(p_input)->p_resource_private );
     }
@@ -1433,6 +1457,17 @@ error:
         EXIT_COUNTER( demux_discontinuity );
         EXIT_COUNTER( played_abuffers );
         EXIT_COUNTER( lost_abuffers );
+        EXIT_COUNTER( aout_latency );
+        EXIT_COUNTER( aout_drift );
+        EXIT_COUNTER( aout_drift_max );
+        EXIT_COUNTER( aout_resampling );
+        EXIT_COUNTER( aout_underruns );
+        EXIT_COUNTER( aout_silences );
+        for( unsigned i = 0; i < INPUT_STATS_DRIFT_BUCKETS; i++ )
+        {
+            stats_CounterClean( priv->counters.pp_aout_drift_buckets[i] );
+            priv->counters.pp_aout_drift_buckets[i] = NULL;
+        }
         EXIT_COUNTER( displayed_pictures );
         EXIT_COUNTER( lost_pictures );
         EXIT_COUNTER( decoded_audio );
@@ -1509,6 +1544,17 @@ do { \
             CL_CO( demux_discontinuity );
             CL_CO( played_abuffers );
             CL_CO( lost_abuffers );
+            CL_CO( aout_latency );
+            CL_CO( aout_drift );
+            CL_CO( aout_drift_max );
+            CL_CO( aout_resampling );
+            CL_CO( aout_underruns );
+            CL_CO( aout_silences );
+            for( unsigned i = 0; i < INPUT_STATS_DRIFT_BUCKETS; i++ )
+            {
+                stats_CounterClean( priv->counters.pp_aout_drift_buckets[i] );
+                priv->counters.pp_aout_drift_buckets[i] = NULL;
+            }
             CL_CO( displayed_pictures );
             CL_CO( lost_pictures );
             CL_CO( decoded_audio) ;
@@ -1546,7 +1592,8 @@ do { \
     /* */
     input_resource_RequestSout( input_priv(p_input)->p_resource,
                                  input_priv(p_input)->p_sout, NULL );
-    input_resource_SetInput( input_priv(p_input)->p_resource, NULL );
+    if( !input_priv(p_input)->b_standby )
+        input_resource_SetInput( input_priv(p_input)->p_resource, NULL );
     if( input_priv(p_input)->p_resource_private )
         input_resource_Terminate( input_priv(p_input)->p_resource_private );
 }
@@ -2348,6 +2395,21 @@ static bool Control( input_thread_t *p_input,
             break;
         }
 
+        case INPUT_CONTROL_LEAVE_STANDBY:
+        {
+            input_thread_private_t *p_priv = input_priv( p_input );
+
+            if( !p_priv->b_standby )
+                break;
+            msg_Dbg( p_input, "leaving standby" );
+            p_priv->b_standby = false;
+            input_resource_SetInput( p_priv->p_resource, p_input );
+            es_out_SetStandby( p_priv->p_es_out_display, false );
+            /* The owner may only be listening from now on */
+            input_SendEventState( p_input, p_priv->i_state );
+            break;
+        }
+
         case INPUT_CONTROL_NAV_ACTIVATE:
         case INPUT_CONTROL_NAV_UP:
         case INPUT_CONTROL_NAV_DOWN:
@@ -3412,10 +3474,9 @@ void input_UpdateStatistic( input_thread_t *p_input,
 {
     assert( input_priv(p_input)->i_state != INIT_S );
 
-    vlc_mutex_lock( &input_priv(p_input)->counters.counters_lock);
     switch( i_type )
     {
-#define I(c) stats_Update( input_priv(p_input)->counters.c, i_delta, NULL )
+#define I(c) stats_Update( input_priv(p_input)->counters.c, i_delta )
     case INPUT_STATISTIC_DECODED_VIDEO:
         I(p_decoded_video);
         break;
@@ -3428,20 +3489,14 @@ void input_UpdateStatistic( input_thread_t *p_input,
     case INPUT_STATISTIC_SENT_PACKET:
         I(p_sout_sent_packets);
         break;
-#undef I
     case INPUT_STATISTIC_SENT_BYTE:
-    {
-        uint64_t bytes;
-
-        stats_Update( input_priv(p_input)->counters.p_sout_sent_bytes, i_delta, &bytes );
-        stats_Update( input_priv(p_input)->counters.p_sout_send_bitrate, bytes, NULL );
+        I(p_sout_sent_bytes);
         break;
-    }
+#undef I
     default:
         msg_Err( p_input, "Invalid statistic type %d (internal error)", i_type );
         break;
     }
-    vlc_mutex_unlock( &input_priv(p_input)->counters.counters_lock);
 }
 
 /**/
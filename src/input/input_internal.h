@@ -97,6 +97,7 @@ typedef struct input_thread_private_t
     bool        is_running;
     bool        is_stopped;
     bool        b_recording;
+    bool        b_standby; /* set before starting, cleared to switch to it */
     int         i_rate;
 
     /* Playtime configuration and state */
@@ -163,9 +164,16 @@ typedef struct input_thread_private_t
         counter_t *p_sout_send_bitrate;
         counter_t *p_played_abuffers;
         counter_t *p_lost_abuffers;
+        counter_t *p_aout_latency;
+        counter_t *p_aout_drift;
+        counter_t *p_aout_drift_max;
+        counter_t *p_aout_resampling;
+        counter_t *p_aout_underruns;
+        counter_t *p_aout_silences;
+        counter_t *pp_aout_drift_buckets[INPUT_STATS_DRIFT_BUCKETS];
         counter_t *p_displayed_pictures;
         counter_t *p_lost_pictures;
-        vlc_mutex_t counters_lock;
+        vlc_mutex_t counters_lock; /**< serializes the readers only */
     } counters;
 
     /* Buffer of pending actions */
@@ -233,6 +241,8 @@ enum input_control_e
     INPUT_CONTROL_SET_FRAME_NEXT,
 
     INPUT_CONTROL_SET_RENDERER,
+
+    INPUT_CONTROL_LEAVE_STANDBY,
 };
 
 /* Internal helpers */
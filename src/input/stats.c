@@ -26,14 +26,34 @@
 #endif
 
 #include <vlc_common.h>
+#include <vlc_atomic.h>
 #include "input/input_internal.h"
 
+typedef struct counter_sample_t
+{
+    uint64_t value;
+    mtime_t  date;
+} counter_sample_t;
+
+/* The counters are updated from the demux, decoder and output threads with
+ * relaxed atomic operations, and aggregated by the input thread when the
+ * statistics are computed. */
+struct counter_t
+{
+    int                  i_compute_type;
+    atomic_uint_fast64_t value;
+
+    /* Rate window of STATS_DERIVATIVE counters, sampled by the reader */
+    unsigned             i_samples;
+    counter_sample_t     samples[2];
+};
+
 /**
  * Create a statistics counter
  * \param i_compute_type the aggregation type. One of STATS_LAST (always
  * keep the last value), STATS_COUNTER (increment by the passed value),
- * STATS_MAX (keep the maximum passed value), STATS_MIN, or STATS_DERIVATIVE
- * (keep a time derivative of the value)
+ * STATS_MAX (keep the maximum passed value), or STATS_DERIVATIVE (keep a time
+ * derivative of a STATS_COUNTER, computed when read)
  */
 counter_t * stats_CounterCreate( int i_compute_type )
 {
@@ -41,30 +61,44 @@ counter_t * stats_CounterCreate( int i_compute_type )
 
     if( !p_counter ) return NULL;
     p_counter->i_compute_type = i_compute_type;
+    atomic_init( &p_counter->value, 0 );
     p_counter->i_samples = 0;
-    p_counter->pp_samples = NULL;
-
-    p_counter->last_update = 0;
 
     return p_counter;
 }
 
 static inline int64_t stats_GetTotal(const counter_t *counter)
 {
-    if (counter == NULL || counter->i_samples == 0)
+    if (counter == NULL)
         return 0;
-    return counter->pp_samples[0]->value;
+    return atomic_load_explicit(&counter->value, memory_order_relaxed);
 }
 
-static inline float stats_GetRate(const counter_t *counter)
+/* Samples the total at most once per second, so that the rate is averaged
+ * over at least a second however often the statistics are read. */
+static float stats_GetRate(counter_t *counter, const counter_t *total)
 {
-    if (counter == NULL || counter->i_samples < 2)
+    if (counter == NULL || total == NULL)
         return 0.;
 
-    return (counter->pp_samples[0]->value - counter->pp_samples[1]->value)
-        / (float)(counter->pp_samples[0]->date - counter->pp_samples[1]->date);
-}
+    mtime_t now = mdate();
+
+    if (counter->i_samples == 0
+     || now - counter->samples[0].date >= CLOCK_FREQ)
+    {
+        counter->samples[1] = counter->samples[0];
+        counter->samples[0].value = stats_GetTotal(total);
+        counter->samples[0].date = now;
+        if (counter->i_samples < 2)
+            counter->i_samples++;
+    }
+
+    if (counter->i_samples < 2)
+        return 0.;
 
+    return (counter->samples[0].value - counter->samples[1].value)
+        / (float)(counter->samples[0].date - counter->samples[1].date);
+}
 input_stats_t *stats_NewInputStats( input_thread_t *p_input )
 {
     (void)p_input;
@@ -91,9 +125,11 @@ void stats_ComputeInputStats(input_thread_t *input, input_stats_t *st)
     /* Input */
     st->i_read_packets = stats_GetTotal(priv->counters.p_read_packets);
     st->i_read_bytes = stats_GetTotal(priv->counters.p_read_bytes);
-    st->f_input_bitrate = stats_GetRate(priv->counters.p_input_bitrate);
+    st->f_input_bitrate = stats_GetRate(priv->counters.p_input_bitrate,
+                                     priv->counters.p_read_bytes);
     st->i_demux_read_bytes = stats_GetTotal(priv->counters.p_demux_read);
-    st->f_demux_bitrate = stats_GetRate(priv->counters.p_demux_bitrate);
+    st->f_demux_bitrate = stats_GetRate(priv->counters.p_demux_bitrate,
+                                     priv->counters.p_demux_read);
     st->i_demux_corrupted = stats_GetTotal(priv->counters.p_demux_corrupted);
     st->i_demux_discontinuity = stats_GetTotal(priv->counters.p_demux_discontinuity);
 
@@ -106,12 +142,22 @@ void stats_ComputeInputStats(input_thread_t *input, input_stats_t *st)
     {
         st->i_sent_packets = stats_GetTotal(priv->counters.p_sout_sent_packets);
         st->i_sent_bytes = stats_GetTotal(priv->counters.p_sout_sent_bytes);
-        st->f_send_bitrate = stats_GetRate(priv->counters.p_sout_send_bitrate);
+        st->f_send_bitrate = stats_GetRate(priv->counters.p_sout_send_bitrate,
+                                        priv->counters.p_sout_sent_bytes);
     }
 
     /* Aout */
     st->i_played_abuffers = stats_GetTotal(priv->counters.p_played_abuffers);
     st->i_lost_abuffers = stats_GetTotal(priv->counters.p_lost_abuffers);
+    st->i_aout_latency = stats_GetTotal(priv->counters.p_aout_latency);
+    st->i_aout_drift = stats_GetTotal(priv->counters.p_aout_drift);
+    st->i_aout_drift_max = stats_GetTotal(priv->counters.p_aout_drift_max);
+    st->i_aout_resampling = stats_GetTotal(priv->counters.p_aout_resampling);
+    st->i_aout_underruns = stats_GetTotal(priv->counters.p_aout_underruns);
+    st->i_aout_silences = stats_GetTotal(priv->counters.p_aout_silences);
+    for (unsigned i = 0; i < INPUT_STATS_DRIFT_BUCKETS; i++)
+        st->pi_aout_drift[i] =
+            stats_GetTotal(priv->counters.pp_aout_drift_buckets[i]);
 
     /* Vouts */
     st->i_displayed_pictures = stats_GetTotal(priv->counters.p_displayed_pictures);
@@ -134,76 +180,50 @@ void stats_ReinitInputStats( input_stats_t *p_stats )
     p_stats->i_decoded_video = p_stats->i_decoded_audio =
     p_stats->i_sent_bytes = p_stats->i_sent_packets = p_stats->f_send_bitrate
      = 0;
+    p_stats->i_aout_latency = p_stats->i_aout_drift =
+    p_stats->i_aout_drift_max = p_stats->i_aout_resampling =
+    p_stats->i_aout_underruns = p_stats->i_aout_silences = 0;
+    for( unsigned i = 0; i < INPUT_STATS_DRIFT_BUCKETS; i++ )
+        p_stats->pi_aout_drift[i] = 0;
     vlc_mutex_unlock( &p_stats->lock );
 }
 
 void stats_CounterClean( counter_t *p_c )
 {
-    if( p_c )
-    {
-        for( int i = 0; i < p_c->i_samples; i++ )
-            free( p_c->pp_samples[i] );
-        TAB_CLEAN(p_c->i_samples, p_c->pp_samples);
-        free( p_c );
-    }
+    free( p_c );
 }
 
-
-/** Update a counter element with new values
+/** Update a counter element with a new value
  * \param p_counter the counter to update
- * \param val the vlc_value union containing the new value to aggregate. For
- * more information on how data is aggregated, \see stats_Create
- * \param val_new a pointer that will be filled with new data
+ * \param val the new value to aggregate. For more information on how data is
+ * aggregated, \see stats_CounterCreate
  */
-void stats_Update( counter_t *p_counter, uint64_t val, uint64_t *new_val )
+void stats_Update( counter_t *p_counter, uint64_t val )
 {
     if( !p_counter )
         return;
 
     switch( p_counter->i_compute_type )
     {
-    case STATS_DERIVATIVE:
+    case STATS_COUNTER:
+        atomic_fetch_add_explicit( &p_counter->value, val,
+                                   memory_order_relaxed );
+        break;
+    case STATS_LAST:
+        atomic_store_explicit( &p_counter->value, val, memory_order_relaxed );
+        break;
+    case STATS_MAX:
     {
-        counter_sample_t *p_new, *p_old;
-        mtime_t now = mdate();
-        if( now - p_counter->last_update < CLOCK_FREQ )
-            return;
-        p_counter->last_update = now;
-        /* Insert the new one at the beginning */
-        p_new = (counter_sample_t*)malloc( sizeof( counter_sample_t ) );
-        if (unlikely(p_new == NULL))
-            return; /* NOTE: Losing sample here */
-
-        p_new->value = val;
-        p_new->date = p_counter->last_update;
-        TAB_INSERT(p_counter->i_samples, p_counter->pp_samples, p_new, 0);
-
-        if( p_counter->i_samples == 3 )
-        {
-            p_old = p_counter->pp_samples[2];
-            TAB_ERASE(p_counter->i_samples, p_counter->pp_samples, 2);
-            free( p_old );
-        }
+        uint_fast64_t old = atomic_load_explicit( &p_counter->value,
+                                                  memory_order_relaxed );
+        while( val > old
+            && !atomic_compare_exchange_weak_explicit( &p_counter->value,
+                                    &old, val, memory_order_relaxed,
+                                    memory_order_relaxed ) );
         break;
     }
-    case STATS_COUNTER:
-        if( p_counter->i_samples == 0 )
-        {
-            counter_sample_t *p_new = (counter_sample_t*)malloc(
-                                               sizeof( counter_sample_t ) );
-            if (unlikely(p_new == NULL))
-                return; /* NOTE: Losing sample here */
-
-            p_new->value = 0;
-
-            TAB_APPEND(p_counter->i_samples, p_counter->pp_samples, p_new);
-        }
-        if( p_counter->i_samples == 1 )
-        {
-            p_counter->pp_samples[0]->value += val;
-            if( new_val )
-                *new_val = p_counter->pp_samples[0]->value;
-        }
+    case STATS_DERIVATIVE:
+        /* Computed from the total counter when read */
         break;
     }
 }
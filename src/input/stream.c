@@ -699,9 +699,33 @@ int vlc_stream_vaControl(stream_t *s, int cmd, va_list args)
  */
 block_t *vlc_stream_Block( stream_t *s, size_t size )
 {
+    stream_priv_t *priv = (stream_priv_t *)s;
+
     if( unlikely(size > SSIZE_MAX) )
         return NULL;
 
+    /* Reference the data of the pending block (e.g. memory mapped by the
+     * access) rather than copying it, if it holds all of it. The slices do
+     * not overlap, so each owner may still write into its own data. */
+    block_t **pp = (priv->peek != NULL) ? &priv->peek : &priv->block;
+    if( *pp != NULL && (*pp)->i_buffer >= size && size > 0 )
+    {
+        block_t *shareable = block_Shareable( *pp );
+
+        *pp = shareable;
+        if( unlikely(shareable == NULL) )
+            return NULL;
+
+        block_t *block = block_Share( shareable );
+        if( likely(block != NULL) )
+        {
+            block->i_buffer = size;
+            vlc_stream_CopyBlock( pp, NULL, size );
+            priv->offset += size;
+            return block;
+        }
+    }
+
     block_t *block = block_Alloc( size );
     if( unlikely(block == NULL) )
         return NULL;
@@ -48,6 +48,7 @@
 #include <vlc_vod.h>
 #include <vlc_sout.h>
 #include <vlc_url.h>
+#include <vlc_memstream.h>
 #include "../stream_output/stream_output.h"
 #include "../libvlc.h"
 
@@ -55,7 +56,7 @@
  * Local prototypes.
  *****************************************************************************/
 
-static void* Manage( void * );
+static void Manage( void * );
 static int vlm_MediaVodControl( void *, vod_media_t *, const char *, int, va_list );
 
 typedef struct preparse_data_t
@@ -101,10 +102,7 @@ static int InputEvent( vlc_object_t *p_this, char const *psz_cmd,
         }
         vlm_SendEventMediaInstanceState( p_vlm, p_media->cfg.id, p_media->cfg.psz_name, psz_instance_name, var_GetInteger( p_input, "state" ) );
 
-        vlc_mutex_lock( &p_vlm->lock_manage );
-        p_vlm->input_state_changed = true;
-        vlc_cond_signal( &p_vlm->wait_manage );
-        vlc_mutex_unlock( &p_vlm->lock_manage );
+        vlm_ManageWakeUp( p_vlm );
     }
     return VLC_SUCCESS;
 }
@@ -145,21 +143,19 @@ vlm_t *vlm_New ( vlc_object_t *p_this )
     }
 
     vlc_mutex_init( &p_vlm->lock );
-    vlc_mutex_init( &p_vlm->lock_manage );
-    vlc_cond_init_daytime( &p_vlm->wait_manage );
     p_vlm->users = 1;
-    p_vlm->input_state_changed = false;
+    time( &p_vlm->lastcheck );
+    atomic_init( &p_vlm->input_state_changed, false );
     p_vlm->i_id = 1;
     TAB_INIT( p_vlm->i_media, p_vlm->media );
     TAB_INIT( p_vlm->i_schedule, p_vlm->schedule );
+    TAB_INIT( p_vlm->i_shared, p_vlm->shared );
     p_vlm->p_vod = NULL;
     var_Create( p_vlm, "intf-event", VLC_VAR_ADDRESS );
 
-    if( vlc_clone( &p_vlm->thread, Manage, p_vlm, VLC_THREAD_PRIORITY_LOW ) )
+    if( vlc_timer_create( &p_vlm->manage_timer, Manage, p_vlm ) )
     {
-        vlc_cond_destroy( &p_vlm->wait_manage );
         vlc_mutex_destroy( &p_vlm->lock );
-        vlc_mutex_destroy( &p_vlm->lock_manage );
         vlc_object_release( p_vlm );
         vlc_mutex_unlock( &vlm_mutex );
         return NULL;
@@ -219,9 +215,12 @@ void vlm_Delete( vlm_t *p_vlm )
 
     vlm_ControlInternal( p_vlm, VLM_CLEAR_SCHEDULES );
     TAB_CLEAN( p_vlm->i_schedule, p_vlm->schedule );
+    assert( p_vlm->i_shared == 0 );
+    TAB_CLEAN( p_vlm->i_shared, p_vlm->shared );
     vlc_mutex_unlock( &p_vlm->lock );
 
-    vlc_cancel( p_vlm->thread );
+    /* Waits for a pending run of the manager, it has nothing left to do */
+    vlc_timer_destroy( p_vlm->manage_timer );
 
     if( p_vlm->p_vod )
     {
@@ -232,11 +231,7 @@ void vlm_Delete( vlm_t *p_vlm )
     libvlc_priv(p_vlm->obj.libvlc)->p_vlm = NULL;
     vlc_mutex_unlock( &vlm_mutex );
 
-    vlc_join( p_vlm->thread, NULL );
-
-    vlc_cond_destroy( &p_vlm->wait_manage );
     vlc_mutex_destroy( &p_vlm->lock );
-    vlc_mutex_destroy( &p_vlm->lock_manage );
     vlc_object_release( p_vlm );
 }
 
@@ -374,140 +369,141 @@ static int vlm_MediaVodControl( void *p_private, vod_media_t *p_vod_media,
 
 /*****************************************************************************
  * Manage:
+ *****************************************************************************
+ * Runs on the timer threads, either as soon as an input changed state, or
+ * on the date of the next schedule.
  *****************************************************************************/
-static void* Manage( void* p_object )
+/* As the schedules use the wall clock, it may be adjusted meanwhile */
+#define MANAGE_MAX_DELAY (60 * CLOCK_FREQ)
+
+void vlm_ManageWakeUp( vlm_t *vlm )
+{
+    atomic_store( &vlm->input_state_changed, true );
+    vlc_timer_schedule( vlm->manage_timer, false, 1, 0 );
+}
+
+static void Manage( void* p_object )
 {
     vlm_t *vlm = (vlm_t*)p_object;
     time_t lastcheck, now, nextschedule = 0;
+    char **ppsz_scheduled_commands = NULL;
+    int    i_scheduled_commands = 0;
 
-    time(&lastcheck);
+    atomic_store( &vlm->input_state_changed, false );
 
-    for( ;; )
+    /* destroy the inputs that wants to die, and launch the next input */
+    vlc_mutex_lock( &vlm->lock );
+    lastcheck = vlm->lastcheck;
+    for( int i = 0; i < vlm->i_media; i++ )
     {
-        char **ppsz_scheduled_commands = NULL;
-        int    i_scheduled_commands = 0;
-        bool scheduled_command = false;
+        vlm_media_sys_t *p_media = vlm->media[i];
 
-        vlc_mutex_lock( &vlm->lock_manage );
-        mutex_cleanup_push( &vlm->lock_manage );
-        while( !vlm->input_state_changed && !scheduled_command )
-        {
-            if( nextschedule != 0 )
-                scheduled_command = vlc_cond_timedwait_daytime( &vlm->wait_manage, &vlm->lock_manage, nextschedule ) != 0;
-            else
-                vlc_cond_wait( &vlm->wait_manage, &vlm->lock_manage );
-        }
-        vlm->input_state_changed = false;
-        vlc_cleanup_pop( );
-        vlc_mutex_unlock( &vlm->lock_manage );
-
-        int canc = vlc_savecancel ();
-        /* destroy the inputs that wants to die, and launch the next input */
-        vlc_mutex_lock( &vlm->lock );
-        for( int i = 0; i < vlm->i_media; i++ )
+        for( int j = 0; j < p_media->i_instance; )
         {
-            vlm_media_sys_t *p_media = vlm->media[i];
+            vlm_media_instance_sys_t *p_instance = p_media->instance[j];
+            int state = INIT_S;
 
-            for( int j = 0; j < p_media->i_instance; )
+            if( p_instance->p_input != NULL )
+                state = var_GetInteger( p_instance->p_input, "state" );
+            if( state == END_S || state == ERROR_S )
             {
-                vlm_media_instance_sys_t *p_instance = p_media->instance[j];
-                int state = INIT_S;
-
-                if( p_instance->p_input != NULL )
-                    state = var_GetInteger( p_instance->p_input, "state" );
-                if( state == END_S || state == ERROR_S )
-                {
-                    int i_new_input_index;
+                int i_new_input_index;
 
-                    /* */
-                    i_new_input_index = p_instance->i_index + 1;
-                    if( !p_media->cfg.b_vod && p_media->cfg.broadcast.b_loop && i_new_input_index >= p_media->cfg.i_input )
-                        i_new_input_index = 0;
+                /* */
+                i_new_input_index = p_instance->i_index + 1;
+                if( !p_media->cfg.b_vod && p_media->cfg.broadcast.b_loop && i_new_input_index >= p_media->cfg.i_input )
+                    i_new_input_index = 0;
 
-                    /* FIXME implement multiple input with VOD */
-                    if( p_media->cfg.b_vod || i_new_input_index >= p_media->cfg.i_input )
-                        vlm_ControlInternal( vlm, VLM_STOP_MEDIA_INSTANCE, p_media->cfg.id, p_instance->psz_name );
-                    else
-                        vlm_ControlInternal( vlm, VLM_START_MEDIA_BROADCAST_INSTANCE, p_media->cfg.id, p_instance->psz_name, i_new_input_index );
-
-                    j = 0;
-                }
+                /* FIXME implement multiple input with VOD */
+                if( p_media->cfg.b_vod || i_new_input_index >= p_media->cfg.i_input )
+                    vlm_ControlInternal( vlm, VLM_STOP_MEDIA_INSTANCE, p_media->cfg.id, p_instance->psz_name );
                 else
-                {
-                    j++;
-                }
+                    vlm_ControlInternal( vlm, VLM_START_MEDIA_BROADCAST_INSTANCE, p_media->cfg.id, p_instance->psz_name, i_new_input_index );
+
+                j = 0;
+            }
+            else
+            {
+                j++;
             }
         }
+    }
 
-        /* scheduling */
-        time(&now);
-        nextschedule = 0;
+    /* scheduling */
+    time(&now);
+    nextschedule = 0;
 
-        for( int i = 0; i < vlm->i_schedule; i++ )
-        {
-            time_t real_date = vlm->schedule[i]->date;
+    for( int i = 0; i < vlm->i_schedule; i++ )
+    {
+        time_t real_date = vlm->schedule[i]->date;
 
-            if( vlm->schedule[i]->b_enabled )
+        if( vlm->schedule[i]->b_enabled )
+        {
+            if( vlm->schedule[i]->date == 0 ) // now !
+            {
+                vlm->schedule[i]->date = now;
+                real_date = now;
+            }
+            else if( vlm->schedule[i]->period != 0 )
             {
-                if( vlm->schedule[i]->date == 0 ) // now !
+                int j = 0;
+                while( ((vlm->schedule[i]->date + j *
+                         vlm->schedule[i]->period) <= lastcheck) &&
+                       ( vlm->schedule[i]->i_repeat > j ||
+                         vlm->schedule[i]->i_repeat < 0 ) )
                 {
-                    vlm->schedule[i]->date = now;
-                    real_date = now;
+                    j++;
                 }
-                else if( vlm->schedule[i]->period != 0 )
-                {
-                    int j = 0;
-                    while( ((vlm->schedule[i]->date + j *
-                             vlm->schedule[i]->period) <= lastcheck) &&
-                           ( vlm->schedule[i]->i_repeat > j ||
-                             vlm->schedule[i]->i_repeat < 0 ) )
-                    {
-                        j++;
-                    }
 
-                    real_date = vlm->schedule[i]->date + j *
-                        vlm->schedule[i]->period;
-                }
+                real_date = vlm->schedule[i]->date + j *
+                    vlm->schedule[i]->period;
+            }
 
-                if( real_date <= now )
+            if( real_date <= now )
+            {
+                if( real_date > lastcheck )
                 {
-                    if( real_date > lastcheck )
+                    for( int j = 0; j < vlm->schedule[i]->i_command; j++ )
                     {
-                        for( int j = 0; j < vlm->schedule[i]->i_command; j++ )
-                        {
-                            TAB_APPEND( i_scheduled_commands,
-                                        ppsz_scheduled_commands,
-                                        strdup(vlm->schedule[i]->command[j] ) );
-                        }
+                        TAB_APPEND( i_scheduled_commands,
+                                    ppsz_scheduled_commands,
+                                    strdup(vlm->schedule[i]->command[j] ) );
                     }
                 }
-                else if( nextschedule == 0 || real_date < nextschedule )
-                {
-                    nextschedule = real_date;
-                }
+            }
+            else if( nextschedule == 0 || real_date < nextschedule )
+            {
+                nextschedule = real_date;
             }
         }
+    }
 
-        while( i_scheduled_commands )
-        {
-            vlm_message_t *message = NULL;
-            char *psz_command = ppsz_scheduled_commands[0];
-            ExecuteCommand( vlm, psz_command,&message );
-
-            /* for now, drop the message */
-            vlm_MessageDelete( message );
-            TAB_REMOVE( i_scheduled_commands,
-                        ppsz_scheduled_commands,
-                        psz_command );
-            free( psz_command );
-        }
-
-        lastcheck = now;
-        vlc_mutex_unlock( &vlm->lock );
-        vlc_restorecancel (canc);
+    while( i_scheduled_commands )
+    {
+        vlm_message_t *message = NULL;
+        char *psz_command = ppsz_scheduled_commands[0];
+        ExecuteCommand( vlm, psz_command,&message );
+
+        /* for now, drop the message */
+        vlm_MessageDelete( message );
+        TAB_REMOVE( i_scheduled_commands,
+                    ppsz_scheduled_commands,
+                    psz_command );
+        free( psz_command );
     }
 
-    return NULL;
+    vlm->lastcheck = now;
+    vlc_mutex_unlock( &vlm->lock );
+
+    if( nextschedule != 0 )
+    {
+        mtime_t delay = (mtime_t)(nextschedule - now) * CLOCK_FREQ;
+        vlc_timer_schedule( vlm->manage_timer, false,
+                            __MIN( delay, MANAGE_MAX_DELAY ), 0 );
+    }
+    /* A wake up during this run may have been overridden just above */
+    if( atomic_load( &vlm->input_state_changed ) )
+        vlc_timer_schedule( vlm->manage_timer, false, 1, 0 );
 }
 
 /* New API
@@ -876,13 +872,224 @@ static vlm_media_instance_sys_t *vlm_MediaInstanceNew( vlm_t *p_vlm, const char
     p_instance->p_parent = vlc_object_create( p_vlm, sizeof (vlc_object_t) );
     p_instance->p_input = NULL;
     p_instance->p_input_resource = input_resource_New( p_instance->p_parent );
+    p_instance->p_media = NULL;
+    p_instance->p_shared = NULL;
 
     return p_instance;
 }
+
+/* Shared inputs:
+ * The broadcast instances of the same input MRL with the same options are
+ * fed by a single input, with a duplicate of all their outputs. Starting or
+ * stopping one of them restarts the input for the others. */
+static char *vlm_SharedInputKey( const vlm_media_sys_t *p_media, const char *psz_uri )
+{
+    const vlm_media_t *p_cfg = &p_media->cfg;
+    struct vlc_memstream stream;
+
+    if( p_cfg->b_vod || p_cfg->psz_output == NULL || p_cfg->psz_output[0] != '#' )
+        return NULL;
+
+    vlc_memstream_open( &stream );
+    vlc_memstream_puts( &stream, psz_uri );
+    for( int i = 0; i < p_cfg->i_option; i++ )
+    {
+        /* The output of the input would be kept across the restarts */
+        if( !strcmp( p_cfg->ppsz_option[i], "sout-keep" ) )
+        {
+            if( vlc_memstream_close( &stream ) == 0 )
+                free( stream.ptr );
+            return NULL;
+        }
+        vlc_memstream_printf( &stream, "\n%s", p_cfg->ppsz_option[i] );
+    }
+    return vlc_memstream_close( &stream ) == 0 ? stream.ptr : NULL;
+}
+
+static void vlm_SharedInputStop( vlm_t *p_vlm, vlm_shared_input_t *p_shared )
+{
+    if( p_shared->p_input == NULL )
+        return;
+
+    input_Stop( p_shared->p_input );
+    input_Close( p_shared->p_input );
+    p_shared->p_input = NULL;
+
+    input_resource_TerminateSout( p_shared->p_input_resource );
+    input_resource_TerminateVout( p_shared->p_input_resource );
+
+    for( int i = 0; i < p_shared->i_instance; i++ )
+    {
+        vlm_media_instance_sys_t *p_instance = p_shared->instance[i];
+
+        p_instance->p_input = NULL;
+        vlm_SendEventMediaInstanceStopped( p_vlm, p_instance->p_media->cfg.id,
+                                           p_instance->p_media->cfg.psz_name );
+    }
+}
+
+static void vlm_SharedInputStart( vlm_t *p_vlm, vlm_shared_input_t *p_shared )
+{
+    const vlm_media_t *p_cfg = &p_shared->instance[0]->p_media->cfg;
+    struct vlc_memstream sout;
+    char *psz_log;
+
+    vlm_SharedInputStop( p_vlm, p_shared );
+
+    /* The options are the same for all the instances, only the outputs
+     * differ */
+    vlc_memstream_open( &sout );
+    if( p_shared->i_instance == 1 )
+        vlc_memstream_printf( &sout, "sout=%s", p_cfg->psz_output );
+    else
+    {
+        vlc_memstream_puts( &sout, "sout=#duplicate{" );
+        for( int i = 0; i < p_shared->i_instance; i++ )
+            vlc_memstream_printf( &sout, "%sdst=%s", i ? "," : "",
+                          p_shared->instance[i]->p_media->cfg.psz_output + 1 );
+        vlc_memstream_putc( &sout, '}' );
+    }
+    if( vlc_memstream_close( &sout ) )
+        return;
+
+    input_item_t *p_item = input_item_New( p_shared->p_item->psz_uri, NULL );
+    if( p_item == NULL )
+    {
+        free( sout.ptr );
+        return;
+    }
+    input_item_AddOption( p_item, sout.ptr, VLC_INPUT_OPTION_TRUSTED );
+    free( sout.ptr );
+    for( int i = 0; i < p_cfg->i_option; i++ )
+        if( strcmp( p_cfg->ppsz_option[i], "nosout-keep" )
+         && strcmp( p_cfg->ppsz_option[i], "no-sout-keep" ) )
+            input_item_AddOption( p_item, p_cfg->ppsz_option[i], VLC_INPUT_OPTION_TRUSTED );
+
+    input_item_Release( p_shared->p_item );
+    p_shared->p_item = p_item;
+
+    if( asprintf( &psz_log, _("Media: %s"), p_cfg->psz_name ) == -1 )
+        return;
+
+    input_thread_t *p_input = input_Create( p_shared->p_parent, p_item,
+                                            psz_log, p_shared->p_input_resource,
+                                            NULL );
+    free( psz_log );
+    if( p_input == NULL )
+        return;
+
+    for( int i = 0; i < p_shared->i_instance; i++ )
+        var_AddCallback( p_input, "intf-event", InputEvent,
+                         p_shared->instance[i]->p_media );
+
+    if( input_Start( p_input ) != VLC_SUCCESS )
+    {
+        for( int i = 0; i < p_shared->i_instance; i++ )
+            var_DelCallback( p_input, "intf-event", InputEvent,
+                             p_shared->instance[i]->p_media );
+        input_Close( p_input );
+        return;
+    }
+
+    p_shared->p_input = p_input;
+    for( int i = 0; i < p_shared->i_instance; i++ )
+    {
+        vlm_media_instance_sys_t *p_instance = p_shared->instance[i];
+
+        p_instance->p_input = p_input;
+        vlm_SendEventMediaInstanceStarted( p_vlm, p_instance->p_media->cfg.id,
+                                           p_instance->p_media->cfg.psz_name );
+    }
+}
+
+static int vlm_SharedInputAttach( vlm_t *p_vlm, vlm_media_instance_sys_t *p_instance, char *psz_key, const char *psz_uri )
+{
+    vlm_shared_input_t *p_shared = NULL;
+
+    for( int i = 0; i < p_vlm->i_shared; i++ )
+        if( !strcmp( p_vlm->shared[i]->psz_key, psz_key ) )
+        {
+            p_shared = p_vlm->shared[i];
+            break;
+        }
+
+    if( p_shared == NULL )
+    {
+        p_shared = malloc( sizeof( *p_shared ) );
+        if( !p_shared )
+        {
+            free( psz_key );
+            return VLC_ENOMEM;
+        }
+
+        p_shared->psz_key = psz_key;
+        p_shared->p_parent = vlc_object_create( p_vlm, sizeof (vlc_object_t) );
+        p_shared->p_input_resource = input_resource_New( p_shared->p_parent );
+        p_shared->p_item = input_item_New( psz_uri, NULL );
+        p_shared->p_input = NULL;
+        TAB_INIT( p_shared->i_instance, p_shared->instance );
+        TAB_APPEND( p_vlm->i_shared, p_vlm->shared, p_shared );
+    }
+    else
+    {
+        free( psz_key );
+        msg_Dbg( p_vlm, "media %s shares the input of media %s",
+                 p_instance->p_media->cfg.psz_name,
+                 p_shared->instance[0]->p_media->cfg.psz_name );
+    }
+
+    TAB_APPEND( p_shared->i_instance, p_shared->instance, p_instance );
+    p_instance->p_shared = p_shared;
+    vlm_SharedInputStart( p_vlm, p_shared );
+    return VLC_SUCCESS;
+}
+
+static void vlm_SharedInputDetach( vlm_t *p_vlm, vlm_media_instance_sys_t *p_instance )
+{
+    vlm_shared_input_t *p_shared = p_instance->p_shared;
+    input_thread_t *p_input = p_shared->p_input;
+    bool b_ended = false;
+
+    if( p_input != NULL )
+    {
+        int state = var_GetInteger( p_input, "state" );
+
+        b_ended = state == END_S || state == ERROR_S;
+        var_DelCallback( p_input, "intf-event", InputEvent, p_instance->p_media );
+    }
+
+    TAB_REMOVE( p_shared->i_instance, p_shared->instance, p_instance );
+    p_instance->p_shared = NULL;
+    p_instance->p_input = NULL;
+
+    if( p_shared->i_instance == 0 )
+    {
+        vlm_SharedInputStop( p_vlm, p_shared );
+        input_resource_Terminate( p_shared->p_input_resource );
+        input_resource_Release( p_shared->p_input_resource );
+        vlc_object_release( p_shared->p_parent );
+        input_item_Release( p_shared->p_item );
+        TAB_CLEAN( p_shared->i_instance, p_shared->instance );
+        TAB_REMOVE( p_vlm->i_shared, p_vlm->shared, p_shared );
+        free( p_shared->psz_key );
+        free( p_shared );
+    }
+    else if( !b_ended )
+        /* The other instances will move to their next input by themselves
+         * when it has ended */
+        vlm_SharedInputStart( p_vlm, p_shared );
+}
+
 static void vlm_MediaInstanceDelete( vlm_t *p_vlm, int64_t id, vlm_media_instance_sys_t *p_instance, vlm_media_sys_t *p_media )
 {
     input_thread_t *p_input = p_instance->p_input;
-    if( p_input )
+    if( p_instance->p_shared )
+    {
+        vlm_SharedInputDetach( p_vlm, p_instance );
+        if( p_input )
+            vlm_SendEventMediaInstanceStopped( p_vlm, id, p_media->cfg.psz_name );
+    }
+    else if( p_input )
     {
         input_Stop( p_input );
         input_Close( p_input );
@@ -925,6 +1132,7 @@ static int vlm_ControlMediaInstanceStart( vlm_t *p_vlm, int64_t id, const char *
         p_instance = vlm_MediaInstanceNew( p_vlm, psz_id );
         if( !p_instance )
             return VLC_ENOMEM;
+        p_instance->p_media = p_media;
 
         if ( p_cfg->b_vod )
         {
@@ -972,15 +1180,22 @@ static int vlm_ControlMediaInstanceStart( vlm_t *p_vlm, int64_t id, const char *
             return VLC_SUCCESS;
         }
 
-        input_Stop( p_input );
-        input_Close( p_input );
+        if( p_instance->p_shared )
+            vlm_SharedInputDetach( p_vlm, p_instance );
+        else
+        {
+            input_Stop( p_input );
+            input_Close( p_input );
 
-        if( !p_instance->b_sout_keep )
-            input_resource_TerminateSout( p_instance->p_input_resource );
-        input_resource_TerminateVout( p_instance->p_input_resource );
+            if( !p_instance->b_sout_keep )
+                input_resource_TerminateSout( p_instance->p_input_resource );
+            input_resource_TerminateVout( p_instance->p_input_resource );
+        }
 
         vlm_SendEventMediaInstanceStopped( p_vlm, id, p_media->cfg.psz_name );
     }
+    else if( p_instance->p_shared )
+        vlm_SharedInputDetach( p_vlm, p_instance );
 
     /* Start new one */
     p_instance->i_index = i_input_index;
@@ -994,6 +1209,16 @@ static int vlm_ControlMediaInstanceStart( vlm_t *p_vlm, int64_t id, const char *
     else
         input_item_SetURI( p_instance->p_item, p_media->cfg.ppsz_input[p_instance->i_index] ) ;
 
+    char *psz_key = vlm_SharedInputKey( p_media, p_instance->p_item->psz_uri );
+    if( psz_key != NULL )
+    {
+        int i_ret = vlm_SharedInputAttach( p_vlm, p_instance, psz_key,
+                                           p_instance->p_item->psz_uri );
+        if( i_ret != VLC_SUCCESS || !p_instance->p_input )
+            vlm_MediaInstanceDelete( p_vlm, id, p_instance, p_media );
+        return i_ret;
+    }
+
     if( asprintf( &psz_log, _("Media: %s"), p_media->cfg.psz_name ) != -1 )
     {
         p_instance->p_input = input_Create( p_instance->p_parent,
@@ -25,9 +25,13 @@
 #define LIBVLC_VLM_INTERNAL_H 1
 
 #include <vlc_vlm.h>
+#include <vlc_atomic.h>
 #include "input_interface.h"
 
 /* Private */
+typedef struct vlm_media_sys_t vlm_media_sys_t;
+typedef struct vlm_shared_input_t vlm_shared_input_t;
+
 typedef struct
 {
     /* instance name */
@@ -43,10 +47,14 @@ typedef struct
     input_thread_t    *p_input;
     input_resource_t *p_input_resource;
 
+    /* broadcast instances of the same input share it, see below */
+    vlm_media_sys_t    *p_media;
+    vlm_shared_input_t *p_shared;
+
 } vlm_media_instance_sys_t;
 
 
-typedef struct
+struct vlm_media_sys_t
 {
     vlm_media_t cfg;
 
@@ -59,7 +67,22 @@ typedef struct
     /* actual input instances */
     int                      i_instance;
     vlm_media_instance_sys_t **instance;
-} vlm_media_sys_t;
+};
+
+/* One input demuxed once for all the broadcast instances with the same
+ * input MRL and options, its outputs are duplicated */
+struct vlm_shared_input_t
+{
+    char *psz_key;
+
+    vlc_object_t     *p_parent;
+    input_resource_t *p_input_resource;
+    input_item_t     *p_item;
+    input_thread_t   *p_input;
+
+    int                      i_instance;
+    vlm_media_instance_sys_t **instance;
+};
 
 typedef struct
 {
@@ -86,13 +109,13 @@ struct vlm_t
     VLC_COMMON_MEMBERS
 
     vlc_mutex_t  lock;
-    vlc_thread_t thread;
-    vlc_mutex_t  lock_manage;
-    vlc_cond_t   wait_manage;
     unsigned     users;
 
-    /* tell vlm thread there is work to do */
-    bool         input_state_changed;
+    /* media instances and schedules are managed on the timer threads */
+    vlc_timer_t  manage_timer;
+    time_t       lastcheck;
+    /* tell the manager there is work to do */
+    atomic_bool  input_state_changed;
     /* */
     int64_t        i_id;
 
@@ -106,10 +129,15 @@ struct vlm_t
     /* Schedule list */
     int            i_schedule;
     vlm_schedule_sys_t **schedule;
+
+    /* Inputs shared by broadcast instances */
+    int                i_shared;
+    vlm_shared_input_t **shared;
 };
 
 int vlm_ControlInternal( vlm_t *p_vlm, int i_query, ... );
 int ExecuteCommand( vlm_t *, const char *, vlm_message_t ** );
 void vlm_ScheduleDelete( vlm_t *vlm, vlm_schedule_sys_t *sched );
+void vlm_ManageWakeUp( vlm_t *vlm );
 
 #endif
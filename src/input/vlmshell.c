@@ -637,10 +637,7 @@ static int ExecuteScheduleProperty( vlm_t *p_vlm, vlm_schedule_sys_t *p_schedule
     }
     *pp_status = vlm_MessageSimpleNew( psz_cmd );
 
-    vlc_mutex_lock( &p_vlm->lock_manage );
-    p_vlm->input_state_changed = true;
-    vlc_cond_signal( &p_vlm->wait_manage );
-    vlc_mutex_unlock( &p_vlm->lock_manage );
+    vlm_ManageWakeUp( p_vlm );
 
     return VLC_SUCCESS;
 
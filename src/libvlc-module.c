@@ -87,6 +87,18 @@ static const char *const ppsz_snap_formats[] =
     "This is the verbosity level (0=only errors and " \
     "standard messages, 1=warnings, 2=debug).")
 
+#define LOG_ASYNC_TEXT N_("Asynchronous logging")
+#define LOG_ASYNC_LONGTEXT N_( \
+    "Log messages are passed to the logger by a background thread, " \
+    "so that logging does not slow down the other threads. Messages " \
+    "can be lost if they are logged faster than they are output.")
+
+#define LOG_RATE_TEXT N_("Log rate limits")
+#define LOG_RATE_LONGTEXT N_( \
+    "Maximum number of log messages per second and per module, " \
+    "e.g. \"100,avcodec=1000,ts=10\". A number alone applies to all " \
+    "other modules, and 0 means no limit.")
+
 #define OPEN_TEXT N_("Default stream")
 #define OPEN_LONGTEXT N_( \
     "This stream will always be opened at VLC startup." )
@@ -390,6 +402,11 @@ static const char *const ppsz_pos_descriptions[] =
     "picture quality, for instance deinterlacing, or distort " \
     "the video.")
 
+#define FILTER_THREADS_TEXT N_("Video filter threads")
+#define FILTER_THREADS_LONGTEXT N_( \
+    "Number of threads the video filters supporting it can use to process " \
+    "a picture, 0 meaning auto." )
+
 #define SNAP_PATH_TEXT N_("Video snapshot directory (or filename)")
 #define SNAP_PATH_LONGTEXT N_( \
     "Directory where the video snapshots will be stored.")
@@ -422,6 +439,11 @@ static const char *const ppsz_pos_descriptions[] =
     "it will keep the original height (-1). Using 0 will scale the height " \
     "to keep the aspect ratio." )
 
+#define SNAP_INTERVAL_TEXT N_("Minimum snapshot interval (ms)")
+#define SNAP_INTERVAL_LONGTEXT N_( \
+    "Asynchronous snapshot requests made less than this delay after the " \
+    "previous one are refused." )
+
 #define CROP_TEXT N_("Video cropping")
 #define CROP_LONGTEXT N_( \
     "This forces the cropping of the source video. " \
@@ -534,6 +556,16 @@ static const char *const ppsz_pos_descriptions[] =
     "This defines the maximum input delay jitter that the synchronization " \
     "algorithms should try to compensate (in milliseconds)." )
 
+#define CLOCK_ADAPTIVE_TEXT N_("Adaptive caching")
+#define CLOCK_ADAPTIVE_LONGTEXT N_( \
+    "Lower the caching of live streams while the clock references arrive " \
+    "in time, so that they play with the lowest stable latency." )
+
+#define CLOCK_ADAPTIVE_MIN_TEXT N_("Minimum adaptive caching")
+#define CLOCK_ADAPTIVE_MIN_LONGTEXT N_( \
+    "The adaptive caching is not lowered below this value (in " \
+    "milliseconds)." )
+
 #define NETSYNC_TEXT N_("Network synchronisation" )
 #define NETSYNC_LONGTEXT N_( "This allows you to remotely " \
         "synchronise clocks for server and client. The detailed settings " \
@@ -1034,6 +1066,17 @@ static const char *const ppsz_prefres[] = {
     "priorities. You can use it to tune VLC priority against other " \
     "programs, or against other VLC instances.")
 
+#define BLOCK_POOL_TEXT N_("Recycle data blocks")
+#define BLOCK_POOL_LONGTEXT N_( \
+    "Keep released data blocks of common sizes for reuse, instead of " \
+    "returning them to the system memory allocator.")
+
+#define KERNEL_AUTOTUNE_TEXT N_("Measure the processing kernels")
+#define KERNEL_AUTOTUNE_LONGTEXT N_( \
+    "Measure the alternative implementations of the processing kernels " \
+    "on first use, and use the fastest one on this CPU instead of the " \
+    "most specialized one. The results are kept in the cache directory.")
+
 #define USE_STREAM_IMMEDIATE_LONGTEXT N_( \
      "This option is useful if you want to lower the latency when " \
      "reading a stream")
@@ -1068,6 +1111,11 @@ static const char *const ppsz_prefres[] = {
 #define PIDFILE_LONGTEXT N_( \
        "Writes process id into specified file.")
 
+#define TRACE_FILE_TEXT N_("Write the pipeline trace to file")
+#define TRACE_FILE_LONGTEXT N_( \
+    "Writes the events traced in the decoding pipelines into the specified " \
+    "file when exiting, in the Chrome trace format.")
+
 #define ONEINSTANCE_TEXT N_("Allow only one running instance")
 #define ONEINSTANCE_LONGTEXT N_( \
     "Allowing only one running instance of VLC can sometimes be useful, " \
@@ -1120,6 +1168,10 @@ static const char *const ppsz_prefres[] = {
 #define PREPARSE_TIMEOUT_LONGTEXT N_( \
     "Maximum time (in milliseconds) allowed to preparse an item" )
 
+#define PREPARSE_THREADS_TEXT N_( "Preparsing threads" )
+#define PREPARSE_THREADS_LONGTEXT N_( \
+    "Maximum number of items preparsed concurrently, 0 meaning auto" )
+
 #define METADATA_NETWORK_TEXT N_( "Allow metadata network access" )
 
 static const char *const psz_recursive_list[] = {
@@ -1178,6 +1230,11 @@ static const char *const psz_recursive_list_text[] = {
 #define SP_LONGTEXT N_( \
     "Pause each item in the playlist on the first frame." )
 
+#define PREROLL_TEXT N_("Preroll the next item (ms)")
+#define PREROLL_LONGTEXT N_( \
+    "Open the next item of the playlist this long before the end of the " \
+    "current one, so that it starts without a gap. 0 disables the preroll." )
+
 #define AUTOSTART_TEXT N_( "Auto start" )
 #define AUTOSTART_LONGTEXT N_( "Automatically start playing the playlist " \
                 "content once it's loaded." )
@@ -1608,6 +1665,8 @@ vlc_module_begin ()
                  SNAP_WIDTH_LONGTEXT, true )
     add_integer( "snapshot-height", -1, SNAP_HEIGHT_TEXT,
                  SNAP_HEIGHT_LONGTEXT, true )
+    add_integer( "snapshot-interval", 0, SNAP_INTERVAL_TEXT,
+                 SNAP_INTERVAL_LONGTEXT, true )
 
     set_section( N_("Window properties" ), NULL )
     add_integer( "width", -1, WIDTH_TEXT, WIDTH_LONGTEXT, true )
@@ -1657,6 +1716,8 @@ vlc_module_begin ()
     set_subcategory( SUBCAT_VIDEO_VFILTER )
     add_module_list( "video-filter", "video filter", NULL,
                      VIDEO_FILTER_TEXT, VIDEO_FILTER_LONGTEXT, false )
+    add_integer( "video-filter-threads", 0, FILTER_THREADS_TEXT,
+                 FILTER_THREADS_LONGTEXT, true )
 
     set_subcategory( SUBCAT_VIDEO_SPLITTER )
     add_module_list( "video-splitter", "video splitter", NULL,
@@ -1899,6 +1960,13 @@ vlc_module_begin ()
     add_integer( "clock-jitter", 5 * CLOCK_FREQ/1000, CLOCK_JITTER_TEXT,
               CLOCK_JITTER_LONGTEXT, true )
         change_safe()
+    add_bool( "clock-adaptive", false, CLOCK_ADAPTIVE_TEXT,
+              CLOCK_ADAPTIVE_LONGTEXT, true )
+        change_safe()
+    add_integer( "clock-adaptive-min", 50, CLOCK_ADAPTIVE_MIN_TEXT,
+                 CLOCK_ADAPTIVE_MIN_LONGTEXT, true )
+        change_integer_range( 0, 60000 )
+        change_safe()
 
     add_bool( "network-synchronisation", false, NETSYNC_TEXT,
               NETSYNC_LONGTEXT, true )
@@ -2034,6 +2102,11 @@ vlc_module_begin ()
                  RT_OFFSET_LONGTEXT, true )
 #endif
 
+    add_bool( "block-pool", true, BLOCK_POOL_TEXT,
+              BLOCK_POOL_LONGTEXT, true )
+    add_bool( "kernel-autotune", false, KERNEL_AUTOTUNE_TEXT,
+              KERNEL_AUTOTUNE_LONGTEXT, true )
+
 #if defined(HAVE_DBUS)
     add_bool( "inhibit", 1, INHIBIT_TEXT,
               INHIBIT_LONGTEXT, true )
@@ -2069,6 +2142,9 @@ vlc_module_begin ()
     add_bool( "play-and-pause", 0, PAP_TEXT, PAP_LONGTEXT, true )
         change_safe()
     add_bool( "start-paused", 0, SP_TEXT, SP_LONGTEXT, false )
+    add_integer_with_range( "playlist-preroll", 0, 0, 60000,
+                            PREROLL_TEXT, PREROLL_LONGTEXT, true )
+        change_safe()
     add_bool( "playlist-autostart", true,
               AUTOSTART_TEXT, AUTOSTART_LONGTEXT, false )
     add_bool( "playlist-cork", true, CORK_TEXT, CORK_LONGTEXT, false )
@@ -2097,6 +2173,8 @@ vlc_module_begin ()
 
     add_integer( "preparse-timeout", 5000, PREPARSE_TIMEOUT_TEXT,
                  PREPARSE_TIMEOUT_LONGTEXT, false )
+    add_integer( "preparse-threads", 0, PREPARSE_THREADS_TEXT,
+                 PREPARSE_THREADS_LONGTEXT, true )
 
     add_obsolete_integer( "album-art" )
     add_bool( "metadata-network-access", false, METADATA_NETWORK_TEXT,
@@ -2127,6 +2205,9 @@ vlc_module_begin ()
         change_short('v')
         change_volatile ()
     add_obsolete_string( "verbose-objects" ) /* since 2.1.0 */
+    add_bool( "log-async", false, LOG_ASYNC_TEXT, LOG_ASYNC_LONGTEXT, true )
+    add_string( "log-rate-limit", NULL, LOG_RATE_TEXT, LOG_RATE_LONGTEXT,
+                true )
 #if !defined(_WIN32) && !defined(__OS2__)
     add_bool( "daemon", 0, DAEMON_TEXT, DAEMON_LONGTEXT, true )
         change_short('d')
@@ -2134,6 +2215,10 @@ vlc_module_begin ()
     add_string( "pidfile", NULL, PIDFILE_TEXT, PIDFILE_LONGTEXT,
                                        false )
 #endif
+#ifdef ENABLE_TRACE
+    add_savefile( "trace-file", NULL, TRACE_FILE_TEXT, TRACE_FILE_LONGTEXT,
+                  true )
+#endif
 
 #if defined (_WIN32) || defined (__APPLE__)
     add_obsolete_string( "language" ) /* since 2.1.0 */
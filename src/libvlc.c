@@ -62,6 +62,7 @@
 #include <vlc_cpu.h>
 #include <vlc_url.h>
 #include <vlc_modules.h>
+#include <vlc_trace.h>
 
 #include "libvlc.h"
 #include "playlist/playlist_internal.h"
@@ -228,6 +229,7 @@ int libvlc_InternalInit( libvlc_int_t *p_libvlc, int i_argc,
         msg_Warn( p_libvlc, "memory keystore init failed" );
 
     vlc_CPU_dump( VLC_OBJECT(p_libvlc) );
+    block_PoolSetup( p_libvlc );
 
     priv->b_stats = var_InheritBool( p_libvlc, "stats" );
 
@@ -416,12 +418,25 @@ void libvlc_InternalCleanup( libvlc_int_t *p_libvlc )
     if (priv->parser != NULL)
         playlist_preparser_Delete(priv->parser);
 
+#ifdef ENABLE_TRACE
+    char *tracefile = var_InheritString( p_libvlc, "trace-file" );
+    if( tracefile != NULL )
+    {
+        msg_Dbg( p_libvlc, "writing trace file %s", tracefile );
+        if( vlc_trace_Dump( tracefile ) )
+            msg_Warn( p_libvlc, "cannot write trace file %s", tracefile );
+        free( tracefile );
+    }
+#endif
+
     libvlc_InternalActionsClean( p_libvlc );
 
     /* Save the configuration */
     if( !var_InheritBool( p_libvlc, "ignore-config" ) )
         config_AutoSaveConfigFile( VLC_OBJECT(p_libvlc) );
 
+    block_PoolCleanup( p_libvlc );
+
     /* Free module bank. It is refcounted, so we call this each time  */
     vlc_LogDeinit (p_libvlc);
     module_EndBank (true);
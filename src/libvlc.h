@@ -43,6 +43,10 @@ size_t EnumClockSource( vlc_object_t *, const char *, char ***, char *** );
 void vlc_CPU_init(void);
 void vlc_CPU_dump(vlc_object_t *);
 
+/* Blocks allocator */
+void block_PoolSetup(libvlc_int_t *);
+void block_PoolCleanup(libvlc_int_t *);
+
 /*
  * Threads subsystem
  */
@@ -217,22 +221,11 @@ enum
 {
     STATS_COUNTER,
     STATS_DERIVATIVE,
+    STATS_LAST,
+    STATS_MAX,
 };
 
-typedef struct counter_sample_t
-{
-    uint64_t value;
-    mtime_t  date;
-} counter_sample_t;
-
-typedef struct counter_t
-{
-    int                 i_compute_type;
-    int                 i_samples;
-    counter_sample_t ** pp_samples;
-
-    mtime_t             last_update;
-} counter_t;
+typedef struct counter_t counter_t;
 
 enum
 {
@@ -258,7 +251,7 @@ enum
 };
 
 counter_t * stats_CounterCreate (int);
-void stats_Update (counter_t *, uint64_t, uint64_t *);
+void stats_Update (counter_t *, uint64_t);
 void stats_CounterClean (counter_t * );
 
 void stats_ComputeInputStats(input_thread_t*, input_stats_t*);
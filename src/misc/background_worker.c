@@ -34,88 +34,95 @@ struct bg_queued_item {
     int timeout; /**< timeout duration in microseconds */
 };
 
+struct bg_thread {
+    struct background_worker* worker;
+    struct bg_queued_item* item; /**< the current task, NULL if idle */
+    mtime_t deadline; /**< deadline of the current task */
+    bool probe_request; /**< true if a probe is requested */
+    bool quit; /**< true if the thread shall terminate */
+    vlc_cond_t worker_wait; /**< wait for probe request or cancelation */
+};
+
 struct background_worker {
     void* owner;
     struct background_worker_config conf;
 
     vlc_mutex_t lock; /**< acquire to inspect members that follow */
-    struct {
-        bool probe_request; /**< true if a probe is requested */
-        vlc_cond_t wait; /**< wait for update in terms of head */
-        vlc_cond_t worker_wait; /**< wait for probe request or cancelation */
-        mtime_t deadline; /**< deadline of the current task */
-        void* id; /**< id of the current task */
-        bool active; /**< true if there is an active thread */
-    } head;
+    vlc_cond_t wait; /**< wait for a thread to finish a task or terminate */
+    vlc_array_t threads; /**< running threads */
+    size_t idle; /**< number of threads waiting for a task */
 
     struct {
         vlc_cond_t wait; /**< wait for update in terms of tail */
         vlc_array_t data; /**< queue of pending entities to process */
+        size_t priority; /**< number of leading prioritized entities */
     } tail;
 };
 
+static void ThreadRemove( struct background_worker* worker,
+                          struct bg_thread* thread )
+{
+    for( size_t i = 0; i < vlc_array_count( &worker->threads ); ++i )
+        if( vlc_array_item_at_index( &worker->threads, i ) == thread )
+        {
+            vlc_array_remove( &worker->threads, i );
+            break;
+        }
+
+    vlc_cond_destroy( &thread->worker_wait );
+    free( thread );
+    vlc_cond_broadcast( &worker->wait );
+}
+
 static void* Thread( void* data )
 {
-    struct background_worker* worker = data;
+    struct bg_thread* thread = data;
+    struct background_worker* worker = thread->worker;
 
+    vlc_mutex_lock( &worker->lock );
     for( ;; )
     {
-        struct bg_queued_item* item = NULL;
-        void* handle;
-
-        vlc_mutex_lock( &worker->lock );
-        for( ;; )
+        while( !thread->quit && vlc_array_count( &worker->tail.data ) == 0 )
         {
-            if( vlc_array_count( &worker->tail.data ) )
-            {
-                item = vlc_array_item_at_index( &worker->tail.data, 0 );
-                handle = NULL;
+            /* Wait 1 seconds for new inputs before terminating */
+            mtime_t deadline = mdate() + INT64_C(1000000);
 
-                vlc_array_remove( &worker->tail.data, 0 );
-            }
-
-            if( worker->head.deadline == VLC_TS_0 && item == NULL )
-                worker->head.active = false;
-            worker->head.id = item ? item->id : NULL;
-            vlc_cond_broadcast( &worker->head.wait );
+            worker->idle++;
+            int ret = vlc_cond_timedwait( &worker->tail.wait,
+                                          &worker->lock, deadline );
+            worker->idle--;
 
-            if( item )
-            {
-                if( item->timeout > 0 )
-                    worker->head.deadline = mdate() + item->timeout * 1000;
-                else
-                    worker->head.deadline = INT64_MAX;
-            }
-            else if( worker->head.deadline != VLC_TS_0 )
-            {
-                /* Wait 1 seconds for new inputs before terminating */
-                mtime_t deadline = mdate() + INT64_C(1000000);
-                int ret = vlc_cond_timedwait( &worker->tail.wait,
-                                              &worker->lock, deadline );
-                if( ret != 0 )
-                {
-                    /* Timeout: if there is still no items, the thread will be
-                     * terminated at next loop iteration (active = false). */
-                    worker->head.deadline = VLC_TS_0;
-                }
-                continue;
-            }
-            break;
+            if( ret != 0 && vlc_array_count( &worker->tail.data ) == 0 )
+                thread->quit = true;
         }
 
-        if( !worker->head.active )
-        {
-            vlc_mutex_unlock( &worker->lock );
+        if( thread->quit )
             break;
-        }
-        vlc_mutex_unlock( &worker->lock );
 
-        assert( item != NULL );
+        struct bg_queued_item* item =
+            vlc_array_item_at_index( &worker->tail.data, 0 );
+        void* handle = NULL;
+
+        vlc_array_remove( &worker->tail.data, 0 );
+        if( worker->tail.priority > 0 )
+            worker->tail.priority--;
+
+        thread->item = item;
+        thread->probe_request = false;
+        if( item->timeout > 0 )
+            thread->deadline = mdate() + item->timeout * 1000;
+        else
+            thread->deadline = INT64_MAX;
+        vlc_mutex_unlock( &worker->lock );
 
         if( worker->conf.pf_start( worker->owner, item->entity, &handle ) )
         {
             worker->conf.pf_release( item->entity );
             free( item );
+
+            vlc_mutex_lock( &worker->lock );
+            thread->item = NULL;
+            vlc_cond_broadcast( &worker->wait );
             continue;
         }
 
@@ -123,8 +130,8 @@ static void* Thread( void* data )
         {
             vlc_mutex_lock( &worker->lock );
 
-            bool const b_timeout = worker->head.deadline <= mdate();
-            worker->head.probe_request = false;
+            bool const b_timeout = thread->deadline <= mdate();
+            thread->probe_request = false;
 
             vlc_mutex_unlock( &worker->lock );
 
@@ -138,19 +145,68 @@ static void* Thread( void* data )
             }
 
             vlc_mutex_lock( &worker->lock );
-            if( worker->head.probe_request == false &&
-                worker->head.deadline > mdate() )
+            if( thread->probe_request == false &&
+                thread->deadline > mdate() )
             {
-                vlc_cond_timedwait( &worker->head.worker_wait, &worker->lock,
-                                     worker->head.deadline );
+                vlc_cond_timedwait( &thread->worker_wait, &worker->lock,
+                                     thread->deadline );
             }
             vlc_mutex_unlock( &worker->lock );
         }
+
+        vlc_mutex_lock( &worker->lock );
+        thread->item = NULL;
+        vlc_cond_broadcast( &worker->wait );
     }
 
+    ThreadRemove( worker, thread );
+    vlc_mutex_unlock( &worker->lock );
     return NULL;
 }
 
+static bool ThreadSpawn( struct background_worker* worker )
+{
+    struct bg_thread* thread = malloc( sizeof( *thread ) );
+    if( unlikely( !thread ) )
+        return false;
+
+    thread->worker = worker;
+    thread->item = NULL;
+    thread->deadline = VLC_TS_INVALID;
+    thread->probe_request = false;
+    thread->quit = false;
+    vlc_cond_init( &thread->worker_wait );
+
+    if( vlc_array_append( &worker->threads, thread ) )
+        goto error;
+
+    if( vlc_clone_detach( NULL, Thread, thread, VLC_THREAD_PRIORITY_LOW ) )
+    {
+        vlc_array_remove( &worker->threads,
+                          vlc_array_count( &worker->threads ) - 1 );
+        goto error;
+    }
+    return true;
+
+error:
+    vlc_cond_destroy( &thread->worker_wait );
+    free( thread );
+    return false;
+}
+
+static bool ThreadsBusyWith( struct background_worker* worker, void* id )
+{
+    for( size_t i = 0; i < vlc_array_count( &worker->threads ); ++i )
+    {
+        struct bg_thread* thread =
+            vlc_array_item_at_index( &worker->threads, i );
+
+        if( thread->item != NULL && thread->item->id == id )
+            return true;
+    }
+    return false;
+}
+
 static void BackgroundWorkerCancel( struct background_worker* worker, void* id)
 {
     vlc_mutex_lock( &worker->lock );
@@ -162,6 +218,8 @@ static void BackgroundWorkerCancel( struct background_worker* worker, void* id)
         if( id == NULL || item->id == id )
         {
             vlc_array_remove( &worker->tail.data, i );
+            if( i < worker->tail.priority )
+                worker->tail.priority--;
             worker->conf.pf_release( item->entity );
             free( item );
             continue;
@@ -170,13 +228,24 @@ static void BackgroundWorkerCancel( struct background_worker* worker, void* id)
         ++i;
     }
 
-    while( ( id == NULL && worker->head.active )
-        || ( id != NULL && worker->head.id == id ) )
+    while( ( id == NULL && vlc_array_count( &worker->threads ) )
+        || ( id != NULL && ThreadsBusyWith( worker, id ) ) )
     {
-        worker->head.deadline = VLC_TS_0;
-        vlc_cond_signal( &worker->head.worker_wait );
-        vlc_cond_signal( &worker->tail.wait );
-        vlc_cond_wait( &worker->head.wait, &worker->lock );
+        for( size_t i = 0; i < vlc_array_count( &worker->threads ); ++i )
+        {
+            struct bg_thread* thread =
+                vlc_array_item_at_index( &worker->threads, i );
+
+            if( id == NULL )
+                thread->quit = true;
+            else if( thread->item == NULL || thread->item->id != id )
+                continue;
+
+            thread->deadline = VLC_TS_0;
+            vlc_cond_signal( &thread->worker_wait );
+        }
+        vlc_cond_broadcast( &worker->tail.wait );
+        vlc_cond_wait( &worker->wait, &worker->lock );
     }
     vlc_mutex_unlock( &worker->lock );
 }
@@ -190,58 +259,111 @@ struct background_worker* background_worker_New( void* owner,
         return NULL;
 
     worker->conf = *conf;
+    if( worker->conf.max_threads < 1 )
+        worker->conf.max_threads = 1;
     worker->owner = owner;
-    worker->head.id = NULL;
-    worker->head.active = false;
-    worker->head.deadline = VLC_TS_INVALID;
+    worker->idle = 0;
 
     vlc_mutex_init( &worker->lock );
-    vlc_cond_init( &worker->head.wait );
-    vlc_cond_init( &worker->head.worker_wait );
+    vlc_cond_init( &worker->wait );
+    vlc_array_init( &worker->threads );
 
     vlc_array_init( &worker->tail.data );
     vlc_cond_init( &worker->tail.wait );
+    worker->tail.priority = 0;
 
     return worker;
 }
 
-int background_worker_Push( struct background_worker* worker, void* entity,
-                        void* id, int timeout )
+static int BackgroundWorkerPush( struct background_worker* worker,
+    void* entity, void* id, int timeout, bool priority )
 {
+    int ret = VLC_SUCCESS;
+
+    vlc_mutex_lock( &worker->lock );
+
+    /* An entity already pending is not queued twice, but it may be moved
+     * ahead if it is now prioritized */
+    for( size_t i = 0; i < vlc_array_count( &worker->tail.data ); ++i )
+    {
+        struct bg_queued_item* item =
+            vlc_array_item_at_index( &worker->tail.data, i );
+
+        if( item->entity != entity )
+            continue;
+
+        if( priority && i >= worker->tail.priority )
+        {
+            vlc_array_remove( &worker->tail.data, i );
+            vlc_array_insert( &worker->tail.data, item,
+                              worker->tail.priority++ );
+        }
+        goto out;
+    }
+
     struct bg_queued_item* item = malloc( sizeof( *item ) );
 
     if( unlikely( !item ) )
-        return VLC_EGENERIC;
+    {
+        ret = VLC_EGENERIC;
+        goto out;
+    }
 
     item->id = id;
     item->entity = entity;
     item->timeout = timeout < 0 ? worker->conf.default_timeout : timeout;
 
-    vlc_mutex_lock( &worker->lock );
-    int i_ret = vlc_array_append( &worker->tail.data, item );
-    vlc_cond_signal( &worker->tail.wait );
+    size_t count = vlc_array_count( &worker->tail.data );
+    int i_ret = priority
+        ? vlc_array_insert( &worker->tail.data, item, worker->tail.priority )
+        : vlc_array_append( &worker->tail.data, item );
     if( i_ret != 0 )
     {
         free( item );
-        return VLC_EGENERIC;
+        ret = VLC_EGENERIC;
+        goto out;
     }
+    if( priority )
+        worker->tail.priority++;
+
+    /* Start another thread if the idle ones cannot serve the whole queue */
+    size_t threads = vlc_array_count( &worker->threads );
+    bool spawned = false;
+    if( count + 1 > worker->idle
+     && threads < (size_t)worker->conf.max_threads )
+        spawned = ThreadSpawn( worker );
 
-    if( worker->head.active == false )
+    if( !spawned && threads == 0 )
     {
-        worker->head.probe_request = false;
-        worker->head.active =
-            !vlc_clone_detach( NULL, Thread, worker, VLC_THREAD_PRIORITY_LOW );
+        /* No thread to ever process it */
+        vlc_array_remove( &worker->tail.data,
+                          priority ? --worker->tail.priority
+                                   : vlc_array_count( &worker->tail.data ) - 1 );
+        free( item );
+        ret = VLC_EGENERIC;
+        goto out;
     }
 
-    if( worker->head.active )
-        worker->conf.pf_hold( item->entity );
+    worker->conf.pf_hold( item->entity );
+    vlc_cond_signal( &worker->tail.wait );
 
-    int ret = worker->head.active ? VLC_SUCCESS : VLC_EGENERIC;
+out:
     vlc_mutex_unlock( &worker->lock );
-
     return ret;
 }
 
+int background_worker_Push( struct background_worker* worker, void* entity,
+                        void* id, int timeout )
+{
+    return BackgroundWorkerPush( worker, entity, id, timeout, false );
+}
+
+int background_worker_PushPriority( struct background_worker* worker,
+                                    void* entity, void* id, int timeout )
+{
+    return BackgroundWorkerPush( worker, entity, id, timeout, true );
+}
+
 void background_worker_Cancel( struct background_worker* worker, void* id )
 {
     BackgroundWorkerCancel( worker, id );
@@ -250,8 +372,14 @@ void background_worker_Cancel( struct background_worker* worker, void* id )
 void background_worker_RequestProbe( struct background_worker* worker )
 {
     vlc_mutex_lock( &worker->lock );
-    worker->head.probe_request = true;
-    vlc_cond_signal( &worker->head.worker_wait );
+    for( size_t i = 0; i < vlc_array_count( &worker->threads ); ++i )
+    {
+        struct bg_thread* thread =
+            vlc_array_item_at_index( &worker->threads, i );
+
+        thread->probe_request = true;
+        vlc_cond_signal( &thread->worker_wait );
+    }
     vlc_mutex_unlock( &worker->lock );
 }
 
@@ -259,9 +387,9 @@ void background_worker_Delete( struct background_worker* worker )
 {
     BackgroundWorkerCancel( worker, NULL );
     vlc_array_clear( &worker->tail.data );
+    vlc_array_clear( &worker->threads );
     vlc_mutex_destroy( &worker->lock );
-    vlc_cond_destroy( &worker->head.wait );
-    vlc_cond_destroy( &worker->head.worker_wait );
+    vlc_cond_destroy( &worker->wait );
     vlc_cond_destroy( &worker->tail.wait );
     free( worker );
 }
@@ -29,6 +29,15 @@ struct background_worker_config {
      **/
     mtime_t default_timeout;
 
+    /**
+     * Maximum number of threads
+     *
+     * Up to this number of tasks are run concurrently, threads being created
+     * on demand when the queue of pending tasks grows, and terminated after
+     * they have been idle for a while. A value less than 1 is handled as 1.
+     **/
+    int max_threads;
+
     /**
      * Release an entity
      *
@@ -137,7 +146,8 @@ void background_worker_RequestProbe( struct background_worker* worker );
  *
  * This function is used to push an entity into the queue of pending work. The
  * entities will be processed in the order in which they are received (in terms
- * of the order of invocations in a single-threaded environment).
+ * of the order of invocations in a single-threaded environment). An entity
+ * which is still pending is not queued a second time.
  *
  * \param worker the background-worker
  * \param entity the entity which is to be queued
@@ -151,6 +161,16 @@ void background_worker_RequestProbe( struct background_worker* worker );
 int background_worker_Push( struct background_worker* worker, void* entity,
     void* id, int timeout );
 
+/**
+ * Push an entity ahead of the queue of the background-worker
+ *
+ * This function is the same as \ref background_worker_Push, except that the
+ * entity is queued after the other prioritized entities but before all the
+ * others. If the entity is already pending, it is moved ahead.
+ **/
+int background_worker_PushPriority( struct background_worker* worker,
+    void* entity, void* id, int timeout );
+
 /**
  * Remove entities from the background-worker
  *
@@ -34,6 +34,8 @@
 #include <vlc_common.h>
 #include <vlc_block.h>
 #include <vlc_fs.h>
+#include <vlc_atomic.h>
+#include "libvlc.h"
 
 #ifndef NDEBUG
 static void BlockNoRelease( block_t *b )
@@ -117,6 +119,136 @@ static void BlockMetaCopy( block_t *restrict out, const block_t *in )
 /** Initial reserved header and footer size. */
 #define BLOCK_PADDING      32
 
+/** Smallest allocation size class of the pool */
+#define BLOCK_POOL_MIN     512
+/** Number of size classes (powers of two), up to 64 KiB */
+#define BLOCK_POOL_CLASSES 8
+/** Bytes kept for reuse per size class */
+#define BLOCK_POOL_BYTES   (1 << 20)
+
+/**
+ * Released allocations are kept per size class, for the next allocations
+ * of the same class, rather than going back to the heap. Blocks are mostly
+ * allocated by one thread and released by another, so the lists are shared.
+ */
+static struct block_pool_class
+{
+    vlc_mutex_t lock;
+    block_t    *first;
+    unsigned    count;
+    /* statistics */
+    uint64_t    hits;
+    uint64_t    misses;
+    uint64_t    recycled;
+    uint64_t    freed;
+} block_pool[BLOCK_POOL_CLASSES] = {
+#define BLOCK_POOL_CLASS_INIT { VLC_STATIC_MUTEX, NULL, 0, 0, 0, 0, 0 }
+    BLOCK_POOL_CLASS_INIT, BLOCK_POOL_CLASS_INIT,
+    BLOCK_POOL_CLASS_INIT, BLOCK_POOL_CLASS_INIT,
+    BLOCK_POOL_CLASS_INIT, BLOCK_POOL_CLASS_INIT,
+    BLOCK_POOL_CLASS_INIT, BLOCK_POOL_CLASS_INIT,
+#undef BLOCK_POOL_CLASS_INIT
+};
+
+static atomic_bool block_pool_enabled = ATOMIC_VAR_INIT(true);
+
+static size_t block_pool_ClassSize (unsigned i)
+{
+    return (size_t)BLOCK_POOL_MIN << i;
+}
+
+static void block_pool_Release (block_t *block)
+{
+    /* That is always true for blocks allocated with block_Alloc(). */
+    assert (block->p_start == (unsigned char *)(block + 1));
+    block_Invalidate (block);
+
+    const size_t alloc = sizeof (*block) + block->i_size;
+    const unsigned i = ctz (alloc / BLOCK_POOL_MIN);
+    struct block_pool_class *pool = &block_pool[i];
+
+    assert (alloc == block_pool_ClassSize (i));
+    vlc_mutex_lock (&pool->lock);
+    if (pool->count < BLOCK_POOL_BYTES / alloc)
+    {
+        block->p_next = pool->first;
+        pool->first = block;
+        pool->count++;
+        pool->recycled++;
+        block = NULL;
+    }
+    else
+        pool->freed++;
+    vlc_mutex_unlock (&pool->lock);
+
+    free (block);
+}
+
+/** Allocates the given size from the pool, rounded up to its class */
+static block_t *block_pool_Alloc (size_t *restrict alloc)
+{
+    unsigned i = 0;
+
+    while (block_pool_ClassSize (i) < *alloc)
+        if (++i >= BLOCK_POOL_CLASSES)
+            return NULL;
+
+    struct block_pool_class *pool = &block_pool[i];
+    block_t *b;
+
+    vlc_mutex_lock (&pool->lock);
+    b = pool->first;
+    if (b != NULL)
+    {
+        pool->first = b->p_next;
+        pool->count--;
+        pool->hits++;
+    }
+    else
+        pool->misses++;
+    vlc_mutex_unlock (&pool->lock);
+
+    *alloc = block_pool_ClassSize (i);
+    if (b == NULL)
+    {
+        b = malloc (*alloc);
+    }
+    return b;
+}
+
+void block_PoolSetup (libvlc_int_t *libvlc)
+{
+    atomic_store (&block_pool_enabled, var_InheritBool (libvlc, "block-pool"));
+}
+
+void block_PoolCleanup (libvlc_int_t *libvlc)
+{
+    for (unsigned i = 0; i < BLOCK_POOL_CLASSES; i++)
+    {
+        struct block_pool_class *pool = &block_pool[i];
+        block_t *list;
+
+        vlc_mutex_lock (&pool->lock);
+        if (pool->hits + pool->misses > 0)
+            msg_Dbg (libvlc, "block pool %zu bytes: %"PRIu64" reused, "
+                     "%"PRIu64" allocated, %"PRIu64" recycled, "
+                     "%"PRIu64" freed", block_pool_ClassSize (i),
+                     pool->hits, pool->misses, pool->recycled,
+                     pool->freed);
+        list = pool->first;
+        pool->first = NULL;
+        pool->count = 0;
+        vlc_mutex_unlock (&pool->lock);
+
+        while (list != NULL)
+        {
+            block_t *next = list->p_next;
+            free (list);
+            list = next;
+        }
+    }
+}
+
 block_t *block_Alloc (size_t size)
 {
     if (unlikely(size >> 27))
@@ -126,25 +258,122 @@ block_t *block_Alloc (size_t size)
     }
 
     /* 2 * BLOCK_PADDING: pre + post padding */
-    const size_t alloc = sizeof (block_t) + BLOCK_ALIGN + (2 * BLOCK_PADDING)
-                       + size;
+    size_t alloc = sizeof (block_t) + BLOCK_ALIGN + (2 * BLOCK_PADDING)
+                 + size;
     if (unlikely(alloc <= size))
         return NULL;
 
-    block_t *b = malloc (alloc);
+    block_t *b = NULL;
+    block_free_t release = block_generic_Release;
+
+    if (atomic_load_explicit (&block_pool_enabled, memory_order_relaxed))
+    {
+        b = block_pool_Alloc (&alloc);
+        release = block_pool_Release;
+    }
+    if (b == NULL)
+    {
+        b = malloc (alloc);
+        release = block_generic_Release;
+    }
     if (unlikely(b == NULL))
         return NULL;
 
+    /* The headroom does not depend on the class rounding: any extra room
+     * is left at the tail */
     block_Init (b, b + 1, alloc - sizeof (*b));
     static_assert ((BLOCK_PADDING % BLOCK_ALIGN) == 0,
                    "BLOCK_PADDING must be a multiple of BLOCK_ALIGN");
     b->p_buffer += BLOCK_PADDING + BLOCK_ALIGN - 1;
     b->p_buffer = (void *)(((uintptr_t)b->p_buffer) & ~(BLOCK_ALIGN - 1));
     b->i_buffer = size;
-    b->pf_release = block_generic_Release;
+    b->pf_release = release;
     return b;
 }
 
+/**
+ * Blocks sharing a payload. The payload is held by the block returned by
+ * block_Shareable(), the owner, until the last sharing block is released.
+ */
+typedef struct block_shared_t
+{
+    block_t     self;
+    struct block_shared_t *owner;
+    /* Owner only */
+    atomic_uint refs;
+    block_t    *payload;
+} block_shared_t;
+
+static void block_shared_Release (block_t *block)
+{
+    block_shared_t *shared = (block_shared_t *)block;
+    block_shared_t *owner = shared->owner;
+
+    block_Invalidate (block);
+    if (shared != owner)
+        free (shared);
+
+    if (atomic_fetch_sub_explicit (&owner->refs, 1,
+                                   memory_order_acq_rel) == 1)
+    {
+        block_Release (owner->payload);
+        free (owner);
+    }
+}
+
+static bool block_IsShared (const block_t *block)
+{
+    return block->pf_release == block_shared_Release;
+}
+
+static block_shared_t *block_shared_New (block_shared_t *owner,
+                                         const block_t *from)
+{
+    block_shared_t *shared = malloc (sizeof (*shared));
+    if (unlikely(shared == NULL))
+        return NULL;
+
+    /* No headroom nor tailroom: growing the payload copies it */
+    block_Init (&shared->self, from->p_buffer, from->i_buffer);
+    block_CopyProperties (&shared->self, (block_t *)from);
+    shared->self.pf_release = block_shared_Release;
+    shared->owner = (owner != NULL) ? owner : shared;
+    return shared;
+}
+
+block_t *block_Shareable (block_t *block)
+{
+    block_Check (block);
+    if (block_IsShared (block))
+        return block;
+
+    block_shared_t *owner = block_shared_New (NULL, block);
+    if (unlikely(owner == NULL))
+    {
+        block_Release (block);
+        return NULL;
+    }
+
+    owner->self.p_next = block->p_next;
+    block->p_next = NULL;
+    atomic_init (&owner->refs, 1);
+    owner->payload = block;
+    return &owner->self;
+}
+
+block_t *block_Share (block_t *block)
+{
+    assert (block_IsShared (block));
+
+    block_shared_t *owner = ((block_shared_t *)block)->owner;
+    block_shared_t *shared = block_shared_New (owner, block);
+    if (unlikely(shared == NULL))
+        return NULL;
+
+    atomic_fetch_add_explicit (&owner->refs, 1, memory_order_relaxed);
+    return &shared->self;
+}
+
 block_t *block_TryRealloc (block_t *p_block, ssize_t i_prebody, size_t i_body)
 {
     block_Check( p_block );
@@ -181,7 +410,7 @@ block_t *block_TryRealloc (block_t *p_block, ssize_t i_prebody, size_t i_body)
 
     if( p_block->i_buffer == 0 )
     {   /* Corner case: nothing to preserve */
-        if( requested <= p_block->i_size )
+        if( requested <= p_block->i_size && !block_IsShared( p_block ) )
         {   /* Enough room: recycle buffer */
             size_t extra = p_block->i_size - requested;
 
@@ -206,7 +435,9 @@ block_t *block_TryRealloc (block_t *p_block, ssize_t i_prebody, size_t i_body)
     /* Second, reallocate the buffer if we lack space. */
     assert( i_prebody >= 0 );
     if( (size_t)(p_block->p_buffer - p_start) < (size_t)i_prebody
-     || (size_t)(p_end - p_block->p_buffer) < i_body )
+     || (size_t)(p_end - p_block->p_buffer) < i_body
+     || (block_IsShared( p_block ) /* the new data must be writable */
+      && (i_prebody > 0 || i_body > p_block->i_buffer)) )
     {
         block_t *p_rea = block_Alloc( requested );
         if( p_rea == NULL )
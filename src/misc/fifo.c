@@ -26,10 +26,12 @@
 #endif
 
 #include <assert.h>
+#include <limits.h>
 #include <stdlib.h>
 
 #include <vlc_common.h>
 #include <vlc_block.h>
+#include <vlc_atomic.h>
 #include "libvlc.h"
 
 /**
@@ -233,3 +235,165 @@ size_t block_FifoCount (block_fifo_t *fifo)
     vlc_mutex_unlock (&fifo->lock);
     return depth;
 }
+
+/**
+ * Single producer single consumer ring of blocks.
+ *
+ * The head and tail are free running counters. A side about to sleep raises
+ * its waiting flag, and then checks the queue again: the other side, which
+ * updates the counter before looking at the flag, either sees the flag, or
+ * its update is seen. The flag is also the address slept on.
+ */
+struct vlc_spsc
+{
+    atomic_uint head; /**< Next slot to dequeue, written by the consumer */
+    atomic_uint tail; /**< Next slot to queue, written by the producer */
+    atomic_uint consumer_waiting;
+    atomic_uint producer_waiting;
+    atomic_bool closed;
+    unsigned    mask;
+    block_t    *slots[];
+};
+
+vlc_spsc_t *vlc_spsc_New(size_t capacity)
+{
+    size_t size = 1;
+
+    while (size < capacity)
+    {
+        size <<= 1;
+        if (size > UINT_MAX / 2)
+            return NULL;
+    }
+
+    vlc_spsc_t *q = malloc(sizeof (*q) + size * sizeof (q->slots[0]));
+    if (unlikely(q == NULL))
+        return NULL;
+
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+    atomic_init(&q->consumer_waiting, 0);
+    atomic_init(&q->producer_waiting, 0);
+    atomic_init(&q->closed, false);
+    q->mask = size - 1;
+    return q;
+}
+
+void vlc_spsc_Delete(vlc_spsc_t *q)
+{
+    block_t *block;
+
+    while ((block = vlc_spsc_TryPop(q)) != NULL)
+        block_Release(block);
+    free(q);
+}
+
+static void vlc_spsc_Wake(atomic_uint *waiting)
+{
+    if (atomic_load(waiting) && atomic_exchange(waiting, 0))
+        vlc_addr_signal(waiting);
+}
+
+static bool vlc_spsc_IsFull(const vlc_spsc_t *q, unsigned tail)
+{
+    return tail - atomic_load(&q->head) > q->mask;
+}
+
+static bool vlc_spsc_IsEmpty(const vlc_spsc_t *q, unsigned head)
+{
+    return atomic_load(&q->tail) == head;
+}
+
+static void vlc_spsc_Put(vlc_spsc_t *q, unsigned tail, block_t *block)
+{
+    q->slots[tail & q->mask] = block;
+    atomic_store(&q->tail, tail + 1);
+    vlc_spsc_Wake(&q->consumer_waiting);
+}
+
+static block_t *vlc_spsc_Take(vlc_spsc_t *q, unsigned head)
+{
+    block_t *block = q->slots[head & q->mask];
+
+    atomic_store(&q->head, head + 1);
+    vlc_spsc_Wake(&q->producer_waiting);
+    return block;
+}
+
+bool vlc_spsc_Push(vlc_spsc_t *q, block_t *block)
+{
+    unsigned tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+
+    while (vlc_spsc_IsFull(q, tail))
+    {
+        if (atomic_load(&q->closed))
+            break;
+
+        atomic_store(&q->producer_waiting, 1);
+        if (vlc_spsc_IsFull(q, tail) && !atomic_load(&q->closed))
+            vlc_addr_wait(&q->producer_waiting, 1);
+        atomic_store(&q->producer_waiting, 0);
+    }
+
+    if (atomic_load(&q->closed))
+    {
+        block_Release(block);
+        return false;
+    }
+
+    vlc_spsc_Put(q, tail, block);
+    return true;
+}
+
+bool vlc_spsc_TryPush(vlc_spsc_t *q, block_t *block)
+{
+    unsigned tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+
+    if (vlc_spsc_IsFull(q, tail) || atomic_load(&q->closed))
+        return false;
+
+    vlc_spsc_Put(q, tail, block);
+    return true;
+}
+
+block_t *vlc_spsc_Pop(vlc_spsc_t *q)
+{
+    unsigned head = atomic_load_explicit(&q->head, memory_order_relaxed);
+
+    while (vlc_spsc_IsEmpty(q, head))
+    {
+        if (atomic_load(&q->closed))
+            return NULL;
+
+        atomic_store(&q->consumer_waiting, 1);
+        if (vlc_spsc_IsEmpty(q, head) && !atomic_load(&q->closed))
+            vlc_addr_wait(&q->consumer_waiting, 1);
+        atomic_store(&q->consumer_waiting, 0);
+    }
+
+    return vlc_spsc_Take(q, head);
+}
+
+block_t *vlc_spsc_TryPop(vlc_spsc_t *q)
+{
+    unsigned head = atomic_load_explicit(&q->head, memory_order_relaxed);
+
+    if (vlc_spsc_IsEmpty(q, head))
+        return NULL;
+
+    return vlc_spsc_Take(q, head);
+}
+
+void vlc_spsc_Close(vlc_spsc_t *q)
+{
+    atomic_store(&q->closed, true);
+    vlc_spsc_Wake(&q->consumer_waiting);
+    vlc_spsc_Wake(&q->producer_waiting);
+}
+
+size_t vlc_spsc_GetCount(const vlc_spsc_t *q)
+{
+    unsigned head = atomic_load(&q->head); /* first, the tail only grows */
+
+    return atomic_load(&q->tail) - head;
+}
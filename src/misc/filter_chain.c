@@ -29,6 +29,7 @@
 #include <vlc_modules.h>
 #include <vlc_mouse.h>
 #include <vlc_spu.h>
+#include <vlc_trace.h>
 #include <libvlc.h>
 #include <assert.h>
 
@@ -412,6 +413,7 @@ static picture_t *FilterChainVideoFilter( chained_filter_t *f, picture_t *p_pic
 
 picture_t *filter_chain_VideoFilter( filter_chain_t *p_chain, picture_t *p_pic )
 {
+    vlc_trace_Scope( "video filter" );
     if( p_pic )
     {
         p_pic = FilterChainVideoFilter( p_chain->first, p_pic );
@@ -0,0 +1,226 @@
+/*****************************************************************************
+ * filter_slices.c : worker threads shared by the video filters
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+#include <vlc_filter.h>
+
+/* Number of bands per thread, so that uneven bands balance out */
+#define SLICES_BANDS_PER_THREAD 2
+
+struct filter_slices_job
+{
+    void (*run)( void *, unsigned, unsigned );
+    void *opaque;
+    unsigned count; /**< number of rows */
+    unsigned band; /**< number of rows per band */
+    unsigned next; /**< first row not yet handed out */
+    unsigned pending; /**< number of bands not yet completed */
+    struct filter_slices_job *p_next;
+};
+
+struct filter_slices_t
+{
+    vlc_mutex_t lock;
+    vlc_cond_t wait; /**< wait for a job or termination */
+    vlc_cond_t done; /**< wait for the completion of a band */
+    struct filter_slices_job *jobs; /**< jobs with rows to hand out */
+    unsigned refs;
+    bool quit;
+    unsigned threads;
+    vlc_thread_t handles[];
+};
+
+static vlc_mutex_t slices_lock = VLC_STATIC_MUTEX;
+static filter_slices_t *slices = NULL;
+
+/* Hands out the next band of a job, must be called with the lock held */
+static void TakeBand( filter_slices_t *p_slices, struct filter_slices_job *job,
+                      unsigned *first, unsigned *last )
+{
+    *first = job->next;
+    *last = __MIN( job->count, job->next + job->band );
+    job->next = *last;
+
+    if( job->next < job->count )
+        return;
+
+    /* Nothing left to hand out, unqueue the job */
+    struct filter_slices_job **pp = &p_slices->jobs;
+    while( *pp != job )
+        pp = &(*pp)->p_next;
+    *pp = job->p_next;
+}
+
+static void RunBand( filter_slices_t *p_slices, struct filter_slices_job *job )
+{
+    unsigned first, last;
+
+    TakeBand( p_slices, job, &first, &last );
+    vlc_mutex_unlock( &p_slices->lock );
+
+    job->run( job->opaque, first, last );
+
+    vlc_mutex_lock( &p_slices->lock );
+    assert( job->pending > 0 );
+    if( --job->pending == 0 )
+        vlc_cond_broadcast( &p_slices->done );
+}
+
+static void *Thread( void *data )
+{
+    filter_slices_t *p_slices = data;
+
+    vlc_mutex_lock( &p_slices->lock );
+    for( ;; )
+    {
+        while( !p_slices->quit && p_slices->jobs == NULL )
+            vlc_cond_wait( &p_slices->wait, &p_slices->lock );
+
+        if( p_slices->quit )
+            break;
+
+        RunBand( p_slices, p_slices->jobs );
+    }
+    vlc_mutex_unlock( &p_slices->lock );
+    return NULL;
+}
+
+#undef filter_SlicesHold
+filter_slices_t *filter_SlicesHold( vlc_object_t *obj )
+{
+    vlc_mutex_lock( &slices_lock );
+    if( slices != NULL )
+    {
+        slices->refs++;
+        goto out;
+    }
+
+    int threads = var_InheritInteger( obj, "video-filter-threads" );
+    if( threads <= 0 )
+        threads = vlc_GetCPUCount();
+    /* The calling thread processes bands too */
+    threads--;
+    if( threads <= 0 )
+        goto out;
+
+    slices = malloc( sizeof( *slices ) + threads * sizeof( vlc_thread_t ) );
+    if( unlikely(slices == NULL) )
+        goto out;
+
+    vlc_mutex_init( &slices->lock );
+    vlc_cond_init( &slices->wait );
+    vlc_cond_init( &slices->done );
+    slices->jobs = NULL;
+    slices->refs = 1;
+    slices->quit = false;
+    slices->threads = 0;
+
+    while( slices->threads < (unsigned)threads
+        && !vlc_clone( &slices->handles[slices->threads], Thread, slices,
+                       VLC_THREAD_PRIORITY_VIDEO ) )
+        slices->threads++;
+
+    if( slices->threads == 0 )
+    {
+        vlc_cond_destroy( &slices->done );
+        vlc_cond_destroy( &slices->wait );
+        vlc_mutex_destroy( &slices->lock );
+        free( slices );
+        slices = NULL;
+    }
+    else
+        msg_Dbg( obj, "using %u video filter slice thread(s)",
+                 slices->threads );
+out:
+    vlc_mutex_unlock( &slices_lock );
+    return slices;
+}
+
+void filter_SlicesRelease( filter_slices_t *p_slices )
+{
+    vlc_mutex_lock( &slices_lock );
+    assert( p_slices == slices );
+    if( --p_slices->refs > 0 )
+    {
+        vlc_mutex_unlock( &slices_lock );
+        return;
+    }
+    slices = NULL;
+    vlc_mutex_unlock( &slices_lock );
+
+    vlc_mutex_lock( &p_slices->lock );
+    assert( p_slices->jobs == NULL );
+    p_slices->quit = true;
+    vlc_cond_broadcast( &p_slices->wait );
+    vlc_mutex_unlock( &p_slices->lock );
+
+    for( unsigned i = 0; i < p_slices->threads; i++ )
+        vlc_join( p_slices->handles[i], NULL );
+
+    vlc_cond_destroy( &p_slices->done );
+    vlc_cond_destroy( &p_slices->wait );
+    vlc_mutex_destroy( &p_slices->lock );
+    free( p_slices );
+}
+
+void filter_SlicesRun( filter_slices_t *p_slices, unsigned count,
+                       void (*run)( void *, unsigned, unsigned ),
+                       void *opaque )
+{
+    if( p_slices == NULL || count < 2 )
+    {
+        run( opaque, 0, count );
+        return;
+    }
+
+    unsigned bands = __MIN( count, ( p_slices->threads + 1 )
+                                   * SLICES_BANDS_PER_THREAD );
+    struct filter_slices_job job = {
+        .run = run,
+        .opaque = opaque,
+        .count = count,
+        .band = ( count + bands - 1 ) / bands,
+        .next = 0,
+        .p_next = NULL,
+    };
+    job.pending = ( count + job.band - 1 ) / job.band;
+
+    vlc_mutex_lock( &p_slices->lock );
+    struct filter_slices_job **pp = &p_slices->jobs;
+    while( *pp != NULL )
+        pp = &(*pp)->p_next;
+    *pp = &job;
+    vlc_cond_broadcast( &p_slices->wait );
+
+    while( job.next < job.count )
+        RunBand( p_slices, &job );
+
+    while( job.pending > 0 )
+        vlc_cond_wait( &p_slices->done, &p_slices->lock );
+    vlc_mutex_unlock( &p_slices->lock );
+}
@@ -31,6 +31,8 @@
 #include <assert.h>
 
 #include <vlc_common.h>
+#include <vlc_arrays.h>
+#include <vlc_memstream.h>
 #include <vlc_messages.h>
 #include <vlc_strings.h>
 #include <vlc_http.h>
@@ -41,10 +43,28 @@ typedef struct http_cookie_t
     char *psz_value;
     char *psz_domain;
     char *psz_path;
+    size_t i_domain_len;
+    size_t i_path_len;
     bool b_host_only;
     bool b_secure;
 } http_cookie_t;
 
+/* The host of a request, measured once for all the cookies */
+typedef struct
+{
+    const char *psz_name;
+    size_t i_len;
+    bool b_ip;
+} http_cookie_host_t;
+
+static void cookie_host_init( http_cookie_host_t *host, const char *name )
+{
+    host->psz_name = name;
+    host->i_len = strlen( name );
+    host->b_ip = strspn( name, "0123456789." ) == host->i_len /* IPv4 */
+              || strchr( name, ':' ) != NULL; /* IPv6 */
+}
+
 static char *cookie_get_attribute_value( const char *cookie, const char *attr )
 {
     size_t attrlen = strlen( attr );
@@ -103,33 +123,40 @@ static char *cookie_get_domain( const char *cookie )
 }
 
 static bool cookie_domain_matches( const http_cookie_t *cookie,
-                                   const char *host )
+                                   const http_cookie_host_t *host )
 {
     // TODO: should convert domain names to punycode before comparing
 
-    if (host == NULL)
+    if ( host->i_len == cookie->i_domain_len )
+        return vlc_ascii_strcasecmp(cookie->psz_domain, host->psz_name) == 0;
+    else if ( cookie->b_host_only || host->b_ip
+           || host->i_len < cookie->i_domain_len )
         return false;
-    if ( vlc_ascii_strcasecmp(cookie->psz_domain, host) == 0 )
-        return true;
-    else if ( cookie->b_host_only )
-        return false;
-
-    size_t host_len = strlen(host);
-    size_t cookie_domain_len = strlen(cookie->psz_domain);
-    bool is_suffix = false, has_dot_before_suffix = false;
 
-    if( host_len > cookie_domain_len )
-    {
-        size_t i = host_len - cookie_domain_len;
+    size_t i = host->i_len - cookie->i_domain_len;
 
-        is_suffix = vlc_ascii_strcasecmp( &host[i], cookie->psz_domain ) == 0;
-        has_dot_before_suffix = host[i-1] == '.';
-    }
+    return host->psz_name[i-1] == '.' &&
+        vlc_ascii_strcasecmp( &host->psz_name[i], cookie->psz_domain ) == 0;
+}
 
-    bool host_is_ipv4 = strspn(host, "0123456789.") == host_len;
-    bool host_is_ipv6 = strchr(host, ':') != NULL;
-    return is_suffix && has_dot_before_suffix &&
-        !( host_is_ipv4 || host_is_ipv6 );
+/* Cookies are indexed by the last two labels of their domain. A cookie only
+ * matches the hosts ending with its domain, which has at least two labels,
+ * so they all share the same key. Without the public suffix list, this is
+ * the closest thing to the registrable domain. */
+static void cookie_domain_key( const char *domain, char *key, size_t size )
+{
+    const char *end = domain + strlen( domain ), *start = end;
+    unsigned dots = 0;
+
+    while( start > domain && ( start[-1] != '.' || ++dots < 2 ) )
+        start--;
+    if( (size_t)(end - start) >= size )
+        start = end - (size - 1);
+
+    size_t i;
+    for( i = 0; start[i] != '\0'; i++ )
+        key[i] = vlc_ascii_tolower( (unsigned char)start[i] );
+    key[i] = '\0';
 }
 
 static char *cookie_get_path(const char *cookie)
@@ -137,27 +164,26 @@ static char *cookie_get_path(const char *cookie)
     return cookie_get_attribute_value(cookie, "path");
 }
 
-static bool cookie_path_matches( const http_cookie_t * cookie, const char *uripath )
+static bool cookie_path_matches( const http_cookie_t * cookie,
+                                 const char *uripath, size_t path_len )
 {
-    if (uripath == NULL )
+    /* The path is a prefix of the request path, ending on a segment */
+    const size_t prefix_len = cookie->i_path_len;
+
+    if ( path_len < prefix_len
+      || strncmp(uripath, cookie->psz_path, prefix_len) != 0 )
         return false;
-    else if ( strcmp(cookie->psz_path, uripath) == 0 )
-        return true;
-
-    size_t path_len = strlen( uripath );
-    size_t prefix_len = strlen( cookie->psz_path );
-    return ( path_len > prefix_len ) &&
-        ( strncmp(uripath, cookie->psz_path, prefix_len) == 0 ) &&
-        ( uripath[prefix_len - 1] == '/' || uripath[prefix_len] == '/' );
+    return path_len == prefix_len || prefix_len == 0 ||
+        uripath[prefix_len - 1] == '/' || uripath[prefix_len] == '/';
 }
 
 static bool cookie_should_be_sent(const http_cookie_t *cookie, bool secure,
-                                  const char *host, const char *path)
+                                  const http_cookie_host_t *host,
+                                  const char *path, size_t path_len)
 {
-    bool protocol_ok = secure || !cookie->b_secure;
-    bool domain_ok = cookie_domain_matches(cookie, host);
-    bool path_ok = cookie_path_matches(cookie, path);
-    return protocol_ok && domain_ok && path_ok;
+    return ( secure || !cookie->b_secure )
+        && cookie_path_matches(cookie, path, path_len)
+        && cookie_domain_matches(cookie, host);
 }
 
 static char *cookie_default_path( const char *request_path )
@@ -256,6 +282,9 @@ static http_cookie_t *cookie_parse(const char *value,
     /* Get secure flag */
     cookie->b_secure = cookie_has_attribute(value, "secure");
 
+    cookie->i_domain_len = strlen(cookie->psz_domain);
+    cookie->i_path_len = strlen(cookie->psz_path);
+
     return cookie;
 
 error:
@@ -263,9 +292,17 @@ error:
     return NULL;
 }
 
-struct vlc_http_cookie_jar_t
+/* Cookies sharing a domain key, in storage order */
+typedef struct
 {
     vlc_array_t cookies;
+} http_cookie_bucket_t;
+
+#define COOKIE_KEY_SIZE 256
+
+struct vlc_http_cookie_jar_t
+{
+    vlc_dictionary_t buckets;
     vlc_mutex_t lock;
 };
 
@@ -275,21 +312,29 @@ vlc_http_cookie_jar_t * vlc_http_cookies_new(void)
     if ( unlikely(jar == NULL) )
         return NULL;
 
-    vlc_array_init( &jar->cookies );
+    vlc_dictionary_init( &jar->buckets, 64 );
     vlc_mutex_init( &jar->lock );
 
     return jar;
 }
 
+static void cookie_bucket_destroy( void *data, void *obj )
+{
+    http_cookie_bucket_t *bucket = data;
+
+    for( size_t i = 0; i < vlc_array_count( &bucket->cookies ); i++ )
+        cookie_destroy( vlc_array_item_at_index( &bucket->cookies, i ) );
+    vlc_array_clear( &bucket->cookies );
+    free( bucket );
+    (void) obj;
+}
+
 void vlc_http_cookies_destroy( vlc_http_cookie_jar_t * p_jar )
 {
     if ( !p_jar )
         return;
 
-    for( size_t i = 0; i < vlc_array_count( &p_jar->cookies ); i++ )
-        cookie_destroy( vlc_array_item_at_index( &p_jar->cookies, i ) );
-
-    vlc_array_clear( &p_jar->cookies );
+    vlc_dictionary_clear( &p_jar->buckets, cookie_bucket_destroy, NULL );
     vlc_mutex_destroy( &p_jar->lock );
 
     free( p_jar );
@@ -305,6 +350,9 @@ bool vlc_http_cookies_store(vlc_http_cookie_jar_t *p_jar, const char *cookies,
     if (cookie == NULL)
         return false;
 
+    http_cookie_host_t req_host;
+    cookie_host_init(&req_host, host);
+
     /* Check if a cookie from host should be added to the cookie jar */
     // FIXME: should check if domain is one of "public suffixes" at
     // http://publicsuffix.org/. The purpose of this check is to
@@ -312,36 +360,55 @@ bool vlc_http_cookies_store(vlc_http_cookie_jar_t *p_jar, const char *cookies,
     // "example.com" should not be able to set a cookie for "com".
     // The current implementation prevents all top-level domains.
     if (strchr(cookie->psz_domain, '.') == NULL
-     || !cookie_domain_matches(cookie, host))
+     || !cookie_domain_matches(cookie, &req_host))
     {
         cookie_destroy(cookie);
         return false;
     }
 
+    char key[COOKIE_KEY_SIZE];
+    cookie_domain_key(cookie->psz_domain, key, sizeof (key));
+
     vlc_mutex_lock( &p_jar->lock );
 
-    for( size_t i = 0; i < vlc_array_count( &p_jar->cookies ); i++ )
+    http_cookie_bucket_t *bucket =
+        vlc_dictionary_value_for_key( &p_jar->buckets, key );
+    if( bucket == NULL )
     {
-        http_cookie_t *iter = vlc_array_item_at_index( &p_jar->cookies, i );
+        bucket = malloc( sizeof (*bucket) );
+        if( unlikely(bucket == NULL) )
+        {
+            vlc_mutex_unlock( &p_jar->lock );
+            cookie_destroy( cookie );
+            return false;
+        }
+        vlc_array_init( &bucket->cookies );
+        vlc_dictionary_insert( &p_jar->buckets, key, bucket );
+    }
+
+    for( size_t i = 0; i < vlc_array_count( &bucket->cookies ); i++ )
+    {
+        http_cookie_t *iter = vlc_array_item_at_index( &bucket->cookies, i );
 
         assert( iter->psz_name );
         assert( iter->psz_domain );
         assert( iter->psz_path );
 
-        bool domains_match =
+        bool domains_match = cookie->i_domain_len == iter->i_domain_len &&
             vlc_ascii_strcasecmp( cookie->psz_domain, iter->psz_domain ) == 0;
-        bool paths_match = strcmp( cookie->psz_path, iter->psz_path ) == 0;
+        bool paths_match = cookie->i_path_len == iter->i_path_len &&
+            strcmp( cookie->psz_path, iter->psz_path ) == 0;
         bool names_match = strcmp( cookie->psz_name, iter->psz_name ) == 0;
         if( domains_match && paths_match && names_match )
         {
             /* Remove previous value for this cookie */
-            vlc_array_remove( &p_jar->cookies, i );
+            vlc_array_remove( &bucket->cookies, i );
             cookie_destroy(iter);
             break;
         }
     }
 
-    bool b_ret = (vlc_array_append( &p_jar->cookies, cookie ) == 0);
+    bool b_ret = (vlc_array_append( &bucket->cookies, cookie ) == 0);
     if( !b_ret )
         cookie_destroy( cookie );
 
@@ -353,33 +420,49 @@ bool vlc_http_cookies_store(vlc_http_cookie_jar_t *p_jar, const char *cookies,
 char *vlc_http_cookies_fetch(vlc_http_cookie_jar_t *p_jar, bool secure,
                              const char *host, const char *path)
 {
-    char *psz_cookiebuf = NULL;
+    if( host == NULL || path == NULL )
+        return NULL;
+
+    http_cookie_host_t req_host;
+    cookie_host_init( &req_host, host );
+
+    const size_t path_len = strlen( path );
+    char key[COOKIE_KEY_SIZE];
+    cookie_domain_key( host, key, sizeof (key) );
+
+    struct vlc_memstream stream;
+    bool b_found = false;
 
+    vlc_memstream_open( &stream );
     vlc_mutex_lock( &p_jar->lock );
 
-    for( size_t i = 0; i < vlc_array_count( &p_jar->cookies ); i++ )
+    http_cookie_bucket_t *bucket =
+        vlc_dictionary_value_for_key( &p_jar->buckets, key );
+    for( size_t i = 0;
+         bucket != NULL && i < vlc_array_count( &bucket->cookies ); i++ )
     {
-        const http_cookie_t * cookie = vlc_array_item_at_index( &p_jar->cookies, i );
-        if (cookie_should_be_sent(cookie, secure, host, path))
+        const http_cookie_t * cookie =
+            vlc_array_item_at_index( &bucket->cookies, i );
+        if (cookie_should_be_sent(cookie, secure, &req_host, path, path_len))
         {
-            char *psz_updated_buf = NULL;
-            if ( asprintf(&psz_updated_buf, "%s%s%s=%s",
-                          psz_cookiebuf ? psz_cookiebuf : "",
-                          psz_cookiebuf ? "; " : "",
-                          cookie->psz_name ? cookie->psz_name : "",
-                          cookie->psz_value ? cookie->psz_value : "") == -1 )
-            {
-                // TODO: report error
-                free( psz_cookiebuf );
-                vlc_mutex_unlock( &p_jar->lock );
-                return NULL;
-            }
-            free( psz_cookiebuf );
-            psz_cookiebuf = psz_updated_buf;
+            if( b_found )
+                vlc_memstream_puts( &stream, "; " );
+            vlc_memstream_puts( &stream, cookie->psz_name );
+            vlc_memstream_putc( &stream, '=' );
+            if( cookie->psz_value != NULL )
+                vlc_memstream_puts( &stream, cookie->psz_value );
+            b_found = true;
         }
     }
 
     vlc_mutex_unlock( &p_jar->lock );
 
-    return psz_cookiebuf;
+    if( vlc_memstream_close( &stream ) )
+        return NULL;
+    if( !b_found )
+    {
+        free( stream.ptr );
+        return NULL;
+    }
+    return stream.ptr;
 }
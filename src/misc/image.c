@@ -48,6 +48,8 @@
 #include <vlc_sout.h>
 #include <libvlc.h>
 #include <vlc_modules.h>
+#include <vlc_atomic.h>
+#include <vlc_cpu.h>
 
 static picture_t *ImageRead( image_handler_t *, block_t *,
                              const video_format_t *, video_format_t * );
@@ -107,6 +109,9 @@ void image_HandlerDelete( image_handler_t *p_image )
     if( !p_image ) return;
 
     if( p_image->p_dec ) DeleteDecoder( p_image->p_dec );
+    for( int i = 0; i < IMAGE_DECODER_CACHE; i++ )
+        if( p_image->pp_dec_cache[i] )
+            DeleteDecoder( p_image->pp_dec_cache[i] );
     if( p_image->p_enc ) DeleteEncoder( p_image->p_enc );
     if( p_image->p_filter ) DeleteFilter( p_image->p_filter );
 
@@ -134,12 +139,35 @@ static picture_t *ImageRead( image_handler_t *p_image, block_t *p_block,
 {
     picture_t *p_pic = NULL;
 
-    /* Check if we can reuse the current decoder */
-    if( p_image->p_dec &&
+    /* Check if we can reuse the current decoder, or one kept for another
+     * format. The least recently used one is at the end of the cache. */
+    if( !p_image->p_dec ||
         p_image->p_dec->fmt_in.i_codec != p_fmt_in->i_chroma )
     {
-        DeleteDecoder( p_image->p_dec );
-        p_image->p_dec = 0;
+        decoder_t **cache = p_image->pp_dec_cache;
+        decoder_t *p_dec = p_image->p_dec;
+
+        p_image->p_dec = NULL;
+        for( int i = 0; i < IMAGE_DECODER_CACHE; i++ )
+        {
+            if( cache[i] && cache[i]->fmt_in.i_codec == p_fmt_in->i_chroma )
+            {
+                p_image->p_dec = cache[i];
+                memmove( &cache[1], &cache[0], i * sizeof (*cache) );
+                cache[0] = p_dec;
+                p_dec = NULL;
+                break;
+            }
+        }
+
+        if( p_dec )
+        {
+            if( cache[IMAGE_DECODER_CACHE - 1] )
+                DeleteDecoder( cache[IMAGE_DECODER_CACHE - 1] );
+            memmove( &cache[1], &cache[0],
+                     (IMAGE_DECODER_CACHE - 1) * sizeof (*cache) );
+            cache[0] = p_dec;
+        }
     }
 
     /* Start a decoder */
@@ -162,6 +190,10 @@ static picture_t *ImageRead( image_handler_t *p_image, block_t *p_block,
         p_image->p_dec->p_queue_ctx = p_image;
     }
 
+    /* Let the decoder reduce the image while decoding, if it can */
+    var_SetInteger( p_image->p_dec, "image-width", p_fmt_out->i_width );
+    var_SetInteger( p_image->p_dec, "image-height", p_fmt_out->i_height );
+
     p_block->i_pts = p_block->i_dts = mdate();
     int ret = p_image->p_dec->pf_decode( p_image->p_dec, p_block );
     if( ret == VLCDEC_SUCCESS )
@@ -317,6 +349,89 @@ error:
     return NULL;
 }
 
+/**
+ * Read a batch of images
+ *
+ */
+
+struct image_batch
+{
+    vlc_object_t *obj;
+    const char *const *urls;
+    size_t count;
+    const video_format_t *fmt_out;
+    picture_t **pics;
+    atomic_size_t next;
+    atomic_size_t read;
+};
+
+static void *ImageBatchThread( void *data )
+{
+    struct image_batch *batch = data;
+    image_handler_t *p_image = image_HandlerCreate( batch->obj );
+    size_t i;
+
+    while( (i = atomic_fetch_add( &batch->next, 1 )) < batch->count )
+    {
+        video_format_t fmt_in, fmt_out;
+
+        batch->pics[i] = NULL;
+        if( p_image == NULL )
+            continue;
+
+        video_format_Init( &fmt_in, 0 );
+        video_format_Init( &fmt_out, 0 );
+        video_format_Copy( &fmt_out, batch->fmt_out );
+
+        batch->pics[i] = ImageReadUrl( p_image, batch->urls[i], &fmt_in,
+                                       &fmt_out );
+        if( batch->pics[i] != NULL )
+            atomic_fetch_add( &batch->read, 1 );
+        video_format_Clean( &fmt_out );
+        video_format_Clean( &fmt_in );
+    }
+
+    image_HandlerDelete( p_image );
+    return NULL;
+}
+
+#undef image_ReadUrlBatch
+size_t image_ReadUrlBatch( vlc_object_t *obj, const char *const *urls,
+                           size_t count, const video_format_t *fmt_out,
+                           picture_t **pics )
+{
+    struct image_batch batch = {
+        .obj = obj, .urls = urls, .count = count, .fmt_out = fmt_out,
+        .pics = pics,
+    };
+    unsigned workers = vlc_GetCPUCount();
+
+    atomic_init( &batch.next, 0 );
+    atomic_init( &batch.read, 0 );
+
+    if( workers > count )
+        workers = count;
+    if( workers > 1 )
+        workers--; /* the calling thread is a worker too */
+    else
+        workers = 0;
+
+    vlc_thread_t threads[workers ? workers : 1];
+    unsigned started = 0;
+
+    while( started < workers
+        && vlc_clone( &threads[started], ImageBatchThread, &batch,
+                      VLC_THREAD_PRIORITY_LOW ) == 0 )
+        started++;
+
+    ImageBatchThread( &batch );
+
+    for( unsigned i = 0; i < started; i++ )
+        vlc_join( threads[i], NULL );
+
+    return atomic_load( &batch.read );
+}
+
 /**
  * Write an image
  *
@@ -653,6 +768,10 @@ static decoder_t *CreateDecoder( vlc_object_t *p_this, const video_format_t *fmt
     p_dec->pf_vout_format_update = video_update_format;
     p_dec->pf_vout_buffer_new = video_new_buffer;
 
+    /* Requested output dimensions, 0 if unknown */
+    var_Create( p_dec, "image-width", VLC_VAR_INTEGER );
+    var_Create( p_dec, "image-height", VLC_VAR_INTEGER );
+
     /* Find a suitable decoder module */
     p_dec->p_module = module_need( p_dec, "video decoder", "$codec", false );
     if( !p_dec->p_module )
@@ -0,0 +1,237 @@
+/*****************************************************************************
+ * kernel.c: selection of the implementations of processing kernels
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/** @ingroup kernel */
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_configuration.h>
+#include <vlc_cpu.h>
+#include <vlc_fs.h>
+#include <vlc_kernel.h>
+
+/* Runs of each implementation, the fastest one counts */
+#define KERNEL_BENCH_RUNS 5
+#define KERNEL_CACHE_NAME "kernels"
+
+/* Implementations selected by measurement, for the current CPU */
+struct kernel_choice
+{
+    char *kernel;
+    char *impl;
+};
+
+static vlc_mutex_t kernel_lock = VLC_STATIC_MUTEX;
+static struct kernel_choice *kernel_choices = NULL;
+static size_t kernel_count = 0;
+static bool kernel_loaded = false;
+
+static const char *FindChoice(const char *kernel)
+{
+    for (size_t i = 0; i < kernel_count; i++)
+        if (!strcmp(kernel_choices[i].kernel, kernel))
+            return kernel_choices[i].impl;
+    return NULL;
+}
+
+static void AddChoice(const char *kernel, const char *impl)
+{
+    struct kernel_choice *tab = realloc(kernel_choices,
+                                        (kernel_count + 1) * sizeof (*tab));
+    if (unlikely(tab == NULL))
+        return;
+    kernel_choices = tab;
+
+    char *k = strdup(kernel), *i = strdup(impl);
+    if (unlikely(k == NULL || i == NULL))
+    {
+        free(k);
+        free(i);
+        return;
+    }
+    tab[kernel_count].kernel = k;
+    tab[kernel_count].impl = i;
+    kernel_count++;
+}
+
+static char *CachePath(void)
+{
+    char *dir = config_GetUserDir(VLC_CACHE_DIR), *path;
+
+    if (dir == NULL)
+        return NULL;
+    if (asprintf(&path, "%s"DIR_SEP KERNEL_CACHE_NAME, dir) == -1)
+        path = NULL;
+    free(dir);
+    return path;
+}
+
+/* The cache is only valid for the CPU that it was measured on */
+static void LoadCache(vlc_object_t *obj)
+{
+    char *path = CachePath();
+    if (path == NULL)
+        return;
+
+    FILE *stream = vlc_fopen(path, "rt");
+    free(path);
+    if (stream == NULL)
+        return;
+
+    char line[256], kernel[128], impl[64];
+    unsigned cpu;
+
+    if (fgets(line, sizeof (line), stream) != NULL
+     && sscanf(line, "cpu %x", &cpu) == 1 && cpu == vlc_CPU())
+    {
+        while (fgets(line, sizeof (line), stream) != NULL)
+            if (sscanf(line, "%127s %63s", kernel, impl) == 2
+             && FindChoice(kernel) == NULL)
+                AddChoice(kernel, impl);
+    }
+    else
+        msg_Dbg(obj, "ignoring the kernels measured on another CPU");
+    fclose(stream);
+}
+
+static void SaveCache(vlc_object_t *obj)
+{
+    char *dir = config_GetUserDir(VLC_CACHE_DIR);
+    if (dir != NULL)
+    {
+        vlc_mkdir(dir, 0700);
+        free(dir);
+    }
+
+    char *path = CachePath(), *tmp;
+    if (path == NULL)
+        return;
+    if (asprintf(&tmp, "%s.tmp", path) == -1)
+    {
+        free(path);
+        return;
+    }
+
+    /* Replace the cache atomically, as concurrent processes may read it */
+    bool saved = false;
+    FILE *stream = vlc_fopen(tmp, "wt");
+    if (stream != NULL)
+    {
+        fprintf(stream, "cpu %x\n", vlc_CPU());
+        for (size_t i = 0; i < kernel_count; i++)
+            fprintf(stream, "%s %s\n", kernel_choices[i].kernel,
+                    kernel_choices[i].impl);
+        saved = fclose(stream) == 0 && vlc_rename(tmp, path) == 0;
+        if (!saved)
+            vlc_unlink(tmp);
+    }
+    if (!saved)
+        msg_Warn(obj, "cannot save the kernel cache %s", path);
+    free(tmp);
+    free(path);
+}
+
+#undef vlc_kernel_Select
+vlc_kernel_func_t vlc_kernel_Select(vlc_object_t *obj, const char *kernel,
+                                    const vlc_kernel_impl_t *impls,
+                                    size_t count, vlc_kernel_bench_cb bench,
+                                    void *opaque)
+{
+    const unsigned cpu = vlc_CPU();
+    const vlc_kernel_impl_t *best = NULL;
+    size_t supported = 0;
+
+    assert(count > 0 && impls[0].cpu == 0);
+
+    /* By default, the last supported one is the most specialized one */
+    for (size_t i = 0; i < count; i++)
+        if ((impls[i].cpu & cpu) == impls[i].cpu)
+        {
+            best = &impls[i];
+            supported++;
+        }
+
+    if (supported < 2 || bench == NULL
+     || !var_InheritBool(obj, "kernel-autotune"))
+        return best->func;
+
+    vlc_mutex_lock(&kernel_lock);
+    if (!kernel_loaded)
+    {
+        LoadCache(obj);
+        kernel_loaded = true;
+    }
+
+    const char *name = FindChoice(kernel);
+    if (name != NULL)
+    {
+        for (size_t i = 0; i < count; i++)
+            if (!strcmp(impls[i].name, name)
+             && (impls[i].cpu & cpu) == impls[i].cpu)
+            {
+                vlc_mutex_unlock(&kernel_lock);
+                return impls[i].func;
+            }
+    }
+    vlc_mutex_unlock(&kernel_lock);
+
+    /* Measure outside of the lock, other kernels may be selected meanwhile.
+     * If the same kernel is measured twice, the first result is kept. */
+    mtime_t best_time = INT64_MAX;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if ((impls[i].cpu & cpu) != impls[i].cpu)
+            continue;
+
+        mtime_t time = INT64_MAX;
+        for (unsigned run = 0; run < KERNEL_BENCH_RUNS; run++)
+        {
+            mtime_t t = bench(impls[i].func, opaque);
+            if (t < time)
+                time = t;
+        }
+        msg_Dbg(obj, "kernel %s: %s implementation in %"PRId64" us", kernel,
+                impls[i].name, time);
+
+        if (time < best_time)
+        {
+            best_time = time;
+            best = &impls[i];
+        }
+    }
+    msg_Dbg(obj, "kernel %s: using the %s implementation", kernel,
+            best->name);
+
+    vlc_mutex_lock(&kernel_lock);
+    if (FindChoice(kernel) == NULL)
+    {
+        AddChoice(kernel, best->name);
+        SaveCache(obj);
+    }
+    vlc_mutex_unlock(&kernel_lock);
+    return best->func;
+}
@@ -41,8 +41,20 @@
 #include <vlc_interface.h>
 #include <vlc_charset.h>
 #include <vlc_modules.h>
+#include <vlc_atomic.h>
 #include "../libvlc.h"
 
+typedef struct vlc_log_async vlc_log_async_t;
+
+/** Per module rate limit */
+typedef struct
+{
+    char *module;
+    unsigned rate; /**< messages per second (0 = unlimited) */
+} vlc_log_limit_t;
+
+#define VLC_LOG_LIMIT_BUCKETS 256
+
 struct vlc_logger_t
 {
     VLC_COMMON_MEMBERS
@@ -50,6 +62,18 @@ struct vlc_logger_t
     vlc_log_cb log;
     void *sys;
     module_t *module;
+    vlc_log_async_t *async;
+
+    /* Rate limiting */
+    unsigned default_rate;
+    size_t limits_count;
+    vlc_log_limit_t *limits;
+    struct
+    {
+        atomic_uint second;
+        atomic_uint count;
+        atomic_uint dropped;
+    } buckets[VLC_LOG_LIMIT_BUCKETS];
 };
 
 static void vlc_vaLogCallback(libvlc_int_t *vlc, int type,
@@ -77,6 +101,341 @@ static void vlc_LogCallback(libvlc_int_t *vlc, int type, const vlc_log_t *item,
     va_end(ap);
 }
 
+/*** Asynchronous logging ***/
+
+/* Messages are formatted by the calling thread into a record of a bounded
+ * multiple producers queue, without locking (the queue from D. Vyukov).
+ * A background thread passes the records to the logger callback, so that the
+ * calling thread never waits for the log output. Messages are dropped, and
+ * counted, if the queue is full. */
+
+#define VLC_LOG_QUEUE_SIZE 256 /* must be a power of two */
+#define VLC_LOG_TEXT_SIZE 512
+
+typedef struct
+{
+    atomic_size_t seq;
+    int type;
+    vlc_log_t meta;
+    char module[32];
+    char header[64];
+    char *long_text; /**< if the message does not fit in text[] */
+    char text[VLC_LOG_TEXT_SIZE];
+} vlc_log_record_t;
+
+struct vlc_log_async
+{
+    vlc_logger_t *logger;
+    vlc_thread_t thread;
+    vlc_sem_t ready; /**< one count per pushed record, plus one to stop */
+    atomic_bool stop;
+    atomic_uint lost;
+    atomic_size_t enqueue;
+    size_t dequeue; /**< owned by the thread */
+    vlc_log_record_t records[VLC_LOG_QUEUE_SIZE];
+};
+
+static void vlc_LogAsyncPush(vlc_log_async_t *q, int type,
+                             const vlc_log_t *item, const char *format,
+                             va_list ap)
+{
+    size_t pos = atomic_load_explicit(&q->enqueue, memory_order_relaxed);
+    vlc_log_record_t *rec;
+
+    for (;;)
+    {
+        rec = &q->records[pos % VLC_LOG_QUEUE_SIZE];
+
+        size_t seq = atomic_load_explicit(&rec->seq, memory_order_acquire);
+        ptrdiff_t diff = (ptrdiff_t)(seq - pos);
+
+        if (diff == 0)
+        {
+            if (atomic_compare_exchange_weak_explicit(&q->enqueue, &pos,
+                                                      pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+        {   /* Full */
+            atomic_fetch_add_explicit(&q->lost, 1, memory_order_relaxed);
+            return;
+        }
+        else
+            pos = atomic_load_explicit(&q->enqueue, memory_order_relaxed);
+    }
+
+    rec->type = type;
+    rec->meta = *item;
+    strlcpy(rec->module, item->psz_module, sizeof (rec->module));
+    strlcpy(rec->header, (item->psz_header != NULL) ? item->psz_header : "",
+            sizeof (rec->header));
+
+    va_list aq;
+    va_copy(aq, ap);
+    int len = vsnprintf(rec->text, sizeof (rec->text), format, ap);
+    if (len < 0)
+        rec->text[0] = '\0';
+    rec->long_text = NULL;
+    if (len >= (int)sizeof (rec->text)
+     && vasprintf(&rec->long_text, format, aq) == -1)
+        rec->long_text = NULL; /* keep the truncated message */
+    va_end(aq);
+
+    atomic_store_explicit(&rec->seq, pos + 1, memory_order_release);
+    vlc_sem_post(&q->ready);
+}
+
+static void vlc_LogAsyncPushf(vlc_log_async_t *q, int type,
+                              const vlc_log_t *item, const char *format, ...)
+{
+    va_list ap;
+
+    va_start(ap, format);
+    vlc_LogAsyncPush(q, type, item, format, ap);
+    va_end(ap);
+}
+
+static void *vlc_LogAsyncThread(void *data)
+{
+    vlc_log_async_t *q = data;
+    libvlc_int_t *vlc = q->logger->obj.libvlc;
+
+    for (;;)
+    {
+        vlc_sem_wait(&q->ready);
+
+        if (atomic_load(&q->enqueue) == q->dequeue)
+        {
+            if (atomic_load(&q->stop))
+                break;
+            continue;
+        }
+
+        vlc_log_record_t *rec = &q->records[q->dequeue % VLC_LOG_QUEUE_SIZE];
+
+        /* The record is being written: its producer is about to finish */
+        while (atomic_load_explicit(&rec->seq, memory_order_acquire)
+                                                          != q->dequeue + 1);
+
+        rec->meta.psz_module = rec->module;
+        rec->meta.psz_header = rec->header[0] ? rec->header : NULL;
+        vlc_LogCallback(vlc, rec->type, &rec->meta, "%s",
+                        (rec->long_text != NULL) ? rec->long_text : rec->text);
+        free(rec->long_text);
+
+        atomic_store_explicit(&rec->seq, q->dequeue + VLC_LOG_QUEUE_SIZE,
+                              memory_order_release);
+        q->dequeue++;
+
+        unsigned lost = atomic_exchange(&q->lost, 0);
+        if (unlikely(lost > 0))
+        {
+            vlc_log_t meta = {
+                .i_object_id = (uintptr_t)q->logger,
+                .psz_object_type = "logger",
+                .psz_module = "core",
+                .tid = vlc_thread_id(),
+            };
+
+            vlc_LogCallback(vlc, VLC_MSG_WARN, &meta,
+                            "%u log message(s) lost", lost);
+        }
+    }
+    return NULL;
+}
+
+static vlc_log_async_t *vlc_LogAsyncStart(vlc_logger_t *logger)
+{
+    vlc_log_async_t *q = malloc(sizeof (*q));
+    if (unlikely(q == NULL))
+        return NULL;
+
+    q->logger = logger;
+    vlc_sem_init(&q->ready, 0);
+    atomic_init(&q->stop, false);
+    atomic_init(&q->lost, 0);
+    atomic_init(&q->enqueue, 0);
+    q->dequeue = 0;
+    for (size_t i = 0; i < VLC_LOG_QUEUE_SIZE; i++)
+        atomic_init(&q->records[i].seq, i);
+
+    if (vlc_clone(&q->thread, vlc_LogAsyncThread, q,
+                  VLC_THREAD_PRIORITY_LOW))
+    {
+        vlc_sem_destroy(&q->ready);
+        free(q);
+        return NULL;
+    }
+    return q;
+}
+
+/**
+ * Dispatches the pending messages and stops the thread.
+ * No more messages can be pushed.
+ */
+static void vlc_LogAsyncStop(vlc_log_async_t *q)
+{
+    atomic_store(&q->stop, true);
+    vlc_sem_post(&q->ready);
+    vlc_join(q->thread, NULL);
+    vlc_sem_destroy(&q->ready);
+    free(q);
+}
+
+/**
+ * Applies the rate limit of the module.
+ *
+ * Modules with a same hash share a budget, which is harmless as few modules
+ * log heavily at a time.
+ *
+ * \param dropped number of messages dropped during the last second,
+ *                if this is the first message of a new second, or 0
+ * \return whether the message can be logged
+ */
+static bool vlc_LogAllowed(vlc_logger_t *logger, const char *module,
+                           unsigned *dropped)
+{
+    unsigned rate = logger->default_rate;
+
+    *dropped = 0;
+    for (size_t i = 0; i < logger->limits_count; i++)
+        if (!strcmp(logger->limits[i].module, module))
+        {
+            rate = logger->limits[i].rate;
+            break;
+        }
+
+    if (rate == 0)
+        return true;
+
+    uint32_t hash = 2166136261u; /* FNV-1a */
+    for (const unsigned char *p = (const void *)module; *p; p++)
+        hash = (hash ^ *p) * 16777619u;
+
+    typeof (logger->buckets[0]) *b =
+        &logger->buckets[hash % VLC_LOG_LIMIT_BUCKETS];
+    unsigned now = mdate() / CLOCK_FREQ;
+    unsigned second = atomic_load(&b->second);
+
+    if (second != now && atomic_compare_exchange_strong(&b->second, &second,
+                                                        now))
+    {
+        *dropped = atomic_exchange(&b->dropped, 0);
+        atomic_store(&b->count, 0);
+    }
+
+    if (atomic_fetch_add(&b->count, 1) < rate)
+        return true;
+
+    atomic_fetch_add(&b->dropped, 1);
+    return false;
+}
+
+/**
+ * Parses the rate limits, e.g. "100,avcodec=1000,ts=10": a bare number sets
+ * the limit of all other modules.
+ */
+static void vlc_LogLimitsInit(vlc_logger_t *logger, const char *str)
+{
+    logger->default_rate = 0;
+    logger->limits_count = 0;
+    logger->limits = NULL;
+
+    if (str == NULL)
+        return;
+
+    char *buf = strdup(str), *saveptr;
+    if (unlikely(buf == NULL))
+        return;
+
+    for (char *tok = strtok_r(buf, ",", &saveptr); tok != NULL;
+         tok = strtok_r(NULL, ",", &saveptr))
+    {
+        char *eq = strchr(tok, '=');
+
+        if (eq == NULL)
+        {
+            logger->default_rate = strtoul(tok, NULL, 10);
+            continue;
+        }
+
+        *eq = '\0';
+
+        vlc_log_limit_t *tab = realloc(logger->limits,
+                                (logger->limits_count + 1) * sizeof (*tab));
+        if (unlikely(tab == NULL))
+            break;
+
+        logger->limits = tab;
+        tab[logger->limits_count].module = strdup(tok);
+        tab[logger->limits_count].rate = strtoul(eq + 1, NULL, 10);
+        if (likely(tab[logger->limits_count].module != NULL))
+            logger->limits_count++;
+    }
+    free(buf);
+}
+
+static void vlc_LogLimitsClean(vlc_logger_t *logger)
+{
+    for (size_t i = 0; i < logger->limits_count; i++)
+        free(logger->limits[i].module);
+    free(logger->limits);
+    logger->limits_count = 0;
+    logger->limits = NULL;
+    logger->default_rate = 0;
+}
+
+/* The logger lock must be held */
+static void vlc_LogLocked(vlc_logger_t *logger, int type,
+                          const vlc_log_t *item, const char *format, ...)
+{
+    va_list ap;
+
+    va_start(ap, format);
+    logger->log(logger->sys, type, item, format, ap);
+    va_end(ap);
+}
+
+/**
+ * Passes a message to the logger, or to the queue in asynchronous mode.
+ */
+static void vlc_vaLogSubmit(libvlc_int_t *vlc, int type,
+                            const vlc_log_t *item, const char *format,
+                            va_list ap)
+{
+    vlc_logger_t *logger = libvlc_priv(vlc)->logger;
+    unsigned dropped;
+    int canc;
+
+    assert(logger != NULL);
+    canc = vlc_savecancel();
+    vlc_rwlock_rdlock(&logger->lock);
+
+    if (!vlc_LogAllowed(logger, item->psz_module, &dropped))
+        goto out;
+
+    if (logger->async != NULL)
+    {
+        if (unlikely(dropped > 0))
+            vlc_LogAsyncPushf(logger->async, VLC_MSG_WARN, item,
+                              "%u message(s) dropped by the rate limit",
+                              dropped);
+        vlc_LogAsyncPush(logger->async, type, item, format, ap);
+    }
+    else
+    {
+        if (unlikely(dropped > 0))
+            vlc_LogLocked(logger, VLC_MSG_WARN, item,
+                          "%u message(s) dropped by the rate limit", dropped);
+        logger->log(logger->sys, type, item, format, ap);
+    }
+out:
+    vlc_rwlock_unlock(&logger->lock);
+    vlc_restorecancel(canc);
+}
+
 #ifdef _WIN32
 static void Win32DebugOutputMsg (void *, int , const vlc_log_t *,
                                  const char *, va_list);
@@ -137,7 +496,7 @@ void vlc_vaLog (vlc_object_t *obj, int type, const char *module,
 
     /* Pass message to the callback */
     if (obj != NULL)
-        vlc_vaLogCallback(obj->obj.libvlc, type, &msg, format, args);
+        vlc_vaLogSubmit(obj->obj.libvlc, type, &msg, format, args);
 }
 
 /**
@@ -330,6 +689,14 @@ int vlc_LogPreinit(libvlc_int_t *vlc)
         return -1;
 
     vlc_rwlock_init(&logger->lock);
+    logger->async = NULL;
+    vlc_LogLimitsInit(logger, NULL);
+    for (size_t i = 0; i < VLC_LOG_LIMIT_BUCKETS; i++)
+    {
+        atomic_init(&logger->buckets[i].second, 0);
+        atomic_init(&logger->buckets[i].count, 0);
+        atomic_init(&logger->buckets[i].dropped, 0);
+    }
 
     if (vlc_LogEarlyOpen(logger))
     {
@@ -345,6 +712,35 @@ int vlc_LogPreinit(libvlc_int_t *vlc)
     return 0;
 }
 
+/**
+ * Stops the asynchronous mode, after the pending messages are dispatched.
+ */
+static void vlc_LogStopAsync(vlc_logger_t *logger)
+{
+    vlc_rwlock_wrlock(&logger->lock);
+    vlc_log_async_t *q = logger->async;
+    logger->async = NULL;
+    vlc_rwlock_unlock(&logger->lock);
+
+    if (q != NULL)
+        vlc_LogAsyncStop(q);
+}
+
+static void vlc_LogStartAsync(vlc_logger_t *logger)
+{
+    if (!var_InheritBool(logger, "log-async"))
+        return;
+
+    vlc_log_async_t *q = vlc_LogAsyncStart(logger);
+    if (q == NULL)
+        return;
+
+    vlc_rwlock_wrlock(&logger->lock);
+    assert(logger->async == NULL);
+    logger->async = q;
+    vlc_rwlock_unlock(&logger->lock);
+}
+
 /**
  * Initializes the messages logging subsystem and drain the early messages to
  * the configured log.
@@ -366,7 +762,10 @@ int vlc_LogInit(libvlc_int_t *vlc)
     if (module == NULL)
         cb = vlc_vaLogDiscard;
 
+    char *limits = var_InheritString(logger, "log-rate-limit");
+
     vlc_rwlock_wrlock(&logger->lock);
+    vlc_LogLimitsInit(logger, limits);
     if (logger->log == vlc_vaLogEarly)
         early_sys = logger->sys;
 
@@ -375,10 +774,12 @@ int vlc_LogInit(libvlc_int_t *vlc)
     assert(logger->module == NULL); /* Only one call to vlc_LogInit()! */
     logger->module = module;
     vlc_rwlock_unlock(&logger->lock);
+    free(limits);
 
     if (early_sys != NULL)
         vlc_LogEarlyClose(logger, early_sys);
 
+    vlc_LogStartAsync(logger);
     return 0;
 }
 
@@ -400,6 +801,9 @@ void vlc_LogSet(libvlc_int_t *vlc, vlc_log_cb cb, void *opaque)
     if (cb == NULL)
         cb = vlc_vaLogDiscard;
 
+    /* Pending messages go to the previous callback */
+    vlc_LogStopAsync(logger);
+
     vlc_rwlock_wrlock(&logger->lock);
     sys = logger->sys;
     module = logger->module;
@@ -412,6 +816,8 @@ void vlc_LogSet(libvlc_int_t *vlc, vlc_log_cb cb, void *opaque)
     if (module != NULL)
         vlc_module_unload(vlc, module, vlc_logger_unload, sys);
 
+    vlc_LogStartAsync(logger);
+
     /* Announce who we are */
     msg_Dbg (vlc, "VLC media player - %s", VERSION_MESSAGE);
     msg_Dbg (vlc, "%s", COPYRIGHT_MESSAGE);
@@ -426,6 +832,8 @@ void vlc_LogDeinit(libvlc_int_t *vlc)
     if (unlikely(logger == NULL))
         return;
 
+    vlc_LogStopAsync(logger);
+
     if (logger->module != NULL)
         vlc_module_unload(vlc, logger->module, vlc_logger_unload, logger->sys);
     else
@@ -436,6 +844,7 @@ void vlc_LogDeinit(libvlc_int_t *vlc)
         vlc_LogEarlyClose(logger, logger->sys);
     }
 
+    vlc_LogLimitsClean(logger);
     vlc_rwlock_destroy(&logger->lock);
     vlc_object_release(logger);
     libvlc_priv(vlc)->logger = NULL;
@@ -191,7 +191,10 @@ void *vlc_custom_create (vlc_object_t *parent, size_t length,
     if (unlikely(priv == NULL))
         return NULL;
     priv->psz_name = NULL;
-    priv->var_root = NULL;
+    atomic_init (&priv->var_table, 0);
+    atomic_init (&priv->var_epoch, 0);
+    atomic_init (&priv->var_readers[0], 0);
+    atomic_init (&priv->var_readers[1], 0);
     vlc_mutex_init (&priv->var_lock);
     vlc_cond_init (&priv->var_wait);
     atomic_init (&priv->refs, 1);
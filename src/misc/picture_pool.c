@@ -41,11 +41,13 @@ static_assert ((POOL_MAX & (POOL_MAX - 1)) == 0, "Not a power of two");
 struct picture_pool_t {
     int       (*pic_lock)(picture_t *);
     void      (*pic_unlock)(picture_t *);
+    /* The lock and the condition are only used by the waiting threads */
     vlc_mutex_t lock;
     vlc_cond_t  wait;
 
-    bool               canceled;
-    unsigned long long available;
+    atomic_bool        canceled;
+    atomic_ullong      available;
+    atomic_uint        waiters;
     atomic_ushort      refs;
     unsigned short     picture_count;
     picture_t  *picture[];
@@ -68,6 +70,48 @@ void picture_pool_Release(picture_pool_t *pool)
     picture_pool_Destroy(pool);
 }
 
+/** Find next (bit) set */
+static int fnsll(unsigned long long x, unsigned i)
+{
+    if (i >= CHAR_BIT * sizeof (x))
+        return 0;
+    return ffsll(x & ~((1ULL << i) - 1));
+}
+
+/**
+ * Takes the first available picture from the given offset onward.
+ * \return the offset of the picture plus one, or 0 if none is available
+ */
+static unsigned picture_pool_Take(picture_pool_t *pool, unsigned from)
+{
+    unsigned long long available = atomic_load(&pool->available);
+
+    for (;;) {
+        unsigned i = fnsll(available, from);
+        if (i == 0)
+            return 0;
+        if (atomic_compare_exchange_weak(&pool->available, &available,
+                                         available & ~(1ULL << (i - 1))))
+            return i;
+    }
+}
+
+static void picture_pool_PutBack(picture_pool_t *pool, unsigned offset)
+{
+    unsigned long long available =
+        atomic_fetch_or(&pool->available, 1ULL << offset);
+    assert(!(available & (1ULL << offset)));
+    (void) available;
+
+    /* The waiters register before checking the available pictures, so
+     * either they get this picture, or they are seen here. */
+    if (atomic_load(&pool->waiters) > 0) {
+        vlc_mutex_lock(&pool->lock);
+        vlc_cond_signal(&pool->wait);
+        vlc_mutex_unlock(&pool->lock);
+    }
+}
+
 static void picture_pool_ReleasePicture(picture_t *clone)
 {
     picture_priv_t *priv = (picture_priv_t *)clone;
@@ -82,12 +126,7 @@ static void picture_pool_ReleasePicture(picture_t *clone)
         pool->pic_unlock(picture);
     picture_Release(picture);
 
-    vlc_mutex_lock(&pool->lock);
-    assert(!(pool->available & (1ULL << offset)));
-    pool->available |= 1ULL << offset;
-    vlc_cond_signal(&pool->wait);
-    vlc_mutex_unlock(&pool->lock);
-
+    picture_pool_PutBack(pool, offset);
     picture_pool_Destroy(pool);
 }
 
@@ -133,14 +172,15 @@ picture_pool_t *picture_pool_NewExtended(const picture_pool_configuration_t *cfg
     vlc_mutex_init(&pool->lock);
     vlc_cond_init(&pool->wait);
     if (cfg->picture_count == POOL_MAX)
-        pool->available = ~0ULL;
+        atomic_init(&pool->available, ~0ULL);
     else
-        pool->available = (1ULL << cfg->picture_count) - 1;
+        atomic_init(&pool->available, (1ULL << cfg->picture_count) - 1);
+    atomic_init(&pool->waiters, 0);
     atomic_init(&pool->refs,  1);
     pool->picture_count = cfg->picture_count;
     memcpy(pool->picture, cfg->picture,
            cfg->picture_count * sizeof (picture_t *));
-    pool->canceled = false;
+    atomic_init(&pool->canceled, false);
     return pool;
 }
 
@@ -201,96 +241,79 @@ error:
     return NULL;
 }
 
-/** Find next (bit) set */
-static int fnsll(unsigned long long x, unsigned i)
+static picture_t *picture_pool_Acquire(picture_pool_t *pool, unsigned offset)
 {
-    if (i >= CHAR_BIT * sizeof (x))
-        return 0;
-    return ffsll(x & ~((1ULL << i) - 1));
+    picture_t *clone = picture_pool_ClonePicture(pool, offset);
+    if (clone != NULL) {
+        assert(clone->p_next == NULL);
+        atomic_fetch_add(&pool->refs, 1);
+    }
+    return clone;
 }
 
 picture_t *picture_pool_Get(picture_pool_t *pool)
 {
-    vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
+    assert(atomic_load(&pool->refs) > 0);
 
-    if (pool->canceled)
-    {
-        vlc_mutex_unlock(&pool->lock);
+    if (atomic_load(&pool->canceled))
         return NULL;
-    }
 
-    for (unsigned i = ffsll(pool->available); i; i = fnsll(pool->available, i))
+    for (unsigned i = picture_pool_Take(pool, 0); i;
+         i = picture_pool_Take(pool, i))
     {
-        pool->available &= ~(1ULL << (i - 1));
-        vlc_mutex_unlock(&pool->lock);
-
         picture_t *picture = pool->picture[i - 1];
 
         if (pool->pic_lock != NULL && pool->pic_lock(picture) != VLC_SUCCESS) {
-            vlc_mutex_lock(&pool->lock);
-            pool->available |= 1ULL << (i - 1);
+            picture_pool_PutBack(pool, i - 1);
             continue;
         }
 
-        picture_t *clone = picture_pool_ClonePicture(pool, i - 1);
-        if (clone != NULL) {
-            assert(clone->p_next == NULL);
-            atomic_fetch_add(&pool->refs, 1);
-        }
-        return clone;
+        return picture_pool_Acquire(pool, i - 1);
     }
-
-    vlc_mutex_unlock(&pool->lock);
     return NULL;
 }
 
 picture_t *picture_pool_Wait(picture_pool_t *pool)
 {
-    unsigned i;
-
-    vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
+    assert(atomic_load(&pool->refs) > 0);
 
-    while (pool->available == 0)
+    unsigned i = picture_pool_Take(pool, 0);
+    if (i == 0)
     {
-        if (pool->canceled)
+        vlc_mutex_lock(&pool->lock);
+        atomic_fetch_add(&pool->waiters, 1);
+
+        while ((i = picture_pool_Take(pool, 0)) == 0)
         {
-            vlc_mutex_unlock(&pool->lock);
-            return NULL;
+            if (atomic_load(&pool->canceled))
+            {
+                atomic_fetch_sub(&pool->waiters, 1);
+                vlc_mutex_unlock(&pool->lock);
+                return NULL;
+            }
+            vlc_cond_wait(&pool->wait, &pool->lock);
         }
-        vlc_cond_wait(&pool->wait, &pool->lock);
-    }
 
-    i = ffsll(pool->available);
-    assert(i > 0);
-    pool->available &= ~(1ULL << (i - 1));
-    vlc_mutex_unlock(&pool->lock);
+        atomic_fetch_sub(&pool->waiters, 1);
+        vlc_mutex_unlock(&pool->lock);
+    }
 
     picture_t *picture = pool->picture[i - 1];
 
     if (pool->pic_lock != NULL && pool->pic_lock(picture) != VLC_SUCCESS) {
-        vlc_mutex_lock(&pool->lock);
-        pool->available |= 1ULL << (i - 1);
-        vlc_cond_signal(&pool->wait);
-        vlc_mutex_unlock(&pool->lock);
+        picture_pool_PutBack(pool, i - 1);
         return NULL;
     }
 
-    picture_t *clone = picture_pool_ClonePicture(pool, i - 1);
-    if (clone != NULL) {
-        assert(clone->p_next == NULL);
-        atomic_fetch_add(&pool->refs, 1);
-    }
-    return clone;
+    return picture_pool_Acquire(pool, i - 1);
 }
 
 void picture_pool_Cancel(picture_pool_t *pool, bool canceled)
 {
     vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
+    assert(atomic_load(&pool->refs) > 0);
 
-    pool->canceled = canceled;
+    atomic_store(&pool->canceled, canceled);
     if (canceled)
         vlc_cond_broadcast(&pool->wait);
     vlc_mutex_unlock(&pool->lock);
@@ -40,6 +40,7 @@ void vlc_global_mutex (unsigned n, bool acquire)
 #ifdef _WIN32
         VLC_STATIC_MUTEX, // For MTA holder
 #endif
+        VLC_STATIC_MUTEX, // For shared stream caches
     };
     static_assert (VLC_MAX_MUTEX == (sizeof (locks) / sizeof (locks[0])),
                    "Wrong number of global mutexes");
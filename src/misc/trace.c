@@ -0,0 +1,219 @@
+/*****************************************************************************
+ * trace.c: hot path tracing
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/** @ingroup trace */
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_fs.h>
+#include <vlc_trace.h>
+#include <vlc_atomic.h>
+
+#ifdef ENABLE_TRACE
+
+/* Events kept per thread, the oldest ones are overwritten (power of 2) */
+#define TRACE_EVENTS 65536
+/* Oldest events left out of the dump of a full buffer, as the thread may be
+ * overwriting them while they are written out */
+#define TRACE_DUMP_MARGIN 256
+
+struct vlc_trace_event
+{
+    mtime_t     date;
+    const char *name;
+    int64_t     value;
+    int         type;
+};
+
+/* The events of a buffer are only written by its thread. The buffers are
+ * never freed: when their thread ends, they are reused by new threads. */
+struct vlc_trace_buffer
+{
+    struct vlc_trace_buffer *next;
+    unsigned long tid;
+    bool          used;
+    atomic_uint_fast64_t count;
+    struct vlc_trace_event events[TRACE_EVENTS];
+};
+
+static vlc_mutex_t trace_lock = VLC_STATIC_MUTEX;
+static struct vlc_trace_buffer *trace_buffers = NULL;
+static vlc_threadvar_t trace_key;
+static bool trace_key_created = false;
+static thread_local struct vlc_trace_buffer *trace_buffer = NULL;
+
+static void ThreadEnd(void *data)
+{
+    struct vlc_trace_buffer *buf = data;
+
+    vlc_mutex_lock(&trace_lock);
+    buf->used = false;
+    vlc_mutex_unlock(&trace_lock);
+}
+
+static struct vlc_trace_buffer *ThreadBuffer(void)
+{
+    struct vlc_trace_buffer *buf;
+
+    vlc_mutex_lock(&trace_lock);
+    /* The key notifies the end of the threads, it lives as long as the
+     * buffers do */
+    if (!trace_key_created)
+    {
+        if (vlc_threadvar_create(&trace_key, ThreadEnd))
+        {
+            vlc_mutex_unlock(&trace_lock);
+            return NULL;
+        }
+        trace_key_created = true;
+    }
+
+    for (buf = trace_buffers; buf != NULL; buf = buf->next)
+        if (!buf->used)
+            break;
+
+    if (buf == NULL)
+    {
+        buf = malloc(sizeof (*buf));
+        if (unlikely(buf == NULL))
+        {
+            vlc_mutex_unlock(&trace_lock);
+            return NULL;
+        }
+        buf->next = trace_buffers;
+        trace_buffers = buf;
+    }
+    buf->tid = vlc_thread_id();
+    buf->used = true;
+    atomic_init(&buf->count, 0);
+    vlc_mutex_unlock(&trace_lock);
+
+    vlc_threadvar_set(trace_key, buf);
+    return buf;
+}
+
+void vlc_trace_Event(int type, const char *name, int64_t value)
+{
+    struct vlc_trace_buffer *buf = trace_buffer;
+
+    if (unlikely(buf == NULL))
+    {
+        buf = trace_buffer = ThreadBuffer();
+        if (buf == NULL)
+            return;
+    }
+
+    uint_fast64_t count = atomic_load_explicit(&buf->count,
+                                               memory_order_relaxed);
+    struct vlc_trace_event *ev = &buf->events[count % TRACE_EVENTS];
+
+    ev->date = mdate();
+    ev->name = name;
+    ev->value = value;
+    ev->type = type;
+    /* Publish the event to the dump */
+    atomic_store_explicit(&buf->count, count + 1, memory_order_release);
+}
+
+static void DumpEvent(FILE *stream, unsigned long tid,
+                      const struct vlc_trace_event *ev)
+{
+    static const char phases[] = {
+        [VLC_TRACE_BEGIN] = 'B',
+        [VLC_TRACE_END] = 'E',
+        [VLC_TRACE_COUNTER] = 'C',
+        [VLC_TRACE_FLOW_START] = 's',
+        [VLC_TRACE_FLOW_STEP] = 't',
+        [VLC_TRACE_FLOW_END] = 'f',
+    };
+
+    if ((unsigned)ev->type >= ARRAY_SIZE(phases) || ev->name == NULL)
+        return;
+
+    fprintf(stream, ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%"PRId64","
+            "\"pid\":1,\"tid\":%lu", ev->name, phases[ev->type], ev->date,
+            tid);
+
+    switch (ev->type)
+    {
+        case VLC_TRACE_COUNTER:
+            fprintf(stream, ",\"args\":{\"value\":%"PRId64"}", ev->value);
+            break;
+        case VLC_TRACE_FLOW_END:
+            /* Binds to the enclosing slice, like the other flow events */
+            fputs(",\"bp\":\"e\"", stream);
+            /* fall through */
+        case VLC_TRACE_FLOW_START:
+        case VLC_TRACE_FLOW_STEP:
+            fprintf(stream, ",\"cat\":\"%s\",\"id\":%"PRId64, ev->name,
+                    ev->value);
+            break;
+    }
+    fputc('}', stream);
+}
+
+int vlc_trace_Dump(const char *path)
+{
+    FILE *stream = vlc_fopen(path, "wt");
+    if (stream == NULL)
+        return VLC_EGENERIC;
+
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+          "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+          "\"args\":{\"name\":\"vlc\"}}", stream);
+
+    vlc_mutex_lock(&trace_lock);
+    for (const struct vlc_trace_buffer *buf = trace_buffers; buf != NULL;
+         buf = buf->next)
+    {
+        uint_fast64_t end = atomic_load_explicit(&buf->count,
+                                                 memory_order_acquire);
+        uint_fast64_t start = 0;
+
+        if (end > TRACE_EVENTS)
+            start = end - TRACE_EVENTS + TRACE_DUMP_MARGIN;
+
+        for (uint_fast64_t i = start; i != end; i++)
+            DumpEvent(stream, buf->tid, &buf->events[i % TRACE_EVENTS]);
+    }
+    vlc_mutex_unlock(&trace_lock);
+
+    fputs("\n]}\n", stream);
+    return fclose(stream) ? VLC_EGENERIC : VLC_SUCCESS;
+}
+
+#else /* !ENABLE_TRACE */
+
+void vlc_trace_Event(int type, const char *name, int64_t value)
+{
+    VLC_UNUSED(type); VLC_UNUSED(name); VLC_UNUSED(value);
+}
+
+int vlc_trace_Dump(const char *path)
+{
+    VLC_UNUSED(path);
+    return VLC_EGENERIC;
+}
+
+#endif
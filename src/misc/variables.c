@@ -28,9 +28,6 @@
 # include "config.h"
 #endif
 
-#ifdef HAVE_SEARCH_H
-# include <search.h>
-#endif
 #include <assert.h>
 #include <float.h>
 #include <math.h>
@@ -73,10 +70,14 @@ typedef struct callback_table_t
  */
 struct variable_t
 {
-    char *       psz_name; /**< The variable unique name (must be first) */
+    char *       psz_name; /**< The variable unique name */
+    uint32_t     hash; /**< Hash of the name */
+    int          i_class; /**< The class of the variable (never changes) */
 
     /** The variable's exported value */
     vlc_value_t  val;
+    /** Copy of the value for lock-free reads (except strings) */
+    atomic_uint_least64_t fast_val;
 
     /** The variable display name, mainly for use by the interfaces */
     char *       psz_text;
@@ -141,23 +142,241 @@ int_ops    = { CmpInt,     DupDummy,  FreeDummy,  },
 string_ops = { CmpString,  DupString, FreeString, },
 coords_ops = { NULL,       DupDummy,  FreeDummy,  };
 
-static int varcmp( const void *a, const void *b )
+/*
+ * Variables are indexed in an open addressing hash table per object.
+ *
+ * Writers hold the object variables lock. Readers of scalar values do not
+ * take the lock: they only enter a read-side section by counting themselves
+ * in the current epoch. Before freeing a removed variable or a replaced
+ * table, writers start a new epoch and wait for the readers of the previous
+ * one to leave. Read-side sections only probe the table and copy a value, so
+ * that wait is short.
+ */
+struct variable_table
+{
+    size_t mask; /**< Number of slots minus one */
+    size_t count; /**< Number of variables */
+    size_t used; /**< Number of variables and removed slots */
+    atomic_uintptr_t slots[];
+};
+
+#define VAR_SLOT_REMOVED ((uintptr_t)1)
+#define VAR_TABLE_MIN 8
+
+static_assert (sizeof (vlc_value_t) <= sizeof (uint_least64_t),
+               "Values do not fit lock-free reads");
+
+static uint32_t VarHash( const char *psz_name )
+{
+    uint32_t hash = 2166136261u; /* FNV-1a */
+
+    for( const unsigned char *p = (const void *)psz_name; *p; p++ )
+        hash = (hash ^ *p) * 16777619u;
+    return hash;
+}
+
+static unsigned VarReadLock( vlc_object_internals_t *priv )
+{
+    for( ;; )
+    {
+        unsigned epoch = atomic_load( &priv->var_epoch );
+
+        atomic_fetch_add( &priv->var_readers[epoch & 1], 1 );
+        if( likely(atomic_load( &priv->var_epoch ) == epoch) )
+            return epoch;
+        /* A writer started a new epoch meanwhile */
+        atomic_fetch_sub( &priv->var_readers[epoch & 1], 1 );
+    }
+}
+
+static void VarReadUnlock( vlc_object_internals_t *priv, unsigned epoch )
+{
+    atomic_fetch_sub_explicit( &priv->var_readers[epoch & 1], 1,
+                               memory_order_release );
+}
+
+/**
+ * Waits until no readers can see memory unlinked before the call.
+ * The variables lock must be held.
+ */
+static void VarSynchronize( vlc_object_internals_t *priv )
+{
+    unsigned epoch = atomic_fetch_add( &priv->var_epoch, 1 );
+
+    /* Read-side sections never block: spin */
+    while( atomic_load( &priv->var_readers[epoch & 1] ) != 0 );
+}
+
+static variable_t *VarFind( const struct variable_table *table,
+                            const char *psz_name, uint32_t hash )
+{
+    if( table == NULL )
+        return NULL;
+
+    for( size_t i = hash & table->mask;; i = (i + 1) & table->mask )
+    {
+        uintptr_t slot = atomic_load_explicit( &table->slots[i],
+                                               memory_order_acquire );
+        if( slot == 0 )
+            return NULL;
+        if( slot == VAR_SLOT_REMOVED )
+            continue;
+
+        variable_t *var = (variable_t *)slot;
+        if( var->hash == hash && !strcmp( var->psz_name, psz_name ) )
+            return var;
+    }
+}
+
+static struct variable_table *VarTable( vlc_object_internals_t *priv )
+{
+    return (struct variable_table *)
+        atomic_load_explicit( &priv->var_table, memory_order_acquire );
+}
+
+static void VarTableAdd( struct variable_table *table, variable_t *var )
+{
+    size_t i = var->hash & table->mask;
+    uintptr_t slot;
+
+    while( (slot = atomic_load_explicit( &table->slots[i],
+                                         memory_order_relaxed )) != 0
+        && slot != VAR_SLOT_REMOVED )
+        i = (i + 1) & table->mask;
+
+    if( slot == 0 )
+        table->used++;
+    table->count++;
+    /* Publish the initialized variable to the readers */
+    atomic_store_explicit( &table->slots[i], (uintptr_t)var,
+                           memory_order_release );
+}
+
+/**
+ * Inserts a variable, growing the table as needed.
+ * The variables lock must be held.
+ */
+static int VarInsert( vlc_object_internals_t *priv, variable_t *var )
 {
-    const variable_t *va = a, *vb = b;
+    struct variable_table *table = VarTable( priv );
+
+    /* Keep at least a quarter of the slots free */
+    if( table == NULL || (table->used + 1) * 4 > (table->mask + 1) * 3 )
+    {
+        size_t size = VAR_TABLE_MIN;
+        size_t count = (table != NULL) ? table->count : 0;
+
+        while( size < (count + 1) * 2 )
+            size *= 2;
+
+        struct variable_table *newtab =
+            malloc( sizeof (*newtab) + size * sizeof (newtab->slots[0]) );
+        if( unlikely(newtab == NULL) )
+            return VLC_ENOMEM;
+
+        newtab->mask = size - 1;
+        newtab->count = 0;
+        newtab->used = 0;
+        for( size_t i = 0; i < size; i++ )
+            atomic_init( &newtab->slots[i], 0 );
 
-    /* psz_name must be first */
-    assert( va == (const void *)&va->psz_name );
-    return strcmp( va->psz_name, vb->psz_name );
+        if( table != NULL )
+            for( size_t i = 0; i <= table->mask; i++ )
+            {
+                uintptr_t slot = atomic_load_explicit( &table->slots[i],
+                                                       memory_order_relaxed );
+                if( slot != 0 && slot != VAR_SLOT_REMOVED )
+                    VarTableAdd( newtab, (variable_t *)slot );
+            }
+
+        atomic_store_explicit( &priv->var_table, (uintptr_t)newtab,
+                               memory_order_release );
+        if( table != NULL )
+        {
+            VarSynchronize( priv );
+            free( table );
+        }
+        table = newtab;
+    }
+
+    VarTableAdd( table, var );
+    return VLC_SUCCESS;
+}
+
+/**
+ * Removes a variable. It can be freed once readers are synchronized.
+ * The variables lock must be held.
+ */
+static void VarRemove( vlc_object_internals_t *priv, variable_t *var )
+{
+    struct variable_table *table = VarTable( priv );
+
+    for( size_t i = var->hash & table->mask;; i = (i + 1) & table->mask )
+        if( atomic_load_explicit( &table->slots[i], memory_order_relaxed )
+                                                         == (uintptr_t)var )
+        {
+            atomic_store_explicit( &table->slots[i], VAR_SLOT_REMOVED,
+                                   memory_order_release );
+            table->count--;
+            break;
+        }
+}
+
+/**
+ * Copies the value for lock-free readers. The variables lock must be held.
+ */
+static void VarPublish( variable_t *var )
+{
+    uint_least64_t raw = 0;
+
+    memcpy( &raw, &var->val, sizeof (var->val) );
+    atomic_store_explicit( &var->fast_val, raw, memory_order_release );
 }
 
 static variable_t *Lookup( vlc_object_t *obj, const char *psz_name )
 {
     vlc_object_internals_t *priv = vlc_internals( obj );
-    variable_t **pp_var;
 
     vlc_mutex_lock(&priv->var_lock);
-    pp_var = tfind( &psz_name, &priv->var_root, varcmp );
-    return (pp_var != NULL) ? *pp_var : NULL;
+    return VarFind( VarTable( priv ), psz_name, VarHash( psz_name ) );
+}
+
+/**
+ * Lists the variables sorted by name. The variables lock must be held.
+ */
+static int varcmp( const void *a, const void *b )
+{
+    const variable_t *const *va = a, *const *vb = b;
+
+    return strcmp( (*va)->psz_name, (*vb)->psz_name );
+}
+
+static variable_t **VarList( vlc_object_internals_t *priv, size_t *count )
+{
+    struct variable_table *table = VarTable( priv );
+    variable_t **tab;
+    size_t n = 0;
+
+    *count = 0;
+    if( table == NULL || table->count == 0 )
+        return NULL;
+
+    tab = vlc_alloc( table->count, sizeof (*tab) );
+    if( unlikely(tab == NULL) )
+        return NULL;
+
+    for( size_t i = 0; i <= table->mask; i++ )
+    {
+        uintptr_t slot = atomic_load_explicit( &table->slots[i],
+                                               memory_order_relaxed );
+        if( slot != 0 && slot != VAR_SLOT_REMOVED )
+            tab[n++] = (variable_t *)slot;
+    }
+    assert( n == table->count );
+
+    qsort( tab, n, sizeof (*tab), varcmp );
+    *count = n;
+    return tab;
 }
 
 static void Destroy( variable_t *p_var )
@@ -286,9 +505,7 @@ static void TriggerListCallback(vlc_object_t *obj, variable_t *var,
 /**
  * Initialize a vlc variable
  *
- * We hash the given string and insert it into the sorted list. The insertion
- * may require slow memory copies, but think about what we gain in the log(n)
- * lookup phase when setting/getting the variable value!
+ * We hash the given string and insert it into the hash table of the object.
  *
  * \param p_this The object in which to create the variable
  * \param psz_name The name of the variable
@@ -304,9 +521,11 @@ int var_Create( vlc_object_t *p_this, const char *psz_name, int i_type )
         return VLC_ENOMEM;
 
     p_var->psz_name = strdup( psz_name );
+    p_var->hash = VarHash( psz_name );
     p_var->psz_text = NULL;
 
     p_var->i_type = i_type & ~VLC_VAR_DOINHERIT;
+    p_var->i_class = i_type & VLC_VAR_CLASS;
 
     p_var->i_usage = 1;
 
@@ -361,17 +580,22 @@ int var_Create( vlc_object_t *p_this, const char *psz_name, int i_type )
     if (i_type & VLC_VAR_DOINHERIT)
         var_Inherit(p_this, psz_name, i_type, &p_var->val);
 
+    atomic_init( &p_var->fast_val, 0 );
+    VarPublish( p_var );
+
     vlc_object_internals_t *p_priv = vlc_internals( p_this );
-    variable_t **pp_var, *p_oldvar;
+    variable_t *p_oldvar;
     int ret = VLC_SUCCESS;
 
     vlc_mutex_lock( &p_priv->var_lock );
 
-    pp_var = tsearch( p_var, &p_priv->var_root, varcmp );
-    if( unlikely(pp_var == NULL) )
-        ret = VLC_ENOMEM;
-    else if( (p_oldvar = *pp_var) == p_var ) /* Variable create */
-        p_var = NULL; /* Variable created */
+    p_oldvar = VarFind( VarTable( p_priv ), psz_name, p_var->hash );
+    if( p_oldvar == NULL ) /* Variable create */
+    {
+        ret = VarInsert( p_priv, p_var );
+        if( likely(ret == VLC_SUCCESS) )
+            p_var = NULL; /* Variable created */
+    }
     else /* Variable already exists */
     {
         assert (((i_type ^ p_oldvar->i_type) & VLC_VAR_CLASS) == 0);
@@ -389,8 +613,7 @@ int var_Create( vlc_object_t *p_this, const char *psz_name, int i_type )
 /**
  * Destroy a vlc variable
  *
- * Look for the variable and destroy it if it is found. As in var_Create we
- * do a call to memmove() but we have performance counterparts elsewhere.
+ * Look for the variable and destroy it if it is found.
  *
  * \param p_this The object that holds the variable
  * \param psz_name The name of the variable
@@ -410,7 +633,8 @@ void (var_Destroy)(vlc_object_t *p_this, const char *psz_name)
     else if( --p_var->i_usage == 0 )
     {
         assert(!p_var->b_incallback);
-        tdelete( p_var, &p_priv->var_root, varcmp );
+        VarRemove( p_priv, p_var );
+        VarSynchronize( p_priv );
     }
     else
     {
@@ -423,17 +647,24 @@ void (var_Destroy)(vlc_object_t *p_this, const char *psz_name)
         Destroy( p_var );
 }
 
-static void CleanupVar( void *var )
-{
-    Destroy( var );
-}
-
 void var_DestroyAll( vlc_object_t *obj )
 {
     vlc_object_internals_t *priv = vlc_internals( obj );
+    struct variable_table *table = VarTable( priv );
 
-    tdestroy( priv->var_root, CleanupVar );
-    priv->var_root = NULL;
+    /* The object has no other users anymore */
+    if( table == NULL )
+        return;
+
+    for( size_t i = 0; i <= table->mask; i++ )
+    {
+        uintptr_t slot = atomic_load_explicit( &table->slots[i],
+                                               memory_order_relaxed );
+        if( slot != 0 && slot != VAR_SLOT_REMOVED )
+            Destroy( (variable_t *)slot );
+    }
+    free( table );
+    atomic_store_explicit( &priv->var_table, 0, memory_order_relaxed );
 }
 
 #undef var_Change
@@ -482,6 +713,7 @@ int var_Change( vlc_object_t *p_this, const char *psz_name,
             assert(p_var->ops->pf_free == FreeDummy);
             p_var->step = *p_val;
             CheckValue( p_var, &p_var->val );
+            VarPublish( p_var );
             break;
         case VLC_VAR_GETSTEP:
             switch (p_var->i_type & VLC_VAR_TYPE)
@@ -569,6 +801,7 @@ int var_Change( vlc_object_t *p_this, const char *psz_name,
             CheckValue( p_var, &newval );
             /* Set the variable */
             p_var->val = newval;
+            VarPublish( p_var );
             /* Free data if needed */
             p_var->ops->pf_free( &oldval );
             break;
@@ -680,6 +913,7 @@ int var_GetAndSet( vlc_object_t *p_this, const char *psz_name, int i_action,
 
     /*  Check boundaries */
     CheckValue( p_var, &p_var->val );
+    VarPublish( p_var );
     *p_val = p_var->val;
 
     /* Deal with callbacks.*/
@@ -753,6 +987,7 @@ int var_SetChecked( vlc_object_t *p_this, const char *psz_name,
 
     /* Set the variable */
     p_var->val = val;
+    VarPublish( p_var );
 
     /* Deal with callbacks */
     TriggerCallback( p_this, p_var, psz_name, oldval );
@@ -777,6 +1012,39 @@ int var_Set( vlc_object_t *p_this, const char *psz_name, vlc_value_t val )
     return var_SetChecked( p_this, psz_name, 0, val );
 }
 
+/**
+ * Gets a value without locking, except for strings which need to be
+ * duplicated under the lock.
+ *
+ * \return false if the value must be read with the lock
+ */
+static bool GetFast( vlc_object_internals_t *priv, const char *psz_name,
+                     int expected_type, vlc_value_t *p_val, int *err )
+{
+    unsigned epoch = VarReadLock( priv );
+    variable_t *var = VarFind( VarTable( priv ), psz_name,
+                               VarHash( psz_name ) );
+    bool done = true;
+
+    if( var == NULL )
+        *err = VLC_ENOVAR;
+    else if( var->i_class == VLC_VAR_STRING )
+        done = false;
+    else
+    {
+        assert( expected_type == 0 || var->i_class == expected_type );
+        assert( var->i_class != VLC_VAR_VOID );
+        (void) expected_type; /* unused with NDEBUG */
+
+        uint_least64_t raw = atomic_load_explicit( &var->fast_val,
+                                                   memory_order_acquire );
+        memcpy( p_val, &raw, sizeof (*p_val) );
+        *err = VLC_SUCCESS;
+    }
+    VarReadUnlock( priv, epoch );
+    return done;
+}
+
 #undef var_GetChecked
 int var_GetChecked( vlc_object_t *p_this, const char *psz_name,
                     int expected_type, vlc_value_t *p_val )
@@ -787,6 +1055,9 @@ int var_GetChecked( vlc_object_t *p_this, const char *psz_name,
     variable_t *p_var;
     int err = VLC_SUCCESS;
 
+    if( GetFast( p_priv, psz_name, expected_type, p_val, &err ) )
+        return err;
+
     p_var = Lookup( p_this, psz_name );
     if( p_var != NULL )
     {
@@ -1309,13 +1580,8 @@ void var_FreeList( vlc_value_t *p_val, vlc_value_t *p_val2 )
     }
 }
 
-static void DumpVariable(const void *data, const VISIT which, const int depth)
+static void DumpVariable(const variable_t *var)
 {
-    if (which != postorder && which != leaf)
-        return;
-    (void) depth;
-
-    const variable_t *var = *(const variable_t **)data;
     const char *typename = "unknown";
 
     switch (var->i_type & VLC_VAR_TYPE)
@@ -1370,40 +1636,37 @@ static void DumpVariable(const void *data, const VISIT which, const int depth)
 
 void DumpVariables(vlc_object_t *obj)
 {
-    vlc_mutex_lock(&vlc_internals(obj)->var_lock);
-    if (vlc_internals(obj)->var_root == NULL)
-        puts(" `-o No variables");
-    else
-        twalk(vlc_internals(obj)->var_root, DumpVariable);
-    vlc_mutex_unlock(&vlc_internals(obj)->var_lock);
-}
-
-static thread_local void *twalk_ctx;
-
-static void TwalkGetNames(const void *data, const VISIT which, const int depth)
-{
-    if (which != postorder && which != leaf)
-        return;
-    (void) depth;
+    vlc_object_internals_t *priv = vlc_internals(obj);
+    size_t count;
 
-    const variable_t *var = *(const variable_t **)data;
-    DECL_ARRAY(char *) *names = twalk_ctx;
-    char *dup = strdup(var->psz_name);
-    if (dup != NULL)
-        ARRAY_APPEND(*names, dup);
+    vlc_mutex_lock(&priv->var_lock);
+    variable_t **vars = VarList(priv, &count);
+    if (count == 0)
+        puts(" `-o No variables");
+    for (size_t i = 0; i < count; i++)
+        DumpVariable(vars[i]);
+    vlc_mutex_unlock(&priv->var_lock);
+    free(vars);
 }
 
 char **var_GetAllNames(vlc_object_t *obj)
 {
     vlc_object_internals_t *priv = vlc_internals(obj);
+    size_t count;
 
     DECL_ARRAY(char *) names;
     ARRAY_INIT(names);
 
-    twalk_ctx = &names;
     vlc_mutex_lock(&priv->var_lock);
-    twalk(priv->var_root, TwalkGetNames);
+    variable_t **vars = VarList(priv, &count);
+    for (size_t i = 0; i < count; i++)
+    {
+        char *dup = strdup(vars[i]->psz_name);
+        if (dup != NULL)
+            ARRAY_APPEND(names, dup);
+    }
     vlc_mutex_unlock(&priv->var_lock);
+    free(vars);
 
     if (names.i_size == 0)
         return NULL;
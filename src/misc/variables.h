@@ -39,7 +39,9 @@ struct vlc_object_internals
     char           *psz_name; /* given name */
 
     /* Object variables */
-    void           *var_root;
+    atomic_uintptr_t var_table; /* hash table, see variables.c */
+    atomic_uint     var_epoch;
+    atomic_uint     var_readers[2]; /* lock-free readers per epoch parity */
     vlc_mutex_t     var_lock;
     vlc_cond_t      var_wait;
 
@@ -107,25 +107,28 @@ vlc_plugin_t *vlc_plugins = NULL;
 static int vlc_module_store(module_t *mod)
 {
     const char *name = module_get_capability(mod);
-    vlc_modcap_t *cap = malloc(sizeof (*cap));
-    if (unlikely(cap == NULL))
-        return -1;
+    vlc_modcap_t key = { .name = (char *)name }, *cap;
+    vlc_modcap_t **cp = tfind(&key, &modules.caps_tree, vlc_modcap_cmp);
 
-    cap->name = strdup(name);
-    cap->modv = NULL;
-    cap->modc = 0;
+    /* Only allocate for capabilities not seen yet */
+    if (cp != NULL)
+        cap = *cp;
+    else
+    {
+        cap = malloc(sizeof (*cap));
+        if (unlikely(cap == NULL))
+            return -1;
 
-    if (unlikely(cap->name == NULL))
-        goto error;
+        cap->name = strdup(name);
+        cap->modv = NULL;
+        cap->modc = 0;
 
-    vlc_modcap_t **cp = tsearch(cap, &modules.caps_tree, vlc_modcap_cmp);
-    if (unlikely(cp == NULL))
-        goto error;
+        if (unlikely(cap->name == NULL))
+            goto error;
 
-    if (*cp != cap)
-    {
-        vlc_modcap_free(cap);
-        cap = *cp;
+        cp = tsearch(cap, &modules.caps_tree, vlc_modcap_cmp);
+        if (unlikely(cp == NULL))
+            goto error;
     }
 
     module_t **modv = realloc(cap->modv, sizeof (*modv) * (cap->modc + 1));
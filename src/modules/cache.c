@@ -57,7 +57,7 @@
 #ifdef HAVE_DYNAMIC_PLUGINS
 /* Sub-version number
  * (only used to avoid breakage in dev version when cache structure changes) */
-#define CACHE_SUBVERSION_NUM 34
+#define CACHE_SUBVERSION_NUM 35
 
 /* Cache filename */
 #define CACHE_NAME "plugins.dat"
@@ -65,6 +65,25 @@
 #define CACHE_STRING "cache "PACKAGE_NAME" "PACKAGE_VERSION
 
 
+/* Plugins are stored as their module_t and module_config_t tables, with
+ * pointers replaced by offsets from the start of the file (0 for NULL).
+ * The file is mapped privately, and loading only turns the offsets back
+ * into pointers: strings, lists and tables are used in place. */
+
+/** Plugin record, in the table at the end of the file */
+struct vlc_cache_plugin
+{
+    uint64_t modules; /**< Offset of the module_t table */
+    uint64_t config; /**< Offset of the module_config_t table */
+    uint64_t textdomain; /**< Offset of the gettext domain (or 0) */
+    uint64_t path; /**< Offset of the relative path */
+    int64_t mtime;
+    uint64_t size;
+    uint32_t modules_count;
+    uint16_t config_size;
+    uint8_t unloadable;
+};
+
 static int vlc_cache_load_immediate(void *out, block_t *in, size_t size)
 {
     if (in->i_buffer < size)
@@ -76,278 +95,177 @@ static int vlc_cache_load_immediate(void *out, block_t *in, size_t size)
     return 0;
 }
 
-static int vlc_cache_load_bool(bool *out, block_t *in)
+static int vlc_cache_load_array(void *p, uint64_t offset, size_t size,
+                                size_t n, size_t align, const block_t *file)
 {
-    unsigned char b;
-
-    if (vlc_cache_load_immediate(&b, in, 1) || b > 1)
-        return -1;
-
-    *out = b;
-    return 0;
-}
+    void **pp = p;
 
-static int vlc_cache_load_array(const void **p, size_t size, size_t n,
-                                block_t *file)
-{
     if (n == 0)
     {
-        *p = NULL;
+        *pp = NULL;
         return 0;
     }
 
-    if (unlikely(size * n < size))
+    if (offset == 0 || offset > file->i_buffer || (offset % align) != 0
+     || (file->i_buffer - offset) / size < n)
         return -1;
 
-    size *= n;
-
-    if (file->i_buffer < size)
-        return -1;
-
-    *p = file->p_buffer;
-    file->p_buffer += size;
-    file->i_buffer -= size;
+    *pp = file->p_buffer + offset;
     return 0;
 }
 
-static int vlc_cache_load_string(const char **restrict p, block_t *file)
+static int vlc_cache_load_string(const char **restrict p, const block_t *file)
 {
-    uint16_t size;
+    uintptr_t offset = (uintptr_t)*p;
 
-    if (vlc_cache_load_immediate(&size, file, sizeof (size)) || size > 16384)
-        return -1;
+    if (offset == 0)
+        return 0; /* NULL */
 
-    if (size == 0)
-    {
-        *p = NULL;
-        return 0;
-    }
+    const char *str = (const char *)file->p_buffer + offset;
 
-    const char *str = (char *)file->p_buffer;
-
-    if (file->i_buffer < size || str[size - 1] != '\0')
+    if (offset >= file->i_buffer
+     || memchr(str, '\0', file->i_buffer - offset) == NULL)
         return -1;
 
-    file->p_buffer += size;
-    file->i_buffer -= size;
     *p = str;
     return 0;
 }
 
-static int vlc_cache_load_align(size_t align, block_t *file)
+static int vlc_cache_load_strings(const char ***p, size_t n,
+                                  const block_t *file)
 {
-    assert(align > 0);
-
-    size_t skip = (-(uintptr_t)file->p_buffer) % align;
-    if (skip == 0)
-        return 0;
-
-    assert(skip < align);
-
-    if (file->i_buffer < skip)
+    if (vlc_cache_load_array(p, (uintptr_t)*p, sizeof (**p), n,
+                             alignof (**p), file))
         return -1;
 
-    file->p_buffer += skip;
-    file->i_buffer -= skip;
-    assert((((uintptr_t)file->p_buffer) % align) == 0);
+    for (size_t i = 0; i < n; i++)
+        if (vlc_cache_load_string(&(*p)[i], file) || (*p)[i] == NULL)
+            return -1;
     return 0;
 }
 
-#define LOAD_IMMEDIATE(a) \
-    if (vlc_cache_load_immediate(&(a), file, sizeof (a))) \
-        goto error
-#define LOAD_FLAG(a) \
-    do \
-    { \
-        bool b; \
-        if (vlc_cache_load_bool(&b, file)) \
-            goto error; \
-        (a) = b; \
-    } while (0)
-#define LOAD_ARRAY(a,n) \
-    do \
-    { \
-        const void *base; \
-        if (vlc_cache_load_array(&base, sizeof (*(a)), (n), file)) \
-            goto error; \
-        (a) = base; \
-    } while (0)
 #define LOAD_STRING(a) \
     if (vlc_cache_load_string(&(a), file)) \
         goto error
-#define LOAD_ALIGNOF(t) \
-    if (vlc_cache_load_align(alignof(t), file)) \
+#define LOAD_STRINGS(a,n) \
+    if (vlc_cache_load_strings(&(a), (n), file)) \
+        goto error
+#define LOAD_ARRAY(a,n) \
+    if (vlc_cache_load_array(&(a), (uintptr_t)(a), sizeof (*(a)), (n), \
+                             alignof (*(a)), file)) \
         goto error
 
-static int vlc_cache_load_config(module_config_t *cfg, block_t *file)
+static int vlc_cache_load_config(module_config_t *cfg, const block_t *file)
 {
-    LOAD_IMMEDIATE (cfg->i_type);
-    LOAD_IMMEDIATE (cfg->i_short);
-    LOAD_FLAG (cfg->b_advanced);
-    LOAD_FLAG (cfg->b_internal);
-    LOAD_FLAG (cfg->b_unsaveable);
-    LOAD_FLAG (cfg->b_safe);
-    LOAD_FLAG (cfg->b_removed);
     LOAD_STRING (cfg->psz_type);
     LOAD_STRING (cfg->psz_name);
     LOAD_STRING (cfg->psz_text);
     LOAD_STRING (cfg->psz_longtext);
-    LOAD_IMMEDIATE (cfg->list_count);
+    LOAD_STRING (cfg->list_cb_name);
 
     if (IsConfigStringType (cfg->i_type))
     {
-        const char *psz;
-        LOAD_STRING(psz);
-        cfg->orig.psz = (char *)psz;
-        cfg->value.psz = (psz != NULL) ? strdup (cfg->orig.psz) : NULL;
-
-        if (cfg->list_count)
-            cfg->list.psz = xmalloc (cfg->list_count * sizeof (char *));
-        else
-            LOAD_STRING(cfg->list_cb_name);
-        for (unsigned i = 0; i < cfg->list_count; i++)
-        {
-            LOAD_STRING (cfg->list.psz[i]);
-            if (cfg->list.psz[i] == NULL /* NULL -> empty string */
-             && (cfg->list.psz[i] = calloc (1, 1)) == NULL)
-                goto error;
-        }
+        LOAD_STRING (*(const char **)&cfg->orig.psz);
+        cfg->value.psz = (cfg->orig.psz != NULL) ? strdup (cfg->orig.psz)
+                                                 : NULL;
+        LOAD_STRINGS (cfg->list.psz, cfg->list_count);
     }
     else
     {
-        LOAD_IMMEDIATE (cfg->orig);
-        LOAD_IMMEDIATE (cfg->min);
-        LOAD_IMMEDIATE (cfg->max);
         cfg->value = cfg->orig;
-
-        if (cfg->list_count)
-        {
-            LOAD_ALIGNOF(*cfg->list.i);
-        }
-        else
-            LOAD_STRING(cfg->list_cb_name);
-
-        LOAD_ARRAY(cfg->list.i, cfg->list_count);
-    }
-
-    cfg->list_text = xmalloc (cfg->list_count * sizeof (char *));
-    for (unsigned i = 0; i < cfg->list_count; i++)
-    {
-        LOAD_STRING (cfg->list_text[i]);
-        if (cfg->list_text[i] == NULL /* NULL -> empty string */
-         && (cfg->list_text[i] = calloc (1, 1)) == NULL)
-            goto error;
-    }
-
-    return 0;
-error:
-    return -1; /* FIXME: leaks */
-}
-
-static int vlc_cache_load_plugin_config(vlc_plugin_t *plugin, block_t *file)
-{
-    uint16_t lines;
-
-    /* Calculate the structure length */
-    LOAD_IMMEDIATE (lines);
-
-    /* Allocate memory */
-    if (lines)
-    {
-        plugin->conf.items = calloc(sizeof (module_config_t), lines);
-        if (unlikely(plugin->conf.items == NULL))
-        {
-            plugin->conf.size = 0;
-            return -1;
-        }
-    }
-    else
-        plugin->conf.items = NULL;
-
-    plugin->conf.size = lines;
-
-    /* Do the duplication job */
-    for (size_t i = 0; i < lines; i++)
-    {
-        module_config_t *item = plugin->conf.items + i;
-
-        if (vlc_cache_load_config(item, file))
-            return -1;
-
-        if (CONFIG_ITEM(item->i_type))
-        {
-            plugin->conf.count++;
-            if (item->i_type == CONFIG_ITEM_BOOL)
-                plugin->conf.booleans++;
-        }
-        item->owner = plugin;
+        LOAD_ARRAY (cfg->list.i, cfg->list_count);
     }
 
+    LOAD_STRINGS (cfg->list_text, cfg->list_count);
     return 0;
 error:
-    return -1; /* FIXME: leaks */
+    return -1;
 }
 
-static int vlc_cache_load_module(vlc_plugin_t *plugin, block_t *file)
+static int vlc_cache_load_module(module_t *module, const block_t *file)
 {
-    module_t *module = vlc_module_create(plugin);
-    if (unlikely(module == NULL))
-        return -1;
-
     LOAD_STRING(module->psz_shortname);
     LOAD_STRING(module->psz_longname);
     LOAD_STRING(module->psz_help);
 
-    LOAD_IMMEDIATE(module->i_shortcuts);
     if (module->i_shortcuts > MODULE_SHORTCUT_MAX)
         goto error;
-    else
-    {
-        module->pp_shortcuts =
-            xmalloc (sizeof (*module->pp_shortcuts) * module->i_shortcuts);
-        for (unsigned j = 0; j < module->i_shortcuts; j++)
-            LOAD_STRING(module->pp_shortcuts[j]);
-    }
+    LOAD_STRINGS(module->pp_shortcuts, module->i_shortcuts);
 
     LOAD_STRING(module->activate_name);
     LOAD_STRING(module->deactivate_name);
     LOAD_STRING(module->psz_capability);
-    LOAD_IMMEDIATE(module->i_score);
+    module->pf_activate = NULL;
+    module->pf_deactivate = NULL;
     return 0;
 error:
     return -1;
 }
 
-static vlc_plugin_t *vlc_cache_load_plugin(block_t *file)
+static vlc_plugin_t *vlc_cache_load_plugin(const struct vlc_cache_plugin *rec,
+                                           const block_t *file)
 {
     vlc_plugin_t *plugin = vlc_plugin_create();
     if (unlikely(plugin == NULL))
         return NULL;
 
-    uint32_t modules;
-    LOAD_IMMEDIATE(modules);
+    plugin->cached = true;
+
+    module_t *modules;
+    if (vlc_cache_load_array(&modules, rec->modules, sizeof (*modules),
+                             rec->modules_count, alignof (*modules), file))
+        goto error;
+
+    for (size_t i = 0; i < rec->modules_count; i++)
+    {
+        module_t *module = modules + i;
 
-    for (size_t i = 0; i < modules; i++)
-        if (vlc_cache_load_module(plugin, file))
+        if (vlc_cache_load_module(module, file))
             goto error;
 
-    if (vlc_cache_load_plugin_config(plugin, file))
+        /* The first module stays first, as in vlc_module_create() */
+        module->plugin = plugin;
+        module->next = (i + 1 < rec->modules_count) ? (module + 1) : NULL;
+    }
+    plugin->module = modules;
+    plugin->modules_count = rec->modules_count;
+
+    module_config_t *items;
+    if (vlc_cache_load_array(&items, rec->config, sizeof (*items),
+                             rec->config_size, alignof (*items), file))
         goto error;
 
-    LOAD_STRING(plugin->textdomain);
+    plugin->conf.items = items;
+    for (size_t i = 0; i < rec->config_size; i++)
+    {
+        module_config_t *item = items + i;
 
-    const char *path;
-    LOAD_STRING(path);
-    if (path == NULL)
+        /* Count the item first, so that its value gets freed on error */
+        plugin->conf.size++;
+        if (vlc_cache_load_config(item, file))
+            goto error;
+
+        if (CONFIG_ITEM(item->i_type))
+        {
+            plugin->conf.count++;
+            if (item->i_type == CONFIG_ITEM_BOOL)
+                plugin->conf.booleans++;
+        }
+        item->owner = plugin;
+    }
+
+    plugin->textdomain = (const char *)(uintptr_t)rec->textdomain;
+    if (vlc_cache_load_string(&plugin->textdomain, file))
         goto error;
 
-    plugin->path = strdup(path);
-    if (unlikely(plugin->path == NULL))
+    const char *path = (const char *)(uintptr_t)rec->path;
+    if (vlc_cache_load_string(&path, file) || path == NULL)
         goto error;
 
-    LOAD_FLAG(plugin->unloadable);
-    LOAD_IMMEDIATE(plugin->mtime);
-    LOAD_IMMEDIATE(plugin->size);
+    plugin->path = (char *)path;
+    plugin->unloadable = rec->unloadable != 0;
+    plugin->mtime = rec->mtime;
+    plugin->size = rec->size;
 
     if (plugin->textdomain != NULL)
         vlc_bindtextdomain(plugin->textdomain);
@@ -379,7 +297,9 @@ vlc_plugin_t *vlc_cache_load(vlc_object_t *p_this, const char *dir,
 
     msg_Dbg( p_this, "loading plugins cache file %s", psz_filename );
 
-    block_t *file = block_FilePath(psz_filename, false);
+    /* The mapping is private and writable, so that pointers can be
+     * relocated in place. */
+    block_t *file = block_FilePath(psz_filename, true);
     if (file == NULL)
         msg_Warn(p_this, "cannot read %s: %s", psz_filename,
                  vlc_strerror_c(errno));
@@ -387,6 +307,9 @@ vlc_plugin_t *vlc_cache_load(vlc_object_t *p_this, const char *dir,
     if (file == NULL)
         return 0;
 
+    uint8_t *base = file->p_buffer;
+    size_t size = file->i_buffer;
+
     /* Check the file is a plugins cache */
     char cachestr[sizeof (CACHE_STRING) - 1];
 
@@ -438,11 +361,30 @@ vlc_plugin_t *vlc_cache_load(vlc_object_t *p_this, const char *dir,
         return 0;
     }
 
-    vlc_plugin_t *cache = NULL;
+    uint64_t offset;
+    uint32_t count;
+    const struct vlc_cache_plugin *tab;
+
+    if (vlc_cache_load_immediate(&offset, file, sizeof (offset))
+     || vlc_cache_load_immediate(&count, file, sizeof (count)))
+        goto error;
+
+    /* Offsets are relative to the start of the file */
+    file->p_buffer = base;
+    file->i_buffer = size;
+
+    if (((uintptr_t)base % alignof (max_align_t)) != 0
+     || vlc_cache_load_array(&tab, offset, sizeof (*tab), count,
+                             alignof (*tab), file))
+        goto error;
+
+    /* Keep the file order, which is also the directory scan order, so that
+     * vlc_cache_lookup() normally finds each plugin first. */
+    vlc_plugin_t *cache = NULL, **pp = &cache;
 
-    while (file->i_buffer > 0)
+    for (size_t i = 0; i < count; i++)
     {
-        vlc_plugin_t *plugin = vlc_cache_load_plugin(file);
+        vlc_plugin_t *plugin = vlc_cache_load_plugin(tab + i, file);
         if (plugin == NULL)
             goto error;
 
@@ -454,8 +396,9 @@ vlc_plugin_t *vlc_cache_load(vlc_object_t *p_this, const char *dir,
             goto error;
         }
 
-        plugin->next = cache;
-        cache = plugin;
+        plugin->next = NULL;
+        *pp = plugin;
+        pp = &plugin->next;
     }
 
     file->p_next = *backingp;
@@ -473,27 +416,29 @@ error:
 #define SAVE_IMMEDIATE( a ) \
     if (fwrite (&(a), sizeof(a), 1, file) != 1) \
         goto error
-#define SAVE_FLAG(a) \
-    do { \
-        char b = (a); \
-        SAVE_IMMEDIATE(b); \
-    } while (0)
 
-static int CacheSaveString (FILE *file, const char *str)
+/**
+ * Writes a string, and replaces the pointer with the string offset.
+ */
+static int CacheSaveString (FILE *file, const char **strp)
 {
-    uint16_t size = (str != NULL) ? (strlen (str) + 1) : 0;
+    const char *str = *strp;
 
-    SAVE_IMMEDIATE (size);
-    if (size != 0 && fwrite(str, 1, size, file) != size)
-    {
-error:
+    if (str == NULL)
+        return 0;
+
+    size_t size = strlen (str) + 1;
+    long offset = ftell (file);
+
+    if (offset <= 0 || fwrite (str, 1, size, file) != size)
         return -1;
-    }
+
+    *strp = (const char *)(uintptr_t)offset;
     return 0;
 }
 
 #define SAVE_STRING( a ) \
-    if (CacheSaveString (file, (a))) \
+    if (CacheSaveString (file, &(a))) \
         goto error
 
 static int CacheSaveAlign(FILE *file, size_t align)
@@ -508,87 +453,210 @@ static int CacheSaveAlign(FILE *file, size_t align)
     return fseek(file, skip, SEEK_CUR);
 }
 
-#define SAVE_ALIGNOF(t) \
-    if (CacheSaveAlign(file, alignof (t))) \
+/**
+ * Writes a table, and replaces the pointer with the table offset.
+ */
+static int CacheSaveArray(FILE *file, const void **p, size_t size, size_t n,
+                          size_t align)
+{
+    if (n == 0)
+    {
+        *p = NULL;
+        return 0;
+    }
+
+    if (CacheSaveAlign(file, align))
+        return -1;
+
+    long offset = ftell(file);
+
+    if (offset <= 0 || fwrite(*p, size, n, file) != n)
+        return -1;
+
+    *p = (const void *)(uintptr_t)offset;
+    return 0;
+}
+
+#define SAVE_ARRAY(a,n) \
+    do { \
+        const void *tab_ = (a); \
+        if (CacheSaveArray(file, &tab_, sizeof (*(a)), (n), \
+                           alignof (*(a)))) \
+            goto error; \
+        (a) = (void *)tab_; \
+    } while (0)
+
+/**
+ * Writes a list of strings, and replaces the pointer with the list offset.
+ */
+static int CacheSaveStrings(FILE *file, const char ***p, size_t n)
+{
+    if (n == 0)
+    {
+        *p = NULL;
+        return 0;
+    }
+
+    const char **tab = vlc_alloc(n, sizeof (*tab));
+    if (unlikely(tab == NULL))
+        return -1;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        tab[i] = ((*p)[i] != NULL) ? (*p)[i] : ""; /* NULL -> empty string */
+        SAVE_STRING(tab[i]);
+    }
+
+    const char **list = tab;
+
+    SAVE_ARRAY(list, n);
+    free(tab);
+    *p = list;
+    return 0;
+error:
+    free(tab);
+    return -1;
+}
+
+#define SAVE_STRINGS(a,n) \
+    if (CacheSaveStrings(file, &(a), (n))) \
         goto error
 
-static int CacheSaveConfig (FILE *file, const module_config_t *cfg)
+static int CacheSaveConfig (FILE *file, module_config_t *cfg)
 {
-    SAVE_IMMEDIATE (cfg->i_type);
-    SAVE_IMMEDIATE (cfg->i_short);
-    SAVE_FLAG (cfg->b_advanced);
-    SAVE_FLAG (cfg->b_internal);
-    SAVE_FLAG (cfg->b_unsaveable);
-    SAVE_FLAG (cfg->b_safe);
-    SAVE_FLAG (cfg->b_removed);
     SAVE_STRING (cfg->psz_type);
     SAVE_STRING (cfg->psz_name);
     SAVE_STRING (cfg->psz_text);
     SAVE_STRING (cfg->psz_longtext);
-    SAVE_IMMEDIATE (cfg->list_count);
+    SAVE_STRING (cfg->list_cb_name);
 
     if (IsConfigStringType (cfg->i_type))
     {
-        SAVE_STRING (cfg->orig.psz);
-        if (cfg->list_count == 0)
-            SAVE_STRING(cfg->list_cb_name);
-
-        for (unsigned i = 0; i < cfg->list_count; i++)
-            SAVE_STRING (cfg->list.psz[i]);
+        SAVE_STRING (*(const char **)&cfg->orig.psz);
+        if (cfg->list_count > 0)
+        {
+            SAVE_STRINGS (cfg->list.psz, cfg->list_count);
+        }
+        else
+            cfg->list.psz = NULL;
     }
     else
     {
-        SAVE_IMMEDIATE (cfg->orig);
-        SAVE_IMMEDIATE (cfg->min);
-        SAVE_IMMEDIATE (cfg->max);
-
         if (cfg->list_count > 0)
-        {
-            SAVE_ALIGNOF(*cfg->list.i);
-        }
+            SAVE_ARRAY (cfg->list.i, cfg->list_count);
         else
-            SAVE_STRING(cfg->list_cb_name);
-
-        for (unsigned i = 0; i < cfg->list_count; i++)
-             SAVE_IMMEDIATE (cfg->list.i[i]);
+            cfg->list.i = NULL;
     }
-    for (unsigned i = 0; i < cfg->list_count; i++)
-        SAVE_STRING (cfg->list_text[i]);
+    SAVE_STRINGS (cfg->list_text, cfg->list_count);
 
+    /* Set when loading */
+    memset (&cfg->value, 0, sizeof (cfg->value));
+    cfg->owner = NULL;
     return 0;
 error:
     return -1;
 }
 
-static int CacheSaveModuleConfig(FILE *file, const vlc_plugin_t *plugin)
+static int CacheSaveModuleConfig(FILE *file, const vlc_plugin_t *plugin,
+                                 uint64_t *offset)
 {
-    uint16_t lines = plugin->conf.size;
+    size_t lines = plugin->conf.size;
+    module_config_t *items = NULL;
 
-    SAVE_IMMEDIATE (lines);
+    if (lines > 0)
+    {
+        items = vlc_alloc(lines, sizeof (*items));
+        if (unlikely(items == NULL))
+            return -1;
+        memcpy(items, plugin->conf.items, lines * sizeof (*items));
+    }
 
     for (size_t i = 0; i < lines; i++)
-        if (CacheSaveConfig(file, plugin->conf.items + i))
+        if (CacheSaveConfig(file, items + i))
            goto error;
 
+    module_config_t *tab = items;
+
+    SAVE_ARRAY(tab, lines);
+    *offset = (uintptr_t)tab;
+    free(items);
     return 0;
 error:
+    free(items);
     return -1;
 }
 
-static int CacheSaveModule(FILE *file, const module_t *module)
+static int CacheSaveModule(FILE *file, module_t *module)
 {
     SAVE_STRING(module->psz_shortname);
     SAVE_STRING(module->psz_longname);
     SAVE_STRING(module->psz_help);
-    SAVE_IMMEDIATE(module->i_shortcuts);
-
-    for (size_t j = 0; j < module->i_shortcuts; j++)
-         SAVE_STRING(module->pp_shortcuts[j]);
-
+    SAVE_STRINGS(module->pp_shortcuts, module->i_shortcuts);
     SAVE_STRING(module->activate_name);
     SAVE_STRING(module->deactivate_name);
     SAVE_STRING(module->psz_capability);
-    SAVE_IMMEDIATE(module->i_score);
+
+    /* Set when loading */
+    module->plugin = NULL;
+    module->next = NULL;
+    module->pf_activate = NULL;
+    module->pf_deactivate = NULL;
+    return 0;
+error:
+    return -1;
+}
+
+static int CacheSaveModules(FILE *file, const vlc_plugin_t *plugin,
+                            uint64_t *offset)
+{
+    size_t count = 0;
+    module_t *modules = vlc_alloc(plugin->modules_count, sizeof (*modules));
+
+    if (unlikely(modules == NULL) && plugin->modules_count > 0)
+        return -1;
+
+    for (const module_t *module = plugin->module;
+         module != NULL;
+         module = module->next)
+    {
+        assert(count < plugin->modules_count);
+        modules[count] = *module;
+        if (CacheSaveModule(file, modules + count))
+            goto error;
+        count++;
+    }
+
+    module_t *tab = modules;
+
+    SAVE_ARRAY(tab, count);
+    *offset = (uintptr_t)tab;
+    free(modules);
+    return 0;
+error:
+    free(modules);
+    return -1;
+}
+
+static int CacheSavePlugin(FILE *file, const vlc_plugin_t *plugin,
+                           struct vlc_cache_plugin *rec)
+{
+    const char *textdomain = plugin->textdomain;
+    const char *path = plugin->path;
+
+    if (CacheSaveModules(file, plugin, &rec->modules)
+     || CacheSaveModuleConfig(file, plugin, &rec->config))
+        goto error;
+
+    SAVE_STRING(textdomain);
+    SAVE_STRING(path);
+
+    rec->textdomain = (uintptr_t)textdomain;
+    rec->path = (uintptr_t)path;
+    rec->mtime = plugin->mtime;
+    rec->size = plugin->size;
+    rec->modules_count = plugin->modules_count;
+    rec->config_size = plugin->conf.size;
+    rec->unloadable = plugin->unloadable;
     return 0;
 error:
     return -1;
@@ -617,31 +685,40 @@ static int CacheSaveBank(FILE *file, vlc_plugin_t *const *cache, size_t n)
     if (fwrite (&i_file_size, sizeof (i_file_size), 1, file) != 1)
         goto error;
 
-    for (size_t i = 0; i < n; i++)
-    {
-        const vlc_plugin_t *plugin = cache[i];
-        uint32_t count = plugin->modules_count;
+    /* Plugins table, written last */
+    long table_pos = ftell(file);
+    uint64_t table = 0;
+    uint32_t count = n;
 
-        SAVE_IMMEDIATE(count);
+    SAVE_IMMEDIATE(table);
+    SAVE_IMMEDIATE(count);
 
-        for (module_t *module = plugin->module;
-             module != NULL;
-             module = module->next)
-            if (CacheSaveModule(file, module))
-                goto error;
+    struct vlc_cache_plugin *tab = vlc_alloc(n, sizeof (*tab));
+    if (unlikely(tab == NULL) && n > 0)
+        goto error;
 
-        /* Config stuff */
-        if (CacheSaveModuleConfig(file, plugin))
+    for (size_t i = 0; i < n; i++)
+    {
+        memset(tab + i, 0, sizeof (tab[i]));
+        if (CacheSavePlugin(file, cache[i], tab + i))
+        {
+            free(tab);
             goto error;
-
-        /* Save common info */
-        SAVE_STRING(plugin->textdomain);
-        SAVE_STRING(plugin->path);
-        SAVE_FLAG(plugin->unloadable);
-        SAVE_IMMEDIATE(plugin->mtime);
-        SAVE_IMMEDIATE(plugin->size);
+        }
     }
 
+    const struct vlc_cache_plugin *records = tab;
+    int val = CacheSaveArray(file, (const void **)&records, sizeof (*tab), n,
+                             alignof (*tab));
+    free(tab);
+    if (val)
+        goto error;
+
+    table = (uintptr_t)records;
+    if (fseek(file, table_pos, SEEK_SET))
+        goto error;
+    SAVE_IMMEDIATE(table);
+
     if (fflush (file)) /* flush libc buffers */
         goto error;
     return 0; /* success! */
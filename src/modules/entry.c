@@ -108,6 +108,7 @@ vlc_plugin_t *vlc_plugin_create(void)
     plugin->abspath = NULL;
     atomic_init(&plugin->loaded, false);
     plugin->unloadable = true;
+    plugin->cached = false;
     plugin->handle = NULL;
     plugin->abspath = NULL;
     plugin->path = NULL;
@@ -129,6 +130,22 @@ void vlc_plugin_destroy(vlc_plugin_t *plugin)
     assert(!plugin->unloadable || !atomic_load(&plugin->loaded));
 #endif
 
+#ifdef HAVE_DYNAMIC_PLUGINS
+    if (plugin->cached)
+    {   /* Only the option values are not in the plugins cache mapping */
+        for (size_t i = 0; i < plugin->conf.size; i++)
+        {
+            module_config_t *item = plugin->conf.items + i;
+
+            if (IsConfigStringType(item->i_type))
+                free(item->value.psz);
+        }
+        free(plugin->abspath);
+        free(plugin);
+        return;
+    }
+#endif
+
     if (plugin->module != NULL)
         vlc_module_destroy(plugin->module);
 
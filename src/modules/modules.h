@@ -52,6 +52,7 @@ typedef struct vlc_plugin_t
 #ifdef HAVE_DYNAMIC_PLUGINS
     atomic_bool loaded; /**< Whether the plug-in is mapped in memory */
     bool unloadable; /**< Whether the plug-in can be unloaded safely */
+    bool cached; /**< Whether the descriptors are in the plugins cache file */
     module_handle_t handle; /**< Run-time linker handle (if loaded) */
     char *abspath; /**< Absolute path */
 
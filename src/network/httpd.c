@@ -40,11 +40,15 @@
 #include <vlc_url.h>
 #include <vlc_mime.h>
 #include <vlc_block.h>
+#include <vlc_fs.h>
 #include "../libvlc.h"
 
 #include <string.h>
 #include <errno.h>
 #include <unistd.h>
+#ifndef _WIN32
+# include <fcntl.h>
+#endif
 #ifdef HAVE_SYS_UIO_H
 # include <sys/uio.h>
 #endif
@@ -86,6 +90,9 @@ struct httpd_host_t
     vlc_mutex_t lock;
     vlc_cond_t  wait;
 
+    /* pipe waking the thread up when streams get new data, if available */
+    int          wake[2];
+
     /* all registered url (becarefull that 2 httpd_url_t could point at the same url)
      * This will slow down the url research but make my live easier
      * All url will have their cb trigger, but only the first one can answer
@@ -128,6 +135,7 @@ enum
     HTTPD_CLIENT_SEND_DONE,
 
     HTTPD_CLIENT_WAITING,
+    HTTPD_CLIENT_STREAMING, /* sending directly from the stream buffer */
 
     HTTPD_CLIENT_DEAD,
 
@@ -146,6 +154,7 @@ struct httpd_client_t
 {
     httpd_url_t *url;
     vlc_tls_t   *sock;
+    httpd_stream_t *stream; /* stream sent without copy, or NULL */
 
     int     i_ref;
 
@@ -619,11 +628,58 @@ struct httpd_stream_t
     int64_t     i_buffer_pos;       /* absolute position from beginning */
     int64_t     i_buffer_last_pos;  /* a new connection will start with that */
 
+    /* clients are waiting for data, wake the host thread up on new data */
+    bool        b_wake;
+
     /* custom headers */
     size_t        i_http_headers;
     httpd_header * p_http_headers;
 };
 
+/**
+ * Gets the stream data available to a client, from its body offset, within
+ * the circular buffer. The stream lock must be held.
+ * \param iov the data, in up to two parts if the buffer wraps around [OUT]
+ * \return the number of parts, 0 if no data is available
+ */
+static unsigned httpd_StreamPeek(httpd_stream_t *stream, httpd_client_t *cl,
+                                 struct iovec iov[2])
+{
+    httpd_message_t *answer = &cl->answer;
+
+    if (answer->i_body_offset >= stream->i_buffer_pos)
+        return 0;    /* wait, no data available */
+
+    if (cl->i_keyframe_wait_to_pass >= 0) {
+        if (stream->i_last_keyframe_seen_pos <= cl->i_keyframe_wait_to_pass)
+            /* still waiting for the next keyframe */
+            return 0;
+
+        /* seek to the new keyframe */
+        answer->i_body_offset = stream->i_last_keyframe_seen_pos;
+        cl->i_keyframe_wait_to_pass = -1;
+    }
+
+    if (answer->i_body_offset + stream->i_buffer_size < stream->i_buffer_pos)
+        answer->i_body_offset = stream->i_buffer_last_pos; /* this client isn't fast enough */
+
+    int     i_pos = answer->i_body_offset % stream->i_buffer_size;
+    int64_t i_write = stream->i_buffer_pos - answer->i_body_offset;
+
+    if (i_write <= 0)
+        return 0;    /* wait, no data available */
+
+    /* Don't go past the end of the circular buffer */
+    iov[0].iov_base = &stream->p_buffer[i_pos];
+    iov[0].iov_len = __MIN(i_write, stream->i_buffer_size - i_pos);
+    if ((int64_t)iov[0].iov_len == i_write)
+        return 1;
+
+    iov[1].iov_base = stream->p_buffer;
+    iov[1].iov_len = i_write - iov[0].iov_len;
+    return 2;
+}
+
 static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
                                  httpd_client_t *cl, httpd_message_t *answer,
                                  const httpd_message_t *query)
@@ -634,34 +690,15 @@ static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
         return VLC_SUCCESS;
 
     if (answer->i_body_offset > 0) {
-        int     i_pos;
+        struct iovec iov[2];
 
-        if (answer->i_body_offset >= stream->i_buffer_pos)
+        vlc_mutex_lock(&stream->lock);
+        if (httpd_StreamPeek(stream, cl, iov) == 0) {
+            vlc_mutex_unlock(&stream->lock);
             return VLC_EGENERIC;    /* wait, no data available */
-
-        if (cl->i_keyframe_wait_to_pass >= 0) {
-            if (stream->i_last_keyframe_seen_pos <= cl->i_keyframe_wait_to_pass)
-                /* still waiting for the next keyframe */
-                return VLC_EGENERIC;
-
-            /* seek to the new keyframe */
-            answer->i_body_offset = stream->i_last_keyframe_seen_pos;
-            cl->i_keyframe_wait_to_pass = -1;
         }
 
-        if (answer->i_body_offset + stream->i_buffer_size < stream->i_buffer_pos)
-            answer->i_body_offset = stream->i_buffer_last_pos; /* this client isn't fast enough */
-
-        i_pos   = answer->i_body_offset % stream->i_buffer_size;
-        int64_t i_write = stream->i_buffer_pos - answer->i_body_offset;
-
-        if (i_write > HTTPD_CL_BUFSIZE)
-            i_write = HTTPD_CL_BUFSIZE;
-        else if (i_write <= 0)
-            return VLC_EGENERIC;    /* wait, no data available */
-
-        /* Don't go past the end of the circular buffer */
-        i_write = __MIN(i_write, stream->i_buffer_size - i_pos);
+        size_t i_write = __MIN(iov[0].iov_len, HTTPD_CL_BUFSIZE);
 
         /* using HTTPD_MSG_ANSWER -> data available */
         answer->i_proto  = HTTPD_PROTO_HTTP;
@@ -670,7 +707,8 @@ static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
 
         answer->i_body = i_write;
         answer->p_body = xmalloc(i_write);
-        memcpy(answer->p_body, &stream->p_buffer[i_pos], i_write);
+        memcpy(answer->p_body, iov[0].iov_base, i_write);
+        vlc_mutex_unlock(&stream->lock);
 
         answer->i_body_offset += i_write;
 
@@ -708,6 +746,7 @@ static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
                 memcpy(answer->p_body, stream->p_header, stream->i_header);
             }
             answer->i_body_offset = stream->i_buffer_last_pos;
+            cl->stream = stream; /* send the data without copying it */
             if (stream->b_has_keyframes)
                 cl->i_keyframe_wait_to_pass = stream->i_last_keyframe_seen_pos;
             else
@@ -778,6 +817,7 @@ httpd_stream_t *httpd_StreamNew(httpd_host_t *host,
     stream->i_buffer_last_pos = 1;
     stream->b_has_keyframes = false;
     stream->i_last_keyframe_seen_pos = 0;
+    stream->b_wake = false;
     stream->i_http_headers = 0;
     stream->p_http_headers = NULL;
 
@@ -842,6 +882,12 @@ int httpd_StreamSend(httpd_stream_t *stream, const block_t *p_block)
 
     httpd_AppendData(stream, p_block->p_buffer, p_block->i_buffer);
 
+    if (stream->b_wake) {
+        /* If the pipe is full, the host thread is woken up already */
+        vlc_write(stream->url->host->wake[1], &(char){ 0 }, 1);
+        stream->b_wake = false;
+    }
+
     vlc_mutex_unlock(&stream->lock);
     return VLC_SUCCESS;
 }
@@ -979,10 +1025,23 @@ static httpd_host_t *httpd_HostCreate(vlc_object_t *p_this,
     host->client   = NULL;
     host->p_tls    = p_tls;
 
+#ifndef _WIN32
+    if (vlc_pipe(host->wake) == 0)
+        for (unsigned i = 0; i < 2; i++)
+            fcntl(host->wake[i], F_SETFL,
+                  fcntl(host->wake[i], F_GETFL) | O_NONBLOCK);
+    else
+#endif
+        host->wake[0] = host->wake[1] = -1; /* poll waiting clients */
+
     /* create the thread */
     if (vlc_clone(&host->thread, httpd_HostThread, host,
                    VLC_THREAD_PRIORITY_LOW)) {
         msg_Err(p_this, "cannot spawn http host thread");
+        if (host->wake[0] != -1) {
+            vlc_close(host->wake[1]);
+            vlc_close(host->wake[0]);
+        }
         goto error;
     }
 
@@ -1045,6 +1104,10 @@ void httpd_HostDelete(httpd_host_t *host)
 
     vlc_tls_Delete(host->p_tls);
     net_ListenClose(host->fds);
+    if (host->wake[0] != -1) {
+        vlc_close(host->wake[1]);
+        vlc_close(host->wake[0]);
+    }
     vlc_cond_destroy(&host->wait);
     vlc_mutex_destroy(&host->lock);
     vlc_object_release(host);
@@ -1206,6 +1269,7 @@ static void httpd_ClientInit(httpd_client_t *cl, mtime_t now)
     cl->p_buffer = xmalloc(cl->i_buffer_size);
     cl->i_keyframe_wait_to_pass = -1;
     cl->b_stream_mode = false;
+    cl->stream = NULL;
 
     httpd_MsgInit(&cl->query);
     httpd_MsgInit(&cl->answer);
@@ -1606,6 +1670,13 @@ static void httpd_ClientSend(httpd_client_t *cl)
         cl->i_buffer += i_len;
 
         if (cl->i_buffer >= cl->i_buffer_size) {
+            if (cl->answer.i_body == 0 && cl->answer.i_body_offset > 0
+             && cl->stream != NULL) {
+                /* send the next data from the stream buffer */
+                cl->i_state = HTTPD_CLIENT_STREAMING;
+                return;
+            }
+
             if (cl->answer.i_body == 0  && cl->answer.i_body_offset > 0) {
                 /* catch more body data */
                 int     i_msg = cl->query.i_type;
@@ -1643,6 +1714,34 @@ static void httpd_ClientSend(httpd_client_t *cl)
     }
 }
 
+static void httpd_ClientStreamSend(httpd_client_t *cl)
+{
+    httpd_stream_t *stream = cl->stream;
+    struct iovec iov[2];
+    ssize_t val = 0;
+    bool b_again = false;
+
+    /* The socket is non-blocking: this only copies to the socket buffer */
+    vlc_mutex_lock(&stream->lock);
+    unsigned count = httpd_StreamPeek(stream, cl, iov);
+    if (count > 0) {
+        val = cl->sock->writev(cl->sock, iov, count);
+#if defined(_WIN32)
+        b_again = val < 0 && WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+        b_again = val < 0 && errno == EAGAIN;
+#endif
+    }
+    vlc_mutex_unlock(&stream->lock);
+
+    if (count == 0 || b_again)
+        return;
+    if (val > 0)
+        cl->answer.i_body_offset += val;
+    else
+        cl->i_state = HTTPD_CLIENT_DEAD;
+}
+
 static void httpd_ClientTlsHandshake(httpd_host_t *host, httpd_client_t *cl)
 {
     switch (vlc_tls_SessionHandshake(host->p_tls, cl->sock))
@@ -1696,13 +1795,18 @@ auth_failed:
 
 static void httpdLoop(httpd_host_t *host)
 {
-    struct pollfd ufd[host->nfd + host->i_client];
+    struct pollfd ufd[host->nfd + 1 + host->i_client];
     unsigned nfd;
     for (nfd = 0; nfd < host->nfd; nfd++) {
         ufd[nfd].fd = host->fds[nfd];
         ufd[nfd].events = POLLIN;
         ufd[nfd].revents = 0;
     }
+    /* wake up pipe (if any), after the listening sockets */
+    ufd[nfd].fd = host->wake[0];
+    ufd[nfd].events = POLLIN;
+    ufd[nfd].revents = 0;
+    nfd++;
 
     /* add all socket that should be read/write and close dead connection */
     while (host->i_url <= 0) {
@@ -1745,6 +1849,22 @@ static void httpdLoop(httpd_host_t *host)
                 pufd->events = POLLOUT;
                 break;
 
+            case HTTPD_CLIENT_STREAMING: {
+                httpd_stream_t *stream = cl->stream;
+                struct iovec iov[2];
+
+                vlc_mutex_lock(&stream->lock);
+                if (httpd_StreamPeek(stream, cl, iov) > 0)
+                    pufd->events = POLLOUT;
+                else if (host->wake[0] != -1) {
+                    /* wait for new data, without polling */
+                    stream->b_wake = true;
+                    pufd->events = POLLHUP; /* still detect disconnection */
+                }
+                vlc_mutex_unlock(&stream->lock);
+                break;
+            }
+
             case HTTPD_CLIENT_RECEIVE_DONE: {
                 httpd_message_t *answer = &cl->answer;
                 httpd_message_t *query  = &cl->query;
@@ -1971,9 +2091,15 @@ static void httpdLoop(httpd_host_t *host)
     canc = vlc_savecancel();
     vlc_mutex_lock(&host->lock);
 
+    /* Drain the wake up pipe */
+    if (ufd[host->nfd].revents) {
+        char buf[64];
+        while (read(host->wake[0], buf, sizeof (buf)) == sizeof (buf));
+    }
+
     /* Handle client sockets */
     now = mdate();
-    nfd = host->nfd;
+    nfd = host->nfd + 1;
 
     for (int i_client = 0; i_client < host->i_client; i_client++) {
         httpd_client_t *cl = host->client[i_client];
@@ -1992,6 +2118,12 @@ static void httpdLoop(httpd_host_t *host)
         switch (cl->i_state) {
             case HTTPD_CLIENT_RECEIVING: httpd_ClientRecv(cl); break;
             case HTTPD_CLIENT_SENDING:   httpd_ClientSend(cl); break;
+            case HTTPD_CLIENT_STREAMING:
+                if (pufd->revents & (POLLHUP|POLLERR))
+                    cl->i_state = HTTPD_CLIENT_DEAD;
+                else
+                    httpd_ClientStreamSend(cl);
+                break;
             case HTTPD_CLIENT_TLS_HS_IN:
             case HTTPD_CLIENT_TLS_HS_OUT:
                 httpd_ClientTlsHandshake(host, cl);
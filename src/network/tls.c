@@ -166,6 +166,122 @@ static void cleanup_tls(void *data)
     vlc_tls_SessionDelete (session);
 }
 
+/*** TLS session resumption cache ***/
+
+#define TLS_SESSION_CACHE_SIZE 32
+#define TLS_SESSION_CACHE_LIFETIME (CLOCK_FREQ * 3600)
+
+struct vlc_tls_session_entry
+{
+    struct vlc_tls_session_entry *next;
+    mtime_t date;
+    size_t len;
+    char host[];
+};
+
+static vlc_mutex_t session_cache_lock = VLC_STATIC_MUTEX;
+static struct vlc_tls_session_entry *session_cache = NULL;
+
+static inline void *vlc_tls_SessionEntryData(struct vlc_tls_session_entry *e)
+{
+    return e->host + strlen(e->host) + 1;
+}
+
+/* Unlinks the entry for host, and drops expired entries along the way.
+ * The list is kept most recently used first. */
+static struct vlc_tls_session_entry *vlc_tls_SessionCacheTake(const char *host)
+{
+    struct vlc_tls_session_entry **pp = &session_cache, *found = NULL;
+    const mtime_t now = mdate();
+
+    while (*pp != NULL)
+    {
+        struct vlc_tls_session_entry *e = *pp;
+
+        if (found == NULL && !strcmp(e->host, host))
+        {
+            *pp = e->next;
+            found = e;
+        }
+        else if (now - e->date > TLS_SESSION_CACHE_LIFETIME)
+        {
+            *pp = e->next;
+            free(e);
+        }
+        else
+            pp = &e->next;
+    }
+
+    if (found != NULL && now - found->date > TLS_SESSION_CACHE_LIFETIME)
+    {
+        free(found);
+        found = NULL;
+    }
+    return found;
+}
+
+void vlc_tls_SessionCacheStore(const char *host, const void *data, size_t len)
+{
+    if (host == NULL || len == 0)
+        return;
+
+    size_t hostlen = strlen(host) + 1;
+    struct vlc_tls_session_entry *e = malloc(sizeof (*e) + hostlen + len);
+    if (unlikely(e == NULL))
+        return;
+
+    e->date = mdate();
+    e->len = len;
+    memcpy(e->host, host, hostlen);
+    memcpy(vlc_tls_SessionEntryData(e), data, len);
+
+    vlc_mutex_lock(&session_cache_lock);
+    free(vlc_tls_SessionCacheTake(host));
+
+    e->next = session_cache;
+    session_cache = e;
+
+    /* Evict the least recently stored entries beyond the cache size */
+    struct vlc_tls_session_entry **pp = &e->next;
+    for (unsigned i = 1; *pp != NULL; i++)
+    {
+        if (i < TLS_SESSION_CACHE_SIZE)
+        {
+            pp = &(*pp)->next;
+            continue;
+        }
+        struct vlc_tls_session_entry *old = *pp;
+        *pp = old->next;
+        free(old);
+    }
+    vlc_mutex_unlock(&session_cache_lock);
+}
+
+void *vlc_tls_SessionCacheLoad(const char *host, size_t *restrict lenp)
+{
+    void *data = NULL;
+
+    if (host == NULL)
+        return NULL;
+
+    vlc_mutex_lock(&session_cache_lock);
+    struct vlc_tls_session_entry *e = vlc_tls_SessionCacheTake(host);
+    if (e != NULL)
+    {
+        data = malloc(e->len);
+        if (likely(data != NULL))
+        {
+            memcpy(data, vlc_tls_SessionEntryData(e), e->len);
+            *lenp = e->len;
+        }
+        /* Put it back in front */
+        e->next = session_cache;
+        session_cache = e;
+    }
+    vlc_mutex_unlock(&session_cache_lock);
+    return data;
+}
+
 #undef vlc_tls_ClientSessionCreate
 vlc_tls_t *vlc_tls_ClientSessionCreate(vlc_tls_creds_t *crd, vlc_tls_t *sock,
                                        const char *host, const char *service,
@@ -31,6 +31,7 @@
 #endif
 
 #include <vlc_common.h>
+#include <vlc_atomic.h>
 
 #include "libvlc.h"
 #include <stdarg.h>
@@ -907,6 +908,9 @@ void msleep (mtime_t delay)
 }
 
 /*** Timers ***/
+static atomic_uint timers_count = ATOMIC_VAR_INIT(0);
+static atomic_uint_fast64_t timers_fired = ATOMIC_VAR_INIT(0);
+
 struct vlc_timer
 {
     TID    tid;
@@ -932,6 +936,7 @@ static void vlc_timer_do (void *arg)
         if (timer->quit)
             break;
 
+        atomic_fetch_add_explicit (&timers_fired, 1, memory_order_relaxed);
         timer->func (timer->data);
 
         if (timer->interval)
@@ -954,6 +959,7 @@ int vlc_timer_create (vlc_timer_t *id, void (*func) (void *), void *data)
     timer->interval = 0;
     timer->quit = false;
     timer->tid  = _beginthread (vlc_timer_do, NULL, 1024 * 1024, timer);
+    atomic_fetch_add_explicit (&timers_count, 1, memory_order_relaxed);
 
     *id = timer;
     return 0;
@@ -968,6 +974,7 @@ void vlc_timer_destroy (vlc_timer_t timer)
     DosPostEventSem (timer->hev);
     DosWaitThread (&timer->tid, DCWW_WAIT);
     DosCloseEventSem (timer->hev);
+    atomic_fetch_sub_explicit (&timers_count, 1, memory_order_relaxed);
 
     free (timer);
 }
@@ -1001,6 +1008,15 @@ unsigned vlc_timer_getoverrun (vlc_timer_t timer)
     return 0;
 }
 
+void vlc_timer_getstats (vlc_timer_stats_t *stats)
+{
+    stats->timers = atomic_load_explicit (&timers_count, memory_order_relaxed);
+    stats->threads = stats->timers; /* one thread per timer */
+    stats->fired = atomic_load_explicit (&timers_fired, memory_order_relaxed);
+    stats->latency_avg = 0;
+    stats->latency_max = 0;
+}
+
 /*** CPU ***/
 unsigned vlc_GetCPUCount (void)
 {
@@ -196,8 +196,9 @@ playlist_t *playlist_Create( vlc_object_t *p_parent )
 
     p_playlist = &p->public_data;
 
-    p->input_tree = NULL;
-    p->id_tree = NULL;
+    playlist_IndexInit( &p->input_index );
+    playlist_IndexInit( &p->id_index );
+    playlist_LiveSearchInit( p_playlist );
 
     TAB_INIT( pl_priv(p_playlist)->i_sds, pl_priv(p_playlist)->pp_sds );
 
@@ -209,6 +210,9 @@ playlist_t *playlist_Create( vlc_object_t *p_parent )
     /* Initialise data structures */
     pl_priv(p_playlist)->i_last_playlist_id = 0;
     pl_priv(p_playlist)->p_input = NULL;
+    pl_priv(p_playlist)->p_preroll = NULL;
+    pl_priv(p_playlist)->batch.depth = 0;
+    pl_priv(p_playlist)->batch.p_node = NULL;
 
     ARRAY_INIT( p_playlist->items );
     ARRAY_INIT( p_playlist->current );
@@ -311,6 +315,7 @@ void playlist_Destroy( playlist_t *p_playlist )
 
     /* Release input resources */
     assert( p_sys->p_input == NULL );
+    assert( p_sys->p_preroll == NULL );
     input_resource_Release( p_sys->p_input_resource );
     if( p_sys->p_renderer )
         vlc_renderer_item_release( p_sys->p_renderer );
@@ -339,6 +344,9 @@ void playlist_Destroy( playlist_t *p_playlist )
         PLAYLIST_DELETE_FORCE );
 
     assert( p_playlist->root.i_children <= 0 );
+    playlist_IndexClean( &p_sys->input_index );
+    playlist_IndexClean( &p_sys->id_index );
+    playlist_LiveSearchDestroy( p_playlist );
     PL_UNLOCK;
 
     vlc_cond_destroy( &p_sys->signal );
@@ -422,6 +430,7 @@ static void VariablesInit( playlist_t *p_playlist )
 
     var_Create( p_playlist, "playlist-item-append", VLC_VAR_ADDRESS );
     var_Create( p_playlist, "playlist-item-deleted", VLC_VAR_ADDRESS );
+    var_Create( p_playlist, "playlist-batch", VLC_VAR_ADDRESS );
 
     var_Create( p_playlist, "input-current", VLC_VAR_ADDRESS );
 
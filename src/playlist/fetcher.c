@@ -23,7 +23,13 @@
 # include "config.h"
 #endif
 
+#include <errno.h>
+#include <time.h>
+#include <sys/stat.h>
+
 #include <vlc_common.h>
+#include <vlc_configuration.h>
+#include <vlc_fs.h>
 #include <vlc_stream.h>
 #include <vlc_modules.h>
 #include <vlc_interrupt.h>
@@ -32,6 +38,7 @@
 #include <vlc_threads.h>
 #include <vlc_memstream.h>
 #include <vlc_meta_fetcher.h>
+#include <vlc_url.h>
 
 #include "art.h"
 #include "libvlc.h"
@@ -45,11 +52,25 @@ struct playlist_fetcher_t {
     struct background_worker* network;
     struct background_worker* downloader;
 
-    vlc_dictionary_t album_cache;
+    vlc_dictionary_t album_cache; /**< artist and album to cache entry */
+    vlc_dictionary_t uri_cache; /**< item URI to cache entry */
+    bool cache_dirty;
     vlc_object_t* owner;
     vlc_mutex_t lock;
 };
 
+/* The album and item caches are kept on disk across runs, including the
+ * failed network searches, which are not tried again for a while unless
+ * explicitly requested. */
+struct fetcher_cache_entry {
+    char* art; /**< art URL, or NULL if none was found */
+    time_t date; /**< last search */
+    uint32_t fingerprint; /**< item meta at the time of the search */
+};
+
+#define FETCHER_CACHE_RETRY (7 * 24 * 60 * 60) /* seconds */
+#define FETCHER_CACHE_HEADER "VLC art cache index 1\n"
+
 struct fetcher_request {
     input_item_t* item;
     atomic_uint refs;
@@ -99,47 +120,331 @@ static char* CreateCacheKey( input_item_t* item )
 
 static void FreeCacheEntry( void* data, void* obj )
 {
-    free( data );
+    struct fetcher_cache_entry* entry = data;
+
+    free( entry->art );
+    free( entry );
     VLC_UNUSED( obj );
 }
 
-static int ReadAlbumCache( playlist_fetcher_t* fetcher, input_item_t* item )
+/**
+ * Hashes the item meta used to search the art (FNV-1a)
+ */
+static uint32_t CacheFingerprint( input_item_t* item )
+{
+    uint32_t hash = 2166136261u;
+    vlc_meta_type_t types[] = { vlc_meta_Title, vlc_meta_Artist,
+                                vlc_meta_Album };
+
+    vlc_mutex_lock( &item->lock );
+    for( size_t i = 0; item->p_meta && i < ARRAY_SIZE( types ); i++ )
+    {
+        const char* psz = vlc_meta_Get( item->p_meta, types[i] );
+
+        for( ; psz != NULL && *psz; psz++ )
+            hash = (hash ^ (unsigned char)*psz) * 16777619u;
+        hash = (hash ^ 0xFF) * 16777619u;
+    }
+    vlc_mutex_unlock( &item->lock );
+    return hash;
+}
+
+static void CacheStore( playlist_fetcher_t* fetcher, vlc_dictionary_t* dict,
+                        const char* key, struct fetcher_cache_entry* entry )
 {
+    vlc_dictionary_remove_value_for_key( dict, key, FreeCacheEntry, NULL );
+    vlc_dictionary_insert( dict, key, entry );
+    fetcher->cache_dirty = true;
+}
+
+/**
+ * Checks that a cached art file was not removed meanwhile
+ */
+static bool CacheArtExists( const char* art )
+{
+    if( strncasecmp( art, "file://", 7 ) )
+        return true;
+
+    char* path = vlc_uri2path( art );
+    struct stat st;
+    bool ok = path != NULL && vlc_stat( path, &st ) == 0;
+
+    free( path );
+    return ok;
+}
+
+/**
+ * Finds the cache entry of an item, by album, or else by URI.
+ * The fetcher lock must be held.
+ */
+static struct fetcher_cache_entry* CacheFind( playlist_fetcher_t* fetcher,
+                                              input_item_t* item )
+{
+    struct fetcher_cache_entry* album = NULL, *entry = NULL;
     char* key = CreateCacheKey( item );
 
-    if( key == NULL )
-        return VLC_EGENERIC;
+    if( key != NULL )
+    {
+        album = vlc_dictionary_value_for_key( &fetcher->album_cache, key );
+        free( key );
+        if( album != NULL && album->art != NULL )
+            return album;
+    }
+
+    char* uri = input_item_GetURI( item );
+    if( uri != NULL )
+    {
+        entry = vlc_dictionary_value_for_key( &fetcher->uri_cache, uri );
+        if( entry != NULL && entry->fingerprint != CacheFingerprint( item ) )
+            entry = NULL; /* meta changed since */
+        free( uri );
+    }
+    return ( entry != NULL && entry->art != NULL ) ? entry
+         : ( album != NULL ) ? album : entry;
+}
 
+static int ReadAlbumCache( playlist_fetcher_t* fetcher, input_item_t* item )
+{
     vlc_mutex_lock( &fetcher->lock );
-    char const* art = vlc_dictionary_value_for_key( &fetcher->album_cache,
-                                                    key );
+    struct fetcher_cache_entry* entry = CacheFind( fetcher, item );
+    char* art = (entry != NULL && entry->art != NULL) ? strdup( entry->art )
+                                                      : NULL;
+    vlc_mutex_unlock( &fetcher->lock );
+
+    if( art != NULL && !CacheArtExists( art ) )
+        FREENULL( art );
     if( art )
         input_item_SetArtURL( item, art );
+
+    free( art );
+    return art ? VLC_SUCCESS : VLC_EGENERIC;
+}
+
+/**
+ * Checks whether a network search failed recently for the item
+ */
+static bool ReadNotFoundCache( playlist_fetcher_t* fetcher,
+                               input_item_t* item )
+{
+    vlc_mutex_lock( &fetcher->lock );
+    struct fetcher_cache_entry* entry = CacheFind( fetcher, item );
+    bool not_found = entry != NULL && entry->art == NULL
+                  && time( NULL ) - entry->date < FETCHER_CACHE_RETRY;
     vlc_mutex_unlock( &fetcher->lock );
 
+    return not_found;
+}
+
+static struct fetcher_cache_entry* CacheEntryNew( const char* art,
+                                                  uint32_t fingerprint )
+{
+    struct fetcher_cache_entry* entry = malloc( sizeof( *entry ) );
+
+    if( unlikely( !entry ) )
+        return NULL;
+
+    entry->art = art ? strdup( art ) : NULL;
+    entry->date = time( NULL );
+    entry->fingerprint = fingerprint;
+
+    if( unlikely( art && !entry->art ) )
+    {
+        free( entry );
+        return NULL;
+    }
+    return entry;
+}
+
+/**
+ * Stores the art of an item, or NULL if none was found
+ */
+static void AddCache( playlist_fetcher_t* fetcher, input_item_t* item,
+                      const char* art, bool overwrite )
+{
+    char* key = CreateCacheKey( item );
+    char* uri = input_item_GetURI( item );
+    uint32_t fingerprint = CacheFingerprint( item );
+
+    vlc_mutex_lock( &fetcher->lock );
+    if( key && ( overwrite ||
+                 !vlc_dictionary_has_key( &fetcher->album_cache, key ) ) )
+    {
+        struct fetcher_cache_entry* entry = CacheEntryNew( art, 0 );
+        if( entry )
+            CacheStore( fetcher, &fetcher->album_cache, key, entry );
+    }
+    if( uri && ( overwrite ||
+                 !vlc_dictionary_has_key( &fetcher->uri_cache, uri ) ) )
+    {
+        struct fetcher_cache_entry* entry = CacheEntryNew( art, fingerprint );
+        if( entry )
+            CacheStore( fetcher, &fetcher->uri_cache, uri, entry );
+    }
+    vlc_mutex_unlock( &fetcher->lock );
+
+    free( uri );
     free( key );
-    return art ? VLC_SUCCESS : VLC_EGENERIC;
 }
 
 static void AddAlbumCache( playlist_fetcher_t* fetcher, input_item_t* item,
                           bool overwrite )
 {
     char* art = input_item_GetArtURL( item );
-    char* key = CreateCacheKey( item );
 
-    if( key && art && strncasecmp( art, "attachment://", 13 ) )
+    if( art && strncasecmp( art, "attachment://", 13 ) )
+        AddCache( fetcher, item, art, overwrite );
+
+    free( art );
+}
+
+static char* CacheIndexPath( void )
+{
+    char* dir = config_GetUserDir( VLC_CACHE_DIR );
+    char* path;
+
+    if( dir == NULL
+     || asprintf( &path, "%s" DIR_SEP "art" DIR_SEP "index", dir ) == -1 )
+        path = NULL;
+    free( dir );
+    return path;
+}
+
+/* Each entry is a line: "<type> <date> <fingerprint> <key length>
+ * <art length> <key><art>", where type is A for albums and U for URIs,
+ * and the art length is -1 if no art was found. */
+static void CacheIndexLoad( playlist_fetcher_t* fetcher )
+{
+    char* path = CacheIndexPath();
+    FILE* file = path ? vlc_fopen( path, "rb" ) : NULL;
+
+    free( path );
+    if( file == NULL )
+        return;
+
+    char header[sizeof( FETCHER_CACHE_HEADER )];
+    time_t now = time( NULL );
+
+    if( fgets( header, sizeof( header ), file ) == NULL
+     || strcmp( header, FETCHER_CACHE_HEADER ) )
+        goto out;
+
+    for( ;; )
+    {
+        char type;
+        long long date;
+        uint32_t fingerprint;
+        int key_len, art_len;
+
+        if( fscanf( file, "%c %lld %"SCNx32" %d %d", &type, &date,
+                    &fingerprint, &key_len, &art_len ) != 5
+         || fgetc( file ) != ' '
+         || key_len < 0 || key_len > 65536 || art_len < -1
+         || art_len > 65536 || ( type != 'A' && type != 'U' ) )
+            break;
+
+        char* key = malloc( key_len + 1 );
+        char* art = art_len >= 0 ? malloc( art_len + 1 ) : NULL;
+
+        if( unlikely( key == NULL || ( art_len >= 0 && art == NULL ) )
+         || fread( key, 1, key_len, file ) != (size_t)key_len
+         || ( art && fread( art, 1, art_len, file ) != (size_t)art_len )
+         || fgetc( file ) != '\n' )
+        {
+            free( key );
+            free( art );
+            break;
+        }
+        key[key_len] = '\0';
+        if( art )
+            art[art_len] = '\0';
+
+        struct fetcher_cache_entry* entry = NULL;
+
+        /* Drop the expired failures */
+        if( art != NULL || now - date < FETCHER_CACHE_RETRY )
+            entry = malloc( sizeof( *entry ) );
+
+        if( entry != NULL )
+        {
+            entry->art = art;
+            entry->date = date;
+            entry->fingerprint = fingerprint;
+            vlc_dictionary_t* dict = ( type == 'A' ) ? &fetcher->album_cache
+                                                     : &fetcher->uri_cache;
+            vlc_dictionary_remove_value_for_key( dict, key, FreeCacheEntry,
+                                                 NULL );
+            vlc_dictionary_insert( dict, key, entry );
+        }
+        else
+            free( art );
+        free( key );
+    }
+out:
+    fclose( file );
+}
+
+static void CacheIndexSaveDict( FILE* file, const vlc_dictionary_t* dict,
+                                char type )
+{
+    for( int i = 0; dict->p_entries && i < dict->i_size; i++ )
+        for( const vlc_dictionary_entry_t* e = dict->p_entries[i]; e;
+             e = e->p_next )
+        {
+            const struct fetcher_cache_entry* entry = e->p_value;
+
+            fprintf( file, "%c %lld %"PRIx32" %zu %d %s%s\n", type,
+                     (long long)entry->date, entry->fingerprint,
+                     strlen( e->psz_key ),
+                     entry->art ? (int)strlen( entry->art ) : -1,
+                     e->psz_key, entry->art ? entry->art : "" );
+        }
+}
+
+static void CacheIndexSave( playlist_fetcher_t* fetcher )
+{
+    if( !fetcher->cache_dirty )
+        return;
+
+    char* path = CacheIndexPath();
+    char* tmp;
+
+    if( path == NULL || asprintf( &tmp, "%s.tmp", path ) == -1 )
     {
-        vlc_mutex_lock( &fetcher->lock );
-        if( overwrite || !vlc_dictionary_has_key( &fetcher->album_cache, key ) )
+        free( path );
+        return;
+    }
+
+    char* dir = config_GetUserDir( VLC_CACHE_DIR );
+    if( dir != NULL )
+    {
+        char* artdir;
+        if( asprintf( &artdir, "%s" DIR_SEP "art", dir ) != -1 )
         {
-            vlc_dictionary_insert( &fetcher->album_cache, key, art );
-            art = NULL;
+            vlc_mkdir( dir, 0700 );
+            vlc_mkdir( artdir, 0700 );
+            free( artdir );
         }
-        vlc_mutex_unlock( &fetcher->lock );
+        free( dir );
     }
 
-    free( art );
-    free( key );
+    FILE* file = vlc_fopen( tmp, "wb" );
+    if( file != NULL )
+    {
+        fputs( FETCHER_CACHE_HEADER, file );
+        CacheIndexSaveDict( file, &fetcher->album_cache, 'A' );
+        CacheIndexSaveDict( file, &fetcher->uri_cache, 'U' );
+
+        if( ferror( file ) | fclose( file ) )
+        {
+            msg_Warn( fetcher->owner, "cannot write %s: %s", tmp,
+                      vlc_strerror_c( errno ) );
+            vlc_unlink( tmp );
+        }
+        else if( vlc_rename( tmp, path ) ) /* atomically replace the index */
+            vlc_unlink( tmp );
+    }
+    free( tmp );
+    free( path );
 }
 
 static int InvokeModule( playlist_fetcher_t* fetcher, input_item_t* item,
@@ -194,7 +499,10 @@ static int SearchByScope( playlist_fetcher_t* fetcher,
 {
     input_item_t* item = req->item;
 
-    if( CheckMeta( item ) &&
+    /* The art found by a previous search needs no meta fetcher */
+    bool cached = CheckArt( item ) && !ReadAlbumCache( fetcher, item );
+
+    if( !cached && CheckMeta( item ) &&
         InvokeModule( fetcher, req->item, scope, "meta fetcher" ) )
     {
         return VLC_EGENERIC;
@@ -294,8 +602,9 @@ static void SearchLocal( playlist_fetcher_t* fetcher, struct fetcher_request* re
     if( SearchByScope( fetcher, req, FETCHER_SCOPE_LOCAL ) == VLC_SUCCESS )
         return; /* done */
 
-    if( var_InheritBool( fetcher->owner, "metadata-network-access" ) ||
-        req->options & META_REQUEST_OPTION_SCOPE_NETWORK )
+    if( req->options & META_REQUEST_OPTION_SCOPE_NETWORK ||
+        ( var_InheritBool( fetcher->owner, "metadata-network-access" ) &&
+          !ReadNotFoundCache( fetcher, req->item ) ) )
     {
         if( background_worker_Push( fetcher->network, req, NULL, 0 ) )
             SetPreparsed( req );
@@ -311,6 +620,8 @@ static void SearchNetwork( playlist_fetcher_t* fetcher, struct fetcher_request*
 {
     if( SearchByScope( fetcher, req, FETCHER_SCOPE_NETWORK ) )
     {
+        if( !vlc_killed() )
+            AddCache( fetcher, req->item, NULL, true );
         input_item_SetArtNotFound( req->item, true );
         SetPreparsed( req );
     }
@@ -404,6 +715,7 @@ static void WorkerInit( playlist_fetcher_t* fetcher,
 {
     struct background_worker_config conf = {
         .default_timeout = 0,
+        .max_threads = 1,
         .pf_start = starter,
         .pf_probe = ProbeWorker,
         .pf_stop = CloseWorker,
@@ -443,6 +755,9 @@ playlist_fetcher_t* playlist_fetcher_New( vlc_object_t* owner )
 
     vlc_mutex_init( &fetcher->lock );
     vlc_dictionary_init( &fetcher->album_cache, 0 );
+    vlc_dictionary_init( &fetcher->uri_cache, 0 );
+    fetcher->cache_dirty = false;
+    CacheIndexLoad( fetcher );
 
     return fetcher;
 }
@@ -475,7 +790,9 @@ void playlist_fetcher_Delete( playlist_fetcher_t* fetcher )
     background_worker_Delete( fetcher->network );
     background_worker_Delete( fetcher->downloader );
 
+    CacheIndexSave( fetcher );
     vlc_dictionary_clear( &fetcher->album_cache, FreeCacheEntry, NULL );
+    vlc_dictionary_clear( &fetcher->uri_cache, FreeCacheEntry, NULL );
     vlc_mutex_destroy( &fetcher->lock );
 
     free( fetcher );
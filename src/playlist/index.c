@@ -0,0 +1,151 @@
+/*****************************************************************************
+ * index.c : hash index of playlist items
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_playlist.h>
+#include "playlist_internal.h"
+
+/* Open addressing with linear probing. Removed entries leave a tombstone
+ * until the table is rebuilt. */
+#define PL_INDEX_MIN 64
+#define PL_INDEX_REMOVED ((playlist_item_t *)(uintptr_t)1)
+
+static size_t playlist_IndexHash( uintptr_t key, size_t mask )
+{
+    uint64_t h = (uint64_t)key * UINT64_C(0x9E3779B97F4A7C15);
+    return (h ^ (h >> 29)) & mask;
+}
+
+void playlist_IndexInit( playlist_index_t *idx )
+{
+    idx->mask = 0;
+    idx->count = 0;
+    idx->used = 0;
+    idx->slots = NULL;
+}
+
+void playlist_IndexClean( playlist_index_t *idx )
+{
+    free( idx->slots );
+    playlist_IndexInit( idx );
+}
+
+playlist_item_t *playlist_IndexFind( const playlist_index_t *idx,
+                                     uintptr_t key )
+{
+    if( idx->slots == NULL )
+        return NULL;
+
+    for( size_t i = playlist_IndexHash( key, idx->mask );;
+         i = (i + 1) & idx->mask )
+    {
+        const struct playlist_index_slot *slot = &idx->slots[i];
+
+        if( slot->item == NULL )
+            return NULL;
+        if( slot->item != PL_INDEX_REMOVED && slot->key == key )
+            return slot->item;
+    }
+}
+
+static int playlist_IndexResize( playlist_index_t *idx )
+{
+    size_t size = PL_INDEX_MIN;
+
+    /* Keep the load under one half once rebuilt */
+    while( size < 4 * idx->count )
+        size *= 2;
+
+    struct playlist_index_slot *slots = calloc( size, sizeof (*slots) );
+    if( unlikely(slots == NULL) )
+        return VLC_ENOMEM;
+
+    for( size_t i = 0; idx->slots != NULL && i <= idx->mask; i++ )
+    {
+        const struct playlist_index_slot *old = &idx->slots[i];
+
+        if( old->item == NULL || old->item == PL_INDEX_REMOVED )
+            continue;
+
+        size_t j = playlist_IndexHash( old->key, size - 1 );
+        while( slots[j].item != NULL )
+            j = (j + 1) & (size - 1);
+        slots[j] = *old;
+    }
+
+    free( idx->slots );
+    idx->slots = slots;
+    idx->mask = size - 1;
+    idx->used = idx->count;
+    return VLC_SUCCESS;
+}
+
+int playlist_IndexAdd( playlist_index_t *idx, uintptr_t key,
+                       playlist_item_t *item )
+{
+    assert( item != NULL && item != PL_INDEX_REMOVED );
+    assert( playlist_IndexFind( idx, key ) == NULL );
+
+    if( (idx->used + 1) * 4 > (idx->mask + 1) * 3 || idx->slots == NULL )
+        if( playlist_IndexResize( idx ) )
+            return VLC_ENOMEM;
+
+    size_t i = playlist_IndexHash( key, idx->mask );
+    while( idx->slots[i].item != NULL
+        && idx->slots[i].item != PL_INDEX_REMOVED )
+        i = (i + 1) & idx->mask;
+
+    if( idx->slots[i].item == NULL )
+        idx->used++;
+    idx->slots[i].key = key;
+    idx->slots[i].item = item;
+    idx->count++;
+    return VLC_SUCCESS;
+}
+
+void playlist_IndexRemove( playlist_index_t *idx, uintptr_t key )
+{
+    if( idx->slots == NULL )
+        return;
+
+    for( size_t i = playlist_IndexHash( key, idx->mask );;
+         i = (i + 1) & idx->mask )
+    {
+        struct playlist_index_slot *slot = &idx->slots[i];
+
+        if( slot->item == NULL )
+            return;
+        if( slot->item != PL_INDEX_REMOVED && slot->key == key )
+        {
+            slot->item = PL_INDEX_REMOVED;
+            idx->count--;
+            break;
+        }
+    }
+
+    if( idx->count == 0 )
+        playlist_IndexClean( idx );
+}
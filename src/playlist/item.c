@@ -27,9 +27,6 @@
 
 #include <assert.h>
 #include <limits.h>
-#ifdef HAVE_SEARCH_H
-# include <search.h>
-#endif
 
 #include <vlc_common.h>
 #include <vlc_playlist.h>
@@ -41,8 +38,9 @@ static void ChangeToNode( playlist_t *p_playlist, playlist_item_t *p_item );
 
 static int RecursiveAddIntoParent (
                 playlist_t *p_playlist, playlist_item_t *p_parent,
-                input_item_node_t *p_node, int i_pos, bool b_flat,
-                playlist_item_t **pp_first_leaf );
+                input_item_node_t *p_node, int i_start, int i_end,
+                int i_pos, bool b_flat, playlist_item_t **pp_first_leaf,
+                unsigned *pi_preparse );
 static int RecursiveInsertCopy (
                 playlist_t *p_playlist, playlist_item_t *p_item,
                 playlist_item_t *p_parent, int i_pos, bool b_flat );
@@ -136,11 +134,23 @@ static void input_item_add_subitem_tree ( const vlc_event_t * p_event,
     "p_item" is the node where sub-items should be inserted,
     "pos" is the insertion position in that node */
 
-    int last_pos = playlist_InsertInputItemTree( p_playlist,
-                                                 p_item,
-                                                 p_new_root,
-                                                 pos,
-                                                 b_flat );
+    /* Large trees, e.g. long M3U or XSPF playlists, are inserted by batches
+     * of sub-trees. The playlist is unlocked between the batches, so that
+     * the interfaces are not blocked meanwhile. Only the first items are
+     * preparsed at once: the others are preparsed once about to be played,
+     * see playlist_PreparseAhead(). The interfaces are notified once. */
+    bool b_batch = p_new_root->i_children > PLAYLIST_INSERT_BATCH;
+    if( b_batch )
+        playlist_BeginBatch( p_playlist, p_item );
+
+    unsigned i_preparse = PLAYLIST_PREPARSE_AHEAD;
+    input_item_t *p_node_input = p_item->p_input;
+    int last_pos = RecursiveAddIntoParent( p_playlist, p_item, p_new_root,
+        0, __MIN( p_new_root->i_children, PLAYLIST_INSERT_BATCH ), pos,
+        b_flat, &(playlist_item_t *){ NULL }, &i_preparse );
+    playlist_item_t *p_first = (last_pos > pos) ? p_item->pp_children[pos]
+                                                : NULL;
+
     if( b_redirect_request )
     {
         /* a redirect of the pending request is required, as such we update the
@@ -158,6 +168,61 @@ static void input_item_add_subitem_tree ( const vlc_event_t * p_event,
         p_sys->request.p_node = NULL;
     }
 
+    if( b_batch )
+    {
+        input_item_Hold( p_node_input );
+
+        for( int i = PLAYLIST_INSERT_BATCH; i < p_new_root->i_children;
+             i += PLAYLIST_INSERT_BATCH )
+        {
+            playlist_item_t *p_last = (last_pos > 0)
+                                    ? p_item->pp_children[last_pos - 1] : NULL;
+            PL_UNLOCK;
+            PL_LOCK;
+
+            /* Find the insertion point again */
+            p_item = playlist_ItemGetByInput( p_playlist, p_node_input );
+            if( p_item == NULL || p_item->i_children < 0 )
+                break;
+
+            if( last_pos > p_item->i_children
+             || (last_pos > 0 && p_item->pp_children[last_pos - 1] != p_last) )
+            {
+                int idx;
+
+                TAB_FIND( p_item->i_children, p_item->pp_children, p_last,
+                          idx );
+                last_pos = (idx >= 0) ? idx + 1 : p_item->i_children;
+            }
+
+            last_pos = RecursiveAddIntoParent( p_playlist, p_item, p_new_root,
+                i, __MIN( p_new_root->i_children, i + PLAYLIST_INSERT_BATCH ),
+                last_pos, b_flat, &(playlist_item_t *){ NULL }, &i_preparse );
+        }
+
+        input_item_Release( p_node_input );
+        playlist_EndBatch( p_playlist );
+
+        if( p_item == NULL )
+        {   /* The node was deleted meanwhile */
+            PL_UNLOCK;
+            return;
+        }
+        if( p_item->i_children < 0 )
+            p_first = NULL;
+
+        /* The position of the first new item may have changed too */
+        if( p_first != NULL && ( pos >= p_item->i_children
+                              || p_item->pp_children[pos] != p_first ) )
+        {
+            TAB_FIND( p_item->i_children, p_item->pp_children, p_first, pos );
+            if( pos < 0 )
+                p_first = NULL;
+        }
+        if( p_first == NULL )
+            pos = last_pos = 0;
+    }
+
     if( !b_flat ) var_SetInteger( p_playlist, "leaf-to-parent", p_item->i_id );
 
     //control playback only if it was the current playing item that got subitems
@@ -230,27 +295,10 @@ static void input_item_changed( const vlc_event_t * p_event,
 {
     playlist_t *p_playlist = user_data;
 
+    playlist_LiveSearchInvalidate( p_playlist );
     var_SetAddress( p_playlist, "item-change", p_event->p_obj );
 }
 
-static int playlist_ItemCmpId( const void *a, const void *b )
-{
-    const playlist_item_t *pa = a, *pb = b;
-
-    /* ID are between 1 and INT_MAX, this cannot overflow. */
-    return pa->i_id - pb->i_id;
-}
-
-static int playlist_ItemCmpInput( const void *a, const void *b )
-{
-    const playlist_item_t *pa = a, *pb = b;
-
-    if( pa->p_input == pb->p_input )
-        return 0;
-    return (((uintptr_t)pa->p_input) > ((uintptr_t)pb->p_input))
-        ? +1 : -1;
-}
-
 /*****************************************************************************
  * Playlist item creation
  *****************************************************************************/
@@ -258,7 +306,7 @@ playlist_item_t *playlist_ItemNewFromInput( playlist_t *p_playlist,
                                               input_item_t *p_input )
 {
     playlist_private_t *p = pl_priv(p_playlist);
-    playlist_item_t **pp, *p_item;
+    playlist_item_t *p_item;
 
     p_item = malloc( sizeof( playlist_item_t ) );
     if( unlikely(p_item == NULL) )
@@ -285,27 +333,25 @@ playlist_item_t *playlist_ItemNewFromInput( playlist_t *p_playlist,
 
         if( unlikely(p_item->i_id == p->i_last_playlist_id) )
             goto error; /* All IDs taken */
- 
-        pp = tsearch( p_item, &p->id_tree, playlist_ItemCmpId );
-        if( unlikely(pp == NULL) )
-            goto error;
-
-        assert( (*pp)->i_id == p_item->i_id );
-        assert( (*pp) == p_item || (*pp)->p_input != p_input );
     }
-    while( p_item != *pp );
+    while( playlist_IndexFind( &p->id_index, p_item->i_id ) != NULL );
 
-    pp = tsearch( p_item, &p->input_tree, playlist_ItemCmpInput );
-    if( unlikely(pp == NULL) )
+    if( unlikely(playlist_IndexAdd( &p->id_index, p_item->i_id, p_item )) )
+        goto error;
+
+    /* Same input item cannot be inserted twice. */
+    assert( playlist_IndexFind( &p->input_index,
+                                (uintptr_t)p_input ) == NULL );
+    if( unlikely(playlist_IndexAdd( &p->input_index, (uintptr_t)p_input,
+                                    p_item )) )
     {
-        tdelete( p_item, &p->id_tree, playlist_ItemCmpId );
+        playlist_IndexRemove( &p->id_index, p_item->i_id );
         goto error;
     }
-    /* Same input item cannot be inserted twice. */
-    assert( p_item == *pp );
 
     p->i_last_playlist_id = p_item->i_id;
     input_item_Hold( p_item->p_input );
+    playlist_LiveSearchInvalidate( p_playlist );
 
     vlc_event_manager_t *p_em = &p_item->p_input->event_manager;
 
@@ -361,8 +407,9 @@ void playlist_ItemRelease( playlist_t *p_playlist, playlist_item_t *p_item )
 
     input_item_Release( p_item->p_input );
 
-    tdelete( p_item, &p->input_tree, playlist_ItemCmpInput );
-    tdelete( p_item, &p->id_tree, playlist_ItemCmpId );
+    playlist_IndexRemove( &p->input_index, (uintptr_t)p_item->p_input );
+    playlist_IndexRemove( &p->id_index, p_item->i_id );
+    playlist_LiveSearchInvalidate( p_playlist );
     free( p_item->pp_children );
     free( p_item );
 }
@@ -388,12 +435,9 @@ void playlist_ItemRelease( playlist_t *p_playlist, playlist_item_t *p_item )
 playlist_item_t *playlist_ItemGetById( playlist_t *p_playlist , int id )
 {
     playlist_private_t *p = pl_priv(p_playlist);
-    playlist_item_t key, **pp;
 
     PL_ASSERT_LOCKED;
-    key.i_id = id;
-    pp = tfind( &key, &p->id_tree, playlist_ItemCmpId );
-    return (pp != NULL) ? *pp : NULL;
+    return playlist_IndexFind( &p->id_index, id );
 }
 
 /**
@@ -412,12 +456,9 @@ playlist_item_t *playlist_ItemGetByInput( playlist_t * p_playlist,
                                           const input_item_t *item )
 {
     playlist_private_t *p = pl_priv(p_playlist);
-    playlist_item_t key, **pp;
 
     PL_ASSERT_LOCKED;
-    key.p_input = (input_item_t *)item;
-    pp = tfind( &key, &p->input_tree, playlist_ItemCmpInput );
-    return (pp != NULL) ? *pp : NULL;
+    return playlist_IndexFind( &p->input_index, (uintptr_t)item );
 }
 
 /**
@@ -542,6 +583,29 @@ playlist_item_t * playlist_NodeAddInput( playlist_t *p_playlist,
     return p_item;
 }
 
+static playlist_item_t *NodeAddInputDeferred( playlist_t *p_playlist,
+                                              input_item_t *p_input,
+                                              playlist_item_t *p_parent,
+                                              int i_pos, unsigned *pi_preparse )
+{
+    if( pi_preparse == NULL || *pi_preparse > 0 )
+    {
+        if( pi_preparse != NULL )
+            (*pi_preparse)--;
+        return playlist_NodeAddInput( p_playlist, p_input, p_parent, i_pos );
+    }
+
+    playlist_item_t *p_item = playlist_ItemNewFromInput( p_playlist, p_input );
+    if( unlikely(p_item == NULL) )
+        return NULL;
+
+    ARRAY_APPEND(p_playlist->items, p_item);
+
+    playlist_NodeInsert( p_parent, p_item, i_pos );
+    playlist_SendAddNotify( p_playlist, p_item );
+    return p_item;
+}
+
 /**
  * Copy an item (and all its children, if any) into another node
  *
@@ -597,8 +661,9 @@ int playlist_InsertInputItemTree (
     playlist_t *p_playlist, playlist_item_t *p_parent,
     input_item_node_t *p_node, int i_pos, bool b_flat )
 {
-    return RecursiveAddIntoParent( p_playlist, p_parent, p_node, i_pos, b_flat,
-                                   &(playlist_item_t*){ NULL } );
+    return RecursiveAddIntoParent( p_playlist, p_parent, p_node, 0,
+                                   p_node->i_children, i_pos, b_flat,
+                                   &(playlist_item_t*){ NULL }, NULL );
 }
 
 
@@ -648,6 +713,7 @@ int playlist_TreeMove( playlist_t * p_playlist, playlist_item_t *p_item,
     p_item->p_parent = p_node;
 
     pl_priv( p_playlist )->b_reset_currently_playing = true;
+    playlist_LiveSearchInvalidate( p_playlist );
     vlc_cond_signal( &pl_priv( p_playlist )->signal );
     return VLC_SUCCESS;
 }
@@ -672,24 +738,88 @@ int playlist_TreeMoveMany( playlist_t *p_playlist,
 
     if ( p_node->i_children == -1 ) return VLC_EGENERIC;
 
+    /* Detach all items in a single pass over each parent, rather than
+     * searching and erasing them one at a time. */
+    playlist_index_t moved, parents;
+    int ret = VLC_ENOMEM;
+
+    playlist_IndexInit( &moved );
+    playlist_IndexInit( &parents );
+
     for( int i = 0; i < i_items; i++ )
     {
         playlist_item_t *p_item = pp_items[i];
-        int i_index = ItemIndex( p_item );
         playlist_item_t *p_parent = p_item->p_parent;
-        TAB_ERASE(p_parent->i_children, p_parent->pp_children, i_index);
-        if ( p_parent == p_node && i_index < i_newpos ) i_newpos--;
+
+        if( playlist_IndexAdd( &moved, (uintptr_t)p_item, p_item ) )
+            goto out;
+        if( playlist_IndexFind( &parents, (uintptr_t)p_parent ) == NULL
+         && playlist_IndexAdd( &parents, (uintptr_t)p_parent, p_parent ) )
+            goto out;
     }
-    for( int i = i_items - 1; i >= 0; i-- )
+
+    if( i_items > 0 )
     {
-        playlist_item_t *p_item = pp_items[i];
-        TAB_INSERT(p_node->i_children, p_node->pp_children, p_item, i_newpos);
-        p_item->p_parent = p_node;
+        playlist_item_t **pp_children = realloc( p_node->pp_children,
+            (p_node->i_children + i_items) * sizeof (*pp_children) );
+        if( unlikely(pp_children == NULL) )
+            goto out;
+        p_node->pp_children = pp_children;
+    }
+
+    for( int i = 0; i < i_items; i++ )
+    {
+        playlist_item_t *p_parent = pp_items[i]->p_parent;
+
+        if( playlist_IndexFind( &parents, (uintptr_t)p_parent ) == NULL )
+            continue; /* already done */
+        playlist_IndexRemove( &parents, (uintptr_t)p_parent );
+
+        int j = 0, i_shift = 0;
+
+        for( int k = 0; k < p_parent->i_children; k++ )
+        {
+            playlist_item_t *p_child = p_parent->pp_children[k];
+
+            if( playlist_IndexFind( &moved, (uintptr_t)p_child ) == NULL )
+                p_parent->pp_children[j++] = p_child;
+            else if( p_parent == p_node && k < i_newpos )
+                i_shift++;
+        }
+
+        p_parent->i_children = j;
+        if( j == 0 && p_parent != p_node )
+        {
+            free( p_parent->pp_children );
+            p_parent->pp_children = NULL;
+        }
+        if( p_parent == p_node )
+            i_newpos -= i_shift;
+    }
+
+    memmove( p_node->pp_children + i_newpos + i_items,
+             p_node->pp_children + i_newpos,
+             (p_node->i_children - i_newpos) * sizeof (*p_node->pp_children) );
+    for( int i = 0; i < i_items; i++ )
+    {
+        p_node->pp_children[i_newpos + i] = pp_items[i];
+        pp_items[i]->p_parent = p_node;
+    }
+    p_node->i_children += i_items;
+    if( p_node->i_children == 0 )
+    {
+        free( p_node->pp_children );
+        p_node->pp_children = NULL;
     }
 
     pl_priv( p_playlist )->b_reset_currently_playing = true;
+    playlist_LiveSearchInvalidate( p_playlist );
     vlc_cond_signal( &pl_priv( p_playlist )->signal );
-    return VLC_SUCCESS;
+    ret = VLC_SUCCESS;
+out:
+    playlist_IndexClean( &parents );
+    playlist_IndexClean( &moved );
+    return ret;
 }
 
 /**
@@ -708,9 +838,63 @@ void playlist_SendAddNotify( playlist_t *p_playlist, playlist_item_t *item )
     p_sys->b_reset_currently_playing = true;
     vlc_cond_signal( &p_sys->signal );
 
+    playlist_BatchChanged( p_playlist, item->p_parent );
     var_SetAddress( p_playlist, "playlist-item-append", item );
 }
 
+void playlist_BeginBatch( playlist_t *p_playlist, playlist_item_t *p_node )
+{
+    playlist_private_t *p_sys = pl_priv(p_playlist);
+    PL_ASSERT_LOCKED;
+
+    if( p_node == NULL )
+        p_node = &p_playlist->root;
+
+    if( p_sys->batch.depth++ == 0 )
+        p_sys->batch.p_node = p_node;
+    else
+        playlist_BatchChanged( p_playlist, p_node );
+}
+
+void playlist_EndBatch( playlist_t *p_playlist )
+{
+    playlist_private_t *p_sys = pl_priv(p_playlist);
+    PL_ASSERT_LOCKED;
+
+    assert( p_sys->batch.depth > 0 );
+    if( --p_sys->batch.depth > 0 )
+        return;
+
+    playlist_item_t *p_node = p_sys->batch.p_node;
+    p_sys->batch.p_node = NULL;
+    var_SetAddress( p_playlist, "playlist-batch", p_node );
+}
+
+bool playlist_IsBatching( playlist_t *p_playlist )
+{
+    PL_ASSERT_LOCKED;
+    return pl_priv(p_playlist)->batch.depth > 0;
+}
+
+/**
+ * Widens the ongoing batch, if any, so that it contains a changed node.
+ * Changes outside of the batch node widen it to the whole playlist.
+ */
+void playlist_BatchChanged( playlist_t *p_playlist, playlist_item_t *p_node )
+{
+    playlist_private_t *p_sys = pl_priv(p_playlist);
+    PL_ASSERT_LOCKED;
+
+    if( p_sys->batch.depth == 0 )
+        return;
+
+    for( playlist_item_t *p = p_node; p != NULL; p = p->p_parent )
+        if( p == p_sys->batch.p_node )
+            return;
+
+    p_sys->batch.p_node = &p_playlist->root;
+}
+
 /**
  * Get the duration of all items in a node.
  */
@@ -751,6 +935,28 @@ static void playlist_Preparse( playlist_t *p_playlist,
     free( psz_album );
 }
 
+/**
+ * Preparses the items about to be played, whose preparsing was deferred
+ * when they were inserted.
+ */
+void playlist_PreparseAhead( playlist_t *p_playlist )
+{
+    PL_ASSERT_LOCKED;
+
+    if( !pl_priv(p_playlist)->b_preparse )
+        return;
+
+    for( int i = 1; i <= PLAYLIST_PREPARSE_AHEAD; i++ )
+    {
+        int i_index = p_playlist->i_current_index + i;
+
+        if( i_index < 0 || i_index >= p_playlist->current.i_size )
+            break;
+        playlist_Preparse( p_playlist,
+                           ARRAY_VAL( p_playlist->current, i_index ) );
+    }
+}
+
 /* Actually convert an item to a node */
 static void ChangeToNode( playlist_t *p_playlist, playlist_item_t *p_item )
 {
@@ -772,10 +978,17 @@ static void ChangeToNode( playlist_t *p_playlist, playlist_item_t *p_item )
         ARRAY_REMOVE( p_playlist->items, i );
 }
 
+/**
+ * Inserts the children from i_start to i_end (excluded) of an input item
+ * node, and their own children.
+ *
+ * \param pi_preparse number of items left to preparse, or NULL to preparse
+ *                    all items
+ */
 static int RecursiveAddIntoParent (
     playlist_t *p_playlist, playlist_item_t *p_parent,
-    input_item_node_t *p_node, int i_pos, bool b_flat,
-    playlist_item_t **pp_first_leaf )
+    input_item_node_t *p_node, int i_start, int i_end, int i_pos,
+    bool b_flat, playlist_item_t **pp_first_leaf, unsigned *pi_preparse )
 {
     *pp_first_leaf = NULL;
 
@@ -783,7 +996,7 @@ static int RecursiveAddIntoParent (
 
     if( i_pos == PLAYLIST_END ) i_pos = p_parent->i_children;
 
-    for( int i = 0; i < p_node->i_children; i++ )
+    for( int i = i_start; i < i_end; i++ )
     {
         input_item_node_t *p_child_node = p_node->pp_children[i];
 
@@ -793,9 +1006,9 @@ static int RecursiveAddIntoParent (
         //Create the playlist item represented by input node, if allowed.
         if( !(b_flat && b_children) )
         {
-            p_new_item = playlist_NodeAddInput( p_playlist,
-                                                p_child_node->p_item,
-                                                p_parent, i_pos );
+            p_new_item = NodeAddInputDeferred( p_playlist,
+                                               p_child_node->p_item,
+                                               p_parent, i_pos, pi_preparse );
             if( !p_new_item ) return i_pos;
 
             i_pos++;
@@ -809,15 +1022,16 @@ static int RecursiveAddIntoParent (
                     p_playlist,
                     p_new_item ? p_new_item : p_parent,
                     p_child_node,
+                    0, p_child_node->i_children,
                     ( b_flat ? i_pos : 0 ),
                     b_flat,
-                    &p_new_item );
+                    &p_new_item, pi_preparse );
             //If flat, take position after recursion as current position
             if( b_flat ) i_pos = i_last_pos;
         }
 
         assert( p_new_item != NULL );
-        if( i == 0 ) *pp_first_leaf = p_new_item;
+        if( i == i_start ) *pp_first_leaf = p_new_item;
     }
     return i_pos;
 }
@@ -36,12 +36,32 @@
 
 #include "input/input_interface.h"
 #include <assert.h>
+#include <vlc_atomic.h>
 
 #include "art.h"
 #include "preparser.h"
 
 typedef struct vlc_sd_internal_t vlc_sd_internal_t;
 
+/** Hash index of playlist items */
+typedef struct
+{
+    size_t mask;
+    size_t count; /**< Number of items */
+    size_t used; /**< Number of items and removed slots */
+    struct playlist_index_slot
+    {
+        uintptr_t key;
+        playlist_item_t *item;
+    } *slots;
+} playlist_index_t;
+
+void playlist_IndexInit( playlist_index_t * );
+void playlist_IndexClean( playlist_index_t * );
+playlist_item_t *playlist_IndexFind( const playlist_index_t *, uintptr_t );
+int playlist_IndexAdd( playlist_index_t *, uintptr_t, playlist_item_t * );
+void playlist_IndexRemove( playlist_index_t *, uintptr_t );
+
 void playlist_ServicesDiscoveryKillAll( playlist_t *p_playlist );
 
 typedef struct playlist_private_t
@@ -49,14 +69,15 @@ typedef struct playlist_private_t
     playlist_t           public_data;
     struct intf_thread_t *interface; /**< Linked-list of interfaces */
 
-    void *input_tree; /**< Search tree for input item
-                           to playlist item mapping */
-    void *id_tree; /**< Search tree for item ID to item mapping */
+    playlist_index_t input_index; /**< Input item to playlist item index */
+    playlist_index_t id_index; /**< Item ID to item index */
 
     vlc_sd_internal_t   **pp_sds;
     int                   i_sds;   /**< Number of service discovery modules */
     input_thread_t *      p_input;  /**< the input thread associated
                                      * with the current item */
+    input_thread_t *      p_preroll; /**< the input thread started ahead
+                                        * of time for the next item */
     input_resource_t *   p_input_resource; /**< input resources */
     vlc_renderer_item_t *p_renderer;
     struct {
@@ -89,10 +110,41 @@ typedef struct playlist_private_t
 
     bool     b_tree; /**< Display as a tree */
     bool     b_preparse; /**< Preparse items */
+
+    struct {
+        /* Last live search, narrowed down as the search string grows */
+        atomic_uint generation; /**< Changes that void the last search */
+        unsigned last_generation;
+        playlist_item_t *p_root;
+        bool b_recursive;
+        char *psz_folded; /**< Case folded search string, or NULL */
+        DECL_ARRAY(struct playlist_search_match) matches; /**< Matching items
+                                                               text */
+        DECL_ARRAY(playlist_item_t *) enabled; /**< Items and their parents */
+    } search;
+
+    struct {
+        /* Ongoing batch of changes, see playlist_BeginBatch() */
+        unsigned depth; /**< Nesting level, 0 if no batch */
+        playlist_item_t *p_node; /**< Node containing all changes so far */
+    } batch;
 } playlist_private_t;
 
 #define pl_priv( pl ) container_of(pl, playlist_private_t, public_data)
 
+/**
+ * Voids the last live search, e.g. as items were added or changed.
+ * This can be called without the playlist lock.
+ */
+static inline void playlist_LiveSearchInvalidate( playlist_t *p_playlist )
+{
+    atomic_fetch_add_explicit( &pl_priv(p_playlist)->search.generation, 1,
+                               memory_order_relaxed );
+}
+
+void playlist_LiveSearchInit( playlist_t * );
+void playlist_LiveSearchDestroy( playlist_t * );
+
 /*****************************************************************************
  * Prototypes
  *****************************************************************************/
@@ -121,10 +173,19 @@ int playlist_MLDump( playlist_t *p_playlist );
  **********************************************************************/
 
 void playlist_SendAddNotify( playlist_t *p_playlist, playlist_item_t *item );
+void playlist_BatchChanged( playlist_t *, playlist_item_t * );
 
 int playlist_InsertInputItemTree ( playlist_t *,
         playlist_item_t *, input_item_node_t *, int, bool );
 
+/** Sub-items of an input item are inserted by batches of that many sub-trees,
+ * unlocking the playlist in between */
+#define PLAYLIST_INSERT_BATCH 512
+/** Number of items preparsed ahead of the playing one */
+#define PLAYLIST_PREPARSE_AHEAD 16
+
+void playlist_PreparseAhead( playlist_t * );
+
 /* Tree walking */
 int playlist_NodeInsert(playlist_item_t*, playlist_item_t *, int);
 
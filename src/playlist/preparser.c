@@ -24,6 +24,7 @@
 #endif
 
 #include <vlc_common.h>
+#include <vlc_cpu.h>
 
 #include "misc/background_worker.h"
 #include "input/input_interface.h"
@@ -122,8 +123,15 @@ playlist_preparser_t* playlist_preparser_New( vlc_object_t *parent )
 {
     playlist_preparser_t* preparser = malloc( sizeof *preparser );
 
+    /* Preparsing is mostly spent waiting for I/O, so by default allow more
+     * concurrent inputs than there are CPUs */
+    int threads = var_InheritInteger( parent, "preparse-threads" );
+    if( threads <= 0 )
+        threads = 2 * vlc_GetCPUCount();
+
     struct background_worker_config conf = {
         .default_timeout = var_InheritInteger( parent, "preparse-timeout" ),
+        .max_threads = threads,
         .pf_start = PreparserOpenInput,
         .pf_probe = PreparserProbeInput,
         .pf_stop = PreparserCloseInput,
@@ -175,7 +183,10 @@ void playlist_preparser_Push( playlist_preparser_t *preparser,
             return;
     }
 
-    if( background_worker_Push( preparser->worker, item, id, timeout ) )
+    int ret = ( i_options & META_REQUEST_OPTION_PRIORITY )
+        ? background_worker_PushPriority( preparser->worker, item, id, timeout )
+        : background_worker_Push( preparser->worker, item, id, timeout );
+    if( ret )
         input_item_SignalPreparseEnded( item, ITEM_PREPARSE_FAILED );
 }
 
@@ -24,10 +24,12 @@
 # include "config.h"
 #endif
 #include <assert.h>
+#include <wctype.h>
 
 #include <vlc_common.h>
 #include <vlc_playlist.h>
 #include <vlc_charset.h>
+#include <vlc_memstream.h>
 #include "playlist_internal.h"
 
 /***************************************************************************
@@ -38,6 +40,147 @@
  * Live search handling
  ***************************************************************************/
 
+/* The text of the matching items is kept case folded along with the last
+ * search, so that typing more characters only checks the previous matches
+ * with plain strstr(), instead of walking the whole tree again. */
+
+struct playlist_search_match
+{
+    playlist_item_t *p_item;
+    char *psz_text; /**< Case folded fields, each nul-terminated,
+                         followed by an empty string */
+};
+
+static void FoldAppend( struct vlc_memstream *stream, const char *psz )
+{
+    while( *psz )
+    {
+        uint32_t cp;
+        size_t len = vlc_towc( psz, &cp );
+
+        if( unlikely(len == (size_t)-1) )
+        {   /* Invalid sequence: compared as is */
+            vlc_memstream_putc( stream, *(psz++) );
+            continue;
+        }
+        psz += len;
+        cp = towlower( cp );
+
+        /* Encode as UTF-8 */
+        if( cp < 0x80 )
+            vlc_memstream_putc( stream, cp );
+        else
+        {
+            char buf[4];
+            int n;
+
+            if( cp < 0x800 )
+            {
+                buf[0] = 0xC0 | (cp >> 6);
+                n = 2;
+            }
+            else if( cp < 0x10000 )
+            {
+                buf[0] = 0xE0 | (cp >> 12);
+                n = 3;
+            }
+            else
+            {
+                buf[0] = 0xF0 | (cp >> 18);
+                n = 4;
+            }
+            for( int i = n - 1; i > 0; i-- )
+            {
+                buf[i] = 0x80 | (cp & 0x3F);
+                cp >>= 6;
+            }
+            vlc_memstream_write( stream, buf, n );
+        }
+    }
+}
+
+static char *FoldCase( const char *psz )
+{
+    struct vlc_memstream stream;
+
+    vlc_memstream_open( &stream );
+    FoldAppend( &stream, psz );
+    return vlc_memstream_close( &stream ) ? NULL : stream.ptr;
+}
+
+static void FoldField( struct vlc_memstream *stream, const char *psz )
+{
+    if( psz != NULL && *psz )
+    {
+        FoldAppend( stream, psz );
+        vlc_memstream_putc( stream, '\0' );
+    }
+}
+
+/**
+ * Gets the case folded text to search in an item: the title (or the name),
+ * the album and the artist.
+ */
+static char *ItemSearchText( playlist_item_t *p_item )
+{
+    input_item_t *p_input = p_item->p_input;
+    struct vlc_memstream stream;
+
+    vlc_memstream_open( &stream );
+    vlc_mutex_lock( &p_input->lock );
+    if( p_input->p_meta )
+    {
+        const char *psz_title = vlc_meta_Get( p_input->p_meta, vlc_meta_Title );
+        if( !psz_title )
+            psz_title = p_input->psz_name;
+        FoldField( &stream, psz_title );
+        FoldField( &stream, vlc_meta_Get( p_input->p_meta, vlc_meta_Album ) );
+        FoldField( &stream, vlc_meta_Get( p_input->p_meta, vlc_meta_Artist ) );
+    }
+    else
+        FoldField( &stream, p_input->psz_name );
+    vlc_mutex_unlock( &p_input->lock );
+
+    return vlc_memstream_close( &stream ) ? NULL : stream.ptr;
+}
+
+static bool SearchTextMatch( const char *psz_text, const char *psz_folded )
+{
+    for( const char *psz = psz_text; *psz; psz += strlen( psz ) + 1 )
+        if( strstr( psz, psz_folded ) != NULL )
+            return true;
+    return false;
+}
+
+static void playlist_LiveSearchReset( playlist_private_t *p )
+{
+    for( int i = 0; i < p->search.matches.i_size; i++ )
+        free( p->search.matches.p_elems[i].psz_text );
+    ARRAY_RESET( p->search.matches );
+    ARRAY_RESET( p->search.enabled );
+    free( p->search.psz_folded );
+    p->search.psz_folded = NULL;
+    p->search.p_root = NULL;
+}
+
+void playlist_LiveSearchInit( playlist_t *p_playlist )
+{
+    playlist_private_t *p = pl_priv(p_playlist);
+
+    atomic_init( &p->search.generation, 0 );
+    p->search.last_generation = 0;
+    p->search.p_root = NULL;
+    p->search.b_recursive = false;
+    p->search.psz_folded = NULL;
+    ARRAY_INIT( p->search.matches );
+    ARRAY_INIT( p->search.enabled );
+}
+
+void playlist_LiveSearchDestroy( playlist_t *p_playlist )
+{
+    playlist_LiveSearchReset( pl_priv(p_playlist) );
+}
+
 /**
  * Enable all items in the playlist
  * @param p_root: the current root item
@@ -56,12 +199,15 @@ static void playlist_LiveSearchClean( playlist_item_t *p_root )
 
 /**
  * Enable/Disable items in the playlist according to the search argument
+ * @param p: the playlist
  * @param p_root: the current root item
- * @param psz_string: the string to search
+ * @param psz_folded: the case folded string to search
  * @return true if an item match
  */
-static bool playlist_LiveSearchUpdateInternal( playlist_item_t *p_root,
-                                               const char *psz_string, bool b_recursive )
+static bool playlist_LiveSearchUpdateInternal( playlist_private_t *p,
+                                               playlist_item_t *p_root,
+                                               const char *psz_folded,
+                                               bool b_recursive )
 {
     int i;
     bool b_match = false;
@@ -71,34 +217,27 @@ static bool playlist_LiveSearchUpdateInternal( playlist_item_t *p_root,
         playlist_item_t *p_item = p_root->pp_children[i];
         // Go recurssively if their is some children
         if( b_recursive && p_item->i_children >= 0 &&
-            playlist_LiveSearchUpdateInternal( p_item, psz_string, true ) )
+            playlist_LiveSearchUpdateInternal( p, p_item, psz_folded, true ) )
         {
             b_enable = true;
         }
 
-        if( !b_enable )
+        char *psz_text = ItemSearchText( p_item );
+        if( psz_text != NULL && SearchTextMatch( psz_text, psz_folded ) )
         {
-            vlc_mutex_lock( &p_item->p_input->lock );
-            // Do we have some meta ?
-            if( p_item->p_input->p_meta )
-            {
-                // Use Title or fall back to psz_name
-                const char *psz_title = vlc_meta_Get( p_item->p_input->p_meta, vlc_meta_Title );
-                if( !psz_title )
-                    psz_title = p_item->p_input->psz_name;
-                const char *psz_album = vlc_meta_Get( p_item->p_input->p_meta, vlc_meta_Album );
-                const char *psz_artist = vlc_meta_Get( p_item->p_input->p_meta, vlc_meta_Artist );
-                b_enable = ( psz_title && vlc_strcasestr( psz_title, psz_string ) ) ||
-                           ( psz_album && vlc_strcasestr( psz_album, psz_string ) ) ||
-                           ( psz_artist && vlc_strcasestr( psz_artist, psz_string ) );
-            }
-            else
-                b_enable = p_item->p_input->psz_name && vlc_strcasestr( p_item->p_input->psz_name, psz_string );
-            vlc_mutex_unlock( &p_item->p_input->lock );
+            struct playlist_search_match match = { p_item, psz_text };
+
+            ARRAY_APPEND( p->search.matches, match );
+            b_enable = true;
         }
+        else
+            free( psz_text );
 
         if( b_enable )
+        {
             p_item->i_flags &= ~PLAYLIST_DBL_FLAG;
+            ARRAY_APPEND( p->search.enabled, p_item );
+        }
         else
             p_item->i_flags |= PLAYLIST_DBL_FLAG;
 
@@ -107,7 +246,48 @@ static bool playlist_LiveSearchUpdateInternal( playlist_item_t *p_root,
    return b_match;
 }
 
+/**
+ * Narrows the last search down to the items that still match.
+ */
+static void playlist_LiveSearchNarrow( playlist_private_t *p,
+                                       playlist_item_t *p_root,
+                                       const char *psz_folded )
+{
+    for( int i = 0; i < p->search.enabled.i_size; i++ )
+        p->search.enabled.p_elems[i]->i_flags |= PLAYLIST_DBL_FLAG;
+
+    int i_matches = 0;
+
+    for( int i = 0; i < p->search.matches.i_size; i++ )
+    {
+        struct playlist_search_match match = p->search.matches.p_elems[i];
+
+        if( !SearchTextMatch( match.psz_text, psz_folded ) )
+        {
+            free( match.psz_text );
+            continue;
+        }
+        p->search.matches.p_elems[i_matches++] = match;
+
+        /* Enable the item and its parents (if recursive) */
+        for( playlist_item_t *p_item = match.p_item;
+             p_item != p_root && (p_item->i_flags & PLAYLIST_DBL_FLAG);
+             p_item = p_item->p_parent )
+            p_item->i_flags &= ~PLAYLIST_DBL_FLAG;
+    }
+    p->search.matches.i_size = i_matches;
+
+    int i_enabled = 0;
+
+    for( int i = 0; i < p->search.enabled.i_size; i++ )
+    {
+        playlist_item_t *p_item = p->search.enabled.p_elems[i];
 
+        if( !(p_item->i_flags & PLAYLIST_DBL_FLAG) )
+            p->search.enabled.p_elems[i_enabled++] = p_item;
+    }
+    p->search.enabled.i_size = i_enabled;
+}
 
 /**
  * Launch the recursive search in the playlist
@@ -119,13 +299,40 @@ static bool playlist_LiveSearchUpdateInternal( playlist_item_t *p_root,
 int playlist_LiveSearchUpdate( playlist_t *p_playlist, playlist_item_t *p_root,
                                const char *psz_string, bool b_recursive )
 {
+    playlist_private_t *p = pl_priv(p_playlist);
+
     PL_ASSERT_LOCKED;
-    pl_priv(p_playlist)->b_reset_currently_playing = true;
-    if( *psz_string )
-        playlist_LiveSearchUpdateInternal( p_root, psz_string, b_recursive );
-    else
+    p->b_reset_currently_playing = true;
+
+    char *psz_folded = *psz_string ? FoldCase( psz_string ) : NULL;
+    unsigned generation = atomic_load_explicit( &p->search.generation,
+                                                memory_order_relaxed );
+
+    if( psz_folded == NULL )
+    {
+        playlist_LiveSearchReset( p );
         playlist_LiveSearchClean( p_root );
-    vlc_cond_signal( &pl_priv(p_playlist)->signal );
+    }
+    else if( p->search.psz_folded != NULL
+          && p->search.last_generation == generation
+          && p->search.p_root == p_root
+          && p->search.b_recursive == b_recursive
+          && strstr( psz_folded, p->search.psz_folded ) != NULL )
+    {   /* Only previous matches can match a longer string */
+        playlist_LiveSearchNarrow( p, p_root, psz_folded );
+        free( p->search.psz_folded );
+        p->search.psz_folded = psz_folded;
+    }
+    else
+    {
+        playlist_LiveSearchReset( p );
+        playlist_LiveSearchUpdateInternal( p, p_root, psz_folded,
+                                           b_recursive );
+        p->search.psz_folded = psz_folded;
+        p->search.p_root = p_root;
+        p->search.b_recursive = b_recursive;
+        p->search.last_generation = generation;
+    }
+    vlc_cond_signal( &p->signal );
     return VLC_SUCCESS;
 }
-
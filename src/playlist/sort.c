@@ -26,83 +26,197 @@
 # include "config.h"
 #endif
 
+#include <ctype.h>
+
 #include <vlc_common.h>
+#include <vlc_cpu.h>
 #include <vlc_rand.h>
+#include <vlc_atomic.h>
 #define  VLC_INTERNAL_PLAYLIST_SORT_FUNCTIONS
 #include "vlc_playlist.h"
 #include "playlist_internal.h"
 
 
+/* The fields of the items are fetched and case folded once, into sort keys,
+ * rather than in each comparison, i.e. with the input item lock held
+ * O(n log n) times. Only the fields used by the sorting mode are fetched. */
+
+enum
+{
+    KEY_TITLE = 1 << 0,
+    KEY_URI = 1 << 1,
+    KEY_TRACK = 1 << 2,
+    KEY_DISC = 1 << 3,
+    KEY_ALBUM = 1 << 4,
+    KEY_DATE = 1 << 5,
+    KEY_ARTIST = 1 << 6,
+    KEY_DESCRIPTION = 1 << 7,
+    KEY_GENRE = 1 << 8,
+    KEY_RATING = 1 << 9,
+    KEY_DURATION = 1 << 10,
+};
+
+typedef struct
+{
+    playlist_item_t *p_item;
+    bool b_node;
+    int i_id;
+    char *psz_title; /**< Title or name, case folded */
+    int i_title; /**< Numeric value of the title */
+    char *psz_uri;
+    char *psz_album;
+    char *psz_artist;
+    char *psz_description;
+    char *psz_genre;
+    bool b_track, b_disc, b_date, b_rating; /**< Whether the meta is set */
+    int i_track, i_disc, i_date, i_rating;
+    mtime_t i_duration;
+} playlist_sort_key_t;
+
+static const unsigned sort_fields[NUM_SORT_FNS] =
+{
+    [SORT_ID] = 0,
+    [SORT_TITLE] = KEY_TITLE,
+    [SORT_TITLE_NODES_FIRST] = KEY_TITLE,
+    [SORT_ARTIST] = KEY_TITLE | KEY_ARTIST | KEY_DATE | KEY_ALBUM
+                  | KEY_DISC | KEY_TRACK,
+    [SORT_GENRE] = KEY_TITLE | KEY_GENRE,
+    [SORT_DURATION] = KEY_DURATION,
+    [SORT_TITLE_NUMERIC] = KEY_TITLE,
+    [SORT_ALBUM] = KEY_TITLE | KEY_ALBUM | KEY_DISC | KEY_TRACK,
+    [SORT_TRACK_NUMBER] = KEY_TITLE | KEY_TRACK,
+    [SORT_DESCRIPTION] = KEY_TITLE | KEY_DESCRIPTION,
+    [SORT_RATING] = KEY_TITLE | KEY_RATING,
+    [SORT_URI] = KEY_URI,
+    [SORT_DISC_NUMBER] = KEY_TITLE | KEY_DISC | KEY_TRACK,
+    [SORT_DATE] = KEY_TITLE | KEY_DATE | KEY_ALBUM | KEY_DISC | KEY_TRACK,
+};
+
+/* Folds like strcasecmp() compares */
+static char *key_fold( char *psz )
+{
+    if( psz != NULL )
+        for( char *p = psz; *p; p++ )
+            *p = tolower( (unsigned char)*p );
+    return psz;
+}
+
+static bool key_integer( input_item_t *p_input, vlc_meta_type_t meta,
+                         int *pi_value )
+{
+    char *psz = input_item_GetMeta( p_input, meta );
+    if( psz == NULL )
+        return false;
+    *pi_value = atoi( psz );
+    free( psz );
+    return true;
+}
+
+static void key_Init( playlist_sort_key_t *key, playlist_item_t *p_item,
+                      unsigned fields )
+{
+    input_item_t *p_input = p_item->p_input;
+
+    memset( key, 0, sizeof (*key) );
+    key->p_item = p_item;
+    key->b_node = p_item->i_children >= 0;
+    key->i_id = p_item->i_id;
+
+    if( fields & KEY_TITLE )
+    {
+        key->psz_title = key_fold( input_item_GetTitleFbName( p_input ) );
+        if( key->psz_title != NULL )
+            key->i_title = atoi( key->psz_title );
+    }
+    if( fields & KEY_URI )
+        key->psz_uri = key_fold( input_item_GetURI( p_input ) );
+    if( fields & KEY_ALBUM )
+        key->psz_album = key_fold( input_item_GetMeta( p_input,
+                                                       vlc_meta_Album ) );
+    if( fields & KEY_ARTIST )
+        key->psz_artist = key_fold( input_item_GetMeta( p_input,
+                                                        vlc_meta_Artist ) );
+    if( fields & KEY_DESCRIPTION )
+        key->psz_description =
+            key_fold( input_item_GetMeta( p_input, vlc_meta_Description ) );
+    if( fields & KEY_GENRE )
+        key->psz_genre = key_fold( input_item_GetMeta( p_input,
+                                                       vlc_meta_Genre ) );
+    if( fields & KEY_TRACK )
+        key->b_track = key_integer( p_input, vlc_meta_TrackNumber,
+                                    &key->i_track );
+    if( fields & KEY_DISC )
+        key->b_disc = key_integer( p_input, vlc_meta_DiscNumber,
+                                   &key->i_disc );
+    if( fields & KEY_DATE )
+        key->b_date = key_integer( p_input, vlc_meta_Date, &key->i_date );
+    if( fields & KEY_RATING )
+        key->b_rating = key_integer( p_input, vlc_meta_Rating,
+                                     &key->i_rating );
+    if( fields & KEY_DURATION )
+        key->i_duration = input_item_GetDuration( p_input );
+}
+
+static void key_Clean( playlist_sort_key_t *key )
+{
+    free( key->psz_title );
+    free( key->psz_uri );
+    free( key->psz_album );
+    free( key->psz_artist );
+    free( key->psz_description );
+    free( key->psz_genre );
+}
+
 /* General comparison functions */
 /**
- * Compare two items using their title or name
- * @param first: the first item
- * @param second: the second item
+ * Compare two strings, missing ones last
  * @return -1, 0 or 1 like strcmp
  */
-static inline int meta_strcasecmp_title( const playlist_item_t *first,
-                              const playlist_item_t *second )
+static inline int key_strcmp( const char *psz_first, const char *psz_second )
 {
-    int i_ret;
-    char *psz_first = input_item_GetTitleFbName( first->p_input );
-    char *psz_second = input_item_GetTitleFbName( second->p_input );
-
     if( psz_first && psz_second )
-        i_ret = strcasecmp( psz_first, psz_second );
+        return strcmp( psz_first, psz_second );
     else if( !psz_first && psz_second )
-        i_ret = 1;
+        return 1;
     else if( psz_first && !psz_second )
-        i_ret = -1;
+        return -1;
     else
-        i_ret = 0;
-    free( psz_first );
-    free( psz_second );
-
-    return i_ret;
+        return 0;
 }
 
 /**
- * Compare two intems according to the given meta type
- * @param first: the first item
- * @param second: the second item
- * @param meta: the meta type to use to sort the items
- * @param b_integer: true if the meta are integers
- * @return -1, 0 or 1 like strcmp
+ * Compare two integer meta, missing ones last
  */
-static inline int meta_sort( const playlist_item_t *first,
-                             const playlist_item_t *second,
-                             vlc_meta_type_t meta, bool b_integer )
+static inline int key_intcmp( bool b_first, int i_first,
+                              bool b_second, int i_second )
 {
-    int i_ret;
-    char *psz_first = input_item_GetMeta( first->p_input, meta );
-    char *psz_second = input_item_GetMeta( second->p_input, meta );
-
-    /* Nodes go first */
-    if( first->i_children == -1 && second->i_children >= 0 )
-        i_ret = 1;
-    else if( first->i_children >= 0 && second->i_children == -1 )
-       i_ret = -1;
-    /* Both are nodes, sort by name */
-    else if( first->i_children >= 0 && second->i_children >= 0 )
-        i_ret = meta_strcasecmp_title( first, second );
-    /* Both are items */
-    else if( !psz_first && !psz_second )
-        i_ret = 0;
-    else if( !psz_first && psz_second )
-        i_ret = 1;
-    else if( psz_first && !psz_second )
-        i_ret = -1;
+    if( b_first && b_second )
+        return i_first - i_second;
+    else if( !b_first && b_second )
+        return 1;
+    else if( b_first && !b_second )
+        return -1;
     else
-    {
-        if( b_integer )
-            i_ret = atoi( psz_first ) - atoi( psz_second );
-        else
-            i_ret = strcasecmp( psz_first, psz_second );
-    }
+        return 0;
+}
 
-    free( psz_first );
-    free( psz_second );
-    return i_ret;
+/**
+ * Order nodes first, and nodes by title
+ * @return true if either item is a node
+ */
+static inline bool key_nodecmp( const playlist_sort_key_t *first,
+                                const playlist_sort_key_t *second,
+                                int *pi_ret )
+{
+    if( !first->b_node && second->b_node )
+        *pi_ret = 1;
+    else if( first->b_node && !second->b_node )
+        *pi_ret = -1;
+    else if( first->b_node && second->b_node )
+        *pi_ret = key_strcmp( first->psz_title, second->psz_title );
+    else
+        return false;
+    return true;
 }
 
 /* Comparison functions */
@@ -123,20 +237,177 @@ static inline sortfn_t find_sorting_fn( unsigned i_mode, unsigned i_type )
     return sorting_fns[i_mode][i_type];
 }
 
+/* Nodes with more children are sorted by several threads */
+#define SORT_PARALLEL_MIN 16384
+#define SORT_THREADS_MAX 8
+
+typedef struct
+{
+    playlist_sort_key_t *p_keys;
+    playlist_item_t **pp_items;
+    size_t i_count;
+    unsigned i_fields;
+    sortfn_t p_sortfn;
+    vlc_thread_t thread;
+} sort_chunk_t;
+
+static void *SortChunkThread( void *data )
+{
+    sort_chunk_t *chunk = data;
+
+    for( size_t i = 0; i < chunk->i_count; i++ )
+        key_Init( &chunk->p_keys[i], chunk->pp_items[i], chunk->i_fields );
+    qsort( chunk->p_keys, chunk->i_count, sizeof (*chunk->p_keys),
+           chunk->p_sortfn );
+    return NULL;
+}
+
 /**
- * Sort an array of items recursively
+ * Merges two sorted runs of keys.
+ */
+static void SortMerge( const playlist_sort_key_t *a, size_t i_a,
+                       const playlist_sort_key_t *b, size_t i_b,
+                       playlist_sort_key_t *out, sortfn_t p_sortfn )
+{
+    while( i_a > 0 && i_b > 0 )
+    {
+        if( p_sortfn( b, a ) < 0 )
+        {
+            *(out++) = *(b++);
+            i_b--;
+        }
+        else
+        {
+            *(out++) = *(a++);
+            i_a--;
+        }
+    }
+    memcpy( out, a, i_a * sizeof (*a) );
+    memcpy( out + i_a, b, i_b * sizeof (*b) );
+}
+
+/**
+ * Sorts keys, by merging runs sorted by several threads if there are many.
+ */
+static void SortKeys( playlist_sort_key_t *p_keys, playlist_item_t **pp_items,
+                      size_t i_count, unsigned i_fields, sortfn_t p_sortfn,
+                      unsigned i_threads )
+{
+    if( i_count < SORT_PARALLEL_MIN )
+        i_threads = 1;
+    if( i_threads > SORT_THREADS_MAX )
+        i_threads = SORT_THREADS_MAX;
+
+    sort_chunk_t chunks[SORT_THREADS_MAX];
+    size_t i_offset = 0;
+
+    for( unsigned i = 0; i < i_threads; i++ )
+    {
+        size_t i_size = (i_count - i_offset) / (i_threads - i);
+
+        chunks[i].p_keys = p_keys + i_offset;
+        chunks[i].pp_items = pp_items + i_offset;
+        chunks[i].i_count = i_size;
+        chunks[i].i_fields = i_fields;
+        chunks[i].p_sortfn = p_sortfn;
+        i_offset += i_size;
+    }
+
+    playlist_sort_key_t *p_tmp = NULL;
+
+    if( i_threads > 1 )
+        p_tmp = malloc( i_count * sizeof (*p_tmp) );
+
+    if( p_tmp == NULL )
+    {
+        chunks[0].i_count = i_count;
+        SortChunkThread( &chunks[0] );
+        return;
+    }
+
+    /* The calling thread sorts the first chunk. */
+    unsigned i_started = 1;
+    for( ; i_started < i_threads; i_started++ )
+        if( vlc_clone( &chunks[i_started].thread, SortChunkThread,
+                       &chunks[i_started], VLC_THREAD_PRIORITY_LOW ) )
+            break;
+    for( unsigned i = i_started; i < i_threads; i++ )
+        SortChunkThread( &chunks[i] );
+    SortChunkThread( &chunks[0] );
+    for( unsigned i = 1; i < i_started; i++ )
+        vlc_join( chunks[i].thread, NULL );
+
+    /* Merge the runs pairwise */
+    playlist_sort_key_t *p_src = p_keys, *p_dst = p_tmp;
+
+    while( i_threads > 1 )
+    {
+        unsigned i_runs = 0;
+
+        for( unsigned i = 0; i < i_threads; i += 2 )
+        {
+            sort_chunk_t *a = &chunks[i];
+            playlist_sort_key_t *p_out = p_dst + (a->p_keys - p_src);
+
+            if( i + 1 < i_threads )
+            {
+                sort_chunk_t *b = &chunks[i + 1];
+
+                SortMerge( a->p_keys, a->i_count, b->p_keys, b->i_count,
+                           p_out, p_sortfn );
+                a->i_count += b->i_count;
+            }
+            else
+                memcpy( p_out, a->p_keys, a->i_count * sizeof (*p_out) );
+
+            chunks[i_runs].p_keys = p_out;
+            chunks[i_runs].i_count = a->i_count;
+            i_runs++;
+        }
+
+        i_threads = i_runs;
+        playlist_sort_key_t *p_swap = p_src;
+        p_src = p_dst;
+        p_dst = p_swap;
+    }
+
+    if( p_src != p_keys )
+        memcpy( p_keys, p_src, i_count * sizeof (*p_keys) );
+    free( p_tmp );
+}
+
+/**
+ * Sort an array of items
  * @param i_items: number of items
  * @param pp_items: the array of items
+ * @param i_mode: the sorting mode
  * @param p_sortfn: the sorting function
+ * @param i_threads: number of threads to sort large arrays
  * @return nothing
  */
-static inline
-void playlist_ItemArraySort( unsigned i_items, playlist_item_t **pp_items,
-                             sortfn_t p_sortfn )
+static void playlist_ItemArraySort( unsigned i_items,
+                                    playlist_item_t **pp_items,
+                                    unsigned i_mode, sortfn_t p_sortfn,
+                                    unsigned i_threads )
 {
     if( p_sortfn )
     {
-        qsort( pp_items, i_items, sizeof( pp_items[0] ), p_sortfn );
+        if( i_items < 2 )
+            return;
+
+        playlist_sort_key_t *p_keys = malloc( i_items * sizeof (*p_keys) );
+        if( unlikely(p_keys == NULL) )
+            return;
+
+        SortKeys( p_keys, pp_items, i_items, sort_fields[i_mode], p_sortfn,
+                  i_threads );
+
+        for( unsigned i = 0; i < i_items; i++ )
+        {
+            pp_items[i] = p_keys[i].p_item;
+            key_Clean( &p_keys[i] );
+        }
+        free( p_keys );
     }
     else /* Randomise */
     {
@@ -154,27 +425,102 @@ void playlist_ItemArraySort( unsigned i_items, playlist_item_t **pp_items,
     }
 }
 
+typedef struct
+{
+    playlist_item_t **pp_nodes;
+    size_t i_nodes;
+    atomic_size_t next;
+    unsigned i_mode;
+    sortfn_t p_sortfn;
+} sort_nodes_t;
+
+static void *SortNodesThread( void *data )
+{
+    sort_nodes_t *sys = data;
+    size_t i;
+
+    while( (i = atomic_fetch_add( &sys->next, 1 )) < sys->i_nodes )
+    {
+        playlist_item_t *p_node = sys->pp_nodes[i];
+
+        playlist_ItemArraySort( p_node->i_children, p_node->pp_children,
+                                sys->i_mode, sys->p_sortfn, 1 );
+    }
+    return NULL;
+}
+
+static void collectNodes( playlist_item_t *p_node,
+                          playlist_item_t ***ppp_nodes, size_t *pi_nodes )
+{
+    if( p_node->i_children > 1 )
+        TAB_APPEND( *pi_nodes, *ppp_nodes, p_node );
+    for( int i = 0; i < p_node->i_children; i++ )
+        if( p_node->pp_children[i]->i_children > 0 )
+            collectNodes( p_node->pp_children[i], ppp_nodes, pi_nodes );
+}
 
 /**
  * Sort a node recursively.
  * This function must be entered with the playlist lock !
  * @param p_playlist the playlist
  * @param p_node the node to sort
+ * @param i_mode the sorting mode
  * @param p_sortfn the sorting function
  * @return VLC_SUCCESS on success
  */
 static int recursiveNodeSort( playlist_t *p_playlist, playlist_item_t *p_node,
-                              sortfn_t p_sortfn )
+                              unsigned i_mode, sortfn_t p_sortfn )
 {
-    int i;
-    playlist_ItemArraySort(p_node->i_children,p_node->pp_children,p_sortfn);
-    for( i = 0 ; i< p_node->i_children; i++ )
+    playlist_item_t **pp_nodes;
+    size_t i_nodes;
+    unsigned i_threads = vlc_GetCPUCount();
+
+    /* Random order uses a single (locked) generator: no threads */
+    if( p_sortfn == NULL )
+        i_threads = 1;
+
+    TAB_INIT( i_nodes, pp_nodes );
+    collectNodes( p_node, &pp_nodes, &i_nodes );
+
+    /* Large nodes are sorted one at a time, each by several threads,
+     * other nodes concurrently. */
+    sort_nodes_t sys = {
+        .pp_nodes = pp_nodes,
+        .i_nodes = 0,
+        .i_mode = i_mode,
+        .p_sortfn = p_sortfn,
+    };
+    atomic_init( &sys.next, 0 );
+
+    for( size_t i = 0; i < i_nodes; i++ )
     {
-        if( p_node->pp_children[i]->i_children != -1 )
-        {
-            recursiveNodeSort( p_playlist, p_node->pp_children[i], p_sortfn );
-        }
+        playlist_item_t *p_child = pp_nodes[i];
+
+        if( p_child->i_children >= SORT_PARALLEL_MIN || i_threads == 1 )
+            playlist_ItemArraySort( p_child->i_children, p_child->pp_children,
+                                    i_mode, p_sortfn, i_threads );
+        else
+            pp_nodes[sys.i_nodes++] = p_child;
     }
+
+    if( i_threads > sys.i_nodes )
+        i_threads = sys.i_nodes;
+    if( i_threads > SORT_THREADS_MAX )
+        i_threads = SORT_THREADS_MAX;
+
+    vlc_thread_t threads[SORT_THREADS_MAX];
+    unsigned i_started = 0;
+
+    for( unsigned i = 1; i < i_threads; i++ )
+        if( vlc_clone( &threads[i_started], SortNodesThread, &sys,
+                       VLC_THREAD_PRIORITY_LOW ) == 0 )
+            i_started++;
+    SortNodesThread( &sys );
+    for( unsigned i = 0; i < i_started; i++ )
+        vlc_join( threads[i], NULL );
+
+    TAB_CLEAN( i_nodes, pp_nodes );
+    (void) p_playlist;
     return VLC_SUCCESS;
 }
 
@@ -198,31 +544,40 @@ int playlist_RecursiveNodeSort( playlist_t *p_playlist, playlist_item_t *p_node,
     pl_priv(p_playlist)->b_reset_currently_playing = true;
 
     /* Do the real job recursively */
-    return recursiveNodeSort(p_playlist,p_node,find_sorting_fn(i_mode,i_type));
+    return recursiveNodeSort(p_playlist,p_node,i_mode,
+                             find_sorting_fn(i_mode,i_type));
 }
 
 
 /* This is the stuff the sorting functions are made of. The proto_##
  * functions are wrapped in cmp_a_## and cmp_d_## functions that do
- * void * to const playlist_item_t * casting and dereferencing and
- * cmp_d_## inverts the result, too. proto_## are static inline,
- * cmp_[ad]_## are merely static as they're the target of pointers.
+ * void * to const playlist_sort_key_t * casting and cmp_d_## inverts the
+ * result, too. proto_## are static inline, cmp_[ad]_## are merely static
+ * as they're the target of pointers.
  *
  * In any case, each SORT_## constant (except SORT_RANDOM) must have
- * a matching SORTFN( )-declared function here.
+ * a matching SORTFN( )-declared function here, and its fields in
+ * sort_fields.
  */
 
 #define SORTFN( SORT, first, second ) static inline int proto_##SORT \
-    ( const playlist_item_t *first, const playlist_item_t *second )
+    ( const playlist_sort_key_t *first, const playlist_sort_key_t *second )
 
 SORTFN( SORT_TRACK_NUMBER, first, second )
 {
-    return meta_sort( first, second, vlc_meta_TrackNumber, true );
+    int i_ret;
+    if( key_nodecmp( first, second, &i_ret ) )
+        return i_ret;
+    return key_intcmp( first->b_track, first->i_track,
+                       second->b_track, second->i_track );
 }
 
 SORTFN( SORT_DISC_NUMBER, first, second )
 {
-    int i_ret = meta_sort( first, second, vlc_meta_DiscNumber, true );
+    int i_ret;
+    if( !key_nodecmp( first, second, &i_ret ) )
+        i_ret = key_intcmp( first->b_disc, first->i_disc,
+                            second->b_disc, second->i_disc );
     /* Items came from the same disc: compare the track numbers */
     if( i_ret == 0 )
         i_ret = proto_SORT_TRACK_NUMBER( first, second );
@@ -232,7 +587,9 @@ SORTFN( SORT_DISC_NUMBER, first, second )
 
 SORTFN( SORT_ALBUM, first, second )
 {
-    int i_ret = meta_sort( first, second, vlc_meta_Album, false );
+    int i_ret;
+    if( !key_nodecmp( first, second, &i_ret ) )
+        i_ret = key_strcmp( first->psz_album, second->psz_album );
     /* Items came from the same album: compare the disc numbers */
     if( i_ret == 0 )
         i_ret = proto_SORT_DISC_NUMBER( first, second );
@@ -242,7 +599,10 @@ SORTFN( SORT_ALBUM, first, second )
 
 SORTFN( SORT_DATE, first, second )
 {
-    int i_ret = meta_sort( first, second, vlc_meta_Date, true );
+    int i_ret;
+    if( !key_nodecmp( first, second, &i_ret ) )
+        i_ret = key_intcmp( first->b_date, first->i_date,
+                            second->b_date, second->i_date );
     /* Items came from the same date: compare the albums */
     if( i_ret == 0 )
         i_ret = proto_SORT_ALBUM( first, second );
@@ -252,7 +612,9 @@ SORTFN( SORT_DATE, first, second )
 
 SORTFN( SORT_ARTIST, first, second )
 {
-    int i_ret = meta_sort( first, second, vlc_meta_Artist, false );
+    int i_ret;
+    if( !key_nodecmp( first, second, &i_ret ) )
+        i_ret = key_strcmp( first->psz_artist, second->psz_artist );
     /* Items came from the same artist: compare the dates */
     if( i_ret == 0 )
         i_ret = proto_SORT_DATE( first, second );
@@ -262,13 +624,16 @@ SORTFN( SORT_ARTIST, first, second )
 
 SORTFN( SORT_DESCRIPTION, first, second )
 {
-    return meta_sort( first, second, vlc_meta_Description, false );
+    int i_ret;
+    if( key_nodecmp( first, second, &i_ret ) )
+        return i_ret;
+    return key_strcmp( first->psz_description, second->psz_description );
 }
 
 SORTFN( SORT_DURATION, first, second )
 {
-    mtime_t time1 = input_item_GetDuration( first->p_input );
-    mtime_t time2 = input_item_GetDuration( second->p_input );
+    mtime_t time1 = first->i_duration;
+    mtime_t time2 = second->i_duration;
     int i_ret = time1 > time2 ? 1 :
                     ( time1 == time2 ? 0 : -1 );
     return i_ret;
@@ -276,7 +641,10 @@ SORTFN( SORT_DURATION, first, second )
 
 SORTFN( SORT_GENRE, first, second )
 {
-    return meta_sort( first, second, vlc_meta_Genre, false );
+    int i_ret;
+    if( key_nodecmp( first, second, &i_ret ) )
+        return i_ret;
+    return key_strcmp( first->psz_genre, second->psz_genre );
 }
 
 SORTFN( SORT_ID, first, second )
@@ -286,65 +654,40 @@ SORTFN( SORT_ID, first, second )
 
 SORTFN( SORT_RATING, first, second )
 {
-    return meta_sort( first, second, vlc_meta_Rating, true );
+    int i_ret;
+    if( key_nodecmp( first, second, &i_ret ) )
+        return i_ret;
+    return key_intcmp( first->b_rating, first->i_rating,
+                       second->b_rating, second->i_rating );
 }
 
 SORTFN( SORT_TITLE, first, second )
 {
-    return meta_strcasecmp_title( first, second );
+    return key_strcmp( first->psz_title, second->psz_title );
 }
 
 SORTFN( SORT_TITLE_NODES_FIRST, first, second )
 {
     /* If first is a node but not second */
-    if( first->i_children == -1 && second->i_children >= 0 )
+    if( !first->b_node && second->b_node )
         return -1;
     /* If second is a node but not first */
-    else if( first->i_children >= 0 && second->i_children == -1 )
+    else if( first->b_node && !second->b_node )
         return 1;
     /* Both are nodes or both are not nodes */
     else
-        return meta_strcasecmp_title( first, second );
+        return key_strcmp( first->psz_title, second->psz_title );
 }
 
 SORTFN( SORT_TITLE_NUMERIC, first, second )
 {
-    int i_ret;
-    char *psz_first = input_item_GetTitleFbName( first->p_input );
-    char *psz_second = input_item_GetTitleFbName( second->p_input );
-
-    if( psz_first && psz_second )
-        i_ret = atoi( psz_first ) - atoi( psz_second );
-    else if( !psz_first && psz_second )
-        i_ret = 1;
-    else if( psz_first && !psz_second )
-        i_ret = -1;
-    else
-        i_ret = 0;
-
-    free( psz_first );
-    free( psz_second );
-    return i_ret;
+    return key_intcmp( first->psz_title != NULL, first->i_title,
+                       second->psz_title != NULL, second->i_title );
 }
 
 SORTFN( SORT_URI, first, second )
 {
-    int i_ret;
-    char *psz_first = input_item_GetURI( first->p_input );
-    char *psz_second = input_item_GetURI( second->p_input );
-
-    if( psz_first && psz_second )
-        i_ret = strcasecmp( psz_first, psz_second );
-    else if( !psz_first && psz_second )
-        i_ret = 1;
-    else if( psz_first && !psz_second )
-        i_ret = -1;
-    else
-        i_ret = 0;
-
-    free( psz_first );
-    free( psz_second );
-    return i_ret;
+    return key_strcmp( first->psz_uri, second->psz_uri );
 }
 
 #undef  SORTFN
@@ -359,11 +702,11 @@ SORTFN( SORT_URI, first, second )
 
 #define DEF( s ) \
     static int cmp_a_##s(const void *l,const void *r) \
-    { return proto_##s(*(const playlist_item_t *const *)l, \
-                           *(const playlist_item_t *const *)r); } \
+    { return proto_##s((const playlist_sort_key_t *)l, \
+                       (const playlist_sort_key_t *)r); } \
     static int cmp_d_##s(const void *l,const void *r) \
-    { return -1*proto_##s(*(const playlist_item_t * const *)l, \
-                              *(const playlist_item_t * const *)r); }
+    { return -1*proto_##s((const playlist_sort_key_t *)l, \
+                          (const playlist_sort_key_t *)r); }
 
     VLC_DEFINE_SORT_FUNCTIONS
 
@@ -185,6 +185,42 @@ void ResetCurrentlyPlaying( playlist_t *p_playlist,
 }
 
 
+/* Interval at which the position of the current input is checked */
+#define PREROLL_POLL_DELAY (CLOCK_FREQ / 4)
+
+/**
+ * Stop and destroy an input that was started ahead of time
+ */
+static void PrerollDiscard( input_thread_t *p_preroll )
+{
+    msg_Dbg( p_preroll, "discarding the prerolled input" );
+    input_Stop( p_preroll );
+    input_Close( p_preroll );
+}
+
+/**
+ * Switch to the input started ahead of time for an item
+ *
+ * \return the input thread, or NULL if it had already ended
+ */
+static input_thread_t *PrerollTake( playlist_t *p_playlist,
+                                    input_thread_t *p_preroll )
+{
+    var_AddCallback( p_preroll, "intf-event", InputEvent, p_playlist );
+
+    /* The input may have failed before the callback was added */
+    int i_state = var_GetInteger( p_preroll, "state" );
+    if( i_state == END_S || i_state == ERROR_S
+     || input_Control( p_preroll, INPUT_SET_STANDBY, false ) )
+    {
+        var_DelCallback( p_preroll, "intf-event", InputEvent, p_playlist );
+        PrerollDiscard( p_preroll );
+        return NULL;
+    }
+    msg_Dbg( p_playlist, "switching to the prerolled input" );
+    return p_preroll;
+}
+
 /**
  * Start the input for an item
  *
@@ -203,6 +239,7 @@ static bool PlayItem( playlist_t *p_playlist, playlist_item_t *p_item )
 
     p_item->i_nb_played++;
     set_current_status_item( p_playlist, p_item );
+    playlist_PreparseAhead( p_playlist );
     p_renderer = p_sys->p_renderer;
     /* Retain the renderer now to avoid it to be released by
      * playlist_SetRenderer when we exit the locked scope. If the last reference
@@ -210,24 +247,38 @@ static bool PlayItem( playlist_t *p_playlist, playlist_item_t *p_item )
     if( p_renderer )
         vlc_renderer_item_hold( p_renderer );
     assert( p_sys->p_input == NULL );
+    input_thread_t *p_preroll = p_sys->p_preroll;
+    p_sys->p_preroll = NULL;
     PL_UNLOCK;
 
     libvlc_MetadataCancel( p_playlist->obj.libvlc, p_item );
 
-    input_thread_t *p_input_thread = input_Create( p_playlist, p_input, NULL,
-                                                   p_sys->p_input_resource,
-                                                   p_renderer );
-    if( likely(p_input_thread != NULL) )
+    input_thread_t *p_input_thread = NULL;
+    if( p_preroll != NULL )
     {
-        var_AddCallback( p_input_thread, "intf-event",
-                         InputEvent, p_playlist );
+        /* The prerolled input does not render remotely */
+        if( input_GetItem( p_preroll ) == p_input && p_renderer == NULL )
+            p_input_thread = PrerollTake( p_playlist, p_preroll );
+        else
+            PrerollDiscard( p_preroll );
+    }
 
-        if( input_Start( p_input_thread ) )
+    if( p_input_thread == NULL )
+    {
+        p_input_thread = input_Create( p_playlist, p_input, NULL,
+                                       p_sys->p_input_resource, p_renderer );
+        if( likely(p_input_thread != NULL) )
         {
-            var_DelCallback( p_input_thread, "intf-event",
+            var_AddCallback( p_input_thread, "intf-event",
                              InputEvent, p_playlist );
-            vlc_object_release( p_input_thread );
-            p_input_thread = NULL;
+
+            if( input_Start( p_input_thread ) )
+            {
+                var_DelCallback( p_input_thread, "intf-event",
+                                 InputEvent, p_playlist );
+                vlc_object_release( p_input_thread );
+                p_input_thread = NULL;
+            }
         }
     }
 
@@ -419,13 +470,93 @@ static playlist_item_t *NextItem( playlist_t *p_playlist )
     return p_new;
 }
 
+/**
+ * Start the input of the next item ahead of time, near the end of the
+ * current one
+ *
+ * The input is opened on standby: it does not output anything and it does
+ * not demux files until the playlist switches to it at the end of the
+ * current input, on the same audio and video outputs.
+ *
+ * \return true once the preroll was attempted
+ */
+static bool Preroll( playlist_t *p_playlist, mtime_t i_preroll )
+{
+    playlist_private_t *p_sys = pl_priv(p_playlist);
+    input_thread_t *p_input = p_sys->p_input;
+
+    PL_ASSERT_LOCKED;
+
+    /* Only the automatic change to the next item can be predicted */
+    if( p_sys->request.b_request || p_sys->b_reset_currently_playing
+     || p_sys->p_renderer != NULL
+     || var_GetBool( p_playlist, "repeat" )
+     || var_InheritBool( p_playlist, "play-and-stop" ) )
+        return false;
+
+    int i_next = p_playlist->i_current_index + 1;
+    if( i_next < 0 || p_playlist->current.i_size == 0 )
+        return false;
+    if( i_next >= p_playlist->current.i_size )
+    {
+        if( !var_GetBool( p_playlist, "loop" ) )
+            return false;
+        i_next = 0;
+    }
+
+    input_item_t *p_item = ARRAY_VAL( p_playlist->current, i_next )->p_input;
+    input_item_Hold( p_item );
+    PL_UNLOCK;
+
+    bool b_done = false;
+    mtime_t i_length = var_GetInteger( p_input, "length" );
+    mtime_t i_time = var_GetInteger( p_input, "time" );
+
+    if( i_length > 0 && i_length - i_time <= i_preroll )
+    {
+        input_thread_t *p_preroll;
+
+        msg_Dbg( p_playlist, "prerolling the next item" );
+        p_preroll = input_Create( p_playlist, p_item, NULL,
+                                  p_sys->p_input_resource, NULL );
+        if( p_preroll != NULL
+         && ( input_Control( p_preroll, INPUT_SET_STANDBY, true )
+           || input_Start( p_preroll ) ) )
+        {
+            vlc_object_release( p_preroll );
+            p_preroll = NULL;
+        }
+
+        PL_LOCK;
+        assert( p_sys->p_preroll == NULL );
+        p_sys->p_preroll = p_preroll;
+        PL_UNLOCK;
+        b_done = true;
+    }
+    input_item_Release( p_item );
+
+    PL_LOCK;
+    return b_done;
+}
+
 static void LoopInput( playlist_t *p_playlist )
 {
     playlist_private_t *p_sys = pl_priv(p_playlist);
     input_thread_t *p_input = p_sys->p_input;
+    mtime_t i_preroll = INT64_C(1000)
+                      * var_InheritInteger( p_playlist, "playlist-preroll" );
 
     assert( p_input != NULL );
 
+    /* The stream output would be shared by both inputs */
+    if( i_preroll > 0 )
+    {
+        char *psz_sout = var_InheritString( p_playlist, "sout" );
+        if( psz_sout != NULL )
+            i_preroll = 0;
+        free( psz_sout );
+    }
+
     /* Wait for input to end or be stopped */
     while( !p_sys->request.input_dead )
     {
@@ -434,6 +565,17 @@ static void LoopInput( playlist_t *p_playlist )
             PL_DEBUG( "incoming request - stopping current input" );
             input_Stop( p_input );
         }
+        else if( i_preroll > 0 && p_sys->p_preroll == NULL )
+        {
+            /* The lock was released: check the requests again first */
+            if( Preroll( p_playlist, i_preroll ) )
+                i_preroll = 0;
+            else if( !p_sys->request.input_dead && !p_sys->request.b_request
+                  && !p_sys->killed )
+                vlc_cond_timedwait( &p_sys->signal, &p_sys->lock,
+                                    mdate() + PREROLL_POLL_DELAY );
+            continue;
+        }
         vlc_cond_wait( &p_sys->signal, &p_sys->lock );
     }
 
@@ -496,6 +638,15 @@ static void *Thread ( void *data )
 
         /* Playlist stopping */
         msg_Dbg( p_playlist, "nothing to play" );
+        if( p_sys->p_preroll != NULL )
+        {
+            input_thread_t *p_preroll = p_sys->p_preroll;
+
+            p_sys->p_preroll = NULL;
+            PL_UNLOCK;
+            PrerollDiscard( p_preroll );
+            PL_LOCK;
+        }
         if( played && var_InheritBool( p_playlist, "play-and-exit" ) )
         {
             msg_Info( p_playlist, "end of playlist, exiting" );
@@ -105,12 +105,25 @@ void playlist_NodeDeleteExplicit( playlist_t *p_playlist,
         !( flags & PLAYLIST_DELETE_FORCE ) )
         return;
 
-    /* Delete the children */
+    /* Delete the children, as a single batch if there are many */
+    bool b_batch = p_root->i_children > PLAYLIST_INSERT_BATCH;
+    if( b_batch )
+        playlist_BeginBatch( p_playlist, p_root );
+
     for( int i = p_root->i_children - 1 ; i >= 0; i-- )
         playlist_NodeDeleteExplicit( p_playlist,
             p_root->pp_children[i], flags | PLAYLIST_DELETE_FORCE );
 
-    pl_priv(p_playlist)->b_reset_currently_playing = true;
+    if( b_batch )
+        playlist_EndBatch( p_playlist );
+
+    playlist_private_t *p_sys = pl_priv(p_playlist);
+    p_sys->b_reset_currently_playing = true;
+
+    if( p_sys->batch.p_node == p_root )
+        p_sys->batch.p_node = p_root->p_parent != NULL ? p_root->p_parent
+                                                       : &p_playlist->root;
+    playlist_BatchChanged( p_playlist, p_root->p_parent );
 
     int i;
     var_SetAddress( p_playlist, "playlist-item-deleted", p_root );
@@ -141,7 +154,15 @@ void playlist_NodeDeleteExplicit( playlist_t *p_playlist,
     /* Remove the item from its parent */
     playlist_item_t *p_parent = p_root->p_parent;
     if( p_parent != NULL )
-        TAB_REMOVE(p_parent->i_children, p_parent->pp_children, p_root);
+    {
+        /* Children are deleted from the last one: avoid searching */
+        if( p_parent->i_children > 0
+         && p_parent->pp_children[p_parent->i_children - 1] == p_root )
+            TAB_ERASE(p_parent->i_children, p_parent->pp_children,
+                      p_parent->i_children - 1);
+        else
+            TAB_REMOVE(p_parent->i_children, p_parent->pp_children, p_root);
+    }
 
     playlist_ItemRelease( p_playlist, p_root );
 }
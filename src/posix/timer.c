@@ -1,5 +1,5 @@
 /*****************************************************************************
- * timer.c: simple threaded timer
+ * timer.c: timer wheel serviced by a thread pool
  *****************************************************************************
  * Copyright (C) 2009-2012 Rémi Denis-Courmont
  *
@@ -22,7 +22,6 @@
 # include "config.h"
 #endif
 
-#include <stdnoreturn.h>
 #include <stdlib.h>
 #include <errno.h>
 #include <assert.h>
@@ -36,41 +35,319 @@
  * they typically require one thread per timer plus one thread per iteration,
  * which is inefficient and overkill (unless you need multiple iteration
  * of the same timer concurrently).
- * Thus, this is a generic manual implementation of timers using a thread.
+ *
+ * Thus, this is a generic manual implementation of timers. All the timers of
+ * the process are kept in a hierarchical timer wheel, advanced by a clock
+ * thread, and their callbacks are run by a small pool of worker threads.
+ * Timers fire with the resolution of the wheel tick.
  */
 
+#define VLC_TIMER_TICK      (CLOCK_FREQ / 1000)
+#define VLC_TIMER_BITS      6
+#define VLC_TIMER_SLOTS     (1 << VLC_TIMER_BITS)
+#define VLC_TIMER_MASK      (VLC_TIMER_SLOTS - 1)
+#define VLC_TIMER_LEVELS    4
+#define VLC_TIMER_WORKERS   4
+
+enum vlc_timer_state
+{
+    VLC_TIMER_IDLE,
+    VLC_TIMER_QUEUED, /* in the wheel */
+    VLC_TIMER_READY, /* waiting for a worker */
+    VLC_TIMER_RUNNING,
+};
+
 struct vlc_timer
 {
-    vlc_thread_t thread;
-    vlc_cond_t   reschedule;
-    vlc_mutex_t  lock;
-    void       (*func) (void *);
-    void        *data;
-    mtime_t      value, interval;
-    atomic_uint  overruns;
+    struct vlc_timer  *next;
+    struct vlc_timer **pprev;
+    void             (*func) (void *);
+    void              *data;
+    mtime_t            value, interval;
+    uint64_t           expires; /* in ticks */
+    enum vlc_timer_state state;
+    atomic_uint        generation; /* bumped by each schedule call */
+    atomic_uint        overruns;
 };
 
-noreturn static void *vlc_timer_thread (void *data)
+static struct
+{
+    vlc_mutex_t       setup; /* serializes the threads start and stop */
+    bool              started;
+    bool              quit;
+    vlc_thread_t      clock;
+    vlc_thread_t      workers[VLC_TIMER_WORKERS];
+    unsigned long     worker_ids[VLC_TIMER_WORKERS];
+    unsigned          worker_count;
+    unsigned          idle_workers;
+
+    vlc_mutex_t       lock;
+    vlc_cond_t        wakeup; /* for the clock thread */
+    vlc_cond_t        ready_wait; /* for the workers */
+    vlc_cond_t        done; /* a callback returned */
+    uint64_t          tick; /* next tick to process */
+    uint64_t          wake; /* tick the clock thread sleeps until */
+    struct vlc_timer *slots[VLC_TIMER_LEVELS][VLC_TIMER_SLOTS];
+    struct vlc_timer *overflow;
+    struct vlc_timer *ready;
+    struct vlc_timer **ready_last;
+    unsigned          timers;
+    unsigned          queued;
+
+    /* statistics */
+    uint64_t          fired;
+    mtime_t           latency_total;
+    mtime_t           latency_max;
+} wheel =
+{
+    .setup = VLC_STATIC_MUTEX,
+    .lock = VLC_STATIC_MUTEX,
+    .wakeup = VLC_STATIC_COND,
+    .ready_wait = VLC_STATIC_COND,
+    .done = VLC_STATIC_COND,
+    .ready_last = &wheel.ready,
+};
+
+static void vlc_timer_unlink(struct vlc_timer *timer)
+{
+    if (timer->next != NULL)
+        timer->next->pprev = timer->pprev;
+    else if (timer->state == VLC_TIMER_READY)
+        wheel.ready_last = timer->pprev;
+    *(timer->pprev) = timer->next;
+    if (timer->state == VLC_TIMER_QUEUED)
+        wheel.queued--;
+    timer->state = VLC_TIMER_IDLE;
+}
+
+static void vlc_timer_link(struct vlc_timer **list, struct vlc_timer *timer)
+{
+    timer->next = *list;
+    if (timer->next != NULL)
+        timer->next->pprev = &timer->next;
+    timer->pprev = list;
+    *list = timer;
+}
+
+/** Queues a timer for a worker, and starts one more if they are all busy */
+static void vlc_timer_ready(struct vlc_timer *timer);
+
+static void *vlc_timer_worker(void *);
+
+static void vlc_timer_insert(struct vlc_timer *timer)
+{
+    assert(timer->state == VLC_TIMER_IDLE && timer->value != 0);
+
+    timer->expires = (timer->value + VLC_TIMER_TICK - 1) / VLC_TIMER_TICK;
+
+    if (timer->expires < wheel.tick)
+    {   /* Already elapsed */
+        vlc_timer_ready(timer);
+        return;
+    }
+
+    uint64_t delta = timer->expires - wheel.tick;
+    struct vlc_timer **list = &wheel.overflow;
+
+    for (unsigned l = 0; l < VLC_TIMER_LEVELS; l++)
+        if (delta < (UINT64_C(1) << ((l + 1) * VLC_TIMER_BITS)))
+        {
+            unsigned idx = (timer->expires >> (l * VLC_TIMER_BITS))
+                           & VLC_TIMER_MASK;
+            list = &wheel.slots[l][idx];
+            break;
+        }
+
+    vlc_timer_link(list, timer);
+    timer->state = VLC_TIMER_QUEUED;
+    wheel.queued++;
+
+    if (timer->expires < wheel.wake)
+    {   /* Earlier than what the clock thread waits for */
+        wheel.wake = timer->expires;
+        vlc_cond_signal(&wheel.wakeup);
+    }
+}
+
+static void vlc_timer_ready(struct vlc_timer *timer)
+{
+    timer->next = NULL;
+    timer->pprev = wheel.ready_last;
+    *(wheel.ready_last) = timer;
+    wheel.ready_last = &timer->next;
+    timer->state = VLC_TIMER_READY;
+
+    if (wheel.idle_workers > 0)
+    {
+        vlc_cond_signal(&wheel.ready_wait);
+        return;
+    }
+
+    unsigned i = wheel.worker_count;
+    if (i < VLC_TIMER_WORKERS
+     && vlc_clone(&wheel.workers[i], vlc_timer_worker, (void *)(uintptr_t)i,
+                  VLC_THREAD_PRIORITY_INPUT) == 0)
+        wheel.worker_count++;
+    /* Otherwise, a busy worker will run it */
+}
+
+/** Redistributes the timers of a slot over the lower levels */
+static void vlc_timer_cascade(struct vlc_timer **list)
+{
+    struct vlc_timer *timer = *list;
+
+    *list = NULL;
+    while (timer != NULL)
+    {
+        struct vlc_timer *next = timer->next;
+
+        timer->state = VLC_TIMER_IDLE;
+        wheel.queued--;
+        vlc_timer_insert(timer);
+        timer = next;
+    }
+}
+
+/** Processes the ticks up to and including the given one */
+static void vlc_timer_advance(uint64_t now)
+{
+    while (wheel.tick <= now)
+    {
+        uint64_t tick = wheel.tick;
+
+        if (wheel.queued == 0)
+        {   /* Nothing to do in the mean time */
+            wheel.tick = now + 1;
+            break;
+        }
+
+        if ((tick & VLC_TIMER_MASK) == 0)
+        {
+            unsigned l;
+
+            for (l = 1; l < VLC_TIMER_LEVELS; l++)
+            {
+                unsigned idx = (tick >> (l * VLC_TIMER_BITS)) & VLC_TIMER_MASK;
+
+                vlc_timer_cascade(&wheel.slots[l][idx]);
+                if (idx != 0)
+                    break;
+            }
+
+            if (l == VLC_TIMER_LEVELS)
+                vlc_timer_cascade(&wheel.overflow);
+        }
+
+        struct vlc_timer **list = &wheel.slots[0][tick & VLC_TIMER_MASK];
+
+        while (*list != NULL)
+        {
+            struct vlc_timer *timer = *list;
+
+            vlc_timer_unlink(timer);
+            vlc_timer_ready(timer);
+        }
+        wheel.tick++;
+    }
+}
+
+/** Finds the next tick when a timer can fire or move down the wheel */
+static uint64_t vlc_timer_next(void)
+{
+    uint64_t next = UINT64_MAX;
+
+    if (wheel.queued == 0)
+        return next;
+
+    for (unsigned i = 0; i < VLC_TIMER_SLOTS; i++)
+        if (wheel.slots[0][(wheel.tick + i) & VLC_TIMER_MASK] != NULL)
+        {
+            next = wheel.tick + i;
+            break;
+        }
+
+    for (unsigned l = 1; l < VLC_TIMER_LEVELS; l++)
+    {
+        const unsigned shift = l * VLC_TIMER_BITS;
+        const uint64_t period = UINT64_C(1) << shift;
+        uint64_t t = (wheel.tick + period - 1) & ~(period - 1);
+
+        for (unsigned i = 0; i < VLC_TIMER_SLOTS && t < next; i++, t += period)
+            if (wheel.slots[l][(t >> shift) & VLC_TIMER_MASK] != NULL)
+            {
+                next = t;
+                break;
+            }
+    }
+
+    if (wheel.overflow != NULL)
+    {
+        const uint64_t period = UINT64_C(1)
+                                << (VLC_TIMER_LEVELS * VLC_TIMER_BITS);
+        uint64_t t = (wheel.tick + period - 1) & ~(period - 1);
+
+        if (t < next)
+            next = t;
+    }
+    return next;
+}
+
+static void *vlc_timer_clock(void *data)
 {
-    struct vlc_timer *timer = data;
+    vlc_mutex_lock(&wheel.lock);
+    while (!wheel.quit)
+    {
+        vlc_timer_advance(mdate() / VLC_TIMER_TICK);
 
-    vlc_mutex_lock (&timer->lock);
-    mutex_cleanup_push (&timer->lock);
+        wheel.wake = vlc_timer_next();
+        if (wheel.wake == UINT64_MAX)
+            vlc_cond_wait(&wheel.wakeup, &wheel.lock);
+        else
+            vlc_cond_timedwait(&wheel.wakeup, &wheel.lock,
+                               wheel.wake * VLC_TIMER_TICK);
+    }
+    vlc_mutex_unlock(&wheel.lock);
+    (void) data;
+    return NULL;
+}
+
+static void *vlc_timer_worker(void *data)
+{
+    vlc_mutex_lock(&wheel.lock);
+    wheel.worker_ids[(uintptr_t)data] = vlc_thread_id();
 
     for (;;)
     {
-        while (timer->value == 0)
+        while (wheel.ready == NULL && !wheel.quit)
         {
-            assert(timer->interval == 0);
-            vlc_cond_wait (&timer->reschedule, &timer->lock);
+            wheel.idle_workers++;
+            vlc_cond_wait(&wheel.ready_wait, &wheel.lock);
+            wheel.idle_workers--;
         }
+        if (wheel.quit)
+            break;
 
-        if (timer->interval != 0)
+        struct vlc_timer *timer = wheel.ready;
+        mtime_t now = mdate();
+        mtime_t latency = now - timer->value;
+        unsigned generation = atomic_load_explicit(&timer->generation,
+                                                   memory_order_relaxed);
+
+        vlc_timer_unlink(timer);
+        timer->state = VLC_TIMER_RUNNING;
+
+        wheel.fired++;
+        if (latency > 0)
         {
-            mtime_t now = mdate();
+            wheel.latency_total += latency;
+            if (latency > wheel.latency_max)
+                wheel.latency_max = latency;
+        }
 
+        if (timer->interval != 0)
+        {
             if (now > timer->value)
-            {   /* Update overrun counter */
+            {   /* Update overrun counter, for this occurrence's callback */
                 unsigned misses = (now - timer->value) / timer->interval;
 
                 timer->value += misses * timer->interval;
@@ -78,32 +355,89 @@ noreturn static void *vlc_timer_thread (void *data)
                 atomic_fetch_add_explicit(&timer->overruns, misses,
                                           memory_order_relaxed);
             }
+            timer->value += timer->interval; /* rearm */
         }
+        else
+            timer->value = 0; /* disarm */
 
-        mtime_t value = timer->value;
+        vlc_mutex_unlock(&wheel.lock);
 
-        if (vlc_cond_timedwait(&timer->reschedule, &timer->lock, value) == 0)
-            continue;
-
-        if (likely(timer->value <= value))
+        /* An occurrence scheduled before the last schedule call is stale */
+        if (atomic_load_explicit(&timer->generation,
+                                 memory_order_relaxed) == generation)
         {
-            timer->value += timer->interval; /* rearm */
-
-            if (timer->interval == 0)
-                timer->value = 0; /* disarm */
+            int canc = vlc_savecancel();
+            timer->func(timer->data);
+            vlc_restorecancel(canc);
         }
 
-        vlc_mutex_unlock (&timer->lock);
+        vlc_mutex_lock(&wheel.lock);
+        timer->state = VLC_TIMER_IDLE;
+        vlc_cond_broadcast(&wheel.done);
 
-        int canc = vlc_savecancel ();
-        timer->func (timer->data);
-        vlc_restorecancel (canc);
+        /* If rescheduled meanwhile, the new value replaced the rearm */
+        if (timer->value != 0)
+            vlc_timer_insert(timer);
+    }
+    vlc_mutex_unlock(&wheel.lock);
+    return NULL;
+}
+
+static int vlc_timer_start(void)
+{
+    wheel.quit = false;
+    wheel.tick = mdate() / VLC_TIMER_TICK;
+    wheel.wake = UINT64_MAX;
 
-        vlc_mutex_lock (&timer->lock);
+    if (vlc_clone(&wheel.clock, vlc_timer_clock, NULL,
+                  VLC_THREAD_PRIORITY_INPUT))
+        return ENOMEM;
+
+    if (vlc_clone(&wheel.workers[0], vlc_timer_worker, (void *)(uintptr_t)0,
+                  VLC_THREAD_PRIORITY_INPUT))
+    {
+        vlc_mutex_lock(&wheel.lock);
+        wheel.quit = true;
+        vlc_cond_signal(&wheel.wakeup);
+        vlc_mutex_unlock(&wheel.lock);
+        vlc_join(wheel.clock, NULL);
+        return ENOMEM;
     }
 
-    vlc_cleanup_pop ();
-    vlc_assert_unreachable ();
+    vlc_mutex_lock(&wheel.lock);
+    wheel.worker_count = 1;
+    vlc_mutex_unlock(&wheel.lock);
+    wheel.started = true;
+    return 0;
+}
+
+static void vlc_timer_stop(void)
+{
+    unsigned long self = vlc_thread_id();
+    unsigned count;
+
+    vlc_mutex_lock(&wheel.lock);
+    count = wheel.worker_count;
+    for (unsigned i = 0; i < count; i++)
+        if (wheel.worker_ids[i] == self)
+        {   /* Called from a callback: the pool cannot join itself */
+            vlc_mutex_unlock(&wheel.lock);
+            return;
+        }
+
+    wheel.quit = true;
+    vlc_cond_signal(&wheel.wakeup);
+    vlc_cond_broadcast(&wheel.ready_wait);
+    vlc_mutex_unlock(&wheel.lock);
+
+    vlc_join(wheel.clock, NULL);
+    for (unsigned i = 0; i < count; i++)
+        vlc_join(wheel.workers[i], NULL);
+
+    vlc_mutex_lock(&wheel.lock);
+    wheel.worker_count = 0;
+    vlc_mutex_unlock(&wheel.lock);
+    wheel.started = false;
 }
 
 int vlc_timer_create (vlc_timer_t *id, void (*func) (void *), void *data)
@@ -112,34 +446,48 @@ int vlc_timer_create (vlc_timer_t *id, void (*func) (void *), void *data)
 
     if (unlikely(timer == NULL))
         return ENOMEM;
-    vlc_mutex_init (&timer->lock);
-    vlc_cond_init (&timer->reschedule);
     assert (func);
     timer->func = func;
     timer->data = data;
     timer->value = 0;
     timer->interval = 0;
+    timer->state = VLC_TIMER_IDLE;
+    atomic_init(&timer->generation, 0);
     atomic_init(&timer->overruns, 0);
 
-    if (vlc_clone (&timer->thread, vlc_timer_thread, timer,
-                   VLC_THREAD_PRIORITY_INPUT))
+    vlc_mutex_lock(&wheel.setup);
+    if (!wheel.started && vlc_timer_start())
     {
-        vlc_cond_destroy (&timer->reschedule);
-        vlc_mutex_destroy (&timer->lock);
+        vlc_mutex_unlock(&wheel.setup);
         free (timer);
         return ENOMEM;
     }
 
+    vlc_mutex_lock(&wheel.lock);
+    wheel.timers++;
+    vlc_mutex_unlock(&wheel.lock);
+    vlc_mutex_unlock(&wheel.setup);
+
     *id = timer;
     return 0;
 }
 
 void vlc_timer_destroy (vlc_timer_t timer)
 {
-    vlc_cancel (timer->thread);
-    vlc_join (timer->thread, NULL);
-    vlc_cond_destroy (&timer->reschedule);
-    vlc_mutex_destroy (&timer->lock);
+    vlc_mutex_lock(&wheel.lock);
+    while (timer->state == VLC_TIMER_RUNNING)
+        vlc_cond_wait(&wheel.done, &wheel.lock);
+    if (timer->state != VLC_TIMER_IDLE)
+        vlc_timer_unlink(timer);
+    vlc_mutex_unlock(&wheel.lock);
+
+    vlc_mutex_lock(&wheel.setup);
+    vlc_mutex_lock(&wheel.lock);
+    bool last = --wheel.timers == 0;
+    vlc_mutex_unlock(&wheel.lock);
+    if (last)
+        vlc_timer_stop();
+    vlc_mutex_unlock(&wheel.setup);
     free (timer);
 }
 
@@ -152,11 +500,18 @@ void vlc_timer_schedule (vlc_timer_t timer, bool absolute,
     if (!absolute)
         value += mdate();
 
-    vlc_mutex_lock (&timer->lock);
+    vlc_mutex_lock (&wheel.lock);
+    atomic_fetch_add_explicit(&timer->generation, 1, memory_order_relaxed);
+    if (timer->state == VLC_TIMER_QUEUED || timer->state == VLC_TIMER_READY)
+        vlc_timer_unlink(timer);
     timer->value = value;
     timer->interval = interval;
-    vlc_cond_signal (&timer->reschedule);
-    vlc_mutex_unlock (&timer->lock);
+    /* Overruns of the previous schedule are not reported */
+    atomic_store_explicit(&timer->overruns, 0, memory_order_relaxed);
+    /* A running timer is queued again when its callback returns */
+    if (timer->state == VLC_TIMER_IDLE && value != 0)
+        vlc_timer_insert(timer);
+    vlc_mutex_unlock (&wheel.lock);
 }
 
 unsigned vlc_timer_getoverrun (vlc_timer_t timer)
@@ -164,3 +519,14 @@ unsigned vlc_timer_getoverrun (vlc_timer_t timer)
     return atomic_exchange_explicit (&timer->overruns, 0,
                                      memory_order_relaxed);
 }
+
+void vlc_timer_getstats(vlc_timer_stats_t *stats)
+{
+    vlc_mutex_lock(&wheel.lock);
+    stats->timers = wheel.timers;
+    stats->threads = wheel.worker_count;
+    stats->fired = wheel.fired;
+    stats->latency_avg = wheel.fired ? wheel.latency_total / wheel.fired : 0;
+    stats->latency_max = wheel.latency_max;
+    vlc_mutex_unlock(&wheel.lock);
+}
@@ -47,6 +47,7 @@
 #include <vlc_block.h>
 #include <vlc_codec.h>
 #include <vlc_modules.h>
+#include <vlc_trace.h>
 
 #include "input/input_interface.h"
 
@@ -232,6 +233,7 @@ int sout_InputSendBuffer( sout_packetizer_input_t *p_input,
     sout_instance_t     *p_sout = p_input->p_sout;
     int                 i_ret;
 
+    vlc_trace_Scope( "sout send" );
     vlc_mutex_lock( &p_sout->lock );
     i_ret = p_sout->p_stream->pf_send( p_sout->p_stream,
                                        p_input->id, p_buffer );
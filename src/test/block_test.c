@@ -86,11 +86,61 @@ static void test_block (void)
     //assert (block == NULL);
 }
 
+static void test_block_Share (void)
+{
+    block_t *block = block_Alloc (sizeof (text));
+    assert (block != NULL);
+
+    memcpy (block->p_buffer, text, sizeof (text));
+    block->i_pts = 42;
+    block = block_Shareable (block);
+    assert (block != NULL);
+    assert (block->i_buffer == sizeof (text));
+    assert (block->i_pts == 42);
+
+    block_t *shared = block_Share (block);
+    assert (shared != NULL);
+    assert (shared->p_buffer == block->p_buffer);
+    assert (shared->i_pts == 42);
+    assert (block_Shareable (shared) == shared);
+
+    /* The properties are not shared */
+    shared->i_pts = 43;
+    assert (block->i_pts == 42);
+
+    /* The payload outlives the first block */
+    block_Release (block);
+    block = block_Share (shared);
+    assert (block != NULL);
+
+    /* Shrinking does not copy, growing does */
+    const uint8_t *payload = shared->p_buffer;
+    shared = block_Realloc (shared, -5, sizeof (text) - 5);
+    assert (shared != NULL);
+    assert (shared->p_buffer == payload + 5);
+    assert (shared->i_buffer == sizeof (text) - 10);
+    shared = block_Realloc (shared, 5, sizeof (text));
+    assert (shared != NULL);
+    assert (shared->p_buffer != payload);
+    memset (shared->p_buffer, 'A', 5);
+    assert (!memcmp (shared->p_buffer + 5, text + 5, sizeof (text) - 10));
+    assert (!memcmp (block->p_buffer, text, sizeof (text)));
+    block_Release (shared);
+
+    block = block_Realloc (block, 0, 0);
+    assert (block != NULL);
+    block = block_Realloc (block, 0, 4);
+    assert (block != NULL);
+    assert (block->p_buffer != payload);
+    block_Release (block);
+}
+
 int main (void)
 {
     test_block_File(false);
     test_block_File(true);
     test_block ();
+    test_block_Share ();
     return 0;
 }
 
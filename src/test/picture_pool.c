@@ -22,7 +22,9 @@
 # include "config.h"
 #endif
 
+#include <inttypes.h>
 #include <stdbool.h>
+#include <stdio.h>
 #undef NDEBUG
 #include <assert.h>
 
@@ -106,6 +108,68 @@ static void test(bool zombie)
             picture_Release(pics[i]);
 }
 
+#define BENCH_THREADS 4
+#define BENCH_ITERATIONS 100000
+
+struct bench
+{
+    picture_pool_t *pool;
+    bool wait;
+};
+
+static void *bench_thread(void *data)
+{
+    const struct bench *bench = data;
+
+    for (unsigned i = 0; i < BENCH_ITERATIONS; i++) {
+        picture_t *pic;
+
+        if (bench->wait)
+            pic = picture_pool_Wait(bench->pool);
+        else
+            while ((pic = picture_pool_Get(bench->pool)) == NULL);
+
+        assert(pic != NULL);
+        picture_Release(pic);
+    }
+    return NULL;
+}
+
+/* Gets and releases pictures from several threads at once, with fewer
+ * pictures than threads for the waiting case */
+static void bench(unsigned count, bool wait)
+{
+    vlc_thread_t threads[BENCH_THREADS];
+    struct bench bench = { .wait = wait };
+
+    bench.pool = picture_pool_NewFromFormat(&fmt, count);
+    assert(bench.pool != NULL);
+
+    mtime_t ts = mdate();
+    for (unsigned i = 0; i < BENCH_THREADS; i++)
+        assert(vlc_clone(&threads[i], bench_thread, &bench,
+                         VLC_THREAD_PRIORITY_LOW) == 0);
+    for (unsigned i = 0; i < BENCH_THREADS; i++)
+        vlc_join(threads[i], NULL);
+    ts = mdate() - ts;
+
+    /* All the pictures must be back */
+    picture_t *pics[PICTURES];
+    assert(count <= PICTURES);
+    for (unsigned i = 0; i < count; i++) {
+        pics[i] = picture_pool_Get(bench.pool);
+        assert(pics[i] != NULL);
+    }
+    assert(picture_pool_Get(bench.pool) == NULL);
+    for (unsigned i = 0; i < count; i++)
+        picture_Release(pics[i]);
+    picture_pool_Release(bench.pool);
+
+    printf("%u threads, %u pictures, %s: %"PRId64" ns per picture\n",
+           BENCH_THREADS, count, wait ? "wait" : "get",
+           ts * 1000 / (BENCH_THREADS * BENCH_ITERATIONS));
+}
+
 int main(void)
 {
     video_format_Setup(&fmt, VLC_CODEC_I420, 320, 200, 320, 200, 1, 1);
@@ -123,5 +187,8 @@ int main(void)
     test(false);
     test(true);
 
+    bench(PICTURES, false);
+    bench(BENCH_THREADS / 2, true);
+
     return 0;
 }
@@ -49,6 +49,58 @@ static void callback (void *ptr)
 }
 
 
+#define TIMERS 100
+
+static void callback_many (void *ptr)
+{
+    struct timer_data *data = ptr;
+
+    vlc_mutex_lock (&data->lock);
+    data->count++;
+    vlc_cond_signal (&data->wait);
+    vlc_mutex_unlock (&data->lock);
+}
+
+/* Many timers, over several levels of the timer wheel */
+static void test_many (void)
+{
+    struct timer_data data;
+    vlc_timer_t timers[TIMERS];
+    vlc_timer_stats_t stats;
+    mtime_t ts = mdate ();
+    int val;
+
+    vlc_mutex_init (&data.lock);
+    vlc_cond_init (&data.wait);
+    data.count = 0;
+
+    for (unsigned i = 0; i < TIMERS; i++)
+    {
+        val = vlc_timer_create (&timers[i], callback_many, &data);
+        assert (val == 0);
+        vlc_timer_schedule (timers[i], true,
+                            ts + (i + 1) * (CLOCK_FREQ / 200), 0);
+    }
+
+    vlc_timer_getstats (&stats);
+    assert (stats.timers >= TIMERS);
+
+    vlc_mutex_lock (&data.lock);
+    while (data.count < TIMERS)
+        vlc_cond_wait (&data.wait, &data.lock);
+    vlc_mutex_unlock (&data.lock);
+    assert (mdate () - ts >= TIMERS * (CLOCK_FREQ / 200));
+
+    vlc_timer_getstats (&stats);
+    printf ("%u timers on %u threads, latency avg %"PRId64" max %"PRId64" us\n",
+            stats.timers, stats.threads, stats.latency_avg, stats.latency_max);
+
+    for (unsigned i = 0; i < TIMERS; i++)
+        vlc_timer_destroy (timers[i]);
+    vlc_cond_destroy (&data.wait);
+    vlc_mutex_destroy (&data.lock);
+}
+
 int main (void)
 {
     struct timer_data data;
@@ -83,11 +135,13 @@ int main (void)
 
     ts = mdate () - ts;
     printf ("%u iterations in %"PRId64" us\n", data.count, ts);
-    data.count = 0;
     vlc_mutex_unlock (&data.lock);
     assert(ts >= (CLOCK_FREQ / 10));
 
     vlc_timer_schedule (data.timer, false, 0, 0);
+    vlc_mutex_lock (&data.lock);
+    data.count = 0;
+    vlc_mutex_unlock (&data.lock);
 
     /* Absolute timer */
     ts = mdate ();
@@ -108,5 +162,6 @@ int main (void)
     vlc_cond_destroy (&data.wait);
     vlc_mutex_destroy (&data.lock);
 
+    test_many ();
     return 0;
 }
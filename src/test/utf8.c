@@ -93,6 +93,31 @@ static void test (const char *in, const char *out)
     free (str);
 }
 
+/* Long enough for the vector scanners, at every alignment */
+static void test_span (const char *suffix, size_t want_extra)
+{
+    char buf[16 + 64 + 8];
+
+    printf ("\"%s\" suffix should span %zu bytes...\n", suffix, want_extra);
+
+    for (size_t offset = 0; offset < 16; offset++)
+        for (size_t ascii = 0; ascii < 64; ascii++)
+        {
+            char *str = buf + offset;
+
+            memset (str, 'a', ascii);
+            strcpy (str + ascii, suffix);
+
+            size_t len = vlc_utf8_span (str);
+            if (len != ascii + want_extra)
+            {
+                printf (" ERROR: got %zu bytes after %zu ASCII bytes\n",
+                        len, ascii);
+                exit (20);
+            }
+        }
+}
+
 static void test_strcasestr (const char *h, const char *n, ssize_t offset)
 {
     printf ("\"%s\" should %sbe found in \"%s\"...\n", n,
@@ -178,6 +203,13 @@ int main (void)
 
     test ("Hel\xF0\x83\x85\x87lo", "Hel????lo"); /* more overlong */
 
+    test_span ("", 0);
+    test_span ("\x7F", 1);
+    test_span ("\xC3\xA9z", 3);
+    test_span ("\xE2\x82\xAC\xFF", 3);
+    test_span ("\x80", 0);
+    test_span ("z\xED\xA0\x80", 1);
+
     test_strcasestr ("", "", 0);
     test_strcasestr ("", "a", -1);
     test_strcasestr ("a", "", 0);
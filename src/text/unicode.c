@@ -32,6 +32,7 @@
 
 #include "libvlc.h"
 #include <vlc_charset.h>
+#include <vlc_cpu.h>
 
 #include <assert.h>
 
@@ -44,6 +45,12 @@
 #endif
 #include <errno.h>
 #include <wctype.h>
+#ifdef HAVE_SSE2_INTRINSICS
+#  include <emmintrin.h>
+#endif
+#ifdef __ARM_NEON
+#  include <arm_neon.h>
+#endif
 
 /**
  * Formats an UTF-8 string as vfprintf(), then print it, with
@@ -184,6 +191,88 @@ size_t vlc_towc (const char *str, uint32_t *restrict pwc)
     return charlen;
 }
 
+/* The vector scanners only use aligned loads: those never cross a page
+ * boundary, so they cannot fault past the null terminator. */
+#ifdef HAVE_SSE2_INTRINSICS
+__attribute__ ((__target__ ("sse2")))
+static const char *ascii_skip_sse2 (const char *p)
+{
+    const __m128i zero = _mm_setzero_si128 ();
+
+    for (;;)
+    {
+        __m128i v = _mm_load_si128 ((const __m128i *)p);
+        /* The sign bit is set for non-ASCII and null bytes */
+        unsigned mask = _mm_movemask_epi8 (_mm_or_si128 (v,
+                                                _mm_cmpeq_epi8 (v, zero)));
+        if (mask)
+            return p + ctz (mask);
+        p += 16;
+    }
+}
+#endif
+
+#ifdef __ARM_NEON
+static const char *ascii_skip_neon (const char *p)
+{
+    const uint8x16_t zero = vdupq_n_u8 (0);
+
+    for (;;)
+    {
+        uint8x16_t v = vld1q_u8 ((const uint8_t *)p);
+        uint64x2_t mask = vreinterpretq_u64_u8 (vshrq_n_u8 (vorrq_u8 (v,
+                                                  vceqq_u8 (v, zero)), 7));
+        if (vgetq_lane_u64 (mask, 0) | vgetq_lane_u64 (mask, 1))
+            break; /* the scalar loop finds the byte in these 16 */
+        p += 16;
+    }
+    return p;
+}
+#endif
+
+/**
+ * Skips the leading non-null ASCII characters of a string.
+ */
+static const char *ascii_skip (const char *p)
+{
+    /* 0 and 0x80-0xFF both wrap to 0x7F or more */
+    while (((uintptr_t)p & 15) != 0)
+        if ((unsigned char)*p - 1u >= 0x7F)
+            return p;
+        else
+            p++;
+
+#if defined (HAVE_SSE2_INTRINSICS)
+    if (vlc_CPU_SSE2 ())
+        return ascii_skip_sse2 (p);
+#elif defined (__ARM_NEON)
+    p = ascii_skip_neon (p);
+#endif
+    while ((unsigned char)*p - 1u < 0x7F)
+        p++;
+    return p;
+}
+
+size_t vlc_utf8_span (const char *str)
+{
+    const char *p = str;
+
+    for (;;)
+    {
+        uint32_t cp;
+        size_t n;
+
+        /* Text is mostly ASCII, even in the other scripts (markup, digits,
+         * white spaces...) */
+        p = ascii_skip (p);
+        n = vlc_towc (p, &cp);
+        if (n == 0 || n == (size_t)-1)
+            break;
+        p += n;
+    }
+    return p - str;
+}
+
 /**
  * Look for an UTF-8 string within another one in a case-insensitive fashion.
  * Beware that this is quite slow. Contrary to strcasestr(), this function
@@ -228,6 +317,21 @@ char *vlc_strcasestr (const char *haystack, const char *needle)
     return NULL;
 }
 
+/* Character sets where the ASCII characters have their ASCII codes, and
+ * are never part of multibyte sequences */
+static bool IsASCIICompatible (const char *charset)
+{
+    static const char prefixes[][12] = {
+        "ASCII", "US-ASCII", "ANSI_X3.4", "ISO-8859-", "ISO8859-", "ISO_8859-",
+        "LATIN", "CP125", "WINDOWS-125", "KOI8-",
+    };
+
+    for (size_t i = 0; i < ARRAY_SIZE(prefixes); i++)
+        if (!strncasecmp (charset, prefixes[i], strlen (prefixes[i])))
+            return true;
+    return false;
+}
+
 /**
  * Converts a string from the given character encoding to utf-8.
  *
@@ -236,6 +340,24 @@ char *vlc_strcasestr (const char *haystack, const char *needle)
  */
 char *FromCharset(const char *charset, const void *data, size_t data_size)
 {
+    /* Pure ASCII and UTF-8 input are copied as is */
+    bool utf8 = !strcasecmp (charset, "UTF-8") || !strcasecmp (charset, "UTF8");
+
+    if (utf8 || IsASCIICompatible (charset))
+    {
+        char *out = malloc (data_size + 1);
+        if (unlikely(out == NULL))
+            return NULL;
+        memcpy (out, data, data_size);
+        out[data_size] = '\0';
+
+        /* Embedded nulls are left to iconv */
+        size_t len = utf8 ? vlc_utf8_span (out) : (size_t)(ascii_skip (out) - out);
+        if (len == data_size)
+            return out;
+        free (out);
+    }
+
     vlc_iconv_t handle = vlc_iconv_open ("UTF-8", charset);
     if (handle == (vlc_iconv_t)(-1))
         return NULL;
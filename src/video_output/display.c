@@ -600,6 +600,13 @@ static void VoutDisplayEvent(vout_display_t *vd, int event, va_list args)
                                      va_arg(args, const vlc_viewpoint_t *));
         break;
 
+    case VOUT_DISPLAY_EVENT_PRESENTED: {
+        const mtime_t date = va_arg(args, mtime_t);
+        const mtime_t presented = va_arg(args, mtime_t);
+        vout_SendDisplayEventPresented(osys->vout, date, presented);
+        break;
+    }
+
 #if defined(_WIN32) || defined(__OS2__)
     case VOUT_DISPLAY_EVENT_FULLSCREEN: {
         const int is_fullscreen = (int)va_arg(args, int);
@@ -33,6 +33,8 @@ vout_display_t *vout_NewSplitter(vout_thread_t *vout,
 
 /* FIXME should not be there */
 void vout_SendDisplayEventMouse(vout_thread_t *, const vlc_mouse_t *);
+void vout_SendDisplayEventPresented(vout_thread_t *, mtime_t date,
+                                    mtime_t presented);
 
 vout_window_t *vout_NewDisplayWindow(vout_thread_t *, unsigned type);
 void vout_DeleteDisplayWindow(vout_thread_t *, vout_window_t *);
@@ -40,6 +40,24 @@
 
 #include "snapshot.h"
 #include "vout_internal.h"
+#include "../misc/background_worker.h"
+
+struct vout_snapshot_async {
+    vout_snapshot_async_t *next;
+    atomic_uint           refs;
+    vout_snapshot_t       *snap;
+
+    vlc_object_t     *obj;
+    picture_t        *picture;
+    vlc_fourcc_t     codec;
+    int              quality;
+    int              width;
+    int              height;
+
+    vout_snapshot_cb cb;
+    void             *opaque;
+    bool             delivered;
+};
 
 /* */
 void vout_snapshot_Init(vout_snapshot_t *snap)
@@ -50,9 +68,16 @@ void vout_snapshot_Init(vout_snapshot_t *snap)
     snap->is_available = true;
     snap->request_count = 0;
     snap->picture = NULL;
+
+    snap->async = NULL;
+    snap->worker = NULL;
+    atomic_init(&snap->async_pending, 0);
+    snap->async_last = VLC_TS_INVALID;
 }
 void vout_snapshot_Clean(vout_snapshot_t *snap)
 {
+    assert(snap->async == NULL && snap->worker == NULL);
+
     picture_t *picture = snap->picture;
     while (picture) {
         picture_t *next = picture->p_next;
@@ -64,14 +89,100 @@ void vout_snapshot_Clean(vout_snapshot_t *snap)
     vlc_mutex_destroy(&snap->lock);
 }
 
+static void AsyncHold(void *entity)
+{
+    vout_snapshot_async_t *req = entity;
+
+    atomic_fetch_add(&req->refs, 1);
+}
+
+/* It may be called with the worker lock held, and so it must not lock the
+ * snapshot one */
+static void AsyncRelease(void *entity)
+{
+    vout_snapshot_async_t *req = entity;
+
+    if (atomic_fetch_sub(&req->refs, 1) != 1)
+        return;
+
+    if (!req->delivered)
+        req->cb(req->opaque, NULL, NULL);
+    if (req->picture)
+        picture_Release(req->picture);
+    atomic_fetch_sub(&req->snap->async_pending, 1);
+    free(req);
+}
+
+/* The encoding is done synchronously by the worker thread */
+static int AsyncStart(void *owner, void *entity, void **out)
+{
+    vout_snapshot_async_t *req = entity;
+    block_t *image;
+    video_format_t fmt;
+
+    VLC_UNUSED(owner);
+
+    /* The encoders inherit the quality from this object */
+    vlc_object_t *obj = vlc_object_create(req->obj, sizeof(*obj));
+    if (!obj)
+        return VLC_ENOMEM;
+    if (req->quality >= 0) {
+        var_Create(obj, "sout-jpeg-quality", VLC_VAR_INTEGER);
+        var_SetInteger(obj, "sout-jpeg-quality", req->quality);
+    }
+
+    video_format_Init(&fmt, 0);
+    if (picture_Export(obj, &image, &fmt, req->picture, req->codec,
+                       req->width, req->height)) {
+        msg_Err(req->obj, "Failed to convert image for snapshot");
+        image = NULL;
+    }
+    vlc_object_release(obj);
+
+    picture_Release(req->picture);
+    req->picture = NULL;
+
+    req->cb(req->opaque, image, image ? &fmt : NULL);
+    req->delivered = true;
+
+    *out = req;
+    return VLC_SUCCESS;
+}
+
+static int AsyncProbe(void *owner, void *handle)
+{
+    VLC_UNUSED(owner); VLC_UNUSED(handle);
+    return 1;
+}
+
+static void AsyncStop(void *owner, void *handle)
+{
+    VLC_UNUSED(owner); VLC_UNUSED(handle);
+}
+
 void vout_snapshot_End(vout_snapshot_t *snap)
 {
     vlc_mutex_lock(&snap->lock);
 
     snap->is_available = false;
 
+    vout_snapshot_async_t *async = snap->async;
+    struct background_worker *worker = snap->worker;
+    snap->async = NULL;
+    snap->worker = NULL;
+
     vlc_cond_broadcast(&snap->wait);
     vlc_mutex_unlock(&snap->lock);
+
+    /* Waits for the pending encodings */
+    if (worker)
+        background_worker_Delete(worker);
+
+    while (async) {
+        vout_snapshot_async_t *next = async->next;
+        AsyncRelease(async);
+        async = next;
+    }
 }
 
 /* */
@@ -100,12 +211,73 @@ picture_t *vout_snapshot_Get(vout_snapshot_t *snap, mtime_t timeout)
     return picture;
 }
 
+int vout_snapshot_GetAsync(vout_snapshot_t *snap, vlc_object_t *obj,
+                           vlc_fourcc_t codec, int quality,
+                           int width, int height, mtime_t interval,
+                           vout_snapshot_cb cb, void *opaque)
+{
+    const mtime_t now = mdate();
+
+    vout_snapshot_async_t *req = malloc(sizeof(*req));
+    if (unlikely(req == NULL))
+        return VLC_ENOMEM;
+
+    atomic_init(&req->refs, 1);
+    req->snap = snap;
+    req->obj = obj;
+    req->picture = NULL;
+    req->codec = codec;
+    req->quality = quality;
+    req->width = width;
+    req->height = height;
+    req->cb = cb;
+    req->opaque = opaque;
+    req->delivered = false;
+
+    vlc_mutex_lock(&snap->lock);
+
+    if (!snap->is_available ||
+        atomic_load(&snap->async_pending) >= VOUT_SNAPSHOT_ASYNC_MAX ||
+        (snap->async_last > VLC_TS_INVALID &&
+         now - snap->async_last < interval))
+        goto error;
+
+    if (!snap->worker) {
+        struct background_worker_config conf = {
+            .default_timeout = -1,
+            .max_threads = 1,
+            .pf_start = AsyncStart,
+            .pf_probe = AsyncProbe,
+            .pf_stop = AsyncStop,
+            .pf_release = AsyncRelease,
+            .pf_hold = AsyncHold,
+        };
+        snap->worker = background_worker_New(snap, &conf);
+        if (!snap->worker)
+            goto error;
+    }
+
+    atomic_fetch_add(&snap->async_pending, 1);
+    snap->async_last = now;
+
+    req->next = snap->async;
+    snap->async = req;
+
+    vlc_mutex_unlock(&snap->lock);
+    return VLC_SUCCESS;
+
+error:
+    vlc_mutex_unlock(&snap->lock);
+    free(req);
+    return VLC_EGENERIC;
+}
+
 /* */
 bool vout_snapshot_IsRequested(vout_snapshot_t *snap)
 {
     bool has_request = false;
     if (!vlc_mutex_trylock(&snap->lock)) {
-        has_request = snap->request_count > 0;
+        has_request = snap->request_count > 0 || snap->async != NULL;
         vlc_mutex_unlock(&snap->lock);
     }
     return has_request;
@@ -129,6 +301,30 @@ void vout_snapshot_Set(vout_snapshot_t *snap,
         snap->picture = dup;
         snap->request_count--;
     }
+
+    if (snap->async) {
+        /* The encoding may take a while, do not keep a picture of the
+         * display pool meanwhile */
+        picture_t *copy = picture_NewFromFormat(&picture->format);
+        if (copy) {
+            picture_Copy(copy, picture);
+            video_format_CopyCrop(&copy->format, fmt);
+        }
+
+        while (snap->async) {
+            vout_snapshot_async_t *req = snap->async;
+            snap->async = req->next;
+
+            if (copy) {
+                req->picture = picture_Hold(copy);
+                background_worker_Push(snap->worker, req, NULL, -1);
+            }
+            AsyncRelease(req);
+        }
+        if (copy)
+            picture_Release(copy);
+    }
+
     vlc_cond_broadcast(&snap->wait);
     vlc_mutex_unlock(&snap->lock);
 }
@@ -25,6 +25,10 @@
 #define LIBVLC_VOUT_INTERNAL_SNAPSHOT_H
 
 #include <vlc_picture.h>
+#include <vlc_vout.h>
+#include <vlc_atomic.h>
+
+typedef struct vout_snapshot_async vout_snapshot_async_t;
 
 typedef struct {
     vlc_mutex_t lock;
@@ -34,6 +38,11 @@ typedef struct {
     int         request_count;
     picture_t   *picture;
 
+    /* Asynchronous requests waiting for a picture */
+    vout_snapshot_async_t     *async;
+    struct background_worker  *worker;
+    atomic_uint               async_pending;
+    mtime_t                   async_last;
 } vout_snapshot_t;
 
 /* */
@@ -45,6 +54,19 @@ void vout_snapshot_End(vout_snapshot_t *);
 /* */
 picture_t *vout_snapshot_Get(vout_snapshot_t *, mtime_t timeout);
 
+/**
+ * It requests a snapshot encoded by a background thread.
+ *
+ * The request is refused if VOUT_SNAPSHOT_ASYNC_MAX snapshots are already
+ * pending, or if the previous one was requested less than interval ago.
+ */
+int vout_snapshot_GetAsync(vout_snapshot_t *, vlc_object_t *,
+                           vlc_fourcc_t codec, int quality,
+                           int width, int height, mtime_t interval,
+                           vout_snapshot_cb, void *opaque);
+
+#define VOUT_SNAPSHOT_ASYNC_MAX 4
+
 /**
  * It tells if they are pending snapshot request
  */
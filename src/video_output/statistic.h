@@ -24,6 +24,56 @@
 #ifndef LIBVLC_VOUT_STATISTIC_H
 # define LIBVLC_VOUT_STATISTIC_H
 # include <vlc_atomic.h>
+# include <vlc_vout.h>
+
+/* Durations histogram, only written by the vout thread, so the buckets,
+ * the sum and the maximum might be a little out of sync when read from
+ * another thread. */
+typedef struct {
+    atomic_uint_least64_t buckets[VOUT_TIMING_BUCKETS];
+    atomic_uint_least64_t sum;
+    atomic_uint_least64_t max;
+} vout_histogram_t;
+
+static inline void vout_histogram_Init(vout_histogram_t *h)
+{
+    for (unsigned i = 0; i < VOUT_TIMING_BUCKETS; i++)
+        atomic_init(&h->buckets[i], 0);
+    atomic_init(&h->sum, 0);
+    atomic_init(&h->max, 0);
+}
+
+static inline void vout_histogram_Add(vout_histogram_t *h, mtime_t duration)
+{
+    const uint64_t d = duration > 0 ? duration : 0;
+
+    /* Bucket i counts the durations below VOUT_TIMING_BUCKET_LIMIT(i) */
+    unsigned i = 0;
+    for (uint64_t limit = VOUT_TIMING_BUCKET_LIMIT(0);
+         d >= limit && i < VOUT_TIMING_BUCKETS - 1; limit *= 2)
+        i++;
+
+    atomic_fetch_add_explicit(&h->buckets[i], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->sum, d, memory_order_relaxed);
+    if (d > atomic_load_explicit(&h->max, memory_order_relaxed))
+        atomic_store_explicit(&h->max, d, memory_order_relaxed);
+}
+
+static inline void vout_histogram_Get(vout_histogram_t *h,
+                                      vout_timing_histogram_t *out)
+{
+    out->count = 0;
+    for (unsigned i = 0; i < VOUT_TIMING_BUCKETS; i++) {
+        out->buckets[i] = atomic_load_explicit(&h->buckets[i],
+                                               memory_order_relaxed);
+        out->count += out->buckets[i];
+    }
+    out->sum = atomic_load_explicit(&h->sum, memory_order_relaxed);
+    out->max = atomic_load_explicit(&h->max, memory_order_relaxed);
+}
+
+/* Number of queued pictures of which the queuing date is kept */
+#define VOUT_STATISTIC_QUEUED 32
 
 /* NOTE: Both statistics are atomic on their own, so one might be older than
  * the other one. Currently, only one of them is updated at a time, so this
@@ -31,17 +81,45 @@
 typedef struct {
     atomic_uint displayed;
     atomic_uint lost;
+
+    /* Frame timings */
+    vout_histogram_t latency;
+    vout_histogram_t late;
+    vout_histogram_t prepare;
+    vout_histogram_t display;
+    vout_histogram_t interval;
+    vout_histogram_t presented;
+
+    /* Dates at which the last pictures were queued by the decoder */
+    vlc_mutex_t lock;
+    struct {
+        mtime_t date;
+        mtime_t queued;
+    } queued[VOUT_STATISTIC_QUEUED];
+    unsigned queued_index;
 } vout_statistic_t;
 
 static inline void vout_statistic_Init(vout_statistic_t *stat)
 {
     atomic_init(&stat->displayed, 0);
     atomic_init(&stat->lost, 0);
+
+    vout_histogram_Init(&stat->latency);
+    vout_histogram_Init(&stat->late);
+    vout_histogram_Init(&stat->prepare);
+    vout_histogram_Init(&stat->display);
+    vout_histogram_Init(&stat->interval);
+    vout_histogram_Init(&stat->presented);
+
+    vlc_mutex_init(&stat->lock);
+    for (unsigned i = 0; i < VOUT_STATISTIC_QUEUED; i++)
+        stat->queued[i].date = VLC_TS_INVALID;
+    stat->queued_index = 0;
 }
 
 static inline void vout_statistic_Clean(vout_statistic_t *stat)
 {
-    (void) stat;
+    vlc_mutex_destroy(&stat->lock);
 }
 
 static inline void vout_statistic_GetReset(vout_statistic_t *stat,
@@ -63,4 +141,46 @@ static inline void vout_statistic_AddLost(vout_statistic_t *stat, int lost)
     atomic_fetch_add(&stat->lost, lost);
 }
 
+/* Keeps the date at which a picture is queued for display */
+static inline void vout_statistic_AddQueued(vout_statistic_t *stat,
+                                            mtime_t date, mtime_t queued)
+{
+    vlc_mutex_lock(&stat->lock);
+    stat->queued[stat->queued_index].date   = date;
+    stat->queued[stat->queued_index].queued = queued;
+    stat->queued_index = (stat->queued_index + 1) % VOUT_STATISTIC_QUEUED;
+    vlc_mutex_unlock(&stat->lock);
+}
+
+/* Returns the date at which the decoded picture a displayed picture comes
+ * from was queued, that is the last one not after it, or VLC_TS_INVALID */
+static inline mtime_t vout_statistic_GetQueued(vout_statistic_t *stat,
+                                               mtime_t date)
+{
+    mtime_t source = VLC_TS_INVALID;
+    mtime_t queued = VLC_TS_INVALID;
+
+    vlc_mutex_lock(&stat->lock);
+    for (unsigned i = 0; i < VOUT_STATISTIC_QUEUED; i++) {
+        if (stat->queued[i].date > VLC_TS_INVALID &&
+            stat->queued[i].date <= date && stat->queued[i].date > source) {
+            source = stat->queued[i].date;
+            queued = stat->queued[i].queued;
+        }
+    }
+    vlc_mutex_unlock(&stat->lock);
+    return queued;
+}
+
+static inline void vout_statistic_GetTiming(vout_statistic_t *stat,
+                                            vout_timing_t *timing)
+{
+    vout_histogram_Get(&stat->latency,  &timing->latency);
+    vout_histogram_Get(&stat->late,     &timing->late);
+    vout_histogram_Get(&stat->prepare,  &timing->prepare);
+    vout_histogram_Get(&stat->display,  &timing->display);
+    vout_histogram_Get(&stat->interval, &timing->interval);
+    vout_histogram_Get(&stat->presented, &timing->presented);
+}
+
 #endif
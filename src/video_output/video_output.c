@@ -47,6 +47,7 @@
 #include <vlc_vout_osd.h>
 #include <vlc_image.h>
 #include <vlc_plugin.h>
+#include <vlc_trace.h>
 
 #include <libvlc.h>
 #include "vout_internal.h"
@@ -74,6 +75,9 @@ static void VoutDestructor(vlc_object_t *);
 /* Better be in advance when awakening than late... */
 #define VOUT_MWAIT_TOLERANCE (INT64_C(4000))
 
+/* Period of the frame timings variables update */
+#define VOUT_TIMING_PERIOD (CLOCK_FREQ)
+
 /* */
 static int VoutValidateFormat(video_format_t *dst,
                               const video_format_t *src)
@@ -139,6 +143,8 @@ static vout_thread_t *VoutCreate(vlc_object_t *object,
     vout_control_PushVoid(&vout->p->control, VOUT_CONTROL_INIT);
 
     vout_statistic_Init(&vout->p->statistic);
+    vout->p->timing.published = VLC_TS_INVALID;
+    memset(&vout->p->timing.previous, 0, sizeof(vout->p->timing.previous));
 
     vout_snapshot_Init(&vout->p->snapshot);
 
@@ -328,6 +334,11 @@ void vout_GetResetStatistic(vout_thread_t *vout, unsigned *restrict displayed,
     vout_statistic_GetReset( &vout->p->statistic, displayed, lost );
 }
 
+void vout_GetTiming(vout_thread_t *vout, vout_timing_t *timing)
+{
+    vout_statistic_GetTiming(&vout->p->statistic, timing);
+}
+
 void vout_Flush(vout_thread_t *vout, mtime_t date)
 {
     vout_control_PushTime(&vout->p->control, VOUT_CONTROL_FLUSH, date);
@@ -427,6 +438,7 @@ void vout_PutPicture(vout_thread_t *vout, picture_t *picture)
     picture->p_next = NULL;
     if (picture_pool_OwnsPic(vout->p->decoder_pool, picture))
     {
+        vout_statistic_AddQueued(&vout->p->statistic, picture->date, mdate());
         picture_fifo_Push(vout->p->decoder_fifo, picture);
 
         vout_control_Wake(&vout->p->control);
@@ -474,6 +486,27 @@ int vout_GetSnapshot(vout_thread_t *vout,
     return VLC_SUCCESS;
 }
 
+int vout_GetSnapshotAsync(vout_thread_t *vout, const char *type, int quality,
+                          vout_snapshot_cb cb, void *opaque)
+{
+    vlc_fourcc_t codec = VLC_CODEC_PNG;
+    if (type && image_Type2Fourcc(type))
+        codec = image_Type2Fourcc(type);
+
+    const int override_width  = var_InheritInteger(vout, "snapshot-width");
+    const int override_height = var_InheritInteger(vout, "snapshot-height");
+    const mtime_t interval =
+        var_InheritInteger(vout, "snapshot-interval") * (CLOCK_FREQ / 1000);
+
+    if (vout_snapshot_GetAsync(&vout->p->snapshot, VLC_OBJECT(vout), codec,
+                               quality, override_width, override_height,
+                               interval, cb, opaque)) {
+        msg_Warn(vout, "Snapshot request refused");
+        return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
 void vout_ChangeAspectRatio( vout_thread_t *p_vout,
                              unsigned int i_num, unsigned int i_den )
 {
@@ -630,6 +663,14 @@ void vout_DeleteDisplayWindow(vout_thread_t *vout, vout_window_t *window)
     assert(vout->p->window == window);
 }
 
+void vout_SendDisplayEventPresented(vout_thread_t *vout, mtime_t date,
+                                    mtime_t presented)
+{
+    /* Sent from the display callbacks, so on the vout thread */
+    if (date > VLC_TS_INVALID)
+        vout_histogram_Add(&vout->p->statistic.presented, presented - date);
+}
+
 void vout_SetDisplayWindowSize(vout_thread_t *vout,
                                unsigned width, unsigned height)
 {
@@ -844,6 +885,44 @@ static void ThreadChangeFilters(vout_thread_t *vout,
 }
 
 
+/* Publishes the average frame timings of the last period as variables */
+static void ThreadPublishTiming(vout_thread_t *vout, mtime_t date)
+{
+    vout_thread_sys_t *sys = vout->p;
+
+    if (sys->timing.published > VLC_TS_INVALID &&
+        date - sys->timing.published < VOUT_TIMING_PERIOD)
+        return;
+    sys->timing.published = date;
+
+    vout_timing_t timing;
+    vout_statistic_GetTiming(&sys->statistic, &timing);
+
+    static const struct {
+        const char *name;
+        size_t offset;
+    } vars[] = {
+        { "stats-latency",   offsetof(vout_timing_t, latency) },
+        { "stats-late",      offsetof(vout_timing_t, late) },
+        { "stats-prepare",   offsetof(vout_timing_t, prepare) },
+        { "stats-display",   offsetof(vout_timing_t, display) },
+        { "stats-interval",  offsetof(vout_timing_t, interval) },
+        { "stats-presented", offsetof(vout_timing_t, presented) },
+    };
+    for (size_t i = 0; i < ARRAY_SIZE(vars); i++) {
+        const vout_timing_histogram_t *now =
+            (const void *)((const char *)&timing + vars[i].offset);
+        const vout_timing_histogram_t *before =
+            (const void *)((const char *)&sys->timing.previous + vars[i].offset);
+        const uint64_t count = now->count - before->count;
+
+        if (count > 0)
+            var_SetInteger(vout, vars[i].name,
+                           (now->sum - before->sum) / count);
+    }
+    sys->timing.previous = timing;
+}
+
 /* */
 static int ThreadDisplayPreparePicture(vout_thread_t *vout, bool reuse, bool frame_by_frame)
 {
@@ -910,9 +989,12 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
     vout_thread_sys_t *sys = vout->p;
     vout_display_t *vd = vout->p->display.vd;
 
+    vlc_trace_Scope("vout render");
+
     picture_t *torender = picture_Hold(vout->p->displayed.current);
 
     vout_chrono_Start(&vout->p->render);
+    const mtime_t prepare_start = mdate();
 
     vlc_mutex_lock(&vout->p->filter.lock);
     picture_t *filtered = filter_chain_VideoFilter(vout->p->filter.chain_interactive, torender);
@@ -1079,6 +1161,7 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
     }
 
     vout_chrono_Stop(&vout->p->render);
+    vout_histogram_Add(&sys->statistic.prepare, mdate() - prepare_start);
 #if 0
         {
         static int i = 0;
@@ -1098,11 +1181,28 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
         mwait(todisplay->date);
 
     /* Display the direct buffer returned by vout_RenderPicture */
-    vout->p->displayed.date = mdate();
+    const mtime_t date = mdate();
+    const mtime_t date_picture = todisplay->date;
+    vout->p->displayed.date = date;
     vout_display_Display(vd, todisplay, subpic);
 
     vout_statistic_AddDisplayed(&vout->p->statistic, 1);
 
+    vout_histogram_Add(&sys->statistic.display, mdate() - date);
+    if (!is_forced) {
+        const mtime_t queued = vout_statistic_GetQueued(&sys->statistic,
+                                                        date_picture);
+        if (queued > VLC_TS_INVALID)
+            vout_histogram_Add(&sys->statistic.latency, date - queued);
+        vout_histogram_Add(&sys->statistic.late, date - date_picture);
+        if (sys->timing.last_display > VLC_TS_INVALID)
+            vout_histogram_Add(&sys->statistic.interval,
+                               date - sys->timing.last_display);
+        sys->timing.last_display = date;
+    } else
+        sys->timing.last_display = VLC_TS_INVALID;
+    ThreadPublishTiming(vout, date);
+
     return VLC_SUCCESS;
 }
 
@@ -1214,6 +1314,8 @@ static void ThreadChangePause(vout_thread_t *vout, bool is_paused, mtime_t date)
 {
     assert(!vout->p->pause.is_on || !is_paused);
 
+    vout->p->timing.last_display = VLC_TS_INVALID;
+
     if (vout->p->pause.is_on) {
         const mtime_t duration = date - vout->p->pause.date;
 
@@ -1243,6 +1345,7 @@ static void ThreadFlush(vout_thread_t *vout, bool below, mtime_t date)
 {
     vout->p->step.timestamp = VLC_TS_INVALID;
     vout->p->step.last      = VLC_TS_INVALID;
+    vout->p->timing.last_display = VLC_TS_INVALID;
 
     ThreadFilterFlush(vout, false); /* FIXME too much */
 
@@ -1466,6 +1569,7 @@ static int ThreadStart(vout_thread_t *vout, vout_display_state_t *state)
     vout->p->displayed.date          = VLC_TS_INVALID;
     vout->p->displayed.timestamp     = VLC_TS_INVALID;
     vout->p->displayed.is_interlaced = false;
+    vout->p->timing.last_display     = VLC_TS_INVALID;
 
     vout->p->step.last               = VLC_TS_INVALID;
     vout->p->step.timestamp          = VLC_TS_INVALID;
@@ -62,6 +62,13 @@ struct vout_thread_sys_t
     /* Statistics */
     vout_statistic_t statistic;
 
+    /* Frame timings published as variables, by the vout thread */
+    struct {
+        mtime_t       last_display;
+        mtime_t       published;
+        vout_timing_t previous;
+    } timing;
+
     /* Subpicture unit */
     vlc_mutex_t     spu_lock;
     spu_t           *spu;
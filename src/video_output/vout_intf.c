@@ -308,6 +308,14 @@ void vout_IntfInit( vout_thread_t *p_vout )
     var_AddCallback( p_vout, "viewpoint", ViewpointCallback, NULL );
     var_Create( p_vout, "viewpoint-changeable", VLC_VAR_BOOL );
 
+    /* Average frame timings (in microseconds) of the last second */
+    var_Create( p_vout, "stats-latency", VLC_VAR_INTEGER );
+    var_Create( p_vout, "stats-late", VLC_VAR_INTEGER );
+    var_Create( p_vout, "stats-prepare", VLC_VAR_INTEGER );
+    var_Create( p_vout, "stats-display", VLC_VAR_INTEGER );
+    var_Create( p_vout, "stats-interval", VLC_VAR_INTEGER );
+    var_Create( p_vout, "stats-presented", VLC_VAR_INTEGER );
+
     vout_IntfReinit( p_vout );
 }
 
@@ -61,11 +61,46 @@ typedef struct {
     spu_heap_entry_t entry[VOUT_MAX_SUBPICTURES];
 } spu_heap_t;
 
+/* Number of rendered text regions kept */
+#define SPU_TEXT_CACHE_SIZE 8
+
+/* A rendered (and possibly scaled) text region, as it was left by
+ * SpuRenderRegion() */
+typedef struct {
+    /* What was rendered */
+    text_segment_t *text;
+    video_format_t source;                    /**< text region format */
+    int            text_align;
+    bool           noregionbg;
+    bool           gridmode;
+    bool           balanced_text;
+    int            max_width;
+    int            max_height;
+    unsigned       render_width;           /**< text renderer output size */
+    unsigned       render_height;
+    vlc_fourcc_t   chroma;                         /**< preferred chroma */
+
+    /* The result */
+    video_format_t fmt;
+    picture_t      *picture;
+    video_format_t scaled_fmt;
+    picture_t      *scaled;                    /**< scaled picture or NULL */
+
+    uint64_t       last_use;
+} spu_text_cache_entry_t;
+
+typedef struct {
+    spu_text_cache_entry_t entry[SPU_TEXT_CACHE_SIZE];
+    uint64_t               uses;
+    uint64_t               hits;
+} spu_text_cache_t;
+
 struct spu_private_t {
     vlc_mutex_t  lock;            /* lock to protect all followings fields */
     vlc_object_t *input;
 
     spu_heap_t   heap;
+    spu_text_cache_t text_cache;
 
     int channel;             /**< number of subpicture channels registered */
     filter_t *text;                              /**< text renderer module */
@@ -159,6 +194,188 @@ static void SpuHeapClean(spu_heap_t *heap)
     }
 }
 
+/*****************************************************************************
+ * text cache management
+ *****************************************************************************/
+static bool TextStyleEqual(const text_style_t *a, const text_style_t *b)
+{
+    if (a == NULL || b == NULL)
+        return a == b;
+
+    return a->i_features == b->i_features &&
+           a->i_style_flags == b->i_style_flags &&
+           a->f_font_relsize == b->f_font_relsize &&
+           a->i_font_size == b->i_font_size &&
+           a->i_font_color == b->i_font_color &&
+           a->i_font_alpha == b->i_font_alpha &&
+           a->i_spacing == b->i_spacing &&
+           a->i_outline_color == b->i_outline_color &&
+           a->i_outline_alpha == b->i_outline_alpha &&
+           a->i_outline_width == b->i_outline_width &&
+           a->i_shadow_color == b->i_shadow_color &&
+           a->i_shadow_alpha == b->i_shadow_alpha &&
+           a->i_shadow_width == b->i_shadow_width &&
+           a->i_background_color == b->i_background_color &&
+           a->i_background_alpha == b->i_background_alpha &&
+           a->i_karaoke_background_color == b->i_karaoke_background_color &&
+           a->i_karaoke_background_alpha == b->i_karaoke_background_alpha &&
+           a->e_wrapinfo == b->e_wrapinfo &&
+           !strcmp(a->psz_fontname ? a->psz_fontname : "",
+                   b->psz_fontname ? b->psz_fontname : "") &&
+           !strcmp(a->psz_monofontname ? a->psz_monofontname : "",
+                   b->psz_monofontname ? b->psz_monofontname : "");
+}
+
+static bool TextSegmentsEqual(const text_segment_t *a, const text_segment_t *b)
+{
+    for (; a != NULL && b != NULL; a = a->p_next, b = b->p_next) {
+        if (strcmp(a->psz_text ? a->psz_text : "",
+                   b->psz_text ? b->psz_text : "") ||
+            !TextStyleEqual(a->style, b->style))
+            return false;
+    }
+    return a == b;
+}
+
+static bool SpuTextCacheMatch(const spu_text_cache_entry_t *entry,
+                              const subpicture_region_t *region,
+                              const video_format_t *source,
+                              const video_format_t *render,
+                              vlc_fourcc_t chroma)
+{
+    return entry->picture != NULL &&
+           entry->chroma == chroma &&
+           entry->render_width  == render->i_width &&
+           entry->render_height == render->i_height &&
+           entry->source.i_width  == source->i_width &&
+           entry->source.i_height == source->i_height &&
+           entry->source.i_visible_width  == source->i_visible_width &&
+           entry->source.i_visible_height == source->i_visible_height &&
+           entry->source.i_sar_num == source->i_sar_num &&
+           entry->source.i_sar_den == source->i_sar_den &&
+           entry->text_align    == region->i_text_align &&
+           entry->noregionbg    == region->b_noregionbg &&
+           entry->gridmode      == region->b_gridmode &&
+           entry->balanced_text == region->b_balanced_text &&
+           entry->max_width     == region->i_max_width &&
+           entry->max_height    == region->i_max_height &&
+           TextSegmentsEqual(entry->text, region->p_text);
+}
+
+static void SpuTextCacheEntryClean(spu_text_cache_entry_t *entry)
+{
+    if (entry->picture == NULL)
+        return;
+
+    text_segment_ChainDelete(entry->text);
+    video_format_Clean(&entry->fmt);
+    picture_Release(entry->picture);
+    if (entry->scaled) {
+        video_format_Clean(&entry->scaled_fmt);
+        picture_Release(entry->scaled);
+    }
+    memset(entry, 0, sizeof(*entry));
+}
+
+static void SpuTextCacheClean(spu_text_cache_t *cache)
+{
+    for (int i = 0; i < SPU_TEXT_CACHE_SIZE; i++)
+        SpuTextCacheEntryClean(&cache->entry[i]);
+}
+
+/**
+ * Restores a not yet rendered text region to its rendered (and scaled)
+ * state, if the same text was rendered recently.
+ */
+static bool SpuTextCacheGet(spu_t *spu, subpicture_region_t *region,
+                            const vlc_fourcc_t *chroma_list)
+{
+    spu_text_cache_t *cache = &spu->p->text_cache;
+    const video_format_t *render = &spu->p->text->fmt_out.video;
+
+    cache->uses++;
+    for (int i = 0; i < SPU_TEXT_CACHE_SIZE; i++) {
+        spu_text_cache_entry_t *entry = &cache->entry[i];
+
+        if (!SpuTextCacheMatch(entry, region, &region->fmt, render,
+                               chroma_list[0]))
+            continue;
+
+        video_format_t fmt;
+        if (video_format_Copy(&fmt, &entry->fmt))
+            return false;
+        video_format_Clean(&region->fmt);
+        region->fmt = fmt;
+
+        if (region->p_picture)
+            picture_Release(region->p_picture);
+        region->p_picture = picture_Hold(entry->picture);
+
+        if (entry->scaled && !region->p_private) {
+            region->p_private = subpicture_region_private_New(&entry->scaled_fmt);
+            if (region->p_private)
+                region->p_private->p_picture = picture_Hold(entry->scaled);
+        }
+
+        entry->last_use = cache->uses;
+        cache->hits++;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Keeps the result of the rendering and scaling of a text region.
+ */
+static void SpuTextCachePut(spu_t *spu, const subpicture_region_t *region,
+                            const video_format_t *source,
+                            const vlc_fourcc_t *chroma_list)
+{
+    spu_text_cache_t *cache = &spu->p->text_cache;
+    const video_format_t *render = &spu->p->text->fmt_out.video;
+    spu_text_cache_entry_t *entry = NULL;
+
+    /* Replace the same text, or else the least recently used one */
+    for (int i = 0; i < SPU_TEXT_CACHE_SIZE; i++) {
+        spu_text_cache_entry_t *e = &cache->entry[i];
+
+        if (SpuTextCacheMatch(e, region, source, render, chroma_list[0])) {
+            entry = e;
+            break;
+        }
+        if (entry == NULL || e->last_use < entry->last_use)
+            entry = e;
+    }
+
+    SpuTextCacheEntryClean(entry);
+
+    entry->text = text_segment_Copy(region->p_text);
+    if (entry->text == NULL ||
+        video_format_Copy(&entry->fmt, &region->fmt)) {
+        text_segment_ChainDelete(entry->text);
+        entry->text = NULL;
+        return;
+    }
+    entry->source = *source;
+    entry->source.p_palette = NULL;
+    entry->text_align    = region->i_text_align;
+    entry->noregionbg    = region->b_noregionbg;
+    entry->gridmode      = region->b_gridmode;
+    entry->balanced_text = region->b_balanced_text;
+    entry->max_width     = region->i_max_width;
+    entry->max_height    = region->i_max_height;
+    entry->render_width  = render->i_width;
+    entry->render_height = render->i_height;
+    entry->chroma        = chroma_list[0];
+    entry->picture       = picture_Hold(region->p_picture);
+
+    if (region->p_private && region->p_private->p_picture &&
+        !video_format_Copy(&entry->scaled_fmt, &region->p_private->fmt))
+        entry->scaled = picture_Hold(region->p_private->p_picture);
+
+    entry->last_use = cache->uses;
+}
+
 static void FilterRelease(filter_t *filter)
 {
     if (filter->p_module)
@@ -677,15 +894,28 @@ static void SpuRenderRegion(spu_t *spu,
     *dst_area = spu_area_create(0,0, 0,0, scale_size);
     *dst_ptr  = NULL;
 
-    /* Render text region */
+    /* Render text region, unless the same text was rendered recently */
+    bool cache_text = false;
+    bool cache_hit = false;
+    const picture_t *cached_scaled = NULL;
     if (region->fmt.i_chroma == VLC_CODEC_TEXT) {
-        SpuRenderText(spu, &restore_text, region,
-                      chroma_list,
-                      render_date - subpic->i_start);
+        if (sys->text && region->p_text &&
+            SpuTextCacheGet(spu, region, chroma_list)) {
+            cached_scaled = region->p_private ? region->p_private->p_picture
+                                              : NULL;
+            cache_text = cache_hit = true;
+        } else {
+            SpuRenderText(spu, &restore_text, region,
+                          chroma_list,
+                          render_date - subpic->i_start);
+
+            /* Check if the rendering has failed ... */
+            if (region->fmt.i_chroma == VLC_CODEC_TEXT)
+                goto exit;
 
-        /* Check if the rendering has failed ... */
-        if (region->fmt.i_chroma == VLC_CODEC_TEXT)
-            goto exit;
+            /* Time dependent rendering (karaoke) cannot be reused */
+            cache_text = !restore_text && region->p_text && region->p_picture;
+        }
     }
 
     /* Force palette if requested
@@ -901,6 +1131,12 @@ static void SpuRenderRegion(spu_t *spu,
         }
     }
 
+    /* Keep the text rendering, or update the scaled picture kept with it */
+    if (cache_text &&
+        (!cache_hit ||
+         (region->p_private ? region->p_private->p_picture : NULL) != cached_scaled))
+        SpuTextCachePut(spu, region, &fmt_original, chroma_list);
+
     /* Force cropping if requested */
     if (crop_requested) {
         int crop_x, crop_y, crop_width, crop_height;
@@ -1301,6 +1537,7 @@ spu_t *spu_Create(vlc_object_t *object, vout_thread_t *vout)
     vlc_mutex_init(&sys->lock);
 
     SpuHeapInit(&sys->heap);
+    memset(&sys->text_cache, 0, sizeof(sys->text_cache));
 
     sys->text = NULL;
     sys->scale = NULL;
@@ -1375,6 +1612,11 @@ void spu_Destroy(spu_t *spu)
     /* Destroy all remaining subpictures */
     SpuHeapClean(&sys->heap);
 
+    if (sys->text_cache.uses > 0)
+        msg_Dbg(spu, "text cache: %"PRIu64" hits out of %"PRIu64" renderings",
+                sys->text_cache.hits, sys->text_cache.uses);
+    SpuTextCacheClean(&sys->text_cache);
+
     vlc_mutex_destroy(&sys->lock);
 
     vlc_object_release(spu);
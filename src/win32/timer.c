@@ -26,6 +26,10 @@
 #include <stdlib.h>
 #include <windows.h>
 #include <vlc_common.h>
+#include <vlc_atomic.h>
+
+static atomic_uint timers_count = ATOMIC_VAR_INIT(0);
+static atomic_uint_fast64_t timers_fired = ATOMIC_VAR_INIT(0);
 
 struct vlc_timer
 {
@@ -39,6 +43,7 @@ static void CALLBACK vlc_timer_do (void *val, BOOLEAN timeout)
     struct vlc_timer *timer = val;
 
     assert (timeout);
+    atomic_fetch_add_explicit (&timers_fired, 1, memory_order_relaxed);
     timer->func (timer->data);
 }
 
@@ -51,6 +56,7 @@ int vlc_timer_create (vlc_timer_t *id, void (*func) (void *), void *data)
     timer->func = func;
     timer->data = data;
     timer->handle = INVALID_HANDLE_VALUE;
+    atomic_fetch_add_explicit (&timers_count, 1, memory_order_relaxed);
     *id = timer;
     return 0;
 }
@@ -59,6 +65,7 @@ void vlc_timer_destroy (vlc_timer_t timer)
 {
     if (timer->handle != INVALID_HANDLE_VALUE)
         DeleteTimerQueueTimer (NULL, timer->handle, INVALID_HANDLE_VALUE);
+    atomic_fetch_sub_explicit (&timers_count, 1, memory_order_relaxed);
     free (timer);
 }
 
@@ -92,3 +99,12 @@ unsigned vlc_timer_getoverrun (vlc_timer_t timer)
     (void)timer;
     return 0;
 }
+
+void vlc_timer_getstats (vlc_timer_stats_t *stats)
+{
+    stats->timers = atomic_load_explicit (&timers_count, memory_order_relaxed);
+    stats->threads = 0; /* system thread pool */
+    stats->fired = atomic_load_explicit (&timers_fired, memory_order_relaxed);
+    stats->latency_avg = 0;
+    stats->latency_max = 0;
+}
@@ -0,0 +1,129 @@
+/*****************************************************************************
+ * equalizer.c: equalizer bands filtering tests and benchmark
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <vlc_common.h>
+
+#include "../modules/audio_filter/equalizer_filter.h"
+
+#define SAMPLES 1024
+#define BLOCKS  96
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void setup(eqz_filter_t *eqz, int rate, bool two_pass)
+{
+    /* "rock" preset */
+    static const float db[EQZ_BANDS_MAX] = {
+        8.f, 4.8f, -5.6f, -8.f, -3.2f, 4.f, 8.8f, 11.2f, 11.2f, 11.2f
+    };
+    eqz_config_t cfg;
+
+    EqzCoeffs(rate, 1.0f, true, &cfg);
+    EqzFilterInit(eqz, &cfg);
+    for (int i = 0; i < eqz->i_band; i++)
+        eqz->f_amp[i] = EqzConvertdB(db[i]);
+    eqz->f_gamp = powf(10.f, 6.f / 20.f);
+    eqz->b_2eqz = two_pass;
+}
+
+/* Filters noise with the generic and the selected filters, and compares the
+ * results, which differ by the rounding of the sums of the bands only */
+static void test(int rate, int channels, bool two_pass)
+{
+    eqz_filter_t *ref = malloc(sizeof (*ref));
+    eqz_filter_t *eqz = malloc(sizeof (*eqz));
+    float *in = malloc(SAMPLES * channels * sizeof (float));
+    float *a = malloc(SAMPLES * channels * sizeof (float));
+    float *b = malloc(SAMPLES * channels * sizeof (float));
+    assert(ref && eqz && in && a && b);
+
+    eqz_filter_cb filter = EqzGetFilter();
+    double t_ref = 0., t_eqz = 0., error = 0.;
+
+    setup(ref, rate, two_pass);
+    setup(eqz, rate, two_pass);
+    srand(rate + channels);
+
+    for (unsigned n = 0; n < BLOCKS; n++)
+    {
+        for (int i = 0; i < SAMPLES * channels; i++)
+            in[i] = (rand() / (float)RAND_MAX - .5f) * .5f;
+
+        double start = now();
+        EqzFilterC(ref, a, in, SAMPLES, channels);
+        t_ref += now() - start;
+
+        /* In place, as by the audio filter */
+        memcpy(b, in, SAMPLES * channels * sizeof (float));
+        start = now();
+        filter(eqz, b, b, SAMPLES, channels);
+        t_eqz += now() - start;
+
+        for (int i = 0; i < SAMPLES * channels; i++)
+        {
+            double diff = fabs(a[i] - b[i]);
+            if (diff > error)
+                error = diff;
+        }
+    }
+
+    printf("%6d Hz, %d channels, %d pass: generic %7.2f ns, "
+           "selected %7.2f ns per sample, error %g\n", rate, channels,
+           two_pass ? 2 : 1, t_ref * 1e9 / (BLOCKS * SAMPLES * channels),
+           t_eqz * 1e9 / (BLOCKS * SAMPLES * channels), error);
+    assert(error < 1e-4);
+
+    free(b);
+    free(a);
+    free(in);
+    free(eqz);
+    free(ref);
+}
+
+int main(void)
+{
+    static const int rates[] = { 44100, 96000 };
+    static const int channels[] = { 2, 8 };
+
+    for (size_t i = 0; i < ARRAY_SIZE(rates); i++)
+        for (size_t j = 0; j < ARRAY_SIZE(channels); j++)
+        {
+            test(rates[i], channels[j], false);
+            test(rates[i], channels[j], true);
+        }
+    return 0;
+}
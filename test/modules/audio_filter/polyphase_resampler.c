@@ -0,0 +1,172 @@
+/*****************************************************************************
+ * polyphase_resampler.c: polyphase resampler tests and benchmark
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <vlc_common.h>
+
+#include "../modules/audio_filter/resampler/polyphase.h"
+
+#define CHANNELS 2
+#define FRAMES   1024
+#define BLOCKS   256
+#define FREQ     1000.
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Resamples sines with the generic and the selected filters, the input rate
+ * being adjusted by drift[] in turn, and compares both outputs, and the
+ * selected one to the expected sines */
+static void test(unsigned in_rate, unsigned out_rate, const int *drift,
+                 size_t drifts)
+{
+    poly_resampler_t ref, poly;
+    assert(PolyInit(&ref, CHANNELS, in_rate, out_rate) == VLC_SUCCESS);
+    assert(PolyInit(&poly, CHANNELS, in_rate, out_rate) == VLC_SUCCESS);
+    ref.pf_frame = PolyFrameC;
+
+    const size_t out_max = PolyGetOutLen(&poly, FRAMES, in_rate - 100);
+    float *in = malloc(FRAMES * CHANNELS * sizeof (float));
+    float *a = malloc(out_max * CHANNELS * sizeof (float));
+    float *b = malloc(out_max * CHANNELS * sizeof (float));
+    assert(in && a && b);
+
+    /* Input position of the next output frame */
+    double pos = 0., t_ref = 0., t_poly = 0.;
+    double error = 0., signal = 0., noise = 0.;
+    size_t outputs = 0;
+
+    for (unsigned n = 0; n < BLOCKS; n++)
+    {
+        const unsigned rate = in_rate + drift[n % drifts];
+
+        for (size_t i = 0; i < FRAMES; i++)
+            for (unsigned c = 0; c < CHANNELS; c++)
+                in[i * CHANNELS + c] =
+                    .5 * sin(2. * M_PI * FREQ * (c + 1)
+                             * (n * FRAMES + i) / in_rate);
+
+        double start = now();
+        size_t a_len = PolyProcess(&ref, a, in, FRAMES, rate);
+        t_ref += now() - start;
+
+        start = now();
+        size_t b_len = PolyProcess(&poly, b, in, FRAMES, rate);
+        t_poly += now() - start;
+
+        assert(a_len == b_len);
+        assert(b_len <= out_max);
+
+        /* The phase is dropped if the rates are the same */
+        if (rate == out_rate)
+            pos = floor(pos + 1e-9);
+
+        for (size_t i = 0; i < b_len; i++)
+        {
+            for (unsigned c = 0; c < CHANNELS; c++)
+            {
+                const float x = b[i * CHANNELS + c];
+                double diff = fabs(a[i * CHANNELS + c] - x);
+                if (diff > error)
+                    error = diff;
+
+                /* Skip the filter startup */
+                if (outputs < 4 * POLY_TAPS_MAX)
+                    continue;
+                const double y = .5 * sin(2. * M_PI * FREQ * (c + 1)
+                                          * pos / in_rate);
+                signal += y * y;
+                noise += (x - y) * (x - y);
+            }
+            pos += (double)rate / out_rate;
+            outputs++;
+        }
+    }
+
+    const double snr = 10. * log10(signal / noise);
+    printf("%6u to %6u Hz%s: %3u phases of %3u taps, "
+           "generic %6.2f ns, selected %6.2f ns per frame, "
+           "error %g, SNR %.1f dB\n", in_rate, out_rate,
+           drifts > 1 ? " with drift" : "", poly.i_phases, poly.i_taps,
+           t_ref * 1e9 / outputs, t_poly * 1e9 / outputs, error, snr);
+    assert(error < 1e-5);
+    assert(snr > 70.);
+
+    free(b);
+    free(a);
+    free(in);
+    PolyClean(&poly);
+    PolyClean(&ref);
+}
+
+/* Checks that the input is output as is, only delayed by the history, for
+ * the same rates */
+static void test_bypass(void)
+{
+    poly_resampler_t poly;
+    float buf[FRAMES * CHANNELS];
+
+    assert(PolyInit(&poly, CHANNELS, 48000, 48000) == VLC_SUCCESS);
+    assert(PolyCanBypass(&poly, 48000));
+    assert(!PolyCanBypass(&poly, 48010));
+
+    for (size_t i = 0; i < ARRAY_SIZE(buf); i++)
+        buf[i] = i;
+    assert(PolyProcess(&poly, buf, buf, FRAMES, 48000) == FRAMES);
+    for (size_t i = 0; i < ARRAY_SIZE(buf); i++)
+        assert(buf[i] == i);
+    assert(PolyGetDelay(&poly, 48000) == 0.);
+    PolyClean(&poly);
+}
+
+int main(void)
+{
+    static const int none[] = { 0 };
+    static const int drift[] = { 0, 4, 12, 20, 20, 8, -8, -20, -4, 0 };
+
+    test_bypass();
+    test(44100, 48000, none, ARRAY_SIZE(none));
+    test(48000, 44100, none, ARRAY_SIZE(none));
+    test(48000, 96000, none, ARRAY_SIZE(none));
+    test(96000, 48000, none, ARRAY_SIZE(none));
+    test(44100, 96000, none, ARRAY_SIZE(none));
+    test(96000, 44100, none, ARRAY_SIZE(none));
+    test(22050, 48000, none, ARRAY_SIZE(none));
+    test(11025, 48000, none, ARRAY_SIZE(none));
+    test(44100, 48000, drift, ARRAY_SIZE(drift));
+    test(48000, 48000, drift, ARRAY_SIZE(drift));
+    return 0;
+}
@@ -0,0 +1,164 @@
+/*****************************************************************************
+ * simple_channel_mixer.c: downmix matrices tests and benchmark
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <vlc_common.h>
+
+#include "../modules/audio_filter/channel_mixer/simple_matrix.h"
+
+#define FRAMES 1021 /* not a multiple of the vectors */
+#define BLOCKS 256
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void noise(float *buf, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        buf[i] = (rand() / (float)RAND_MAX - .5f) * 2.f;
+}
+
+/* Checks the matrix against the formula of the former 5.1 to stereo
+ * downmix */
+static void test_5_1_to_stereo(void)
+{
+    mix_matrix_t mx;
+    float in[6 * 16], out[2 * 16];
+
+    assert(MixMatrixInit(&mx, AOUT_CHANS_5_1, AOUT_CHANS_2_0) == VLC_SUCCESS);
+    assert(mx.i_in == 6 && mx.i_out == 2);
+    noise(in, ARRAY_SIZE(in));
+    MixGetMatrix()(&mx, out, in, 16);
+
+    for (unsigned f = 0; f < 16; f++)
+    {
+        const float *s = &in[6 * f];
+        assert(fabsf(out[2 * f] - (s[0] + 0.7071f * (s[4] + s[2]))) < 1e-5f);
+        assert(fabsf(out[2 * f + 1]
+                     - (s[1] + 0.7071f * (s[4] + s[3]))) < 1e-5f);
+    }
+}
+
+/* Downmixes noise with the generic and the selected kernels, in place as by
+ * the audio filter, and compares the results */
+static void test(const char *name, uint32_t input, uint32_t output)
+{
+    mix_matrix_t mx;
+
+    assert(MixMatrixInit(&mx, input, output) == VLC_SUCCESS);
+    assert(mx.i_in == popcount(input));
+    assert(mx.i_out == popcount(output));
+
+    const size_t samples = FRAMES * mx.i_in;
+    float *in = malloc(samples * sizeof (float));
+    float *a = malloc(samples * sizeof (float));
+    float *b = malloc(samples * sizeof (float));
+    assert(in && a && b);
+
+    mix_matrix_cb mix = MixGetMatrix();
+    double t_ref = 0., t_mix = 0., error = 0.;
+
+    srand(input ^ output);
+    for (unsigned n = 0; n < BLOCKS; n++)
+    {
+        noise(in, samples);
+
+        memcpy(a, in, samples * sizeof (float));
+        double start = now();
+        MixMatrixC(&mx, a, a, FRAMES);
+        t_ref += now() - start;
+
+        memcpy(b, in, samples * sizeof (float));
+        start = now();
+        mix(&mx, b, b, FRAMES);
+        t_mix += now() - start;
+
+        for (size_t i = 0; i < FRAMES * mx.i_out; i++)
+        {
+            double diff = fabs(a[i] - b[i]);
+            if (diff > error)
+                error = diff;
+        }
+    }
+
+    printf("%-12s generic %6.2f ns, selected %6.2f ns per frame, error %g\n",
+           name, t_ref * 1e9 / (BLOCKS * FRAMES),
+           t_mix * 1e9 / (BLOCKS * FRAMES), error);
+    assert(error < 1e-5);
+
+    free(b);
+    free(a);
+    free(in);
+}
+
+int main(void)
+{
+    static const struct
+    {
+        const char *name;
+        uint32_t input;
+        uint32_t output;
+    } pairs[] = {
+        { "7.1 to 2.0", AOUT_CHANS_7_1,          AOUT_CHANS_2_0 },
+        { "7.0 to 2.0", AOUT_CHANS_7_0,          AOUT_CHANS_2_0 },
+        { "6.1 to 2.0", AOUT_CHANS_6_1_MIDDLE,   AOUT_CHANS_2_0 },
+        { "5.1 to 2.0", AOUT_CHANS_5_1,          AOUT_CHANS_2_0 },
+        { "5.0 to 2.0", AOUT_CHANS_5_0_MIDDLE,   AOUT_CHANS_2_0 },
+        { "4.0 to 2.0", AOUT_CHANS_4_CENTER_REAR, AOUT_CHANS_2_0 },
+        { "3.1 to 2.0", AOUT_CHANS_3_0 | AOUT_CHAN_LFE, AOUT_CHANS_2_0 },
+        { "3.0 to 2.0", AOUT_CHANS_3_0,          AOUT_CHANS_2_0 },
+        { "7.1 to 1.0", AOUT_CHANS_7_1,          AOUT_CHAN_CENTER },
+        { "5.1 to 1.0", AOUT_CHANS_5_1,          AOUT_CHAN_CENTER },
+        { "4.0 to 1.0", AOUT_CHANS_4_CENTER_REAR, AOUT_CHAN_CENTER },
+        { "3.0 to 1.0", AOUT_CHANS_3_0,          AOUT_CHAN_CENTER },
+        { "2.0 to 1.0", AOUT_CHANS_2_0,          AOUT_CHAN_CENTER },
+        { "2.1 to 1.0", AOUT_CHANS_2_0 | AOUT_CHAN_LFE, AOUT_CHAN_CENTER },
+        { "7.1 to 4.0", AOUT_CHANS_7_1,          AOUT_CHANS_4_0 },
+        { "5.1 to 4.0", AOUT_CHANS_5_1,          AOUT_CHANS_4_0 },
+        { "7.1 to 5.1", AOUT_CHANS_7_1,          AOUT_CHANS_5_1 },
+        { "7.0 to 5.0", AOUT_CHANS_7_0,          AOUT_CHANS_5_0 },
+        { "6.1 to 5.1", AOUT_CHANS_6_1_MIDDLE,   AOUT_CHANS_5_1 },
+        { "6.1 to 5.0", AOUT_CHANS_6_1_MIDDLE,   AOUT_CHANS_5_0_MIDDLE },
+    };
+
+    test_5_1_to_stereo();
+    for (size_t i = 0; i < ARRAY_SIZE(pairs); i++)
+        test(pairs[i].name, pairs[i].input, pairs[i].output);
+
+    mix_matrix_t mx;
+    assert(MixMatrixInit(&mx, AOUT_CHANS_4_0, AOUT_CHANS_2_0) != VLC_SUCCESS);
+    return 0;
+}
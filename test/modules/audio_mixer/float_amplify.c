@@ -0,0 +1,107 @@
+/*****************************************************************************
+ * float_amplify.c: gain ramps tests and benchmark
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <vlc_common.h>
+
+#include "../modules/audio_mixer/float_amplify.h"
+
+#define SAMPLES (2 * 1021) /* not a multiple of the vectors */
+#define BLOCKS  4096
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Amplifies noise with the generic and the selected amplifiers, and compares
+ * the results */
+static void test(const char *name, float from, float to)
+{
+    float *in = malloc(SAMPLES * sizeof (float));
+    float *a = malloc(SAMPLES * sizeof (float));
+    float *b = malloc(SAMPLES * sizeof (float));
+    assert(in && a && b);
+
+    amplify_ramp_cb ramp = AmplifyGetRamp();
+    const float step = (to - from) / SAMPLES;
+    double t_ref = 0., t_ramp = 0., error = 0.;
+
+    srand(SAMPLES);
+    for (size_t i = 0; i < SAMPLES; i++)
+        in[i] = (rand() / (float)RAND_MAX - .5f) * 2.f;
+
+    for (unsigned n = 0; n < BLOCKS; n++)
+    {
+        memcpy(a, in, SAMPLES * sizeof (float));
+        double start = now();
+        AmplifyRampC(a, SAMPLES, from + step, step);
+        t_ref += now() - start;
+
+        memcpy(b, in, SAMPLES * sizeof (float));
+        start = now();
+        ramp(b, SAMPLES, from + step, step);
+        t_ramp += now() - start;
+    }
+
+    for (size_t i = 0; i < SAMPLES; i++)
+    {
+        double diff = fabs(a[i] - b[i]);
+        if (diff > error)
+            error = diff;
+
+        /* The gain does not jump, and reaches the new one */
+        if (i > 0 && fabsf(in[i]) > .1f && fabsf(in[i - 1]) > .1f)
+            assert(fabsf(b[i] / in[i] - b[i - 1] / in[i - 1])
+                   <= fabsf(step) * 1.01f + 1e-5f);
+    }
+    assert(fabsf(b[SAMPLES - 1] - in[SAMPLES - 1] * to) < 1e-5f);
+
+    printf("%-10s generic %6.3f ns, selected %6.3f ns per sample, error %g\n",
+           name, t_ref * 1e9 / (BLOCKS * SAMPLES),
+           t_ramp * 1e9 / (BLOCKS * SAMPLES), error);
+    assert(error < 1e-6);
+
+    free(b);
+    free(a);
+    free(in);
+}
+
+int main(void)
+{
+    test("constant", .5f, .5f);
+    test("fade in", 0.f, 1.f);
+    test("fade out", 1.5f, .25f);
+    return 0;
+}
@@ -0,0 +1,145 @@
+/*****************************************************************************
+ * commands.cpp: adaptive commands queue allocation benchmark
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Feeds a CommandsQueue with the commands pattern of a 60 fps video and
+ * two audio tracks, and reports the heap allocations done per command.
+ *
+ * usage: test_modules_demux_adaptive_commands [seconds]
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+
+#include "../modules/demux/adaptive/plumbing/CommandsQueue.hpp"
+
+#include <new>
+
+using namespace adaptive;
+
+const char vlc_module_name[] = "adaptive";
+
+static unsigned long allocations = 0;
+
+void * operator new(size_t size)
+{
+    allocations++;
+    void *p = malloc(size ? size : 1);
+    if(!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void * operator new(size_t size, const std::nothrow_t &) throw()
+{
+    allocations++;
+    return malloc(size ? size : 1);
+}
+
+void operator delete(void *p) throw()
+{
+    free(p);
+}
+
+void operator delete(void *p, const std::nothrow_t &) throw()
+{
+    free(p);
+}
+
+static block_t * newFrame(mtime_t dts)
+{
+    block_t *p_block = block_Alloc(16);
+    assert(p_block);
+    p_block->i_dts = p_block->i_pts = dts;
+    return p_block;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned seconds = (argc > 1) ? atoi(argv[1]) : 600;
+    if(seconds < 2)
+        seconds = 2;
+    const mtime_t latency = 5 * CLOCK_FREQ; /* dts ahead of pcr, beyond the consumed span */
+    const unsigned tracks_fps[] = { 60, 50, 50 };
+
+    CommandsQueue *queue = new CommandsQueue(new CommandsFactory());
+    const CommandsFactory *factory = queue->factory();
+
+    unsigned long commands = 0;
+    unsigned long warmup = 0;
+    struct timespec start, end;
+
+    for(unsigned s = 0; s < seconds; s++)
+    {
+        if(s == 1) /* steady state only */
+        {
+            warmup = allocations;
+            commands = 0;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+        }
+
+        /* 100ms between PCRs */
+        for(unsigned slice = 0; slice < 10; slice++)
+        {
+            const mtime_t pcr = VLC_TS_0 + s * CLOCK_FREQ + slice * CLOCK_FREQ / 10;
+            for(size_t t = 0; t < ARRAY_SIZE(tracks_fps); t++)
+            {
+                const unsigned frames = tracks_fps[t] / 10;
+                for(unsigned f = 0; f < frames; f++)
+                {
+                    const mtime_t dts = pcr + latency + f * CLOCK_FREQ / tracks_fps[t];
+                    queue->Schedule(factory->createEsOutSendCommand(NULL, newFrame(dts)));
+                    commands++;
+                }
+            }
+            queue->Schedule(factory->createEsOutControlPCRCommand(0, pcr));
+            commands++;
+            /* PCR commands are executed, sends stay queued ahead of pcr */
+            queue->Process(NULL, pcr);
+        }
+
+        /* consume what would have been output */
+        if(s % 2)
+            queue->Abort(false);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    const unsigned long steady = allocations - warmup;
+    const double ns = (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+
+    printf("%lu commands, %lu heap allocations (%.3f per command), %.1f ns per command\n",
+           commands, steady, commands ? (double) steady / commands : 0.0,
+           commands ? ns / commands : 0.0);
+
+    delete queue;
+    return 0;
+}
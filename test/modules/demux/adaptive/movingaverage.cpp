@@ -0,0 +1,133 @@
+/*****************************************************************************
+ * movingaverage.cpp: adaptive MovingAverage tests and benchmark
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../modules/demux/adaptive/tools/MovingAverage.hpp"
+
+#include <list>
+#include <algorithm>
+
+/* Previous list based implementation, used as reference */
+template <class T>
+class ListMovingAverageSum
+{
+    public:
+        ListMovingAverageSum(T i): sum(0), prev(i) { }
+        void operator()(T n) {
+            sum += (n > prev) ? n - prev : prev - n;
+            prev = n;
+        }
+        T sum;
+    private:
+        T prev;
+};
+
+template <class T>
+class ListMovingAverage
+{
+    public:
+        ListMovingAverage(unsigned nbobs) : previous(0), maxobs(nbobs), avg(0) { }
+        T push(T v)
+        {
+            if(values.size() >= maxobs)
+            {
+                previous = values.front();
+                values.pop_front();
+            }
+            values.push_back(v);
+            T omin = *std::min_element(values.begin(), values.end());
+            T omax = *std::max_element(values.begin(), values.end());
+            ListMovingAverageSum<T> diffsums = std::for_each(values.begin(), values.end(),
+                                                             ListMovingAverageSum<T>(previous));
+            const T deltamax = omax - omin;
+            double alpha = (diffsums.sum) ? 0.33 * ((double)deltamax / diffsums.sum) : 0.5;
+            avg = alpha * avg + (1.0 - alpha) * (*values.rbegin());
+            return avg;
+        }
+
+    private:
+        std::list<T> values;
+        T previous;
+        unsigned maxobs;
+        T avg;
+};
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void test_window(unsigned window, unsigned count)
+{
+    adaptive::MovingAverage<size_t> ring(window);
+    ListMovingAverage<size_t> list(window);
+
+    srand(window);
+    for(unsigned i=0; i<count; i++)
+    {
+        /* bursts and plateaus, as seen with download rates */
+        size_t v = (i % 50 < 25) ? 1000000 + rand() % 1000 : rand() % 8000000;
+        assert(ring.push(v) == list.push(v));
+    }
+}
+
+template <class A>
+static double bench(unsigned window, unsigned count)
+{
+    A average(window);
+    size_t dummy = 0;
+    double start = now();
+    for(unsigned i=0; i<count; i++)
+        dummy += average.push(i * 7919 % 8000000);
+    double elapsed = now() - start;
+    assert(dummy != 1);
+    return elapsed;
+}
+
+int main(void)
+{
+    static const unsigned windows[] = { 1, 2, 3, 10, 20, 64 };
+    for(size_t i=0; i<sizeof(windows)/sizeof(windows[0]); i++)
+        test_window(windows[i], 10000);
+
+    for(size_t i=0; i<sizeof(windows)/sizeof(windows[0]); i++)
+    {
+        const unsigned count = 200000;
+        double tring = bench< adaptive::MovingAverage<size_t> >(windows[i], count);
+        double tlist = bench< ListMovingAverage<size_t> >(windows[i], count);
+        printf("window %2u: ring %.2f ns/push, list %.2f ns/push\n", windows[i],
+               tring * 1e9 / count, tlist * 1e9 / count);
+    }
+
+    return 0;
+}
@@ -0,0 +1,380 @@
+/*****************************************************************************
+ * replay.cpp: adaptive logic offline replay benchmark
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Replays scripted network traces against the adaptation logics, using a
+ * simulated player buffer, so that logics can be compared reproducibly.
+ *
+ * usage: test_modules_demux_adaptive_replay [trace file] [ladder]
+ *  trace file: one "<duration s> <bandwidth kbps> <latency ms>" step per line
+ *  ladder: comma separated representation bitrates in kbps
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <vlc_common.h>
+
+#include "../modules/demux/adaptive/playlist/AbstractPlaylist.hpp"
+#include "../modules/demux/adaptive/playlist/BasePeriod.h"
+#include "../modules/demux/adaptive/playlist/BaseAdaptationSet.h"
+#include "../modules/demux/adaptive/playlist/BaseRepresentation.h"
+#include "../modules/demux/adaptive/logic/PredictiveAdaptationLogic.hpp"
+#include "../modules/demux/adaptive/logic/NearOptimalAdaptationLogic.hpp"
+#include "../modules/demux/adaptive/logic/BufferBasedAdaptationLogic.hpp"
+#include "../modules/demux/adaptive/logic/RateBasedAdaptationLogic.h"
+#include "../modules/demux/adaptive/SegmentTracker.hpp"
+#include "../modules/demux/adaptive/ID.hpp"
+#include "../modules/demux/adaptive/http/HTTPConnectionManager.h"
+#include "../modules/demux/adaptive/http/ConnectionParams.hpp"
+
+#include <vector>
+
+using namespace adaptive;
+using namespace adaptive::playlist;
+
+const char vlc_module_name[] = "adaptive";
+using namespace adaptive::logic;
+using namespace adaptive::http;
+
+/* Segments refer to the connection manager, which the replay never creates:
+ * this avoids linking the whole HTTP stack */
+ConnectionParams AbstractConnectionManager::getParams(const std::string &url)
+{
+    return ConnectionParams(url);
+}
+
+ChunkCache * AbstractConnectionManager::getChunkCache() const
+{
+    return NULL;
+}
+
+#define SEGMENT_DURATION (CLOCK_FREQ * 4)
+#define SEGMENT_COUNT    150
+
+class ReplayPlaylist : public AbstractPlaylist
+{
+    public:
+        ReplayPlaylist() : AbstractPlaylist(NULL) {}
+        virtual bool isLive() const { return false; }
+        virtual void debug() {}
+};
+
+struct TraceStep
+{
+    mtime_t  duration;
+    uint64_t bandwidth; /* bps */
+    mtime_t  latency;
+};
+
+class Trace
+{
+    public:
+        Trace(const char *psz_name) : name(psz_name), index(0), stepstart(0) {}
+
+        void add(double seconds, unsigned kbps, unsigned latencyms)
+        {
+            TraceStep step;
+            step.duration = seconds * CLOCK_FREQ;
+            step.bandwidth = (uint64_t) kbps * 1000;
+            step.latency = (mtime_t) latencyms * 1000;
+            steps.push_back(step);
+        }
+
+        bool load(const char *psz_file)
+        {
+            FILE *f = fopen(psz_file, "r");
+            if(!f)
+                return false;
+            double seconds;
+            unsigned kbps, latency;
+            char line[256];
+            while(fgets(line, sizeof(line), f))
+            {
+                if(line[0] == '#')
+                    continue;
+                if(sscanf(line, "%lf %u %u", &seconds, &kbps, &latency) == 3 && seconds > 0)
+                    add(seconds, kbps, latency);
+            }
+            fclose(f);
+            return !steps.empty();
+        }
+
+        void rewind()
+        {
+            index = 0;
+            stepstart = 0;
+        }
+
+        /* Time needed to fetch size bytes when starting at time now.
+         * The trace is looped when exhausted. */
+        mtime_t download(mtime_t now, uint64_t size)
+        {
+            mtime_t t = now + current(now).latency;
+            double bits = (double) size * 8;
+            for(;;)
+            {
+                const TraceStep &step = current(t);
+                const mtime_t stepend = stepstart + step.duration;
+                const double avail = (double) step.bandwidth * (stepend - t) / CLOCK_FREQ;
+                if(step.bandwidth && avail >= bits)
+                {
+                    t += bits * CLOCK_FREQ / step.bandwidth;
+                    break;
+                }
+                bits -= avail;
+                t = stepend;
+            }
+            return t - now;
+        }
+
+        const char *name;
+
+    private:
+        const TraceStep & current(mtime_t t)
+        {
+            while(t >= stepstart + steps[index].duration)
+            {
+                stepstart += steps[index].duration;
+                index = (index + 1) % steps.size();
+            }
+            return steps[index];
+        }
+
+        std::vector<TraceStep> steps;
+        size_t index;
+        mtime_t stepstart;
+};
+
+/* simulation and logic CPU time are accounted together, the simulation
+ * itself being negligible */
+struct ReplayResult
+{
+    mtime_t  playtime;
+    mtime_t  stalltime;
+    mtime_t  startdelay;
+    unsigned rebuffers;
+    unsigned switches;
+    uint64_t bitratesum;
+    uint64_t cpu_ns;
+};
+
+class Player
+{
+    public:
+        Player(BaseAdaptationSet *set, mtime_t min, mtime_t max)
+            : adaptSet(set), minbuffer(min), maxbuffer(max) {}
+
+        ReplayResult run(AbstractAdaptationLogic *logic, Trace &trace)
+        {
+            ReplayResult res;
+            memset(&res, 0, sizeof(res));
+            trace.rewind();
+
+            const ID &id = adaptSet->getID();
+            logic->trackerEvent(SegmentTrackerEvent(id, true));
+
+            BaseRepresentation *prev = NULL;
+            mtime_t now = 0;
+            mtime_t buffer = 0;
+            bool playing = false;
+            bool stalled = false;
+            const clock_t start = clock();
+
+            for(unsigned i=0; i<SEGMENT_COUNT; i++)
+            {
+                BaseRepresentation *rep = logic->getNextRepresentation(adaptSet, prev);
+                assert(rep);
+                if(rep != prev)
+                {
+                    if(prev)
+                        res.switches++;
+                    logic->trackerEvent(SegmentTrackerEvent(prev, rep));
+                }
+                prev = rep;
+
+                const uint64_t size = rep->getBandwidth() * SEGMENT_DURATION / CLOCK_FREQ / 8;
+                const mtime_t dltime = trace.download(now, size);
+                now += dltime;
+
+                if(playing)
+                {
+                    if(buffer < dltime)
+                    {
+                        if(!stalled)
+                            res.rebuffers++;
+                        stalled = true;
+                        res.stalltime += dltime - buffer;
+                        res.playtime += buffer;
+                        buffer = 0;
+                    }
+                    else
+                    {
+                        res.playtime += dltime;
+                        buffer -= dltime;
+                    }
+                }
+                else
+                {
+                    res.startdelay += dltime;
+                }
+
+                buffer += SEGMENT_DURATION;
+                res.bitratesum += rep->getBandwidth();
+                if(buffer >= minbuffer)
+                {
+                    playing = true;
+                    stalled = false;
+                }
+
+                logic->updateDownloadRate(id, size, dltime);
+                logic->trackerEvent(SegmentTrackerEvent(id, SEGMENT_DURATION));
+
+                /* buffer full, wait for playback to drain it */
+                if(buffer > maxbuffer)
+                {
+                    res.playtime += buffer - maxbuffer;
+                    now += buffer - maxbuffer;
+                    buffer = maxbuffer;
+                }
+
+                logic->trackerEvent(SegmentTrackerEvent(id, minbuffer, buffer, maxbuffer));
+            }
+
+            logic->trackerEvent(SegmentTrackerEvent(prev, NULL));
+            logic->trackerEvent(SegmentTrackerEvent(id, false));
+            res.playtime += buffer;
+            res.cpu_ns = (uint64_t)(clock() - start) * 1000000000 / CLOCKS_PER_SEC;
+
+            return res;
+        }
+
+    private:
+        BaseAdaptationSet *adaptSet;
+        mtime_t minbuffer;
+        mtime_t maxbuffer;
+};
+
+static void report(const char *psz_logic, const Trace &trace, const ReplayResult &res)
+{
+    const double rebuffer_ratio = (double) res.stalltime / (res.playtime + res.stalltime);
+    assert(rebuffer_ratio >= 0.0 && rebuffer_ratio <= 1.0);
+    printf("%-12s %-10s rebuffer %6.2f%% (%2u) startup %5.2fs avg %6" PRIu64 " kbps "
+           "switches %3u cpu %6" PRIu64 " ns/segment\n",
+           psz_logic, trace.name, rebuffer_ratio * 100, res.rebuffers,
+           (double) res.startdelay / CLOCK_FREQ,
+           res.bitratesum / SEGMENT_COUNT / 1000, res.switches,
+           res.cpu_ns / SEGMENT_COUNT);
+}
+
+static void replay(Player &player, Trace &trace)
+{
+    AbstractAdaptationLogic *logics[4];
+    const char *names[4] = { "predictive", "nearoptimal", "buffer", "rate" };
+    logics[0] = new PredictiveAdaptationLogic(NULL);
+    logics[1] = new NearOptimalAdaptationLogic(NULL);
+    logics[2] = new BufferBasedAdaptationLogic(NULL);
+    logics[3] = new RateBasedAdaptationLogic(NULL);
+
+    for(size_t i=0; i<ARRAY_SIZE(logics); i++)
+    {
+        logics[i]->setMaxDeviceResolution(0, 0);
+        ReplayResult res = player.run(logics[i], trace);
+        report(names[i], trace, res);
+        delete logics[i];
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<unsigned> ladder;
+    if(argc > 2)
+    {
+        for(char *psz = strtok(argv[2], ","); psz; psz = strtok(NULL, ","))
+            ladder.push_back(atoi(psz));
+    }
+    if(ladder.empty())
+    {
+        const unsigned defaults[] = { 300, 750, 1200, 2400, 4800 };
+        ladder.assign(defaults, defaults + ARRAY_SIZE(defaults));
+    }
+
+    ReplayPlaylist *playlist = new ReplayPlaylist();
+    BasePeriod *period = new BasePeriod(playlist);
+    playlist->addPeriod(period);
+    BaseAdaptationSet *adaptSet = new BaseAdaptationSet(period);
+    adaptSet->setID(ID("replay"));
+    period->addAdaptationSet(adaptSet);
+    for(size_t i=0; i<ladder.size(); i++)
+    {
+        BaseRepresentation *rep = new BaseRepresentation(adaptSet);
+        rep->setBandwidth((uint64_t) ladder[i] * 1000);
+        adaptSet->addRepresentation(rep);
+    }
+
+    Player player(adaptSet, playlist->getMinBuffering(), playlist->getMaxBuffering());
+
+    if(argc > 1)
+    {
+        Trace trace(argv[1]);
+        if(!trace.load(argv[1]))
+        {
+            fprintf(stderr, "can't load trace %s\n", argv[1]);
+            delete playlist;
+            return 1;
+        }
+        replay(player, trace);
+    }
+    else
+    {
+        Trace fixed("fixed");
+        fixed.add(60, 3000, 50);
+        replay(player, fixed);
+
+        Trace steps("steps");
+        steps.add(60, 6000, 30);
+        steps.add(40, 800, 80);
+        steps.add(60, 2500, 50);
+        replay(player, steps);
+
+        /* congested mobile link, deterministic */
+        Trace mobile("mobile");
+        unsigned seed = 42;
+        for(unsigned i=0; i<120; i++)
+        {
+            seed = seed * 1103515245 + 12345;
+            mobile.add(1.0 + (seed >> 16) % 4, 300 + (seed >> 8) % 3500, 60 + (seed >> 4) % 240);
+        }
+        replay(player, mobile);
+    }
+
+    delete playlist;
+    return 0;
+}
@@ -0,0 +1,157 @@
+/*****************************************************************************
+ * seekpoints.cpp: mkv SeekpointIndex tests and seek latency benchmark
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../modules/demux/mkv/seekpoint_index.hpp"
+
+#include <vector>
+#include <algorithm>
+
+/* Previous array of structures implementation, used as reference */
+class VectorSeekpoints
+{
+    public:
+        struct Seekpoint
+        {
+            uint64_t fpos;
+            mtime_t pts;
+            int trust;
+            bool operator<(const Seekpoint &rhs) const { return pts < rhs.pts; }
+        };
+
+        void insert(uint64_t fpos, mtime_t pts, int trust)
+        {
+            Seekpoint sp = { fpos, pts, trust };
+            std::vector<Seekpoint>::iterator it =
+                    std::lower_bound(points.begin(), points.end(), sp);
+            if(it != points.end() && it->pts == pts)
+            {
+                if(trust > it->trust)
+                    *it = sp;
+            }
+            else points.insert(it, sp);
+        }
+
+        size_t greatest_lower_bound(mtime_t pts) const
+        {
+            Seekpoint needle = { 0, pts, 0 };
+            size_t i = std::upper_bound(points.begin(), points.end(), needle) - points.begin();
+            return i ? i - 1 : 0;
+        }
+
+        std::vector<Seekpoint> points;
+};
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Cues every 40ms, about 200KB apart */
+static mtime_t cue_pts(unsigned i) { return (mtime_t)i * 40000; }
+static uint64_t cue_fpos(unsigned i) { return (uint64_t)i * 200000 + 4096; }
+
+static void test_index(void)
+{
+    SeekpointIndex index;
+    VectorSeekpoints reference;
+
+    srand(42);
+    for(unsigned i=0; i<20000; i++)
+    {
+        /* mostly in order, with revisits as from cues then blocks */
+        unsigned n = (i % 7 == 0) ? rand() % (i + 1) : i;
+        int trust = (rand() % 2) ? 3 : 2;
+        index.insert(cue_fpos(n), cue_pts(n), trust);
+        reference.insert(cue_fpos(n), cue_pts(n), trust);
+    }
+
+    assert(index.size() == reference.points.size());
+    for(size_t i=0; i<index.size(); i++)
+    {
+        assert(index.fpos(i) == reference.points[i].fpos);
+        assert(index.pts(i) == reference.points[i].pts);
+        assert(index.trust(i) == reference.points[i].trust);
+    }
+
+    for(unsigned i=0; i<10000; i++)
+    {
+        mtime_t pts = (mtime_t)rand() * 41 % cue_pts(index.size() + 10) - 1000;
+        assert(index.greatest_lower_bound(pts) == reference.greatest_lower_bound(pts));
+    }
+
+    /* trust only upgrades */
+    SeekpointIndex single;
+    single.insert(100, 0, 2);
+    single.insert(200, 0, -1);
+    assert(single.size() == 1 && single.fpos(0) == 100);
+    single.insert(300, 0, 3);
+    assert(single.size() == 1 && single.fpos(0) == 300 && single.trust(0) == 3);
+    assert(single.greatest_lower_bound(-5) == 0);
+}
+
+template <class I>
+static void bench(const char *name, unsigned count, unsigned lookups)
+{
+    I index;
+
+    double start = now();
+    for(unsigned i=0; i<count; i++)
+        index.insert(cue_fpos(i), cue_pts(i), 3);
+    double tinsert = now() - start;
+
+    srand(count);
+    size_t dummy = 0;
+    start = now();
+    for(unsigned i=0; i<lookups; i++)
+        dummy += index.greatest_lower_bound(rand() % cue_pts(count));
+    double tlookup = now() - start;
+    assert(dummy != 1);
+
+    printf("%-8s %8u cues: insert %7.2f ns, seek %7.2f ns\n", name, count,
+           tinsert * 1e9 / count, tlookup * 1e9 / lookups);
+}
+
+int main(void)
+{
+    test_index();
+
+    static const unsigned counts[] = { 1000, 100000, 1000000 };
+    for(size_t i=0; i<sizeof(counts)/sizeof(counts[0]); i++)
+    {
+        bench<SeekpointIndex>("soa", counts[i], 200000);
+        bench<VectorSeekpoints>("aos", counts[i], 200000);
+    }
+
+    return 0;
+}
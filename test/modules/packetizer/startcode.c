@@ -0,0 +1,170 @@
+/*****************************************************************************
+ * startcode.c: AnnexB startcode scanners tests and benchmark
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <vlc_common.h>
+
+#include "../modules/packetizer/startcode_helper.h"
+
+#define BENCH_SIZE  (8 << 20)
+#define BENCH_LOOPS 16
+
+typedef const uint8_t *(*startcode_scanner_cb)( const uint8_t *,
+                                                const uint8_t * );
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Startcodes are only returned when followed by at least one byte */
+static const uint8_t *FindReference(const uint8_t *p, const uint8_t *end)
+{
+    for (; end - p > 3; p++)
+        if (p[0] == 0 && p[1] == 0 && p[2] == 1)
+            return p;
+    return NULL;
+}
+
+/* Scans short buffers at every alignment, with many zeros and ones, and
+ * compares with the reference */
+static void test(const char *name, startcode_scanner_cb find)
+{
+    uint8_t buf[64 + 512];
+
+    srand(512);
+    for (unsigned n = 0; n < 20000; n++)
+    {
+        for (size_t i = 0; i < sizeof (buf); i++)
+        {
+            int r = rand() % 16;
+            buf[i] = r < 6 ? 0 : r < 8 ? 1 : rand();
+        }
+
+        size_t offset = n % 64;
+        size_t size = rand() % (sizeof (buf) - 64);
+        const uint8_t *p = buf + offset, *end = p + size;
+
+        while (p < end)
+        {
+            const uint8_t *ref = FindReference(p, end);
+            const uint8_t *res = find(p, end);
+            if (res != ref)
+            {
+                fprintf(stderr, "%s: found %td instead of %td "
+                        "(offset %zu, size %zu)\n", name,
+                        res ? res - buf : -1, ref ? ref - buf : -1,
+                        offset, size);
+                abort();
+            }
+            if (ref == NULL)
+                break;
+            p = ref + 1; /* also checks the unaligned starts */
+        }
+    }
+}
+
+/* Scans a large buffer with a startcode every 64 KiB, as in slices of a
+ * high bitrate stream */
+static void bench(const char *name, startcode_scanner_cb find, double *ref)
+{
+    uint8_t *buf = malloc(BENCH_SIZE);
+    assert(buf != NULL);
+
+    srand(BENCH_SIZE);
+    for (size_t i = 0; i < BENCH_SIZE; i++)
+        buf[i] = rand() | 0x02; /* never 0 nor 1 */
+    for (size_t i = 0; i + 4 < BENCH_SIZE; i += 65536)
+        memcpy(&buf[i], "\x00\x00\x00\x01", 4);
+
+    unsigned count = 0;
+    double start = now();
+    for (unsigned n = 0; n < BENCH_LOOPS; n++)
+    {
+        const uint8_t *p = buf, *end = buf + BENCH_SIZE;
+        while ((p = find(p, end)) != NULL)
+        {
+            p += 3;
+            count++;
+        }
+    }
+    double t = now() - start;
+    assert(count == BENCH_LOOPS * (BENCH_SIZE / 65536));
+
+    double rate = (double)BENCH_LOOPS * BENCH_SIZE / t / (1 << 20);
+    if (*ref == 0.)
+        *ref = rate;
+    printf("%-8s %8.1f MiB/s (x%.2f)\n", name, rate, rate / *ref);
+    free(buf);
+}
+
+int main(void)
+{
+    static const struct
+    {
+        const char *name;
+        startcode_scanner_cb find;
+    } scanners[] = {
+        { "C", startcode_FindAnnexB_C },
+#if defined(CAN_COMPILE_SSE2) || defined(HAVE_SSE2_INTRINSICS)
+        { "SSE2", startcode_FindAnnexB_SSE2 },
+#endif
+#if defined(HAVE_AVX2_INTRINSICS)
+        { "AVX2", startcode_FindAnnexB_AVX2 },
+#endif
+#if defined(__ARM_NEON)
+        { "NEON", startcode_FindAnnexB_NEON },
+#endif
+        { "selected", startcode_FindAnnexB },
+    };
+    double ref = 0.;
+
+    for (size_t i = 0; i < ARRAY_SIZE(scanners); i++)
+    {
+        const char *name = scanners[i].name;
+
+        if ((!strcmp(name, "SSE2") && !vlc_CPU_SSE2())
+#if defined(HAVE_AVX2_INTRINSICS)
+         || (!strcmp(name, "AVX2") && !vlc_CPU_AVX2())
+#endif
+           )
+        {
+            printf("%-8s not supported by the CPU\n", name);
+            continue;
+        }
+
+        test(name, scanners[i].find);
+        bench(name, scanners[i].find, &ref);
+    }
+    return 0;
+}
@@ -53,6 +53,8 @@ struct test_es_out_t
 {
     struct es_out_t out;
     struct es_out_id_t *ids;
+    uintmax_t blocks;
+    uintmax_t bytes;
 };
 
 struct es_out_id_t
@@ -97,8 +99,12 @@ static void EsOutCheckId(es_out_t *out, es_out_id_t *id)
 
 static int EsOutSend(es_out_t *out, es_out_id_t *id, block_t *block)
 {
+    struct test_es_out_t *ctx = (struct test_es_out_t *) out;
+
     //debug("[%p] Sent    ES: %zu\n", (void *)idd, block->i_buffer);
     EsOutCheckId(out, id);
+    ctx->blocks++;
+    ctx->bytes += block->i_buffer;
 #ifdef HAVE_DECODERS
     if (id->decoder)
         test_decoder_process(id->decoder, block);
@@ -204,6 +210,8 @@ static es_out_t *test_es_out_create(vlc_object_t *parent)
     }
 
     ctx->ids = NULL;
+    ctx->blocks = 0;
+    ctx->bytes = 0;
 
     es_out_t *out = &ctx->out;
     out->pf_add = EsOutAdd;
@@ -256,7 +264,45 @@ static void demux_get_meta(demux_t *demux)
     vlc_meta_Delete(p_meta);
 }
 
-static int demux_process_stream(const struct vlc_run_args *args, stream_t *s)
+static void demux_bench_seeks(demux_t *demux, struct test_es_out_t *ctx,
+                              struct vlc_demux_bench *bench)
+{
+    mtime_t length;
+    unsigned count = bench->seeks;
+
+    bench->seeks = 0;
+    bench->seek_time = 0;
+    bench->seek_max = 0;
+
+    if (demux_Control(demux, DEMUX_GET_LENGTH, &length) != VLC_SUCCESS
+     || length <= 0)
+        return;
+
+    /* same positions on every run */
+    srand(count);
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        mtime_t target = (mtime_t)(length * ((double)rand() / RAND_MAX));
+        uintmax_t blocks = ctx->blocks;
+        mtime_t start = mdate();
+
+        if (demux_Control(demux, DEMUX_SET_TIME, target, false) != VLC_SUCCESS)
+            continue;
+
+        while (ctx->blocks == blocks
+            && demux_Demux(demux) == VLC_DEMUXER_SUCCESS);
+
+        mtime_t latency = mdate() - start;
+        bench->seek_time += latency;
+        if (latency > bench->seek_max)
+            bench->seek_max = latency;
+        bench->seeks++;
+    }
+}
+
+static int demux_process_stream(const struct vlc_run_args *args, stream_t *s,
+                                struct vlc_demux_bench *bench)
 {
     const char *name = args->name;
     if (name == NULL)
@@ -278,9 +324,19 @@ static int demux_process_stream(const struct vlc_run_args *args, stream_t *s)
         return -1;
     }
 
+    struct test_es_out_t *ctx = (struct test_es_out_t *)out;
+    uintmax_t allocations = 0;
+    mtime_t start = 0;
     uintmax_t i = 0;
     int val;
 
+    if (bench != NULL)
+    {
+        if (bench->allocations != NULL)
+            allocations = bench->allocations();
+        start = mdate();
+    }
+
     while ((val = demux_Demux(demux)) == VLC_DEMUXER_SUCCESS)
     {
         if (args->test_demux_controls)
@@ -305,6 +361,18 @@ static int demux_process_stream(const struct vlc_run_args *args, stream_t *s)
         i++;
     }
 
+    if (bench != NULL)
+    {
+        bench->demux_time = mdate() - start;
+        if (bench->allocations != NULL)
+            bench->block_allocations = bench->allocations() - allocations;
+        bench->blocks = ctx->blocks;
+        bench->bytes = ctx->bytes;
+
+        if (val == VLC_DEMUXER_EOF)
+            demux_bench_seeks(demux, ctx, bench);
+    }
+
     demux_Delete(demux);
     es_out_Delete(out);
 
@@ -313,7 +381,8 @@ static int demux_process_stream(const struct vlc_run_args *args, stream_t *s)
     return val == VLC_DEMUXER_EOF ? 0 : -1;
 }
 
-int vlc_demux_process_url(const struct vlc_run_args *args, const char *url)
+static int demux_process_url(const struct vlc_run_args *args, const char *url,
+                             struct vlc_demux_bench *bench)
 {
     libvlc_instance_t *vlc = libvlc_create(args);
     if (vlc == NULL)
@@ -323,12 +392,13 @@ int vlc_demux_process_url(const struct vlc_run_args *args, const char *url)
     if (s == NULL)
         fprintf(stderr, "Error: cannot create input stream: %s\n", url);
 
-    int ret = demux_process_stream(args, s);
+    int ret = demux_process_stream(args, s, bench);
     libvlc_release(vlc);
     return ret;
 }
 
-int vlc_demux_process_path(const struct vlc_run_args *args, const char *path)
+static int demux_process_path(const struct vlc_run_args *args, const char *path,
+                              struct vlc_demux_bench *bench)
 {
     char *url = vlc_path2uri(path, NULL);
     if (url == NULL)
@@ -337,11 +407,27 @@ int vlc_demux_process_path(const struct vlc_run_args *args, const char *path)
         return -1;
     }
 
-    int ret = vlc_demux_process_url(args, url);
+    int ret = demux_process_url(args, url, bench);
     free(url);
     return ret;
 }
 
+int vlc_demux_process_url(const struct vlc_run_args *args, const char *url)
+{
+    return demux_process_url(args, url, NULL);
+}
+
+int vlc_demux_process_path(const struct vlc_run_args *args, const char *path)
+{
+    return demux_process_path(args, path, NULL);
+}
+
+int vlc_demux_bench_path(const struct vlc_run_args *args, const char *path,
+                         struct vlc_demux_bench *bench)
+{
+    return demux_process_path(args, path, bench);
+}
+
 int vlc_demux_process_memory(const struct vlc_run_args *args,
                              const unsigned char *buf, size_t length)
 {
@@ -354,7 +440,7 @@ int vlc_demux_process_memory(const struct vlc_run_args *args,
     if (s == NULL)
         fprintf(stderr, "Error: cannot create input stream\n");
 
-    int ret = demux_process_stream(args, s);
+    int ret = demux_process_stream(args, s, NULL);
     libvlc_release(vlc);
     return ret;
 }
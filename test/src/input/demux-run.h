@@ -24,9 +24,30 @@
  * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
  *****************************************************************************/
 
+#include <stdint.h>
 #include "common.h"
 
 int vlc_demux_process_url(const struct vlc_run_args *, const char *url);
 int vlc_demux_process_path(const struct vlc_run_args *, const char *path);
 int vlc_demux_process_memory(const struct vlc_run_args *,
                              const unsigned char *buf, size_t length);
+
+/* Demux benchmark, see vlc_demux_bench_path() */
+struct vlc_demux_bench
+{
+    /* in: optional, number of heap allocations made so far */
+    uintmax_t (*allocations)(void);
+    /* in: random seeks to do once the input is demuxed,
+     * out: seeks that succeeded */
+    unsigned seeks;
+
+    uintmax_t blocks; /* sent to the ES out */
+    uintmax_t bytes;
+    uintmax_t block_allocations; /* while demuxing the whole input */
+    int64_t demux_time; /* all times in microseconds */
+    int64_t seek_time; /* from the seek request to the first block, summed */
+    int64_t seek_max;
+};
+
+int vlc_demux_bench_path(const struct vlc_run_args *, const char *path,
+                         struct vlc_demux_bench *);
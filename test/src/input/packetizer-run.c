@@ -0,0 +1,176 @@
+/**
+ * @file packetizer-run.c
+ */
+/*****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_codec.h>
+#include <vlc_modules.h>
+#include "../lib/libvlc_internal.h"
+
+#include <vlc/vlc.h>
+
+#include "packetizer-run.h"
+
+static int64_t now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * INT64_C(1000000000) + ts.tv_nsec;
+}
+
+static block_t *stream_cut(const unsigned char *buf, size_t length,
+                           size_t block_size, uintmax_t *count)
+{
+    block_t *chain = NULL, **pp_last = &chain;
+
+    *count = 0;
+    for (size_t offset = 0; offset < length; offset += block_size)
+    {
+        size_t size = __MIN(block_size, length - offset);
+        block_t *block = block_Alloc(size);
+        if (block == NULL)
+        {
+            block_ChainRelease(chain);
+            return NULL;
+        }
+        memcpy(block->p_buffer, &buf[offset], size);
+        /* Only the start is dated, as by the ES demuxers */
+        if (offset == 0)
+            block->i_pts = block->i_dts = VLC_TS_0;
+        block_ChainLastAppend(&pp_last, block);
+        (*count)++;
+    }
+    return chain;
+}
+
+static void packetizer_run(decoder_t *packetizer, block_t *chain,
+                           struct vlc_packetizer_bench *bench)
+{
+    block_t *block = chain;
+
+    for (;;)
+    {
+        block_t *next = NULL, **pp_block = NULL;
+        if (block != NULL)
+        {
+            next = block->p_next;
+            block->p_next = NULL;
+            pp_block = &block;
+        }
+
+        for (;;)
+        {
+            int64_t start = now();
+            block_t *out = packetizer->pf_packetize(packetizer, pp_block);
+            if (out == NULL)
+                break;
+
+            int64_t latency = now() - start;
+            if (latency > bench->latency_max)
+                bench->latency_max = latency;
+
+            /* As done by the decoder thread */
+            if (packetizer->pf_get_cc != NULL)
+            {
+                decoder_cc_desc_t desc;
+                block_t *cc = packetizer->pf_get_cc(packetizer, &desc);
+                if (cc != NULL)
+                    block_Release(cc);
+            }
+
+            for (block_t *unit = out; unit != NULL; unit = unit->p_next)
+            {
+                bench->units++;
+                bench->bytes += unit->i_buffer;
+            }
+            block_ChainRelease(out);
+        }
+
+        if (pp_block == NULL)
+            break; /* drained */
+        block = next;
+    }
+}
+
+int vlc_packetizer_bench_memory(const struct vlc_run_args *args,
+                                int cat, uint32_t codec,
+                                const unsigned char *buf, size_t length,
+                                struct vlc_packetizer_bench *bench)
+{
+    libvlc_instance_t *vlc = libvlc_create(args);
+    if (vlc == NULL)
+        return -1;
+
+    int ret = -1;
+    decoder_t *packetizer = vlc_object_create(vlc->p_libvlc_int,
+                                              sizeof (*packetizer));
+    if (packetizer == NULL)
+        goto out;
+
+    es_format_Init(&packetizer->fmt_in, cat, codec);
+    es_format_Init(&packetizer->fmt_out, cat, 0);
+    packetizer->p_module = module_need(packetizer, "packetizer",
+                                       args->name, args->name != NULL);
+    if (packetizer->p_module == NULL)
+    {
+        fprintf(stderr, "Error: cannot create packetizer for %4.4s\n",
+                (const char *)&codec);
+        goto error;
+    }
+
+    block_t *chain = stream_cut(buf, length, bench->block_size,
+                                &bench->blocks);
+    if (chain != NULL)
+    {
+        uintmax_t allocations = 0;
+
+        bench->units = bench->bytes = 0;
+        bench->latency_max = 0;
+        if (bench->allocations != NULL)
+            allocations = bench->allocations();
+        int64_t start = now();
+
+        packetizer_run(packetizer, chain, bench);
+
+        bench->time = now() - start;
+        if (bench->allocations != NULL)
+            bench->unit_allocations = bench->allocations() - allocations;
+        ret = 0;
+    }
+
+    module_unneed(packetizer, packetizer->p_module);
+    es_format_Clean(&packetizer->fmt_out);
+error:
+    es_format_Clean(&packetizer->fmt_in);
+    vlc_object_release(packetizer);
+out:
+    libvlc_release(vlc);
+    return ret;
+}
@@ -0,0 +1,52 @@
+/**
+ * @file packetizer-run.h
+ */
+/*****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include <stdint.h>
+#include "common.h"
+
+/* Packetizer benchmark, see vlc_packetizer_bench_memory() */
+struct vlc_packetizer_bench
+{
+    /* in: optional, number of heap allocations made so far */
+    uintmax_t (*allocations)(void);
+    /* in: size of the blocks the elementary stream is cut into */
+    size_t block_size;
+
+    uintmax_t blocks; /* fed to the packetizer */
+    uintmax_t units; /* access units or frames output */
+    uintmax_t bytes; /* output */
+    uintmax_t unit_allocations; /* while packetizing the whole input */
+    int64_t time; /* all times in nanoseconds */
+    int64_t latency_max; /* of the calls returning a unit */
+};
+
+/**
+ * Packetizes an elementary stream held in memory.
+ *
+ * The stream is cut in blocks of bench->block_size bytes, all allocated
+ * before the measurement starts, and the packetizer is drained at the end.
+ * @param codec elementary stream codec (packetizer input)
+ * @param cat elementary stream category
+ */
+int vlc_packetizer_bench_memory(const struct vlc_run_args *,
+                                int cat, uint32_t codec,
+                                const unsigned char *buf, size_t length,
+                                struct vlc_packetizer_bench *);
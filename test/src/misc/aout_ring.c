@@ -0,0 +1,182 @@
+/*****************************************************************************
+ * aout_ring.c test audio samples ring buffer
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "../../libvlc/test.h"
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <vlc_common.h>
+#include <vlc_aout_ring.h>
+#include <assert.h>
+
+#define CHANNELS 2
+#define FRAMES   100000
+#define CHUNK    37 /* not a divisor of the capacities */
+
+/* The ring does not block: the threads wait for each other with these */
+static vlc_mutex_t lock = VLC_STATIC_MUTEX;
+static vlc_cond_t wait = VLC_STATIC_COND;
+
+static void Signal(void)
+{
+    vlc_mutex_lock(&lock);
+    vlc_cond_signal(&wait);
+    vlc_mutex_unlock(&lock);
+}
+
+static aout_ring_t *NewRing(size_t frames)
+{
+    aout_ring_t *ring = malloc(sizeof (*ring));
+    int16_t *buf = malloc(frames * CHANNELS * sizeof (*buf));
+    assert(ring != NULL && buf != NULL);
+    aout_RingInit(ring, buf, frames, CHANNELS * sizeof (*buf));
+    return ring;
+}
+
+static void DeleteRing(aout_ring_t *ring)
+{
+    free(ring->buffer);
+    aout_RingRelease(ring);
+}
+
+static void *Producer(void *data)
+{
+    aout_ring_t *ring = data;
+    int16_t chunk[CHUNK * CHANNELS];
+
+    for (unsigned i = 0; i < FRAMES;)
+    {
+        unsigned n = FRAMES - i < CHUNK ? FRAMES - i : CHUNK;
+
+        for (unsigned j = 0; j < n; j++)
+            for (unsigned c = 0; c < CHANNELS; c++)
+                chunk[j * CHANNELS + c] = (int16_t)(i + j + c);
+
+        /* Retry the frames that did not fit, the ring being full */
+        for (size_t done = 0; done < n;)
+        {
+            size_t count = aout_RingWrite(ring, chunk + done * CHANNELS,
+                                          n - done);
+            if (count == 0)
+            {
+                vlc_mutex_lock(&lock);
+                while (aout_RingGetPending(ring) == ring->frames)
+                    vlc_cond_wait(&wait, &lock);
+                vlc_mutex_unlock(&lock);
+            }
+            else
+                Signal();
+            done += count;
+        }
+        i += n;
+    }
+    return NULL;
+}
+
+static void test_threads(size_t capacity)
+{
+    aout_ring_t *ring = NewRing(capacity);
+
+    vlc_thread_t th;
+    int ret = vlc_clone(&th, Producer, ring, VLC_THREAD_PRIORITY_LOW);
+    assert(ret == 0);
+
+    unsigned i = 0;
+    while (i < FRAMES)
+    {
+        const void *data;
+        size_t count = aout_RingPeek(ring, &data);
+        const int16_t *p = data;
+
+        if (count == 0)
+        {
+            vlc_mutex_lock(&lock);
+            while (aout_RingGetPending(ring) == 0)
+                vlc_cond_wait(&wait, &lock);
+            vlc_mutex_unlock(&lock);
+            continue;
+        }
+        assert(count <= capacity);
+        for (size_t j = 0; j < count; j++)
+            for (unsigned c = 0; c < CHANNELS; c++)
+                assert(p[j * CHANNELS + c] == (int16_t)(i + j + c));
+        aout_RingConsume(ring, count);
+        Signal();
+        i += count;
+    }
+    assert(i == FRAMES);
+
+    vlc_join(th, NULL);
+    assert(aout_RingGetPending(ring) == 0);
+    DeleteRing(ring);
+}
+
+static void test_single(void)
+{
+    aout_ring_t *ring = NewRing(4);
+    const int16_t in[6 * CHANNELS] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+    const void *data;
+
+    assert(aout_RingPeek(ring, &data) == 0);
+    assert(aout_RingWrite(ring, in, 3) == 3);
+    assert(aout_RingGetPending(ring) == 3);
+
+    /* Full */
+    assert(aout_RingWrite(ring, in + 3 * CHANNELS, 3) == 1);
+    assert(aout_RingGetPending(ring) == 4);
+
+    assert(aout_RingPeek(ring, &data) == 4);
+    assert(((const int16_t *)data)[0] == 0);
+    aout_RingConsume(ring, 2);
+
+    /* Wraps around */
+    assert(aout_RingWrite(ring, in + 4 * CHANNELS, 2) == 2);
+    assert(aout_RingPeek(ring, &data) == 2);
+    assert(((const int16_t *)data)[0] == 2 * CHANNELS);
+    aout_RingConsume(ring, 2);
+    assert(aout_RingPeek(ring, &data) == 2);
+    assert(((const int16_t *)data)[0] == 4 * CHANNELS);
+    assert(((const int16_t *)data)[CHANNELS] == 5 * CHANNELS);
+    aout_RingConsume(ring, 1);
+
+    /* Flushed frames are skipped */
+    assert(aout_RingWrite(ring, in, 2) == 2);
+    aout_RingFlush(ring);
+    assert(aout_RingGetPending(ring) == 0);
+    assert(aout_RingPeek(ring, &data) == 0);
+    assert(aout_RingWrite(ring, in + CHANNELS, 1) == 1);
+    assert(aout_RingPeek(ring, &data) == 1);
+    assert(((const int16_t *)data)[0] == CHANNELS);
+
+    /* References */
+    aout_RingHold(ring);
+    aout_RingRelease(ring);
+    DeleteRing(ring);
+}
+
+int main(void)
+{
+    test_init();
+
+    test_single();
+    test_threads(256);
+    test_threads(4096);
+    return 0;
+}
@@ -0,0 +1,115 @@
+/*****************************************************************************
+ * spsc.c test single producer single consumer block queue
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "../../libvlc/test.h"
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <assert.h>
+
+#define BLOCKS 100000
+
+static block_t *NewBlock(mtime_t i)
+{
+    block_t *block = block_Alloc(0);
+    assert(block != NULL);
+    block->i_dts = i;
+    return block;
+}
+
+static void *Producer(void *data)
+{
+    vlc_spsc_t *q = data;
+
+    for (mtime_t i = 0; i < BLOCKS; i++)
+        assert(vlc_spsc_Push(q, NewBlock(i)));
+    vlc_spsc_Close(q);
+    return NULL;
+}
+
+static void test_threads(size_t capacity)
+{
+    vlc_spsc_t *q = vlc_spsc_New(capacity);
+    assert(q != NULL);
+
+    vlc_thread_t th;
+    int ret = vlc_clone(&th, Producer, q, VLC_THREAD_PRIORITY_LOW);
+    assert(ret == 0);
+
+    block_t *block;
+    mtime_t i = 0;
+    while ((block = vlc_spsc_Pop(q)) != NULL)
+    {
+        assert(block->i_dts == i++);
+        block_Release(block);
+    }
+    assert(i == BLOCKS);
+
+    vlc_join(th, NULL);
+    vlc_spsc_Delete(q);
+}
+
+static void test_single(void)
+{
+    vlc_spsc_t *q = vlc_spsc_New(3);
+    assert(q != NULL);
+
+    assert(vlc_spsc_TryPop(q) == NULL);
+    for (mtime_t i = 0; i < 4; i++)
+        assert(vlc_spsc_TryPush(q, NewBlock(i)));
+    assert(vlc_spsc_GetCount(q) == 4);
+
+    block_t *block = NewBlock(4);
+    assert(!vlc_spsc_TryPush(q, block));
+
+    block_t *first = vlc_spsc_TryPop(q);
+    assert(first != NULL && first->i_dts == 0);
+    block_Release(first);
+    assert(vlc_spsc_TryPush(q, block));
+
+    vlc_spsc_Close(q);
+    assert(!vlc_spsc_Push(q, NewBlock(5)));
+    for (mtime_t i = 1; i < 5; i++)
+    {
+        block = vlc_spsc_Pop(q);
+        assert(block != NULL && block->i_dts == i);
+        block_Release(block);
+    }
+    assert(vlc_spsc_Pop(q) == NULL);
+
+    /* leftover blocks are released */
+    vlc_spsc_Delete(q);
+    q = vlc_spsc_New(2);
+    assert(vlc_spsc_TryPush(q, NewBlock(0)));
+    vlc_spsc_Delete(q);
+}
+
+int main(void)
+{
+    test_init();
+
+    test_single();
+    test_threads(1);
+    test_threads(4);
+    test_threads(1024);
+    return 0;
+}
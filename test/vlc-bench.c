@@ -0,0 +1,607 @@
+/**
+ * @file vlc-bench.c
+ */
+/*****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* End-to-end playback benchmark: plays a corpus of samples through LibVLC,
+ * with the video output callbacks and the dummy audio output, and writes the
+ * results of each scenario as JSON on the standard output. */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/resource.h>
+
+#include <vlc_common.h>
+#include <vlc_threads.h>
+#include <vlc/vlc.h>
+
+#ifdef __GLIBC__
+/* Count the heap allocations of the whole process, by wrapping the glibc
+ * allocator entry points */
+void *__libc_malloc(size_t);
+void *__libc_calloc(size_t, size_t);
+void *__libc_realloc(void *, size_t);
+void *__libc_memalign(size_t, size_t);
+
+static atomic_uintmax_t allocations = ATOMIC_VAR_INIT(0);
+
+void *malloc(size_t size)
+{
+    atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size)
+{
+    atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    if (ptr == NULL)
+        atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+
+int posix_memalign(void **ptr, size_t align, size_t size)
+{
+    atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+    *ptr = __libc_memalign(align, size);
+    return (*ptr != NULL) ? 0 : ENOMEM;
+}
+
+static uintmax_t count_allocations(void)
+{
+    return atomic_load_explicit(&allocations, memory_order_relaxed);
+}
+#else
+static uintmax_t count_allocations(void)
+{
+    return 0;
+}
+#endif
+
+/* Longest wait for a picture or for the end of a stream */
+#define BENCH_TIMEOUT (10 * CLOCK_FREQ)
+/* Playback rate of the sustained decoding, as fast as the input allows */
+#define BENCH_DECODE_RATE 8.f
+#define BENCH_SOUT "#transcode{vcodec=mp2v,vb=4000,acodec=mpga,ab=192}:dummy"
+
+struct bench
+{
+    libvlc_instance_t *vlc;
+    libvlc_media_player_t *mp;
+
+    vlc_mutex_t lock;
+    vlc_cond_t wait;
+    unsigned frames; /* pictures displayed */
+    mtime_t frame_date; /* date of the last picture */
+    bool ended; /* end of stream or error */
+
+    void *pixels;
+
+    /* Resources at the start of the scenario */
+    struct rusage usage;
+    uintmax_t allocations;
+    mtime_t start;
+};
+
+/*
+ * Video output callbacks: the pictures are counted, not rendered
+ */
+static unsigned VideoFormat(void **opaque, char *chroma, unsigned *width,
+                            unsigned *height, unsigned *pitches,
+                            unsigned *lines)
+{
+    struct bench *b = *opaque;
+    unsigned pitch = (*width + 31) & ~31;
+
+    memcpy(chroma, "I420", 4);
+    pitches[0] = pitch;
+    pitches[1] = pitches[2] = pitch / 2;
+    lines[0] = (*height + 1) & ~1;
+    lines[1] = lines[2] = lines[0] / 2;
+
+    b->pixels = malloc(pitch * lines[0] * 3 / 2);
+    return (b->pixels != NULL) ? 1 : 0;
+}
+
+static void VideoCleanup(void *opaque)
+{
+    struct bench *b = opaque;
+
+    free(b->pixels);
+    b->pixels = NULL;
+}
+
+static void *VideoLock(void *opaque, void **planes)
+{
+    struct bench *b = opaque;
+    unsigned char *pixels = b->pixels;
+
+    /* The plane sizes do not matter: nothing reads the pixels */
+    planes[0] = planes[1] = planes[2] = pixels;
+    return NULL;
+}
+
+static void VideoDisplay(void *opaque, void *picture)
+{
+    struct bench *b = opaque;
+
+    vlc_mutex_lock(&b->lock);
+    b->frames++;
+    b->frame_date = libvlc_clock();
+    vlc_cond_broadcast(&b->wait);
+    vlc_mutex_unlock(&b->lock);
+    (void) picture;
+}
+
+static void PlayerEvent(const libvlc_event_t *event, void *opaque)
+{
+    struct bench *b = opaque;
+
+    (void) event;
+    vlc_mutex_lock(&b->lock);
+    b->ended = true;
+    vlc_cond_broadcast(&b->wait);
+    vlc_mutex_unlock(&b->lock);
+}
+
+/* Waits for more than the given count of pictures to be displayed.
+ * Returns the date of the picture, or -1 at the end of the stream. */
+static mtime_t WaitFrame(struct bench *b, unsigned count)
+{
+    mtime_t deadline = mdate() + BENCH_TIMEOUT;
+    mtime_t date = -1;
+
+    vlc_mutex_lock(&b->lock);
+    while (b->frames <= count && !b->ended)
+        if (vlc_cond_timedwait(&b->wait, &b->lock, deadline))
+            break;
+    if (b->frames > count)
+        date = b->frame_date;
+    vlc_mutex_unlock(&b->lock);
+    return date;
+}
+
+/* Waits for the end of the stream, at most until the given date */
+static void WaitEnd(struct bench *b, mtime_t deadline)
+{
+    vlc_mutex_lock(&b->lock);
+    while (!b->ended)
+        if (vlc_cond_timedwait(&b->wait, &b->lock, deadline))
+            break;
+    vlc_mutex_unlock(&b->lock);
+}
+
+static unsigned GetFrames(struct bench *b)
+{
+    vlc_mutex_lock(&b->lock);
+    unsigned frames = b->frames;
+    vlc_mutex_unlock(&b->lock);
+    return frames;
+}
+
+static int Play(struct bench *b, const char *mrl, const char *option)
+{
+    libvlc_media_t *md;
+
+    if (strstr(mrl, "://") != NULL)
+        md = libvlc_media_new_location(b->vlc, mrl);
+    else
+        md = libvlc_media_new_path(b->vlc, mrl);
+    if (md == NULL)
+        return -1;
+
+    /* Decode every picture, even late */
+    libvlc_media_add_option(md, ":no-avcodec-hurry-up");
+    if (option != NULL)
+        libvlc_media_add_option(md, option);
+
+    vlc_mutex_lock(&b->lock);
+    b->frames = 0;
+    b->ended = false;
+    vlc_mutex_unlock(&b->lock);
+
+    libvlc_media_player_set_media(b->mp, md);
+    libvlc_media_release(md);
+    return libvlc_media_player_play(b->mp);
+}
+
+/*
+ * Results
+ */
+static bool first_result = true;
+
+static void BeginResult(struct bench *b, const char *scenario,
+                        const char *mrl)
+{
+    printf("%s\n  {\n    \"scenario\": \"%s\",\n    \"media\": \"",
+           first_result ? "" : ",", scenario);
+    first_result = false;
+
+    /* Escape the path as a JSON string */
+    for (const char *p = mrl; *p != '\0'; p++)
+    {
+        if (*p == '"' || *p == '\\')
+            putchar('\\');
+        if ((unsigned char)*p >= 0x20)
+            putchar(*p);
+    }
+    printf("\",\n");
+
+    getrusage(RUSAGE_SELF, &b->usage);
+    b->allocations = count_allocations();
+    b->start = libvlc_clock();
+}
+
+static double Seconds(const struct timeval *tv)
+{
+    return tv->tv_sec + tv->tv_usec / 1e6;
+}
+
+/* Prints the CPU time of each thread alive at the end of the scenario,
+ * while the threads of the player still run */
+static void PrintThreads(void)
+{
+    printf("    \"threads\": [");
+#ifdef __linux__
+    DIR *dir = opendir("/proc/self/task");
+    if (dir != NULL)
+    {
+        const long ticks = sysconf(_SC_CLK_TCK);
+        const char *sep = "";
+        struct dirent *ent;
+
+        while ((ent = readdir(dir)) != NULL)
+        {
+            char path[64], line[512];
+            unsigned long utime, stime;
+
+            if (ent->d_name[0] == '.')
+                continue;
+            snprintf(path, sizeof (path), "/proc/self/task/%s/stat",
+                     ent->d_name);
+
+            FILE *stream = fopen(path, "rt");
+            if (stream == NULL)
+                continue;
+            char *s = fgets(line, sizeof (line), stream);
+            fclose(stream);
+            if (s == NULL)
+                continue;
+
+            /* Skip the command name, that may contain spaces */
+            s = strrchr(line, ')');
+            if (s == NULL
+             || sscanf(s + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u "
+                       "%lu %lu", &utime, &stime) != 2)
+                continue;
+
+            printf("%s\n      { \"tid\": %s, \"user\": %.3f, "
+                   "\"system\": %.3f }", sep, ent->d_name,
+                   (double)utime / ticks, (double)stime / ticks);
+            sep = ",";
+        }
+        closedir(dir);
+    }
+#endif
+    printf("\n    ],\n");
+}
+
+static void EndResult(struct bench *b)
+{
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+    PrintThreads();
+    printf("    \"elapsed\": %.3f,\n"
+           "    \"user\": %.3f,\n"
+           "    \"system\": %.3f,\n"
+           "    \"allocations\": %ju\n  }",
+           (libvlc_clock() - b->start) / 1e6,
+           Seconds(&usage.ru_utime) - Seconds(&b->usage.ru_utime),
+           Seconds(&usage.ru_stime) - Seconds(&b->usage.ru_stime),
+           count_allocations() - b->allocations);
+    fflush(stdout);
+}
+
+/*
+ * Scenarios
+ */
+struct scenario_args
+{
+    unsigned duration; /* seconds */
+    unsigned seeks;
+};
+
+/* Time from the start of the playback to the first picture */
+static void BenchOpen(struct bench *b, const char *mrl,
+                      const struct scenario_args *args)
+{
+    BeginResult(b, "open", mrl);
+
+    mtime_t start = libvlc_clock();
+    if (Play(b, mrl, NULL) == 0)
+    {
+        mtime_t date = WaitFrame(b, 0);
+        if (date >= 0)
+            printf("    \"first_frame\": %.3f,\n", (date - start) / 1e3);
+    }
+    EndResult(b);
+    libvlc_media_player_stop(b->mp);
+    (void) args;
+}
+
+/* Pictures decoded per second, playing faster than real time */
+static void BenchDecode(struct bench *b, const char *mrl,
+                        const struct scenario_args *args)
+{
+    BeginResult(b, "decode", mrl);
+
+    if (Play(b, mrl, NULL) == 0 && WaitFrame(b, 0) >= 0)
+    {
+        libvlc_media_t *md = libvlc_media_player_get_media(b->mp);
+        libvlc_media_stats_t before, after;
+        mtime_t start = libvlc_clock();
+
+        libvlc_media_get_stats(md, &before);
+        libvlc_media_player_set_rate(b->mp, BENCH_DECODE_RATE);
+        WaitEnd(b, start + args->duration * CLOCK_FREQ);
+        libvlc_media_get_stats(md, &after);
+
+        double seconds = (libvlc_clock() - start) / 1e6;
+        printf("    \"decoded_fps\": %.1f,\n"
+               "    \"displayed_fps\": %.1f,\n"
+               "    \"lost_pictures\": %d,\n",
+               (after.i_decoded_video - before.i_decoded_video) / seconds,
+               (after.i_displayed_pictures - before.i_displayed_pictures)
+                   / seconds,
+               after.i_lost_pictures - before.i_lost_pictures);
+        libvlc_media_release(md);
+    }
+    EndResult(b);
+    libvlc_media_player_stop(b->mp);
+}
+
+/* Time from a seek request to the first picture after it */
+static void BenchSeek(struct bench *b, const char *mrl,
+                      const struct scenario_args *args)
+{
+    BeginResult(b, "seek", mrl);
+
+    if (Play(b, mrl, NULL) == 0 && WaitFrame(b, 0) >= 0)
+    {
+        mtime_t total = 0, max = 0;
+        unsigned count = 0;
+
+        for (unsigned i = 0; i < args->seeks; i++)
+        {
+            unsigned frames = GetFrames(b);
+            mtime_t start = libvlc_clock();
+
+            libvlc_media_player_set_position(b->mp,
+                                             (i + 1.f) / (args->seeks + 1));
+            mtime_t date = WaitFrame(b, frames);
+            if (date < 0)
+                break;
+
+            total += date - start;
+            if (date - start > max)
+                max = date - start;
+            count++;
+        }
+
+        printf("    \"seeks\": %u,\n", count);
+        if (count > 0)
+            printf("    \"seek_average\": %.3f,\n"
+                   "    \"seek_max\": %.3f,\n",
+                   total / 1e3 / count, max / 1e3);
+    }
+    EndResult(b);
+    libvlc_media_player_stop(b->mp);
+}
+
+/* Time to switch from a playing sample to the first picture of the next */
+static void BenchZap(struct bench *b, char *const *mrls, unsigned count,
+                     const struct scenario_args *args)
+{
+    mtime_t total = 0, max = 0;
+    unsigned zaps = 0;
+
+    BeginResult(b, "zap", mrls[0]);
+
+    if (Play(b, mrls[0], NULL) == 0 && WaitFrame(b, 0) >= 0)
+        for (unsigned i = 1; i < count + 1; i++)
+        {
+            mtime_t start = libvlc_clock();
+
+            /* Loop back to the first sample for a single one */
+            if (Play(b, mrls[i % count], NULL))
+                break;
+            mtime_t date = WaitFrame(b, 0);
+            if (date < 0)
+                break;
+
+            total += date - start;
+            if (date - start > max)
+                max = date - start;
+            zaps++;
+        }
+
+    printf("    \"zaps\": %u,\n", zaps);
+    if (zaps > 0)
+        printf("    \"zap_average\": %.3f,\n"
+               "    \"zap_max\": %.3f,\n", total / 1e3 / zaps, max / 1e3);
+    EndResult(b);
+    libvlc_media_player_stop(b->mp);
+    (void) args;
+}
+
+/* Pictures transcoded per second, through the stream output */
+static void BenchTranscode(struct bench *b, const char *mrl,
+                           const struct scenario_args *args)
+{
+    const char *sout = getenv("VLC_BENCH_SOUT");
+    char *option;
+
+    if (asprintf(&option, ":sout=%s", sout ? sout : BENCH_SOUT) == -1)
+        return;
+
+    BeginResult(b, "transcode", mrl);
+
+    mtime_t start = libvlc_clock();
+    if (Play(b, mrl, option) == 0)
+    {
+        libvlc_media_t *md = libvlc_media_player_get_media(b->mp);
+        libvlc_media_stats_t stats;
+
+        WaitEnd(b, start + args->duration * CLOCK_FREQ);
+        libvlc_media_get_stats(md, &stats);
+
+        double seconds = (libvlc_clock() - start) / 1e6;
+        printf("    \"transcoded_fps\": %.1f,\n"
+               "    \"sent_packets\": %d,\n",
+               stats.i_decoded_video / seconds, stats.i_sent_packets);
+        libvlc_media_release(md);
+    }
+    EndResult(b);
+    libvlc_media_player_stop(b->mp);
+    free(option);
+}
+
+static const struct
+{
+    const char *name;
+    void (*run)(struct bench *, const char *, const struct scenario_args *);
+} scenarios[] = {
+    { "open",      BenchOpen },
+    { "decode",    BenchDecode },
+    { "seek",      BenchSeek },
+    { "zap",       NULL /* over the whole corpus */ },
+    { "transcode", BenchTranscode },
+};
+
+static int Usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s [-d seconds] [-n seeks] "
+            "<all|open|decode|seek|zap|transcode> <samples...>\n"
+            "  The transcoding chain can be set with VLC_BENCH_SOUT.\n",
+            name);
+    return 1;
+}
+
+int main(int argc, char *argv[])
+{
+    struct scenario_args args = { .duration = 10, .seeks = 10 };
+    int c;
+
+    while ((c = getopt(argc, argv, "d:n:")) != -1)
+        switch (c)
+        {
+            case 'd':
+                args.duration = strtoul(optarg, NULL, 10);
+                break;
+            case 'n':
+                args.seeks = strtoul(optarg, NULL, 10);
+                break;
+            default:
+                return Usage(argv[0]);
+        }
+
+    if (argc - optind < 2)
+        return Usage(argv[0]);
+
+    const char *scenario = argv[optind];
+    char *const *mrls = &argv[optind + 1];
+    unsigned count = argc - optind - 1;
+    bool all = !strcmp(scenario, "all");
+    bool found = all;
+
+    for (size_t i = 0; i < ARRAY_SIZE(scenarios); i++)
+        if (!strcmp(scenario, scenarios[i].name))
+            found = true;
+    if (!found)
+    {
+        fprintf(stderr, "Error: unknown scenario %s\n", scenario);
+        return Usage(argv[0]);
+    }
+
+    static const char *const vlc_args[] = {
+        "--quiet", "--aout=adummy", "--no-video-title-show", "--stats",
+    };
+    struct bench b = { .pixels = NULL };
+
+    setenv("VLC_PLUGIN_PATH", "../modules", 0);
+    b.vlc = libvlc_new(ARRAY_SIZE(vlc_args), vlc_args);
+    if (b.vlc == NULL)
+        return 1;
+
+    b.mp = libvlc_media_player_new(b.vlc);
+    if (b.mp == NULL)
+    {
+        libvlc_release(b.vlc);
+        return 1;
+    }
+
+    vlc_mutex_init(&b.lock);
+    vlc_cond_init(&b.wait);
+
+    libvlc_video_set_format_callbacks(b.mp, VideoFormat, VideoCleanup);
+    libvlc_video_set_callbacks(b.mp, VideoLock, NULL, VideoDisplay, &b);
+
+    libvlc_event_manager_t *em = libvlc_media_player_event_manager(b.mp);
+    libvlc_event_attach(em, libvlc_MediaPlayerEndReached, PlayerEvent, &b);
+    libvlc_event_attach(em, libvlc_MediaPlayerEncounteredError,
+                        PlayerEvent, &b);
+
+    printf("[");
+    for (size_t i = 0; i < ARRAY_SIZE(scenarios); i++)
+    {
+        if (!all && strcmp(scenario, scenarios[i].name))
+            continue;
+
+        if (scenarios[i].run == NULL)
+            BenchZap(&b, mrls, count, &args);
+        else
+            for (unsigned j = 0; j < count; j++)
+                scenarios[i].run(&b, mrls[j], &args);
+    }
+    printf("\n]\n");
+
+    libvlc_event_detach(em, libvlc_MediaPlayerEndReached, PlayerEvent, &b);
+    libvlc_event_detach(em, libvlc_MediaPlayerEncounteredError,
+                        PlayerEvent, &b);
+    libvlc_media_player_release(b.mp);
+    libvlc_release(b.vlc);
+    vlc_cond_destroy(&b.wait);
+    vlc_mutex_destroy(&b.lock);
+    return 0;
+}
@@ -0,0 +1,162 @@
+/**
+ * @file vlc-chroma-bench.c
+ */
+/*****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Chroma conversion benchmark: converts I420 pictures to RGB32 with a video
+ * converter module, at several resolutions, and prints the time per picture.
+ * The remaining arguments are passed to LibVLC, e.g.
+ * --video-filter-threads=1 to disable the slice threads. */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <vlc_common.h>
+#include <vlc_filter.h>
+#include <vlc_modules.h>
+#include <vlc_picture.h>
+#include "../lib/libvlc_internal.h"
+
+#include <vlc/vlc.h>
+
+#define BENCH_PICTURES 100
+
+static const struct
+{
+    const char *name;
+    unsigned width, height;
+} resolutions[] = {
+    { "360p",   640,  360 },
+    { "720p",  1280,  720 },
+    { "1080p", 1920, 1080 },
+    { "2160p", 3840, 2160 },
+};
+
+static int64_t now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * INT64_C(1000000000) + ts.tv_nsec;
+}
+
+/* The output picture is allocated once, outside of the measurement */
+static picture_t *buffer_new(filter_t *filter)
+{
+    return picture_Hold((picture_t *)filter->owner.sys);
+}
+
+static int bench(vlc_object_t *parent, const char *module, unsigned width,
+                 unsigned height, double *ms)
+{
+    filter_t *filter = vlc_object_create(parent, sizeof (*filter));
+    if (filter == NULL)
+        return -1;
+
+    int ret = -1;
+    es_format_Init(&filter->fmt_in, VIDEO_ES, VLC_CODEC_I420);
+    video_format_Setup(&filter->fmt_in.video, VLC_CODEC_I420, width, height,
+                       width, height, 1, 1);
+    es_format_Init(&filter->fmt_out, VIDEO_ES, VLC_CODEC_RGB32);
+    video_format_Setup(&filter->fmt_out.video, VLC_CODEC_RGB32, width, height,
+                       width, height, 1, 1);
+    video_format_FixRgb(&filter->fmt_out.video);
+
+    picture_t *in = picture_NewFromFormat(&filter->fmt_in.video);
+    picture_t *out = picture_NewFromFormat(&filter->fmt_out.video);
+    if (in == NULL || out == NULL)
+        goto error;
+
+    /* Random samples, so that no clipping shortcuts are taken */
+    for (int i = 0; i < in->i_planes; i++)
+        for (int y = 0; y < in->p[i].i_lines; y++)
+            for (int x = 0; x < in->p[i].i_pitch; x++)
+                in->p[i].p_pixels[y * in->p[i].i_pitch + x] = rand();
+
+    filter->owner.sys = out;
+    filter->owner.video.buffer_new = buffer_new;
+    filter->p_module = module_need(filter, "video converter", module,
+                                   module != NULL);
+    if (filter->p_module == NULL)
+    {
+        fprintf(stderr, "Error: no converter for %ux%u\n", width, height);
+        goto error;
+    }
+
+    int64_t start = now();
+    for (unsigned i = 0; i < BENCH_PICTURES; i++)
+    {
+        picture_t *pic = filter->pf_video_filter(filter, picture_Hold(in));
+        if (pic != NULL)
+            picture_Release(pic);
+    }
+    *ms = (now() - start) / (BENCH_PICTURES * 1e6);
+    ret = 0;
+
+    module_unneed(filter, filter->p_module);
+error:
+    if (out != NULL)
+        picture_Release(out);
+    if (in != NULL)
+        picture_Release(in);
+    es_format_Clean(&filter->fmt_out);
+    es_format_Clean(&filter->fmt_in);
+    vlc_object_release(filter);
+    return ret;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *module = NULL;
+
+    if (argc > 1 && argv[1][0] != '-')
+    {
+        module = argv[1];
+        argc--;
+        argv++;
+    }
+
+    setenv("VLC_PLUGIN_PATH", "../modules", 0);
+
+    libvlc_instance_t *vlc = libvlc_new(argc - 1,
+                                        (const char *const *)argv + 1);
+    if (vlc == NULL)
+        return 1;
+
+    printf("%-8s %12s %12s\n", "size", "ms/picture", "Mpixels/s");
+    for (size_t i = 0; i < ARRAY_SIZE(resolutions); i++)
+    {
+        double ms;
+
+        if (bench(VLC_OBJECT(vlc->p_libvlc_int), module,
+                  resolutions[i].width, resolutions[i].height, &ms))
+            continue;
+        printf("%-8s %12.3f %12.1f\n", resolutions[i].name, ms,
+               resolutions[i].width * resolutions[i].height / (ms * 1e3));
+    }
+
+    libvlc_release(vlc);
+    return 0;
+}
@@ -0,0 +1,119 @@
+/**
+ * @file vlc-demux-bench.c
+ */
+/*****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "src/input/demux-run.h"
+
+#ifdef __GLIBC__
+/* Count the heap allocations of the whole process, by wrapping the glibc
+ * allocator entry points */
+void *__libc_malloc(size_t);
+void *__libc_calloc(size_t, size_t);
+void *__libc_realloc(void *, size_t);
+void *__libc_memalign(size_t, size_t);
+
+static atomic_uintmax_t allocations = ATOMIC_VAR_INIT(0);
+
+void *malloc(size_t size)
+{
+    atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size)
+{
+    atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    if (ptr == NULL)
+        atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+
+int posix_memalign(void **ptr, size_t align, size_t size)
+{
+    atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+    *ptr = __libc_memalign(align, size);
+    return (*ptr != NULL) ? 0 : ENOMEM;
+}
+
+static uintmax_t count_allocations(void)
+{
+    return atomic_load_explicit(&allocations, memory_order_relaxed);
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+    struct vlc_run_args args;
+    struct vlc_demux_bench bench = { 0 };
+
+    vlc_run_args_init(&args);
+    if (args.name == NULL)
+        args.name = "mkv";
+
+    switch (argc)
+    {
+        case 3:
+            bench.seeks = atoi(argv[2]);
+            /* fall through */
+        case 2:
+            break;
+        default:
+            fprintf(stderr, "Usage: [VLC_TARGET=mkv] %s <filename> [seeks]\n",
+                    argv[0]);
+            return 1;
+    }
+
+#ifdef __GLIBC__
+    bench.allocations = count_allocations;
+#endif
+
+    if (vlc_demux_bench_path(&args, argv[1], &bench))
+        return 1;
+
+    double seconds = bench.demux_time / 1e6;
+    if (seconds <= 0.)
+        seconds = 1e-6;
+
+    printf("%ju blocks, %ju bytes in %.3f s\n", bench.blocks, bench.bytes,
+           seconds);
+    printf("%.0f blocks/s, %.0f bytes/s\n", bench.blocks / seconds,
+           bench.bytes / seconds);
+    if (bench.allocations != NULL && bench.blocks > 0)
+        printf("%.2f allocations/block\n",
+               (double)bench.block_allocations / bench.blocks);
+    if (bench.seeks > 0)
+        printf("%u seeks: average %.3f ms, max %.3f ms\n", bench.seeks,
+               bench.seek_time / 1e3 / bench.seeks, bench.seek_max / 1e3);
+
+    return 0;
+}
@@ -0,0 +1,448 @@
+/**
+ * @file vlc-packetizer-bench.c
+ */
+/*****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_es.h>
+#include <vlc_fourcc.h>
+#include "src/input/packetizer-run.h"
+
+#ifdef __GLIBC__
+/* Count the heap allocations of the whole process, by wrapping the glibc
+ * allocator entry points */
+void *__libc_malloc(size_t);
+void *__libc_calloc(size_t, size_t);
+void *__libc_realloc(void *, size_t);
+void *__libc_memalign(size_t, size_t);
+
+static atomic_uintmax_t allocations = ATOMIC_VAR_INIT(0);
+
+void *malloc(size_t size)
+{
+    atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size)
+{
+    atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    if (ptr == NULL)
+        atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+
+int posix_memalign(void **ptr, size_t align, size_t size)
+{
+    atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+    *ptr = __libc_memalign(align, size);
+    return (*ptr != NULL) ? 0 : ENOMEM;
+}
+
+static uintmax_t count_allocations(void)
+{
+    return atomic_load_explicit(&allocations, memory_order_relaxed);
+}
+#endif
+
+/*
+ * Synthetic elementary streams: valid headers, random payloads
+ */
+#define SYNTHETIC_SIZE (32 << 20)
+
+struct stream
+{
+    unsigned char *buf;
+    size_t length;
+    size_t size;
+};
+
+struct bits
+{
+    uint8_t buf[64];
+    size_t pos; /* in bits */
+};
+
+static void bits_put(struct bits *b, unsigned count, uint32_t value)
+{
+    while (count-- > 0)
+    {
+        if ((b->pos & 7) == 0)
+            b->buf[b->pos / 8] = 0;
+        if ((value >> count) & 1)
+            b->buf[b->pos / 8] |= 0x80 >> (b->pos & 7);
+        b->pos++;
+    }
+}
+
+static void bits_put_ue(struct bits *b, uint32_t value)
+{
+    unsigned count = 0;
+    while ((value + 1) >> (count + 1))
+        count++;
+    bits_put(b, count, 0);
+    bits_put(b, count + 1, value + 1);
+}
+
+static void bits_trailing(struct bits *b)
+{
+    bits_put(b, 1, 1);
+    while (b->pos & 7)
+        bits_put(b, 1, 0);
+}
+
+static bool stream_write(struct stream *s, const void *data, size_t length)
+{
+    if (s->length + length > s->size)
+        return false;
+    memcpy(&s->buf[s->length], data, length);
+    s->length += length;
+    return true;
+}
+
+/* Random payload without any 0 byte, so without any false start code */
+static bool stream_random(struct stream *s, size_t length)
+{
+    if (s->length + length > s->size)
+        return false;
+    for (size_t i = 0; i < length; i++)
+        s->buf[s->length++] = 1 + rand() % 255;
+    return true;
+}
+
+static bool stream_nal(struct stream *s, uint8_t header, struct bits *b,
+                       size_t payload)
+{
+    static const uint8_t startcode[] = { 0x00, 0x00, 0x00, 0x01 };
+    return stream_write(s, startcode, sizeof (startcode))
+        && stream_write(s, &header, 1)
+        && stream_write(s, b->buf, (b->pos + 7) / 8)
+        && stream_random(s, payload);
+}
+
+/* 1080p baseline profile, 1 slice per picture, an IDR every 25 pictures
+ * with its SPS and PPS, as in broadcasts */
+static void make_h264(struct stream *s)
+{
+    for (unsigned n = 0;; n++)
+    {
+        struct bits b = { .pos = 0 };
+        bool idr = (n % 25) == 0;
+
+        if (idr)
+        {
+            bits_put(&b, 8, 66); /* profile_idc */
+            bits_put(&b, 8, 0);
+            bits_put(&b, 8, 40); /* level_idc */
+            bits_put_ue(&b, 0); /* seq_parameter_set_id */
+            bits_put_ue(&b, 1); /* log2_max_frame_num_minus4 */
+            bits_put_ue(&b, 2); /* pic_order_cnt_type */
+            bits_put_ue(&b, 1); /* max_num_ref_frames */
+            bits_put(&b, 1, 0);
+            bits_put_ue(&b, 119); /* pic_width_in_mbs_minus1 */
+            bits_put_ue(&b, 67); /* pic_height_in_map_units_minus1 */
+            bits_put(&b, 1, 1); /* frame_mbs_only_flag */
+            bits_put(&b, 1, 1); /* direct_8x8_inference_flag */
+            bits_put(&b, 1, 0); /* frame_cropping_flag */
+            bits_put(&b, 1, 0); /* vui_parameters_present_flag */
+            bits_trailing(&b);
+            if (!stream_nal(s, 0x67, &b, 0))
+                break;
+
+            b.pos = 0;
+            bits_put_ue(&b, 0); /* pic_parameter_set_id */
+            bits_put_ue(&b, 0); /* seq_parameter_set_id */
+            bits_put(&b, 2, 0);
+            bits_put_ue(&b, 0); /* num_slice_groups_minus1 */
+            bits_put_ue(&b, 0);
+            bits_put_ue(&b, 0);
+            bits_put(&b, 3, 0);
+            bits_put_ue(&b, 0); /* pic_init_qp_minus26 */
+            bits_put_ue(&b, 0);
+            bits_put_ue(&b, 0);
+            bits_put(&b, 3, 4); /* deblocking_filter_control_present_flag */
+            bits_trailing(&b);
+            if (!stream_nal(s, 0x68, &b, 0))
+                break;
+        }
+
+        b.pos = 0;
+        bits_put_ue(&b, 0); /* first_mb_in_slice */
+        bits_put_ue(&b, idr ? 7 : 5); /* slice_type (I or P) */
+        bits_put_ue(&b, 0); /* pic_parameter_set_id */
+        bits_put(&b, 5, n % 25); /* frame_num */
+        if (idr)
+        {
+            bits_put_ue(&b, n / 25 % 2); /* idr_pic_id */
+            bits_put(&b, 2, 0); /* dec_ref_pic_marking() */
+        }
+        else
+        {
+            bits_put(&b, 1, 0); /* num_ref_idx_active_override_flag */
+            bits_put(&b, 1, 0); /* ref_pic_list_modification_flag_l0 */
+            bits_put(&b, 1, 0); /* adaptive_ref_pic_marking_mode_flag */
+        }
+        bits_put_ue(&b, 0); /* slice_qp_delta */
+        bits_put_ue(&b, 1); /* disable_deblocking_filter_idc */
+        if (!stream_nal(s, idr ? 0x65 : 0x41, &b, idr ? 150000 : 30000))
+            break;
+    }
+}
+
+/* 1080p MPEG-2 (without extensions), a GOP of 12 pictures, 68 slices */
+static void make_mpgv(struct stream *s)
+{
+    for (unsigned n = 0;; n++)
+    {
+        struct bits b = { .pos = 0 };
+        bool intra = (n % 12) == 0;
+
+        if (intra)
+        {
+            static const uint8_t sequence[] = {
+                0x00, 0x00, 0x01, 0xB3,
+                0x78, 0x04, 0x38, /* 1920x1080 */
+                0x33, /* 16:9, 25 fps */
+                0xFF, 0xFF, 0xE3, 0x80, /* VBR, vbv size 112 */
+            };
+            static const uint8_t gop[] = {
+                0x00, 0x00, 0x01, 0xB8, 0x00, 0x08, 0x00, 0x00,
+            };
+            if (!stream_write(s, sequence, sizeof (sequence))
+             || !stream_write(s, gop, sizeof (gop)))
+                break;
+        }
+
+        static const uint8_t picture[] = { 0x00, 0x00, 0x01, 0x00 };
+        bits_put(&b, 10, n % 12); /* temporal_reference */
+        bits_put(&b, 3, intra ? 1 : 2); /* picture_coding_type */
+        bits_put(&b, 16, 0xFFFF); /* vbv_delay */
+        if (!intra)
+            bits_put(&b, 4, 3); /* full_pel_forward_vector, f_code */
+        bits_put(&b, 1, 0); /* extra_bit_picture */
+        bits_put(&b, 8 - (b.pos & 7), 0);
+        if (!stream_write(s, picture, sizeof (picture))
+         || !stream_write(s, b.buf, b.pos / 8))
+            break;
+
+        for (uint8_t slice = 1; slice <= 68; slice++)
+        {
+            const uint8_t header[] = { 0x00, 0x00, 0x01, slice };
+            if (!stream_write(s, header, sizeof (header))
+             || !stream_random(s, intra ? 2000 : 400))
+                return;
+        }
+    }
+}
+
+/* AC-3 48 kHz stereo 384 kbit/s */
+static void make_a52(struct stream *s)
+{
+    static const uint8_t header[] = {
+        0x0B, 0x77, 0x00, 0x00, /* sync word, crc1 */
+        0x1C, /* fscod 48 kHz, frmsizecod 384 kbit/s */
+        0x40, /* bsid 8, bsmod 0 */
+        0x40, /* acmod 2/0, dsurmod 0, lfeon 0 */
+    };
+
+    while (stream_write(s, header, sizeof (header)))
+        if (!stream_random(s, 1536 - sizeof (header)))
+            break;
+}
+
+/* ADTS AAC-LC 48 kHz stereo, varying frame sizes */
+static void make_mp4a(struct stream *s)
+{
+    for (;;)
+    {
+        size_t size = 7 + 200 + rand() % 400;
+        const uint8_t header[] = {
+            0xFF, 0xF1, /* sync word, MPEG-4, no CRC */
+            0x4C, /* AAC-LC, 48 kHz */
+            0x80 | (size >> 11), size >> 3, ((size & 7) << 5) | 0x1F,
+            0xFC, /* buffer fullness 0x7FF, 1 raw data block */
+        };
+        if (!stream_write(s, header, sizeof (header))
+         || !stream_random(s, size - sizeof (header)))
+            break;
+    }
+}
+
+static const struct
+{
+    const char *name;
+    int cat;
+    vlc_fourcc_t codec;
+    void (*make)(struct stream *);
+} codecs[] = {
+    { "h264", VIDEO_ES, VLC_CODEC_H264, make_h264 },
+    { "hevc", VIDEO_ES, VLC_CODEC_HEVC, NULL },
+    { "mpgv", VIDEO_ES, VLC_CODEC_MPGV, make_mpgv },
+    { "mp4a", AUDIO_ES, VLC_CODEC_MP4A, make_mp4a },
+    { "a52",  AUDIO_ES, VLC_CODEC_A52,  make_a52 },
+    { "dts",  AUDIO_ES, VLC_CODEC_DTS,  NULL },
+    { "flac", AUDIO_ES, VLC_CODEC_FLAC, NULL },
+    { "mlp",  AUDIO_ES, VLC_CODEC_MLP,  NULL },
+};
+
+static bool stream_load(struct stream *s, const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        perror(path);
+        return false;
+    }
+
+    s->buf = NULL;
+    s->length = s->size = 0;
+    for (;;)
+    {
+        if (s->length == s->size)
+        {
+            unsigned char *buf = realloc(s->buf, s->size + (1 << 20));
+            if (buf == NULL)
+                break;
+            s->buf = buf;
+            s->size += 1 << 20;
+        }
+
+        size_t length = fread(&s->buf[s->length], 1, s->size - s->length,
+                              file);
+        if (length == 0)
+            break;
+        s->length += length;
+    }
+
+    bool ok = !ferror(file);
+    fclose(file);
+    return ok && s->length > 0;
+}
+
+int main(int argc, char *argv[])
+{
+    static const size_t default_sizes[] = { 184, 2048, 65536, 1 << 20 };
+    struct vlc_run_args args;
+    struct stream stream;
+    size_t i;
+
+    vlc_run_args_init(&args);
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: [VLC_TARGET=packetizer] %s "
+                "<codec> [<filename> [block sizes...]]\n", argv[0]);
+        fprintf(stderr, "Codecs:");
+        for (i = 0; i < ARRAY_SIZE(codecs); i++)
+            fprintf(stderr, " %s%s", codecs[i].name,
+                    codecs[i].make ? "" : " (file only)");
+        fputc('\n', stderr);
+        return 1;
+    }
+
+    for (i = 0; i < ARRAY_SIZE(codecs); i++)
+        if (!strcmp(codecs[i].name, argv[1]))
+            break;
+    if (i == ARRAY_SIZE(codecs))
+    {
+        fprintf(stderr, "Error: unknown codec %s\n", argv[1]);
+        return 1;
+    }
+
+    if (argc >= 3)
+    {
+        if (!stream_load(&stream, argv[2]))
+            return 1;
+    }
+    else if (codecs[i].make != NULL)
+    {
+        stream.buf = malloc(SYNTHETIC_SIZE);
+        if (stream.buf == NULL)
+            return 1;
+        stream.length = 0;
+        stream.size = SYNTHETIC_SIZE;
+        srand(0);
+        codecs[i].make(&stream);
+    }
+    else
+    {
+        fprintf(stderr, "Error: no synthetic %s stream, "
+                "a file is needed\n", codecs[i].name);
+        return 1;
+    }
+
+    size_t count = (argc > 3) ? (size_t)(argc - 3) : ARRAY_SIZE(default_sizes);
+    int ret = 0;
+
+    for (size_t j = 0; j < count; j++)
+    {
+        struct vlc_packetizer_bench bench = { 0 };
+
+        bench.block_size = (argc > 3) ? strtoul(argv[3 + j], NULL, 0)
+                                      : default_sizes[j];
+        if (bench.block_size == 0)
+            continue;
+#ifdef __GLIBC__
+        bench.allocations = count_allocations;
+#endif
+
+        if (vlc_packetizer_bench_memory(&args, codecs[i].cat, codecs[i].codec,
+                                        stream.buf, stream.length, &bench))
+        {
+            ret = 1;
+            break;
+        }
+
+        double seconds = bench.time / 1e9;
+        if (seconds <= 0.)
+            seconds = 1e-9;
+
+        printf("%s, %zu bytes blocks: %ju units, %.1f MiB/s", codecs[i].name,
+               bench.block_size, bench.units,
+               stream.length / seconds / (1 << 20));
+        if (bench.units > 0)
+        {
+            if (bench.allocations != NULL)
+                printf(", %.2f allocations/unit",
+                       (double)bench.unit_allocations / bench.units);
+            printf(", %.2f us/unit (max %.2f us)",
+                   bench.time / 1e3 / bench.units, bench.latency_max / 1e3);
+        }
+        putchar('\n');
+    }
+
+    free(stream.buf);
+    return ret;
+}